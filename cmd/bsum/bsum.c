@@ -4,22 +4,28 @@
 \brief Hash files using belt-hash / bash-hash
 \project bee2/cmd 
 \created 2014.10.28
-\version 2024.06.14
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
 #include "../cmd.h"
+#include <bee2/core/blob.h>
 #include <bee2/core/dec.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
 #include <bee2/core/str.h>
+#include <bee2/core/rng.h>
+#include <bee2/core/tm.h>
+#include <bee2/core/u64.h>
 #include <bee2/core/util.h>
 #include <bee2/crypto/bash.h>
 #include <bee2/crypto/belt.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #ifdef OS_WIN
 	#include <locale.h>
 #endif
@@ -35,16 +41,58 @@
 Поддержаны следующие алгоритмы хэширования:
 - belt-hash (СТБ 34.101.31);
 - bash32, bash64, ..., bash512 (СТБ 34.101.77);
-- bash-prg-hashNNND (СТБ 34.101.77), где NNN in {256, 384, 512}, D in {1, 2}.
+- bash-prg-hashNNND (СТБ 34.101.77), где NNN in {256, 384, 512}, D in {1, 2};
+- bash-prg-treeNNND (древовидный режим bash-prg, см. bash.h).
 
 \remark В алгоритмах bash-prg-hashNNND используется пустой анонс (annonce, фр.).
 
+\remark В алгоритмах bash-prg-treeNNND листья файла хэшируются параллельно
+во всех доступных процессорах. Хэш-значения bash-prg-treeNNND отличаются
+от хэш-значений bash-prg-hashNNND.
+
+Опция -j N задает число потоков, между которыми распределяются файлы
+(как при вычислении, так и при проверке хэш-значений). Результаты выводятся
+в порядке перечисления файлов. Каждый поток одновременно держит открытым
+не более одного файла, поэтому число открытых файлов не превосходит N.
+
+При проверке хэш-значений (опция -c):
+- имя файла контрольных сумм "-" означает стандартный поток ввода;
+- опция -q подавляет вывод строк "OK", печатаются только ошибки;
+- опция -p включает печать хода проверки в стандартный поток ошибок
+  (не чаще раза в секунду).
+
+Опция -cache <file> подключает кэш хэш-значений (см. раздел "Кэш").
+Хэш-значение файла, версия которого (см. cmdFileId()) записана в кэше,
+не вычисляется повторно. Кэш защищается имитовставкой belt-mac на ключе,
+построенном по паролю (опция -pass <schema>). Опция -f отключает чтение
+кэша: все файлы хэшируются заново, кэш перезаписывается.
+
 Хэш-значения выводятся в формате
 ```
 	hex(хэш_значение_файла) имя_файла
 ```
 Файл такого формата используется при проверке хэш-значений.
 
+В командной строке можно указать до BSUM_HIDS_MAX = 4 различных алгоритмов
+хэширования (см. раздел "Несколько алгоритмов"). Каждый файл читается один
+раз, прочитанные данные обрабатываются всеми алгоритмами. Хэш-значения
+каждого алгоритма записываются в отдельный файл <prefix>.<alg>, где prefix
+задается опцией -o, а alg -- имя алгоритма без начального дефиса
+(belt-hash, bash384, bash-prg-hash2561,...). Формат каждого файла -- обычный
+формат хэш-значений, проверка выполняется по одному алгоритму:
+bsum -bash384 -c <prefix>.bash384.
+
+Опция -chunks включает пофрагментное хэширование (см. раздел "Фрагменты").
+Файл делится на фрагменты по границам, которые определяются содержимым,
+каждый фрагмент хэшируется выбранным алгоритмом. Выводится манифест
+```
+	hex(хэш_значение_фрагмента) смещение длина имя_файла
+```
+со строкой на каждый фрагмент (смещение и длина -- десятичные числа).
+Вставка или удаление данных в файле меняет только фрагменты вблизи
+изменения, поэтому неизменные фрагменты (например, при резервном
+копировании с дедупликацией) распознаются сравнением хэш-значений.
+
 \remark Такой же формат файла хэш-значений используется в утилитах
 {md5|sha1|sha256}sum. В bsum частично повторен интерфейс командной строки
 этих утилит.
@@ -53,6 +101,12 @@
 	bee2cmd bsum file1 file2 file3
 	bee2cmd bsum -belt-hash file1 file2 file3 > checksum
 	bee2cmd bsum -c checksum
+	bee2cmd bsum -j 8 -c checksum
+	find . -type f | xargs bee2cmd bsum | bee2cmd bsum -j 8 -q -p -c -
+	bee2cmd bsum -cache cache -pass env:BSUM_PWD -c checksum
+	bee2cmd bsum -bash256 -j 4 -chunks file1 file2 > manifest
+	bee2cmd bsum -belt-hash -bash256 -bash384 -o sums file1 file2
+	bee2cmd bsum -bash384 -c sums.bash384
 	bee2cmd bsum -- -c
 
 Обратим внимание на последнюю команду. В ней лексема "--" означает окончание
@@ -74,14 +128,33 @@ static int bsumUsage()
 	printf(
 		"bee2cmd/%s: %s\n"
 		"Usage:\n" 
-		"  bsum [hash_alg] <file_to_hash> <file_to_hash> ...\n"
-		"  bsum [hash_alg] -c <checksum_file>\n"
+		"  bsum [hash_alg] [-j N] [cache] <file_to_hash> <file_to_hash> ...\n"
+		"  bsum hash_alg [hash_alg ...] [-j N] -o <prefix> <file_to_hash> ...\n"
+		"  bsum [hash_alg] [-j N] [cache] [-q] [-p] -c <checksum_file>\n"
+		"  bsum [hash_alg] [-j N] -chunks <file_to_hash> <file_to_hash> ...\n"
 		"  hash_alg:\n" 
 		"    -belt-hash (STB 34.101.31), by default\n"
 		"    -bash32, -bash64, ..., -bash512 (STB 34.101.77)\n"
 		"    -bash-prg-hashNNND (STB 34.101.77)\n"
 		"      with NNN in {256, 384, 512}, D in {1, 2}\n"
 		"      \\note annonce = NULL\n"
+		"    -bash-prg-treeNNND (tree mode of bash-prg, multithreaded)\n"
+		"      with NNN in {256, 384, 512}, D in {1, 2}\n"
+		"  -j N: hash files in N threads (1 <= N <= 64)\n"
+		"  -o <prefix>: write hashes of each hash_alg to <prefix>.<alg>\n"
+		"    \\note up to 4 hash_algs are computed in one pass over files\n"
+		"    \\note not for -bash-prg-treeNNND, -c, -chunks, cache\n"
+		"  -q: do not print OK for each successfully verified file\n"
+		"  -p: report progress of verification to stderr\n"
+		"  -chunks: split files into content-defined chunks and print\n"
+		"    a manifest of chunk hashes, offsets and lengths\n"
+		"    \\note not for -bash-prg-treeNNND, -c, cache\n"
+		"  cache:\n"
+		"    -cache <file> -pass <schema> [-f]\n"
+		"      reuse hashes of unchanged files stored in <file>\n"
+		"      <schema> -- password protecting the cache (belt-mac)\n"
+		"      -f -- ignore the cache, rehash and rewrite it\n"
+		"  \\remark checksum_file \"-\" means stdin\n"
 		"  \\remark use \"--\" to stop parsing options"
 		,
 		_name, _descr
@@ -96,12 +169,19 @@ static int bsumUsage()
 Идентификатор хэш-алгоритма (hid), заданного в командной строке:
 *	0 -- belt-hash;
 *	32, 64, ..., 512 -- bash32, bash64, ..., bash512;
-*	NNND  -- bash-prg-hashNNND (NNN in {256, 384, 512}, D in {1, 2}).
+*	NNND  -- bash-prg-hashNNND (NNN in {256, 384, 512}, D in {1, 2});
+*	1NNND  -- bash-prg-treeNNND.
 *******************************************************************************
 */
 
+#define BSUM_HID_TREE 10000
+#define BSUM_HIDS_MAX 4
+
 static bool_t bsumHidIsValid(size_t hid)
 {
+	if (hid > BSUM_HID_TREE)
+		return (hid -= BSUM_HID_TREE) > 512 && hid < BSUM_HID_TREE &&
+			bsumHidIsValid(hid);
 	return hid == 0 ||
 		(hid <= 512 && hid % 32 == 0) ||
 		(hid % 10 != 0 && hid % 10 <= 2 &&
@@ -111,170 +191,1058 @@ static bool_t bsumHidIsValid(size_t hid)
 static size_t bsumHidHashLen(size_t hid)
 {
 	ASSERT(bsumHidIsValid(hid));
+	hid %= BSUM_HID_TREE;
 	return hid == 0 ? 32 : (hid <= 512 ? hid / 8 : hid / 80);
 };
 
+static void bsumHidName(char* name, size_t hid)
+{
+	ASSERT(bsumHidIsValid(hid));
+	if (hid == 0)
+		strCopy(name, "belt-hash");
+	else if (hid <= 512)
+	{
+		strCopy(name, "bash");
+		decFromU32(name + 4, hid < 100 ? 2 : 3, (u32)hid);
+	}
+	else if (hid < BSUM_HID_TREE)
+	{
+		strCopy(name, "bash-prg-hash");
+		decFromU32(name + 13, 4, (u32)hid);
+	}
+	else
+	{
+		strCopy(name, "bash-prg-tree");
+		decFromU32(name + 13, 4, (u32)(hid - BSUM_HID_TREE));
+	}
+}
+
+static bool_t bsumHidsAdd(size_t hids[BSUM_HIDS_MAX], size_t* count,
+	size_t hid)
+{
+	size_t k;
+	ASSERT(*count <= BSUM_HIDS_MAX);
+	if (*count == BSUM_HIDS_MAX)
+		return FALSE;
+	for (k = 0; k < *count; ++k)
+		if (hids[k] == hid)
+			return FALSE;
+	hids[(*count)++] = hid;
+	return TRUE;
+}
+
+static bool_t bsumHidsHaveTree(const size_t hids[], size_t count)
+{
+	while (count--)
+		if (hids[count] > BSUM_HID_TREE)
+			return TRUE;
+	return FALSE;
+}
+
 /*
 *******************************************************************************
 Хэширование файла
 
-\remark Если в функции bsumHash() переместить переменную buf в кучу,
-то скорость обработки больших файлов (несколько Gb) существенно упадет.
-Возможные объяснения:
-```
-https://stackoverflow.com/questions/24057331/
-	is-accessing-data-in-the-heap-faster-than-from-the-stack
-```
+Функции bsumHash(), bsumHashTree() не печатают сообщений об ошибках,
+а возвращают краткое описание ошибки ("open", "read", ...) или 0 в случае
+успеха. Это позволяет вызывать функции в нескольких потоках и печатать
+сообщения в порядке перечисления файлов.
+
+Содержимое файла передается функциям хэширования с помощью cmdFileStep():
+обычные файлы отображаются в память, остальные читаются фрагментами.
 *******************************************************************************
 */
 
-static int bsumHash(octet hash[], size_t hid, const char* filename)
+static const char* bsumErr(err_t code)
 {
-	octet buf[32768];
-	octet state[4096];
-	size_t hash_len;
-	void (*step_hash)(const void*, size_t, void*);
-	FILE* fp;
-	size_t count;
-	// pre
-	ASSERT(beltHash_keep() <= sizeof(state));
-	ASSERT(bashHash_keep() <= sizeof(state));
-	ASSERT(bashPrg_keep() <= sizeof(state));
+	switch (code)
+	{
+	case ERR_OK:
+		return 0;
+	case ERR_FILE_OPEN:
+		return "open";
+	case ERR_BAD_FILE:
+		return "close";
+	case ERR_OUTOFMEMORY:
+		return "memory";
+	default:
+		return "read";
+	}
+}
+
+static const char* bsumHashTree(octet hash[], size_t hid,
+	const char* filename, size_t threads)
+{
+	void* state;
+	err_t code;
 	// обработать hid
-	hash_len = bsumHidHashLen(hid);
+	ASSERT(bsumHidIsValid(hid) && hid > BSUM_HID_TREE);
+	hid -= BSUM_HID_TREE;
+	ASSERT(memIsValid(hash, bsumHidHashLen(hid)));
+	// создать состояние
+	threads = MAX2(threads, 1);
+	if (!(state = blobCreate(bashPrgTree_keep(threads))))
+		return "memory";
+	bashPrgTreeStart(state, hid / 20, hid % 10, threads);
+	// хэшировать файл (при чтении -- по листу на каждый поток)
+	code = cmdFileStep(filename, SIZE_MAX, bashPrgTreeStepH, state,
+		threads * BASH_PRG_TREE_LEAF);
+	// возвратить хэш-значение
+	if (code == ERR_OK)
+		bashPrgTreeStepG(hash, bsumHidHashLen(hid), state);
+	// завершить
+	blobClose(state);
+	return bsumErr(code);
+}
+
+typedef void (*bsum_step_i)(const void*, size_t, void*);
+
+static bsum_step_i bsumHashStart(void* state, size_t hid)
+{
+	ASSERT(bsumHidIsValid(hid) && hid < BSUM_HID_TREE);
 	if (hid == 0)
 	{
 		beltHashStart(state);
-		step_hash = beltHashStepH;
+		return beltHashStepH;
 	}
-	else if (hid <= 512)
+	if (hid <= 512)
 	{
 		bashHashStart(state, hid / 2);
-		step_hash = bashHashStepH;
+		return bashHashStepH;
 	}
+	bashPrgStart(state, hid / 20, hid % 10, 0, 0, 0, 0);
+	bashPrgAbsorbStart(state);
+	return bashPrgAbsorbStep;
+}
+
+static void bsumHashStop(octet hash[], size_t hid, void* state)
+{
+	ASSERT(bsumHidIsValid(hid) && hid < BSUM_HID_TREE);
+	ASSERT(memIsValid(hash, bsumHidHashLen(hid)));
+	if (hid == 0)
+		beltHashStepG(hash, state);
+	else if (hid <= 512)
+		bashHashStepG(hash, bsumHidHashLen(hid), state);
 	else
+		bashPrgSqueeze(hash, bsumHidHashLen(hid), state);
+}
+
+static const char* bsumHash(octet hash[], size_t hid, const char* filename,
+	size_t threads)
+{
+	octet state[4096];
+	bsum_step_i step_hash;
+	err_t code;
+	// древовидный режим?
+	if (hid > BSUM_HID_TREE)
+		return bsumHashTree(hash, hid, filename, threads);
+	// pre
+	ASSERT(beltHash_keep() <= sizeof(state));
+	ASSERT(bashHash_keep() <= sizeof(state));
+	ASSERT(bashPrg_keep() <= sizeof(state));
+	// хэшировать файл
+	step_hash = bsumHashStart(state, hid);
+	code = cmdFileStep(filename, SIZE_MAX, step_hash, state, 32768);
+	// возвратить хэш-значение
+	if (code == ERR_OK)
+		bsumHashStop(hash, hid, state);
+	// завершить
+	memWipe(state, sizeof(state));
+	return bsumErr(code);
+}
+
+/*
+*******************************************************************************
+Несколько алгоритмов
+
+Функция bsumHashMulti() передает фрагменты файла, полученные
+от cmdFileStep(), всем запрошенным алгоритмам. Длинные фрагменты
+(от BSUM_MULTI_PAR октетов, например, окна отображения файла)
+обрабатываются алгоритмами параллельно: алгоритм 0 -- в вызывающем потоке,
+остальные -- в отдельных потоках, которые запускаются на время обработки
+фрагмента. Параллельная обработка включается, если на поток пула
+приходится более одного процессора (см. bsum_pool::tree_threads).
+При чтении (файл не отображается) фрагменты имеют длину BSUM_MULTI_PAR.
+*******************************************************************************
+*/
+
+#define BSUM_MULTI_PAR ((size_t)1 << 20)
+
+typedef struct {
+	bsum_step_i step;		/*< шаг хэширования */
+	const void* buf;		/*< фрагмент */
+	size_t count;			/*< длина фрагмента */
+	void* state;			/*< состояние хэширования */
+} bsum_multi_task;
+
+typedef struct {
+	size_t count;			/*< число алгоритмов */
+	bool_t par;				/*< параллельная обработка? */
+	bsum_multi_task tasks[BSUM_HIDS_MAX];	/*< задачи алгоритмов */
+	octet states[BSUM_HIDS_MAX][4096];		/*< состояния хэширования */
+} bsum_multi;
+
+static void bsumMultiTask(void* arg)
+{
+	bsum_multi_task* task = (bsum_multi_task*)arg;
+	task->step(task->buf, task->count, task->state);
+}
+
+static void bsumMultiStep(const void* buf, size_t count, void* state)
+{
+	bsum_multi* m = (bsum_multi*)state;
+	mt_thrd_t thrds[BSUM_HIDS_MAX];
+	bool_t created[BSUM_HIDS_MAX];
+	size_t k;
+	for (k = 0; k < m->count; ++k)
+		m->tasks[k].buf = buf, m->tasks[k].count = count;
+	// последовательная обработка
+	if (!m->par || count < BSUM_MULTI_PAR)
 	{
-		bashPrgStart(state, hid / 20, hid % 10, 0, 0, 0, 0);
-		bashPrgAbsorbStart(state);
-		step_hash = bashPrgAbsorbStep;
+		for (k = 0; k < m->count; ++k)
+			bsumMultiTask(m->tasks + k);
+		return;
 	}
-	ASSERT(memIsValid(hash, hash_len));
-	// открыть файл
-	fp = fopen(filename, "rb");
-	if (!fp)
+	// параллельная обработка
+	for (k = 1; k < m->count; ++k)
+		created[k] = mtThrdCreate(thrds + k, bsumMultiTask, m->tasks + k);
+	bsumMultiTask(m->tasks);
+	for (k = 1; k < m->count; ++k)
+		if (created[k])
+			mtThrdJoin(thrds + k);
+		else
+			bsumMultiTask(m->tasks + k);
+}
+
+static const char* bsumHashMulti(octet hashes[], const size_t hids[],
+	size_t count, const char* filename, bool_t par)
+{
+	bsum_multi* m;
+	err_t code;
+	size_t k;
+	// pre
+	ASSERT(1 <= count && count <= BSUM_HIDS_MAX);
+	ASSERT(memIsValid(hashes, 64 * count));
+	ASSERT(beltHash_keep() <= sizeof(m->states[0]));
+	ASSERT(bashHash_keep() <= sizeof(m->states[0]));
+	ASSERT(bashPrg_keep() <= sizeof(m->states[0]));
+	// создать состояние
+	if (!(m = (bsum_multi*)blobCreate(sizeof(bsum_multi))))
+		return "memory";
+	m->count = count, m->par = par;
+	for (k = 0; k < count; ++k)
 	{
-		printf("%s: FAILED [open]\n", filename);
-		return -1;
+		m->tasks[k].step = bsumHashStart(m->states[k], hids[k]);
+		m->tasks[k].state = m->states[k];
 	}
-	// читать и хэшировать файл
-	do
+	// хэшировать файл
+	code = cmdFileStep(filename, SIZE_MAX, bsumMultiStep, m, BSUM_MULTI_PAR);
+	// возвратить хэш-значения
+	if (code == ERR_OK)
+		for (k = 0; k < count; ++k)
+			bsumHashStop(hashes + 64 * k, hids[k], m->states[k]);
+	// завершить
+	blobClose(m);
+	return bsumErr(code);
+}
+
+/*
+*******************************************************************************
+Фрагменты
+
+Границы фрагментов определяются скользящей функцией Gear [Xia W. et al.
+FastCDC: a Fast and Efficient Content-Defined Chunking Approach for Data
+Deduplication, USENIX ATC 2016]:
+  h <- (h << 1) + gear[x],
+где x -- очередной октет. Старшие разряды h зависят от последних 64
+октетов. Граница проводится после октета x, если старшие 13 разрядов h
+нулевые (маска BSUM_CHUNK_MASK). Первые BSUM_CHUNK_MIN октетов фрагмента
+пропускаются без расчета h, фрагмент принудительно завершается на длине
+BSUM_CHUNK_MAX. Средняя длина фрагмента -- около 10 Кбайт.
+
+Таблица gear строится по таблице H из СТБ 34.101.31 (см. beltH()):
+gear[i] -- это 8 октетов H[i], H[i + 1],..., H[i + 7] (индексы по
+модулю 256), записанные как число u64 в порядке big-endian. Таблица
+одинакова на всех платформах, поэтому и границы фрагментов не зависят
+от платформы.
+
+Фрагменты хэшируются по мере продвижения границ функцией bsumChunkStep(),
+которая передается в cmdFileStep(). Файлы распределяются между потоками
+пула так же, как и при хэшировании целых файлов. Пустой файл представляется
+одним фрагментом нулевой длины.
+*******************************************************************************
+*/
+
+#define BSUM_CHUNK_MIN 2048
+#define BSUM_CHUNK_MAX 65536
+#define BSUM_CHUNK_MASK (U64_MAX << 51)
+
+static u64 _gear[256];
+
+static void bsumGearInit()
+{
+	const octet* H = beltH();
+	size_t i, j;
+	for (i = 0; i < 256; ++i)
+		for (_gear[i] = 0, j = 0; j < 8; ++j)
+			_gear[i] = _gear[i] << 8 | H[(i + j) % 256];
+}
+
+typedef struct {
+	u64 offset;				/*< смещение фрагмента */
+	u64 len;				/*< длина фрагмента */
+	octet hash[64];			/*< хэш-значение фрагмента */
+} bsum_chunk;
+
+typedef struct {
+	size_t hid;				/*< идентификатор алгоритма */
+	bsum_step_i step_hash;	/*< шаг хэширования */
+	u64 h;					/*< скользящее значение */
+	u64 offset;				/*< смещение текущего фрагмента */
+	u64 len;				/*< длина текущего фрагмента */
+	bsum_chunk* chunks;		/*< [count] готовые фрагменты */
+	size_t count;			/*< число готовых фрагментов */
+	size_t max;				/*< максимальное число фрагментов */
+	bool_t oom;				/*< не хватило памяти? */
+	octet state[4096];		/*< состояние хэширования */
+} bsum_chunker;
+
+static void bsumChunkEmit(bsum_chunker* ch)
+{
+	// расширить массив фрагментов
+	if (ch->count == ch->max && !ch->oom)
 	{
-		count = fread(buf, 1, sizeof(buf), fp);
-		step_hash(buf, count, state);
+		size_t max = MAX2(2 * ch->max, 256);
+		bsum_chunk* chunks = (bsum_chunk*)blobResize(ch->chunks,
+			max * sizeof(bsum_chunk));
+		if (!chunks)
+			ch->oom = TRUE;
+		else
+			ch->chunks = chunks, ch->max = max;
 	}
-	while (count == sizeof(buf));
-	// ошибка чтения?
-	if (ferror(fp))
+	// сохранить фрагмент
+	if (!ch->oom)
 	{
-		fclose(fp);
-		memWipe(buf, sizeof(buf));
-		memWipe(state, sizeof(state));
-		printf("%s: FAILED [read]\n", filename);
-		return -1;
+		bsum_chunk* chunk = ch->chunks + ch->count++;
+		chunk->offset = ch->offset, chunk->len = ch->len;
+		memSetZero(chunk->hash, 64);
+		bsumHashStop(chunk->hash, ch->hid, ch->state);
 	}
-	// закрыть файл
-	if (fclose(fp) != 0)
+	// к следующему фрагменту
+	ch->offset += ch->len, ch->len = 0, ch->h = 0;
+	ch->step_hash = bsumHashStart(ch->state, ch->hid);
+}
+
+static void bsumChunkStep(const void* buf, size_t count, void* state)
+{
+	bsum_chunker* ch = (bsum_chunker*)state;
+	const octet* b = (const octet*)buf;
+	register u64 h = ch->h;
+	size_t start, pos, lim, i;
+	for (start = pos = 0; pos < count; )
 	{
-		memWipe(buf, sizeof(buf));
-		memWipe(state, sizeof(state));
-		printf("%s: FAILED [close]\n", filename);
-		return -1;
+		// пропустить начало фрагмента
+		if (ch->len < BSUM_CHUNK_MIN)
+		{
+			i = (size_t)MIN2(count - pos, BSUM_CHUNK_MIN - ch->len);
+			pos += i, ch->len += i;
+			continue;
+		}
+		// искать границу
+		lim = (size_t)MIN2(count - pos, BSUM_CHUNK_MAX - ch->len);
+		for (i = 0; i < lim; )
+		{
+			h = (h << 1) + _gear[b[pos + i++]];
+			if ((h & BSUM_CHUNK_MASK) == 0)
+				break;
+		}
+		pos += i, ch->len += i;
+		// граница не найдена?
+		if (i == lim && (h & BSUM_CHUNK_MASK) && ch->len < BSUM_CHUNK_MAX)
+			continue;
+		// завершить фрагмент
+		ch->step_hash(b + start, pos - start, ch->state);
+		bsumChunkEmit(ch);
+		start = pos, h = 0;
 	}
-	// возвратить хэш-значение
-	if (hid == 0)
-		beltHashStepG(hash, state);
-	else if (hid <= 512)
-		bashHashStepG(hash, hash_len, state);
+	// хэшировать остаток
+	if (start < count)
+		ch->step_hash(b + start, count - start, ch->state);
+	ch->h = h;
+}
+
+static const char* bsumChunks(bsum_chunk** chunks, size_t* count,
+	size_t hid, const char* filename)
+{
+	bsum_chunker* ch;
+	err_t code;
+	// pre
+	ASSERT(bsumHidIsValid(hid) && hid < BSUM_HID_TREE);
+	ASSERT(beltHash_keep() <= sizeof(ch->state));
+	ASSERT(bashHash_keep() <= sizeof(ch->state));
+	ASSERT(bashPrg_keep() <= sizeof(ch->state));
+	*chunks = 0, *count = 0;
+	// создать состояние
+	if (!(ch = (bsum_chunker*)blobCreate(sizeof(bsum_chunker))))
+		return "memory";
+	ch->hid = hid;
+	ch->step_hash = bsumHashStart(ch->state, hid);
+	// разбить файл на фрагменты и хэшировать их
+	code = cmdFileStep(filename, SIZE_MAX, bsumChunkStep, ch, 32768);
+	// последний фрагмент (пустой файл -- фрагмент нулевой длины)
+	if (code == ERR_OK && (ch->len || !ch->count))
+		bsumChunkEmit(ch);
+	if (code == ERR_OK && ch->oom)
+		code = ERR_OUTOFMEMORY;
+	// возвратить фрагменты
+	if (code == ERR_OK)
+		*chunks = ch->chunks, *count = ch->count;
 	else
-		bashPrgSqueeze(hash, hash_len, state);
+		blobClose(ch->chunks);
 	// завершить
-	memWipe(buf, sizeof(buf));
-	memWipe(state, sizeof(state));
-	return 0;
+	blobClose(ch);
+	return bsumErr(code);
+}
+
+/*
+*******************************************************************************
+Кэш
+
+Кэш -- это файл со структурой
+  magic || salt || rec_1 || rec_2 || ... || rec_n || mac,
+где magic -- 8-октетная метка "bee2bsum", salt -- 8-октетная синхропосылка,
+rec_i -- записи, mac -- имитовставка belt-mac, которая вычисляется
+от всех предшествующих октетов на ключе
+  beltPBKDF2(pwd, BSUM_CACHE_ITER, salt).
+Синхропосылка вырабатывается при создании кэша.
+
+Запись кэша состоит из версии файла (dev, ino, size, mtime, ctime),
+идентификатора алгоритма hid (все поля -- u64, little-endian) и 64-октетного
+хэш-значения (дополняется нулями). Ключ поиска -- тройка (dev, ino, hid).
+Записи упорядочены по ключу. Хэш-значение из кэша используется, если
+остальные поля версии совпадают.
+
+Потоки пула только читают записи кэша. Новые записи формируются для файлов,
+версия которых не изменилась за время хэширования, и после обработки пакета
+добавляются в кэш вызывающим потоком. Если в кэш добавлены записи,
+то он перезаписывается при закрытии: новые записи заменяют старые с тем
+же ключом. Запись ведется во временный файл, который затем переименовывается.
+*******************************************************************************
+*/
+
+#define BSUM_CACHE_ITER 10000
+#define BSUM_CACHE_REC (6 * 8 + 64)
+
+typedef struct {
+	cmd_file_id_t id;		/*< версия файла */
+	u64 hid;				/*< идентификатор алгоритма */
+	octet hash[64];			/*< хэш-значение */
+	bool_t fresh;			/*< новая запись? */
+} bsum_rec;
+
+typedef struct {
+	const char* file;		/*< файл кэша */
+	octet salt[8];			/*< синхропосылка */
+	octet key[32];			/*< ключ имитозащиты */
+	bool_t force;			/*< перезаписать кэш? */
+	bsum_rec* recs;			/*< [count] записи (упорядочены) */
+	size_t count;			/*< число записей */
+	bsum_rec* added;		/*< [added_count] новые записи */
+	size_t added_count;		/*< число новых записей */
+	size_t added_max;		/*< максимальное число новых записей */
+} bsum_cache;
+
+static int bsumCacheCmp(const void* a, const void* b)
+{
+	const bsum_rec* ra = (const bsum_rec*)a;
+	const bsum_rec* rb = (const bsum_rec*)b;
+	if (ra->id.dev != rb->id.dev)
+		return ra->id.dev < rb->id.dev ? -1 : 1;
+	if (ra->id.ino != rb->id.ino)
+		return ra->id.ino < rb->id.ino ? -1 : 1;
+	if (ra->hid != rb->hid)
+		return ra->hid < rb->hid ? -1 : 1;
+	// новые записи раньше старых
+	return (int)rb->fresh - (int)ra->fresh;
+}
+
+static void bsumCacheRecFrom(bsum_rec* rec, const octet buf[])
+{
+	u64 w[6];
+	u64From(w, buf, sizeof(w));
+	rec->id.dev = w[0], rec->id.ino = w[1], rec->id.size = w[2];
+	rec->id.mtime = w[3], rec->id.ctime = w[4], rec->hid = w[5];
+	memCopy(rec->hash, buf + sizeof(w), 64);
+	rec->fresh = FALSE;
+}
+
+static void bsumCacheRecTo(octet buf[], const bsum_rec* rec)
+{
+	u64 w[6];
+	w[0] = rec->id.dev, w[1] = rec->id.ino, w[2] = rec->id.size;
+	w[3] = rec->id.mtime, w[4] = rec->id.ctime, w[5] = rec->hid;
+	u64To(buf, sizeof(w), w);
+	memCopy(buf + sizeof(w), rec->hash, 64);
+}
+
+static err_t bsumCacheStart(bsum_cache* cache, const char* file,
+	const cmd_pwd_t pwd, bool_t force)
+{
+	err_t code;
+	size_t size;
+	octet* buf;
+	octet mac[8];
+	size_t i;
+	// pre
+	ASSERT(strIsValid(file));
+	ASSERT(cmdPwdIsValid(pwd));
+	memSetZero(cache, sizeof(bsum_cache));
+	cache->file = file;
+	cache->force = force;
+	size = force ? SIZE_MAX : cmdFileSize(file);
+	// новый кэш
+	if (size == SIZE_MAX)
+	{
+		code = cmdRngStart(FALSE);
+		ERR_CALL_CHECK(code);
+		rngStepR(cache->salt, 8, 0);
+		cache->force = TRUE;
+		return beltPBKDF2(cache->key, (const octet*)pwd, cmdPwdLen(pwd),
+			BSUM_CACHE_ITER, cache->salt, 8);
+	}
+	// прочитать кэш
+	if (size < 24 || (size - 24) % BSUM_CACHE_REC)
+		return ERR_BAD_FORMAT;
+	code = cmdBlobCreate(buf, size);
+	ERR_CALL_CHECK(code);
+	code = cmdFileReadAll(buf, &size, file);
+	ERR_CALL_HANDLE(code, cmdBlobClose(buf));
+	if (!memEq(buf, "bee2bsum", 8))
+		code = ERR_BAD_FORMAT;
+	ERR_CALL_HANDLE(code, cmdBlobClose(buf));
+	// проверить имитовставку
+	memCopy(cache->salt, buf + 8, 8);
+	code = beltPBKDF2(cache->key, (const octet*)pwd, cmdPwdLen(pwd),
+		BSUM_CACHE_ITER, cache->salt, 8);
+	ERR_CALL_HANDLE(code, cmdBlobClose(buf));
+	code = beltMAC(mac, buf, size - 8, cache->key, 32);
+	if (code == ERR_OK && !memEq(mac, buf + size - 8, 8))
+		code = ERR_BAD_MAC;
+	ERR_CALL_HANDLE(code, (memWipe(cache->key, 32), cmdBlobClose(buf)));
+	// разобрать записи
+	cache->count = (size - 24) / BSUM_CACHE_REC;
+	if (cache->count)
+	{
+		code = cmdBlobCreate(cache->recs, cache->count * sizeof(bsum_rec));
+		ERR_CALL_HANDLE(code, (memWipe(cache->key, 32), cmdBlobClose(buf)));
+	}
+	for (i = 0; i < cache->count; ++i)
+		bsumCacheRecFrom(cache->recs + i, buf + 16 + i * BSUM_CACHE_REC);
+	qsort(cache->recs, cache->count, sizeof(bsum_rec), bsumCacheCmp);
+	cmdBlobClose(buf);
+	return ERR_OK;
+}
+
+static bool_t bsumCacheGet(octet hash[64], const bsum_cache* cache,
+	const cmd_file_id_t* id, size_t hid)
+{
+	bsum_rec key[1];
+	const bsum_rec* rec;
+	key->id = *id;
+	key->hid = (u64)hid;
+	key->fresh = FALSE;
+	rec = (const bsum_rec*)bsearch(key, cache->recs, cache->count,
+		sizeof(bsum_rec), bsumCacheCmp);
+	if (!rec || rec->id.size != id->size || rec->id.mtime != id->mtime ||
+		rec->id.ctime != id->ctime)
+		return FALSE;
+	memCopy(hash, rec->hash, 64);
+	return TRUE;
+}
+
+static void bsumCacheAdd(bsum_cache* cache, const cmd_file_id_t* id,
+	size_t hid, const octet hash[], size_t hash_len)
+{
+	bsum_rec* rec;
+	// расширить массив новых записей
+	if (cache->added_count == cache->added_max)
+	{
+		size_t max = MAX2(2 * cache->added_max, 1024);
+		bsum_rec* added = (bsum_rec*)blobResize(cache->added,
+			max * sizeof(bsum_rec));
+		if (!added)
+			return;
+		cache->added = added, cache->added_max = max;
+	}
+	// добавить запись
+	rec = cache->added + cache->added_count++;
+	rec->id = *id;
+	rec->hid = (u64)hid;
+	memSetZero(rec->hash, 64);
+	memCopy(rec->hash, hash, hash_len);
+	rec->fresh = TRUE;
+}
+
+static err_t bsumCacheFlush(bsum_cache* cache)
+{
+	err_t code;
+	bsum_rec* recs;
+	size_t count;
+	size_t i, j;
+	octet* buf;
+	char* tmp;
+	size_t size;
+	// нечего записывать?
+	if (!cache->added_count && !cache->force)
+		return ERR_OK;
+	// объединить записи
+	count = cache->count + cache->added_count;
+	code = cmdBlobCreate(recs, MAX2(count, 1) * sizeof(bsum_rec));
+	ERR_CALL_CHECK(code);
+	memCopy(recs, cache->added, cache->added_count * sizeof(bsum_rec));
+	memCopy(recs + cache->added_count, cache->recs,
+		cache->count * sizeof(bsum_rec));
+	qsort(recs, count, sizeof(bsum_rec), bsumCacheCmp);
+	for (i = j = 0; i < count; ++i)
+		if (j == 0 || recs[j - 1].id.dev != recs[i].id.dev ||
+			recs[j - 1].id.ino != recs[i].id.ino ||
+			recs[j - 1].hid != recs[i].hid)
+			recs[j++] = recs[i];
+	count = j;
+	// сформировать кэш
+	size = 24 + count * BSUM_CACHE_REC;
+	code = cmdBlobCreate(buf, size + strLen(cache->file) + 5);
+	ERR_CALL_HANDLE(code, cmdBlobClose(recs));
+	memCopy(buf, "bee2bsum", 8);
+	memCopy(buf + 8, cache->salt, 8);
+	for (i = 0; i < count; ++i)
+		bsumCacheRecTo(buf + 16 + i * BSUM_CACHE_REC, recs + i);
+	cmdBlobClose(recs);
+	code = beltMAC(buf + size - 8, buf, size - 8, cache->key, 32);
+	ERR_CALL_HANDLE(code, cmdBlobClose(buf));
+	// записать во временный файл и переименовать
+	tmp = (char*)buf + size;
+	strCopy(tmp, cache->file);
+	strCopy(tmp + strLen(cache->file), ".tmp");
+	code = cmdFileWrite(tmp, buf, size);
+	if (code == ERR_OK)
+	{
+#ifdef OS_WIN
+		remove(cache->file);
+#endif
+		if (rename(tmp, cache->file) != 0)
+			code = ERR_FILE_WRITE, remove(tmp);
+	}
+	cmdBlobClose(buf);
+	return code;
+}
+
+static void bsumCacheClose(bsum_cache* cache)
+{
+	memWipe(cache->key, sizeof(cache->key));
+	cmdBlobClose(cache->recs);
+	cmdBlobClose(cache->added);
+	memSetZero(cache, sizeof(bsum_cache));
+}
+
+/*
+*******************************************************************************
+Пул потоков
+
+Файлы обрабатываются пакетами по BSUM_BATCH заданий. Задания пакета
+распределяются между jobs потоками (опция -j): очередное задание выбирается
+потоком с помощью атомарного инкремента общего счетчика. Первый поток пула --
+вызывающий. После завершения пакета результаты печатаются в порядке заданий.
+
+В древовидном режиме процессоры делятся между потоками пула: каждый поток
+хэширует листья файла в mtCPUs() / jobs потоках.
+*******************************************************************************
+*/
+
+#define BSUM_BATCH 256
+
+typedef struct {
+	const char* filename;	/*< имя файла */
+	char* line;				/*< строка файла контрольных сумм */
+	octet hash[64 * BSUM_HIDS_MAX];	/*< хэш-значения (по 64 октета) */
+	const char* err;		/*< описание ошибки */
+	cmd_file_id_t id;		/*< версия файла */
+	bool_t fresh;			/*< добавить хэш-значение в кэш? */
+	bsum_chunk* chunks;		/*< [chunk_count] фрагменты (-chunks) */
+	size_t chunk_count;		/*< число фрагментов */
+} bsum_job;
+
+typedef struct {
+	size_t hid;				/*< идентификатор алгоритма (первого) */
+	const size_t* hids;		/*< [hid_count] идентификаторы алгоритмов */
+	size_t hid_count;		/*< число алгоритмов */
+	size_t tree_threads;	/*< число потоков древовидного хэширования */
+	bool_t chunked;			/*< пофрагментное хэширование? */
+	bsum_job* jobs;			/*< задания */
+	size_t count;			/*< число заданий */
+	size_t next;			/*< счетчик выбранных заданий */
+	bsum_cache* cache;		/*< кэш (может быть нулевым) */
+} bsum_pool;
+
+static void bsumJob(bsum_job* job, const bsum_pool* pool)
+{
+	cmd_file_id_t id;
+	job->fresh = FALSE;
+	// пофрагментное хэширование?
+	if (pool->chunked)
+	{
+		job->err = bsumChunks(&job->chunks, &job->chunk_count, pool->hid,
+			job->filename);
+		return;
+	}
+	// несколько алгоритмов?
+	if (pool->hid_count > 1)
+	{
+		job->err = bsumHashMulti(job->hash, pool->hids, pool->hid_count,
+			job->filename, pool->tree_threads > 1);
+		return;
+	}
+	// без кэша или не обычный файл?
+	if (!pool->cache || !cmdFileId(&job->id, job->filename))
+	{
+		job->err = bsumHash(job->hash, pool->hid, job->filename,
+			pool->tree_threads);
+		return;
+	}
+	// хэш-значение в кэше?
+	if (!pool->cache->force &&
+		bsumCacheGet(job->hash, pool->cache, &job->id, pool->hid))
+	{
+		job->err = 0;
+		return;
+	}
+	// хэшировать (версия не должна измениться)
+	job->err = bsumHash(job->hash, pool->hid, job->filename,
+		pool->tree_threads);
+	job->fresh = !job->err && cmdFileId(&id, job->filename) &&
+		memEq(&id, &job->id, sizeof(id));
+}
+
+static void bsumWorker(void* arg)
+{
+	bsum_pool* pool = (bsum_pool*)arg;
+	size_t i;
+	while ((i = mtAtomicIncr(&pool->next) - 1) < pool->count)
+		bsumJob(pool->jobs + i, pool);
+}
+
+static void bsumRun(bsum_pool* pool, size_t jobs)
+{
+	mt_thrd_t thrds[64];
+	bool_t created[64];
+	size_t t;
+	ASSERT(1 <= jobs && jobs <= COUNT_OF(thrds));
+	pool->next = 0;
+	jobs = MIN2(jobs, pool->count);
+	for (t = 1; t < jobs; ++t)
+		created[t] = mtThrdCreate(thrds + t, bsumWorker, pool);
+	bsumWorker(pool);
+	for (t = 1; t < jobs; ++t)
+		if (created[t])
+			mtThrdJoin(thrds + t);
+	// пополнить кэш
+	if (pool->cache)
+		for (t = 0; t < pool->count; ++t)
+			if (pool->jobs[t].fresh)
+				bsumCacheAdd(pool->cache, &pool->jobs[t].id, pool->hid,
+					pool->jobs[t].hash, bsumHidHashLen(pool->hid));
+}
+
+static void bsumPoolStart(bsum_pool* pool, size_t hid, size_t jobs,
+	bsum_job batch[BSUM_BATCH], bsum_cache* cache)
+{
+	pool->hid = hid;
+	pool->hids = 0;
+	pool->hid_count = 1;
+	pool->tree_threads = MAX2(mtCPUs() / jobs, 1);
+	pool->chunked = FALSE;
+	pool->jobs = batch;
+	pool->count = 0;
+	pool->cache = cache;
+}
+
+/*
+*******************************************************************************
+Печать и проверка хэш-значений
+*******************************************************************************
+*/
+
+static int bsumPrint(size_t hid, size_t jobs, bsum_cache* cache, int argc,
+	char* argv[])
+{
+	bsum_job batch[BSUM_BATCH];
+	bsum_pool pool[1];
+	char str[64 * 2 + 8];
+	int ret = 0;
+	size_t i;
+	bsumPoolStart(pool, hid, jobs, batch, cache);
+	while (argc)
+	{
+		// сформировать пакет
+		for (pool->count = 0; argc && pool->count < BSUM_BATCH; --argc)
+			batch[pool->count++].filename = *argv++;
+		// обработать пакет и напечатать результаты
+		bsumRun(pool, jobs);
+		for (i = 0; i < pool->count; ++i)
+		{
+			if (batch[i].err)
+			{
+				printf("%s: FAILED [%s]\n", batch[i].filename, batch[i].err);
+				ret = -1;
+				continue;
+			}
+			hexFrom(str, batch[i].hash, bsumHidHashLen(hid));
+			hexLower(str);
+			printf("%s  %s\n", str, batch[i].filename);
+		}
+	}
+	return ret;
 }
 
-static int bsumPrint(size_t hid, int argc, char* argv[])
+static int bsumPrintMulti(const size_t hids[], size_t hid_count,
+	FILE* const outs[], size_t jobs, int argc, char* argv[])
 {
-	octet hash[64];
+	bsum_job batch[BSUM_BATCH];
+	bsum_pool pool[1];
 	char str[64 * 2 + 8];
 	int ret = 0;
-	for (; argc--; argv++)
+	size_t i, k;
+	ASSERT(1 <= hid_count && hid_count <= BSUM_HIDS_MAX);
+	bsumPoolStart(pool, hids[0], jobs, batch, 0);
+	pool->hids = hids, pool->hid_count = hid_count;
+	while (argc)
 	{
-		if (bsumHash(hash, hid, argv[0]) != 0)
+		// сформировать пакет
+		for (pool->count = 0; argc && pool->count < BSUM_BATCH; --argc)
+			batch[pool->count++].filename = *argv++;
+		// обработать пакет и записать результаты
+		bsumRun(pool, jobs);
+		for (i = 0; i < pool->count; ++i)
 		{
+			if (batch[i].err)
+			{
+				printf("%s: FAILED [%s]\n", batch[i].filename, batch[i].err);
+				ret = -1;
+				continue;
+			}
+			for (k = 0; k < hid_count; ++k)
+			{
+				hexFrom(str, batch[i].hash + 64 * k, bsumHidHashLen(hids[k]));
+				hexLower(str);
+				fprintf(outs[k], "%s  %s\n", str, batch[i].filename);
+			}
+		}
+	}
+	return ret;
+}
+
+static int bsumPrintTo(const size_t hids[], size_t hid_count,
+	const char* prefix, size_t jobs, int argc, char* argv[])
+{
+	FILE* outs[BSUM_HIDS_MAX];
+	char* name;
+	size_t len;
+	int ret = 0;
+	size_t k;
+	ASSERT(1 <= hid_count && hid_count <= BSUM_HIDS_MAX);
+	ASSERT(strIsValid(prefix));
+	// имена файлов: prefix.alg
+	len = strLen(prefix);
+	if (!(name = (char*)blobCreate(len + 32)))
+	{
+		fprintf(stderr, "bee2cmd/%s: %s\n", _name, errMsg(ERR_OUTOFMEMORY));
+		return -1;
+	}
+	strCopy(name, prefix);
+	name[len] = '.';
+	// создать файлы
+	for (k = 0; k < hid_count; ++k)
+	{
+		bsumHidName(name + len + 1, hids[k]);
+		if (!(outs[k] = fopen(name, "w")))
+		{
+			fprintf(stderr, "bee2cmd/%s: %s: %s\n", _name, name,
+				errMsg(ERR_FILE_CREATE));
+			break;
+		}
+	}
+	// хэшировать
+	if (k == hid_count)
+		ret = bsumPrintMulti(hids, hid_count, outs, jobs, argc, argv);
+	else
+		ret = -1, hid_count = k;
+	// закрыть файлы
+	for (k = 0; k < hid_count; ++k)
+		if (fclose(outs[k]) != 0)
+		{
+			bsumHidName(name + len + 1, hids[k]);
+			fprintf(stderr, "bee2cmd/%s: %s: %s\n", _name, name,
+				errMsg(ERR_FILE_WRITE));
 			ret = -1;
-			continue;
 		}
-		hexFrom(str, hash, bsumHidHashLen(hid));
-		hexLower(str);
-		printf("%s  %s\n", str, argv[0]);
+	blobClose(name);
+	return ret;
+}
+
+static void bsumU64Str(char* str, u64 num)
+{
+	size_t count;
+	u64 t;
+	for (count = 1, t = num; t >= 10; t /= 10)
+		++count;
+	decFromU64(str, count, num);
+}
+
+static int bsumPrintChunks(size_t hid, size_t jobs, int argc, char* argv[])
+{
+	bsum_job batch[BSUM_BATCH];
+	bsum_pool pool[1];
+	char str[64 * 2 + 8];
+	char offset[21];
+	char len[21];
+	int ret = 0;
+	size_t i, j;
+	bsumGearInit();
+	bsumPoolStart(pool, hid, jobs, batch, 0);
+	pool->chunked = TRUE;
+	while (argc)
+	{
+		// сформировать пакет
+		for (pool->count = 0; argc && pool->count < BSUM_BATCH; --argc)
+			batch[pool->count++].filename = *argv++;
+		// обработать пакет и напечатать манифест
+		bsumRun(pool, jobs);
+		for (i = 0; i < pool->count; ++i)
+		{
+			if (batch[i].err)
+			{
+				printf("%s: FAILED [%s]\n", batch[i].filename, batch[i].err);
+				ret = -1;
+				continue;
+			}
+			for (j = 0; j < batch[i].chunk_count; ++j)
+			{
+				hexFrom(str, batch[i].chunks[j].hash, bsumHidHashLen(hid));
+				hexLower(str);
+				bsumU64Str(offset, batch[i].chunks[j].offset);
+				bsumU64Str(len, batch[i].chunks[j].len);
+				printf("%s  %s %s  %s\n", str, offset, len,
+					batch[i].filename);
+			}
+			blobClose(batch[i].chunks);
+		}
 	}
 	return ret;
 }
 
-static int bsumCheck(size_t hid, const char* filename)
+static void bsumProgress(size_t checked, size_t failed)
 {
-	octet hash[64];
+	fprintf(stderr, "bee2cmd/%s: %lu files checked, %lu failed\n", _name,
+		(unsigned long)checked, (unsigned long)failed);
+}
+
+static int bsumCheck(size_t hid, size_t jobs, bsum_cache* cache,
+	bool_t quiet, bool_t progress, const char* filename)
+{
+	bsum_job batch[BSUM_BATCH];
+	bsum_pool pool[1];
+	char* lines;
 	size_t hash_len;
-	char str[1024];
+	char* str;
 	size_t str_len;
 	FILE* fp;
 	size_t all_lines = 0;
 	size_t bad_lines = 0;
 	size_t bad_files = 0;
 	size_t bad_hashes = 0;
+	size_t checked = 0;
+	tm_time_t reported;
+	size_t i;
+	bool_t eof = FALSE;
 	// длина хэш-значения в байтах
 	hash_len = bsumHidHashLen(hid);
+	// строки пакета
+	if (!(lines = (char*)blobCreate(BSUM_BATCH * 1024)))
+	{
+		printf("%s: FAILED [memory]\n", filename);
+		return -1;
+	}
+	bsumPoolStart(pool, hid, jobs, batch, cache);
 	// открыть файл контрольных сумм
-	fp = fopen(filename, "rb");
+	fp = strEq(filename, "-") ? stdin : fopen(filename, "rb");
 	if (!fp)
 	{
+		blobClose(lines);
 		printf("%s: No such file\n", filename);
 		return -1;
 	}
-	for (; fgets(str, sizeof(str), fp); ++all_lines)
+	reported = tmTime();
+	while (!eof)
 	{
-		// проверить строку
-		str_len = strLen(str);
-		if (str_len < hash_len * 2 + 2 || 
-			str[2 * hash_len] != ' ' || 
-			str[2 * hash_len + 1] != ' ' ||
-			(str[hash_len * 2] = 0, !hexIsValid(str)))
+		// сформировать пакет
+		for (pool->count = 0; pool->count < BSUM_BATCH; ++all_lines)
 		{
-			bad_lines++;
-			continue;
+			str = lines + 1024 * pool->count;
+			if (!fgets(str, 1024, fp))
+			{
+				eof = TRUE;
+				break;
+			}
+			// проверить строку
+			str_len = strLen(str);
+			if (str_len < hash_len * 2 + 2 || 
+				str[2 * hash_len] != ' ' || 
+				str[2 * hash_len + 1] != ' ' ||
+				(str[hash_len * 2] = 0, !hexIsValid(str)))
+			{
+				bad_lines++;
+				continue;
+			}
+			// выделить имя файла
+			if(str[str_len - 1] == '\n') 
+				str[--str_len] = 0;
+			if(str[str_len - 1] == '\r') 
+				str[--str_len] = 0;
+			batch[pool->count].line = str;
+			batch[pool->count++].filename = str + 2 * hash_len + 2;
 		}
-		// выделить имя файла
-		if(str[str_len - 1] == '\n') 
-			str[--str_len] = 0;
-		if(str[str_len - 1] == '\r') 
-			str[--str_len] = 0;
-		// хэшировать
-		if (bsumHash(hash, hid, str + 2 * hash_len + 2) == -1)
+		// обработать пакет и напечатать результаты
+		if (pool->count)
+			bsumRun(pool, jobs);
+		for (i = 0; i < pool->count; ++i)
 		{
-			bad_files++;
-			continue;
+			if (batch[i].err)
+			{
+				printf("%s: FAILED [%s]\n", batch[i].filename, batch[i].err);
+				bad_files++;
+				continue;
+			}
+			if (!hexEq(batch[i].hash, batch[i].line))
+			{
+				bad_hashes++;
+				printf("%s: FAILED [checksum]\n", batch[i].filename);
+				continue;
+			}
+			if (!quiet)
+				printf("%s: OK\n", batch[i].filename);
 		}
-		if (!hexEq(hash, str))
+		checked += pool->count;
+		// ход проверки
+		if (progress && (eof || tmTime() != reported))
 		{
-			bad_hashes++;
-			printf("%s: FAILED [checksum]\n", str + 2 * hash_len + 2);
-			continue;
+			fflush(stdout);
+			bsumProgress(checked, bad_files + bad_hashes);
+			reported = tmTime();
 		}
-		printf("%s: OK\n", str + 2 * hash_len + 2);
 	}
+	blobClose(lines);
 	// закрыть файл контрольных сумм
-	if (fclose(fp) != 0)
+	if (fp != stdin && fclose(fp) != 0)
 	{
 		printf("%s: FAILED [close]\n", filename);
 		return -1;
@@ -309,6 +1277,19 @@ int bsumMain(int argc, char* argv[])
 	err_t code = ERR_OK;
 	size_t hid = SIZE_MAX;
 	bool_t check = FALSE;
+	bool_t quiet = FALSE;
+	bool_t progress = FALSE;
+	bool_t chunks = FALSE;
+	size_t hids[BSUM_HIDS_MAX];
+	size_t hid_count = 0;
+	const char* out = 0;
+	size_t jobs = SIZE_MAX;
+	const char* cache_file = 0;
+	const char* pass = 0;
+	bool_t force = FALSE;
+	bsum_cache cache[1];
+	cmd_pwd_t pwd;
+	int ret;
 #ifdef OS_WIN
 	setlocale(LC_ALL, "russian_belarus.1251");
 #endif
@@ -322,21 +1303,36 @@ int bsumMain(int argc, char* argv[])
 		// belt-hash
 		if (strStartsWith(argv[0], "-belt-hash"))
 		{
-			if (hid != SIZE_MAX)
+			if (!bsumHidsAdd(hids, &hid_count, 0))
 			{
 				code = ERR_CMD_PARAMS;
 				break;
 			}
-			hid = 0;
 			--argc, ++argv;
 		}
 		// bash-prg-hash
 		else if (strStartsWith(argv[0], "-bash-prg-hash"))
 		{
 			char* alg_name = argv[0] + strLen("-bash-prg-hash");
-			if (hid != SIZE_MAX || !decIsValid(alg_name) ||
+			if (!decIsValid(alg_name) ||
 				strLen(alg_name) != 4 || decCLZ(alg_name) ||
-				!bsumHidIsValid(hid = (size_t)decToU32(alg_name)))
+				!bsumHidIsValid(hid = (size_t)decToU32(alg_name)) ||
+				!bsumHidsAdd(hids, &hid_count, hid))
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			--argc, ++argv;
+		}
+		// bash-prg-tree
+		else if (strStartsWith(argv[0], "-bash-prg-tree"))
+		{
+			char* alg_name = argv[0] + strLen("-bash-prg-tree");
+			if (!decIsValid(alg_name) ||
+				strLen(alg_name) != 4 || decCLZ(alg_name) ||
+				!bsumHidIsValid(hid = BSUM_HID_TREE +
+					(size_t)decToU32(alg_name)) ||
+				!bsumHidsAdd(hids, &hid_count, hid))
 			{
 				code = ERR_CMD_PARAMS;
 				break;
@@ -347,10 +1343,11 @@ int bsumMain(int argc, char* argv[])
 		else if (strStartsWith(argv[0], "-bash"))
 		{
 			char* alg_name = argv[0] + strLen("-bash");
-			if (hid != SIZE_MAX || !decIsValid(alg_name) ||
+			if (!decIsValid(alg_name) ||
 				2 > strLen(alg_name) || strLen(alg_name) > 4 ||
 				decCLZ(alg_name) ||
-				!bsumHidIsValid(hid = (size_t)decToU32(alg_name)))
+				!bsumHidIsValid(hid = (size_t)decToU32(alg_name)) ||
+				!bsumHidsAdd(hids, &hid_count, hid))
 			{
 				code = ERR_CMD_PARAMS;
 				break;
@@ -368,6 +1365,99 @@ int bsumMain(int argc, char* argv[])
 			check = TRUE;
 			--argc, ++argv;
 		}
+		// quiet
+		else if (strEq(argv[0], "-q"))
+		{
+			if (quiet)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			quiet = TRUE;
+			--argc, ++argv;
+		}
+		// progress
+		else if (strEq(argv[0], "-p"))
+		{
+			if (progress)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			progress = TRUE;
+			--argc, ++argv;
+		}
+		// chunks
+		else if (strEq(argv[0], "-chunks"))
+		{
+			if (chunks)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			chunks = TRUE;
+			--argc, ++argv;
+		}
+		// output
+		else if (strEq(argv[0], "-o"))
+		{
+			if (out || argc < 2)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			out = argv[1];
+			argc -= 2, argv += 2;
+		}
+		// cache
+		else if (strEq(argv[0], "-cache"))
+		{
+			if (cache_file || argc < 2)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			cache_file = argv[1];
+			argc -= 2, argv += 2;
+		}
+		// pass
+		else if (strEq(argv[0], "-pass"))
+		{
+			if (pass || argc < 2)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			pass = argv[1];
+			argc -= 2, argv += 2;
+		}
+		// force
+		else if (strEq(argv[0], "-f"))
+		{
+			if (force)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			force = TRUE;
+			--argc, ++argv;
+		}
+		// jobs
+		else if (strEq(argv[0], "-j"))
+		{
+			if (jobs != SIZE_MAX || argc < 2 || !decIsValid(argv[1]) ||
+				strLen(argv[1]) == 0 || strLen(argv[1]) > 2 ||
+				decCLZ(argv[1]) || (jobs = (size_t)decToU32(argv[1])) == 0 ||
+				jobs > 64)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			argc -= 2, argv += 2;
+		}
+		// стандартный поток ввода
+		else if (strEq(argv[0], "-"))
+			break;
 		// --
 		else if (strEq(argv[0], "--"))
 		{
@@ -380,20 +1470,61 @@ int bsumMain(int argc, char* argv[])
 			break;
 		}
 	}
+	// belt-hash по умолчанию
+	if (hid_count == 0)
+		hids[hid_count++] = 0;
+	hid = hids[0];
 	// дополнительные проверки и обработка ошибок
-	if (code == ERR_OK && (argc < 1 || check && argc != 1))
+	if (code == ERR_OK && (argc < 1 || check && argc != 1 ||
+		!check && (quiet || progress) || !cache_file != !pass ||
+		!cache_file && force ||
+		chunks && (check || cache_file || hid > BSUM_HID_TREE) ||
+		hid_count > 1 && !out ||
+		out && (check || chunks || cache_file ||
+			bsumHidsHaveTree(hids, hid_count))))
 		code = ERR_CMD_PARAMS;
 	if (code != ERR_OK)
 	{
 		fprintf(stderr, "bee2cmd/%s: %s\n", _name, errMsg(code));
 		return -1;
 	}
-	// belt-hash по умолчанию
-	if (hid == SIZE_MAX)
-		hid = 0;
+	// один поток по умолчанию
+	if (jobs == SIZE_MAX)
+		jobs = 1;
 	// вычисление/проверка хэш-значениий
 	ASSERT(bsumHidIsValid(hid));
-	return check ? bsumCheck(hid, argv[0]) : bsumPrint(hid, argc, argv);
+	if (chunks)
+		return bsumPrintChunks(hid, jobs, argc, argv);
+	if (out)
+		return bsumPrintTo(hids, hid_count, out, jobs, argc, argv);
+	if (!cache_file)
+		return check ? bsumCheck(hid, jobs, 0, quiet, progress, argv[0]) :
+			bsumPrint(hid, jobs, 0, argc, argv);
+	// открыть кэш
+	code = cmdPwdRead(&pwd, pass);
+	if (code == ERR_OK)
+	{
+		code = bsumCacheStart(cache, cache_file, pwd, force);
+		cmdPwdClose(pwd);
+	}
+	if (code != ERR_OK)
+	{
+		fprintf(stderr, "bee2cmd/%s: %s: %s\n", _name, cache_file,
+			errMsg(code));
+		return -1;
+	}
+	// вычисление/проверка хэш-значений с кэшированием
+	ret = check ? bsumCheck(hid, jobs, cache, quiet, progress, argv[0]) :
+		bsumPrint(hid, jobs, cache, argc, argv);
+	code = bsumCacheFlush(cache);
+	bsumCacheClose(cache);
+	if (code != ERR_OK)
+	{
+		fprintf(stderr, "bee2cmd/%s: %s: %s\n", _name, cache_file,
+			errMsg(code));
+		ret = -1;
+	}
+	return ret;
 }
 
 /*
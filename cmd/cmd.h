@@ -4,7 +4,7 @@
 \brief Command-line interface to Bee2
 \project bee2/cmd
 \created 2022.06.09
-\version 2024.06.14
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -22,6 +22,7 @@ extern "C" {
 #include <bee2/core/err.h>
 #include <bee2/core/tm.h>
 #include <bee2/crypto/btok.h>
+#include <stdio.h>
 
 /*
 *******************************************************************************
@@ -64,6 +65,42 @@ err_t cmdReg(
 	cmd_main_i fn			/*!< [in] главная функция команды */
 );
 
+/*
+*******************************************************************************
+Самотестирование
+
+Результаты самотестов команд кэшируются в процессе и (при заданной
+переменной окружения BEE2CMD_SELFTEST) в файле маркеров, жестко
+привязанных к исполнимому файлу и процессору.
+*******************************************************************************
+*/
+
+/*!	\brief Самотест */
+typedef err_t (*cmd_selftest_i)();
+
+/*!	\brief Выполнение самотеста
+
+	Выполняется самотест fn с именем name. Если самотест уже выполнялся
+	в процессе, то возвращается сохраненный результат. Если задана
+	переменная окружения BEE2CMD_SELFTEST и в определяемом ею файле есть
+	маркер успешного выполнения самотеста для данных исполнимого файла
+	и процессора, то самотест не выполняется.
+	\return ERR_OK, если самотест пройден, и код ошибки в противном случае.
+	\remark После успешного выполнения самотеста его маркер записывается
+	в файл BEE2CMD_SELFTEST.
+*/
+err_t cmdSelfTest(
+	const char* name,		/*!< [in] имя самотеста */
+	cmd_selftest_i fn		/*!< [in] самотест */
+);
+
+/*!	\brief Принудительное самотестирование
+
+	Маркеры самотестов игнорируются: последующие вызовы cmdSelfTest()
+	выполняют самотесты (однократно в процессе).
+*/
+void cmdSelfTestForce();
+
 /*
 *******************************************************************************
 Терминал
@@ -244,6 +281,77 @@ err_t cmdFileDup(
 	size_t count		/*!< [in] число дублируемых октетов */
 );
 
+/*!	\brief Обработка содержимого файла
+
+	Первые count октетов файла file последовательно передаются функции
+	step() вместе с состоянием state. При count == SIZE_MAX передаются все
+	октеты файла. Обычный файл отображается в память (POSIX: mmap() с
+	рекомендацией MADV_SEQUENTIAL, Windows: MapViewOfFile()), и step()
+	обрабатывает фрагменты отображения. Если отобразить файл не удается
+	(например, это канал), то он читается фрагментами по buf_len октетов
+	с упреждением (см. cmdFileRdrStart()).
+	\return ERR_OK в случае успеха и код ошибки в противном случае.
+	\remark Сигнатура step() совпадает с сигнатурой функций beltHashStepH(),
+	bashHashStepH(), bashPrgAbsorbStep().
+*/
+err_t cmdFileStep(
+	const char* file,	/*!< [in] файл */
+	size_t count,		/*!< [in] число обрабатываемых октетов */
+	void (*step)(const void*, size_t, void*),	/*!< [in] обработка */
+	void* state,		/*!< [in,out] состояние step() */
+	size_t buf_len		/*!< [in] длина фрагмента при чтении */
+);
+
+/*!	\brief Упреждающее чтение
+
+	Описатель процесса упреждающего чтения из потока.
+*/
+typedef struct cmd_file_rdr_st cmd_file_rdr_t;
+
+/*!	\brief Запуск упреждающего чтения
+
+	Запускается чтение count октетов из потока fp фрагментами по buf_len
+	октетов. При count == SIZE_MAX читаются все октеты вплоть до конца
+	потока. Фрагменты читаются в отдельном потоке выполнения в несколько
+	буферов заранее, пока вызывающий поток обрабатывает ранее прочитанные
+	фрагменты. Описатель процесса чтения возвращается по адресу rdr.
+	\return ERR_OK в случае успеха и код ошибки в противном случае.
+	\remark Все фрагменты, кроме, может быть, последнего, имеют длину
+	buf_len.
+	\remark До вызова cmdFileRdrClose() поток fp используется только
+	процессом чтения.
+*/
+err_t cmdFileRdrStart(
+	cmd_file_rdr_t** rdr,	/*!< [out] процесс чтения */
+	FILE* fp,				/*!< [in,out] поток */
+	size_t count,			/*!< [in] число читаемых октетов */
+	size_t buf_len			/*!< [in] длина фрагмента */
+);
+
+/*!	\brief Очередной фрагмент
+
+	Из процесса чтения rdr извлекается очередной фрагмент [len]buf.
+	Нулевая длина len означает завершение чтения.
+	\return ERR_OK в случае успеха и код ошибки чтения в противном случае.
+	\remark Буфер buf остается корректным до следующего вызова
+	cmdFileRdrNext() или cmdFileRdrClose().
+*/
+err_t cmdFileRdrNext(
+	const void** buf,		/*!< [out] фрагмент */
+	size_t* len,			/*!< [out] длина фрагмента */
+	cmd_file_rdr_t* rdr		/*!< [in,out] процесс чтения */
+);
+
+/*!	\brief Завершение упреждающего чтения
+
+	Процесс чтения rdr останавливается, и его ресурсы освобождаются.
+	Поток, из которого выполнялось чтение, не закрывается.
+	\return ERR_OK или код ошибки чтения.
+*/
+err_t cmdFileRdrClose(
+	cmd_file_rdr_t* rdr		/*!< [in] процесс чтения */
+);
+
 /*!	\brief Чтение всего файла
 
 	Буфер [?count]buf прочитывается из файла file. При ненулевом buf
@@ -291,6 +399,34 @@ bool_t cmdFileAreSame(
 	const char* file2		/*!< [in] второй файл */
 );
 
+/*!	\brief Версия файла
+
+	Версия обычного файла описывается устройством и номером файла на нем
+	(POSIX: st_dev, st_ino; Windows: серийный номер тома, индекс файла),
+	размером и отметками времени последнего изменения содержимого (mtime)
+	и метаданных (ctime, только POSIX). Разные версии одного файла
+	отличаются размером или отметками времени.
+*/
+typedef struct {
+	u64 dev;			/*!< устройство */
+	u64 ino;			/*!< номер файла */
+	u64 size;			/*!< размер */
+	u64 mtime;			/*!< время изменения содержимого */
+	u64 ctime;			/*!< время изменения метаданных */
+} cmd_file_id_t;
+
+/*!	\brief Определение версии файла
+
+	Определяется версия id обычного файла file.
+	\return Признак успеха.
+	\remark Отметки времени задаются с максимальной точностью, которую
+	предоставляет система. Их можно только сравнивать.
+*/
+bool_t cmdFileId(
+	cmd_file_id_t* id,		/*!< [out] версия */
+	const char* file		/*!< [in] файл */
+);
+
 /*
 *******************************************************************************
 Командная строка
@@ -576,6 +712,73 @@ err_t cmdCVCsFind(
 	size_t cert_len					/*!< [in] длина сертификата */
 );
 
+/*!	\brief Поиск сертификата в коллекции по владельцу
+
+	В коллекции [certs_len]certs ведется поиск первого сертификата,
+	владельцем которого является holder. Смещение сертификата в коллекции
+	возвращается по адресу offset, длина -- по адресу cert_len.
+	\return ERR_OK, если сертификат найден, и код ошибки в противном случае.
+	\remark Сертификаты коллекции не разбираются полностью: владелец
+	сравнивается на месте по представлению (см. btokCVCView()).
+	\remark Адреса offset и cert_len могут быть нулевыми, и тогда данные по
+	этим адресам не возвращаются.
+*/
+err_t cmdCVCsFindHolder(
+	size_t* offset,					/*!< [out] смещение сертификата */
+	size_t* cert_len,				/*!< [out] длина сертификата */
+	const octet* certs,				/*!< [in] коллекция сертификатов */
+	size_t certs_len,				/*!< [in] длина коллекции */
+	const char* holder				/*!< [in] владелец */
+);
+
+/*!	\brief Элемент индекса коллекции сертификатов
+
+	Элемент индекса описывает сертификат коллекции: метку (первые
+	8 октетов хэш-значения belt-hash сертификата), смещение в коллекции
+	и длину.
+*/
+typedef struct {
+	octet tag[8];					/*!< метка сертификата */
+	size_t offset;					/*!< смещение сертификата */
+	size_t len;						/*!< длина сертификата */
+} cmd_cvcs_idx_t;
+
+/*!	\brief Индексирование коллекции сертификатов
+
+	Строится индекс [count]idx коллекции [certs_len]certs. Элементы индекса
+	упорядочиваются по меткам.
+	\pre Буфер idx содержит не менее cmdCVCsCount(certs, certs_len)
+	элементов.
+	\return ERR_OK, если индекс построен, и код ошибки в противном случае.
+	\remark При idx == 0 определяется только число элементов индекса.
+	\remark Индекс строится за один проход по коллекции и позволяет затем
+	искать сертификаты за логарифмическое время (см. cmdCVCsIdxFind()).
+*/
+err_t cmdCVCsIdx(
+	cmd_cvcs_idx_t* idx,			/*!< [out] индекс */
+	size_t* count,					/*!< [out] число элементов индекса */
+	const octet* certs,				/*!< [in] коллекция сертификатов */
+	size_t certs_len				/*!< [in] длина коллекции */
+);
+
+/*!	\brief Поиск сертификата по индексу
+
+	В коллекции certs с индексом [count]idx ведется поиск сертификата
+	[cert_len]cert. Его смещение в коллекции возвращается по адресу offset.
+	\pre Индекс построен функцией cmdCVCsIdx().
+	\return ERR_OK, если сертификат найден, и код ошибки в противном случае.
+	\remark Адрес offset может быть нулевым, и тогда данные по этому адресу
+	не возвращаются.
+*/
+err_t cmdCVCsIdxFind(
+	size_t* offset,					/*!< [out] смещение сертификата */
+	const cmd_cvcs_idx_t* idx,		/*!< [in] индекс */
+	size_t count,					/*!< [in] число элементов индекса */
+	const octet* certs,				/*!< [in] коллекция сертификатов */
+	const octet* cert,				/*!< [in] cертификат */
+	size_t cert_len					/*!< [in] длина сертификата */
+);
+
 /*!	\brief Проверка коллекции сертификатов
 
 	Проверяется корректность сертификатов коллекции [certs_len]certs.
@@ -699,6 +902,28 @@ err_t cmdSigSign(
 	size_t privkey_len			/*!< [in] длина личного ключа */
 );
 
+/*!	\brief Подпись заголовка файла
+
+	Подписываются только первые head_len октетов файла file. В остальном
+	функция работает так же, как cmdSigSign(). При head_len == SIZE_MAX
+	подписывается все содержимое file.
+	\expect{ERR_BAD_FORMAT} Длина file не меньше head_len.
+	\return ERR_OK, если заголовок успешно подписан, и код ошибки
+	в противном случае.
+	\remark Октеты file, которые следуют за заголовком, не защищаются
+	подписью. Их целостность должна контролироваться через заголовок
+	(см. манифесты в sig.c).
+*/
+err_t cmdSigSignHead(
+	const char* sig_file,		/*!< [in] файл подписи */
+	const char* file,			/*!< [in] подписываемый файл */
+	size_t head_len,			/*!< [in] длина заголовка */
+	const char* certs,			/*!< [in] цепочка сертификатов */
+	const octet date[6],		/*!< [in] дата подписания */
+	const octet privkey[],		/*!< [in] личный ключ */
+	size_t privkey_len			/*!< [in] длина личного ключа */
+);
+
 /*!	\brief Чтение подписи
 
 	Из файла sig_file прочитывается подпись sig. При ненулевом sig_len по этому
@@ -738,6 +963,23 @@ err_t cmdSigVerify(
 	size_t pubkey_len			/*!< [in] длина открытого ключа */
 );
 
+/*!	\brief Проверка подписи заголовка файла на открытом ключе
+
+	Проверяется подпись первых head_len октетов файла file, выработанная
+	функцией cmdSigSignHead(). В остальном функция работает так же, как
+	cmdSigVerify().
+	\expect{ERR_BAD_FORMAT} Длина file без присоединенной подписи
+	не меньше head_len.
+	\return ERR_OK, если подпись корректна, и код ошибки в противном случае.
+*/
+err_t cmdSigVerifyHead(
+	const char* file,			/*!< [in] подписанный файл */
+	const char* sig_file,		/*!< [in] файл подписи */
+	size_t head_len,			/*!< [in] длина заголовка */
+	const octet pubkey[],		/*!< [in] открытый ключ */
+	size_t pubkey_len			/*!< [in] длина открытого ключа */
+);
+
 /*!	\brief Проверка подписи файла на доверенном сертификате
 
 	Подпись содержимого файла file, размещенная в sig_file, проверяется
@@ -764,6 +1006,23 @@ err_t cmdSigVerify2(
 	size_t anchor_len			/*!< [in] длина anchor */
 );
 
+/*!	\brief Проверка подписи заголовка файла на доверенном сертификате
+
+	Проверяется подпись первых head_len октетов файла file, выработанная
+	функцией cmdSigSignHead(). В остальном функция работает так же, как
+	cmdSigVerify2().
+	\expect{ERR_BAD_FORMAT} Длина file без присоединенной подписи
+	не меньше head_len.
+	\return ERR_OK, если подпись корректна, и код ошибки в противном случае.
+*/
+err_t cmdSigVerify2Head(
+	const char* file,			/*!< [in] подписанный файл */
+	const char* sig_file,		/*!< [in] файл подписи */
+	size_t head_len,			/*!< [in] длина заголовка */
+	const octet anchor[],		/*!< [in] доверенный сертификат */
+	size_t anchor_len			/*!< [in] длина anchor */
+);
+
 /*!	\brief Самопроверка подписи на открытом ключе
 
 	Подпись исполнимого файла, в котором вызывается данная функция,
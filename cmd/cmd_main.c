@@ -4,7 +4,7 @@
 \brief Command-line interface to Bee2: main
 \project bee2/cmd
 \created 2022.06.07
-\version 2023.12.19
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -66,7 +66,7 @@ int cmdUsage()
 	// перечень команд
 	printf(
 		"Usage:\n"
-		"  bee2cmd {");
+		"  bee2cmd [-selftest] {");
 	for (pos = 0; pos + 1 < _count; ++pos)
 		printf("%s|", _cmds[pos].name);
 	printf("%s} ...\n", _cmds[pos].name);
@@ -118,6 +118,8 @@ extern err_t cvrInit();
 extern err_t sigInit();
 extern err_t csrInit();
 extern err_t esInit();
+extern err_t serveInit();
+extern err_t encInit();
 #ifdef OS_WIN
 extern err_t stampInit();
 #endif
@@ -144,6 +146,10 @@ err_t cmdInit()
 	ERR_CALL_CHECK(code);
 	code = esInit();
 	ERR_CALL_CHECK(code);
+	code = serveInit();
+	ERR_CALL_CHECK(code);
+	code = encInit();
+	ERR_CALL_CHECK(code);
 #ifdef OS_WIN
 	code = stampInit();
 	ERR_CALL_CHECK(code);
@@ -168,6 +174,9 @@ int main(int argc, char* argv[])
 		printf("bee2cmd: %s\n", errMsg(code));
 		return -1;
 	}
+	// принудительное самотестирование
+	if (argc >= 2 && strEq(argv[1], "-selftest"))
+		cmdSelfTestForce(), --argc, ++argv;
 	// справка
 	if (argc < 2)
 		return cmdUsage();
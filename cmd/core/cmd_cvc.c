@@ -4,7 +4,7 @@
 \brief Command-line interface to Bee2: managing CV-certificates
 \project bee2/cmd
 \created 2022.08.20
-\version 2023.06.19
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -15,9 +15,12 @@
 #include <bee2/core/blob.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
 #include <bee2/core/str.h>
 #include <bee2/core/util.h>
+#include <bee2/crypto/belt.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 /*
 *******************************************************************************
@@ -226,6 +229,102 @@ err_t cmdCVCsFind(size_t* offset, const octet* certs, size_t certs_len,
 	return ERR_NOT_FOUND;
 }
 
+err_t cmdCVCsFindHolder(size_t* offset, size_t* cert_len, const octet* certs,
+	size_t certs_len, const char* holder)
+{
+	btok_cvc_view_t view[1];
+	size_t pos;
+	// pre
+	ASSERT(memIsValid(certs, certs_len));
+	ASSERT(strIsValid(holder));
+	ASSERT(memIsNullOrValid(offset, O_PER_S));
+	ASSERT(memIsNullOrValid(cert_len, O_PER_S));
+	// цикл по сертификатам
+	for (pos = 0; certs_len; )
+	{
+		size_t len = btokCVCLen(certs, certs_len);
+		if (len == SIZE_MAX || btokCVCView(view, certs, len) != ERR_OK)
+			return ERR_BAD_CERTRING;
+		if (btokCVCViewIsHolder(view, certs, holder))
+		{
+			if (offset)
+				*offset = pos;
+			if (cert_len)
+				*cert_len = len;
+			return ERR_OK;
+		}
+		pos += len, certs += len, certs_len -= len;
+	}
+	return ERR_NOT_FOUND;
+}
+
+static int cmdCVCsIdxCmp(const void* a, const void* b)
+{
+	return memCmp(((const cmd_cvcs_idx_t*)a)->tag,
+		((const cmd_cvcs_idx_t*)b)->tag, 8);
+}
+
+err_t cmdCVCsIdx(cmd_cvcs_idx_t* idx, size_t* count, const octet* certs,
+	size_t certs_len)
+{
+	octet hash[32];
+	size_t pos;
+	// pre
+	ASSERT(memIsValid(certs, certs_len));
+	ASSERT(memIsValid(count, O_PER_S));
+	// цикл по сертификатам
+	for (pos = 0, *count = 0; pos < certs_len; ++*count)
+	{
+		size_t len = btokCVCLen(certs + pos, certs_len - pos);
+		if (len == SIZE_MAX)
+			return ERR_BAD_CERTRING;
+		if (idx)
+		{
+			ASSERT(memIsValid(idx + *count, sizeof(cmd_cvcs_idx_t)));
+			beltHash(hash, certs + pos, len);
+			memCopy(idx[*count].tag, hash, 8);
+			idx[*count].offset = pos;
+			idx[*count].len = len;
+		}
+		pos += len;
+	}
+	// упорядочить индекс
+	if (idx && *count)
+		qsort(idx, *count, sizeof(cmd_cvcs_idx_t), cmdCVCsIdxCmp);
+	return ERR_OK;
+}
+
+err_t cmdCVCsIdxFind(size_t* offset, const cmd_cvcs_idx_t* idx, size_t count,
+	const octet* certs, const octet* cert, size_t cert_len)
+{
+	octet hash[32];
+	size_t lo, hi;
+	// pre
+	ASSERT(memIsValid(idx, count * sizeof(cmd_cvcs_idx_t)));
+	ASSERT(memIsValid(cert, cert_len));
+	ASSERT(memIsNullOrValid(offset, O_PER_S));
+	// найти первый элемент с меткой не меньше метки cert
+	beltHash(hash, cert, cert_len);
+	for (lo = 0, hi = count; lo < hi; )
+	{
+		size_t mid = lo + (hi - lo) / 2;
+		if (memCmp(idx[mid].tag, hash, 8) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	// перебрать элементы с совпадающими метками
+	for (; lo < count && memEq(idx[lo].tag, hash, 8); ++lo)
+		if (idx[lo].len == cert_len &&
+			memEq(certs + idx[lo].offset, cert, cert_len))
+		{
+			if (offset)
+				*offset = idx[lo].offset;
+			return ERR_OK;
+		}
+	return ERR_NOT_FOUND;
+}
+
 err_t cmdCVCsCheck(const octet* certs, size_t certs_len)
 {
 	err_t code;
@@ -255,51 +354,117 @@ err_t cmdCVCsCheck(const octet* certs, size_t certs_len)
 	return code;
 }
 
+/*
+*******************************************************************************
+Проверка цепочки сертификатов
+
+Сначала все сертификаты цепочки разбираются без проверки подписей. Затем
+звенья цепочки (подпись сертификата на ключе предшественника, соответствие
+предшественнику, для последнего сертификата -- дата) проверяются
+в btokCVCVal2() независимо друг от друга, в задачах пула потоков.
+Если звено одно или пул создать не удалось, то звенья проверяются
+в вызывающем потоке.
+
+Если очередной сертификат не удалось разобрать, то цепочка обрывается на нем,
+а сам он проверяется как последнее звено: btokCVCVal2() вернет ту же
+ошибку, что и при последовательном проходе. Коды звеньев просматриваются
+по порядку, поэтому возвращается тот же код, что и при последовательной
+проверке.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	const octet* cert;			/*< сертификат */
+	size_t len;					/*< длина сертификата */
+	const btok_cvc_t* cvca;		/*< содержание сертификата издателя */
+	const octet* date;			/*< дата проверки */
+	err_t code;					/*< результат проверки */
+} cmd_cvcs_link_t;
+
+static void cmdCVCsValTask(void* arg, void* scratch)
+{
+	cmd_cvcs_link_t* link = (cmd_cvcs_link_t*)arg;
+	link->code = btokCVCVal2(0, link->cert, link->len, link->cvca,
+		link->date);
+}
+
 err_t cmdCVCsVal(const octet* certs, size_t certs_len, const octet date[6])
 {
 	err_t code;
 	void* stack;
-	size_t len;
-	btok_cvc_t* cvca;
-	btok_cvc_t* cvc;
+	size_t count, len, pos, i;
+	btok_cvc_t* cvcs;
+	cmd_cvcs_link_t* links;
+	mt_pool_t* pool;
 	// pre
 	ASSERT(memIsValid(certs, certs_len));
 	ASSERT(memIsNullOrValid(date, 6));
 	// пустая цепочка?
 	if (!certs_len)
 		return ERR_OK;
+	if (date && memIsZero(date, 6))
+		date = 0;
+	// подсчитать сертификаты
+	for (count = pos = 0; pos < certs_len; pos += len)
+	{
+		len = btokCVCLen(certs + pos, certs_len - pos);
+		++count;
+		if (len == SIZE_MAX)
+			break;
+	}
 	// выделить и разметить память
-	code = cmdBlobCreate(stack, 2 * sizeof(btok_cvc_t));
+	code = cmdBlobCreate(stack,
+		count * (sizeof(btok_cvc_t) + sizeof(cmd_cvcs_link_t)));
 	ERR_CALL_CHECK(code);
-	cvca = (btok_cvc_t*)stack;
-	cvc = cvca + 1;
-	// найти и разобрать первый сертификат
-	len = btokCVCLen(certs, certs_len);
-	if (len == SIZE_MAX)
-		code = ERR_BAD_CERT;
-	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
-	code = btokCVCUnwrap(cvca, certs, len, 0, 0);
-	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
-	certs_len -= len, certs += len;
-	// цикл по остальным сертификатам
-	while (certs_len)
+	cvcs = (btok_cvc_t*)stack;
+	links = (cmd_cvcs_link_t*)(cvcs + count);
+	// разобрать сертификаты
+	for (i = pos = 0; i < count; ++i, pos += len)
 	{
-		// разобрать сертификат
-		len = btokCVCLen(certs, certs_len);
+		len = btokCVCLen(certs + pos, certs_len - pos);
 		if (len == SIZE_MAX)
 			code = ERR_BAD_CERT;
-		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
-		// проверить сертификат
-		if (len == certs_len && date && !memIsZero(date, 6))
-			code = btokCVCVal2(cvc, certs, len, cvca, date);
 		else
-			code = btokCVCVal2(cvc, certs, len, cvca, 0);
-		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
-		// к следующему сертификату
-		certs_len -= len, certs += len;
-		// издатель <- эмитент
-		memCopy(cvca, cvc, sizeof(btok_cvc_t));
+			code = btokCVCUnwrap(cvcs + i, certs + pos, len, 0, 0);
+		// первый сертификат?
+		if (i == 0)
+		{
+			ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+		}
+		// звено i (сертификат без длины не проверяется)
+		else
+		{
+			links[i].cert = len == SIZE_MAX ? 0 : certs + pos;
+			links[i].len = len;
+			links[i].cvca = cvcs + i - 1;
+			links[i].date = pos + len == certs_len ? date : 0;
+			links[i].code = code;
+		}
+		// оборвать цепочку?
+		if (code != ERR_OK)
+		{
+			count = i + 1;
+			break;
+		}
+	}
+	// проверить звенья
+	pool = count > 2 ? mtPoolCreate(0, 0, 0) : 0;
+	for (i = 1; i < count; ++i)
+		if (!links[i].cert)
+			continue;
+		else if (pool)
+			mtPoolSubmit(pool, cmdCVCsValTask, links + i);
+		else
+			cmdCVCsValTask(links + i, 0);
+	if (pool)
+	{
+		mtPoolWait(pool);
+		mtPoolClose(pool);
 	}
+	// первое некорректное звено
+	for (code = ERR_OK, i = 1; code == ERR_OK && i < count; ++i)
+		code = links[i].code;
 	// завершить
 	cmdBlobClose(stack);
 	return code;
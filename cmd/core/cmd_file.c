@@ -4,7 +4,7 @@
 \brief Command-line interface to Bee2: file management
 \project bee2/cmd 
 \created 2022.06.08
-\version 2024.06.14
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -14,14 +14,28 @@
 #include <bee2/core/blob.h>
 #include <bee2/core/err.h>
 #include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
 #include <bee2/core/str.h>
 #include <bee2/core/util.h>
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef OS_UNIX
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#elif defined OS_WIN
+	#include <windows.h>
+#endif
 
 /*
 *******************************************************************************
 Размер файла
+
+Размер обычного файла определяется через stat() / GetFileAttributesEx()
+и не ограничивается диапазоном long (ftell()). Такое ограничение
+действует в Windows и 32-битных системах и не позволяет обрабатывать
+файлы размером более 2 Гб.
 *******************************************************************************
 */
 
@@ -29,7 +43,26 @@ size_t cmdFileSize(const char* file)
 {
 	FILE* fp;
 	long size;
+#if defined OS_UNIX
+	struct stat st;
+#elif defined OS_WIN
+	WIN32_FILE_ATTRIBUTE_DATA fa;
+#endif
 	ASSERT(strIsValid(file));
+	// обычный файл: размер без ограничений long
+#if defined OS_UNIX
+	if (stat(file, &st) == 0 && S_ISREG(st.st_mode))
+		return (st.st_size < 0 || (off_t)(size_t)st.st_size != st.st_size) ?
+			SIZE_MAX : (size_t)st.st_size;
+#elif defined OS_WIN
+	if (GetFileAttributesExA(file, GetFileExInfoStandard, &fa) &&
+		!(fa.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+	{
+		ULONGLONG s = (ULONGLONG)fa.nFileSizeHigh << 32 | fa.nFileSizeLow;
+		return ((ULONGLONG)(size_t)s != s) ? SIZE_MAX : (size_t)s;
+	}
+#endif
+	// прочие файлы
 	if (!(fp = fopen(file, "rb")))
 		return SIZE_MAX;
 	if (fseek(fp, 0, SEEK_END))
@@ -118,6 +151,356 @@ err_t cmdFileReadAll(void* buf, size_t* count, const char* file)
 	return ERR_OK;
 }
 
+/*
+*******************************************************************************
+Упреждающее чтение
+
+Фрагменты читаются в отдельном потоке в кольцо из CMD_FILE_RDR_BUFS
+буферов. Поток-читатель заполняет свободные буферы, вызывающий поток
+получает заполненные буферы в cmdFileRdrNext(). Буфер, полученный при
+предыдущем вызове cmdFileRdrNext(), возвращается в кольцо при следующем
+вызове. Таким образом, пока вызывающий поток обрабатывает один буфер,
+читатель заполняет остальные, и ожидание чтения совмещается
+с обработкой.
+
+Если поток создать не удается (или ОС не распознана), то фрагменты
+читаются непосредственно в cmdFileRdrNext().
+*******************************************************************************
+*/
+
+#define CMD_FILE_RDR_BUFS 3
+
+struct cmd_file_rdr_st
+{
+	FILE* fp;					/*< поток чтения */
+	size_t count;				/*< число непрочитанных октетов */
+	size_t buf_len;				/*< длина буфера */
+	octet* bufs;				/*< [CMD_FILE_RDR_BUFS * buf_len] буферы */
+	size_t lens[CMD_FILE_RDR_BUFS];	/*< длины фрагментов в буферах */
+	size_t head;				/*< число заполненных буферов */
+	size_t tail;				/*< число освобожденных буферов */
+	bool_t held;				/*< буфер tail выдан? */
+	bool_t eof;					/*< чтение завершено? */
+	bool_t stop;				/*< остановить читателя? */
+	err_t code;					/*< результат чтения */
+	bool_t async;				/*< работает читатель? */
+	mt_mtx_t mtx[1];			/*< мьютекс */
+	mt_cnd_t cnd[1];			/*< условная переменная */
+	mt_thrd_t thrd[1];			/*< читатель */
+};
+
+static bool_t cmdFileRdrRead(octet* buf, size_t* len, cmd_file_rdr_t* rdr)
+{
+	size_t c;
+	ASSERT(rdr->count);
+	c = fread(buf, 1, MIN2(rdr->count, rdr->buf_len), rdr->fp);
+	if (c != MIN2(rdr->count, rdr->buf_len) &&
+		(rdr->count != SIZE_MAX || ferror(rdr->fp)))
+	{
+		rdr->code = ERR_FILE_READ;
+		return FALSE;
+	}
+	if (rdr->count != SIZE_MAX)
+		rdr->count -= c;
+	else if (c < rdr->buf_len)
+		rdr->count = 0;
+	*len = c;
+	return c > 0;
+}
+
+static void cmdFileRdrMain(void* arg)
+{
+	cmd_file_rdr_t* rdr = (cmd_file_rdr_t*)arg;
+	size_t slot, len;
+	bool_t ok;
+	mtMtxLock(rdr->mtx);
+	while (!rdr->stop && rdr->count)
+	{
+		// ждать свободного буфера
+		if (rdr->head - rdr->tail == CMD_FILE_RDR_BUFS)
+		{
+			mtCndWait(rdr->cnd, rdr->mtx);
+			continue;
+		}
+		slot = rdr->head % CMD_FILE_RDR_BUFS;
+		// читать без блокировки
+		mtMtxUnlock(rdr->mtx);
+		ok = cmdFileRdrRead(rdr->bufs + slot * rdr->buf_len, &len, rdr);
+		mtMtxLock(rdr->mtx);
+		if (!ok)
+			break;
+		rdr->lens[slot] = len, ++rdr->head;
+		mtCndBroadcast(rdr->cnd);
+	}
+	rdr->eof = TRUE;
+	mtCndBroadcast(rdr->cnd);
+	mtMtxUnlock(rdr->mtx);
+}
+
+err_t cmdFileRdrStart(cmd_file_rdr_t** rdr, FILE* fp, size_t count,
+	size_t buf_len)
+{
+	err_t code;
+	cmd_file_rdr_t* r;
+	// pre
+	ASSERT(memIsValid(rdr, sizeof(cmd_file_rdr_t*)));
+	ASSERT(fp);
+	ASSERT(buf_len > 0);
+	// выделить память и разметить ее
+	code = cmdBlobCreate(r, sizeof(cmd_file_rdr_t) +
+		CMD_FILE_RDR_BUFS * buf_len);
+	ERR_CALL_CHECK(code);
+	r->fp = fp, r->count = count, r->buf_len = buf_len;
+	r->bufs = (octet*)(r + 1);
+	r->code = ERR_OK;
+	// запустить читателя
+#if defined OS_UNIX || defined OS_WIN
+	if (count && mtMtxCreate(r->mtx))
+	{
+		if (!mtCndCreate(r->cnd))
+			mtMtxClose(r->mtx);
+		else if (!mtThrdCreate(r->thrd, cmdFileRdrMain, r))
+			mtCndClose(r->cnd), mtMtxClose(r->mtx);
+		else
+			r->async = TRUE;
+	}
+#endif
+	*rdr = r;
+	return ERR_OK;
+}
+
+err_t cmdFileRdrNext(const void** buf, size_t* len, cmd_file_rdr_t* rdr)
+{
+	err_t code;
+	size_t slot;
+	// pre
+	ASSERT(memIsValid(buf, sizeof(const void*)));
+	ASSERT(memIsValid(len, O_PER_S));
+	ASSERT(memIsValid(rdr, sizeof(cmd_file_rdr_t)));
+	// синхронное чтение
+	if (!rdr->async)
+	{
+		*buf = rdr->bufs, *len = 0;
+		if (rdr->count && rdr->code == ERR_OK)
+			cmdFileRdrRead(rdr->bufs, len, rdr);
+		return rdr->code;
+	}
+	// вернуть ранее выданный буфер и ждать следующего
+	mtMtxLock(rdr->mtx);
+	if (rdr->held)
+	{
+		++rdr->tail, rdr->held = FALSE;
+		mtCndBroadcast(rdr->cnd);
+	}
+	while (rdr->head == rdr->tail && !rdr->eof)
+		mtCndWait(rdr->cnd, rdr->mtx);
+	if (rdr->head != rdr->tail)
+	{
+		slot = rdr->tail % CMD_FILE_RDR_BUFS;
+		*buf = rdr->bufs + slot * rdr->buf_len, *len = rdr->lens[slot];
+		rdr->held = TRUE;
+		code = ERR_OK;
+	}
+	else
+		*buf = rdr->bufs, *len = 0, code = rdr->code;
+	mtMtxUnlock(rdr->mtx);
+	return code;
+}
+
+err_t cmdFileRdrClose(cmd_file_rdr_t* rdr)
+{
+	err_t code;
+	ASSERT(memIsNullOrValid(rdr, sizeof(cmd_file_rdr_t)));
+	if (!rdr)
+		return ERR_OK;
+	// остановить читателя
+	if (rdr->async)
+	{
+		mtMtxLock(rdr->mtx);
+		rdr->stop = TRUE;
+		mtCndBroadcast(rdr->cnd);
+		mtMtxUnlock(rdr->mtx);
+		mtThrdJoin(rdr->thrd);
+		mtCndClose(rdr->cnd);
+		mtMtxClose(rdr->mtx);
+	}
+	code = rdr->code;
+	cmdBlobClose(rdr);
+	return code;
+}
+
+/*
+*******************************************************************************
+Обработка содержимого
+
+Файл отображается в память окнами по CMD_FILE_WINDOW октетов, окна
+последовательно передаются функции step(). Размер окна кратен гранулярности
+отображения (размеру страницы в POSIX, 64 Кб в Windows). Если файл
+не удается отобразить (например, это канал или пустой файл), то функция
+cmdFileStepMap() возвращает открытый для чтения поток fp и файл читается
+фрагментами по buf_len октетов с упреждением (см. cmdFileRdrStart()).
+
+В POSIX перед обработкой окна ядру сообщается, что потребуются данные
+этого и следующего окон (madvise(MADV_WILLNEED), posix_fadvise()).
+Ядро начинает их чтение асинхронно, и ожидание диска совмещается
+с обработкой.
+*******************************************************************************
+*/
+
+#define CMD_FILE_WINDOW ((size_t)1 << 26)
+
+#ifdef OS_UNIX
+
+static err_t cmdFileStepMap(FILE** fp, const char* file, size_t count,
+	void (*step)(const void*, size_t, void*), void* state)
+{
+	int fd;
+	struct stat st;
+	off_t offset;
+	size_t size;
+	void* map;
+	// открыть файл
+	*fp = 0;
+	if ((fd = open(file, O_RDONLY)) == -1)
+		return ERR_FILE_OPEN;
+	// отображение невозможно?
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+		(off_t)(size_t)st.st_size != st.st_size)
+	{
+		if (!(*fp = fdopen(fd, "rb")))
+		{
+			close(fd);
+			return ERR_FILE_OPEN;
+		}
+		return ERR_OK;
+	}
+	size = (size_t)st.st_size;
+	if (count == SIZE_MAX)
+		count = size;
+	else if (count > size)
+	{
+		close(fd);
+		return ERR_FILE_READ;
+	}
+	// обработать окна
+	for (offset = 0; count; offset += CMD_FILE_WINDOW)
+	{
+		size = MIN2(count, CMD_FILE_WINDOW);
+		map = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, offset);
+		if (map == MAP_FAILED)
+		{
+			close(fd);
+			return ERR_FILE_READ;
+		}
+#ifdef MADV_SEQUENTIAL
+		madvise(map, size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_WILLNEED
+		madvise(map, size, MADV_WILLNEED);
+#endif
+#ifdef POSIX_FADV_WILLNEED
+		if (count > size)
+			posix_fadvise(fd, offset + (off_t)size,
+				(off_t)MIN2(count - size, CMD_FILE_WINDOW),
+				POSIX_FADV_WILLNEED);
+#endif
+		step(map, size, state);
+		munmap(map, size);
+		count -= size;
+	}
+	return close(fd) == 0 ? ERR_OK : ERR_BAD_FILE;
+}
+
+#elif defined OS_WIN
+
+static err_t cmdFileStepMap(FILE** fp, const char* file, size_t count,
+	void (*step)(const void*, size_t, void*), void* state)
+{
+	HANDLE fh;
+	HANDLE mh;
+	LARGE_INTEGER size;
+	ULONGLONG offset;
+	size_t len;
+	void* map;
+	// открыть файл
+	*fp = 0;
+	fh = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if (fh == INVALID_HANDLE_VALUE)
+		return ERR_FILE_OPEN;
+	// отображение невозможно?
+	if (GetFileType(fh) != FILE_TYPE_DISK || !GetFileSizeEx(fh, &size) ||
+		size.QuadPart <= 0 ||
+		(ULONGLONG)(size_t)size.QuadPart != (ULONGLONG)size.QuadPart ||
+		!(mh = CreateFileMappingA(fh, 0, PAGE_READONLY, 0, 0, 0)))
+	{
+		CloseHandle(fh);
+		return (*fp = fopen(file, "rb")) ? ERR_OK : ERR_FILE_OPEN;
+	}
+	if (count == SIZE_MAX)
+		count = (size_t)size.QuadPart;
+	else if (count > (size_t)size.QuadPart)
+	{
+		CloseHandle(mh), CloseHandle(fh);
+		return ERR_FILE_READ;
+	}
+	// обработать окна
+	for (offset = 0; count; offset += CMD_FILE_WINDOW)
+	{
+		len = MIN2(count, CMD_FILE_WINDOW);
+		map = MapViewOfFile(mh, FILE_MAP_READ, (DWORD)(offset >> 32),
+			(DWORD)offset, len);
+		if (!map)
+		{
+			CloseHandle(mh), CloseHandle(fh);
+			return ERR_FILE_READ;
+		}
+		step(map, len, state);
+		UnmapViewOfFile(map);
+		count -= len;
+	}
+	CloseHandle(mh);
+	return CloseHandle(fh) ? ERR_OK : ERR_BAD_FILE;
+}
+
+#else
+
+static err_t cmdFileStepMap(FILE** fp, const char* file, size_t count,
+	void (*step)(const void*, size_t, void*), void* state)
+{
+	return (*fp = fopen(file, "rb")) ? ERR_OK : ERR_FILE_OPEN;
+}
+
+#endif
+
+err_t cmdFileStep(const char* file, size_t count,
+	void (*step)(const void*, size_t, void*), void* state, size_t buf_len)
+{
+	err_t code;
+	FILE* fp;
+	cmd_file_rdr_t* rdr;
+	const void* buf;
+	size_t c;
+	// pre
+	ASSERT(strIsValid(file));
+	ASSERT(buf_len > 0);
+	// отобразить в память или открыть для чтения
+	code = cmdFileStepMap(&fp, file, count, step, state);
+	if (code != ERR_OK || !fp)
+		return code;
+	// запустить упреждающее чтение
+	code = cmdFileRdrStart(&rdr, fp, count, buf_len);
+	ERR_CALL_HANDLE(code, fclose(fp));
+	// обрабатывать фрагменты
+	while ((code = cmdFileRdrNext(&buf, &c, rdr)) == ERR_OK && c)
+		step(buf, c, state);
+	// завершить
+	cmdFileRdrClose(rdr);
+	if (fclose(fp) != 0)
+		code = (code != ERR_OK) ? code : ERR_BAD_FILE;
+	return code;
+}
+
 /*
 *******************************************************************************
 Дублирование
@@ -250,3 +633,62 @@ bool_t cmdFileAreSame(const char* file1, const char* file2)
 #endif
 	return ret;
 }
+
+/*
+*******************************************************************************
+Версия файла
+*******************************************************************************
+*/
+
+bool_t cmdFileId(cmd_file_id_t* id, const char* file)
+{
+#if defined OS_UNIX
+	struct stat st;
+	ASSERT(memIsValid(id, sizeof(cmd_file_id_t)));
+	ASSERT(strIsValid(file));
+	if (stat(file, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < 0)
+		return FALSE;
+	id->dev = (u64)st.st_dev;
+	id->ino = (u64)st.st_ino;
+	id->size = (u64)st.st_size;
+#if defined(__linux__)
+	id->mtime = (u64)st.st_mtim.tv_sec * 1000000000u +
+		(u64)st.st_mtim.tv_nsec;
+	id->ctime = (u64)st.st_ctim.tv_sec * 1000000000u +
+		(u64)st.st_ctim.tv_nsec;
+#elif defined(__APPLE__)
+	id->mtime = (u64)st.st_mtimespec.tv_sec * 1000000000u +
+		(u64)st.st_mtimespec.tv_nsec;
+	id->ctime = (u64)st.st_ctimespec.tv_sec * 1000000000u +
+		(u64)st.st_ctimespec.tv_nsec;
+#else
+	id->mtime = (u64)st.st_mtime;
+	id->ctime = (u64)st.st_ctime;
+#endif
+	return TRUE;
+#elif defined OS_WIN
+	HANDLE h;
+	BY_HANDLE_FILE_INFORMATION fi;
+	bool_t ret;
+	ASSERT(memIsValid(id, sizeof(cmd_file_id_t)));
+	ASSERT(strIsValid(file));
+	h = CreateFileA(file, 0, FILE_SHARE_READ | FILE_SHARE_WRITE |
+		FILE_SHARE_DELETE, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (h == INVALID_HANDLE_VALUE)
+		return FALSE;
+	ret = GetFileInformationByHandle(h, &fi) &&
+		!(fi.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY);
+	CloseHandle(h);
+	if (!ret)
+		return FALSE;
+	id->dev = (u64)fi.dwVolumeSerialNumber;
+	id->ino = (u64)fi.nFileIndexHigh << 32 | fi.nFileIndexLow;
+	id->size = (u64)fi.nFileSizeHigh << 32 | fi.nFileSizeLow;
+	id->mtime = (u64)fi.ftLastWriteTime.dwHighDateTime << 32 |
+		fi.ftLastWriteTime.dwLowDateTime;
+	id->ctime = 0;
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
@@ -4,7 +4,7 @@
 \brief Command-line interface to Bee2: password management
 \project bee2/cmd 
 \created 2022.06.13
-\version 2024.06.14
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -205,12 +205,12 @@ static err_t cmdPwdGenShare_internal(cmd_pwd_t* pwd, size_t scount,
 	code = cmdBlobCreate(stack, len +
 		utilMax(2,
 			beltMAC_keep(),
-			scount * (len + 1) + epki_len + 8));
+			scount * (len + 1 + 8 + epki_len)));
 	ERR_CALL_CHECK(code);
 	pwd_bin = (octet*)stack;
 	state = share = pwd_bin + len;
 	salt = share + scount * (len + 1);
-	epki = salt + 8;
+	epki = salt + 8 * scount;
 	// генерировать пароль
 	if (crc)
 	{
@@ -226,15 +226,14 @@ static err_t cmdPwdGenShare_internal(cmd_pwd_t* pwd, size_t scount,
 	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	// обновить ключ ГСЧ
 	rngRekey();
-	// защитить частичные секреты
-	for (; scount--; share += (len + 1), ++shares)
+	// защитить частичные секреты (одновременно)
+	rngStepR(salt, 8 * scount, 0);
+	code = bpkiShareWrapMB(epki, 0, share, len + 1, (const octet*)spwd,
+		cmdPwdLen(spwd), salt, iter, scount);
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	// записать в файлы
+	for (; scount--; epki += epki_len, ++shares)
 	{
-		// установить защиту
-		rngStepR(salt, 8, 0);
-		code = bpkiShareWrap(epki, 0, share, len + 1, (const octet*)spwd,
-			cmdPwdLen(spwd), salt, iter);
-		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
-		// записать в файл
 		code = cmdFileWrite(*shares, epki, epki_len);
 		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	}
@@ -258,6 +257,8 @@ static err_t cmdPwdReadShare_internal(cmd_pwd_t* pwd, size_t scount,
 	octet* share;
 	octet* state;
 	octet* epki;
+	const octet** epkis;
+	size_t* epki_lens;
 	octet* pwd_bin;
 	size_t pos;
 	// pre
@@ -296,15 +297,17 @@ static err_t cmdPwdReadShare_internal(cmd_pwd_t* pwd, size_t scount,
 		ERR_CALL_CHECK(code);
 	}
 	// выделить память и разметить ее
-	code = cmdBlobCreate(stack, scount * (len + 1) + epki_len_max + 1 + len);
+	code = cmdBlobCreate(stack, scount * (sizeof(octet*) + O_PER_S) +
+		scount * (len + 1) + scount * epki_len_max + len);
 	ERR_CALL_HANDLE(code, cmdPwdClose(*pwd));
-	share = state = (octet*)stack;
+	epkis = (const octet**)stack;
+	epki_lens = (size_t*)(epkis + scount);
+	share = state = (octet*)(epki_lens + scount);
 	epki = share + scount * (len + 1);
-	pwd_bin = epki + epki_len_max + 1;
-	// прочитать частичные секреты
+	pwd_bin = epki + scount * epki_len_max;
+	// прочитать контейнеры
 	for (pos = 0; pos < scount; ++pos, ++shares)
 	{
-		size_t share_len;
 		// определить длину контейнера
 		code = cmdFileReadAll(0, &epki_len, *shares);
 		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
@@ -313,15 +316,14 @@ static err_t cmdPwdReadShare_internal(cmd_pwd_t* pwd, size_t scount,
 			ERR_OK : ERR_BAD_FORMAT;
 		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 		// читать
-		code = cmdFileReadAll(epki, &epki_len, *shares);
-		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
-		// декодировать
-		code = bpkiShareUnwrap(share + pos * (len + 1), &share_len,
-			epki, epki_len, (const octet*)spwd, cmdPwdLen(spwd));
-		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
-		code = (share_len == len + 1) ? ERR_OK : ERR_BAD_FORMAT;
+		epkis[pos] = epki + pos * epki_len_max, epki_lens[pos] = epki_len;
+		code = cmdFileReadAll(epki + pos * epki_len_max, &epki_len, *shares);
 		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	}
+	// извлечь частичные секреты (одновременно)
+	code = bpkiShareUnwrapMB(share, len + 1, epkis, epki_lens,
+		(const octet*)spwd, cmdPwdLen(spwd), scount);
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	// собрать пароль
 	code = belsRecover2(pwd_bin, scount, len, share);
 	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
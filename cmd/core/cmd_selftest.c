@@ -0,0 +1,220 @@
+/*
+*******************************************************************************
+\file cmd_selftest.c
+\brief Command-line interface to Bee2: self-tests
+\project bee2/cmd
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "../cmd.h"
+#include <bee2/core/blob.h>
+#include <bee2/core/err.h>
+#include <bee2/core/hex.h>
+#include <bee2/core/mem.h>
+#include <bee2/core/str.h>
+#include <bee2/core/util.h>
+#include <bee2/crypto/belt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "whereami.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) &&\
+	(defined(__x86_64__) || defined(__i386__))
+	#include <cpuid.h>
+	#define cmdCPUID(info, id)\
+		__cpuid_count(id, 0, info[0], info[1], info[2], info[3])
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+	#define cmdCPUID(info, id) __cpuidex((int*)info, id, 0)
+#endif
+
+/*
+*******************************************************************************
+Кэширование результатов самотестирования
+
+Результат самотестирования команды сохраняется в процессе и повторно
+не вычисляется.
+
+Если задана переменная окружения BEE2CMD_SELFTEST, то она определяет
+файл маркеров. Маркер -- это шестнадцатеричная запись хэш-значения
+  belt-hash(belt-hash(exe) || cpu || name),
+где exe -- содержимое исполнимого файла, cpu -- идентификационные данные
+процессора (результат инструкции cpuid, если она доступна), name -- имя
+самотеста. Маркеры записываются по одному в строке после успешного
+выполнения самотестов. Если маркер самотеста найден в файле, то самотест
+не выполняется. При изменении исполнимого файла или процессора маркеры
+перестают совпадать и самотесты выполняются снова.
+
+Маркер -- контрольная сумма, а не имитовставка: он защищает от случайной
+смены сборки или процессора, но не от намеренной подделки. Файл маркеров
+следует размещать в каталоге, запись в который разрешена только
+владельцу.
+
+Вызов cmdSelfTestForce() (опция bee2cmd -selftest) отключает проверку
+маркеров: самотесты выполняются, недостающие маркеры записываются.
+*******************************************************************************
+*/
+
+#define CMD_SELFTEST_MAX 16
+#define CMD_SELFTEST_FILE_MAX 65536
+
+typedef struct
+{
+	cmd_selftest_i fn;		/*< самотест */
+	err_t code;				/*< результат */
+} cmd_selftest_entry_t;
+
+static cmd_selftest_entry_t _tests[CMD_SELFTEST_MAX];
+static size_t _count;
+static bool_t _force;
+static bool_t _exe_ready;
+static octet _exe_hash[32];
+
+void cmdSelfTestForce()
+{
+	_force = TRUE;
+}
+
+static void cmdSelfTestCPU(octet cpu[32])
+{
+	memSetZero(cpu, 32);
+#ifdef cmdCPUID
+	{
+		u32 info[4];
+		cmdCPUID(info, 0);
+		memCopy(cpu, info, 16);
+		if (info[0] >= 1)
+		{
+			cmdCPUID(info, 1);
+			memCopy(cpu + 16, info, 16);
+		}
+	}
+#endif
+}
+
+static bool_t cmdSelfTestExe()
+{
+	octet state[1024];
+	int len;
+	char* path;
+	if (_exe_ready)
+		return TRUE;
+	// определить имя исполнимого файла
+	len = wai_getExecutablePath(0, 0, 0);
+	if (len < 0 || !(path = (char*)blobCreate((size_t)len + 1)))
+		return FALSE;
+	if (wai_getExecutablePath(path, len, 0) != len)
+	{
+		blobClose(path);
+		return FALSE;
+	}
+	// хэшировать исполнимый файл
+	ASSERT(sizeof(state) >= beltHash_keep());
+	beltHashStart(state);
+	if (cmdFileStep(path, SIZE_MAX, beltHashStepH, state, 4096) == ERR_OK)
+	{
+		beltHashStepG(_exe_hash, state);
+		_exe_ready = TRUE;
+	}
+	blobClose(path);
+	return _exe_ready;
+}
+
+static bool_t cmdSelfTestMark(char mark[64 + 1], const char* name)
+{
+	octet state[1024];
+	octet buf[32];
+	if (!cmdSelfTestExe())
+		return FALSE;
+	ASSERT(sizeof(state) >= beltHash_keep());
+	beltHashStart(state);
+	beltHashStepH(_exe_hash, 32, state);
+	cmdSelfTestCPU(buf);
+	beltHashStepH(buf, 32, state);
+	beltHashStepH(name, strLen(name), state);
+	beltHashStepG(buf, state);
+	hexFrom(mark, buf, 32);
+	return TRUE;
+}
+
+static bool_t cmdSelfTestFind(const char* file, const char* mark)
+{
+	size_t size;
+	char* buf;
+	char* line;
+	bool_t found = FALSE;
+	// прочитать файл маркеров
+	size = cmdFileSize(file);
+	if (size == SIZE_MAX || size > CMD_SELFTEST_FILE_MAX ||
+		!(buf = (char*)blobCreate(size + 1)))
+		return FALSE;
+	if (cmdFileReadAll(buf, &size, file) != ERR_OK)
+	{
+		blobClose(buf);
+		return FALSE;
+	}
+	buf[size] = 0;
+	// искать маркер
+	for (line = buf; !found && *line; )
+	{
+		size_t len;
+		for (len = 0; line[len] && line[len] != '\n'; ++len);
+		if (len >= 64 && memEq(line, mark, 64))
+			found = TRUE;
+		line += len;
+		if (*line)
+			++line;
+	}
+	blobClose(buf);
+	return found;
+}
+
+static void cmdSelfTestSave(const char* file, const char* mark)
+{
+	char line[64 + 1];
+	size_t size;
+	memCopy(line, mark, 64);
+	line[64] = '\n';
+	size = cmdFileSize(file);
+	if (size == SIZE_MAX || size > CMD_SELFTEST_FILE_MAX)
+		cmdFileWrite(file, line, sizeof(line));
+	else
+		cmdFileAppend(file, line, sizeof(line));
+}
+
+err_t cmdSelfTest(const char* name, cmd_selftest_i fn)
+{
+	const char* file;
+	char mark[64 + 1];
+	bool_t marked;
+	size_t pos;
+	err_t code;
+	// pre
+	ASSERT(strIsValid(name));
+	ASSERT(fn != 0);
+	// результат уже известен?
+	for (pos = 0; pos < _count; ++pos)
+		if (_tests[pos].fn == fn)
+			return _tests[pos].code;
+	// есть маркер?
+	file = getenv("BEE2CMD_SELFTEST");
+	marked = file && *file && cmdSelfTestMark(mark, name);
+	if (marked && !_force && cmdSelfTestFind(file, mark))
+		code = ERR_OK;
+	// выполнить самотест
+	else
+	{
+		code = fn();
+		if (code == ERR_OK && marked &&
+			(!_force || !cmdSelfTestFind(file, mark)))
+			cmdSelfTestSave(file, mark);
+	}
+	// сохранить результат
+	if (_count < COUNT_OF(_tests))
+		_tests[_count].fn = fn, _tests[_count++].code = code;
+	return code;
+}
@@ -4,7 +4,7 @@
 \brief Command-line interface to Bee2: signing files
 \project bee2/cmd
 \created 2022.08.20
-\version 2024.06.27
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -139,24 +139,39 @@ static size_t cmdSigDec(cmd_sig_t* sig, const octet der[], size_t count)
 *******************************************************************************
 */
 
+/*
+	Обратный DER-код подписи строится за один проход в буфере, длина
+	которого оценивается сверху: к длинам вложенных данных добавляется
+	максимальная длина тега и длины для каждого из четырех элементов
+	(Signature, сертификаты, дата, подпись).
+*/
+static err_t cmdSigEncRev(octet** der, size_t* len, const cmd_sig_t* sig)
+{
+	err_t code;
+	// pre
+	ASSERT(cmdSigSeemsValid(sig));
+	// подготовить память
+	code = cmdBlobCreate(*der,
+		sig->certs_len + 6 + sig->sig_len + 4 * (2 + O_PER_S));
+	ERR_CALL_CHECK(code);
+	// кодировать
+	*len = cmdSigEnc(*der, sig);
+	code = *len <= blobSize(*der) ? ERR_OK : ERR_BAD_SIG;
+	ERR_CALL_HANDLE(code, cmdBlobClose(*der));
+	memRev(*der, *len);
+	return ERR_OK;
+}
+
 static err_t cmdSigWrite(const char* sig_file, const cmd_sig_t* sig)
 {
 	err_t code;
 	octet* der;
 	size_t len;
 	// pre
-	ASSERT(cmdSigSeemsValid(sig));
 	ASSERT(strIsValid(sig_file));
-	// определить длину DER-кода
-	len = cmdSigEnc(0, sig);
-	code = len != SIZE_MAX ? ERR_OK : ERR_BAD_SIG;
-	ERR_CALL_CHECK(code);
-	// подготовить память
-	code = cmdBlobCreate(der, len);
-	ERR_CALL_CHECK(code);
 	// кодировать
-	cmdSigEnc(der, sig);
-	memRev(der, len);
+	code = cmdSigEncRev(&der, &len, sig);
+	ERR_CALL_CHECK(code);
 	// записать код в файл
 	code = cmdFileWrite(sig_file, der, len);
 	// завершить
@@ -170,18 +185,10 @@ static err_t cmdSigAppend(const char* sig_file, const cmd_sig_t* sig)
 	octet* der;
 	size_t len;
 	// pre
-	ASSERT(cmdSigSeemsValid(sig));
 	ASSERT(strIsValid(sig_file));
-	// определить длину DER-кода
-	len = cmdSigEnc(0, sig);
-	code = len != SIZE_MAX ? ERR_OK : ERR_BAD_SIG;
-	ERR_CALL_CHECK(code);
-	// подготовить память
-	code = cmdBlobCreate(der, len);
-	ERR_CALL_CHECK(code);
 	// кодировать
-	cmdSigEnc(der, sig);
-	memRev(der, len);
+	code = cmdSigEncRev(&der, &len, sig);
+	ERR_CALL_CHECK(code);
 	// дописать код к файлу
 	code = cmdFileAppend(sig_file, der, len);
 	// завершить
@@ -225,14 +232,14 @@ err_t cmdSigRead(cmd_sig_t* sig, size_t* sig_len, const char* sig_file)
 	ERR_CALL_HANDLE(code, fclose(fp));
 	// определить длину DER-кода
 	count += len;
-	code = count <= file_size ? ERR_OK : ERR_BAD_SIG;
+	code = count <= file_size && (size_t)(long)count == count ?
+		ERR_OK : ERR_BAD_SIG;
 	ERR_CALL_HANDLE(code, fclose(fp));
 	// подготовить память
 	code = cmdBlobCreate(der, count);
 	ERR_CALL_HANDLE(code, fclose(fp));
 	// читать DER-код и закрыть файл
-	code = fseek(fp, (long)(file_size - count), SEEK_SET) == 0 ?
-		ERR_OK : ERR_FILE_READ;
+	code = fseek(fp, -(long)count, SEEK_END) == 0 ? ERR_OK : ERR_FILE_READ;
 	ERR_CALL_HANDLE(code, (cmdBlobClose(der), fclose(fp)));
 	code = fread(der, 1, count, fp) == count ? ERR_OK : ERR_FILE_READ;
 	ERR_CALL_HANDLE(code, (cmdBlobClose(der), fclose(fp)));
@@ -263,22 +270,18 @@ err_t cmdSigRead(cmd_sig_t* sig, size_t* sig_len, const char* sig_file)
 static err_t cmdSigHash(octet hash[], size_t hash_len, const char* file,
 	size_t drop, const octet certs[], size_t certs_len, const octet date[6])
 {
-	const size_t buf_size = 4096;
 	err_t code;
-	octet* stack;
 	octet* state;
 	size_t file_size;
-	FILE* fp;
 	// pre
 	ASSERT(hash_len == 24 || hash_len == 32 || hash_len == 48 ||
 		hash_len == 64);
 	ASSERT(memIsValid(hash, hash_len));
 	ASSERT(strIsValid(file));
-	// выделить и разметить память
-	code = cmdBlobCreate(stack, buf_size +
-		(hash_len <= 32 ? beltHash_keep() : bashHash_keep()));
+	// выделить память
+	code = cmdBlobCreate(state,
+		hash_len <= 32 ? beltHash_keep() : bashHash_keep());
 	ERR_CALL_CHECK(code);
-	state = stack + buf_size;
 	// запустить хэширование
 	if (hash_len <= 32)
 		beltHashStart(state);
@@ -287,31 +290,15 @@ static err_t cmdSigHash(octet hash[], size_t hash_len, const char* file,
 	// определить размер файла
 	file_size = cmdFileSize(file);
 	code = file_size != SIZE_MAX ? ERR_OK : ERR_FILE_READ;
-	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	ERR_CALL_HANDLE(code, cmdBlobClose(state));
 	// определить размер хэшируемой части файла
 	code = drop <= file_size ? ERR_OK : ERR_BAD_FORMAT;
-	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	ERR_CALL_HANDLE(code, cmdBlobClose(state));
 	file_size -= drop;
-	// открыть файл для чтения
-	fp = fopen(file, "rb");
-	code = fp ? ERR_OK : ERR_FILE_OPEN;
-	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	// хэшировать файл
-	while (file_size)
-	{
-		// прочитать фрагмент
-		size_t count = MIN2(file_size, buf_size);
-		code = fread(stack, 1, count, fp) == count ? ERR_OK : ERR_FILE_READ;
-		ERR_CALL_HANDLE(code, (fclose(fp), cmdBlobClose(stack)));
-		file_size -= count;
-		// хэшировать фрагмент
-		if (hash_len <= 32)
-			beltHashStepH(stack, count, state);
-		else
-			bashHashStepH(stack, count, state);
-	}
-	code = (fclose(fp) == 0) ? ERR_OK : ERR_BAD_FILE;
-	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	code = cmdFileStep(file, file_size,
+		hash_len <= 32 ? beltHashStepH : bashHashStepH, state, 4096);
+	ERR_CALL_HANDLE(code, cmdBlobClose(state));
 	// хэшировать сертификаты и дату
 	if (hash_len <= 32)
 	{
@@ -326,7 +313,7 @@ static err_t cmdSigHash(octet hash[], size_t hash_len, const char* file,
 		bashHashStepG(hash, hash_len, state);
 	}
 	// завершить
-	cmdBlobClose(stack);
+	cmdBlobClose(state);
 	return code;
 }
 
@@ -358,8 +345,9 @@ static err_t cmdSigParamsStd(bign_params* params, size_t privkey_len)
 *******************************************************************************
 */
 
-err_t cmdSigSign(const char* sig_file, const char* file, const char* certs,
-	const octet date[6], const octet privkey[], size_t privkey_len)
+err_t cmdSigSignHead(const char* sig_file, const char* file, size_t head_len,
+	const char* certs, const octet date[6], const octet privkey[],
+	size_t privkey_len)
 {
 	err_t code;
 	void* stack;
@@ -370,6 +358,7 @@ err_t cmdSigSign(const char* sig_file, const char* file, const char* certs,
 	octet* hash;
 	octet* t;
 	size_t t_len;
+	size_t drop = 0;
 	// входной контроль
 	if (!strIsValid(sig_file) || !strIsValid(file) ||
 		!(privkey_len == 24 || privkey_len == 32 || privkey_len == 48 || 
@@ -419,9 +408,17 @@ err_t cmdSigSign(const char* sig_file, const char* file, const char* certs,
 	// загрузить долговременные параметры
 	code = cmdSigParamsStd(params, privkey_len);
 	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	// подписывается только заголовок?
+	if (head_len != SIZE_MAX)
+	{
+		drop = cmdFileSize(file);
+		code = drop != SIZE_MAX && head_len <= drop ? ERR_OK : ERR_BAD_FORMAT;
+		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+		drop -= head_len;
+	}
 	// хэшировать
-	code = cmdSigHash(hash, privkey_len, file, 0, sig->certs, sig->certs_len, 
-		sig->date);
+	code = cmdSigHash(hash, privkey_len, file, drop, sig->certs,
+		sig->certs_len, sig->date);
 	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	if (privkey_len <= 32)
 	{
@@ -465,14 +462,37 @@ err_t cmdSigSign(const char* sig_file, const char* file, const char* certs,
 	return code;
 }
 
+err_t cmdSigSign(const char* sig_file, const char* file, const char* certs,
+	const octet date[6], const octet privkey[], size_t privkey_len)
+{
+	return cmdSigSignHead(sig_file, file, SIZE_MAX, certs, date, privkey,
+		privkey_len);
+}
+
 /*
 *******************************************************************************
 Проверка подписи
+
+Если подписан только заголовок файла file (head_len != SIZE_MAX), то
+из хэширования исключается все, что следует за первыми head_len октетами,
+в том числе присоединенная подпись.
 *******************************************************************************
 */
 
-err_t cmdSigVerify(const char* file, const char* sig_file,
-	const octet pubkey[], size_t pubkey_len)
+static err_t cmdSigDropHead(size_t* drop, const char* file, size_t head_len)
+{
+	size_t size;
+	if (head_len == SIZE_MAX)
+		return ERR_OK;
+	size = cmdFileSize(file);
+	if (size == SIZE_MAX || size < *drop || size - *drop < head_len)
+		return ERR_BAD_FORMAT;
+	*drop = size - head_len;
+	return ERR_OK;
+}
+
+err_t cmdSigVerifyHead(const char* file, const char* sig_file,
+	size_t head_len, const octet pubkey[], size_t pubkey_len)
 {
 	err_t code;
 	void* stack;
@@ -508,6 +528,9 @@ err_t cmdSigVerify(const char* file, const char* sig_file,
 		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 		drop = 0;
 	}
+	// подписан только заголовок?
+	code = cmdSigDropHead(&drop, file, head_len);
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	// проверить сертификаты
 	code = cmdCVCsVal(sig->certs, sig->certs_len, sig->date);	
 	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
@@ -563,8 +586,14 @@ err_t cmdSigVerify(const char* file, const char* sig_file,
 	return code;
 }
 
-err_t cmdSigVerify2(const char* file, const char* sig_file,
-	const octet anchor[], size_t anchor_len)
+err_t cmdSigVerify(const char* file, const char* sig_file,
+	const octet pubkey[], size_t pubkey_len)
+{
+	return cmdSigVerifyHead(file, sig_file, SIZE_MAX, pubkey, pubkey_len);
+}
+
+err_t cmdSigVerify2Head(const char* file, const char* sig_file,
+	size_t head_len, const octet anchor[], size_t anchor_len)
 {
 	err_t code;
 	void* stack;
@@ -600,6 +629,9 @@ err_t cmdSigVerify2(const char* file, const char* sig_file,
 		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 		drop = 0;
 	}
+	// подписан только заголовок?
+	code = cmdSigDropHead(&drop, file, head_len);
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	// цепочка сертификатов включает anchor?
 	code = cmdCVCsFind(0, sig->certs, sig->certs_len, anchor, anchor_len);
 	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
@@ -650,6 +682,12 @@ err_t cmdSigVerify2(const char* file, const char* sig_file,
 	return code;
 }
 
+err_t cmdSigVerify2(const char* file, const char* sig_file,
+	const octet anchor[], size_t anchor_len)
+{
+	return cmdSigVerify2Head(file, sig_file, SIZE_MAX, anchor, anchor_len);
+}
+
 /*
 *******************************************************************************
 Самопроверка
@@ -4,7 +4,7 @@
 \brief Manage CV-certificate rings
 \project bee2/cmd 
 \created 2023.06.08
-\version 2023.12.17
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -48,6 +48,7 @@
   bee2cmd sig val -anchor cert2 ring2 ring2
   bee2cmd cvr find ring2 cert3
   bee2cmd cvr extr -cert0 ring2 cert31
+  bee2cmd cvr extr -holder 590082394655 ring2 cert32
   bee2cmd sig extr -cert0 ring2 cert21
   bee2cmd cvr print ring2
   bee2cmd cvr print -certc ring2
@@ -73,13 +74,14 @@ static int cvrUsage()
 		"    remove <cert> from <ring>\n"
 		"  cvr val <certa> <ring>\n"
 		"    validate <ring> using <certa> as an anchor\n"
-		"  cvr find <ring> <cert>\n"
-		"    find <cert> in <ring>\n"
-		"  cvr extr -cert<nnn> <ring> <file>\n"
+		"  cvr find <ring> <cert> [<cert> ...]\n"
+		"    find <cert>s in <ring>\n"
+		"  cvr extr {-cert<nnn>|-holder <name>} <ring> <file>\n"
 		"    extract from <ring> an object and store it in <file>\n"
 		"      -cert<nnn> -- the <nnn>th certificate\n"
 		"        \\remark certificates are numbered from zero\n"
 		"      -certa -- holder's certificate\n"
+		"      -holder -- the first certificate of the holder <name>\n"
 		"  cvr print [-certc] <ring>\n"
 		"    print <ring> info: all fields or a specific field\n"
 		"      -certc -- the number of certificates\n"
@@ -170,7 +172,7 @@ static err_t cvrCreate(int argc, char* argv[])
 	octet* privkey;
 	octet date[6];
 	// самотестирование
-	code = cvrSelfTest();
+	code = cmdSelfTest(_name, cvrSelfTest);
 	ERR_CALL_CHECK(code);
 	// обработать опции
 	if (argc != 5 || !strEq(argv[0], "-pass"))
@@ -234,7 +236,7 @@ static err_t cvrAdd(int argc, char* argv[])
 	octet* certs;
 	octet date[6];
 	// самотестирование
-	code = cvrSelfTest();
+	code = cmdSelfTest(_name, cvrSelfTest);
 	ERR_CALL_CHECK(code);
 	// обработать опции
 	if (argc != 6 || !strEq(argv[0], "-pass"))
@@ -359,7 +361,7 @@ static err_t cvrDel(int argc, char* argv[])
 	size_t offset;
 	octet date[6];
 	// самотестирование
-	code = cvrSelfTest();
+	code = cmdSelfTest(_name, cvrSelfTest);
 	ERR_CALL_CHECK(code);
 	// обработать опции
 	if (argc != 6 || !strEq(argv[0], "-pass"))
@@ -467,7 +469,7 @@ static err_t cvrVal(int argc, char* argv[])
 	void* ring;
 	octet* certs;
 	// самотестирование
-	code = cvrSelfTest();
+	code = cmdSelfTest(_name, cvrSelfTest);
 	ERR_CALL_CHECK(code);
 	// обработать опции
 	if (argc != 2)
@@ -518,7 +520,11 @@ static err_t cvrVal(int argc, char* argv[])
 *******************************************************************************
 Поиск сертификата
 
-cvr find <ring> <cert>
+cvr find <ring> <cert> [<cert> ...]
+
+Для поиска строится индекс кольца (см. cmdCVCsIdx()). Индекс строится
+один раз, после чего каждый сертификат ищется за логарифмическое время.
+Поиск завершается на первом ненайденном сертификате.
 *******************************************************************************
 */
 
@@ -526,42 +532,61 @@ static err_t cvrFind(int argc, char* argv[])
 {
 	err_t code;
 	void* stack;
-	size_t cert_len;
-	octet* cert;
 	size_t sig_len;
 	cmd_sig_t* sig;
 	size_t ring_len;
 	octet* certs;
+	size_t count;
+	cmd_cvcs_idx_t* idx;
+	int i;
 	// обработать опции
-	if (argc != 2)
+	if (argc < 2)
 		return ERR_CMD_PARAMS;
 	// проверить наличие файлов
-	code = cmdFileValExist(2, argv);
-	ERR_CALL_CHECK(code);
-	// определить длину cert
-	code = cmdFileReadAll(0, &cert_len, argv[1]);
+	code = cmdFileValExist(argc, argv);
 	ERR_CALL_CHECK(code);
 	// определить длину кольца
 	code = cmdFileReadAll(0, &ring_len, argv[0]);
 	ERR_CALL_CHECK(code);
 	// выделить и разметить память
-	code = cmdBlobCreate(stack, cert_len + MAX2(sizeof(cmd_sig_t), ring_len));
+	code = cmdBlobCreate(stack, MAX2(sizeof(cmd_sig_t), ring_len));
 	ERR_CALL_CHECK(code);
-	cert = (octet*)stack;
-	certs = cert + cert_len;
+	certs = (octet*)stack;
 	sig = (cmd_sig_t*)certs;
-	// прочитать cert
-	code = cmdFileReadAll(cert, &cert_len, argv[1]);
-	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	// определить длину подписи
 	code = cmdSigRead(sig, &sig_len, argv[0]);
 	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	// прочитать кольцо
 	code = cmdFileReadAll(certs, &ring_len, argv[0]);
 	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
-	// найти сертификат
-	code = cmdCVCsFind(0, certs, ring_len - sig_len, cert, cert_len);
+	ASSERT(sig_len <= ring_len);
+	// построить индекс
+	code = cmdCVCsIdx(0, &count, certs, ring_len - sig_len);
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	code = cmdBlobCreate(idx, MAX2(count, 1) * sizeof(cmd_cvcs_idx_t));
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	code = cmdCVCsIdx(idx, &count, certs, ring_len - sig_len);
+	ERR_CALL_HANDLE(code, (cmdBlobClose(idx), cmdBlobClose(stack)));
+	// искать сертификаты
+	for (i = 1; code == ERR_OK && i < argc; ++i)
+	{
+		size_t cert_len;
+		octet* cert;
+		// прочитать cert
+		code = cmdFileReadAll(0, &cert_len, argv[i]);
+		if (code != ERR_OK)
+			break;
+		code = cmdBlobCreate(cert, cert_len);
+		if (code != ERR_OK)
+			break;
+		code = cmdFileReadAll(cert, &cert_len, argv[i]);
+		// найти cert
+		if (code == ERR_OK)
+			code = cmdCVCsIdxFind(0, idx, count, certs, cert, cert_len);
+		cmdBlobClose(cert);
+	}
 	// завершить
+	cmdBlobClose(idx);
 	cmdBlobClose(stack);
 	return code;
 }
@@ -570,7 +595,7 @@ static err_t cvrFind(int argc, char* argv[])
 *******************************************************************************
 Извлечение объекта
 
-cvr extr -cert<nnn> <ring> <file>
+cvr extr {-cert<nnn>|-holder <name>} <ring> <file>
 *******************************************************************************
 */
 
@@ -578,7 +603,8 @@ static err_t cvrExtr(int argc, char* argv[])
 {
 	err_t code;
 	const char* scope;
-	size_t num;
+	const char* holder = 0;
+	size_t num = 0;
 	void* stack;
 	size_t sig_len;
 	cmd_sig_t* sig;
@@ -588,13 +614,23 @@ static err_t cvrExtr(int argc, char* argv[])
 	size_t cert_len;
 	// обработать опции
 	scope = argv[0];
-	if (argc != 3 || !strStartsWith(scope, "-cert"))
-		return ERR_CMD_PARAMS;
-	scope += strLen("-cert");
-	// определить номер сертификата
-	if (!decIsValid(scope) || strLen(scope) < 1 || strLen(scope) > 8)
+	if (argc == 4 && strEq(scope, "-holder"))
+	{
+		holder = argv[1];
+		if (strLen(holder) < 8 || strLen(holder) > 12)
+			return ERR_CMD_PARAMS;
+		++argv, --argc;
+	}
+	else if (argc == 3 && strStartsWith(scope, "-cert"))
+	{
+		// определить номер сертификата
+		scope += strLen("-cert");
+		if (!decIsValid(scope) || strLen(scope) < 1 || strLen(scope) > 8)
+			return ERR_CMD_PARAMS;
+		num = (size_t)decToU32(scope);
+	}
+	else
 		return ERR_CMD_PARAMS;
-	num = (size_t)decToU32(scope);
 	// проверить наличие/отсутствие файлов
 	code = cmdFileValExist(1, argv + 1);
 	ERR_CALL_CHECK(code);
@@ -615,7 +651,11 @@ static err_t cvrExtr(int argc, char* argv[])
 	code = cmdFileReadAll(certs, &ring_len, argv[1]);
 	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	// найти сертификат
-	code = cmdCVCsGet(&offset, &cert_len, certs, ring_len - sig_len, num);
+	if (holder)
+		code = cmdCVCsFindHolder(&offset, &cert_len, certs,
+			ring_len - sig_len, holder);
+	else
+		code = cmdCVCsGet(&offset, &cert_len, certs, ring_len - sig_len, num);
 	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	// записать сертификат в файл
 	code = cmdFileWrite(argv[2], certs + offset, cert_len);
@@ -0,0 +1,927 @@
+/*
+*******************************************************************************
+\file enc.c
+\brief Encrypt and decrypt files
+\project bee2/cmd
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "../cmd.h"
+#include <bee2/core/blob.h>
+#include <bee2/core/dec.h>
+#include <bee2/core/err.h>
+#include <bee2/core/hex.h>
+#include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
+#include <bee2/core/rng.h>
+#include <bee2/core/str.h>
+#include <bee2/core/u32.h>
+#include <bee2/core/u64.h>
+#include <bee2/core/util.h>
+#include <bee2/crypto/bash.h>
+#include <bee2/crypto/belt.h>
+#include <stdio.h>
+#ifdef OS_UNIX
+	#include <sys/types.h>
+#endif
+
+/*
+*******************************************************************************
+Утилита enc
+
+Функционал:
+- зашифрование файла на пароле с установкой имитозащиты;
+- расшифрование файла целиком, диапазона сегментов или с продолжением
+  прерванного расшифрования;
+- печать заголовка зашифрованного файла.
+
+Пример:
+  bee2cmd enc enc -pass pass:alice file file.enc
+  bee2cmd enc enc -alg bash -seg 20 -pass pass:alice file file.enc
+  bee2cmd enc print file.enc
+  bee2cmd enc dec -pass pass:alice file.enc file
+  bee2cmd enc dec -pass pass:alice -from 3 -count 2 file.enc part
+  bee2cmd enc dec -pass pass:alice -resume file.enc file
+*******************************************************************************
+*/
+
+static const char _name[] = "enc";
+static const char _descr[] = "encrypt and decrypt files";
+
+static int encUsage()
+{
+	printf(
+		"bee2cmd/%s: %s\n"
+		"Usage:\n"
+		"  enc enc [-alg <alg>] [-seg <nn>] -pass <schema> <file> <encfile>\n"
+		"    encrypt <file> and store the result in <encfile>\n"
+		"  enc dec [-from <i>] [-count <n>] [-resume] -pass <schema>\n"
+		"    <encfile> <file>\n"
+		"    decrypt <encfile> and store the result in <file>\n"
+		"  enc print <encfile>\n"
+		"    print the header of <encfile>\n"
+		"  options:\n"
+		"    -alg <alg> -- encryption algorithm: che (by default) or bash\n"
+		"    -seg <nn> -- segment length 2^nn: 10 <= nn <= 24 (16 by default)\n"
+		"    -pass <schema> -- password description\n"
+		"    -from <i> -- number of the first decrypted segment (0 by default)\n"
+		"    -count <n> -- number of decrypted segments (all by default)\n"
+		"    -resume -- continue decryption into partially written <file>\n"
+		,
+		_name, _descr
+	);
+	return -1;
+}
+
+/*
+*******************************************************************************
+Формат
+
+Зашифрованный файл состоит из заголовка и сегментов. Заголовок
+(ENC_HDR_LEN октетов):
+- [8] сигнатура "bee2-enc";
+- [1] алгоритм: ENC_ALG_CHE (belt-che) или ENC_ALG_BASH (bash-prg-ae);
+- [1] логарифм nn длины сегмента seg = 2^nn;
+- [2] нули;
+- [4] число итераций PBKDF2 (little-endian);
+- [16] синхропосылка ("соль") PBKDF2;
+- [16] базовый анонс (nonce);
+- [8] длина открытых данных size (little-endian);
+- [8] имитовставка belt-mac предыдущих полей.
+
+Из пароля по алгоритму PBKDF2 строится ключ theta. По theta с помощью
+belt-keyrep строятся ключ имитозащиты заголовка и ключ шифрования.
+Неверный пароль обнаруживается при проверке имитовставки заголовка.
+
+Открытые данные разбиваются на n = max(1, ceil(size / seg)) сегментов:
+все, кроме последнего, имеют длину seg. Сегмент с номером i, 0 <= i < n,
+зашифровывается независимо от других и сопровождается имитовставкой:
+- belt-che: синхропосылка -- базовый анонс, первые 8 октетов которого
+  сложены с номером i (little-endian), имитовставка -- 8 октетов;
+- bash-prg-ae (l = 128, d = 2): анонс -- базовый анонс, дополненный
+  номером i, имитовставка -- 16 октетов.
+.
+Открытыми (имитозащищаемыми, но не шифруемыми) данными сегмента являются
+номер i (8 октетов) и признак последнего сегмента (1 октет). Поэтому
+перестановка, удаление и дописывание сегментов обнаруживаются. Длина size
+в заголовке защищена имитовставкой, что позволяет обнаружить усечение
+файла.
+
+Сегменты можно расшифровывать по отдельности: смещение сегмента i в файле
+равно ENC_HDR_LEN + i * (seg + tag_len). Это используется при расшифровании
+диапазона сегментов и при продолжении прерванного расшифрования.
+*******************************************************************************
+*/
+
+#define ENC_HDR_LEN 64
+#define ENC_ALG_CHE 1
+#define ENC_ALG_BASH 2
+#define ENC_SEG_LOG_MIN 10
+#define ENC_SEG_LOG_MAX 24
+#define ENC_SEG_LOG_DEF 16
+#define ENC_ITER 10000
+#define ENC_ITER_MAX 10000000
+
+static const octet _magic[8] = { 'b', 'e', 'e', '2', '-', 'e', 'n', 'c' };
+
+typedef struct {
+	octet alg;				/*< алгоритм */
+	size_t seg;				/*< длина сегмента */
+	size_t tag_len;			/*< длина имитовставки сегмента */
+	u64 size;				/*< длина открытых данных */
+	u64 n;					/*< число сегментов */
+	u32 iter;				/*< число итераций PBKDF2 */
+	bool_t decr;			/*< расшифрование? */
+	octet nonce[16];		/*< базовый анонс */
+	octet key[32];			/*< ключ шифрования */
+} enc_ctx;
+
+static size_t encTagLen(octet alg)
+{
+	return alg == ENC_ALG_CHE ? 8 : 16;
+}
+
+static size_t encScratch_keep()
+{
+	return MAX2(beltCHE_keep(), bashPrg_keep());
+}
+
+static size_t encSegLen(const enc_ctx* ctx, u64 i)
+{
+	ASSERT(i < ctx->n);
+	return i + 1 < ctx->n ? ctx->seg : (size_t)(ctx->size - i * ctx->seg);
+}
+
+/*
+*******************************************************************************
+Заголовок
+*******************************************************************************
+*/
+
+static err_t encKeyDerive(octet key[32], octet mac[8], const octet hdr[],
+	const cmd_pwd_t pwd)
+{
+	err_t code;
+	void* stack;
+	octet* theta;
+	octet* key_mac;
+	octet* krp_hdr;
+	u32 iter;
+	// выделить память и разметить ее
+	code = cmdBlobCreate(stack, 32 + 32 + 16 + beltKRP_keep());
+	ERR_CALL_CHECK(code);
+	theta = (octet*)stack;
+	key_mac = theta + 32;
+	krp_hdr = key_mac + 32;
+	// построить theta
+	u32From(&iter, hdr + 12, 4);
+	code = beltPBKDF2(theta, (const octet*)pwd, cmdPwdLen(pwd), iter,
+		hdr + 16, 16);
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	// построить ключи
+	beltKRPStart(krp_hdr + 16, theta, 32, beltH());
+	memSetZero(krp_hdr, 16), krp_hdr[15] = 1;
+	beltKRPStepG(key_mac, 32, krp_hdr, krp_hdr + 16);
+	krp_hdr[15] = 2;
+	beltKRPStepG(key, 32, krp_hdr, krp_hdr + 16);
+	// имитовставка заголовка
+	code = beltMAC(mac, hdr, ENC_HDR_LEN - 8, key_mac, 32);
+	cmdBlobClose(stack);
+	return code;
+}
+
+static err_t encHdrRead(enc_ctx* ctx, octet hdr[ENC_HDR_LEN],
+	const char* file)
+{
+	FILE* fp;
+	size_t file_size;
+	ASSERT(memIsValid(ctx, sizeof(enc_ctx)));
+	ASSERT(memIsValid(hdr, ENC_HDR_LEN));
+	// читать заголовок
+	file_size = cmdFileSize(file);
+	if (file_size == SIZE_MAX)
+		return ERR_FILE_READ;
+	if (file_size < ENC_HDR_LEN)
+		return ERR_BAD_FORMAT;
+	if (!(fp = fopen(file, "rb")))
+		return ERR_FILE_OPEN;
+	if (fread(hdr, 1, ENC_HDR_LEN, fp) != ENC_HDR_LEN)
+	{
+		fclose(fp);
+		return ERR_FILE_READ;
+	}
+	fclose(fp);
+	// разобрать заголовок
+	memSetZero(ctx, sizeof(enc_ctx));
+	if (!memEq(hdr, _magic, 8) ||
+		hdr[8] != ENC_ALG_CHE && hdr[8] != ENC_ALG_BASH ||
+		hdr[9] < ENC_SEG_LOG_MIN || hdr[9] > ENC_SEG_LOG_MAX ||
+		hdr[10] || hdr[11])
+		return ERR_BAD_FORMAT;
+	ctx->alg = hdr[8];
+	ctx->seg = (size_t)1 << hdr[9];
+	ctx->tag_len = encTagLen(ctx->alg);
+	u32From(&ctx->iter, hdr + 12, 4);
+	memCopy(ctx->nonce, hdr + 32, 16);
+	u64From(&ctx->size, hdr + 48, 8);
+	if (ctx->iter == 0 || ctx->iter > ENC_ITER_MAX)
+		return ERR_BAD_FORMAT;
+	// проверить длину файла
+	if (ctx->size > file_size)
+		return ERR_BAD_FORMAT;
+	ctx->n = ctx->size ? (ctx->size - 1) / ctx->seg + 1 : 1;
+	if ((u64)file_size != ENC_HDR_LEN + ctx->size + ctx->n * ctx->tag_len)
+		return ERR_BAD_FORMAT;
+	return ERR_OK;
+}
+
+/*
+*******************************************************************************
+Самотестирование
+*******************************************************************************
+*/
+
+static err_t encSelfTest()
+{
+	octet state[1024];
+	octet buf[32];
+	octet mac[8];
+	// belt-che: тест A.19-2
+	ASSERT(sizeof(state) >= beltCHE_keep());
+	beltCHEStart(state, beltH() + 128, 32, beltH() + 192);
+	memCopy(buf, beltH(), 15);
+	beltCHEStepE(buf, 15, state);
+	beltCHEStepI(beltH() + 16, 32, state);
+	beltCHEStepA(buf, 15, state);
+	beltCHEStepG(mac, state);
+	if (!hexEq(buf,
+		"BF3DAEAF5D18D2BCC30EA62D2E70A4") ||
+		!hexEq(mac,
+		"548622B844123FF7"))
+		return ERR_SELFTEST;
+	// pbkdf2 тест E.5
+	beltPBKDF2(buf, (const octet*)"B194BAC80A08F53B", 16, 10000,
+		beltH() + 128 + 64, 8);
+	if (!hexEq(buf,
+		"3D331BBBB1FBBB40E4BF22F6CB9A689E"
+		"F13A77DC09ECF93291BFE42439A72E7D"))
+		return ERR_SELFTEST;
+	// bash-prg: зашифрование и расшифрование
+	ASSERT(sizeof(state) >= bashPrg_keep());
+	bashPrgStart(state, 128, 2, beltH(), 24, beltH() + 32, 32);
+	bashPrgAbsorb(beltH() + 64, 9, state);
+	memCopy(buf, beltH() + 96, 32);
+	bashPrgEncr(buf, 32, state);
+	bashPrgSqueeze(mac, 8, state);
+	bashPrgStart(state, 128, 2, beltH(), 24, beltH() + 32, 32);
+	bashPrgAbsorb(beltH() + 64, 9, state);
+	bashPrgDecr(buf, 32, state);
+	bashPrgSqueeze(buf, 8, state);
+	if (!memEq(buf, mac, 8))
+		return ERR_SELFTEST;
+	// все нормально
+	return ERR_OK;
+}
+
+/*
+*******************************************************************************
+Обработка сегментов
+
+Сегменты обрабатываются в пуле потоков окнами по w сегментов. Пока пул
+обрабатывает одно окно, в другое окно (второй буфер) читаются следующие
+сегменты входного файла. После завершения обработки окна его сегменты
+в порядке номеров проверяются и записываются в выходной файл. Входной файл
+читается с упреждением в отдельном потоке (см. cmdFileRdrStart()), поэтому
+ожидание диска совмещается с обработкой и при отсутствии пула. Используемая
+память не зависит от длины файла и ограничена (2 * w + 3) * (seg + tag_len)
+октетами.
+
+Окно содержит 4 сегмента на каждый поток пула, но не более ENC_WINDOW_MAX
+октетов (и не менее одного сегмента).
+
+При расшифровании сегменты записываются только после проверки
+их имитовставок. Если проверка не прошла, то обработка прекращается,
+а ранее записанные (и проверенные) сегменты сохраняются в выходном файле.
+Расшифрование может быть продолжено с первого незаписанного октета.
+*******************************************************************************
+*/
+
+#define ENC_WINDOW_MAX ((size_t)1 << 25)
+
+typedef struct {
+	const enc_ctx* ctx;		/*< контекст */
+	u64 i;					/*< номер сегмента */
+	octet* buf;				/*< [len + tag_len] данные и имитовставка */
+	size_t len;				/*< длина данных */
+	err_t code;				/*< результат */
+} enc_seg;
+
+static void encSegTask(void* arg, void* scratch)
+{
+	enc_seg* s = (enc_seg*)arg;
+	const enc_ctx* ctx = s->ctx;
+	octet ad[9];
+	octet iv[24];
+	octet tag[16];
+	// открытые данные: номер сегмента и признак последнего сегмента
+	u64To(ad, 8, &s->i);
+	ad[8] = s->i + 1 == ctx->n ? 1 : 0;
+	memCopy(iv, ctx->nonce, 16);
+	s->code = ERR_OK;
+	// belt-che
+	if (ctx->alg == ENC_ALG_CHE)
+	{
+		memXor2(iv, ad, 8);
+		beltCHEStart(scratch, ctx->key, 32, iv);
+		beltCHEStepI(ad, 9, scratch);
+		if (!ctx->decr)
+		{
+			beltCHEStepE(s->buf, s->len, scratch);
+			beltCHEStepA(s->buf, s->len, scratch);
+			beltCHEStepG(s->buf + s->len, scratch);
+		}
+		else
+		{
+			beltCHEStepA(s->buf, s->len, scratch);
+			if (beltCHEStepV(s->buf + s->len, scratch))
+				beltCHEStepD(s->buf, s->len, scratch);
+			else
+				s->code = ERR_BAD_MAC;
+		}
+	}
+	// bash-prg-ae
+	else
+	{
+		memCopy(iv + 16, ad, 8);
+		bashPrgStart(scratch, 128, 2, iv, 24, ctx->key, 32);
+		bashPrgAbsorb(ad, 9, scratch);
+		if (!ctx->decr)
+		{
+			bashPrgEncr(s->buf, s->len, scratch);
+			bashPrgSqueeze(s->buf + s->len, 16, scratch);
+		}
+		else
+		{
+			bashPrgDecr(s->buf, s->len, scratch);
+			bashPrgSqueeze(tag, 16, scratch);
+			if (!memEq(tag, s->buf + s->len, 16))
+			{
+				memWipe(s->buf, s->len);
+				s->code = ERR_BAD_MAC;
+			}
+		}
+	}
+	memWipe(iv, sizeof(iv));
+}
+
+/*
+*******************************************************************************
+Позиционирование
+
+Смещение сегмента в зашифрованном файле может выходить за диапазон long
+(Windows, 32-битные системы), поэтому fseek() не используется. Файл
+позиционируется через _fseeki64() / fseeko(), а если смещение не
+представляется в off_t, то последовательным чтением с начала файла.
+*******************************************************************************
+*/
+
+static err_t encSeek(FILE* fp, u64 offset)
+{
+	octet buf[1024];
+	size_t n;
+	// прямое позиционирование
+#ifdef OS_WIN
+	if (_fseeki64(fp, (__int64)offset, SEEK_SET) == 0)
+		return ERR_OK;
+#elif defined OS_UNIX
+	if ((off_t)offset >= 0 && (u64)(off_t)offset == offset &&
+		fseeko(fp, (off_t)offset, SEEK_SET) == 0)
+		return ERR_OK;
+#else
+	if ((long)offset >= 0 && (u64)(long)offset == offset &&
+		fseek(fp, (long)offset, SEEK_SET) == 0)
+		return ERR_OK;
+#endif
+	// последовательный пропуск
+	if (fseek(fp, 0, SEEK_SET))
+		return ERR_FILE_READ;
+	for (; offset; offset -= n)
+	{
+		n = (size_t)MIN2(offset, (u64)sizeof(buf));
+		if (fread(buf, 1, n, fp) != n)
+			return ERR_FILE_READ;
+	}
+	return ERR_OK;
+}
+
+static err_t encWindowRead(enc_seg segs[], size_t* k, octet* buf, size_t w,
+	const enc_ctx* ctx, cmd_file_rdr_t* rdr, u64* i, u64 end)
+{
+	err_t code;
+	const void* chunk;
+	size_t rlen, len;
+	for (*k = 0; *k < w && *i < end; ++*k, ++*i)
+	{
+		segs[*k].ctx = ctx;
+		segs[*k].i = *i;
+		segs[*k].buf = buf + *k * (ctx->seg + ctx->tag_len);
+		segs[*k].len = encSegLen(ctx, *i);
+		rlen = segs[*k].len + (ctx->decr ? ctx->tag_len : 0);
+		if (rlen == 0)
+			continue;
+		code = cmdFileRdrNext(&chunk, &len, rdr);
+		ERR_CALL_CHECK(code);
+		if (len != rlen)
+			return ERR_FILE_READ;
+		memCopy(segs[*k].buf, chunk, len);
+	}
+	return ERR_OK;
+}
+
+static err_t encStream(const enc_ctx* ctx, FILE* ifp, FILE* ofp, u64 from,
+	u64 end, size_t skip)
+{
+	err_t code;
+	err_t code_read;
+	mt_pool_t* pool;
+	size_t unit, runit, count, w, k[2], cur, j;
+	cmd_file_rdr_t* rdr;
+	void* stack;
+	enc_seg* segs;
+	octet* bufs;
+	octet* scratch;
+	// pre
+	ASSERT(from <= end && end <= ctx->n);
+	// создать пул и определить окно
+	pool = mtPoolCreate(0, encScratch_keep(), 0);
+	unit = ctx->seg + ctx->tag_len;
+	w = 4 * (pool ? mtPoolThreads(pool) : 1);
+	w = MIN2(w, MAX2(ENC_WINDOW_MAX / unit, 1));
+	// выделить память и разметить ее
+	code = cmdBlobCreate(stack, 2 * w * (sizeof(enc_seg) + unit) +
+		encScratch_keep());
+	ERR_CALL_HANDLE(code, pool ? mtPoolClose(pool) : (void)0);
+	segs = (enc_seg*)stack;
+	bufs = (octet*)(segs + 2 * w);
+	scratch = bufs + 2 * w * unit;
+	// запустить упреждающее чтение сегментов
+	runit = ctx->decr ? unit : ctx->seg;
+	count = (size_t)(end - from - 1) * runit +
+		encSegLen(ctx, end - 1) + (ctx->decr ? ctx->tag_len : 0);
+	code = cmdFileRdrStart(&rdr, ifp, count, runit);
+	ERR_CALL_HANDLE(code,
+		(cmdBlobClose(stack), pool ? mtPoolClose(pool) : (void)0));
+	// читать первое окно
+	code_read = encWindowRead(segs, k, bufs, w, ctx, rdr, &from, end);
+	code = code_read;
+	for (cur = 0; code == ERR_OK && k[cur]; cur ^= 1)
+	{
+		// обрабатывать окно cur
+		for (j = 0; j < k[cur]; ++j)
+			if (pool)
+				mtPoolSubmit(pool, encSegTask, segs + cur * w + j);
+			else
+				encSegTask(segs + cur * w + j, scratch);
+		// читать следующее окно
+		code_read = encWindowRead(segs + (cur ^ 1) * w, k + (cur ^ 1),
+			bufs + (cur ^ 1) * w * unit, w, ctx, rdr, &from, end);
+		if (pool)
+			mtPoolWait(pool);
+		// записать обработанные сегменты
+		for (j = 0; code == ERR_OK && j < k[cur]; ++j)
+		{
+			enc_seg* s = segs + cur * w + j;
+			size_t wlen = s->len + (ctx->decr ? 0 : ctx->tag_len);
+			code = s->code;
+			if (code != ERR_OK)
+				break;
+			ASSERT(skip <= wlen);
+			if (fwrite(s->buf + skip, 1, wlen - skip, ofp) != wlen - skip)
+				code = ERR_FILE_WRITE;
+			skip = 0;
+		}
+		if (code == ERR_OK)
+			code = code_read;
+	}
+	// завершить
+	cmdFileRdrClose(rdr);
+	if (pool)
+		mtPoolClose(pool);
+	cmdBlobClose(stack);
+	return code;
+}
+
+/*
+*******************************************************************************
+Зашифрование
+
+enc [-alg <alg>] [-seg <nn>] -pass <schema> <file> <encfile>
+*******************************************************************************
+*/
+
+static err_t encEnc(int argc, char* argv[])
+{
+	err_t code = ERR_OK;
+	octet alg = 0;
+	size_t seg_log = 0;
+	cmd_pwd_t pwd = 0;
+	size_t size;
+	void* stack;
+	enc_ctx* ctx;
+	octet* hdr;
+	u32 iter = ENC_ITER;
+	FILE* ifp;
+	FILE* ofp;
+	// самотестирование
+	code = cmdSelfTest(_name, encSelfTest);
+	ERR_CALL_CHECK(code);
+	// разбор опций
+	while (argc && strStartsWith(*argv, "-"))
+	{
+		if (strEq(*argv, "-alg"))
+		{
+			if (alg)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			++argv, --argc;
+			if (!argc)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			if (strEq(*argv, "che"))
+				alg = ENC_ALG_CHE;
+			else if (strEq(*argv, "bash"))
+				alg = ENC_ALG_BASH;
+			else
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			++argv, --argc;
+		}
+		else if (strEq(*argv, "-seg"))
+		{
+			if (seg_log)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			++argv, --argc;
+			if (!argc || !decIsValid(*argv) || decCLZ(*argv) ||
+				strLen(*argv) != 2 ||
+				(seg_log = (size_t)decToU32(*argv)) < ENC_SEG_LOG_MIN ||
+				seg_log > ENC_SEG_LOG_MAX)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			++argv, --argc;
+		}
+		else if (strEq(*argv, "-pass"))
+		{
+			if (pwd)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			++argv, --argc;
+			if (!argc)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			code = cmdPwdRead(&pwd, *argv);
+			if (code != ERR_OK)
+				break;
+			ASSERT(cmdPwdIsValid(pwd));
+			++argv, --argc;
+		}
+		else
+		{
+			code = ERR_CMD_PARAMS;
+			break;
+		}
+	}
+	if (code == ERR_OK && (!pwd || argc != 2))
+		code = ERR_CMD_PARAMS;
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	if (!alg)
+		alg = ENC_ALG_CHE;
+	if (!seg_log)
+		seg_log = ENC_SEG_LOG_DEF;
+	// проверить файлы
+	code = cmdFileValExist(1, argv);
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	if (cmdFileAreSame(argv[0], argv[1]))
+		code = ERR_CMD_PARAMS;
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	code = cmdFileValNotExist(1, argv + 1);
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	// определить длину файла
+	if ((size = cmdFileSize(argv[0])) == SIZE_MAX)
+		code = ERR_FILE_READ;
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	// запустить ГСЧ
+	code = cmdRngStart(TRUE);
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	// выделить память и разметить ее
+	code = cmdBlobCreate(stack, sizeof(enc_ctx) + ENC_HDR_LEN);
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	ctx = (enc_ctx*)stack;
+	hdr = (octet*)(ctx + 1);
+	// составить заголовок
+	memCopy(hdr, _magic, 8);
+	hdr[8] = alg, hdr[9] = (octet)seg_log, hdr[10] = hdr[11] = 0;
+	u32To(hdr + 12, 4, &iter);
+	rngStepR(hdr + 16, 32, 0);
+	ctx->size = (u64)size;
+	u64To(hdr + 48, 8, &ctx->size);
+	// построить ключи и выработать имитовставку заголовка
+	code = encKeyDerive(ctx->key, hdr + ENC_HDR_LEN - 8, hdr, pwd);
+	cmdPwdClose(pwd);
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	// обновить ключ ГСЧ
+	rngRekey();
+	// настроить контекст
+	ctx->alg = alg;
+	ctx->seg = (size_t)1 << seg_log;
+	ctx->tag_len = encTagLen(alg);
+	ctx->n = ctx->size ? (ctx->size - 1) / ctx->seg + 1 : 1;
+	ctx->iter = iter;
+	ctx->decr = FALSE;
+	memCopy(ctx->nonce, hdr + 32, 16);
+	// открыть файлы
+	if (!(ifp = fopen(argv[0], "rb")))
+		code = ERR_FILE_OPEN;
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	if (!(ofp = fopen(argv[1], "wb")))
+		code = ERR_FILE_CREATE;
+	ERR_CALL_HANDLE(code, (fclose(ifp), cmdBlobClose(stack)));
+	// записать заголовок и зашифровать сегменты
+	if (fwrite(hdr, 1, ENC_HDR_LEN, ofp) != ENC_HDR_LEN)
+		code = ERR_FILE_WRITE;
+	else
+		code = encStream(ctx, ifp, ofp, 0, ctx->n, 0);
+	// завершить
+	if (fclose(ofp) && code == ERR_OK)
+		code = ERR_FILE_WRITE;
+	fclose(ifp);
+	cmdBlobClose(stack);
+	return code;
+}
+
+/*
+*******************************************************************************
+Расшифрование
+
+dec [-from <i>] [-count <n>] [-resume] -pass <schema> <encfile> <file>
+
+Расшифровываются сегменты с номерами from, from + 1,..., from + count - 1.
+При продолжении расшифрования (-resume) выходной файл должен содержать
+начальный фрагмент результата. Расшифрование начинается с сегмента,
+содержащего первый незаписанный октет, октеты сегмента до этого октета
+пропускаются.
+*******************************************************************************
+*/
+
+static err_t encDec(int argc, char* argv[])
+{
+	err_t code = ERR_OK;
+	cmd_pwd_t pwd = 0;
+	u32 from = 0;
+	u32 count = 0;
+	bool_t from_set = FALSE;
+	bool_t resume = FALSE;
+	void* stack;
+	enc_ctx* ctx;
+	octet* hdr;
+	octet* mac;
+	u64 start, end, total, done = 0;
+	FILE* ifp;
+	FILE* ofp;
+	// самотестирование
+	code = cmdSelfTest(_name, encSelfTest);
+	ERR_CALL_CHECK(code);
+	// разбор опций
+	while (argc && strStartsWith(*argv, "-"))
+	{
+		if (strEq(*argv, "-from"))
+		{
+			if (from_set)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			++argv, --argc;
+			if (!argc || !decIsValid(*argv) || decCLZ(*argv) ||
+				strLen(*argv) == 0 || strLen(*argv) > 9)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			from = decToU32(*argv), from_set = TRUE;
+			++argv, --argc;
+		}
+		else if (strEq(*argv, "-count"))
+		{
+			if (count)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			++argv, --argc;
+			if (!argc || !decIsValid(*argv) || decCLZ(*argv) ||
+				strLen(*argv) == 0 || strLen(*argv) > 9 ||
+				(count = decToU32(*argv)) == 0)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			++argv, --argc;
+		}
+		else if (strEq(*argv, "-resume"))
+		{
+			if (resume)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			resume = TRUE;
+			++argv, --argc;
+		}
+		else if (strEq(*argv, "-pass"))
+		{
+			if (pwd)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			++argv, --argc;
+			if (!argc)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			code = cmdPwdRead(&pwd, *argv);
+			if (code != ERR_OK)
+				break;
+			ASSERT(cmdPwdIsValid(pwd));
+			++argv, --argc;
+		}
+		else
+		{
+			code = ERR_CMD_PARAMS;
+			break;
+		}
+	}
+	if (code == ERR_OK && (!pwd || argc != 2))
+		code = ERR_CMD_PARAMS;
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	// проверить файлы
+	code = cmdFileValExist(1, argv);
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	if (cmdFileAreSame(argv[0], argv[1]))
+		code = ERR_CMD_PARAMS;
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	code = resume ? cmdFileValExist(1, argv + 1) :
+		cmdFileValNotExist(1, argv + 1);
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	// выделить память и разметить ее
+	code = cmdBlobCreate(stack, sizeof(enc_ctx) + ENC_HDR_LEN + 8);
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	ctx = (enc_ctx*)stack;
+	hdr = (octet*)(ctx + 1);
+	mac = hdr + ENC_HDR_LEN;
+	// читать заголовок
+	code = encHdrRead(ctx, hdr, argv[0]);
+	ERR_CALL_HANDLE(code, (cmdBlobClose(stack), cmdPwdClose(pwd)));
+	// построить ключи и проверить пароль
+	code = encKeyDerive(ctx->key, mac, hdr, pwd);
+	cmdPwdClose(pwd);
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	if (!memEq(mac, hdr + ENC_HDR_LEN - 8, 8))
+		code = ERR_BAD_PWD;
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	ctx->decr = TRUE;
+	// определить диапазон сегментов
+	if ((u64)from >= ctx->n || count && (u64)count > ctx->n - from)
+		code = ERR_CMD_PARAMS;
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	end = count ? (u64)from + count : ctx->n;
+	total = MIN2(ctx->size, end * ctx->seg) - from * ctx->seg;
+	// учесть ранее расшифрованные данные
+	if (resume)
+	{
+		size_t size = cmdFileSize(argv[1]);
+		if (size == SIZE_MAX)
+			code = ERR_FILE_READ;
+		else if ((done = (u64)size) > total)
+			code = ERR_BAD_FILE;
+		ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	}
+	start = from + (done == total && done ? end - from : done / ctx->seg);
+	// все расшифровано?
+	if (start == end)
+	{
+		cmdBlobClose(stack);
+		return ERR_OK;
+	}
+	// открыть файлы
+	if (!(ifp = fopen(argv[0], "rb")))
+		code = ERR_FILE_OPEN;
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	code = encSeek(ifp, ENC_HDR_LEN + start * (ctx->seg + ctx->tag_len));
+	ERR_CALL_HANDLE(code, (fclose(ifp), cmdBlobClose(stack)));
+	if (!(ofp = fopen(argv[1], resume ? "ab" : "wb")))
+		code = ERR_FILE_CREATE;
+	ERR_CALL_HANDLE(code, (fclose(ifp), cmdBlobClose(stack)));
+	// расшифровать сегменты
+	code = encStream(ctx, ifp, ofp, start, end,
+		(size_t)(done - (start - from) * ctx->seg));
+	// завершить
+	if (fclose(ofp) && code == ERR_OK)
+		code = ERR_FILE_WRITE;
+	fclose(ifp);
+	cmdBlobClose(stack);
+	return code;
+}
+
+/*
+*******************************************************************************
+Печать
+
+print <encfile>
+*******************************************************************************
+*/
+
+static err_t encPrint(int argc, char* argv[])
+{
+	err_t code;
+	enc_ctx ctx[1];
+	octet hdr[ENC_HDR_LEN];
+	char hex[33];
+	// разбор опций
+	if (argc != 1)
+		return ERR_CMD_PARAMS;
+	// проверить файл
+	code = cmdFileValExist(1, argv);
+	ERR_CALL_CHECK(code);
+	// читать заголовок
+	code = encHdrRead(ctx, hdr, argv[0]);
+	ERR_CALL_CHECK(code);
+	// печатать
+	printf("alg: %s\n", ctx->alg == ENC_ALG_CHE ? "belt-che" : "bash-prg-ae");
+	printf("seg: %u\n", (unsigned)ctx->seg);
+	printf("segs: %lu\n", (unsigned long)ctx->n);
+	printf("size: %lu\n", (unsigned long)ctx->size);
+	printf("iter: %u\n", (unsigned)ctx->iter);
+	hexFrom(hex, ctx->nonce, 16);
+	printf("nonce: %s\n", hex);
+	return ERR_OK;
+}
+
+/*
+*******************************************************************************
+Главная функция
+*******************************************************************************
+*/
+
+int encMain(int argc, char* argv[])
+{
+	err_t code;
+	// справка
+	if (argc < 3)
+		return encUsage();
+	// разбор команды
+	++argv, --argc;
+	if (strEq(argv[0], "enc"))
+		code = encEnc(argc - 1, argv + 1);
+	else if (strEq(argv[0], "dec"))
+		code = encDec(argc - 1, argv + 1);
+	else if (strEq(argv[0], "print"))
+		code = encPrint(argc - 1, argv + 1);
+	else
+		code = ERR_CMD_NOT_FOUND;
+	// завершить
+	if (code != ERR_OK)
+		printf("bee2cmd/%s: %s\n", _name, errMsg(code));
+	return code != ERR_OK ? -1 : 0;
+}
+
+/*
+*******************************************************************************
+Инициализация
+*******************************************************************************
+*/
+
+err_t encInit()
+{
+	return cmdReg(_name, _descr, encMain);
+}
@@ -4,13 +4,14 @@
 \brief Dealing with entropy sources
 \project bee2/cmd 
 \created 2021.04.20
-\version 2024.06.14
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
 #include "../cmd.h"
+#include <bee2/core/blob.h>
 #include <bee2/core/err.h>
 #include <bee2/core/dec.h>
 #include <bee2/core/mem.h>
@@ -22,6 +23,10 @@
 #include <bee2/core/word.h>
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef OS_WIN
+	#include <fcntl.h>
+	#include <io.h>
+#endif
 
 /*
 *******************************************************************************
@@ -31,11 +36,22 @@
 - перечень доступных источников энтропии;
 - проверка работоспосбности источников энтропии;
 - выгрузка данных от стандартных источников энтропии;
-- эксперименты с источником timer.
+- эксперименты с источником timer;
+- замер скорости источников и длительности их тестирования.
+
+Данные выгружаются фрагментами по ES_BUF октетов. Если имя выходного файла
+"-", то данные выводятся в стандартный поток вывода. Это позволяет
+передавать большие объемы данных статистическим тестам через канал.
+
+Источники trng и trng2 -- это непосредственно инструкции rdseed и rdrand
+(см. rng.h), поэтому отдельного режима работы с ними не требуется.
 
 Пример:
   bee2cmd es print
   bee2cmd es read trng2 128 file
+  bee2cmd es read trng 1048576 - | dieharder -a -g 200
+  bee2cmd es bench
+  bee2cmd es bench sys timer16
 *******************************************************************************
 */
 
@@ -51,7 +67,10 @@ static int esUsage()
 		"    list available entropy sources and determine their health\n"
 		"  es read <source> <count> <file>\n"
 		"    read <count> Kbytes from <source> and store them in <file>\n"
-		"  <source> in {trng, trng2, sys, sys2, timer, timerNN}\n"
+		"    (\"-\" means stdout)\n"
+		"  es bench [<source> ...]\n"
+		"    measure speed of sources and duration of their health tests\n"
+		"  <source> in {trng, trng2, sys, sys2, timer, timerNNN}\n"
 		"    timerNNN -- use NNN sleep delays to produce one output bit\n"
 		,
 		_name, _descr
@@ -107,7 +126,7 @@ static err_t rngReadSourceEx(size_t* read, void* buf, size_t count,
 	const char* source_name, size_t par)
 {
 	if (strEq(source_name, "trng") || strEq(source_name, "trng2") ||
-		strEq(source_name, "sys") ||
+		strEq(source_name, "sys") || strEq(source_name, "sys2") ||
 		strEq(source_name, "timer") && par == 0)
 		return rngESRead(read, buf, count, source_name);
 	// эксперименты с источником timer
@@ -144,69 +163,202 @@ static err_t rngReadSourceEx(size_t* read, void* buf, size_t count,
 	return ERR_OK;
 }
 
+static err_t esSource(char source[6], size_t* par, const char* arg)
+{
+	*par = 0;
+	if (strEq(arg, "trng") || strEq(arg, "trng2") || strEq(arg, "sys") ||
+		strEq(arg, "sys2") || strEq(arg, "timer"))
+		strCopy(source, arg);
+	else if (strStartsWith(arg, "timer"))
+	{
+		strCopy(source, "timer");
+		arg += strLen("timer");
+		if (!decIsValid(arg) || !strLen(arg) || strLen(arg) > 3 ||
+			decCLZ(arg))
+			return ERR_CMD_PARAMS;
+		*par = (size_t)decToU32(arg);
+	}
+	else
+		return ERR_CMD_PARAMS;
+	return ERR_OK;
+}
+
+#define ES_BUF (64 * 1024)
+
 static err_t esRead(int argc, char *argv[])
 {
 	err_t code;
 	char source[6];
-	size_t par = 0;
+	size_t par;
 	size_t count;
 	FILE* fp;
-	octet buf[2048];
+	bool_t out;
+	octet* buf;
 	// разбор командной строки: число параметров
 	if (argc != 3)
 		return ERR_CMD_PARAMS;
 	// разбор командной строки: источник энтропии
-	if (strEq(argv[0], "trng"))
-		strCopy(source, "trng");
-	else if (strEq(argv[0], "trng2"))
-		strCopy(source, "trng2");
-	else if (strEq(argv[0], "sys"))
-		strCopy(source, "sys");
-	else if (strEq(argv[0], "timer"))
-		strCopy(source, "timer");
-	else if (strStartsWith(argv[0], "timer"))
-	{
-		strCopy(source, "timer");
-		argv[0]	+= strLen("timer");
-		if (!decIsValid(argv[0]) || !strLen(argv[0]) || 
-			strLen(argv[0]) > 3 || decCLZ(argv[0]))
-			return ERR_CMD_PARAMS;
-		par = (size_t)decToU32(argv[0]);
-	}
-	else
-		return ERR_CMD_PARAMS;
+	code = esSource(source, &par, argv[0]);
+	ERR_CALL_CHECK(code);
 	// разбор командной строки: число Кбайтов
 	if (!decIsValid(argv[1]) || !strLen(argv[1]) || 
-		strLen(argv[1]) > 4 || decCLZ(argv[1]))
+		strLen(argv[1]) > 9 || decCLZ(argv[1]))
 		return ERR_CMD_PARAMS;
 	count = (size_t)decToU32(argv[1]);
 	if (((count << 10) >> 10) != count)
 		return ERR_OUTOFRANGE;
 	count <<= 10;
-	// разбор командной строки: имя выходного файла
-	code = cmdFileValNotExist(1, argv + 2);
+	// выделить память
+	code = cmdBlobCreate(buf, ES_BUF);
 	ERR_CALL_CHECK(code);
-	fp = fopen(argv[2], "wb");
-	if (!fp)
-		return ERR_FILE_OPEN;
+	// разбор командной строки: имя выходного файла
+	if ((out = strEq(argv[2], "-")))
+	{
+		fp = stdout;
+#ifdef OS_WIN
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	}
+	else
+	{
+		code = cmdFileValNotExist(1, argv + 2);
+		ERR_CALL_HANDLE(code, cmdBlobClose(buf));
+		fp = fopen(argv[2], "wb");
+		code = fp ? ERR_OK : ERR_FILE_OPEN;
+		ERR_CALL_HANDLE(code, cmdBlobClose(buf));
+	}
 	// выгрузка данных
 	while (count)
 	{
 		size_t read;
 		// читать
-		code = rngReadSourceEx(&read, buf,
-			MIN2(sizeof(buf), count), source, par);
-		ERR_CALL_HANDLE(code, fclose(fp));
-		code = read == MIN2(sizeof(buf), count) ? ERR_OK : ERR_FILE_READ;
-		ERR_CALL_HANDLE(code, fclose(fp));
+		code = rngReadSourceEx(&read, buf, MIN2(ES_BUF, count), source,
+			par);
+		if (code == ERR_OK && read != MIN2(ES_BUF, count))
+			code = ERR_FILE_READ;
 		// писать
-		code = fwrite(buf, 1, read, fp) == read ? ERR_OK : ERR_FILE_WRITE;
-		ERR_CALL_HANDLE(code, fclose(fp));
+		if (code == ERR_OK && fwrite(buf, 1, read, fp) != read)
+			code = ERR_FILE_WRITE;
+		if (code != ERR_OK)
+			break;
 		count -= read;
 	}
 	// завершение
-	if (fclose(fp) != 0)
-		return ERR_BAD_FILE;
+	cmdBlobClose(buf);
+	if (out)
+	{
+		if (fflush(fp) != 0 && code == ERR_OK)
+			code = ERR_FILE_WRITE;
+	}
+	else if (fclose(fp) != 0 && code == ERR_OK)
+		code = ERR_BAD_FILE;
+	return code;
+}
+
+/*
+*******************************************************************************
+Замеры
+
+es bench [<source> ...]
+
+Для каждого источника данные читаются фрагментами возрастающей длины (от 16
+до ES_BUF октетов) в течение ES_BENCH_MS миллисекунд. Печатаются скорость
+(октетов в секунду) и длительность теста rngESTest() (в микросекундах).
+Для источников timerNNN тест не проводится: он определен только для
+стандартных источников. В завершение печатается длительность rngESHealth().
+*******************************************************************************
+*/
+
+#define ES_BENCH_MS 500
+
+static tm_ticks_t esUSecs(tm_ticks_t ticks, tm_ticks_t freq)
+{
+	return freq ? ticks / freq * 1000000u + ticks % freq * 1000000u / freq :
+		0;
+}
+
+static err_t esBench(int argc, char* argv[])
+{
+	char sources[][6] = { "trng", "trng2", "sys", "sys2", "timer" };
+	char* std_argv[COUNT_OF(sources)];
+	err_t code;
+	char source[6];
+	size_t par;
+	tm_ticks_t freq;
+	tm_ticks_t start;
+	tm_ticks_t ticks;
+	octet* buf;
+	size_t total;
+	size_t chunk;
+	size_t read;
+	int i;
+	// по умолчанию -- все стандартные источники
+	if (argc == 0)
+	{
+		for (i = 0; i < (int)COUNT_OF(sources); ++i)
+			std_argv[i] = sources[i];
+		argc = (int)COUNT_OF(sources), argv = std_argv;
+	}
+	// проверить источники
+	for (i = 0; i < argc; ++i)
+	{
+		code = esSource(source, &par, argv[i]);
+		ERR_CALL_CHECK(code);
+	}
+	// подготовить таймер и память
+	freq = tmFreq();
+	if (freq == 0)
+		return ERR_NOT_IMPLEMENTED;
+	code = cmdBlobCreate(buf, ES_BUF);
+	ERR_CALL_CHECK(code);
+	// замеры
+	for (i = 0; i < argc; ++i)
+	{
+		esSource(source, &par, argv[i]);
+		printf("%s: ", argv[i]);
+		if (rngESRead(&read, 0, 0, source) != ERR_OK)
+		{
+			printf("not available\n");
+			continue;
+		}
+		// скорость
+		code = ERR_OK, total = 0, chunk = 16, start = tmTicks();
+		do
+		{
+			code = rngReadSourceEx(&read, buf, chunk, source, par);
+			if (code == ERR_OK && read != chunk)
+				code = ERR_FILE_READ;
+			total += read;
+			chunk = MIN2(2 * chunk, ES_BUF);
+			ticks = tmTicks() - start;
+		}
+		while (code == ERR_OK && esUSecs(ticks, freq) < ES_BENCH_MS * 1000u);
+		if (code != ERR_OK)
+		{
+			printf("%s\n", errMsg(code));
+			continue;
+		}
+		printf("%lu bytes/sec", (unsigned long)tmSpeed(total, ticks));
+		// длительность теста
+		if (par == 0)
+		{
+			start = tmTicks();
+			code = rngESTest(source);
+			ticks = tmTicks() - start;
+			printf(", health test %lu us (%c)",
+				(unsigned long)esUSecs(ticks, freq),
+				code == ERR_OK ? '+' : '-');
+		}
+		printf("\n");
+	}
+	cmdBlobClose(buf);
+	// общая работоспособность
+	start = tmTicks();
+	code = rngESHealth();
+	ticks = tmTicks() - start;
+	printf("Health: %lu us (%c)\n", (unsigned long)esUSecs(ticks, freq),
+		code == ERR_OK ? '+' : '-');
+	printf("\\warning health is volatile\n");
 	return ERR_OK;
 }
 
@@ -228,6 +380,8 @@ int esMain(int argc, char* argv[])
 		code = esPrint(argc - 1, argv + 1);
 	else if (strEq(argv[0], "read"))
 		code = esRead(argc - 1, argv + 1);
+	else if (strEq(argv[0], "bench"))
+		code = esBench(argc - 1, argv + 1);
 	else
 		code = ERR_CMD_NOT_FOUND;
 	// завершить
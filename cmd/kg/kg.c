@@ -4,7 +4,7 @@
 \brief Generate and manage private keys
 \project bee2/cmd 
 \created 2022.06.08
-\version 2024.06.13
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -16,6 +16,7 @@
 #include <bee2/core/err.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
 #include <bee2/core/prng.h>
 #include <bee2/core/rng.h>
 #include <bee2/core/str.h>
@@ -34,6 +35,7 @@
 
 Функционал:
 - генерация личного ключа bign с сохранением в контейнер СТБ 34.101.78;
+- массовая генерация личных ключей с сохранением открытых ключей;
 - проверочное чтение личного ключа из контейнера с печатью открытого ключа;
 - смена пароля защиты контейнера.
 
@@ -45,6 +47,7 @@
     -passout pass:"1?23&aaA..." privkey
   bee2cmd kg extr -pass pass:"1?23&aaA..." privkey pubkey
   bee2cmd kg print -pass pass:"1?23&aaA..." privkey
+  bee2cmd kg gen -pass env:FLEET_PWD -count 10000 -outdir keys
 *******************************************************************************
 */
 
@@ -58,6 +61,9 @@ static int kgUsage()
 		"Usage:\n"
 		"  kg gen [-l<nnn>] -pass <schema> <privkey>\n"
 		"    generate a private key and store it in <privkey>\n"
+		"  kg gen [-l<nnn>] -pass <schema> -count <N> -outdir <dir>\n"
+		"    generate N private keys in <dir>/privkey<i>\n"
+		"    and the corresponding public keys in <dir>/pubkey<i>\n"
 		"  kg chp -passin <schema> -passout <schema> <privkey>\n"
 		"    change the password used to protect <privkey>\n"
 		"  kg val -pass <schema> <privkey>\n"
@@ -71,6 +77,8 @@ static int kgUsage()
 		"    -pass <schema> -- password description\n"
 		"    -passin <schema> -- input password description\n"
 		"    -passout <schema> -- output password description\n"
+		"    -count <N> -- number of keys: 1 <= N <= 1000000\n"
+		"    -outdir <dir> -- existing output directory\n"
 		,
 		_name, _descr
 	);
@@ -176,6 +184,158 @@ static err_t kgSelfTest()
 	return ERR_OK;
 }
 
+/*
+*******************************************************************************
+Массовая генерация ключей
+
+gen [-lnnn] -pass <schema> -count <N> -outdir <dir>
+
+Ключи генерируются в пуле потоков группами по KG_GEN_LANES. В каждой группе
+контейнеры создаются функцией bpkiPrivkeyWrapMB(): ключи защиты PBKDF2
+строятся одновременно. В потоках используется генератор rngStepR3().
+Открытые ключи вычисляются в bignKeypairGen() с помощью предвычисленной
+таблицы кратных базовой точки.
+
+Личный ключ номер i (1 <= i <= N) записывается в контейнер <dir>/privkey<i>,
+открытый -- в файл <dir>/pubkey<i>. Номера i дополняются слева нулями
+до длины записи N.
+*******************************************************************************
+*/
+
+#define KG_GEN_LANES 4
+#define KG_GEN_COUNT_MAX 1000000
+
+typedef struct {
+	const bign_params* params;	/*< параметры */
+	size_t len;					/*< длина личного ключа */
+	cmd_pwd_t pwd;				/*< пароль */
+	char** names;				/*< [2 * count] имена файлов */
+	size_t offset;				/*< номер первого ключа группы */
+	size_t n;					/*< число ключей в группе */
+	err_t code;					/*< результат */
+} kg_gen_job;
+
+static void kgGenTask(void* arg, void* scratch)
+{
+	kg_gen_job* job = (kg_gen_job*)arg;
+	const size_t len = job->len;
+	size_t epki_len;
+	void* stack;
+	octet* privkeys;
+	octet* pubkeys;
+	octet* salts;
+	octet* epkis;
+	size_t i;
+	// длина контейнера
+	job->code = bpkiPrivkeyWrapMB(0, &epki_len, 0, len, 0, 0, 0, 10000,
+		job->n);
+	if (job->code != ERR_OK)
+		return;
+	// выделить память и разметить ее
+	job->code = cmdBlobCreate(stack, job->n * (3 * len + 8 + epki_len));
+	if (job->code != ERR_OK)
+		return;
+	privkeys = (octet*)stack;
+	pubkeys = privkeys + job->n * len;
+	salts = pubkeys + job->n * 2 * len;
+	epkis = salts + job->n * 8;
+	// генерировать ключи
+	for (i = 0; job->code == ERR_OK && i < job->n; ++i)
+		job->code = len == 24 ?
+			bign96KeypairGen(privkeys + i * len, pubkeys + i * 2 * len,
+				job->params, rngStepR3, 0) :
+			bignKeypairGen(privkeys + i * len, pubkeys + i * 2 * len,
+				job->params, rngStepR3, 0);
+	// создать контейнеры
+	if (job->code == ERR_OK)
+	{
+		rngStepR3(salts, job->n * 8, 0);
+		job->code = bpkiPrivkeyWrapMB(epkis, 0, privkeys, len,
+			(const octet*)job->pwd, cmdPwdLen(job->pwd), salts, 10000,
+			job->n);
+	}
+	// записать контейнеры и открытые ключи
+	for (i = 0; job->code == ERR_OK && i < job->n; ++i)
+	{
+		job->code = cmdFileWrite(job->names[2 * (job->offset + i)],
+			epkis + i * epki_len, epki_len);
+		if (job->code == ERR_OK)
+			job->code = cmdFileWrite(job->names[2 * (job->offset + i) + 1],
+				pubkeys + i * 2 * len, 2 * len);
+	}
+	// завершить
+	cmdBlobClose(stack);
+}
+
+static err_t kgGenBulk(const bign_params* params, size_t len,
+	const cmd_pwd_t pwd, size_t count, const char* outdir)
+{
+	err_t code;
+	size_t width, name_len, jobs, i;
+	void* stack;
+	char** names;
+	char* name;
+	kg_gen_job* job;
+	mt_pool_t* pool;
+	// pre
+	ASSERT(1 <= count && count <= KG_GEN_COUNT_MAX);
+	ASSERT(strIsValid(outdir));
+	// длина номера и имени файла
+	for (width = 1, i = count; i >= 10; i /= 10, ++width);
+	name_len = strLen(outdir) + strLen("/privkey") + width + 1;
+	jobs = (count + KG_GEN_LANES - 1) / KG_GEN_LANES;
+	// выделить память и разметить ее
+	code = cmdBlobCreate(stack, 2 * count * (sizeof(char*) + name_len) +
+		jobs * sizeof(kg_gen_job));
+	ERR_CALL_CHECK(code);
+	job = (kg_gen_job*)stack;
+	names = (char**)(job + jobs);
+	name = (char*)(names + 2 * count);
+	// составить имена файлов
+	for (i = 0; i < count; ++i)
+	{
+		names[2 * i] = name, name += name_len;
+		names[2 * i + 1] = name, name += name_len;
+		sprintf(names[2 * i], "%s/privkey%0*lu", outdir, (int)width,
+			(unsigned long)(i + 1));
+		sprintf(names[2 * i + 1], "%s/pubkey%0*lu", outdir, (int)width,
+			(unsigned long)(i + 1));
+	}
+	// проверить файлы
+	code = cmdFileValNotExist((int)(2 * count), names);
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	// запустить ГСЧ
+	code = cmdRngStart(TRUE);
+	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
+	// генерировать группы ключей
+	pool = mtPoolCreate(0, 0, 0);
+	for (i = 0; i < jobs; ++i)
+	{
+		job[i].params = params;
+		job[i].len = len;
+		job[i].pwd = pwd;
+		job[i].names = names;
+		job[i].offset = i * KG_GEN_LANES;
+		job[i].n = MIN2(KG_GEN_LANES, count - job[i].offset);
+		if (pool)
+			mtPoolSubmit(pool, kgGenTask, job + i);
+		else
+			kgGenTask(job + i, 0);
+	}
+	if (pool)
+	{
+		mtPoolWait(pool);
+		mtPoolClose(pool);
+	}
+	// обновить ключ ГСЧ
+	rngRekey();
+	// первая ошибка
+	for (i = 0; code == ERR_OK && i < jobs; ++i)
+		code = job[i].code;
+	cmdBlobClose(stack);
+	return code;
+}
+
 /*
 *******************************************************************************
 Генерация ключа
@@ -188,13 +348,15 @@ static err_t kgGen(int argc, char* argv[])
 {
 	err_t code = ERR_OK;
 	size_t len = 0;
+	size_t count = 0;
+	const char* outdir = 0;
 	cmd_pwd_t pwd = 0;
 	bign_params params[1];
 	void* stack = 0;
 	octet* privkey;
 	octet* pubkey;
 	// самотестирование
-	code = kgSelfTest();
+	code = cmdSelfTest(_name, kgSelfTest);
 	ERR_CALL_CHECK(code);
 	// разбор опций
 	while (argc && strStartsWith(*argv, "-"))
@@ -235,23 +397,65 @@ static err_t kgGen(int argc, char* argv[])
 			ASSERT(cmdPwdIsValid(pwd));
 			++argv, --argc;
 		}
+		else if (strEq(*argv, "-count"))
+		{
+			if (count)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			++argv, --argc;
+			if (!argc || !decIsValid(*argv) || decCLZ(*argv) ||
+				strLen(*argv) == 0 || strLen(*argv) > 7 ||
+				(count = (size_t)decToU32(*argv)) == 0 ||
+				count > KG_GEN_COUNT_MAX)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			++argv, --argc;
+		}
+		else if (strEq(*argv, "-outdir"))
+		{
+			if (outdir)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			++argv, --argc;
+			if (!argc)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			outdir = *argv;
+			++argv, --argc;
+		}
 		else
 		{
 			code = ERR_CMD_PARAMS;
 			break;
 		}
 	}
-	if (code == ERR_OK && (!pwd || argc != 1))
+	if (code == ERR_OK && (!pwd || !count != !outdir ||
+		argc != (count ? 0 : 1)))
 		code = ERR_CMD_PARAMS;
 	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
-	// проверить файл-контейнер
-	code = cmdFileValNotExist(1, argv);
-	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
 	// загрузить параметры
 	if (len == 0)
 		len = 32;
 	code = kgParamsStd(params, len);
 	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	// массовая генерация
+	if (count)
+	{
+		code = kgGenBulk(params, len, pwd, count, outdir);
+		cmdPwdClose(pwd);
+		return code;
+	}
+	// проверить файл-контейнер
+	code = cmdFileValNotExist(1, argv);
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
 	// запустить ГСЧ
 	code = cmdRngStart(TRUE);
 	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
@@ -289,7 +493,7 @@ static err_t kgChp(int argc, char* argv[])
 	size_t len = 0;
 	octet* privkey;
 	// самотестирование
-	code = kgSelfTest();
+	code = cmdSelfTest(_name, kgSelfTest);
 	ERR_CALL_CHECK(code);
 	// разбор опций
 	while (argc && strStartsWith(*argv, "-"))
@@ -376,7 +580,7 @@ static err_t kgVal(int argc, char* argv[])
 	size_t len = 0;
 	octet* privkey;
 	// самотестирование
-	code = kgSelfTest();
+	code = cmdSelfTest(_name, kgSelfTest);
 	ERR_CALL_CHECK(code);
 	// разбор опций
 	while (argc && strStartsWith(*argv, "-"))
@@ -443,7 +647,7 @@ static err_t kgExtr(int argc, char* argv[])
 	octet* privkey;
 	octet* pubkey;
 	// самотестирование
-	code = kgSelfTest();
+	code = cmdSelfTest(_name, kgSelfTest);
 	ERR_CALL_CHECK(code);
 	// разбор опций
 	while (argc && strStartsWith(*argv, "-"))
@@ -526,7 +730,7 @@ static err_t kgPrint(int argc, char* argv[])
 	octet* pubkey;
 	char* hex;
 	// самотестирование
-	code = kgSelfTest();
+	code = cmdSelfTest(_name, kgSelfTest);
 	ERR_CALL_CHECK(code);
 	// разбор опций
 	while (argc && strStartsWith(*argv, "-"))
@@ -4,7 +4,7 @@
 \brief Generate and manage passwords
 \project bee2/cmd 
 \created 2022.06.23
-\version 2024.06.14
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -152,7 +152,7 @@ static err_t pwdGen(int argc, char* argv[])
 	if (argc != 1)
 		return ERR_CMD_PARAMS;
 	// самотестирование
-	code = pwdSelfTest();
+	code = cmdSelfTest(_name, pwdSelfTest);
 	ERR_CALL_CHECK(code);
 	// генерировать пароль
 	code = cmdPwdGen(&pwd, *argv);
@@ -176,7 +176,7 @@ static err_t pwdVal(int argc, char* argv[])
 	if (argc != 1)
 		return ERR_CMD_PARAMS;
 	// самотестирование
-	code = pwdSelfTest();
+	code = cmdSelfTest(_name, pwdSelfTest);
 	ERR_CALL_CHECK(code);
 	// определить пароль (с одновременной проверкой)
 	code = cmdPwdRead(&pwd, *argv);
@@ -0,0 +1,646 @@
+/*
+*******************************************************************************
+\file serve.c
+\brief Serve signing and verification requests over a local socket
+\project bee2/cmd
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "../cmd.h"
+#include <bee2/core/blob.h>
+#include <bee2/core/dec.h>
+#include <bee2/core/err.h>
+#include <bee2/core/hex.h>
+#include <bee2/core/mem.h>
+#include <bee2/core/prng.h>
+#include <bee2/core/str.h>
+#include <bee2/core/tm.h>
+#include <bee2/core/u32.h>
+#include <bee2/core/util.h>
+#include <bee2/crypto/belt.h>
+#include <bee2/crypto/bign.h>
+#include <stdio.h>
+#ifdef OS_UNIX
+	#include <poll.h>
+	#include <signal.h>
+	#include <sys/socket.h>
+	#include <sys/stat.h>
+	#include <sys/time.h>
+	#include <sys/un.h>
+	#include <unistd.h>
+#endif
+
+/*
+*******************************************************************************
+Утилита serve
+
+Функционал:
+- обслуживание запросов на хэширование файлов, выработку и проверку
+  подписей через локальный сокет (Unix domain socket);
+- отправка запросов.
+
+Сервер однократно выполняет самотестирование, запускает генератор
+случайных чисел, читает личный ключ, цепочку сертификатов и доверенный
+сертификат и затем обслуживает запросы без повторной инициализации.
+Личный ключ очищается, если запросы на выработку подписи не поступали
+в течение ttl секунд. После этого запросы на выработку подписи
+отклоняются кодом ERR_KEY_NOT_FOUND.
+
+Протокол. Запрос: op || len || payload, ответ: code || len || payload.
+Здесь op -- код операции (1 октет), code -- код ошибки err_t, len --
+длина payload (поля code и len -- 4 октета, little-endian). Полезная
+нагрузка запроса -- последовательность имен файлов, каждое завершается
+нулевым октетом. Операции:
+- 'H' <file>: хэширование (belt-hash), в ответе хэш-значение;
+- 'S' <file> <sig>: выработка подписи (как в sig sign);
+- 'V' <file> <sig>: проверка подписи на доверенном сертификате;
+- 'Q': остановка сервера.
+Соединение обслуживает один запрос.
+
+Сокет создается с правами доступа только для владельца. Сервер
+предназначен для использования одним пользователем: права на сокет --
+единственное средство разграничения доступа.
+
+Пример (после примера в cvc.c):
+  bee2cmd serve run -certs "cert0 cert1 cert2" -pass pass:alice privkey2 \
+    -anchor cert0 -ttl 600 sock &
+  bee2cmd serve call sock sign file sig
+  bee2cmd serve call sock val file sig
+  bee2cmd serve call sock hash file
+  bee2cmd serve call sock stop
+
+\remark Именованные каналы Windows не поддерживаются.
+*******************************************************************************
+*/
+
+static const char _name[] = "serve";
+static const char _descr[] = "serve sign/verify requests over a socket";
+
+static int serveUsage()
+{
+	printf(
+		"bee2cmd/%s: %s\n"
+		"Usage:\n"
+		"  serve run [options] <socket>\n"
+		"    serve requests on the local socket <socket>\n"
+		"  serve call <socket> {hash <file>|sign <file> <sig>|"
+			"val <file> <sig>|stop}\n"
+		"    send a request to the server listening on <socket>\n"
+		"  options:\n"
+		"    -certs <certs> -- certificate chain (optional)\n"
+		"    -pass <schema> <privkey> -- signing key (optional)\n"
+		"    -anchor <anchor> -- trusted certificate (optional)\n"
+		"    -ttl <sec> -- wipe the key after <sec> idle seconds "
+			"(default: 600)\n"
+		,
+		_name, _descr
+	);
+	return -1;
+}
+
+/*
+*******************************************************************************
+Самотестирование
+*******************************************************************************
+*/
+
+static err_t serveSelfTest()
+{
+	octet state[1024];
+	bign_params params[1];
+	octet privkey[32];
+	octet pubkey[64];
+	octet hash[32];
+	const octet oid[] = {
+		0x06, 0x09, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x1F, 0x51,
+	};
+	octet sig[48];
+	// bign-genkeypair
+	hexTo(privkey,
+		"1F66B5B84B7339674533F0329C74F218"
+		"34281FED0732429E0C79235FC273E269");
+	ASSERT(sizeof(state) >= prngEcho_keep());
+	prngEchoStart(state, privkey, 32);
+	if (bignParamsStd(params, "1.2.112.0.2.0.34.101.45.3.1") != ERR_OK ||
+		bignKeypairGen(privkey, pubkey, params, prngEchoStepR,
+			state) != ERR_OK ||
+		!hexEq(pubkey,
+			"BD1A5650179D79E03FCEE49D4C2BD5DD"
+			"F54CE46D0CF11E4FF87BF7A890857FD0"
+			"7AC6A60361E8C8173491686D461B2826"
+			"190C2EDA5909054A9AB84D2AB9D99A90"))
+		return ERR_SELFTEST;
+	// bign-valpubkey
+	if (bignPubkeyVal(params, pubkey) != ERR_OK)
+		return ERR_SELFTEST;
+	// bign-sign
+	if (beltHash(hash, beltH(), 13) != ERR_OK)
+		return ERR_SELFTEST;
+	if (bignSign2(sig, params, oid, sizeof(oid), hash, privkey,
+		0, 0) != ERR_OK)
+		return ERR_SELFTEST;
+	if (!hexEq(sig,
+		"19D32B7E01E25BAE4A70EB6BCA42602C"
+		"CA6A13944451BCC5D4C54CFD8737619C"
+		"328B8A58FB9C68FD17D569F7D06495FB"))
+		return ERR_SELFTEST;
+	if (bignVerify(params, oid, sizeof(oid), hash, sig, pubkey) != ERR_OK)
+		return ERR_SELFTEST;
+	sig[0] ^= 1;
+	if (bignVerify(params, oid, sizeof(oid), hash, sig, pubkey) == ERR_OK)
+		return ERR_SELFTEST;
+	// все нормально
+	return ERR_OK;
+}
+
+#ifdef OS_UNIX
+
+/*
+*******************************************************************************
+Обмен данными
+*******************************************************************************
+*/
+
+#define SERVE_PAYLOAD_MAX 4096
+
+static bool_t serveRecv(int fd, void* buf, size_t count)
+{
+	while (count)
+	{
+		ssize_t c = read(fd, buf, count);
+		if (c <= 0)
+			return FALSE;
+		buf = (octet*)buf + c, count -= (size_t)c;
+	}
+	return TRUE;
+}
+
+static bool_t serveSend(int fd, const void* buf, size_t count)
+{
+	while (count)
+	{
+		ssize_t c = write(fd, buf, count);
+		if (c <= 0)
+			return FALSE;
+		buf = (const octet*)buf + c, count -= (size_t)c;
+	}
+	return TRUE;
+}
+
+static bool_t serveSendFrame(int fd, u32 head, const void* payload,
+	size_t len)
+{
+	octet hdr[8];
+	u32 w[2];
+	ASSERT(len <= SERVE_PAYLOAD_MAX);
+	w[0] = head, w[1] = (u32)len;
+	u32To(hdr, 8, w);
+	return serveSend(fd, hdr, 8) && serveSend(fd, payload, len);
+}
+
+static bool_t serveRecvLen(int fd, size_t* len)
+{
+	octet hdr[4];
+	u32 w;
+	if (!serveRecv(fd, hdr, 4))
+		return FALSE;
+	u32From(&w, hdr, 4);
+	*len = (size_t)w;
+	return *len <= SERVE_PAYLOAD_MAX;
+}
+
+/*
+	Разбор полезной нагрузки на count имен файлов.
+*/
+static bool_t serveArgs(const char* args[], size_t count, const char* payload,
+	size_t len)
+{
+	size_t i;
+	for (i = 0; i < count; ++i)
+	{
+		size_t l;
+		for (l = 0; l < len && payload[l]; ++l);
+		if (l == 0 || l == len)
+			return FALSE;
+		args[i] = payload, payload += l + 1, len -= l + 1;
+	}
+	return len == 0;
+}
+
+static int serveConnect(const char* sock)
+{
+	struct sockaddr_un addr;
+	int fd;
+	if (strLen(sock) >= sizeof(addr.sun_path))
+		return -1;
+	memSetZero(&addr, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strCopy(addr.sun_path, sock);
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		return -1;
+	if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/*
+*******************************************************************************
+Сервер
+
+serve run [-certs <certs>] [-pass <schema> <privkey>] [-anchor <anchor>]
+  [-ttl <sec>] <socket>
+*******************************************************************************
+*/
+
+typedef struct
+{
+	const char* certs;		/*< цепочка сертификатов */
+	octet* privkey;			/*< личный ключ */
+	size_t privkey_len;		/*< длина личного ключа */
+	octet* anchor;			/*< доверенный сертификат */
+	size_t anchor_len;		/*< длина доверенного сертификата */
+	tm_time_t ttl;			/*< время жизни личного ключа */
+	tm_time_t used;			/*< время последнего использования ключа */
+} serve_st;
+
+static void serveExpire(serve_st* st)
+{
+	tm_time_t now;
+	if (!st->privkey || !st->ttl)
+		return;
+	now = tmTime();
+	if (now == TIME_ERR || now < st->used || now - st->used >= st->ttl)
+	{
+		memWipe(st->privkey, st->privkey_len);
+		cmdBlobClose(st->privkey);
+		st->privkey = 0;
+	}
+}
+
+static err_t serveDo(serve_st* st, octet op, const char* payload,
+	size_t len, octet out[32], size_t* out_len)
+{
+	err_t code;
+	const char* args[2];
+	octet date[6];
+	octet state[1024];
+	*out_len = 0;
+	switch (op)
+	{
+	case 'H':
+		if (!serveArgs(args, 1, payload, len))
+			return ERR_CMD_PARAMS;
+		ASSERT(sizeof(state) >= beltHash_keep());
+		beltHashStart(state);
+		code = cmdFileStep(args[0], SIZE_MAX, beltHashStepH, state, 4096);
+		ERR_CALL_CHECK(code);
+		beltHashStepG(out, state);
+		*out_len = 32;
+		return ERR_OK;
+	case 'S':
+		if (!serveArgs(args, 2, payload, len))
+			return ERR_CMD_PARAMS;
+		serveExpire(st);
+		if (!st->privkey)
+			return ERR_KEY_NOT_FOUND;
+		if (!cmdFileAreSame(args[0], args[1]) &&
+			cmdFileSize(args[1]) != SIZE_MAX)
+			return ERR_FILE_EXISTS;
+		memSetZero(date, 6);
+		code = cmdSigSign(args[1], args[0], st->certs, date, st->privkey,
+			st->privkey_len);
+		st->used = tmTime();
+		return code;
+	case 'V':
+		if (!serveArgs(args, 2, payload, len))
+			return ERR_CMD_PARAMS;
+		if (!st->anchor)
+			return ERR_BAD_ANCHOR;
+		return cmdSigVerify2(args[0], args[1], st->anchor, st->anchor_len);
+	}
+	return ERR_CMD_NOT_FOUND;
+}
+
+static err_t serveLoop(serve_st* st, int lfd)
+{
+	char* payload;
+	octet op;
+	octet out[32];
+	size_t len;
+	bool_t stop = FALSE;
+	err_t code;
+	code = cmdBlobCreate(payload, SERVE_PAYLOAD_MAX);
+	ERR_CALL_CHECK(code);
+	while (!stop)
+	{
+		struct pollfd pfd;
+		struct timeval tv;
+		int fd;
+		// ждать соединения, очищая ключ по истечении времени жизни
+		pfd.fd = lfd, pfd.events = POLLIN, pfd.revents = 0;
+		if (poll(&pfd, 1, 1000) <= 0)
+		{
+			serveExpire(st);
+			continue;
+		}
+		if ((fd = accept(lfd, 0, 0)) == -1)
+			continue;
+		// не ждать медленного клиента дольше 5 секунд
+		tv.tv_sec = 5, tv.tv_usec = 0;
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+		// прочитать запрос
+		if (!serveRecv(fd, &op, 1) || !serveRecvLen(fd, &len) ||
+			!serveRecv(fd, payload, len))
+		{
+			close(fd);
+			continue;
+		}
+		// выполнить запрос и отправить ответ
+		if (op == 'Q')
+			code = ERR_OK, len = 0, stop = TRUE;
+		else
+			code = serveDo(st, op, payload, len, out, &len);
+		serveSendFrame(fd, (u32)code, out, len);
+		close(fd);
+		memWipe(payload, SERVE_PAYLOAD_MAX);
+	}
+	cmdBlobClose(payload);
+	return ERR_OK;
+}
+
+static err_t serveListen(int* lfd, const char* sock)
+{
+	struct sockaddr_un addr;
+	mode_t mask;
+	if (strLen(sock) >= sizeof(addr.sun_path))
+		return ERR_BAD_NAME;
+	memSetZero(&addr, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strCopy(addr.sun_path, sock);
+	if ((*lfd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		return ERR_SYS;
+	// создать сокет с правами доступа только для владельца
+	mask = umask(077);
+	if (bind(*lfd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+	{
+		umask(mask);
+		close(*lfd);
+		return ERR_FILE_CREATE;
+	}
+	umask(mask);
+	if (listen(*lfd, 16) != 0)
+	{
+		close(*lfd);
+		unlink(sock);
+		return ERR_SYS;
+	}
+	return ERR_OK;
+}
+
+static err_t serveRun(int argc, char* argv[])
+{
+	err_t code = ERR_OK;
+	serve_st st[1];
+	cmd_pwd_t pwd = 0;
+	const char* privkey_file = 0;
+	const char* anchor_file = 0;
+	int lfd;
+	// самотестирование
+	code = cmdSelfTest(_name, serveSelfTest);
+	ERR_CALL_CHECK(code);
+	// настроить сервер
+	memSetZero(st, sizeof(serve_st));
+	st->ttl = 600;
+	// разобрать опции
+	while (argc && strStartsWith(*argv, "-"))
+	{
+		if (argc < 2)
+		{
+			code = ERR_CMD_PARAMS;
+			break;
+		}
+		if (strEq(*argv, "-certs"))
+		{
+			if (st->certs)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			st->certs = argv[1];
+			argc -= 2, argv += 2;
+		}
+		else if (strEq(*argv, "-pass"))
+		{
+			if (pwd)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			if (argc < 3)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			code = cmdPwdRead(&pwd, argv[1]);
+			if (code != ERR_OK)
+				break;
+			privkey_file = argv[2];
+			argc -= 3, argv += 3;
+		}
+		else if (strEq(*argv, "-anchor"))
+		{
+			if (anchor_file)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			anchor_file = argv[1];
+			argc -= 2, argv += 2;
+		}
+		else if (strEq(*argv, "-ttl"))
+		{
+			if (!decIsValid(argv[1]) || strLen(argv[1]) > 9)
+			{
+				code = ERR_CMD_PARAMS;
+				break;
+			}
+			st->ttl = (tm_time_t)decToU32(argv[1]);
+			argc -= 2, argv += 2;
+		}
+		else
+		{
+			code = ERR_CMD_PARAMS;
+			break;
+		}
+	}
+	if (code == ERR_OK && argc != 1)
+		code = ERR_CMD_PARAMS;
+	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	// прочитать личный ключ
+	if (pwd)
+	{
+		code = cmdPrivkeyRead(0, &st->privkey_len, privkey_file, pwd);
+		ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+		code = cmdBlobCreate(st->privkey, st->privkey_len);
+		ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+		code = cmdPrivkeyRead(st->privkey, 0, privkey_file, pwd);
+		cmdPwdClose(pwd);
+		ERR_CALL_HANDLE(code, cmdBlobClose(st->privkey));
+		// запустить генератор для рандомизации подписей
+		code = cmdRngStart(FALSE);
+		ERR_CALL_HANDLE(code, cmdBlobClose(st->privkey));
+		st->used = tmTime();
+	}
+	// прочитать доверенный сертификат
+	if (anchor_file)
+	{
+		code = cmdFileReadAll(0, &st->anchor_len, anchor_file);
+		if (code == ERR_OK)
+			code = cmdBlobCreate(st->anchor, st->anchor_len);
+		if (code == ERR_OK)
+			code = cmdFileReadAll(st->anchor, &st->anchor_len, anchor_file);
+		ERR_CALL_HANDLE(code,
+			(cmdBlobClose(st->anchor), cmdBlobClose(st->privkey)));
+	}
+	// открыть сокет и обслуживать запросы
+	signal(SIGPIPE, SIG_IGN);
+	code = serveListen(&lfd, argv[0]);
+	if (code == ERR_OK)
+	{
+		code = serveLoop(st, lfd);
+		close(lfd);
+		unlink(argv[0]);
+	}
+	// завершить
+	cmdBlobClose(st->anchor);
+	cmdBlobClose(st->privkey);
+	return code;
+}
+
+/*
+*******************************************************************************
+Клиент
+
+serve call <socket> {hash <file>|sign <file> <sig>|val <file> <sig>|stop}
+*******************************************************************************
+*/
+
+static err_t serveCall(int argc, char* argv[])
+{
+	char payload[SERVE_PAYLOAD_MAX];
+	octet out[SERVE_PAYLOAD_MAX];
+	char hex[2 * 32 + 1];
+	size_t len = 0;
+	octet op;
+	octet hdr[4];
+	u32 w;
+	int fd;
+	int i;
+	err_t code;
+	// разобрать команду
+	if (argc < 2)
+		return ERR_CMD_PARAMS;
+	if (strEq(argv[1], "hash") && argc == 3)
+		op = 'H';
+	else if (strEq(argv[1], "sign") && argc == 4)
+		op = 'S';
+	else if (strEq(argv[1], "val") && argc == 4)
+		op = 'V';
+	else if (strEq(argv[1], "stop") && argc == 2)
+		op = 'Q';
+	else
+		return ERR_CMD_PARAMS;
+	// сформировать полезную нагрузку
+	for (i = 2; i < argc; ++i)
+	{
+		size_t l = strLen(argv[i]) + 1;
+		if (l > sizeof(payload) - len)
+			return ERR_CMD_PARAMS;
+		memCopy(payload + len, argv[i], l);
+		len += l;
+	}
+	// отправить запрос
+	if ((fd = serveConnect(argv[0])) == -1)
+		return ERR_FILE_OPEN;
+	w = (u32)len;
+	u32To(hdr, 4, &w);
+	if (!serveSend(fd, &op, 1) || !serveSend(fd, hdr, 4) ||
+		!serveSend(fd, payload, len))
+	{
+		close(fd);
+		return ERR_SYS;
+	}
+	// получить ответ
+	if (!serveRecv(fd, hdr, 4) || !serveRecvLen(fd, &len) ||
+		!serveRecv(fd, out, len))
+	{
+		close(fd);
+		return ERR_SYS;
+	}
+	close(fd);
+	u32From(&w, hdr, 4);
+	code = (err_t)w;
+	// напечатать хэш-значение
+	if (code == ERR_OK && op == 'H')
+	{
+		if (len != 32)
+			return ERR_BAD_FORMAT;
+		hexFrom(hex, out, 32);
+		hexLower(hex);
+		printf("%s  %s\n", hex, argv[2]);
+	}
+	return code;
+}
+
+#else
+
+static err_t serveRun(int argc, char* argv[])
+{
+	return ERR_NOT_IMPLEMENTED;
+}
+
+static err_t serveCall(int argc, char* argv[])
+{
+	return ERR_NOT_IMPLEMENTED;
+}
+
+#endif /* OS_UNIX */
+
+/*
+*******************************************************************************
+Главная функция
+*******************************************************************************
+*/
+
+static int serveMain(int argc, char* argv[])
+{
+	err_t code;
+	// справка
+	if (argc < 2)
+		return serveUsage();
+	// разбор команды
+	--argc, ++argv;
+	if (strEq(argv[0], "run"))
+		code = serveRun(argc - 1, argv + 1);
+	else if (strEq(argv[0], "call"))
+		code = serveCall(argc - 1, argv + 1);
+	else
+		code = ERR_CMD_NOT_FOUND;
+	// завершить
+	if (code != ERR_OK || strEq(argv[0], "call"))
+		printf("bee2cmd/%s: %s\n", _name, errMsg(code));
+	return code != ERR_OK ? -1 : 0;
+}
+
+err_t serveInit()
+{
+	return cmdReg(_name, _descr, serveMain);
+}
@@ -4,7 +4,7 @@
 \brief Sign files and verify signatures
 \project bee2/cmd
 \created 2022.08.01
-\version 2023.12.17
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -16,13 +16,16 @@
 #include <bee2/core/err.h>
 #include <bee2/core/mem.h>
 #include <bee2/core/hex.h>
+#include <bee2/core/mt.h>
 #include <bee2/core/prng.h>
 #include <bee2/core/str.h>
 #include <bee2/core/tm.h>
 #include <bee2/core/util.h>
+#include <bee2/crypto/bash.h>
 #include <bee2/crypto/belt.h>
 #include <bee2/crypto/bign.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 /*
 *******************************************************************************
@@ -31,6 +34,7 @@
 Функционал:
 - выработка ЭЦП;
 - проверка ЭЦП;
+- подпись манифестов (много файлов -- одна ЭЦП);
 - печать ЭЦП.
 
 Пример (после примера в cvc.c):
@@ -45,6 +49,8 @@
     privkey2 sig_file sig_file
   bee2cmd sig val -anchor cert0 sig_file sig_file
   bee2cmd sig val -pubkey pubkey2 sig_file sig_file
+  # пакетная проверка
+  ls sig_file | bee2cmd sig val -anchor cert0 -batch -
   bee2cmd sig print sig_file
   bee2cmd sig print -certc sig_file
   bee2cmd sig print -date sig_file
@@ -73,6 +79,15 @@ static int sigUsage()
 		"    sign <file> using <privkey> and store the signature in <sig>\n"
 		"  sig val {-pubkey <pubkey>|-anchor <anchor>} <file> <sig>\n"
 		"    verify <sig> of <file> using either <pubkey> or <anchor>\n"
+		"  sig sign [options] -manifest <list> <privkey> <manifest>\n"
+		"    sign files listed in <list> (\"-\" for stdin) with a single\n"
+		"    signature of the <manifest>\n"
+		"  sig val {-pubkey <pubkey>|-anchor <anchor>} -batch <list>\n"
+		"    verify signatures of files listed in <list> (\"-\" for stdin)\n"
+		"      \\remark each line: <file> or <file><TAB><sig>\n"
+		"  sig val {-pubkey <pubkey>|-anchor <anchor>} -manifest <manifest>\n"
+		"    <file>\n"
+		"    verify <file> against a signed <manifest> or a proof\n"
 		"  sig extr {-cert<n>|-body|-sig} <sig> <file>\n"
 		"    extract from <sig> an object and store it in <file>\n"
 		"      -cert<n> -- the <n>th attached certificate\n"
@@ -80,6 +95,8 @@ static int sigUsage()
 		"        \\remark the signing certificate comes last\n"
 		"      -body -- the signed body\n"
 		"      -sig -- the signature itself\n"
+		"  sig extr -proof <file> <manifest> <proof>\n"
+		"    extract from <manifest> a short proof for <file>\n"
 		"  sig print [field] <sig>\n"
 		"    print <sig> info: all fields or a specific field\n"
 		"  .\n"
@@ -159,11 +176,669 @@ static err_t sigSelfTest()
 	return ERR_OK;
 }
 
+/*
+*******************************************************************************
+Манифесты
+
+Манифест позволяет подписать много файлов одной подписью. Файлы
+перечисляются в списке, по одному в строке. Для каждого файла
+вычисляется хэш-значение F его содержимого. По парам (F, имя файла)
+строится дерево Меркле:
+- лист: H(0x00 || F || имя файла);
+- внутренний узел: H(0x01 || левый потомок || правый потомок).
+Листья упорядочиваются по именам файлов. Если на очередном уровне дерева
+число узлов нечетно, то последний узел без изменений переходит на
+следующий уровень.
+
+Алгоритм хэширования H определяется по длине личного ключа l так же, как
+при обычной подписи файлов: belt-hash с усечением до l октетов при l <= 32,
+bash с длиной хэш-значения l в остальных случаях.
+
+Манифест -- текстовый файл:
+\code
+  <root>
+  <F_1>  <имя файла 1>
+  ...
+  <F_n>  <имя файла n>
+\endcode
+Здесь root -- корень дерева, F_i -- хэш-значения содержимого файлов
+(в шестнадцатеричной записи). К манифесту присоединяется подпись, которая
+вычисляется только от заголовка -- первой строки, т.е. от корня
+(см. cmdSigSignHead()). Остальные строки контролируются через корень.
+
+Доказательство принадлежности файла манифесту -- это манифест, в котором
+строки файлов заменены на:
+\code
+  proof <i> <n>
+  <F_i>  <имя файла i>
+  <s_1>
+  ...
+  <s_d>
+\endcode
+Здесь i -- номер листа (от нуля), n -- число листов, s_1,..., s_d --
+соседние узлы на пути от листа к корню. Длина доказательства
+пропорциональна log(n). Подпись переносится в доказательство из манифеста
+без изменений.
+
+Пример:
+  find build -type f | bee2cmd sig sign -certs "cert0 cert1 cert2" \
+    -pass pass:alice -manifest - privkey2 manifest
+  bee2cmd sig val -anchor cert0 -manifest manifest build/app
+  bee2cmd sig extr -proof build/app manifest app_proof
+  bee2cmd sig val -anchor cert0 -manifest app_proof build/app
+*******************************************************************************
+*/
+
+#define SIG_MANIFEST_MAX 100000000
+#define SIG_LIST_CHUNK 4096
+
+typedef struct {
+	const char* name;		/*< имя файла */
+	size_t hash_len;		/*< длина хэш-значения */
+	octet hash[64];			/*< хэш-значение содержимого */
+	err_t code;				/*< результат хэширования */
+} sig_leaf;
+
+static size_t sigHash_keep()
+{
+	return MAX2(beltHash_keep(), bashHash_keep());
+}
+
+static err_t sigHashFile(octet hash[], size_t hash_len, const char* file,
+	void* state)
+{
+	err_t code;
+	if (hash_len <= 32)
+		beltHashStart(state);
+	else
+		bashHashStart(state, hash_len * 4);
+	code = cmdFileStep(file, SIZE_MAX,
+		hash_len <= 32 ? beltHashStepH : bashHashStepH, state, 4096);
+	ERR_CALL_CHECK(code);
+	if (hash_len <= 32)
+		beltHashStepG2(hash, hash_len, state);
+	else
+		bashHashStepG(hash, hash_len, state);
+	return ERR_OK;
+}
+
+static void sigHashNode(octet hash[], size_t hash_len, octet tag,
+	const void* a, size_t a_len, const void* b, size_t b_len, void* state)
+{
+	if (hash_len <= 32)
+	{
+		beltHashStart(state);
+		beltHashStepH(&tag, 1, state);
+		beltHashStepH(a, a_len, state);
+		beltHashStepH(b, b_len, state);
+		beltHashStepG2(hash, hash_len, state);
+	}
+	else
+	{
+		bashHashStart(state, hash_len * 4);
+		bashHashStepH(&tag, 1, state);
+		bashHashStepH(a, a_len, state);
+		bashHashStepH(b, b_len, state);
+		bashHashStepG(hash, hash_len, state);
+	}
+}
+
+static void sigLeafTask(void* arg, void* scratch)
+{
+	sig_leaf* leaf = (sig_leaf*)arg;
+	leaf->code = sigHashFile(leaf->hash, leaf->hash_len, leaf->name, scratch);
+}
+
+static int sigLeafCmp(const void* a, const void* b)
+{
+	return strCmp(((const sig_leaf*)a)->name, ((const sig_leaf*)b)->name);
+}
+
+/*
+*******************************************************************************
+Дерево Меркле
+
+Функция sigMerkle() сворачивает n листов nodes в корень root. Листья
+затираются. Если path != 0, то в path сохраняются соседние узлы на пути
+от листа с номером i к корню, а в depth -- их число.
+
+Функция sigMerkleFold() восстанавливает корень по листу с номером i
+и соседним узлам [depth]path.
+*******************************************************************************
+*/
+
+static void sigMerkle(octet root[], octet path[], size_t* depth,
+	octet nodes[], size_t n, size_t i, size_t hash_len, void* state)
+{
+	size_t j;
+	ASSERT(n > 0);
+	if (path)
+		*depth = 0;
+	for (; n > 1; n = (n + 1) / 2, i /= 2)
+	{
+		if (path && (i ^ 1) < n)
+			memCopy(path + hash_len * (*depth)++, nodes + hash_len * (i ^ 1),
+				hash_len);
+		for (j = 0; 2 * j + 1 < n; ++j)
+			sigHashNode(nodes + hash_len * j, hash_len, 1,
+				nodes + hash_len * 2 * j, hash_len,
+				nodes + hash_len * (2 * j + 1), hash_len, state);
+		if (n & 1)
+			memMove(nodes + hash_len * j, nodes + hash_len * (n - 1),
+				hash_len);
+	}
+	memCopy(root, nodes, hash_len);
+}
+
+static bool_t sigMerkleFold(octet root[], const octet leaf[],
+	const octet path[], size_t depth, size_t n, size_t i, size_t hash_len,
+	void* state)
+{
+	size_t k = 0;
+	ASSERT(i < n);
+	memCopy(root, leaf, hash_len);
+	for (; n > 1; n = (n + 1) / 2, i /= 2)
+	{
+		if ((i ^ 1) >= n)
+			continue;
+		if (k == depth)
+			return FALSE;
+		if (i & 1)
+			sigHashNode(root, hash_len, 1, path + hash_len * k, hash_len,
+				root, hash_len, state);
+		else
+			sigHashNode(root, hash_len, 1, root, hash_len,
+				path + hash_len * k, hash_len, state);
+		++k;
+	}
+	return k == depth;
+}
+
+/*
+*******************************************************************************
+Разбор манифеста
+
+Манифест (доказательство) читается в память целиком. Строки манифеста
+завершаются нулями вместо символов '\n'. Функция sigLineNext() возвращает
+очередную строку или 0, если строки закончились.
+*******************************************************************************
+*/
+
+typedef struct {
+	octet* buf;				/*< содержимое файла (с подписью) */
+	size_t size;			/*< длина файла */
+	size_t body_len;		/*< длина манифеста без подписи */
+	size_t head_len;		/*< длина заголовка */
+	size_t hash_len;		/*< длина хэш-значений */
+	octet root[64];			/*< корень дерева */
+	char* pos;				/*< текущая строка */
+} sig_manifest;
+
+static char* sigLineNext(sig_manifest* m)
+{
+	char* line = m->pos;
+	char* end = (char*)m->buf + m->body_len;
+	if (line == end)
+		return 0;
+	while (m->pos < end && *m->pos != '\n')
+		++m->pos;
+	if (m->pos == end)
+	{
+		m->pos = line;
+		return 0;
+	}
+	*m->pos++ = 0;
+	return line;
+}
+
+static bool_t sigLineHash(octet hash[], const char* line, size_t hash_len)
+{
+	char hex[129];
+	size_t len = strLen(line);
+	if (len < 2 * hash_len || hash_len > 64)
+		return FALSE;
+	memCopy(hex, line, 2 * hash_len), hex[2 * hash_len] = 0;
+	return hexTo(hash, hex);
+}
+
+static bool_t sigLineLeaf(octet hash[], const char** name, const char* line,
+	size_t hash_len)
+{
+	if (!sigLineHash(hash, line, hash_len) ||
+		!strStartsWith(line + 2 * hash_len, "  ") ||
+		!line[2 * hash_len + 2])
+		return FALSE;
+	*name = line + 2 * hash_len + 2;
+	return TRUE;
+}
+
+static bool_t sigLineSize(size_t* num, const char* str, size_t len)
+{
+	char dec[10];
+	if (len == 0 || len > 9)
+		return FALSE;
+	memCopy(dec, str, len), dec[len] = 0;
+	if (!decIsValid(dec))
+		return FALSE;
+	*num = (size_t)decToU32(dec);
+	return TRUE;
+}
+
+static size_t sigDecLen(size_t num)
+{
+	size_t len = 1;
+	for (; num >= 10; num /= 10)
+		++len;
+	return len;
+}
+
+static err_t sigManifestOpen(sig_manifest* m, const char* file)
+{
+	err_t code;
+	cmd_sig_t* sig;
+	char* head;
+	size_t drop;
+	// прочитать файл
+	memSetZero(m, sizeof(sig_manifest));
+	code = cmdFileReadAll(0, &m->size, file);
+	ERR_CALL_CHECK(code);
+	code = cmdBlobCreate(m->buf, m->size + sizeof(cmd_sig_t));
+	ERR_CALL_CHECK(code);
+	code = cmdFileReadAll(m->buf, &m->size, file);
+	ERR_CALL_HANDLE(code, cmdBlobClose(m->buf));
+	// определить длину подписи
+	sig = (cmd_sig_t*)(m->buf + m->size);
+	code = cmdSigRead(sig, &drop, file);
+	ERR_CALL_HANDLE(code, cmdBlobClose(m->buf));
+	ASSERT(drop <= m->size);
+	m->body_len = m->size - drop;
+	// разобрать заголовок
+	m->pos = (char*)m->buf;
+	head = sigLineNext(m);
+	m->head_len = head ? strLen(head) : 0;
+	m->hash_len = m->head_len / 2;
+	if (!head || m->head_len % 2 || m->hash_len != 24 &&
+			m->hash_len != 32 && m->hash_len != 48 && m->hash_len != 64 ||
+		!hexTo(m->root, head))
+		code = ERR_BAD_FORMAT;
+	ERR_CALL_HANDLE(code, cmdBlobClose(m->buf));
+	++m->head_len;
+	return code;
+}
+
+static void sigManifestClose(sig_manifest* m)
+{
+	cmdBlobClose(m->buf);
+}
+
+/*
+*******************************************************************************
+Построение манифеста
+
+sig sign [options] -manifest <list> <privkey> <manifest>
+*******************************************************************************
+*/
+
+static err_t sigListRead(char** list, size_t* len, const char* file)
+{
+	err_t code = ERR_OK;
+	FILE* fp;
+	size_t count;
+	// открыть список
+	fp = strEq(file, "-") ? stdin : fopen(file, "rb");
+	if (!fp)
+		return ERR_FILE_OPEN;
+	// читать фрагментами
+	*list = 0, *len = 0;
+	do
+	{
+		char* buf = (char*)blobResize(*list, *len + SIG_LIST_CHUNK + 1);
+		if (!buf)
+		{
+			code = ERR_OUTOFMEMORY;
+			break;
+		}
+		*list = buf;
+		count = fread(buf + *len, 1, SIG_LIST_CHUNK, fp);
+		*len += count;
+		buf[*len] = 0;
+	}
+	while (count == SIG_LIST_CHUNK);
+	if (code == ERR_OK && ferror(fp))
+		code = ERR_FILE_READ;
+	// завершить
+	if (fp != stdin)
+		fclose(fp);
+	if (code != ERR_OK)
+		blobClose(*list), *list = 0;
+	return code;
+}
+
+static err_t sigManifestWrite(const char* manifest, const sig_leaf leaves[],
+	size_t count, const octet root[], size_t hash_len)
+{
+	err_t code;
+	size_t len;
+	size_t i;
+	char* text;
+	char* str;
+	// определить длину манифеста
+	len = 2 * hash_len + 1;
+	for (i = 0; i < count; ++i)
+		len += 2 * hash_len + 2 + strLen(leaves[i].name) + 1;
+	// сформировать манифест
+	code = cmdBlobCreate(text, len + 1);
+	ERR_CALL_CHECK(code);
+	hexFrom(text, root, hash_len), hexLower(text);
+	str = text + 2 * hash_len, *str++ = '\n';
+	for (i = 0; i < count; ++i)
+	{
+		hexFrom(str, leaves[i].hash, hash_len), hexLower(str);
+		str += 2 * hash_len, *str++ = ' ', *str++ = ' ';
+		strCopy(str, leaves[i].name);
+		str += strLen(leaves[i].name), *str++ = '\n';
+	}
+	ASSERT(str == text + len);
+	// записать манифест
+	code = cmdFileWrite(manifest, text, len);
+	cmdBlobClose(text);
+	return code;
+}
+
+static err_t sigSignManifest(const char* list_file, const char* manifest,
+	const char* certs, const octet date[6], const octet privkey[],
+	size_t privkey_len)
+{
+	err_t code;
+	char* list;
+	size_t total;
+	size_t len;
+	size_t count;
+	size_t i;
+	char* str;
+	void* stack;
+	sig_leaf* leaves;
+	octet* nodes;
+	octet* state;
+	octet root[64];
+	mt_pool_t* pool;
+	// прочитать список
+	code = sigListRead(&list, &total, list_file);
+	ERR_CALL_CHECK(code);
+	// разбить список на строки
+	for (str = list; str < list + total; ++str)
+		if (*str == '\n' || *str == '\r')
+			*str = 0;
+	for (count = 0, str = list; str < list + total; str += len + 1)
+		if ((len = strLen(str)) != 0)
+			++count;
+	code = count && count <= SIG_MANIFEST_MAX ? ERR_OK : ERR_CMD_PARAMS;
+	ERR_CALL_HANDLE(code, blobClose(list));
+	// выделить и разметить память
+	code = cmdBlobCreate(stack, count * (sizeof(sig_leaf) + privkey_len) +
+		sigHash_keep());
+	ERR_CALL_HANDLE(code, blobClose(list));
+	leaves = (sig_leaf*)stack;
+	nodes = (octet*)(leaves + count);
+	state = nodes + count * privkey_len;
+	// собрать листья
+	for (i = 0, str = list; str < list + total; str += len + 1)
+		if ((len = strLen(str)) != 0)
+		{
+			leaves[i].name = str;
+			leaves[i].hash_len = privkey_len;
+			leaves[i++].code = ERR_OK;
+		}
+	ASSERT(i == count);
+	// упорядочить листья и проверить уникальность имен
+	qsort(leaves, count, sizeof(sig_leaf), sigLeafCmp);
+	for (i = 1; i < count; ++i)
+		if (strEq(leaves[i - 1].name, leaves[i].name))
+		{
+			code = ERR_CMD_DUPLICATE;
+			break;
+		}
+	ERR_CALL_HANDLE(code, (cmdBlobClose(stack), blobClose(list)));
+	// хэшировать файлы (при неудаче создания пула -- в вызывающем потоке)
+	pool = mtPoolCreate(0, sigHash_keep(), 0);
+	for (i = 0; i < count; ++i)
+		if (pool)
+			mtPoolSubmit(pool, sigLeafTask, leaves + i);
+		else
+			sigLeafTask(leaves + i, state);
+	if (pool)
+		mtPoolWait(pool), mtPoolClose(pool);
+	for (i = 0; i < count && code == ERR_OK; ++i)
+		if ((code = leaves[i].code) != ERR_OK)
+			printf("%s: FAILED [%s]\n", leaves[i].name, errMsg(code));
+	ERR_CALL_HANDLE(code, (cmdBlobClose(stack), blobClose(list)));
+	// построить дерево
+	for (i = 0; i < count; ++i)
+		sigHashNode(nodes + i * privkey_len, privkey_len, 0,
+			leaves[i].hash, privkey_len, leaves[i].name,
+			strLen(leaves[i].name), state);
+	sigMerkle(root, 0, 0, nodes, count, 0, privkey_len, state);
+	// записать манифест и подписать его заголовок
+	code = sigManifestWrite(manifest, leaves, count, root, privkey_len);
+	if (code == ERR_OK)
+		code = cmdSigSignHead(manifest, manifest, 2 * privkey_len + 1, certs,
+			date, privkey, privkey_len);
+	// завершить
+	cmdBlobClose(stack);
+	blobClose(list);
+	return code;
+}
+
+/*
+*******************************************************************************
+Поиск файла в манифесте
+
+В манифесте m (или в доказательстве) ищется файл с именем name.
+Возвращаются номер i листа файла, число листов n, хэш-значение hash
+содержимого файла и соседние узлы [depth]path на пути к корню. Если m --
+манифест, то дерево перестраивается и его корень сверяется с заголовком.
+*******************************************************************************
+*/
+
+#define SIG_DEPTH_MAX 32
+
+static err_t sigManifestFind(octet hash[], octet path[], size_t* depth,
+	size_t* n, size_t* i, sig_manifest* m, const char* name, void* state)
+{
+	err_t code = ERR_OK;
+	char* line;
+	char* pos;
+	const char* leaf_name;
+	size_t hash_len = m->hash_len;
+	size_t j;
+	octet* nodes;
+	octet root[64];
+	// доказательство?
+	pos = m->pos;
+	line = sigLineNext(m);
+	if (!line)
+		return ERR_BAD_FORMAT;
+	if (strStartsWith(line, "proof "))
+	{
+		char* sep = line + 6;
+		while (*sep && *sep != ' ')
+			++sep;
+		if (!*sep || !sigLineSize(i, line + 6, (size_t)(sep - line - 6)) ||
+			!sigLineSize(n, sep + 1, strLen(sep + 1)) || *i >= *n)
+			return ERR_BAD_FORMAT;
+		line = sigLineNext(m);
+		if (!line || !sigLineLeaf(hash, &leaf_name, line, hash_len))
+			return ERR_BAD_FORMAT;
+		if (!strEq(leaf_name, name))
+			return ERR_FILE_NOT_FOUND;
+		for (*depth = 0; (line = sigLineNext(m)) != 0; ++*depth)
+			if (*depth == SIG_DEPTH_MAX || strLen(line) != 2 * hash_len ||
+				!sigLineHash(path + hash_len * *depth, line, hash_len))
+				return ERR_BAD_FORMAT;
+		if (m->pos != (char*)m->buf + m->body_len)
+			return ERR_BAD_FORMAT;
+		return ERR_OK;
+	}
+	// подсчитать файлы манифеста
+	for (*n = 1; sigLineNext(m); ++*n)
+		if (*n == SIG_MANIFEST_MAX)
+			return ERR_BAD_FORMAT;
+	if (m->pos != (char*)m->buf + m->body_len)
+		return ERR_BAD_FORMAT;
+	// построить листья и найти файл
+	code = cmdBlobCreate(nodes, *n * hash_len);
+	ERR_CALL_CHECK(code);
+	for (*i = *n, j = 0; j < *n; ++j)
+	{
+		if (!sigLineLeaf(root, &leaf_name, pos, hash_len))
+		{
+			code = ERR_BAD_FORMAT;
+			break;
+		}
+		if (strEq(leaf_name, name))
+			*i = j, memCopy(hash, root, hash_len);
+		sigHashNode(nodes + hash_len * j, hash_len, 0, root, hash_len,
+			leaf_name, strLen(leaf_name), state);
+		pos += strLen(pos) + 1;
+	}
+	if (code == ERR_OK && *i == *n)
+		code = ERR_FILE_NOT_FOUND;
+	ERR_CALL_HANDLE(code, cmdBlobClose(nodes));
+	// построить дерево и сверить корень
+	sigMerkle(root, path, depth, nodes, *n, *i, hash_len, state);
+	if (!memEq(root, m->root, hash_len))
+		code = ERR_BAD_HASH;
+	cmdBlobClose(nodes);
+	return code;
+}
+
+/*
+*******************************************************************************
+Проверка файла по манифесту
+
+sig val {-pubkey <pubkey> | -anchor <anchor>} -manifest <manifest> <file>
+
+Проверяется подпись заголовка манифеста (доказательства), затем
+хэш-значение содержимого file и путь от листа file к корню дерева.
+*******************************************************************************
+*/
+
+static err_t sigValManifest(const octet key[], size_t key_len, bool_t anchor,
+	const char* manifest, const char* file)
+{
+	err_t code;
+	sig_manifest m[1];
+	void* stack;
+	octet* path;
+	octet* hash;
+	octet* leaf;
+	octet* state;
+	size_t depth, n, i;
+	// прочитать манифест
+	code = sigManifestOpen(m, manifest);
+	ERR_CALL_CHECK(code);
+	// проверить подпись заголовка
+	if (anchor)
+		code = cmdSigVerify2Head(manifest, manifest, m->head_len, key,
+			key_len);
+	else
+		code = cmdSigVerifyHead(manifest, manifest, m->head_len, key,
+			key_len);
+	ERR_CALL_HANDLE(code, sigManifestClose(m));
+	// выделить и разметить память
+	code = cmdBlobCreate(stack, 64 * (SIG_DEPTH_MAX + 2) + sigHash_keep());
+	ERR_CALL_HANDLE(code, sigManifestClose(m));
+	path = (octet*)stack;
+	hash = path + 64 * SIG_DEPTH_MAX;
+	leaf = hash + 64;
+	state = leaf + 64;
+	// найти файл
+	code = sigManifestFind(hash, path, &depth, &n, &i, m, file, state);
+	ERR_CALL_HANDLE(code, (cmdBlobClose(stack), sigManifestClose(m)));
+	// проверить содержимое файла
+	code = sigHashFile(leaf, m->hash_len, file, state);
+	ERR_CALL_HANDLE(code, (cmdBlobClose(stack), sigManifestClose(m)));
+	if (!memEq(leaf, hash, m->hash_len))
+		code = ERR_BAD_HASH;
+	ERR_CALL_HANDLE(code, (cmdBlobClose(stack), sigManifestClose(m)));
+	// проверить путь к корню
+	sigHashNode(leaf, m->hash_len, 0, hash, m->hash_len, file, strLen(file),
+		state);
+	if (!sigMerkleFold(hash, leaf, path, depth, n, i, m->hash_len, state) ||
+		!memEq(hash, m->root, m->hash_len))
+		code = ERR_BAD_HASH;
+	// завершить
+	cmdBlobClose(stack);
+	sigManifestClose(m);
+	return code;
+}
+
+/*
+*******************************************************************************
+Извлечение доказательства
+
+sig extr -proof <file> <manifest> <proof>
+*******************************************************************************
+*/
+
+static err_t sigExtrProof(const char* proof, const char* manifest,
+	const char* file)
+{
+	err_t code;
+	sig_manifest m[1];
+	void* stack;
+	octet* path;
+	octet* hash;
+	octet* state;
+	char* text;
+	char* str;
+	size_t depth, n, i, k, len;
+	// прочитать манифест
+	code = sigManifestOpen(m, manifest);
+	ERR_CALL_CHECK(code);
+	// выделить и разметить память
+	len = strLen(file);
+	code = cmdBlobCreate(stack, 64 * (SIG_DEPTH_MAX + 1) + sigHash_keep() +
+		129 * (SIG_DEPTH_MAX + 2) + 32 + len + m->size);
+	ERR_CALL_HANDLE(code, sigManifestClose(m));
+	path = (octet*)stack;
+	hash = path + 64 * SIG_DEPTH_MAX;
+	state = hash + 64;
+	text = (char*)state + sigHash_keep();
+	// найти файл
+	code = sigManifestFind(hash, path, &depth, &n, &i, m, file, state);
+	ERR_CALL_HANDLE(code, (cmdBlobClose(stack), sigManifestClose(m)));
+	// сформировать доказательство
+	hexFrom(text, m->root, m->hash_len), hexLower(text);
+	str = text + 2 * m->hash_len, *str++ = '\n';
+	strCopy(str, "proof "), str += 6;
+	decFromU32(str, sigDecLen(i), (u32)i), str += strLen(str), *str++ = ' ';
+	decFromU32(str, sigDecLen(n), (u32)n), str += strLen(str), *str++ = '\n';
+	hexFrom(str, hash, m->hash_len), hexLower(str);
+	str += 2 * m->hash_len, *str++ = ' ', *str++ = ' ';
+	strCopy(str, file), str += len, *str++ = '\n';
+	for (k = 0; k < depth; ++k)
+	{
+		hexFrom(str, path + m->hash_len * k, m->hash_len), hexLower(str);
+		str += 2 * m->hash_len, *str++ = '\n';
+	}
+	// присоединить подпись манифеста
+	memCopy(str, m->buf + m->body_len, m->size - m->body_len);
+	str += m->size - m->body_len;
+	code = cmdFileWrite(proof, text, (size_t)(str - text));
+	// завершить
+	cmdBlobClose(stack);
+	sigManifestClose(m);
+	return code;
+}
+
 /*
 *******************************************************************************
 Выработка подписи
 
 sig sign [-certs <certs>] [-date <YYMMDD>] -pass <schema> <file> <sig>
+sig sign [-certs <certs>] [-date <YYMMDD>] -pass <schema> -manifest <list>
+  <manifest>
 *******************************************************************************
 */
 
@@ -171,12 +846,13 @@ static err_t sigSign(int argc, char* argv[])
 {
 	err_t code;
 	const char* certs = 0;
+	char* list = 0;
 	octet date[6];
 	cmd_pwd_t pwd = 0;
 	size_t privkey_len;
 	octet* privkey;
 	// самотестирование
-	code = sigSelfTest();
+	code = cmdSelfTest(_name, sigSelfTest);
 	ERR_CALL_CHECK(code);
 	// без даты по умолчанию
 	memSetZero(date, 6);
@@ -214,6 +890,18 @@ static err_t sigSign(int argc, char* argv[])
 				break;
 			--argc, ++argv;
 		}
+		else if (strStartsWith(*argv, "-manifest"))
+		{
+			if (list)
+			{
+				code = ERR_CMD_DUPLICATE;
+				break;
+			}
+			++argv, --argc;
+			ASSERT(argc > 0);
+			list = *argv;
+			++argv, --argc;
+		}
 		else if (strStartsWith(*argv, "-pass"))
 		{
 			if (pwd)
@@ -235,17 +923,33 @@ static err_t sigSign(int argc, char* argv[])
 			break;
 		}
 	}
-	if (code == ERR_OK && (!pwd || argc != 3))
+	if (code == ERR_OK && (!pwd || argc != (list ? 2 : 3)))
 		code = ERR_CMD_PARAMS;
 	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	// манифест: проверить наличие <privkey> и <list>, отсутствие <manifest>
+	if (list)
+	{
+		code = cmdFileValExist(1, argv);
+		ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+		if (!strEq(list, "-"))
+		{
+			code = cmdFileValExist(1, &list);
+			ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+		}
+		code = cmdFileValNotExist(1, argv + 1);
+		ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+	}
 	// проверить наличие <privkey> и <file>
-	code = cmdFileValExist(2, argv);
-	ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
-	// получить разрешение на перезапись <sig>
-	if (!cmdFileAreSame(argv[1], argv[2]))
+	else
 	{
-		code = cmdFileValNotExist(1, argv + 2);
+		code = cmdFileValExist(2, argv);
 		ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+		// получить разрешение на перезапись <sig>
+		if (!cmdFileAreSame(argv[1], argv[2]))
+		{
+			code = cmdFileValNotExist(1, argv + 2);
+			ERR_CALL_HANDLE(code, cmdPwdClose(pwd));
+		}
 	}
 	// прочитать личный ключ
 	privkey_len = 0;
@@ -257,17 +961,151 @@ static err_t sigSign(int argc, char* argv[])
 	cmdPwdClose(pwd);
 	ERR_CALL_HANDLE(code, cmdBlobClose(privkey));
 	// подписать
-	code = cmdSigSign(argv[2], argv[1], certs, date, privkey, privkey_len);
+	if (list)
+		code = sigSignManifest(list, argv[1], certs, date, privkey,
+			privkey_len);
+	else
+		code = cmdSigSign(argv[2], argv[1], certs, date, privkey,
+			privkey_len);
 	// завершить
 	cmdBlobClose(privkey);
 	return code;
 }
 
+/*
+*******************************************************************************
+Пакетная проверка подписей
+
+sig val {-pubkey <pubkey> | -anchor <anchor>} -batch <list>
+
+В файле list (в стандартном потоке ввода, если list == "-") перечисляются
+подписанные файлы, по одному в строке. Строка имеет вид <file> (подпись
+встроена в файл) или <file><TAB><sig> (подпись в отдельном файле).
+
+Открытый ключ (сертификат-якорь) читается и самотестирование выполняется
+один раз. Строки списка обрабатываются пакетами по SIG_BATCH. Подписи пакета
+проверяются в пуле потоков, после завершения пакета результаты печатаются
+в порядке строк.
+*******************************************************************************
+*/
+
+#define SIG_BATCH 256
+#define SIG_LINE 1024
+
+typedef struct {
+	const octet* key;		/*< открытый ключ или сертификат-якорь */
+	size_t key_len;			/*< длина key */
+	bool_t anchor;			/*< key -- сертификат-якорь? */
+} sig_batch;
+
+typedef struct {
+	const sig_batch* batch;	/*< общие данные */
+	const char* file;		/*< подписанный файл */
+	const char* sig;		/*< файл подписи */
+	err_t code;				/*< результат проверки */
+} sig_job;
+
+static void sigValTask(void* arg, void* scratch)
+{
+	sig_job* job = (sig_job*)arg;
+	if (job->batch->anchor)
+		job->code = cmdSigVerify2(job->file, job->sig, job->batch->key,
+			job->batch->key_len);
+	else
+		job->code = cmdSigVerify(job->file, job->sig, job->batch->key,
+			job->batch->key_len);
+}
+
+static err_t sigValBatch(const octet key[], size_t key_len, bool_t anchor,
+	const char* list)
+{
+	err_t code;
+	err_t ret = ERR_OK;
+	sig_batch batch[1];
+	sig_job* jobs;
+	char* lines;
+	mt_pool_t* pool;
+	FILE* fp;
+	size_t count;
+	size_t i;
+	bool_t eof = FALSE;
+	const bool_t in = strEq(list, "-");
+	// подготовить память
+	code = cmdBlobCreate(jobs, SIG_BATCH * (sizeof(sig_job) + SIG_LINE));
+	ERR_CALL_CHECK(code);
+	lines = (char*)(jobs + SIG_BATCH);
+	// открыть список
+	fp = in ? stdin : fopen(list, "rb");
+	code = fp ? ERR_OK : ERR_FILE_OPEN;
+	ERR_CALL_HANDLE(code, cmdBlobClose(jobs));
+	// создать пул (при неудаче проверять в вызывающем потоке)
+	pool = mtPoolCreate(0, 0, 0);
+	batch->key = key, batch->key_len = key_len, batch->anchor = anchor;
+	while (!eof)
+	{
+		// сформировать пакет
+		for (count = 0; count < SIG_BATCH; )
+		{
+			char* str = lines + SIG_LINE * count;
+			size_t len;
+			if (!fgets(str, SIG_LINE, fp))
+			{
+				eof = TRUE;
+				break;
+			}
+			len = strLen(str);
+			while (len && (str[len - 1] == '\n' || str[len - 1] == '\r'))
+				str[--len] = 0;
+			if (!len)
+				continue;
+			jobs[count].batch = batch;
+			jobs[count].file = jobs[count].sig = str;
+			for (; *str; ++str)
+				if (*str == '\t')
+				{
+					*str = 0, jobs[count].sig = str + 1;
+					break;
+				}
+			jobs[count++].code = ERR_OK;
+		}
+		// проверить подписи пакета
+		for (i = 0; i < count; ++i)
+			if (pool)
+				mtPoolSubmit(pool, sigValTask, jobs + i);
+			else
+				sigValTask(jobs + i, 0);
+		if (pool)
+			mtPoolWait(pool);
+		// напечатать результаты
+		for (i = 0; i < count; ++i)
+			if (jobs[i].code == ERR_OK)
+				printf("%s: OK\n", jobs[i].file);
+			else
+			{
+				printf("%s: FAILED [%s]\n", jobs[i].file,
+					errMsg(jobs[i].code));
+				if (ret == ERR_OK)
+					ret = jobs[i].code;
+			}
+	}
+	// завершить
+	if (ferror(fp))
+		code = ERR_FILE_READ;
+	if (!in && fclose(fp) != 0 && code == ERR_OK)
+		code = ERR_BAD_FILE;
+	if (pool)
+		mtPoolClose(pool);
+	cmdBlobClose(jobs);
+	return code != ERR_OK ? code : ret;
+}
+
 /*
 *******************************************************************************
 Проверка подписи
 
 sig val {-pubkey <pubkey> | -anchor <anchor>} <file> <sig>
+sig val {-pubkey <pubkey> | -anchor <anchor>} -batch <list>
+sig val {-pubkey <pubkey> | -anchor <anchor>} -manifest <manifest> <file>
 *******************************************************************************
 */
 
@@ -276,15 +1114,26 @@ static err_t sigVal(int argc, char* argv[])
 	err_t code;
 	size_t count;
 	octet* stack;
+	bool_t manifest;
 	// самотестирование
-	code = sigSelfTest();
+	code = cmdSelfTest(_name, sigSelfTest);
 	ERR_CALL_CHECK(code);
 	// проверить опции
-	if (argc != 4 ||
+	manifest = argc == 5 && strEq(argv[2], "-manifest");
+	if (argc != 4 && !manifest ||
 		!strEq(argv[0], "-pubkey") && !strEq(argv[0], "-anchor"))
 		return ERR_CMD_PARAMS;
-	// проверить наличие {<pubkey> | <anchor>} <file> <sig>
-	code = cmdFileValExist(3, argv + 1);
+	// проверить наличие {<pubkey> | <anchor>} [<file> <sig>]
+	if (manifest)
+	{
+		code = cmdFileValExist(1, argv + 1);
+		ERR_CALL_CHECK(code);
+		code = cmdFileValExist(2, argv + 3);
+	}
+	else if (strEq(argv[2], "-batch"))
+		code = cmdFileValExist(1, argv + 1);
+	else
+		code = cmdFileValExist(3, argv + 1);
 	ERR_CALL_CHECK(code);
 	// прочитать pubkey / anchor
 	code = cmdFileReadAll(0, &count, argv[1]);
@@ -294,7 +1143,12 @@ static err_t sigVal(int argc, char* argv[])
 	code = cmdFileReadAll(stack, &count, argv[1]);
 	ERR_CALL_HANDLE(code, cmdBlobClose(stack));
 	// проверить подпись
-	if (strEq(argv[0], "-pubkey"))
+	if (manifest)
+		code = sigValManifest(stack, count, strEq(argv[0], "-anchor"),
+			argv[3], argv[4]);
+	else if (strEq(argv[2], "-batch"))
+		code = sigValBatch(stack, count, strEq(argv[0], "-anchor"), argv[3]);
+	else if (strEq(argv[0], "-pubkey"))
 		code = cmdSigVerify(argv[2], argv[3], stack, count);
 	else
 		code = cmdSigVerify2(argv[2], argv[3], stack, count);
@@ -308,6 +1162,7 @@ static err_t sigVal(int argc, char* argv[])
 Извлечение из подписи объекта
 
 sig extr {-cert<n>|-body|-sig} <sig> <file>
+sig extr -proof <file> <manifest> <proof>
 *******************************************************************************
 */
 
@@ -315,6 +1170,15 @@ static err_t sigExtr(int argc, char* argv[])
 {
 	err_t code;
 	const char* scope;
+	// доказательство?
+	if (argc == 4 && strEq(argv[0], "-proof"))
+	{
+		code = cmdFileValExist(1, argv + 2);
+		ERR_CALL_CHECK(code);
+		code = cmdFileValNotExist(1, argv + 3);
+		ERR_CALL_CHECK(code);
+		return sigExtrProof(argv[3], argv[2], argv[1]);
+	}
 	// обработать опции
 	if (argc != 3)
 		return ERR_CMD_PARAMS;
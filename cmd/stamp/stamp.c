@@ -4,7 +4,7 @@
 \brief Integrity control of Windows PE Executables
 \project bee2/cmd
 \created 2011.10.18
-\version 2023.10.09
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -14,6 +14,7 @@
 #include <bee2/core/blob.h>
 #include <bee2/core/err.h>
 #include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
 #include <bee2/core/str.h>
 #include <bee2/core/util.h>
 #include <bee2/crypto/belt.h>
@@ -38,6 +39,14 @@
 
 Контрольная сумма представляет собой строку из STAMP_SIZE октетов, которая
 добавляется в исполнимый файл как строковый ресурс с идентификатором STAMP_ID.
+
+Контрольная сумма -- это хэш-значение belt-hash всех октетов файла, кроме
+октетов самой суммы. Файл отображается в память, и хэшируются два фрагмента
+отображения: до суммы и после нее.
+
+В одной команде можно обработать несколько файлов. Файлы обрабатываются
+параллельно пакетами по STAMP_BATCH, результаты печатаются в порядке
+перечисления файлов.
 *******************************************************************************
 */
 
@@ -49,9 +58,9 @@ static int stampUsage()
 	printf(
 		"bee2cmd/%s: %s\n"
 		"Usage:\n"
-		"  stamp -s <file>\n"
+		"  stamp -s <file> [<file> ...]\n"
 		"    set a stamp on <file>\n"
-		"  stamp -c <file>\n"
+		"  stamp -c <file> [<file> ...]\n"
 		"    check a stamp of <file>\n"
 		"\\pre  <file> is a PE-module (exe or dll)\n"
 		"\\pre <file> contains the user-defined resource\n"
@@ -81,49 +90,69 @@ void stampPrint(const octet* stamp, const char* stamp_name)
 /* 
 *******************************************************************************
 Работа с контрольными характеристиками
+
+Функция stampProcess() не печатает сообщений, а возвращает код завершения
+в поле задания. Это позволяет обрабатывать файлы в нескольких потоках
+и печатать сообщения в порядке перечисления файлов.
 *******************************************************************************
 */
 
-static int stampSet(const char* name)
+#define STAMP_OK		0
+#define STAMP_OPEN		1
+#define STAMP_FILE		2
+#define STAMP_NOT_FOUND	3
+#define STAMP_MEMORY	4
+#define STAMP_MISMATCH	5
+
+#define STAMP_BATCH 256
+
+typedef struct {
+	const char* name;			/*< имя файла */
+	bool_t set;					/*< установить характеристику? */
+	octet stamp[STAMP_SIZE];	/*< вычисленная характеристика */
+	octet read[STAMP_SIZE];		/*< прочитанная характеристика */
+	int ret;					/*< код завершения */
+} stamp_job;
+
+static int stampProcess(stamp_job* job)
 {
 	HANDLE hFile;
 	DWORD size;
+	DWORD size_hi;
 	HANDLE hMapping;
 	octet* image;
 	DWORD offset;
 	void* hash_state;
 	// открыть файл
-	hFile = CreateFileA(name, GENERIC_READ | GENERIC_WRITE,
+	hFile = CreateFileA(job->name,
+		job->set ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
 		0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
 	if (hFile == INVALID_HANDLE_VALUE)
-	{
-		printf("File \"%s\" was not found or could not be open.\n", name);
-		return -1;
-	}
-	// длина файла
-	size = SetFilePointer(hFile, 0, NULL, FILE_END);
-	if (size == INVALID_SET_FILE_POINTER)
+		return STAMP_OPEN;
+	// длина файла (PE-модуль меньше 4 Гб)
+	size = GetFileSize(hFile, &size_hi);
+	if ((size == INVALID_FILE_SIZE && GetLastError() != NO_ERROR) ||
+		size_hi != 0)
 	{
 		CloseHandle(hFile);
-		printf("Error processing the file \"%s\".\n", name);
-		return -1;
+		return STAMP_FILE;
 	}
 	// проецировать файл в память
-	hMapping = CreateFileMappingA(hFile, NULL, PAGE_READWRITE, 0, 0, NULL);
+	hMapping = CreateFileMappingA(hFile, NULL,
+		job->set ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
 	if (hMapping == NULL)
 	{
 		CloseHandle(hFile);
-		printf("Error processing the file \"%s\".\n", name);
-		return -1;
+		return STAMP_FILE;
 	}
 	// отобразить файл в память
-	image = (octet*)MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, 0);
+	image = (octet*)MapViewOfFile(hMapping,
+		job->set ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
 	if (image == NULL)
 	{
 		CloseHandle(hMapping);
 		CloseHandle(hFile);
-		printf("Error processing the file \"%s\".\n", name);
-		return -1;
+		return STAMP_FILE;
 	}
 	// найти смещение контрольной характеристики
 	offset = stampFindOffset(image, size);
@@ -132,126 +161,122 @@ static int stampSet(const char* name)
 		UnmapViewOfFile(image);
 		CloseHandle(hMapping);
 		CloseHandle(hFile);
-		printf("A stamp of \"%s\" was not found or corrupted.\n", name);
-		return -1;
+		return STAMP_NOT_FOUND;
 	}
 	// подготовить место для контрольной характеристики
 	CASSERT(STAMP_SIZE >= 32);
-	memSetZero(image + offset, STAMP_SIZE);
-	// стек хэширования
+	memCopy(job->read, image + offset, STAMP_SIZE);
+	memSetZero(job->stamp, STAMP_SIZE);
+	if (job->set)
+		memSetZero(image + offset, STAMP_SIZE);
+	// состояние хэширования
 	hash_state = blobCreate(beltHash_keep());
 	if (!hash_state)
 	{
 		UnmapViewOfFile(image);
 		CloseHandle(hMapping);
 		CloseHandle(hFile);
-		printf("Insufficient memory.\n");
-		return -1;
+		return STAMP_MEMORY;
 	}
-	// хэшировать
+	// хэшировать фрагменты отображения до и после характеристики
 	beltHashStart(hash_state);
 	beltHashStepH(image, offset, hash_state);
 	beltHashStepH(image + offset + STAMP_SIZE,
 		size - offset - STAMP_SIZE, hash_state);
-	beltHashStepG(image + offset, hash_state);
+	beltHashStepG(job->stamp, hash_state);
 	blobClose(hash_state);
-	// печать
-	printf("A stamp successfully added to \"%s\"\n", name);
-	stampPrint(image + offset, "stamp");
+	// установить характеристику
+	if (job->set)
+		memCopy(image + offset, job->stamp, STAMP_SIZE);
 	// завершение
 	UnmapViewOfFile(image);
 	CloseHandle(hMapping);
 	CloseHandle(hFile);
-	return 0;
+	if (!job->set && !memEq(job->read, job->stamp, STAMP_SIZE))
+		return STAMP_MISMATCH;
+	return STAMP_OK;
 }
 
-// проверить характеристику
-static int stampCheck(const char* name)
+static void stampTask(void* arg, void* scratch)
 {
-	HANDLE hFile;
-	DWORD size;
-	HANDLE hMapping;
-	octet* image;
-	DWORD offset;
-	octet stamp[STAMP_SIZE];
-	void* hash_state;
-	bool_t success;
-	// открыть файл
-	hFile = CreateFileA(name, GENERIC_READ, 0, NULL, OPEN_EXISTING, 
-		FILE_ATTRIBUTE_NORMAL, NULL);
-	if (hFile == INVALID_HANDLE_VALUE)
+	stamp_job* job = (stamp_job*)arg;
+	job->ret = stampProcess(job);
+}
+
+static int stampReport(const stamp_job* job)
+{
+	switch (job->ret)
 	{
-		printf("File \"%s\" was not found or could not be open.\n", name);
+	case STAMP_OPEN:
+		printf("File \"%s\" was not found or could not be open.\n",
+			job->name);
 		return -1;
-	}
-	// длина файла
-	size = SetFilePointer(hFile, 0, NULL, FILE_END);
-	if (size == INVALID_SET_FILE_POINTER)
-	{
-		CloseHandle(hFile);
-		printf("Error processing the file \"%s\".\n", name);
+	case STAMP_FILE:
+		printf("Error processing the file \"%s\".\n", job->name);
 		return -1;
-	}
-	// проецировать файл в память
-	hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
-	if (hMapping == NULL)
-	{
-		CloseHandle(hFile);
-		printf("Error processing the file \"%s\".\n", name);
+	case STAMP_NOT_FOUND:
+		printf("A stamp of \"%s\" was not found or corrupted.\n",
+			job->name);
 		return -1;
-	}
-	// отобразить файл в память
-	image = (octet*)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
-	if (image == NULL)
-	{
-		CloseHandle(hMapping);
-		CloseHandle(hFile);
-		printf("Error processing the file \"%s\".\n", name);
+	case STAMP_MEMORY:
+		printf("Insufficient memory.\n");
 		return -1;
 	}
-	// найти смещение контрольной характеристики
-	offset = stampFindOffset(image, size);
-	if (offset == (DWORD)-1)
+	if (job->set)
 	{
-		UnmapViewOfFile(image);
-		CloseHandle(hMapping);
-		CloseHandle(hFile);
-		printf("A stamp of \"%s\" was not found or corrupted.\n", name);
-		return -1;
+		printf("A stamp successfully added to \"%s\"\n", job->name);
+		stampPrint(job->stamp, "stamp");
+		return 0;
 	}
-	// подготовить место для контрольной характеристики
-	CASSERT(STAMP_SIZE >= 32);
-	memSet(stamp, 0, STAMP_SIZE);
-	// состояние хэширования
-	hash_state = blobCreate(beltHash_keep());
-	if (!hash_state)
+	printf("Validating \"%s\"... %s\n", job->name,
+		job->ret == STAMP_OK ? "OK" : "Failed");
+	if (job->ret == STAMP_OK)
+		stampPrint(job->read, "stamp");
+	else
+		stampPrint(job->read, "read_stamp"),
+		stampPrint(job->stamp, "calc_stamp");
+	return job->ret == STAMP_OK ? 0 : -1;
+}
+
+static int stampRun(bool_t set, int argc, char* argv[])
+{
+	stamp_job* jobs;
+	mt_pool_t* pool;
+	size_t count, i;
+	int ret = 0;
+	// выделить память
+	jobs = (stamp_job*)blobCreate(STAMP_BATCH * sizeof(stamp_job));
+	if (!jobs)
 	{
-		UnmapViewOfFile(image);
-		CloseHandle(hMapping);
-		CloseHandle(hFile);
 		printf("Insufficient memory.\n");
 		return -1;
 	}
-	// хэшировать
-	beltHashStart(hash_state);
-	beltHashStepH(image, offset, hash_state);
-	beltHashStepH(image + offset + STAMP_SIZE, 
-		size - offset - STAMP_SIZE, hash_state);
-	beltHashStepG(stamp, hash_state);
-	blobClose(hash_state);
-	// сравнить
-	success = memEq(image + offset, stamp, STAMP_SIZE);
-	printf("Validating \"%s\"... %s\n", name, success ? "OK" : "Failed");
-	if (success)
-		stampPrint(image + offset, "stamp");
-	else
-		stampPrint(image + offset, "read_stamp"),
-		stampPrint(stamp, "calc_stamp");
+	// создать пул (если файлов несколько)
+	pool = argc > 1 ? mtPoolCreate(0, 0, 0) : 0;
+	while (argc)
+	{
+		// обработать пакет
+		for (count = 0; argc && count < STAMP_BATCH; --argc, ++argv)
+		{
+			jobs[count].name = *argv;
+			jobs[count].set = set;
+			if (pool)
+				mtPoolSubmit(pool, stampTask, jobs + count++);
+			else
+				stampTask(jobs + count++, 0);
+		}
+		if (pool)
+			mtPoolWait(pool);
+		// напечатать результаты
+		for (i = 0; i < count; ++i)
+			if (stampReport(jobs + i) != 0)
+				ret = -1;
+	}
 	// завершение
-	UnmapViewOfFile(image);
-	CloseHandle(hMapping);
-	CloseHandle(hFile);
-	return 0;
+	if (pool)
+		mtPoolClose(pool);
+	blobClose(jobs);
+	return ret;
 }
 
 /*
@@ -263,14 +288,14 @@ static int stampCheck(const char* name)
 int stampMain(int argc, char* argv[])
 {
 	// справка
-	if (argc != 3)
+	if (argc < 3)
 		return stampUsage();
 	// разбор команды
 	--argc, ++argv;
 	if (strEq(argv[0], "-s"))
-		return stampSet(argv[1]);
+		return stampRun(TRUE, argc - 1, argv + 1);
 	if (strEq(argv[0], "-c"))
-		return stampCheck(argv[1]);
+		return stampRun(FALSE, argc - 1, argv + 1);
 	return -1;
 }
 
@@ -3,7 +3,7 @@ rem ===========================================================================
 rem \brief Testing command-line interface
 rem \project bee2evp/cmd
 rem \created 2022.06.24
-rem \version 2024.06.14
+rem \version 2026.10.15
 rem \pre The working directory contains zed.csr.
 rem ===========================================================================
 
@@ -74,6 +74,67 @@ if %ERRORLEVEL% equ 0 goto Error
 bee2cmd bsum -b -c -- -c
 if %ERRORLEVEL% equ 0 goto Error
 
+bee2cmd bsum -q -p -c check256
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd bsum -q -c - < check256
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd bsum -q bee2cmd.exe
+if %ERRORLEVEL% equ 0 goto Error
+
+del /q cache 2> nul
+
+bee2cmd bsum -cache cache bee2cmd.exe
+if %ERRORLEVEL% equ 0 goto Error
+
+bee2cmd bsum -cache cache -pass pass:zed bee2cmd.exe test.cmd
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd bsum -cache cache -pass pass:zed -c check256
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd bsum -cache cache -pass pass:ze bee2cmd.exe
+if %ERRORLEVEL% equ 0 goto Error
+
+bee2cmd bsum -cache cache -pass pass:zed -f -c check256
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd bsum -chunks -c check256
+if %ERRORLEVEL% equ 0 goto Error
+
+bee2cmd bsum -bash-prg-tree2561 -chunks bee2cmd.exe
+if %ERRORLEVEL% equ 0 goto Error
+
+bee2cmd bsum -bash256 -chunks bee2cmd.exe test.cmd > manifest
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd bsum -bash256 -j 2 -chunks bee2cmd.exe test.cmd > manifest2
+if %ERRORLEVEL% neq 0 goto Error
+
+fc /b manifest manifest2 > nul
+if %ERRORLEVEL% neq 0 goto Error
+
+del /q sums.belt-hash sums.bash32 2> nul
+
+bee2cmd bsum -belt-hash -bash32 bee2cmd.exe test.cmd
+if %ERRORLEVEL% equ 0 goto Error
+
+bee2cmd bsum -bash32 -bash32 -o sums bee2cmd.exe
+if %ERRORLEVEL% equ 0 goto Error
+
+bee2cmd bsum -belt-hash -bash32 -o sums -chunks bee2cmd.exe
+if %ERRORLEVEL% equ 0 goto Error
+
+bee2cmd bsum -belt-hash -bash32 -o sums bee2cmd.exe test.cmd
+if %ERRORLEVEL% neq 0 goto Error
+
+fc /b sums.belt-hash check256 > nul
+if %ERRORLEVEL% neq 0 goto Error
+
+fc /b sums.bash32 check32 > nul
+if %ERRORLEVEL% neq 0 goto Error
+
 echo ****** OK
 
 rem ===========================================================================
@@ -247,6 +308,21 @@ if %ERRORLEVEL% neq 0 goto Error
 bee2cmd kg extr -pass pass:bob privkey3 pubkey3
 if %ERRORLEVEL% neq 0 goto Error
 
+rmdir /s /q keys 2> nul
+mkdir keys
+
+bee2cmd kg gen -pass pass:fleet -count 5
+if %ERRORLEVEL% equ 0 goto Error
+
+bee2cmd kg gen -l192 -pass pass:fleet -count 5 -outdir keys
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd kg extr -pass pass:fleet keys/privkey5 keys/pubkey
+if %ERRORLEVEL% neq 0 goto Error
+
+fc /b keys\pubkey keys\pubkey5 > nul
+if %ERRORLEVEL% neq 0 goto Error
+
 echo ****** OK
 
 rem ===========================================================================
@@ -446,6 +522,39 @@ if %ERRORLEVEL% neq 0 goto Error
 bee2cmd sig val -anchor cert0 ff ff
 if %ERRORLEVEL% neq 0 goto Error
 
+echo ff> ll
+bee2cmd sig val -anchor cert0 -batch ll
+if %ERRORLEVEL% neq 0 goto Error
+del /q ll 1> nul
+
+del /q mm pp 2> nul
+
+(echo ff& echo cert2& echo cert1)> ll
+bee2cmd sig sign -certs "cert0 cert1 cert2" -pass pass:alice -manifest ll ^
+  privkey2 mm
+if %ERRORLEVEL% neq 0 goto Error
+del /q ll 1> nul
+
+bee2cmd sig val -anchor cert0 -manifest mm cert1
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd sig val -pubkey pubkey2 -manifest mm ff
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd sig val -anchor cert0 -manifest mm cert0
+if %ERRORLEVEL% equ 0 goto Error
+
+bee2cmd sig extr -proof cert2 mm pp
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd sig val -anchor cert0 -manifest pp cert2
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd sig val -anchor cert0 -manifest pp cert1
+if %ERRORLEVEL% equ 0 goto Error
+
+del /q mm pp 1> nul
+
 bee2cmd sig extr -cert0 ff cert01
 if %ERRORLEVEL% neq 0 goto Error
 
@@ -535,7 +644,7 @@ rem ===========================================================================
 
 echo ****** Testing bee2cmd/cvr...
 
-del /q ring2 cert21 cert31 2> nul
+del /q ring2 cert21 cert31 cert32 cert33 2> nul
 
 bee2cmd cvr init -pass pass:alice privkey2 cert2 ring2
 if %ERRORLEVEL% neq 0 goto Error
@@ -558,12 +667,27 @@ if %ERRORLEVEL% neq 0 goto Error
 bee2cmd cvr find ring2 cert2
 if %ERRORLEVEL% equ 0 goto Error
 
+bee2cmd cvr find ring2 cert3 cert3
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd cvr find ring2 cert3 cert2
+if %ERRORLEVEL% equ 0 goto Error
+
 bee2cmd cvr extr -cert0 ring2 cert31
 if %ERRORLEVEL% neq 0 goto Error
 
 fc /b cert31 cert3 1> nul
 if %ERRORLEVEL% neq 0 goto Error
 
+bee2cmd cvr extr -holder 590082394655 ring2 cert32
+if %ERRORLEVEL% neq 0 goto Error
+
+fc /b cert32 cert3 1> nul
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd cvr extr -holder 590082394654 ring2 cert33
+if %ERRORLEVEL% equ 0 goto Error
+
 bee2cmd sig extr -cert0 ring2 cert21
 if %ERRORLEVEL% neq 0 goto Error
 
@@ -638,6 +762,37 @@ if %ERRORLEVEL% neq 0 goto Error
 for %%A in (dd) do set dd_len=%%~zA
 if %dd_len% neq 1024 goto Error
 
+bee2cmd es bench sys sys2
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd es bench sys3
+if %ERRORLEVEL% equ 0 goto Error
+
+echo ****** OK
+
+rem ===========================================================================
+rem  bee2cmd/enc
+rem ===========================================================================
+
+echo ****** Testing bee2cmd/enc...
+
+del /q ee.enc ee1 2> nul
+
+bee2cmd enc enc -alg bash -seg 12 -pass pass:alice zed.csr ee.enc
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd enc print ee.enc
+if %ERRORLEVEL% neq 0 goto Error
+
+bee2cmd enc dec -pass pass:bob ee.enc ee1
+if %ERRORLEVEL% equ 0 goto Error
+
+bee2cmd enc dec -pass pass:alice ee.enc ee1
+if %ERRORLEVEL% neq 0 goto Error
+
+fc /b zed.csr ee1 > nul
+if %ERRORLEVEL% neq 0 goto Error
+
 echo ****** OK
 
 rem ===========================================================================
@@ -3,7 +3,7 @@
 # \brief Testing command-line interface
 # \project bee2evp/cmd
 # \created 2022.06.24
-# \version 2024.06.14
+# \version 2026.10.15
 # \pre The working directory contains zed.csr.
 # =============================================================================
 
@@ -32,7 +32,7 @@ test_ver() {
 }
 
 test_bsum() {
-  rm -rf -- check32 check256 -c \
+  rm -rf -- check32 check256 -c cache \
     || return 2
   $bee2cmd bsum -bash31 $bee2cmd \
     && return 1
@@ -64,6 +64,75 @@ test_bsum() {
     && return 1
   $bee2cmd bsum -b -c -- -c \
     && return 1
+  $bee2cmd bsum -j 0 $bee2cmd \
+    && return 1
+  $bee2cmd bsum -j 2 $bee2cmd $this | cmp - check256 \
+    || return 1
+  $bee2cmd bsum -j 2 -c check256 \
+    || return 1
+  if [ -n "$($bee2cmd bsum -q -c check256)" ]; then
+    return 1
+  fi
+  $bee2cmd bsum -q -p -c - < check256 2>&1 | grep -q "2 files checked" \
+    || return 1
+  $bee2cmd bsum -q $bee2cmd \
+    && return 1
+  $bee2cmd bsum -q -c check32 | grep -q OK \
+    && return 1
+  # cache
+  $bee2cmd bsum -cache cache $bee2cmd \
+    && return 1
+  $bee2cmd bsum -f $bee2cmd \
+    && return 1
+  $bee2cmd bsum -cache cache -pass pass:zed $bee2cmd $this \
+    | cmp - check256 \
+    || return 1
+  $bee2cmd bsum -cache cache -pass pass:zed $bee2cmd $this \
+    | cmp - check256 \
+    || return 1
+  $bee2cmd bsum -cache cache -pass pass:zed -j 2 -c check256 \
+    || return 1
+  $bee2cmd bsum -cache cache -pass pass:ze $bee2cmd \
+    && return 1
+  $bee2cmd bsum -cache cache -pass pass:zed -f $bee2cmd $this \
+    | cmp - check256 \
+    || return 1
+  # chunks
+  $bee2cmd bsum -chunks -c check256 \
+    && return 1
+  $bee2cmd bsum -bash-prg-tree2561 -chunks $bee2cmd \
+    && return 1
+  $bee2cmd bsum -cache cache -pass pass:zed -chunks $bee2cmd \
+    && return 1
+  $bee2cmd bsum -bash256 -chunks $bee2cmd $this > manifest \
+    || return 1
+  $bee2cmd bsum -bash256 -j 2 -chunks $bee2cmd $this | cmp - manifest \
+    || return 1
+  if [ "$(grep " $this\$" manifest | awk '{s += $3} END {print s}')" != \
+    "$(wc -c < $this | tr -d ' ')" ]; then
+    return 1
+  fi
+  # several algorithms
+  rm -f sums.belt-hash sums.bash32 \
+    || return 2
+  $bee2cmd bsum -belt-hash -bash32 $bee2cmd $this \
+    && return 1
+  $bee2cmd bsum -bash32 -bash32 -o sums $bee2cmd \
+    && return 1
+  $bee2cmd bsum -belt-hash -bash-prg-tree2561 -o sums $bee2cmd \
+    && return 1
+  $bee2cmd bsum -belt-hash -bash32 -o sums -chunks $bee2cmd \
+    && return 1
+  $bee2cmd bsum -bash32 -bash64 -bash96 -bash128 -bash160 -o sums $bee2cmd \
+    && return 1
+  $bee2cmd bsum -belt-hash -bash32 -o sums $bee2cmd $this \
+    || return 1
+  cmp sums.belt-hash check256 \
+    || return 1
+  cmp sums.bash32 check32 \
+    || return 1
+  $bee2cmd bsum -bash32 -c sums.bash32 \
+    || return 1
   return 0
 }
 
@@ -195,6 +264,24 @@ test_kg() {
   $bee2cmd kg extr -pass pass:bob privkey3 pubkey3 \
     || return 1
 
+  rm -rf keys && mkdir keys \
+    || return 2
+  $bee2cmd kg gen -pass pass:fleet -count 5 \
+    && return 1
+  $bee2cmd kg gen -pass pass:fleet -count 0 -outdir keys \
+    && return 1
+  $bee2cmd kg gen -pass pass:fleet -count 5 -outdir keys privkey4 \
+    && return 1
+  $bee2cmd kg gen -l192 -pass pass:fleet -count 5 -outdir keys \
+    || return 1
+  $bee2cmd kg extr -pass pass:fleet keys/privkey5 keys/pubkey \
+    || return 1
+  cmp keys/pubkey keys/pubkey5 \
+    || return 1
+  if [ "$(wc -c keys/pubkey1 | awk '{print $1}')" != "96" ]; then
+    return 1
+  fi
+
   return 0
 }
 
@@ -295,7 +382,7 @@ test_cvc() {
 }
 
 test_sig(){
-  rm -rf ss ff cert01 cert11 cert21 body sig\
+  rm -rf ss ff cert01 cert11 cert21 body sig ll mm pp\
     || return 2
 
   echo test> ff
@@ -363,8 +450,35 @@ test_sig(){
     || return 1
   $bee2cmd sig val -anchor cert0 ff ff \
     || return 1
+  echo ff > ll
+  $bee2cmd sig val -anchor cert0 -batch ll \
+    || return 1
+  printf 'ff\nff\tss\n' | $bee2cmd sig val -pubkey pubkey2 -batch - \
+    && return 1
 
-  rm -rf ss body
+  printf 'ff\ncert2\ncert1\nff\n' | $bee2cmd sig sign -pass pass:alice \
+    -manifest - privkey2 mm \
+    && return 1
+  printf 'ff\ncert2\n\ncert1\n' | $bee2cmd sig sign -pass pass:alice \
+    -certs "cert0 cert1 cert2" -manifest - privkey2 mm \
+    || return 1
+  $bee2cmd sig val -anchor cert0 -manifest mm cert1 \
+    || return 1
+  $bee2cmd sig val -pubkey pubkey2 -manifest mm ff \
+    || return 1
+  $bee2cmd sig val -anchor cert0 -manifest mm cert0 \
+    && return 1
+  $bee2cmd sig extr -proof cert2 mm pp \
+    || return 1
+  $bee2cmd sig val -anchor cert0 -manifest pp cert2 \
+    || return 1
+  $bee2cmd sig val -anchor cert0 -manifest pp cert1 \
+    && return 1
+  if [ "$($bee2cmd sig print -certc pp)" != "3" ]; then
+    return 1
+  fi
+
+  rm -rf ss body ll mm pp
 
   $bee2cmd sig sign -certs cert2 -pass pass:alice privkey2 ff ss \
     || return 1
@@ -409,7 +523,7 @@ test_sig(){
 }
 
 test_cvr(){
-  rm -rf ring2 cert21 cert31 \
+  rm -rf ring2 cert21 cert31 cert32 cert33 \
     || return 2
 
   $bee2cmd cvr init -pass pass:alice privkey2 cert2 ring2 \
@@ -426,10 +540,20 @@ test_cvr(){
     || return 1
   $bee2cmd cvr find ring2 cert2 \
     && return 1
+  $bee2cmd cvr find ring2 cert3 cert3 \
+    || return 1
+  $bee2cmd cvr find ring2 cert3 cert2 \
+    && return 1
   $bee2cmd cvr extr -cert0 ring2 cert31 \
     || return 1
   diff cert3 cert31 \
     || return 1
+  $bee2cmd cvr extr -holder 590082394655 ring2 cert32 \
+    || return 1
+  diff cert3 cert32 \
+    || return 1
+  $bee2cmd cvr extr -holder 590082394654 ring2 cert33 \
+    && return 1
   $bee2cmd sig extr -cert0 ring2 cert21 \
     || return 1
   diff cert2 cert21 \
@@ -483,6 +607,89 @@ test_es() {
   if [ "$(wc -c dd | awk '{print $1}')" != "1024" ]; then
     return 1
   fi
+  if [ "$($bee2cmd es read sys2 2 - | wc -c | awk '{print $1}')" != "2048" ];
+  then
+    return 1
+  fi
+  $bee2cmd es bench sys sys2 \
+    || return 1
+  $bee2cmd es bench sys3 \
+    && return 1
+
+  return 0
+}
+
+test_serve() {
+  rm -rf sock ff ss\
+    || return 2
+
+  echo test> ff
+
+  $bee2cmd serve run -certs "cert1 cert2" -pass pass:alice privkey2 \
+    -anchor cert1 sock &
+  for i in $(seq 50); do
+    [ -S sock ] && break
+    sleep 0.1
+  done
+  $bee2cmd serve call sock sign ff ss \
+    || return 1
+  $bee2cmd serve call sock val ff ss \
+    || return 1
+  $bee2cmd sig val -anchor cert1 ff ss \
+    || return 1
+  $bee2cmd serve call sock val ff ff \
+    && return 1
+  if [ "$($bee2cmd serve call sock hash ff | head -n 1)" != \
+    "$($bee2cmd bsum -belt-hash ff)" ]; then
+    return 1
+  fi
+  $bee2cmd serve call sock stop \
+    || return 1
+  wait
+
+  return 0
+}
+
+test_enc() {
+  rm -rf ee ee.enc ee1 ee2 ee3 \
+    || return 2
+
+  head -c 100000 /dev/urandom > ee \
+    || return 2
+
+  $bee2cmd enc enc -pass pass:alice ee \
+    && return 1
+  $bee2cmd enc enc -seg 9 -pass pass:alice ee ee.enc \
+    && return 1
+  $bee2cmd enc enc -alg bash -seg 12 -pass pass:alice ee ee.enc \
+    || return 1
+  $bee2cmd enc print ee.enc \
+    || return 1
+  $bee2cmd enc dec -pass pass:bob ee.enc ee1 \
+    && return 1
+  $bee2cmd enc dec -pass pass:alice ee.enc ee1 \
+    || return 1
+  cmp ee ee1 \
+    || return 1
+  $bee2cmd enc dec -pass pass:alice -from 3 -count 2 ee.enc ee2 \
+    || return 1
+  cmp ee2 <(tail -c +12289 ee | head -c 8192) \
+    || return 1
+  head -c 5000 ee1 > ee3 \
+    || return 2
+  $bee2cmd enc dec -pass pass:alice -resume ee.enc ee3 \
+    || return 1
+  cmp ee ee3 \
+    || return 1
+
+  rm -rf ee.enc ee1 \
+    || return 2
+  $bee2cmd enc enc -pass pass:alice ee ee.enc \
+    || return 1
+  printf '\x01' | dd of=ee.enc bs=1 seek=1000 conv=notrunc 2> /dev/null \
+    || return 2
+  $bee2cmd enc dec -pass pass:alice ee.enc ee1 \
+    && return 1
 
   return 0
 }
@@ -498,4 +705,5 @@ run_test() {
 } 
 
 run_test ver && run_test bsum && run_test pwd && run_test kg && run_test cvc \
-  && run_test sig && run_test cvr && run_test csr && run_test es
+  && run_test sig && run_test cvr && run_test csr && run_test es \
+  && run_test serve && run_test enc
@@ -4,7 +4,7 @@
 \brief Version and build information
 \project bee2/cmd 
 \created 2022.06.22
-\version 2024.01.25
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -12,6 +12,8 @@
 
 #include "../cmd.h"
 #include <bee2/core/util.h>
+#include <bee2/crypto/bash.h>
+#include <bee2/crypto/belt.h>
 #include <stdio.h>
 
 /*
@@ -181,7 +183,8 @@ static void verPrint()
 		"  build options:\n"
 		"    NDEBUG: %s\n"
 		"    safe (constant-time): %s\n"
-		"    bash_platform: %s\n",
+		"    bash_platform: %s [%s]\n"
+		"    belt_platform: %s\n",
 		utilVersion(), __DATE__,
 		verOS(),
 		(unsigned)B_PER_S,
@@ -190,7 +193,8 @@ static void verPrint()
 		verCompiler(),
 		verNDebug(),
 		verSafe(),
-		bash_platform
+		bash_platform, bashPlatform(),
+		beltBlockPlatform()
 	);
 }
 
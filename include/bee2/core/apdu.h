@@ -4,7 +4,7 @@
 \brief Smart card Application Protocol Data Unit
 \project bee2 [cryptographic library]
 \created 2022.10.31
-\version 2022.11.02
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -126,6 +126,74 @@ size_t apduCmdDec(
 	size_t count			/*!< [in] длина apdu в октетах */
 );
 
+/*!	\brief Представление команды APDU
+
+	Представление описывает команду, код которой размещен в другом буфере.
+	Поле cdf указывает на данные команды внутри этого буфера.
+*/
+typedef struct {
+	octet cla;			/*!< класс команды */
+	octet ins;			/*!< инструкция команды */
+	octet p1;			/*!< первый параметр команды */
+	octet p2;			/*!< второй параметр команды */
+	size_t rdf_len;		/*!< максимальная длина данных ответа */
+	size_t cdf_len;		/*!< длина данных команды */
+	const octet* cdf;	/*!< данные команды (в коде команды) */
+} apdu_cmd_view_t;
+
+/*!	\brief Построение представления команды
+
+	Строится представление view команды, заданной кодом [count]apdu.
+	Данные команды не копируются: view->cdf указывает внутрь apdu.
+	Указатель view может быть нулевым, и тогда выполняется только
+	проверка формата кода.
+	\pre Буфер [count]apdu корректен.
+	\return Признак успеха.
+	\remark Правила разбора совпадают с правилами apduCmdDec().
+*/
+bool_t apduCmdView(
+	apdu_cmd_view_t* view,	/*!< [out] представление */
+	const octet apdu[],		/*!< [in] код команды */
+	size_t count			/*!< [in] длина apdu в октетах */
+);
+
+/*!	\brief Позиция данных в коде команды
+
+	Определяется смещение данных команды в ее коде при длине данных
+	cdf_len и максимальной длине данных ответа rdf_len.
+	\return Смещение (4, 5 или 7) или SIZE_MAX, если
+	cdf_len >= 65536 или rdf_len > 65536.
+*/
+size_t apduCmdCDFOffset(
+	size_t cdf_len,			/*!< [in] длина данных команды */
+	size_t rdf_len			/*!< [in] максимальная длина данных ответа */
+);
+
+/*!	\brief Кодирование команды на месте
+
+	Определяется число октетов в коде команды с заголовком hdr
+	(CLA, INS, P1, P2), данными длины cdf_len и максимальной длиной данных
+	ответа rdf_len. Если apdu != 0, то код формируется по этому адресу:
+	данные команды должны быть заранее размещены в apdu по смещению
+	apduCmdCDFOffset(cdf_len, rdf_len), вокруг них записываются заголовок,
+	Lc и Le. Данные не копируются.
+	\pre Если адрес apdu != 0, то по этому адресу зарезервировано
+	apduCmdEnc2(0, hdr, cdf_len, rdf_len) октетов.
+	\pre Буфер hdr либо совпадает с apdu, либо не пересекается с ним.
+	\return Число октетов в коде или SIZE_MAX в случае ошибки.
+	\remark Результат совпадает с результатом apduCmdEnc() для команды
+	с теми же полями. При hdr == apdu функция переписывает в уже
+	сформированном коде только длины. Так можно изменить CLA или rdf_len
+	пересылаемой команды без копирования данных, если смещение данных
+	при этом не меняется.
+*/
+size_t apduCmdEnc2(
+	octet apdu[],			/*!< [in,out] данные / код команды */
+	const octet hdr[4],		/*!< [in] заголовок команды */
+	size_t cdf_len,			/*!< [in] длина данных команды */
+	size_t rdf_len			/*!< [in] максимальная длина данных ответа */
+);
+
 /*!
 *******************************************************************************
 \file apdu.h
@@ -195,6 +263,49 @@ size_t apduRespDec(
 	size_t count				/*!< [in] длина apdu в октетах */
 );
 
+/*!	\brief Представление ответа APDU
+
+	Представление описывает ответ, код которого размещен в другом буфере.
+	Поле rdf указывает на данные ответа внутри этого буфера.
+*/
+typedef struct {
+	octet sw1;			/*!< первый статус ответа */
+	octet sw2;			/*!< второй статус ответа */
+	size_t rdf_len;		/*!< длина данных ответа */
+	const octet* rdf;	/*!< данные ответа (в коде ответа) */
+} apdu_resp_view_t;
+
+/*!	\brief Построение представления ответа
+
+	Строится представление view ответа, заданного кодом [count]apdu.
+	Данные ответа не копируются: view->rdf указывает внутрь apdu.
+	Указатель view может быть нулевым, и тогда выполняется только
+	проверка формата кода.
+	\pre Буфер [count]apdu корректен.
+	\return Признак успеха.
+*/
+bool_t apduRespView(
+	apdu_resp_view_t* view,		/*!< [out] представление */
+	const octet apdu[],			/*!< [in] код ответа */
+	size_t count				/*!< [in] длина apdu в октетах */
+);
+
+/*!	\brief Кодирование ответа на месте
+
+	Определяется число октетов в коде ответа с данными длины rdf_len и
+	статусами sw1, sw2. Если apdu != 0, то данные ответа должны быть заранее
+	размещены в начале apdu, а статусы записываются вслед за ними.
+	\pre Если адрес apdu != 0, то по этому адресу зарезервировано
+	rdf_len + 2 октетов.
+	\return Число октетов в коде или SIZE_MAX, если rdf_len > 65536.
+*/
+size_t apduRespEnc2(
+	octet apdu[],				/*!< [in,out] данные / код ответа */
+	size_t rdf_len,				/*!< [in] длина данных ответа */
+	octet sw1,					/*!< [in] первый статус */
+	octet sw2					/*!< [in] второй статус */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief The Base64 encoding
 \project bee2 [cryptographic library]
 \created 2016.06.16
-\version 2023.02.02
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -52,8 +52,12 @@ Base64-строка -- это слово в алфавите
   не дописывается. Если последний блок состоял из 2 октетов, то будет 
   дописан 1 символ '=', если из 1 октета -- 2 символа. 
 
-\pre Во все функции, кроме возможно b64IsValid(), передаются корректные строки 
-и буферы памяти.
+Кодирование и декодирование выполняются без обращений к таблицам
+и ветвлений, зависящих от данных, и поэтому пригодны для обработки
+секретных данных. При возможности используются векторные инструкции.
+
+\pre Во все функции, кроме возможно b64IsValid() и b64To(), передаются
+корректные строки и буферы памяти.
 *******************************************************************************
 */
 
@@ -79,6 +83,7 @@ bool_t b64IsValid(
 
 	Буфер [count]src кодируется base64-строкой [4 * ((count + 2) / 3) + 1]dest.
 	\pre Буферы dest и src не пересекаются.
+	\safe Функция регулярна.
 */
 void b64From(
 	char* dest,			/*!< [out] строка-приемник */
@@ -92,11 +97,15 @@ void b64From(
 	\pre Если dest != 0, то буфер [count]dest корректен и его размер
 	достаточен для размещения декодированных данных.
 	\pre Буферы dest и src не пересекаются.
-	\pre b64IsValid(src) == TRUE. 
+	\return Признак корректности src (см. b64IsValid()).
+	\remark Корректность src проверяется при декодировании. Если строка
+	некорректна, то содержимое dest не определено. Если dest == 0, то
+	проверяется только длина src.
 	\remark Декодированные данные всегда уместятся  
 	в буфер из 3 * strLen(src) / 4 октетов.
+	\safe Функция регулярна.
 */
-void b64To(
+bool_t b64To(
 	void* dest,			/*!< [out] память-приемник */
 	size_t* count,		/*!< [in,out] размер dest / декодированных данных */
 	const char* src		/*!< [in] строка-источник */
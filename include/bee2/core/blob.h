@@ -4,7 +4,7 @@
 \brief Blobs
 \project bee2 [cryptographic library]
 \created 2012.04.01
-\version 2022.06.17
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -41,10 +41,33 @@ memcpy, memset. Дополнительно по указателю можно о
 например, через файл подкачки. Поэтому в блобах рекомендуется размещать
 ключи и другие критические объекты.
 
+Небольшие блобы размещаются в пулах, разбитых на ячейки нескольких
+классов размеров. Память пулов выделяется у операционной системы
+страницами и, если возможно, закрепляется в физической памяти, т.е.
+исключается из подкачки. Освобожденные ячейки кэшируются в потоках.
+Большие блобы, а также блобы, для которых не хватило пулов, размещаются
+в куче. Очень большие блобы (от 2 Мб), например, таблицы предвычислений,
+размещаются в отдельных отображениях страниц, по возможности больших
+(huge pages, large pages). Если большие страницы недоступны, то
+используются обычные страницы или куча.
+
+Блобы выравниваются на границу BLOB_ALIGN = 64 октета, т.е. на границу
+строки кэша. Векторные реализации алгоритмов могут использовать
+выровненные загрузки и выгрузки при работе с состояниями в блобах,
+а блобы разных потоков не делят строки кэша (нет ложного разделения).
+См. также раздел \ref stack-align.
+
+При освобождении блоба очищаются только октеты, которые действительно
+использовались. Статистика размещения блобов возвращается функцией
+blobStat().
+
 \pre В функциях работы с блобами дескрипторы входных блобов корректны.
 *******************************************************************************
 */
 
+/*!	\brief Выравнивание блобов */
+#define BLOB_ALIGN 64
+
 /*! Дескриптор блоба. */
 typedef void* blob_t;
 
@@ -55,6 +78,7 @@ typedef void* blob_t;
 	при нулевом size и при нехватке памяти.
 	\post Выходной блоб корректен.
 	\remark При создании блоба все его октеты обнуляются.
+	\remark Блоб выравнивается на границу BLOB_ALIGN.
 */
 blob_t blobCreate(
 	size_t size		/*!< [in] размер */
@@ -153,6 +177,38 @@ int blobCmp(
 	const blob_t blob2		/*!< [in] второй блоб */
 );
 
+/*!	\brief Статистика блобов
+
+	Счетчики размещения блобов.
+	\remark Статистика собирается с момента запуска программы.
+	\remark Поля huge_size и thp_size -- текущие объемы памяти блобов,
+	размещенных в явных больших страницах и в страницах, для которых
+	запрошены прозрачные большие страницы (Linux, madvise(MADV_HUGEPAGE)).
+	Объемы учитывают округление до кратных 2 Мб. Операционная система
+	может не выделить прозрачные большие страницы даже после запроса.
+*/
+typedef struct
+{
+	size_t created;		/*!< число созданных блобов */
+	size_t pooled;		/*!< из них размещено в пулах */
+	size_t closed;		/*!< число освобожденных блобов */
+	size_t arenas;		/*!< число страничных областей пулов */
+	size_t locked;		/*!< из них закреплено в физической памяти */
+	size_t mapped;		/*!< число блобов в отображениях страниц */
+	size_t huge_size;	/*!< октетов в явных больших страницах */
+	size_t thp_size;	/*!< октетов в прозрачных больших страницах */
+} blob_stat_t;
+
+/*!	\brief Статистика блобов
+
+	В stat возвращается статистика размещения блобов.
+	\remark Счетчики читаются по отдельности и в многопоточной программе
+	могут быть несогласованы между собой.
+*/
+void blobStat(
+	blob_stat_t* stat		/*!< [out] статистика */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
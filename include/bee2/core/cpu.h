@@ -0,0 +1,110 @@
+/*
+*******************************************************************************
+\file cpu.h
+\brief CPU features
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+/*!
+*******************************************************************************
+\file cpu.h
+\brief Возможности процессора
+*******************************************************************************
+*/
+
+#ifndef __BEE2_CPU_H
+#define __BEE2_CPU_H
+
+#include "bee2/defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+*******************************************************************************
+\file cpu.h
+
+Модуль определяет наборы инструкций, которые поддерживаются процессором
+и операционной системой. Наборы определяются однократно, при первом
+обращении к cpuFeatures() или cpuHas() (см. mtCallOnce()). Реализации,
+которые выбираются во время выполнения (bash-f, belt-block, memXor(),
+умножение без переносов, zm8Mul(), источники trng и trng2), опрашивают
+наборы только через эти функции.
+
+На платформах x86, x64 наборы определяются с помощью инструкции cpuid.
+Для AVX и последующих наборов дополнительно проверяется (инструкция
+xgetbv), что операционная система сохраняет расширенные регистры.
+Наборы RDRAND, RDSEED учитываются только для процессоров Intel и AMD.
+
+На платформе AArch64 набор NEON является базовым, наличие PMULL
+определяется с помощью getauxval(AT_HWCAP) (Linux) или
+sysctlbyname() (Apple).
+
+Зависимые наборы снимаются вместе с базовыми: например, без AVX
+не учитываются AVX2 и AVX512F, без AVX512F -- AVX512BW, AVX512VBMI,
+AVX512IFMA.
+
+Переменная окружения BEE2_CPU_DISABLE задает наборы, которые следует
+считать неподдерживаемыми. Наборы перечисляются через запятую
+по именам из cpuName(), имя "all" снимает все наборы. Например,
+BEE2_CPU_DISABLE=avx512f,pclmul или BEE2_CPU_DISABLE=all (базовые
+реализации). Переменная читается однократно, при определении наборов.
+Переменная предназначена для тестирования.
+*******************************************************************************
+*/
+
+#define CPU_SSE2		((u32)0x00000001)	/*!< SSE2 */
+#define CPU_SSSE3		((u32)0x00000002)	/*!< SSSE3 */
+#define CPU_PCLMUL		((u32)0x00000004)	/*!< PCLMULQDQ */
+#define CPU_AVX			((u32)0x00000008)	/*!< AVX */
+#define CPU_AVX2		((u32)0x00000010)	/*!< AVX2 */
+#define CPU_BMI2		((u32)0x00000020)	/*!< BMI2 */
+#define CPU_ADX			((u32)0x00000040)	/*!< ADX */
+#define CPU_AVX512F		((u32)0x00000080)	/*!< AVX512F */
+#define CPU_AVX512BW	((u32)0x00000100)	/*!< AVX512BW */
+#define CPU_AVX512VBMI	((u32)0x00000200)	/*!< AVX512VBMI */
+#define CPU_AVX512IFMA	((u32)0x00000400)	/*!< AVX512IFMA */
+#define CPU_RDRAND		((u32)0x00000800)	/*!< RDRAND */
+#define CPU_RDSEED		((u32)0x00001000)	/*!< RDSEED */
+#define CPU_NEON		((u32)0x00010000)	/*!< NEON (AArch64) */
+#define CPU_PMULL		((u32)0x00020000)	/*!< PMULL (AArch64) */
+
+/*!	\brief Наборы инструкций
+
+	Определяются наборы инструкций, которые поддерживаются процессором
+	и операционной системой и не сняты переменной окружения
+	BEE2_CPU_DISABLE.
+	\return Объединение флагов CPU_XXX.
+*/
+u32 cpuFeatures();
+
+/*!	\brief Поддерживаются наборы?
+
+	Проверяется, что поддерживаются все наборы инструкций features.
+	\return Признак поддержки.
+*/
+bool_t cpuHas(
+	u32 features		/*!< [in] объединение флагов CPU_XXX */
+);
+
+/*!	\brief Имя набора
+
+	Определяется имя набора инструкций feature.
+	\return Имя набора (строчные буквы, например, "avx2") или 0, если
+	feature не является флагом CPU_XXX.
+*/
+const char* cpuName(
+	u32 feature			/*!< [in] флаг CPU_XXX */
+);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __BEE2_CPU_H */
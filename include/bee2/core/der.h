@@ -4,7 +4,7 @@
 \brief Distinguished Encoding Rules
 \project bee2 [cryptographic library]
 \created 2014.04.21
-\version 2023.09.19
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -334,6 +334,12 @@ TSIZE, TBIT и т.д.
 структуры. Эта ссылка называется якорем, описывается типом der_anchor_t и
 используется при завершении кодирования.
 
+Код контейнера строится за один проход. В начале под длину резервируется
+один октет. При завершении длина дописывается в резерв, а вложенные данные
+сдвигаются только тогда, когда длина не помещается в резерв (128 и более
+октетов). Повторный проход с der == 0 нужен только для того, чтобы заранее
+определить длину кода, например, для выделения памяти.
+
 Якорь используется также при декодировании контейнера: сохраняется в начале,
 учитывается в конце для проверки кода.
 
@@ -800,6 +806,147 @@ size_t derTSEQDecStop(
 /*!	\brief Завершить декодирование SEQ */
 #define derSEQDecStop derTSEQDecStop
 
+/*
+*******************************************************************************
+Курсор
+*******************************************************************************
+*/
+
+/*!	\brief Максимальная глубина вложенности контейнеров в курсоре */
+#define DER_CUR_DEPTH 16
+
+/*!	\brief Курсор
+
+	Курсор последовательно разбирает DER-код: перечисляет элементы
+	(derCurNext()), входит в контейнеры (derCurEnter()) и выходит из них
+	(derCurLeave()). Каждый октет кода проверяется один раз: при разборе
+	TL-префикса элемента проверяется, что значение не выходит за границы
+	объемлющего контейнера, при выходе из контейнера -- что все его
+	элементы разобраны. Значения элементов не копируются: возвращаются
+	указатели внутрь буфера кода.
+
+	Код может поступать порциями (потоком). Позиции курсора отсчитываются
+	от начала потока. Очередная порция передается в derCurFeed(). Если
+	для разбора элемента не хватает октетов, то функции курсора возвращают
+	SIZE_MAX и устанавливают в поле need ненулевое число недостающих
+	октетов (точное или оценку снизу). Для входа в контейнер достаточно
+	его TL-префикса, поэтому большие контейнеры можно разбирать, не
+	размещая их в памяти целиком.
+*/
+typedef struct
+{
+	const octet* der;			/*!< буфер с порцией кода */
+	size_t count;				/*!< длина буфера */
+	size_t off;					/*!< позиция буфера в потоке */
+	size_t pos;					/*!< текущая позиция в потоке */
+	size_t need;				/*!< число недостающих октетов */
+	bool_t eof;					/*!< поток завершен? */
+	size_t depth;				/*!< глубина вложенности */
+	size_t end[DER_CUR_DEPTH];	/*!< позиции окончаний контейнеров */
+} der_cur_t;
+
+/*!	\brief Начало разбора
+
+	Курсор cur настраивается на разбор DER-кода [count]der. Код считается
+	полностью размещенным в der.
+*/
+void derCurStart(
+	der_cur_t* cur,			/*!< [out] курсор */
+	const octet der[],		/*!< [in] DER-код */
+	size_t count			/*!< [in] длина der в октетах */
+);
+
+/*!	\brief Очередная порция кода
+
+	Курсору cur передается буфер [count]der, который содержит октеты потока
+	DER-кода, начиная с позиции off. Признак eof означает, что поток
+	завершен, т.е. der содержит последние октеты.
+	\pre off <= cur->pos <= off + count.
+	\remark Октеты перед позицией cur->pos уже разобраны, их можно
+	не передавать повторно.
+	\remark Указатели на значения, полученные до вызова функции, относятся
+	к прежнему буферу.
+*/
+void derCurFeed(
+	der_cur_t* cur,			/*!< [in,out] курсор */
+	const octet der[],		/*!< [in] порция DER-кода */
+	size_t count,			/*!< [in] длина der в октетах */
+	size_t off,				/*!< [in] позиция der в потоке */
+	bool_t eof				/*!< [in] поток завершен? */
+);
+
+/*!	\brief Просмотр элемента
+
+	Определяются тег tag и длина значения len очередного элемента
+	без продвижения курсора cur.
+	\return Длина TL-префикса элемента, 0, если элементы текущего
+	контейнера (кода) закончились, или SIZE_MAX в случае ошибки или
+	нехватки октетов (cur->need > 0).
+	\remark Любой из указателей tag и len может быть нулевым.
+*/
+size_t derCurPeek(
+	u32* tag,				/*!< [out] тег */
+	size_t* len,			/*!< [out] длина значения */
+	der_cur_t* cur			/*!< [in,out] курсор */
+);
+
+/*!	\brief Разбор элемента
+
+	Определяются тег tag и значение [len?]val очередного элемента, курсор
+	cur продвигается за элемент. Указатель val ссылается внутрь буфера
+	кода.
+	\return Длина элемента, 0, если элементы текущего контейнера
+	закончились, или SIZE_MAX в случае ошибки или нехватки
+	октетов (cur->need > 0).
+	\remark Любой из указателей tag, val и len может быть нулевым.
+	Вызов с нулевыми указателями пропускает элемент.
+	\remark При ошибке курсор не продвигается.
+*/
+size_t derCurNext(
+	u32* tag,				/*!< [out] тег */
+	const octet** val,		/*!< [out] значение */
+	size_t* len,			/*!< [out] длина значения */
+	der_cur_t* cur			/*!< [in,out] курсор */
+);
+
+/*!	\brief Разбор элемента с проверкой тега
+
+	Проверяется, что тег очередного элемента равняется tag, и, если это
+	так, элемент разбирается так же, как в derCurNext().
+	\return Длина элемента или SIZE_MAX в случае ошибки, нехватки октетов
+	(cur->need > 0) или окончания элементов.
+*/
+size_t derCurNext2(
+	const octet** val,		/*!< [out] значение */
+	size_t* len,			/*!< [out] длина значения */
+	der_cur_t* cur,			/*!< [in,out] курсор */
+	u32 tag					/*!< [in] тег */
+);
+
+/*!	\brief Вход в контейнер
+
+	Проверяется, что очередной элемент -- контейнер с тегом tag, и курсор
+	cur устанавливается на первый элемент контейнера.
+	\expect{SIZE_MAX} В tag установлен бит конструктивности.
+	\return Длина TL-префикса контейнера или SIZE_MAX в случае ошибки,
+	нехватки октетов (cur->need > 0) или превышения глубины вложенности
+	DER_CUR_DEPTH.
+*/
+size_t derCurEnter(
+	der_cur_t* cur,			/*!< [in,out] курсор */
+	u32 tag					/*!< [in] тег */
+);
+
+/*!	\brief Выход из контейнера
+
+	Проверяется, что все элементы текущего контейнера разобраны, и курсор
+	cur возвращается на уровень объемлющего контейнера.
+	\return 0 в случае успешного завершения или SIZE_MAX в случае ошибки.
+*/
+size_t derCurLeave(
+	der_cur_t* cur			/*!< [in,out] курсор */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief Hexadecimal strings
 \project bee2 [cryptographic library]
 \created 2015.10.29
-\version 2023.02.02
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -39,8 +39,12 @@ extern "C" {
 Символы 'A' и 'a', 'B' и 'b',... считаются эквивалентными. 
 В соответствии с RFC 4648 преимущество отдается прописным символам.
 
-\pre Во все функции, кроме возможно hexIsValid(), передаются корректные 
-шестнадцатеричные строки и буферы памяти.
+Кодирование и декодирование выполняются без обращений к таблицам
+и ветвлений, зависящих от данных, и поэтому пригодны для обработки
+секретных данных. При возможности используются векторные инструкции.
+
+\pre Во все функции, кроме возможно hexIsValid(), hexTo() и hexToRev(),
+передаются корректные шестнадцатеричные строки и буферы памяти.
 *******************************************************************************
 */
 
@@ -127,6 +131,7 @@ bool_t FAST(hexEqRev)(const void* buf, const char* hex);
 	{2 * count + 1}dest. Первому октету src соответствует первая пара 
 	символов dest, второму октету -- вторая пара и т.д.
 	\pre Буферы dest и src не пересекаются.
+	\safe Функция регулярна.
 */
 void hexFrom(
 	char* dest,			/*!< [out] строка-приемник */
@@ -140,6 +145,7 @@ void hexFrom(
 	[2 * count + 1]dest. Первому октету src соответствует последняя пара 
 	символов dest, второму октету -- предпоследняя пара и т.д.
 	\pre Буферы dest и src не пересекаются.
+	\safe Функция регулярна.
 */
 void hexFromRev(
 	char* dest,			/*!< [out] строка-приемник */
@@ -152,9 +158,12 @@ void hexFromRev(
 	Шестнадцатеричная строка src преобразуется в строку октетов 
 	[strLen(src) / 2]dest. По первой паре символов src определяется первый 
 	октет dest, по второй паре -- второй октет и т.д.
-	\pre hexIsValid(hex) == TRUE.
+	\return Признак корректности src (см. hexIsValid()).
+	\remark Корректность src проверяется при декодировании. Если строка
+	некорректна, то содержимое dest не определено.
+	\safe Функция регулярна.
 */
-void hexTo(
+bool_t hexTo(
 	void* dest,			/*!< [out] память-приемник */
 	const char* src		/*!< [in] строка-источник */
 );
@@ -164,9 +173,12 @@ void hexTo(
 	Шестнадцатеричная строка src преобразуется в строку октетов 
 	[strLen(src) / 2]dest. По последней паре символов src определяется первый 
 	октет dest, по предпоследней паре -- второй октет и т. д.
-	\pre hexIsValid(hex) == TRUE.
+	\return Признак корректности src (см. hexIsValid()).
+	\remark Корректность src проверяется при декодировании. Если строка
+	некорректна, то содержимое dest не определено.
+	\safe Функция регулярна.
 */
-void hexToRev(
+bool_t hexToRev(
 	void* dest,			/*!< [out] память-приемник */
 	const char* src		/*!< [in] строка-источник */
 );
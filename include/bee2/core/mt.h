@@ -4,7 +4,7 @@
 \brief Multithreading
 \project bee2 [cryptographic library]
 \created 2014.10.10
-\version 2023.02.02
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -130,6 +130,105 @@ void mtMtxClose(
 *******************************************************************************
 \file mt.h
 
+\section mt-cnd Условные переменные
+
+Условная переменная позволяет потоку ожидать выполнения условия над общими
+объектами, защищенными мьютексом. Поток блокирует мьютекс, проверяет условие
+и, если оно не выполнено, вызывает mtCndWait(). Функция атомарно
+разблокирует мьютекс и приостанавливает поток. Поток, изменивший общие
+объекты, вызывает mtCndSignal() или mtCndBroadcast(), чтобы возобновить
+один или все ожидающие потоки. Возобновленный поток снова блокирует мьютекс.
+
+Ожидание может завершиться и без вызова mtCndSignal() / mtCndBroadcast()
+(ложное пробуждение, spurious wakeup). Поэтому условие следует проверять
+в цикле:
+\code
+	mtMtxLock(mtx);
+	while (!cond)
+		mtCndWait(cnd, mtx);
+	...
+	mtMtxUnlock(mtx);
+\endcode
+
+Управление условными переменными реализуется по схемам, заданным
+в стандарте языка Си ISO/IEC 9899:2011 (см. заголовочный файл threads.h).
+
+Если операционная система не распознана, то условные переменные будут
+"положительно пустыми": ожидание на них завершается немедленно.
+
+\remark В реализации для Windows используются переменные
+CONDITION_VARIABLE, совместимые с критическими секциями.
+
+\typedef mt_cnd_t
+\brief Условная переменная
+*******************************************************************************
+*/
+
+#ifdef OS_WIN
+	typedef CONDITION_VARIABLE mt_cnd_t;
+#elif defined OS_UNIX
+	typedef pthread_cond_t mt_cnd_t;
+#else
+	typedef bool_t mt_cnd_t;
+#endif
+
+/*!	\brief Создание условной переменной
+
+	Создается условная переменная cnd.
+	\return Признак успеха.
+	\post В случае успеха условная переменная корректна.
+*/
+bool_t mtCndCreate(
+	mt_cnd_t* cnd		/*!< [out] условная переменная */
+);
+
+/*!	\brief Ожидание
+
+	Мьютекс mtx атомарно разблокируется, и поток приостанавливается
+	до возобновления с помощью условной переменной cnd. Перед возвратом
+	мьютекс снова блокируется.
+	\pre Мьютекс mtx заблокирован в текущем потоке.
+	\pre Условная переменная корректна.
+	\remark Возможны ложные пробуждения.
+*/
+void mtCndWait(
+	mt_cnd_t* cnd,		/*!< [in,out] условная переменная */
+	mt_mtx_t* mtx		/*!< [in,out] мьютекс */
+);
+
+/*!	\brief Возобновление одного потока
+
+	Возобновляется один из потоков, ожидающих на условной переменной cnd.
+	\pre Условная переменная корректна.
+	\remark Если ожидающих потоков нет, то ничего не происходит.
+*/
+void mtCndSignal(
+	mt_cnd_t* cnd		/*!< [in,out] условная переменная */
+);
+
+/*!	\brief Возобновление всех потоков
+
+	Возобновляются все потоки, ожидающие на условной переменной cnd.
+	\pre Условная переменная корректна.
+*/
+void mtCndBroadcast(
+	mt_cnd_t* cnd		/*!< [in,out] условная переменная */
+);
+
+/*!	\brief Закрытие условной переменной
+
+	Условная переменная cnd закрывается.
+	\pre Условная переменная корректна и на ней нет ожидающих потоков.
+	\pre mtCndClose() < mtCndCreate().
+*/
+void mtCndClose(
+	mt_cnd_t* cnd		/*!< [in,out] условная переменная */
+);
+
+/*!
+*******************************************************************************
+\file mt.h
+
 \section mt-thrd Управление потоками
 
 Управление потоками реализуется по схемам, заданным в стандарте языка Си
@@ -148,6 +247,14 @@ void mtSleep(
 	u32 ms		/*!< [in] число миллисекунд */
 );
 
+/*!	\brief Уступка процессора
+
+	Текущий поток уступает процессор другим потокам, готовым к выполнению.
+	\remark Функцию рекомендуется вызывать в циклах ожидания.
+	\remark Если операционная система не распознана, то ничего не происходит.
+*/
+void mtThrdYield();
+
 /*!	\brief Вызов один раз
 
 	Функция fn() вызывается в точности один раз даже в ситуации конкурентных
@@ -157,12 +264,178 @@ void mtSleep(
 	функции. 
 	\return TRUE, если fn() успешно вызвана в данном или предыдущем обращении
 	к mtCallOnce(), и FALSE в противном случае.
+	\remark Результаты fn() видны всем потокам, вернувшимся из mtCallOnce().
+	Если вызов fn() уже завершен, то mtCallOnce() сводится к чтению триггера.
+	Потоки, конкурирующие с вызовом fn(), ожидают его завершения, уступая
+	процессор (mtThrdYield()).
 */
 bool_t mtCallOnce(
 	size_t* once,	/*!< [in,out] триггер */
 	void (*fn)()	/*!< [in] функция */
 );
 
+/*!	\brief Поток
+
+	Описатель потока, запущенного функцией mtThrdCreate().
+	\remark Если операционная система не распознана, то поток "положительно
+	пустой": функция потока выполняется непосредственно при его создании.
+*/
+typedef struct
+{
+#ifdef OS_WIN
+	HANDLE h;				/*!< описатель потока */
+#elif defined OS_UNIX
+	pthread_t h;			/*!< идентификатор потока */
+#endif
+	void (*fn)(void*);		/*!< функция потока */
+	void* arg;				/*!< аргумент функции */
+} mt_thrd_t;
+
+/*!	\brief Создание потока
+
+	Создается поток thrd, в котором выполняется функция fn(arg).
+	\return Признак успеха.
+	\post В случае успеха поток должен быть завершен вызовом mtThrdJoin().
+*/
+bool_t mtThrdCreate(
+	mt_thrd_t* thrd,		/*!< [out] поток */
+	void (*fn)(void*),		/*!< [in] функция потока */
+	void* arg				/*!< [in] аргумент функции */
+);
+
+/*!	\brief Ожидание завершения потока
+
+	Ожидается завершение потока thrd, после чего поток закрывается.
+	\expect mtThrdCreate() < mtThrdJoin().
+*/
+void mtThrdJoin(
+	mt_thrd_t* thrd			/*!< [in,out] поток */
+);
+
+/*!	\brief Число процессоров
+
+	Определяется число логических процессоров, доступных процессу.
+	\return Число процессоров (не меньше 1).
+	\remark Результат можно использовать как число потоков, между которыми
+	распределяется вычислительная нагрузка.
+*/
+size_t mtCPUs();
+
+/*!	\brief Число узлов NUMA
+
+	Определяется число узлов NUMA -- групп процессоров с общей локальной
+	памятью.
+	\return Число узлов (не меньше 1).
+	\remark Если операционная система не распознана или не сообщает
+	о топологии памяти, то возвращается 1.
+*/
+size_t mtNodes();
+
+/*!	\brief Текущий узел NUMA
+
+	Определяется узел NUMA процессора, на котором выполняется текущий поток.
+	\return Номер узла (меньше mtNodes()).
+	\remark Если поток не закреплен за процессорами узла, то к моменту
+	возврата он может выполняться уже на другом узле. Поэтому результат --
+	рекомендация.
+*/
+size_t mtNodeCur();
+
+/*!
+*******************************************************************************
+\file mt.h
+
+\section mt-key Ключи потоков
+
+Ключ потока позволяет закрепить за каждым потоком собственное значение
+(указатель). Значение, закрепленное за потоком по ключу, первоначально
+нулевое. При завершении потока с ненулевым закрепленным значением
+для этого значения вызывается деструктор ключа.
+
+Деструктор имеет тип mt_key_dtor_i и должен объявляться с пометкой
+MT_CALLBACK:
+\code
+	static void MT_CALLBACK fooClose(void* val)
+	{
+		...
+	}
+\endcode
+
+Ключи реализуются с помощью функций pthread_key_create() (<pthread.h>)
+и FlsAlloc() (WinAPI). В последнем случае значения закрепляются за волокнами
+(fibers), что для потоков без волокон равносильно закреплению за потоками.
+
+Если операционная система не распознана, то ключи не поддерживаются:
+функция mtKeyCreate() возвращает FALSE.
+
+\typedef mt_key_t
+\brief Ключ потока
+
+\typedef mt_key_dtor_i
+\brief Деструктор значения ключа
+*******************************************************************************
+*/
+
+#ifdef OS_WIN
+	typedef DWORD mt_key_t;
+	#define MT_CALLBACK WINAPI
+#elif defined OS_UNIX
+	typedef pthread_key_t mt_key_t;
+	#define MT_CALLBACK
+#else
+	typedef size_t mt_key_t;
+	#define MT_CALLBACK
+#endif
+
+typedef void (MT_CALLBACK* mt_key_dtor_i)(
+	void* val			/*!< [in,out] закрепленное значение */
+);
+
+/*!	\brief Создание ключа
+
+	Создается ключ потока key с деструктором dtor.
+	\return Признак успеха.
+	\remark Деструктор может быть нулевым.
+*/
+bool_t mtKeyCreate(
+	mt_key_t* key,		/*!< [out] ключ */
+	mt_key_dtor_i dtor	/*!< [in] деструктор */
+);
+
+/*!	\brief Значение ключа
+
+	Определяется значение, закрепленное за текущим потоком по ключу key.
+	\pre Ключ создан.
+	\return Закрепленное значение.
+*/
+void* mtKeyGet(
+	const mt_key_t* key	/*!< [in] ключ */
+);
+
+/*!	\brief Закрепление значения
+
+	За текущим потоком по ключу key закрепляется значение val.
+	\pre Ключ создан.
+	\return Признак успеха.
+	\remark Деструктор для прежнего значения не вызывается.
+*/
+bool_t mtKeySet(
+	mt_key_t* key,		/*!< [in,out] ключ */
+	void* val			/*!< [in] значение */
+);
+
+/*!	\brief Закрытие ключа
+
+	Ключ key закрывается.
+	\pre Ключ создан.
+	\remark Деструкторы для закрепленных значений могут не вызываться
+	(pthread_key_delete()) или вызываться (FlsFree()). Поэтому ключ следует
+	закрывать только после освобождения закрепленных значений.
+*/
+void mtKeyClose(
+	mt_key_t* key		/*!< [in,out] ключ */
+);
+
 /*!
 *******************************************************************************
 \file mt.h
@@ -173,8 +446,21 @@ bool_t mtCallOnce(
 Операции атомарны в том смысле, что счетчик защищен от изменения в других
 потоках вплоть до завершения операции.
 
-\warning Если указатель на счетчик не выровнен на границу size_t, то поведение
-функций может быть непредсказуемым.
+Кроме счетчиков, атомарным операциям подвергаются указатели типа void*.
+
+Функции mtAtomicIncr(), mtAtomicDecr(), mtAtomicFetchAdd(),
+mtAtomicCmpSwap() и mtAtomicCmpSwapPtr() являются полными барьерами
+памяти. Функции чтения mtAtomicLoad() и mtAtomicLoadPtr() имеют семантику
+захвата (acquire): последующие обращения к памяти не переносятся до чтения.
+Функции записи mtAtomicStore() и mtAtomicStorePtr() имеют семантику
+освобождения (release): предшествующие обращения к памяти не переносятся
+после записи. Пара "запись -- чтение" позволяет опубликовать объект:
+поток, прочитавший указатель, видит все изменения объекта, выполненные
+до записи указателя.
+
+\warning Если указатель на счетчик не выровнен на границу size_t
+(указатель на указатель -- на границу void*), то поведение функций может
+быть непредсказуемым.
 *******************************************************************************
 */
 
@@ -210,6 +496,434 @@ size_t mtAtomicCmpSwap(
 	size_t swap		/*!< [in] новое значение */
 );
 
+/*!	\brief Атомарное прибавление
+
+	К счетчику ctr атомарно прибавляется val.
+	\remark Возможно переполнение (сверху, overflow).
+	\return Первоначальное значение счетчика.
+*/
+size_t mtAtomicFetchAdd(
+	size_t* ctr,	/*!< [in,out] счетчик */
+	size_t val		/*!< [in] слагаемое */
+);
+
+/*!	\brief Атомарное чтение
+
+	Атомарно читается значение счетчика ctr (с семантикой захвата).
+	\return Значение счетчика.
+*/
+size_t mtAtomicLoad(
+	const size_t* ctr	/*!< [in] счетчик */
+);
+
+/*!	\brief Атомарная запись
+
+	Счетчик ctr атомарно устанавливается равным val (с семантикой
+	освобождения).
+*/
+void mtAtomicStore(
+	size_t* ctr,	/*!< [out] счетчик */
+	size_t val		/*!< [in] новое значение */
+);
+
+/*!	\brief Атомарное чтение указателя
+
+	Атомарно читается указатель ptr (с семантикой захвата).
+	\return Значение указателя.
+*/
+void* mtAtomicLoadPtr(
+	void* const* ptr	/*!< [in] указатель */
+);
+
+/*!	\brief Атомарная запись указателя
+
+	Указатель ptr атомарно устанавливается равным val (с семантикой
+	освобождения).
+*/
+void mtAtomicStorePtr(
+	void** ptr,		/*!< [out] указатель */
+	void* val		/*!< [in] новое значение */
+);
+
+/*!	\brief Атомарное сравнение с заменой указателя
+
+	Указатель ptr атомарно сравнивается с cmp и, в случае совпадения,
+	устанавливается равным swap.
+	\return Первоначальное значение указателя.
+*/
+void* mtAtomicCmpSwapPtr(
+	void** ptr,		/*!< [in,out] указатель */
+	void* cmp,		/*!< [in] сравниваемое значение */
+	void* swap		/*!< [in] новое значение */
+);
+
+/*!
+*******************************************************************************
+\file mt.h
+
+\section mt-pool Пул потоков
+
+Пул потоков выполняет задачи -- вызовы fn(arg, scratch) -- в нескольких
+рабочих потоках. Задачи ставятся в очередь функцией mtPoolSubmit().
+Функция mtPoolWait() ожидает завершения всех поставленных задач,
+при этом вызывающий поток также выполняет задачи.
+
+У каждого рабочего потока (и у потока, вызывающего mtPoolWait()) есть
+собственная очередь задач (дек). Поток выбирает задачи с конца своей
+очереди, а если она пуста -- с начала очередей других потоков
+(work stealing). Новые задачи распределяются по очередям по кругу.
+Потоки, которым не хватает задач, засыпают на условной переменной.
+
+Каждому потоку выделяется память задач scratch из mtPoolCreate()::scratch
+октетов. Память передается выполняемой задаче и очищается (memWipe())
+после ее завершения. Перед выполнением задачи память обнулена.
+
+В scratch рекомендуется размещать ключи, промежуточные результаты и другие
+критические данные задачи.
+
+Пул создается с ограниченным числом потоков. По запросу (флаг
+MT_POOL_PIN) рабочие потоки закрепляются за процессорами.
+
+По запросу (флаг MT_POOL_NUMA) рабочие потоки распределяются по узлам NUMA
+(см. mtNodes()) и закрепляются за процессорами своих узлов. При этом задачи
+сначала выбираются из очередей потоков своего узла и только затем из
+очередей потоков других узлов. Разделяемые неизменяемые данные задач
+(контексты, таблицы предвычислений) рекомендуется тиражировать по узлам
+с помощью реплик (см. mtRepCreate()).
+
+Пример:
+\code
+	mt_pool_t* pool = mtPoolCreate(0, 1024, 0);
+	if (pool)
+	{
+		for (i = 0; i < n; ++i)
+			mtPoolSubmit(pool, fooTask, foo + i);
+		mtPoolWait(pool);
+		mtPoolClose(pool);
+	}
+\endcode
+
+Если операционная система не распознана, то рабочие потоки не создаются
+и все задачи выполняются в mtPoolWait().
+
+\typedef mt_pool_t
+\brief Пул потоков
+
+\typedef mt_task_i
+\brief Задача пула потоков
+*******************************************************************************
+*/
+
+#define MT_POOL_THREADS_MAX 64
+#define MT_POOL_PIN 1
+#define MT_POOL_NUMA 2
+
+typedef struct mt_pool_st mt_pool_t;
+
+typedef void (*mt_task_i)(
+	void* arg,			/*!< [in,out] аргумент задачи */
+	void* scratch		/*!< [in,out] память задачи */
+);
+
+/*!	\brief Создание пула потоков
+
+	Создается пул из threads потоков с памятью задач из scratch октетов
+	для каждого потока. Параметр flags задает дополнительные возможности:
+	- MT_POOL_PIN -- закрепить рабочие потоки за процессорами;
+	- MT_POOL_NUMA -- распределить рабочие потоки по узлам NUMA.
+	.
+	\return Созданный пул или 0 в случае ошибки.
+	\remark Если threads == 0, то используется mtCPUs() потоков. Число
+	потоков ограничивается MT_POOL_THREADS_MAX. В число потоков входит
+	поток, вызывающий mtPoolWait(), поэтому рабочих потоков создается
+	на один меньше.
+	\remark Закрепление потоков -- рекомендация, которая может
+	не выполняться.
+	\remark При установке MT_POOL_NUMA поток с номером t (вызывающий
+	mtPoolWait() поток имеет номер 0) закрепляется за процессорами узла
+	t % mtNodes(). Флаг MT_POOL_PIN при этом игнорируется. Если mtNodes() == 1,
+	то флаг MT_POOL_NUMA игнорируется.
+*/
+mt_pool_t* mtPoolCreate(
+	size_t threads,		/*!< [in] число потоков */
+	size_t scratch,		/*!< [in] длина памяти задач */
+	size_t flags		/*!< [in] флаги */
+);
+
+/*!	\brief Число потоков пула
+
+	Определяется число потоков пула pool, включая вызывающий поток.
+	\return Число потоков.
+*/
+size_t mtPoolThreads(
+	const mt_pool_t* pool	/*!< [in] пул */
+);
+
+/*!	\brief Постановка задачи
+
+	В пул pool ставится задача fn(arg, scratch).
+	\remark Задачи можно ставить как вне пула, так и из выполняемых задач.
+	\remark Если очереди пула заполнены, то задача выполняется
+	непосредственно в mtPoolSubmit().
+*/
+void mtPoolSubmit(
+	mt_pool_t* pool,	/*!< [in,out] пул */
+	mt_task_i fn,		/*!< [in] задача */
+	void* arg			/*!< [in,out] аргумент задачи */
+);
+
+/*!	\brief Ожидание задач
+
+	Ожидается завершение всех задач, поставленных в пул pool. Вызывающий
+	поток участвует в выполнении задач.
+	\pre Функция не вызывается из задач пула и не вызывается одновременно
+	в нескольких потоках.
+*/
+void mtPoolWait(
+	mt_pool_t* pool		/*!< [in,out] пул */
+);
+
+/*!	\brief Закрытие пула потоков
+
+	Ожидается завершение задач пула pool, после чего рабочие потоки
+	завершаются и пул закрывается. Память пула очищается.
+*/
+void mtPoolClose(
+	mt_pool_t* pool		/*!< [in] пул */
+);
+
+/*!
+*******************************************************************************
+\file mt.h
+
+\section mt-rep Реплики
+
+Реплика -- набор копий неизменяемого объекта, по одной копии на каждый
+узел NUMA. Функция mtRepGet() возвращает копию объекта, которая размещена
+в памяти узла текущего потока. Копия создается при первом обращении к ней
+в потоке, который выполняется на соответствующем узле. Память копии
+выделяется и заполняется в этом потоке, и операционная система (по правилу
+первого касания) размещает страницы копии в локальной памяти узла.
+
+Копирование выполняется функцией копирования, которая передается
+в mtRepCreate(). Для объектов, которые не содержат указателей на свои
+внутренние данные, можно использовать нулевую функцию копирования: тогда
+объект копируется с помощью memCopy(). Для других объектов нужны
+специальные функции, например, bignCtxCopy().
+
+Пример:
+\code
+	mt_rep_t* rep = mtRepCreate(ctx, bignCtx_keep(128), bignCtxCopy);
+	...
+	// в задаче пула
+	code = bignVerifyCtx(mtRepGet(rep), oid_der, oid_len, hash, sig, pubkey);
+	...
+	mtRepClose(rep);
+\endcode
+
+Если mtNodes() == 1, то копии не создаются и mtRepGet() возвращает
+исходный объект.
+
+\typedef mt_rep_t
+\brief Реплика
+
+\typedef mt_rep_copy_i
+\brief Функция копирования объекта
+*******************************************************************************
+*/
+
+typedef struct mt_rep_st mt_rep_t;
+
+typedef void (*mt_rep_copy_i)(
+	void* dest,			/*!< [out] копия */
+	const void* src		/*!< [in] исходный объект */
+);
+
+/*!	\brief Создание реплики
+
+	Создается реплика объекта [size]obj с функцией копирования copy.
+	\return Созданная реплика или 0 в случае ошибки.
+	\remark Если copy == 0, то объект копируется с помощью memCopy().
+	\remark Объект obj не должен изменяться или освобождаться до закрытия
+	реплики.
+*/
+mt_rep_t* mtRepCreate(
+	const void* obj,		/*!< [in] объект */
+	size_t size,			/*!< [in] размер объекта */
+	mt_rep_copy_i copy		/*!< [in] функция копирования */
+);
+
+/*!	\brief Локальная копия
+
+	Определяется копия объекта реплики rep, размещенная в памяти узла NUMA
+	текущего потока. Если копии еще нет, то она создается.
+	\return Копия объекта или исходный объект, если создать копию
+	не удалось.
+	\remark Функцию можно вызывать одновременно в нескольких потоках.
+	Если копию одновременно создают несколько потоков, то сохраняется
+	только одна из копий.
+*/
+const void* mtRepGet(
+	mt_rep_t* rep			/*!< [in,out] реплика */
+);
+
+/*!	\brief Закрытие реплики
+
+	Реплика rep закрывается, копии объекта освобождаются.
+	\pre Полученные с помощью mtRepGet() копии больше не используются.
+*/
+void mtRepClose(
+	mt_rep_t* rep			/*!< [in] реплика */
+);
+
+/*!
+*******************************************************************************
+\file mt.h
+
+\section mt-async Асинхронные запросы
+
+Асинхронный исполнитель принимает запросы и выполняет их в пуле потоков,
+не блокируя вызывающий поток. Запрос -- структура вызывающей стороны,
+которая начинается с заголовка mt_req_t. Буферы запроса (входные данные
+и результаты) принадлежат вызывающей стороне и должны оставаться
+доступными до завершения запроса.
+
+В заголовке запроса задаются обработчик пакета batch и признак
+совместимости key. Запросы с одинаковыми batch и key собираются
+в пакет, и пакет обрабатывается одним вызовом batch(reqs, count, scratch)
+в потоке пула. Обработчик устанавливает коды завершения reqs[i]->code.
+Таким образом, например, проверки подписей на одной кривой передаются
+пакетной функции проверки, а хэширование нескольких сообщений --
+функции многобуферного хэширования (см. bignVerifyAsync(),
+beltHashAsync()).
+
+Пакет отправляется в пул, когда в нем накапливается max запросов
+(см. mtAsyncCreate()) и при вызове mtAsyncFlush(). О завершении запроса
+сообщается одним из двух способов:
+-	если в заголовке задан обратный вызов done, то он выполняется
+	в потоке пула сразу после обработки пакета;
+-	иначе запрос ставится в очередь завершений, из которой его извлекает
+	функция mtAsyncPoll().
+
+Функции mtAsyncSubmit(), mtAsyncFlush() и mtAsyncPoll() можно вызывать
+одновременно в нескольких потоках.
+
+Если пул не задан или в нем нет рабочих потоков, то пакеты
+обрабатываются немедленно, в потоке, который их отправляет.
+
+Пример:
+\code
+	mt_async_t* as = mtAsyncCreate(pool, 32);
+	...
+	req->req.done = 0;
+	bignVerifyAsync(as, req);
+	...
+	mtAsyncFlush(as);
+	while ((r = mtAsyncPoll(as)))
+		onVerified((bign_verify_req_t*)r);
+	...
+	mtAsyncClose(as);
+\endcode
+
+\typedef mt_async_t
+\brief Асинхронный исполнитель
+
+\typedef mt_batch_i
+\brief Обработчик пакета запросов
+
+\typedef mt_done_i
+\brief Обратный вызов завершения запроса
+*******************************************************************************
+*/
+
+typedef struct mt_async_st mt_async_t;
+typedef struct mt_req_st mt_req_t;
+
+typedef void (*mt_batch_i)(
+	mt_req_t* const reqs[],	/*!< [in,out] запросы */
+	size_t count,			/*!< [in] число запросов */
+	void* scratch			/*!< [in,out] память задачи */
+);
+
+typedef void (*mt_done_i)(
+	mt_req_t* req			/*!< [in,out] завершенный запрос */
+);
+
+/*!	\brief Заголовок асинхронного запроса */
+struct mt_req_st
+{
+	mt_batch_i batch;		/*!< обработчик пакета */
+	const void* key;		/*!< признак совместимости */
+	mt_done_i done;			/*!< обратный вызов (или 0) */
+	void* user;				/*!< данные вызывающей стороны */
+	err_t code;				/*!< код завершения */
+	mt_req_t* next;			/*!< служебное поле */
+};
+
+/*!	\brief Создание асинхронного исполнителя
+
+	Создается исполнитель, который выполняет запросы в пуле pool
+	пакетами не более чем из max запросов.
+	\return Созданный исполнитель или 0 в случае ошибки.
+	\remark Пул pool может быть нулевым (см. описание раздела).
+	\remark Если max == 0, то используется max == 1, т.е. запросы
+	не объединяются в пакеты.
+*/
+mt_async_t* mtAsyncCreate(
+	mt_pool_t* pool,		/*!< [in] пул */
+	size_t max				/*!< [in] максимальный размер пакета */
+);
+
+/*!	\brief Постановка запроса
+
+	Запрос req ставится на выполнение в исполнитель as.
+	\pre В req заданы поля batch, key и done.
+	\remark Поля code и next запроса устанавливаются исполнителем.
+*/
+void mtAsyncSubmit(
+	mt_async_t* as,			/*!< [in,out] исполнитель */
+	mt_req_t* req			/*!< [in,out] запрос */
+);
+
+/*!	\brief Отправка незаполненных пакетов
+
+	Все накопленные в исполнителе as пакеты отправляются на обработку
+	независимо от их размера.
+*/
+void mtAsyncFlush(
+	mt_async_t* as			/*!< [in,out] исполнитель */
+);
+
+/*!	\brief Извлечение завершенного запроса
+
+	Из очереди завершений исполнителя as извлекается очередной запрос.
+	\return Завершенный запрос или 0, если очередь пуста.
+	\remark Запросы извлекаются в порядке завершения.
+*/
+mt_req_t* mtAsyncPoll(
+	mt_async_t* as			/*!< [in,out] исполнитель */
+);
+
+/*!	\brief Ожидание запросов
+
+	Накопленные в исполнителе as пакеты отправляются на обработку,
+	после чего ожидается завершение задач пула.
+	\pre Выполняются предусловия mtPoolWait().
+*/
+void mtAsyncWait(
+	mt_async_t* as			/*!< [in,out] исполнитель */
+);
+
+/*!	\brief Закрытие асинхронного исполнителя
+
+	Ожидается завершение запросов исполнителя as (см. mtAsyncWait()),
+	после чего исполнитель закрывается. Завершенные, но не извлеченные
+	запросы остаются в распоряжении вызывающей стороны.
+*/
+void mtAsyncClose(
+	mt_async_t* as			/*!< [in] исполнитель */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief Compound objects
 \project bee2 [cryptographic library]
 \created 2014.04.14
-\version 2014.04.17
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -46,6 +46,12 @@ extern "C" {
 Указатели в таблице могут ссылаться не только на внутренние участки памяти, 
 но и на внешние, т.е. лежащие вне фрагмента, принадлежащего объекту. 
 Внешние ссылки остаются постоянными при перемещении объекта. 
+
+Объект без внешних ссылок можно упаковать (objPack()): ссылки заменяются 
+смещениями, и объект перестает зависеть от своего адреса. Упакованный 
+объект можно сохранить в файле и затем распаковать (objUnpack()) 
+по адресу, по которому файл отображен в память. Распаковывать можно только
+объекты, упакованные в надежной среде.
 ******************************************************************************
 */
 
@@ -93,6 +99,14 @@ typedef struct
 #define objEnd(obj, type)\
 	((type*)((octet*)(obj) + objKeep(obj)))
 
+/*! \brief Const-окончание объекта 
+
+	Определяется адрес окончания фрагмента памяти, занимаемой объектом obj.
+	Адрес интерпретируется как указатель на тип const type.
+*/
+#define objCEnd(obj, type)\
+	((const type*)((const octet*)(obj) + objKeep(obj)))
+
 /*
 *******************************************************************************
 Управление объектом
@@ -146,6 +160,53 @@ void objAppend(
 	size_t i			/*!< [in] номер присоединяемого объекта */
 );
 
+/*!	\brief Упаковка объекта
+
+	Ссылки объекта obj и вложенных в него объектов на внутренние участки
+	памяти заменяются смещениями этих участков. Упакованный объект
+	не зависит от своего адреса: его можно записать в файл или разделяемую
+	память и затем распаковать по другому адресу, в том числе в другом
+	процессе.
+	\pre Объект obj работоспособен.
+	\return Признак успеха. Объект не упаковывается (и остается
+	неизменным), если в таблице указателей obj или вложенных объектов есть
+	внешние ссылки или ссылки на начало объекта.
+	\remark Упаковываются только указатели из таблиц. Другие указатели,
+	например, указатели на функции в описаниях колец и кривых, сохраняются
+	без изменений и остаются действительными только в процессах с тем же
+	размещением кода (например, в процессах, порожденных от общего
+	родителя с помощью fork()).
+	\remark Упакованный объект нельзя использовать до распаковки.
+*/
+bool_t objPack(
+	void* obj			/*!< [in,out] объект */
+);
+
+/*!	\brief Распаковка объекта
+
+	Объект obj, упакованный функцией objPack(), распаковывается
+	по своему текущему адресу: смещения в таблицах указателей obj
+	и вложенных объектов заменяются ссылками.
+	\pre По адресу obj размещается count октетов.
+	\pre Объект obj получен с помощью objPack() из надежного источника
+	в процессе с тем же размещением кода.
+	\return Признак успеха. Объект не распаковывается (и остается
+	неизменным), если его заголовок или смещения некорректны относительно
+	count.
+	\warning Проверки защищают только от случайных искажений (например,
+	усечения файла). Выравнивание вложенных объектов, глубина вложенности
+	и указатели на функции не проверяются, поэтому данные из ненадежного
+	источника распаковывать нельзя.
+	\remark При распаковке изменяются только таблицы указателей. Если obj
+	отображен в память из файла с копированием при записи, то остальные
+	страницы объекта остаются общими для всех процессов, которые
+	отображают файл.
+*/
+bool_t objUnpack(
+	void* obj,			/*!< [in,out] объект */
+	size_t count		/*!< [in] размер памяти */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
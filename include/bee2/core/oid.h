@@ -4,7 +4,7 @@
 \brief Object identifiers
 \project bee2 [cryptographic library]
 \created 2013.02.04
-\version 2022.07.06
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -54,6 +54,12 @@ d1, d2,..., dn, разделенных точками. Числа di запис
 -	"1.2.112.0.2" --- стандарты РБ;
 -	"1.2.112.0.2.0" --- СТБ.
 
+Идентификаторы объектов, которые используются в библиотеке (алгоритмы
+хэширования, стандартные кривые bign, параметры bels, stb99, pfok и др.),
+зарегистрированы в реестре вместе с готовыми DER-кодами. Для них функции
+oidToDER() и oidFromDER() не выполняют арифметику кодирования, а берут
+результат из реестра.
+
 \safe Функции модуля нерегулярны: обрабатываемые идентификаторы не считаются 
 секретными.
 
@@ -76,6 +82,36 @@ bool_t oidIsValid(
 	const char* oid		/*!< [in] идентификатор объекта */
 );
 
+/*
+*******************************************************************************
+Реестр
+*******************************************************************************
+*/
+
+/*!	\brief DER-код зарегистрированного OID
+
+	Определяется DER-код зарегистрированного идентификатора oid.
+	Длина DER-кода возвращается по адресу count.
+	\return Указатель на DER-код в реестре или 0, если идентификатор
+	не зарегистрирован.
+	\remark Адрес count может быть нулевым.
+*/
+const octet* oidRegDER(
+	size_t* count,		/*!< [out] длина DER-кода */
+	const char* oid		/*!< [in] идентификатор объекта */
+);
+
+/*!	\brief Поиск OID по DER-коду
+
+	В реестре ищется идентификатор, представленный DER-кодом [count]der.
+	\return Идентификатор в реестре или 0, если DER-код не принадлежит
+	зарегистрированному идентификатору.
+*/
+const char* oidRegFind(
+	const octet der[],	/*!< [in] DER-код */
+	size_t count		/*!< [in] длина der */
+);
+
 /*
 *******************************************************************************
 Преобразования
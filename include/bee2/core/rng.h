@@ -4,7 +4,7 @@
 \brief Entropy sources and random number generators
 \project bee2 [cryptographic library]
 \created 2014.10.13
-\version 2023.12.19
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -178,6 +178,8 @@ err_t rngESTest(
 	если недостает одного работоспособного источника, и ERR_BAD_ENTROPY
 	в остальных случаях.
 	\remark Проверяемые требования -- это требования СТБ 34.101.27 уровня 1.
+	\remark Проверка выполняется однократно, ее результат сохраняется
+	до завершения процесса.
 */
 err_t rngESHealth();
 
@@ -189,6 +191,8 @@ err_t rngESHealth();
 	в противном случае.
 	\remark Проверяемые требования -- это требования СТБ 34.101.27 уровня 2
 	и выше.
+	\remark Проверка выполняется однократно, ее результат сохраняется
+	до завершения процесса.
 */
 err_t rngESHealth2();
 
@@ -216,15 +220,58 @@ brngCTR (см. crypto/brng.h).
 от доступных источников случайности. Эти данные используются в качестве 
 входного буфера функции brngCTRStepR().
 
-Данные от источников используются в функции rngStepR() и не используются 
+Вместо brngCTR можно использовать программируемый автомат bash-prg
+(см. crypto/bash.h). Механизм генерации выбирается при создании генератора
+функцией rngCreate2(). Автомат выдает случайные числа командой squeeze
+и после каждой выдачи необратимо меняется командой ratchet. Поэтому ранее
+выданные числа нельзя определить по текущему состоянию автомата.
+На платформах с векторными расширениями bash-prg работает быстрее brngCTR.
+
+Данные от источников используются в функции rngStepR() (время от времени
+или, в режиме paranoid, при каждом обращении) и не используются
 в функции rngStepR2(). Первую функцию можно применять время от времени 
 (например, во время согласования общего ключа перед передачей данных), 
 вторую -- регулярно (в процессе передачи данных).
 
+В многопоточных приложениях обращения к генератору синхронизируются.
+Чтобы снизить накладные расходы на синхронизацию, можно использовать
+функцию rngStepR3(). В ней за каждым потоком закрепляется собственный
+экземпляр brngCTR (генератор потока), ключ которого вырабатывается общим
+генератором. После обновления ключа общего генератора, его повторного
+создания, а также в дочернем процессе после fork() генераторы потоков
+получают новые ключи.
+
 С помощью функции rngRekey() можно обновить ключ генератора. После обновления
 ключа случайные числа, сгенерированные ранее, будет невозможно определить
 даже если при их генерации не использовались источники энтропии, а новый ключ
 стал известен противнику.
+
+\section rng-fork Генератор и fork()
+
+В Unix генератор отслеживает создание дочерних процессов функцией fork().
+В дочернем процессе ключ генератора обновляется: в механизм генерации
+вводятся идентификатор процесса и 32 октета от системного источника "sys",
+после чего механизм перезапускается. Обновление выполняется
+в обработчике pthread_atfork(), а если дочерний процесс создан в обход
+обработчиков, -- при первом обращении к rngStepR() или rngStepR2()
+(сменился идентификатор процесса). Поэтому родительский и дочерние процессы
+выдают разные случайные числа, при этом генератор в дочернем процессе
+не создается заново: источники случайности не опрашиваются полностью,
+статистические тесты не проводятся.
+
+Рекомендуемая схема для серверов, которые порождают рабочие процессы
+заранее (pre-fork):
+-	в родительском процессе до fork() вызвать rngCreate() (опрос всех
+	источников выполняется один раз);
+-	там же построить все разделяемые неизменяемые объекты: контексты
+	(bignCtxStart() и др.), кэши и таблицы предвычислений;
+-	в дочерних процессах не вызывать rngCreate() повторно, использовать
+	унаследованные генератор и объекты (страницы памяти разделяются
+	до первой записи);
+-	в процессах, созданных в обход fork() (например, системным вызовом
+	clone()), первым обращением к генератору сделать вызов rngStepR()
+	или rngStepR2(): rngStepR3() смену процесса не обнаруживает.
+.
 *******************************************************************************
 */
 
@@ -243,6 +290,8 @@ brngCTR (см. crypto/brng.h).
 	к ним добавляются данные, полученные от дополнительного источника source.
 	\remark У каждого источника	запрашивается 32 октета данных, но он может
 	выдать меньше. Данные не запрашиваются, если источник отсутствует.
+	Медленный источник "timer" опрашивается, только если остальные
+	источники выдали в совокупности меньше 64 октетов.
 	\remark Поддерживается счетчик обращений к rngCreate(). Счетчик
 	уменьшается функцией rngClose(). При достижении счетчиком нулевого
 	значения накопленные энтропийные данные (в том числе ключ
@@ -253,6 +302,31 @@ err_t rngCreate(
 	void* source_state		/*!< [in] состояние дополнительного источника */
 );
 
+/*!	\brief Создание генератора с выбором механизма
+
+	Создается генератор случайных чисел, который использует механизм
+	генерации engine:
+	- "belt": brngCTR (см. crypto/brng.h);
+	- "bash": программируемый автомат bash-prg (см. crypto/bash.h).
+	.
+	В остальном функция действует так же, как rngCreate().
+	\expect{ERR_BAD_PARAMS} Механизм engine поддерживается.
+	\expect{ERR_BAD_PARAMS} Если генератор уже создан, то механизм engine
+	совпадает с механизмом, выбранным при создании.
+	\return Признак успеха.
+	\remark При нулевом engine используется механизм уже созданного
+	генератора или, если генератор не создан, механизм "belt". Вызов
+	rngCreate(source, source_state) эквивалентен вызову
+	rngCreate2(source, source_state, 0).
+	\remark Генераторы потоков (см. rngStepR3()) используют тот же механизм,
+	что и общий генератор.
+*/
+err_t rngCreate2(
+	read_i source,			/*!< [in] дополнительный источник */
+	void* source_state,		/*!< [in] состояние дополнительного источника */
+	const char* engine		/*!< [in] механизм генерации */
+);
+
 /*!	\brief Корректный генератор?
 
 	Проверяется корректность генератора случайных чисел.
@@ -270,8 +344,13 @@ bool_t rngIsValid();
 	\remark Поддержан интерфейс gen_i (defs.h).
 	\remark Состояние state не используется. Оно передается в функцию только 
 	для того, чтобы поддержать интерфейс gen_i.
-	\remark Запрашивается count октетов от источников. Будет возвращено 
-	меньше октетов только если все источники отказали.
+	\remark Источники опрашиваются по исчерпании бюджета: после выдачи
+	определенного числа случайных октетов или по истечении определенного
+	времени. Данные от источников используются для обновления ключа
+	генератора. В промежутках между опросами rngStepR() действует
+	так же, как rngStepR2().
+	\remark В режиме paranoid (см. rngSetParanoid()) от источников
+	при каждом обращении запрашивается count октетов.
 */
 void rngStepR(
 	void* buf,				/*!< [out] буфер */
@@ -279,6 +358,19 @@ void rngStepR(
 	void* state				/*!< [in,out] состояние (игнорируется) */
 );
 
+/*!	\brief Режим paranoid
+
+	Устанавливается (paranoid == TRUE) или снимается (paranoid == FALSE)
+	режим paranoid, в котором rngStepR() опрашивает источники случайности
+	при каждом обращении.
+	\remark По умолчанию режим paranoid не установлен.
+	\remark Опрос источников при каждом обращении может занимать
+	от микросекунд до миллисекунд (источник timer).
+*/
+void rngSetParanoid(
+	bool_t paranoid			/*!< [in] признак режима */
+);
+
 /*!	\brief Облегченная генерация случайных чисел
 
 	В буфер [count]buf записываются случайные октеты, построенные с помощью 
@@ -296,6 +388,31 @@ void rngStepR2(
 	void* state				/*!< [in,out] состояние (игнорируется) */
 );
 
+/*!	\brief Генерация случайных чисел в потоке
+
+	В буфер [count]buf записываются случайные октеты, построенные с помощью
+	генератора текущего потока. Данные от источников энтропии
+	не используются.
+	\pre Генератор корректен.
+	\expect rngСreate() < rngStepR3()*.
+	\remark Поддержан интерфейс gen_i (defs.h).
+	\remark Состояние state не используется. Оно передается в функцию только
+	для того, чтобы поддержать интерфейс gen_i.
+	\remark Общий генератор блокируется только при выработке ключа
+	генератора потока: при первом обращении потока и после смены ключа
+	общего генератора.
+	\remark Генератор потока вырабатывает случайные октеты порциями
+	(несколько килобайт) и выдает их из буфера. Выданные октеты
+	в буфере очищаются.
+	\remark Если генератор потока создать не удалось, то вызывается
+	rngStepR2().
+*/
+void rngStepR3(
+	void* buf,				/*!< [out] буфер */
+	size_t count,			/*!< [in] размер буфера (в октетах) */
+	void* state				/*!< [in,out] состояние (игнорируется) */
+);
+
 /*!	\brief Обновление ключа генератора
 
 	Ключ генератора обновляется: в его качестве выступают генеририруемые
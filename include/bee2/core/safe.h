@@ -4,7 +4,7 @@
 \brief Safe (regular) calculations
 \project bee2 [cryptographic library]
 \created 2013.10.07
-\version 2019.06.13
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -66,6 +66,16 @@ extern "C" {
 производительности при регуляризации. Директиву следует включать только тогда, 
 когда регулярность библиотеки не имеет значения.
 
+Функции, которые обрабатывают только открытые данные (например, проверка
+ЭЦП в bignVerify(), dstuVerify(), g12sVerify()), могут явно вызывать
+ускоренные редакции FAST(f) независимо от директивы SAFE_FAST. Явные
+вызовы оправданы, только если ускоренная редакция действительно быстрее:
+на x86-64 это так для сравнений (wwCmp(), wwEq(), wwIsZero()) и
+zzNegMod(), но не для zzInvMod(), zzRedMont() и zzDoubleMod(), регулярные
+редакции которых быстрее ускоренных. Арифметика эллиптических кривых
+при проверке ЭЦП остается регулярной: сборка с директивой SAFE_FAST
+не ускоряет bignVerify() заметнее погрешности замеров.
+
 \warning Директива включена вплоть до завершения регуляризации bee2.
 
 \remark Длины строк, размерности массивов не считаются критическими данными.
@@ -4,7 +4,7 @@
 \brief Controlled stack 
 \project bee2 [cryptographic library]
 \created 2012.05.10
-\version 2019.06.13
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -104,9 +104,179 @@ extern "C" {
 
 Для стандартизированного оформления описаний в doxygen предусмотрены 
 окружения \\deep, \\deep{stack}, \\keep, \\keep{state}.
+
+Глубина стека и захват зависят от длин окон и числа предвычисленных
+кратных в алгоритмах умножения точек и возведения в степень. При сборке
+с директивой BEE2_LOW_MEMORY длины окон и число строк гребенок
+ограничиваются величиной 4. Функции работают медленнее, но требуют
+меньше памяти. Значения функций _deep и _keep учитывают директиву.
+*******************************************************************************
+*/
+
+/*!
+*******************************************************************************
+\file stack.h
+
+\section stack-arena Стек потока
+
+Высокоуровневые функции могут размещать контролируемый стек не в куче
+(blobCreate()), а в памяти потока -- буфере, который закрепляется
+за потоком при первом обращении и затем используется повторно.
+Стек в памяти потока создается функцией stackCreate() и освобождается
+функцией stackClose(). Стеки освобождаются в порядке, обратном порядку
+создания, поэтому вложенные вызовы высокоуровневых функций размещают
+свои стеки в одном буфере друг за другом.
+
+Буфер потока расширяется, только если в нем нет созданных стеков,
+и не более чем до максимального размера (см. stackSetMax()). Если стек
+не помещается в буфер, то он создается в куче. При завершении потока
+буфер очищается и освобождается.
+
+Обращения к буферу потока не требуют синхронизации с другими потоками.
+*******************************************************************************
+*/
+
+/*!
+*******************************************************************************
+\file stack.h
+
+\section stack-align Выравнивание состояний
+
+Стеки, созданные функцией stackCreate(), и блобы (см. blobCreate())
+выравниваются на границу STACK_ALIGN = 64 октета, т.е. на границу строки
+кэша. Векторные реализации (bash-f на SSE2, AVX2, AVX512, NEON) могут
+рассчитывать на то, что состояние, размещенное в начале стека или блоба,
+выровнено, и использовать выровненные загрузки и выгрузки.
+
+Если связка g размещает в своем состоянии векторные данные, то она
+располагает их в начале состояния и определяет функцию g_keep_aligned(),
+которая возвращает захват g_keep(), округленный вверх до кратного
+STACK_ALIGN (см. stackAlign()). Массив из n состояний связки следует
+размещать в буфере длины n * g_keep_aligned(), располагая состояния
+по смещениям, кратным g_keep_aligned(). Тогда каждое состояние
+выровнено и занимает собственные строки кэша: состояния, которые
+обрабатываются в разных потоках, не делят строки кэша (нет ложного
+разделения).
+*******************************************************************************
+*/
+
+/*!
+*******************************************************************************
+\file stack.h
+
+\section stack-prof Профилирование глубины стека
+
+Если библиотека собрана с директивой BEE2_INSTRUMENT (опция CMake
+BUILD_INSTRUMENT), то фактическую глубину стеков можно сравнить
+с объявленной. Профилирование начинается вызовом stackProfReset()
+и продолжается до вызова stackProfGet(). При освобождении стека
+определяется число его начальных октетов, которые изменялись: все
+последующие октеты остались нулевыми (стеки stackCreate() обнуляются,
+в том числе при профилировании). Данные по освобожденным стекам
+накапливаются и возвращаются функцией stackProfGet():
+\code
+	stack_prof_t p[1];
+	stackProfReset();
+	bignSign(...);
+	stackProfGet(p);
+\endcode
+Здесь p->declared -- суммарная длина стеков, запрошенная через функции
+_keep и _deep, а p->used -- суммарная длина фактически использованных
+частей стеков. Нулевые октеты, записанные в конец использованной части,
+не учитываются, поэтому p->used -- оценка снизу.
+
+Профилирование предназначено для отладки и тестирования. Данные ведутся
+общими для всех потоков (изменения синхронизируются). Без директивы
+BEE2_INSTRUMENT stackProfIsEnabled() возвращает FALSE, а stackProfGet()
+возвращает нулевые данные.
 *******************************************************************************
 */
 
+/*!	\brief Выравнивание стеков и состояний */
+#define STACK_ALIGN 64
+
+/*!	\def stackAlign
+	\brief Округление длины size вверх до кратного STACK_ALIGN
+*/
+#define stackAlign(size)\
+	(((size) + STACK_ALIGN - 1) / STACK_ALIGN * STACK_ALIGN)
+
+/*!	\brief Максимальный размер буфера потока по умолчанию */
+#define STACK_MAX_DEFAULT ((size_t)1 << 16)
+
+/*!	\brief Создание стека
+
+	Создается стек размера size. Стек размещается в буфере текущего потока
+	или, если места в буфере недостаточно, в куче.
+	\return Указатель на созданный стек. Нулевой указатель возвращается
+	при нулевом size и при нехватке памяти.
+	\remark При создании стека все его октеты обнуляются.
+	\remark Стек выравнивается на границу STACK_ALIGN.
+	\post Стек должен быть освобожден вызовом stackClose() в том же потоке.
+*/
+void* stackCreate(
+	size_t size		/*!< [in] размер */
+);
+
+/*!	\brief Очистка и освобождение стека
+
+	Выполняется очистка и освобождение стека stack.
+	\pre Стек stack создан функцией stackCreate() в текущем потоке.
+	\pre Стеки, созданные в текущем потоке после stack, уже освобождены.
+	\remark Нулевой указатель stack допускается.
+*/
+void stackClose(
+	void* stack		/*!< [in] стек */
+);
+
+/*!	\brief Максимальный размер буфера потока
+
+	Устанавливается максимальный размер max буфера потока.
+	\remark Нулевое значение max запрещает использование буферов потоков:
+	стеки будут создаваться в куче.
+	\remark В буферах потоков не размещаются стеки длины больше max,
+	буферы не расширяются больше чем до max октетов. Функцию следует
+	вызывать перед началом многопоточной работы.
+*/
+void stackSetMax(
+	size_t max		/*!< [in] максимальный размер */
+);
+
+/*!	\brief Данные профилирования */
+typedef struct
+{
+	size_t count;		/*!< число освобожденных стеков */
+	size_t declared;	/*!< суммарная объявленная длина */
+	size_t used;		/*!< суммарная использованная длина */
+	size_t max_used;	/*!< максимальная использованная длина */
+	size_t max_decl;	/*!< объявленная длина стека с max_used */
+} stack_prof_t;
+
+/*!	\brief Профилирование поддерживается?
+
+	Проверяется, что библиотека собрана с директивой BEE2_INSTRUMENT.
+	\return Признак поддержки профилирования.
+*/
+bool_t stackProfIsEnabled();
+
+/*!	\brief Начало профилирования
+
+	Данные профилирования обнуляются. Начинается накопление данных
+	по освобождаемым стекам.
+	\remark Без директивы BEE2_INSTRUMENT функция ничего не делает.
+*/
+void stackProfReset();
+
+/*!	\brief Чтение данных профилирования
+
+	В p копируются данные профилирования, накопленные после последнего
+	вызова stackProfReset(). Профилирование прекращается.
+	\remark Без директивы BEE2_INSTRUMENT данные нулевые.
+*/
+void stackProfGet(
+	stack_prof_t* p		/*!< [out] данные профилирования */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
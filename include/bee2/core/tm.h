@@ -4,7 +4,7 @@
 \brief Time and timers
 \project bee2 [cryptographic library]
 \created 2014.10.13
-\version 2022.07.18
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -41,6 +41,8 @@ extern "C" {
 
 Таймер определяется в следующей очередности (до первого найденного):
 --	на платформах x86, x64 использовать регистр RDTSC;
+--	на платформе AArch64 использовать регистр CNTVCT_EL0 (частота
+	определяется по регистру CNTFRQ_EL0);
 --	в среде Windows использовать функции QueryPerformance[Counter|Frequency]();
 --	в среде Unix использовать функции clock_get[time|res]();
 --	использовать функцию clock() и константу CLOCK_PER_SEC (см. time.h).
@@ -91,6 +93,116 @@ size_t tmSpeed(
 *******************************************************************************
 \file tm.h
 
+\section tm-trace Трассировка
+
+Функции tmTraceBegin(), tmTraceEnd() отмечают начало и окончание
+интервала выполнения. Отметки (события) содержат имя интервала и
+показания таймера tmTicks(). События записываются в кольцевой буфер
+текущего потока на TM_TRACE_EVENTS событий: при переполнении самые старые
+события затираются. Буфер создается при первом событии потока,
+закрепляется за потоком с помощью ключа (см. mtKeyCreate()) и
+освобождается для повторного использования при завершении потока.
+
+События записываются только после вызова tmTraceStart() и до вызова
+tmTraceStop(). Если трассировка не запущена, то tmTraceBegin() и
+tmTraceEnd() сводятся к проверке флага и почти ничего не стоят.
+Поэтому ими отмечены высокоуровневые функции библиотеки: функции
+выработки и проверки ЭЦП и ключей bign, шаги протоколов bake, функции
+шифрования и имитозащиты belt, функции rngCreate() и rngStepR().
+
+Функция tmTraceExport() выгружает события всех буферов в формате
+Chrome Trace Event (JSON, события "B" и "E"). Отметки времени
+приводятся к микросекундам от момента вызова tmTraceStart().
+Выгрузку можно загрузить в chrome://tracing или Perfetto.
+
+Имена интервалов должны быть строковыми константами: в событиях
+сохраняются указатели на имена, а не сами имена.
+
+\warning Функция tmTraceStart() очищает буферы всех потоков. Ее следует
+вызывать, когда другие потоки не выполняют отмеченные функции.
+
+\remark Если ключи потоков не поддерживаются, то все потоки разделяют
+один буфер.
+*******************************************************************************
+*/
+
+/*!	\brief Число событий в буфере потока */
+#define TM_TRACE_EVENTS 4096
+
+/*!	\brief Запуск трассировки
+
+	Очищаются буферы событий и запускается трассировка.
+	\return Признак успеха.
+*/
+bool_t tmTraceStart();
+
+/*!	\brief Останов трассировки
+
+	Трассировка останавливается. Ранее записанные события сохраняются.
+*/
+void tmTraceStop();
+
+/*!	\brief Начало интервала
+
+	В буфер текущего потока записывается событие начала интервала name.
+	\pre name -- строковая константа.
+*/
+void tmTraceBegin(
+	const char* name	/*!< [in] имя интервала */
+);
+
+/*!	\brief Окончание интервала
+
+	В буфер текущего потока записывается событие окончания интервала name.
+	\pre name -- строковая константа.
+*/
+void tmTraceEnd(
+	const char* name	/*!< [in] имя интервала */
+);
+
+/*!	\brief Окончание интервала с возвратом кода
+
+	В буфер текущего потока записывается событие окончания интервала name.
+	\return Код code.
+	\remark Функция предназначена для макроса tmTraceCall().
+*/
+err_t tmTraceEnd2(
+	const char* name,	/*!< [in] имя интервала */
+	err_t code			/*!< [in] код */
+);
+
+/*!	\brief Трассировка вызова
+
+	Выполняется вызов call, возвращающий значение типа err_t. Вызов
+	отмечается как интервал name.
+	\return Результат call.
+*/
+#define tmTraceCall(name, call)\
+	(tmTraceBegin(name), tmTraceEnd2(name, call))
+
+/*!	\brief Выгрузка событий
+
+	Определяется число символов (исключая завершающий нулевой) в
+	представлении событий всех потоков в формате Chrome Trace Event.
+	Если json != 0 и size больше найденного числа, то представление
+	размещается по адресу json. Если json != 0, но size недостаточно,
+	то по адресу json размещается пустая строка.
+	\pre Если json != 0, то по адресу json зарезервировано size октетов,
+	size > 0.
+	\return Число символов.
+	\remark Число событий может измениться между вызовами
+	tmTraceExport(0, 0) и tmTraceExport(json, size), если трассировка
+	не остановлена.
+*/
+size_t tmTraceExport(
+	char* json,			/*!< [out] представление */
+	size_t size			/*!< [in] размер буфера json */
+);
+
+/*!
+*******************************************************************************
+\file tm.h
+
 \section tm-time Время
 
 Системное время задается числом секунд, прошедших с полуночи 
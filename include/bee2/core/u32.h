@@ -4,7 +4,7 @@
 \brief 32-bit words
 \project bee2 [cryptographic library]
 \created 2015.10.28
-\version 2024.11.18
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -56,6 +56,21 @@ extern "C" {
 #define u32RotLo(w, d)\
 	((u32)((w) >> (d) | (w) << (32 - (d))))
 
+/*!	\def u32Rev_
+	\brief Реверс октетов слова u32
+	\remark Компиляторы GCC и Clang транслируют встроенную функцию
+	__builtin_bswap32() в одну инструкцию (bswap, rev, lrvr, brw) или
+	объединяют реверс с загрузкой / выгрузкой слова (lrv, lwbrx, strv),
+	а циклы с реверсом -- в векторные перестановки октетов.
+*/
+#if defined(__GNUC__) || defined(__clang__)
+	#define u32Rev_(w) ((u32)__builtin_bswap32((u32)(w)))
+#else
+	#define u32Rev_(w)\
+		((u32)((w) << 24 | ((w) & 0xFF00) << 8 | ((w) >> 8 & 0xFF00) |\
+		(w) >> 24))
+#endif
+
 /*!	\brief Реверс октетов
 
 	Выполняется реверс октетов u32-слова w.
@@ -4,7 +4,7 @@
 \brief 64-bit words
 \project bee2 [cryptographic library]
 \created 2015.10.28
-\version 2024.11.18
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -59,13 +59,19 @@ extern "C" {
 #define u64RotLo(w, d)\
 	((u64)((w) >> (d) | (w) << (64 - (d))))
 
-/*!	\def u64Rev
+/*!	\def u64Rev_
 	\brief Реверс октетов слова u64
-*/
-#define u64Rev_(w)\
-	((u64)((w) << 56 | ((w) & 0xFF00) << 40 | ((w) & 0xFF0000) << 24 |\
-	((w) & 0xFF000000) << 8 | ((w) >> 8 & 0xFF000000) |\
-	((w) >> 24 & 0xFF0000) | ((w) >> 40 & 0xFF00) | (w) >> 56))
+	\remark В компиляторах GCC и Clang используется встроенная функция
+	__builtin_bswap64() (см. u32Rev_).
+*/
+#if defined(__GNUC__) || defined(__clang__)
+	#define u64Rev_(w) ((u64)__builtin_bswap64((u64)(w)))
+#else
+	#define u64Rev_(w)\
+		((u64)((w) << 56 | ((w) & 0xFF00) << 40 | ((w) & 0xFF0000) << 24 |\
+		((w) & 0xFF000000) << 8 | ((w) >> 8 & 0xFF000000) |\
+		((w) >> 24 & 0xFF0000) | ((w) >> 40 & 0xFF00) | (w) >> 56))
+#endif
 
 /*!	\brief Реверс октетов слова
 
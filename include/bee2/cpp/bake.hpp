@@ -0,0 +1,96 @@
+/*
+*******************************************************************************
+\file bake.hpp
+\brief C++ wrappers: STB 34.101.66 (bake)
+\project bee2 [cryptographic library]
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+/*!
+*******************************************************************************
+\file bake.hpp
+\brief Обертки C++: СТБ 34.101.66 (bake)
+*******************************************************************************
+*/
+
+#ifndef __BEE2_CPP_BAKE_HPP
+#define __BEE2_CPP_BAKE_HPP
+
+#include "bee2/cpp/core.hpp"
+#include "bee2/crypto/bake.h"
+
+namespace bee2 {
+
+/*!	\brief Контекст сервера bake
+
+	Обертка над контекстом, который создает функция bakeCtxStart().
+	Конструктор возбуждает исключение bee2::error при ошибке.
+	\pre privkey.size() == params.l / 4.
+	\pre Данные сертификата cert.data доступны, пока существует контекст
+	(в контексте сохраняется только копия описателя cert).
+*/
+class bake_ctx
+{
+	bee2::state _ctx;
+
+public:
+	bake_ctx(const bign_params& params, cbytes privkey, const bake_cert& cert) :
+		_ctx(bakeCtx_keep(params.l))
+	{
+		ASSERT(privkey.size() == params.l / 4);
+		check(bakeCtxStart(_ctx.get(), &params, privkey.data(), &cert));
+	}
+
+	const void* get() const noexcept { return _ctx.get(); }
+};
+
+/*!	\brief Сеанс протокола BMQV
+
+	Обертка над состоянием, которое создает функция bakeBMQVStart2().
+	Методы step2() -- step5(), key() повторяют функции bakeBMQVStep2() --
+	bakeBMQVStep5(), bakeBMQVStepG() и возвращают их коды.
+	\pre Контекст ctx существует, пока существует сеанс.
+	\pre Длины сообщений соответствуют описанию bakeBMQVStepX().
+*/
+class bake_bmqv
+{
+	bee2::state _st;
+
+public:
+	bake_bmqv(const bake_ctx& ctx, const bake_settings& settings) :
+		_st(bakeBMQV2_keep(ctx.get()))
+	{
+		check(bakeBMQVStart2(_st.get(), ctx.get(), &settings));
+	}
+
+	err_t step2(bytes out)
+	{
+		return bakeBMQVStep2(out.data(), _st.get());
+	}
+	err_t step3(bytes out, cbytes in, const bake_cert& certb)
+	{
+		return bakeBMQVStep3(out.data(), in.data(), &certb, _st.get());
+	}
+	err_t step4(bytes out, cbytes in, const bake_cert& certa)
+	{
+		return bakeBMQVStep4(out.data(), in.data(), &certa, _st.get());
+	}
+	err_t step5(cbytes in)
+	{
+		return bakeBMQVStep5(in.data(), _st.get());
+	}
+	err_t key(bytes key)
+	{
+		ASSERT(key.size() >= 32);
+		return bakeBMQVStepG(key.data(), _st.get());
+	}
+	void* state() noexcept { return _st.get(); }
+};
+
+} // namespace bee2
+
+#endif /* __BEE2_CPP_BAKE_HPP */
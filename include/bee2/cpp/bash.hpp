@@ -0,0 +1,65 @@
+/*
+*******************************************************************************
+\file bash.hpp
+\brief C++ wrappers: STB 34.101.77 (bash)
+\project bee2 [cryptographic library]
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+/*!
+*******************************************************************************
+\file bash.hpp
+\brief Обертки C++: СТБ 34.101.77 (bash)
+*******************************************************************************
+*/
+
+#ifndef __BEE2_CPP_BASH_HPP
+#define __BEE2_CPP_BASH_HPP
+
+#include "bee2/cpp/core.hpp"
+#include "bee2/crypto/bash.h"
+
+namespace bee2 {
+
+/*!	\brief Хэширование bash-hash
+
+	Обертка над функциями bashHashXXX. Объект создается по уровню
+	стойкости l. Методы final() и verify() обрабатывают первые
+	[buf.size()]buf октетов окончательного хэш-значения.
+	\pre l > 0 && l % 16 == 0 && l <= 256.
+	\pre Длины хэш-значений в final() и verify() не превосходят l / 4.
+*/
+class bash_hash
+{
+	bee2::state _st;
+
+public:
+	explicit bash_hash(size_t l) : _st(bashHash_keep())
+	{
+		ASSERT(l > 0 && l % 16 == 0 && l <= 256);
+		bashHashStart(_st.get(), l);
+	}
+
+	bash_hash& update(cbytes buf)
+	{
+		bashHashStepH(buf.data(), buf.size(), _st.get());
+		return *this;
+	}
+	void final(bytes hash)
+	{
+		bashHashStepG(hash.data(), hash.size(), _st.get());
+	}
+	bool_t verify(cbytes hash)
+	{
+		return bashHashStepV(hash.data(), hash.size(), _st.get());
+	}
+	void* state() noexcept { return _st.get(); }
+};
+
+} // namespace bee2
+
+#endif /* __BEE2_CPP_BASH_HPP */
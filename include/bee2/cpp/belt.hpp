@@ -0,0 +1,256 @@
+/*
+*******************************************************************************
+\file belt.hpp
+\brief C++ wrappers: STB 34.101.31 (belt)
+\project bee2 [cryptographic library]
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+/*!
+*******************************************************************************
+\file belt.hpp
+\brief Обертки C++: СТБ 34.101.31 (belt)
+*******************************************************************************
+*/
+
+#ifndef __BEE2_CPP_BELT_HPP
+#define __BEE2_CPP_BELT_HPP
+
+#include "bee2/cpp/core.hpp"
+#include "bee2/crypto/belt.h"
+
+/*!
+*******************************************************************************
+\file belt.hpp
+
+Обертки над функциями хэширования (beltHashXXX), имитозащиты (beltMACXXX,
+beltHMACXXX) и аутентифицированного шифрования (beltCHEXXX, beltDWPXXX).
+
+Методы update(), encrypt(), decrypt(), auth() возвращают ссылку на объект,
+что позволяет строить цепочки вызовов. Метод final() определяет
+[buf.size()]buf первых октетов окончательного хэш-значения или
+имитовставки, метод verify() проверяет первые [buf.size()]buf октетов.
+После final() или verify() обработку можно продолжить.
+
+\pre Длины ключей и синхропосылок соответствуют функциям belt.
+\pre Длины хэш-значений и имитовставок в final() и verify() не превосходят
+длин, которые возвращают соответствующие функции belt.
+*******************************************************************************
+*/
+
+namespace bee2 {
+
+/*!	\brief Хэширование belt-hash */
+class belt_hash
+{
+	bee2::state _st;
+
+public:
+	belt_hash() : _st(beltHash_keep()) { beltHashStart(_st.get()); }
+
+	belt_hash& update(cbytes buf)
+	{
+		beltHashStepH(buf.data(), buf.size(), _st.get());
+		return *this;
+	}
+	void final(bytes hash)
+	{
+		ASSERT(hash.size() <= 32);
+		beltHashStepG2(hash.data(), hash.size(), _st.get());
+	}
+	bool_t verify(cbytes hash)
+	{
+		ASSERT(hash.size() <= 32);
+		return beltHashStepV2(hash.data(), hash.size(), _st.get());
+	}
+	void* state() noexcept { return _st.get(); }
+};
+
+/*!	\brief Имитозащита belt-mac */
+class belt_mac
+{
+	bee2::state _st;
+
+public:
+	explicit belt_mac(cbytes key) : _st(beltMAC_keep())
+	{
+		beltMACStart(_st.get(), key.data(), key.size());
+	}
+
+	belt_mac& update(cbytes buf)
+	{
+		beltMACStepA(buf.data(), buf.size(), _st.get());
+		return *this;
+	}
+	void final(bytes mac)
+	{
+		ASSERT(mac.size() <= 8);
+		beltMACStepG2(mac.data(), mac.size(), _st.get());
+	}
+	bool_t verify(cbytes mac)
+	{
+		ASSERT(mac.size() <= 8);
+		return beltMACStepV2(mac.data(), mac.size(), _st.get());
+	}
+	void* state() noexcept { return _st.get(); }
+};
+
+/*!	\brief Имитозащита belt-hmac */
+class belt_hmac
+{
+	bee2::state _st;
+
+public:
+	explicit belt_hmac(cbytes key) : _st(beltHMAC_keep())
+	{
+		beltHMACStart(_st.get(), key.data(), key.size());
+	}
+
+	belt_hmac& update(cbytes buf)
+	{
+		beltHMACStepA(buf.data(), buf.size(), _st.get());
+		return *this;
+	}
+	void final(bytes mac)
+	{
+		ASSERT(mac.size() <= 32);
+		beltHMACStepG2(mac.data(), mac.size(), _st.get());
+	}
+	bool_t verify(cbytes mac)
+	{
+		ASSERT(mac.size() <= 32);
+		return beltHMACStepV2(mac.data(), mac.size(), _st.get());
+	}
+	void* state() noexcept { return _st.get(); }
+};
+
+/*!	\brief Аутентифицированное шифрование belt-che
+
+	Методы encrypt() и decrypt() с одним аргументом обрабатывают данные
+	на месте, с двумя -- переносят данные из src в dest
+	(dest.size() >= src.size()). Метод auth() учитывает открытые данные,
+	методы encrypt() / decrypt() автоматически учитывают зашифрованные.
+	Имитовставка -- 8 октетов.
+	\expect auth()* < encrypt()* / decrypt()*.
+*/
+class belt_che
+{
+	bee2::state _st;
+
+public:
+	belt_che(cbytes key, cbytes iv) : _st(beltCHE_keep())
+	{
+		ASSERT(iv.size() == 16);
+		beltCHEStart(_st.get(), key.data(), key.size(), iv.data());
+	}
+
+	belt_che& auth(cbytes buf)
+	{
+		beltCHEStepI(buf.data(), buf.size(), _st.get());
+		return *this;
+	}
+	belt_che& encrypt(bytes buf)
+	{
+		beltCHEStepE(buf.data(), buf.size(), _st.get());
+		beltCHEStepA(buf.data(), buf.size(), _st.get());
+		return *this;
+	}
+	belt_che& encrypt(bytes dest, cbytes src)
+	{
+		ASSERT(dest.size() >= src.size());
+		beltCHEStepETo(dest.data(), src.data(), src.size(), _st.get());
+		beltCHEStepA(dest.data(), src.size(), _st.get());
+		return *this;
+	}
+	belt_che& decrypt(bytes buf)
+	{
+		beltCHEStepA(buf.data(), buf.size(), _st.get());
+		beltCHEStepD(buf.data(), buf.size(), _st.get());
+		return *this;
+	}
+	belt_che& decrypt(bytes dest, cbytes src)
+	{
+		ASSERT(dest.size() >= src.size());
+		beltCHEStepA(src.data(), src.size(), _st.get());
+		beltCHEStepDTo(dest.data(), src.data(), src.size(), _st.get());
+		return *this;
+	}
+	void final(bytes mac)
+	{
+		ASSERT(mac.size() >= 8);
+		beltCHEStepG(mac.data(), _st.get());
+	}
+	bool_t verify(cbytes mac)
+	{
+		ASSERT(mac.size() >= 8);
+		return beltCHEStepV(mac.data(), _st.get());
+	}
+	void* state() noexcept { return _st.get(); }
+};
+
+/*!	\brief Аутентифицированное шифрование belt-dwp
+
+	Интерфейс совпадает с интерфейсом belt_che.
+*/
+class belt_dwp
+{
+	bee2::state _st;
+
+public:
+	belt_dwp(cbytes key, cbytes iv) : _st(beltDWP_keep())
+	{
+		ASSERT(iv.size() == 16);
+		beltDWPStart(_st.get(), key.data(), key.size(), iv.data());
+	}
+
+	belt_dwp& auth(cbytes buf)
+	{
+		beltDWPStepI(buf.data(), buf.size(), _st.get());
+		return *this;
+	}
+	belt_dwp& encrypt(bytes buf)
+	{
+		beltDWPStepE(buf.data(), buf.size(), _st.get());
+		beltDWPStepA(buf.data(), buf.size(), _st.get());
+		return *this;
+	}
+	belt_dwp& encrypt(bytes dest, cbytes src)
+	{
+		ASSERT(dest.size() >= src.size());
+		beltDWPStepETo(dest.data(), src.data(), src.size(), _st.get());
+		beltDWPStepA(dest.data(), src.size(), _st.get());
+		return *this;
+	}
+	belt_dwp& decrypt(bytes buf)
+	{
+		beltDWPStepA(buf.data(), buf.size(), _st.get());
+		beltDWPStepD(buf.data(), buf.size(), _st.get());
+		return *this;
+	}
+	belt_dwp& decrypt(bytes dest, cbytes src)
+	{
+		ASSERT(dest.size() >= src.size());
+		beltDWPStepA(src.data(), src.size(), _st.get());
+		beltDWPStepDTo(dest.data(), src.data(), src.size(), _st.get());
+		return *this;
+	}
+	void final(bytes mac)
+	{
+		ASSERT(mac.size() >= 8);
+		beltDWPStepG(mac.data(), _st.get());
+	}
+	bool_t verify(cbytes mac)
+	{
+		ASSERT(mac.size() >= 8);
+		return beltDWPStepV(mac.data(), _st.get());
+	}
+	void* state() noexcept { return _st.get(); }
+};
+
+} // namespace bee2
+
+#endif /* __BEE2_CPP_BELT_HPP */
@@ -0,0 +1,89 @@
+/*
+*******************************************************************************
+\file bign.hpp
+\brief C++ wrappers: STB 34.101.45 (bign)
+\project bee2 [cryptographic library]
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+/*!
+*******************************************************************************
+\file bign.hpp
+\brief Обертки C++: СТБ 34.101.45 (bign)
+*******************************************************************************
+*/
+
+#ifndef __BEE2_CPP_BIGN_HPP
+#define __BEE2_CPP_BIGN_HPP
+
+#include "bee2/cpp/core.hpp"
+#include "bee2/crypto/bign.h"
+
+namespace bee2 {
+
+/*!	\brief Контекст bign
+
+	Обертка над контекстом, который создает функция bignCtxStart().
+	Конструктор возбуждает исключение bee2::error, если параметры
+	некорректны. Методы повторяют функции bignSignCtx(), bignSign2Ctx(),
+	bignVerifyCtx(), bignDHCtx() и возвращают их коды. Длины ключей,
+	подписей и хэш-значений должны соответствовать уровню стойкости l.
+	Длина общего ключа в dh() равняется key.size().
+
+	Контекст используется потоками совместно только для чтения.
+	Метод get() позволяет передать контекст в функции C, например,
+	в mtRepCreate() вместе с bignCtxCopy().
+*/
+class bign_ctx
+{
+	bee2::state _ctx;
+	size_t _l;
+
+public:
+	explicit bign_ctx(const bign_params& params) :
+		_ctx(bignCtx_keep(params.l)), _l(params.l)
+	{
+		check(bignCtxStart(_ctx.get(), &params));
+	}
+
+	size_t l() const noexcept { return _l; }
+
+	err_t sign(bytes sig, cbytes oid_der, cbytes hash, cbytes privkey,
+		gen_i rng, void* rng_state) const
+	{
+		ASSERT(sig.size() >= _l * 3 / 8);
+		ASSERT(hash.size() == _l / 4 && privkey.size() == _l / 4);
+		return bignSignCtx(sig.data(), _ctx.get(), oid_der.data(),
+			oid_der.size(), hash.data(), privkey.data(), rng, rng_state);
+	}
+	err_t sign2(bytes sig, cbytes oid_der, cbytes hash, cbytes privkey,
+		cbytes t = cbytes()) const
+	{
+		ASSERT(sig.size() >= _l * 3 / 8);
+		ASSERT(hash.size() == _l / 4 && privkey.size() == _l / 4);
+		return bignSign2Ctx(sig.data(), _ctx.get(), oid_der.data(),
+			oid_der.size(), hash.data(), privkey.data(), t.data(), t.size());
+	}
+	err_t verify(cbytes oid_der, cbytes hash, cbytes sig, cbytes pubkey) const
+	{
+		ASSERT(hash.size() == _l / 4 && sig.size() == _l * 3 / 8);
+		ASSERT(pubkey.size() == _l / 2);
+		return bignVerifyCtx(_ctx.get(), oid_der.data(), oid_der.size(),
+			hash.data(), sig.data(), pubkey.data());
+	}
+	err_t dh(bytes key, cbytes privkey, cbytes pubkey) const
+	{
+		ASSERT(privkey.size() == _l / 4 && pubkey.size() == _l / 2);
+		return bignDHCtx(key.data(), _ctx.get(), privkey.data(),
+			pubkey.data(), key.size());
+	}
+	const void* get() const noexcept { return _ctx.get(); }
+};
+
+} // namespace bee2
+
+#endif /* __BEE2_CPP_BIGN_HPP */
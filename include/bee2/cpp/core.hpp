@@ -0,0 +1,235 @@
+/*
+*******************************************************************************
+\file core.hpp
+\brief C++ wrappers: spans, errors, states
+\project bee2 [cryptographic library]
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+/*!
+*******************************************************************************
+\file core.hpp
+\brief Обертки C++: фрагменты, ошибки, состояния
+*******************************************************************************
+*/
+
+#ifndef __BEE2_CPP_CORE_HPP
+#define __BEE2_CPP_CORE_HPP
+
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "bee2/defs.h"
+#include "bee2/core/blob.h"
+#include "bee2/core/err.h"
+#include "bee2/core/util.h"
+
+#if defined(__has_include)
+	#if __has_include(<version>)
+		#include <version>
+	#endif
+#endif
+#if defined(__cpp_lib_span)
+	#include <span>
+#endif
+
+/*!
+*******************************************************************************
+\file core.hpp
+
+Заголовочные файлы каталога bee2/cpp содержат обертки C++ (стандарт C++17
+и выше) над функциями библиотеки. Обертки реализованы полностью
+в заголовочных файлах, вычисления выполняются функциями C.
+
+Данные передаются в обертки фрагментами памяти bee2::span<T>
+без копирования. Если стандартная библиотека поддерживает std::span
+(C++20), то bee2::span<T> -- это std::span<T>. Иначе bee2::span<T> --
+минимальная собственная реализация с тем же интерфейсом: указатель
+data(), число элементов size(), перечисление begin() / end(), выделение
+подфрагментов first(), last(), subspan(). Фрагменты строятся по
+указателю и длине, по массивам и по контейнерам с методами data()
+и size() (std::vector, std::array, std::string).
+
+Объекты-обертки (состояния хэширования и имитозащиты, контексты bign
+и bake) только перемещаются, но не копируются. Память под состояние
+выделяется функцией blobCreate() по размеру, который возвращает функция
+xxx_keep(): небольшие состояния размещаются в пулах блобов, т.е. в
+закрепленной памяти с кэшированием в потоках, большие -- в куче или
+отдельных отображениях страниц. При перемещении передается только
+дескриптор блоба, поэтому состояния с внутренними указателями
+(например, контексты bign) остаются корректными. При уничтожении
+объекта состояние очищается (см. blobClose()).
+
+Ошибки конструкторов передаются исключениями: нехватка памяти --
+std::bad_alloc, прочие ошибки -- bee2::error с кодом err_t. Методы
+объектов возвращают err_t или bool_t, как и соответствующие функции C.
+*******************************************************************************
+*/
+
+namespace bee2 {
+
+/*
+*******************************************************************************
+Фрагменты
+*******************************************************************************
+*/
+
+#if defined(__cpp_lib_span)
+
+template<class T> using span = std::span<T>;
+
+#else
+
+/*!	\brief Фрагмент памяти
+
+	Последовательность [size()]data() элементов типа T, которая
+	принадлежит другому объекту.
+*/
+template<class T> class span
+{
+	T* _data;
+	size_t _size;
+
+	template<class C> using data_t =
+		decltype(std::declval<C&>().data());
+
+public:
+	typedef T element_type;
+	typedef typename std::remove_cv<T>::type value_type;
+	typedef T* iterator;
+
+	constexpr span() noexcept : _data(0), _size(0) {}
+	constexpr span(T* data, size_t size) noexcept :
+		_data(data), _size(size) {}
+	template<size_t N> constexpr span(T (&arr)[N]) noexcept :
+		_data(arr), _size(N) {}
+	template<class C, class = typename std::enable_if<
+		!std::is_array<C>::value &&
+		std::is_convertible<data_t<C>, T*>::value>::type>
+	constexpr span(C& c) noexcept : _data(c.data()), _size(c.size()) {}
+	template<class C, class = typename std::enable_if<
+		!std::is_array<C>::value &&
+		std::is_convertible<data_t<const C>, T*>::value>::type>
+	constexpr span(const C& c) noexcept : _data(c.data()), _size(c.size()) {}
+
+	constexpr T* data() const noexcept { return _data; }
+	constexpr size_t size() const noexcept { return _size; }
+	constexpr size_t size_bytes() const noexcept
+		{ return _size * sizeof(T); }
+	constexpr bool empty() const noexcept { return _size == 0; }
+	constexpr T& operator[](size_t i) const noexcept { return _data[i]; }
+	constexpr T* begin() const noexcept { return _data; }
+	constexpr T* end() const noexcept { return _data + _size; }
+
+	constexpr span first(size_t count) const noexcept
+		{ return span(_data, count); }
+	constexpr span last(size_t count) const noexcept
+		{ return span(_data + _size - count, count); }
+	constexpr span subspan(size_t offset, size_t count = size_t(-1))
+		const noexcept
+	{
+		return span(_data + offset,
+			count == size_t(-1) ? _size - offset : count);
+	}
+};
+
+#endif
+
+/*!	\brief Октеты только для чтения */
+typedef span<const octet> cbytes;
+
+/*!	\brief Октеты для записи */
+typedef span<octet> bytes;
+
+/*
+*******************************************************************************
+Ошибки
+*******************************************************************************
+*/
+
+/*!	\brief Исключение с кодом ошибки
+
+	Исключение, которое возбуждают конструкторы оберток, если функция C
+	вернула код ошибки code(). Описание ошибки what() -- это errMsg(code())
+	или "unknown error", если описание отсутствует.
+*/
+class error : public std::runtime_error
+{
+	err_t _code;
+
+	static const char* msg(err_t code) noexcept
+	{
+		const char* m = errMsg(code);
+		return m ? m : "unknown error";
+	}
+
+public:
+	explicit error(err_t code) : std::runtime_error(msg(code)), _code(code) {}
+	err_t code() const noexcept { return _code; }
+};
+
+/*!	\brief Проверка кода ошибки
+
+	Если code != ERR_OK, то возбуждается исключение: std::bad_alloc при
+	code == ERR_OUTOFMEMORY, bee2::error(code) в остальных случаях.
+*/
+inline void check(err_t code)
+{
+	if (code == ERR_OUTOFMEMORY)
+		throw std::bad_alloc();
+	if (code != ERR_OK)
+		throw error(code);
+}
+
+/*
+*******************************************************************************
+Состояния
+*******************************************************************************
+*/
+
+/*!	\brief Состояние
+
+	Блок памяти, выделенный функцией blobCreate() и освобождаемый
+	(с очисткой) функцией blobClose(). Объект только перемещается.
+	После перемещения исходный объект пуст: get() == 0.
+*/
+class state
+{
+	blob_t _blob;
+
+public:
+	state() noexcept : _blob(0) {}
+	explicit state(size_t size) : _blob(blobCreate(size))
+	{
+		if (!_blob)
+			throw std::bad_alloc();
+	}
+	state(const state&) = delete;
+	state& operator=(const state&) = delete;
+	state(state&& other) noexcept : _blob(other._blob) { other._blob = 0; }
+	state& operator=(state&& other) noexcept
+	{
+		if (this != &other)
+		{
+			blobClose(_blob);
+			_blob = other._blob, other._blob = 0;
+		}
+		return *this;
+	}
+	~state() { blobClose(_blob); }
+
+	void* get() noexcept { return _blob; }
+	const void* get() const noexcept { return _blob; }
+	size_t size() const noexcept { return _blob ? blobSize(_blob) : 0; }
+	explicit operator bool() const noexcept { return _blob != 0; }
+};
+
+} // namespace bee2
+
+#endif /* __BEE2_CPP_CORE_HPP */
@@ -4,7 +4,7 @@
 \brief STB 34.101.66 (bake): authenticated key establishment (AKE) protocols
 \project bee2 [cryptographic library]
 \created 2014.04.14
-\version 2023.09.22
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -144,6 +144,43 @@ typedef struct
 	bake_certval_i val;		/*!< функция проверки сертификата */
 } bake_cert;
 
+/*!	\brief Создание кэша сертификатов
+
+	Создается общий для всех потоков кэш count проверенных сертификатов.
+	Кэш используется при проверке своего сертификата (bakeCtxStart(),
+	bakeBMQVStart(), bakeBSTSStart()) и сертификатов другой стороны
+	(bakeBMQVStep3(), bakeBMQVStep4(), bakeBSTSStep4(), bakeBSTSStep5()).
+	В кэше хранятся дайджесты сертификатов вместе с извлеченными из них
+	и проверенными открытыми ключами. Повторно предъявленный сертификат
+	не разбирается, и функция его проверки не вызывается. Сертификат
+	попадает в кэш после успешной проверки и хранится в нем не дольше
+	ttl секунд (ttl == 0 -- без ограничения). При переполнении в первую
+	очередь вытесняются устаревшие сертификаты, затем сертификаты, которые
+	дольше всего не использовались (LRU).
+	\expect{ERR_BAD_INPUT} count > 0.
+	\return ERR_OK, если кэш создан, и код ошибки в противном случае
+	(ERR_ALREADY_EXISTS, если кэш уже создан).
+	\remark Дайджест зависит от функции проверки, долговременных параметров
+	и данных сертификата. Сертификат, проверенный одной функцией,
+	проверяется заново при передаче другой функции.
+	\warning Результат проверки сертификата запоминается на время ttl.
+	Если функция проверки учитывает изменяющиеся обстоятельства (срок
+	действия, списки отзыва), то ttl следует выбирать с учетом того,
+	насколько быстро эти обстоятельства должны приниматься во внимание.
+*/
+err_t bakeCertCacheCreate(
+	size_t count,			/*!< [in] число сертификатов */
+	size_t ttl				/*!< [in] время жизни (в секундах) */
+);
+
+/*!	\brief Закрытие кэша сертификатов
+
+	Закрывается кэш, созданный в bakeCertCacheCreate().
+	\warning Функцию нельзя вызывать одновременно с функциями протоколов
+	в других потоках.
+*/
+void bakeCertCacheClose();
+
 /*
 *******************************************************************************
 Вспомогательные функции
@@ -194,6 +231,59 @@ err_t bakeSWU(
 *******************************************************************************
 \file bake.h
 
+\section bake-ctx Контекст сервера
+
+Сторона, которая выполняет много сеансов протоколов BMQV, BSTS с одним
+и тем же личным ключом и сертификатом, может один раз создать контекст
+(функция bakeCtxStart()) и затем инициализировать сеансы функциями
+bakeBMQVStart2(), bakeBSTSStart2(). В контексте хранятся описание
+эллиптической кривой, личный ключ и проверенный сертификат.
+
+Состояние, инициализированное с контекстом, не содержит описания кривой,
+а ссылается на описание в контексте. Поэтому такое состояние короче
+(см. bakeBMQV2_keep(), bakeBSTS2_keep()), а контекст должен оставаться
+доступным до завершения протокола. Контекст после создания не изменяется
+и может одновременно использоваться в нескольких потоках (с разными
+состояниями). Контекст не может перемещаться в памяти.
+
+Шаги протоколов с облегченными состояниями выполняются теми же функциями
+bakeBMQVStep2(), ..., bakeBSTSStepG().
+*******************************************************************************
+*/
+
+/*!	\brief Длина контекста сервера
+
+	Возвращается длина контекста (в октетах) для уровня стойкости l.
+	\pre l == 128 || l == 192 || l == 256.
+	\return Длина контекста.
+*/
+size_t bakeCtx_keep(
+	size_t l						/*!< [in] уровень стойкости */
+);
+
+/*!	\brief Создание контекста сервера
+
+	По параметрам params, личному ключу [l / 4]privkey и сертификату cert
+	соответствующего открытого ключа в ctx формируется контекст сервера.
+	\pre По адресу ctx зарезервировано bakeCtx_keep(params->l) октетов.
+	\expect{ERR_BAD_PARAMS} Параметры params корректны.
+	\expect{ERR_BAD_CERT} Сертификат cert корректен.
+	\expect Ключ privkey и сертификат cert согласованы.
+	\return ERR_OK, если контекст создан, и код ошибки в противном случае.
+	\remark В контексте сохраняется копия cert, но не данные cert->data.
+	Данные должны оставаться доступными, пока используется контекст.
+*/
+err_t bakeCtxStart(
+	void* ctx,						/*!< [out] контекст */
+	const bign_params* params,		/*!< [in] долговременные параметры */
+	const octet privkey[],			/*!< [in] личный ключ */
+	const bake_cert* cert			/*!< [in] сертификат */
+);
+
+/*!
+*******************************************************************************
+\file bake.h
+
 \section bake-bmqv Протокол BMQV
 *******************************************************************************
 */
@@ -234,6 +324,39 @@ err_t bakeBMQVStart(
 	const bake_cert* cert			/*!< [in] сертификат */
 );
 
+/*!	\brief Длина облегченного состояния функций BMQV
+
+	Возвращается длина состояния (в октетах) функций протокола BMQV,
+	которое инициализируется с контекстом ctx.
+	\pre Контекст ctx создан в bakeCtxStart().
+	\return Длина состояния.
+*/
+size_t bakeBMQV2_keep(
+	const void* ctx					/*!< [in] контекст */
+);
+
+/*!	\brief Инициализация протокола BMQV с контекстом
+
+	Аналог bakeBMQVStart() с долговременными параметрами, личным ключом
+	и сертификатом из контекста ctx. Состояние state ссылается на ctx.
+	\pre По адресу state зарезервировано bakeBMQV2_keep(ctx) октетов.
+	\expect{ERR_BAD_INPUT} Контекст ctx создан в bakeCtxStart().
+	\expect{ERR_BAD_INPUT} Указатель settings->helloa нулевой, либо буфер
+	[settings->helloa_len]settings->helloa корректен. Аналогичное требование
+	касается полей settings->hellob, settings->hellob_len.
+	\expect{ERR_BAD_RNG} Генератор settings->rng (с состоянием
+	settings->rng_state) корректен.
+	\expect Контекст ctx не изменяется и не освобождается до завершения
+	протокола.
+	\return ERR_OK, если инициализация успешно выполнена, и код ошибки
+	в противном случае.
+*/
+err_t bakeBMQVStart2(
+	void* state,					/*!< [out] состояние */
+	const void* ctx,				/*!< [in] контекст */
+	const bake_settings* settings	/*!< [in] настройки */
+);
+
 /*!	\brief Шаг 2 протокола BMQV
 
 	Выполняется шаг 2 протокола BMQV с состоянием state. Сторона B формирует
@@ -247,6 +370,21 @@ err_t bakeBMQVStep2(
 	void* state				/*!< [in,out] состояние */
 );
 
+/*!	\brief Шаг 2 протокола BMQV с пулом одноразовых ключей
+
+	Аналог bakeBMQVStep2(), в котором одноразовый личный ключ стороны B
+	и соответствующая кратная базовой точки берутся из пула eph
+	(см. bignEphStart()).
+	\expect{ERR_BAD_INPUT} Пул eph создан по тем же долговременным
+	параметрам, что и state.
+	\return ERR_OK, если шаг успешно выполнен, и код ошибки в противном случае.
+*/
+err_t bakeBMQVStep2Eph(
+	octet out[],			/*!< [out] выходное сообщение M1 */
+	void* eph,				/*!< [in,out] пул одноразовых ключей */
+	void* state				/*!< [in,out] состояние */
+);
+
 /*!	\brief Шаг 3 протокола BMQV
 
 	Выполняется шаг 3 протокола BMQV с состоянием state. Сторона A 
@@ -402,6 +540,40 @@ err_t bakeBSTSStart(
 	const bake_cert* cert			/*!< [in] сертификат */
 );
 
+/*!	\brief Длина облегченного состояния функций BSTS
+
+	Возвращается длина состояния (в октетах) функций протокола BSTS,
+	которое инициализируется с контекстом ctx.
+	\pre Контекст ctx создан в bakeCtxStart().
+	\return Длина состояния.
+*/
+size_t bakeBSTS2_keep(
+	const void* ctx					/*!< [in] контекст */
+);
+
+/*!	\brief Инициализация протокола BSTS с контекстом
+
+	Аналог bakeBSTSStart() с долговременными параметрами, личным ключом
+	и сертификатом из контекста ctx. Состояние state ссылается на ctx.
+	\pre По адресу state зарезервировано bakeBSTS2_keep(ctx) октетов.
+	\expect{ERR_BAD_INPUT} Контекст ctx создан в bakeCtxStart().
+	\expect{ERR_BAD_INPUT} settings->kca == TRUE && settings->kcb == TRUE.
+	\expect{ERR_BAD_INPUT} Указатель settings->helloa нулевой, либо буфер
+	[settings->helloa_len]settings->helloa корректен. Аналогичное требование
+	касается полей settings->hellob, settings->hellob_len.
+	\expect{ERR_BAD_RNG} Генератор settings->rng (с состоянием
+	settings->rng_state) корректен.
+	\expect Контекст ctx не изменяется и не освобождается до завершения
+	протокола.
+	\return ERR_OK, если инициализация успешно выполнена, и код ошибки
+	в противном случае.
+*/
+err_t bakeBSTSStart2(
+	void* state,					/*!< [out] состояние */
+	const void* ctx,				/*!< [in] контекст */
+	const bake_settings* settings	/*!< [in] настройки */
+);
+
 /*!	\brief Шаг 2 протокола BSTS
 
 	Выполняется шаг 2 протокола BSTS с состоянием state. Сторона B формирует
@@ -415,6 +587,21 @@ err_t bakeBSTSStep2(
 	void* state				/*!< [in,out] состояние */
 );
 
+/*!	\brief Шаг 2 протокола BSTS с пулом одноразовых ключей
+
+	Аналог bakeBSTSStep2(), в котором одноразовый личный ключ стороны B
+	и соответствующая кратная базовой точки берутся из пула eph
+	(см. bignEphStart()).
+	\expect{ERR_BAD_INPUT} Пул eph создан по тем же долговременным
+	параметрам, что и state.
+	\return ERR_OK, если шаг успешно выполнен, и код ошибки в противном случае.
+*/
+err_t bakeBSTSStep2Eph(
+	octet out[],			/*!< [out] выходное сообщение M1 */
+	void* eph,				/*!< [in,out] пул одноразовых ключей */
+	void* state				/*!< [in,out] состояние */
+);
+
 /*!	\brief Шаг 3 протокола BSTS
 
 	Выполняется шаг 3 протокола BSTS с состоянием state. Сторона A 
@@ -567,6 +754,75 @@ err_t bakeBPACEStart(
 	size_t pwd_len					/*!< [in] длина пароля */
 );
 
+/*!	\brief Длина контекста BPACE
+
+	Возвращается длина контекста (в октетах) протокола BPACE для уровня
+	стойкости l.
+	\pre l == 128 || l == 192 || l == 256.
+	\return Длина контекста.
+*/
+size_t bakeBPACECtx_keep(
+	size_t l						/*!< [in] уровень стойкости */
+);
+
+/*!	\brief Создание контекста BPACE
+
+	По параметрам params и паролю [pwd_len]pwd в ctx формируется контекст
+	протокола BPACE. В контексте сохраняются описание эллиптической кривой
+	и ключ, построенный по паролю. Контекст передается в bakeBPACEStart2()
+	и позволяет при повторных сеансах с одним паролем не строить описание
+	кривой и не хэшировать пароль.
+	\pre По адресу ctx зарезервировано bakeBPACECtx_keep(params->l) октетов.
+	\expect{ERR_BAD_PARAMS} Параметры params корректны.
+	\return ERR_OK, если контекст создан, и код ошибки в противном случае.
+	\remark Точка W, которая строится в bakeBPACEStep3(), bakeBPACEStep4()
+	по одноразовым Ra и Rb, в контексте не сохраняется.
+	\remark Контекст содержит ключ, построенный по паролю, и должен быть
+	очищен после использования.
+	\remark Контекст после создания не изменяется и может одновременно
+	использоваться в нескольких потоках. Контекст не может перемещаться
+	в памяти.
+*/
+err_t bakeBPACECtxStart(
+	void* ctx,						/*!< [out] контекст */
+	const bign_params* params,		/*!< [in] долговременные параметры */
+	const octet pwd[],				/*!< [in] пароль */
+	size_t pwd_len					/*!< [in] длина пароля */
+);
+
+/*!	\brief Длина облегченного состояния функций BPACE
+
+	Возвращается длина состояния (в октетах) функций протокола BPACE,
+	которое инициализируется с контекстом ctx.
+	\pre Контекст ctx создан в bakeBPACECtxStart().
+	\return Длина состояния.
+*/
+size_t bakeBPACE2_keep(
+	const void* ctx					/*!< [in] контекст */
+);
+
+/*!	\brief Инициализация протокола BPACE с контекстом
+
+	Аналог bakeBPACEStart() с долговременными параметрами и паролем
+	из контекста ctx. Состояние state ссылается на ctx.
+	\pre По адресу state зарезервировано bakeBPACE2_keep(ctx) октетов.
+	\expect{ERR_BAD_INPUT} Контекст ctx создан в bakeBPACECtxStart().
+	\expect{ERR_BAD_INPUT} Указатель settings->helloa нулевой, либо буфер
+	[settings->helloa_len]settings->helloa корректен. Аналогичное требование
+	касается полей settings->hellob, settings->hellob_len.
+	\expect{ERR_BAD_RNG} Генератор settings->rng (с состоянием
+	settings->rng_state) корректен.
+	\expect Контекст ctx не изменяется и не освобождается до завершения
+	протокола.
+	\return ERR_OK, если инициализация успешно выполнена, и код ошибки
+	в противном случае.
+*/
+err_t bakeBPACEStart2(
+	void* state,					/*!< [out] состояние */
+	const void* ctx,				/*!< [in] контекст */
+	const bake_settings* settings	/*!< [in] настройки */
+);
+
 /*!	\brief Шаг 2 протокола BPACE
 
 	Выполняется шаг 2 протокола BPACE с состоянием state. Сторона B формирует
@@ -696,6 +952,143 @@ err_t bakeBPACERunA(
 	void* file						/*!< [in,out] канал связи */
 );
 
+/*!
+*******************************************************************************
+\file bake.h
+
+\section bake-drv Драйвер протоколов
+
+Функции bakeBMQVRunA(), ..., bakeBPACERunB() используют блокирующие
+функции чтения и записи и занимают поток на все время выполнения
+протокола. Драйвер позволяет выполнять протокол по мере поступления
+сообщений: сообщение другой стороны передается в bakeDrvStep(),
+которая выполняет очередной шаг и возвращает сообщение для отправки.
+Тем самым в одном потоке можно обслуживать много сеансов, например,
+в цикле обработки событий.
+
+Драйвер работает с состоянием протокола, которое предварительно
+инициализировано функцией bakeBMQVStart(), bakeBSTSStart(),
+bakeBPACEStart() или их версиями с контекстом. Шаги выполняются теми же
+функциями bakeBMQVStep2(), ..., bakeBPACEStep6().
+
+Сторона B начинает протокол: при первом обращении к bakeDrvStep()
+входное сообщение не передается (in_len == 0). Длина очередного ожидаемого
+сообщения возвращается функцией bakeDrvInLen(). В протоколе BSTS
+сообщения M2 и M3 содержат сертификаты и имеют переменную длину. Их границы
+должен определять канал связи.
+
+Драйвер и состояние не являются потокобезопасными: с одним драйвером
+в каждый момент времени должен работать один поток.
+*******************************************************************************
+*/
+
+#define BAKE_DRV_BMQV_A		1	/*!< BMQV, сторона A */
+#define BAKE_DRV_BMQV_B		2	/*!< BMQV, сторона B */
+#define BAKE_DRV_BSTS_A		3	/*!< BSTS, сторона A */
+#define BAKE_DRV_BSTS_B		4	/*!< BSTS, сторона B */
+#define BAKE_DRV_BPACE_A	5	/*!< BPACE, сторона A */
+#define BAKE_DRV_BPACE_B	6	/*!< BPACE, сторона B */
+
+/*!	\brief Длина состояния драйвера
+
+	Возвращается длина состояния (в октетах) драйвера протоколов.
+	\return Длина состояния.
+*/
+size_t bakeDrv_keep();
+
+/*!	\brief Инициализация драйвера
+
+	В drv формируется драйвер протокола proto, который будет выполняться
+	с состоянием state.
+	\pre По адресу drv зарезервировано bakeDrv_keep() октетов.
+	\expect{ERR_BAD_INPUT} proto -- одна из констант BAKE_DRV_XXX.
+	\expect{ERR_BAD_INPUT} Состояние state инициализировано функцией Start
+	протокола proto.
+	\expect{ERR_BAD_INPUT} В протоколе BMQV передан сертификат cert другой
+	стороны (certb для A, certa для B).
+	\expect{ERR_BAD_INPUT} В протоколе BSTS передана функция val проверки
+	сертификата другой стороны.
+	\return ERR_OK, если драйвер инициализирован, и код ошибки в противном
+	случае.
+	\remark Параметр cert используется только в BMQV, параметр val --
+	только в BSTS. Неиспользуемые параметры могут быть нулевыми.
+	\remark Драйвер ссылается на state и cert. Они должны оставаться
+	доступными до завершения протокола.
+*/
+err_t bakeDrvStart(
+	void* drv,						/*!< [out] драйвер */
+	size_t proto,					/*!< [in] протокол и сторона */
+	void* state,					/*!< [in,out] состояние протокола */
+	const bake_cert* cert,			/*!< [in] сертификат другой стороны */
+	bake_certval_i val				/*!< [in] проверка сертификата */
+);
+
+/*!	\brief Длина ожидаемого сообщения
+
+	Определяется длина сообщения, которое должно быть передано в очередном
+	вызове bakeDrvStep().
+	\return Длина сообщения в октетах, 0, если сообщение не ожидается
+	(первый шаг стороны B или протокол завершен), или SIZE_MAX, если
+	длина сообщения заранее не известна.
+*/
+size_t bakeDrvInLen(
+	const void* drv					/*!< [in] драйвер */
+);
+
+/*!	\brief Длина выходного сообщения
+
+	Определяется длина сообщения, которое будет сформировано в очередном
+	вызове bakeDrvStep().
+	\return Длина сообщения в октетах (0, если сообщение не формируется).
+*/
+size_t bakeDrvOutLen(
+	const void* drv					/*!< [in] драйвер */
+);
+
+/*!	\brief Очередной шаг протокола
+
+	Обрабатывается сообщение [in_len]in другой стороны и выполняется
+	очередной шаг протокола. Сообщение для отправки записывается в буфер
+	out, его длина -- по адресу out_len. Если *out_len == 0, то отправлять
+	нечего.
+	\pre Буфер out вмещает bakeDrvOutLen(drv) октетов.
+	\expect{ERR_BAD_LOGIC} Протокол не завершен.
+	\expect{ERR_BAD_INPUT} in_len == bakeDrvInLen(drv), если длина
+	ожидаемого сообщения известна.
+	\return ERR_OK, если шаг успешно выполнен, и код ошибки в противном
+	случае.
+	\remark При ошибке выполнения шага драйвер не меняет номер шага.
+	Продолжать протокол после ошибки не следует.
+*/
+err_t bakeDrvStep(
+	octet out[],					/*!< [out] выходное сообщение */
+	size_t* out_len,				/*!< [out] длина выходного сообщения */
+	const octet in[],				/*!< [in] входное сообщение */
+	size_t in_len,					/*!< [in] длина входного сообщения */
+	void* drv						/*!< [in,out] драйвер */
+);
+
+/*!	\brief Протокол завершен?
+
+	Проверяется, что все шаги протокола выполнены.
+	\return Признак завершения.
+*/
+bool_t bakeDrvIsOver(
+	const void* drv					/*!< [in] драйвер */
+);
+
+/*!	\brief Извлечение ключа
+
+	Определяется общий секретный ключ key, полученный в протоколе.
+	\expect{ERR_BAD_LOGIC} bakeDrvIsOver(drv).
+	\return ERR_OK, если ключ успешно извлечен, и код ошибки в противном
+	случае.
+*/
+err_t bakeDrvStepG(
+	octet key[32],					/*!< [out] общий ключ */
+	void* drv						/*!< [in,out] драйвер */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief STB 34.101.77 (bash): sponge-based algorithms
 \project bee2 [cryptographic library]
 \created 2014.07.15
-\version 2023.02.02
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -47,8 +47,15 @@ sponge-функции bash-f, реализованной в bashF(). Sponge-фу
 - Intel AVX2 (BASH_AVX2),
 - Intel AVX512 (BASH_AVX512),
 - ARM NEON (BASH_NEON).
-По умолчанию используется реализация для платформы BASH_64 либо, если
-64-разрядные регистры не поддерживаются, BASH_32.
+Кроме этого, можно запросить выбор реализации во время выполнения (BASH_AUTO).
+В этом случае в библиотеку включаются реализации для платформ BASH_64, 
+BASH_SSE2, BASH_AVX2, BASH_AVX512 и при первом обращении к bashF() выбирается 
+наиболее быстрая из реализаций, поддерживаемых процессором. Режим BASH_AUTO
+доступен при сборке компиляторами GCC и Clang для платформы x86_64 и 
+используется для нее по умолчанию. На других платформах по умолчанию 
+используется реализация для платформы BASH_64 либо, если 64-разрядные 
+регистры не поддерживаются, BASH_32. Выбранная реализация возвращается 
+функцией bashPlatform().
 
 Глубина стека bashF() определяется с помощью функции bashF_deep().
 
@@ -136,6 +143,39 @@ void bashF(
 	void* stack			/*!< [in,out] стек */
 );
 
+/*!	\brief Глубина стека sponge-функции над несколькими состояниями
+
+	Возвращается глубина стека (в октетах) функции bashFN().
+	\return Глубина стека.
+*/
+size_t bashFN_deep();
+
+/*!	\brief Sponge-функция над несколькими состояниями
+
+	Каждый из count буферов [192]block[192 * i], размещенных в памяти 
+	последовательно, преобразуется с помощью sponge-функции bash-f.
+	\pre Буфер [192 * count]block корректен.
+	\remark На платформах BASH_AVX2 и BASH_AVX512 одновременно преобразуются
+	соответственно 4 и 8 состояний, размещенных в соседних 64-разрядных 
+	полях расширенных регистров.
+*/
+void bashFN(
+	octet block[],		/*!< [in,out] прообразы/образы */
+	size_t count,		/*!< [in] число буферов */
+	void* stack			/*!< [in,out] стек */
+);
+
+/*!	\brief Платформа sponge-функции
+
+	Возвращается имя платформы (BASH_32, BASH_64, BASH_SSE2, BASH_AVX2, 
+	BASH_AVX512, BASH_NEON), для которой оптимизирована используемая 
+	реализация bashF().
+	\return Имя платформы.
+	\remark В режиме BASH_AUTO платформа определяется при первом вызове 
+	bashPlatform() или bashF().
+*/
+const char* bashPlatform();
+
 /*
 *******************************************************************************
 Алгоритмы хэширования (bashHash)
@@ -149,6 +189,16 @@ void bashF(
 */
 size_t bashHash_keep();
 
+/*!	\brief Длина выровненного состояния функций хэширования
+
+	Возвращается длина состояния алгоритмов хэширования bash, округленная
+	вверх до кратного STACK_ALIGN (см. \ref stack-align). Состояния,
+	размещенные в массиве с шагом bashHash_keep_aligned(), выровнены
+	и не делят строки кэша.
+	\return Длина выровненного состояния.
+*/
+size_t bashHash_keep_aligned();
+
 /*!	\brief Инициализация хэширования
 
 	В state формируются структуры данных, необходимые для хэширования 
@@ -173,6 +223,23 @@ void bashHashStepH(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Хэширование фрагментов данных
+
+	Текущее хэш-значение, размещенное в state, пересчитывается по алгоритму
+	bash с учетом фрагментов данных
+	[count[0]]buf[0],..., [count[n - 1]]buf[n - 1].
+	Фрагменты обрабатываются так, как если бы они были записаны подряд
+	в один буфер.
+	\expect bashHashStart() < bashHashStepHV()*.
+	\remark Вызовы bashHashStepH() и bashHashStepHV() можно чередовать.
+*/
+void bashHashStepHV(
+	const void* const buf[],	/*!< [in] фрагменты данных */
+	const size_t count[],		/*!< [in] длины фрагментов */
+	size_t n,					/*!< [in] число фрагментов */
+	void* state					/*!< [in,out] состояние */
+);
+
 /*!	\brief Определение хэш-значения
 
 	Определяются первые октеты [hash_len]hash окончательного хэш-значения 
@@ -205,6 +272,41 @@ bool_t bashHashStepV(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Длина экспорта состояния хэширования */
+#define BASH_HASH_EXPORT_LEN 196
+
+/*!	\brief Экспорт состояния хэширования
+
+	Состояние хэширования state записывается в буфер
+	[BASH_HASH_EXPORT_LEN]buf в переносимом формате:
+	- октет 0x77 (идентификатор bash-hash);
+	- октет 0x01 (версия формата);
+	- октет l / 16, где l -- уровень стойкости;
+	- число накопленных октетов неполного блока;
+	- 192 октета состояния (незаполненная часть буфера обнуляется).
+	\expect bashHashStart() < bashHashExport().
+	\remark Экспорт не зависит от платформы и не меняет состояние.
+*/
+void bashHashExport(
+	octet buf[],			/*!< [out] экспорт */
+	const void* state		/*!< [in] состояние */
+);
+
+/*!	\brief Импорт состояния хэширования
+
+	По экспорту [BASH_HASH_EXPORT_LEN]buf восстанавливается состояние
+	хэширования state. После импорта хэширование можно продолжить
+	функциями bashHashStepH(), bashHashStepG(), bashHashStepV().
+	\pre По адресу state зарезервировано bashHash_keep() октетов.
+	\return ERR_OK, если состояние восстановлено, ERR_BAD_FORMAT, если
+	buf не является корректным экспортом, и код ошибки в противном случае.
+	\expect bashHashExport() < bashHashImport().
+*/
+err_t bashHashImport(
+	void* state,			/*!< [out] состояние */
+	const octet buf[]		/*!< [in] экспорт */
+);
+
 /*!	\brief Хэширование
 
 	С помощью алгоритма bash уровня стойкости l определяется хэш-значение 
@@ -214,6 +316,7 @@ bool_t bashHashStepV(
 	\return ERR_OK, если хэширование завершено успешно, и код ошибки
 	в противном случае.
 	\remark Буферы могут пересекаться.
+	\remark Состояние размещается в памяти потока (см. stackCreate()).
 */
 err_t bashHash(
 	octet hash[],		/*!< [out] хэш-значение */
@@ -222,6 +325,27 @@ err_t bashHash(
 	size_t count		/*!< [in] число октетов данных */
 );
 
+/*!	\brief Хэширование нескольких сообщений
+
+	С помощью алгоритма bash уровня стойкости l определяются хэш-значения 
+	[l / 4]hash[l / 4 * i] буферов [count[i]]src[i], i = 0, 1,..., n - 1.
+	\expect{ERR_BAD_PARAM} l > 0 && l % 16 == 0 && l <= 256.
+	\expect{ERR_BAD_INPUT} Буферы hash, src, count, src[i] корректны.
+	\return ERR_OK, если хэширование завершено успешно, и код ошибки
+	в противном случае.
+	\remark Сообщения обрабатываются одновременно на 8 дорожках. Состояния
+	дорожек преобразуются с помощью bashFN(). Освободившаяся дорожка сразу
+	получает следующее сообщение.
+	\remark Буфер hash не должен пересекаться с буферами src[i].
+*/
+err_t bashHashMB(
+	octet hash[],				/*!< [out] хэш-значения */
+	size_t l,					/*!< [in] уровень стойкости */
+	const void* const src[],	/*!< [in] сообщения */
+	const size_t count[],		/*!< [in] длины сообщений */
+	size_t n					/*!< [in] число сообщений */
+);
+
 /*
 *******************************************************************************
 bash256
@@ -287,6 +411,14 @@ bashHash512
 */
 size_t bashPrg_keep();
 
+/*!	\brief Длина выровненного состояния автомата
+
+	Возвращается длина состояния программируемого автомата, округленная
+	вверх до кратного STACK_ALIGN (см. \ref stack-align).
+	\return Длина выровненного состояния.
+*/
+size_t bashPrg_keep_aligned();
+
 /*!	\brief Инициализация автомата
 
 	По уровню стойкости l, емкости d, анонсу [ann_len]ann и ключу
@@ -415,6 +547,22 @@ void bashPrgEncrStep(
 	void* state			/*!< [inout] автомат */
 );
 
+/*!	\brief Шаг зашифрования с выводом в отдельный буфер
+
+	Выполняется зашифрование с помощью автомата state фрагмента [count]src.
+	Результат зашифрования размещается в [count]dest.
+	\expect bashPrgEncrStart() < bashPrgEncrStep2()*.
+	\pre Буферы src и dest либо не пересекаются, либо совпадают.
+	\remark Вызов bashPrgEncrStep(buf, count, state) эквивалентен вызову
+	bashPrgEncrStep2(buf, buf, count, state).
+*/
+void bashPrgEncrStep2(
+	void* dest,			/*!< [out] зашифрованные данные */
+	const void* src,	/*!< [in] открытые данные */
+	size_t count,		/*!< [in] число октетов данных */
+	void* state			/*!< [in,out] автомат */
+);
+
 /*!	\brief Зашифрование
 
 	С помощью автомата state зашифровываются данные [count]buf.
@@ -427,6 +575,21 @@ void bashPrgEncr(
 	void* state			/*!< [in,out] автомат */
 );
 
+/*!	\brief Зашифрование с выводом в отдельный буфер
+
+	С помощью автомата state зашифровываются данные [count]src. Результат
+	зашифрования размещается в [count]dest.
+	\pre Автомат находится в ключевом режиме.
+	\pre Буферы src и dest либо не пересекаются, либо совпадают.
+	\expect bashPrgStart() < bashPrgEncr2()*.
+*/
+void bashPrgEncr2(
+	void* dest,			/*!< [out] зашифрованные данные */
+	const void* src,	/*!< [in] открытые данные */
+	size_t count,		/*!< [in] число октетов данных */
+	void* state			/*!< [in,out] автомат */
+);
+
 /*!	\brief Начало расшифрования
 
 	Инициализируется расшифрование данных с помощью автомата state.
@@ -449,6 +612,22 @@ void bashPrgDecrStep(
 	void* state			/*!< [in,out] автомат */
 );
 
+/*!	\brief Шаг расшифрования с выводом в отдельный буфер
+
+	Выполняется расшифрование с помощью автомата state фрагмента [count]src.
+	Результат расшифрования размещается в [count]dest.
+	\expect bashPrgDecrStart() < bashPrgDecrStep2()*.
+	\pre Буферы src и dest либо не пересекаются, либо совпадают.
+	\remark Вызов bashPrgDecrStep(buf, count, state) эквивалентен вызову
+	bashPrgDecrStep2(buf, buf, count, state).
+*/
+void bashPrgDecrStep2(
+	void* dest,			/*!< [out] открытые данные */
+	const void* src,	/*!< [in] зашифрованные данные */
+	size_t count,		/*!< [in] число октетов данных */
+	void* state			/*!< [in,out] автомат */
+);
+
 /*!	\brief Расшифрование
 
 	С помощью автомата state расшифровываются данные [count]buf. 
@@ -461,6 +640,21 @@ void bashPrgDecr(
 	void* state			/*!< [in,out] автомат */
 );
 
+/*!	\brief Расшифрование с выводом в отдельный буфер
+
+	С помощью автомата state расшифровываются данные [count]src. Результат
+	расшифрования размещается в [count]dest.
+	\pre Автомат находится в ключевом режиме.
+	\pre Буферы src и dest либо не пересекаются, либо совпадают.
+	\expect bashPrgStart() < bashPrgDecr2()*.
+*/
+void bashPrgDecr2(
+	void* dest,			/*!< [out] открытые данные */
+	const void* src,	/*!< [in] зашифрованные данные */
+	size_t count,		/*!< [in] число октетов данных */
+	void* state			/*!< [in,out] автомат */
+);
+
 /*!	\brief Необратимое изменение автомата
 
 	Автомат state меняется так, что по новому состоянию трудно определить
@@ -471,6 +665,181 @@ void bashPrgRatchet(
 	void* state			/*!< [in,out] автомат */
 );
 
+/*!	\brief Длина снимка автомата
+
+	Возвращается длина снимка (в октетах) автомата программируемых
+	алгоритмов.
+	\return Длина снимка.
+*/
+size_t bashPrgSnapshot_keep();
+
+/*!	\brief Снимок автомата
+
+	В snapshot сохраняется текущее состояние автомата state.
+	\pre По адресу snapshot зарезервировано bashPrgSnapshot_keep() октетов.
+	\expect bashPrgStart() < bashPrgSnapshot().
+	\remark Снимок позволяет один раз выполнить bashPrgStart() с ключом
+	и анонсом, а затем для каждого сообщения восстанавливать автомат
+	функцией bashPrgRestore(). Если снимок сделан после bashPrgAbsorbStart(),
+	то в нем учтено и начальное применение sponge-функции.
+	\warning Снимок автомата в ключевом режиме содержит ключевой материал
+	и должен защищаться так же, как ключ.
+*/
+void bashPrgSnapshot(
+	void* snapshot,		/*!< [out] снимок */
+	const void* state	/*!< [in] автомат */
+);
+
+/*!	\brief Восстановление автомата по снимку
+
+	Автомат state восстанавливается по снимку snapshot. После восстановления
+	автомат находится в том же состоянии, что и в момент снимка.
+	\pre По адресу state зарезервировано bashPrg_keep() октетов.
+	\expect bashPrgSnapshot() < bashPrgRestore()*.
+*/
+void bashPrgRestore(
+	void* state,			/*!< [out] автомат */
+	const void* snapshot	/*!< [in] снимок */
+);
+
+/*!	\brief Длина экспорта автомата */
+#define BASH_PRG_EXPORT_LEN 198
+
+/*!	\brief Экспорт автомата
+
+	Автомат state записывается в буфер [BASH_PRG_EXPORT_LEN]buf
+	в переносимом формате:
+	- октет 0x78 (идентификатор bash-prg);
+	- октет 0x01 (версия формата);
+	- октеты l / 16, d, где l -- уровень стойкости, d -- емкость;
+	- признак ключевого режима (0 или 1);
+	- позиция в буфере;
+	- 192 октета состояния.
+	\expect bashPrgStart() < bashPrgExport().
+	\remark В отличие от снимка bashPrgSnapshot(), экспорт не зависит
+	от платформы: его можно импортировать на платформе с другим порядком
+	октетов или другой разрядностью.
+	\warning Экспорт автомата в ключевом режиме содержит ключевой материал
+	и должен защищаться так же, как ключ.
+*/
+void bashPrgExport(
+	octet buf[],			/*!< [out] экспорт */
+	const void* state		/*!< [in] автомат */
+);
+
+/*!	\brief Импорт автомата
+
+	По экспорту [BASH_PRG_EXPORT_LEN]buf восстанавливается автомат state.
+	\pre По адресу state зарезервировано bashPrg_keep() октетов.
+	\return ERR_OK, если автомат восстановлен, ERR_BAD_FORMAT, если
+	buf не является корректным экспортом, и код ошибки в противном случае.
+	\expect bashPrgExport() < bashPrgImport().
+*/
+err_t bashPrgImport(
+	void* state,			/*!< [out] автомат */
+	const octet buf[]		/*!< [in] экспорт */
+);
+
+/*
+*******************************************************************************
+Древовидное хэширование (bash-prg-tree)
+
+Сообщение разбивается на листья длины BASH_PRG_TREE_LEAF октетов (последний
+лист может быть неполным). Каждый лист хэшируется программируемым автоматом
+с анонсом "LEAF" || <номер_листа>_64. Хэш-значения листьев длины l / 4
+октетов вместе с числом листьев (<n>_64) загружаются в корневой автомат
+с анонсом "ROOT", из которого выгружается итоговое хэш-значение.
+
+Листья обрабатываются независимо и могут хэшироваться в нескольких потоках.
+Результат не зависит от числа потоков и от разбиения сообщения на фрагменты
+при обработке.
+
+\warning Хэш-значения bash-prg-tree отличаются от хэш-значений
+bash-prg-hash с теми же параметрами.
+*******************************************************************************
+*/
+
+/*!	\brief Длина листа */
+#define BASH_PRG_TREE_LEAF ((size_t)1 << 20)
+
+/*!	\brief Длина состояния древовидного хэширования
+
+	Возвращается длина состояния (в октетах) алгоритма древовидного
+	хэширования, рассчитанного на threads потоков.
+	\return Длина состояния.
+	\remark Значение threads == 0 интерпретируется как threads == 1.
+*/
+size_t bashPrgTree_keep(
+	size_t threads		/*!< [in] число потоков */
+);
+
+/*!	\brief Инициализация древовидного хэширования
+
+	В state формируются структуры данных, необходимые для древовидного
+	хэширования с уровнем стойкости l и емкостью d в threads потоках.
+	\pre l == 128 || l == 192 || l == 256.
+	\pre d == 1 || d == 2.
+	\pre По адресу state зарезервировано bashPrgTree_keep(threads) октетов.
+	\remark Значение threads == 0 интерпретируется как threads == 1.
+*/
+void bashPrgTreeStart(
+	void* state,		/*!< [out] состояние */
+	size_t l,			/*!< [in] уровень стойкости */
+	size_t d,			/*!< [in] емкость */
+	size_t threads		/*!< [in] число потоков */
+);
+
+/*!	\brief Древовидное хэширование фрагмента данных
+
+	Текущее хэш-значение, размещенное в state, пересчитывается по алгоритму
+	bash-prg-tree с учетом нового фрагмента данных [count]buf.
+	\expect bashPrgTreeStart() < bashPrgTreeStepH()*.
+	\remark Полные листья, поступившие на границе листа, распределяются между
+	потоками. Для эффективного распараллеливания фрагменты должны
+	начинаться на границе листа и содержать threads * BASH_PRG_TREE_LEAF
+	октетов.
+*/
+void bashPrgTreeStepH(
+	const void* buf,	/*!< [in] данные */
+	size_t count,		/*!< [in] число октетов данных */
+	void* state			/*!< [in,out] состояние */
+);
+
+/*!	\brief Определение древовидного хэш-значения
+
+	Первые hash_len октетов хэш-значения, определенного по алгоритму
+	bash-prg-tree, возвращаются в hash.
+	\pre hash_len <= l / 4, где l --- уровень стойкости,
+	заданный в bashPrgTreeStart().
+	\expect bashPrgTreeStepH()* < bashPrgTreeStepG().
+	\remark После вызова функции состояние state становится некорректным.
+*/
+void bashPrgTreeStepG(
+	octet hash[],		/*!< [out] хэш-значение */
+	size_t hash_len,	/*!< [in] длина hash */
+	void* state			/*!< [in,out] состояние */
+);
+
+/*!	\brief Древовидное хэширование
+
+	С помощью алгоритма bash-prg-tree с уровнем стойкости l и емкостью d
+	определяется хэш-значение [l / 4]hash буфера памяти [count]src.
+	Листья хэшируются в threads потоках.
+	\expect{ERR_BAD_PARAMS} l == 128 || l == 192 || l == 256.
+	\expect{ERR_BAD_PARAMS} d == 1 || d == 2.
+	\expect{ERR_BAD_INPUT} Буферы hash, src корректны.
+	\return ERR_OK, если хэширование завершено успешно, и код ошибки
+	в противном случае.
+*/
+err_t bashPrgTreeHash(
+	octet hash[],		/*!< [out] хэш-значение */
+	size_t l,			/*!< [in] уровень стойкости */
+	size_t d,			/*!< [in] емкость */
+	const void* src,	/*!< [in] данные */
+	size_t count,		/*!< [in] число октетов данных */
+	size_t threads		/*!< [in] число потоков */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
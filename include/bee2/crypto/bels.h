@@ -4,7 +4,7 @@
 \brief STB 34.101.60 (bels): secret sharing algorithms
 \project bee2 [cryptographic library]
 \created 2013.05.14
-\version 2023.02.02
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 #include "bee2/defs.h"
+#include "bee2/core/mt.h"
 
 /*!
 *******************************************************************************
@@ -176,6 +177,53 @@ err_t belsGenMid(
 	size_t id_len			/*!< [in] длина идентификаторa в октетах */
 );
 
+/*!	\brief Пакетная генерация открытых ключей пользователей
+
+	По общему открытому ключу [len]m0 и затравке [seed_len]seed
+	генерируются открытые ключи count пользователей, которые записываются
+	в массив [count * len]mi последовательными блоками из len октетов.
+	Ключ пользователя номер i (i = 0, 1,..., count - 1) генерируется
+	функцией belsGenMid() по идентификатору seed || <i>_32.
+	\expect{ERR_BAD_INPUT} len == 16 || len == 24 || len == 32.
+	\expect{ERR_BAD_PUBKEY} Ключ m0 корректен.
+	\return ERR_OK, если ключи успешно сгенерированы и отличаются друг
+	от друга, и код ошибки в противном случае.
+	\remark Ключи зависят только от m0, seed и номеров пользователей,
+	а не от числа потоков и порядка выполнения задач.
+	\remark Ключи генерируются в задачах пула потоков pool (по одной
+	задаче на пользователя). Если pool == 0, то ключи генерируются
+	в вызывающем потоке.
+	\pre Функция не вызывается из задач пула pool.
+*/
+err_t belsGenMiBatch(
+	octet mi[],				/*!< [out] открытые ключи пользователей */
+	size_t count,			/*!< [in] число пользователей */
+	size_t len,				/*!< [in] длина ключей в октетах */
+	const octet m0[],		/*!< [in] общий открытый ключ */
+	const octet seed[],		/*!< [in] затравка */
+	size_t seed_len,		/*!< [in] длина затравки в октетах */
+	mt_pool_t* pool			/*!< [in,out] пул потоков */
+);
+
+/*!	\brief Пакетная проверка открытых ключей
+
+	Проверяется корректность (см. belsValM()) открытых ключей из массива
+	[count * len]m.
+	\expect{ERR_BAD_INPUT} len == 16 || len == 24 || len == 32.
+	\return ERR_OK, если все ключи корректны, и код ошибки для первого
+	некорректного ключа в противном случае.
+	\remark Ключи проверяются в задачах пула потоков pool (по одной
+	задаче на ключ). Если pool == 0, то ключи проверяются в вызывающем
+	потоке.
+	\pre Функция не вызывается из задач пула pool.
+*/
+err_t belsValMBatch(
+	const octet m[],		/*!< [in] открытые ключи */
+	size_t count,			/*!< [in] число ключей */
+	size_t len,				/*!< [in] длина ключей в октетах */
+	mt_pool_t* pool			/*!< [in,out] пул потоков */
+);
+
 /*
 *******************************************************************************
 Разделение и восстановление секрета
@@ -274,6 +322,92 @@ err_t belsShare3(
 	const octet s[]			/*!< [in] секрет */
 );
 
+/*!	\brief Пакетное разделение секретов
+
+	Каждый из секретов [num * len]s разделяется с порогом threshold
+	на count частичных секретов так же, как в belsShare(). Используются
+	общий открытый ключ [len]m0 и открытые ключи пользователей из массива
+	[count * len]mi. Частичные секреты записываются в массив
+	[num * count * len]si: сначала count частичных секретов первого
+	секрета, затем второго и т.д.
+	\expect{ERR_BAD_INPUT}
+	-	len == 16 || len == 24 || len == 32;
+	-	0 < threshold <= count.
+	.
+	\expect{ERR_BAD_PUBKEY} Открытые ключи m0, mi корректны и отличаются
+	друг от друга.
+	\expect{ERR_BAD_RNG} Генератор rng (с состоянием rng_state) корректен.
+	\expect Генератор rng является криптографически стойким.
+	\return ERR_OK, если секреты успешно разделены, и код ошибки
+	в противном случае.
+	\remark Реализован алгоритм bels-share. Генератор rng вызывается для
+	секретов последовательно, в том же порядке, что и при num вызовах
+	belsShare().
+	\remark Частичные секреты пользователей вычисляются в задачах пула
+	потоков pool (по одной задаче на пользователя). Если pool == 0, то
+	вычисления выполняются в вызывающем потоке.
+	\pre Функция не вызывается из задач пула pool.
+*/
+err_t belsShareBatch(
+	octet si[],				/*!< [out] частичные секреты */
+	size_t num,				/*!< [in] число секретов */
+	size_t count,			/*!< [in] число пользователей */
+	size_t threshold,		/*!< [in] пороговое число */
+	size_t len,				/*!< [in] длина секрета в октетах */
+	const octet s[],		/*!< [in] секреты */
+	const octet m0[],		/*!< [in] общий открытый ключ */
+	const octet mi[],		/*!< [in] открытые ключи пользователей */
+	gen_i rng,				/*!< [in] генератор случайных чисел */
+	void* rng_state,		/*!< [in,out] состояние генератора */
+	mt_pool_t* pool			/*!< [in,out] пул потоков */
+);
+
+/*!	\brief Длина состояния функций восстановления
+
+	Возвращается длина состояния (в октетах) функций восстановления секрета
+	длины len по count частичным секретам.
+	\return Длина состояния.
+*/
+size_t belsRecover_keep(
+	size_t count,			/*!< [in] число пользователей */
+	size_t len				/*!< [in] длина секрета в октетах */
+);
+
+/*!	\brief Инициализация восстановления
+
+	По общему открытому ключу [len]m0 и открытым ключам пользователей из
+	массива [count * len]mi в state выполняются предвычисления, не
+	зависящие от частичных секретов.
+	\expect{ERR_BAD_INPUT} len == 16 || len == 24 || len == 32.
+	\expect{ERR_BAD_PUBKEY} Открытые ключи mi отличаются друг от друга.
+	\return ERR_OK, если предвычисления выполнены, и код ошибки в противном
+	случае.
+	\pre По адресу state зарезервировано belsRecover_keep(count, len)
+	октетов.
+	\remark Состояние можно использовать для восстановления многих секретов,
+	разделенных между одними и теми же пользователями.
+*/
+err_t belsRecoverStart(
+	void* state,			/*!< [out] состояние */
+	size_t count,			/*!< [in] число пользователей */
+	size_t len,				/*!< [in] длина секрета в октетах */
+	const octet m0[],		/*!< [in] общий открытый ключ */
+	const octet mi[]		/*!< [in] открытые ключи пользователей */
+);
+
+/*!	\brief Восстановление секрета по предвычислениям
+
+	Секрет [len]s восстанавливается по частичным секретам из массива
+	[count * len]si. Частичные секреты следуют в том же порядке, что и
+	открытые ключи, переданные в belsRecoverStart().
+	\pre Состояние state подготовлено вызовом belsRecoverStart().
+*/
+void belsRecoverStepR(
+	octet s[],				/*!< [out] восстановленный секрет */
+	const octet si[],		/*!< [in] частичные секреты */
+	void* state				/*!< [in,out] состояние */
+);
+
 /*!	\brief Восстановление секрета
 
 	Секрет [len]s восстанавливается по count частичным секретам из массива 
@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): data encryption and integrity algorithms
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2023.02.02
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 #include "bee2/defs.h"
+#include "bee2/core/mt.h"
 
 /*!
 *******************************************************************************
@@ -177,6 +178,33 @@ void beltKeyExpand2(
 	size_t len			/*!< [in] длина ключа в октетах */
 );
 
+/*!	\brief Длина подготовленного ключа
+
+	Возвращается длина (в октетах) подготовленного ключа.
+	\return Длина подготовленного ключа.
+*/
+size_t beltKey_keep();
+
+/*!	\brief Подготовка ключа
+
+	По ключу [len]key в skey формируется подготовленный ключ:
+	расширенный форматированный ключ и зависящие только от ключа
+	значения режимов (например, переменная r режима MAC). Подготовленный
+	ключ передается функциям beltXXXStartK(), которые не выполняют
+	расширение ключа повторно.
+	\pre len == 16 || len == 24 || len == 32.
+	\pre По адресу skey зарезервировано beltKey_keep() октетов.
+	\remark Подготовленный ключ не меняется функциями beltXXXStartK()
+	и может одновременно использоваться в нескольких потоках.
+	\warning Подготовленный ключ содержит ключевой материал и должен
+	защищаться так же, как ключ.
+*/
+void beltKeyStart(
+	void* skey,			/*!< [out] подготовленный ключ */
+	const octet key[],	/*!< [in] ключ */
+	size_t len			/*!< [in] длина ключа в октетах */
+);
+
 
 /*
 *******************************************************************************
@@ -219,6 +247,24 @@ void beltBlockEncr3(
 	const u32 key[8]	/*!< [in] ключ */
 );
 
+/*!	\brief Зашифрование нескольких форматированных блоков
+
+	Выполняется зашифрование count форматированных блоков данных, 
+	записанных последовательно по адресу blocks, на форматированном 
+	ключе key. Результаты зашифрования возвращаются по адресу blocks.
+	\remark Реализация выбирается во время выполнения (см.
+	beltBlockPlatform()). В табличной реализации блоки обрабатываются
+	четверками с чередованием вычислений. Это быстрее, чем последовательные
+	вызовы beltBlockEncr2(). В векторных реализациях одновременно
+	обрабатываются 8 или 16 блоков, а время зашифрования не зависит
+	от данных.
+*/
+void beltBlockEncrN(
+	u32 blocks[],			/*!< [in,out] блоки */
+	size_t count,			/*!< [in] число блоков */
+	const u32 key[8]		/*!< [in] ключ */
+);
+
 /*!	\brief Расшифрование блока
 
 	Выполняется расшифрование блока данных block на форматированном ключе key.
@@ -254,6 +300,39 @@ void beltBlockDecr3(
 	const u32 key[8]	/*!< [in] ключ */
 );
 
+/*!	\brief Расшифрование нескольких форматированных блоков
+
+	Выполняется расшифрование count форматированных блоков данных, 
+	записанных последовательно по адресу blocks, на форматированном 
+	ключе key. Результаты расшифрования возвращаются по адресу blocks.
+	\remark Реализация выбирается во время выполнения (см.
+	beltBlockPlatform()). В табличной реализации блоки обрабатываются
+	четверками с чередованием вычислений. Это быстрее, чем последовательные
+	вызовы beltBlockDecr2(). В векторных реализациях одновременно
+	обрабатываются 8 или 16 блоков, а время расшифрования не зависит
+	от данных.
+*/
+void beltBlockDecrN(
+	u32 blocks[],			/*!< [in,out] блоки */
+	size_t count,			/*!< [in] число блоков */
+	const u32 key[8]		/*!< [in] ключ */
+);
+
+/*!	\brief Реализация belt-block
+
+	Возвращается название реализации, используемой в функциях
+	beltBlockEncrN() и beltBlockDecrN():
+	- "BELT_TABLE" -- табличная реализация;
+	- "BELT_AVX2" -- векторная реализация для AVX2 (8 блоков);
+	- "BELT_AVX512" -- векторная реализация для AVX512VBMI (16 блоков).
+	.
+	\return Название реализации.
+	\remark Векторные реализации включаются в библиотеку при сборке в режиме
+	BELT_AUTO (GCC или Clang, x86_64) и выбираются, если их поддерживает
+	процессор.
+*/
+const char* beltBlockPlatform();
+
 /*
 *******************************************************************************
 Шифрование широкого блока (belt-wbl, WBL)
@@ -412,6 +491,20 @@ void beltECBStart(
 	size_t len				/*!< [in] длина ключа в октетах */
 );
 
+/*!	\brief Инициализация шифрования в режиме ECB по подготовленному ключу
+
+	Выполняются действия beltECBStart() с ключом, подготовленным
+	в skey функцией beltKeyStart().
+	\pre По адресу state зарезервировано beltECB_keep() октетов.
+	\expect beltKeyStart() < beltECBStartK().
+	\remark Расширенный ключ копируется из skey в state. Подготовленный
+	ключ можно изменить или уничтожить сразу после вызова.
+*/
+void beltECBStartK(
+	void* state,			/*!< [out] состояние */
+	const void* skey		/*!< [in] подготовленный ключ */
+);
+
 /*!	\brief Зашифрование фрагмента в режиме ECB
 
 	Буфер [count]buf зашифровывается в режиме ECB на ключе, размещенном 
@@ -432,6 +525,21 @@ void beltECBStepE(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Зашифрование в режиме ECB с выходным буфером
+
+	Буфер [count]src зашифровывается так же, как в beltECBStepE().
+	Результат размещается в буфере [count]dest.
+	\pre count >= 16.
+	\pre Буфер dest либо не пересекается, либо совпадает с буфером src.
+	\remark Вызовы beltECBStepE() и beltECBStepETo() можно чередовать.
+*/
+void beltECBStepETo(
+	void* dest,			/*!< [out] шифртекст */
+	const void* src,	/*!< [in] открытый текст */
+	size_t count,		/*!< [in] число октетов текста */
+	void* state			/*!< [in,out] состояние */
+);
+
 /*!	\brief Расшифрование в режиме ECB
 
 	Буфер [count]buf расшифровывается в режиме ECB на ключе, размещенном 
@@ -446,6 +554,21 @@ void beltECBStepD(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Расшифрование в режиме ECB с выходным буфером
+
+	Буфер [count]src расшифровывается так же, как в beltECBStepD().
+	Результат размещается в буфере [count]dest.
+	\pre count >= 16.
+	\pre Буфер dest либо не пересекается, либо совпадает с буфером src.
+	\remark Вызовы beltECBStepD() и beltECBStepDTo() можно чередовать.
+*/
+void beltECBStepDTo(
+	void* dest,			/*!< [out] открытый текст */
+	const void* src,	/*!< [in] шифртекст */
+	size_t count,		/*!< [in] число октетов текста */
+	void* state			/*!< [in,out] состояние */
+);
+
 /*!	\brief Зашифрование в режиме ECB
 
 	Буфер [count]src зашифровывается на ключе [len]key октетов.
@@ -512,6 +635,21 @@ void beltCBCStart(
 	const octet iv[16]		/*!< [in] синхропосылка */
 );
 
+/*!	\brief Инициализация шифрования в режиме CBC по подготовленному ключу
+
+	Выполняются действия beltCBCStart() с ключом, подготовленным
+	в skey функцией beltKeyStart().
+	\pre По адресу state зарезервировано beltCBC_keep() октетов.
+	\expect beltKeyStart() < beltCBCStartK().
+	\remark Расширенный ключ копируется из skey в state. Подготовленный
+	ключ можно изменить или уничтожить сразу после вызова.
+*/
+void beltCBCStartK(
+	void* state,			/*!< [out] состояние */
+	const void* skey,		/*!< [in] подготовленный ключ */
+	const octet iv[16]		/*!< [in] синхропосылка */
+);
+
 /*!	\brief Зашифрование в режиме CBC
 
 	Буфер [count]buf зашифровывается в режиме CBC на ключе, размещенном 
@@ -532,6 +670,21 @@ void beltCBCStepE(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Зашифрование в режиме CBC с выходным буфером
+
+	Буфер [count]src зашифровывается так же, как в beltCBCStepE().
+	Результат размещается в буфере [count]dest.
+	\pre count >= 16.
+	\pre Буфер dest либо не пересекается, либо совпадает с буфером src.
+	\remark Вызовы beltCBCStepE() и beltCBCStepETo() можно чередовать.
+*/
+void beltCBCStepETo(
+	void* dest,			/*!< [out] шифртекст */
+	const void* src,	/*!< [in] открытый текст */
+	size_t count,		/*!< [in] число октетов текста */
+	void* state			/*!< [in,out] состояние */
+);
+
 /*!	\brief Расшифрование в режиме CBC
 
 	Буфер [count]buf расшифровывается в режиме CBC на ключе, размещенном 
@@ -546,6 +699,21 @@ void beltCBCStepD(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Расшифрование в режиме CBC с выходным буфером
+
+	Буфер [count]src расшифровывается так же, как в beltCBCStepD().
+	Результат размещается в буфере [count]dest.
+	\pre count >= 16.
+	\pre Буфер dest либо не пересекается, либо совпадает с буфером src.
+	\remark Вызовы beltCBCStepD() и beltCBCStepDTo() можно чередовать.
+*/
+void beltCBCStepDTo(
+	void* dest,			/*!< [out] открытый текст */
+	const void* src,	/*!< [in] шифртекст */
+	size_t count,		/*!< [in] число октетов текста */
+	void* state			/*!< [in,out] состояние */
+);
+
 /*!	\brief Зашифрование в режиме CBC
 
 	Буфер [count]src зашифровывается на ключе [len]key с использованием 
@@ -616,6 +784,21 @@ void beltCFBStart(
 	const octet iv[16]		/*!< [in] синхропосылка */
 );
 
+/*!	\brief Инициализация шифрования в режиме CFB по подготовленному ключу
+
+	Выполняются действия beltCFBStart() с ключом, подготовленным
+	в skey функцией beltKeyStart().
+	\pre По адресу state зарезервировано beltCFB_keep() октетов.
+	\expect beltKeyStart() < beltCFBStartK().
+	\remark Расширенный ключ копируется из skey в state. Подготовленный
+	ключ можно изменить или уничтожить сразу после вызова.
+*/
+void beltCFBStartK(
+	void* state,			/*!< [out] состояние */
+	const void* skey,		/*!< [in] подготовленный ключ */
+	const octet iv[16]		/*!< [in] синхропосылка */
+);
+
 /*!	\brief Зашифрование в режиме CFB
 
 	Буфер [count]buf зашифровывается в режиме CFB на ключе, размещенном 
@@ -628,6 +811,20 @@ void beltCFBStepE(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Зашифрование в режиме CFB с выходным буфером
+
+	Буфер [count]src зашифровывается так же, как в beltCFBStepE().
+	Результат размещается в буфере [count]dest.
+	\pre Буфер dest либо не пересекается, либо совпадает с буфером src.
+	\remark Вызовы beltCFBStepE() и beltCFBStepETo() можно чередовать.
+*/
+void beltCFBStepETo(
+	void* dest,			/*!< [out] шифртекст */
+	const void* src,	/*!< [in] открытый текст */
+	size_t count,		/*!< [in] число октетов текста */
+	void* state			/*!< [in,out] состояние */
+);
+
 /*!	\brief Расшифрование в режиме CFB
 
 	Буфер [count]buf расшифровывается в режиме CFB на ключе, размещенном 
@@ -640,6 +837,20 @@ void beltCFBStepD(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Расшифрование в режиме CFB с выходным буфером
+
+	Буфер [count]src расшифровывается так же, как в beltCFBStepD().
+	Результат размещается в буфере [count]dest.
+	\pre Буфер dest либо не пересекается, либо совпадает с буфером src.
+	\remark Вызовы beltCFBStepD() и beltCFBStepDTo() можно чередовать.
+*/
+void beltCFBStepDTo(
+	void* dest,			/*!< [out] открытый текст */
+	const void* src,	/*!< [in] шифртекст */
+	size_t count,		/*!< [in] число октетов текста */
+	void* state			/*!< [in,out] состояние */
+);
+
 /*!	\brief Зашифрование в режиме CFB
 
 	Буфер [count]src зашифровывается на ключе [len]key с использованием 
@@ -704,6 +915,21 @@ void beltCTRStart(
 	const octet iv[16]		/*!< [in] синхропосылка */
 );
 
+/*!	\brief Инициализация шифрования в режиме CTR по подготовленному ключу
+
+	Выполняются действия beltCTRStart() с ключом, подготовленным
+	в skey функцией beltKeyStart().
+	\pre По адресу state зарезервировано beltCTR_keep() октетов.
+	\expect beltKeyStart() < beltCTRStartK().
+	\remark Расширенный ключ копируется из skey в state. Подготовленный
+	ключ можно изменить или уничтожить сразу после вызова.
+*/
+void beltCTRStartK(
+	void* state,			/*!< [out] состояние */
+	const void* skey,		/*!< [in] подготовленный ключ */
+	const octet iv[16]		/*!< [in] синхропосылка */
+);
+
 /*!	\brief Зашифрование фрагмента в режиме CTR
 
 	Буфер [count]buf зашифровывается в режиме CTR на ключе, размещенном 
@@ -721,6 +947,40 @@ void beltCTRStepE(
 */
 #define beltCTRStepD beltCTRStepE
 
+/*!	\brief Зашифрование в режиме CTR с выходным буфером
+
+	Буфер [count]src зашифровывается так же, как в beltCTRStepE().
+	Результат размещается в буфере [count]dest.
+	\pre Буфер dest либо не пересекается, либо совпадает с буфером src.
+	\remark Вызовы beltCTRStepE() и beltCTRStepETo() можно чередовать.
+*/
+void beltCTRStepETo(
+	void* dest,			/*!< [out] шифртекст / открытый текст */
+	const void* src,	/*!< [in] открытый текст / шифртекст */
+	size_t count,		/*!< [in] число октетов текста */
+	void* state			/*!< [in,out] состояние */
+);
+
+/*!	\brief Расшифрование в режиме CTR с выходным буфером
+	\remark Зашифрование в режиме CTR не отличается от расшифрования.
+*/
+#define beltCTRStepDTo beltCTRStepETo
+
+/*!	\brief Позиционирование в режиме CTR
+
+	Состояние state перестраивается так, как если бы после beltCTRStart()
+	было зашифровано offset октетов текста. Следующий вызов
+	beltCTRStepE() (beltCTRStepD()) обрабатывает текст, начиная
+	с октета с номером offset.
+	\expect beltCTRStart() < beltCTRSeek().
+	\remark Время позиционирования не зависит от offset: вычисляется
+	не более одного блока гаммы.
+*/
+void beltCTRSeek(
+	void* state,		/*!< [in,out] состояние */
+	size_t offset		/*!< [in] номер октета текста */
+);
+
 /*!	\brief Шифрование в режиме CTR
 
 	Буфер [count]src зашифровывается или расшифровывается на ключе
@@ -740,6 +1000,28 @@ err_t beltCTR(
 	const octet iv[16]		/*!< [in] синхропосылка */
 );
 
+/*!	\brief Шифрование в режиме CTR в пуле потоков
+
+	Буфер [count]src зашифровывается или расшифровывается так же, как
+	в beltCTR(). Буфер разбивается на фрагменты, которые шифруются
+	в задачах пула потоков pool (см. beltCTRSeek()). Если pool == 0, то
+	шифрование выполняется в вызывающем потоке.
+	\expect{ERR_BAD_INPUT} len == 16 || len == 24 || len == 32.
+	\return ERR_OK, если шифрование завершено успешно, и код ошибки
+	в противном случае.
+	\remark Буферы могут пересекаться.
+	\pre Функция не вызывается из задач пула pool.
+*/
+err_t beltCTRPool(
+	void* dest,				/*!< [out] шифртекст / открытый текст */
+	const void* src,		/*!< [in] открытый текст / шифртекст */
+	size_t count,			/*!< [in] число октетов текста */
+	const octet key[],		/*!< [in] ключ */
+	size_t len,				/*!< [in] длина ключа */
+	const octet iv[16],		/*!< [in] синхропосылка */
+	mt_pool_t* pool			/*!< [in,out] пул потоков */
+);
+
 /*
 *******************************************************************************
 Имитозащита (belt-mac, MAC)
@@ -767,6 +1049,20 @@ void beltMACStart(
 	size_t len				/*!< [in] длина ключа в октетах */
 );
 
+/*!	\brief Инициализация имитозащиты в режиме MAC по подготовленному ключу
+
+	Выполняются действия beltMACStart() с ключом, подготовленным
+	в skey функцией beltKeyStart().
+	\pre По адресу state зарезервировано beltMAC_keep() октетов.
+	\expect beltKeyStart() < beltMACStartK().
+	\remark Расширенный ключ копируется из skey в state. Подготовленный
+	ключ можно изменить или уничтожить сразу после вызова.
+*/
+void beltMACStartK(
+	void* state,			/*!< [out] состояние */
+	const void* skey		/*!< [in] подготовленный ключ */
+);
+
 /*!	\brief Имитозащита фрагмента данных в режиме MAC
 
 	Текущая имитовставка, размещенная в state, пересчитывается с учетом нового
@@ -780,6 +1076,22 @@ void beltMACStepA(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Имитозащита фрагментов данных в режиме MAC
+
+	Текущая имитовставка, размещенная в state, пересчитывается с учетом
+	фрагментов данных [count[0]]buf[0],..., [count[n - 1]]buf[n - 1].
+	Фрагменты обрабатываются так, как если бы они были записаны подряд
+	в один буфер.
+	\expect beltMACStart() < beltMACStepAV()*.
+	\remark Вызовы beltMACStepA() и beltMACStepAV() можно чередовать.
+*/
+void beltMACStepAV(
+	const void* const buf[],	/*!< [in] фрагменты данных */
+	const size_t count[],		/*!< [in] длины фрагментов */
+	size_t n,					/*!< [in] число фрагментов */
+	void* state					/*!< [in,out] состояние */
+);
+
 /*!	\brief Определение имитовставки в режиме MAC
 
 	Определяется окончательная имитовставка mac всех данных,
@@ -842,6 +1154,7 @@ bool_t beltMACStepV2(
 	\return ERR_OK, если имитовставка успешно вычислена, и код ошибки
 	в противном случае.
 	\remark Буферы могут пересекаться.
+	\remark Состояние размещается в памяти потока (см. stackCreate()).
 */
 err_t beltMAC(
 	octet mac[8],			/*!< [out] имитовставка */
@@ -851,6 +1164,29 @@ err_t beltMAC(
 	size_t len				/*!< [in] длина ключа */
 );
 
+/*!	\brief Имитозащита нескольких сообщений
+
+	На ключах [len[0]]key[0], [len[1]]key[1],..., [len[n - 1]]key[n - 1]
+	определяются имитовставки [8]mac, [8](mac + 8),..., [8](mac + 8 * (n - 1))
+	буферов [count[0]]src[0], [count[1]]src[1],..., [count[n - 1]]src[n - 1].
+	\expect{ERR_BAD_INPUT} len[i] == 16 || len[i] == 24 || len[i] == 32.
+	\return ERR_OK, если имитовставки успешно вычислены, и код ошибки
+	в противном случае.
+	\remark Буферы обрабатываются одновременно по четыре. Функцию 
+	рекомендуется использовать при имитозащите большого числа
+	независимых сообщений.
+	\remark Ключи key[i] могут совпадать.
+	\remark Буферы src[i] могут пересекаться.
+*/
+err_t beltMACMB(
+	octet mac[],				/*!< [out] имитовставки */
+	const void* const src[],	/*!< [in] данные */
+	const size_t count[],		/*!< [in] длины данных в октетах */
+	const octet* const key[],	/*!< [in] ключи */
+	const size_t len[],			/*!< [in] длины ключей в октетах */
+	size_t n					/*!< [in] число сообщений */
+);
+
 /*
 *******************************************************************************
 Аутентифицированное шифрование по схеме DWP (belt-dwp, DWP)
@@ -880,6 +1216,21 @@ void beltDWPStart(
 	const octet iv[16]		/*!< [in] синхропосылка */
 );
 
+/*!	\brief Инициализация режима DWP по подготовленному ключу
+
+	Выполняются действия beltDWPStart() с ключом, подготовленным
+	в skey функцией beltKeyStart().
+	\pre По адресу state зарезервировано beltDWP_keep() октетов.
+	\expect beltKeyStart() < beltDWPStartK().
+	\remark Расширенный ключ копируется из skey в state. Подготовленный
+	ключ можно изменить или уничтожить сразу после вызова.
+*/
+void beltDWPStartK(
+	void* state,			/*!< [out] состояние */
+	const void* skey,		/*!< [in] подготовленный ключ */
+	const octet iv[16]		/*!< [in] синхропосылка */
+);
+
 /*!	\brief Зашифрование критического фрагмента в режиме DWP
 
 	Фрагмент критических данных [count]buf зашифровывается на ключе,
@@ -892,6 +1243,37 @@ void beltDWPStepE(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Зашифрование критических фрагментов в режиме DWP
+
+	Фрагменты критических данных [count[0]]buf[0],..., [count[n - 1]]buf[n - 1]
+	зашифровываются на ключе, размещенном в state. Результаты
+	зашифрования сохраняются в buf[i].
+	Фрагменты обрабатываются так, как если бы они были записаны подряд
+	в один буфер.
+	\expect beltDWPStart() < beltDWPStepEV()*.
+	\remark Вызовы beltDWPStepE() и beltDWPStepEV() можно чередовать.
+*/
+void beltDWPStepEV(
+	void* const buf[],		/*!< [in,out] критические данные */
+	const size_t count[],	/*!< [in] длины фрагментов */
+	size_t n,				/*!< [in] число фрагментов */
+	void* state				/*!< [in,out] состояние */
+);
+
+/*!	\brief Зашифрование критического фрагмента в режиме DWP с выходным буфером
+
+	Фрагмент [count]src зашифровывается так же, как в beltDWPStepE().
+	Результат размещается в буфере [count]dest.
+	\pre Буфер dest либо не пересекается, либо совпадает с буфером src.
+	\remark Вызовы beltDWPStepE() и beltDWPStepETo() можно чередовать.
+*/
+void beltDWPStepETo(
+	void* dest,			/*!< [out] зашифрованные данные */
+	const void* src,	/*!< [in] критические данные */
+	size_t count,		/*!< [in] число октетов данных */
+	void* state			/*!< [in,out] состояние */
+);
+
 /*!	\brief Имитозащита открытого фрагмента в режиме DWP
 
 	Текущая имитовставка, размещенная в state, пересчитывается с учетом нового
@@ -920,6 +1302,23 @@ void beltDWPStepA(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Имитозащита критических фрагментов в режиме DWP
+
+	Текущая имитовставка, размещенная в state, пересчитывается с учетом
+	фрагментов зашифрованных критических данных
+	[count[0]]buf[0],..., [count[n - 1]]buf[n - 1].
+	Фрагменты обрабатываются так, как если бы они были записаны подряд
+	в один буфер.
+	\expect beltDWPStepE()* < beltDWPStepAV()*.
+	\remark Вызовы beltDWPStepA() и beltDWPStepAV() можно чередовать.
+*/
+void beltDWPStepAV(
+	const void* const buf[],	/*!< [in] критические данные */
+	const size_t count[],		/*!< [in] длины фрагментов */
+	size_t n,					/*!< [in] число фрагментов */
+	void* state					/*!< [in,out] состояние */
+);
+
 /*!	\brief Определение имитовставки в режиме DWP
 
 	Определяется окончательная имитовставка mac всех данных,
@@ -964,6 +1363,20 @@ void beltDWPStepD(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Расшифрование критического фрагмента в режиме DWP с выходным буфером
+
+	Фрагмент [count]src расшифровывается так же, как в beltDWPStepD().
+	Результат размещается в буфере [count]dest.
+	\pre Буфер dest либо не пересекается, либо совпадает с буфером src.
+	\remark Вызовы beltDWPStepD() и beltDWPStepDTo() можно чередовать.
+*/
+void beltDWPStepDTo(
+	void* dest,			/*!< [out] критические данные */
+	const void* src,	/*!< [in] зашифрованные данные */
+	size_t count,		/*!< [in] число октетов данных */
+	void* state			/*!< [in,out] состояние */
+);
+
 /*!	\brief Установка защиты в режиме DWP
 
 	На ключе [len]key с использованием имитовставки iv устанавливается 
@@ -978,6 +1391,8 @@ void beltDWPStepD(
 	\return ERR_OK, если защита успешно установлена, и код ошибки
 	в противном случае.
 	\remark Буферы могут пересекаться, за исключением пересечения dest и mac.
+	\remark Критические данные зашифровываются и обрабатываются фрагментами
+	за один проход.
 */
 err_t beltDWPWrap(
 	void* dest,				/*!< [out] зашифрованные критические данные */
@@ -1003,6 +1418,9 @@ err_t beltDWPWrap(
 	\return ERR_OK, если защита успешно снята, и код ошибки
 	в противном случае.
 	\remark Буферы могут пересекаться.
+	\remark Если буфер dest не пересекается с буферами src1 и src2, то
+	проверка целостности и расшифрование выполняются за один проход
+	по данным. При нарушении целостности буфер dest обнуляется.
 */
 err_t beltDWPUnwrap(
 	void* dest,				/*!< [out] расшифрованные критические данные */
@@ -1045,6 +1463,21 @@ void beltCHEStart(
 	const octet iv[16]		/*!< [in] синхропосылка */
 );
 
+/*!	\brief Инициализация режима CHE по подготовленному ключу
+
+	Выполняются действия beltCHEStart() с ключом, подготовленным
+	в skey функцией beltKeyStart().
+	\pre По адресу state зарезервировано beltCHE_keep() октетов.
+	\expect beltKeyStart() < beltCHEStartK().
+	\remark Расширенный ключ копируется из skey в state. Подготовленный
+	ключ можно изменить или уничтожить сразу после вызова.
+*/
+void beltCHEStartK(
+	void* state,			/*!< [out] состояние */
+	const void* skey,		/*!< [in] подготовленный ключ */
+	const octet iv[16]		/*!< [in] синхропосылка */
+);
+
 /*!	\brief Зашифрование критического фрагмента в режиме CHE
 
 	Фрагмент критических данных [count]buf зашифровывается на ключе,
@@ -1057,6 +1490,20 @@ void beltCHEStepE(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Зашифрование критического фрагмента в режиме CHE с выходным буфером
+
+	Фрагмент [count]src зашифровывается так же, как в beltCHEStepE().
+	Результат размещается в буфере [count]dest.
+	\pre Буфер dest либо не пересекается, либо совпадает с буфером src.
+	\remark Вызовы beltCHEStepE() и beltCHEStepETo() можно чередовать.
+*/
+void beltCHEStepETo(
+	void* dest,			/*!< [out] зашифрованные данные */
+	const void* src,	/*!< [in] критические данные */
+	size_t count,		/*!< [in] число октетов данных */
+	void* state			/*!< [in,out] состояние */
+);
+
 /*!	\brief Имитозащита открытого фрагмента в режиме CHE
 
 	Текущая имитовставка, размещенная в state, пересчитывается с учетом нового
@@ -1129,6 +1576,20 @@ void beltCHEStepD(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Расшифрование критического фрагмента в режиме CHE с выходным буфером
+
+	Фрагмент [count]src расшифровывается так же, как в beltCHEStepD().
+	Результат размещается в буфере [count]dest.
+	\pre Буфер dest либо не пересекается, либо совпадает с буфером src.
+	\remark Вызовы beltCHEStepD() и beltCHEStepDTo() можно чередовать.
+*/
+void beltCHEStepDTo(
+	void* dest,			/*!< [out] критические данные */
+	const void* src,	/*!< [in] зашифрованные данные */
+	size_t count,		/*!< [in] число октетов данных */
+	void* state			/*!< [in,out] состояние */
+);
+
 /*!	\brief Установка защиты в режиме CHE
 
 	На ключе [len]key с использованием имитовставки iv устанавливается
@@ -1143,6 +1604,8 @@ void beltCHEStepD(
 	\return ERR_OK, если защита успешно установлена, и код ошибки
 	в противном случае.
 	\remark Буферы могут пересекаться, за исключением пересечения dest и mac.
+	\remark Критические данные зашифровываются и обрабатываются фрагментами
+	за один проход.
 */
 err_t beltCHEWrap(
 	void* dest,				/*!< [out] зашифрованные критические данные */
@@ -1168,6 +1631,9 @@ err_t beltCHEWrap(
 	\return ERR_OK, если защита успешно снята, и код ошибки
 	в противном случае.
 	\remark Буферы могут пересекаться.
+	\remark Если буфер dest не пересекается с буферами src1 и src2, то
+	проверка целостности и расшифрование выполняются за один проход
+	по данным. При нарушении целостности буфер dest обнуляется.
 */
 err_t beltCHEUnwrap(
 	void* dest,				/*!< [out] расшифрованные критические данные */
@@ -1181,6 +1647,75 @@ err_t beltCHEUnwrap(
 	const octet iv[16]		/*!< [in] синхропосылка */
 );
 
+/*!	\brief Пакетная установка защиты в режиме CHE
+
+	На ключе [len]key устанавливается защита пакетов i = 0, 1,..., n - 1:
+	критические данные [count1[i]]src1[i] зашифровываются и записываются
+	в буфер [count1[i]]dest[i], для критических и открытых данных
+	[count2[i]]src2[i] вырабатывается имитовставка [8](mac + 8 * i).
+	При этом используется синхропосылка [16](iv + 16 * i).
+	\expect{ERR_BAD_INPUT}
+	-	len == 16 || len == 24 || len == 32;
+	-	буферы dest, src1, count1, src2, count2, [16 * n]iv, [8 * n]mac,
+	а также буферы пакетов корректны.
+	.
+	\return ERR_OK, если защита установлена, и код ошибки в противном
+	случае.
+	\remark Результат для каждого пакета совпадает с результатом
+	beltCHEWrap(). Синхропосылки, счетчики и имитовставки нескольких пакетов
+	зашифровываются одновременно (см. beltBlockEncrN()), что ускоряет
+	обработку коротких пакетов.
+	\remark Буферы src1[i], src2[i], dest[i] одного пакета могут пересекаться.
+	Буфер dest[i] не должен пересекаться с буферами других пакетов.
+	\warning Синхропосылки пакетов должны быть различными.
+*/
+err_t beltCHEWrapBatch(
+	void* const dest[],			/*!< [out] зашифрованные критические данные */
+	octet mac[],				/*!< [out] имитовставки */
+	const void* const src1[],	/*!< [in] критические данные */
+	const size_t count1[],		/*!< [in] длины критических данных */
+	const void* const src2[],	/*!< [in] открытые данные */
+	const size_t count2[],		/*!< [in] длины открытых данных */
+	size_t n,					/*!< [in] число пакетов */
+	const octet key[],			/*!< [in] ключ */
+	size_t len,					/*!< [in] длина ключа */
+	const octet iv[]			/*!< [in] синхропосылки */
+);
+
+/*!	\brief Пакетное снятие защиты в режиме CHE
+
+	На ключе [len]key снимается защита пакетов i = 0, 1,..., n - 1:
+	проверяется целостность зашифрованных критических данных
+	[count1[i]]src1[i] и открытых данных [count2[i]]src2[i] по имитовставке
+	[8](mac + 8 * i) и синхропосылке [16](iv + 16 * i). Признак целостности
+	записывается в valid[i]. Если целостность не нарушена, то критические
+	данные расшифровываются и записываются в буфер [count1[i]]dest[i].
+	В противном случае буфер dest[i] не меняется.
+	\expect{ERR_BAD_INPUT}
+	-	len == 16 || len == 24 || len == 32;
+	-	буферы dest, valid, src1, count1, src2, count2, [8 * n]mac,
+	[16 * n]iv, а также буферы пакетов корректны.
+	.
+	\return ERR_OK, если целостность всех пакетов не нарушена, ERR_BAD_MAC,
+	если нарушена целостность хотя бы одного пакета, и другой код ошибки
+	в остальных случаях.
+	\remark Буферы src1[i], src2[i], dest[i] одного пакета могут пересекаться.
+	Буфер dest[i] не должен пересекаться с буферами других пакетов.
+*/
+err_t beltCHEUnwrapBatch(
+	void* const dest[],			/*!< [out] расшифрованные критические данные */
+	bool_t valid[],				/*!< [out] признаки целостности */
+	const void* const src1[],	/*!< [in] зашифрованные критические данные */
+	const size_t count1[],		/*!< [in] длины критических данных */
+	const void* const src2[],	/*!< [in] открытые данные */
+	const size_t count2[],		/*!< [in] длины открытых данных */
+	const octet mac[],			/*!< [in] имитовставки */
+	size_t n,					/*!< [in] число пакетов */
+	const octet key[],			/*!< [in] ключ */
+	size_t len,					/*!< [in] длина ключа */
+	const octet iv[]			/*!< [in] синхропосылки */
+);
+
 /*
 *******************************************************************************
 Шифрование и имитозащита ключей (belt-kwp, KWP)
@@ -1242,6 +1777,59 @@ err_t beltKWPUnwrap(
 	size_t len				/*!< [in] длина key в октетах */
 );
 
+/*!	\brief Установка защиты нескольких ключей в режиме KWP
+
+	На ключе, размещенном в state, устанавливается защита ключей 
+	[count]src[count * i] с заголовком header, i = 0, 1,..., n - 1.
+	Защищенные ключи [count + 16]dest[(count + 16) * i] размещаются 
+	в буфере dest последовательно.
+	\pre Состояние state подготовлено функцией beltKWPStart().
+	\expect{ERR_BAD_INPUT}
+	-	count >= 16;
+	-	буфер dest не пересекается с буферами src, header и state.
+	.
+	\return ERR_OK, если защита успешно установлена, и код ошибки 
+	в противном случае.
+	\remark При нулевом указателе header используется нулевой заголовок.
+	\remark Динамическая память не используется. При count % 16 == 0 
+	ключи обрабатываются четверками.
+*/
+err_t beltKWPWrapN(
+	octet dest[],				/*!< [out] защищенные ключи */
+	const octet src[],			/*!< [in] защищаемые ключи */
+	size_t count,				/*!< [in] длина ключа в октетах */
+	size_t n,					/*!< [in] число ключей */
+	const octet header[16],		/*!< [in] заголовок ключей */
+	void* state					/*!< [in,out] состояние */
+);
+
+/*!	\brief Снятие защиты с нескольких ключей в режиме KWP
+
+	На ключе, размещенном в state, снимается защита с ключей 
+	[count]src[count * i], i = 0, 1,..., n - 1. Первоначальные ключи 
+	[count - 16]dest[(count - 16) * i] размещаются в буфере dest 
+	последовательно. Все ключи должны иметь заголовок header.
+	\pre Состояние state подготовлено функцией beltKWPStart().
+	\expect{ERR_BAD_INPUT}
+	-	count >= 32;
+	-	буфер dest не пересекается с буферами src и state.
+	.
+	\return ERR_OK, если защита успешно снята, и код ошибки в противном 
+	случае.
+	\remark При нулевом указателе header используется нулевой заголовок.
+	\remark Если заголовок хотя бы одного ключа не совпадает с header, то 
+	возвращается ERR_BAD_KEYTOKEN и буфер dest обнуляется.
+	\remark Динамическая память не используется.
+*/
+err_t beltKWPUnwrapN(
+	octet dest[],				/*!< [out] ключи */
+	const octet src[],			/*!< [in] защищенные ключи */
+	size_t count,				/*!< [in] длина защищенного ключа в октетах */
+	size_t n,					/*!< [in] число ключей */
+	const octet header[16],		/*!< [in] заголовок ключей */
+	void* state					/*!< [in,out] состояние */
+);
+
 /*
 *******************************************************************************
 Хэширование (belt-hash, Hash)
@@ -1276,6 +1864,22 @@ void beltHashStepH(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Хэширование фрагментов данных
+
+	Текущее хэш-значение, размещенное в state, пересчитывается с учетом
+	фрагментов данных [count[0]]buf[0],..., [count[n - 1]]buf[n - 1].
+	Фрагменты обрабатываются так, как если бы они были записаны подряд
+	в один буфер.
+	\expect beltHashStart() < beltHashStepHV()*.
+	\remark Вызовы beltHashStepH() и beltHashStepHV() можно чередовать.
+*/
+void beltHashStepHV(
+	const void* const buf[],	/*!< [in] фрагменты данных */
+	const size_t count[],		/*!< [in] длины фрагментов */
+	size_t n,					/*!< [in] число фрагментов */
+	void* state					/*!< [in,out] состояние */
+);
+
 /*!	\brief Определение хэш-значения
 
 	Определяется окончательное хэш-значение hash всех данных,
@@ -1331,12 +1935,51 @@ bool_t beltHashStepV2(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Длина экспорта состояния хэширования */
+#define BELT_HASH_EXPORT_LEN 99
+
+/*!	\brief Экспорт состояния хэширования
+
+	Состояние хэширования state записывается в буфер
+	[BELT_HASH_EXPORT_LEN]buf в переносимом формате:
+	- октет 0x31 (идентификатор belt-hash);
+	- октет 0x01 (версия формата);
+	- число накопленных октетов неполного блока (от 0 до 31);
+	- 128-битовая длина обработанных данных в битах, переменные s и h
+	(слова в порядке little-endian);
+	- накопленные октеты неполного блока, дополненные нулями до 32.
+	\expect beltHashStart() < beltHashExport().
+	\remark Экспорт не зависит от платформы: его можно импортировать
+	на платформе с другим порядком октетов или другой разрядностью.
+	\remark Экспорт не меняет состояние: хэширование можно продолжить.
+*/
+void beltHashExport(
+	octet buf[],			/*!< [out] экспорт */
+	const void* state		/*!< [in] состояние */
+);
+
+/*!	\brief Импорт состояния хэширования
+
+	По экспорту [BELT_HASH_EXPORT_LEN]buf восстанавливается состояние
+	хэширования state. После импорта хэширование можно продолжить
+	функциями beltHashStepH(), beltHashStepG(), beltHashStepV().
+	\pre По адресу state зарезервировано beltHash_keep() октетов.
+	\return ERR_OK, если состояние восстановлено, ERR_BAD_FORMAT, если
+	buf не является корректным экспортом, и код ошибки в противном случае.
+	\expect beltHashExport() < beltHashImport().
+*/
+err_t beltHashImport(
+	void* state,			/*!< [out] состояние */
+	const octet buf[]		/*!< [in] экспорт */
+);
+
 /*!	\brief Хэширование
 
 	Определяется хэш-значение hash буфера [count]src.
 	\return ERR_OK, если хэширование успешно завершено, и код ошибки
 	в противном случае.
 	\remark Буферы могут пересекаться.
+	\remark Состояние размещается в памяти потока (см. stackCreate()).
 */
 err_t beltHash(
 	octet hash[32],		/*!< [out] хэш-значение */
@@ -1344,6 +1987,53 @@ err_t beltHash(
 	size_t count		/*!< [in] число октетов данных */
 );
 
+/*!	\brief Хэширование нескольких сообщений
+
+	Определяются хэш-значения [32]hash, [32](hash + 32),..., 
+	[32](hash + 32 * (n - 1)) буферов [count[0]]src[0], [count[1]]src[1],...,
+	[count[n - 1]]src[n - 1].
+	\return ERR_OK, если хэширование успешно завершено, и код ошибки
+	в противном случае.
+	\remark Буферы обрабатываются одновременно по четыре. Функцию 
+	рекомендуется использовать при хэшировании большого числа коротких
+	сообщений.
+	\remark Буферы src[i] могут пересекаться.
+*/
+err_t beltHashMB(
+	octet hash[],				/*!< [out] хэш-значения */
+	const void* const src[],	/*!< [in] данные */
+	const size_t count[],		/*!< [in] длины данных в октетах */
+	size_t n					/*!< [in] число сообщений */
+);
+
+/*!	\brief Запрос на хэширование
+
+	Асинхронный запрос на хэширование буфера [count]src. Хэш-значение
+	записывается по адресу [32]hash.
+*/
+typedef struct
+{
+	mt_req_t req;				/*!< заголовок запроса */
+	const void* src;			/*!< [in] данные */
+	size_t count;				/*!< [in] длина данных в октетах */
+	octet* hash;				/*!< [out] хэш-значение */
+} belt_hash_req_t;
+
+/*!	\brief Асинхронное хэширование
+
+	Запрос req ставится на выполнение в исполнитель as. Запросы
+	исполнителя на хэширование объединяются в пакеты, которые
+	обрабатываются функцией beltHashMB().
+	\pre В req->req задано поле done и, возможно, поле user.
+	\pre Буферы запроса остаются доступными до его завершения.
+	\remark Код завершения запроса req->req.code -- ERR_OK, если
+	хэширование успешно завершено, и код ошибки в противном случае.
+*/
+void beltHashAsync(
+	mt_async_t* as,				/*!< [in,out] исполнитель */
+	belt_hash_req_t* req		/*!< [in,out] запрос */
+);
+
 /*
 *******************************************************************************
 Блоковое дисковое шифрование (belt-bde, BDE)
@@ -1440,6 +2130,61 @@ err_t beltBDEDecr(
 	const octet iv[16]		/*!< [in] синхропосылка */
 );
 
+/*!	\brief Зашифрование секторов в режиме BDE
+
+	Буфер [count]src, составленный из секторов длины sector_len,
+	зашифровывается на ключе [len]key. Для зашифрования i-го сектора 
+	используется синхропосылка iv + i, где iv интерпретируется как номер 
+	первого сектора, записанный по правилам little-endian, а сложение 
+	выполняется по модулю 2^128. Результат зашифрования размещается 
+	в буфере [count]dest.
+	\expect{ERR_BAD_INPUT}
+	-	len == 16 || len == 24 || len == 32;
+	-	sector_len % 16 == 0 && sector_len >= 16;
+	-	count % sector_len == 0 && count >= sector_len.
+	.
+	\return ERR_OK, если данные успешно зашифрованы, и код ошибки
+	в противном случае.
+	\remark Результат совпадает с результатом последовательных вызовов 
+	beltBDEEncr() для отдельных секторов. Ключ разбирается один раз, 
+	блоки секторов обрабатываются четверками.
+	\remark Буферы могут пересекаться.
+*/
+err_t beltBDEEncrSectors(
+	void* dest,				/*!< [out] шифртекст */
+	const void* src,		/*!< [in] открытый текст */
+	size_t count,			/*!< [in] число октетов текста */
+	size_t sector_len,		/*!< [in] длина сектора */
+	const octet key[],		/*!< [in] ключ */
+	size_t len,				/*!< [in] длина ключа */
+	const octet iv[16]		/*!< [in] номер первого сектора */
+);
+
+/*!	\brief Расшифрование секторов в режиме BDE
+
+	Буфер [count]src, составленный из секторов длины sector_len,
+	расшифровывается на ключе [len]key. Для расшифрования i-го сектора 
+	используется синхропосылка iv + i (см. beltBDEEncrSectors()).
+	Результат расшифрования размещается в буфере [count]dest.
+	\expect{ERR_BAD_INPUT}
+	-	len == 16 || len == 24 || len == 32;
+	-	sector_len % 16 == 0 && sector_len >= 16;
+	-	count % sector_len == 0 && count >= sector_len.
+	.
+	\return ERR_OK, если данные успешно расшифрованы, и код ошибки
+	в противном случае.
+	\remark Буферы могут пересекаться.
+*/
+err_t beltBDEDecrSectors(
+	void* dest,				/*!< [out] открытый текст */
+	const void* src,		/*!< [in] шифртекст */
+	size_t count,			/*!< [in] число октетов текста */
+	size_t sector_len,		/*!< [in] длина сектора */
+	const octet key[],		/*!< [in] ключ */
+	size_t len,				/*!< [in] длина ключа */
+	const octet iv[16]		/*!< [in] номер первого сектора */
+);
+
 /*
 *******************************************************************************
 Секторное дисковое шифрование (belt-sde, SDE)
@@ -1537,6 +2282,61 @@ err_t beltSDEDecr(
 	const octet iv[16]		/*!< [in] синхропосылка */
 );
 
+/*!	\brief Зашифрование секторов в режиме SDE
+
+	Буфер [count]src, составленный из секторов длины sector_len,
+	зашифровывается на ключе [len]key. Для зашифрования i-го сектора 
+	используется синхропосылка iv + i, где iv интерпретируется как номер 
+	первого сектора, записанный по правилам little-endian, а сложение 
+	выполняется по модулю 2^128. Результат зашифрования размещается 
+	в буфере [count]dest.
+	\expect{ERR_BAD_INPUT}
+	-	len == 16 || len == 24 || len == 32;
+	-	sector_len % 16 == 0 && sector_len >= 32;
+	-	count % sector_len == 0 && count >= sector_len.
+	.
+	\return ERR_OK, если данные успешно зашифрованы, и код ошибки
+	в противном случае.
+	\remark Результат совпадает с результатом последовательных вызовов 
+	beltSDEEncr() для отдельных секторов. Ключ разбирается один раз, 
+	блоки секторов обрабатываются четверками.
+	\remark Буферы могут пересекаться.
+*/
+err_t beltSDEEncrSectors(
+	void* dest,				/*!< [out] шифртекст */
+	const void* src,		/*!< [in] открытый текст */
+	size_t count,			/*!< [in] число октетов текста */
+	size_t sector_len,		/*!< [in] длина сектора */
+	const octet key[],		/*!< [in] ключ */
+	size_t len,				/*!< [in] длина ключа */
+	const octet iv[16]		/*!< [in] номер первого сектора */
+);
+
+/*!	\brief Расшифрование секторов в режиме SDE
+
+	Буфер [count]src, составленный из секторов длины sector_len,
+	расшифровывается на ключе [len]key. Для расшифрования i-го сектора 
+	используется синхропосылка iv + i (см. beltSDEEncrSectors()).
+	Результат расшифрования размещается в буфере [count]dest.
+	\expect{ERR_BAD_INPUT}
+	-	len == 16 || len == 24 || len == 32;
+	-	sector_len % 16 == 0 && sector_len >= 32;
+	-	count % sector_len == 0 && count >= sector_len.
+	.
+	\return ERR_OK, если данные успешно расшифрованы, и код ошибки
+	в противном случае.
+	\remark Буферы могут пересекаться.
+*/
+err_t beltSDEDecrSectors(
+	void* dest,				/*!< [out] открытый текст */
+	const void* src,		/*!< [in] шифртекст */
+	size_t count,			/*!< [in] число октетов текста */
+	size_t sector_len,		/*!< [in] длина сектора */
+	const octet key[],		/*!< [in] ключ */
+	size_t len,				/*!< [in] длина ключа */
+	const octet iv[16]		/*!< [in] номер первого сектора */
+);
+
 /*
 *******************************************************************************
 Шифрование с сохранением формата (belt-fmt, FMT)
@@ -1565,6 +2365,11 @@ size_t beltFMT_keep(
 	\pre len == 16 || len == 24 || len == 32.
 	\pre По адресу state зарезервировано beltFMT_keep() октетов.
 	\remark Буферы key и state могут пересекаться.
+	\remark В state, кроме ключа, сохраняются величины, которые зависят
+	только от mod и count: число блоков для обработки половинок строк
+	и степень mod^k, используемая при переводе между системами счисления.
+	Поэтому одно состояние подходит для многократных вызовов
+	beltFMTStepE(), beltFMTStepD(), beltFMTStepEN(), beltFMTStepDN().
 */
 void beltFMTStart(
 	void* state,		/*!< [in,out] состояние */
@@ -1608,6 +2413,47 @@ void beltFMTStepD(
 	void* state				/*!< [in,out] состояние */
 );
 
+/*!	\brief Зашифрование нескольких строк в режиме FMT
+
+	Строки [count](buf + count * i), i = 0, 1,..., n - 1, зашифровываются
+	на ключе, размещенном в state, и синхропосылках [16](iv + 16 * i).
+	Здесь count -- длина строк, предварительно установленная в state функцией
+	beltFMTStart(). Результаты зашифрования сохраняются в buf.
+	\expect beltFMTStart() < beltFMTStepEN()*.
+	\expect Символы строк принадлежат алфавиту {0,1,..., mod - 1}.
+	\remark При нулевом указателе iv используются нулевые синхропосылки.
+	\remark Результат совпадает с результатом последовательных вызовов
+	beltFMTStepE(). Если половинки строк обрабатываются в одном или двух
+	блоках (например, при mod == 10 и count <= 38), то такты выполняются
+	одновременно для нескольких строк, а их блоки зашифровываются вместе
+	(см. beltBlockEncrN()).
+*/
+void beltFMTStepEN(
+	u16 buf[],				/*!< [in,out] открытые тексты / шифртексты */
+	size_t n,				/*!< [in] число строк */
+	const octet iv[],		/*!< [in] синхропосылки */
+	void* state				/*!< [in,out] состояние */
+);
+
+/*!	\brief Расшифрование нескольких строк в режиме FMT
+
+	Строки [count](buf + count * i), i = 0, 1,..., n - 1, расшифровываются
+	на ключе, размещенном в state, и синхропосылках [16](iv + 16 * i).
+	Здесь count -- длина строк, предварительно установленная в state функцией
+	beltFMTStart(). Результаты расшифрования сохраняются в buf.
+	\expect beltFMTStart() < beltFMTStepDN()*.
+	\expect Символы строк принадлежат алфавиту {0,1,..., mod - 1}.
+	\remark При нулевом указателе iv используются нулевые синхропосылки.
+	\remark Результат совпадает с результатом последовательных вызовов
+	beltFMTStepD().
+*/
+void beltFMTStepDN(
+	u16 buf[],				/*!< [in,out] шифртексты / открытые тексты */
+	size_t n,				/*!< [in] число строк */
+	const octet iv[],		/*!< [in] синхропосылки */
+	void* state				/*!< [in,out] состояние */
+);
+
 /*!	\brief Зашифрование в режиме FMT
 
 	Строка [count]src в алфавите {0, 1,..., mod - 1} зашифровывается на ключе 
@@ -1704,6 +2550,25 @@ void beltKRPStepG(
 	void* state				/*!< [in,out] состояние */
 );
 
+/*!	\brief Тиражирование ключа с несколькими заголовками
+
+	Ключ [len]key, размещенный в state функцией beltKRPStart(),
+	преобразуется в ключи [key_len]keys, [key_len](keys + key_len),...,
+	[key_len](keys + key_len * (n - 1)), которые имеют заголовки
+	[16]headers, [16](headers + 16),..., [16](headers + 16 * (n - 1)).
+	\pre (key_len == 16 || key_len == 24 || key_len == 32) && key_len <= len.
+	\expect beltKRPStart() < beltKRPStepGN()*.
+	\remark Ключи строятся одновременно по четыре. Результат совпадает
+	с результатом n вызовов beltKRPStepG().
+*/
+void beltKRPStepGN(
+	octet keys[],			/*!< [out] преобразованные ключи */
+	size_t key_len,			/*!< [in] длина каждого ключа в октетах */
+	const octet headers[],	/*!< [in] заголовки ключей */
+	size_t n,				/*!< [in] число ключей */
+	void* state				/*!< [in,out] состояние */
+);
+
 /*!	\brief Преобразование ключа
 
 	По ключу [n]src, который имеет уровень level, строится ключ [m]dest, 
@@ -1752,12 +2617,49 @@ void beltHMACStart(
 	size_t len				/*!< [in] длина ключа в октетах */
 );
 
+/*!	\brief Длина подготовленного ключа HMAC
+
+	Возвращается длина подготовленного ключа HMAC.
+	\return Длина ключа.
+*/
+size_t beltHMACKey_keep();
+
+/*!	\brief Подготовка ключа HMAC
+
+	По состоянию state, только что инициализированному функцией
+	beltHMACStart(), строится подготовленный ключ hkey.
+	\pre По адресу hkey зарезервировано beltHMACKey_keep() октетов.
+	\expect beltHMACStart() < beltHMACKeyPrepare().
+	\remark Подготовленный ключ содержит состояния хэширования после
+	обработки key ^ ipad и key ^ opad. Он позволяет многократно начинать
+	выработку имитовставок на одном ключе без повторной обработки ключа.
+*/
+void beltHMACKeyPrepare(
+	void* hkey,				/*!< [out] подготовленный ключ */
+	const void* state		/*!< [in] состояние */
+);
+
+/*!	\brief Инициализация режима HMAC на подготовленном ключе
+
+	По подготовленному ключу hkey в state формируются структуры данных, 
+	необходимые для имитозащиты в режиме HMAC.
+	\pre По адресу state зарезервировано beltHMAC_keep() октетов.
+	\expect beltHMACKeyPrepare() < beltHMACStartPrepared().
+	\remark Вызов beltHMACStartPrepared() эквивалентен вызову 
+	beltHMACStart() на ключе, по которому построен hkey, но выполняется 
+	значительно быстрее.
+*/
+void beltHMACStartPrepared(
+	void* state,			/*!< [out] состояние */
+	const void* hkey		/*!< [in] подготовленный ключ */
+);
+
 /*!	\brief Имитозащита фрагмента данных в режиме HMAC
 
 	Текущая имитовставка, размещенная в state, пересчитывается с учетом нового
 	фрагмента данных [count]buf. Пересчет выполняется на ключе,
 	также размещенном в state.
-	\expect beltHMACStart() < beltHMACStepA()*.
+	\expect (beltHMACStart() | beltHMACStartPrepared()) < beltHMACStepA()*.
 */
 void beltHMACStepA(
 	const void* buf,	/*!< [in] данные */
@@ -1765,6 +2667,22 @@ void beltHMACStepA(
 	void* state			/*!< [in,out] состояние */
 );
 
+/*!	\brief Имитозащита фрагментов данных в режиме HMAC
+
+	Текущая имитовставка, размещенная в state, пересчитывается с учетом
+	фрагментов данных [count[0]]buf[0],..., [count[n - 1]]buf[n - 1].
+	Фрагменты обрабатываются так, как если бы они были записаны подряд
+	в один буфер.
+	\expect (beltHMACStart() | beltHMACStartPrepared()) < beltHMACStepAV()*.
+	\remark Вызовы beltHMACStepA() и beltHMACStepAV() можно чередовать.
+*/
+void beltHMACStepAV(
+	const void* const buf[],	/*!< [in] фрагменты данных */
+	const size_t count[],		/*!< [in] длины фрагментов */
+	size_t n,					/*!< [in] число фрагментов */
+	void* state					/*!< [in,out] состояние */
+);
+
 /*!	\brief Определение имитовставки в режиме HMAC
 
 	Определяется окончательная имитовставка mac всех данных,
@@ -1823,6 +2741,7 @@ bool_t beltHMACStepV2(
 	\return ERR_OK, если имитовставка успешно вычислена, и код ошибки
 	в противном случае.
 	\remark Буферы могут пересекаться.
+	\remark Состояние размещается в памяти потока (см. stackCreate()).
 */
 err_t beltHMAC(
 	octet mac[32],			/*!< [out] имитовставка */
@@ -1860,6 +2779,60 @@ err_t beltPBKDF2(
 	size_t salt_len			/*!< [in] длина синхропосылки (в октетах) */
 );
 
+/*!	\brief Построение ключей по нескольким паролям
+
+	По паролям [pwd_lens[i]]pwds[i] и синхропосылкам [salt_lens[i]]salts[i]
+	строятся ключи [32]keys[32 * i], i = 0, 1,..., n - 1. Для построения 
+	каждого ключа выполняется iter итераций.
+	\expect{ERR_BAD_INPUT} iter > 0.
+	\return ERR_OK, если ключи успешно построены, и код ошибки в противном
+	случае.
+	\remark Результат совпадает с результатом последовательных вызовов
+	beltPBKDF2(keys + 32 * i, pwds[i], pwd_lens[i], iter, salts[i],
+	salt_lens[i]). Итерации для четверок паролей выполняются одновременно,
+	что ускоряет обработку.
+*/
+err_t beltPBKDF2MB(
+	octet keys[],				/*!< [out] ключи */
+	const octet* const pwds[],	/*!< [in] пароли */
+	const size_t pwd_lens[],	/*!< [in] длины паролей (в октетах) */
+	size_t iter,				/*!< [in] число итераций */
+	const octet* const salts[],	/*!< [in] синхропосылки ("соли") */
+	const size_t salt_lens[],	/*!< [in] длины синхропосылок (в октетах) */
+	size_t n					/*!< [in] число паролей */
+);
+
+/*!	\brief Запрос на построение ключа по паролю
+
+	Асинхронный запрос на построение ключа [32]key по паролю [pwd_len]pwd
+	и синхропосылке [salt_len]salt за iter итераций.
+*/
+typedef struct
+{
+	mt_req_t req;				/*!< заголовок запроса */
+	octet* key;					/*!< [out] ключ */
+	const octet* pwd;			/*!< [in] пароль */
+	size_t pwd_len;				/*!< [in] длина пароля (в октетах) */
+	size_t iter;				/*!< [in] число итераций */
+	const octet* salt;			/*!< [in] синхропосылка ("соль") */
+	size_t salt_len;			/*!< [in] длина синхропосылки (в октетах) */
+} belt_pbkdf2_req_t;
+
+/*!	\brief Асинхронное построение ключа по паролю
+
+	Запрос req ставится на выполнение в исполнитель as. Запросы
+	исполнителя на построение ключей объединяются в пакеты, в которых
+	ключи с одинаковым числом итераций строятся одновременно функцией
+	beltPBKDF2MB().
+	\pre В req->req задано поле done и, возможно, поле user.
+	\pre Буферы запроса остаются доступными до его завершения.
+	\remark Код завершения запроса req->req.code -- как у beltPBKDF2().
+*/
+void beltPBKDF2Async(
+	mt_async_t* as,				/*!< [in,out] исполнитель */
+	belt_pbkdf2_req_t* req		/*!< [in,out] запрос */
+);
+
 
 #ifdef __cplusplus
 } /* extern "C" */
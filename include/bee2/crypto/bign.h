@@ -4,7 +4,7 @@
 \brief STB 34.101.45 (bign): digital signature and key transport algorithms
 \project bee2 [cryptographic library]
 \created 2012.04.27
-\version 2023.09.25
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 #include "bee2/defs.h"
+#include "bee2/core/mt.h"
 
 /*!
 *******************************************************************************
@@ -94,6 +95,10 @@ err_t bignParamsStd(
 	Проверяется корректность долговременных параметров params.
 	\return ERR_OK, если параметры корректны, и код ошибки в противном случае.
 	\remark Реализован алгоритм 6.1.4.
+	\remark Стандартные параметры (см. bignParamsStd()) признаются
+	корректными без выполнения алгоритма. Остальные параметры после
+	успешной проверки запоминаются (по хэш-значениям) в общем для всех
+	потоков кэше, повторная проверка сводится к хэшированию и поиску в кэше.
 */
 err_t bignParamsVal(
 	const bign_params* params	/*!< [in] долговременные параметры */
@@ -280,6 +285,28 @@ err_t bignPubkeyVal(
 	const octet pubkey[]		/*!< [in] проверяемый ключ */
 );
 
+/*!	\brief Пакетная проверка открытых ключей
+
+	При долговременных параметрах params проверяется корректность
+	открытых ключей [l / 2]pubkey_i, размещенных подряд в массиве
+	[count * l / 2]pubkeys. Результат проверки pubkey_i возвращается
+	в codes[i] (если codes != 0).
+	\expect{ERR_BAD_PARAMS} Параметры params корректны.
+	\return ERR_OK, если все ключи корректны, ERR_BAD_PUBKEY, если
+	имеются некорректные ключи, и другой код ошибки, если проверка
+	не выполнялась (в этом случае codes не заполняется).
+	\remark Результаты проверок совпадают с результатами bignPubkeyVal().
+	\remark Эллиптическая кривая строится однократно для всего пакета,
+	точки проверяются функцией ecpIsOnABatch(). Функция предназначена
+	для загрузки хранилищ открытых ключей и сертификатов.
+*/
+err_t bignPubkeyValBatch(
+	err_t codes[],				/*!< [out] результаты проверок */
+	const bign_params* params,	/*!< [in] долговременные параметры */
+	size_t count,				/*!< [in] число ключей */
+	const octet pubkeys[]		/*!< [in] проверяемые ключи */
+);
+
 /*!	\brief Построение открытого ключа по личному
 
 	При долговременных параметрах params по личному ключу [l / 4]privkey
@@ -401,6 +428,64 @@ err_t bignVerify(
 	const octet pubkey[]		/*!< [in] открытый ключ */
 );
 
+/*!	\brief Пакетная проверка ЭЦП
+
+	Проверяются count подписей: i-я подпись [3 * l / 8]sig_i сообщения
+	с хэш-значением [l / 4]hash_i на открытом ключе [l / 2]pubkey_i. Подписи,
+	хэш-значения и открытые ключи последовательно записаны в массивы sigs,
+	hashes и pubkeys соответственно. При проверке используются долговременные
+	параметры params. Считается, что все хэш-значения получены с помощью
+	алгоритма с идентификатором [oid_len]oid_der, заданным DER-кодом.
+	Если bad != 0, то по адресу bad возвращается номер первой некорректной
+	подписи (count, если все подписи корректны).
+	\expect{ERR_BAD_PARAMS} Параметры params корректны.
+	\expect{ERR_BAD_OID} Идентификатор oid_der корректен.
+	\expect{ERR_BAD_PUBKEY} Открытые ключи pubkeys корректны.
+	\return ERR_OK, если все подписи корректны, и код ошибки проверки
+	первой некорректной подписи (как в bignVerify()) в противном случае.
+	\remark Описание кривой строится один раз для всех подписей.
+*/
+err_t bignVerifyBatch(
+	size_t* bad,				/*!< [out] номер некорректной подписи */
+	const bign_params* params,	/*!< [in] долговременные параметры */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	size_t count,				/*!< [in] число подписей */
+	const octet hashes[],		/*!< [in] хэш-значения */
+	const octet sigs[],			/*!< [in] подписи */
+	const octet pubkeys[]		/*!< [in] открытые ключи */
+);
+
+/*!	\brief Создание кэша открытых ключей
+
+	Создается общий для всех потоков кэш count открытых ключей, который
+	используется при проверке подписей в bignVerify(), bignVerifyWs(),
+	bignVerifyCtx(). В кэше хранятся открытые ключи стандартных кривых
+	вместе с заранее рассчитанными аффинными малыми кратными
+	соответствующих точек. Ключ попадает в кэш при первой проверке
+	подписи на нем, если точка ключа лежит на кривой. При переполнении
+	вытесняются ключи, которые дольше всего не использовались (LRU).
+	\expect{ERR_BAD_INPUT} count > 0.
+	\return ERR_OK, если кэш создан, и код ошибки в противном случае
+	(ERR_ALREADY_EXISTS, если кэш уже создан).
+	\remark Ячейки кэша распределены по полосам, каждая из которых
+	защищена своим мьютексом. Поэтому count округляется вверх до числа
+	полос (16).
+	\remark Ячейка кэша занимает около 2 Кб (64-битовая платформа).
+	\remark Результаты проверки подписей с кэшем и без кэша совпадают.
+*/
+err_t bignVerifyCacheCreate(
+	size_t count				/*!< [in] число ключей */
+);
+
+/*!	\brief Закрытие кэша открытых ключей
+
+	Закрывается кэш, созданный в bignVerifyCacheCreate().
+	\warning Функцию нельзя вызывать одновременно с функциями проверки
+	подписей в других потоках.
+*/
+void bignVerifyCacheClose();
+
 /*
 *******************************************************************************
 Транспорт ключа
@@ -592,6 +677,909 @@ err_t bignIdVerify(
 	const octet pubkey[]		/*!< [in] открытый ключ доверенной стороны */
 );
 
+/*!
+*******************************************************************************
+\file bign.h
+
+\section bign-ctx Контекст
+
+Каждая из функций bignSign(), bignVerify(), bignDH(), ... строит по
+долговременным параметрам описания базового поля и эллиптической кривой.
+При многократном использовании одних и тех же параметров описания можно
+построить один раз: сохранить в контексте (функция bignCtxStart())
+и передавать контекст функциям bignSignCtx(), bignVerifyCtx(), ...
+
+Контекст после создания не изменяется. Поэтому его можно одновременно
+использовать в нескольких потоках. Контекст содержит указатели на свои же
+внутренние данные и не может перемещаться в памяти.
+
+Функции с контекстом действуют так же, как одноименные функции
+с параметрами, и возвращают такие же коды ошибок. Если контекст
+не работоспособен, то возвращается код ERR_BAD_INPUT.
+*******************************************************************************
+*/
+
+/*!	\brief Длина контекста
+
+	Возвращается длина контекста, создаваемого по долговременным параметрам
+	с уровнем стойкости l.
+	\pre l == 128 || l == 192 || l == 256.
+	\return Длина контекста.
+*/
+size_t bignCtx_keep(
+	size_t l					/*!< [in] уровень стойкости */
+);
+
+/*!	\brief Создание контекста
+
+	По долговременным параметрам params по адресу ctx создается контекст.
+	\pre По адресу ctx зарезервировано bignCtx_keep(params->l) октетов.
+	\expect{ERR_BAD_PARAMS} Параметры params корректны.
+	\return ERR_OK, если контекст создан, и код ошибки в противном случае.
+	\remark Параметры params не проверяются так полно, как в
+	bignParamsVal(). Их рекомендуется проверить предварительно.
+*/
+err_t bignCtxStart(
+	void* ctx,					/*!< [out] контекст */
+	const bign_params* params	/*!< [in] долговременные параметры */
+);
+
+/*!	\brief Копирование контекста
+
+	Контекст src копируется по адресу dest. При копировании настраиваются
+	внутренние указатели контекста.
+	\pre Контекст src создан функцией bignCtxStart().
+	\pre По адресу dest зарезервировано bignCtx_keep(l) октетов, где l --
+	уровень стойкости параметров контекста src.
+	\remark Функцию можно передавать в mtRepCreate() для тиражирования
+	контекста по узлам NUMA.
+*/
+void bignCtxCopy(
+	void* dest,					/*!< [out] копия контекста */
+	const void* src				/*!< [in] контекст */
+);
+
+/*!	\brief Выработка ЭЦП с контекстом
+
+	Аналог bignSign() с долговременными параметрами из контекста ctx.
+*/
+err_t bignSignCtx(
+	octet sig[],				/*!< [out] подпись */
+	const void* ctx,			/*!< [in] контекст */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	const octet hash[],			/*!< [in] хэш-значение */
+	const octet privkey[],		/*!< [in] личный ключ */
+	gen_i rng,					/*!< [in] генератор случайных чисел */
+	void* rng_state				/*!< [in,out] состояние генератора */
+);
+
+/*!	\brief Детерминированная выработка ЭЦП с контекстом
+
+	Аналог bignSign2() с долговременными параметрами из контекста ctx.
+*/
+err_t bignSign2Ctx(
+	octet sig[],				/*!< [out] подпись */
+	const void* ctx,			/*!< [in] контекст */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	const octet hash[],			/*!< [in] хэш-значение */
+	const octet privkey[],		/*!< [in] личный ключ */
+	const void* t,				/*!< [in] дополнительные данные */
+	size_t t_len				/*!< [in] размер дополнительных данных */
+);
+
+/*!	\brief Проверка ЭЦП с контекстом
+
+	Аналог bignVerify() с долговременными параметрами из контекста ctx.
+*/
+err_t bignVerifyCtx(
+	const void* ctx,			/*!< [in] контекст */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	const octet hash[],			/*!< [in] хэш-значение */
+	const octet sig[],			/*!< [in] подпись */
+	const octet pubkey[]		/*!< [in] открытый ключ */
+);
+
+/*!	\brief Построение общего ключа с контекстом
+
+	Аналог bignDH() с долговременными параметрами из контекста ctx.
+*/
+err_t bignDHCtx(
+	octet key[],				/*!< [out] общий ключ */
+	const void* ctx,			/*!< [in] контекст */
+	const octet privkey[],		/*!< [in] личный ключ */
+	const octet pubkey[],		/*!< [in] открытый ключ */
+	size_t key_len				/*!< [in] длина общего ключа */
+);
+
+/*!	\brief Создание токена с контекстом
+
+	Аналог bignKeyWrap() с долговременными параметрами из контекста ctx.
+*/
+err_t bignKeyWrapCtx(
+	octet token[],				/*!< [out] токен ключа */
+	const void* ctx,			/*!< [in] контекст */
+	const octet key[],			/*!< [in] транспортируемый ключ */
+	size_t len,					/*!< [in] длина ключа в октетах */
+	const octet header[16],		/*!< [in] заголовок ключа */
+	const octet pubkey[],		/*!< [in] открытый ключ получателя */
+	gen_i rng,					/*!< [in] генератор случайных чисел */
+	void* rng_state				/*!< [in,out] состояние генератора */
+);
+
+/*!	\brief Пакетное создание токенов
+
+	Ключ [len]key с заголовком header транспортируется count получателям
+	с открытыми ключами из массива pubkeys: в tokens записываются count
+	токенов длины 16 + no + len, где no -- длина открытого ключа
+	(в октетах), деленная на 2. Токен для i-го получателя совпадает
+	с токеном, который был бы построен bignKeyWrapCtx() при i-м из count
+	последовательных вызовов с генератором rng.
+	\expect{ERR_BAD_INPUT} Контекст ctx работоспособен, буферы key
+	и header не пересекаются с tokens.
+	\return ERR_OK, если токены созданы, и код ошибки в противном случае.
+	Если создать токен для какого-либо получателя не удалось, то
+	возвращается код ошибки первого такого получателя.
+	\remark Кратные открытых ключей и базовой точки вычисляются в задачах
+	пула потоков pool (по одной задаче на получателя). Если pool == 0, то
+	вычисления выполняются в вызывающем потоке.
+	\pre Функция не вызывается из задач пула pool.
+*/
+err_t bignKeyWrapBatch(
+	octet tokens[],				/*!< [out] токены ключа */
+	const void* ctx,			/*!< [in] контекст */
+	const octet key[],			/*!< [in] транспортируемый ключ */
+	size_t len,					/*!< [in] длина ключа в октетах */
+	const octet header[16],		/*!< [in] заголовок ключа */
+	size_t count,				/*!< [in] число получателей */
+	const octet pubkeys[],		/*!< [in] открытые ключи получателей */
+	gen_i rng,					/*!< [in] генератор случайных чисел */
+	void* rng_state,			/*!< [in,out] состояние генератора */
+	mt_pool_t* pool				/*!< [in,out] пул потоков */
+);
+
+/*!	\brief Разбор токена с контекстом
+
+	Аналог bignKeyUnwrap() с долговременными параметрами из контекста ctx.
+*/
+err_t bignKeyUnwrapCtx(
+	octet key[],				/*!< [out] ключ */
+	const void* ctx,			/*!< [in] контекст */
+	const octet token[],		/*!< [in] токен ключа */
+	size_t len,					/*!< [in] длина токена в октетах */
+	const octet header[16],		/*!< [in] заголовок ключа */
+	const octet privkey[]		/*!< [in] личный ключ получателя */
+);
+
+/*!
+*******************************************************************************
+\file bign.h
+
+\section bign-ws Рабочая память
+
+Функции с контекстом создают рабочую память (стек) с помощью stackCreate()
+и освобождают ее перед возвратом. Функциям bignSignWs(), bignVerifyWs(), ... рабочая
+память ws передается вызывающей программой. Длина рабочей памяти
+определяется функцией bignWs_keep() и пригодна для любой из функций.
+
+Для стандартных кривых кратные базовой точки рассчитываются по таблицам,
+которые строятся однократно. После построения таблиц функции с рабочей
+памятью не обращаются к куче.
+
+Рабочую память нельзя одновременно использовать в нескольких потоках.
+Если контекст не работоспособен или рабочая память недостаточной длины,
+то возвращается код ERR_BAD_INPUT.
+
+\warning В рабочей памяти остаются промежуточные данные, в том числе
+производные от личного ключа. Перед освобождением рабочую память
+следует очистить (memWipe()).
+*******************************************************************************
+*/
+
+/*!	\brief Длина рабочей памяти
+
+	Возвращается длина рабочей памяти для функций с контекстом ctx.
+	\pre Контекст ctx работоспособен.
+	\return Длина рабочей памяти.
+*/
+size_t bignWs_keep(
+	const void* ctx				/*!< [in] контекст */
+);
+
+/*!	\brief Выработка ЭЦП с рабочей памятью
+
+	Аналог bignSignCtx() с рабочей памятью ws.
+	\pre По адресу ws зарезервировано bignWs_keep(ctx) октетов.
+*/
+err_t bignSignWs(
+	octet sig[],				/*!< [out] подпись */
+	const void* ctx,			/*!< [in] контекст */
+	void* ws,					/*!< [in,out] рабочая память */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	const octet hash[],			/*!< [in] хэш-значение */
+	const octet privkey[],		/*!< [in] личный ключ */
+	gen_i rng,					/*!< [in] генератор случайных чисел */
+	void* rng_state				/*!< [in,out] состояние генератора */
+);
+
+/*!	\brief Детерминированная выработка ЭЦП с рабочей памятью
+
+	Аналог bignSign2Ctx() с рабочей памятью ws.
+	\pre По адресу ws зарезервировано bignWs_keep(ctx) октетов.
+*/
+err_t bignSign2Ws(
+	octet sig[],				/*!< [out] подпись */
+	const void* ctx,			/*!< [in] контекст */
+	void* ws,					/*!< [in,out] рабочая память */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	const octet hash[],			/*!< [in] хэш-значение */
+	const octet privkey[],		/*!< [in] личный ключ */
+	const void* t,				/*!< [in] дополнительные данные */
+	size_t t_len				/*!< [in] размер дополнительных данных */
+);
+
+/*!	\brief Проверка ЭЦП с рабочей памятью
+
+	Аналог bignVerifyCtx() с рабочей памятью ws.
+	\pre По адресу ws зарезервировано bignWs_keep(ctx) октетов.
+*/
+err_t bignVerifyWs(
+	const void* ctx,			/*!< [in] контекст */
+	void* ws,					/*!< [in,out] рабочая память */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	const octet hash[],			/*!< [in] хэш-значение */
+	const octet sig[],			/*!< [in] подпись */
+	const octet pubkey[]		/*!< [in] открытый ключ */
+);
+
+/*!	\brief Построение общего ключа с рабочей памятью
+
+	Аналог bignDHCtx() с рабочей памятью ws.
+	\pre По адресу ws зарезервировано bignWs_keep(ctx) октетов.
+*/
+err_t bignDHWs(
+	octet key[],				/*!< [out] общий ключ */
+	const void* ctx,			/*!< [in] контекст */
+	void* ws,					/*!< [in,out] рабочая память */
+	const octet privkey[],		/*!< [in] личный ключ */
+	const octet pubkey[],		/*!< [in] открытый ключ */
+	size_t key_len				/*!< [in] длина общего ключа */
+);
+
+/*!	\brief Создание токена с рабочей памятью
+
+	Аналог bignKeyWrapCtx() с рабочей памятью ws.
+	\pre По адресу ws зарезервировано bignWs_keep(ctx) октетов.
+*/
+err_t bignKeyWrapWs(
+	octet token[],				/*!< [out] токен ключа */
+	const void* ctx,			/*!< [in] контекст */
+	void* ws,					/*!< [in,out] рабочая память */
+	const octet key[],			/*!< [in] транспортируемый ключ */
+	size_t len,					/*!< [in] длина ключа в октетах */
+	const octet header[16],		/*!< [in] заголовок ключа */
+	const octet pubkey[],		/*!< [in] открытый ключ получателя */
+	gen_i rng,					/*!< [in] генератор случайных чисел */
+	void* rng_state				/*!< [in,out] состояние генератора */
+);
+
+/*!	\brief Разбор токена с рабочей памятью
+
+	Аналог bignKeyUnwrapCtx() с рабочей памятью ws.
+	\pre По адресу ws зарезервировано bignWs_keep(ctx) октетов.
+*/
+err_t bignKeyUnwrapWs(
+	octet key[],				/*!< [out] ключ */
+	const void* ctx,			/*!< [in] контекст */
+	void* ws,					/*!< [in,out] рабочая память */
+	const octet token[],		/*!< [in] токен ключа */
+	size_t len,					/*!< [in] длина токена в октетах */
+	const octet header[16],		/*!< [in] заголовок ключа */
+	const octet privkey[]		/*!< [in] личный ключ получателя */
+);
+
+/*!
+*******************************************************************************
+\file bign.h
+
+\section bign-det Подготовленная детерминированная ЭЦП
+
+При детерминированной выработке ЭЦП (bignSign2()) одноразовый личный ключ
+строится с помощью belt-wbl на ключе theta = belt-hash(oid || d || t).
+Ключ theta и состояние хэширования oid не зависят от подписываемого
+хэш-значения. При многократной выработке подписей на одном личном ключе
+их можно подготовить один раз (функция bignDetStart()) и передавать
+подготовленное состояние функции bignSignDet().
+
+Состояние после создания не изменяется и может одновременно
+использоваться в нескольких потоках. Контекст bign, по которому
+создано состояние, должен оставаться доступным.
+
+\warning Состояние содержит личный ключ и производный от него ключ
+theta. После использования состояние следует очистить (memWipe()).
+*******************************************************************************
+*/
+
+/*!	\brief Длина состояния детерминированной ЭЦП
+
+	Возвращается длина состояния (в октетах) подготовленной
+	детерминированной выработки ЭЦП.
+	\return Длина состояния.
+*/
+size_t bignDet_keep();
+
+/*!	\brief Подготовка детерминированной ЭЦП
+
+	По адресу det создается состояние выработки подписей с долговременными
+	параметрами контекста ctx, идентификатором хэш-алгоритма oid_der,
+	личным ключом privkey и дополнительными данными [t_len]t.
+	\pre По адресу det зарезервировано bignDet_keep() октетов.
+	\expect{ERR_BAD_INPUT} Контекст ctx работоспособен.
+	\expect{ERR_BAD_OID} oid_der является корректной DER-кодировкой.
+	\expect{ERR_BAD_PRIVKEY} Личный ключ privkey корректен.
+	\return ERR_OK, если состояние создано, и код ошибки в противном
+	случае.
+*/
+err_t bignDetStart(
+	void* det,					/*!< [out] состояние */
+	const void* ctx,			/*!< [in] контекст */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	const octet privkey[],		/*!< [in] личный ключ */
+	const void* t,				/*!< [in] дополнительные данные */
+	size_t t_len				/*!< [in] размер дополнительных данных */
+);
+
+/*!	\brief Детерминированная выработка ЭЦП с подготовленным состоянием
+
+	Вырабатывается подпись sig хэш-значения hash. Подпись совпадает
+	с подписью bignSign2() с параметрами, идентификатором, личным ключом
+	и дополнительными данными, заданными в bignDetStart().
+	\pre Состояние det создано функцией bignDetStart().
+	\expect{ERR_BAD_INPUT} Состояние det работоспособно.
+	\return ERR_OK, если подпись выработана, и код ошибки в противном
+	случае.
+*/
+err_t bignSignDet(
+	octet sig[],				/*!< [out] подпись */
+	const void* det,			/*!< [in] состояние */
+	const octet hash[]			/*!< [in] хэш-значение */
+);
+
+/*!
+*******************************************************************************
+\file bign.h
+
+\section bign-ibs-ctx Подготовленная идентификационная ЭЦП
+
+Подписант, который многократно вырабатывает идентификационные подписи
+на одном личном ключе, может один раз подготовить состояние
+(функция bignIdPrivStart()) и передавать его функции bignIdSignPriv().
+В состоянии сохраняются личный ключ, хэш-значение идентификатора
+и результат хэширования идентификатора хэш-алгоритма.
+
+Проверяющий, который многократно проверяет подписи сторон, ключи
+которых извлечены с помощью одной доверенной стороны, может один раз
+подготовить состояние с открытым ключом доверенной стороны (функция
+bignIdPubStart()) и передавать его функциям bignIdVerifyPub()
+и bignIdVerifyBatch(). В состоянии сохраняется таблица кратных открытого
+ключа доверенной стороны (гребенчатый метод), которая ускоряет проверку.
+
+Состояния создаются по контексту bign (см. bignCtxStart()), который
+должен оставаться доступным. Состояния после создания не изменяются и
+могут одновременно использоваться в нескольких потоках. Состояния
+содержат указатели на контекст и не могут перемещаться в памяти.
+
+\warning Состояние подписанта содержит личный ключ. После использования
+его следует очистить (memWipe()).
+*******************************************************************************
+*/
+
+/*!	\brief Длина состояния подписанта
+
+	Возвращается длина состояния (в октетах) подписанта.
+	\return Длина состояния.
+*/
+size_t bignIdPriv_keep();
+
+/*!	\brief Подготовка состояния подписанта
+
+	По адресу priv создается состояние подписанта с личным ключом
+	[l / 4]id_privkey и хэш-значением идентификатора [l / 4]id_hash.
+	Используются долговременные параметры контекста ctx. Считается, что
+	хэш-значения получены с помощью алгоритма с идентификатором
+	[oid_len]oid_der, заданным DER-кодом.
+	\pre По адресу priv зарезервировано bignIdPriv_keep() октетов.
+	\expect{ERR_BAD_INPUT} Контекст ctx работоспособен.
+	\expect{ERR_BAD_OID} Идентификатор oid_der корректен.
+	\expect{ERR_BAD_PRIVKEY} Ключ id_privkey получен с помощью функции
+	bignIdExtract().
+	\return ERR_OK, если состояние создано, и код ошибки в противном
+	случае.
+*/
+err_t bignIdPrivStart(
+	void* priv,					/*!< [out] состояние подписанта */
+	const void* ctx,			/*!< [in] контекст */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	const octet id_hash[],		/*!< [in] хэш-значение идентификатора */
+	const octet id_privkey[]	/*!< [in] личный ключ */
+);
+
+/*!	\brief Выработка идентификационной ЭЦП с состоянием подписанта
+
+	Аналог bignIdSign() с параметрами, идентификатором хэш-алгоритма,
+	хэш-значением идентификатора и личным ключом из состояния priv.
+	\pre Состояние priv создано функцией bignIdPrivStart().
+	\expect{ERR_BAD_INPUT} Состояние priv работоспособно.
+*/
+err_t bignIdSignPriv(
+	octet id_sig[],				/*!< [out] идентификационная подпись */
+	const void* priv,			/*!< [in] состояние подписанта */
+	const octet hash[],			/*!< [in] хэш-значение сообщения */
+	gen_i rng,					/*!< [in] генератор случайных чисел */
+	void* rng_state				/*!< [in,out] состояние генератора */
+);
+
+/*!	\brief Длина состояния проверяющего
+
+	Возвращается длина состояния (в октетах) проверяющего для уровня
+	стойкости l.
+	\pre l == 128 || l == 192 || l == 256.
+	\return Длина состояния.
+*/
+size_t bignIdPub_keep(
+	size_t l					/*!< [in] уровень стойкости */
+);
+
+/*!	\brief Подготовка состояния проверяющего
+
+	По адресу pub создается состояние проверяющего с открытым ключом
+	[l / 2]pubkey доверенной стороны. Используются долговременные параметры
+	контекста ctx. Считается, что хэш-значения будут получены с помощью
+	алгоритма с идентификатором [oid_len]oid_der, заданным DER-кодом.
+	\pre По адресу pub зарезервировано bignIdPub_keep(l) октетов, где
+	l -- уровень стойкости параметров ctx.
+	\expect{ERR_BAD_INPUT} Контекст ctx работоспособен.
+	\expect{ERR_BAD_OID} Идентификатор oid_der корректен.
+	\expect{ERR_BAD_PUBKEY} Открытый ключ pubkey корректен.
+	\return ERR_OK, если состояние создано, и код ошибки в противном
+	случае.
+	\remark В отличие от bignIdVerify() проверяется, что pubkey лежит
+	на кривой.
+*/
+err_t bignIdPubStart(
+	void* pub,					/*!< [out] состояние проверяющего */
+	const void* ctx,			/*!< [in] контекст */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	const octet pubkey[]		/*!< [in] открытый ключ доверенной стороны */
+);
+
+/*!	\brief Проверка идентификационной ЭЦП с состоянием проверяющего
+
+	Аналог bignIdVerify() с параметрами, идентификатором хэш-алгоритма и
+	открытым ключом доверенной стороны из состояния pub.
+	\pre Состояние pub создано функцией bignIdPubStart().
+	\expect{ERR_BAD_INPUT} Состояние pub работоспособно.
+*/
+err_t bignIdVerifyPub(
+	const void* pub,			/*!< [in] состояние проверяющего */
+	const octet id_hash[],		/*!< [in] хэш-значение идентификатора */
+	const octet hash[],			/*!< [in] хэш-значение сообщения */
+	const octet id_sig[],		/*!< [in] подпись */
+	const octet id_pubkey[]		/*!< [in] открытый ключ */
+);
+
+/*!	\brief Пакетная проверка идентификационной ЭЦП
+
+	Проверяются count идентификационных подписей: i-я подпись
+	[3 * l / 8]id_sig_i сообщения с хэш-значением [l / 4]hash_i,
+	выработанная стороной с хэш-значением идентификатора [l / 4]id_hash_i
+	и открытым ключом [l / 2]id_pubkey_i. Хэш-значения идентификаторов,
+	хэш-значения сообщений, подписи и открытые ключи последовательно
+	записаны в массивы id_hashes, hashes, id_sigs и id_pubkeys
+	соответственно. Используется состояние проверяющего pub. Если
+	bad != 0, то по адресу bad возвращается номер первой некорректной
+	подписи (count, если все подписи корректны).
+	\pre Состояние pub создано функцией bignIdPubStart().
+	\expect{ERR_BAD_INPUT} Состояние pub работоспособно.
+	\return ERR_OK, если все подписи корректны, и код ошибки проверки
+	первой некорректной подписи (как в bignIdVerify()) в противном случае.
+*/
+err_t bignIdVerifyBatch(
+	size_t* bad,				/*!< [out] номер некорректной подписи */
+	const void* pub,			/*!< [in] состояние проверяющего */
+	size_t count,				/*!< [in] число подписей */
+	const octet id_hashes[],	/*!< [in] хэш-значения идентификаторов */
+	const octet hashes[],		/*!< [in] хэш-значения сообщений */
+	const octet id_sigs[],		/*!< [in] подписи */
+	const octet id_pubkeys[]	/*!< [in] открытые ключи */
+);
+
+/*!
+*******************************************************************************
+\file bign.h
+
+\section bign-eph Пул одноразовых ключей
+
+При выработке ЭЦП (и в протоколах bake) строится одноразовый личный ключ k
+и кратная точка k G. Пару (k, k G) можно построить заранее, например,
+в периоды простоя, и сохранить в пуле. Функция bignSignEph() и аналогичные
+функции bake берут пару из пула, что исключает вычисление кратной точки
+из времени выполнения запроса.
+
+Пул создается функцией bignEphStart() по контексту bign. Пул пополняется
+функцией bignEphFill() или функцией bignEphFillTask(), которую можно
+передать в пул потоков (см. mtPoolSubmit()). Все функции пула
+потокобезопасны. Пары выдаются не более одного раза и стираются из пула
+при выдаче. Если пул пуст, то пара строится на месте.
+
+Генератор пула используется, в том числе, при пополнении пула в других
+потоках. Поэтому он должен быть потокобезопасным (например, rngStepR()).
+Контекст bign должен оставаться доступным, пока используется пул.
+
+Пул, унаследованный дочерним процессом после fork(), очищается при первом
+обращении к нему в дочернем процессе: пары родительского процесса
+не выдаются. Вызывать fork() во время пополнения пула в других потоках
+нельзя (мьютекс пула может остаться заблокированным).
+
+\warning Пул содержит одноразовые личные ключи. После использования пул
+следует закрыть функцией bignEphClose().
+*******************************************************************************
+*/
+
+/*!	\brief Длина пула одноразовых ключей
+
+	Возвращается длина пула (в октетах) из count пар для уровня
+	стойкости l.
+	\pre l == 128 || l == 192 || l == 256.
+	\return Длина пула.
+*/
+size_t bignEph_keep(
+	size_t l,					/*!< [in] уровень стойкости */
+	size_t count				/*!< [in] число пар */
+);
+
+/*!	\brief Создание пула одноразовых ключей
+
+	По адресу eph создается пустой пул из count пар для кривой
+	из контекста ctx. Пары будут строиться с помощью генератора rng
+	с состоянием rng_state.
+	\pre По адресу eph зарезервировано bignEph_keep(l, count) октетов,
+	где l -- уровень стойкости параметров ctx.
+	\expect{ERR_BAD_INPUT} Контекст ctx работоспособен, count > 0.
+	\expect{ERR_BAD_RNG} rng != 0.
+	\expect Генератор rng является криптографически стойким
+	и потокобезопасным.
+	\return ERR_OK, если пул создан, и код ошибки в противном случае.
+*/
+err_t bignEphStart(
+	void* eph,					/*!< [out] пул */
+	const void* ctx,			/*!< [in] контекст */
+	size_t count,				/*!< [in] число пар */
+	gen_i rng,					/*!< [in] генератор случайных чисел */
+	void* rng_state				/*!< [in,out] состояние генератора */
+);
+
+/*!	\brief Пополнение пула одноразовых ключей
+
+	В пул eph добавляется не более max пар.
+	\pre Пул eph создан функцией bignEphStart().
+	\return Число добавленных пар.
+	\remark Функция может одновременно вызываться в нескольких потоках.
+*/
+size_t bignEphFill(
+	void* eph,					/*!< [in,out] пул */
+	size_t max					/*!< [in] максимальное число пар */
+);
+
+/*!	\brief Задача пополнения пула одноразовых ключей
+
+	Пул eph заполняется полностью. Функция удовлетворяет интерфейсу
+	mt_task_i и предназначена для передачи в mtPoolSubmit().
+	\pre Пул eph создан функцией bignEphStart().
+*/
+void bignEphFillTask(
+	void* eph,					/*!< [in,out] пул */
+	void* scratch				/*!< [in] не используется */
+);
+
+/*!	\brief Число готовых пар
+
+	Определяется число пар, которые находятся в пуле eph.
+	\pre Пул eph создан функцией bignEphStart().
+	\return Число готовых пар.
+*/
+size_t bignEphReady(
+	void* eph					/*!< [in] пул */
+);
+
+/*!	\brief Закрытие пула одноразовых ключей
+
+	Пул eph закрывается, его пары стираются.
+	\pre Пул eph создан функцией bignEphStart().
+	\pre Пул не используется в других потоках.
+*/
+void bignEphClose(
+	void* eph					/*!< [in,out] пул */
+);
+
+/*!	\brief Выработка ЭЦП с пулом одноразовых ключей
+
+	Аналог bignSignCtx(), в котором одноразовый личный ключ и кратная точка
+	берутся из пула eph. Используются долговременные параметры контекста
+	пула.
+	\pre Пул eph создан функцией bignEphStart().
+	\expect{ERR_BAD_INPUT} Пул eph работоспособен.
+*/
+err_t bignSignEph(
+	octet sig[],				/*!< [out] подпись */
+	void* eph,					/*!< [in,out] пул */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	const octet hash[],			/*!< [in] хэш-значение */
+	const octet privkey[]		/*!< [in] личный ключ */
+);
+
+/*!
+*******************************************************************************
+\file bign.h
+
+\section bign-sq Пакетная выработка ЭЦП
+
+При выработке ЭЦП точка R = k G переводится в аффинные координаты, что
+требует обращения в базовом поле, а затем хэшируется вместе с oid
+и хэш-значением. Функция bignSignBatch() вырабатывает сразу несколько
+подписей: точки R вычисляются в проективных координатах и переводятся
+в аффинные координаты вместе (одно обращение на группу подписей),
+а хэш-значения вычисляются одновременно в beltHashMB().
+
+Очередь выработки ЭЦП накапливает отдельные запросы и передает их
+функции bignSignBatch(), когда число запросов достигает заданного
+максимума либо когда истекает максимальная задержка первого запроса.
+Задержка проверяется при постановке запросов в очередь (функция
+bignSignQueueAdd()) и при опросе очереди (функция bignSignQueuePoll()).
+Очередь не является потокобезопасной. Контекст bign и идентификатор
+хэш-алгоритма должны оставаться доступными, пока используется очередь.
+
+\warning Очередь содержит копии личных ключей ожидающих запросов.
+После использования очередь следует закрыть функцией bignSignQueueClose().
+*******************************************************************************
+*/
+
+/*!	\brief Пакетная выработка ЭЦП
+
+	Вырабатываются count подписей: i-я подпись [3 * l / 8]sig_i хэш-значения
+	[l / 4]hash_i на личном ключе [l / 4]privkey_i. Подписи, хэш-значения
+	и личные ключи последовательно записаны в массивы sigs, hashes
+	и privkeys соответственно. Используются долговременные параметры
+	контекста ctx. Считается, что все хэш-значения получены с помощью
+	алгоритма с идентификатором [oid_len]oid_der, заданным DER-кодом.
+	Если codes != 0, то в codes[i] возвращается код выработки i-й
+	подписи.
+	\expect{ERR_BAD_INPUT} Контекст ctx работоспособен, буферы hashes
+	и sigs не пересекаются.
+	\expect{ERR_BAD_OID} Идентификатор oid_der корректен.
+	\expect{ERR_BAD_RNG} Генератор rng (с состоянием rng_state) корректен.
+	\expect{ERR_BAD_PRIVKEY} Личные ключи privkeys корректны.
+	\return ERR_OK, если все подписи выработаны, и код ошибки первой
+	невыработанной подписи в противном случае. При ошибках проверки
+	входных данных массив codes не изменяется.
+	\remark Подписи совпадают с подписями, которые были бы выработаны
+	bignSignCtx() при count последовательных вызовах с генератором rng.
+*/
+err_t bignSignBatch(
+	err_t codes[],				/*!< [out] коды выработки подписей */
+	octet sigs[],				/*!< [out] подписи */
+	const void* ctx,			/*!< [in] контекст */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	size_t count,				/*!< [in] число подписей */
+	const octet hashes[],		/*!< [in] хэш-значения */
+	const octet privkeys[],		/*!< [in] личные ключи */
+	gen_i rng,					/*!< [in] генератор случайных чисел */
+	void* rng_state				/*!< [in,out] состояние генератора */
+);
+
+/*!	\brief Длина очереди выработки ЭЦП
+
+	Возвращается длина очереди (в октетах) из max запросов для уровня
+	стойкости l.
+	\pre l == 128 || l == 192 || l == 256.
+	\return Длина очереди.
+*/
+size_t bignSignQueue_keep(
+	size_t l,					/*!< [in] уровень стойкости */
+	size_t max					/*!< [in] максимальное число запросов */
+);
+
+/*!	\brief Создание очереди выработки ЭЦП
+
+	По адресу queue создается пустая очередь из не более чем max запросов
+	на выработку ЭЦП с долговременными параметрами контекста ctx
+	и идентификатором хэш-алгоритма [oid_len]oid_der. Очередь
+	обрабатывается, когда в ней накапливается max запросов либо когда
+	с момента постановки первого запроса проходит не менее delay_ms
+	миллисекунд. Подписи вырабатываются с помощью генератора rng
+	с состоянием rng_state.
+	\pre По адресу queue зарезервировано bignSignQueue_keep(l, max)
+	октетов, где l -- уровень стойкости параметров ctx.
+	\expect{ERR_BAD_INPUT} Контекст ctx работоспособен, max > 0.
+	\expect{ERR_BAD_OID} Идентификатор oid_der корректен.
+	\expect{ERR_BAD_RNG} rng != 0.
+	\return ERR_OK, если очередь создана, и код ошибки в противном случае.
+	\remark При delay_ms == 0 очередь обрабатывается при постановке
+	каждого запроса.
+*/
+err_t bignSignQueueStart(
+	void* queue,				/*!< [out] очередь */
+	const void* ctx,			/*!< [in] контекст */
+	const octet oid_der[],		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len,				/*!< [in] длина oid_der в октетах */
+	size_t max,					/*!< [in] максимальное число запросов */
+	size_t delay_ms,			/*!< [in] максимальная задержка */
+	gen_i rng,					/*!< [in] генератор случайных чисел */
+	void* rng_state				/*!< [in,out] состояние генератора */
+);
+
+/*!	\brief Постановка запроса в очередь выработки ЭЦП
+
+	В очередь queue ставится запрос на выработку подписи sig хэш-значения
+	hash на личном ключе privkey. Хэш-значение и личный ключ копируются
+	в очередь. Подпись будет записана по адресу sig, а код ее выработки
+	(как в bignSignBatch()) -- по адресу code (если code != 0) при
+	обработке очереди. Если после постановки запроса число запросов
+	достигает максимума или истекает максимальная задержка, то очередь
+	обрабатывается.
+	\pre Очередь queue создана функцией bignSignQueueStart().
+	\pre Буферы sig и code остаются доступными до обработки очереди.
+	\expect{ERR_BAD_INPUT} Буферы hash, privkey, sig и code корректны.
+	\return ERR_OK, если запрос поставлен в очередь и, если очередь
+	обрабатывалась, все ее подписи выработаны, и код ошибки
+	в противном случае.
+*/
+err_t bignSignQueueAdd(
+	void* queue,				/*!< [in,out] очередь */
+	octet sig[],				/*!< [out] подпись */
+	err_t* code,				/*!< [out] код выработки подписи */
+	const octet hash[],			/*!< [in] хэш-значение */
+	const octet privkey[]		/*!< [in] личный ключ */
+);
+
+/*!	\brief Опрос очереди выработки ЭЦП
+
+	Очередь queue обрабатывается, если истекла максимальная задержка
+	ее первого запроса.
+	\pre Очередь queue создана функцией bignSignQueueStart().
+	\return ERR_OK, если очередь не обрабатывалась или все ее подписи
+	выработаны, и код ошибки первой невыработанной подписи в противном
+	случае.
+*/
+err_t bignSignQueuePoll(
+	void* queue					/*!< [in,out] очередь */
+);
+
+/*!	\brief Обработка очереди выработки ЭЦП
+
+	Очередь queue обрабатывается независимо от числа запросов
+	и задержки.
+	\pre Очередь queue создана функцией bignSignQueueStart().
+	\return ERR_OK, если все подписи очереди выработаны, и код ошибки
+	первой невыработанной подписи в противном случае.
+*/
+err_t bignSignQueueFlush(
+	void* queue					/*!< [in,out] очередь */
+);
+
+/*!	\brief Число ожидающих запросов
+
+	Определяется число запросов, которые находятся в очереди queue.
+	\pre Очередь queue создана функцией bignSignQueueStart().
+	\return Число запросов.
+*/
+size_t bignSignQueuePending(
+	const void* queue			/*!< [in] очередь */
+);
+
+/*!	\brief Закрытие очереди выработки ЭЦП
+
+	Очередь queue закрывается, ожидающие запросы отбрасываются, копии
+	личных ключей стираются.
+	\pre Очередь queue создана функцией bignSignQueueStart().
+	\remark Чтобы выполнить ожидающие запросы, перед закрытием следует
+	вызвать bignSignQueueFlush().
+*/
+void bignSignQueueClose(
+	void* queue					/*!< [in,out] очередь */
+);
+
+/*!
+*******************************************************************************
+\file bign.h
+
+\section bign-async Асинхронная обработка
+
+Запросы на проверку и выработку ЭЦП ставятся в асинхронный исполнитель
+(см. mtAsyncCreate()) и выполняются в пуле потоков. Запросы проверки
+с одинаковыми долговременными параметрами объединяются в пакеты, которые
+обрабатываются функцией bignVerifyBatch(). Запросы выработки
+с одинаковым контекстом объединяются в пакеты, которые обрабатываются
+функцией bignSignBatch(). Внутри пакета подписи группируются
+по идентификатору хэш-алгоритма.
+
+Буферы запросов (в том числе параметры, контекст, личные ключи)
+принадлежат вызывающей стороне и должны оставаться доступными до
+завершения запросов. Личные ключи копируются только на время обработки
+пакета, после чего копии стираются.
+*******************************************************************************
+*/
+
+/*!	\brief Запрос на проверку ЭЦП
+
+	Асинхронный запрос на проверку подписи [3 * l / 8]sig сообщения
+	с хэш-значением [l / 4]hash на открытом ключе [l / 2]pubkey
+	с долговременными параметрами params. Хэш-значение получено с помощью
+	алгоритма с идентификатором [oid_len]oid_der.
+*/
+typedef struct
+{
+	mt_req_t req;				/*!< заголовок запроса */
+	const bign_params* params;	/*!< [in] долговременные параметры */
+	const octet* oid_der;		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len;				/*!< [in] длина oid_der в октетах */
+	const octet* hash;			/*!< [in] хэш-значение */
+	const octet* sig;			/*!< [in] подпись */
+	const octet* pubkey;		/*!< [in] открытый ключ */
+} bign_verify_req_t;
+
+/*!	\brief Асинхронная проверка ЭЦП
+
+	Запрос req ставится на выполнение в исполнитель as.
+	\pre В req->req задано поле done и, возможно, поле user.
+	\remark Код завершения запроса req->req.code -- как у bignVerify().
+*/
+void bignVerifyAsync(
+	mt_async_t* as,				/*!< [in,out] исполнитель */
+	bign_verify_req_t* req		/*!< [in,out] запрос */
+);
+
+/*!	\brief Запрос на выработку ЭЦП
+
+	Асинхронный запрос на выработку подписи [3 * l / 8]sig хэш-значения
+	[l / 4]hash на личном ключе [l / 4]privkey с долговременными
+	параметрами контекста ctx. Хэш-значение получено с помощью алгоритма
+	с идентификатором [oid_len]oid_der.
+*/
+typedef struct
+{
+	mt_req_t req;				/*!< заголовок запроса */
+	const void* ctx;			/*!< [in] контекст */
+	const octet* oid_der;		/*!< [in] идентификатор хэш-алгоритма */
+	size_t oid_len;				/*!< [in] длина oid_der в октетах */
+	const octet* hash;			/*!< [in] хэш-значение */
+	const octet* privkey;		/*!< [in] личный ключ */
+	octet* sig;					/*!< [out] подпись */
+} bign_sign_req_t;
+
+/*!	\brief Асинхронная выработка ЭЦП
+
+	Запрос req ставится на выполнение в исполнитель as. Одноразовые
+	ключи вырабатываются генератором rngStepR3().
+	\pre В req->req задано поле done и, возможно, поле user.
+	\remark Код завершения запроса req->req.code -- как у bignSignBatch().
+	Если генератор rng не создан (см. rngCreate()), то код -- ERR_BAD_RNG.
+*/
+void bignSignAsync(
+	mt_async_t* as,				/*!< [in,out] исполнитель */
+	bign_sign_req_t* req		/*!< [in,out] запрос */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief STB 34.101.47/botp: OTP algorithms
 \project bee2 [cryptographic library]
 \created 2015.11.02
-\version 2023.02.02
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -125,6 +125,12 @@ void botpCtrNext(
 botpHOTPStepV() счетчик, размещенный в состоянии, инкрементируется. 
 Обновленный счетчик можно использовать для генерации или проверки нового 
 пароля. Выгрузить счетчик из состояния можно с помощью функции botpHOTPStepG().
+
+Для синхронизации со счетчиком клиента можно использовать функции
+botpHOTPStepW(), botpHOTPVerifyWindow(), которые проверяют пароль не на
+одном счетчике ctr, а в окне ctr, ctr + 1,..., ctr + window (см. п. 7.4
+RFC 4226). Пароли окна строятся на подготовленном ключе HMAC и
+вычисляются четверками с помощью одновременного сжатия четырех блоков.
 *******************************************************************************
 */
 
@@ -187,6 +193,27 @@ bool_t botpHOTPStepV(
 	void* state				/*!< [in,out] состояние */
 );
 
+/*!	\brief Проверка пароля в окне режима HOTP
+
+	По числу digit, ключу и счетчику ctr, размещенным в state, строятся
+	одноразовые пароли для счетчиков ctr, ctr + 1,..., ctr + window.
+	Построенные пароли сравниваются с otp. Если пароль для счетчика
+	ctr + i совпадает с otp (выбирается минимальное i), то в offset
+	возвращается i, а счетчик в state устанавливается равным ctr + i + 1.
+	\expect botpHOTPStepS() < botpHOTPStepW()*.
+	\return Признак совпадения паролей.
+	\remark Функция регулярна: проверяются все счетчики окна.
+	\remark Вызов botpHOTPStepW(0, otp, 0, state) эквивалентен вызову
+	botpHOTPStepV(otp, state).
+	\remark Указатель offset может быть нулевым.
+*/
+bool_t botpHOTPStepW(
+	size_t* offset,			/*!< [out] смещение совпавшего счетчика */
+	const char* otp,		/*!< [in] контрольный пароль */
+	size_t window,			/*!< [in] размер окна */
+	void* state				/*!< [in,out] состояние */
+);
+
 /*!	\brief Возврат счетчика
 
 	В ctr возвращается текущий счетчик, размещенный в state.
@@ -228,6 +255,71 @@ err_t botpHOTPVerify(
 	const octet ctr[8]		/*!< [in] счетчик */
 );
 
+/*!	\brief Проверка пароля в окне режима HOTP
+
+	По ключу [key_len]key и счетчикам ctr, ctr + 1,..., ctr + window
+	строятся одноразовые пароли из digit = strLen(otp) символов. Построенные
+	пароли сравниваются с otp. Если пароль для счетчика ctr + i совпадает
+	с otp (выбирается минимальное i), то в offset возвращается i, а счетчик
+	ctr устанавливается равным ctr + i + 1.
+	\expect{ERR_BAD_PWD} 6 <= digit && digit <= 8.
+	\expect{ERR_BAD_PWD} Пароль otp совпадает с одним из построенных.
+	\return ERR_OK в случае успеха или код ошибки.
+	\remark Указатель offset может быть нулевым.
+*/
+err_t botpHOTPVerifyWindow(
+	size_t* offset,			/*!< [out] смещение совпавшего счетчика */
+	const char* otp,		/*!< [in] контрольный пароль */
+	const octet key[],		/*!< [in] ключ */
+	size_t key_len,			/*!< [in] длина ключа в октетах */
+	octet ctr[8],			/*!< [in,out] счетчик */
+	size_t window			/*!< [in] размер окна */
+);
+
+/*!	\brief Пакетная проверка паролей в режиме HOTP
+
+	Для i = 0, 1,..., count - 1 по ключу [key_len[i]]key[i] и счетчику
+	ctr[i] строится одноразовый пароль из strLen(otp[i]) символов.
+	Построенный пароль сравнивается с otp[i]. Признак совпадения паролей
+	возвращается в success[i]. При совпадении счетчик ctr[i]
+	инкрементируется.
+	\return ERR_OK, если пакет обработан, и код ошибки в противном случае.
+	\remark Пароли неверного формата не считаются ошибками пакета:
+	соответствующие признаки success[i] принимают значение FALSE.
+	\remark Пароли строятся параллельно для четверок элементов. Память
+	выделяется однократно для всего пакета.
+*/
+err_t botpHOTPVerifyBatch(
+	bool_t success[],			/*!< [out] признаки совпадения */
+	size_t count,				/*!< [in] число элементов пакета */
+	const char* const otp[],	/*!< [in] контрольные пароли */
+	const octet* const key[],	/*!< [in] ключи */
+	const size_t key_len[],		/*!< [in] длины ключей в октетах */
+	octet ctr[][8]				/*!< [in,out] счетчики */
+);
+
+/*!	\brief Пакетная генерация паролей в режиме HOTP
+
+	По ключу [key_len]key и счетчикам ctr, ctr + 1,..., ctr + count - 1
+	генерируются одноразовые пароли из digit десятичных символов. Пароль
+	для счетчика ctr + i записывается в otps по смещению i * (digit + 1)
+	(с завершающим нулевым символом).
+	\expect{ERR_BAD_PARAMS} 6 <= digit && digit <= 8.
+	\return ERR_OK, если пароли успешно сгенерированы, и код ошибки
+	в противном случае.
+	\remark Ключ HMAC подготавливается однократно, пароли строятся
+	параллельно для четверок счетчиков. Память выделяется однократно
+	для всего пакета.
+*/
+err_t botpHOTPRandBatch(
+	char* otps,			/*!< [out] одноразовые пароли */
+	size_t count,		/*!< [in] число паролей */
+	size_t digit,		/*!< [in] длина пароля */
+	const octet key[],	/*!< [in] ключ */
+	size_t key_len,		/*!< [in] длина ключа в октетах */
+	const octet ctr[8]	/*!< [in] начальный счетчик */
+);
+
 /*!
 *******************************************************************************
 \file botp.h
@@ -246,6 +338,13 @@ tmTimeRound(). Эта функция возвращает TIME_ERR при оши
 
 Отметка времени представляется типом tm_time_t. Отметка преобразуется в счетчик
 режима HOTP, т.е. в 64-разрядное беззнаковое число. 
+
+Для учета расхождения часов клиента и сервера можно использовать функции
+botpTOTPStepW(), botpTOTPVerifyWindow(), которые проверяют пароль
+в окне отметок t - window,..., t + window (см. п. 5.2 RFC 6238). Отметки
+окна перебираются в порядке удаления от t: t, t - 1, t + 1, t - 2,...
+Совпавшую отметку рекомендуется сохранять и в дальнейшем не принимать
+пароли для нее и предшествующих ей отметок.
 *******************************************************************************
 */
 
@@ -300,6 +399,31 @@ bool_t botpTOTPStepV(
 	void* state				/*!< [in,out] состояние */
 );
 
+/*!	\brief Проверка пароля в окне режима TOTP
+
+	По округленной отметке t текущего времени, по числу digit и ключу,
+	размещенным в state, строятся одноразовые пароли для отметок
+	t - window,..., t + window. Построенные пароли сравниваются с otp.
+	Из отметок, для которых пароли совпали, выбирается ближайшая к t
+	(при равном удалении -- предшествующая t). Выбранная отметка
+	возвращается в t1.
+	\pre t != TIME_ERR.
+	\pre window <= SIZE_MAX / 2 - 2.
+	\pre Отметка t + window представляется типом tm_time_t.
+	\expect botpTOTPStart() < botpTOTPStepW()*.
+	\return TRUE, если пароль подошел, и FALSE в противном случае.
+	\remark Отрицательные отметки окна не проверяются.
+	\remark Функция регулярна: проверяются все отметки окна.
+	\remark Указатель t1 может быть нулевым.
+*/
+bool_t botpTOTPStepW(
+	tm_time_t* t1,			/*!< [out] совпавшая отметка */
+	const char* otp,		/*!< [in] контрольный пароль */
+	tm_time_t t,			/*!< [in] округленная отметка времени */
+	size_t window,			/*!< [in] размер окна */
+	void* state				/*!< [in,out] состояние */
+);
+
 /*!	\brief Генерация пароля в режиме TOTP
 
 	По числу digit, ключу [key_len]key и округленной отметке t текущего 
@@ -334,6 +458,76 @@ err_t botpTOTPVerify(
 	tm_time_t t				/*!< [in] округленная отметка времени */
 );
 
+/*!	\brief Проверка пароля в окне режима TOTP
+
+	По ключу [key_len]key и округленным отметкам t - window,..., t + window
+	строятся одноразовые пароли из strLen(otp) символов. Построенные пароли
+	сравниваются с otp. Из отметок, для которых пароли совпали, выбирается
+	ближайшая к t (при равном удалении -- предшествующая t). Выбранная
+	отметка возвращается в t1.
+	\expect{ERR_BAD_PWD} 6 <= digit && digit <= 8.
+	\expect{ERR_BAD_TIME} t != TIME_ERR.
+	\expect{ERR_BAD_PARAMS} window <= SIZE_MAX / 2 - 2.
+	\expect{ERR_BAD_PWD} Пароль otp подошел.
+	\return ERR_OK в случае успеха или код ошибки.
+	\remark Указатель t1 может быть нулевым.
+*/
+err_t botpTOTPVerifyWindow(
+	tm_time_t* t1,			/*!< [out] совпавшая отметка */
+	const char* otp,		/*!< [in] контрольный пароль */
+	const octet key[],		/*!< [in] ключ */
+	size_t key_len,			/*!< [in] длина ключа в октетах */
+	tm_time_t t,			/*!< [in] округленная отметка времени */
+	size_t window			/*!< [in] размер окна */
+);
+
+/*!	\brief Пакетная проверка паролей в режиме TOTP
+
+	Для i = 0, 1,..., count - 1 по ключу [key_len[i]]key[i] и округленной
+	отметке t[i] текущего времени строится одноразовый пароль
+	из strLen(otp[i]) символов. Построенный пароль сравнивается с otp[i].
+	Признак совпадения паролей возвращается в success[i].
+	\return ERR_OK, если пакет обработан, и код ошибки в противном случае.
+	\remark Пароли неверного формата и отметки t[i] == TIME_ERR
+	не считаются ошибками пакета: соответствующие признаки success[i]
+	принимают значение FALSE.
+	\remark Пароли строятся параллельно для четверок элементов. Память
+	выделяется однократно для всего пакета.
+*/
+err_t botpTOTPVerifyBatch(
+	bool_t success[],			/*!< [out] признаки совпадения */
+	size_t count,				/*!< [in] число элементов пакета */
+	const char* const otp[],	/*!< [in] контрольные пароли */
+	const octet* const key[],	/*!< [in] ключи */
+	const size_t key_len[],		/*!< [in] длины ключей в октетах */
+	const tm_time_t t[]			/*!< [in] округленные отметки времени */
+);
+
+/*!	\brief Пакетная генерация паролей в режиме TOTP
+
+	По ключу [key_len]key и округленным отметкам времени t, t + 1,...,
+	t + count - 1 генерируются одноразовые пароли из digit десятичных
+	символов. Пароль для отметки t + i записывается в otps по смещению
+	i * (digit + 1) (с завершающим нулевым символом).
+	\expect{ERR_BAD_PARAMS} 6 <= digit && digit <= 8.
+	\expect{ERR_BAD_TIME} t != TIME_ERR.
+	\return ERR_OK, если пароли успешно сгенерированы, и код ошибки
+	в противном случае.
+	\remark Отметки t + i преобразуются в счетчики режима HOTP, которые
+	инкрементируются по модулю 2^64.
+	\remark Ключ HMAC подготавливается однократно, пароли строятся
+	параллельно для четверок отметок. Память выделяется однократно
+	для всего пакета.
+*/
+err_t botpTOTPRandBatch(
+	char* otps,			/*!< [out] одноразовые пароли */
+	size_t count,		/*!< [in] число паролей */
+	size_t digit,		/*!< [in] длина пароля */
+	const octet key[],	/*!< [in] ключ */
+	size_t key_len,		/*!< [in] длина ключа в октетах */
+	tm_time_t t			/*!< [in] начальная округленная отметка времени */
+);
+
 /*!
 *******************************************************************************
 \file botp.h
@@ -363,6 +557,14 @@ strIsAlphanumeric(), decIsValid(), hexIsValid().
 длина лежит в пределах от 4 до q_max, где q_max -- максимальная длина, 
 указанная в suite. Если q -- двойной, то его длина лежит в пределах от 8 до
 2 * q_max. За подготовку составного запроса отвечает вызывающая программа.
+
+Описатель можно предварительно разобрать с помощью функции
+botpOCRASuiteParse() и затем использовать результат разбора в функции
+botpOCRAStart2() для нескольких ключей. Ключ и описатель обрабатываются
+в botpOCRAStart2() (botpOCRAStart()) однократно, в botpOCRAStepR() и
+botpOCRAStepV() обрабатываются только переменные данные: счетчик, запрос,
+данные сеанса и отметка времени. Поэтому состояние, подготовленное для
+данного ключа, рекомендуется сохранять и использовать повторно.
 *******************************************************************************
 */
 
@@ -373,6 +575,45 @@ strIsAlphanumeric(), decIsValid(), hexIsValid().
 */
 size_t botpOCRA_keep();
 
+/*!	\brief Разобранный описатель OCRA */
+typedef struct
+{
+	size_t digit;		/*!< число цифр в пароле */
+	size_t ctr_len;		/*!< длина счетчика (0 или 8) */
+	char q_type;		/*!< тип запроса (A, N, H) */
+	size_t q_max;		/*!< максимальная длина одиночного запроса */
+	size_t p_len;		/*!< длина хэш-значения статического пароля */
+	size_t s_len;		/*!< длина идентификатора сеанса */
+	tm_time_t ts;		/*!< шаг времени (0, если время не используется) */
+	char str[64];		/*!< описатель */
+} botp_ocra_suite_t;
+
+/*!	\brief Разбор описателя OCRA
+
+	Описатель str разбирается, результаты разбора сохраняются в suite.
+	\return TRUE, если описатель корректен, и FALSE в противном случае.
+*/
+bool_t botpOCRASuiteParse(
+	botp_ocra_suite_t* suite,	/*!< [out] разобранный описатель */
+	const char* str				/*!< [in] описатель */
+);
+
+/*!	\brief Инициализация режима OCRA по разобранному описателю
+
+	По разобранному описателю suite и ключу [key_len]key в state формируются
+	структуры данных, необходимые для управления паролями в режиме OCRA.
+	\pre По адресу state зарезервировано botpOCRA_keep() октетов.
+	\expect botpOCRASuiteParse() < botpOCRAStart2().
+	\remark Вызов botpOCRAStart2() эквивалентен вызову botpOCRAStart()
+	с описателем suite->str, но выполняется без разбора описателя.
+*/
+void botpOCRAStart2(
+	void* state,					/*!< [out] состояние */
+	const botp_ocra_suite_t* suite,	/*!< [in] разобранный описатель */
+	const octet key[],				/*!< [in] ключ */
+	size_t key_len					/*!< [in] длина ключа в октетах */
+);
+
 /*!	\brief Инициализация режима OCRA
 
 	По описателю suite и ключу [key_len]key в state формируются структуры данных, 
@@ -4,7 +4,7 @@
 \brief STB 34.101.78 (bpki): PKI helpers
 \project bee2/apps/bpki
 \created 2021.04.03
-\version 2023.12.19
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -97,6 +97,34 @@ err_t bpkiPrivkeyWrap(
 	size_t iter				/*!< [in] количество итераций в PBKDF2 */
 );
 
+/*!	\brief Создание нескольких контейнеров с личными ключами
+
+	Создаются контейнеры [n * epki_len?]epkis с защищенными личными ключами
+	[n * privkey_len]privkeys. Все ключи защищаются на пароле [pwd_len]pwd,
+	i-й ключ -- с синхропосылкой salts + 8 * i.
+	\expect{ERR_BAD_PRIVKEY} privkey_len \in {24, 32, 48, 64}.
+	\expect{ERR_BAD_INPUT} iter >= 10000.
+	\return ERR_OK, если контейнеры успешно созданы, и код ошибки
+	в противном случае.
+	\remark Результат совпадает с результатом последовательных вызовов
+	bpkiPrivkeyWrap(epkis + epki_len * i, 0, privkeys + privkey_len * i,
+	privkey_len, pwd, pwd_len, salts + 8 * i, iter). Ключи защиты строятся
+	одновременно с помощью beltPBKDF2MB().
+	\remark При нулевом epkis указатели privkeys, pwd и salts могут быть
+	нулевыми.
+*/
+err_t bpkiPrivkeyWrapMB(
+	octet epkis[],			/*!< [out] контейнеры с личными ключами */
+	size_t* epki_len,		/*!< [out] длина одного контейнера */
+	const octet privkeys[],	/*!< [in] личные ключи */
+	size_t privkey_len,		/*!< [in] длина одного личного ключа */
+	const octet pwd[],		/*!< [in] пароль */
+	size_t pwd_len,			/*!< [in] длина pwd */
+	const octet salts[],	/*!< [in] синхропосылки ("соли") PBKDF2 */
+	size_t iter,			/*!< [in] количество итераций в PBKDF2 */
+	size_t n				/*!< [in] число контейнеров */
+);
+
 /*!	\brief Разбор контейнера с личным ключом
 
 	Из контейнера [epki_len]epki извлекается личный ключ [privkey_len?]privkey,
@@ -171,6 +199,154 @@ err_t bpkiShareUnwrap(
 	size_t pwd_len			/*!< [in] длина pwd */
 );
 
+/*!	\brief Создание нескольких контейнеров с частичными секретами
+
+	Создаются контейнеры [n * epki_len?]epkis с защищенными частичными
+	секретами [n * share_len]shares. Все секреты защищаются на пароле
+	[pwd_len]pwd, i-й секрет -- с синхропосылкой salts + 8 * i.
+	\expect{ERR_BAD_SHAREKEY} share_len \in {17, 25, 33}.
+	\expect{ERR_BAD_SHAREKEY} Первые октеты частичных секретов лежат
+	в диапазоне от 1 до 16.
+	\expect{ERR_BAD_INPUT} iter >= 10000.
+	\return ERR_OK, если контейнеры успешно созданы, и код ошибки
+	в противном случае.
+	\remark Результат совпадает с результатом последовательных вызовов
+	bpkiShareWrap(epkis + epki_len * i, 0, shares + share_len * i,
+	share_len, pwd, pwd_len, salts + 8 * i, iter). Ключи защиты строятся
+	одновременно с помощью beltPBKDF2MB().
+	\remark При нулевом epkis указатели shares, pwd и salts могут быть
+	нулевыми.
+*/
+err_t bpkiShareWrapMB(
+	octet epkis[],			/*!< [out] контейнеры с частичными секретами */
+	size_t* epki_len,		/*!< [out] длина одного контейнера */
+	const octet shares[],	/*!< [in] частичные секреты */
+	size_t share_len,		/*!< [in] длина одного частичного секрета */
+	const octet pwd[],		/*!< [in] пароль */
+	size_t pwd_len,			/*!< [in] длина pwd */
+	const octet salts[],	/*!< [in] синхропосылки ("соли") PBKDF2 */
+	size_t iter,			/*!< [in] количество итераций в PBKDF2 */
+	size_t n				/*!< [in] число контейнеров */
+);
+
+/*!	\brief Разбор нескольких контейнеров с частичными секретами
+
+	Из контейнеров [epki_lens[i]]epkis[i], i = 0, 1,..., n - 1,
+	извлекаются частичные секреты [n * share_len]shares. Защита со всех
+	контейнеров снимается на пароле [pwd_len]pwd.
+	\expect{ERR_BAD_SHAREKEY} share_len \in {17, 25, 33}.
+	\expect{ERR_BAD_FORMAT} Длины частичных секретов в контейнерах
+	равны share_len.
+	\return ERR_OK, если все частичные секреты успешно извлечены, и код
+	ошибки в противном случае.
+	\remark Результат совпадает с результатом последовательных вызовов
+	bpkiShareUnwrap(shares + share_len * i, 0, epkis[i], epki_lens[i],
+	pwd, pwd_len). Ключи защиты контейнеров с одинаковым числом итераций
+	PBKDF2 строятся одновременно с помощью beltPBKDF2MB().
+	\remark В случае ошибки буфер shares обнуляется.
+*/
+err_t bpkiShareUnwrapMB(
+	octet shares[],				/*!< [out] частичные секреты */
+	size_t share_len,			/*!< [in] длина одного частичного секрета */
+	const octet* const epkis[],	/*!< [in] контейнеры */
+	const size_t epki_lens[],	/*!< [in] длины контейнеров */
+	const octet pwd[],			/*!< [in] пароль */
+	size_t pwd_len,				/*!< [in] длина pwd */
+	size_t n					/*!< [in] число контейнеров */
+);
+
+/*!
+*******************************************************************************
+\file bpki.h
+
+\section bpki-kek Кэш ключей защиты
+
+Снятие защиты с контейнера требует построения ключа защиты с помощью
+PBKDF2 и занимает основное время. При многократном разборе одних и тех
+же контейнеров в пределах процесса построенные ключи можно сохранять
+в кэше и передавать кэш функциям bpkiPrivkeyUnwrap2(), bpkiShareUnwrap2().
+
+Ключ защиты идентифицируется хэш-значением синхропосылки, числа итераций
+и пароля. Ключ размещается в кэше только после успешного снятия защиты.
+Ключ хранится в кэше не дольше ttl секунд: элементы с истекшим временем
+жизни очищаются при каждом обращении к кэшу. При закрытии кэша очищаются
+все элементы.
+
+Кэш защищен мьютексом и может одновременно использоваться в нескольких
+потоках.
+
+\warning Кэш содержит ключи защиты контейнеров в открытом виде. Время
+жизни ttl следует выбирать минимально необходимым.
+*******************************************************************************
+*/
+
+/*!	\brief Длина кэша
+
+	Возвращается длина кэша из count элементов.
+	\return Длина кэша.
+*/
+size_t bpkiKEKCache_keep(
+	size_t count			/*!< [in] число элементов */
+);
+
+/*!	\brief Создание кэша
+
+	По адресу cache создается кэш из count элементов, в котором ключи
+	защиты хранятся не дольше ttl секунд.
+	\pre По адресу cache зарезервировано bpkiKEKCache_keep(count) октетов.
+	\expect{ERR_BAD_INPUT} count > 0 && ttl > 0.
+	\return ERR_OK, если кэш создан, и код ошибки в противном случае.
+	\post Кэш закрывается функцией bpkiKEKCacheClose().
+*/
+err_t bpkiKEKCacheStart(
+	void* cache,			/*!< [out] кэш */
+	size_t count,			/*!< [in] число элементов */
+	size_t ttl				/*!< [in] время жизни ключей (в секундах) */
+);
+
+/*!	\brief Закрытие кэша
+
+	Кэш cache закрывается, все его элементы очищаются.
+	\pre Кэш создан функцией bpkiKEKCacheStart().
+*/
+void bpkiKEKCacheClose(
+	void* cache				/*!< [in,out] кэш */
+);
+
+/*!	\brief Разбор контейнера с личным ключом с кэшем ключей защиты
+
+	Аналог bpkiPrivkeyUnwrap(), в котором ключ защиты ищется в кэше cache
+	и размещается в кэше после построения.
+	\pre Если cache != 0, то кэш создан функцией bpkiKEKCacheStart().
+	\remark При cache == 0 функция действует так же, как bpkiPrivkeyUnwrap().
+*/
+err_t bpkiPrivkeyUnwrap2(
+	octet privkey[],		/*!< [out] личный ключ */
+	size_t* privkey_len,	/*!< [in] длина privkey */
+	const octet epki[],		/*!< [in] контейнер с личным ключом */
+	size_t epki_len,		/*!< [in] длина epki */
+	const octet pwd[],		/*!< [in] пароль */
+	size_t pwd_len,			/*!< [in] длина pwd */
+	void* cache				/*!< [in,out] кэш ключей защиты */
+);
+
+/*!	\brief Разбор контейнера с частичным секретом с кэшем ключей защиты
+
+	Аналог bpkiShareUnwrap(), в котором ключ защиты ищется в кэше cache
+	и размещается в кэше после построения.
+	\pre Если cache != 0, то кэш создан функцией bpkiKEKCacheStart().
+	\remark При cache == 0 функция действует так же, как bpkiShareUnwrap().
+*/
+err_t bpkiShareUnwrap2(
+	octet share[],			/*!< [out] частичный секрет */
+	size_t* share_len,		/*!< [out] длина share */
+	const octet epki[],		/*!< [in] контейнер с частичным секретом */
+	size_t epki_len,		/*!< [in] длина epki */
+	const octet pwd[],		/*!< [in] пароль */
+	size_t pwd_len,			/*!< [in] длина pwd */
+	void* cache				/*!< [in,out] кэш ключей защиты */
+);
+
 /*!	\brief Перевыпуск запроса на выпуск сертификата
 
 	В запрос на выпуск сертификата [csr_len]csr вкладывается новый
@@ -208,6 +384,36 @@ err_t bpkiCSRUnwrap(
 	size_t csr_len			/*!< [in] длина csr */
 );
 
+/*!	\brief Пакетный разбор запросов на выпуск сертификатов
+
+	Разбираются запросы на выпуск сертификатов [csr_lens[i]]csrs[i],
+	i = 0, 1,..., n - 1. Проверяются открытые ключи и подписи запросов.
+	Результат проверки i-го запроса возвращается в codes[i], открытый
+	ключ из корректного запроса -- в [64](pubkeys + 64 * i).
+	\expect{ERR_BAD_FORMAT} Запросы имеют формат, поддерживаемый
+	функцией bpkiCSRUnwrap().
+	\return ERR_OK, если все запросы корректны, и код ошибки первого
+	некорректного запроса в противном случае.
+	\remark codes[i] совпадает с результатом вызова
+	bpkiCSRUnwrap(pubkeys + 64 * i, 0, csrs[i], csr_lens[i]), за исключением
+	того, что открытые ключи проверяются функцией bignPubkeyVal()
+	(некорректный ключ -- код ERR_BAD_PUBKEY).
+	\remark Подписываемые части запросов хэшируются одновременно с помощью
+	beltHashMB(), подписи проверяются пакетами с помощью bignVerifyBatch().
+	Пакет проверяется повторно, начиная со следующей за некорректной
+	подписи, поэтому одна некорректная подпись не препятствует проверке
+	остальных.
+	\remark Открытые ключи некорректных запросов обнуляются.
+	\remark Указатель pubkeys может быть нулевым.
+*/
+err_t bpkiCSRUnwrapBatch(
+	err_t codes[],				/*!< [out] результаты проверки запросов */
+	octet pubkeys[],			/*!< [out] открытые ключи */
+	const octet* const csrs[],	/*!< [in] запросы на выпуск сертификатов */
+	const size_t csr_lens[],	/*!< [in] длины запросов */
+	size_t n					/*!< [in] число запросов */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief STB 34.101.47 (brng): algorithms of pseudorandom number generation
 \project bee2 [cryptographic library]
 \created 2013.01.31
-\version 2023.02.02
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -136,6 +136,10 @@ void brngCTRStart(
 		brngCTRStepR(buf, 32, state);
 	\endcode
 	вызываемые сразу после brngCTRStart(), не эквивалентны друг другу.
+	\remark Четверки полных блоков обрабатываются частично одновременно.
+	Поэтому генерацию больших объемов данных выгоднее выполнять одним
+	вызовом. Результат не зависит от разбиения buf на фрагменты
+	(с учетом предыдущего замечания).
 */
 void brngCTRStepR(
 	void* buf,			/*!< [in,out] дополн. / псевдослучайные данные */
@@ -225,7 +229,9 @@ void brngHMACStart(
 	Реализована буферизация блоков и функцию можно вызвать с произвольным
 	значением count. Если не все данные сгенерированного ранее блока
 	израсходованы, то они будут возвращены в первую очередь.
-
+	\remark Четверки полных блоков обрабатываются частично одновременно.
+	Поэтому генерацию больших объемов данных выгоднее выполнять одним
+	вызовом.
 */
 void brngHMACStepR(
 	void* buf,			/*!< [out] псевдослучайные данные */
@@ -4,7 +4,7 @@
 \brief STB 34.101.79 (btok): cryptographic tokens
 \project bee2 [cryptographic library]
 \created 2022.07.04
-\version 2023.06.17
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -15,6 +15,7 @@
 
 #include "bee2/defs.h"
 #include "bee2/core/apdu.h"
+#include "bee2/core/mt.h"
 #include "bee2/crypto/bake.h"
 
 /*!
@@ -383,6 +384,102 @@ err_t btokCVCUnwrap(
 	size_t pubkey_len			/*!< [in] длина pubkey в октетах */
 );
 
+/*!	\brief Представление CV-сертификата
+
+	Представление описывает поля CV-сертификата смещениями относительно
+	начала его DER-кода. Значения полей не копируются и остаются в
+	сертификате. Нулевое смещение hat_eid или hat_esign означает, что
+	соответствующие права доступа в сертификате отсутствуют.
+*/
+typedef struct
+{
+	size_t body;			/*!< основная часть (подписываемые данные) */
+	size_t body_len;		/*!< длина основной части в октетах */
+	size_t authority;		/*!< издатель */
+	size_t authority_len;	/*!< длина authority в октетах (8..12) */
+	size_t holder;			/*!< владелец */
+	size_t holder_len;		/*!< длина holder в октетах (8..12) */
+	size_t pubkey;			/*!< открытый ключ */
+	size_t pubkey_len;		/*!< длина открытого ключа (48, 64, 96, 128) */
+	size_t from;			/*!< дата начала действия (6 октетов) */
+	size_t until;			/*!< дата окончания действия (6 октетов) */
+	size_t hat_eid;			/*!< права доступа к eId (5 октетов, optional) */
+	size_t hat_esign;		/*!< права доступа к eSign (2 октета, optional) */
+	size_t sig;				/*!< подпись */
+	size_t sig_len;			/*!< длина подписи (34, 48, 72 или 96) */
+} btok_cvc_view_t;
+
+/*!	\brief Построение представления CV-сертификата
+
+	Строится представление view CV-сертификата [cert_len]cert. Сертификат
+	разбирается за один проход по DER-коду без копирования полей.
+	\return ERR_OK, если представление успешно построено, и код ошибки
+	в противном случае.
+	\remark Контролируются структура DER-кода, длины имен, открытого
+	ключа и подписи. Печатаемость имен и корректность дат не проверяются:
+	для полной проверки следует вызвать btokCVCUnwrap().
+	\remark Длина cert должна в точности равняться cert_len. Противное
+	считается ошибкой формата.
+*/
+err_t btokCVCView(
+	btok_cvc_view_t* view,		/*!< [out] представление */
+	const octet cert[],			/*!< [in] сертификат */
+	size_t cert_len				/*!< [in] длина cert в октетах */
+);
+
+/*!	\brief Издатель по представлению
+
+	По представлению view сертификата cert определяется издатель
+	authority.
+	\pre view построено по cert.
+*/
+void btokCVCViewAuthority(
+	char authority[13],			/*!< [out] издатель */
+	const btok_cvc_view_t* view,/*!< [in] представление */
+	const octet cert[]			/*!< [in] сертификат */
+);
+
+/*!	\brief Владелец по представлению
+
+	По представлению view сертификата cert определяется владелец holder.
+	\pre view построено по cert.
+*/
+void btokCVCViewHolder(
+	char holder[13],			/*!< [out] владелец */
+	const btok_cvc_view_t* view,/*!< [in] представление */
+	const octet cert[]			/*!< [in] сертификат */
+);
+
+/*!	\brief Сравнение владельца
+
+	Проверяется, что владельцем сертификата cert с представлением view
+	является name.
+	\pre view построено по cert.
+	\return Признак совпадения.
+	\remark Имя сравнивается с полем сертификата на месте, без копирования.
+*/
+bool_t btokCVCViewIsHolder(
+	const btok_cvc_view_t* view,/*!< [in] представление */
+	const octet cert[],			/*!< [in] сертификат */
+	const char* name			/*!< [in] имя */
+);
+
+/*!	\brief Проверка подписи по представлению
+
+	Подпись сертификата cert с представлением view проверяется на открытом
+	ключе [pubkey_len]pubkey.
+	\pre view построено по cert.
+	\return ERR_OK, если подпись верна, и код ошибки в противном случае.
+	\remark Если длина подписи не соответствует длине pubkey, то
+	возвращается ERR_BAD_SIG.
+*/
+err_t btokCVCViewVerify(
+	const btok_cvc_view_t* view,/*!< [in] представление */
+	const octet cert[],			/*!< [in] сертификат */
+	const octet pubkey[],		/*!< [in] открытый ключ */
+	size_t pubkey_len			/*!< [in] длина pubkey в октетах */
+);
+
 /*!	\brief Выпуск CV-сертификата
 
 	Выпускается CV-сертификат [cert_len?]cert с содержанием cvc. При выпуске
@@ -407,6 +504,37 @@ err_t btokCVCIss(
 	size_t privkeya_len			/*!< [in] длина privkeya в октетах */
 );
 
+/*!	\brief Пакетный выпуск CV-сертификатов
+
+	Выпускаются count CV-сертификатов с содержаниями из массива cvcs.
+	При выпуске используются личный ключ [privkeya_len]privkeya и сертификат
+	[certa_len]certa издателя. Сертификаты записываются в буфер certs
+	последовательно друг за другом, длина i-го сертификата возвращается
+	в cert_len[i]. Подпись i-го сертификата сохраняется в cvcs[i].sig.
+	Проверяются те же условия, что и в btokCVCIss(), причем certa и
+	privkeya проверяются однократно. Если certs == 0, то определяются
+	только длины сертификатов. Сертификаты подписываются в задачах пула
+	потоков pool (по одной задаче на сертификат). Если pool == 0, то
+	вычисления выполняются в вызывающем потоке.
+	\expect{ERR_BAD_INPUT} Длина буфера certs не меньше суммы длин
+	cert_len[i].
+	\return ERR_OK, если сертификаты успешно выпущены, и код ошибки в
+	противном случае.
+	\pre Функция не вызывается из задач пула pool.
+	\remark Открытые ключи cvcs[i].pubkey должны быть заданы.
+*/
+err_t btokCVCIssBatch(
+	octet certs[],				/*!< [out] сертификаты */
+	size_t cert_len[],			/*!< [out] длины сертификатов */
+	size_t count,				/*!< [in] число сертификатов */
+	btok_cvc_t cvcs[],			/*!< [in,out] содержания сертификатов */
+	const octet certa[],		/*!< [in] сертификат издателя */
+	size_t certa_len,			/*!< [in] длина certa в октетах */
+	const octet privkeya[],		/*!< [in] личный ключ издателя */
+	size_t privkeya_len,		/*!< [in] длина privkeya в октетах */
+	mt_pool_t* pool				/*!< [in,out] пул потоков */
+);
+
 /*!	\brief Точная длина CV-сертификата
 
 	Определяется точная длина CV-сертификата, размещенного в префиксе
@@ -480,6 +608,91 @@ err_t btokCVCVal2(
 	const octet* date			/*!< [in] дата проверки */
 );
 
+/*!	\brief Длина состояния хранилища якорей
+
+	Возвращается длина состояния (в октетах) хранилища, рассчитанного
+	на anchors якорей и cache элементов кэша проверенных сертификатов.
+	\return Длина состояния.
+*/
+size_t btokCVCStore_keep(
+	size_t anchors,				/*!< [in] максимальное число якорей */
+	size_t cache				/*!< [in] число элементов кэша */
+);
+
+/*!	\brief Создание хранилища якорей
+
+	По адресу state создается пустое хранилище, рассчитанное на anchors
+	якорей и cache элементов кэша проверенных сертификатов.
+	\expect{ERR_BAD_INPUT} anchors > 0.
+	\return ERR_OK, если хранилище создано, и код ошибки в противном случае.
+	\pre По адресу state зарезервировано btokCVCStore_keep(anchors, cache)
+	октетов.
+	\remark Хранилище содержит указатели на свои же внутренние данные и не
+	может перемещаться в памяти.
+	\remark Хранилище не может одновременно использоваться в нескольких
+	потоках.
+*/
+err_t btokCVCStoreStart(
+	void* state,				/*!< [out] хранилище */
+	size_t anchors,				/*!< [in] максимальное число якорей */
+	size_t cache				/*!< [in] число элементов кэша */
+);
+
+/*!	\brief Добавление якоря
+
+	В хранилище state добавляется якорь -- CV-сертификат [certa_len]certa.
+	Подпись certa не проверяется.
+	\expect{ERR_BAD_ANCHOR} В хранилище нет якоря с тем же владельцем.
+	\expect{ERR_OUTOFMEMORY} Хранилище не заполнено.
+	\return ERR_OK, если якорь добавлен, и код ошибки в противном случае.
+	\remark Ключ якоря проверяется однократно при добавлении. Для ключей на
+	стандартных кривых bign-curveXXXv1 однократно строится контекст bign
+	(см. bignCtxStart()).
+*/
+err_t btokCVCStoreAdd(
+	void* state,				/*!< [in,out] хранилище */
+	const octet certa[],		/*!< [in] сертификат якоря */
+	size_t certa_len			/*!< [in] длина certa в октетах */
+);
+
+/*!	\brief Добавление якоря по содержанию сертификата
+
+	В хранилище state добавляется якорь с содержанием cvca.
+	\expect{ERR_BAD_ANCHOR} В хранилище нет якоря с тем же владельцем.
+	\expect{ERR_OUTOFMEMORY} Хранилище не заполнено.
+	\return ERR_OK, если якорь добавлен, и код ошибки в противном случае.
+	\remark В роли cvca может выступать содержание промежуточного
+	сертификата, проверенного с помощью btokCVCStoreVal().
+*/
+err_t btokCVCStoreAdd2(
+	void* state,				/*!< [in,out] хранилище */
+	const btok_cvc_t* cvca		/*!< [in] содержание сертификата якоря */
+);
+
+/*!	\brief Проверка CV-сертификата по хранилищу
+
+	Проверяется корректность CV-сертификата [cert_len]cert на дату date.
+	Сертификат издателя выбирается в хранилище state по имени издателя
+	cert. Проверки совпадают с проверками btokCVCVal2(). В случае успеха
+	определяется содержание cvc проверяемого сертификата. Указатели cvc и
+	date могут быть нулевыми (см. btokCVCVal2()).
+	\expect{ERR_BAD_ANCHOR} Издатель cert размещен в хранилище.
+	\return ERR_OK, если сертификат признан корректным, и код ошибки в
+	противном случае.
+	\remark Хэш-значения успешно проверенных сертификатов и сроки их
+	действия сохраняются в кэше хранилища. Для сертификата из кэша подпись
+	и соответствие издателю повторно не проверяются, а проверка с нулевым
+	cvc сводится к хэшированию cert и контролю даты. Если на дату date срок
+	действия сертификата истек, то он удаляется из кэша.
+*/
+err_t btokCVCStoreVal(
+	btok_cvc_t* cvc,			/*!< [out] содержание сертификата */
+	void* state,				/*!< [in,out] хранилище */
+	const octet cert[],			/*!< [in] сертификат */
+	size_t cert_len,			/*!< [in] длина cert в октетах */
+	const octet* date			/*!< [in] дата проверки */
+);
+
 /*!	\brief Проверка соответствия CV-сертификата
 
 	Проверяется соответствие между CV-сертификатом [cert_len]cert и личным
@@ -588,6 +801,47 @@ err_t btokSMCmdWrap(
 	void* state					/*!< [in,out] состояние SM */
 );
 
+/*!	\brief Позиция данных в защищенной команде
+
+	Определяется позиция, которую в защищенной команде с длиной данных
+	cdf_len и максимальной длиной данных ответа rdf_len занимает
+	зашифрованное поле данных команды.
+	\return Позиция или SIZE_MAX, если cdf_len >= 65536 || rdf_len > 65536.
+	\remark Позиция не превосходит 4 + 3 + 4 + 1 = 12.
+*/
+size_t btokSMCmdCDFOffset(
+	size_t cdf_len,				/*!< [in] длина данных команды */
+	size_t rdf_len				/*!< [in] максимальная длина данных ответа */
+);
+
+/*!	\brief Установка защиты команды на месте
+
+	Устанавливается защита команды с заголовком hdr (CLA INS P1 P2),
+	данными длины cdf_len и максимальной длиной данных ответа rdf_len.
+	Данные команды должны быть размещены в буфере apdu по смещению
+	btokSMCmdCDFOffset(cdf_len, rdf_len). Защищенная команда формируется
+	в том же буфере [count?]apdu, данные зашифровываются на месте.
+	Если apdu == 0, то определяется только длина защищенной команды.
+	\pre По адресу state зарезервировано btokSM_keep() октетов.
+	\pre Буфер hdr либо совпадает с apdu, либо не пересекается с ним.
+	\expect btokSMStart() < btokSMCmdWrap2()*.
+	\expect{ERR_BAD_APDU} В hdr[0] снят бит 0x04 (признак защиты),
+	cdf_len < 65536 && rdf_len <= 65536.
+	\expect{ERR_BAD_LOGIC} Непосредственно а момент установки защиты
+	(apdu != 0) счетчик SM принимает нечетное значение.
+	\return ERR_OK в случае успеха и код ошибки в противном случае.
+	\remark Результат совпадает с результатом btokSMCmdWrap() для
+	команды с теми же полями.
+*/
+err_t btokSMCmdWrap2(
+	octet apdu[],				/*!< [in,out] данные / код команды */
+	size_t* count,				/*!< [out] длина кода команды */
+	const octet hdr[4],			/*!< [in] заголовок команды */
+	size_t cdf_len,				/*!< [in] длина данных команды */
+	size_t rdf_len,				/*!< [in] максимальная длина данных ответа */
+	void* state					/*!< [in,out] состояние SM */
+);
+
 /*!	\brief Декодирование и снятие защиты команды с помощью SM
 
 	Код команды [count]apdu декодируется и одновременно с него снимается
@@ -612,6 +866,31 @@ err_t btokSMCmdUnwrap(
 	void* state					/*!< [in,out] состояние SM */
 );
 
+/*!	\brief Снятие защиты команды на месте
+
+	С кода команды [count]apdu снимается защита с помощью объектов SM,
+	размещенных в state. Данные команды расшифровываются на месте.
+	Если view != 0, то по этому адресу возвращается представление
+	команды: заголовок со снятым признаком защиты, длины и указатель
+	view->cdf на расшифрованные данные внутри apdu.
+	\pre По адресу state зарезервировано btokSM_keep() октетов.
+	\expect btokSMStart() < btokSMCmdUnwrap2()*.
+	\expect{ERR_BAD_APDU} В apdu[0] установлен бит 0x04 (признак защиты).
+	\expect{ERR_BAD_LOGIC} Непосредственно а момент снятия защиты
+	счетчик SM принимает нечетное значение.
+	\return ERR_OK в случае успеха и код ошибки в противном случае.
+	\remark Если имитовставка неверна, то возвращается код ERR_BAD_MAC,
+	а поле данных команды в apdu очищается (см. memWipe()).
+	\remark Результат согласован с btokSMCmdUnwrap(), но данные не
+	копируются в отдельный буфер.
+*/
+err_t btokSMCmdUnwrap2(
+	apdu_cmd_view_t* view,		/*!< [out] представление команды */
+	octet apdu[],				/*!< [in,out] код / данные команды */
+	size_t count,				/*!< [in] длина кода команды */
+	void* state					/*!< [in,out] состояние SM */
+);
+
 /*!	\brief Кодирование и установка защиты ответа с помощью SM
 
 	Ответ resp кодируется и защищается с помощью объектов SM, размещенных
@@ -630,6 +909,41 @@ err_t btokSMRespWrap(
 	void* state					/*!< [in,out] состояние SM */
 );
 
+/*!	\brief Позиция данных в защищенном ответе
+
+	Определяется смещение, по которому размещаются данные длины rdf_len
+	в защищенном ответе (см. btokSMRespWrap2()).
+	\return Смещение или SIZE_MAX, если rdf_len > 65536.
+*/
+size_t btokSMRespRDFOffset(
+	size_t rdf_len				/*!< [in] длина данных ответа */
+);
+
+/*!	\brief Установка защиты ответа на месте
+
+	Устанавливается защита ответа с данными длины rdf_len и статусами
+	sw1, sw2. Данные ответа должны быть размещены в буфере apdu по смещению
+	btokSMRespRDFOffset(rdf_len). Защищенный ответ формируется в том же
+	буфере [count?]apdu, данные зашифровываются на месте. Если apdu == 0,
+	то определяется только длина защищенного ответа.
+	\pre По адресу state зарезервировано btokSM_keep() октетов.
+	\expect btokSMStart() < btokSMRespWrap2()*.
+	\expect{ERR_BAD_APDU} rdf_len <= 65536.
+	\expect{ERR_BAD_LOGIC} Непосредственно а момент установки защиты
+	(apdu != 0) счетчик SM принимает четное значение.
+	\return ERR_OK в случае успеха и код ошибки в противном случае.
+	\remark Результат совпадает с результатом btokSMRespWrap() для
+	ответа с теми же полями.
+*/
+err_t btokSMRespWrap2(
+	octet apdu[],				/*!< [in,out] данные / код ответа */
+	size_t* count,				/*!< [out] длина кода ответа */
+	size_t rdf_len,				/*!< [in] длина данных ответа */
+	octet sw1,					/*!< [in] первый статус */
+	octet sw2,					/*!< [in] второй статус */
+	void* state					/*!< [in,out] состояние SM */
+);
+
 /*!	\brief Декодирование и снятие защиты ответа с помощью SM
 
 	Код ответа [count]apdu декодируется и одновременно с него снимается
@@ -652,6 +966,28 @@ err_t btokSMRespUnwrap(
 	void* state					/*!< [in,out] состояние SM */
 );
 
+/*!	\brief Снятие защиты ответа на месте
+
+	С кода ответа [count]apdu снимается защита с помощью объектов SM,
+	размещенных в state. Данные ответа расшифровываются на месте, их
+	позиция в apdu возвращается в rdf_offset, а длина -- в rdf_len.
+	Статусы ответа располагаются в последних двух октетах apdu.
+	\pre По адресу state зарезервировано btokSM_keep() октетов.
+	\expect btokSMStart() < btokSMRespUnwrap2()*.
+	\expect{ERR_BAD_LOGIC} Непосредственно а момент снятия защиты
+	счетчик SM принимает четное значение.
+	\return ERR_OK в случае успеха и код ошибки в противном случае.
+	\remark Если имитовставка неверна, то возвращается код ERR_BAD_MAC,
+	а поле данных ответа в apdu очищается (см. memWipe()).
+*/
+err_t btokSMRespUnwrap2(
+	size_t* rdf_offset,			/*!< [out] позиция данных ответа */
+	size_t* rdf_len,			/*!< [out] длина данных ответа */
+	octet apdu[],				/*!< [in,out] код / данные ответа */
+	size_t count,				/*!< [in] длина кода ответа */
+	void* state					/*!< [in,out] состояние SM */
+);
+
 /*!
 *******************************************************************************
 \file btok.h
@@ -718,6 +1054,62 @@ err_t btokBAuthTStart(
 	const bake_cert* cert			/*!< [in] сертификат */
 );
 
+/*!	\brief Длина контекста терминала BAUTH
+
+	Определяется длина контекста (в октетах) терминала протокола BAUTH
+	для уровня стойкости l.
+	\pre l == 128 || l == 192 || l == 256.
+	\return Длина контекста.
+*/
+size_t btokBAuthTCtx_keep(
+	size_t l						/*!< [in] уровень стойкости */
+);
+
+/*!	\brief Создание контекста терминала BAUTH
+
+	По параметрам params, личному ключу [l / 4]privkey и сертификату cert
+	соответствующего открытого ключа в ctx формируется контекст терминала.
+	Контекст передается в btokBAuthTStart2() и позволяет не повторять
+	в каждом сеансе построение описания кривой и проверку ключа
+	и сертификата.
+	\pre По адресу ctx зарезервировано btokBAuthTCtx_keep(params->l)
+	октетов.
+	\expect{ERR_BAD_PARAMS} Параметры params корректны.
+	\expect{ERR_BAD_PRIVKEY} Личный ключ privkey корректен.
+	\expect{ERR_BAD_CERT} Сертификат cert корректен.
+	\return ERR_OK, если контекст создан, и код ошибки в противном случае.
+	\remark В контексте сохраняется копия cert, но не данные cert->data.
+	Данные должны оставаться доступными, пока используется контекст.
+	\remark Контекст после создания не изменяется и может одновременно
+	использоваться в нескольких потоках. Контекст не может перемещаться
+	в памяти (см. bignCtxStart()).
+*/
+err_t btokBAuthTCtxStart(
+	void* ctx,						/*!< [out] контекст */
+	const bign_params* params,		/*!< [in] долговременные параметры */
+	const octet privkey[],			/*!< [in] личный ключ */
+	const bake_cert* cert			/*!< [in] сертификат */
+);
+
+/*!	\brief Инициализация протокола BAUTH на стороне Т с контекстом
+
+	Аналог btokBAuthTStart() с долговременными параметрами, личным ключом
+	и сертификатом из контекста ctx. Дальнейшие шаги протокола выполняются
+	так же, как после btokBAuthTStart().
+	\pre По адресу state зарезервировано btokBAuthT_keep() октетов.
+	\expect{ERR_BAD_INPUT} Контекст ctx создан в btokBAuthTCtxStart().
+	\expect{ERR_BAD_INPUT} settings->kca == TRUE.
+	\expect{ERR_BAD_RNG} Генератор settings->rng (с состоянием
+	settings->rng_state) корректен.
+	\return ERR_OK, если инициализация успешно выполнена, и код ошибки
+	в противном случае.
+*/
+err_t btokBAuthTStart2(
+	void* state,					/*!< [out] состояние */
+	const void* ctx,				/*!< [in] контекст */
+	const bake_settings* settings	/*!< [in] настройки */
+);
+
 /*!	\brief Длина состояния функций BAUTH на стороне КТ
 
 	Определяется длина состояния (в октетах) функций протокола BAUTH на
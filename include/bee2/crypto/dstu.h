@@ -4,7 +4,7 @@
 \brief DSTU 4145-2002 (Ukraine): digital signature algorithms
 \project bee2 [cryptographic library]
 \created 2012.04.27
-\version 2023.09.22
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -201,6 +201,60 @@ err_t dstuPointRecover(
 	const octet xpoint[]			/*!< [in] сжатая точка */
 );
 
+/*!	\brief Пакетное сжатие точек
+
+	Точки points[i] эллиптической кривой, заданной долговременными
+	параметрами params, сжимаются в точки xpoints[i], i = 0, 1,...,
+	count - 1. Точки и сжатые точки последовательно записаны в массивы
+	[count * 2 * O_OF_B(m)]points и [count * O_OF_B(m)]xpoints. Если
+	codes != 0, то в codes[i] записывается ERR_OK, если i-я точка сжата,
+	и ERR_BAD_POINT, если ее координаты некорректны (как в
+	dstuPointCompress()). Сжатые некорректные точки не определяются.
+	\expect{ERR_BAD_PARAMS} Параметры params корректны.
+	\return ERR_OK, если все точки сжаты, ERR_BAD_POINT, если хотя бы одна
+	точка некорректна, и другой код ошибки в остальных случаях.
+	\remark Точки обрабатываются пакетами, в каждом пакете выполняется одно
+	обращение в базовом поле вместо обращения для каждой точки.
+	\remark Буферы points и xpoints могут совпадать.
+*/
+err_t dstuPointCompressBatch(
+	octet xpoints[],				/*!< [out] сжатые точки */
+	err_t codes[],					/*!< [out] коды ошибок для точек */
+	const dstu_params* params,		/*!< [in] параметры */
+	size_t count,					/*!< [in] число точек */
+	const octet points[]			/*!< [in] сжимаемые точки */
+);
+
+/*!	\brief Пакетное восстановление точек
+
+	Точки points[i] эллиптической кривой, заданной долговременными
+	параметрами params, восстанавливаются по сжатым точкам xpoints[i],
+	i = 0, 1,..., count - 1. Сжатые точки и точки последовательно записаны
+	в массивы [count * O_OF_B(m)]xpoints и [count * 2 * O_OF_B(m)]points.
+	Если codes != 0, то в codes[i] записывается ERR_OK, если i-я точка
+	восстановлена, и ERR_BAD_POINT, если сжатая точка некорректна:
+	ее координата не является элементом поля либо ей не соответствует
+	точка кривой. Восстановленные некорректные точки не определяются.
+	\expect{ERR_BAD_PARAMS} Параметры params корректны.
+	\return ERR_OK, если все точки восстановлены, ERR_BAD_POINT, если
+	хотя бы одна сжатая точка некорректна, и другой код ошибки в остальных
+	случаях.
+	\remark Точки обрабатываются пакетами, в каждом пакете выполняется одно
+	обращение в базовом поле вместо обращения для каждой точки.
+	При большом числе точек квадратные уравнения решаются с помощью
+	таблицы полуследов (см. gf2HTr()).
+	\remark В отличие от dstuPointRecover(), отсутствие решения квадратного
+	уравнения означает некорректность сжатой точки, а не параметров.
+	\remark Буферы points и xpoints не пересекаются.
+*/
+err_t dstuPointRecoverBatch(
+	octet points[],					/*!< [out] восстановленные точки */
+	err_t codes[],					/*!< [out] коды ошибок для точек */
+	const dstu_params* params,		/*!< [in] параметры */
+	size_t count,					/*!< [in] число точек */
+	const octet xpoints[]			/*!< [in] сжатые точки */
+);
+
 /*
 *******************************************************************************
 Управление ключами
@@ -279,6 +333,83 @@ err_t dstuVerify(
 	const octet pubkey[]			/*!< [in] открытый ключ */
 );
 
+/*
+*******************************************************************************
+Контекст
+
+Каждая из функций dstuSign(), dstuVerify() строит по долговременным
+параметрам описания базового поля и эллиптической кривой. При многократном
+использовании одних и тех же параметров описания можно построить один раз:
+сохранить в контексте (функция dstuCtxStart()) и передавать контекст
+функциям dstuSignCtx(), dstuVerifyCtx().
+
+Дополнительно в контексте сохраняется таблица кратных базовой точки P.
+По таблице кратные P вычисляются гребенчатым методом, что ускоряет
+выработку и проверку ЭЦП.
+
+Контекст после создания не изменяется. Поэтому его можно одновременно
+использовать в нескольких потоках. Контекст содержит указатели на свои же
+внутренние данные и не может перемещаться в памяти.
+
+Функции с контекстом действуют так же, как одноименные функции
+с параметрами, и возвращают такие же коды ошибок. Если контекст
+не работоспособен, то возвращается код ERR_BAD_INPUT.
+*******************************************************************************
+*/
+
+/*!	\brief Длина контекста
+
+	Возвращается длина контекста, создаваемого по долговременным параметрам
+	над полем GF(2^m).
+	\pre 160 <= m <= 509.
+	\return Длина контекста.
+*/
+size_t dstuCtx_keep(
+	size_t m						/*!< [in] степень расширения (p[0]) */
+);
+
+/*!	\brief Создание контекста
+
+	По долговременным параметрам params по адресу ctx создается контекст.
+	\pre По адресу ctx зарезервировано dstuCtx_keep(params->p[0]) октетов.
+	\expect{ERR_BAD_PARAMS} Параметры params корректны.
+	\return ERR_OK, если контекст создан, и код ошибки в противном случае.
+	\remark Параметры params не проверяются так полно, как в
+	dstuParamsVal(). Их рекомендуется проверить предварительно.
+*/
+err_t dstuCtxStart(
+	void* ctx,						/*!< [out] контекст */
+	const dstu_params* params		/*!< [in] долговременные параметры */
+);
+
+/*!	\brief Выработка ЭЦП с контекстом
+
+	Аналог dstuSign() с долговременными параметрами из контекста ctx.
+*/
+err_t dstuSignCtx(
+	octet sig[],					/*!< [out] подпись */
+	const void* ctx,				/*!< [in] контекст */
+	size_t ld,						/*!< [in] длина подписи в битах */
+	const octet hash[],				/*!< [in] хэш-значение */
+	size_t hash_len,				/*!< [in] длина хэш-значения в октетах */
+	const octet privkey[],			/*!< [in] личный ключ */
+	gen_i rng,						/*!< [in] генератор случайных чисел */
+	void* rng_state					/*!< [in,out] состояние генератора */
+);
+
+/*!	\brief Проверка ЭЦП с контекстом
+
+	Аналог dstuVerify() с долговременными параметрами из контекста ctx.
+*/
+err_t dstuVerifyCtx(
+	const void* ctx,				/*!< [in] контекст */
+	size_t ld,						/*!< [in] длина подписи в битах */
+	const octet hash[],				/*!< [in] хэш-значение */
+	size_t hash_len,				/*!< [in] длина хэш-значения в октетах */
+	const octet sig[],				/*!< [in] подпись */
+	const octet pubkey[]			/*!< [in] открытый ключ */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief GOST R 34.10-94 (Russia): digital signature algorithms
 \project bee2 [cryptographic library]
 \created 2012.04.27
-\version 2023.09.22
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -225,6 +225,81 @@ err_t g12sVerify(
 	const octet pubkey[]		/*!< [in] открытый ключ */
 );
 
+/*!
+*******************************************************************************
+\file g12s.h
+
+\section g12s-ctx Контекст
+
+Каждая из функций g12sSign(), g12sVerify() строит по долговременным
+параметрам описания базового поля и эллиптической кривой. При многократном
+использовании одних и тех же параметров описания можно построить один раз:
+сохранить в контексте (функция g12sCtxStart()) и передавать контекст
+функциям g12sSignCtx(), g12sVerifyCtx().
+
+Дополнительно в контексте сохраняется таблица кратных базовой точки P.
+По таблице кратные P вычисляются гребенчатым методом, что ускоряет
+выработку и проверку ЭЦП.
+
+Контекст после создания не изменяется. Поэтому его можно одновременно
+использовать в нескольких потоках. Контекст содержит указатели на свои же
+внутренние данные и не может перемещаться в памяти.
+
+Функции с контекстом действуют так же, как одноименные функции
+с параметрами, и возвращают такие же коды ошибок. Если контекст
+не работоспособен, то возвращается код ERR_BAD_INPUT.
+*******************************************************************************
+*/
+
+/*!	\brief Длина контекста
+
+	Возвращается длина контекста, создаваемого по долговременным параметрам
+	с уровнем стойкости l.
+	\pre l == 256 || l == 512.
+	\return Длина контекста.
+*/
+size_t g12sCtx_keep(
+	size_t l					/*!< [in] уровень стойкости (params->l) */
+);
+
+/*!	\brief Создание контекста
+
+	По долговременным параметрам params по адресу ctx создается контекст.
+	\pre По адресу ctx зарезервировано g12sCtx_keep(params->l) октетов.
+	\expect{ERR_BAD_PARAMS} Параметры params корректны.
+	\return ERR_OK, если контекст создан, и код ошибки в противном случае.
+	\remark Параметры params не проверяются так полно, как в
+	g12sParamsVal(). Их рекомендуется проверить предварительно.
+*/
+err_t g12sCtxStart(
+	void* ctx,					/*!< [out] контекст */
+	const g12s_params* params	/*!< [in] долговременные параметры */
+);
+
+/*!	\brief Выработка ЭЦП с контекстом
+
+	Аналог g12sSign() с долговременными параметрами из контекста ctx.
+*/
+err_t g12sSignCtx(
+	octet sig[],				/*!< [out] подпись */
+	const void* ctx,			/*!< [in] контекст */
+	const octet hash[],			/*!< [in] хэш-значение */
+	const octet privkey[],		/*!< [in] личный ключ */
+	gen_i rng,					/*!< [in] генератор случайных чисел */
+	void* rng_state				/*!< [in,out] состояние генератора */
+);
+
+/*!	\brief Проверка ЭЦП с контекстом
+
+	Аналог g12sVerify() с долговременными параметрами из контекста ctx.
+*/
+err_t g12sVerifyCtx(
+	const void* ctx,			/*!< [in] контекст */
+	const octet hash[],			/*!< [in] хэш-значение */
+	const octet sig[],			/*!< [in] подпись */
+	const octet pubkey[]		/*!< [in] открытый ключ */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief Draft of RD_RB: key establishment protocols in finite fields
 \project bee2 [cryptographic library]
 \created 2014.06.30
-\version 2024.01.11
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -101,6 +101,16 @@ extern "C" {
 Поэтому в функцию генерации параметров можно передавать указатель на функцию
 интерфейса pfok_on_q_i, которая получает управление при построении каждого 
 нового кандидата q.
+
+Кроме того, генерацию можно выполнять по шагам: функция
+pfokParamsGenStart() готовит состояние генерации, функция
+pfokParamsGenStep() продолжает генерацию до построения параметров
+или заданного числа кандидатов q. Состояние не содержит указателей,
+его можно сохранить между шагами (например, в файл) и затем продолжить
+генерацию по сохраненной копии, в том числе в другом процессе. Кандидаты
+при расширении простых проверяются в нескольких потоках. Результат
+генерации не зависит ни от числа потоков, ни от разбиения на шаги
+и совпадает с результатом pfokParamsGen().
 *******************************************************************************
 */
 
@@ -209,6 +219,55 @@ err_t pfokParamsGen(
 	pfok_on_q_i on_q		/*!< [in] обработчик */
 );
 
+/*!	\brief Длина состояния генерации долговременных параметров
+
+	Возвращается длина состояния (в октетах) функций пошаговой генерации
+	долговременных параметров с битовой длиной l.
+	\return Длина состояния.
+*/
+size_t pfokParamsGen_keep(
+	size_t l				/*!< [in] битовая длина p */
+);
+
+/*!	\brief Начало генерации долговременных параметров
+
+	По затравочным параметрам seed в state готовится состояние генерации
+	долговременных параметров.
+	\pre По адресу state зарезервировано pfokParamsGen_keep(seed->l)
+	октетов.
+	\return ERR_OK, если состояние подготовлено, и код ошибки в противном
+	случае.
+*/
+err_t pfokParamsGenStart(
+	void* state,			/*!< [out] состояние */
+	const pfok_seed* seed	/*!< [in] затравочные параметры */
+);
+
+/*!	\brief Шаг генерации долговременных параметров
+
+	Генерация долговременных параметров params, которая описывается
+	состоянием state, продолжается до тех пор, пока параметры не будут
+	построены или не будет построено max новых кандидатов q. Кандидаты
+	при расширении простых проверяются в threads потоках. При построении
+	очередного кандидата q вызывается функция on_q (нумерация кандидатов
+	сквозная для всех шагов).
+	\pre Состояние state подготовлено функцией pfokParamsGenStart()
+	и, возможно, изменено предыдущими шагами.
+	\return ERR_OK, если параметры построены, ERR_NOT_READY, если
+	построено max кандидатов, а параметры еще не построены, и код ошибки
+	в противном случае.
+	\remark Повторный вызов функции после построения параметров снова
+	возвращает те же параметры.
+	\remark При threads == 0 используется один поток.
+*/
+err_t pfokParamsGenStep(
+	pfok_params* params,	/*!< [out] долговременные параметры */
+	void* state,			/*!< [in,out] состояние */
+	size_t max,				/*!< [in] максимальное число кандидатов */
+	size_t threads,			/*!< [in] число потоков */
+	pfok_on_q_i on_q		/*!< [in] обработчик */
+);
+
 /*!	\brief Проверка долговременных параметров
 
 	Проверяется, что долговременные параметры params корректны. Для полей 
@@ -347,6 +406,104 @@ err_t pfokMTI(
 	const octet pubkey1[]		/*!< [in] однораз. откр. ключ (др. стороны) */
 );
 
+/*!
+*******************************************************************************
+\file pfok.h
+
+\section pfok-ctx Контекст
+
+Каждая из функций pfokKeypairGen(), pfokPubkeyCalc(), pfokDH(), pfokMTI()
+строит по долговременным параметрам описание кольца Монтгомери по модулю p.
+При многократном использовании одних и тех же параметров описание можно
+построить один раз: сохранить в контексте (функция pfokCtxStart())
+и передавать контекст функциям pfokKeypairGenCtx(), pfokPubkeyCalcCtx(),
+pfokDHCtx(), pfokMTICtx().
+
+Дополнительно в контексте сохраняется таблица степеней образующего g.
+По таблице степени g вычисляются гребенчатым методом, что ускоряет
+генерацию ключей и построение открытого ключа по личному. Время 
+вычисления степеней g, как и без контекста, не зависит от личного ключа.
+
+Контекст после создания не изменяется. Поэтому его можно одновременно
+использовать в нескольких потоках. Контекст содержит указатели на свои же
+внутренние данные и не может перемещаться в памяти.
+
+Функции с контекстом действуют так же, как одноименные функции
+с параметрами, и возвращают такие же коды ошибок. Если контекст
+не работоспособен, то возвращается код ERR_BAD_INPUT.
+*******************************************************************************
+*/
+
+/*!	\brief Длина контекста
+
+	Возвращается длина контекста, создаваемого по долговременным параметрам
+	с модулем p битовой длины l.
+	\return Длина контекста.
+*/
+size_t pfokCtx_keep(
+	size_t l					/*!< [in] битовая длина p (params->l) */
+);
+
+/*!	\brief Создание контекста
+
+	По долговременным параметрам params по адресу ctx создается контекст.
+	\pre По адресу ctx зарезервировано pfokCtx_keep(params->l) октетов.
+	\expect{ERR_BAD_PARAMS} Параметры params корректны.
+	\return ERR_OK, если контекст создан, и код ошибки в противном случае.
+	\remark Параметры params не проверяются так полно, как в
+	pfokParamsVal(). Их рекомендуется проверить предварительно.
+*/
+err_t pfokCtxStart(
+	void* ctx,					/*!< [out] контекст */
+	const pfok_params* params	/*!< [in] долговременные параметры */
+);
+
+/*!	\brief Генерация пары ключей с контекстом
+
+	Аналог pfokKeypairGen() с долговременными параметрами из контекста ctx.
+*/
+err_t pfokKeypairGenCtx(
+	octet privkey[],			/*!< [out] личный ключ */
+	octet pubkey[],				/*!< [out] открытый ключ */
+	const void* ctx,			/*!< [in] контекст */
+	gen_i rng,					/*!< [in] генератор случайных чисел */
+	void* rng_state				/*!< [in,out] состояние генератора */
+);
+
+/*!	\brief Построение открытого ключа по личному с контекстом
+
+	Аналог pfokPubkeyCalc() с долговременными параметрами из контекста ctx.
+*/
+err_t pfokPubkeyCalcCtx(
+	octet pubkey[],				/*!< [out] открытый ключ */
+	const void* ctx,			/*!< [in] контекст */
+	const octet privkey[]		/*!< [in] личный ключ */
+);
+
+/*!	\brief Построение общего ключа протокола Диффи -- Хеллмана с контекстом
+
+	Аналог pfokDH() с долговременными параметрами из контекста ctx.
+*/
+err_t pfokDHCtx(
+	octet sharekey[],			/*!< [out] общий ключ */
+	const void* ctx,			/*!< [in] контекст */
+	const octet privkey[],		/*!< [in] личный ключ */
+	const octet pubkey[]		/*!< [in] открытый ключ (другой стороны) */
+);
+
+/*!	\brief Построение общего ключа протокола MTI с контекстом
+
+	Аналог pfokMTI() с долговременными параметрами из контекста ctx.
+*/
+err_t pfokMTICtx(
+	octet sharekey[],			/*!< [out] общий ключ */
+	const void* ctx,			/*!< [in] контекст */
+	const octet privkey[],		/*!< [in] личный ключ */
+	const octet privkey1[],		/*!< [in] одноразовый личный ключ */
+	const octet pubkey[],		/*!< [in] открытый ключ (другой стороны) */
+	const octet pubkey1[]		/*!< [in] однораз. откр. ключ (др. стороны) */
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
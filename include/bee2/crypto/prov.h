@@ -0,0 +1,155 @@
+/*
+*******************************************************************************
+\file prov.h
+\brief Cryptographic providers
+\project bee2 [cryptographic library]
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+/*!
+*******************************************************************************
+\file prov.h
+\brief Криптографические провайдеры
+*******************************************************************************
+*/
+
+#ifndef __BEE2_PROV_H
+#define __BEE2_PROV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "bee2/defs.h"
+#include "bee2/crypto/bign.h"
+
+/*!
+*******************************************************************************
+\file prov.h
+
+\section prov-common Общие положения
+
+Провайдер -- внешняя реализация (аппаратный ускоритель, HSM) массовых
+криптографических операций. Провайдер описывается таблицей функций prov_o
+(по аналогии с описаниями колец qr_o и кривых ec_o). Функции таблицы
+перехватывают следующие операции библиотеки:
+-	block_encr / block_decr -- зашифрование / расшифрование нескольких
+	форматированных блоков (beltBlockEncrN(), beltBlockDecrN() и,
+	следовательно, режимы belt, построенные на этих функциях);
+-	hash_mb -- хэширование нескольких сообщений (beltHashMB());
+-	sign_batch -- пакетная выработка ЭЦП (bignSignBatch());
+-	verify_batch -- пакетная проверка ЭЦП (bignVerifyBatch());
+-	rng -- выдача случайных чисел (rngStepR(), rngStepR2(), rngStepR3()).
+.
+
+Любая функция таблицы может быть нулевой. Функция, которая не может
+выполнить операцию (например, для неподдерживаемой кривой), должна
+вернуть ERR_NOT_IMPLEMENTED, не изменяя выходных данных. В обоих
+случаях операция выполняется программной реализацией библиотеки.
+Иные коды возврата считаются результатом операции. Исключение -- функции
+block_encr, block_decr и rng: они перехватывают операции, которые
+не возвращают кодов ошибок, поэтому при любом коде, отличном от ERR_OK,
+операция выполняется библиотекой. Такие функции при ошибке не должны
+изменять выходные данные. Кроме того, функция rng не используется
+в режиме paranoid (см. rngSetParanoid()). Функции таблицы получают
+последним аргументом состояние провайдера state.
+
+Провайдеры регистрируются функцией provRegister(), активный провайдер
+выбирается функцией provSelect(). По умолчанию активного провайдера нет,
+т.е. используется программная реализация (провайдер "BEE2").
+Регистрация и выбор могут выполняться во время работы программы
+в любом потоке. Зарегистрированный провайдер (таблица и состояние)
+должен оставаться доступным до завершения программы.
+
+Перед вызовом функций провайдера выполняется проверка входных данных,
+как в соответствующих функциях библиотеки. Функции провайдера вызываются
+одновременно из нескольких потоков и должны быть потокобезопасными.
+
+\warning Если провайдер вырабатывает подписи со своими одноразовыми
+ключами, то подписи bignSignBatch() не совпадают с подписями bignSignCtx()
+с тем же генератором.
+*******************************************************************************
+*/
+
+/*!	\brief Описание провайдера */
+typedef struct
+{
+	const char* name;	/*!< название */
+	void* state;		/*!< состояние */
+	/*!	\brief Зашифрование форматированных блоков */
+	err_t (*block_encr)(u32 blocks[], size_t count, const u32 key[8],
+		void* state);
+	/*!	\brief Расшифрование форматированных блоков */
+	err_t (*block_decr)(u32 blocks[], size_t count, const u32 key[8],
+		void* state);
+	/*!	\brief Хэширование n сообщений (как в beltHashMB()) */
+	err_t (*hash_mb)(octet hash[], const void* const src[],
+		const size_t count[], size_t n, void* state);
+	/*!	\brief Выработка count подписей (как в bignSignBatch())
+		на параметрах params */
+	err_t (*sign_batch)(err_t codes[], octet sigs[],
+		const bign_params* params, const octet oid_der[], size_t oid_len,
+		size_t count, const octet hashes[], const octet privkeys[],
+		gen_i rng, void* rng_state, void* state);
+	/*!	\brief Проверка count подписей (как в bignVerifyBatch()) */
+	err_t (*verify_batch)(size_t* bad, const bign_params* params,
+		const octet oid_der[], size_t oid_len, size_t count,
+		const octet hashes[], const octet sigs[], const octet pubkeys[],
+		void* state);
+	/*!	\brief Выдача count случайных октетов в buf */
+	err_t (*rng)(void* buf, size_t count, void* state);
+} prov_o;
+
+/*!	\brief Регистрация провайдера
+
+	Регистрируется провайдер prov.
+	\expect{ERR_BAD_INPUT} Таблица prov корректна, prov->name -- непустая
+	строка, отличная от "BEE2".
+	\return ERR_OK, если провайдер зарегистрирован, и код ошибки в противном
+	случае (ERR_ALREADY_EXISTS, если провайдер с тем же названием уже
+	зарегистрирован, ERR_OVERFLOW, если зарегистрировано максимальное
+	число провайдеров (8), ERR_SYS, если не удалось создать мьютекс
+	реестра).
+	\remark Регистрация не делает провайдер активным.
+*/
+err_t provRegister(
+	const prov_o* prov		/*!< [in] провайдер */
+);
+
+/*!	\brief Выбор провайдера
+
+	Активным становится провайдер с названием name. Если name == 0 или
+	name == "BEE2", то активного провайдера нет и используется программная
+	реализация.
+	\return ERR_OK, если провайдер выбран, и ERR_NOT_FOUND, если провайдер
+	с названием name не зарегистрирован.
+	\remark Операции, которые уже начаты, завершаются с прежним провайдером.
+*/
+err_t provSelect(
+	const char* name		/*!< [in] название провайдера */
+);
+
+/*!	\brief Активный провайдер
+
+	Возвращается активный провайдер.
+	\return Активный провайдер или 0, если используется программная
+	реализация.
+*/
+const prov_o* provActive();
+
+/*!	\brief Название активного провайдера
+
+	Возвращается название активного провайдера.
+	\return Название провайдера ("BEE2" для программной реализации).
+*/
+const char* provName();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __BEE2_PROV_H */
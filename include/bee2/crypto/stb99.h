@@ -4,7 +4,7 @@
 \brief STB 1176.2-99: generation of parameters
 \project bee2 [cryptographic library]
 \created 2023.08.01
-\version 2023.09.22
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 #include "bee2/defs.h"
+#include "bee2/core/mt.h"
 
 /*!
 *******************************************************************************
@@ -192,6 +193,31 @@ err_t stb99ParamsGen(
 	const stb99_seed* seed		/*!< [in] затравочные параметры */
 );
 
+/*!	\brief Генерация долговременных параметров по нескольким затравкам
+
+	Долговременные параметры params генерируются параллельно по count
+	затравкам. Затравка с номером j отличается от seed только числом
+	zi[0], которое заменяется на ((seed->zi[0] - 1 + j) mod 65256) + 1.
+	Генерации выполняются задачами пула pool. Результатом являются
+	параметры, построенные первой завершившейся генерацией. Ее затравка
+	возвращается в seed.
+	\pre 0 < count <= 65256.
+	\expect{ERR_BAD_SEED} Затравочные параметры seed корректны.
+	\return ERR_OK, если параметры успешно сгенерированы, и код ошибки
+	в противном случае.
+	\remark Выбор затравки зависит от планирования потоков. Однако
+	параметры воспроизводимы: stb99ParamsGen() по возвращенной затравке
+	seed строит те же params.
+	\remark Если pool == 0, то генерации выполняются последовательно
+	и возвращаются результат и затравка stb99ParamsGen(params, seed).
+*/
+err_t stb99ParamsGenMT(
+	stb99_params* params,		/*!< [out] долговременные параметры */
+	stb99_seed* seed,			/*!< [in,out] затравочные параметры */
+	size_t count,				/*!< [in] число затравок */
+	mt_pool_t* pool				/*!< [in,out] пул потоков */
+);
+
 /*!	\brief Проверка долговременных параметров
 
 	Проверяется, что долговременные параметры params корректны:
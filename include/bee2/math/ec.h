@@ -4,7 +4,7 @@
 \brief Elliptic curves
 \project bee2 [cryptographic library]
 \created 2012.04.19
-\version 2023.03.30
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -98,7 +98,7 @@ ec->order задается 2 * ec->f->n + 1 машинным словом. Ко
 криптографические вычисления на эллиптической кривой. 
 
 Описание ec эллиптической кривой включает указатели на функции арифметики 
-в группе точек этой кривой. Функцию интерфейса ec_tpl_i
+в группе точек этой кривой. Функции интерфейсов ec_dbln_i и ec_tpl_i
 можно не поддерживать. Указатель на неподдерживаемую функцию 
 должен быть нулевым.
 
@@ -183,6 +183,30 @@ typedef bool_t (*ec_toa_i)(
 	void* stack				/*!< [in] вспомогательная память */
 );
 
+/*!	\brief Пакетный экспорт в аффинные точки
+
+	По точкам [count * ec->d * ec->f->n]a эллиптической кривой ec строятся
+	аффинные точки [count * 2 * ec->f->n]b. Выполняется одно обращение
+	в базовом поле (см. qrInvBatch()).
+	\pre Описание ec работоспособно.
+	\pre Буферы a и b не пересекаются.
+	\pre Координаты a лежат в базовом поле.
+	\expect Описание ec корректно.
+	\expect Точки a лежат на кривой.
+	\return TRUE, если все аффинные точки построены, и FALSE, если хотя бы
+	одной из точек a соответствует бесконечно удаленная точка (такой точке
+	соответствует неопределенная аффинная точка).
+	\remark Размер вспомогательной памяти:
+	O_OF_W(2 * count * ec->f->n) + ec->deep.
+*/
+typedef bool_t (*ec_toan_i)(
+	word b[],				/*!< [out] аффинные точки */
+	const word a[],			/*!< [in] входные точки */
+	size_t count,			/*!< [in] число точек */
+	const struct ec_o* ec,	/*!< [in] описание эллиптической кривой */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
 /*!	\brief Обратная точка
 
 	На эллиптической кривой ec определяется точка [ec->d * ec->f->n]b,
@@ -332,6 +356,30 @@ typedef void (*ec_dbla_i)(
 	void* stack				/*!< [in] вспомогательная память */
 );
 
+/*!	\brief Кратное удвоение точки
+
+	На эллиптической кривой ec определяется точка [ec->d * ec->f->n]b,
+	полученная k-кратным удвоением точки [ec->d * ec->f->n]a:
+	\code
+		b <- 2^k a.
+	\endcode
+	\pre Описание ec работоспособно.
+	\pre Буфер b либо не пересекается, либо совпадает с буфером a.
+	\pre Координаты a лежат в базовом поле.
+	\expect Описание ec корректно.
+	\expect Точка a лежит на кривой.
+	\remark Реализация должна быть быстрее k вызовов ec->dbl, например, за
+	счет переноса между удвоениями промежуточных значений.
+	\remark Размер вспомогательной памяти: ec->deep.
+*/
+typedef void (*ec_dbln_i)(
+	word b[],				/*!< [out] кратная точка */
+	const word a[],			/*!< [in] первоначальная точка */
+	size_t k,				/*!< [in] число удвоений */
+	const struct ec_o* ec,	/*!< [in] описание эллиптической кривой */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
 /*!	\brief Утроение точки
 
 	На эллиптической кривой ec определяется точка [ec->d * ec->f->n]b, 
@@ -374,6 +422,7 @@ typedef struct ec_o
 	word cofactor;			/*!< кофактор группы точек */
 	ec_froma_i froma;		/*!< функция импорта из аффинной точки */
 	ec_toa_i toa;			/*!< функция экспорта в аффинную точку */
+	ec_toan_i toan;			/*!< функция пакетного экспорта (или 0) */
 	ec_neg_i neg;			/*!< функция обращения */
 	ec_add_i add;			/*!< функция сложения */
 	ec_adda_i adda;			/*!< функция сложения с аффинной точкой */
@@ -381,6 +430,7 @@ typedef struct ec_o
 	ec_suba_i suba;			/*!< функция вычитания аффинной точки */
 	ec_dbl_i dbl;			/*!< функция удвоения */
 	ec_dbla_i dbla;			/*!< функция удвоения аффинной точки */
+	ec_dbln_i dbln;			/*!< функция кратного удвоения (или 0) */
 	ec_tpl_i tpl;			/*!< функция утроения */
 	size_t deep;			/*!< максимальная глубина стека функций */
 	octet descr[];			/*!< память для размещения данных */
@@ -401,22 +451,42 @@ typedef struct ec_o
 #define ecZ(pt, n)\
 	((pt) + (n) + (n))
 
+#ifdef BEE2_INSTRUMENT
+
 #define ecFromA(b, a, ec, stack)\
-	(ec)->froma(b, a, ec, stack)
+	(opcntInc(ec_froma), (ec)->froma(b, a, ec, stack))
 
 #define ecToA(b, a, ec, stack)\
-	(ec)->toa(b, a, ec, stack)
+	(opcntInc(ec_toa), (ec)->toa(b, a, ec, stack))
 
-#define ecFrom(b, a, ec, stack)\
-	(qrFrom(ecX(b), a, (ec)->f, stack) &&\
-		qrFrom(ecY(b, (ec)->f->n), (a) + (ec)->f->no, (ec)->f, stack) &&\
-			ecFromA(b, b, ec, stack))
+#define ecNeg(b, a, ec, stack)\
+	(opcntInc(ec_neg), (ec)->neg(b, a, ec, stack))
 
-#define ecTo(b, a, ec, stack)\
-	(ecToA(b, a, ec, stack) ?\
-		qrTo((b), ecX(b), (ec)->f, stack),\
-			qrTo((b) + (ec)->f->no, ecY(b, (ec)->f->n), (ec)->f, stack),\
-		TRUE : FALSE)
+#define ecAdd(c, a, b, ec, stack)\
+	(opcntInc(ec_add), (ec)->add(c, a, b, ec, stack))
+
+#define ecAddA(c, a, b, ec, stack)\
+	(opcntInc(ec_adda), (ec)->adda(c, a, b, ec, stack))
+
+#define ecSub(c, a, b, ec, stack)\
+	(opcntInc(ec_sub), (ec)->sub(c, a, b, ec, stack))
+
+#define ecSubA(c, a, b, ec, stack)\
+	(opcntInc(ec_suba), (ec)->suba(c, a, b, ec, stack))
+
+#define ecDbl(b, a, ec, stack)\
+	(opcntInc(ec_dbl), (ec)->dbl(b, a, ec, stack))
+
+#define ecDblA(b, a, ec, stack)\
+	(opcntInc(ec_dbla), (ec)->dbla(b, a, ec, stack))
+
+#else
+
+#define ecFromA(b, a, ec, stack)\
+	(ec)->froma(b, a, ec, stack)
+
+#define ecToA(b, a, ec, stack)\
+	(ec)->toa(b, a, ec, stack)
 
 #define ecNeg(b, a, ec, stack)\
 	(ec)->neg(b, a, ec, stack)
@@ -439,8 +509,21 @@ typedef struct ec_o
 #define ecDblA(b, a, ec, stack)\
 	(ec)->dbla(b, a, ec, stack)
 
+#endif /* BEE2_INSTRUMENT */
+
+#define ecFrom(b, a, ec, stack)\
+	(qrFrom(ecX(b), a, (ec)->f, stack) &&\
+		qrFrom(ecY(b, (ec)->f->n), (a) + (ec)->f->no, (ec)->f, stack) &&\
+			ecFromA(b, b, ec, stack))
+
+#define ecTo(b, a, ec, stack)\
+	(ecToA(b, a, ec, stack) ?\
+		qrTo((b), ecX(b), (ec)->f, stack),\
+			qrTo((b) + (ec)->f->no, ecY(b, (ec)->f->n), (ec)->f, stack),\
+		TRUE : FALSE)
+
 #define ecSetO(a, ec)\
-	wwSetZero(ecZ(a, (ec)->f->n), (ec)->f->n)
+	wwSetZero(a, (ec)->d * (ec)->f->n)
 
 #define ecIsO(a, ec)\
 	wwIsZero(ecZ(a, (ec)->f->n), (ec)->f->n)
@@ -536,12 +619,68 @@ bool_t ecIsOperableGroup(
 	const ec_o* ec			/*!< [in] описание кривой */
 );
 
+/*
+*******************************************************************************
+Кратное удвоение
+*******************************************************************************
+*/
+
+/*!	\brief Кратное удвоение
+
+	На эллиптической кривой ec определяется точка [ec->d * ec->f->n]b,
+	полученная k-кратным удвоением точки [ec->d * ec->f->n]a:
+	\code
+		b <- 2^k a.
+	\endcode
+	Если задана функция ec->dbln, то используется она, иначе выполняется
+	k вызовов ec->dbl.
+	\pre Описание ec работоспособно.
+	\pre Буфер b либо не пересекается, либо совпадает с буфером a.
+	\pre Координаты a лежат в базовом поле.
+	\expect Описание ec корректно.
+	\expect Точка a лежит на кривой.
+	\remark При k == 0 точка a копируется в b.
+	\deep{stack} ec->deep.
+*/
+void ecDblN(
+	word b[],				/*!< [out] кратная точка */
+	const word a[],			/*!< [in] первоначальная точка */
+	size_t k,				/*!< [in] число удвоений */
+	const ec_o* ec,			/*!< [in] описание кривой */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
 /*
 *******************************************************************************
 Макрооперации с аффинными точками
 *******************************************************************************
 */
 
+/*!	\brief Пакетный экспорт в аффинные точки
+
+	По точкам [count * ec->d * ec->f->n]a эллиптической кривой ec строятся
+	аффинные точки [count * 2 * ec->f->n]b. Если задана функция ec->toan,
+	то используется она, иначе точки экспортируются по одной с помощью
+	ec->toa.
+	\pre Описание ec работоспособно.
+	\pre Буферы a и b не пересекаются.
+	\pre Координаты a лежат в базовом поле.
+	\expect Описание ec корректно.
+	\expect Точки a лежат на ec.
+	\return TRUE, если все аффинные точки построены, и FALSE, если хотя бы
+	одной из точек a соответствует бесконечно удаленная точка.
+	\deep{stack} ecToABatch_deep(ec->f->n, ec->deep, count).
+*/
+bool_t ecToABatch(
+	word b[],				/*!< [out] аффинные точки */
+	const word a[],			/*!< [in] входные точки */
+	size_t count,			/*!< [in] число точек */
+	const ec_o* ec,			/*!< [in] описание кривой */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
+size_t ecToABatch_deep(size_t n, size_t ec_deep, size_t count);
+
 /*!	\brief Кратная точка
 
 	Определяется аффинная точка [2 * ec->f->n]b эллиптической кривой ec, 
@@ -568,6 +707,206 @@ bool_t ecMulA(
 
 size_t ecMulA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t m);
 
+/*!	\brief Кодирование кратности
+
+	Рассчитывается кодированное представление [2 * m + 2]code кратности [m]d,
+	которое используется в ecMulANAF(). Представление содержит оконную NAF
+	кратности (см. wwNAF()) с длиной окна, которую выбирает ecMulA().
+	\remark Кодирование рекомендуется выполнять один раз для кратности,
+	которая умножается на разные точки (например, для долговременного
+	личного ключа в протоколах выработки общего ключа).
+	\pre Буфер code не пересекается с буфером d.
+	\safe Функция нерегулярна.
+	\warning Представление code является секретным, если секретна d.
+*/
+void ecNAFCode(
+	word code[],		/*!< [out] кодированная кратность */
+	const word d[],		/*!< [in] кратность */
+	size_t m			/*!< [in] длина d в машинных словах */
+);
+
+/*!	\brief Кратная точка по кодированной кратности
+
+	Определяется аффинная точка [2 * ec->f->n]b эллиптической кривой ec,
+	которая является d-кратной аффинной точки [2 * ec->f->n]a. Кратность d
+	задается представлением [2 * m + 2]code, рассчитанным функцией
+	ecNAFCode() по кратности [m]d.
+	\pre Описание ec работоспособно.
+	\pre Координаты a лежат в базовом поле.
+	\pre Представление code рассчитано функцией ecNAFCode() с тем же m.
+	\expect Описание ec корректно.
+	\expect Точка a лежит на ec.
+	\return TRUE, если кратная точка является аффинной, и FALSE в противном
+	случае (b == O).
+	\remark ecMulA() совпадает с последовательным вызовом функций
+	ecNAFCode() и ecMulANAF().
+	\deep{stack} ecMulANAF_deep(ec->f->n, ec->d, ec->deep, m).
+*/
+bool_t ecMulANAF(
+	word b[],			/*!< [out] кратная точка */
+	const word a[],		/*!< [in] базовая точка */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	const word code[],	/*!< [in] кодированная кратность */
+	size_t m,			/*!< [in] длина кратности в машинных словах */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecMulANAF_deep(size_t n, size_t ec_d, size_t ec_deep, size_t m);
+
+/*!	\brief Размер представления цепочки с двойной базой
+
+	Возвращается длина в машинных словах представления code, которое
+	рассчитывает функция ecDBCode() по кратности из m машинных слов.
+*/
+size_t ecDBCode_size(
+	size_t m			/*!< [in] длина кратности в машинных словах */
+);
+
+/*!	\brief Кодирование кратности цепочкой с двойной базой
+
+	Рассчитывается представление [ecDBCode_size(m)]code кратности [m]d
+	цепочкой с двойной базой (2, 3), которое используется в ecMulADB().
+	Цепочка минимизирует оценку стоимости вычислений, в которой утроение
+	стоит tpl, а сложение с малой кратной -- add шестнадцатых долей
+	удвоения.
+	\remark Для кривых над GF(p) в якобиановых координатах (см. ecp.h)
+	можно использовать tpl = 34, add = 20.
+	\pre Буфер code не пересекается с буфером d.
+	\safe Функция нерегулярна. Кодировать можно только открытые кратности.
+	\deep{stack} ecDBCode_deep(m).
+*/
+void ecDBCode(
+	word code[],		/*!< [out] кодированная кратность */
+	const word d[],		/*!< [in] кратность */
+	size_t m,			/*!< [in] длина d в машинных словах */
+	size_t tpl,			/*!< [in] стоимость утроения */
+	size_t add,			/*!< [in] стоимость сложения */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecDBCode_deep(size_t m);
+
+/*!	\brief Кратная точка по цепочке с двойной базой
+
+	Определяется аффинная точка [2 * ec->f->n]b эллиптической кривой ec,
+	которая является d-кратной аффинной точки [2 * ec->f->n]a. Кратность d
+	задается представлением [ecDBCode_size(m)]code, рассчитанным функцией
+	ecDBCode() по кратности [m]d.
+	\pre Описание ec работоспособно и ec->tpl != 0.
+	\pre Координаты a лежат в базовом поле.
+	\pre Представление code рассчитано функцией ecDBCode() с тем же m.
+	\expect Описание ec корректно.
+	\expect Точка a лежит на ec.
+	\return TRUE, если кратная точка является аффинной, и FALSE в противном
+	случае (b == O).
+	\remark При стоимости утроения больше log2(3) удвоений цепочки
+	не дают заметного выигрыша по сравнению с ecMulA().
+	\safe Функция нерегулярна.
+	\deep{stack} ecMulADB_deep(ec->f->n, ec->d, ec->deep, m).
+*/
+bool_t ecMulADB(
+	word b[],			/*!< [out] кратная точка */
+	const word a[],		/*!< [in] базовая точка */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	const word code[],	/*!< [in] кодированная кратность */
+	size_t m,			/*!< [in] длина кратности в машинных словах */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecMulADB_deep(size_t n, size_t ec_d, size_t ec_deep, size_t m);
+
+/*!	\brief Перевод таблицы точек в формат SoA
+
+	Таблица [count * step]pre из count точек по step слов в каждой
+	переводится в формат SoA (structure of arrays):
+	\code
+		soa[j * count + i] <- pre[i * step + j],
+		i = 0, 1,..., count - 1,	j = 0, 1,..., step - 1.
+	\endcode
+	Сначала размещаются слова x-координат всех точек, затем слова
+	y-координат (и z-координат проективных точек). В формате SoA
+	выбор точки с маскированием (см. ecSoASelect()) сводится к проходу
+	по непрерывным участкам таблицы, который выполняется векторными
+	инструкциями.
+	\pre Буферы soa и pre не пересекаются.
+	\remark Перевести можно как таблицу малых кратных, так и таблицу
+	гребенчатого метода (ecCombPrecompA(), count = 2^w - 1, step = 2 * n).
+*/
+void ecSoAFrom(
+	word soa[],			/*!< [out] таблица в формате SoA */
+	const word pre[],	/*!< [in] таблица точек */
+	size_t count,		/*!< [in] число точек */
+	size_t step			/*!< [in] число слов в точке */
+);
+
+/*!	\brief Перевод таблицы точек из формата SoA
+
+	Таблица [count * step]soa в формате SoA переводится в обычную
+	таблицу [count * step]pre из count точек по step слов в каждой.
+	\pre Буферы soa и pre не пересекаются.
+	\remark Функция является обратной к ecSoAFrom().
+*/
+void ecSoATo(
+	word pre[],			/*!< [out] таблица точек */
+	const word soa[],	/*!< [in] таблица в формате SoA */
+	size_t count,		/*!< [in] число точек */
+	size_t step			/*!< [in] число слов в точке */
+);
+
+/*!	\brief Выбор точки из таблицы SoA с маскированием
+
+	Из таблицы [count * step]soa в формате SoA выбирается точка
+	[step]b с номером idx:
+	\code
+		b[j] <- soa[j * count + idx],	j = 0, 1,..., step - 1.
+	\endcode
+	\pre idx < count.
+	\safe Просматривается вся таблица. Время выполнения и обращения
+	к памяти не зависят от idx.
+*/
+void ecSoASelect(
+	word b[],			/*!< [out] выбранная точка */
+	const word soa[],	/*!< [in] таблица в формате SoA */
+	size_t count,		/*!< [in] число точек */
+	size_t step,		/*!< [in] число слов в точке */
+	size_t idx			/*!< [in] номер точки */
+);
+
+/*!	\brief Регулярная кратная точка
+
+	Определяется аффинная точка [2 * ec->f->n]b эллиптической кривой ec,
+	которая является [m]d-кратной аффинной точки [2 * ec->f->n]a:
+	\code
+		b <- d a.
+	\endcode
+	Используется регулярное знаковое оконное представление d. Малые кратные
+	хранятся в таблице формата SoA и выбираются из нее полным просмотром
+	с маскированием (см. ecSoASelect()).
+	\pre Описание ec работоспособно.
+	\pre Описание группы точек ec работоспособно.
+	\pre 0 < m <= ec->f->n + 1.
+	\pre d < ec->order.
+	\pre Координаты a лежат в базовом поле.
+	\expect Описание ec корректно.
+	\expect Точка a лежит на ec и ec->order a == O.
+	\return TRUE, если кратная точка является аффинной, и FALSE в противном
+	случае (b == O).
+	\safe Время вычислений и обращения к памяти не зависят от d, если
+	при сложении точек не возникают исключительные входы. Исключительные
+	входы возникают с пренебрежимо малой вероятностью для случайной d.
+	\deep{stack} ecMulACT_deep(ec->f->n, ec->d, ec->deep).
+*/
+bool_t ecMulACT(
+	word b[],			/*!< [out] кратная точка */
+	const word a[],		/*!< [in] базовая точка */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	const word d[],		/*!< [in] кратность */
+	size_t m,			/*!< [in] длина d в машинных словах */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecMulACT_deep(size_t n, size_t ec_d, size_t ec_deep);
+
 /*!	\brief Имеет порядок?
 
 	Проверяется, что аффинная точка [2 * ec->f->n]a имеет порядок [m]q 
@@ -620,6 +959,230 @@ bool_t ecAddMulA(
 
 size_t ecAddMulA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t k,...);
 
+/*!	\brief Сумма многих кратных точек
+
+	Определяется точка [2n]b эллиптической кривой ec, которая является
+	суммой [m]d[i]-кратных точек [2n]a[i], i = 0, 1,.., k - 1:
+	\code
+		b <- d[0] a[0] + d[1] a[1] + ... + d[k - 1] a[k - 1].
+	\endcode
+	Точки a[i] размещаются в массиве [2n * k]a, кратности d[i] --
+	в массиве [m * k]d. При небольшом k сумма вычисляется так же, как
+	в ecAddMulA(), при большом k -- методом Пиппенджера.
+	\pre Описание ec работоспособно.
+	\pre k > 0 && m > 0.
+	\pre Координаты точек a[i] лежат в базовом поле.
+	\expect Описание ec корректно.
+	\expect Точки a[i] лежат на ec.
+	\return TRUE, если полученная точка является аффинной, и FALSE
+	в противном случае (b == O).
+	\warning Время вычислений и обращения к памяти зависят от кратностей.
+	Кратности не должны быть секретными.
+	\deep{stack} ecMultiMulA_deep(ec->f->n, ec->d, ec->deep, m, k).
+*/
+bool_t ecMultiMulA(
+	word b[],			/*!< [out] сумма кратных точек */
+	const word a[],		/*!< [in] точки */
+	const word d[],		/*!< [in] кратности */
+	size_t m,			/*!< [in] длина d[i] в машинных словах */
+	size_t k,			/*!< [in] число точек */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecMultiMulA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t m,
+	size_t k);
+
+/*!	\brief Таблица гребенчатого метода
+
+	Для аффинной точки [2 * ec->f->n]a эллиптической кривой ec рассчитывается
+	таблица [2 * ec->f->n * (2^w - 1)]pre аффинных точек, которая
+	используется в ecCombMulA() для вычисления кратных a с кратностями
+	длины m машинных слов. Если s = \ceil(B_OF_W(m) / w), то
+	\code
+		pre[j - 1] <- \sum_{i: j_i = 1} 2^{is} a,	j = 1, 2,..., 2^w - 1.
+	\endcode
+	\pre Описание ec работоспособно.
+	\pre Координаты a лежат в базовом поле.
+	\pre 1 <= w < B_PER_S && m > 0.
+	\expect Описание ec корректно.
+	\expect Точка a лежит на ec.
+	\return TRUE, если таблица рассчитана, и FALSE, если одна из ее точек
+	оказалась бесконечно удаленной.
+	\remark Таблица зависит от a, w и m и может рассчитываться один раз
+	для фиксированной точки a.
+	\deep{stack} ecCombPrecompA_deep(ec->f->n, ec->d, ec->deep).
+*/
+bool_t ecCombPrecompA(
+	word pre[],			/*!< [out] таблица */
+	const word a[],		/*!< [in] фиксированная точка */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	size_t w,			/*!< [in] число строк гребенки */
+	size_t m,			/*!< [in] длина кратностей в машинных словах */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecCombPrecompA_deep(size_t n, size_t ec_d, size_t ec_deep);
+
+/*!	\brief Кратная фиксированной точки в проективных координатах
+
+	Определяется точка [ec->d * ec->f->n]b эллиптической кривой ec,
+	которая является [m]d-кратной фиксированной аффинной точки a:
+	\code
+		b <- d a.
+	\endcode
+	Точка a задается таблицей [2 * ec->f->n * (2^w - 1)]pre. Точка b
+	остается в проективных координатах, что позволяет перевести в аффинные
+	координаты сразу несколько кратных (см. ecToABatch()).
+	\pre Описание ec работоспособно.
+	\pre Таблица pre рассчитана функцией ecCombPrecompA() с параметрами
+	w и m.
+	\pre Буферы b и pre не пересекаются.
+	\expect Описание ec корректно.
+	\deep{stack} ecCombMul_deep(ec->f->n, ec->d, ec->deep).
+*/
+void ecCombMul(
+	word b[],			/*!< [out] кратная точка */
+	const word pre[],	/*!< [in] таблица */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	size_t w,			/*!< [in] число строк гребенки */
+	const word d[],		/*!< [in] кратность */
+	size_t m,			/*!< [in] длина d в машинных словах */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecCombMul_deep(size_t n, size_t ec_d, size_t ec_deep);
+
+/*!	\brief Кратная фиксированной точки
+
+	Определяется аффинная точка [2 * ec->f->n]b эллиптической кривой ec, 
+	которая является [m]d-кратной фиксированной аффинной точки a:
+	\code
+		b <- d a.
+	\endcode
+	Точка a задается таблицей [2 * ec->f->n * (2^w - 1)]pre.
+	\pre Описание ec работоспособно.
+	\pre Таблица pre рассчитана функцией ecCombPrecompA() с параметрами
+	w и m.
+	\expect Описание ec корректно.
+	\return TRUE, если кратная точка является аффинной, и FALSE в противном
+	случае (b == O).
+	\remark Вычисление d a требует \ceil(B_OF_W(m) / w) удвоений и столько же
+	(не более) сложений, тогда как в ecMulA() требуется B_OF_W(m) удвоений.
+	\deep{stack} ecCombMulA_deep(ec->f->n, ec->d, ec->deep).
+*/
+bool_t ecCombMulA(
+	word b[],			/*!< [out] кратная точка */
+	const word pre[],	/*!< [in] таблица */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	size_t w,			/*!< [in] число строк гребенки */
+	const word d[],		/*!< [in] кратность */
+	size_t m,			/*!< [in] длина d в машинных словах */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecCombMulA_deep(size_t n, size_t ec_d, size_t ec_deep);
+
+/*!	\brief Сумма кратных фиксированной и произвольной точек
+
+	Определяется аффинная точка [2 * ec->f->n]b эллиптической кривой ec,
+	которая является суммой [m]d-кратной фиксированной аффинной точки g
+	и [k]e-кратной аффинной точки [2 * ec->f->n]a:
+	\code
+		b <- d g + e a.
+	\endcode
+	Точка g задается таблицей [2 * ec->f->n * (2^w - 1)]pre.
+	\pre Описание ec работоспособно.
+	\pre Таблица pre рассчитана функцией ecCombPrecompA() с параметрами
+	w и m.
+	\pre Координаты a лежат в базовом поле.
+	\expect Описание ec корректно.
+	\expect Точка a лежит на ec.
+	\return TRUE, если сумма кратных является аффинной точкой, и FALSE
+	в противном случае (b == O).
+	\remark Столбцы гребенки d и символы NAF-представления e обрабатываются
+	в общей цепочке удвоений длины max(\ceil(B_OF_W(m) / w), B_OF_W(k) + 1).
+	\remark Функция предназначена для открытых кратностей d и e
+	(например, при проверке подписи).
+	\deep{stack} ecCombAddMulA_deep(ec->f->n, ec->d, ec->deep, k).
+*/
+bool_t ecCombAddMulA(
+	word b[],			/*!< [out] сумма кратных */
+	const word pre[],	/*!< [in] таблица фиксированной точки */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	size_t w,			/*!< [in] число строк гребенки */
+	const word d[],		/*!< [in] кратность фиксированной точки */
+	size_t m,			/*!< [in] длина d в машинных словах */
+	const word a[],		/*!< [in] произвольная точка */
+	const word e[],		/*!< [in] кратность произвольной точки */
+	size_t k,			/*!< [in] длина e в машинных словах */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecCombAddMulA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t k);
+
+/*!	\brief Малые кратные точки
+
+	Для аффинной точки [2 * ec->f->n]a эллиптической кривой ec
+	рассчитываются аффинные малые кратные
+	\code
+		pa[i] <- (2i + 1) a,	i = 0, 1,..., 2^{w - 2} - 1,
+	\endcode
+	которые используются в ecCombAddMulNAFA() при обработке NAF
+	с длиной окна w. Кратные занимают [2 * ec->f->n * 2^{w - 2}]pa.
+	\pre Описание ec работоспособно.
+	\pre Координаты a лежат в базовом поле.
+	\pre 3 <= w < B_PER_W.
+	\expect Описание ec корректно.
+	\expect Точка a лежит на ec.
+	\return TRUE, если кратные рассчитаны, и FALSE, если одна из них
+	оказалась бесконечно удаленной.
+	\remark Кратные можно рассчитать один раз для точки a, которая
+	многократно участвует в вычислениях (например, для открытого ключа).
+	\deep{stack} ecNAFPrecompA_deep(ec->f->n, ec->d, ec->deep, w).
+*/
+bool_t ecNAFPrecompA(
+	word pa[],			/*!< [out] малые кратные */
+	const word a[],		/*!< [in] точка */
+	size_t w,			/*!< [in] длина окна */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecNAFPrecompA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t w);
+
+/*!	\brief Сумма кратных фиксированной и произвольной точек
+	с готовыми малыми кратными
+
+	Определяется аффинная точка [2 * ec->f->n]b = d g + e a, как
+	в ecCombAddMulA(). Вместо точки a передаются ее малые кратные pa,
+	рассчитанные функцией ecNAFPrecompA() с длиной окна naf_w.
+	\pre Описание ec работоспособно.
+	\pre Таблица pre рассчитана функцией ecCombPrecompA() с параметрами
+	w и m.
+	\pre 3 <= naf_w < B_PER_W.
+	\expect Описание ec корректно.
+	\return TRUE, если сумма кратных является аффинной точкой, и FALSE
+	в противном случае (b == O).
+	\deep{stack} ecCombAddMulNAFA_deep(ec->f->n, ec->d, ec->deep, k).
+*/
+bool_t ecCombAddMulNAFA(
+	word b[],			/*!< [out] сумма кратных */
+	const word pre[],	/*!< [in] таблица фиксированной точки */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	size_t w,			/*!< [in] число строк гребенки */
+	const word d[],		/*!< [in] кратность фиксированной точки */
+	size_t m,			/*!< [in] длина d в машинных словах */
+	const word pa[],	/*!< [in] малые кратные произвольной точки */
+	size_t naf_w,		/*!< [in] длина окна */
+	const word e[],		/*!< [in] кратность произвольной точки */
+	size_t k,			/*!< [in] длина e в машинных словах */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecCombAddMulNAFA_deep(size_t n, size_t ec_d, size_t ec_deep,
+	size_t k);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief Elliptic curves over binary fields
 \project bee2 [cryptographic library]
 \created 2012.04.19
-\version 2021.06.30
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -228,6 +228,40 @@ bool_t ec2SubAA(
 
 size_t ec2SubAA_deep(size_t n, size_t f_deep);
 
+/*!	\brief Кратная точка: лестница Монтгомери
+
+	Определяется аффинная точка [2 * ec->f->n]b эллиптической кривой ec,
+	которая является [m]d-кратной аффинной точки [2 * ec->f->n]a:
+	\code
+		b <- d a.
+	\endcode
+	Используется лестница Монтгомери в x-координатах Лопеса -- Дахаба
+	с восстановлением y-координаты. Предварительные вычисления
+	не выполняются.
+	\pre Описание ec работоспособно.
+	\pre Описание группы точек ec работоспособно.
+	\pre 0 < m <= ec->f->n + 1.
+	\pre d < ec->order.
+	\pre Координаты a лежат в базовом поле.
+	\expect Описание ec корректно.
+	\expect Точка a лежит на ec и ec->order a == O.
+	\return TRUE, если кратная точка является аффинной, и FALSE в противном
+	случае (b == O).
+	\safe Время вычислений и обращения к памяти не зависят от d
+	(при xa != 0, что выполняется для точек нечетного порядка).
+	\deep{stack} ec2MulALadder_deep(ec->f->n, ec->d, ec->deep).
+*/
+bool_t ec2MulALadder(
+	word b[],			/*!< [out] кратная точка */
+	const word a[],		/*!< [in] базовая точка */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	const word d[],		/*!< [in] кратность */
+	size_t m,			/*!< [in] длина d в машинных словах */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ec2MulALadder_deep(size_t n, size_t ec_d, size_t ec_deep);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief Elliptic curves over prime fields
 \project bee2 [cryptographic library]
 \created 2012.06.24
-\version 2021.06.30
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -165,6 +165,32 @@ bool_t ecpIsOnA(
 
 size_t ecpIsOnA_deep(size_t n, size_t f_deep);
 
+/*!	\brief Пакет аффинных точек лежит на кривой?
+
+	Для каждой из count аффинных точек [2 * ec->f->n]a_i, размещенных
+	подряд в массиве a, проверяется, что a_i лежит на кривой ec.
+	Результат проверки a_i возвращается в rets[i].
+	\pre Описание ec работоспособно.
+	\expect Описание ec корректно.
+	\return Число точек, лежащих на кривой.
+	\remark Результаты совпадают с результатами ecpIsOnA(). Для полей
+	с редукцией Крэндалла и длиной модуля 192, 256, 384, 512 битов
+	(стандартные кривые СТБ 34.101.45) используются функции
+	арифметики с фиксированной размерностью.
+	\remark Функция предназначена для открытых точек (например, при
+	загрузке хранилищ открытых ключей).
+	\deep{stack} ecpIsOnABatch_deep(ec->f->n, ec->f->deep).
+*/
+size_t ecpIsOnABatch(
+	bool_t rets[],		/*!< [out] результаты проверок */
+	const word a[],		/*!< [in] точки */
+	size_t count,		/*!< [in] число точек */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecpIsOnABatch_deep(size_t n, size_t f_deep);
+
 /*!	\brief Обратная аффинная точка
 
 	Определяется аффинная точка [2 * ec->f->n]b кривой ec, обратная к аффинной 
@@ -239,7 +265,8 @@ size_t ecpSubAA_deep(size_t n, size_t f_deep);
 	\expect Описание ec корректно.
 	\expect B -- квадратичный вычет по модулю p. Если это условие 
 	нарушается, то точка b не будет лежать на ec для a \in {0, p - 1}.
-	\remark Реализован алгоритм SWU в редакции СТБ 34.101.66.
+	\remark Реализован алгоритм SWU в редакции СТБ 34.101.66. Обращение
+	в поле и проверка квадратичности выполняются одним возведением в степень.
 	\deep{stack} ecpSWU_deep(ec->f->n, ec->f->deep).
 */
 void ecpSWU(
@@ -251,6 +278,83 @@ void ecpSWU(
 
 size_t ecpSWU_deep(size_t n, size_t f_deep);
 
+/*!	\brief Восстановление аффинной точки по сжатому представлению
+
+	По x-координате [ec->f->n]x и четности ybit y-координаты
+	восстанавливается аффинная точка [2 * ec->f->n]b = (x, y) кривой ec.
+	Четность определяется по числу, которое представляет y (см. qrTo()).
+	\pre Описание ec работоспособно.
+	\pre x \in ec->f.
+	\pre Буферы b и x либо не пересекаются, либо x == b.
+	\expect Описание ec корректно.
+	\return TRUE, если точка восстановлена, и FALSE в противном случае
+	(x^3 + A x + B -- квадратичный невычет или y = 0 при ybit != 0).
+	\remark Квадратный корень извлекается с помощью gfpSqrt().
+	\deep{stack} ecpDecompress_deep(ec->f->n, ec->f->deep).
+	\safe Функция нерегулярна.
+*/
+bool_t ecpDecompress(
+	word b[],			/*!< [out] точка */
+	const word x[],		/*!< [in] x-координата */
+	bool_t ybit,		/*!< [in] четность y-координаты */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecpDecompress_deep(size_t n, size_t f_deep);
+
+#ifdef U64_SUPPORT
+
+/*!	\brief Восемь сумм кратных фиксированной и произвольных точек
+
+	Для j = 0, 1,..., 7 определяются аффинные точки [2 * ec->f->n]b_j
+	эллиптической кривой ec, которые являются суммами [m]d_j-кратной
+	фиксированной аффинной точки g и [k]e_j-кратных аффинных точек
+	[2 * ec->f->n]a_j:
+	\code
+		b_j <- d_j g + e_j a_j.
+	\endcode
+	Точки b_j, a_j, кратности d_j и e_j размещаются подряд в массивах
+	b, a, d, e. Точка g задается таблицей [2 * ec->f->n * (2^w - 1)]pre.
+	Суммы вычисляются одновременно над 8 дорожками с помощью функций
+	zm8XXX().
+	\pre Описание ec работоспособно.
+	\pre ec->f -- простое поле, построенное функцией gfpCreate().
+	\pre Таблица pre рассчитана функцией ecCombPrecompA() с параметрами
+	w и m.
+	\pre Координаты a_j лежат в базовом поле.
+	\expect Описание ec корректно.
+	\expect Точки a_j лежат на ec.
+	\return Маска дорожек: бит j маски равен 1, если точка b_j вычислена.
+	Точка b_j не вычисляется, если b_j == O или если в цепочке
+	дорожки j встретилось сложение совпадающих (противоположных) точек.
+	Такие суммы следует вычислить функцией ecCombAddMulA().
+	\remark Кратности d_j обрабатываются гребенчатым методом (как в
+	ecCombAddMulA()), кратности e_j -- методом окон фиксированной ширины
+	со знаковыми символами. Цепочки удвоений и сложений всех дорожек
+	совпадают.
+	\remark Функция предназначена для открытых кратностей d_j и e_j
+	(например, при пакетной проверке подписей). Ускорение по сравнению
+	с 8 вызовами ecCombAddMulA() достигается, если zm8IsFast() == TRUE.
+	\deep{stack} ecpCombAddMulA8_deep(ec->f->n, ec->f->deep, w, k).
+*/
+size_t ecpCombAddMulA8(
+	word b[],			/*!< [out] суммы кратных */
+	const word pre[],	/*!< [in] таблица фиксированной точки */
+	const ec_o* ec,		/*!< [in] описание кривой */
+	size_t w,			/*!< [in] число строк гребенки */
+	const word d[],		/*!< [in] кратности фиксированной точки */
+	size_t m,			/*!< [in] длина d_j в машинных словах */
+	const word a[],		/*!< [in] произвольные точки */
+	const word e[],		/*!< [in] кратности произвольных точек */
+	size_t k,			/*!< [in] длина e_j в машинных словах */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t ecpCombAddMulA8_deep(size_t n, size_t f_deep, size_t w, size_t k);
+
+#endif /* U64_SUPPORT */
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief Binary fields
 \project bee2 [cryptographic library]
 \created 2012.04.17
-\version 2015.02.01
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -61,6 +61,9 @@ extern "C" {
 машинными словами (степень p(x) кратна B_PER_W), либо n + 1 словом 
 (степень p(x) не кратна B_PER_W).  
 
+При создании поля рассчитывается также маска следа: элемент, i-й разряд
+которого равняется следу x^i. Маска используется в функции gf2Tr().
+
 Некоторые неприводимые многочлены из криптографических стандартов:
 Belt, GCM:	x^128 + x^7 + x^2 + x + 1,
 NIST163:	x^163 + x^7 + x^6 + x^3 + 1,
@@ -233,6 +236,58 @@ bool_t gf2QSolve(
 
 size_t gf2QSolve_deep(size_t n, size_t f_deep);
 
+/*!	\brief Таблица полуследов в поле GF(2^m)
+
+	В поле f = GF(2^m) с нечетным m рассчитывается таблица
+	[(m + 1) / 2 * f->n]tab полуследов мономов 1, x, x^3,..., x^{m - 2}.
+	Полуслед элемента a определяется следующим образом:
+	\code
+		htr(a) <- \sum {k = 0}^{(m - 1) / 2} a^{4^k}.
+	\endcode
+	\pre Описание f работоспособно.
+	\pre m -- нечетное.
+	\expect Описание f корректно.
+	\remark Расчет таблицы по трудоемкости примерно соответствует (m + 1) / 2
+	вычислениям полуследа в gf2QSolve(). Таблицу имеет смысл рассчитывать,
+	если требуется решить много квадратных уравнений в одном поле
+	(см. gf2HTr()).
+	\deep{stack} gf2HTrPrecomp_deep(f->n, f->deep).
+*/
+void gf2HTrPrecomp(
+	word tab[],					/*!< [out] таблица полуследов */
+	const qr_o* f,				/*!< [in] описание поля */
+	void* stack					/*!< [in] вспомогательная память */
+);
+
+size_t gf2HTrPrecomp_deep(size_t n, size_t f_deep);
+
+/*!	\brief Полуслед элемента поля GF(2^m) по таблице
+
+	В поле f = GF(2^m) с нечетным m определяется полуслед [f->n]b
+	элемента [f->n]a. Используется таблица tab, рассчитанная функцией
+	gf2HTrPrecomp().
+	\pre Описание f работоспособно.
+	\pre m -- нечетное.
+	\pre Элемент a принадлежит f.
+	\pre Буфер b не пересекается с таблицей tab.
+	\expect Описание f корректно.
+	\remark Если \tr(a) == 0, то b -- решение уравнения x^2 + x + a == 0.
+	Следовательно, решение уравнения x^2 + a x + b == 0 (a != 0)
+	можно найти как a htr(b / a^2), избежав (m - 1) возведений в квадрат
+	в gf2QSolve().
+	\remark Время вычислений зависит от a.
+	\deep{stack} gf2HTr_deep(f->n, f->deep).
+*/
+void gf2HTr(
+	word b[],					/*!< [out] полуслед */
+	const word a[],				/*!< [in] элемент */
+	const word tab[],			/*!< [in] таблица полуследов */
+	const qr_o* f,				/*!< [in] описание поля */
+	void* stack					/*!< [in] вспомогательная память */
+);
+
+size_t gf2HTr_deep(size_t n, size_t f_deep);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
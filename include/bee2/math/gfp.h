@@ -4,7 +4,7 @@
 \brief Prime fields
 \project bee2 [cryptographic library]
 \created 2012.07.11
-\version 2014.04.17
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -99,6 +99,38 @@ bool_t gfpIsValid(
 
 size_t gfpIsValid_deep(size_t n);
 
+/*
+*******************************************************************************
+Квадратные корни
+*******************************************************************************
+*/
+
+/*!	\brief Квадратный корень
+
+	В поле f = GF(p) определяется квадратный корень [f->n]b из элемента
+	[f->n]a:
+	\code
+		b <- \sqrt(a).
+	\endcode
+	Если a -- квадратичный невычет, то возвращается FALSE.
+	\pre Описание f работоспособно.
+	\pre Элемент a принадлежит f.
+	\expect f->mod -- простое.
+	\return Признак успеха (a -- квадратичный вычет или 0).
+	\remark Возвращается один из двух квадратных корней: b или -b.
+	\remark Буферы a и b могут совпадать.
+	\deep{stack} gfpSqrt_deep(f->n, f->deep).
+	\safe Функция нерегулярна.
+*/
+bool_t gfpSqrt(
+	word b[],			/*!< [out] квадратный корень */
+	const word a[],		/*!< [in] элемент поля */
+	const qr_o* f,		/*!< [in] описание поля */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t gfpSqrt_deep(size_t n, size_t f_deep);
+
 /*
 *******************************************************************************
 Псевдонимы
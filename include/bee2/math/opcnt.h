@@ -0,0 +1,126 @@
+/*
+*******************************************************************************
+\file opcnt.h
+\brief Operation counters for rings and elliptic curves
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+/*!
+*******************************************************************************
+\file opcnt.h
+\brief Счетчики операций в кольцах и на эллиптических кривых
+*******************************************************************************
+*/
+
+#ifndef __BEE2_OPCNT_H
+#define __BEE2_OPCNT_H
+
+#include "bee2/defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+*******************************************************************************
+\file opcnt.h
+
+Если библиотека собрана с директивой BEE2_INSTRUMENT (опция CMake
+BUILD_INSTRUMENT), то подсчитываются вызовы интерфейсов описаний колец
+вычетов (qr_o) и эллиптических кривых (ec_o): каждый вызов через макросы
+qrXXX() и ecXXX() (а также прямые вызовы интерфейсов ec_o в ec.c)
+увеличивает соответствующий счетчик. Счетчики закрепляются за потоками
+(см. mtKeyCreate()). Если ключи потоков не поддерживаются, то
+используются общие для всех потоков счетчики.
+
+Счетчики позволяют определить число операций в поле (умножений,
+возведений в квадрат, обращений) и над точками (сложений, удвоений),
+выполняемых при вызове высокоуровневой функции:
+\code
+	opcnt_t c[1];
+	opcntReset();
+	bignSign(...);
+	opcntGet(c);
+\endcode
+
+Без директивы BEE2_INSTRUMENT макросы qrXXX() и ecXXX() не изменяются,
+счетчики не ведутся, opcntIsEnabled() возвращает FALSE, а opcntGet()
+возвращает нулевые счетчики.
+*******************************************************************************
+*/
+
+/*!	\brief Счетчики операций */
+typedef struct
+{
+	size_t qr_from;		/*!< qr_o::from */
+	size_t qr_to;		/*!< qr_o::to */
+	size_t qr_add;		/*!< qr_o::add */
+	size_t qr_sub;		/*!< qr_o::sub */
+	size_t qr_neg;		/*!< qr_o::neg */
+	size_t qr_mul;		/*!< qr_o::mul */
+	size_t qr_sqr;		/*!< qr_o::sqr */
+	size_t qr_inv;		/*!< qr_o::inv */
+	size_t qr_div;		/*!< qr_o::div */
+	size_t ec_froma;	/*!< ec_o::froma */
+	size_t ec_toa;		/*!< ec_o::toa */
+	size_t ec_toan;		/*!< ec_o::toan */
+	size_t ec_neg;		/*!< ec_o::neg */
+	size_t ec_add;		/*!< ec_o::add */
+	size_t ec_adda;		/*!< ec_o::adda */
+	size_t ec_sub;		/*!< ec_o::sub */
+	size_t ec_suba;		/*!< ec_o::suba */
+	size_t ec_dbl;		/*!< ec_o::dbl */
+	size_t ec_dbla;		/*!< ec_o::dbla */
+	size_t ec_dbln;		/*!< ec_o::dbln */
+} opcnt_t;
+
+/*!	\brief Счетчики ведутся?
+
+	Проверяется, что библиотека собрана с директивой BEE2_INSTRUMENT.
+	\return Признак ведения счетчиков.
+*/
+bool_t opcntIsEnabled();
+
+/*!	\brief Обнуление счетчиков
+
+	Обнуляются счетчики текущего потока.
+*/
+void opcntReset();
+
+/*!	\brief Чтение счетчиков
+
+	В c копируются счетчики текущего потока.
+	\remark Без директивы BEE2_INSTRUMENT счетчики нулевые.
+*/
+void opcntGet(
+	opcnt_t* c			/*!< [out] счетчики */
+);
+
+#ifdef BEE2_INSTRUMENT
+
+/*!	\brief Счетчики текущего потока
+
+	Возвращается указатель на счетчики текущего потока.
+	\remark Функция предназначена для макроса opcntInc().
+*/
+opcnt_t* opcntCounters();
+
+/*!	\brief Увеличение счетчика
+
+	Увеличивается счетчик name текущего потока.
+*/
+#define opcntInc(name)\
+	(++opcntCounters()->name)
+
+#endif /* BEE2_INSTRUMENT */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __BEE2_OPCNT_H */
@@ -4,7 +4,7 @@
 \brief Binary polynomials
 \project bee2 [cryptographic library]
 \created 2012.03.01
-\version 2023.02.02
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -128,6 +128,10 @@ size_t ppAddMulW_deep(size_t n);
 		c <- a * b.
 	\endcode
 	\pre Буфер c не пересекается с буферами a и b.
+	\remark Если B_PER_W == 64 и платформа поддерживает инструкции
+	умножения без переносов (PCLMULQDQ, PMULL), то они используются
+	в ppMul(), ppSqr(), ppMulW(), ppAddMulW(). Наличие PCLMULQDQ
+	проверяется во время выполнения.
 	\deep{stack} ppMul_deep(n, m).
 */
 void ppMul(
@@ -4,7 +4,7 @@
 \brief Primes
 \project bee2 [cryptographic library]
 \created 2012.08.13
-\version 2024.02.22
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -329,6 +329,86 @@ bool_t priExtendPrime2(
 
 size_t priExtendPrime2_deep(size_t l, size_t n, size_t m, size_t base_count);
 
+/*
+*******************************************************************************
+Многопоточная генерация простых
+
+Функции priNextPrimeMT(), priExtendPrimeMT(), priExtendPrime2MT() действуют
+так же, как функции priNextPrime(), priExtendPrime(), priExtendPrime2(),
+но распределяют проверку кандидатов между threads потоками. Кандидаты,
+прошедшие проверку на факторной базе, тестируются пакетами по threads штук.
+Если в пакете несколько простых, то выбирается первое из них.
+
+Результат поиска (в том числе последовательность обращений к генератору rng)
+не зависит от threads и совпадает с результатом последовательной функции.
+При threads == 0 используется один поток.
+*******************************************************************************
+*/
+
+/*!	\brief Многопоточный поиск следующего простого
+
+	Аналог priNextPrime(), в котором кандидаты проверяются в threads потоках.
+	\deep{stack} priNextPrimeMT_deep(n, base_count, threads).
+*/
+bool_t priNextPrimeMT(
+	word p[],			/*!< [out] простое число */
+	const word a[],		/*!< [in] начальное значение */
+	size_t n,			/*!< [in] длина a и p в машинных словах */
+	size_t trials,		/*!< [in] число кандидатов */
+	size_t base_count,	/*!< [in] число элементов факторной базы */
+	size_t iter,		/*!< [in] число итераций теста Рабина -- Миллера */
+	size_t threads,		/*!< [in] число потоков */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t priNextPrimeMT_deep(size_t n, size_t base_count, size_t threads);
+
+/*!	\brief Многопоточное расширение простого
+
+	Аналог priExtendPrime(), в котором кандидаты проверяются в threads
+	потоках.
+	\deep{stack} priExtendPrimeMT_deep(l, n, base_count, threads).
+*/
+bool_t priExtendPrimeMT(
+	word p[],			/*!< [out] расширенное простое число */
+	size_t l,			/*!< [in] длина p в битах */
+	const word q[],		/*!< [in] базовое простое число */
+	size_t n,			/*!< [in] длина q в машинных словах */
+	size_t trials,		/*!< [in] число кандидатов */
+	size_t base_count,	/*!< [in] число элементов факторной базы */
+	size_t threads,		/*!< [in] число потоков */
+	gen_i rng,			/*!< [in] генератор случайных чисел */
+	void* rng_state,	/*!< [in] состояние rng */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t priExtendPrimeMT_deep(size_t l, size_t n, size_t base_count,
+	size_t threads);
+
+/*!	\brief Многопоточное расширение простого с условием делимости
+
+	Аналог priExtendPrime2(), в котором кандидаты проверяются в threads
+	потоках.
+	\deep{stack} priExtendPrime2MT_deep(l, n, m, base_count, threads).
+*/
+bool_t priExtendPrime2MT(
+	word p[],			/*!< [out] расширенное простое число */
+	size_t l,			/*!< [in] длина p в битах */
+	const word q[],		/*!< [in] базовое простое число */
+	size_t n,			/*!< [in] длина q в машинных словах */
+	const word a[],		/*!< [in] делитель p - 1 */
+	size_t m,			/*!< [in] длина m в машинных словах */
+	size_t trials,		/*!< [in] число кандидатов */
+	size_t base_count,	/*!< [in] число элементов факторной базы */
+	size_t threads,		/*!< [in] число потоков */
+	gen_i rng,			/*!< [in] генератор случайных чисел */
+	void* rng_state,	/*!< [in] состояние rng */
+	void* stack			/*!< [in] вспомогательная память */
+);
+
+size_t priExtendPrime2MT_deep(size_t l, size_t n, size_t m,
+	size_t base_count, size_t threads);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
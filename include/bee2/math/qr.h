@@ -4,7 +4,7 @@
 \brief Quotient rings
 \project bee2 [cryptographic library]
 \created 2013.08.09
-\version 2015.09.01
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -22,6 +22,7 @@
 
 #include "bee2/defs.h"
 #include "bee2/core/obj.h"
+#include "bee2/math/opcnt.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -360,6 +361,43 @@ typedef struct qr_o
 #define qrCmp(b, a, r)\
 	wwCmp(b, a, (r)->n)
 
+#ifdef BEE2_INSTRUMENT
+
+#define qrFrom(b, a, r, stack)\
+	(opcntInc(qr_from), (r)->from(b, a, r, stack))
+
+#define qrTo(b, a, r, stack)\
+	(opcntInc(qr_to), (r)->to(b, a, r, stack))
+
+#define qrAdd(c, a, b, r)\
+	(opcntInc(qr_add), (r)->add(c, a, b, r))
+
+#define qrAddUnity(b, a, r)\
+	(opcntInc(qr_add), (r)->add(b, a, (r)->unity, r))
+
+#define qrSub(c, a, b, r)\
+	(opcntInc(qr_sub), (r)->sub(c, a, b, r))
+
+#define qrSubUnity(a, r)\
+	(opcntInc(qr_sub), (r)->sub(a, a, (r)->unity, r))
+
+#define qrNeg(b, a, r)\
+	(opcntInc(qr_neg), (r)->neg(b, a, r))
+
+#define qrMul(c, a, b, r, stack)\
+	(opcntInc(qr_mul), (r)->mul(c, a, b, r, stack))
+
+#define qrSqr(b, a, r, stack)\
+	(opcntInc(qr_sqr), (r)->sqr(b, a, r, stack))
+
+#define qrInv(b, a, r, stack)\
+	(opcntInc(qr_inv), (r)->inv(b, a, r, stack))
+
+#define qrDiv(b, divident, a, r, stack)\
+	(opcntInc(qr_div), (r)->div(b, divident, a, r, stack))
+
+#else
+
 #define qrFrom(b, a, r, stack)\
 	(r)->from(b, a, r, stack)
 
@@ -393,6 +431,8 @@ typedef struct qr_o
 #define qrDiv(b, divident, a, r, stack)\
 	(r)->div(b, divident, a, r, stack)
 
+#endif /* BEE2_INSTRUMENT */
+
 /*
 *******************************************************************************
 Управление описанием кольца
@@ -445,6 +485,150 @@ void qrPower(
 
 size_t qrPower_deep(size_t n, size_t m, size_t r_deep);
 
+/*! \brief Регулярное возведение в степень в кольце вычетов
+
+	В кольце вычетов r определяется элемент [r->n]c, который является [m]b-ой 
+	степенью элемента [r->n]a:
+	\code
+		c <- a^b.
+	\endcode
+	Последовательность операций в кольце и адреса обращений к памяти
+	не зависят от b.
+	\pre Описание кольца r работоспособно.
+	\pre Элемент a принадлежит r.
+	\pre m > 0.
+	\expect Описание кольца r корректно.
+	\remark Функция предназначена для секретных показателей b. Время
+	выполнения определяется длиной m, но не значением b. 
+	\deep{stack} qrPowerCT_deep(r->n, m, r->deep).
+*/
+void qrPowerCT(
+	word c[],				/*!< [out] степень */
+	const word a[],			/*!< [in] основание */
+	const word b[],			/*!< [in] показатель */
+	size_t m,				/*!< [in] длина b в машинных словах */
+	const qr_o* r,			/*!< [in] описание кольца */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
+size_t qrPowerCT_deep(size_t n, size_t m, size_t r_deep);
+
+/*! \brief Таблица гребенчатого метода
+
+	В кольце вычетов r для элемента [r->n]a рассчитывается таблица
+	[r->n * 2^w]pre, которая используется в qrCombPowerCT() для возведения
+	a в степени с показателями длины m машинных слов. Если 
+	s = \ceil(B_OF_W(m) / w), то
+	\code
+		pre[j] <- \prod_{i: j_i = 1} a^{2^{is}},	j = 0, 1,..., 2^w - 1.
+	\endcode
+	\pre Описание кольца r работоспособно.
+	\pre Элемент a принадлежит r.
+	\pre 1 <= w < B_PER_S && m > 0.
+	\expect Описание кольца r корректно.
+	\remark Таблица зависит от a, w и m и может рассчитываться один раз
+	для многократного использования.
+	\deep{stack} qrCombPrecomp_deep(r->n, r->deep).
+*/
+void qrCombPrecomp(
+	word pre[],				/*!< [out] таблица */
+	const word a[],			/*!< [in] фиксированное основание */
+	size_t w,				/*!< [in] число строк гребенки */
+	size_t m,				/*!< [in] длина показателей в машинных словах */
+	const qr_o* r,			/*!< [in] описание кольца */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
+size_t qrCombPrecomp_deep(size_t n, size_t r_deep);
+
+/*! \brief Регулярное возведение в степень фиксированного основания
+
+	В кольце вычетов r определяется элемент [r->n]c, который является 
+	[m]b-ой степенью фиксированного элемента a:
+	\code
+		c <- a^b.
+	\endcode
+	Элемент a задается таблицей [r->n * 2^w]pre. 
+	Последовательность операций в кольце и адреса обращений к памяти
+	не зависят от b.
+	\pre Описание кольца r работоспособно.
+	\pre Таблица pre рассчитана функцией qrCombPrecomp() с параметрами
+	w и m.
+	\expect Описание кольца r корректно.
+	\remark Вычисление a^b требует \ceil(B_OF_W(m) / w) возведений
+	в квадрат и столько же умножений, тогда как в qrPowerCT() требуется
+	B_OF_W(m) возведений в квадрат.
+	\deep{stack} qrCombPowerCT_deep(r->n, r->deep).
+*/
+void qrCombPowerCT(
+	word c[],				/*!< [out] степень */
+	const word pre[],		/*!< [in] таблица */
+	size_t w,				/*!< [in] число строк гребенки */
+	const word b[],			/*!< [in] показатель */
+	size_t m,				/*!< [in] длина b в машинных словах */
+	const qr_o* r,			/*!< [in] описание кольца */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
+size_t qrCombPowerCT_deep(size_t n, size_t r_deep);
+
+/*! \brief Совместное возведение в степень в кольце вычетов
+
+	В кольце вычетов r определяется произведение [r->n]c [m]b-ой степени
+	элемента [r->n]a и [k]e-ой степени элемента [r->n]d:
+	\code
+		c <- a^b * d^e.
+	\endcode
+	\pre Описание кольца r работоспособно.
+	\pre Элементы a и d принадлежат r.
+	\expect Описание кольца r корректно.
+	\remark При b == 0 и e == 0 возвращается r->unity.
+	\remark Функция предназначена для открытых показателей b и e
+	(например, при проверке подписи). 
+	\deep{stack} qrPower2_deep(r->n, m, k, r->deep).
+*/
+void qrPower2(
+	word c[],				/*!< [out] произведение степеней */
+	const word a[],			/*!< [in] первое основание */
+	const word b[],			/*!< [in] первый показатель */
+	size_t m,				/*!< [in] длина b в машинных словах */
+	const word d[],			/*!< [in] второе основание */
+	const word e[],			/*!< [in] второй показатель */
+	size_t k,				/*!< [in] длина e в машинных словах */
+	const qr_o* r,			/*!< [in] описание кольца */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
+size_t qrPower2_deep(size_t n, size_t m, size_t k, size_t r_deep);
+
+/*! \brief Пакетное обращение в кольце вычетов
+
+	В кольце вычетов r определяются элементы [count * r->n]b,
+	мультипликативно обратные к элементам [count * r->n]a:
+	\code
+		b[i] <- a[i]^{-1},	i = 0, 1,..., count - 1.
+	\endcode
+	Нулевым элементам a[i] соответствуют нулевые b[i].
+	\pre Описание кольца r работоспособно.
+	\pre Элементы a[i] принадлежат r.
+	\pre Буферы a и b не пересекаются.
+	\expect Описание кольца r корректно.
+	\expect Ненулевые элементы a[i] обратимы. Если хотя бы один из них
+	не обратим, то b может быть любым.
+	\remark Реализован трюк Монтгомери: вместо count обращений выполняется
+	одно обращение и 3(count - 1) умножений.
+	\deep{stack} qrInvBatch_deep(r->n, r->deep).
+*/
+void qrInvBatch(
+	word b[],				/*!< [out] обратные элементы */
+	const word a[],			/*!< [in] обращаемые элементы */
+	size_t count,			/*!< [in] число элементов */
+	const qr_o* r,			/*!< [in] описание кольца */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
+size_t qrInvBatch_deep(size_t n, size_t r_deep);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief Quotient rings of integers modulo m
 \project bee2 [cryptographic library]
 \created 2013.09.14
-\version 2023.02.02
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -166,11 +166,15 @@ size_t zmCreateMont_deep(size_t no);
 	вычислений) описание.
 	\pre no > 0 && mod[no - 1] > 0.
 	\post r->no == no и r->n == W_OF_O(no).
-	\remark Оптимальное кольцо подбирается с учетом следующих 
-	результатов экспериментов (2013.09.17):
-	-	редукция Крэндалла примерно в 2 раза быстрее редукции Монтгомери;
-	-	редукция Монтгомери примерно в 2 раза быстрее редукции Барретта;
-	-	редукция Барретта несколько опережает обычную редукцию при r->n >= 4.
+	\remark Оптимальное кольцо подбирается по форме модуля и порогам
+	ZM_MONT_THRESHOLD, ZM_BARR_THRESHOLD, ZM_PLAIN_THRESHOLD на длину
+	модуля в словах (см. zm.c). Пороги задаются при сборке. Для
+	текущей платформы пороги подбираются замерами zmBench (bee2bench).
+	По умолчанию:
+	-	модули Крэндалла: редукция Крэндалла;
+	-	нечетные модули: редукция Монтгомери;
+	-	четные модули из двух и более слов: редукция Барретта;
+	-	четные модули из одного слова: обычная редукция.
 	\keep{r} zmCreate_keep(no).
 	\deep{stack} zmCreate_deep(no).
 */
@@ -255,6 +259,201 @@ qr_sub_i, qr_neg_i идут прямые обращения к zzAddMod(), zzSub
 #define zmNeg(b, a, r)\
 	zzNegMod(b, a, (r)->mod, (r)->n)
 
+/*
+*******************************************************************************
+Восемь экземпляров кольца
+
+Функции zm8XXX() выполняют операции одновременно над 8 элементами кольца
+Zm = Z / (mod) с общим нечетным модулем mod (8 независимых дорожек).
+Дорожки используются в пакетных вычислениях: 8 экземпляров алгоритма,
+которые различаются только данными, выполняются синхронно.
+
+Перед вычислениями по модулю [n]mod строится состояние (zm8Start()).
+Модуль задается машинными словами и может не занимать старшие слова.
+
+Набор из 8 элементов (8-набор) задается массивом из 8 * L слов типа u64,
+где L = zm8Len(n) = ceil(n * B_PER_W / 52). Элементы разбиваются
+на 52-битовые разряды, разряд с номером i элемента с номером j
+размещается в позиции 8 * i + j массива. Элементы хранятся в форме
+Монтгомери с параметром R = 2^{52 L}: элемент a представляется вычетом
+a R \mod mod. Преобразование в форму Монтгомери и обратно выполняют
+функции zm8From(), zm8To().
+
+Если в библиотеке поддерживается ZM8_AUTO, а процессор поддерживает
+расширения AVX512F и AVX512IFMA, то умножения zm8Mul(), zm8Sqr()
+выполняются векторными инструкциями vpmadd52luq, vpmadd52huq над 8
+дорожками одновременно. Наличие векторной реализации можно проверить
+с помощью функции zm8IsFast(). В противном случае дорожки
+обрабатываются последовательно, и пакетные вычисления с помощью zm8XXX()
+теряют смысл.
+
+Время выполнения функций zm8XXX() зависит только от размерности n
+и длины показателя в zm8Power().
+
+\pre Все указатели действительны.
+\pre Входные 8-наборы содержат вычеты по модулю mod.
+\pre Буферы 8-наборов одной функции либо не пересекаются, либо совпадают.
+*******************************************************************************
+*/
+
+#ifdef U64_SUPPORT
+
+/*!	\brief Число разрядов в элементах 8-набора
+
+	Определяется число 52-битовых разрядов в элементах 8-наборов
+	по модулю из n машинных слов.
+	\return ceil(n * B_PER_W / 52).
+*/
+size_t zm8Len(
+	size_t n				/*!< [in] длина модуля в словах */
+);
+
+/*!	\brief Начало вычислений в 8 экземплярах кольца
+
+	По модулю [n]mod строится состояние state для вычислений в 8
+	экземплярах кольца Z / (mod).
+	\pre mod -- нечетное число и mod > 1.
+	\keep{state} zm8Start_keep(n).
+	\deep{stack} zm8Start_deep(n).
+*/
+void zm8Start(
+	void* state,			/*!< [out] состояние */
+	const word mod[],		/*!< [in] модуль */
+	size_t n,				/*!< [in] длина mod в словах */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
+size_t zm8Start_keep(size_t n);
+size_t zm8Start_deep(size_t n);
+
+/*!	\brief Загрузка 8-набора
+
+	Числа [n]a[0], [n]a[1],..., [n]a[7], размещенные подряд в массиве a,
+	преобразуются в элементы 8-набора b (в форме Монтгомери).
+	\pre Числа a[j] меньше модуля.
+	\deep{stack} zm8From_deep(n).
+*/
+void zm8From(
+	u64 b[],				/*!< [out] 8-набор */
+	const word a[],			/*!< [in] числа */
+	const void* state,		/*!< [in] состояние */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
+size_t zm8From_deep(size_t n);
+
+/*!	\brief Выгрузка 8-набора
+
+	Элементы 8-набора a преобразуются в числа [n]b[0], [n]b[1],...,
+	[n]b[7], которые размещаются подряд в массиве b.
+	\deep{stack} zm8To_deep(n).
+*/
+void zm8To(
+	word b[],				/*!< [out] числа */
+	const u64 a[],			/*!< [in] 8-набор */
+	const void* state,		/*!< [in] состояние */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
+size_t zm8To_deep(size_t n);
+
+/*!	\brief Сложение 8-наборов
+
+	Определяется 8-набор c с элементами c_j = a_j + b_j \mod mod.
+*/
+void zm8Add(
+	u64 c[],				/*!< [out] сумма */
+	const u64 a[],			/*!< [in] первое слагаемое */
+	const u64 b[],			/*!< [in] второе слагаемое */
+	const void* state		/*!< [in] состояние */
+);
+
+/*!	\brief Вычитание 8-наборов
+
+	Определяется 8-набор c с элементами c_j = a_j - b_j \mod mod.
+*/
+void zm8Sub(
+	u64 c[],				/*!< [out] разность */
+	const u64 a[],			/*!< [in] уменьшаемое */
+	const u64 b[],			/*!< [in] вычитаемое */
+	const void* state		/*!< [in] состояние */
+);
+
+/*!	\brief Умножение 8-наборов
+
+	Определяется 8-набор c с элементами c_j = a_j * b_j \mod mod
+	(умножение Монтгомери: a_j R * b_j R * R^{-1} == a_j b_j R).
+	\deep{stack} zm8Mul_deep(n).
+*/
+void zm8Mul(
+	u64 c[],				/*!< [out] произведение */
+	const u64 a[],			/*!< [in] первый множитель */
+	const u64 b[],			/*!< [in] второй множитель */
+	const void* state,		/*!< [in] состояние */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
+size_t zm8Mul_deep(size_t n);
+
+/*!	\brief Возведение 8-набора в квадрат
+
+	Определяется 8-набор b с элементами b_j = a_j^2 \mod mod.
+	\deep{stack} zm8Mul_deep(n).
+*/
+#define zm8Sqr(b, a, state, stack)\
+	zm8Mul(b, a, a, state, stack)
+
+/*!	\brief Возведение 8-набора в степень
+
+	Определяется 8-набор b с элементами b_j = a_j^d \mod mod, где
+	[m]d -- общий показатель.
+	\remark При d == 0 элементы b_j равняются 1.
+	\deep{stack} zm8Power_deep(n, m).
+*/
+void zm8Power(
+	u64 b[],				/*!< [out] степень */
+	const u64 a[],			/*!< [in] основание */
+	const word d[],			/*!< [in] показатель */
+	size_t m,				/*!< [in] длина d в словах */
+	const void* state,		/*!< [in] состояние */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
+size_t zm8Power_deep(size_t n, size_t m);
+
+/*!	\brief Выбор элементов 8-наборов
+
+	Определяется 8-набор c: c_j = b_j, если бит j маски mask равен 1,
+	и c_j = a_j в противном случае.
+*/
+void zm8Select(
+	u64 c[],				/*!< [out] результат */
+	const u64 a[],			/*!< [in] первый 8-набор */
+	const u64 b[],			/*!< [in] второй 8-набор */
+	size_t mask,			/*!< [in] маска дорожек */
+	const void* state		/*!< [in] состояние */
+);
+
+/*!	\brief Нулевые элементы 8-набора
+
+	Определяются элементы 8-набора a, равные нулю.
+	\return Маска дорожек: бит j маски равен 1, если a_j == 0.
+*/
+size_t zm8Zeros(
+	const u64 a[],			/*!< [in] 8-набор */
+	const void* state		/*!< [in] состояние */
+);
+
+/*!	\brief Быстрые вычисления в 8 экземплярах кольца?
+
+	Проверяется, что умножения 8-наборов выполняются векторными
+	инструкциями, т.е. одновременно для всех дорожек.
+	\return Признак векторной реализации.
+*/
+bool_t zm8IsFast();
+
+#endif /* U64_SUPPORT */
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,7 +4,7 @@
 \brief Multiple-precision unsigned integers
 \project bee2 [cryptographic library]
 \created 2012.04.22
-\version 2023.09.23
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -841,7 +841,7 @@ size_t zzSqrMod_deep(size_t n);
 	\expect \gcd(a, mod) == 1.
 	\remark Если \gcd(a, mod) != 1, то b <- 0.
 	\deep{stack} zzInvMod_deep(n).
-	\safe Функция нерегулярна.
+	\safe Имеется ускоренная нерегулярная реализация.
 */
 void zzInvMod(
 	word b[],			/*!< [out] обратное число */
@@ -851,6 +851,11 @@ void zzInvMod(
 	void* stack			/*!< [in] вспомогательная память */
 );
 
+void SAFE(zzInvMod)(word b[], const word a[], const word mod[], size_t n,
+	void* stack);
+void FAST(zzInvMod)(word b[], const word a[], const word mod[], size_t n,
+	void* stack);
+
 size_t zzInvMod_deep(size_t n);
 
 /*!	\brief Деление по модулю
@@ -865,8 +870,10 @@ size_t zzInvMod_deep(size_t n);
 	\pre Буфер b не пересекается с буфером mod.
 	\expect \gcd(a, mod) = 1.
 	\remark Если \gcd(a, mod) != 1, то b <- 0.
+	\remark В регулярной реализации используется алгоритм Бернштейна -- Янга
+	(шаги divstep). Время ее работы определяется только длиной mod.
 	\deep{stack} zzDivMod_deep(n).
-	\safe Функция нерегулярна.
+	\safe Имеется ускоренная нерегулярная реализация.
 */
 void zzDivMod(
 	word b[],				/*!< [out] частное */
@@ -877,6 +884,11 @@ void zzDivMod(
 	void* stack				/*!< [in] вспомогательная память */
 );
 
+void SAFE(zzDivMod)(word b[], const word divident[], const word a[],
+	const word mod[], size_t n, void* stack);
+void FAST(zzDivMod)(word b[], const word divident[], const word a[],
+	const word mod[], size_t n, void* stack);
+
 size_t zzDivMod_deep(size_t n);
 
 /*!	\brief Удвоение числа по модулю
@@ -4,7 +4,7 @@
 \brief Smart card Application Protocol Data Unit
 \project bee2 [cryptographic library]
 \created 2022.10.31
-\version 2022.11.03
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -36,85 +36,75 @@ bool_t apduCmdIsValid(const apdu_cmd_t* cmd)
 		cmd->rdf_len <= 65536;
 }
 
-size_t apduCmdEnc(octet apdu[], const apdu_cmd_t* cmd)
+size_t apduCmdCDFOffset(size_t cdf_len, size_t rdf_len)
+{
+	if (cdf_len >= 65536 || rdf_len > 65536)
+		return SIZE_MAX;
+	if (cdf_len == 0)
+		return 4;
+	if (cdf_len < 256 && rdf_len <= 256)
+		return 5;
+	return 7;
+}
+
+size_t apduCmdEnc2(octet apdu[], const octet hdr[4], size_t cdf_len,
+	size_t rdf_len)
 {
 	size_t count;
-	// pre
-	ASSERT(apduCmdIsValid(cmd));
-	// кодировать заголовок
+	// длина заголовка и Lc
+	count = apduCmdCDFOffset(cdf_len, rdf_len);
+	if (count == SIZE_MAX)
+		return SIZE_MAX;
+	// кодировать заголовок и Lc
 	if (apdu)
 	{
-		ASSERT(memIsDisjoint2(apdu, 4, cmd, apduCmdSizeof(cmd)));
-		apdu[0] = cmd->cla, apdu[1] = cmd->ins;
-		apdu[2] = cmd->p1, apdu[3] = cmd->p2;
-		apdu += 4;
-	}
-	count = 4;
-	// кодировать [cdf_len]cdf: пустая форма
-	if (cmd->cdf_len == 0)
-		count += 0 + cmd->cdf_len;
-	// кодировать [cdf_len]cdf: короткая форма
-	else if (cmd->cdf_len < 256 && cmd->rdf_len <= 256)
-	{
-		if (apdu)
+		ASSERT(memIsValid(hdr, 4));
+		ASSERT(hdr == apdu || memIsDisjoint2(apdu, count, hdr, 4));
+		if (hdr != apdu)
 		{
-			ASSERT(memIsDisjoint2(apdu, 1, cmd, apduCmdSizeof(cmd)));
-			apdu[0] = (octet)cmd->cdf_len;
-			memCopy(apdu + 1, cmd->cdf, cmd->cdf_len);
-			apdu += 1 + cmd->cdf_len;
+			apdu[0] = hdr[0], apdu[1] = hdr[1];
+			apdu[2] = hdr[2], apdu[3] = hdr[3];
 		}
-		count += 1 + cmd->cdf_len;
-	}
-	// кодировать [cdf_len]cdf: длинная форма
-	else
-	{
-		ASSERT(cmd->cdf_len < 65536);
-		if (apdu)
+		if (count == 5)
+			apdu[4] = (octet)cdf_len;
+		else if (count == 7)
 		{
-			ASSERT(memIsDisjoint2(apdu, 3, cmd, apduCmdSizeof(cmd)));
-			apdu[0] = 0;
-			apdu[1] = (octet)(cmd->cdf_len / 256);
-			apdu[2] = (octet)cmd->cdf_len;
-			memCopy(apdu + 3, cmd->cdf, cmd->cdf_len);
-			apdu += 3 + cmd->cdf_len;
+			apdu[4] = 0;
+			apdu[5] = (octet)(cdf_len / 256);
+			apdu[6] = (octet)cdf_len;
 		}
-		count += 3 + cmd->cdf_len;
+		apdu += count + cdf_len;
 	}
+	count += cdf_len;
 	// кодировать rdf_len: пустая форма
-	if (cmd->rdf_len == 0)
+	if (rdf_len == 0)
 		count += 0;
 	// кодировать rdf_len: короткая форма
-	else if (cmd->rdf_len <= 256 && cmd->cdf_len < 256)
+	else if (rdf_len <= 256 && cdf_len < 256)
 	{
 		if (apdu)
-		{
-			ASSERT(memIsDisjoint2(apdu, 1, cmd, apduCmdSizeof(cmd)));
-			apdu[0] = (octet)cmd->rdf_len;
-		}
+			apdu[0] = (octet)rdf_len;
 		count += 1;
 	}
 	// кодировать rdf_len: длинная форма, 2 октета
-	else if (cmd->cdf_len)
+	else if (cdf_len)
 	{ 
-		ASSERT(256 <= cmd->cdf_len || 256 < cmd->rdf_len);
-		ASSERT(cmd->rdf_len <= 65536);
+		ASSERT(256 <= cdf_len || 256 < rdf_len);
 		if (apdu)
 		{
-			ASSERT(memIsDisjoint2(apdu, 2, cmd, apduCmdSizeof(cmd)));
-			apdu[0] = (octet)(cmd->rdf_len / 256);
-			apdu[1] = (octet)cmd->rdf_len;
+			apdu[0] = (octet)(rdf_len / 256);
+			apdu[1] = (octet)rdf_len;
 		}
 		count += 2;
 	}
 	else
 	{
-		ASSERT(256 < cmd->rdf_len && cmd->rdf_len <= 65536);
+		ASSERT(256 < rdf_len);
 		if (apdu)
 		{
-			ASSERT(memIsDisjoint2(apdu, 3, cmd, apduCmdSizeof(cmd)));
 			apdu[0] = 0;
-			apdu[1] = (octet)(cmd->rdf_len / 256);
-			apdu[2] = (octet)cmd->rdf_len;
+			apdu[1] = (octet)(rdf_len / 256);
+			apdu[2] = (octet)rdf_len;
 		}
 		count += 3;
 	}
@@ -122,24 +112,36 @@ size_t apduCmdEnc(octet apdu[], const apdu_cmd_t* cmd)
 	return count;
 }
 
-size_t apduCmdDec(apdu_cmd_t* cmd, const octet apdu[], size_t count)
+size_t apduCmdEnc(octet apdu[], const apdu_cmd_t* cmd)
+{
+	octet hdr[4];
+	// pre
+	ASSERT(apduCmdIsValid(cmd));
+	// разместить cdf
+	if (apdu)
+	{
+		size_t offset = apduCmdCDFOffset(cmd->cdf_len, cmd->rdf_len);
+		ASSERT(memIsDisjoint2(apdu, apduCmdEnc(0, cmd),
+			cmd, apduCmdSizeof(cmd)));
+		memCopy(apdu + offset, cmd->cdf, cmd->cdf_len);
+	}
+	// кодировать
+	hdr[0] = cmd->cla, hdr[1] = cmd->ins, hdr[2] = cmd->p1, hdr[3] = cmd->p2;
+	return apduCmdEnc2(apdu, hdr, cmd->cdf_len, cmd->rdf_len);
+}
+
+bool_t apduCmdView(apdu_cmd_view_t* view, const octet apdu[], size_t count)
 {
+	const octet* hdr = apdu;
 	size_t cdf_len_len;
 	size_t cdf_len;
 	size_t rdf_len;
 	// pre
 	ASSERT(memIsValid(apdu, count));
-	ASSERT(memIsNullOrValid(cmd, sizeof(apdu_cmd_t)));
+	ASSERT(memIsNullOrValid(view, sizeof(apdu_cmd_view_t)));
 	// декодировать заголовок
 	if (count < 4)
-		return SIZE_MAX;
-	if (cmd)
-	{
-		ASSERT(memIsDisjoint2(cmd, sizeof(apdu_cmd_t), apdu, count));
-		memSetZero(cmd, sizeof(apdu_cmd_t));
-		cmd->cla = apdu[0], cmd->ins = apdu[1];
-		cmd->p1 = apdu[2], cmd->p2 = apdu[3];
-	}
+		return FALSE;
 	apdu += 4, count -= 4;
 	// декодировать cdf_len
 	if (count == 0 || count == 1 || count == 3 && apdu[0] == 0)
@@ -154,7 +156,7 @@ size_t apduCmdDec(apdu_cmd_t* cmd, const octet apdu[], size_t count)
 		else
 		{
 			if (count < 3)
-				return SIZE_MAX;
+				return FALSE;
 			cdf_len_len = 3;
 			cdf_len = apdu[1], cdf_len *= 256, cdf_len += apdu[2];
 		}
@@ -162,9 +164,9 @@ size_t apduCmdDec(apdu_cmd_t* cmd, const octet apdu[], size_t count)
 	}
 	// декодировать cdf
 	if (cdf_len > count)
-		return SIZE_MAX;
-	if (cmd)
-		memCopy(cmd->cdf, apdu, cdf_len);
+		return FALSE;
+	if (view)
+		view->cdf = apdu;
 	apdu += cdf_len, count -= cdf_len;
 	// декодировать rdf_len
 	switch (count)
@@ -178,7 +180,7 @@ size_t apduCmdDec(apdu_cmd_t* cmd, const octet apdu[], size_t count)
 		if (rdf_len == 0)
 			rdf_len = 256;
 		if (cdf_len_len == 3)
-			return SIZE_MAX;
+			return FALSE;
 		break;
 	case 2:
 		// длинная форма, 2 октета
@@ -186,7 +188,7 @@ size_t apduCmdDec(apdu_cmd_t* cmd, const octet apdu[], size_t count)
 		if (rdf_len == 0)
 			rdf_len = 65536;
 		if (cdf_len_len <= 1 || cdf_len < 256 && rdf_len <= 256)
-			return SIZE_MAX;
+			return FALSE;
 		break;
 	case 3:
 		// длинная форма, 3 октета
@@ -194,16 +196,43 @@ size_t apduCmdDec(apdu_cmd_t* cmd, const octet apdu[], size_t count)
 		if (rdf_len == 0)
 			rdf_len = 65536;
 		if (apdu[0] != 0 || cdf_len_len != 0 || rdf_len <= 256)
-			return SIZE_MAX;
+			return FALSE;
 		break;
 	default:
-		return SIZE_MAX;
+		return FALSE;
+	}
+	// заполнить представление
+	if (view)
+	{
+		view->cla = hdr[0], view->ins = hdr[1];
+		view->p1 = hdr[2], view->p2 = hdr[3];
+		view->cdf_len = cdf_len, view->rdf_len = rdf_len;
 	}
-	// сохранить длины
+	return TRUE;
+}
+
+size_t apduCmdDec(apdu_cmd_t* cmd, const octet apdu[], size_t count)
+{
+	apdu_cmd_view_t view[1];
+	// pre
+	ASSERT(memIsValid(apdu, count));
+	ASSERT(memIsNullOrValid(cmd, sizeof(apdu_cmd_t)));
+	// разобрать
+	if (!apduCmdView(view, apdu, count))
+		return SIZE_MAX;
+	// скопировать
 	if (cmd)
-		cmd->cdf_len = cdf_len, cmd->rdf_len = rdf_len;
+	{
+		ASSERT(memIsDisjoint2(cmd, sizeof(apdu_cmd_t) + view->cdf_len,
+			apdu, count));
+		memSetZero(cmd, sizeof(apdu_cmd_t));
+		cmd->cla = view->cla, cmd->ins = view->ins;
+		cmd->p1 = view->p1, cmd->p2 = view->p2;
+		cmd->cdf_len = view->cdf_len, cmd->rdf_len = view->rdf_len;
+		memCopy(cmd->cdf, view->cdf, view->cdf_len);
+	}
 	// возвратить размер cmd
-	return sizeof(apdu_cmd_t) + cdf_len;
+	return sizeof(apdu_cmd_t) + view->cdf_len;
 }
 
 /*
@@ -234,6 +263,35 @@ size_t apduRespEnc(octet apdu[], const apdu_resp_t* resp)
 	return resp->rdf_len + 2;
 }
 
+size_t apduRespEnc2(octet apdu[], size_t rdf_len, octet sw1, octet sw2)
+{
+	if (rdf_len > 65536)
+		return SIZE_MAX;
+	if (apdu)
+	{
+		ASSERT(memIsValid(apdu, rdf_len + 2));
+		apdu[rdf_len] = sw1, apdu[rdf_len + 1] = sw2;
+	}
+	return rdf_len + 2;
+}
+
+bool_t apduRespView(apdu_resp_view_t* view, const octet apdu[], size_t count)
+{
+	// pre
+	ASSERT(memIsValid(apdu, count));
+	ASSERT(memIsNullOrValid(view, sizeof(apdu_resp_view_t)));
+	// разобрать
+	if (count < 2 || count - 2 > 65536)
+		return FALSE;
+	if (view)
+	{
+		view->sw1 = apdu[count - 2], view->sw2 = apdu[count - 1];
+		view->rdf_len = count - 2;
+		view->rdf = apdu;
+	}
+	return TRUE;
+}
+
 size_t apduRespDec(apdu_resp_t* resp, const octet apdu[], size_t count)
 {
 	// pre
@@ -4,7 +4,7 @@
 \brief The Base64 encoding
 \project bee2 [cryptographic library]
 \created 2016.06.16
-\version 2016.09.01
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -15,37 +15,230 @@
 #include "bee2/core/str.h"
 #include "bee2/core/util.h"
 
+#if defined(__SSE2__) || defined(_M_X64) ||\
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define B64_SSE2
+#endif
+
 /*
 *******************************************************************************
-Таблицы
+Символы
+
+Символы кодируются и декодируются арифметически, без таблиц и ветвлений,
+зависящих от данных. Поэтому кодирование и декодирование регулярны
+и пригодны для обработки секретных данных.
+
+Функция b64DecC() возвращает 6-ку битов, соответствующую символу ch,
+и взводит бит 8, если символ не входит в алфавит. Функция b64DecS()
+дописывает 6-ку символа ch к block и накапливает ошибки в err. Макрос b64In()
+возвращает 1, если lo <= c <= hi, и 0 в противном случае. Функция b64EncS()
+возвращает символ для 6-ки x: к x прибавляется 'A' и поправки на границах
+диапазонов алфавита.
 
 \todo Кодировка base64url: + меняется на -, / меняется на _.
 *******************************************************************************
 */
 
-static const char b64_alphabet[] = 
-	"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-	"abcdefghijklmnopqrstuvwxyz"
-	"0123456789+/";
-
-static const octet b64_dec_table[256] = {
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x3E,0xFF,0xFF,0xFF,0x3F,
-	0x34,0x35,0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,
-	0x0F,0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0x1A,0x1B,0x1C,0x1D,0x1E,0x1F,0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,
-	0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F,0x30,0x31,0x32,0x33,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-};
+#define b64In(c, lo, hi)\
+	((((u32)(((c) - (lo)) | ((hi) - (c)))) >> 31) ^ 1)
+
+static u32 b64DecC(char ch)
+{
+	register int c = (octet)ch;
+	register u32 m1 = b64In(c, 'A', 'Z');
+	register u32 m2 = b64In(c, 'a', 'z');
+	register u32 m3 = b64In(c, '0', '9');
+	register u32 m4 = b64In(c, '+', '+');
+	register u32 m5 = b64In(c, '/', '/');
+	return ((u32)(c - 'A') & (0 - m1)) |
+		((u32)(c - 'a' + 26) & (0 - m2)) |
+		((u32)(c - '0' + 52) & (0 - m3)) |
+		(62 & (0 - m4)) | (63 & (0 - m5)) |
+		((m1 | m2 | m3 | m4 | m5) ^ 1) << 8;
+}
+
+static u32 b64DecS(u32 block, char ch, u32* err)
+{
+	register u32 s = b64DecC(ch);
+	*err |= s;
+	return block << 6 | (s & 63);
+}
+
+static char b64EncS(register u32 x)
+{
+	register int c = (int)x + 'A';
+	c += 6 & -(int)((u32)(25 - x) >> 31);
+	c -= 75 & -(int)((u32)(51 - x) >> 31);
+	c -= 15 & -(int)((u32)(61 - x) >> 31);
+	c += 3 & -(int)((u32)(62 - x) >> 31);
+	return (char)c;
+}
+
+/*
+*******************************************************************************
+Серии
+
+Функция b64Dec() декодирует строку [len]src без символов '=' в буфер dest
+и возвращает признак корректности: символы принадлежат алфавиту, неполный
+последний блок (2 или 3 символа) не содержит лишних ненулевых битов.
+Если dest == 0, то выполняется только проверка. Функция b64Enc()
+кодирует полные тройки октетов [3 * count]src в строку
+[4 * count]dest.
+
+При наличии SSE2 строки обрабатываются порциями по 16 символов
+(12 октетов). Символы переводятся в 6-ки (и обратно) векторными
+сравнениями с границами диапазонов алфавита, ошибки накапливаются в маске
+без досрочного выхода. Упаковка 6-ок в 24-ки битов выполняется векторными
+сдвигами и инструкцией pmaddwd. В SSE2 нет инструкции pshufb, поэтому
+24-ки записываются 32-битовыми словами внахлест, и при декодировании
+за порцией должен следовать хотя бы еще один блок из 4 символов.
+*******************************************************************************
+*/
+
+#if defined(B64_SSE2)
+
+#define b64InV(c, lo, hi)\
+	_mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8((lo) - 1)),\
+		_mm_cmplt_epi8(c, _mm_set1_epi8((hi) + 1)))
+
+static __m128i b64DecV(__m128i c, __m128i* err)
+{
+	__m128i m1 = b64InV(c, 'A', 'Z');
+	__m128i m2 = b64InV(c, 'a', 'z');
+	__m128i m3 = b64InV(c, '0', '9');
+	__m128i m4 = _mm_cmpeq_epi8(c, _mm_set1_epi8('+'));
+	__m128i m5 = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+	__m128i v;
+	*err = _mm_or_si128(*err, _mm_cmpeq_epi8(_mm_or_si128(
+		_mm_or_si128(_mm_or_si128(m1, m2), _mm_or_si128(m3, m4)), m5),
+		_mm_setzero_si128()));
+	v = _mm_and_si128(m1, _mm_sub_epi8(c, _mm_set1_epi8('A')));
+	v = _mm_or_si128(v, _mm_and_si128(m2, _mm_sub_epi8(c,
+		_mm_set1_epi8('a' - 26))));
+	v = _mm_or_si128(v, _mm_and_si128(m3, _mm_add_epi8(c,
+		_mm_set1_epi8(52 - '0'))));
+	v = _mm_or_si128(v, _mm_and_si128(m4, _mm_set1_epi8(62)));
+	return _mm_or_si128(v, _mm_and_si128(m5, _mm_set1_epi8(63)));
+}
+
+static __m128i b64EncV(__m128i x)
+{
+	__m128i c = _mm_add_epi8(x, _mm_set1_epi8('A'));
+	c = _mm_add_epi8(c, _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(25)),
+		_mm_set1_epi8(6)));
+	c = _mm_sub_epi8(c, _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(51)),
+		_mm_set1_epi8(75)));
+	c = _mm_sub_epi8(c, _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(61)),
+		_mm_set1_epi8(15)));
+	return _mm_add_epi8(c, _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(62)),
+		_mm_set1_epi8(3)));
+}
+
+#endif // B64_SSE2
+
+static bool_t b64Dec(octet* dest, const char* src, size_t len)
+{
+	register u32 block;
+	u32 err = 0;
+#if defined(B64_SSE2)
+	__m128i e = _mm_setzero_si128();
+	size_t i;
+	for (; len >= 20; len -= 16, src += 16)
+	{
+		__m128i v = b64DecV(_mm_loadu_si128((const __m128i*)src), &e);
+		// (s0, s1) -> s0 << 6 | s1 в 16-битовых словах
+		v = _mm_or_si128(
+			_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00FF)), 6),
+			_mm_srli_epi16(v, 8));
+		// (p0, p1) -> p0 << 12 | p1 в 32-битовых словах
+		v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+		if (dest)
+		{
+			// b0 << 16 | b1 << 8 | b2 -> b2 << 16 | b1 << 8 | b0
+			v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+			v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+			v = _mm_srli_epi32(v, 8);
+			// 4-й октет каждой записи перекрывается следующей записью
+			for (i = 0; i < 4; ++i, dest += 3, v = _mm_srli_si128(v, 4))
+				*(u32*)dest = (u32)_mm_cvtsi128_si32(v);
+		}
+	}
+	err = (u32)_mm_movemask_epi8(e) << 8;
+#endif
+	for (; len >= 4; len -= 4, src += 4)
+	{
+		block = b64DecS(0, src[0], &err);
+		block = b64DecS(block, src[1], &err);
+		block = b64DecS(block, src[2], &err);
+		block = b64DecS(block, src[3], &err);
+		if (dest)
+		{
+			dest[2] = (octet)block, block >>= 8;
+			dest[1] = (octet)block, block >>= 8;
+			dest[0] = (octet)block;
+			dest += 3;
+		}
+	}
+	if (len == 3)
+	{
+		block = b64DecS(0, src[0], &err);
+		block = b64DecS(block, src[1], &err);
+		block = b64DecS(block, src[2], &err);
+		// 2 младших бита -- нулевые
+		err |= (block & 3) << 8, block >>= 2;
+		if (dest)
+			dest[1] = (octet)block, dest[0] = (octet)(block >> 8);
+	}
+	else if (len == 2)
+	{
+		block = b64DecS(0, src[0], &err);
+		block = b64DecS(block, src[1], &err);
+		// 4 младших бита -- нулевые
+		err |= (block & 15) << 8, block >>= 4;
+		if (dest)
+			dest[0] = (octet)block;
+	}
+	else if (len == 1)
+		err |= 1 << 8;
+	block = 0;
+	return (err >> 8) == 0;
+}
+
+static void b64Enc(char* dest, const octet* src, size_t count)
+{
+	register u32 block;
+#if defined(B64_SSE2)
+	for (; count >= 4; count -= 4, src += 12, dest += 16)
+	{
+		__m128i v = _mm_set_epi32(
+			src[9] << 16 | src[10] << 8 | src[11],
+			src[6] << 16 | src[7] << 8 | src[8],
+			src[3] << 16 | src[4] << 8 | src[5],
+			src[0] << 16 | src[1] << 8 | src[2]);
+		__m128i m = _mm_set1_epi32(63);
+		// 24-ка -> 6-ки в порядке следования символов
+		v = _mm_or_si128(
+			_mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 18), m),
+				_mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 12), m), 8)),
+			_mm_or_si128(
+				_mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 6), m), 16),
+				_mm_slli_epi32(_mm_and_si128(v, m), 24)));
+		_mm_storeu_si128((__m128i*)dest, b64EncV(v));
+	}
+#endif
+	for (; count; --count, src += 3, dest += 4)
+	{
+		block  = src[0], block <<= 8;
+		block |= src[1], block <<= 8;
+		block |= src[2];
+		dest[3] = b64EncS(block & 63), block >>= 6;
+		dest[2] = b64EncS(block & 63), block >>= 6;
+		dest[1] = b64EncS(block & 63), block >>= 6;
+		dest[0] = b64EncS(block);
+	}
+	block = 0;
+}
 
 /*
 *******************************************************************************
@@ -65,25 +258,8 @@ bool_t b64IsValid(const char* b64)
 	// обработать паддинг 
 	if (len && b64[len - 1] == '=' && b64[--len - 1] == '=')
 		--len;
-	// последний блок данных из 2 октетов?
-	if (len % 4 == 3)
-	{
-		if (b64_dec_table[(octet)b64[len - 1]] & 3)
-			return FALSE;
-		--len;
-	}
-	// последний блок данных из 1 октета?
-	else if (len % 4 == 2)
-	{
-		if (b64_dec_table[(octet)b64[len - 1]] & 15)
-			return FALSE;
-		--len;
-	}
-	// проверить остальные символы 
-	for (; len--; ++b64)
-		if (b64_dec_table[(octet)*b64] == 0xFF)
-			return FALSE;
-	return TRUE;
+	// проверить символы
+	return b64Dec(0, b64, len);
 }
 
 /*
@@ -96,82 +272,50 @@ void b64From(char* dest, const void* src, size_t count)
 {
 	register u32 block;
 	ASSERT(memIsDisjoint2(src, count, dest, 4 * ((count + 2) / 3) + 1));
-	for (; count >= 3; count -= 3)
-	{
-		block  = ((const octet*)src)[0], block <<= 8;
-		block |= ((const octet*)src)[1], block <<= 8;
-		block |= ((const octet*)src)[2];
-		dest[3] = b64_alphabet[block & 63], block >>= 6;
-		dest[2] = b64_alphabet[block & 63], block >>= 6;
-		dest[1] = b64_alphabet[block & 63], block >>= 6;
-		dest[0] = b64_alphabet[block];
-		src = (const octet*)src + 3;
-		dest += 4;
-	}
+	b64Enc(dest, (const octet*)src, count / 3);
+	src = (const octet*)src + count / 3 * 3;
+	dest += count / 3 * 4;
+	count %= 3;
 	if (count == 2)
 	{
 		block  = ((const octet*)src)[0], block <<= 8;
 		block |= ((const octet*)src)[1], block <<= 2;
 		dest[3] = '=';
-		dest[2] = b64_alphabet[block & 63], block >>= 6;
-		dest[1] = b64_alphabet[block & 63], block >>= 6;
-		dest[0] = b64_alphabet[block];
+		dest[2] = b64EncS(block & 63), block >>= 6;
+		dest[1] = b64EncS(block & 63), block >>= 6;
+		dest[0] = b64EncS(block);
 		dest += 4;
 	}
 	else if (count == 1)
 	{
 		block  = ((const octet*)src)[0], block <<= 4;
 		dest[3] = dest[2] = '=';
-		dest[1] = b64_alphabet[block & 63], block >>= 6;
-		dest[0] = b64_alphabet[block];
+		dest[1] = b64EncS(block & 63), block >>= 6;
+		dest[0] = b64EncS(block);
 		dest += 4;
 	}
 	*dest = '\0';
 	block = 0;
 }
 
-void b64To(void* dest, size_t* count, const char* src)
+bool_t b64To(void* dest, size_t* count, const char* src)
 {
-	register u32 block;
 	size_t len;
-	ASSERT(b64IsValid(src));
+	ASSERT(strIsValid(src));
 	ASSERT(memIsValid(count, sizeof(size_t)));
 	ASSERT(memIsNullOrValid(dest, *count));
-	// размер dest
+	// проверить длину
 	len = strLen(src);
+	if (len % 4)
+		return FALSE;
+	// размер dest
 	if (len && src[len - 1] == '=' && src[--len - 1] == '=')
 		--len;
 	ASSERT(dest ? *count >= 3 * (len / 4) + (len & 1) + (len >> 1 & 1) : TRUE);
 	*count = 3 * (len / 4) + (len & 1) + (len >> 1 & 1);
 	if (dest == 0)
-		return;
+		return TRUE;
 	// декодировать
 	ASSERT(memIsDisjoint2(src, strLen(src) + 1, dest, *count));
-	for (; len >= 4; len -= 4)
-	{
-		block  = b64_dec_table[(octet)src[0]], block <<= 6;
-		block |= b64_dec_table[(octet)src[1]], block <<= 6;
-		block |= b64_dec_table[(octet)src[2]], block <<= 6;
-		block |= b64_dec_table[(octet)src[3]];
-		((octet*)dest)[2] = block & 255, block >>= 8;
-		((octet*)dest)[1] = block & 255, block >>= 8;
-		((octet*)dest)[0] = block;
-		src += 4;
-		dest = (octet*)dest + 3;
-	}
-	if (len == 3)
-	{
-		block  = b64_dec_table[(octet)src[0]], block <<= 6;
-		block |= b64_dec_table[(octet)src[1]], block <<= 6;
-		block |= b64_dec_table[(octet)src[2]], block >>= 2;
-		((octet*)dest)[1] = block & 255, block >>= 8;
-		((octet*)dest)[0] = block;
-	}
-	else if (len == 2)
-	{
-		block  = b64_dec_table[(octet)src[0]], block <<= 6;
-		block |= b64_dec_table[(octet)src[1]], block >>= 4;
-		((octet*)dest)[0] = block;
-	}
-	block = 0;
+	return b64Dec((octet*)dest, src, len);
 }
@@ -4,7 +4,7 @@
 \brief Blobs
 \project bee2 [cryptographic library]
 \created 2012.04.01
-\version 2023.03.23
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -12,62 +12,442 @@
 
 #include "bee2/core/blob.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
 #include "bee2/core/util.h"
 
+#if defined(OS_UNIX)
+	#include <sys/mman.h>
+	#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+		#define MAP_ANONYMOUS MAP_ANON
+	#endif
+#endif
+
 /*
 *******************************************************************************
 Блоб: реализация
 
-В куче выделяется память под указатель ptr. Память выделяется страницами.
+Блоб предваряется заголовком из BLOB_HDR_SIZE = BLOB_ALIGN октетов.
+В заголовке размещаются размер блоба и номер его класса: 0 -- блоб в куче, i + 1 --
+блоб в ячейке класса i, BLOB_MAP -- блоб в отдельном отображении страниц,
+BLOB_THP -- то же с запросом прозрачных больших страниц, BLOB_HUGE --
+блоб в отдельном отображении явных больших страниц.
+
+Ячейка класса i занимает BLOB_SLOT_MIN << i октетов вместе с заголовком.
+Ячейки нарезаются из страничных областей (арен) длины BLOB_ARENA_SIZE.
+Арены запрашиваются у операционной системы (mmap(), VirtualAlloc())
+и закрепляются в физической памяти (mlock(), VirtualLock()). Если
+закрепить арену не удалось, то она все равно используется. Число арен
+ограничено BLOB_ARENAS_MAX. Арены не возвращаются операционной системе.
+
+Освобожденные ячейки связываются в списки: общие (защищены мьютексом)
+и кэши потоков (закрепляются за потоками с помощью ключа, см. mtKeyCreate()).
+В кэше потока хранится не более BLOB_CACHE_MAX ячеек каждого класса.
+При переполнении кэша половина ячеек возвращается в общий список, при
+опустошении -- ячейки берутся из общего списка порциями. При завершении
+потока кэш возвращается в общий список. Ячейка может быть освобождена
+в потоке, отличном от создавшего ее.
+
+Блобы в куче выделяются страницами по BLOB_PAGE_SIZE октетов. К странице
+добавляются BLOB_ALIGN - 1 октетов для выравнивания, указатель на
+выделенную память сохраняется в заголовке (третье слово).
+
+Блобы выравниваются на границу BLOB_ALIGN: арены и отображения страниц
+выровнены на границу страниц, размеры ячеек -- степени двойки, не
+меньшие 2 * BLOB_ALIGN, и заголовок занимает BLOB_ALIGN октетов.
+Поэтому блоб начинается с новой строки кэша и не делит строки кэша
+с другими блобами.
+
+Блобы размера не меньше BLOB_HUGE_MIN (крупные таблицы предвычислений,
+кэши ключей, пакеты проверки подписей) размещаются в отдельных отображениях
+страниц. Сначала запрашиваются явные большие страницы (mmap() с флагом
+MAP_HUGETLB, VirtualAlloc() с флагом MEM_LARGE_PAGES) размера
+BLOB_HUGE_PAGE. Они доступны, только если администратор зарезервировал
+большие страницы (Linux) или выдал процессу привилегию SeLockMemoryPrivilege
+(Windows). Если явные большие страницы недоступны, то запрашиваются обычные
+страницы, и в Linux для них запрашиваются прозрачные большие страницы
+(madvise(MADV_HUGEPAGE)). Если не удалось и это, то блоб размещается в куче.
+Длины отображений округляются вверх до кратных BLOB_HUGE_PAGE, поэтому
+после переноса блоба в отображение страниц изменение его размера в пределах
+округления не требует нового переноса.
 
-Первые sizeof(size_t) октетов по адресу ptr --- размер блоба,
-следующие октеты --- собственно блоб.
+Большие страницы снижают промахи TLB при произвольном доступе к таблицам.
+Объем памяти в больших страницах (явных и прозрачных) возвращается
+в статистике blobStat().
 
-\todo Обеспечить защиту памяти блоба от утечек.
+При освобождении блоба очищаются только заголовок и size октетов блоба.
+Поэтому при уменьшении размера блоба отбрасываемые октеты очищаются,
+а при перераспределении памяти блоб переносится в новую память
+(память, освобождаемая memRealloc(), не очищается).
 
 \todo Полноценная проверка корректности блоба.
 *******************************************************************************
 */
 
-// память для блобов выделяется страницами
+#define BLOB_HDR_SIZE BLOB_ALIGN
 #define BLOB_PAGE_SIZE 1024
+#define BLOB_SLOT_MIN (2 * BLOB_ALIGN)
+#define BLOB_CLASSES 8
+#define BLOB_ARENA_SIZE 65536
+#define BLOB_ARENAS_MAX 256
+#define BLOB_CACHE_MAX 16
+#define BLOB_HUGE_MIN ((size_t)1 << 21)
+#define BLOB_HUGE_PAGE ((size_t)1 << 21)
+#define BLOB_MAP (BLOB_CLASSES + 1)
+#define BLOB_THP (BLOB_CLASSES + 2)
+#define BLOB_HUGE (BLOB_CLASSES + 3)
 
-// требуется страниц
-#define blobPageCount(size)\
-	(((size) + sizeof(size_t) + BLOB_PAGE_SIZE - 1) / BLOB_PAGE_SIZE)
+// заголовок блоба
+#define blobHdrOf(blob) ((size_t*)((octet*)(blob) - BLOB_HDR_SIZE))
 
-// требуется памяти на страницах
-#define blobActualSize(size)\
-	(blobPageCount(size) * BLOB_PAGE_SIZE)
+// размер блоба
+#define blobSizeOf(blob) (blobHdrOf(blob)[0])
 
-// heap-указатель для блоба
-#define blobPtrOf(blob) ((size_t*)blob - 1)
+// класс блоба
+#define blobClassOf(blob) (blobHdrOf(blob)[1])
 
-// размер блоба
-#define blobSizeOf(blob) (*blobPtrOf(blob))
+// память блоба в куче (указатель, возвращенный memAlloc())
+#define blobHeapOf(blob) (((void**)blobHdrOf(blob))[2])
+
+// блоб по заголовку
+#define blobValueOf(hdr) ((blob_t)((octet*)(hdr) + BLOB_HDR_SIZE))
+
+// размер ячейки класса i
+#define blobSlotSize(i) ((size_t)BLOB_SLOT_MIN << (i))
+
+// память блоба в куче
+#define blobHeapSize(size)\
+	((BLOB_HDR_SIZE + (size) + BLOB_PAGE_SIZE - 1) / BLOB_PAGE_SIZE *\
+		BLOB_PAGE_SIZE)
+
+// память блоба в отображении страниц
+#define blobMapSize(size)\
+	((BLOB_HDR_SIZE + (size) + BLOB_HUGE_PAGE - 1) / BLOB_HUGE_PAGE *\
+		BLOB_HUGE_PAGE)
+
+// блоб в отображении страниц?
+#define blobIsMapped(blob) (blobClassOf(blob) > BLOB_CLASSES)
+
+// память блоба
+#define blobActualSizeOf(blob)\
+	(blobIsMapped(blob) ? blobMapSize(blobSizeOf(blob)) :\
+		blobClassOf(blob) ? blobSlotSize(blobClassOf(blob) - 1) :\
+		blobHeapSize(blobSizeOf(blob)))
+
+// ссылка на следующую свободную ячейку
+#define blobSlotNext(slot) (*(void**)(slot))
+
+/*
+*******************************************************************************
+Пулы
+*******************************************************************************
+*/
+
+typedef struct
+{
+	void* head[BLOB_CLASSES];	/*< списки свободных ячеек */
+	size_t count[BLOB_CLASSES];	/*< длины списков */
+} blob_cache_st;
+
+static size_t _once;
+static bool_t _inited;
+static bool_t _keyed;
+static mt_mtx_t _mtx[1];
+static mt_key_t _key;
+static void* _head[BLOB_CLASSES];
+static octet* _arena;
+static size_t _arena_pos;
+static size_t _created;
+static size_t _pooled;
+static size_t _closed;
+static size_t _arenas;
+static size_t _locked;
+static size_t _mapped;
+static size_t _huge_size;
+static size_t _thp_size;
+
+static void MT_CALLBACK blobCacheClose(void* cache)
+{
+	blob_cache_st* c = (blob_cache_st*)cache;
+	size_t i;
+	void* slot;
+	if (!c)
+		return;
+	mtMtxLock(_mtx);
+	for (i = 0; i < BLOB_CLASSES; ++i)
+		while ((slot = c->head[i]))
+		{
+			c->head[i] = blobSlotNext(slot);
+			blobSlotNext(slot) = _head[i], _head[i] = slot;
+		}
+	mtMtxUnlock(_mtx);
+	memFree(c);
+}
+
+static void blobInit()
+{
+	_inited = mtMtxCreate(_mtx);
+	_keyed = _inited && mtKeyCreate(&_key, blobCacheClose);
+}
+
+static octet* blobArenaCreate()
+{
+	octet* arena;
+	bool_t locked;
+#if defined(OS_WIN)
+	arena = (octet*)VirtualAlloc(0, BLOB_ARENA_SIZE, MEM_COMMIT | MEM_RESERVE,
+		PAGE_READWRITE);
+	if (!arena)
+		return 0;
+	locked = VirtualLock(arena, BLOB_ARENA_SIZE) != 0;
+#elif defined(OS_UNIX) && defined(MAP_ANONYMOUS)
+	arena = (octet*)mmap(0, BLOB_ARENA_SIZE, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (arena == (octet*)MAP_FAILED)
+		return 0;
+	locked = mlock(arena, BLOB_ARENA_SIZE) == 0;
+	#if defined(MADV_DONTDUMP)
+		madvise(arena, BLOB_ARENA_SIZE, MADV_DONTDUMP);
+	#endif
+#else
+	arena = (octet*)memAlloc(BLOB_ARENA_SIZE);
+	if (!arena)
+		return 0;
+	locked = FALSE;
+#endif
+	mtAtomicIncr(&_arenas);
+	if (locked)
+		mtAtomicIncr(&_locked);
+	return arena;
+}
 
-// страничный размер блоба
-#define blobActualSizeOf(blob) (blobActualSize(blobSizeOf(blob)))
+// вызывается под мьютексом
+static void* blobSlotNew(size_t i)
+{
+	void* slot;
+	// свободная ячейка?
+	if ((slot = _head[i]))
+	{
+		_head[i] = blobSlotNext(slot);
+		return slot;
+	}
+	// новая арена?
+	if (!_arena || BLOB_ARENA_SIZE - _arena_pos < blobSlotSize(i))
+	{
+		if (mtAtomicLoad(&_arenas) >= BLOB_ARENAS_MAX ||
+			!(_arena = blobArenaCreate()))
+			return 0;
+		_arena_pos = 0;
+	}
+	// нарезать ячейку
+	slot = _arena + _arena_pos;
+	_arena_pos += blobSlotSize(i);
+	return slot;
+}
 
-// блоб для heap-указателя
-#define blobValueOf(ptr) ((blob_t)((size_t*)ptr + 1))
+static blob_cache_st* blobCacheGet(bool_t create)
+{
+	blob_cache_st* c;
+	if (!_keyed)
+		return 0;
+	c = (blob_cache_st*)mtKeyGet(&_key);
+	if (!c && create)
+	{
+		c = (blob_cache_st*)memAlloc(sizeof(blob_cache_st));
+		if (c)
+		{
+			memSetZero(c, sizeof(blob_cache_st));
+			if (!mtKeySet(&_key, c))
+				memFree(c), c = 0;
+		}
+	}
+	return c;
+}
+
+static void* blobSlotAlloc(size_t i)
+{
+	blob_cache_st* c;
+	void* slot;
+	if (!mtCallOnce(&_once, blobInit) || !_inited)
+		return 0;
+	// взять из кэша
+	c = blobCacheGet(TRUE);
+	if (c && (slot = c->head[i]))
+	{
+		c->head[i] = blobSlotNext(slot), --c->count[i];
+		return slot;
+	}
+	// взять из общего списка и пополнить кэш
+	mtMtxLock(_mtx);
+	slot = blobSlotNew(i);
+	if (c && slot)
+		while (c->count[i] < BLOB_CACHE_MAX / 2 && _head[i])
+		{
+			void* next = _head[i];
+			_head[i] = blobSlotNext(next);
+			blobSlotNext(next) = c->head[i], c->head[i] = next;
+			++c->count[i];
+		}
+	mtMtxUnlock(_mtx);
+	return slot;
+}
+
+static void blobSlotFree(void* slot, size_t i)
+{
+	blob_cache_st* c;
+	// вернуть в кэш
+	c = blobCacheGet(FALSE);
+	if (c && c->count[i] < BLOB_CACHE_MAX)
+	{
+		blobSlotNext(slot) = c->head[i], c->head[i] = slot;
+		++c->count[i];
+		return;
+	}
+	// вернуть в общий список (вместе с половиной кэша)
+	mtMtxLock(_mtx);
+	blobSlotNext(slot) = _head[i], _head[i] = slot;
+	if (c)
+		while (c->count[i] > BLOB_CACHE_MAX / 2)
+		{
+			slot = c->head[i];
+			c->head[i] = blobSlotNext(slot), --c->count[i];
+			blobSlotNext(slot) = _head[i], _head[i] = slot;
+		}
+	mtMtxUnlock(_mtx);
+}
+
+// класс для блоба размера size (BLOB_CLASSES, если блоб не помещается)
+static size_t blobClass(size_t size)
+{
+	size_t i;
+	for (i = 0; i < BLOB_CLASSES; ++i)
+		if (size <= blobSlotSize(i) - BLOB_HDR_SIZE)
+			break;
+	return i;
+}
+
+/*
+*******************************************************************************
+Отображения страниц
+*******************************************************************************
+*/
+
+// разместить count октетов, в class возвращается BLOB_MAP, BLOB_THP
+// или BLOB_HUGE
+static void* blobMapCreate(size_t* class, size_t count)
+{
+#if defined(OS_WIN)
+	size_t large = GetLargePageMinimum();
+	void* ptr;
+	ASSERT(count % BLOB_HUGE_PAGE == 0);
+	if (large && count % large == 0 &&
+		(ptr = VirtualAlloc(0, count, MEM_COMMIT | MEM_RESERVE |
+			MEM_LARGE_PAGES, PAGE_READWRITE)))
+		*class = BLOB_HUGE;
+	else if ((ptr = VirtualAlloc(0, count, MEM_COMMIT | MEM_RESERVE,
+		PAGE_READWRITE)))
+		*class = BLOB_MAP;
+	else
+		return 0;
+#elif defined(OS_UNIX) && defined(MAP_ANONYMOUS)
+	void* ptr = MAP_FAILED;
+	ASSERT(count % BLOB_HUGE_PAGE == 0);
+	#if defined(MAP_HUGETLB)
+	{
+		int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+		#if defined(MAP_HUGE_2MB)
+			flags |= MAP_HUGE_2MB;
+		#endif
+		ptr = mmap(0, count, PROT_READ | PROT_WRITE, flags, -1, 0);
+	}
+	#endif
+	if (ptr != MAP_FAILED)
+		*class = BLOB_HUGE;
+	else
+	{
+		ptr = mmap(0, count, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED)
+			return 0;
+		*class = BLOB_MAP;
+	#if defined(MADV_HUGEPAGE)
+		if (madvise(ptr, count, MADV_HUGEPAGE) == 0)
+			*class = BLOB_THP;
+	#endif
+	}
+	#if defined(MADV_DONTDUMP)
+		madvise(ptr, count, MADV_DONTDUMP);
+	#endif
+#else
+	return 0;
+#endif
+	if (*class == BLOB_HUGE)
+		mtAtomicFetchAdd(&_huge_size, count);
+	else if (*class == BLOB_THP)
+		mtAtomicFetchAdd(&_thp_size, count);
+	mtAtomicIncr(&_mapped);
+	return ptr;
+}
+
+static void blobMapClose(void* ptr, size_t class, size_t count)
+{
+	ASSERT(class == BLOB_MAP || class == BLOB_THP || class == BLOB_HUGE);
+	if (class == BLOB_HUGE)
+		mtAtomicFetchAdd(&_huge_size, (size_t)0 - count);
+	else if (class == BLOB_THP)
+		mtAtomicFetchAdd(&_thp_size, (size_t)0 - count);
+#if defined(OS_WIN)
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#elif defined(OS_UNIX) && defined(MAP_ANONYMOUS)
+	munmap(ptr, count);
+#endif
+}
+
+/*
+*******************************************************************************
+Управление блобами
+*******************************************************************************
+*/
 
 blob_t blobCreate(size_t size)
 {
-	size_t* ptr;
+	size_t* hdr = 0;
+	size_t i;
 	if (size == 0)
 		return 0;
-	ptr = (size_t*)memAlloc(blobActualSize(size));
-	if (ptr == 0)
-		return 0;
-	*ptr = size;
-	memSetZero(blobValueOf(ptr), size);
-	return blobValueOf(ptr);
+	// разместить в пуле
+	i = blobClass(size);
+	if (i < BLOB_CLASSES && (hdr = (size_t*)blobSlotAlloc(i)))
+		hdr[1] = i + 1, mtAtomicIncr(&_pooled);
+	// разместить в отображении страниц
+	else if (size >= BLOB_HUGE_MIN &&
+		size <= SIZE_MAX - BLOB_HDR_SIZE - BLOB_HUGE_PAGE &&
+		(hdr = (size_t*)blobMapCreate(&i, blobMapSize(size))))
+		hdr[1] = i;
+	// разместить в куче
+	else
+	{
+		void* ptr;
+		if (size > SIZE_MAX - BLOB_HDR_SIZE - BLOB_PAGE_SIZE - BLOB_ALIGN)
+			return 0;
+		ptr = memAlloc(blobHeapSize(size) + BLOB_ALIGN - 1);
+		if (ptr == 0)
+			return 0;
+		hdr = (size_t*)((octet*)ptr +
+			(BLOB_ALIGN - (size_t)ptr % BLOB_ALIGN) % BLOB_ALIGN);
+		hdr[1] = 0, ((void**)hdr)[2] = ptr;
+	}
+	hdr[0] = size;
+	mtAtomicIncr(&_created);
+	memSetZero(blobValueOf(hdr), size);
+	return blobValueOf(hdr);
 }
 
 bool_t blobIsValid(const blob_t blob)
 {
-	return blob == 0 || memIsValid(blobPtrOf(blob), blobActualSizeOf(blob));
+	return blob == 0 ||
+		(memIsValid(blobHdrOf(blob), BLOB_HDR_SIZE) &&
+		blobClassOf(blob) <= BLOB_HUGE &&
+		memIsValid(blobHdrOf(blob), blobActualSizeOf(blob)));
 }
 
 void blobWipe(blob_t blob)
@@ -79,18 +459,29 @@ void blobWipe(blob_t blob)
 
 void blobClose(blob_t blob)
 {
+	size_t i;
 	ASSERT(blobIsValid(blob));
 	if (blob)
 	{
-		memWipe(blobPtrOf(blob), blobActualSizeOf(blob));
-		memFree(blobPtrOf(blob));
+		size_t count = blobActualSizeOf(blob);
+		void* ptr;
+		i = blobClassOf(blob);
+		ptr = i ? blobHdrOf(blob) : blobHeapOf(blob);
+		memWipe(blobHdrOf(blob), BLOB_HDR_SIZE + blobSizeOf(blob));
+		if (i > BLOB_CLASSES)
+			blobMapClose(ptr, i, count);
+		else if (i)
+			blobSlotFree(ptr, i - 1);
+		else
+			memFree(ptr);
+		mtAtomicIncr(&_closed);
 	}
 }
 
 blob_t blobResize(blob_t blob, size_t size)
 {
 	size_t old_size;
-	size_t* ptr;
+	blob_t b;
 	// pre
 	ASSERT(blobIsValid(blob));
 	// создать блоб
@@ -104,20 +495,27 @@ blob_t blobResize(blob_t blob, size_t size)
 	}
 	// сохранить размер
 	old_size = blobSizeOf(blob);
-	// перераспределить память?
-	ptr = blobPtrOf(blob);
-	if (blobActualSizeOf(blob) != blobActualSize(size))
+	// изменить размер в прежней памяти?
+	if (blobIsMapped(blob) ?
+			size <= SIZE_MAX - BLOB_HDR_SIZE - BLOB_HUGE_PAGE &&
+			blobMapSize(size) == blobMapSize(old_size) :
+		blobClassOf(blob) ? blobClassOf(blob) == blobClass(size) + 1 :
+		size <= SIZE_MAX - BLOB_HDR_SIZE - BLOB_PAGE_SIZE &&
+			blobHeapSize(size) == blobHeapSize(old_size))
 	{
-		ptr = (size_t*)memRealloc(ptr, blobActualSize(size));
-		if (ptr == 0)
-			return 0;
+		if (size > old_size)
+			memSetZero((octet*)blob + old_size, size - old_size);
+		else
+			memWipe((octet*)blob + size, old_size - size);
+		blobSizeOf(blob) = size;
+		return blob;
 	}
-	// настроить и возвратить блоб
-	*ptr = size;
-	blob = blobValueOf(ptr);
-	if (size > old_size)
-		memSetZero((octet*)blob + old_size, size - old_size);
-	return blob;
+	// перенести блоб
+	if (!(b = blobCreate(size)))
+		return 0;
+	memCopy(b, blob, MIN2(size, old_size));
+	blobClose(blob);
+	return b;
 }
 
 size_t blobSize(const blob_t blob)
@@ -153,3 +551,16 @@ int blobCmp(const blob_t blob1, const blob_t blob2)
 		return blobSize(blob1) < blobSize(blob2) ? - 1 : 1;
 	return memCmp(blob1, blob2, blobSize(blob1));
 }
+
+void blobStat(blob_stat_t* stat)
+{
+	ASSERT(memIsValid(stat, sizeof(blob_stat_t)));
+	stat->created = mtAtomicLoad(&_created);
+	stat->pooled = mtAtomicLoad(&_pooled);
+	stat->closed = mtAtomicLoad(&_closed);
+	stat->arenas = mtAtomicLoad(&_arenas);
+	stat->locked = mtAtomicLoad(&_locked);
+	stat->mapped = mtAtomicLoad(&_mapped);
+	stat->huge_size = mtAtomicLoad(&_huge_size);
+	stat->thp_size = mtAtomicLoad(&_thp_size);
+}
@@ -0,0 +1,343 @@
+/*
+*******************************************************************************
+\file cpu.c
+\brief CPU features
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include <stdlib.h>
+#include "bee2/core/cpu.h"
+#include "bee2/core/mt.h"
+#include "bee2/core/str.h"
+#include "bee2/core/util.h"
+
+/*
+*******************************************************************************
+Имена наборов
+*******************************************************************************
+*/
+
+static const struct
+{
+	u32 feature;			/*< флаг */
+	const char* name;		/*< имя */
+} _names[] =
+{
+	{ CPU_SSE2, "sse2" },
+	{ CPU_SSSE3, "ssse3" },
+	{ CPU_PCLMUL, "pclmul" },
+	{ CPU_AVX, "avx" },
+	{ CPU_AVX2, "avx2" },
+	{ CPU_BMI2, "bmi2" },
+	{ CPU_ADX, "adx" },
+	{ CPU_AVX512F, "avx512f" },
+	{ CPU_AVX512BW, "avx512bw" },
+	{ CPU_AVX512VBMI, "avx512vbmi" },
+	{ CPU_AVX512IFMA, "avx512ifma" },
+	{ CPU_RDRAND, "rdrand" },
+	{ CPU_RDSEED, "rdseed" },
+	{ CPU_NEON, "neon" },
+	{ CPU_PMULL, "pmull" },
+};
+
+const char* cpuName(u32 feature)
+{
+	size_t i;
+	for (i = 0; i < COUNT_OF(_names); ++i)
+		if (_names[i].feature == feature)
+			return _names[i].name;
+	return 0;
+}
+
+/*
+*******************************************************************************
+Определение наборов
+
+Функция cpuDetect() возвращает наборы, которые поддерживаются процессором
+и операционной системой.
+
+На платформах x86, x64 используются листы 0, 1 и 7 инструкции cpuid:
+-	лист 0: максимальный номер листа и идентификатор производителя;
+-	лист 1: SSE2 (edx[26]), SSSE3 (ecx[9]), PCLMULQDQ (ecx[1]),
+	OSXSAVE (ecx[27]), AVX (ecx[28]), RDRAND (ecx[30]);
+-	лист 7: AVX2 (ebx[5]), BMI2 (ebx[8]), AVX512F (ebx[16]),
+	RDSEED (ebx[18]), ADX (ebx[19]), AVX512IFMA (ebx[21]),
+	AVX512BW (ebx[30]), AVX512VBMI (ecx[1]).
+
+Для AVX требуется, чтобы операционная система сохраняла регистры XMM, YMM
+(биты 1, 2 регистра XCR0), для AVX512 -- дополнительно регистры opmask,
+ZMM_Hi256, Hi16_ZMM (биты 5, 6, 7). Регистр XCR0 читается инструкцией
+xgetbv, которая доступна только при OSXSAVE.
+
+Наборы RDRAND, RDSEED учитываются только для процессоров Intel и AMD
+(источники trng, trng2 в rng.c).
+
+На платформе AArch64 набор NEON является базовым. Наличие PMULL
+определяется по флагу HWCAP_PMULL (Linux), параметру
+hw.optional.arm.FEAT_PMULL (Apple), функции IsProcessorFeaturePresent()
+(Windows). На остальных ОС наличие PMULL определяется во время компиляции
+(макрос __ARM_FEATURE_CRYPTO).
+
+\remark В cpu.c не вызываются функции mem.c: memXor() и другие функции
+обращаются к cpuHas() и могли бы оказаться внутри cpuInit().
+*******************************************************************************
+*/
+
+static bool_t cpuEq(const void* buf1, const void* buf2, size_t count)
+{
+	const octet* b1 = (const octet*)buf1;
+	const octet* b2 = (const octet*)buf2;
+	for (; count; --count)
+		if (*b1++ != *b2++)
+			return FALSE;
+	return TRUE;
+}
+
+#if (_MSC_VER >= 1600) && (defined(_M_IX86) || defined(_M_X64))
+
+#include <intrin.h>
+#include <immintrin.h>
+
+#define CPU_X86
+#define cpuCPUID(info, id) __cpuidex((int*)info, id, 0)
+#define cpuXCR0() ((u32)_xgetbv(0))
+
+#elif defined(_MSC_VER) && defined(_M_IX86)
+
+#define CPU_X86
+#define cpuid	__asm _emit 0x0F __asm _emit 0xA2
+#define xgetbv	__asm _emit 0x0F __asm _emit 0x01 __asm _emit 0xD0
+
+static void cpuCPUID(u32 info[4], u32 id)
+{
+	u32 a, b, c, d;
+	__asm {
+		mov eax, id
+		xor ecx, ecx
+		cpuid
+		mov a, eax
+		mov b, ebx
+		mov c, ecx
+		mov d, edx
+	}
+	info[0] = a, info[1] = b, info[2] = c, info[3] = d;
+}
+
+static u32 cpuXCR0()
+{
+	u32 a;
+	__asm {
+		xor ecx, ecx
+		xgetbv
+		mov a, eax
+	}
+	return a;
+}
+
+#elif (defined(__GNUC__) || defined(__clang__)) &&\
+	(defined(__i386__) || defined(__x86_64__))
+
+#include <cpuid.h>
+
+#define CPU_X86
+#define cpuCPUID(info, id)\
+	__cpuid_count(id, 0, info[0], info[1], info[2], info[3])
+
+static u32 cpuXCR0()
+{
+	u32 lo, hi;
+	__asm__ __volatile__ ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return lo;
+}
+
+#elif defined(__aarch64__) || defined(_M_ARM64)
+
+#define CPU_ARM64
+#if defined(OS_LINUX)
+	#include <sys/auxv.h>
+	#define CPU_HWCAP_PMULL ((unsigned long)1 << 4)
+#elif defined(OS_APPLE)
+	#include <sys/sysctl.h>
+#elif defined(OS_WIN)
+	#include <windows.h>
+#endif
+
+#endif
+
+#if defined(CPU_X86)
+
+static bool_t cpuIsManufId(const u32 info[4], const char id[12 + 1])
+{
+	ASSERT(strIsValid(id));
+	ASSERT(strLen(id) == 12);
+	return cpuEq(info + 1, id + 0, 4) &&
+		cpuEq(info + 3, id + 4, 4) &&
+		cpuEq(info + 2, id + 8, 4);
+}
+
+static u32 cpuDetect()
+{
+	u32 info[4];
+	u32 max_id, xcr0 = 0;
+	u32 f = 0;
+	bool_t rd;
+	cpuCPUID(info, 0);
+	if ((max_id = info[0]) < 1)
+		return 0;
+	// Intel or AMD?
+	rd = cpuIsManufId(info, "GenuineIntel") ||
+		cpuIsManufId(info, "AuthenticAMD");
+	cpuCPUID(info, 1);
+	if (info[3] & 0x04000000)
+		f |= CPU_SSE2;
+	if (info[2] & 0x00000200)
+		f |= CPU_SSSE3;
+	if (info[2] & 0x00000002)
+		f |= CPU_PCLMUL;
+	if (rd && (info[2] & 0x40000000))
+		f |= CPU_RDRAND;
+	// OSXSAVE && AVX (с сохранением регистров XMM, YMM)?
+	if ((info[2] & 0x18000000) == 0x18000000 &&
+		((xcr0 = cpuXCR0()) & 0x06) == 0x06)
+		f |= CPU_AVX;
+	if (max_id < 7)
+		return f;
+	cpuCPUID(info, 7);
+	if (info[1] & 0x00000100)
+		f |= CPU_BMI2;
+	if (info[1] & 0x00080000)
+		f |= CPU_ADX;
+	if (rd && (info[1] & 0x00040000))
+		f |= CPU_RDSEED;
+	if (!(f & CPU_AVX))
+		return f;
+	if (info[1] & 0x00000020)
+		f |= CPU_AVX2;
+	// AVX512 (с сохранением регистров opmask, ZMM_Hi256, Hi16_ZMM)?
+	if ((xcr0 & 0xE6) != 0xE6)
+		return f;
+	if (info[1] & 0x00010000)
+		f |= CPU_AVX512F;
+	if (info[1] & 0x40000000)
+		f |= CPU_AVX512BW;
+	if (info[2] & 0x00000002)
+		f |= CPU_AVX512VBMI;
+	if (info[1] & 0x00200000)
+		f |= CPU_AVX512IFMA;
+	return f;
+}
+
+#elif defined(CPU_ARM64)
+
+static u32 cpuDetect()
+{
+	u32 f = CPU_NEON;
+#if defined(OS_LINUX)
+	if (getauxval(AT_HWCAP) & CPU_HWCAP_PMULL)
+		f |= CPU_PMULL;
+#elif defined(OS_APPLE)
+	int val = 0;
+	size_t len = sizeof(val);
+	if (sysctlbyname("hw.optional.arm.FEAT_PMULL", &val, &len, 0, 0) == 0 &&
+		val)
+		f |= CPU_PMULL;
+#elif defined(OS_WIN)
+	if (IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE))
+		f |= CPU_PMULL;
+#elif defined(__ARM_FEATURE_CRYPTO)
+	f |= CPU_PMULL;
+#endif
+	return f;
+}
+
+#else
+
+static u32 cpuDetect()
+{
+	return 0;
+}
+
+#endif
+
+/*
+*******************************************************************************
+Снятие наборов
+
+Функция cpuDisabled() разбирает значение переменной окружения
+BEE2_CPU_DISABLE. Неизвестные имена игнорируются.
+
+Функция cpuClose() снимает наборы, которые зависят от снятых:
+-	без SSE2 -- SSSE3, PCLMUL, AVX;
+-	без AVX -- AVX2, AVX512F;
+-	без AVX512F -- AVX512BW, AVX512VBMI, AVX512IFMA;
+-	без NEON -- PMULL.
+*******************************************************************************
+*/
+
+static u32 cpuDisabled()
+{
+	const char* env = getenv("BEE2_CPU_DISABLE");
+	u32 mask = 0;
+	size_t len, i;
+	if (!env)
+		return 0;
+	while (*env)
+	{
+		for (len = 0; env[len] && env[len] != ','; ++len);
+		if (len == 3 && cpuEq(env, "all", 3))
+			mask = 0xFFFFFFFF;
+		else
+			for (i = 0; i < COUNT_OF(_names); ++i)
+				if (strLen(_names[i].name) == len &&
+					cpuEq(env, _names[i].name, len))
+					mask |= _names[i].feature;
+		env += len;
+		if (*env == ',')
+			++env;
+	}
+	return mask;
+}
+
+static u32 cpuClose(u32 f)
+{
+	if (!(f & CPU_SSE2))
+		f &= ~(CPU_SSSE3 | CPU_PCLMUL | CPU_AVX);
+	if (!(f & CPU_AVX))
+		f &= ~(CPU_AVX2 | CPU_AVX512F);
+	if (!(f & CPU_AVX512F))
+		f &= ~(CPU_AVX512BW | CPU_AVX512VBMI | CPU_AVX512IFMA);
+	if (!(f & CPU_NEON))
+		f &= ~CPU_PMULL;
+	return f;
+}
+
+/*
+*******************************************************************************
+Запросы
+*******************************************************************************
+*/
+
+static size_t _once;
+static u32 _features;
+
+static void cpuInit()
+{
+	_features = cpuClose(cpuDetect() & ~cpuDisabled());
+}
+
+u32 cpuFeatures()
+{
+	if (_once != 1)
+		mtCallOnce(&_once, cpuInit);
+	return _features;
+}
+
+bool_t cpuHas(u32 features)
+{
+	return (cpuFeatures() & features) == features;
+}
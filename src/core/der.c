@@ -4,7 +4,7 @@
 \brief Distinguished Encoding Rules
 \project bee2 [cryptographic library]
 \created 2014.04.21
-\version 2023.09.21
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -121,7 +121,7 @@ static size_t derTDec(u32* tag, const octet der[], size_t count)
 	{
 		// короткий код? лишний октет с нулем?
 		if (count < 2 || (der[1] & 127) == 0)
-			return FALSE;
+			return SIZE_MAX;
 		for (t = 0; t_count < count;)
 		{
 			t <<= 8, t |= der[t_count] & 127;
@@ -1084,11 +1084,13 @@ size_t derTSEQEncStop(octet der[], size_t pos, const der_anchor_t* anchor)
 	l_count1 = derLEnc(0, len);
 	// определить величину смещения вложенных данных
 	pos = l_count1 - l_count;
-	// сдвинуть вложенные данные и уточнить длину
+	// сдвинуть вложенные данные (если длина не поместилась в резерв)
+	// и уточнить длину
 	if (anchor->der)
 	{
 		ASSERT(anchor->der + t_count == der - len - l_count);
-		memMove(der - len + pos, der - len, len);
+		if (pos)
+			memMove(der - len + pos, der - len, len);
 		if (derLEnc(der - len - l_count, len) != l_count1)
 			return SIZE_MAX;
 	}
@@ -1129,3 +1131,169 @@ size_t derTSEQDecStop(const octet der[], const der_anchor_t* anchor)
 	// сравнить длину вложенных данных с сохраненной длиной
 	return (der == val + anchor->len) ? 0 : SIZE_MAX;
 }
+
+/*
+*******************************************************************************
+Курсор
+
+Граница текущего контейнера -- позиция его окончания, сохраненная в стеке
+cur->end. На верхнем уровне границей является конец кода, если поток
+завершен, и SIZE_MAX в противном случае.
+
+TL-префикс элемента вместе со значением должен укладываться в границу.
+Для разбора TL-префикса требуется не более DER_TL_MAX октетов. Если
+префикс не удалось разобрать, доступно меньше DER_TL_MAX октетов и
+еще могут поступить октеты, предшествующие границе, то считается, что
+не хватает (по меньшей мере одного) октета.
+*******************************************************************************
+*/
+
+#define DER_TL_MAX (4 + 1 + O_PER_S)
+
+static size_t derCurEnd(const der_cur_t* cur)
+{
+	if (cur->depth)
+		return cur->end[cur->depth - 1];
+	return cur->eof ? cur->off + cur->count : SIZE_MAX;
+}
+
+static size_t derCurTL(u32* tag, size_t* len, der_cur_t* cur)
+{
+	size_t end;
+	size_t avail;
+	size_t tl_count;
+	size_t l;
+	// pre
+	ASSERT(memIsValid(cur, sizeof(der_cur_t)));
+	ASSERT(cur->off <= cur->pos && cur->pos <= cur->off + cur->count);
+	ASSERT(cur->depth <= DER_CUR_DEPTH);
+	cur->need = 0;
+	// элементы закончились?
+	end = derCurEnd(cur);
+	if (cur->pos >= end)
+		return cur->pos == end ? 0 : SIZE_MAX;
+	// декодировать TL
+	avail = cur->off + cur->count - cur->pos;
+	avail = MIN2(avail, end - cur->pos);
+	tl_count = derTLDec(tag, &l, cur->der + (cur->pos - cur->off), avail);
+	if (tl_count == SIZE_MAX)
+	{
+		if (!cur->eof && avail < DER_TL_MAX && cur->pos + avail < end)
+			cur->need = 1;
+		return SIZE_MAX;
+	}
+	// значение выходит за границу?
+	if (l > end - cur->pos - tl_count)
+		return SIZE_MAX;
+	if (len)
+		*len = l;
+	return tl_count;
+}
+
+void derCurStart(der_cur_t* cur, const octet der[], size_t count)
+{
+	ASSERT(memIsValid(cur, sizeof(der_cur_t)));
+	ASSERT(memIsValid(der, count));
+	cur->der = der;
+	cur->count = count;
+	cur->off = cur->pos = cur->need = 0;
+	cur->eof = TRUE;
+	cur->depth = 0;
+}
+
+void derCurFeed(der_cur_t* cur, const octet der[], size_t count, size_t off,
+	bool_t eof)
+{
+	ASSERT(memIsValid(cur, sizeof(der_cur_t)));
+	ASSERT(memIsValid(der, count));
+	ASSERT(off <= cur->pos && cur->pos - off <= count);
+	cur->der = der;
+	cur->count = count;
+	cur->off = off;
+	cur->need = 0;
+	cur->eof = eof;
+}
+
+size_t derCurPeek(u32* tag, size_t* len, der_cur_t* cur)
+{
+	ASSERT(tag == 0 || memIsValid(tag, 4));
+	ASSERT(len == 0 || memIsValid(len, O_PER_S));
+	return derCurTL(tag, len, cur);
+}
+
+size_t derCurNext(u32* tag, const octet** val, size_t* len, der_cur_t* cur)
+{
+	u32 t;
+	size_t tl_count;
+	size_t l;
+	// pre
+	ASSERT(tag == 0 || memIsValid(tag, 4));
+	ASSERT(val == 0 || memIsValid(val, sizeof(const octet*)));
+	ASSERT(len == 0 || memIsValid(len, O_PER_S));
+	// декодировать TL
+	tl_count = derCurTL(&t, &l, cur);
+	if (tl_count == 0 || tl_count == SIZE_MAX)
+		return tl_count;
+	// значение в буфере?
+	if (cur->pos + tl_count + l > cur->off + cur->count)
+	{
+		if (!cur->eof)
+			cur->need = cur->pos + tl_count + l - cur->off - cur->count;
+		return SIZE_MAX;
+	}
+	// возврат
+	if (tag)
+		*tag = t;
+	if (val)
+		*val = cur->der + (cur->pos - cur->off) + tl_count;
+	if (len)
+		*len = l;
+	cur->pos += tl_count + l;
+	return tl_count + l;
+}
+
+size_t derCurNext2(const octet** val, size_t* len, der_cur_t* cur, u32 tag)
+{
+	u32 t;
+	size_t tl_count;
+	// проверить тег
+	tl_count = derCurTL(&t, 0, cur);
+	if (tl_count == 0 || tl_count == SIZE_MAX || t != tag)
+		return SIZE_MAX;
+	// декодировать
+	tl_count = derCurNext(0, val, len, cur);
+	return tl_count == 0 ? SIZE_MAX : tl_count;
+}
+
+size_t derCurEnter(der_cur_t* cur, u32 tag)
+{
+	u32 t;
+	size_t tl_count;
+	size_t l;
+	// pre
+	ASSERT(memIsValid(cur, sizeof(der_cur_t)));
+	cur->need = 0;
+	// проверить тег и глубину
+	if (!derTIsValid(tag) || !derTIsConstructive(tag) ||
+		cur->depth >= DER_CUR_DEPTH)
+		return SIZE_MAX;
+	// декодировать TL
+	tl_count = derCurTL(&t, &l, cur);
+	if (tl_count == 0 || tl_count == SIZE_MAX || t != tag)
+		return SIZE_MAX;
+	// войти в контейнер
+	cur->end[cur->depth++] = cur->pos + tl_count + l;
+	cur->pos += tl_count;
+	return tl_count;
+}
+
+size_t derCurLeave(der_cur_t* cur)
+{
+	ASSERT(memIsValid(cur, sizeof(der_cur_t)));
+	cur->need = 0;
+	// все элементы контейнера разобраны?
+	if (cur->depth == 0 || cur->pos != cur->end[cur->depth - 1])
+		return SIZE_MAX;
+	--cur->depth;
+	return 0;
+}
@@ -4,7 +4,7 @@
 \brief Hexadecimal strings
 \project bee2 [cryptographic library]
 \created 2015.10.29
-\version 2016.06.19
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -16,65 +16,155 @@
 #include "bee2/core/util.h"
 #include "bee2/core/word.h"
 
+#if defined(__SSE2__) || defined(_M_X64) ||\
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define HEX_SSE2
+#endif
+
 /*
 *******************************************************************************
-Таблицы
+Символы
+
+Символы кодируются и декодируются арифметически, без таблиц и ветвлений,
+зависящих от данных. Поэтому кодирование и декодирование регулярны
+и пригодны для обработки секретных данных.
+
+Функция hexDecC() возвращает значение тетрады, соответствующей символу ch,
+и взводит бит 8, если символ некорректен. Функция hexEncN() возвращает
+символ, соответствующий тетраде n: при a == 7 прописную букву, при
+a == 39 -- строчную.
 *******************************************************************************
 */
 
-static const char hex_upper[] = "0123456789ABCDEF";
-static const char hex_lower[] = "0123456789abcdef";
-
-static const octet hex_dec_table[256] = {
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0x0A,0x0B,0x0C,0x0D,0x0E,0x0F,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0x0A,0x0B,0x0C,0x0D,0x0E,0x0F,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-};
+static u32 hexDecC(char ch)
+{
+	register int c = (octet)ch;
+	register int d = c - '0';
+	register int l = (c | 0x20) - 'a';
+	register u32 md = ((u32)(d | (9 - d)) >> 31) ^ 1;
+	register u32 ml = ((u32)(l | (5 - l)) >> 31) ^ 1;
+	return ((u32)d & (0 - md)) | ((u32)(l + 10) & (0 - ml)) |
+		((md | ml) ^ 1) << 8;
+}
+
+#define hexEncN(n, a)\
+	((char)((n) + '0' + (((u32)(9 - (n)) >> 8) & (a))))
 
 /*
 *******************************************************************************
 Октеты
+
+В hexToO() признак некорректности символов накапливается в err (бит 8).
 *******************************************************************************
 */
 
-static octet hexToO(const char* hex)
+static octet hexToO(const char* hex, u32* err)
 {
-	register octet hi;
-	register octet lo;
+	register u32 hi;
+	register u32 lo;
 	ASSERT(memIsValid(hex, 2));
-	hi = hex_dec_table[(octet)hex[0]];
-	lo = hex_dec_table[(octet)hex[1]];
-	ASSERT(hi != 0xFF && lo != 0xFF);
-	return hi << 4 | lo;
+	hi = hexDecC(hex[0]);
+	lo = hexDecC(hex[1]);
+	*err |= hi | lo;
+	return (octet)(hi << 4 | (lo & 15));
 }
 
-static void hexFromOUpper(char* hex, register octet o)
+static void hexFromO(char* hex, register u32 o, u32 a)
 {
 	ASSERT(memIsValid(hex, 2));
-	hex[0] = hex_upper[o >> 4];
-	hex[1] = hex_upper[o & 15];
+	hex[0] = hexEncN(o >> 4, a);
+	hex[1] = hexEncN(o & 15, a);
 	o = 0;
 }
 
-static void hexFromOLower(char* hex, register octet o)
+/*
+*******************************************************************************
+Серии
+
+Функция hexDec() декодирует строку [count]src (count четно) в буфер dest
+и возвращает признак корректности символов. Если dest == 0, то
+выполняется только проверка. Функция hexEnc() кодирует буфер [count]src
+строкой [2 * count]dest прописными символами.
+
+При наличии SSE2 строки обрабатываются порциями по 32 символа
+(16 октетов). Тетрады декодируются сравнениями с границами диапазонов
+символов, кодируются сравнением с 9. Ошибки накапливаются в маске без
+досрочного выхода.
+*******************************************************************************
+*/
+
+#if defined(HEX_SSE2)
+
+static __m128i hexDecV(__m128i c, __m128i* err)
 {
-	ASSERT(memIsValid(hex, 2));
-	hex[0] = hex_lower[o >> 4];
-	hex[1] = hex_lower[o & 15];
-	o = 0;
+	__m128i l = _mm_or_si128(c, _mm_set1_epi8(0x20));
+	__m128i md = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+		_mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+	__m128i ml = _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8('a' - 1)),
+		_mm_cmplt_epi8(l, _mm_set1_epi8('f' + 1)));
+	*err = _mm_or_si128(*err, _mm_cmpeq_epi8(_mm_or_si128(md, ml),
+		_mm_setzero_si128()));
+	return _mm_or_si128(
+		_mm_and_si128(md, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+		_mm_and_si128(ml, _mm_sub_epi8(l, _mm_set1_epi8('a' - 10))));
+}
+
+static __m128i hexEncV(__m128i n)
+{
+	return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')),
+		_mm_and_si128(_mm_cmpgt_epi8(n, _mm_set1_epi8(9)),
+			_mm_set1_epi8(7)));
+}
+
+#endif // HEX_SSE2
+
+static bool_t hexDec(octet* dest, const char* src, size_t count)
+{
+	u32 err = 0;
+#if defined(HEX_SSE2)
+	__m128i e = _mm_setzero_si128();
+	__m128i lo8 = _mm_set1_epi16(0x00FF);
+	for (; count >= 32; count -= 32, src += 32)
+	{
+		__m128i a = hexDecV(_mm_loadu_si128((const __m128i*)src), &e);
+		__m128i b = hexDecV(_mm_loadu_si128((const __m128i*)(src + 16)), &e);
+		// (hi, lo) -> hi << 4 | lo в 16-битовых словах
+		a = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(a, lo8), 4),
+			_mm_srli_epi16(a, 8));
+		b = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(b, lo8), 4),
+			_mm_srli_epi16(b, 8));
+		if (dest)
+		{
+			_mm_storeu_si128((__m128i*)dest, _mm_packus_epi16(a, b));
+			dest += 16;
+		}
+	}
+	err = (u32)_mm_movemask_epi8(e) << 8;
+#endif
+	for (; count; count -= 2, src += 2)
+		if (dest)
+			*dest++ = hexToO(src, &err);
+		else
+			hexToO(src, &err);
+	return (err >> 8) == 0;
+}
+
+static void hexEnc(char* dest, const octet* src, size_t count)
+{
+#if defined(HEX_SSE2)
+	__m128i lo4 = _mm_set1_epi8(15);
+	for (; count >= 16; count -= 16, src += 16, dest += 32)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)src);
+		__m128i hi = hexEncV(_mm_and_si128(_mm_srli_epi16(x, 4), lo4));
+		__m128i lo = hexEncV(_mm_and_si128(x, lo4));
+		_mm_storeu_si128((__m128i*)dest, _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128((__m128i*)(dest + 16), _mm_unpackhi_epi8(hi, lo));
+	}
+#endif
+	for (; count--; dest += 2, ++src)
+		hexFromO(dest, *src, 7);
 }
 
 /*
@@ -87,10 +177,7 @@ bool_t hexIsValid(const char* hex)
 {
 	if (!strIsValid(hex) || strLen(hex) % 2)
 		return FALSE;
-	for (; *hex; ++hex)
-		if (hex_dec_table[(octet)*hex] == 0xFF)
-			return FALSE;
-	return TRUE;
+	return hexDec(0, hex, strLen(hex));
 }
 
 /*
@@ -101,16 +188,18 @@ bool_t hexIsValid(const char* hex)
 
 void hexUpper(char* hex)
 {
+	u32 err = 0;
 	ASSERT(hexIsValid(hex));
 	for (; *hex; hex += 2)
-		hexFromOUpper(hex, hexToO(hex));
+		hexFromO(hex, hexToO(hex, &err), 7);
 }
 
 void hexLower(char* hex)
 {
+	u32 err = 0;
 	ASSERT(hexIsValid(hex));
 	for (; *hex; hex += 2)
-		hexFromOLower(hex, hexToO(hex));
+		hexFromO(hex, hexToO(hex, &err), 39);
 }
 
 /*
@@ -122,23 +211,25 @@ void hexLower(char* hex)
 bool_t SAFE(hexEq)(const void* buf, const char* hex)
 {
 	register word diff = 0;
+	u32 err = 0;
 	size_t count;
 	ASSERT(hexIsValid(hex));
 	ASSERT(memIsValid(buf, strLen(hex) / 2));
 	count = strLen(hex);
 	for (; count; count -= 2, hex += 2, buf = (const octet*)buf + 1)
-		diff |= *(const octet*)buf ^ hexToO(hex);
+		diff |= *(const octet*)buf ^ hexToO(hex, &err);
 	return wordEq(diff, 0);
 }
 
 bool_t FAST(hexEq)(const void* buf, const char* hex)
 {
+	u32 err = 0;
 	size_t count;
 	ASSERT(hexIsValid(hex));
 	ASSERT(memIsValid(buf, strLen(hex) / 2));
 	count = strLen(hex);
 	for (; count; count -= 2, hex += 2, buf = (const octet*)buf + 1)
-		if (*(const octet*)buf != hexToO(hex))
+		if (*(const octet*)buf != hexToO(hex, &err))
 			return FALSE;
 	return TRUE;
 }
@@ -146,25 +237,27 @@ bool_t FAST(hexEq)(const void* buf, const char* hex)
 bool_t SAFE(hexEqRev)(const void* buf, const char* hex)
 {
 	register word diff = 0;
+	u32 err = 0;
 	size_t count;
 	ASSERT(hexIsValid(hex));
 	ASSERT(memIsValid(buf, strLen(hex) / 2));
 	count = strLen(hex);
 	hex = hex + count;
 	for (; count; count -= 2, buf = (const octet*)buf + 1)
-		diff |= *(const octet*)buf ^ hexToO(hex -= 2);
+		diff |= *(const octet*)buf ^ hexToO(hex -= 2, &err);
 	return wordEq(diff, 0);
 }
 
 bool_t FAST(hexEqRev)(const void* buf, const char* hex)
 {
+	u32 err = 0;
 	size_t count;
 	ASSERT(hexIsValid(hex));
 	ASSERT(memIsValid(buf, strLen(hex) / 2));
 	count = strLen(hex);
 	hex = hex + count;
 	for (; count; count -= 2, buf = (const octet*)buf + 1)
-		if (*(const octet*)buf != hexToO(hex -= 2))
+		if (*(const octet*)buf != hexToO(hex -= 2, &err))
 			return FALSE;
 	return TRUE;
 }
@@ -178,9 +271,8 @@ bool_t FAST(hexEqRev)(const void* buf, const char* hex)
 void hexFrom(char* dest, const void* src, size_t count)
 {
 	ASSERT(memIsDisjoint2(src, count, dest, 2 * count + 1));
-	for (; count--; dest += 2, src = (const octet*)src + 1)
-		hexFromOUpper(dest, *(const octet*)src);
-	*dest = '\0';
+	hexEnc(dest, (const octet*)src, count);
+	dest[2 * count] = '\0';
 }
 
 void hexFromRev(char* dest, const void* src, size_t count)
@@ -189,26 +281,31 @@ void hexFromRev(char* dest, const void* src, size_t count)
 	dest = dest + 2 * count;
 	*dest = '\0';
 	for (; count--; src = (const octet*)src + 1)
-		hexFromOUpper(dest -= 2, *(const octet*)src);
+		hexFromO(dest -= 2, *(const octet*)src, 7);
 }
 
-void hexTo(void* dest, const char* src)
+bool_t hexTo(void* dest, const char* src)
 {
 	size_t count;
-	ASSERT(hexIsValid(src));
-	ASSERT(memIsDisjoint2(src, strLen(src) + 1, dest, strLen(src) / 2));
+	ASSERT(strIsValid(src));
 	count = strLen(src);
-	for (; count; count -= 2, src += 2, dest = (octet*)dest + 1)
-		*(octet*)dest = hexToO(src);
+	ASSERT(memIsDisjoint2(src, count + 1, dest, count / 2));
+	if (count % 2)
+		return FALSE;
+	return hexDec((octet*)dest, src, count);
 }
 
-void hexToRev(void* dest, const char* src)
+bool_t hexToRev(void* dest, const char* src)
 {
+	u32 err = 0;
 	size_t count;
-	ASSERT(hexIsValid(src));
-	ASSERT(memIsDisjoint2(src, strLen(src) + 1, dest, strLen(src) / 2));
+	ASSERT(strIsValid(src));
 	count = strLen(src);
+	ASSERT(memIsDisjoint2(src, count + 1, dest, count / 2));
+	if (count % 2)
+		return FALSE;
 	src = src + count;
 	for (; count; count -= 2, dest = (octet*)dest + 1)
-		*(octet*)dest = hexToO(src -= 2);
+		*(octet*)dest = hexToO(src -= 2, &err);
+	return (err >> 8) == 0;
 }
@@ -4,7 +4,7 @@
 \brief Memory management
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2019.07.09
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -24,6 +24,69 @@
 	#include <windows.h>
 #endif
 
+/*
+*******************************************************************************
+Векторные ядра
+
+Функции memXor(), memXor2(), SAFE(memEq)() и SAFE(memIsZero)() обрабатывают
+буферы 16-октетными порциями с помощью инструкций SSE2 (x86_64) или NEON
+(AArch64). Эти наборы инструкций являются базовыми для платформ и
+не требуют проверки во время выполнения. Макрос memVToWord() сворачивает
+вектор в слово без ветвлений: результат нулевой тогда и только тогда,
+когда нулевой вектор.
+
+В режиме MEM_AUTO в библиотеку дополнительно включаются 32-октетные ядра
+AVX2 (mem_avx2.c), которые используются для буферов длины не менее
+MEM_AVX2_MIN, если процессор поддерживает AVX2 (см. cpuHas()).
+*******************************************************************************
+*/
+
+#if defined(__SSE2__) || defined(_M_X64) ||\
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define MEM_V
+	typedef __m128i mem_v;
+	#define memVLoad(p) _mm_loadu_si128((const __m128i*)(p))
+	#define memVStore(p, v) _mm_storeu_si128((__m128i*)(p), v)
+	#define memVXor _mm_xor_si128
+	#define memVOr _mm_or_si128
+	#define memVZero() _mm_setzero_si128()
+	#define memVToWord(v)\
+		((word)(_mm_movemask_epi8(_mm_cmpeq_epi8(v, memVZero())) ^ 0xFFFF))
+#elif defined(__ARM_NEON)
+	#include <arm_neon.h>
+	#define MEM_V
+	typedef uint8x16_t mem_v;
+	#define memVLoad(p) vld1q_u8((const uint8_t*)(p))
+	#define memVStore(p, v) vst1q_u8((uint8_t*)(p), v)
+	#define memVXor veorq_u8
+	#define memVOr vorrq_u8
+	#define memVZero() vdupq_n_u8(0)
+	static word memVToWord(mem_v v)
+	{
+		u64 t = vgetq_lane_u64(vreinterpretq_u64_u8(v), 0) |
+			vgetq_lane_u64(vreinterpretq_u64_u8(v), 1);
+		return (word)(t | t >> 32);
+	}
+#endif
+
+#if defined(MEM_AUTO)
+
+#include "bee2/core/cpu.h"
+
+#define MEM_AVX2_MIN 128
+
+extern void memXorAVX2(void* dest, const void* src1, const void* src2,
+	size_t count);
+extern void memXor2AVX2(void* dest, const void* src, size_t count);
+extern bool_t memEqAVX2(const void* buf1, const void* buf2, size_t count);
+extern bool_t memIsZeroAVX2(const void* buf, size_t count);
+
+#define memAVX2(count)\
+	((count) >= MEM_AVX2_MIN && cpuHas(CPU_AVX2))
+
+#endif // MEM_AUTO
+
 /*
 *******************************************************************************
 Проверка
@@ -162,6 +225,23 @@ bool_t SAFE(memEq)(const void* buf1, const void* buf2, size_t count)
 	register word diff = 0;
 	ASSERT(memIsValid(buf1, count));
 	ASSERT(memIsValid(buf2, count));
+#if defined(MEM_AUTO)
+	if (memAVX2(count))
+		return memEqAVX2(buf1, buf2, count);
+#endif
+#if defined(MEM_V)
+	if (count >= 16)
+	{
+		mem_v d = memVZero();
+		for (; count >= 16; count -= 16)
+		{
+			d = memVOr(d, memVXor(memVLoad(buf1), memVLoad(buf2)));
+			buf1 = (const octet*)buf1 + 16;
+			buf2 = (const octet*)buf2 + 16;
+		}
+		diff = memVToWord(d);
+	}
+#endif
 	for (; count >= O_PER_W; count -= O_PER_W)
 	{
 		diff |= *(const word*)buf1 ^ *(const word*)buf2;
@@ -298,6 +378,22 @@ bool_t SAFE(memIsZero)(const void* buf, size_t count)
 {
 	register word diff = 0;
 	ASSERT(memIsValid(buf, count));
+#if defined(MEM_AUTO)
+	if (memAVX2(count))
+		return memIsZeroAVX2(buf, count);
+#endif
+#if defined(MEM_V)
+	if (count >= 16)
+	{
+		mem_v d = memVZero();
+		for (; count >= 16; count -= 16)
+		{
+			d = memVOr(d, memVLoad(buf));
+			buf = (const octet*)buf + 16;
+		}
+		diff = memVToWord(d);
+	}
+#endif
 	for (; count >= O_PER_W; count -= O_PER_W)
 	{
 		diff |= *(const word*)buf;
@@ -461,6 +557,22 @@ void memXor(void* dest, const void* src1, const void* src2, size_t count)
 {
 	ASSERT(memIsSameOrDisjoint(src1, dest, count));
 	ASSERT(memIsSameOrDisjoint(src2, dest, count));
+#if defined(MEM_AUTO)
+	if (memAVX2(count))
+	{
+		memXorAVX2(dest, src1, src2, count);
+		return;
+	}
+#endif
+#if defined(MEM_V)
+	for (; count >= 16; count -= 16)
+	{
+		memVStore(dest, memVXor(memVLoad(src1), memVLoad(src2)));
+		src1 = (const octet*)src1 + 16;
+		src2 = (const octet*)src2 + 16;
+		dest = (octet*)dest + 16;
+	}
+#endif
 	for (; count >= O_PER_W; count -= O_PER_W)
 	{
 		*(word*)dest = *(const word*)src1 ^ *(const word*)src2;
@@ -480,6 +592,21 @@ void memXor(void* dest, const void* src1, const void* src2, size_t count)
 void memXor2(void* dest, const void* src, size_t count)
 {
 	ASSERT(memIsSameOrDisjoint(src, dest, count));
+#if defined(MEM_AUTO)
+	if (memAVX2(count))
+	{
+		memXor2AVX2(dest, src, count);
+		return;
+	}
+#endif
+#if defined(MEM_V)
+	for (; count >= 16; count -= 16)
+	{
+		memVStore(dest, memVXor(memVLoad(dest), memVLoad(src)));
+		src = (const octet*)src + 16;
+		dest = (octet*)dest + 16;
+	}
+#endif
 	for (; count >= O_PER_W; count -= O_PER_W)
 	{
 		*(word*)dest ^= *(const word*)src;
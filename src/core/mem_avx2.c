@@ -0,0 +1,113 @@
+/*
+*******************************************************************************
+\file mem_avx2.c
+\brief Memory management: AVX2 kernels
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "bee2/defs.h"
+
+#if !defined(__AVX2__)
+	#error "The compiler does not support AVX2 intrinsics"
+#endif
+
+#include <immintrin.h>
+
+#include "bee2/core/mem.h"
+#include "bee2/core/word.h"
+
+/*
+*******************************************************************************
+Векторная реализация
+
+Буферы обрабатываются 32-октетными порциями, хвосты -- пооктетно.
+Выравнивание буферов не требуется.
+
+В функциях memEqAVX2() и memIsZeroAVX2() отличия накапливаются без
+досрочного выхода, результат определяется инструкцией vptest. Время
+выполнения зависит только от длины буферов.
+
+Функции вызываются из mem.c (см. MEM_AUTO).
+*******************************************************************************
+*/
+
+#define W __m256i
+#define LOAD(p) _mm256_loadu_si256((const W*)(p))
+#define STORE(p, x) _mm256_storeu_si256((W*)(p), x)
+
+void memXorAVX2(void* dest, const void* src1, const void* src2, size_t count)
+{
+	for (; count >= 32; count -= 32)
+	{
+		STORE(dest, _mm256_xor_si256(LOAD(src1), LOAD(src2)));
+		src1 = (const octet*)src1 + 32;
+		src2 = (const octet*)src2 + 32;
+		dest = (octet*)dest + 32;
+	}
+	while (count--)
+	{
+		*(octet*)dest = *(const octet*)src1 ^ *(const octet*)src2;
+		src1 = (const octet*)src1 + 1;
+		src2 = (const octet*)src2 + 1;
+		dest = (octet*)dest + 1;
+	}
+}
+
+void memXor2AVX2(void* dest, const void* src, size_t count)
+{
+	for (; count >= 32; count -= 32)
+	{
+		STORE(dest, _mm256_xor_si256(LOAD(dest), LOAD(src)));
+		src = (const octet*)src + 32;
+		dest = (octet*)dest + 32;
+	}
+	while (count--)
+	{
+		*(octet*)dest ^= *(const octet*)src;
+		src = (const octet*)src + 1;
+		dest = (octet*)dest + 1;
+	}
+}
+
+bool_t memEqAVX2(const void* buf1, const void* buf2, size_t count)
+{
+	W d = _mm256_setzero_si256();
+	word diff = 0;
+	for (; count >= 32; count -= 32)
+	{
+		d = _mm256_or_si256(d, _mm256_xor_si256(LOAD(buf1), LOAD(buf2)));
+		buf1 = (const octet*)buf1 + 32;
+		buf2 = (const octet*)buf2 + 32;
+	}
+	while (count--)
+	{
+		diff |= *(const octet*)buf1 ^ *(const octet*)buf2;
+		buf1 = (const octet*)buf1 + 1;
+		buf2 = (const octet*)buf2 + 1;
+	}
+	diff |= (word)(_mm256_testz_si256(d, d) ^ 1);
+	return wordEq(diff, 0);
+}
+
+bool_t memIsZeroAVX2(const void* buf, size_t count)
+{
+	W d = _mm256_setzero_si256();
+	word diff = 0;
+	for (; count >= 32; count -= 32)
+	{
+		d = _mm256_or_si256(d, LOAD(buf));
+		buf = (const octet*)buf + 32;
+	}
+	while (count--)
+	{
+		diff |= *(const octet*)buf;
+		buf = (const octet*)buf + 1;
+	}
+	diff |= (word)(_mm256_testz_si256(d, d) ^ 1);
+	return wordEq(diff, 0);
+}
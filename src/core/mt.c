@@ -4,15 +4,20 @@
 \brief Multithreading
 \project bee2 [cryptographic library]
 \created 2014.10.10
-\version 2023.04.13
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	#define _GNU_SOURCE
+#endif
+
 #include "bee2/core/mem.h"
 #include "bee2/core/mt.h"
 #include "bee2/core/blob.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/str.h"
 #include "bee2/core/util.h"
 
@@ -113,6 +118,103 @@ void mtMtxClose(mt_mtx_t* mtx)
 
 #endif // OS
 
+/*
+*******************************************************************************
+Условные переменные
+*******************************************************************************
+*/
+
+#ifdef OS_WIN
+
+bool_t mtCndCreate(mt_cnd_t* cnd)
+{
+	ASSERT(memIsValid(cnd, sizeof(mt_cnd_t)));
+	InitializeConditionVariable(cnd);
+	return TRUE;
+}
+
+void mtCndWait(mt_cnd_t* cnd, mt_mtx_t* mtx)
+{
+	ASSERT(memIsValid(cnd, sizeof(mt_cnd_t)));
+	ASSERT(mtMtxIsValid(mtx));
+	SleepConditionVariableCS(cnd, mtx, INFINITE);
+}
+
+void mtCndSignal(mt_cnd_t* cnd)
+{
+	ASSERT(memIsValid(cnd, sizeof(mt_cnd_t)));
+	WakeConditionVariable(cnd);
+}
+
+void mtCndBroadcast(mt_cnd_t* cnd)
+{
+	ASSERT(memIsValid(cnd, sizeof(mt_cnd_t)));
+	WakeAllConditionVariable(cnd);
+}
+
+void mtCndClose(mt_cnd_t* cnd)
+{
+	ASSERT(memIsValid(cnd, sizeof(mt_cnd_t)));
+}
+
+#elif defined OS_UNIX
+
+bool_t mtCndCreate(mt_cnd_t* cnd)
+{
+	ASSERT(memIsValid(cnd, sizeof(mt_cnd_t)));
+	return pthread_cond_init(cnd, 0) == 0;
+}
+
+void mtCndWait(mt_cnd_t* cnd, mt_mtx_t* mtx)
+{
+	ASSERT(memIsValid(cnd, sizeof(mt_cnd_t)));
+	ASSERT(mtMtxIsValid(mtx));
+	pthread_cond_wait(cnd, mtx);
+}
+
+void mtCndSignal(mt_cnd_t* cnd)
+{
+	ASSERT(memIsValid(cnd, sizeof(mt_cnd_t)));
+	pthread_cond_signal(cnd);
+}
+
+void mtCndBroadcast(mt_cnd_t* cnd)
+{
+	ASSERT(memIsValid(cnd, sizeof(mt_cnd_t)));
+	pthread_cond_broadcast(cnd);
+}
+
+void mtCndClose(mt_cnd_t* cnd)
+{
+	ASSERT(memIsValid(cnd, sizeof(mt_cnd_t)));
+	pthread_cond_destroy(cnd);
+}
+
+#else
+
+bool_t mtCndCreate(mt_cnd_t* cnd)
+{
+	return TRUE;
+}
+
+void mtCndWait(mt_cnd_t* cnd, mt_mtx_t* mtx)
+{
+}
+
+void mtCndSignal(mt_cnd_t* cnd)
+{
+}
+
+void mtCndBroadcast(mt_cnd_t* cnd)
+{
+}
+
+void mtCndClose(mt_cnd_t* cnd)
+{
+}
+
+#endif // OS
+
 /*
 *******************************************************************************
 Потоки
@@ -120,7 +222,10 @@ void mtMtxClose(mt_mtx_t* mtx)
 \remark Реализация mtCallOnce() выполнена по мотивам Windows-редакции
 функции CRYPTO_THREAD_run_once() из OpenSSL 1.1.1. Другие варианты реализации
 могут быть основаны на функциях InitOnceExecuteOnce() (WinAPI) и pthread_once()
-(<pthread.h>).
+(<pthread.h>). Триггер принимает значения 0 (fn() не вызывалась),
+SIZE_MAX (fn() вызывается) и 1 (вызов fn() завершен). Завершение вызова
+публикуется записью mtAtomicStore(), поэтому повторные обращения сводятся
+к чтению mtAtomicLoad() без захвата триггера.
 *******************************************************************************
 */
 
@@ -131,8 +236,14 @@ void mtSleep(u32 ms)
 	Sleep(ms);
 }
 
+void mtThrdYield()
+{
+	SwitchToThread();
+}
+
 #elif defined OS_UNIX
 
+#include <sched.h>
 #include <time.h>
 
 void mtSleep(u32 ms)
@@ -144,37 +255,1029 @@ void mtSleep(u32 ms)
 	nanosleep(&ts, 0);
 }
 
+void mtThrdYield()
+{
+	sched_yield();
+}
+
 #else
 
 void mtSleep(u32 ms)
 {
 }
 
+void mtThrdYield()
+{
+}
+
+#endif // OS
+
+#ifdef OS_WIN
+
+static DWORD WINAPI mtThrdMain(LPVOID arg)
+{
+	mt_thrd_t* thrd = (mt_thrd_t*)arg;
+	thrd->fn(thrd->arg);
+	return 0;
+}
+
+bool_t mtThrdCreate(mt_thrd_t* thrd, void (*fn)(void*), void* arg)
+{
+	ASSERT(memIsValid(thrd, sizeof(mt_thrd_t)));
+	thrd->fn = fn, thrd->arg = arg;
+	thrd->h = CreateThread(0, 0, mtThrdMain, thrd, 0, 0);
+	return thrd->h != 0;
+}
+
+void mtThrdJoin(mt_thrd_t* thrd)
+{
+	ASSERT(memIsValid(thrd, sizeof(mt_thrd_t)));
+	WaitForSingleObject(thrd->h, INFINITE);
+	CloseHandle(thrd->h);
+}
+
+size_t mtCPUs()
+{
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return si.dwNumberOfProcessors ? (size_t)si.dwNumberOfProcessors : 1;
+}
+
+#elif defined OS_UNIX
+
+#include <unistd.h>
+
+static void* mtThrdMain(void* arg)
+{
+	mt_thrd_t* thrd = (mt_thrd_t*)arg;
+	thrd->fn(thrd->arg);
+	return 0;
+}
+
+bool_t mtThrdCreate(mt_thrd_t* thrd, void (*fn)(void*), void* arg)
+{
+	ASSERT(memIsValid(thrd, sizeof(mt_thrd_t)));
+	thrd->fn = fn, thrd->arg = arg;
+	return pthread_create(&thrd->h, 0, mtThrdMain, thrd) == 0;
+}
+
+void mtThrdJoin(mt_thrd_t* thrd)
+{
+	ASSERT(memIsValid(thrd, sizeof(mt_thrd_t)));
+	pthread_join(thrd->h, 0);
+}
+
+size_t mtCPUs()
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (size_t)n : 1;
+}
+
+#else
+
+bool_t mtThrdCreate(mt_thrd_t* thrd, void (*fn)(void*), void* arg)
+{
+	ASSERT(memIsValid(thrd, sizeof(mt_thrd_t)));
+	thrd->fn = fn, thrd->arg = arg;
+	fn(arg);
+	return TRUE;
+}
+
+void mtThrdJoin(mt_thrd_t* thrd)
+{
+	ASSERT(memIsValid(thrd, sizeof(mt_thrd_t)));
+}
+
+size_t mtCPUs()
+{
+	return 1;
+}
+
 #endif // OS
 
 bool_t mtCallOnce(size_t* once, void (*fn)())
 {
 	size_t t;
+	// вызов уже завершен?
+	if (mtAtomicLoad(once) == 1)
+		return TRUE;
 	// попытки вызова
-	do
-		// удается захватить триггер?...
-		if ((t = mtAtomicCmpSwap(once, 0, SIZE_MAX)) == 0)
+	while ((t = mtAtomicCmpSwap(once, 0, SIZE_MAX)) != 1)
+		// удалось захватить триггер?...
+		if (t == 0)
 		{
 			// ... да, обработать захват
-			fn(), *once = 1;
+			fn();
+			mtAtomicStore(once, 1);
 			break;
 		}
-	// ... нет, ожидаем обработки захвата в другом потоке
-	while (t == SIZE_MAX);
+		// ... нет, ожидаем обработки захвата в другом потоке
+		else
+			mtThrdYield();
 	// завершить
-	ASSERT(*once == 1);
+	ASSERT(mtAtomicLoad(once) == 1);
+	return TRUE;
+}
+
+/*
+*******************************************************************************
+Ключи потоков
+*******************************************************************************
+*/
+
+#ifdef OS_WIN
+
+bool_t mtKeyCreate(mt_key_t* key, mt_key_dtor_i dtor)
+{
+	ASSERT(memIsValid(key, sizeof(mt_key_t)));
+	*key = FlsAlloc(dtor);
+	return *key != FLS_OUT_OF_INDEXES;
+}
+
+void* mtKeyGet(const mt_key_t* key)
+{
+	ASSERT(memIsValid(key, sizeof(mt_key_t)));
+	return FlsGetValue(*key);
+}
+
+bool_t mtKeySet(mt_key_t* key, void* val)
+{
+	ASSERT(memIsValid(key, sizeof(mt_key_t)));
+	return FlsSetValue(*key, val) != 0;
+}
+
+void mtKeyClose(mt_key_t* key)
+{
+	ASSERT(memIsValid(key, sizeof(mt_key_t)));
+	FlsFree(*key);
+}
+
+#elif defined OS_UNIX
+
+bool_t mtKeyCreate(mt_key_t* key, mt_key_dtor_i dtor)
+{
+	ASSERT(memIsValid(key, sizeof(mt_key_t)));
+	return pthread_key_create(key, dtor) == 0;
+}
+
+void* mtKeyGet(const mt_key_t* key)
+{
+	ASSERT(memIsValid(key, sizeof(mt_key_t)));
+	return pthread_getspecific(*key);
+}
+
+bool_t mtKeySet(mt_key_t* key, void* val)
+{
+	ASSERT(memIsValid(key, sizeof(mt_key_t)));
+	return pthread_setspecific(*key, val) == 0;
+}
+
+void mtKeyClose(mt_key_t* key)
+{
+	ASSERT(memIsValid(key, sizeof(mt_key_t)));
+	pthread_key_delete(*key);
+}
+
+#else
+
+bool_t mtKeyCreate(mt_key_t* key, mt_key_dtor_i dtor)
+{
+	return FALSE;
+}
+
+void* mtKeyGet(const mt_key_t* key)
+{
+	return 0;
+}
+
+bool_t mtKeySet(mt_key_t* key, void* val)
+{
+	return FALSE;
+}
+
+void mtKeyClose(mt_key_t* key)
+{
+}
+
+#endif // OS
+
+/*
+*******************************************************************************
+Узлы NUMA
+
+В Linux число узлов определяется по списку /sys/devices/system/node/online,
+процессоры узла -- по списку /sys/devices/system/node/node<i>/cpulist.
+Списки имеют вид "0-3,8-11". Узел текущего процессора возвращает
+системный вызов getcpu(). В Windows используются функции
+GetNumaHighestNodeNumber(), GetNumaNodeProcessorMask(),
+GetNumaProcessorNode().
+
+Число узлов ограничивается MT_NODES_MAX и определяется один раз.
+*******************************************************************************
+*/
+
+#define MT_NODES_MAX 64
+
+static size_t _nodes_once;
+static size_t _nodes = 1;
+
+#if defined(OS_WIN)
+
+static void mtNodesInit()
+{
+	ULONG h;
+	if (GetNumaHighestNodeNumber(&h))
+		_nodes = MIN2((size_t)h + 1, MT_NODES_MAX);
+}
+
+size_t mtNodeCur()
+{
+	UCHAR node;
+	if (mtNodes() == 1 ||
+		!GetNumaProcessorNode((UCHAR)GetCurrentProcessorNumber(), &node))
+		return 0;
+	return (size_t)node < _nodes ? (size_t)node : 0;
+}
+
+static void mtNodePin(size_t node)
+{
+	ULONGLONG mask;
+	if (GetNumaNodeProcessorMask((UCHAR)node, &mask) && mask)
+		SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)mask);
+}
+
+#elif defined(__linux__)
+
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+static bool_t mtNodeRead(char* buf, size_t size, const char* path)
+{
+	int fd;
+	ssize_t len;
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return FALSE;
+	len = read(fd, buf, size - 1);
+	close(fd);
+	if (len <= 0)
+		return FALSE;
+	buf[len] = 0;
+	return TRUE;
+}
+
+static const char* mtNodeNum(size_t* num, const char* str)
+{
+	if (*str < '0' || *str > '9')
+		return 0;
+	for (*num = 0; *str >= '0' && *str <= '9'; ++str)
+		*num = *num < SIZE_MAX / 16 ? 10 * *num + (*str - '0') : SIZE_MAX;
+	return str;
+}
+
+static void mtNodesInit()
+{
+	char buf[256];
+	const char* str = buf;
+	size_t a, b = 0;
+	if (!mtNodeRead(buf, sizeof(buf), "/sys/devices/system/node/online"))
+		return;
+	// последнее число списка -- наибольший номер узла
+	while ((str = mtNodeNum(&a, str)))
+	{
+		b = a;
+		if (*str != '-' && *str != ',')
+			break;
+		++str;
+	}
+	_nodes = MIN2(b + 1, MT_NODES_MAX);
+}
+
+size_t mtNodeCur()
+{
+	unsigned cpu, node;
+	if (mtNodes() == 1 || syscall(SYS_getcpu, &cpu, &node, 0) != 0)
+		return 0;
+	return (size_t)node < _nodes ? (size_t)node : 0;
+}
+
+static void mtNodePin(size_t node)
+{
+	char path[64] = "/sys/devices/system/node/node";
+	char buf[1024];
+	const char* str = buf;
+	cpu_set_t set;
+	size_t a, b, pos;
+	// составить путь
+	pos = strLen(path);
+	if (node >= 10)
+		path[pos++] = (char)('0' + node / 10);
+	path[pos++] = (char)('0' + node % 10);
+	strCopy(path + pos, "/cpulist");
+	if (!mtNodeRead(buf, sizeof(buf), path))
+		return;
+	// разобрать список процессоров
+	CPU_ZERO(&set);
+	while ((str = mtNodeNum(&a, str)))
+	{
+		b = a;
+		if (*str == '-' && !(str = mtNodeNum(&b, str + 1)))
+			break;
+		for (; a <= b && a < CPU_SETSIZE; ++a)
+			CPU_SET(a, &set);
+		if (*str != ',')
+			break;
+		++str;
+	}
+	if (CPU_COUNT(&set))
+		sched_setaffinity(0, sizeof(set), &set);
+}
+
+#else
+
+static void mtNodesInit()
+{
+}
+
+size_t mtNodeCur()
+{
+	return 0;
+}
+
+static void mtNodePin(size_t node)
+{
+}
+
+#endif // OS
+
+size_t mtNodes()
+{
+	mtCallOnce(&_nodes_once, mtNodesInit);
+	return _nodes;
+}
+
+/*
+*******************************************************************************
+Пул потоков
+
+Пул размещается в одном блобе: описание пула mt_pool_st, описания потоков
+mt_pool_wk (первым идет поток, вызывающий mtPoolWait()), память задач
+потоков. Длины памяти задач округляются вверх до кратных 16.
+
+Очередь (дек) потока -- кольцевой буфер из MT_POOL_DEQUE задач, защищенный
+мьютексом очереди. Владелец выбирает задачи с конца очереди (tail), другие
+потоки -- с начала (head).
+
+Счетчик queued -- число задач в очередях (с опережением: увеличивается
+до постановки задачи), счетчик pending -- число поставленных, но
+не завершенных задач. Рабочие потоки засыпают на условной переменной work,
+если queued == 0, и пробуждаются при постановке задач. Поток,
+вызвавший mtPoolWait(), засыпает на переменной done, если queued == 0
+и pending != 0, и пробуждается при обнулении pending. Условия проверяются,
+а оповещения выполняются под мьютексом mtx, что исключает потерю
+оповещений.
+
+Если очереди заполнены, то задача выполняется в mtPoolSubmit(), память задачи
+выделяется с помощью stackCreate(). Если память выделить не удалось, то
+ожидается освобождение места в очереди.
+
+Если задан флаг MT_POOL_NUMA, то потоку с номером t назначается узел
+t % mtNodes(), иначе всем потокам назначается узел 0. Поток, у которого
+опустела очередь, просматривает сначала очереди потоков своего узла,
+затем -- других узлов.
+
+Если операционная система не распознана, то mtThrdCreate() выполняет функцию
+потока немедленно. Поэтому рабочие потоки не создаются.
+*******************************************************************************
+*/
+
+#define MT_POOL_DEQUE 256
+
+typedef struct
+{
+	mt_task_i fn;				/*< задача */
+	void* arg;					/*< аргумент задачи */
+} mt_pool_task;
+
+typedef struct
+{
+	mt_pool_t* pool;			/*< пул */
+	size_t idx;					/*< номер потока */
+	size_t node;				/*< узел NUMA */
+	mt_thrd_t thrd;				/*< поток */
+	bool_t created;				/*< поток создан? */
+	mt_mtx_t mtx[1];			/*< мьютекс очереди */
+	size_t head;				/*< начало очереди */
+	size_t tail;				/*< конец очереди */
+	octet* scratch;				/*< память задач */
+	mt_pool_task tasks[MT_POOL_DEQUE];	/*< очередь */
+} mt_pool_wk;
+
+struct mt_pool_st
+{
+	size_t threads;				/*< число потоков */
+	size_t scratch;				/*< длина памяти задач */
+	size_t flags;				/*< флаги */
+	mt_mtx_t mtx[1];			/*< мьютекс оповещений */
+	mt_cnd_t work[1];			/*< оповещение о задачах */
+	mt_cnd_t done[1];			/*< оповещение о завершении задач */
+	size_t queued;				/*< число задач в очередях */
+	size_t pending;				/*< число незавершенных задач */
+	size_t next;				/*< счетчик распределения задач */
+	bool_t stop;				/*< признак завершения */
+	mt_pool_wk wk[];			/*< потоки */
+};
+
+static void mtPoolPin(size_t cpu)
+{
+#if defined(OS_WIN)
+	if (cpu < 8 * sizeof(DWORD_PTR))
+		SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu);
+#elif defined(__linux__)
+	cpu_set_t set;
+	if (cpu < CPU_SETSIZE)
+	{
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		sched_setaffinity(0, sizeof(set), &set);
+	}
+#endif
+}
+
+static bool_t mtPoolPush(mt_pool_wk* wk, mt_task_i fn, void* arg)
+{
+	bool_t ret = FALSE;
+	mtMtxLock(wk->mtx);
+	if (wk->tail - wk->head < MT_POOL_DEQUE)
+	{
+		wk->tasks[wk->tail % MT_POOL_DEQUE].fn = fn;
+		wk->tasks[wk->tail % MT_POOL_DEQUE].arg = arg;
+		++wk->tail, ret = TRUE;
+	}
+	mtMtxUnlock(wk->mtx);
+	return ret;
+}
+
+static bool_t mtPoolPop(mt_pool_task* task, mt_pool_wk* wk, bool_t back)
+{
+	bool_t ret = FALSE;
+	mtMtxLock(wk->mtx);
+	if (wk->tail != wk->head)
+	{
+		*task = wk->tasks[(back ? --wk->tail : wk->head++) % MT_POOL_DEQUE];
+		ret = TRUE;
+	}
+	mtMtxUnlock(wk->mtx);
+	return ret;
+}
+
+static void mtPoolDone(mt_pool_t* pool)
+{
+	if (mtAtomicDecr(&pool->pending) == 0)
+	{
+		mtMtxLock(pool->mtx);
+		mtCndBroadcast(pool->done);
+		mtMtxUnlock(pool->mtx);
+	}
+}
+
+static bool_t mtPoolRun(mt_pool_t* pool, mt_pool_wk* wk)
+{
+	mt_pool_task task;
+	size_t pass, t;
+	// выбрать задачу из своей очереди или из чужой (сначала своего узла)
+	if (!mtPoolPop(&task, wk, TRUE))
+	{
+		bool_t found = FALSE;
+		for (pass = 0; !found && pass < 2; ++pass)
+			for (t = 1; !found && t < pool->threads; ++t)
+			{
+				mt_pool_wk* victim = pool->wk + (wk->idx + t) % pool->threads;
+				if ((victim->node == wk->node) == (pass == 0))
+					found = mtPoolPop(&task, victim, FALSE);
+			}
+		if (!found)
+			return FALSE;
+	}
+	mtAtomicDecr(&pool->queued);
+	// выполнить задачу
+	task.fn(task.arg, wk->scratch);
+	if (wk->scratch)
+	{
+		memWipe(wk->scratch, pool->scratch);
+		memSetZero(wk->scratch, pool->scratch);
+	}
+	mtPoolDone(pool);
 	return TRUE;
 }
 
+static void mtPoolMain(void* arg)
+{
+	mt_pool_wk* wk = (mt_pool_wk*)arg;
+	mt_pool_t* pool = wk->pool;
+	bool_t stop;
+	// закрепить за процессорами узла или за процессором
+	if ((pool->flags & MT_POOL_NUMA) && mtNodes() > 1)
+		mtNodePin(wk->node);
+	else if (pool->flags & MT_POOL_PIN)
+		mtPoolPin(wk->idx % mtCPUs());
+	// выполнять задачи
+	while (1)
+	{
+		if (mtPoolRun(pool, wk))
+			continue;
+		mtMtxLock(pool->mtx);
+		while (!pool->stop && mtAtomicLoad(&pool->queued) == 0)
+			mtCndWait(pool->work, pool->mtx);
+		stop = pool->stop && mtAtomicLoad(&pool->queued) == 0;
+		mtMtxUnlock(pool->mtx);
+		if (stop)
+			break;
+	}
+}
+
+static void mtPoolFree(mt_pool_t* pool, size_t mtxs)
+{
+	while (mtxs--)
+		mtMtxClose(pool->wk[mtxs].mtx);
+	blobClose(pool);
+}
+
+mt_pool_t* mtPoolCreate(size_t threads, size_t scratch, size_t flags)
+{
+	mt_pool_t* pool;
+	size_t size;
+	size_t t;
+	// число потоков
+	if (threads == 0)
+		threads = mtCPUs();
+	threads = MIN2(threads, MT_POOL_THREADS_MAX);
+	// длина памяти задач
+	if (scratch > (SIZE_MAX - sizeof(mt_pool_t)) / threads -
+		sizeof(mt_pool_wk) - 16)
+		return 0;
+	size = (scratch + 15) / 16 * 16;
+	// создать пул
+	pool = (mt_pool_t*)blobCreate(sizeof(mt_pool_t) +
+		threads * (sizeof(mt_pool_wk) + size));
+	if (pool == 0)
+		return 0;
+	pool->threads = threads, pool->scratch = scratch, pool->flags = flags;
+	if (!mtMtxCreate(pool->mtx))
+	{
+		blobClose(pool);
+		return 0;
+	}
+	if (!mtCndCreate(pool->work))
+	{
+		mtMtxClose(pool->mtx);
+		blobClose(pool);
+		return 0;
+	}
+	if (!mtCndCreate(pool->done))
+	{
+		mtCndClose(pool->work);
+		mtMtxClose(pool->mtx);
+		blobClose(pool);
+		return 0;
+	}
+	// подготовить потоки
+	for (t = 0; t < threads; ++t)
+	{
+		mt_pool_wk* wk = pool->wk + t;
+		wk->pool = pool, wk->idx = t;
+		wk->node = (flags & MT_POOL_NUMA) ? t % mtNodes() : 0;
+		wk->scratch = scratch ? 
+			(octet*)(pool->wk + threads) + t * size : 0;
+		if (!mtMtxCreate(wk->mtx))
+		{
+			mtCndClose(pool->done);
+			mtCndClose(pool->work);
+			mtMtxClose(pool->mtx);
+			mtPoolFree(pool, t);
+			return 0;
+		}
+	}
+	// запустить рабочие потоки
+#if defined(OS_WIN) || defined(OS_UNIX)
+	for (t = 1; t < threads; ++t)
+		pool->wk[t].created =
+			mtThrdCreate(&pool->wk[t].thrd, mtPoolMain, pool->wk + t);
+#endif
+	return pool;
+}
+
+size_t mtPoolThreads(const mt_pool_t* pool)
+{
+	ASSERT(memIsValid(pool, sizeof(mt_pool_t)));
+	return pool->threads;
+}
+
+void mtPoolSubmit(mt_pool_t* pool, mt_task_i fn, void* arg)
+{
+	size_t i, t;
+	ASSERT(memIsValid(pool, sizeof(mt_pool_t)));
+	// поставить в очередь
+	mtAtomicIncr(&pool->pending);
+	mtAtomicIncr(&pool->queued);
+	i = mtAtomicIncr(&pool->next);
+	for (t = 0; t < pool->threads; ++t)
+		if (mtPoolPush(pool->wk + (i + t) % pool->threads, fn, arg))
+			break;
+	// очереди заполнены?
+	if (t == pool->threads)
+	{
+		void* scratch = pool->scratch ? stackCreate(pool->scratch) : 0;
+		// выполнить немедленно
+		if (pool->scratch == 0 || scratch)
+		{
+			mtAtomicDecr(&pool->queued);
+			fn(arg, scratch);
+			stackClose(scratch);
+			mtPoolDone(pool);
+			return;
+		}
+		// ожидать места в очереди
+		while (!mtPoolPush(pool->wk + i % pool->threads, fn, arg))
+			mtThrdYield();
+	}
+	// оповестить рабочие потоки
+	mtMtxLock(pool->mtx);
+	mtCndSignal(pool->work);
+	mtMtxUnlock(pool->mtx);
+}
+
+void mtPoolWait(mt_pool_t* pool)
+{
+	ASSERT(memIsValid(pool, sizeof(mt_pool_t)));
+	while (mtAtomicLoad(&pool->pending))
+	{
+		if (mtPoolRun(pool, pool->wk))
+			continue;
+		mtMtxLock(pool->mtx);
+		while (mtAtomicLoad(&pool->pending) &&
+			mtAtomicLoad(&pool->queued) == 0)
+			mtCndWait(pool->done, pool->mtx);
+		mtMtxUnlock(pool->mtx);
+	}
+}
+
+void mtPoolClose(mt_pool_t* pool)
+{
+	size_t t;
+	if (pool == 0)
+		return;
+	ASSERT(memIsValid(pool, sizeof(mt_pool_t)));
+	// завершить задачи
+	mtPoolWait(pool);
+	// завершить рабочие потоки
+	mtMtxLock(pool->mtx);
+	pool->stop = TRUE;
+	mtCndBroadcast(pool->work);
+	mtMtxUnlock(pool->mtx);
+	for (t = 1; t < pool->threads; ++t)
+		if (pool->wk[t].created)
+			mtThrdJoin(&pool->wk[t].thrd);
+	// освободить ресурсы
+	mtCndClose(pool->done);
+	mtCndClose(pool->work);
+	mtMtxClose(pool->mtx);
+	mtPoolFree(pool, pool->threads);
+}
+
+/*
+*******************************************************************************
+Реплики
+
+Указатели на копии объекта хранятся в массиве copies, индексированном
+номерами узлов. Копия устанавливается атомарной заменой нулевого указателя.
+Поток, проигравший гонку за установку, освобождает свою копию.
+*******************************************************************************
+*/
+
+struct mt_rep_st
+{
+	const void* obj;			/*< объект */
+	size_t size;				/*< размер объекта */
+	mt_rep_copy_i copy;			/*< функция копирования */
+	size_t nodes;				/*< число узлов */
+	void* copies[];				/*< копии */
+};
+
+mt_rep_t* mtRepCreate(const void* obj, size_t size, mt_rep_copy_i copy)
+{
+	mt_rep_t* rep;
+	size_t nodes;
+	if (!memIsValid(obj, size))
+		return 0;
+	nodes = mtNodes();
+	rep = (mt_rep_t*)memAlloc(sizeof(mt_rep_t) + nodes * sizeof(void*));
+	if (rep == 0)
+		return 0;
+	rep->obj = obj, rep->size = size, rep->copy = copy, rep->nodes = nodes;
+	memSetZero(rep->copies, nodes * sizeof(void*));
+	return rep;
+}
+
+const void* mtRepGet(mt_rep_t* rep)
+{
+	size_t node;
+	void* copy;
+	void* prev;
+	ASSERT(memIsValid(rep, sizeof(mt_rep_t)));
+	if (rep->nodes == 1)
+		return rep->obj;
+	// копия уже создана?
+	node = mtNodeCur();
+	ASSERT(node < rep->nodes);
+	copy = mtAtomicLoadPtr(rep->copies + node);
+	if (copy)
+		return copy;
+	// создать копию (в памяти текущего узла)
+	copy = memAlloc(rep->size);
+	if (copy == 0)
+		return rep->obj;
+	if (rep->copy)
+		rep->copy(copy, rep->obj);
+	else
+		memCopy(copy, rep->obj, rep->size);
+	// установить копию
+	prev = mtAtomicCmpSwapPtr(rep->copies + node, 0, copy);
+	if (prev)
+	{
+		memFree(copy);
+		return prev;
+	}
+	return copy;
+}
+
+void mtRepClose(mt_rep_t* rep)
+{
+	size_t node;
+	if (rep == 0)
+		return;
+	ASSERT(memIsValid(rep, sizeof(mt_rep_t)));
+	for (node = 0; node < rep->nodes; ++node)
+		if (rep->copies[node])
+			memFree(rep->copies[node]);
+	memFree(rep);
+}
+
+/*
+*******************************************************************************
+Асинхронные запросы
+
+Накапливаемые пакеты хранятся в MT_ASYNC_GROUPS группах: запросы группы
+(с одинаковыми batch и key) связываются в список через поле next.
+Если для нового запроса не нашлось ни подходящей, ни свободной группы,
+то отправляется самая старая группа (с наименьшим номером seq).
+
+Отправляемый пакет переносится из списка в задачу mt_async_task, которая
+выделяется в куче вместе с массивом указателей на запросы. Задача
+выполняется в пуле или, если в пуле нет рабочих потоков, немедленно.
+Если память под задачу выделить не удалось, то запросы пакета
+обрабатываются по одному немедленно.
+
+Группы и очередь завершений защищены мьютексом mtx. Пакеты отправляются
+и обработчики вызываются вне мьютекса, поэтому в обратных вызовах done
+разрешается ставить новые запросы.
+*******************************************************************************
+*/
+
+#define MT_ASYNC_GROUPS 16
+
+typedef struct
+{
+	mt_batch_i batch;			/*< обработчик пакета */
+	const void* key;			/*< признак совместимости */
+	mt_req_t* head;				/*< первый запрос */
+	mt_req_t* tail;				/*< последний запрос */
+	size_t count;				/*< число запросов */
+	size_t seq;					/*< номер создания */
+} mt_async_group;
+
+typedef struct
+{
+	mt_async_t* as;				/*< исполнитель */
+	size_t count;				/*< число запросов */
+	mt_req_t* reqs[];			/*< запросы */
+} mt_async_task;
+
+struct mt_async_st
+{
+	mt_pool_t* pool;			/*< пул */
+	size_t max;					/*< максимальный размер пакета */
+	mt_mtx_t mtx[1];			/*< мьютекс */
+	size_t seq;					/*< счетчик групп */
+	mt_async_group groups[MT_ASYNC_GROUPS];	/*< группы */
+	mt_req_t* head;				/*< начало очереди завершений */
+	mt_req_t* tail;				/*< конец очереди завершений */
+};
+
+static void mtAsyncComplete(mt_async_t* as, mt_req_t* req)
+{
+	if (req->done)
+	{
+		req->done(req);
+		return;
+	}
+	req->next = 0;
+	mtMtxLock(as->mtx);
+	if (as->tail)
+		as->tail->next = req;
+	else
+		as->head = req;
+	as->tail = req;
+	mtMtxUnlock(as->mtx);
+}
+
+static void mtAsyncTask(void* arg, void* scratch)
+{
+	mt_async_task* task = (mt_async_task*)arg;
+	size_t i;
+	task->reqs[0]->batch(task->reqs, task->count, scratch);
+	for (i = 0; i < task->count; ++i)
+		mtAsyncComplete(task->as, task->reqs[i]);
+	memFree(task);
+}
+
+static void mtAsyncDispatch(mt_async_t* as, mt_req_t* head, size_t count)
+{
+	mt_async_task* task;
+	void* scratch;
+	size_t i;
+	ASSERT(head && count);
+	// перенести пакет в задачу
+	task = (mt_async_task*)memAlloc(
+		sizeof(mt_async_task) + count * sizeof(mt_req_t*));
+	if (task)
+	{
+		task->as = as, task->count = count;
+		for (i = 0; i < count; ++i, head = head->next)
+			task->reqs[i] = head;
+		// выполнить в пуле
+		if (as->pool && as->pool->threads > 1)
+		{
+			mtPoolSubmit(as->pool, mtAsyncTask, task);
+			return;
+		}
+	}
+	// выполнить немедленно
+	scratch = as->pool && as->pool->scratch ?
+		stackCreate(as->pool->scratch) : 0;
+	if (task)
+		mtAsyncTask(task, scratch);
+	else
+		while (count--)
+		{
+			mt_req_t* req = head;
+			head = head->next;
+			req->batch(&req, 1, scratch);
+			mtAsyncComplete(as, req);
+		}
+	stackClose(scratch);
+}
+
+mt_async_t* mtAsyncCreate(mt_pool_t* pool, size_t max)
+{
+	mt_async_t* as;
+	ASSERT(pool == 0 || memIsValid(pool, sizeof(mt_pool_t)));
+	as = (mt_async_t*)memAlloc(sizeof(mt_async_t));
+	if (as == 0)
+		return 0;
+	memSetZero(as, sizeof(mt_async_t));
+	if (!mtMtxCreate(as->mtx))
+	{
+		memFree(as);
+		return 0;
+	}
+	as->pool = pool, as->max = max ? max : 1;
+	return as;
+}
+
+void mtAsyncSubmit(mt_async_t* as, mt_req_t* req)
+{
+	mt_async_group* g;
+	mt_req_t* head[2];
+	size_t count[2];
+	size_t i;
+	ASSERT(memIsValid(as, sizeof(mt_async_t)));
+	ASSERT(memIsValid(req, sizeof(mt_req_t)));
+	ASSERT(req->batch != 0);
+	req->code = ERR_OK, req->next = 0;
+	count[0] = count[1] = 0;
+	mtMtxLock(as->mtx);
+	// найти подходящую группу
+	for (i = 0, g = 0; i < MT_ASYNC_GROUPS; ++i)
+		if (as->groups[i].count && as->groups[i].batch == req->batch &&
+			as->groups[i].key == req->key)
+		{
+			g = as->groups + i;
+			break;
+		}
+	// занять свободную или самую старую группу
+	if (g == 0)
+	{
+		for (i = 0, g = as->groups; i < MT_ASYNC_GROUPS; ++i)
+		{
+			if (as->groups[i].count == 0)
+			{
+				g = as->groups + i;
+				break;
+			}
+			if (as->groups[i].seq < g->seq)
+				g = as->groups + i;
+		}
+		if (g->count)
+			head[0] = g->head, count[0] = g->count;
+		g->batch = req->batch, g->key = req->key;
+		g->head = g->tail = 0, g->count = 0, g->seq = as->seq++;
+	}
+	// добавить запрос
+	if (g->tail)
+		g->tail->next = req;
+	else
+		g->head = req;
+	g->tail = req, ++g->count;
+	// группа заполнена?
+	if (g->count >= as->max)
+	{
+		head[1] = g->head, count[1] = g->count;
+		g->head = g->tail = 0, g->count = 0;
+	}
+	mtMtxUnlock(as->mtx);
+	// отправить пакеты
+	for (i = 0; i < 2; ++i)
+		if (count[i])
+			mtAsyncDispatch(as, head[i], count[i]);
+}
+
+void mtAsyncFlush(mt_async_t* as)
+{
+	mt_req_t* head[MT_ASYNC_GROUPS];
+	size_t count[MT_ASYNC_GROUPS];
+	size_t i;
+	ASSERT(memIsValid(as, sizeof(mt_async_t)));
+	mtMtxLock(as->mtx);
+	for (i = 0; i < MT_ASYNC_GROUPS; ++i)
+	{
+		head[i] = as->groups[i].head, count[i] = as->groups[i].count;
+		as->groups[i].head = as->groups[i].tail = 0;
+		as->groups[i].count = 0;
+	}
+	mtMtxUnlock(as->mtx);
+	for (i = 0; i < MT_ASYNC_GROUPS; ++i)
+		if (count[i])
+			mtAsyncDispatch(as, head[i], count[i]);
+}
+
+mt_req_t* mtAsyncPoll(mt_async_t* as)
+{
+	mt_req_t* req;
+	ASSERT(memIsValid(as, sizeof(mt_async_t)));
+	mtMtxLock(as->mtx);
+	req = as->head;
+	if (req)
+	{
+		as->head = req->next;
+		if (as->head == 0)
+			as->tail = 0;
+		req->next = 0;
+	}
+	mtMtxUnlock(as->mtx);
+	return req;
+}
+
+void mtAsyncWait(mt_async_t* as)
+{
+	ASSERT(memIsValid(as, sizeof(mt_async_t)));
+	mtAsyncFlush(as);
+	if (as->pool)
+		mtPoolWait(as->pool);
+}
+
+void mtAsyncClose(mt_async_t* as)
+{
+	if (as == 0)
+		return;
+	ASSERT(memIsValid(as, sizeof(mt_async_t)));
+	mtAsyncWait(as);
+	mtMtxClose(as->mtx);
+	memFree(as);
+}
+
 /*
 *******************************************************************************
 Атомарные операции
 
+В OS_UNIX операции реализуются с помощью встроенных функций GCC / Clang:
+__sync_*() (полные барьеры) и, если поддерживаются, __atomic_*()
+(захват / освобождение). Типы _Atomic стандарта C11 не используются,
+поскольку операции выполняются над обычными объектами size_t и void*.
+В OS_WIN используются функции Interlocked*() и барьер MemoryBarrier().
+
 Пока не потребовалась функция mtMtxTryLock(). Она отличается от mtMtxLock()
 тем, что немедленно блокирует разблокированный мьютекс и не ожидает
 разблокировки заблокированного.
@@ -269,6 +1372,53 @@ size_t mtAtomicCmpSwap(size_t* ctr, size_t cmp, size_t swap)
 
 #endif // O_PER_S
 
+size_t mtAtomicFetchAdd(size_t* ctr, size_t val)
+{
+	size_t t;
+	ASSERT(memIsAligned(ctr, O_PER_S));
+	do
+		t = mtAtomicLoad(ctr);
+	while (mtAtomicCmpSwap(ctr, t, t + val) != t);
+	return t;
+}
+
+size_t mtAtomicLoad(const size_t* ctr)
+{
+	size_t t;
+	ASSERT(memIsAligned(ctr, O_PER_S));
+	t = *(const volatile size_t*)ctr;
+	MemoryBarrier();
+	return t;
+}
+
+void mtAtomicStore(size_t* ctr, size_t val)
+{
+	ASSERT(memIsAligned(ctr, O_PER_S));
+	MemoryBarrier();
+	*(volatile size_t*)ctr = val;
+}
+
+void* mtAtomicLoadPtr(void* const* ptr)
+{
+	void* t;
+	ASSERT(memIsAligned(ptr, sizeof(void*)));
+	t = *(void* const volatile*)ptr;
+	MemoryBarrier();
+	return t;
+}
+
+void mtAtomicStorePtr(void** ptr, void* val)
+{
+	ASSERT(memIsAligned(ptr, sizeof(void*)));
+	InterlockedExchangePointer(ptr, val);
+}
+
+void* mtAtomicCmpSwapPtr(void** ptr, void* cmp, void* swap)
+{
+	ASSERT(memIsAligned(ptr, sizeof(void*)));
+	return InterlockedCompareExchangePointer(ptr, swap, cmp);
+}
+
 #elif defined OS_UNIX
 
 size_t mtAtomicIncr(size_t* ctr)
@@ -286,6 +1436,68 @@ size_t mtAtomicCmpSwap(size_t* ctr, size_t cmp, size_t swap)
 	return __sync_val_compare_and_swap(ctr, cmp, swap);
 }
 
+size_t mtAtomicFetchAdd(size_t* ctr, size_t val)
+{
+	return __sync_fetch_and_add(ctr, val);
+}
+
+#if defined(__ATOMIC_ACQUIRE)
+
+size_t mtAtomicLoad(const size_t* ctr)
+{
+	return __atomic_load_n(ctr, __ATOMIC_ACQUIRE);
+}
+
+void mtAtomicStore(size_t* ctr, size_t val)
+{
+	__atomic_store_n(ctr, val, __ATOMIC_RELEASE);
+}
+
+void* mtAtomicLoadPtr(void* const* ptr)
+{
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+void mtAtomicStorePtr(void** ptr, void* val)
+{
+	__atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+}
+
+#else
+
+size_t mtAtomicLoad(const size_t* ctr)
+{
+	size_t t = *(const volatile size_t*)ctr;
+	__sync_synchronize();
+	return t;
+}
+
+void mtAtomicStore(size_t* ctr, size_t val)
+{
+	__sync_synchronize();
+	*(volatile size_t*)ctr = val;
+}
+
+void* mtAtomicLoadPtr(void* const* ptr)
+{
+	void* t = *(void* const volatile*)ptr;
+	__sync_synchronize();
+	return t;
+}
+
+void mtAtomicStorePtr(void** ptr, void* val)
+{
+	__sync_synchronize();
+	*(void* volatile*)ptr = val;
+}
+
+#endif // __ATOMIC_ACQUIRE
+
+void* mtAtomicCmpSwapPtr(void** ptr, void* cmp, void* swap)
+{
+	return __sync_val_compare_and_swap(ptr, cmp, swap);
+}
+
 #else
 
 size_t mtAtomicIncr(size_t* ctr)
@@ -308,4 +1520,44 @@ size_t mtAtomicCmpSwap(size_t* ctr, size_t cmp, size_t swap)
 	return t;
 }
 
+size_t mtAtomicFetchAdd(size_t* ctr, size_t val)
+{
+	register size_t t;
+	ASSERT(memIsValid(ctr, O_PER_S));
+	t = *ctr, *ctr += val;
+	return t;
+}
+
+size_t mtAtomicLoad(const size_t* ctr)
+{
+	ASSERT(memIsValid(ctr, O_PER_S));
+	return *ctr;
+}
+
+void mtAtomicStore(size_t* ctr, size_t val)
+{
+	ASSERT(memIsValid(ctr, O_PER_S));
+	*ctr = val;
+}
+
+void* mtAtomicLoadPtr(void* const* ptr)
+{
+	ASSERT(memIsValid(ptr, sizeof(void*)));
+	return *ptr;
+}
+
+void mtAtomicStorePtr(void** ptr, void* val)
+{
+	ASSERT(memIsValid(ptr, sizeof(void*)));
+	*ptr = val;
+}
+
+void* mtAtomicCmpSwapPtr(void** ptr, void* cmp, void* swap)
+{
+	register void* t;
+	ASSERT(memIsValid(ptr, sizeof(void*)));
+	*ptr = ((t = *ptr) == cmp) ? swap : t;
+	return t;
+}
+
 #endif // OS
@@ -4,7 +4,7 @@
 \brief Compound objects
 \project bee2 [cryptographic library]
 \created 2014.04.14
-\version 2015.05.22
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -66,8 +66,8 @@ static void objShiftPtrs(void* obj, ptrdiff_t diff)
 		if ((octet*)obj <= objPtr(obj, i, octet) + diff && 
 			objPtr(obj, i, octet) + diff < objEnd(obj, octet))
 		{
-			objShiftPtrs(objPtr(obj, i, void), diff);
 			objPtr(obj, i, octet) += diff;
+			objShiftPtrs(objPtr(obj, i, void), diff);
 		}
 	// просмотреть оставшиеся указатели
 	for (; i < objPCount(obj); ++i)
@@ -104,3 +104,128 @@ void objAppend(void* dest, const void* src, size_t i)
 	// расширить dest
 	objHdr(dest)->keep += t;
 }
+
+/*
+*******************************************************************************
+Упаковка
+
+При упаковке ссылки на внутренние участки объекта заменяются смещениями
+этих участков относительно начала объекта (для вложенных объектов --
+относительно начала вложенного объекта). Нулевые указатели сохраняются.
+Внешние ссылки не могут быть представлены смещениями, поэтому объекты
+с внешними ссылками не упаковываются. Не упаковываются и объекты
+со ссылками на собственное начало: нулевое смещение неотличимо от нулевого
+указателя.
+
+При распаковке смещения проверяются: они должны указывать внутрь объекта,
+вложенные объекты должны целиком размещаться внутри содержащих их объектов
+за пределами таблиц указателей и не должны пересекаться между собой.
+Проверки защищают от поврежденных (например, усеченных) файлов, но не от
+злонамеренных данных: выравнивание и глубина вложенности не проверяются,
+указатели на функции копируются без изменений. Поэтому распаковываются
+только объекты, упакованные в надежной среде.
+*******************************************************************************
+*/
+
+#define objOff(obj, i)\
+	(((size_t*)((octet*)(obj) + sizeof(obj_hdr_t)))[i])
+
+#define objCOff(obj, i)\
+	(((const size_t*)((const octet*)(obj) + sizeof(obj_hdr_t)))[i])
+
+static bool_t objIsPackable(const void* obj)
+{
+	size_t i;
+	const octet* p;
+	for (i = 0; i < objPCount(obj); ++i)
+	{
+		p = objCPtr(obj, i, octet);
+		if (p == 0)
+			continue;
+		if (p <= (const octet*)obj || objCEnd(obj, octet) <= p)
+			return FALSE;
+		if (i < objOCount(obj) && !objIsPackable(p))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void objPackPtrs(void* obj)
+{
+	size_t i;
+	for (i = 0; i < objPCount(obj); ++i)
+		if (objPtr(obj, i, octet))
+		{
+			if (i < objOCount(obj))
+				objPackPtrs(objPtr(obj, i, void));
+			objOff(obj, i) = (size_t)(objPtr(obj, i, octet) - (octet*)obj);
+		}
+}
+
+bool_t objPack(void* obj)
+{
+	ASSERT(objIsOperable(obj));
+	if (!objIsPackable(obj))
+		return FALSE;
+	objPackPtrs(obj);
+	return TRUE;
+}
+
+static bool_t objIsUnpackable(const void* obj, size_t count)
+{
+	size_t i, j;
+	size_t offset;
+	const void* sub;
+	// проверить заголовок
+	if (count < sizeof(obj_hdr_t) ||
+		objKeep(obj) > count ||
+		objKeep(obj) < sizeof(obj_hdr_t) ||
+		objOCount(obj) > objPCount(obj) ||
+		objPCount(obj) > (objKeep(obj) - sizeof(obj_hdr_t)) / sizeof(void*))
+		return FALSE;
+	// проверить смещения
+	for (i = 0; i < objPCount(obj); ++i)
+		if (objCOff(obj, i) >= objKeep(obj))
+			return FALSE;
+	// проверить вложенные объекты
+	for (i = 0; i < objOCount(obj); ++i)
+	{
+		if ((offset = objCOff(obj, i)) == 0)
+			continue;
+		// не пересекаются с таблицей указателей?
+		if (offset < sizeof(obj_hdr_t) + sizeof(void*) * objPCount(obj))
+			return FALSE;
+		sub = (const octet*)obj + offset;
+		if (!objIsUnpackable(sub, objKeep(obj) - offset))
+			return FALSE;
+		// не пересекаются друг с другом?
+		for (j = 0; j < i; ++j)
+			if (objCOff(obj, j) != 0 &&
+				offset < objCOff(obj, j) + objKeep((const octet*)obj +
+					objCOff(obj, j)) &&
+				objCOff(obj, j) < offset + objKeep(sub))
+				return FALSE;
+	}
+	return TRUE;
+}
+
+static void objUnpackPtrs(void* obj)
+{
+	size_t i;
+	for (i = 0; i < objPCount(obj); ++i)
+		if (objCOff(obj, i))
+		{
+			objPtr(obj, i, octet) = (octet*)obj + objOff(obj, i);
+			if (i < objOCount(obj))
+				objUnpackPtrs(objPtr(obj, i, void));
+		}
+}
+
+bool_t objUnpack(void* obj, size_t count)
+{
+	ASSERT(memIsValid(obj, count));
+	if (!objIsUnpackable(obj, count))
+		return FALSE;
+	objUnpackPtrs(obj);
+	return TRUE;
+}
@@ -4,7 +4,7 @@
 \brief Object identifiers
 \project bee2 [cryptographic library]
 \created 2013.02.04
-\version 2021.04.12
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -81,20 +81,150 @@ bool_t oidIsValid(const char* oid)
 	return n >= 2;
 }
 
+/*
+*******************************************************************************
+Реестр
+
+Элементы реестра _oid_reg упорядочены по DER-кодам: сначала по длине,
+затем лексикографически. Массив _oid_by_name содержит номера элементов
+реестра, упорядоченные по идентификаторам (strCmp()). Поиск в обоих
+случаях двоичный.
+
+\remark При пополнении реестра следует сохранить оба порядка. Тест
+oidTest() проверяет, что каждый элемент находится поиском.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	const char* oid;	/*!< идентификатор */
+	octet der[13];		/*!< DER-код */
+	size_t der_len;		/*!< длина DER-кода */
+} oid_reg_st;
+
+static const oid_reg_st _oid_reg[] =
+{
+	{"1.2.112.0.2.0.34.101.31.73", {0x06, 0x09, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x1F, 0x49}, 11},	/* belt-kwp256 */
+	{"1.2.112.0.2.0.34.101.31.81", {0x06, 0x09, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x1F, 0x51}, 11},	/* belt-hash */
+	{"1.2.112.0.2.0.34.101.45.12", {0x06, 0x09, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x2D, 0x0C}, 11},	/* bign-with-hbelt */
+	{"1.2.112.0.2.0.34.101.47.12", {0x06, 0x09, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x2F, 0x0C}, 11},	/* hmac-hbelt */
+	{"1.2.112.0.2.0.34.101.60.11", {0x06, 0x09, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x3C, 0x0B}, 11},	/* bels-share */
+	{"1.2.112.0.2.0.34.101.77.11", {0x06, 0x09, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x4D, 0x0B}, 11},	/* bash256 */
+	{"1.2.112.0.2.0.34.101.77.12", {0x06, 0x09, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x4D, 0x0C}, 11},	/* bash384 */
+	{"1.2.112.0.2.0.34.101.77.13", {0x06, 0x09, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x4D, 0x0D}, 11},	/* bash512 */
+	{"1.2.112.0.2.0.34.101.45.2.1", {0x06, 0x0A, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x2D, 0x02, 0x01}, 12},	/* bign-pubkey */
+	{"1.2.112.0.2.0.34.101.45.3.0", {0x06, 0x0A, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x2D, 0x03, 0x00}, 12},	/* bign-curve192v1 */
+	{"1.2.112.0.2.0.34.101.45.3.1", {0x06, 0x0A, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x2D, 0x03, 0x01}, 12},	/* bign-curve256v1 */
+	{"1.2.112.0.2.0.34.101.45.3.2", {0x06, 0x0A, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x2D, 0x03, 0x02}, 12},	/* bign-curve384v1 */
+	{"1.2.112.0.2.0.34.101.45.3.3", {0x06, 0x0A, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x2D, 0x03, 0x03}, 12},	/* bign-curve512v1 */
+	{"1.2.112.0.2.0.34.101.45.4.1", {0x06, 0x0A, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x2D, 0x04, 0x01}, 12},	/* bign-primefield */
+	{"1.2.112.0.2.0.34.101.60.2.1", {0x06, 0x0A, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x3C, 0x02, 0x01}, 12},	/* bels-m0128v1 */
+	{"1.2.112.0.2.0.34.101.60.2.2", {0x06, 0x0A, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x3C, 0x02, 0x02}, 12},	/* bels-m0192v1 */
+	{"1.2.112.0.2.0.34.101.60.2.3", {0x06, 0x0A, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x3C, 0x02, 0x03}, 12},	/* bels-m0256v1 */
+	{"1.2.112.0.2.0.34.101.79.6.1", {0x06, 0x0A, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x4F, 0x06, 0x01}, 12},	/* eid-access */
+	{"1.2.112.0.2.0.34.101.79.6.2", {0x06, 0x0A, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x4F, 0x06, 0x02}, 12},	/* esign-access */
+	{"1.2.112.0.2.0.34.101.79.8.1", {0x06, 0x0A, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x22, 0x65, 0x4F, 0x08, 0x01}, 12},	/* esign-auth-ext */
+	{"1.2.112.0.2.0.1176.2.3.3.1", {0x06, 0x0B, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x89, 0x18, 0x02, 0x03, 0x03, 0x01}, 13},	/* bds-params3 */
+	{"1.2.112.0.2.0.1176.2.3.3.2", {0x06, 0x0B, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x89, 0x18, 0x02, 0x03, 0x03, 0x02}, 13},	/* bdh-params3 */
+	{"1.2.112.0.2.0.1176.2.3.6.1", {0x06, 0x0B, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x89, 0x18, 0x02, 0x03, 0x06, 0x01}, 13},	/* bds-params6 */
+	{"1.2.112.0.2.0.1176.2.3.6.2", {0x06, 0x0B, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x89, 0x18, 0x02, 0x03, 0x06, 0x02}, 13},	/* bdh-params6 */
+	{"1.2.112.0.2.0.1176.2.3.10.1", {0x06, 0x0B, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x89, 0x18, 0x02, 0x03, 0x0A, 0x01}, 13},	/* bds-params10 */
+	{"1.2.112.0.2.0.1176.2.3.10.2", {0x06, 0x0B, 0x2A, 0x70, 0x00, 0x02, 0x00, 0x89, 0x18, 0x02, 0x03, 0x0A, 0x02}, 13},	/* bdh-params10 */
+};
+
+static const octet _oid_by_name[COUNT_OF(_oid_reg)] =
+{
+	24, 25, 20, 21, 22, 23, 0, 1, 2, 8, 9, 10, 11, 12, 13, 3, 4, 14, 15, 16, 5, 6, 7, 17, 18, 19
+};
+
+static int oidRegCmp(const oid_reg_st* reg, const octet der[], size_t count)
+{
+	if (reg->der_len != count)
+		return reg->der_len < count ? -1 : 1;
+	return FAST(memCmp)(reg->der, der, count);
+}
+
+const octet* oidRegDER(size_t* count, const char* oid)
+{
+	size_t l = 0, r = COUNT_OF(_oid_reg);
+	ASSERT(memIsNullOrValid(count, O_PER_S));
+	ASSERT(strIsValid(oid));
+	while (l < r)
+	{
+		size_t m = (l + r) / 2;
+		const oid_reg_st* reg = _oid_reg + _oid_by_name[m];
+		int cmp = strCmp(reg->oid, oid);
+		if (cmp == 0)
+		{
+			if (count)
+				*count = reg->der_len;
+			return reg->der;
+		}
+		if (cmp < 0)
+			l = m + 1;
+		else
+			r = m;
+	}
+	return 0;
+}
+
+const char* oidRegFind(const octet der[], size_t count)
+{
+	size_t l = 0, r = COUNT_OF(_oid_reg);
+	ASSERT(memIsValid(der, count));
+	while (l < r)
+	{
+		size_t m = (l + r) / 2;
+		int cmp = oidRegCmp(_oid_reg + m, der, count);
+		if (cmp == 0)
+			return _oid_reg[m].oid;
+		if (cmp < 0)
+			l = m + 1;
+		else
+			r = m;
+	}
+	return 0;
+}
+
 /*
 *******************************************************************************
 Кодирование
+
+Для зарегистрированных идентификаторов вместо кодирования / декодирования
+используется реестр.
 *******************************************************************************
 */
 
 size_t oidToDER(octet der[], const char* oid)
 {
+	const octet* reg;
+	size_t len;
+	if (strIsValid(oid) && (reg = oidRegDER(&len, oid)))
+	{
+		if (der)
+		{
+			ASSERT(memIsValid(der, len));
+			memCopy(der, reg, len);
+		}
+		return len;
+	}
 	return derOIDEnc(der, oid);
 }
 
 size_t oidFromDER(char* oid, const octet der[], size_t count)
 {
 	size_t len, c;
+	const char* reg;
+	if (memIsValid(der, count) && (reg = oidRegFind(der, count)))
+	{
+		len = strLen(reg);
+		if (oid)
+		{
+			ASSERT(memIsValid(oid, len + 1));
+			strCopy(oid, reg);
+		}
+		return len;
+	}
 	c = derOIDDec(oid, &len, der, count);
 	if (len == SIZE_MAX || c != count)
 		return SIZE_MAX;
@@ -4,13 +4,14 @@
 \brief Entropy sources and random number generators
 \project bee2 [cryptographic library]
 \created 2014.10.13
-\version 2024.06.14
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
 #include "bee2/core/blob.h"
+#include "bee2/core/cpu.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
 #include "bee2/core/mt.h"
@@ -21,8 +22,10 @@
 #include "bee2/core/u32.h"
 #include "bee2/core/util.h"
 #include "bee2/core/word.h"
+#include "bee2/crypto/bash.h"
 #include "bee2/crypto/belt.h"
 #include "bee2/crypto/brng.h"
+#include "bee2/crypto/prov.h"
 #include "bee2/math/ww.h"
 
 /*
@@ -51,12 +54,17 @@ bool_t rngTestFIPS1(const octet buf[2500])
 
 bool_t rngTestFIPS2(const octet buf[2500])
 {
+	u32 h[256];
 	u32 s[16];
 	size_t i = 2500;
 	ASSERT(memIsValid(buf, 2500));
-	memSetZero(s, sizeof(s));
+	// гистограмма октетов -> гистограмма тетрад
+	memSetZero(h, sizeof(h));
 	while (i--)
-		++s[buf[i] & 15], ++s[buf[i] >> 4];
+		++h[buf[i]];
+	memSetZero(s, sizeof(s));
+	for (i = 0; i < 256; ++i)
+		s[i & 15] += h[i], s[i >> 4] += h[i];
 	s[0] *= s[0];
 	for (i = 1; i < 16; ++i)
 		s[0] += s[i] * s[i];
@@ -64,22 +72,60 @@ bool_t rngTestFIPS2(const octet buf[2500])
 	return 10800 < s[0] && s[0] < 230850;
 }
 
-bool_t rngTestFIPS3(const octet buf[2500])
+/*
+*******************************************************************************
+Серии
+
+Функция rngTestRuns() определяет число серий s[b][l] из битов b длины l
+(l = 1, 2,..., 5, s[b][6] -- число серий длины 6 и больше) и длину самой
+длинной серии. Серии просматриваются по машинным словам: в слове
+d = w ^ (w >> 1) установлены биты, на которых заканчиваются серии
+(следующий бит отличается от текущего), и эти биты перебираются с помощью
+wordCTZ(). Число шагов равняется числу серий (в среднем 10000), а не числу
+битов (20000), и каждый шаг выполняется без ветвлений по отдельным битам.
+*******************************************************************************
+*/
+
+static size_t rngTestRuns(word s[2][7], const octet buf[2500])
 {
-	word s[2][7];
-	octet b;
-	size_t l;
-	size_t i;
-	ASSERT(memIsValid(buf, 2500));
-	memSetZero(s, sizeof(s));
-	b = buf[0] & 1;
-	l = 1;
-	for (i = 1; i < 20000; ++i)
-		if ((buf[i / 8] >> i % 8 & 1) == b)
-			++l;
+	const size_t n = W_OF_O(2500);
+	word w[W_OF_O(2500)];
+	size_t max = 0;
+	size_t start = 0;
+	size_t i, e, l;
+	word b, d;
+	wwFrom(w, buf, 2500);
+	memSetZero(s, 2 * 7 * sizeof(word));
+	b = w[0] & 1;
+	for (i = 0; i < n; ++i)
+	{
+		// d <- окончания серий в w[i]
+		d = w[i] >> 1;
+		if (i + 1 < n)
+			d |= w[i + 1] << (B_PER_W - 1);
 		else
-			++s[b][MIN2(l, 6)], b = !b, l = 1;
+			d &= WORD_BIT_POS(19999 % B_PER_W) - 1;
+		d ^= w[i];
+		// обработать серии
+		for (; d; d &= d - 1)
+		{
+			e = i * B_PER_W + wordCTZ(d) + 1;
+			l = e - start, start = e;
+			++s[b][MIN2(l, 6)];
+			max = MAX2(max, l);
+			b ^= 1;
+		}
+	}
+	// последняя серия
+	l = 20000 - start;
 	++s[b][MIN2(l, 6)];
+	max = MAX2(max, l);
+	memWipe(w, sizeof(w));
+	return max;
+}
+
+static bool_t rngTestRunsOk(word s[2][7])
+{
 	return 2315 <= s[0][1] && s[0][1] <= 2685 &&
 		2315 <= s[1][1] && s[1][1] <= 2685 &&
 		1114 <= s[0][2] && s[0][2] <= 1386 &&
@@ -94,24 +140,26 @@ bool_t rngTestFIPS3(const octet buf[2500])
 		103 <= s[1][6] && s[1][6] <= 209;
 }
 
+bool_t rngTestFIPS3(const octet buf[2500])
+{
+	word s[2][7];
+	ASSERT(memIsValid(buf, 2500));
+	rngTestRuns(s, buf);
+	return rngTestRunsOk(s);
+}
+
 bool_t rngTestFIPS4(const octet buf[2500])
 {
-	octet b;
-	size_t l;
-	size_t i;
+	word s[2][7];
 	ASSERT(memIsValid(buf, 2500));
-	b = buf[0] & 1;
-	l = 1;
-	for (i = 1; i < 20000; ++i)
-		if ((buf[i / 8] >> i % 8 & 1) == b)
-			++l;
-		else
-		{
-			if (l >= 26)
-				return FALSE;
-			b = !b, l = 1;
-		}
-	return l < 26;
+	return rngTestRuns(s, buf) < 26;
+}
+
+static bool_t rngTestFIPS(const octet buf[2500])
+{
+	word s[2][7];
+	return rngTestFIPS1(buf) && rngTestFIPS2(buf) &&
+		rngTestRuns(s, buf) < 26 && rngTestRunsOk(s);
 }
 
 /*
@@ -133,40 +181,32 @@ bool_t rngTestFIPS4(const octet buf[2500])
 инструкция rdrand поддержана более широко.
 
 Инструкция rdseed используется в основном источнике "trng",
-инструкция rdrand -- во вспомогательном источнике "trng2".
+инструкция rdrand -- во вспомогательном источнике "trng2". Наличие инструкций
+определяется с помощью cpuHas().
+
+Инструкции могут временно не выдавать данные (флаг CF сброшен), особенно rdseed
+при интенсивных обращениях. Следуя рекомендациям Intel, обращения
+повторяются: не более RNG_RDSEED_RETRIES раз для rdseed и не более
+RNG_RDRAND_RETRIES раз для rdrand. Только после этого фиксируется ошибка.
 *******************************************************************************
 */
 
+#define RNG_RDSEED_RETRIES 100
+#define RNG_RDRAND_RETRIES 10
+
 #if (_MSC_VER >= 1600) && (defined(_M_IX86) || defined(_M_X64))
 
 #include <intrin.h>
 #include <immintrin.h>
 
-#define rngCPUID(info, id) __cpuidex((int*)info, id, 0)
 #define rngRDStep(val) _rdseed32_step(val)
 #define rngRDStep2(val) _rdrand32_step(val)
 
 #elif defined(_MSC_VER) && defined(_M_IX86)
 
-#define cpuid		__asm _emit 0x0F __asm _emit 0xA2
 #define rdseed_eax	__asm _emit 0x0F __asm _emit 0xC7 __asm _emit 0xF8
 #define rdrand_eax	__asm _emit 0x0F __asm _emit 0xC7 __asm _emit 0xF0
 
-static void rngCPUID(u32 info[4], u32 id)
-{
-	u32 a, b, c, d;
-	__asm {
-		mov eax, id
-		xor ecx, ecx
-		cpuid
-		mov a, eax
-		mov b, ebx
-		mov c, ecx
-		mov d, edx
-	}
-	info[0] = a, info[1] = b, info[2] = c, info[3] = d; 
-}
-
 static int rngRDStep(u32* val)
 {
 	__asm {
@@ -200,11 +240,6 @@ err:
 #elif (defined(__GNUC__) || defined(__clang__)) && \
   (defined(__i386__) || defined(__x86_64__))
 
-#include <cpuid.h>
-
-#define rngCPUID(info, id) \
-	__cpuid_count(id, 0, info[0], info[1], info[2], info[3])
-
 static int rngRDStep(u32* val)
 {
 	octet ok = 0;
@@ -221,46 +256,31 @@ static int rngRDStep2(u32* val)
 
 #else
 
-#define rngCPUID(info, id) memSetZero(info, 16)
 #define rngRDStep(val) 0
 #define rngRDStep2(val) 0
 
 #endif
 
-static bool_t rngCPUIDIsManufId(const u32 info[4], const char id[12 + 1])
+static bool_t rngRDSeed(u32* val)
 {
-	ASSERT(strIsValid(id));
-	ASSERT(strLen(id) == 12);
-	return memEq(info + 1, id + 0, 4) &&
-		memEq(info + 3, id + 4, 4) &&
-		memEq(info + 2, id + 8, 4);
+	size_t i;
+	for (i = 0; i < RNG_RDSEED_RETRIES; ++i)
+		if (rngRDStep(val))
+			return TRUE;
+	return FALSE;
 }
 
-static bool_t rngTRNGIsAvail()
+static bool_t rngRDRand(u32* val)
 {
-	u32 info[4];
-	// Intel or AMD?
-	rngCPUID(info, 0);
-	if (!rngCPUIDIsManufId(info, "GenuineIntel") &&
-		!rngCPUIDIsManufId(info, "AuthenticAMD"))
-		return FALSE;
-	// rdseed?
-	rngCPUID(info, 7);
-	return (info[1] & 0x00040000) != 0;
+	size_t i;
+	for (i = 0; i < RNG_RDRAND_RETRIES; ++i)
+		if (rngRDStep2(val))
+			return TRUE;
+	return FALSE;
 }
 
-static bool_t rngTRNG2IsAvail()
-{
-	u32 info[4];
-	// Intel or AMD?
-	rngCPUID(info, 0);
-	if (!rngCPUIDIsManufId(info, "GenuineIntel") &&
-		!rngCPUIDIsManufId(info, "AuthenticAMD"))
-		return FALSE;
-	// rdrand?
-	rngCPUID(info, 1);
-	return (info[2] & 0x40000000) != 0;
-}
+#define rngTRNGIsAvail() cpuHas(CPU_RDSEED)
+#define rngTRNG2IsAvail() cpuHas(CPU_RDRAND)
 
 static err_t rngTRNGRead(void* buf, size_t* read, size_t count)
 {
@@ -277,13 +297,13 @@ static err_t rngTRNGRead(void* buf, size_t* read, size_t count)
 		return ERR_OK;
 	// генерация
 	for (; *read + 4 <= count; *read += 4, ++rand)
-		if (!rngRDStep(rand))
+		if (!rngRDSeed(rand))
 			return ERR_BAD_ENTROPY;
 	// неполный блок
 	if (*read < count)
 	{
 		rand = (u32*)((octet*)buf + count - 4);
-		if (!rngRDStep(rand))
+		if (!rngRDSeed(rand))
 			return ERR_BAD_ENTROPY;
 		*read = count;
 	}
@@ -305,13 +325,13 @@ static err_t rngTRNG2Read(void* buf, size_t* read, size_t count)
 		return ERR_OK;
 	// генерация
 	for (; *read + 4 <= count; *read += 4, ++rand)
-		if (!rngRDStep2(rand))
+		if (!rngRDRand(rand))
 			return ERR_BAD_ENTROPY;
 	// неполный блок
 	if (*read < count)
 	{
 		rand = (u32*)((octet*)buf + count - 4);
-		if (!rngRDStep2(rand))
+		if (!rngRDRand(rand))
 			return ERR_BAD_ENTROPY;
 		*read = count;
 	}
@@ -323,15 +343,25 @@ static err_t rngTRNG2Read(void* buf, size_t* read, size_t count)
 Системный источник
 
 Системные источники Windows:
-- функция CryptGenRandom() поверх стандартного провайдера PROV_RSA_FULL;
+- функция BCryptGenRandom() с флагом BCRYPT_USE_SYSTEM_PREFERRED_RNG;
 - функция RtlGenRandom(). 
 
 Системный источник Unix:
-- файл dev/urandom.
+- системный вызов getrandom() (Linux) или функция getentropy() (Apple);
+- файл dev/urandom, если системный вызов не поддерживается.
 
 Дополнительный системный источник Linix:
 - функция RAND_bytes() библиотеки OpenSSL/libcrypto.
 
+Генератор rngStepR() опрашивает системные источники при каждом обновлении
+ключа. Чтобы не открывать их при каждом опросе, дескрипторы (файл
+dev/urandom, библиотека libcrypto) открываются однократно и хранятся, пока
+создан общий генератор: функция rngSysOpen() вызывается из rngCreate(),
+функция rngSysClose() -- из rngClose() при закрытии последней ссылки.
+Файл открывается только тогда, когда getrandom() недоступен, библиотека --
+при первом обращении к "sys2". Если генератор не создан, то дескрипторы
+открываются и закрываются при каждом обращении, как и раньше.
+
 Анализ источников:
 * https://eprint.iacr.org/2005/029;
 * https://eprint.iacr.org/2006/086;
@@ -356,8 +386,8 @@ static err_t rngTRNG2Read(void* buf, size_t* read, size_t count)
 запускались под виртуальной машиной). Поэтому было решено использовать чтение
 из dev/urandom. Это неблокирующий источник, который всегда выдает данные.
 
-\remark Установка флагов CRYPT_VERIFYCONTEXT и CRYPT_SILENT при вызове
-CryptAcquireContextW() снижает риск ошибочного завершения функции.
+\remark Функция BCryptGenRandom() с флагом BCRYPT_USE_SYSTEM_PREFERRED_RNG
+не требует открытия провайдера алгоритма.
 
 \remark На платформе OS_UNIX функция rngSys2Read() реализуется по-разному
 в зависимости от использования инструмента MemSan (Memory Sanitizer).
@@ -371,29 +401,33 @@ CryptAcquireContextW() снижает риск ошибочного заверш
 #if defined OS_WIN
 
 #include <windows.h>
-#include <wincrypt.h>
+#include <bcrypt.h>
 #include <ntsecapi.h>
 
+#ifndef BCRYPT_USE_SYSTEM_PREFERRED_RNG
+	#define BCRYPT_USE_SYSTEM_PREFERRED_RNG 0x00000002
+#endif
+
+static void rngSysOpen()
+{
+}
+
+static void rngSysClose()
+{
+}
+
 static err_t rngSysRead(void* buf, size_t* read, size_t count)
 {
-	HCRYPTPROV hprov = 0;
 	// pre
 	ASSERT(memIsValid(read, O_PER_S));
 	ASSERT(memIsValid(buf, count));
-	ASSERT((size_t)(DWORD)count == count);
-	// открыть провайдер
-	if (!CryptAcquireContextW(&hprov, 0, 0, PROV_RSA_FULL,
-		CRYPT_VERIFYCONTEXT | CRYPT_SILENT))
-		return ERR_FILE_NOT_FOUND;
+	ASSERT((size_t)(ULONG)count == count);
 	// получить данные
 	*read = 0;
-	if (!CryptGenRandom(hprov, (DWORD)count, (octet*)buf))
-	{
-		CryptReleaseContext(hprov, 0);
+	if (BCryptGenRandom(0, (PUCHAR)buf, (ULONG)count,
+		BCRYPT_USE_SYSTEM_PREFERRED_RNG) != 0)
 		return ERR_BAD_ENTROPY;
-	}
 	// завершение
-	CryptReleaseContext(hprov, 0);
 	*read = count;
 	return ERR_OK;
 }
@@ -415,19 +449,119 @@ static err_t rngSys2Read(void* buf, size_t* read, size_t count)
 
 #elif defined OS_UNIX
 
-#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <dlfcn.h>
+#if defined(OS_LINUX)
+	#include <sys/syscall.h>
+#elif defined(OS_APPLE)
+	#include <sys/random.h>
+#endif
+
+static size_t _sys_opened;		/*< дескрипторы хранятся? */
+static size_t _sys_fd;			/*< дескриптор dev/urandom плюс 1 */
+
+/*
+	Системный вызов: ERR_OK, если данные получены, ERR_NOT_IMPLEMENTED,
+	если вызов не поддерживается, ERR_BAD_ENTROPY в остальных случаях.
+*/
+
+static err_t rngSysCall(void* buf, size_t count)
+{
+#if defined(OS_LINUX) && defined(SYS_getrandom)
+	long r;
+	// при count == 0 проверяется поддержка вызова
+	do
+	{
+		r = syscall(SYS_getrandom, buf, count, 0);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r < 0)
+			return errno == ENOSYS ? ERR_NOT_IMPLEMENTED : ERR_BAD_ENTROPY;
+		buf = (octet*)buf + r, count -= (size_t)r;
+	}
+	while (count);
+	return ERR_OK;
+#elif defined(OS_APPLE)
+	size_t c;
+	for (; count; buf = (octet*)buf + c, count -= c)
+	{
+		c = MIN2(count, 256);
+		if (getentropy(buf, c) != 0)
+			return errno == ENOSYS ? ERR_NOT_IMPLEMENTED : ERR_BAD_ENTROPY;
+	}
+	return ERR_OK;
+#else
+	return ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+static size_t rngSysFileRead(int fd, void* buf, size_t count)
+{
+	size_t done = 0;
+	ssize_t r;
+	while (done < count)
+	{
+		r = read(fd, (octet*)buf + done, count - done);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0)
+			break;
+		done += (size_t)r;
+	}
+	return done;
+}
+
+static void rngSysOpen()
+{
+	int fd;
+	if (mtAtomicLoad(&_sys_opened))
+		return;
+	if (rngSysCall(0, 0) == ERR_NOT_IMPLEMENTED &&
+		(fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC)) >= 0)
+		mtAtomicStore(&_sys_fd, (size_t)fd + 1);
+	mtAtomicStore(&_sys_opened, 1);
+}
+
+static void rngSys2Close();
+
+static void rngSysClose()
+{
+	size_t fd;
+	if (!mtAtomicLoad(&_sys_opened))
+		return;
+	mtAtomicStore(&_sys_opened, 0);
+	if ((fd = mtAtomicLoad(&_sys_fd)) != 0)
+		mtAtomicStore(&_sys_fd, 0), close((int)(fd - 1));
+	rngSys2Close();
+}
 
 static err_t rngSysRead(void* buf, size_t* read, size_t count)
 {
-	FILE* fp;
+	size_t fd;
+	int tmp;
+	err_t code;
 	ASSERT(memIsValid(read, sizeof(size_t)));
 	ASSERT(memIsValid(buf, count));
-	fp = fopen("/dev/urandom", "r");
-	if (!fp)
+	// системный вызов
+	*read = 0;
+	code = rngSysCall(buf, count);
+	if (code == ERR_OK)
+		*read = count;
+	if (code != ERR_NOT_IMPLEMENTED)
+		return code;
+	// хранимый дескриптор
+	if ((fd = mtAtomicLoad(&_sys_fd)) != 0)
+	{
+		*read = rngSysFileRead((int)(fd - 1), buf, count);
+		return ERR_OK;
+	}
+	// временный дескриптор
+	if ((tmp = open("/dev/urandom", O_RDONLY | O_CLOEXEC)) < 0)
 		return ERR_FILE_OPEN;
-	*read = fread(buf, 1, count, fp);
-	fclose(fp);
+	*read = rngSysFileRead(tmp, buf, count);
+	close(tmp);
 	return ERR_OK;
 }
 
@@ -440,40 +574,69 @@ static err_t rngSysRead(void* buf, size_t* read, size_t count)
 
 #if defined(OS_LINUX) && !defined(MEMORY_SANITIZER) 
 
-static err_t rngSys2Read(void* buf, size_t* read, size_t count)
+static void* _sys2_lib;			/*< хранимая библиотека libcrypto */
+
+static void* rngSys2Open()
 {
 	const char* names[] = {
 		"libcrypto.so", "libcrypto.so.3", "libcrypto.so.1.1",
 		"libcrypto.so.1.1.1" };
 	size_t pos;
+	void* lib = 0;
+	for (pos = 0; pos < COUNT_OF(names); ++pos)
+		if (lib = dlopen(names[pos], RTLD_NOW))
+			break;
+	return lib;
+}
+
+static void rngSys2Close()
+{
+	void* lib = mtAtomicLoadPtr(&_sys2_lib);
+	if (lib && mtAtomicCmpSwapPtr(&_sys2_lib, lib, 0) == lib)
+		dlclose(lib);
+}
+
+static err_t rngSys2Read(void* buf, size_t* read, size_t count)
+{
 	void* lib;
+	void* prev;
+	bool_t temp = FALSE;
 	int(*rand_bytes)(octet*, int) = 0;
+	err_t code = ERR_OK;
 	// pre
 	ASSERT(memIsValid(read, sizeof(size_t)));
 	ASSERT(memIsValid(buf, count));
 	ASSERT((size_t)(int)count == count);
-	// пробежать имена
-	for (pos = 0; pos < COUNT_OF(names); ++pos)
-		if (lib = dlopen(names[pos], RTLD_NOW))
-			break;
-	if (pos == COUNT_OF(names))
-		return ERR_FILE_NOT_FOUND;
+	// найти библиотеку
+	if (!(lib = mtAtomicLoadPtr(&_sys2_lib)))
+	{
+		if (!(lib = rngSys2Open()))
+			return ERR_FILE_NOT_FOUND;
+		// сохранить (если хранятся дескрипторы и не успел другой поток)
+		if (!mtAtomicLoad(&_sys_opened))
+			temp = TRUE;
+		else if ((prev = mtAtomicCmpSwapPtr(&_sys2_lib, 0, lib)) != 0)
+			dlclose(lib), lib = prev;
+	}
 	// прочитать случайные данные
 	*read = 0;
 	rand_bytes = dlsym(lib, "RAND_bytes");
 	if (!rand_bytes || rand_bytes(buf, (int)count) != 1)
-	{
-		dlclose(lib);
-		return ERR_NOT_FOUND;
-	}
+		code = ERR_NOT_FOUND;
+	else
+		*read = count;
 	// завершение
-	dlclose(lib);
-	*read = count;
-	return ERR_OK;
+	if (temp)
+		dlclose(lib);
+	return code;
 }
 
 #else
 
+static void rngSys2Close()
+{
+}
+
 static err_t rngSys2Read(void* buf, size_t* read, size_t count)
 {
 	ASSERT(memIsValid(read, sizeof(size_t)));
@@ -485,6 +648,14 @@ static err_t rngSys2Read(void* buf, size_t* read, size_t count)
 
 #else
 
+static void rngSysOpen()
+{
+}
+
+static void rngSysClose()
+{
+}
+
 static err_t rngSysRead(void* buf, size_t* read, size_t count)
 {
 	ASSERT(memIsValid(read, sizeof(size_t)));
@@ -605,15 +776,33 @@ err_t rngESTest(const char* source)
 		code = ERR_FILE_READ;
 	ERR_CALL_CHECK(code);
 	// статистическое тестирование
-	if (!rngTestFIPS1(buf) || !rngTestFIPS2(buf) || !rngTestFIPS3(buf) ||
-		!rngTestFIPS4(buf))
+	if (!rngTestFIPS(buf))
 		code = ERR_STATTEST;
 	// завершение
 	memWipe(buf, sizeof(buf));
 	return code;
 }
 
-err_t rngESHealth2()
+/*
+*******************************************************************************
+Проверка работоспособности источников
+
+Источники проверяются в порядке убывания качества, проверка прекращается,
+как только найдено достаточное число работоспособных источников.
+Результаты проверок rngESHealth() и rngESHealth2() рассчитываются
+однократно и сохраняются до завершения процесса: повторные вызовы
+(например, в каждой команде bee2cmd, запущенной из одного процесса)
+не читают источники повторно. Отдельные источники по-прежнему можно
+проверить функцией rngESTest().
+*******************************************************************************
+*/
+
+static size_t _health_once;			/*< триггер однократности */
+static size_t _health2_once;		/*< триггер однократности */
+static err_t _health_code;			/*< результат rngESHealth() */
+static err_t _health2_code;			/*< результат rngESHealth2() */
+
+static err_t rngESHealth2Int()
 {
 	const char* sources[] = { "trng", "trng2" };
 	size_t pos;
@@ -625,7 +814,19 @@ err_t rngESHealth2()
 	return ERR_NOT_ENOUGH_ENTROPY;
 }
 
-err_t rngESHealth()
+static void rngESHealth2Once()
+{
+	_health2_code = rngESHealth2Int();
+}
+
+err_t rngESHealth2()
+{
+	if (!mtCallOnce(&_health2_once, rngESHealth2Once))
+		return rngESHealth2Int();
+	return _health2_code;
+}
+
+static err_t rngESHealthInt()
 {
 	const char* sources[] = { "sys", "sys2", "timer" };
 	size_t valid_sources = 0;
@@ -649,6 +850,18 @@ err_t rngESHealth()
 	return ERR_BAD_ENTROPY;
 }
 
+static void rngESHealthOnce()
+{
+	_health_code = rngESHealthInt();
+}
+
+err_t rngESHealth()
+{
+	if (!mtCallOnce(&_health_once, rngESHealthOnce))
+		return rngESHealthInt();
+	return _health_code;
+}
+
 /*
 *******************************************************************************
 Создание / закрытие генератора
@@ -661,32 +874,92 @@ err_t rngESHealth()
 не обязательно будет вызвана позже rngClose(). Например, rngClose()
 может вызываться в другом зарегистрированном деструкторе, который следует
 за rngDestroy().
+
+Счетчик _epoch увеличивается при каждом изменении ключа общего генератора:
+при создании и закрытии состояния, в rngRekey(), а также в дочернем
+процессе после fork(). Генераторы потоков (см. rngStepR3()) сравнивают
+сохраненное значение счетчика с текущим и при расхождении получают
+новый ключ от общего генератора.
+
+Механизм генерации (engine) выбирается при создании состояния:
+-	"belt": brngCTR (по умолчанию);
+-	"bash": программируемый автомат bash-prg уровня 256 с емкостью 1.
+Автомат bash-prg выдает данные командой squeeze, после чего необратимо
+меняется командой ratchet. Данные, которые brngCTR использует в качестве
+входного буфера (опрос источников, fork()), автомат загружает командой
+absorb. Механизм общего генератора наследуют генераторы потоков.
 *******************************************************************************
 */
 
 typedef struct 
 {
-	octet block[32];			/*< дополнительные данные brngCTR */
-	octet alg_state[];			/*< [MAX(beltHash_keep(), brngCTR_keep())] */
+	octet block[32];			/*< дополнительные данные (ключ) */
+	octet alg_state[];			/*< [rngAlg_keep()] */
 } rng_state_st;
 
+static size_t rngAlg_keep()
+{
+	return utilMax(3, beltHash_keep(), brngCTR_keep(), bashPrg_keep());
+}
+
+static void rngAlgStart(void* alg_state, bool_t bash, const octet key[32])
+{
+	if (bash)
+		bashPrgStart(alg_state, 256, 1, 0, 0, key, 32);
+	else
+		brngCTRStart(alg_state, key, 0);
+}
+
+static void rngAlgStepR(void* buf, size_t count, bool_t bash, 
+	void* alg_state)
+{
+	if (bash)
+	{
+		bashPrgSqueeze(buf, count, alg_state);
+		bashPrgRatchet(alg_state);
+	}
+	else
+		brngCTRStepR(buf, count, alg_state);
+}
+
+static void rngAlgStepRA(void* buf, size_t count, bool_t bash, 
+	void* alg_state)
+{
+	if (bash)
+		bashPrgAbsorb(buf, count, alg_state);
+	rngAlgStepR(buf, count, bash, alg_state);
+}
+
 static size_t _once;			/*< триггер однократности */
 static mt_mtx_t _mtx[1];		/*< мьютекс */
 static bool_t _inited;			/*< мьютекс создан? */
 static size_t _ctr;				/*< счетчик обращений */
 static rng_state_st* _state;	/*< состояние */
+static size_t _epoch;			/*< эпоха ключа */
+static bool_t _paranoid;		/*< режим paranoid? */
+static bool_t _bash;			/*< механизм bash-prg? */
+static size_t _reseed_ctr;		/*< октетов после опроса источников */
+static tm_time_t _reseed_time;	/*< время опроса источников */
 
 size_t rngCreate_keep()
 {
-	return sizeof(rng_state_st) + MAX2(beltHash_keep(), brngCTR_keep());
+	return sizeof(rng_state_st) + rngAlg_keep();
 }
 
+static void rngThrdInit();
+static void rngThrdDestroy();
+static void rngForkInit();
+static void rngForkMark();
+
 static void rngDestroy()
 {
 	// закрыть состояние (могли забыть)
 	mtMtxLock(_mtx);
-	blobClose(_state), _state = 0, _ctr = 0;
+	blobClose(_state), _state = 0, _ctr = 0, ++_epoch;
+	rngSysClose();
 	mtMtxUnlock(_mtx);
+	// закрыть генератор текущего потока
+	rngThrdDestroy();
 	// закрыть мьютекс
 	mtMtxClose(_mtx);
 }
@@ -703,13 +976,21 @@ static void rngInit()
 		mtMtxClose(_mtx);
 		return;
 	}
+	// подготовить генераторы потоков
+	rngThrdInit();
+	// зарегистрировать обработчики fork()
+	rngForkInit();
 	_inited = TRUE;
 }
 
-err_t rngCreate(read_i source, void* source_state)
+static err_t rngCreateInt(read_i source, void* source_state, 
+	const char* engine)
 {
 	const char* sources[] = { "trng", "trng2", "sys", "timer" };
 	size_t read, count, pos;
+	// проверить механизм
+	if (engine && !strEq(engine, "belt") && !strEq(engine, "bash"))
+		return ERR_BAD_PARAMS;
 	// инициализировать однократно
 	if (!mtCallOnce(&_once, rngInit) || !_inited)
 		return ERR_FILE_CREATE;
@@ -718,9 +999,15 @@ err_t rngCreate(read_i source, void* source_state)
 	// состояние уже создано?
 	if (_ctr)
 	{
+		// механизм не совпадает?
+		if (engine && strEq(engine, "bash") != _bash)
+		{
+			mtMtxUnlock(_mtx);
+			return ERR_BAD_PARAMS;
+		}
 		// учесть дополнительный источник
 		if (source && source(&read, _state->block, 32, source_state) == ERR_OK)
-			brngCTRStepR(_state->block, 32, _state->alg_state);
+			rngAlgStepRA(_state->block, 32, _bash, _state->alg_state);
 		// увеличить счетчик обращений и завершить
 		++_ctr;
 		mtMtxUnlock(_mtx);
@@ -733,15 +1020,22 @@ err_t rngCreate(read_i source, void* source_state)
 		mtMtxUnlock(_mtx);
 		return ERR_OUTOFMEMORY;
 	}
-	// опрос источников случайности
+	// открыть системные источники
+	rngSysOpen();
+	// опрос источников случайности (медленный таймер -- только если
+	// остальные источники выдали меньше 64 октетов)
 	count = 0;
 	beltHashStart(_state->alg_state);
 	for (pos = 0; pos < COUNT_OF(sources); ++pos)
+	{
+		if (count >= 64 && strEq(sources[pos], "timer"))
+			break;
 		if (rngESRead(&read, _state->block, 32, sources[pos]) == ERR_OK)
 		{
 			beltHashStepH(_state->block, read, _state->alg_state);
 			count += read;
 		}
+	}
 	if (source && source(&read, _state->block, 32, source_state) == ERR_OK)
 	{
 		beltHashStepH(_state->block, read, _state->alg_state);
@@ -750,19 +1044,34 @@ err_t rngCreate(read_i source, void* source_state)
 	if (count < 64)
 	{
 		blobClose(_state), _state = 0;
+		rngSysClose();
 		mtMtxUnlock(_mtx);
 		return ERR_NOT_ENOUGH_ENTROPY;
 	}
-	// создать brngCTR
+	// запустить механизм
 	beltHashStepG(_state->block, _state->alg_state);
-	brngCTRStart(_state->alg_state, _state->block, 0);
+	_bash = engine && strEq(engine, "bash");
+	rngAlgStart(_state->alg_state, _bash, _state->block);
 	memWipe(_state->block, 32);
 	// завершить
-	_ctr = 1;
+	_ctr = 1, ++_epoch;
+	_reseed_ctr = 0, _reseed_time = tmTime();
+	rngForkMark();
 	mtMtxUnlock(_mtx);
 	return ERR_OK;
 }
 
+err_t rngCreate(read_i source, void* source_state)
+{
+	return tmTraceCall("rngCreate", rngCreateInt(source, source_state, 0));
+}
+
+err_t rngCreate2(read_i source, void* source_state, const char* engine)
+{
+	return tmTraceCall("rngCreate2", 
+		rngCreateInt(source, source_state, engine));
+}
+
 static bool_t rngIsValid_internal()
 {
 	return _ctr && _state && blobIsValid(_state);
@@ -785,10 +1094,106 @@ void rngClose()
 	mtMtxLock(_mtx);
 	ASSERT(rngIsValid_internal());
 	if (--_ctr == 0)
-		blobClose(_state), _state = 0;
+		blobClose(_state), _state = 0, ++_epoch, rngSysClose();
 	mtMtxUnlock(_mtx);
 }
 
+/*
+*******************************************************************************
+Дочерний процесс
+
+В OS_UNIX с помощью pthread_atfork() регистрируются обработчики fork().
+В родительском процессе на время fork() блокируется мьютекс _mtx.
+В дочернем процессе вызывается функция rngForkMix(), которая
+обновляет ключ общего генератора: в механизм генерации вводятся
+идентификатор процесса, показания счетчика тактов и 32 октета от системного
+источника "sys", после чего механизм перезапускается на новом ключе,
+эпоха сменяется, бюджет опроса источников восстанавливается.
+Чтение из системного источника -- один системный вызов getrandom() или
+чтение ранее открытого файла dev/urandom. Поэтому обновление занимает
+микросекунды, в отличие от повторного создания генератора (опрос всех
+источников, в том числе источника timer).
+
+Идентификатор процесса, в котором последний раз обновлялся ключ, хранится
+в _pid. Функции rngStepR() и rngStepR2() сравнивают его с текущим
+идентификатором и при расхождении также вызывают rngForkMix(). Тем самым
+обнаруживаются дочерние процессы, созданные без вызова обработчиков
+pthread_atfork() (например, системным вызовом clone()).
+
+Функция rngForkMix() вызывается при заблокированном мьютексе _mtx.
+*******************************************************************************
+*/
+
+#ifdef OS_UNIX
+
+static pid_t _pid;				/*< процесс, в котором обновлялся ключ */
+
+#define rngForkCheck() if (_pid != getpid()) rngForkMix()
+
+static void rngForkMark()
+{
+	_pid = getpid();
+}
+
+static void rngForkMix()
+{
+	pid_t pid = getpid();
+	tm_ticks_t ticks = tmTicks();
+	size_t read;
+	if (_state)
+	{
+		// идентификатор процесса и счетчик тактов
+		memSetZero(_state->block, 32);
+		memCopy(_state->block, &pid, MIN2(sizeof(pid), 16));
+		memCopy(_state->block + 16, &ticks, MIN2(sizeof(ticks), 16));
+		rngAlgStepRA(_state->block, 32, _bash, _state->alg_state);
+		// системный источник
+		if (rngSysRead(_state->block, &read, 32) != ERR_OK || read != 32)
+			memSetZero(_state->block, 32);
+		// перезапуск
+		rngAlgStepRA(_state->block, 32, _bash, _state->alg_state);
+		rngAlgStart(_state->alg_state, _bash, _state->block);
+		memWipe(_state->block, 32);
+		_reseed_ctr = 0, _reseed_time = tmTime();
+	}
+	_pid = pid, ++_epoch;
+}
+
+static void rngAtForkPrepare()
+{
+	mtMtxLock(_mtx);
+}
+
+static void rngAtForkParent()
+{
+	mtMtxUnlock(_mtx);
+}
+
+static void rngAtForkChild()
+{
+	rngForkMix();
+	mtMtxUnlock(_mtx);
+}
+
+static void rngForkInit()
+{
+	pthread_atfork(rngAtForkPrepare, rngAtForkParent, rngAtForkChild);
+}
+
+#else
+
+#define rngForkCheck()
+
+static void rngForkInit()
+{
+}
+
+static void rngForkMark()
+{
+}
+
+#endif // OS_UNIX
+
 /*
 *******************************************************************************
 Генерация
@@ -801,25 +1206,87 @@ void rngClose()
 	A lock is held while waiting for a long running or blocking operation 
 	to complete (CWE-667)".
 Проблема в том, что в источнике timer многократно вызывается функция
-mtSleep(0).
+mtSleep(0). Предупреждение относится к режиму paranoid.
+
+В обычном режиме источники опрашиваются в rngStepR() не при каждом
+обращении, а по исчерпании бюджета: после выдачи RNG_RESEED_BYTES октетов
+или по истечении RNG_RESEED_SECS секунд с момента предыдущего опроса.
+От источников запрашивается 32 октета, опрос выполняется без блокировки
+мьютекса. Полученные данные вводятся в механизм генерации, после чего ключ
+генератора обновляется (как в rngRekey()) и эпоха сменяется. Таким образом,
+новые данные от источников получают и генераторы потоков.
+
+В режиме paranoid (см. rngSetParanoid()) источники опрашиваются при каждом
+обращении к rngStepR(), данные от них используются в качестве входного
+буфера механизма генерации (см. rngAlgStepRA()).
 *******************************************************************************
 */
 
+#define RNG_RESEED_BYTES ((size_t)1 << 20)
+#define RNG_RESEED_SECS 60
+
+
+static void rngReseedRead(size_t* read, octet block[32])
+{
+	const char* sources[] = {"trng", "trng2", "sys", "sys2", "timer"};
+	size_t r, pos;
+	*read = pos = 0;
+	memSetZero(block, 32);
+	while (*read < 32 && pos < COUNT_OF(sources))
+	{
+		if (rngESRead(&r, block + *read, 32 - *read, sources[pos]) != ERR_OK)
+			r = 0;
+		*read += r, ++pos;
+	}
+}
+
+static bool_t rngReseedIsDue(size_t count)
+{
+	tm_time_t t = tmTime();
+	return _reseed_ctr >= RNG_RESEED_BYTES - MIN2(count, RNG_RESEED_BYTES) ||
+		(t != TIME_ERR &&
+			(t < _reseed_time || t - _reseed_time >= RNG_RESEED_SECS));
+}
+
+void rngSetParanoid(bool_t paranoid)
+{
+	_paranoid = paranoid;
+}
+
+/*
+*******************************************************************************
+Провайдер
+
+Если активный провайдер (см. provActive()) выдает случайные числа, то они
+возвращаются вместо чисел механизма генерации. В режиме paranoid
+провайдер не используется.
+*******************************************************************************
+*/
+
+static bool_t rngStepRProv(void* buf, size_t count)
+{
+	const prov_o* prov = provActive();
+	return !_paranoid && prov && prov->rng &&
+		prov->rng(buf, count, prov->state) == ERR_OK;
+}
+
 void rngStepR2(void* buf, size_t count, void* state)
 {
 	ASSERT(_inited);
+	if (rngStepRProv(buf, count))
+		return;
 	mtMtxLock(_mtx);
 	ASSERT(rngIsValid_internal());
-	brngCTRStepR(buf, count, _state->alg_state);
+	rngForkCheck();
+	rngAlgStepR(buf, count, _bash, _state->alg_state);
 	mtMtxUnlock(_mtx);
 }
 
-void rngStepR(void* buf, size_t count, void* state)
+static void rngStepRParanoid(void* buf, size_t count)
 {
 	const char* sources[] = {"trng", "trng2", "sys", "sys2", "timer"};
 	size_t read, r, pos;
 	// блокировать мьютекс
-	ASSERT(_inited);
 	mtMtxLock(_mtx);
 	// опросить источники
 	read = pos = 0;
@@ -833,9 +1300,57 @@ void rngStepR(void* buf, size_t count, void* state)
 	read = r = pos = 0;
 	// генерация
 	ASSERT(rngIsValid_internal());
-	brngCTRStepR(buf, count, _state->alg_state);
+	rngAlgStepRA(buf, count, _bash, _state->alg_state);
+	// снять блокировку
+	mtMtxUnlock(_mtx);
+}
+
+static void rngStepRInt(void* buf, size_t count, void* state)
+{
+	octet block[32];
+	size_t read = 0;
+	bool_t due;
+	ASSERT(_inited);
+	// режим paranoid?
+	if (_paranoid)
+	{
+		rngStepRParanoid(buf, count);
+		return;
+	}
+	// опросить источники (без блокировки)
+	if ((due = rngReseedIsDue(count)))
+		rngReseedRead(&read, block);
+	// блокировать мьютекс
+	mtMtxLock(_mtx);
+	ASSERT(rngIsValid_internal());
+	rngForkCheck();
+	// обновить ключ
+	if (due)
+	{
+		if (read)
+		{
+			memCopy(_state->block, block, 32);
+			rngAlgStepRA(_state->block, 32, _bash, _state->alg_state);
+			rngAlgStart(_state->alg_state, _bash, _state->block);
+			memWipe(_state->block, 32);
+			++_epoch;
+		}
+		_reseed_ctr = 0, _reseed_time = tmTime();
+	}
+	// генерация
+	rngAlgStepR(buf, count, _bash, _state->alg_state);
+	_reseed_ctr += count;
 	// снять блокировку
 	mtMtxUnlock(_mtx);
+	memWipe(block, sizeof(block));
+}
+
+void rngStepR(void* buf, size_t count, void* state)
+{
+	tmTraceBegin("rngStepR");
+	if (!rngStepRProv(buf, count))
+		rngStepRInt(buf, count, state);
+	tmTraceEnd("rngStepR");
 }
 
 void rngRekey()
@@ -845,10 +1360,148 @@ void rngRekey()
 	mtMtxLock(_mtx);
 	// сгенерировать новый ключ
 	ASSERT(rngIsValid_internal());
-	brngCTRStepR(_state->block, 32, _state->alg_state);
-	// пересоздать brngCTR
-	brngCTRStart(_state->alg_state, _state->block, 0);
+	rngAlgStepR(_state->block, 32, _bash, _state->alg_state);
+	// перезапустить механизм
+	rngAlgStart(_state->alg_state, _bash, _state->block);
 	memWipe(_state->block, 32);
+	// сменить эпоху
+	++_epoch;
 	// снять блокировку
 	mtMtxUnlock(_mtx);
 }
+
+/*
+*******************************************************************************
+Генераторы потоков
+
+Генератор потока -- экземпляр механизма генерации общего генератора
+(brngCTR или bash-prg), который закрепляется за потоком
+с помощью ключа потока (см. mtKeyCreate()).
+Ключ генератора потока вырабатывается общим генератором. Генератор потока
+получает новый ключ, если у общего генератора сменилась эпоха (_epoch).
+Мьютекс _mtx блокируется только на время выработки ключа.
+
+При завершении потока состояние его генератора очищается и освобождается.
+
+В дочернем процессе после fork() эпоха общего генератора сменяется
+(см. rngForkMix()). Поэтому генераторы потоков родительского и дочернего
+процессов после fork() выдают разные случайные числа.
+
+Если ключи потоков не поддерживаются, то генераторы потоков
+не используются и rngStepR3() действует как rngStepR2().
+
+Генератор потока вырабатывает случайные октеты порциями по RNG_POOL_SIZE
+октетов в буфер pool. Короткие запросы удовлетворяются копированием
+октетов из буфера, использованные октеты буфера сразу очищаются. Запросы
+длины не меньше RNG_POOL_SIZE обслуживаются напрямую. При смене эпохи
+(в том числе после fork()) буфер очищается и заполняется заново
+на новом ключе.
+*******************************************************************************
+*/
+
+#define RNG_POOL_SIZE 4096
+
+typedef struct
+{
+	bool_t bash;				/*< механизм bash-prg? */
+	size_t epoch;				/*< эпоха ключа */
+	size_t pos;					/*< число использованных октетов pool */
+	octet block[32];			/*< ключ механизма */
+	octet pool[RNG_POOL_SIZE];	/*< выработанные октеты */
+	octet alg_state[];			/*< [rngAlg_keep()] */
+} rng_thrd_st;
+
+static bool_t _thrd_inited;		/*< ключ потока создан? */
+
+static size_t rngThrd_keep()
+{
+	return sizeof(rng_thrd_st) + rngAlg_keep();
+}
+
+static mt_key_t _thrd_key;
+
+static void MT_CALLBACK rngThrdClose(void* st)
+{
+	blobClose(st);
+}
+
+static void rngThrdInit()
+{
+	if (mtKeyCreate(&_thrd_key, rngThrdClose))
+		_thrd_inited = TRUE;
+}
+
+#define rngThrdGet() ((rng_thrd_st*)mtKeyGet(&_thrd_key))
+#define rngThrdSet(st) mtKeySet(&_thrd_key, st)
+
+static void rngThrdDestroy()
+{
+	rng_thrd_st* st;
+	if (_thrd_inited && (st = rngThrdGet()) && rngThrdSet(0))
+		rngThrdClose(st);
+}
+
+static rng_thrd_st* rngThrdState()
+{
+	rng_thrd_st* st;
+	if (!_thrd_inited)
+		return 0;
+	st = rngThrdGet();
+	if (st)
+		return st;
+	st = (rng_thrd_st*)blobCreate(rngThrd_keep());
+	if (st && !rngThrdSet(st))
+		blobClose(st), st = 0;
+	return st;
+}
+
+void rngStepR3(void* buf, size_t count, void* state)
+{
+	rng_thrd_st* st;
+	ASSERT(_inited);
+	// провайдер
+	if (rngStepRProv(buf, count))
+		return;
+	// генератор потока
+	st = rngThrdState();
+	if (!st)
+	{
+		rngStepR2(buf, count, state);
+		return;
+	}
+	// сменилась эпоха?
+	if (st->epoch != _epoch)
+	{
+		mtMtxLock(_mtx);
+		ASSERT(rngIsValid_internal());
+		rngForkCheck();
+		rngAlgStepR(st->block, 32, _bash, _state->alg_state);
+		st->epoch = _epoch, st->bash = _bash;
+		mtMtxUnlock(_mtx);
+		rngAlgStart(st->alg_state, st->bash, st->block);
+		memWipe(st->block, 32);
+		// сбросить буфер
+		memWipe(st->pool, RNG_POOL_SIZE);
+		st->pos = RNG_POOL_SIZE;
+	}
+	// длинный запрос
+	if (count >= RNG_POOL_SIZE)
+	{
+		rngAlgStepR(buf, count, st->bash, st->alg_state);
+		return;
+	}
+	// короткий запрос
+	while (count)
+	{
+		size_t r;
+		if (st->pos == RNG_POOL_SIZE)
+		{
+			rngAlgStepR(st->pool, RNG_POOL_SIZE, st->bash, st->alg_state);
+			st->pos = 0;
+		}
+		r = MIN2(count, RNG_POOL_SIZE - st->pos);
+		memCopy(buf, st->pool + st->pos, r);
+		memWipe(st->pool + st->pos, r);
+		buf = (octet*)buf + r, count -= r, st->pos += r;
+	}
+}
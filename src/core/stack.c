@@ -0,0 +1,253 @@
+/*
+*******************************************************************************
+\file stack.c
+\brief Controlled stack
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "bee2/core/blob.h"
+#include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
+#include "bee2/core/stack.h"
+#include "bee2/core/util.h"
+
+/*
+*******************************************************************************
+Стек потока: реализация
+
+Буфер потока описывается структурой stack_arena_st: в поле buf размещаются
+стеки, поле top указывает на первый свободный октет. Буфер buf выровнен
+на границу STACK_ALIGN, длины стеков округляются вверх до кратных
+STACK_ALIGN, поэтому выровнен и каждый стек. Стек, созданный в буфере,
+распознается в stackClose() по адресу. Стек, созданный в куче, является
+блобом.
+
+Буфер закрепляется за потоком с помощью ключа потока (см. mtKeyCreate()).
+Ключ создается однократно. Деструктор ключа очищает и освобождает буфер
+при завершении потока.
+
+Новый размер буфера -- максимум из удвоенного прежнего размера и требуемой
+длины, округленный вверх до кратного STACK_PAGE_SIZE, но не больше _max.
+
+Если ключи потоков не поддерживаются, то буферы не используются.
+*******************************************************************************
+*/
+
+#define STACK_PAGE_SIZE 4096
+
+typedef struct
+{
+	size_t cap;		/*< емкость буфера */
+	size_t top;		/*< число занятых октетов */
+	octet* buf;		/*< буфер (выровнен) */
+} stack_arena_st;
+
+static size_t _max = STACK_MAX_DEFAULT;
+static size_t _once;
+static bool_t _inited;
+
+static mt_key_t _key;
+
+static void MT_CALLBACK stackArenaClose(void* arena)
+{
+	stack_arena_st* st = (stack_arena_st*)arena;
+	if (st)
+	{
+		memWipe(st, sizeof(stack_arena_st) + STACK_ALIGN - 1 + st->cap);
+		memFree(st);
+	}
+}
+
+static void stackInit()
+{
+	_inited = mtKeyCreate(&_key, stackArenaClose);
+}
+
+#define stackArenaGet() ((stack_arena_st*)mtKeyGet(&_key))
+#define stackArenaSet(arena) mtKeySet(&_key, arena)
+
+static stack_arena_st* stackArenaReserve(size_t size)
+{
+	stack_arena_st* st;
+	size_t cap;
+	// ключ потока
+	if (!mtCallOnce(&_once, stackInit) || !_inited)
+		return 0;
+	// стек слишком длинный?
+	if (size > _max)
+		return 0;
+	// буфер вмещает стек?
+	st = stackArenaGet();
+	if (st && st->cap - st->top >= size)
+		return st;
+	// буфер нельзя расширить?
+	if (st && st->top)
+		return 0;
+	// новый размер буфера
+	cap = st ? MAX2(2 * st->cap, size) : size;
+	cap = (cap + STACK_PAGE_SIZE - 1) / STACK_PAGE_SIZE * STACK_PAGE_SIZE;
+	cap = MIN2(cap, _max);
+	// расширить буфер
+	stackArenaClose(st);
+	st = (stack_arena_st*)memAlloc(sizeof(stack_arena_st) + STACK_ALIGN - 1 +
+		cap);
+	if (st)
+	{
+		st->cap = cap, st->top = 0;
+		st->buf = (octet*)(st + 1);
+		st->buf += (STACK_ALIGN - (size_t)st->buf % STACK_ALIGN) % STACK_ALIGN;
+	}
+	if (!stackArenaSet(st))
+	{
+		if (st)
+			memFree(st);
+		return 0;
+	}
+	return st;
+}
+
+/*
+*******************************************************************************
+Профилирование
+
+Стеки всегда обнуляются. При профилировании (_prof != 0) при освобождении
+стека его длина и число использованных октетов (до последнего ненулевого
+октета) добавляются к данным профилирования. Стек, созданный
+до stackProfReset() и освобожденный после, считается использованным
+полностью или до последнего ненулевого октета.
+
+Признак _prof читается и записывается атомарно. Данные профилирования
+_prof_data общие для всех потоков и изменяются под защитой мьютекса
+_prof_mtx, который создается однократно.
+*******************************************************************************
+*/
+
+#ifdef BEE2_INSTRUMENT
+
+static size_t _prof;
+static stack_prof_t _prof_data;
+static size_t _prof_once;
+static bool_t _prof_inited;
+static mt_mtx_t _prof_mtx[1];
+
+static void stackProfInit()
+{
+	_prof_inited = mtMtxCreate(_prof_mtx);
+}
+
+static void stackProfAdd(const void* stack, size_t size)
+{
+	const octet* s = (const octet*)stack;
+	size_t used;
+	if (!mtAtomicLoad(&_prof))
+		return;
+	for (used = size; used && s[used - 1] == 0; --used);
+	mtMtxLock(_prof_mtx);
+	_prof_data.count++;
+	_prof_data.declared += size;
+	_prof_data.used += used;
+	if (used >= _prof_data.max_used)
+		_prof_data.max_used = used, _prof_data.max_decl = size;
+	mtMtxUnlock(_prof_mtx);
+}
+
+#else
+
+#define stackProfAdd(stack, size) ((void)0)
+
+#endif /* BEE2_INSTRUMENT */
+
+bool_t stackProfIsEnabled()
+{
+#ifdef BEE2_INSTRUMENT
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+void stackProfReset()
+{
+#ifdef BEE2_INSTRUMENT
+	if (!mtCallOnce(&_prof_once, stackProfInit) || !_prof_inited)
+		return;
+	mtMtxLock(_prof_mtx);
+	memSetZero(&_prof_data, sizeof(stack_prof_t));
+	mtAtomicStore(&_prof, 1);
+	mtMtxUnlock(_prof_mtx);
+#endif
+}
+
+void stackProfGet(stack_prof_t* p)
+{
+	ASSERT(memIsValid(p, sizeof(stack_prof_t)));
+#ifdef BEE2_INSTRUMENT
+	if (!mtCallOnce(&_prof_once, stackProfInit) || !_prof_inited)
+	{
+		memSetZero(p, sizeof(stack_prof_t));
+		return;
+	}
+	mtMtxLock(_prof_mtx);
+	mtAtomicStore(&_prof, 0);
+	memCopy(p, &_prof_data, sizeof(stack_prof_t));
+	mtMtxUnlock(_prof_mtx);
+#else
+	memSetZero(p, sizeof(stack_prof_t));
+#endif
+}
+
+/*
+*******************************************************************************
+Создание и освобождение
+*******************************************************************************
+*/
+
+void* stackCreate(size_t size)
+{
+	stack_arena_st* st;
+	void* stack;
+	if (size == 0)
+		return 0;
+	// разместить в буфере потока
+	if (size <= SIZE_MAX - STACK_ALIGN &&
+		(st = stackArenaReserve(stackAlign(size))))
+	{
+		stack = st->buf + st->top;
+		st->top += stackAlign(size);
+		memSetZero(stack, stackAlign(size));
+		return stack;
+	}
+	// разместить в куче
+	return blobCreate(size);
+}
+
+void stackClose(void* stack)
+{
+	stack_arena_st* st;
+	if (stack == 0)
+		return;
+	// стек в буфере потока?
+	st = _inited ? stackArenaGet() : 0;
+	if (st && (octet*)stack >= st->buf && (octet*)stack < st->buf + st->top)
+	{
+		size_t pos = (size_t)((octet*)stack - st->buf);
+		stackProfAdd(stack, st->top - pos);
+		memWipe(stack, st->top - pos);
+		st->top = pos;
+	}
+	else
+	{
+		stackProfAdd(stack, blobSize(stack));
+		blobClose(stack);
+	}
+}
+
+void stackSetMax(size_t max)
+{
+	_max = max;
+}
@@ -4,7 +4,7 @@
 \brief Time and timers
 \project bee2 [cryptographic library]
 \created 2012.05.10
-\version 2023.04.13
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -72,6 +72,23 @@ tm_ticks_t tmFreq()
 	return mtCallOnce(&_once, tmCalcFreq) ? _freq : 0;
 }
 
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+
+tm_ticks_t tmTicks()
+{
+	u64 ticks;
+	__asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(ticks) ::
+		"memory");
+	return (tm_ticks_t)ticks;
+}
+
+tm_ticks_t tmFreq()
+{
+	u64 freq;
+	__asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(freq));
+	return (tm_ticks_t)freq;
+}
+
 #elif defined(OS_WIN)
 
 #include <windows.h>
@@ -156,6 +173,249 @@ size_t tmSpeed(size_t reps, tm_ticks_t ticks)
 	return ticks ? (size_t)((dword)reps * tmFreq() / ticks) : SIZE_MAX;
 }
 
+/*
+*******************************************************************************
+Трассировка
+
+Буферы событий связаны в список _bufs. Список пополняется и просматривается
+под защитой мьютекса _mtx. Буфер потока закрепляется за ним с помощью
+ключа _key. При завершении потока деструктор ключа снимает с буфера признак
+занятости busy, и буфер может быть закреплен за другим потоком. Буферы
+не освобождаются: они остаются доступными через _bufs до завершения
+процесса.
+
+В буфер пишет только поток, за которым буфер закреплен. Счетчик pos
+записанных событий увеличивается после записи события (с семантикой
+освобождения). Событие с номером i находится в ячейке i % TM_TRACE_EVENTS.
+При выгрузке событие i, прочитанное из буфера, отбрасывается, если
+к моменту окончания чтения счетчик превысил i + TM_TRACE_EVENTS, т.е.
+событие могло быть затерто. Кроме этого, отбрасываются события окончания
+интервалов, начала которых затерты.
+
+Отметка времени события t переводится в микросекунды от начала
+трассировки _t0: (t - _t0) / freq даст секунды, дробная часть
+определяется поразрядно, без переполнений.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	const char* name;		/*< имя интервала */
+	tm_ticks_t ticks;		/*< показания таймера */
+	size_t end;				/*< событие окончания? */
+} tm_trace_event;
+
+typedef struct tm_trace_buf
+{
+	struct tm_trace_buf* next;	/*< следующий буфер */
+	size_t busy;				/*< буфер закреплен за потоком? */
+	size_t tid;					/*< номер буфера (потока) */
+	size_t pos;					/*< число записанных событий */
+	tm_trace_event events[TM_TRACE_EVENTS];	/*< события */
+} tm_trace_buf;
+
+static size_t _trace_once;		/*< триггер однократности */
+static bool_t _trace_inited;	/*< мьютекс создан? */
+static bool_t _trace_keyed;		/*< ключ создан? */
+static mt_mtx_t _trace_mtx[1];	/*< мьютекс */
+static mt_key_t _trace_key;		/*< ключ потока */
+static tm_trace_buf* _trace_bufs;	/*< список буферов */
+static size_t _trace_on;		/*< трассировка запущена? */
+static tm_ticks_t _trace_t0;	/*< начало трассировки */
+
+static void MT_CALLBACK tmTraceRelease(void* buf)
+{
+	mtAtomicStore(&((tm_trace_buf*)buf)->busy, 0);
+}
+
+static void tmTraceInit()
+{
+	if (!mtMtxCreate(_trace_mtx))
+		return;
+	_trace_keyed = mtKeyCreate(&_trace_key, tmTraceRelease);
+	_trace_inited = TRUE;
+}
+
+static tm_trace_buf* tmTraceBuf()
+{
+	tm_trace_buf* buf;
+	size_t tid = 0;
+	// буфер уже закреплен за потоком?
+	if (_trace_keyed && (buf = (tm_trace_buf*)mtKeyGet(&_trace_key)))
+		return buf;
+	mtMtxLock(_trace_mtx);
+	// найти свободный буфер
+	for (buf = _trace_bufs; buf; buf = buf->next)
+	{
+		if (!_trace_keyed || !mtAtomicLoad(&buf->busy))
+			break;
+		tid = MAX2(tid, buf->tid);
+	}
+	// создать буфер
+	if (!buf && (buf = (tm_trace_buf*)memAlloc(sizeof(tm_trace_buf))))
+	{
+		buf->pos = 0, buf->tid = tid + 1;
+		buf->next = _trace_bufs, _trace_bufs = buf;
+	}
+	// закрепить буфер
+	if (buf && _trace_keyed)
+	{
+		mtAtomicStore(&buf->busy, 1);
+		if (!mtKeySet(&_trace_key, buf))
+			mtAtomicStore(&buf->busy, 0), buf = 0;
+	}
+	mtMtxUnlock(_trace_mtx);
+	return buf;
+}
+
+static void tmTraceEvent(const char* name, size_t end)
+{
+	tm_trace_buf* buf;
+	tm_trace_event* e;
+	if (!mtAtomicLoad(&_trace_on) || !(buf = tmTraceBuf()))
+		return;
+	e = buf->events + buf->pos % TM_TRACE_EVENTS;
+	e->name = name, e->end = end, e->ticks = tmTicks();
+	mtAtomicStore(&buf->pos, buf->pos + 1);
+}
+
+bool_t tmTraceStart()
+{
+	tm_trace_buf* buf;
+	if (!mtCallOnce(&_trace_once, tmTraceInit) || !_trace_inited)
+		return FALSE;
+	// откалибровать таймер (может занять время)
+	tmFreq();
+	// очистить буферы
+	mtMtxLock(_trace_mtx);
+	for (buf = _trace_bufs; buf; buf = buf->next)
+		mtAtomicStore(&buf->pos, 0);
+	_trace_t0 = tmTicks();
+	mtMtxUnlock(_trace_mtx);
+	// запустить
+	mtAtomicStore(&_trace_on, 1);
+	return TRUE;
+}
+
+void tmTraceStop()
+{
+	mtAtomicStore(&_trace_on, 0);
+}
+
+void tmTraceBegin(const char* name)
+{
+	tmTraceEvent(name, 0);
+}
+
+void tmTraceEnd(const char* name)
+{
+	tmTraceEvent(name, 1);
+}
+
+err_t tmTraceEnd2(const char* name, err_t code)
+{
+	tmTraceEvent(name, 1);
+	return code;
+}
+
+typedef struct
+{
+	char* json;				/*< буфер */
+	size_t size;			/*< размер буфера */
+	size_t len;				/*< число символов */
+} tm_trace_out;
+
+static void tmTraceOutStr(tm_trace_out* out, const char* str)
+{
+	for (; *str; ++str, ++out->len)
+		if (out->json && out->len + 1 < out->size)
+			out->json[out->len] = *str;
+}
+
+static void tmTraceOutNum(tm_trace_out* out, tm_ticks_t num, size_t digits)
+{
+	char dec[24];
+	size_t pos = sizeof(dec) - 1;
+	dec[pos] = '\0';
+	do
+	{
+		dec[--pos] = (char)('0' + num % 10);
+		num /= 10;
+	}
+	while (num || sizeof(dec) - 1 - pos < digits);
+	tmTraceOutStr(out, dec + pos);
+}
+
+static void tmTraceOutTs(tm_trace_out* out, tm_ticks_t ticks, tm_ticks_t freq)
+{
+	tm_ticks_t us, ns;
+	size_t i;
+	ticks = ticks > _trace_t0 ? ticks - _trace_t0 : 0;
+	if (freq == 0)
+	{
+		tmTraceOutNum(out, ticks, 1);
+		return;
+	}
+	// us <- секунды, ns <- наносекунды внутри секунды
+	us = ticks / freq, ticks %= freq;
+	for (ns = 0, i = 0; i < 9; ++i)
+	{
+		ticks *= 10;
+		ns = ns * 10 + ticks / freq, ticks %= freq;
+	}
+	us = us * 1000000 + ns / 1000;
+	tmTraceOutNum(out, us, 1);
+	tmTraceOutStr(out, ".");
+	tmTraceOutNum(out, ns % 1000, 3);
+}
+
+size_t tmTraceExport(char* json, size_t size)
+{
+	const tm_ticks_t freq = tmFreq();
+	tm_trace_out out[1];
+	tm_trace_buf* buf;
+	bool_t first = TRUE;
+	ASSERT(json == 0 || memIsValid(json, size) && size > 0);
+	out->json = json, out->size = json ? size : 0, out->len = 0;
+	tmTraceOutStr(out, "{\"traceEvents\":[");
+	if (mtCallOnce(&_trace_once, tmTraceInit) && _trace_inited)
+	{
+		mtMtxLock(_trace_mtx);
+		for (buf = _trace_bufs; buf; buf = buf->next)
+		{
+			size_t pos = mtAtomicLoad(&buf->pos);
+			size_t i = pos > TM_TRACE_EVENTS ? pos - TM_TRACE_EVENTS : 0;
+			size_t depth = 0;
+			for (; i < pos; ++i)
+			{
+				tm_trace_event e = buf->events[i % TM_TRACE_EVENTS];
+				// событие затерто? начало интервала затерто?
+				if (mtAtomicLoad(&buf->pos) > i + TM_TRACE_EVENTS ||
+					e.end && depth == 0)
+					continue;
+				depth = e.end ? depth - 1 : depth + 1;
+				// {"name":"...","ph":"B","ts":...,"pid":1,"tid":...}
+				tmTraceOutStr(out, first ? "\n" : ",\n");
+				tmTraceOutStr(out, "{\"name\":\"");
+				tmTraceOutStr(out, e.name);
+				tmTraceOutStr(out, e.end ? "\",\"ph\":\"E\",\"ts\":" :
+					"\",\"ph\":\"B\",\"ts\":");
+				tmTraceOutTs(out, e.ticks, freq);
+				tmTraceOutStr(out, ",\"pid\":1,\"tid\":");
+				tmTraceOutNum(out, (tm_ticks_t)buf->tid, 1);
+				tmTraceOutStr(out, "}");
+				first = FALSE;
+			}
+		}
+		mtMtxUnlock(_trace_mtx);
+	}
+	tmTraceOutStr(out, "\n],\"displayTimeUnit\":\"ns\"}\n");
+	// завершить
+	if (json)
+		json[out->len < size ? out->len : 0] = '\0';
+	return out->len;
+}
+
 /*
 *******************************************************************************
 Время
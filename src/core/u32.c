@@ -4,7 +4,7 @@
 \brief 32-bit unsigned words
 \project bee2 [cryptographic library]
 \created 2015.10.28
-\version 2024.11.18
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -32,19 +32,27 @@ http://www.hackersdelight.org/.
 /*
 *******************************************************************************
 Реверс октетов
+
+Реверс выполняется макросом u32Rev_(). Цикл в u32Rev2() просматривает слова
+в порядке возрастания адресов и не содержит вызовов, поэтому компиляторы
+векторизуют его (перестановки октетов в регистрах SSSE3, NEON, AltiVec /
+VSX, z/Vector). Функция u32Rev2() используется для пакетного перевода
+последовательностей слов (серий блоков belt, загружаемых массивов
+u32From() / u32To()) на платформах BIG_ENDIAN.
 *******************************************************************************
 */
 
 u32 u32Rev(u32 w)
 {
-	return w << 24 | (w & 0xFF00) << 8 | (w >> 8 & 0xFF00) | w >> 24;
+	return u32Rev_(w);
 }
 
 void u32Rev2(u32 buf[], size_t count)
 {
+	size_t i;
 	ASSERT(memIsValid(buf, count * 4));
-	while (count--)
-		buf[count] = u32Rev(buf[count]);
+	for (i = 0; i < count; ++i)
+		buf[i] = u32Rev_(buf[i]);
 }
 
 /*
@@ -238,8 +246,7 @@ void u32From(u32 dest[], const void* src, size_t count)
 	if (count % 4)
 		memSetZero((octet*)dest + count, 4 - count % 4);
 #if (OCTET_ORDER == BIG_ENDIAN)
-	for (count = (count + 3) / 4; count--;)
-		dest[count] = u32Rev(dest[count]);
+	u32Rev2(dest, (count + 3) / 4);
 #endif // OCTET_ORDER
 }
 
@@ -256,7 +263,6 @@ void u32To(void* dest, size_t count, const u32 src[])
 		for (t *= 4; t < count; ++t, u >>= 8)
 			((octet*)dest)[t] = (octet)u;
 	}
-	for (count /= 4; count--;)
-		((u32*)dest)[count] = u32Rev(((u32*)dest)[count]);
+	u32Rev2((u32*)dest, count / 4);
 #endif // OCTET_ORDER
 }
@@ -4,7 +4,7 @@
 \brief 64-bit unsigned words
 \project bee2 [cryptographic library]
 \created 2015.10.28
-\version 2024.11.18
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -24,16 +24,15 @@
 
 u64 u64Rev(u64 w)
 {
-	return w << 56 | (w & 0xFF00) << 40 | (w & 0xFF0000) << 24 |
-		(w & 0xFF000000) << 8 | (w >> 8 & 0xFF000000) |
-		(w >> 24 & 0xFF0000) | (w >> 40 & 0xFF00) | w >> 56;
+	return u64Rev_(w);
 }
 
 void u64Rev2(u64 buf[], size_t count)
 {
+	size_t i;
 	ASSERT(memIsValid(buf, count * 8));
-	while (count--)
-		buf[count] = u64Rev(buf[count]);
+	for (i = 0; i < count; ++i)
+		buf[i] = u64Rev_(buf[i]);
 }
 
 u64 u64Bitrev(register u64 w)
@@ -167,8 +166,7 @@ void u64From(u64 dest[], const void* src, size_t count)
 	if (count % 8)
 		memSetZero((octet*)dest + count, 8 - count % 8);
 #if (OCTET_ORDER == BIG_ENDIAN)
-	for (count = (count + 7) / 8; count--;)
-		dest[count] = u64Rev(dest[count]);
+	u64Rev2(dest, (count + 7) / 8);
 #endif // OCTET_ORDER
 }
 
@@ -185,7 +183,6 @@ void u64To(void* dest, size_t count, const u64 src[])
 		for (t *= 8; t < count; ++t, u >>= 8)
 			((octet*)dest)[t] = (octet)u;
 	}
-	for (count /= 8; count--;)
-		((u64*)dest)[count] = u64Rev(((u64*)dest)[count]);
+	u64Rev2((u64*)dest, count / 8);
 #endif // OCTET_ORDER
 }
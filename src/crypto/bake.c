@@ -4,7 +4,7 @@
 \brief STB 34.101.66 (bake): authenticated key establishment (AKE) protocols
 \project bee2 [cryptographic library]
 \created 2014.04.14
-\version 2023.09.19
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,7 +13,10 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
 #include "bee2/core/obj.h"
+#include "bee2/core/stack.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/bake.h"
 #include "bee2/crypto/belt.h"
@@ -46,7 +49,7 @@ err_t bakeKDF(octet key[32], const octet secret[], size_t secret_len,
 		!memIsValid(key, 32))
 		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(utilMax(2, beltHash_keep(), beltKRP_keep() + 16));
+	state = stackCreate(utilMax(2, beltHash_keep(), beltKRP_keep() + 16));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	block = (octet*)state + beltKRP_keep();
@@ -66,7 +69,7 @@ err_t bakeKDF(octet key[32], const octet secret[], size_t secret_len,
 	memSetZero(block + sizeof(size_t), 16 - sizeof(size_t));
 	beltKRPStepG(key, 32, block, state);
 	// завершить
-	blobClose(state);
+	stackClose(state);
 	return ERR_OK;
 }
 
@@ -126,21 +129,319 @@ err_t bakeSWU(octet pt[], const bign_params* params, const octet msg[])
 		!memIsValid(pt, params->l / 2))
 		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bakeSWU2_deep));
+	state = stackCreate(bignStart_keep(params->l, bakeSWU2_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	// основные действия
 	W = (word*)pt;
 	bakeSWU2(W, (const ec_o*)state, msg, objEnd(state, void));
 	wwTo(pt, params->l / 2, W);
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return ERR_OK;
 }
 
+/*
+*******************************************************************************
+Кэш сертификатов
+
+Ячейка кэша содержит дайджест сертификата, уровень стойкости l (l == 0
+для пустой ячейки), открытый ключ Q (аффинная точка в том представлении
+координат, которое используется в описании кривой, построенном
+в bignStart()), время добавления и момент последнего обращения.
+
+Дайджест -- это хэш-значение beltHash() от адреса функции проверки,
+долговременных параметров и данных сертификата. Поэтому сертификат,
+проверенный другой функцией или при других параметрах, проверяется
+заново.
+
+Ячейка устаревает через ttl секунд после добавления (ttl == 0 -- никогда).
+При добавлении в заполненный кэш вытесняется устаревшая ячейка или,
+если таких нет, ячейка, к которой дольше всего не обращались (LRU).
+Кэш защищен одним мьютексом: поиск и добавление выполняются быстро
+по сравнению с остальными вычислениями протоколов. Указатель на кэш
+читается и записывается атомарно.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	size_t l;					/*< уровень стойкости (0 -- пустая ячейка) */
+	tm_time_t time;				/*< время добавления */
+	size_t stamp;				/*< момент последнего обращения */
+	octet digest[32];			/*< дайджест сертификата */
+	word Q[2 * W_OF_B(512)];	/*< открытый ключ */
+} bake_ccache_entry;
+
+typedef struct
+{
+	mt_mtx_t mtx;				/*< мьютекс */
+	tm_time_t ttl;				/*< время жизни ячеек */
+	size_t count;				/*< число ячеек */
+	size_t tick;				/*< счетчик обращений */
+	bake_ccache_entry entries[];	/*< ячейки */
+} bake_ccache_st;
+
+static void* _ccache;
+
+err_t bakeCertCacheCreate(size_t count, size_t ttl)
+{
+	bake_ccache_st* cache;
+	// проверить входные данные
+	if (count == 0 ||
+		count > (SIZE_MAX - sizeof(bake_ccache_st)) /
+			sizeof(bake_ccache_entry))
+		return ERR_BAD_INPUT;
+	if (mtAtomicLoadPtr(&_ccache))
+		return ERR_ALREADY_EXISTS;
+	// создать кэш
+	cache = (bake_ccache_st*)blobCreate(
+		sizeof(bake_ccache_st) + count * sizeof(bake_ccache_entry));
+	if (cache == 0)
+		return ERR_OUTOFMEMORY;
+	if (!mtMtxCreate(&cache->mtx))
+	{
+		blobClose(cache);
+		return ERR_OUTOFMEMORY;
+	}
+	cache->ttl = (tm_time_t)ttl;
+	cache->count = count;
+	// установить кэш
+	if (mtAtomicCmpSwapPtr(&_ccache, 0, cache) != 0)
+	{
+		mtMtxClose(&cache->mtx);
+		blobClose(cache);
+		return ERR_ALREADY_EXISTS;
+	}
+	return ERR_OK;
+}
+
+void bakeCertCacheClose()
+{
+	bake_ccache_st* cache;
+	cache = (bake_ccache_st*)mtAtomicLoadPtr(&_ccache);
+	if (cache == 0 || mtAtomicCmpSwapPtr(&_ccache, cache, 0) != cache)
+		return;
+	mtMtxClose(&cache->mtx);
+	blobClose(cache);
+}
+
+static bool_t bakeCertCacheIsFresh(const bake_ccache_st* cache,
+	const bake_ccache_entry* e, tm_time_t now)
+{
+	return e->l != 0 &&
+		(cache->ttl == 0 || e->time <= now && now - e->time < cache->ttl);
+}
+
+static bool_t bakeCertCacheGet(word Q[], size_t l, const octet digest[32])
+{
+	bake_ccache_st* cache;
+	bake_ccache_entry* e;
+	tm_time_t now;
+	size_t i;
+	bool_t found = FALSE;
+	// кэш создан?
+	cache = (bake_ccache_st*)mtAtomicLoadPtr(&_ccache);
+	if (cache == 0)
+		return FALSE;
+	// найти сертификат
+	now = tmTime();
+	mtMtxLock(&cache->mtx);
+	for (i = 0, e = cache->entries; i < cache->count; ++i, ++e)
+		if (e->l == l && memEq(e->digest, digest, 32))
+		{
+			if (bakeCertCacheIsFresh(cache, e, now))
+			{
+				wwCopy(Q, e->Q, 2 * W_OF_B(2 * l));
+				e->stamp = ++cache->tick;
+				found = TRUE;
+			}
+			else
+				e->l = 0;
+			break;
+		}
+	mtMtxUnlock(&cache->mtx);
+	return found;
+}
+
+static void bakeCertCacheAdd(size_t l, const octet digest[32],
+	const word Q[])
+{
+	bake_ccache_st* cache;
+	bake_ccache_entry* e;
+	bake_ccache_entry* victim;
+	tm_time_t now;
+	size_t i;
+	// кэш создан?
+	cache = (bake_ccache_st*)mtAtomicLoadPtr(&_ccache);
+	if (cache == 0)
+		return;
+	// выбрать ячейку
+	now = tmTime();
+	mtMtxLock(&cache->mtx);
+	victim = cache->entries;
+	for (i = 0, e = cache->entries; i < cache->count; ++i, ++e)
+	{
+		// сертификат уже добавлен в другом потоке?
+		if (e->l == l && memEq(e->digest, digest, 32))
+		{
+			victim = e;
+			break;
+		}
+		if (!bakeCertCacheIsFresh(cache, victim, now))
+			continue;
+		if (!bakeCertCacheIsFresh(cache, e, now) || e->stamp < victim->stamp)
+			victim = e;
+	}
+	// заполнить ячейку
+	victim->l = l;
+	victim->time = now;
+	victim->stamp = ++cache->tick;
+	memCopy(victim->digest, digest, 32);
+	wwCopy(victim->Q, Q, 2 * W_OF_B(2 * l));
+	mtMtxUnlock(&cache->mtx);
+}
+
+/*
+*******************************************************************************
+Проверка сертификата
+
+Функция bakeCertVal() проверяет сертификат [len]data функцией val,
+извлекает из него открытый ключ и проверяет, что ключ задает точку Q
+кривой ec. Если создан кэш сертификатов, то сначала выполняется поиск
+в кэше, а успешно проверенный сертификат добавляется в кэш.
+*******************************************************************************
+*/
+
+static err_t bakeCertVal(word Q[], const bign_params* params,
+	const ec_o* ec, bake_certval_i val, const octet data[], size_t len,
+	void* stack)
+{
+	err_t code;
+	size_t n = ec->f->n, no = ec->f->no;
+	bool_t cached;
+	// стек
+	octet* digest = (octet*)stack;		/* [32] */
+	stack = digest + 32;
+	// искать в кэше
+	if ((cached = mtAtomicLoadPtr(&_ccache) != 0))
+	{
+		beltHashStart(stack);
+		beltHashStepH(&val, sizeof(val), stack);
+		beltHashStepH(params, sizeof(bign_params), stack);
+		beltHashStepH(data, len, stack);
+		beltHashStepG(digest, stack);
+		if (bakeCertCacheGet(Q, params->l, digest))
+			return ERR_OK;
+	}
+	// проверить сертификат
+	code = val((octet*)Q, params, data, len);
+	ERR_CALL_CHECK(code);
+	// проверить открытый ключ
+	if (!qrFrom(ecX(Q), (octet*)Q, ec->f, stack) ||
+		!qrFrom(ecY(Q, n), (octet*)Q + no, ec->f, stack) ||
+		!ecpIsOnA(Q, ec, stack))
+		return ERR_BAD_CERT;
+	// добавить в кэш
+	if (cached)
+		bakeCertCacheAdd(params->l, digest, Q);
+	return ERR_OK;
+}
+
+static size_t bakeCertVal_deep(size_t n, size_t f_deep)
+{
+	return 32 +
+		utilMax(3,
+			beltHash_keep(),
+			f_deep,
+			ecpIsOnA_deep(n, f_deep));
+}
+
+/*
+*******************************************************************************
+Контекст сервера
+
+Контекст содержит копию своего сертификата, загруженный личный ключ
+и контекст bign (описание кривой). Сертификат проверяется один раз при
+создании контекста.
+
+Облегченные состояния, которые создаются функциями bakeBMQVStart2(),
+bakeBSTSStart2(), не содержат описания кривой: указатель ec ссылается
+на описание в контексте. Указатель не является вложенным, поэтому
+при копировании состояния функцией objCopy() он не изменяется.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	bake_cert cert[1];			/*< сертификат */
+	word d[W_OF_B(512)];		/*< долговременный личный ключ */
+	octet bign[];				/*< контекст bign */
+} bake_ctx_st;
+
+static size_t bakeCtxStart_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return O_OF_W(2 * n) + bakeCertVal_deep(n, f_deep);
+}
+
+size_t bakeCtx_keep(size_t l)
+{
+	return sizeof(bake_ctx_st) + bignCtx_keep(l);
+}
+
+err_t bakeCtxStart(void* ctx, const bign_params* params,
+	const octet privkey[], const bake_cert* cert)
+{
+	err_t code;
+	bake_ctx_st* st = (bake_ctx_st*)ctx;
+	const ec_o* ec;
+	size_t n, no;
+	// стек
+	word* Q;
+	void* stack;
+	// проверить входные данные
+	if (!memIsValid(params, sizeof(bign_params)))
+		return ERR_BAD_INPUT;
+	if (!bignIsOperable(params))
+		return ERR_BAD_PARAMS;
+	if (!memIsValid(ctx, bakeCtx_keep(params->l)) ||
+		!memIsValid(privkey, params->l / 4) ||
+		!memIsValid(cert, sizeof(bake_cert)) ||
+		!memIsValid(cert->data, cert->len) ||
+		cert->val == 0)
+		return ERR_BAD_INPUT;
+	// построить контекст bign
+	code = bignCtxStart(st->bign, params);
+	ERR_CALL_CHECK(code);
+	ec = (const ec_o*)((const bign_ctx_st*)st->bign)->ec;
+	n = ec->f->n, no = ec->f->no;
+	// загрузить личный ключ
+	wwFrom(st->d, privkey, no);
+	// проверить сертификат и его открытый ключ
+	Q = (word*)stackCreate(bignCtxStack_keep(st->bign, bakeCtxStart_deep));
+	if (Q == 0)
+		return ERR_OUTOFMEMORY;
+	stack = Q + 2 * n;
+	code = bakeCertVal(Q, params, ec, cert->val, cert->data, cert->len,
+		stack);
+	stackClose(Q);
+	ERR_CALL_CHECK(code);
+	// сохранить сертификат
+	memCopy(st->cert, cert, sizeof(bake_cert));
+	return code;
+}
+
+static bool_t bakeCtxIsOperable(const void* ctx)
+{
+	const bake_ctx_st* st = (const bake_ctx_st*)ctx;
+	return memIsValid(ctx, sizeof(bake_ctx_st)) &&
+		bignCtxIsOperable(st->bign);
+}
+
 /*
 *******************************************************************************
 Шаги протокола BMQV
@@ -157,7 +458,7 @@ typedef struct
 {
 	obj_hdr_t hdr;				/*< заголовок */
 // ptr_table {
-	ec_o* ec;					/*< описание эллиптической кривой */
+	const ec_o* ec;					/*< описание эллиптической кривой */
 	word* d;					/*< [ec->f->n] долговременный личный ключ */
 	word* u;					/*< [ec->f->n] одноразовый личный ключ */
 	octet* Vb;					/*< [ec->f->no] ecX(Vb) */
@@ -181,7 +482,7 @@ size_t bakeBMQV_keep(size_t l)
 		O_OF_W(2 * n) + no;
 }
 
-err_t bakeBMQVStart(void* state, const bign_params* params,
+static err_t bakeBMQVStartInt(void* state, const bign_params* params,
 	const bake_settings* settings, const octet privkey[],
 	const bake_cert* cert)
 {
@@ -209,14 +510,14 @@ err_t bakeBMQVStart(void* state, const bign_params* params,
 	// загрузить параметры
 	code = bignStart(s->data, params);
 	ERR_CALL_CHECK(code);
-	s->ec = (ec_o*)s->data;
+	s->ec = (const ec_o*)s->data;
 	n = s->ec->f->n, no = s->ec->f->no;
 	// сохранить параметры
 	memCopy(s->params, params, sizeof(bign_params));
 	// сохранить настройки
 	memCopy(s->settings, settings, sizeof(bake_settings));
 	// настроить указатели
-	s->d = objEnd(s->ec, word);
+	s->d = objEnd(s->data, word);
 	s->u = s->d + n;
 	s->Vb = (octet*)(s->u + n);
 	// настроить заголовок
@@ -229,29 +530,108 @@ err_t bakeBMQVStart(void* state, const bign_params* params,
 	Q = objEnd(s, word);
 	stack = Q + 2 * n;
 	// проверить сертификат и его открытый ключ
-	code = cert->val((octet*)Q, params, cert->data, cert->len);
+	code = bakeCertVal(Q, params, s->ec, cert->val, cert->data, cert->len,
+		stack);
 	ERR_CALL_CHECK(code);
-	if (!qrFrom(ecX(Q), (octet*)Q, s->ec->f, stack) ||
-		!qrFrom(ecY(Q, n), (octet*)Q + no, s->ec->f, stack) ||
-		!ecpIsOnA(Q, s->ec, stack))
-		return ERR_BAD_CERT;
 	// сохранить сертификат
 	memCopy(s->cert, cert, sizeof(bake_cert));
 	// все нормально
 	return code;
 }
 
+err_t bakeBMQVStart(void* state, const bign_params* params,
+	const bake_settings* settings, const octet privkey[],
+	const bake_cert* cert)
+{
+	return tmTraceCall("bakeBMQVStart",
+		bakeBMQVStartInt(state, params, settings, privkey, cert));
+}
+
 static size_t bakeBMQVStart_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
-	return O_OF_W(2 * n) +
-		utilMax(2,
-			f_deep,
-			ecpIsOnA_deep(n, f_deep));
+	return O_OF_W(2 * n) + bakeCertVal_deep(n, f_deep);
 }
 
-err_t bakeBMQVStep2(octet out[], void* state)
+size_t bakeBMQV2_keep(const void* ctx)
+{
+	const bake_ctx_st* st = (const bake_ctx_st*)ctx;
+	const ec_o* ec;
+	ASSERT(bakeCtxIsOperable(ctx));
+	ec = (const ec_o*)((const bign_ctx_st*)st->bign)->ec;
+	return sizeof(bake_bmqv_o) + O_OF_W(2 * ec->f->n) + ec->f->no +
+		bignCtxStack_keep(st->bign, bakeBMQV_deep);
+}
+
+err_t bakeBMQVStart2(void* state, const void* ctx,
+	const bake_settings* settings)
 {
+	bake_bmqv_o* s = (bake_bmqv_o*)state;
+	const bake_ctx_st* st = (const bake_ctx_st*)ctx;
+	const bign_ctx_st* bign;
+	size_t n, no;
+	// проверить входные данные
+	if (!memIsValid(settings, sizeof(bake_settings)) ||
+		!memIsNullOrValid(settings->helloa, settings->helloa_len) ||
+		!memIsNullOrValid(settings->hellob, settings->hellob_len))
+		return ERR_BAD_INPUT;
+	if (settings->rng == 0)
+		return ERR_BAD_RNG;
+	if (!bakeCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	bign = (const bign_ctx_st*)st->bign;
+	// сослаться на описание кривой
+	s->ec = (const ec_o*)bign->ec;
+	n = s->ec->f->n, no = s->ec->f->no;
+	// сохранить параметры
+	memCopy(s->params, bign->params, sizeof(bign_params));
+	// сохранить настройки
+	memCopy(s->settings, settings, sizeof(bake_settings));
+	// настроить указатели
+	s->d = (word*)s->data;
+	s->u = s->d + n;
+	s->Vb = (octet*)(s->u + n);
+	// настроить заголовок
+	s->hdr.keep = sizeof(bake_bmqv_o) + O_OF_W(2 * n) + no;
+	s->hdr.p_count = 4;
+	s->hdr.o_count = 1;
+	// загрузить личный ключ
+	wwCopy(s->d, st->d, n);
+	// сохранить сертификат
+	memCopy(s->cert, st->cert, sizeof(bake_cert));
+	// все нормально
+	return ERR_OK;
+}
+
+/*
+	Пара (u, u G) берется из пула eph или (при eph == 0) строится на месте.
+	Пул должен соответствовать долговременным параметрам params.
+*/
+static err_t bakeEphPop(word u[], word V[], void* eph,
+	const bign_params* params, const ec_o* ec, const bake_settings* settings,
+	void* stack)
+{
+	if (eph)
+	{
+		if (!bignEphIsOperable(eph) ||
+			!memEq(((const bign_ctx_st*)bignEphCtx(eph))->params, params,
+				sizeof(bign_params)))
+			return ERR_BAD_INPUT;
+		return bignEphPop(u, V, eph, stack);
+	}
+	// u <-R {1, 2, ..., q - 1}
+	if (!zzRandNZMod(u, ec->order, ec->f->n, settings->rng,
+		settings->rng_state))
+		return ERR_BAD_RNG;
+	// V <- u G
+	if (!bignMulBase(V, params, ec, u, ec->f->n, stack))
+		return ERR_BAD_PARAMS;
+	return ERR_OK;
+}
+
+static err_t bakeBMQVStep2Int(octet out[], void* eph, void* state)
+{
+	err_t code;
 	bake_bmqv_o* s = (bake_bmqv_o*)state;
 	size_t n, no;
 	// стек
@@ -267,13 +647,9 @@ err_t bakeBMQVStep2(octet out[], void* state)
 	// раскладка стека
 	Vb = objEnd(s, word);
 	stack = Vb + 2 * n;
-	// ub <-R {1, 2, ..., q - 1}
-	if (!zzRandNZMod(s->u, s->ec->order, n, s->settings->rng,
-		s->settings->rng_state))
-		return ERR_BAD_RNG;
-	// Vb <- ub G
-	if (!ecMulA(Vb, s->ec->base, s->ec, s->u, n, stack))
-		return ERR_BAD_PARAMS;
+	// ub <-R {1, 2, ..., q - 1}, Vb <- ub G
+	code = bakeEphPop(s->u, Vb, eph, s->params, s->ec, s->settings, stack);
+	ERR_CALL_CHECK(code);
 	// out <- <Vb>
 	qrTo(out, ecX(Vb), s->ec->f, stack);
 	qrTo(out + no, ecY(Vb, n), s->ec->f, stack);
@@ -283,16 +659,28 @@ err_t bakeBMQVStep2(octet out[], void* state)
 	return ERR_OK;
 }
 
+err_t bakeBMQVStep2(octet out[], void* state)
+{
+	return tmTraceCall("bakeBMQVStep2", bakeBMQVStep2Int(out, 0, state));
+}
+
+err_t bakeBMQVStep2Eph(octet out[], void* eph, void* state)
+{
+	if (eph == 0)
+		return ERR_BAD_INPUT;
+	return tmTraceCall("bakeBMQVStep2Eph", bakeBMQVStep2Int(out, eph, state));
+}
+
 static size_t bakeBMQVStep2_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(2 * n) +
 		utilMax(2,
 			f_deep,
-			ecMulA_deep(n, ec_d, ec_deep, n));
+			ecMulACT_deep(n, ec_d, ec_deep));
 }
 
-err_t bakeBMQVStep3(octet out[], const octet in[], const bake_cert* certb,
+static err_t bakeBMQVStep3Int(octet out[], const octet in[], const bake_cert* certb,
 	void* state)
 {
 	err_t code;
@@ -332,12 +720,9 @@ err_t bakeBMQVStep3(octet out[], const octet in[], const bake_cert* certb,
 	block1 = block0 + 16;
 	ASSERT(block1 + 16 <= (octet*)stack);
 	// проверить certb
-	code = certb->val((octet*)Qb, s->params, certb->data, certb->len);
+	code = bakeCertVal(Qb, s->params, s->ec, certb->val, certb->data,
+		certb->len, stack);
 	ERR_CALL_CHECK(code);
-	if (!qrFrom(ecX(Qb), (octet*)Qb, s->ec->f, stack) ||
-		!qrFrom(ecY(Qb, n), (octet*)Qb + no, s->ec->f, stack) ||
-		!ecpIsOnA(Qb, s->ec, stack))
-		return ERR_BAD_CERT;
 	// Vb <- in, Vb \in E*?
 	if (!qrFrom(ecX(Vb), in, s->ec->f, stack) ||
 		!qrFrom(ecY(Vb, n), in + no, s->ec->f, stack) ||
@@ -348,7 +733,7 @@ err_t bakeBMQVStep3(octet out[], const octet in[], const bake_cert* certb,
 		s->settings->rng_state))
 		return ERR_BAD_RNG;
 	// Va <- ua G
-	if (!ecMulA(Va, s->ec->base, s->ec, s->u, n, stack))
+	if (!bignMulBase(Va, s->params, s->ec, s->u, n, stack))
 		return ERR_BAD_PARAMS;
 	qrTo((octet*)Va, ecX(Va), s->ec->f, stack);
 	qrTo((octet*)Va + no, ecY(Va, n), s->ec->f, stack);
@@ -363,7 +748,7 @@ err_t bakeBMQVStep3(octet out[], const octet in[], const bake_cert* certb,
 	// sa <- (ua - (2^l + t)da) \mod q
 	zzMul(sa, t, n / 2, s->d, n, stack);
 	sa[n + n / 2] = zzAdd2(sa + n / 2, s->d, n);
-	zzMod(sa, sa, n + n / 2 + 1, s->ec->order, n, stack);
+	bignModQ(sa, sa, n + n / 2 + 1, s->ec, stack);
 	zzSubMod(sa, s->u, sa, s->ec->order, n);
 	// K <- sa(Vb - (2^l + t)Qb), K == O => K <- G
 	t[n / 2] = 1;
@@ -373,7 +758,7 @@ err_t bakeBMQVStep3(octet out[], const octet in[], const bake_cert* certb,
 		qrTo(K, s->ec->base, s->ec->f, stack);
 	else
 	{
-		if (!ecMulA(Vb, Vb, s->ec, sa, n, stack))
+		if (!ecMulACT(Vb, Vb, s->ec, sa, n, stack))
 			return ERR_BAD_PARAMS;
 		qrTo(K, ecX(Vb), s->ec->f, stack);
 	}
@@ -410,23 +795,32 @@ err_t bakeBMQVStep3(octet out[], const octet in[], const bake_cert* certb,
 	return ERR_OK;
 }
 
+err_t bakeBMQVStep3(octet out[], const octet in[], const bake_cert* certb,
+	void* state)
+{
+	return tmTraceCall("bakeBMQVStep3",
+		bakeBMQVStep3Int(out, in, certb, state));
+}
+
 static size_t bakeBMQVStep3_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(8 * n + 2) +
-		utilMax(9,
+		utilMax(11,
 			f_deep,
 			ecpIsOnA_deep(n, f_deep),
+			bakeCertVal_deep(n, f_deep),
 			ecMulA_deep(n, ec_d, ec_deep, n),
+			ecMulACT_deep(n, ec_d, ec_deep),
 			beltHash_keep(),
 			zzMul_deep(n / 2, n),
-			zzMod_deep(n + n / 2 + 1, n),
+			bignModQ_deep(n),
 			ecpSubAA_deep(n, f_deep),
 			beltKRP_keep(),
 			beltMAC_keep());
 }
 
-err_t bakeBMQVStep4(octet out[], const octet in[], const bake_cert* certa,
+static err_t bakeBMQVStep4Int(octet out[], const octet in[], const bake_cert* certa,
 	void* state)
 {
 	err_t code;
@@ -463,12 +857,9 @@ err_t bakeBMQVStep4(octet out[], const octet in[], const bake_cert* certa,
 	block1 = block0 + 16;
 	ASSERT(block1 + 16 <= (octet*)stack);
 	// проверить certa
-	code = certa->val((octet*)Qa, s->params, certa->data, certa->len);
+	code = bakeCertVal(Qa, s->params, s->ec, certa->val, certa->data,
+		certa->len, stack);
 	ERR_CALL_CHECK(code);
-	if (!qrFrom(ecX(Qa), (octet*)Qa, s->ec->f, stack) ||
-		!qrFrom(ecY(Qa, n), (octet*)Qa + no, s->ec->f, stack) ||
-		!ecpIsOnA(Qa, s->ec, stack))
-		return ERR_BAD_CERT;
 	// Va <- in, Va \in E*?
 	if (!qrFrom(ecX(Va), in, s->ec->f, stack) ||
 		!qrFrom(ecY(Va, n), in + no, s->ec->f, stack) ||
@@ -483,7 +874,7 @@ err_t bakeBMQVStep4(octet out[], const octet in[], const bake_cert* certa,
 	// sb <- (ub - (2^l + t)db) \mod q
 	zzMul(sb, t, n / 2, s->d, n, stack);
 	sb[n + n / 2] = zzAdd2(sb + n / 2, s->d, n);
-	zzMod(sb, sb, n + n / 2 + 1, s->ec->order, n, stack);
+	bignModQ(sb, sb, n + n / 2 + 1, s->ec, stack);
 	zzSubMod(sb, s->u, sb, s->ec->order, n);
 	// K <- sb(Va - (2^l + t)Qa), K == O => K <- G
 	t[n / 2] = 1;
@@ -493,7 +884,7 @@ err_t bakeBMQVStep4(octet out[], const octet in[], const bake_cert* certa,
 		qrTo(K, s->ec->base, s->ec->f, stack);
 	else
 	{
-		if (!ecMulA(Va, Va, s->ec, sb, n, stack))
+		if (!ecMulACT(Va, Va, s->ec, sb, n, stack))
 			return ERR_BAD_PARAMS;
 		qrTo(K, ecX(Va), s->ec->f, stack);
 	}
@@ -538,23 +929,32 @@ err_t bakeBMQVStep4(octet out[], const octet in[], const bake_cert* certa,
 	return ERR_OK;
 }
 
+err_t bakeBMQVStep4(octet out[], const octet in[], const bake_cert* certa,
+	void* state)
+{
+	return tmTraceCall("bakeBMQVStep4",
+		bakeBMQVStep4Int(out, in, certa, state));
+}
+
 static size_t bakeBMQVStep4_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(6 * n + 2) +
-		utilMax(9,
+		utilMax(11,
 			f_deep,
 			ecpIsOnA_deep(n, f_deep),
+			bakeCertVal_deep(n, f_deep),
 			ecMulA_deep(n, ec_d, ec_deep, n),
+			ecMulACT_deep(n, ec_d, ec_deep),
 			beltHash_keep(),
 			zzMul_deep(n / 2, n),
-			zzMod_deep(n + n / 2 + 1, n),
+			bignModQ_deep(n),
 			ecpSubAA_deep(n, f_deep),
 			beltKRP_keep(),
 			beltMAC_keep());
 }
 
-err_t bakeBMQVStep5(const octet in[8], void* state)
+static err_t bakeBMQVStep5Int(const octet in[8], void* state)
 {
 	bake_bmqv_o* s = (bake_bmqv_o*)state;
 	// стек
@@ -580,6 +980,11 @@ err_t bakeBMQVStep5(const octet in[8], void* state)
 	return ERR_OK;
 }
 
+err_t bakeBMQVStep5(const octet in[8], void* state)
+{
+	return tmTraceCall("bakeBMQVStep5", bakeBMQVStep5Int(in, state));
+}
+
 static size_t bakeBMQVStep5_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
@@ -634,7 +1039,7 @@ err_t bakeBMQVRunB(octet key[32], const bign_params* params,
 	// создать блоб
 	if (params->l != 128 && params->l != 192 && params->l != 256)
 		return ERR_BAD_PARAMS;
-	blob = blobCreate(params->l + 8 + bakeBMQV_keep(params->l));
+	blob = stackCreate(params->l + 8 + bakeBMQV_keep(params->l));
 	if (blob == 0)
 		return ERR_OUTOFMEMORY;
 	// раскладка блоба
@@ -643,25 +1048,25 @@ err_t bakeBMQVRunB(octet key[32], const bign_params* params,
 	state = out + params->l / 2;
 	// старт
 	code = bakeBMQVStart(state, params, settings, privkeyb, certb);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 2
 	code = bakeBMQVStep2(out, state);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = write(&len, out, params->l / 2, file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 4
 	code = read(&len, in, params->l / 2 + (settings->kca ? 8u : 0), file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = bakeBMQVStep4(out, in, certa, state);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	if (settings->kcb)
 	{
 		code = write(&len, out, 8, file);
-		ERR_CALL_HANDLE(code, blobClose(blob));
+		ERR_CALL_HANDLE(code, stackClose(blob));
 	}
 	// завершение
 	code = bakeBMQVStepG(key, state);
-	blobClose(blob);
+	stackClose(blob);
 	return code;
 }
 
@@ -683,7 +1088,7 @@ err_t bakeBMQVRunA(octet key[32], const bign_params* params,
 	// создать блоб
 	if (params->l != 128 && params->l != 192 && params->l != 256)
 		return ERR_BAD_PARAMS;
-	blob = blobCreate(params->l + 8 + bakeBMQV_keep(params->l));
+	blob = stackCreate(params->l + 8 + bakeBMQV_keep(params->l));
 	if (blob == 0)
 		return ERR_OUTOFMEMORY;
 	// раскладка блоба
@@ -692,25 +1097,25 @@ err_t bakeBMQVRunA(octet key[32], const bign_params* params,
 	state = out + params->l / 2 + 8;
 	// старт
 	code = bakeBMQVStart(state, params, settings, privkeya, certa);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 3
 	code = read(&len, in, params->l / 2, file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = bakeBMQVStep3(out, in, certb, state);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = write(&len, out, params->l / 2 + (settings->kca ? 8u : 0), file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 5
 	if (settings->kcb)
 	{
 		code = read(&len, in, 8, file);
-		ERR_CALL_HANDLE(code, blobClose(blob));
+		ERR_CALL_HANDLE(code, stackClose(blob));
 		code = bakeBMQVStep5(in, state);
-		ERR_CALL_HANDLE(code, blobClose(blob));
+		ERR_CALL_HANDLE(code, stackClose(blob));
 	}
 	// завершение
 	code = bakeBMQVStepG(key, state);
-	blobClose(blob);
+	stackClose(blob);
 	return code;
 }
 
@@ -724,7 +1129,7 @@ typedef struct
 {
 	obj_hdr_t hdr;				/*< заголовок */
 // ptr_table {
-	ec_o* ec;					/*< описание эллиптической кривой */
+	const ec_o* ec;					/*< описание эллиптической кривой */
 	word* d;					/*< [ec->f->n] долговременный личный ключ */
 	word* u;					/*< [ec->f->n] одноразовый личный ключ */
 	word* t;					/*< [ec->f->n / 2 + 1] t (совпадает с u) */
@@ -749,7 +1154,7 @@ size_t bakeBSTS_keep(size_t l)
 		O_OF_W(4 * n);
 }
 
-err_t bakeBSTSStart(void* state, const bign_params* params,
+static err_t bakeBSTSStartInt(void* state, const bign_params* params,
 	const bake_settings* settings, const octet privkey[],
 	const bake_cert* cert)
 {
@@ -778,14 +1183,14 @@ err_t bakeBSTSStart(void* state, const bign_params* params,
 	// загрузить параметры
 	code = bignStart(s->data, params);
 	ERR_CALL_CHECK(code);
-	s->ec = (ec_o*)s->data;
+	s->ec = (const ec_o*)s->data;
 	n = s->ec->f->n, no = s->ec->f->no;
 	// сохранить параметры
 	memCopy(s->params, params, sizeof(bign_params));
 	// сохранить настройки
 	memCopy(s->settings, settings, sizeof(bake_settings));
 	// настроить указатели
-	s->d = objEnd(s->ec, word);
+	s->d = objEnd(s->data, word);
 	s->u = s->d + n;
 	s->t = s->u;
 	s->Vb = s->u + n;
@@ -799,28 +1204,84 @@ err_t bakeBSTSStart(void* state, const bign_params* params,
 	stack = objEnd(s, void);
 	// проверить сертификат и его открытый ключ
 	Q = s->Vb;
-	code = cert->val((octet*)Q, params, cert->data, cert->len);
+	code = bakeCertVal(Q, params, s->ec, cert->val, cert->data, cert->len,
+		stack);
 	ERR_CALL_CHECK(code);
-	if (!qrFrom(ecX(Q), (octet*)Q, s->ec->f, stack) ||
-		!qrFrom(ecY(Q, n), (octet*)Q + no, s->ec->f, stack) ||
-		!ecpIsOnA(Q, s->ec, stack))
-		return ERR_BAD_CERT;
 	// сохранить сертификат
 	memCopy(s->cert, cert, sizeof(bake_cert));
 	// все нормально
 	return code;
 }
 
+err_t bakeBSTSStart(void* state, const bign_params* params,
+	const bake_settings* settings, const octet privkey[],
+	const bake_cert* cert)
+{
+	return tmTraceCall("bakeBSTSStart",
+		bakeBSTSStartInt(state, params, settings, privkey, cert));
+}
+
 static size_t bakeBSTSStart_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
-	return utilMax(2,
-			f_deep,
-			ecpIsOnA_deep(n, f_deep));
+	return bakeCertVal_deep(n, f_deep);
 }
 
-err_t bakeBSTSStep2(octet out[], void* state)
+size_t bakeBSTS2_keep(const void* ctx)
 {
+	const bake_ctx_st* st = (const bake_ctx_st*)ctx;
+	const ec_o* ec;
+	ASSERT(bakeCtxIsOperable(ctx));
+	ec = (const ec_o*)((const bign_ctx_st*)st->bign)->ec;
+	return sizeof(bake_bsts_o) + O_OF_W(4 * ec->f->n) +
+		bignCtxStack_keep(st->bign, bakeBSTS_deep);
+}
+
+err_t bakeBSTSStart2(void* state, const void* ctx,
+	const bake_settings* settings)
+{
+	bake_bsts_o* s = (bake_bsts_o*)state;
+	const bake_ctx_st* st = (const bake_ctx_st*)ctx;
+	const bign_ctx_st* bign;
+	size_t n;
+	// проверить входные данные
+	if (!memIsValid(settings, sizeof(bake_settings)) ||
+		settings->kca != TRUE || settings->kcb != TRUE ||
+		!memIsNullOrValid(settings->helloa, settings->helloa_len) ||
+		!memIsNullOrValid(settings->hellob, settings->hellob_len))
+		return ERR_BAD_INPUT;
+	if (settings->rng == 0)
+		return ERR_BAD_RNG;
+	if (!bakeCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	bign = (const bign_ctx_st*)st->bign;
+	// сослаться на описание кривой
+	s->ec = (const ec_o*)bign->ec;
+	n = s->ec->f->n;
+	// сохранить параметры
+	memCopy(s->params, bign->params, sizeof(bign_params));
+	// сохранить настройки
+	memCopy(s->settings, settings, sizeof(bake_settings));
+	// настроить указатели
+	s->d = (word*)s->data;
+	s->u = s->d + n;
+	s->t = s->u;
+	s->Vb = s->u + n;
+	// настроить заголовок
+	s->hdr.keep = sizeof(bake_bsts_o) + O_OF_W(4 * n);
+	s->hdr.p_count = 5;
+	s->hdr.o_count = 1;
+	// загрузить личный ключ
+	wwCopy(s->d, st->d, n);
+	// сохранить сертификат
+	memCopy(s->cert, st->cert, sizeof(bake_cert));
+	// все нормально
+	return ERR_OK;
+}
+
+static err_t bakeBSTSStep2Int(octet out[], void* eph, void* state)
+{
+	err_t code;
 	bake_bsts_o* s = (bake_bsts_o*)state;
 	size_t n, no;
 	// стек
@@ -833,13 +1294,10 @@ err_t bakeBSTSStep2(octet out[], void* state)
 		return ERR_BAD_INPUT;
 	// раскладка стека
 	stack = objEnd(s, void);
-	// ub <-R {1, 2, ..., q - 1}
-	if (!zzRandNZMod(s->u, s->ec->order, n, s->settings->rng,
-		s->settings->rng_state))
-		return ERR_BAD_RNG;
-	// Vb <- ub G
-	if (!ecMulA(s->Vb, s->ec->base, s->ec, s->u, n, stack))
-		return ERR_BAD_PARAMS;
+	// ub <-R {1, 2, ..., q - 1}, Vb <- ub G
+	code = bakeEphPop(s->u, s->Vb, eph, s->params, s->ec, s->settings,
+		stack);
+	ERR_CALL_CHECK(code);
 	// out <- <Vb>
 	qrTo(out, ecX(s->Vb), s->ec->f, stack);
 	qrTo(out + no, ecY(s->Vb, n), s->ec->f, stack);
@@ -847,15 +1305,27 @@ err_t bakeBSTSStep2(octet out[], void* state)
 	return ERR_OK;
 }
 
+err_t bakeBSTSStep2(octet out[], void* state)
+{
+	return tmTraceCall("bakeBSTSStep2", bakeBSTSStep2Int(out, 0, state));
+}
+
+err_t bakeBSTSStep2Eph(octet out[], void* eph, void* state)
+{
+	if (eph == 0)
+		return ERR_BAD_INPUT;
+	return tmTraceCall("bakeBSTSStep2Eph", bakeBSTSStep2Int(out, eph, state));
+}
+
 static size_t bakeBSTSStep2_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return utilMax(2,
 			f_deep,
-			ecMulA_deep(n, ec_d, ec_deep, n));
+			ecMulACT_deep(n, ec_d, ec_deep));
 }
 
-err_t bakeBSTSStep3(octet out[], const octet in[], void* state)
+static err_t bakeBSTSStep3Int(octet out[], const octet in[], void* state)
 {
 	bake_bsts_o* s = (bake_bsts_o*)state;
 	size_t n, no;
@@ -893,7 +1363,7 @@ err_t bakeBSTSStep3(octet out[], const octet in[], void* state)
 		s->settings->rng_state))
 		return ERR_BAD_RNG;
 	// Va <- ua G
-	if (!ecMulA(Va, s->ec->base, s->ec, s->u, n, stack))
+	if (!bignMulBase(Va, s->params, s->ec, s->u, n, stack))
 		return ERR_BAD_PARAMS;
 	qrTo((octet*)Va, ecX(Va), s->ec->f, stack);
 	qrTo((octet*)Va + no, ecY(Va, n), s->ec->f, stack);
@@ -908,13 +1378,13 @@ err_t bakeBSTSStep3(octet out[], const octet in[], void* state)
 	// sa <- (ua - (2^l + t)da) \mod q
 	zzMul(sa, t, n / 2, s->d, n, stack);
 	sa[n + n / 2] = zzAdd2(sa + n / 2, s->d, n);
-	zzMod(sa, sa, n + n / 2 + 1, s->ec->order, n, stack);
+	bignModQ(sa, sa, n + n / 2 + 1, s->ec, stack);
 	zzSubMod(sa, s->u, sa, s->ec->order, n);
 	// ..|| out ||.. <- sa || certa
 	wwTo(out + 2 * no, no, sa);
 	memCopy(out + 3 * no, s->cert->data, s->cert->len);
 	// K <- beltHash(<ua Vb>_2l || helloa || hellob)
-	if (!ecMulA(Va, s->Vb, s->ec, s->u, n, stack))
+	if (!ecMulACT(Va, s->Vb, s->ec, s->u, n, stack))
 		return ERR_BAD_PARAMS;
 	qrTo(K, ecX(Va), s->ec->f, stack);
 	beltHashStart(stack);
@@ -951,6 +1421,11 @@ err_t bakeBSTSStep3(octet out[], const octet in[], void* state)
 	return ERR_OK;
 }
 
+err_t bakeBSTSStep3(octet out[], const octet in[], void* state)
+{
+	return tmTraceCall("bakeBSTSStep3", bakeBSTSStep3Int(out, in, state));
+}
+
 static size_t bakeBSTSStep3_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
@@ -958,16 +1433,16 @@ static size_t bakeBSTSStep3_deep(size_t n, size_t f_deep, size_t ec_d,
 		utilMax(9,
 			f_deep,
 			ecpIsOnA_deep(n, f_deep),
-			ecMulA_deep(n, ec_d, ec_deep, n),
+			ecMulACT_deep(n, ec_d, ec_deep),
 			beltHash_keep(),
 			zzMul_deep(n / 2, n),
-			zzMod_deep(n + n / 2 + 1, n),
+			bignModQ_deep(n),
 			beltKRP_keep(),
 			beltCFB_keep(),
 			beltMAC_keep());
 }
 
-err_t bakeBSTSStep4(octet out[], const octet in[], size_t in_len,
+static err_t bakeBSTSStep4Int(octet out[], const octet in[], size_t in_len,
 	bake_certval_i vala, void* state)
 {
 	err_t code;
@@ -1008,7 +1483,7 @@ err_t bakeBSTSStep4(octet out[], const octet in[], size_t in_len,
 		!ecpIsOnA(Va, s->ec, stack))
 		return ERR_BAD_POINT;
 	// K <- beltHash(<ub Va>_2l || helloa || hellob)
-	if (!ecMulA(Qa, Va, s->ec, s->u, n, stack))
+	if (!ecMulACT(Qa, Va, s->ec, s->u, n, stack))
 		return ERR_BAD_PARAMS;
 	qrTo(K, ecX(Qa), s->ec->f, stack);
 	beltHashStart(stack);
@@ -1041,7 +1516,7 @@ err_t bakeBSTSStep4(octet out[], const octet in[], size_t in_len,
 	{
 		blob_t Ya;
 		// sa || certa <- beltCFBDecr(Ya, K2, 0^128)
-		if ((Ya = blobCreate(in_len)) == 0)
+		if ((Ya = stackCreate(in_len)) == 0)
 			return ERR_OUTOFMEMORY;
 		memCopy(Ya, in + 2 * no, in_len);
 		beltCFBStart(stack, s->K2, 32, block0);
@@ -1050,17 +1525,13 @@ err_t bakeBSTSStep4(octet out[], const octet in[], size_t in_len,
 		wwFrom(sa, Ya, no);
 		if (wwCmp(sa, s->ec->order, n) >= 0)
 		{
-			blobClose(Ya);
+			stackClose(Ya);
 			return ERR_AUTH;
 		}
 		// проверить certa
-		code = vala((octet*)Qa, s->params, (octet*)Ya + no, in_len - no);
-		ERR_CALL_HANDLE(code, blobClose(Ya));
-		if (!qrFrom(ecX(Qa), (octet*)Qa, s->ec->f, stack) ||
-			!qrFrom(ecY(Qa, n), (octet*)Qa + no, s->ec->f, stack) ||
-			!ecpIsOnA(Qa, s->ec, stack))
-			code = ERR_BAD_CERT;
-		blobClose(Ya);
+		code = bakeCertVal(Qa, s->params, s->ec, vala, (octet*)Ya + no,
+			in_len - no, stack);
+		stackClose(Ya);
 		ERR_CALL_CHECK(code);
 	}
 	// t <- <beltHash(<Va>_2l || <Vb>_2l)>_l
@@ -1072,14 +1543,15 @@ err_t bakeBSTSStep4(octet out[], const octet in[], size_t in_len,
 	wwFrom(t, t, no / 2);
 	// sa G + (2^l + t)Qa == Va?
 	t[n / 2] = 1;
-	if (!ecAddMulA(Qa, s->ec, stack, 2, s->ec->base, sa, n, Qa, t, n / 2 + 1))
+	if (!bignAddMulBase(Qa, s->params, s->ec, sa, n, Qa, t, n / 2 + 1,
+		stack))
 		return ERR_BAD_PARAMS;
 	if (!wwEq(Qa, Va, 2 * n))
 		return ERR_AUTH;
 	// sb <- (ub - (2^l + t)db) \mod q
 	zzMul(sb, t, n / 2, s->d, n, stack);
 	sb[n + n / 2] = zzAdd2(sb + n / 2, s->d, n);
-	zzMod(sb, sb, n + n / 2 + 1, s->ec->order, n, stack);
+	bignModQ(sb, sb, n + n / 2 + 1, s->ec, stack);
 	zzSubMod(sb, s->u, sb, s->ec->order, n);
 	// out ||.. <- beltCFBEncr(sb || certb)
 	wwTo(out, no, sb);
@@ -1095,24 +1567,32 @@ err_t bakeBSTSStep4(octet out[], const octet in[], size_t in_len,
 	return ERR_OK;
 }
 
+err_t bakeBSTSStep4(octet out[], const octet in[], size_t in_len,
+	bake_certval_i vala, void* state)
+{
+	return tmTraceCall("bakeBSTSStep4",
+		bakeBSTSStep4Int(out, in, in_len, vala, state));
+}
+
 static size_t bakeBSTSStep4_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(6 * n + 2) + 32 +
-		utilMax(10,
+		utilMax(11,
 			f_deep,
 			ecpIsOnA_deep(n, f_deep),
-			ecMulA_deep(n, ec_d, ec_deep, n),
+			bakeCertVal_deep(n, f_deep),
+			ecMulACT_deep(n, ec_d, ec_deep),
 			beltHash_keep(),
 			zzMul_deep(n / 2, n),
-			zzMod_deep(n + n / 2 + 1, n),
-			ecAddMulA_deep(n, ec_d, ec_deep, 2, n, n / 2 + 1),
+			bignModQ_deep(n),
+			bignAddMulBase_deep(n, ec_d, ec_deep, n / 2 + 1),
 			beltKRP_keep(),
 			beltCFB_keep(),
 			beltMAC_keep());
 }
 
-err_t bakeBSTSStep5(const octet in[], size_t in_len, bake_certval_i valb,
+static err_t bakeBSTSStep5Int(const octet in[], size_t in_len, bake_certval_i valb,
 	void* state)
 {
 	err_t code;
@@ -1148,7 +1628,7 @@ err_t bakeBSTSStep5(const octet in[], size_t in_len, bake_certval_i valb,
 	{
 		blob_t Yb;
 		// sb || certb <- beltCFBDecr(Yb, K2, 1^128)
-		if ((Yb = blobCreate(in_len)) == 0)
+		if ((Yb = stackCreate(in_len)) == 0)
 			return ERR_OUTOFMEMORY;
 		memCopy(Yb, in, in_len);
 		beltCFBStart(stack, s->K2, 32, block1);
@@ -1157,22 +1637,18 @@ err_t bakeBSTSStep5(const octet in[], size_t in_len, bake_certval_i valb,
 		wwFrom(sb, Yb, no);
 		if (wwCmp(sb, s->ec->order, n) >= 0)
 		{
-			blobClose(Yb);
+			stackClose(Yb);
 			return ERR_AUTH;
 		}
 		// проверить certa
-		code = valb((octet*)Qb, s->params, (octet*)Yb + no, in_len - no);
-		ERR_CALL_HANDLE(code, blobClose(Yb));
-		if (!qrFrom(ecX(Qb), (octet*)Qb, s->ec->f, stack) ||
-			!qrFrom(ecY(Qb, n), (octet*)Qb + no, s->ec->f, stack) ||
-			!ecpIsOnA(Qb, s->ec, stack))
-			code = ERR_BAD_CERT;
-		blobClose(Yb);
+		code = bakeCertVal(Qb, s->params, s->ec, valb, (octet*)Yb + no,
+			in_len - no, stack);
+		stackClose(Yb);
 		ERR_CALL_CHECK(code);
 	}
 	// sb G + (2^l + t)Qa == Vb?
-	if (!ecAddMulA(Qb, s->ec, stack, 2, s->ec->base, sb, n,
-		Qb, s->t, n / 2 + 1))
+	if (!bignAddMulBase(Qb, s->params, s->ec, sb, n, Qb, s->t, n / 2 + 1,
+		stack))
 		return ERR_BAD_PARAMS;
 	if (!wwEq(Qb, s->Vb, 2 * n))
 		return ERR_AUTH;
@@ -1180,16 +1656,22 @@ err_t bakeBSTSStep5(const octet in[], size_t in_len, bake_certval_i valb,
 	return ERR_OK;
 }
 
+err_t bakeBSTSStep5(const octet in[], size_t in_len, bake_certval_i valb,
+	void* state)
+{
+	return tmTraceCall("bakeBSTSStep5",
+		bakeBSTSStep5Int(in, in_len, valb, state));
+}
+
 static size_t bakeBSTSStep5_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(3 * n) +
-		utilMax(5,
+		utilMax(4,
 			beltMAC_keep(),
 			beltCFB_keep(),
-			f_deep,
-			ecpIsOnA_deep(n, f_deep),
-			ecAddMulA_deep(n, ec_d, ec_deep, 2, n, n / 2 + 1));
+			bakeCertVal_deep(n, f_deep),
+			bignAddMulBase_deep(n, ec_d, ec_deep, n / 2 + 1));
 }
 
 err_t bakeBSTSStepG(octet key[32], void* state)
@@ -1241,7 +1723,7 @@ err_t bakeBSTSRunB(octet key[32], const bign_params* params,
 	// создать блоб
 	if (params->l != 128 && params->l != 192 && params->l != 256)
 		return ERR_BAD_PARAMS;
-	blob = blobCreate(512 +
+	blob = stackCreate(512 +
 		MAX2(params->l / 2, params->l / 4 + certb->len + 8) +
 		bakeBSTS_keep(params->l));
 	if (blob == 0)
@@ -1252,26 +1734,26 @@ err_t bakeBSTSRunB(octet key[32], const bign_params* params,
 	state = out + MAX2(params->l / 2, params->l / 4 + certb->len + 8);
 	// старт
 	code = bakeBSTSStart(state, params, settings, privkeyb, certb);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 2
 	code = bakeBSTSStep2(out, state);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = write(&len, out, params->l / 2, file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 4: прочитать блок M2
 	code = read(&len, in, 512, file);
 	// шаг 4: M2 из одного блока?
 	if (code == ERR_MAX)
 	{
 		code = bakeBSTSStep4(out, in, len, vala, state);
-		ERR_CALL_HANDLE(code, blobClose(blob));
+		ERR_CALL_HANDLE(code, stackClose(blob));
 		code = write(&len, out, params->l / 4 + certb->len + 8, file);
-		ERR_CALL_HANDLE(code, blobClose(blob));
+		ERR_CALL_HANDLE(code, stackClose(blob));
 	}
 	// шаг 4: ошибка при чтении
 	else if (code != ERR_OK)
 	{
-		blobClose(blob);
+		stackClose(blob);
 		return code;
 	}
 	// шаг 4: обработать M2 из нескольких блоков
@@ -1282,7 +1764,7 @@ err_t bakeBSTSRunB(octet key[32], const bign_params* params,
 		{
 			if ((M2 = blobResize(M2, blobSize(M2) + len)) == 0)
 			{
-				blobClose(blob);
+				stackClose(blob);
 				return ERR_OUTOFMEMORY;
 			}
 			memCopy((octet*)M2 + blobSize(M2) - len, in, len);
@@ -1291,24 +1773,24 @@ err_t bakeBSTSRunB(octet key[32], const bign_params* params,
 		if (code != ERR_MAX)
 		{
 			blobClose(M2);
-			blobClose(blob);
+			stackClose(blob);
 			return code;
 		}
 		if ((M2 = blobResize(M2, blobSize(M2) + len)) == 0)
 		{
-			blobClose(blob);
+			stackClose(blob);
 			return ERR_OUTOFMEMORY;
 		}
 		memCopy((octet*)M2 + blobSize(M2) - len, in, len);
 		code = bakeBSTSStep4(out, M2, blobSize(M2), vala, state);
 		blobClose(M2);
-		ERR_CALL_HANDLE(code, blobClose(blob));
+		ERR_CALL_HANDLE(code, stackClose(blob));
 		code = write(&len, out, params->l / 4 + certb->len + 8, file);
-		ERR_CALL_HANDLE(code, blobClose(blob));
+		ERR_CALL_HANDLE(code, stackClose(blob));
 	}
 	// завершение
 	code = bakeBSTSStepG(key, state);
-	blobClose(blob);
+	stackClose(blob);
 	return code;
 }
 
@@ -1331,7 +1813,7 @@ err_t bakeBSTSRunA(octet key[32], const bign_params* params,
 	// создать блоб
 	if (params->l != 128 && params->l != 192 && params->l != 256)
 		return ERR_BAD_PARAMS;
-	blob = blobCreate(MAX2(512, params->l / 2) + 3 * params->l / 4 +
+	blob = stackCreate(MAX2(512, params->l / 2) + 3 * params->l / 4 +
 		certa->len + 8 + bakeBSTS_keep(params->l));
 	if (blob == 0)
 		return ERR_OUTOFMEMORY;
@@ -1341,26 +1823,26 @@ err_t bakeBSTSRunA(octet key[32], const bign_params* params,
 	state = out + 3 * params->l / 4 + certa->len + 8;
 	// старт
 	code = bakeBSTSStart(state, params, settings, privkeya, certa);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 3
 	code = read(&len, in, params->l / 2, file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = bakeBSTSStep3(out, in, state);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = write(&len, out, 3 * params->l / 4 + certa->len + 8, file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 5: прочитать блок M3
 	code = read(&len, in, 512, file);
 	// шаг 5: M3 из одного блока?
 	if (code == ERR_MAX)
 	{
 		code = bakeBSTSStep5(in, len, valb, state);
-		ERR_CALL_HANDLE(code, blobClose(blob));
+		ERR_CALL_HANDLE(code, stackClose(blob));
 	}
 	// шаг 5: ошибка при чтении
 	else if (code != ERR_OK)
 	{
-		blobClose(blob);
+		stackClose(blob);
 		return code;
 	}
 	// шаг 5: обработать M3 из нескольких блоков
@@ -1371,7 +1853,7 @@ err_t bakeBSTSRunA(octet key[32], const bign_params* params,
 		{
 			if ((M3 = blobResize(M3, blobSize(M3) + len)) == 0)
 			{
-				blobClose(blob);
+				stackClose(blob);
 				return ERR_OUTOFMEMORY;
 			}
 			memCopy((octet*)M3 + blobSize(M3) - len, in, len);
@@ -1380,22 +1862,22 @@ err_t bakeBSTSRunA(octet key[32], const bign_params* params,
 		if (code != ERR_MAX)
 		{
 			blobClose(M3);
-			blobClose(blob);
+			stackClose(blob);
 			return code;
 		}
 		if ((M3 = blobResize(M3, blobSize(M3) + len)) == 0)
 		{
-			blobClose(blob);
+			stackClose(blob);
 			return ERR_OUTOFMEMORY;
 		}
 		memCopy((octet*)M3 + blobSize(M3) - len, in, len);
 		code = bakeBSTSStep5(M3, blobSize(M3), valb, state);
 		blobClose(M3);
-		ERR_CALL_HANDLE(code, blobClose(blob));
+		ERR_CALL_HANDLE(code, stackClose(blob));
 	}
 	// завершение
 	code = bakeBSTSStepG(key, state);
-	blobClose(blob);
+	stackClose(blob);
 	return code;
 }
 
@@ -1409,7 +1891,7 @@ typedef struct
 {
 	obj_hdr_t hdr;				/*< заголовок */
 // ptr_table {
-	ec_o* ec;					/*< описание эллиптической кривой */
+	const ec_o* ec;					/*< описание эллиптической кривой */
 	octet* R;					/*< [ec->f->no](Ra || Rb или ecX(Va)) */
 	word* W;					/*< [2 * ec->f->n] точка W */
 	word* u;					/*< [ec->f->n] ua или ub */
@@ -1432,7 +1914,7 @@ size_t bakeBPACE_keep(size_t l)
 		no + O_OF_W(3 * n);
 }
 
-err_t bakeBPACEStart(void* state, const bign_params* params,
+static err_t bakeBPACEStartInt(void* state, const bign_params* params,
 	const bake_settings* settings, const octet pwd[], size_t pwd_len)
 {
 	err_t code;
@@ -1452,12 +1934,12 @@ err_t bakeBPACEStart(void* state, const bign_params* params,
 	// загрузить параметры
 	code = bignStart(s->data, params);
 	ERR_CALL_CHECK(code);
-	s->ec = (ec_o*)s->data;
+	s->ec = (const ec_o*)s->data;
 	n = s->ec->f->n, no = s->ec->f->no;
 	// загрузить настройки
 	memCopy(s->settings, settings, sizeof(bake_settings));
 	// настроить указатели
-	s->R = objEnd(s->ec, octet);
+	s->R = objEnd(s->data, octet);
 	s->W = (word*)(s->R + no);
 	s->u = s->W + 2 * n;
 	// настроить заголовок
@@ -1472,13 +1954,112 @@ err_t bakeBPACEStart(void* state, const bign_params* params,
 	return code;
 }
 
+err_t bakeBPACEStart(void* state, const bign_params* params,
+	const bake_settings* settings, const octet pwd[], size_t pwd_len)
+{
+	return tmTraceCall("bakeBPACEStart",
+		bakeBPACEStartInt(state, params, settings, pwd, pwd_len));
+}
+
 static size_t bakeBPACEStart_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return beltHash_keep();
 }
 
-err_t bakeBPACEStep2(octet out[], void* state)
+/*
+*******************************************************************************
+Контекст BPACE
+
+Контекст содержит ключ K2 = beltHash(pwd) и контекст bign. Точка W
+зависит от одноразовых Ra, Rb и кэшированию не подлежит.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	octet K2[32];				/*< ключ K2 */
+	octet bign[];				/*< контекст bign */
+} bake_bpace_ctx_st;
+
+size_t bakeBPACECtx_keep(size_t l)
+{
+	return sizeof(bake_bpace_ctx_st) + bignCtx_keep(l);
+}
+
+err_t bakeBPACECtxStart(void* ctx, const bign_params* params,
+	const octet pwd[], size_t pwd_len)
+{
+	err_t code;
+	bake_bpace_ctx_st* st = (bake_bpace_ctx_st*)ctx;
+	void* stack;
+	// проверить входные данные
+	if (!memIsValid(params, sizeof(bign_params)))
+		return ERR_BAD_INPUT;
+	if (!bignIsOperable(params))
+		return ERR_BAD_PARAMS;
+	if (!memIsValid(ctx, bakeBPACECtx_keep(params->l)) ||
+		!memIsValid(pwd, pwd_len))
+		return ERR_BAD_INPUT;
+	// построить контекст bign
+	code = bignCtxStart(st->bign, params);
+	ERR_CALL_CHECK(code);
+	// K2 <- beltHash(pwd)
+	if ((stack = stackCreate(beltHash_keep())) == 0)
+		return ERR_OUTOFMEMORY;
+	beltHashStart(stack);
+	beltHashStepH(pwd, pwd_len, stack);
+	beltHashStepG(st->K2, stack);
+	stackClose(stack);
+	return code;
+}
+
+size_t bakeBPACE2_keep(const void* ctx)
+{
+	const bake_bpace_ctx_st* st = (const bake_bpace_ctx_st*)ctx;
+	const ec_o* ec;
+	ASSERT(bignCtxIsOperable(st->bign));
+	ec = (const ec_o*)((const bign_ctx_st*)st->bign)->ec;
+	return sizeof(bake_bpace_o) + ec->f->no + O_OF_W(3 * ec->f->n) +
+		bignCtxStack_keep(st->bign, bakeBPACE_deep);
+}
+
+err_t bakeBPACEStart2(void* state, const void* ctx,
+	const bake_settings* settings)
+{
+	bake_bpace_o* s = (bake_bpace_o*)state;
+	const bake_bpace_ctx_st* st = (const bake_bpace_ctx_st*)ctx;
+	size_t n, no;
+	// проверить входные данные
+	if (!memIsValid(settings, sizeof(bake_settings)) ||
+		!memIsNullOrValid(settings->helloa, settings->helloa_len) ||
+		!memIsNullOrValid(settings->hellob, settings->hellob_len))
+		return ERR_BAD_INPUT;
+	if (settings->rng == 0)
+		return ERR_BAD_RNG;
+	if (!memIsValid(ctx, sizeof(bake_bpace_ctx_st)) ||
+		!bignCtxIsOperable(st->bign))
+		return ERR_BAD_INPUT;
+	// сослаться на описание кривой
+	s->ec = (const ec_o*)((const bign_ctx_st*)st->bign)->ec;
+	n = s->ec->f->n, no = s->ec->f->no;
+	// загрузить настройки
+	memCopy(s->settings, settings, sizeof(bake_settings));
+	// настроить указатели
+	s->R = (octet*)s->data;
+	s->W = (word*)(s->R + no);
+	s->u = s->W + 2 * n;
+	// настроить заголовок
+	s->hdr.keep = sizeof(bake_bpace_o) + no + O_OF_W(3 * n);
+	s->hdr.p_count = 4;
+	s->hdr.o_count = 1;
+	// K2 <- K2 контекста
+	memCopy(s->K2, st->K2, 32);
+	// все нормально
+	return ERR_OK;
+}
+
+static err_t bakeBPACEStep2Int(octet out[], void* state)
 {
 	bake_bpace_o* s = (bake_bpace_o*)state;
 	size_t no;
@@ -1502,13 +2083,18 @@ err_t bakeBPACEStep2(octet out[], void* state)
 	return ERR_OK;
 }
 
+err_t bakeBPACEStep2(octet out[], void* state)
+{
+	return tmTraceCall("bakeBPACEStep2", bakeBPACEStep2Int(out, state));
+}
+
 static size_t bakeBPACEStep2_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return beltECB_keep();
 }
 
-err_t bakeBPACEStep3(octet out[], const octet in[], void* state)
+static err_t bakeBPACEStep3Int(octet out[], const octet in[], void* state)
 {
 	bake_bpace_o* s = (bake_bpace_o*)state;
 	size_t n, no;
@@ -1543,7 +2129,7 @@ err_t bakeBPACEStep3(octet out[], const octet in[], void* state)
 		s->settings->rng_state))
 		return ERR_BAD_RNG;
 	// Va <- ua W
-	if (!ecMulA(Va, s->W, s->ec, s->u, n, stack))
+	if (!ecMulACT(Va, s->W, s->ec, s->u, n, stack))
 		return ERR_BAD_PARAMS;
 	// ...|| out <- <Va>
 	qrTo(out + no / 2, ecX(Va), s->ec->f, stack);
@@ -1554,6 +2140,11 @@ err_t bakeBPACEStep3(octet out[], const octet in[], void* state)
 	return ERR_OK;
 }
 
+err_t bakeBPACEStep3(octet out[], const octet in[], void* state)
+{
+	return tmTraceCall("bakeBPACEStep3", bakeBPACEStep3Int(out, in, state));
+}
+
 static size_t bakeBPACEStep3_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
@@ -1561,11 +2152,11 @@ static size_t bakeBPACEStep3_deep(size_t n, size_t f_deep, size_t ec_d,
 		utilMax(4,
 			beltECB_keep(),
 			bakeSWU2_deep(n, f_deep, ec_d, ec_deep),
-			ecMulA_deep(n, ec_d, ec_deep, n),
+			ecMulACT_deep(n, ec_d, ec_deep),
 			f_deep);
 }
 
-err_t bakeBPACEStep4(octet out[], const octet in[], void* state)
+static err_t bakeBPACEStep4Int(octet out[], const octet in[], void* state)
 {
 	bake_bpace_o* s = (bake_bpace_o*)state;
 	size_t n, no;
@@ -1610,11 +2201,11 @@ err_t bakeBPACEStep4(octet out[], const octet in[], void* state)
 		s->settings->rng_state))
 		return ERR_BAD_RNG;
 	// K <- ub Va
-	if (!ecMulA(K, Va, s->ec, s->u, n, stack))
+	if (!ecMulACT(K, Va, s->ec, s->u, n, stack))
 		return ERR_BAD_PARAMS;
 	qrTo((octet*)K, ecX(K), s->ec->f, stack);
 	// Vb <- ub W
-	if (!ecMulA(Vb, s->W, s->ec, s->u, n, stack))
+	if (!ecMulACT(Vb, s->W, s->ec, s->u, n, stack))
 		return ERR_BAD_PARAMS;
 	qrTo((octet*)ecX(Vb), ecX(Vb), s->ec->f, stack);
 	qrTo((octet*)ecY(Vb, n), ecY(Vb, n), s->ec->f, stack);
@@ -1653,6 +2244,11 @@ err_t bakeBPACEStep4(octet out[], const octet in[], void* state)
 	return ERR_OK;
 }
 
+err_t bakeBPACEStep4(octet out[], const octet in[], void* state)
+{
+	return tmTraceCall("bakeBPACEStep4", bakeBPACEStep4Int(out, in, state));
+}
+
 static size_t bakeBPACEStep4_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
@@ -1661,13 +2257,13 @@ static size_t bakeBPACEStep4_deep(size_t n, size_t f_deep, size_t ec_d,
 			f_deep,
 			beltECB_keep(),
 			bakeSWU2_deep(n, f_deep, ec_d, ec_deep),
-			ecMulA_deep(n, ec_d, ec_deep, n),
+			ecMulACT_deep(n, ec_d, ec_deep),
 			beltHash_keep(),
 			beltKRP_keep(),
 			beltMAC_keep());
 }
 
-err_t bakeBPACEStep5(octet out[], const octet in[], void* state)
+static err_t bakeBPACEStep5Int(octet out[], const octet in[], void* state)
 {
 	bake_bpace_o* s = (bake_bpace_o*)state;
 	size_t n, no;
@@ -1700,7 +2296,7 @@ err_t bakeBPACEStep5(octet out[], const octet in[], void* state)
 		!ecpIsOnA(Vb, s->ec, stack))
 		return ERR_BAD_POINT;
 	// K <- ua Vb
-	if (!ecMulA(K, Vb, s->ec, s->u, n, stack))
+	if (!ecMulACT(K, Vb, s->ec, s->u, n, stack))
 		return ERR_BAD_PARAMS;
 	qrTo((octet*)K, ecX(K), s->ec->f, stack);
 	qrTo((octet*)Vb, ecX(Vb), s->ec->f, stack);
@@ -1746,19 +2342,24 @@ err_t bakeBPACEStep5(octet out[], const octet in[], void* state)
 	return ERR_OK;
 }
 
+err_t bakeBPACEStep5(octet out[], const octet in[], void* state)
+{
+	return tmTraceCall("bakeBPACEStep5", bakeBPACEStep5Int(out, in, state));
+}
+
 static size_t bakeBPACEStep5_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(3 * n) +
 		utilMax(5,
 			f_deep,
-			ecMulA_deep(n, ec_d, ec_deep, n),
+			ecMulACT_deep(n, ec_d, ec_deep),
 			beltHash_keep(),
 			beltKRP_keep(),
 			beltMAC_keep());
 }
 
-err_t bakeBPACEStep6(const octet in[8], void* state)
+static err_t bakeBPACEStep6Int(const octet in[8], void* state)
 {
 	bake_bpace_o* s = (bake_bpace_o*)state;
 	// стек
@@ -1784,6 +2385,11 @@ err_t bakeBPACEStep6(const octet in[8], void* state)
 	return ERR_OK;
 }
 
+err_t bakeBPACEStep6(const octet in[8], void* state)
+{
+	return tmTraceCall("bakeBPACEStep6", bakeBPACEStep6Int(in, state));
+}
+
 static size_t bakeBPACEStep6_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
@@ -1838,7 +2444,7 @@ err_t bakeBPACERunB(octet key[32], const bign_params* params,
 	// создать блоб
 	if (params->l != 128 && params->l != 192 && params->l != 256)
 		return ERR_BAD_PARAMS;
-	blob = blobCreate(9 * params->l / 8 + 8 + bakeBPACE_keep(params->l));
+	blob = stackCreate(9 * params->l / 8 + 8 + bakeBPACE_keep(params->l));
 	if (blob == 0)
 		return ERR_OUTOFMEMORY;
 	// раскладка блоба
@@ -1847,30 +2453,30 @@ err_t bakeBPACERunB(octet key[32], const bign_params* params,
 	state = out + params->l / 2 + 8;
 	// старт
 	code = bakeBPACEStart(state, params, settings, pwd, pwd_len);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 2
 	code = bakeBPACEStep2(out, state);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = write(&len, out, params->l / 8, file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 4
 	code = read(&len, in, 5 * params->l / 8, file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = bakeBPACEStep4(out, in, state);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = write(&len, out, params->l / 2 + (settings->kcb ? 8u : 0), file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 6
 	if (settings->kca)
 	{
 		code = read(&len, in, 8, file);
-		ERR_CALL_HANDLE(code, blobClose(blob));
+		ERR_CALL_HANDLE(code, stackClose(blob));
 		code = bakeBPACEStep6(in, state);
-		ERR_CALL_HANDLE(code, blobClose(blob));
+		ERR_CALL_HANDLE(code, stackClose(blob));
 	}
 	// завершение
 	code = bakeBPACEStepG(key, state);
-	blobClose(blob);
+	stackClose(blob);
 	return code;
 }
 
@@ -1891,7 +2497,7 @@ err_t bakeBPACERunA(octet key[32], const bign_params* params,
 	// создать блоб
 	if (params->l != 128 && params->l != 192 && params->l != 256)
 		return ERR_BAD_PARAMS;
-	blob = blobCreate(9 * params->l / 8 + 8 + bakeBPACE_keep(params->l));
+	blob = stackCreate(9 * params->l / 8 + 8 + bakeBPACE_keep(params->l));
 	if (blob == 0)
 		return ERR_OUTOFMEMORY;
 	// раскладка блоба
@@ -1900,26 +2506,270 @@ err_t bakeBPACERunA(octet key[32], const bign_params* params,
 	state = out + 5 * params->l / 8;
 	// старт
 	code = bakeBPACEStart(state, params, settings, pwd, pwd_len);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 3
 	code = read(&len, in, params->l / 8, file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = bakeBPACEStep3(out, in, state);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = write(&len, out, 5 * params->l / 8, file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	// шаг 5
 	code = read(&len, in, params->l / 2 + (settings->kcb ? 8u : 0), file);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	code = bakeBPACEStep5(out, in, state);
-	ERR_CALL_HANDLE(code, blobClose(blob));
+	ERR_CALL_HANDLE(code, stackClose(blob));
 	if (settings->kca)
 	{
 		code = write(&len, out, 8, file);
-		ERR_CALL_HANDLE(code, blobClose(blob));
+		ERR_CALL_HANDLE(code, stackClose(blob));
 	}
 	// завершение
 	code = bakeBPACEStepG(key, state);
-	blobClose(blob);
+	stackClose(blob);
 	return code;
 }
+
+/*
+*******************************************************************************
+Драйвер протоколов
+
+Драйвер хранит номер очередного шага step протокола proto. Шаги с четными
+номерами выполняет сторона B, с нечетными -- сторона A. Нулевой номер
+означает, что протокол завершен.
+
+Длины сообщений (l -- уровень стойкости):
+-	BMQV: M1 = l / 2, M2 = l / 2 [+ 8], [M3 = 8];
+-	BSTS: M1 = l / 2, M2 = 3 l / 4 + |certa| + 8, M3 = l / 4 + |certb| + 8;
+-	BPACE: M1 = l / 8, M2 = 5 l / 8, M3 = l / 2 [+ 8], [M4 = 8].
+*******************************************************************************
+*/
+
+typedef struct
+{
+	size_t proto;				/*< протокол и сторона */
+	void* state;				/*< состояние протокола */
+	const bake_cert* cert;		/*< сертификат другой стороны (BMQV) */
+	bake_certval_i val;			/*< проверка сертификата (BSTS) */
+	size_t l;					/*< уровень стойкости */
+	bool_t kca;					/*< подтверждение ключа стороной A */
+	bool_t kcb;					/*< подтверждение ключа стороной B */
+	size_t cert_len;			/*< длина своего сертификата (BSTS) */
+	size_t step;				/*< номер очередного шага */
+} bake_drv_st;
+
+size_t bakeDrv_keep()
+{
+	return sizeof(bake_drv_st);
+}
+
+err_t bakeDrvStart(void* drv, size_t proto, void* state,
+	const bake_cert* cert, bake_certval_i val)
+{
+	bake_drv_st* st = (bake_drv_st*)drv;
+	const bake_settings* settings;
+	// проверить входные данные
+	if (!memIsValid(drv, sizeof(bake_drv_st)) ||
+		!objIsOperable(state))
+		return ERR_BAD_INPUT;
+	// разобрать состояние
+	switch (proto)
+	{
+	case BAKE_DRV_BMQV_A:
+	case BAKE_DRV_BMQV_B:
+		if (!memIsValid(cert, sizeof(bake_cert)))
+			return ERR_BAD_INPUT;
+		settings = ((const bake_bmqv_o*)state)->settings;
+		st->l = ((const bake_bmqv_o*)state)->params->l;
+		st->cert_len = 0;
+		break;
+	case BAKE_DRV_BSTS_A:
+	case BAKE_DRV_BSTS_B:
+		if (val == 0)
+			return ERR_BAD_INPUT;
+		settings = ((const bake_bsts_o*)state)->settings;
+		st->l = ((const bake_bsts_o*)state)->params->l;
+		st->cert_len = ((const bake_bsts_o*)state)->cert->len;
+		break;
+	case BAKE_DRV_BPACE_A:
+	case BAKE_DRV_BPACE_B:
+		settings = ((const bake_bpace_o*)state)->settings;
+		st->l = ((const bake_bpace_o*)state)->ec->f->no * 4;
+		st->cert_len = 0;
+		break;
+	default:
+		return ERR_BAD_INPUT;
+	}
+	// настроить драйвер
+	st->proto = proto;
+	st->state = state;
+	st->cert = cert;
+	st->val = val;
+	st->kca = settings->kca;
+	st->kcb = settings->kcb;
+	st->step = 2;
+	// сторона A начинает с шага 3
+	if (proto == BAKE_DRV_BMQV_A || proto == BAKE_DRV_BSTS_A ||
+		proto == BAKE_DRV_BPACE_A)
+		++st->step;
+	return ERR_OK;
+}
+
+/*
+	Длина сообщения, которое выдается на шаге step.
+*/
+static size_t bakeDrvMsgLen(const bake_drv_st* st, size_t step)
+{
+	switch (st->proto)
+	{
+	case BAKE_DRV_BMQV_A:
+	case BAKE_DRV_BMQV_B:
+		if (step == 2)
+			return st->l / 2;
+		if (step == 3)
+			return st->l / 2 + (st->kca ? 8u : 0);
+		if (step == 4)
+			return st->kcb ? 8u : 0;
+		return 0;
+	case BAKE_DRV_BSTS_A:
+	case BAKE_DRV_BSTS_B:
+		if (step == 2)
+			return st->l / 2;
+		if (step == 3)
+			return 3 * st->l / 4 + st->cert_len + 8;
+		if (step == 4)
+			return st->l / 4 + st->cert_len + 8;
+		return 0;
+	default:
+		if (step == 2)
+			return st->l / 8;
+		if (step == 3)
+			return 5 * st->l / 8;
+		if (step == 4)
+			return st->l / 2 + (st->kcb ? 8u : 0);
+		if (step == 5)
+			return st->kca ? 8u : 0;
+		return 0;
+	}
+}
+
+size_t bakeDrvInLen(const void* drv)
+{
+	const bake_drv_st* st = (const bake_drv_st*)drv;
+	ASSERT(memIsValid(drv, sizeof(bake_drv_st)));
+	// первый шаг B или протокол завершен?
+	if (st->step <= 2)
+		return 0;
+	// сообщения переменной длины
+	if (st->proto == BAKE_DRV_BSTS_A || st->proto == BAKE_DRV_BSTS_B)
+		return st->step == 3 ? st->l / 2 : SIZE_MAX;
+	return bakeDrvMsgLen(st, st->step - 1);
+}
+
+size_t bakeDrvOutLen(const void* drv)
+{
+	const bake_drv_st* st = (const bake_drv_st*)drv;
+	ASSERT(memIsValid(drv, sizeof(bake_drv_st)));
+	return st->step ? bakeDrvMsgLen(st, st->step) : 0;
+}
+
+bool_t bakeDrvIsOver(const void* drv)
+{
+	const bake_drv_st* st = (const bake_drv_st*)drv;
+	ASSERT(memIsValid(drv, sizeof(bake_drv_st)));
+	return st->step == 0;
+}
+
+err_t bakeDrvStep(octet out[], size_t* out_len, const octet in[],
+	size_t in_len, void* drv)
+{
+	err_t code;
+	bake_drv_st* st = (bake_drv_st*)drv;
+	size_t len;
+	// проверить входные данные
+	if (!memIsValid(drv, sizeof(bake_drv_st)) ||
+		!memIsValid(out_len, sizeof(size_t)))
+		return ERR_BAD_INPUT;
+	if (st->step == 0)
+		return ERR_BAD_LOGIC;
+	len = bakeDrvInLen(st);
+	if (len != SIZE_MAX && in_len != len)
+		return ERR_BAD_INPUT;
+	if (!memIsValid(in, in_len) ||
+		!memIsValid(out, bakeDrvOutLen(st)))
+		return ERR_BAD_INPUT;
+	// выполнить шаг
+	switch (st->proto * 8 + st->step)
+	{
+	case BAKE_DRV_BMQV_B * 8 + 2:
+		code = bakeBMQVStep2(out, st->state);
+		break;
+	case BAKE_DRV_BMQV_A * 8 + 3:
+		code = bakeBMQVStep3(out, in, st->cert, st->state);
+		break;
+	case BAKE_DRV_BMQV_B * 8 + 4:
+		code = bakeBMQVStep4(out, in, st->cert, st->state);
+		break;
+	case BAKE_DRV_BMQV_A * 8 + 5:
+		code = bakeBMQVStep5(in, st->state);
+		break;
+	case BAKE_DRV_BSTS_B * 8 + 2:
+		code = bakeBSTSStep2(out, st->state);
+		break;
+	case BAKE_DRV_BSTS_A * 8 + 3:
+		code = bakeBSTSStep3(out, in, st->state);
+		break;
+	case BAKE_DRV_BSTS_B * 8 + 4:
+		code = bakeBSTSStep4(out, in, in_len, st->val, st->state);
+		break;
+	case BAKE_DRV_BSTS_A * 8 + 5:
+		code = bakeBSTSStep5(in, in_len, st->val, st->state);
+		break;
+	case BAKE_DRV_BPACE_B * 8 + 2:
+		code = bakeBPACEStep2(out, st->state);
+		break;
+	case BAKE_DRV_BPACE_A * 8 + 3:
+		code = bakeBPACEStep3(out, in, st->state);
+		break;
+	case BAKE_DRV_BPACE_B * 8 + 4:
+		code = bakeBPACEStep4(out, in, st->state);
+		break;
+	case BAKE_DRV_BPACE_A * 8 + 5:
+		code = bakeBPACEStep5(out, in, st->state);
+		break;
+	case BAKE_DRV_BPACE_B * 8 + 6:
+		code = bakeBPACEStep6(in, st->state);
+		break;
+	default:
+		code = ERR_BAD_LOGIC;
+	}
+	ERR_CALL_CHECK(code);
+	*out_len = bakeDrvMsgLen(st, st->step);
+	// перейти к следующему шагу своей стороны
+	st->step += 2;
+	if (bakeDrvMsgLen(st, st->step - 1) == 0)
+		st->step = 0;
+	return code;
+}
+
+err_t bakeDrvStepG(octet key[32], void* drv)
+{
+	bake_drv_st* st = (bake_drv_st*)drv;
+	// проверить входные данные
+	if (!memIsValid(drv, sizeof(bake_drv_st)))
+		return ERR_BAD_INPUT;
+	if (st->step != 0)
+		return ERR_BAD_LOGIC;
+	// извлечь ключ
+	switch (st->proto)
+	{
+	case BAKE_DRV_BMQV_A:
+	case BAKE_DRV_BMQV_B:
+		return bakeBMQVStepG(key, st->state);
+	case BAKE_DRV_BSTS_A:
+	case BAKE_DRV_BSTS_B:
+		return bakeBSTSStepG(key, st->state);
+	default:
+		return bakeBPACEStepG(key, st->state);
+	}
+}
@@ -4,7 +4,7 @@
 \brief STB 34.101.77 (bash): bash-f
 \project bee2 [cryptographic library]
 \created 2019.06.25
-\version 2021.03.25
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -23,7 +23,18 @@
 	#define __SSE2__
 #endif
 
-#if defined(__AVX512F__) && defined(BASH_AVX512)
+#if defined(BASH_AUTO)
+	#include "bee2/core/mt.h"
+	#include "bee2/core/util.h"
+	#include "bee2/crypto/bash.h"
+	#define bashF bashF64
+	#define bashF_deep bashF64_deep
+	size_t bashF64_deep();
+	#include "bash_f64.c"
+	#undef bashF
+	#undef bashF_deep
+	const char bash_platform[] = "BASH_AUTO";
+#elif defined(__AVX512F__) && defined(BASH_AVX512)
 	#include "bash_favx512.c"
 	const char bash_platform[] = "BASH_AVX512";
 #elif defined(__AVX2__) && defined(BASH_AVX2)
@@ -42,3 +53,117 @@
 	#include "bash_f64.c"
 	const char bash_platform[] = "BASH_64";
 #endif
+
+/*
+*******************************************************************************
+Выбор реализации во время выполнения
+
+В режиме BASH_AUTO в библиотеку включаются реализации bash-f для платформ
+BASH_64, BASH_SSE2, BASH_AVX2 и BASH_AVX512. Реализации для SSE2, AVX2
+и AVX512 компилируются в отдельных единицах трансляции со своими наборами
+инструкций, их открытые имена получают суффиксы платформ.
+
+При первом обращении к bashF() определяется наиболее быстрая реализация,
+поддерживаемая процессором и операционной системой (см. cpuHas()).
+
+Аналогично выбирается реализация bashFN(): для платформ BASH_AVX2 и 
+BASH_AVX512 одновременно обрабатываются 4 и 8 состояний соответственно, 
+для остальных платформ состояния обрабатываются по очереди.
+
+В остальных режимах реализация выбирается во время компиляции.
+*******************************************************************************
+*/
+
+#if defined(BASH_AUTO)
+
+#include "bee2/core/cpu.h"
+
+void bashFSSE2(octet block[192], void* stack);
+size_t bashFSSE2_deep();
+void bashFAVX2(octet block[192], void* stack);
+size_t bashFAVX2_deep();
+void bashFAVX512(octet block[192], void* stack);
+size_t bashFAVX512_deep();
+void bashFNAVX2(octet block[], size_t count, void* stack);
+size_t bashFNAVX2_deep();
+void bashFNAVX512(octet block[], size_t count, void* stack);
+size_t bashFNAVX512_deep();
+
+static void bashFN64(octet block[], size_t count, void* stack)
+{
+	for (; count; --count, block += 192)
+		bashF(block, stack);
+}
+
+static size_t _once;
+static void (*_bashF)(octet block[192], void* stack) = bashF64;
+static void (*_bashFN)(octet block[], size_t count, void* stack) = bashFN64;
+static const char* _platform = "BASH_64";
+
+static void bashFInit()
+{
+	if (cpuHas(CPU_SSE2))
+		_bashF = bashFSSE2, _platform = "BASH_SSE2";
+	if (cpuHas(CPU_AVX2))
+		_bashF = bashFAVX2, _bashFN = bashFNAVX2, _platform = "BASH_AVX2";
+	if (cpuHas(CPU_AVX512F))
+		_bashF = bashFAVX512, _bashFN = bashFNAVX512,
+			_platform = "BASH_AVX512";
+}
+
+size_t bashF_deep()
+{
+	return utilMax(4, bashF64_deep(), bashFSSE2_deep(), bashFAVX2_deep(), 
+		bashFAVX512_deep());
+}
+
+void bashF(octet block[192], void* stack)
+{
+	if (_once != 1)
+		mtCallOnce(&_once, bashFInit);
+	_bashF(block, stack);
+}
+
+size_t bashFN_deep()
+{
+	return utilMax(3, bashF_deep(), bashFNAVX2_deep(), bashFNAVX512_deep());
+}
+
+void bashFN(octet block[], size_t count, void* stack)
+{
+	if (_once != 1)
+		mtCallOnce(&_once, bashFInit);
+	_bashFN(block, count, stack);
+}
+
+const char* bashPlatform()
+{
+	if (_once != 1)
+		mtCallOnce(&_once, bashFInit);
+	return _platform;
+}
+
+#else
+
+#ifndef BASH_FN
+
+size_t bashFN_deep()
+{
+	return bashF_deep();
+}
+
+void bashFN(octet block[], size_t count, void* stack)
+{
+	ASSERT(memIsValid(block, 192 * count));
+	for (; count; --count, block += 192)
+		bashF(block, stack);
+}
+
+#endif
+
+const char* bashPlatform()
+{
+	return bash_platform;
+}
+
+#endif
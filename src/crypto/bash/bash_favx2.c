@@ -4,12 +4,14 @@
 \brief STB 34.101.77 (bash): bash-f optimized for AVX2
 \project bee2 [cryptographic library]
 \created 2019.04.03
-\version 2021.03.26
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include "bee2/defs.h"
+
 #ifndef __AVX2__
 	#error "The compiler does not support AVX2 intrinsics"
 #endif
@@ -364,3 +366,127 @@ void bashF2(octet block[192])
 	STORE(block + 160, W5);
 	ZEROALL;
 }
+
+/*
+*******************************************************************************
+Bash-f для нескольких состояний
+
+Одновременно преобразуются 4 независимых состояний, размещенных в памяти
+последовательно. 64-разрядное слово Si (i = 0, 1,..., 23) всех состояний
+загружается в одно 256-разрядное слово s[i]. В такой раскладке
+перестановка слов выполняется переименованием (макросы Pi, как в
+bash_f64.c), а преобразования bash-s -- поразрядными операциями над
+словами s[i].
+*******************************************************************************
+*/
+
+#define P0(x) x
+
+#define P1(x)\
+	((x < 8) ? 8 + (x + 2 * (x & 1) + 7) % 8 :\
+		((x < 16) ? 8 + (x ^ 1) : (5 * x + 6) % 8))
+
+#define P2(x) P1(P1(x))
+
+#define P3(x)\
+	(8 * (x / 8) + ( x % 8 + 4) % 8)
+
+#define P4(x) P1(P3(x))
+#define P5(x) P2(P3(x))
+
+#define XN(W1, W2) _mm256_xor_si256(W1, W2)
+#define ON(W1, W2) _mm256_or_si256(W1, W2)
+#define AN(W1, W2) _mm256_and_si256(W1, W2)
+#define NON(W1, W2) _mm256_or_si256(_mm256_xor_si256(W1, ONES), W2)
+#define SETN(w) _mm256_set1_epi64x(w)
+#define ROTN(W, m) ON(_mm256_slli_epi64(W, m), _mm256_srli_epi64(W, 64 - m))
+#define ONES _mm256_set1_epi64x(-1)
+
+#define bashSN(w0, w1, w2, m1, n1, m2, n2)\
+	T2 = ROTN(w0, m1);\
+	w0 = XN(XN(w0, w1), w2);\
+	T1 = XN(w1, ROTN(w0, n1));\
+	w1 = XN(T1, T2);\
+	w2 = XN(XN(w2, ROTN(w2, m2)), ROTN(T1, n2));\
+	T1 = ON(w0, w2);\
+	T2 = AN(w0, w1);\
+	T0 = NON(w2, w1);\
+	w0 = XN(w0, T0);\
+	w1 = XN(w1, T1);\
+	w2 = XN(w2, T2)
+
+#define bashRN(s, p, p_next, i)\
+	bashSN(s[p( 0)], s[p( 8)], s[p(16)],  8, 53, 14,  1);\
+	bashSN(s[p( 1)], s[p( 9)], s[p(17)], 56, 51, 34,  7);\
+	bashSN(s[p( 2)], s[p(10)], s[p(18)],  8, 37, 46, 49);\
+	bashSN(s[p( 3)], s[p(11)], s[p(19)], 56,  3,  2, 23);\
+	bashSN(s[p( 4)], s[p(12)], s[p(20)],  8, 21, 14, 33);\
+	bashSN(s[p( 5)], s[p(13)], s[p(21)], 56, 19, 34, 39);\
+	bashSN(s[p( 6)], s[p(14)], s[p(22)],  8,  5, 46, 17);\
+	bashSN(s[p( 7)], s[p(15)], s[p(23)], 56, 35,  2, 55);\
+	s[p_next(23)] = XN(s[p_next(23)], SETN((long long)c##i))
+
+#define bashFN0(s)\
+	bashRN(s, P0, P1,  1);\
+	bashRN(s, P1, P2,  2);\
+	bashRN(s, P2, P3,  3);\
+	bashRN(s, P3, P4,  4);\
+	bashRN(s, P4, P5,  5);\
+	bashRN(s, P5, P0,  6);\
+	bashRN(s, P0, P1,  7);\
+	bashRN(s, P1, P2,  8);\
+	bashRN(s, P2, P3,  9);\
+	bashRN(s, P3, P4, 10);\
+	bashRN(s, P4, P5, 11);\
+	bashRN(s, P5, P0, 12);\
+	bashRN(s, P0, P1, 13);\
+	bashRN(s, P1, P2, 14);\
+	bashRN(s, P2, P3, 15);\
+	bashRN(s, P3, P4, 16);\
+	bashRN(s, P4, P5, 17);\
+	bashRN(s, P5, P0, 18);\
+	bashRN(s, P0, P1, 19);\
+	bashRN(s, P1, P2, 20);\
+	bashRN(s, P2, P3, 21);\
+	bashRN(s, P3, P4, 22);\
+	bashRN(s, P4, P5, 23);\
+	bashRN(s, P5, P0, 24)
+
+static void bashFX4(octet block[4 * 192])
+{
+	__m256i s[24];
+	register __m256i T0, T1, T2;
+	u64* b = (u64*)block;
+	u64 t[4];
+	size_t i;
+	// загрузить состояния
+	for (i = 0; i < 24; ++i)
+		s[i] = _mm256_set_epi64x((long long)b[72 + i], (long long)b[48 + i],
+			(long long)b[24 + i], (long long)b[i]);
+	// преобразовать
+	bashFN0(s);
+	// выгрузить состояния
+	for (i = 0; i < 24; ++i)
+	{
+		STOREU(t, s[i]);
+		b[i] = t[0], b[24 + i] = t[1], b[48 + i] = t[2], b[72 + i] = t[3];
+	}
+	T0 = T1 = T2 = _mm256_setzero_si256();
+	ZEROALL;
+}
+
+#define BASH_FN
+
+void bashFN(octet block[], size_t count, void* stack)
+{
+	ASSERT(memIsValid(block, 192 * count));
+	for (; count >= 4; count -= 4, block += 4 * 192)
+		bashFX4(block);
+	for (; count; --count, block += 192)
+		bashF(block, stack);
+}
+
+size_t bashFN_deep()
+{
+	return bashF_deep();
+}
@@ -5,12 +5,14 @@
 \remark AVX512 is interpreted here only as AVX512F
 \project bee2 [cryptographic library]
 \created 2019.04.03
-\version 2021.03.25
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include "bee2/defs.h"
+
 /*
 *******************************************************************************
 Архитектура AVX512 интерпретируется как AVX512F
@@ -276,3 +278,119 @@ void bashF2(octet block[192])
 	STORE(block + 128, W2);
 	ZEROALL;
 }
+
+/*
+*******************************************************************************
+Bash-f для нескольких состояний
+
+Одновременно преобразуются 8 независимых состояний, размещенных в памяти
+последовательно. 64-разрядное слово Si (i = 0, 1,..., 23) всех состояний
+загружается в одно 512-разрядное слово s[i]. В такой раскладке
+перестановка слов выполняется переименованием (макросы Pi, как в
+bash_f64.c), а преобразования bash-s -- поразрядными операциями над
+словами s[i].
+*******************************************************************************
+*/
+
+#define P0(x) x
+
+#define P1(x)\
+	((x < 8) ? 8 + (x + 2 * (x & 1) + 7) % 8 :\
+		((x < 16) ? 8 + (x ^ 1) : (5 * x + 6) % 8))
+
+#define P2(x) P1(P1(x))
+
+#define P3(x)\
+	(8 * (x / 8) + ( x % 8 + 4) % 8)
+
+#define P4(x) P1(P3(x))
+#define P5(x) P2(P3(x))
+
+#define XN(W1, W2) _mm512_xor_si512(W1, W2)
+#define SETN(w) _mm512_set1_epi64(w)
+#define ROTN(W, m) _mm512_rol_epi64(W, m)
+
+#define bashSN(w0, w1, w2, m1, n1, m2, n2)\
+	T2 = ROTN(w0, m1);\
+	w0 = XX8(w0, w1, w2);\
+	T1 = XN(w1, ROTN(w0, n1));\
+	w1 = XN(T1, T2);\
+	w2 = XX8(w2, ROTN(w2, m2), ROTN(T1, n2));\
+	T0 = XNO8(w0, w2, w1);\
+	T1 = XO8(w1, w0, w2);\
+	w2 = XA8(w2, w0, w1);\
+	w0 = T0;\
+	w1 = T1
+
+#define bashRN(s, p, p_next, i)\
+	bashSN(s[p( 0)], s[p( 8)], s[p(16)],  8, 53, 14,  1);\
+	bashSN(s[p( 1)], s[p( 9)], s[p(17)], 56, 51, 34,  7);\
+	bashSN(s[p( 2)], s[p(10)], s[p(18)],  8, 37, 46, 49);\
+	bashSN(s[p( 3)], s[p(11)], s[p(19)], 56,  3,  2, 23);\
+	bashSN(s[p( 4)], s[p(12)], s[p(20)],  8, 21, 14, 33);\
+	bashSN(s[p( 5)], s[p(13)], s[p(21)], 56, 19, 34, 39);\
+	bashSN(s[p( 6)], s[p(14)], s[p(22)],  8,  5, 46, 17);\
+	bashSN(s[p( 7)], s[p(15)], s[p(23)], 56, 35,  2, 55);\
+	s[p_next(23)] = XN(s[p_next(23)], SETN((long long)c##i))
+
+#define bashFN0(s)\
+	bashRN(s, P0, P1,  1);\
+	bashRN(s, P1, P2,  2);\
+	bashRN(s, P2, P3,  3);\
+	bashRN(s, P3, P4,  4);\
+	bashRN(s, P4, P5,  5);\
+	bashRN(s, P5, P0,  6);\
+	bashRN(s, P0, P1,  7);\
+	bashRN(s, P1, P2,  8);\
+	bashRN(s, P2, P3,  9);\
+	bashRN(s, P3, P4, 10);\
+	bashRN(s, P4, P5, 11);\
+	bashRN(s, P5, P0, 12);\
+	bashRN(s, P0, P1, 13);\
+	bashRN(s, P1, P2, 14);\
+	bashRN(s, P2, P3, 15);\
+	bashRN(s, P3, P4, 16);\
+	bashRN(s, P4, P5, 17);\
+	bashRN(s, P5, P0, 18);\
+	bashRN(s, P0, P1, 19);\
+	bashRN(s, P1, P2, 20);\
+	bashRN(s, P2, P3, 21);\
+	bashRN(s, P3, P4, 22);\
+	bashRN(s, P4, P5, 23);\
+	bashRN(s, P5, P0, 24)
+
+static void bashFX8(octet block[8 * 192])
+{
+	__m512i s[24];
+	register __m512i T0, T1, T2;
+	u64* b = (u64*)block;
+	const __m512i idx = _mm512_set_epi64(7 * 24, 6 * 24, 5 * 24, 4 * 24,
+		3 * 24, 2 * 24, 24, 0);
+	size_t i;
+	// загрузить состояния
+	for (i = 0; i < 24; ++i)
+		s[i] = _mm512_i64gather_epi64(idx, (const void*)(b + i), 8);
+	// преобразовать
+	bashFN0(s);
+	// выгрузить состояния
+	for (i = 0; i < 24; ++i)
+		_mm512_i64scatter_epi64((void*)(b + i), idx, s[i], 8);
+	T0 = T1 = T2 = _mm512_setzero_si512();
+	ZEROALL;
+}
+
+#define BASH_FN
+
+void bashFN(octet block[], size_t count, void* stack)
+{
+	ASSERT(memIsValid(block, 192 * count));
+	for (; count >= 8; count -= 8, block += 8 * 192)
+		bashFX8(block);
+	for (; count; --count, block += 192)
+		bashF(block, stack);
+}
+
+size_t bashFN_deep()
+{
+	return bashF_deep();
+}
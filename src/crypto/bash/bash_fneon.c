@@ -4,7 +4,7 @@
 \brief STB 34.101.77 (bash): bash-f optimized for ARM NEON
 \project bee2 [cryptographic library]
 \created 2020.10.26
-\version 2021.03.26
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -344,6 +344,12 @@ void bashF(octet block_unaligned[192], void* stack)
 	octet *block_aligned = (octet*)((((uintptr_t)stack) + 7) & ~((uintptr_t)7));
 
 	ASSERT(memIsDisjoint2(block_unaligned, 192, stack, bashF_deep()));
+	// состояние выровнено (в блобе или стеке, см. stack-align)?
+	if (memIsAligned(block_unaligned, 8))
+	{
+		bashF2(block_unaligned, stack);
+		return;
+	}
 	memCopy(block_aligned, block_unaligned, 192);
 	bashF2(block_aligned, (octet*)stack + bashF_deep());
 	memCopy(block_unaligned, block_aligned, 192);
@@ -4,12 +4,14 @@
 \brief STB 34.101.77 (bash): bash-f optimized for SSE2
 \project bee2 [cryptographic library]
 \created 2019.07.12
-\version 2021.03.26
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include "bee2/defs.h"
+
 #ifndef __SSE2__
 	#error "The compiler does not support SSE2 intrinsics"
 #endif
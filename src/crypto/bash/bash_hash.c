@@ -4,7 +4,7 @@
 \brief STB 34.101.77 (bash): hashing algorithms
 \project bee2 [cryptographic library]
 \created 2014.07.15
-\version 2021.02.03
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,7 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/bash.h"
 
@@ -35,6 +36,11 @@ size_t bashHash_keep()
 	return sizeof(bash_hash_st) + bashF_deep();
 }
 
+size_t bashHash_keep_aligned()
+{
+	return stackAlign(bashHash_keep());
+}
+
 void bashHashStart(void* state, size_t l)
 {
 	bash_hash_st* st = (bash_hash_st*)state;
@@ -78,6 +84,16 @@ void bashHashStepH(const void* buf, size_t count, void* state)
 		memCopy(st->s, buf, count);
 }
 
+void bashHashStepHV(const void* const buf[], const size_t count[], size_t n,
+	void* state)
+{
+	size_t i;
+	ASSERT(memIsValid(buf, n * sizeof(const void*)));
+	ASSERT(memIsValid(count, n * sizeof(size_t)));
+	for (i = 0; i < n; ++i)
+		bashHashStepH(buf[i], count[i], state);
+}
+
 static void bashHashStepG_internal(size_t hash_len, void* state)
 {
 	bash_hash_st* st = (bash_hash_st*)state;
@@ -124,7 +140,7 @@ err_t bashHash(octet hash[], size_t l, const void* src, size_t count)
 	if (!memIsValid(src, count) || !memIsValid(hash, l / 4))
 		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(bashHash_keep());
+	state = stackCreate(bashHash_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// вычислить хэш-значение
@@ -132,6 +148,161 @@ err_t bashHash(octet hash[], size_t l, const void* src, size_t count)
 	bashHashStepH(src, count, state);
 	bashHashStepG(hash, l / 4, state);
 	// завершить
+	stackClose(state);
+	return ERR_OK;
+}
+
+/*
+*******************************************************************************
+Экспорт / импорт
+
+\remark Незаполненная часть буфера bash_hash_st::s не влияет на результат
+(она перезаписывается в bashHashStepH() и bashHashStepG()) и при экспорте
+обнуляется.
+*******************************************************************************
+*/
+
+void bashHashExport(octet buf[], const void* state)
+{
+	const bash_hash_st* st = (const bash_hash_st*)state;
+	ASSERT(memIsValid(st, bashHash_keep()));
+	ASSERT(memIsValid(buf, BASH_HASH_EXPORT_LEN));
+	ASSERT(st->pos < st->buf_len);
+	buf[0] = 0x77, buf[1] = 0x01;
+	buf[2] = (octet)((192 - st->buf_len) / 8), buf[3] = (octet)st->pos;
+	memCopy(buf + 4, st->s, st->pos);
+	memSetZero(buf + 4 + st->pos, st->buf_len - st->pos);
+	memCopy(buf + 4 + st->buf_len, st->s + st->buf_len, 192 - st->buf_len);
+}
+
+err_t bashHashImport(void* state, const octet buf[])
+{
+	bash_hash_st* st = (bash_hash_st*)state;
+	size_t buf_len;
+	// проверить входные данные
+	if (!memIsValid(buf, BASH_HASH_EXPORT_LEN) ||
+		!memIsValid(state, bashHash_keep()))
+		return ERR_BAD_INPUT;
+	// проверить формат
+	if (buf[0] != 0x77 || buf[1] != 0x01 || buf[2] == 0 || buf[2] > 16)
+		return ERR_BAD_FORMAT;
+	buf_len = 192 - 8 * (size_t)buf[2];
+	if (buf[3] >= buf_len || !memIsZero(buf + 4 + buf[3], buf_len - buf[3]))
+		return ERR_BAD_FORMAT;
+	// восстановить состояние
+	memCopy(st->s, buf + 4, 192);
+	st->buf_len = buf_len, st->pos = buf[3];
+	return ERR_OK;
+}
+
+/*
+*******************************************************************************
+Хэширование нескольких сообщений
+
+Состояния восьми дорожек размещаются в памяти последовательно и 
+преобразуются одним вызовом bashFN(). Если заняты не все дорожки (очередь 
+сообщений исчерпана), то состояния занятых дорожек преобразуются 
+по отдельности.
+
+На каждом шаге в состояние занятой дорожки загружается очередной полный 
+блок сообщения либо последний блок, дополненный так же, как 
+в bashHashStepG().
+*******************************************************************************
+*/
+
+#define BASH_MB_LANES 8
+
+typedef struct {
+	size_t job;			/*< номер сообщения */
+	size_t pos;			/*< обработано октетов сообщения */
+	bool_t busy;		/*< дорожка занята? */
+	bool_t last;		/*< загружен последний блок? */
+} bash_hash_lane_st;
+
+typedef struct {
+	octet s[BASH_MB_LANES][192];			/*< состояния дорожек */
+	bash_hash_lane_st lanes[BASH_MB_LANES];	/*< дорожки */
+	octet stack[];							/*< [bashFN_deep()] стек bashFN */
+} bash_hash_mb_st;
+
+err_t bashHashMB(octet hash[], size_t l, const void* const src[], 
+	const size_t count[], size_t n)
+{
+	void* state;
+	bash_hash_mb_st* st;
+	size_t buf_len;
+	size_t next;
+	size_t i;
+	// проверить входные данные
+	if (l == 0 || l % 16 != 0 || l > 256)
+		return ERR_BAD_PARAMS;
+	if (!memIsValid(src, n * sizeof(const void*)) ||
+		!memIsValid(count, n * O_PER_S) ||
+		!memIsValid(hash, l / 4 * n))
+		return ERR_BAD_INPUT;
+	for (i = 0; i < n; ++i)
+		if (!memIsValid(src[i], count[i]))
+			return ERR_BAD_INPUT;
+	// создать состояние
+	state = blobCreate(sizeof(bash_hash_mb_st) + bashFN_deep());
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	st = (bash_hash_mb_st*)state;
+	buf_len = 192 - l / 2;
+	// цикл обработки очереди
+	for (next = 0;;)
+	{
+		size_t active = 0;
+		size_t j;
+		// назначить сообщения и загрузить блоки
+		for (j = 0; j < BASH_MB_LANES; ++j)
+		{
+			bash_hash_lane_st* lane = st->lanes + j;
+			size_t rest;
+			if (!lane->busy && next < n)
+			{
+				lane->job = next++, lane->pos = 0;
+				lane->busy = TRUE, lane->last = FALSE;
+				memSetZero(st->s[j], 192);
+				st->s[j][192 - 8] = (octet)(l / 4);
+			}
+			if (!lane->busy)
+				continue;
+			++active;
+			rest = count[lane->job] - lane->pos;
+			if (rest >= buf_len)
+			{
+				memCopy(st->s[j], (const octet*)src[lane->job] + lane->pos,
+					buf_len);
+				lane->pos += buf_len;
+			}
+			else
+			{
+				memCopy(st->s[j], (const octet*)src[lane->job] + lane->pos,
+					rest);
+				memSetZero(st->s[j] + rest, buf_len - rest);
+				st->s[j][rest] = 0x40;
+				lane->last = TRUE;
+			}
+		}
+		if (active == 0)
+			break;
+		// преобразовать состояния
+		if (active == BASH_MB_LANES)
+			bashFN(st->s[0], BASH_MB_LANES, st->stack);
+		else
+			for (j = 0; j < BASH_MB_LANES; ++j)
+				if (st->lanes[j].busy)
+					bashF(st->s[j], st->stack);
+		// завершить обработку сообщений
+		for (j = 0; j < BASH_MB_LANES; ++j)
+			if (st->lanes[j].busy && st->lanes[j].last)
+			{
+				memCopy(hash + l / 4 * st->lanes[j].job, st->s[j], l / 4);
+				st->lanes[j].busy = FALSE;
+			}
+	}
+	// завершить
 	blobClose(state);
 	return ERR_OK;
 }
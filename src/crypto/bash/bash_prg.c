@@ -4,14 +4,16 @@
 \brief STB 34.101.77 (bash): programmable algorithms
 \project bee2 [cryptographic library]
 \created 2018.10.30
-\version 2023.04.07
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
 #include "bee2/core/blob.h"
+#include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/bash.h"
 
@@ -55,12 +57,12 @@
 #define BASH_PRG_OUT		0x11	/* 000100 01 */
 
 typedef struct {
+	octet s[192];		/*< состояние (в начале, см. stack-align) */
+	octet t[192];		/*< копия состояния (для ratchet) */
 	size_t l;			/*< уровень стойкости */
 	size_t d;			/*< емкость */
-	octet s[192];		/*< состояние */
 	size_t buf_len;		/*< длина буфера */
 	size_t pos;			/*< позиция в буфере */
-	octet t[192];		/*< копия состояния (для ratchet) */
 	octet stack[];		/*< [bashF_deep()] стек bashF */
 } bash_prg_st;
 
@@ -69,6 +71,11 @@ size_t bashPrg_keep()
 	return sizeof(bash_prg_st) + bashF_deep();
 }
 
+size_t bashPrg_keep_aligned()
+{
+	return stackAlign(bashPrg_keep());
+}
+
 /*
 *******************************************************************************
 Вспомогательные макросы
@@ -264,48 +271,77 @@ void bashPrgSqueeze(void* buf, size_t count, void* state)
 /*
 *******************************************************************************
 Encr: зашифровать
+
+\remark Функции bashPrgEncrBlock() и bashPrgDecrBlock() обрабатывают фрагмент
+буфера за один проход машинными словами: загрузка данных в состояние
+совмещается с выгрузкой результата. Полные блоки обрабатываются без
+промежуточного учета позиции в буфере.
 *******************************************************************************
 */
 
+static void bashPrgEncrBlock(void* dest, const void* src, octet s[],
+	size_t count)
+{
+	for (; count >= O_PER_W; count -= O_PER_W)
+	{
+		*(word*)s ^= *(const word*)src;
+		*(word*)dest = *(const word*)s;
+		src = (const word*)src + 1;
+		dest = (word*)dest + 1;
+		s += O_PER_W;
+	}
+	while (count--)
+	{
+		*s ^= *(const octet*)src;
+		*(octet*)dest = *s;
+		src = (const octet*)src + 1;
+		dest = (octet*)dest + 1;
+		s++;
+	}
+}
+
 void bashPrgEncrStart(void* state)
 {
 	ASSERT(bashPrgIsKeymode(state));
 	bashPrgCommit(BASH_PRG_TEXT, state);
 }
 
-void bashPrgEncrStep(void* buf, size_t count, void* state)
+void bashPrgEncrStep2(void* dest, const void* src, size_t count, void* state)
 {
 	bash_prg_st* st = (bash_prg_st*)state;
-	ASSERT(memIsDisjoint2(st, bashPrg_keep(), buf, count));
+	ASSERT(memIsSameOrDisjoint(src, dest, count));
+	ASSERT(memIsDisjoint2(st, bashPrg_keep(), dest, count));
+	ASSERT(memIsDisjoint2(st, bashPrg_keep(), src, count));
 	// остатка буфера достаточно?
 	if (count < st->buf_len - st->pos)
 	{
-		memXor2(st->s + st->pos, buf, count);
-		memCopy(buf, st->s + st->pos, count);
+		bashPrgEncrBlock(dest, src, st->s + st->pos, count);
 		st->pos += count;
 		return;
 	}
 	// новый буфер
-	memXor2(st->s + st->pos, buf, st->buf_len - st->pos);
-	memCopy(buf, st->s + st->pos, st->buf_len - st->pos);
-	buf = (octet*)buf + st->buf_len - st->pos;
+	bashPrgEncrBlock(dest, src, st->s + st->pos, st->buf_len - st->pos);
+	src = (const octet*)src + st->buf_len - st->pos;
+	dest = (octet*)dest + st->buf_len - st->pos;
 	count -= st->buf_len - st->pos;
 	bashF(st->s, st->stack);
 	// цикл по полным блокам
 	while (count >= st->buf_len)
 	{
-		memXor2(st->s, buf, st->buf_len);
-		memCopy(buf, st->s, st->buf_len);
-		buf = (octet*)buf + st->buf_len;
+		bashPrgEncrBlock(dest, src, st->s, st->buf_len);
+		src = (const octet*)src + st->buf_len;
+		dest = (octet*)dest + st->buf_len;
 		count -= st->buf_len;
 		bashF(st->s, st->stack);
 	}
 	// неполный блок
 	if (st->pos = count)
-	{
-		memXor2(st->s, buf, count);
-		memCopy(buf, st->s, count);
-	}
+		bashPrgEncrBlock(dest, src, st->s, count);
+}
+
+void bashPrgEncrStep(void* buf, size_t count, void* state)
+{
+	bashPrgEncrStep2(buf, buf, count, state);
 }
 
 void bashPrgEncr(void* buf, size_t count, void* state)
@@ -314,51 +350,85 @@ void bashPrgEncr(void* buf, size_t count, void* state)
 	bashPrgEncrStep(buf, count, state);
 }
 
+void bashPrgEncr2(void* dest, const void* src, size_t count, void* state)
+{
+	bashPrgEncrStart(state);
+	bashPrgEncrStep2(dest, src, count, state);
+}
+
 /*
 *******************************************************************************
 Decr: расшифровать
 *******************************************************************************
 */
 
+static void bashPrgDecrBlock(void* dest, const void* src, octet s[],
+	size_t count)
+{
+	word w;
+	octet o;
+	for (; count >= O_PER_W; count -= O_PER_W)
+	{
+		w = *(const word*)src;
+		*(word*)dest = *(const word*)s ^ w;
+		*(word*)s = w;
+		src = (const word*)src + 1;
+		dest = (word*)dest + 1;
+		s += O_PER_W;
+	}
+	while (count--)
+	{
+		o = *(const octet*)src;
+		*(octet*)dest = *s ^ o;
+		*s = o;
+		src = (const octet*)src + 1;
+		dest = (octet*)dest + 1;
+		s++;
+	}
+}
+
 void bashPrgDecrStart(void* state)
 {
 	ASSERT(bashPrgIsKeymode(state));
 	bashPrgCommit(BASH_PRG_TEXT, state);
 }
 
-void bashPrgDecrStep(void* buf, size_t count, void* state)
+void bashPrgDecrStep2(void* dest, const void* src, size_t count, void* state)
 {
 	bash_prg_st* st = (bash_prg_st*)state;
-	ASSERT(memIsDisjoint2(st, bashPrg_keep(), buf, count));
+	ASSERT(memIsSameOrDisjoint(src, dest, count));
+	ASSERT(memIsDisjoint2(st, bashPrg_keep(), dest, count));
+	ASSERT(memIsDisjoint2(st, bashPrg_keep(), src, count));
 	// остатка буфера достаточно?
 	if (count < st->buf_len - st->pos)
 	{
-		memXor2(buf, st->s + st->pos, count);
-		memXor2(st->s + st->pos, buf, count);
+		bashPrgDecrBlock(dest, src, st->s + st->pos, count);
 		st->pos += count;
 		return;
 	}
 	// новый буфер
-	memXor2(buf, st->s + st->pos, st->buf_len - st->pos);
-	memXor2(st->s + st->pos, buf, st->buf_len - st->pos);
-	buf = (octet*)buf + st->buf_len - st->pos;
+	bashPrgDecrBlock(dest, src, st->s + st->pos, st->buf_len - st->pos);
+	src = (const octet*)src + st->buf_len - st->pos;
+	dest = (octet*)dest + st->buf_len - st->pos;
 	count -= st->buf_len - st->pos;
 	bashF(st->s, st->stack);
 	// цикл по полным блокам
 	while (count >= st->buf_len)
 	{
-		memXor2(buf, st->s, st->buf_len);
-		memXor2(st->s, buf, st->buf_len);
-		buf = (octet*)buf + st->buf_len;
+		bashPrgDecrBlock(dest, src, st->s, st->buf_len);
+		src = (const octet*)src + st->buf_len;
+		dest = (octet*)dest + st->buf_len;
 		count -= st->buf_len;
 		bashF(st->s, st->stack);
 	}
 	// неполный блок
 	if (st->pos = count)
-	{
-		memXor2(buf, st->s, count);
-		memXor2(st->s, buf, count);
-	}
+		bashPrgDecrBlock(dest, src, st->s, count);
+}
+
+void bashPrgDecrStep(void* buf, size_t count, void* state)
+{
+	bashPrgDecrStep2(buf, buf, count, state);
 }
 
 void bashPrgDecr(void* buf, size_t count, void* state)
@@ -367,6 +437,104 @@ void bashPrgDecr(void* buf, size_t count, void* state)
 	bashPrgDecrStep(buf, count, state);
 }
 
+void bashPrgDecr2(void* dest, const void* src, size_t count, void* state)
+{
+	bashPrgDecrStart(state);
+	bashPrgDecrStep2(dest, src, count, state);
+}
+
+/*
+*******************************************************************************
+Snapshot: сохранить / восстановить
+
+\remark В снимок попадают параметры автомата и bash_prg_st::s. Копия
+состояния t и стек bashF не сохраняются: они заполняются заново при каждом
+использовании.
+*******************************************************************************
+*/
+
+typedef struct {
+	size_t l;			/*< уровень стойкости */
+	size_t d;			/*< емкость */
+	octet s[192];		/*< состояние */
+	size_t buf_len;		/*< длина буфера */
+	size_t pos;			/*< позиция в буфере */
+} bash_prg_snapshot_st;
+
+size_t bashPrgSnapshot_keep()
+{
+	return sizeof(bash_prg_snapshot_st);
+}
+
+void bashPrgSnapshot(void* snapshot, const void* state)
+{
+	bash_prg_snapshot_st* sn = (bash_prg_snapshot_st*)snapshot;
+	const bash_prg_st* st = (const bash_prg_st*)state;
+	ASSERT(memIsValid(st, bashPrg_keep()));
+	ASSERT(memIsValid(sn, bashPrgSnapshot_keep()));
+	ASSERT(memIsDisjoint2(sn, bashPrgSnapshot_keep(), st, bashPrg_keep()));
+	sn->l = st->l, sn->d = st->d;
+	memCopy(sn->s, st->s, 192);
+	sn->buf_len = st->buf_len, sn->pos = st->pos;
+}
+
+void bashPrgRestore(void* state, const void* snapshot)
+{
+	bash_prg_st* st = (bash_prg_st*)state;
+	const bash_prg_snapshot_st* sn = (const bash_prg_snapshot_st*)snapshot;
+	ASSERT(memIsValid(st, bashPrg_keep()));
+	ASSERT(memIsValid(sn, bashPrgSnapshot_keep()));
+	ASSERT(memIsDisjoint2(sn, bashPrgSnapshot_keep(), st, bashPrg_keep()));
+	st->l = sn->l, st->d = sn->d;
+	memCopy(st->s, sn->s, 192);
+	st->buf_len = sn->buf_len, st->pos = sn->pos;
+}
+
+/*
+*******************************************************************************
+Экспорт / импорт
+
+\remark Длина буфера не экспортируется: она определяется по параметрам l, d
+и признаку ключевого режима (см. таблицу в начале файла).
+*******************************************************************************
+*/
+
+void bashPrgExport(octet buf[], const void* state)
+{
+	const bash_prg_st* st = (const bash_prg_st*)state;
+	ASSERT(memIsValid(st, bashPrg_keep()));
+	ASSERT(memIsValid(buf, BASH_PRG_EXPORT_LEN));
+	ASSERT(st->pos < st->buf_len);
+	buf[0] = 0x78, buf[1] = 0x01;
+	buf[2] = (octet)(st->l / 16), buf[3] = (octet)st->d;
+	buf[4] = bashPrgIsKeymode(st) ? 1 : 0, buf[5] = (octet)st->pos;
+	memCopy(buf + 6, st->s, 192);
+}
+
+err_t bashPrgImport(void* state, const octet buf[])
+{
+	bash_prg_st* st = (bash_prg_st*)state;
+	size_t l, d, buf_len;
+	// проверить входные данные
+	if (!memIsValid(buf, BASH_PRG_EXPORT_LEN) ||
+		!memIsValid(state, bashPrg_keep()))
+		return ERR_BAD_INPUT;
+	// проверить формат
+	if (buf[0] != 0x78 || buf[1] != 0x01)
+		return ERR_BAD_FORMAT;
+	l = 16 * (size_t)buf[2], d = buf[3];
+	if (l != 128 && l != 192 && l != 256 || d != 1 && d != 2 || buf[4] > 1)
+		return ERR_BAD_FORMAT;
+	buf_len = buf[4] ? 192 - (l + d * l / 2) / 8 : 192 - d * l / 4;
+	if (buf[5] >= buf_len)
+		return ERR_BAD_FORMAT;
+	// восстановить автомат
+	st->l = l, st->d = d;
+	memCopy(st->s, buf + 6, 192);
+	st->buf_len = buf_len, st->pos = buf[5];
+	return ERR_OK;
+}
+
 /*
 *******************************************************************************
 Ratchet: необратимо изменить
@@ -0,0 +1,259 @@
+/*
+*******************************************************************************
+\file bash_tree.c
+\brief STB 34.101.77 (bash): tree hashing over bash-prg
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "bee2/core/blob.h"
+#include "bee2/core/err.h"
+#include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
+#include "bee2/core/stack.h"
+#include "bee2/core/u64.h"
+#include "bee2/core/util.h"
+#include "bee2/crypto/bash.h"
+
+/*
+*******************************************************************************
+Древовидное хэширование
+
+Сообщение разбивается на листья по BASH_PRG_TREE_LEAF октетов (последний
+лист может быть неполным, пустое сообщение состоит из одного пустого листа).
+Лист с номером i хэшируется программируемым автоматом с анонсом
+	"LEAF" || <i>_64,
+хэш-значение листа имеет длину l / 4 октетов.
+
+Хэш-значения листьев последовательно загружаются в корневой автомат с анонсом
+"ROOT". После хэш-значений загружается число листьев n в формате <n>_64.
+Хэш-значение сообщения выгружается из корневого автомата.
+
+Листья обрабатываются независимо, поэтому их можно хэшировать параллельно.
+Вслед за заголовком bash_prg_tree_st последовательно размещаются:
+1) корневой автомат [bashPrg_keep_aligned()];
+2) автомат текущего листа [bashPrg_keep_aligned()];
+3) описатели потоков [threads * stackAlign(sizeof(bash_prg_tree_wk))];
+4) автоматы потоков [threads * bashPrg_keep_aligned()].
+Заголовок также занимает stackAlign(sizeof(bash_prg_tree_st)) октетов.
+Поэтому при выровненном состоянии (см. stack-align) все автоматы и
+описатели выровнены и занимают собственные строки кэша: потоки,
+которые одновременно пишут в свои автоматы и описатели, не делят
+строки кэша.
+
+Если в bashPrgTreeStepH() на границе листа поступает не менее двух полных
+листьев, то они распределяются между потоками: первый лист обрабатывается
+в вызывающем потоке, остальные -- в дополнительных. Если дополнительный поток
+создать не удалось, то его лист обрабатывается в вызывающем потоке.
+*******************************************************************************
+*/
+
+static const octet _leaf_tag[4] = { 'L', 'E', 'A', 'F' };
+static const octet _root_tag[4] = { 'R', 'O', 'O', 'T' };
+
+typedef struct {
+	size_t l;			/*< уровень стойкости */
+	size_t d;			/*< емкость */
+	u64 i;				/*< номер листа */
+	const octet* leaf;	/*< лист */
+	octet y[64];		/*< хэш-значение листа */
+	mt_thrd_t thrd;		/*< поток */
+	void* prg;			/*< автомат */
+} bash_prg_tree_wk;
+
+typedef struct {
+	size_t l;			/*< уровень стойкости */
+	size_t d;			/*< емкость */
+	size_t threads;		/*< число потоков */
+	u64 n;				/*< число обработанных листьев */
+	size_t pos;			/*< число октетов текущего листа */
+} bash_prg_tree_st;
+
+// корневой автомат
+#define bashPrgTreeRoot(st)\
+	((octet*)(st) + stackAlign(sizeof(bash_prg_tree_st)))
+
+// автомат текущего листа
+#define bashPrgTreeCur(st)\
+	(bashPrgTreeRoot(st) + bashPrg_keep_aligned())
+
+// описатель потока t
+#define bashPrgTreeWk(st, t)\
+	((bash_prg_tree_wk*)(bashPrgTreeRoot(st) + 2 * bashPrg_keep_aligned() +\
+		(t) * stackAlign(sizeof(bash_prg_tree_wk))))
+
+size_t bashPrgTree_keep(size_t threads)
+{
+	threads = MAX2(threads, 1);
+	return stackAlign(sizeof(bash_prg_tree_st)) +
+		2 * bashPrg_keep_aligned() + threads *
+		(stackAlign(sizeof(bash_prg_tree_wk)) + bashPrg_keep_aligned());
+}
+
+/*
+*******************************************************************************
+Хэширование листа
+*******************************************************************************
+*/
+
+static void bashPrgTreeLeafStart(size_t l, size_t d, u64 i, void* prg)
+{
+	octet ann[12];
+	memCopy(ann, _leaf_tag, 4);
+	u64To(ann + 4, 8, &i);
+	bashPrgStart(prg, l, d, ann, sizeof(ann), 0, 0);
+	bashPrgAbsorbStart(prg);
+}
+
+static void bashPrgTreeLeaf(void* arg)
+{
+	bash_prg_tree_wk* wk = (bash_prg_tree_wk*)arg;
+	bashPrgTreeLeafStart(wk->l, wk->d, wk->i, wk->prg);
+	bashPrgAbsorbStep(wk->leaf, BASH_PRG_TREE_LEAF, wk->prg);
+	bashPrgSqueeze(wk->y, wk->l / 4, wk->prg);
+}
+
+/*
+*******************************************************************************
+Хэширование
+*******************************************************************************
+*/
+
+void bashPrgTreeStart(void* state, size_t l, size_t d, size_t threads)
+{
+	bash_prg_tree_st* st = (bash_prg_tree_st*)state;
+	bash_prg_tree_wk* wk;
+	size_t t;
+	ASSERT(l == 128 || l == 192 || l == 256);
+	ASSERT(d == 1 || d == 2);
+	threads = MAX2(threads, 1);
+	ASSERT(memIsValid(state, bashPrgTree_keep(threads)));
+	// сохранить параметры
+	st->l = l, st->d = d, st->threads = threads;
+	st->n = 0, st->pos = 0;
+	// подготовить автоматы потоков
+	for (t = 0; t < threads; ++t)
+	{
+		wk = bashPrgTreeWk(st, t);
+		wk->l = l, wk->d = d;
+		wk->prg = (octet*)bashPrgTreeWk(st, threads) +
+			t * bashPrg_keep_aligned();
+	}
+	// запустить корень и первый лист
+	bashPrgStart(bashPrgTreeRoot(st), l, d, _root_tag, 4, 0, 0);
+	bashPrgAbsorbStart(bashPrgTreeRoot(st));
+	bashPrgTreeLeafStart(l, d, 0, bashPrgTreeCur(st));
+}
+
+static void bashPrgTreeLeafClose(void* state)
+{
+	bash_prg_tree_st* st = (bash_prg_tree_st*)state;
+	octet y[64];
+	bashPrgSqueeze(y, st->l / 4, bashPrgTreeCur(st));
+	bashPrgAbsorbStep(y, st->l / 4, bashPrgTreeRoot(st));
+	memWipe(y, sizeof(y));
+	st->n++, st->pos = 0;
+}
+
+void bashPrgTreeStepH(const void* buf, size_t count, void* state)
+{
+	bash_prg_tree_st* st = (bash_prg_tree_st*)state;
+	bash_prg_tree_wk* wk;
+	size_t k, t;
+	ASSERT(memIsDisjoint2(buf, count, state,
+		bashPrgTree_keep(st->threads)));
+	while (count)
+	{
+		// параллельная обработка полных листьев
+		if (st->pos == 0 && st->threads > 1 &&
+			(k = MIN2(st->threads, count / BASH_PRG_TREE_LEAF)) > 1)
+		{
+			for (t = 0; t < k; ++t)
+			{
+				wk = bashPrgTreeWk(st, t);
+				wk->i = st->n + t;
+				wk->leaf = (const octet*)buf + t * BASH_PRG_TREE_LEAF;
+			}
+			for (t = 1; t < k; ++t)
+			{
+				wk = bashPrgTreeWk(st, t);
+				if (!mtThrdCreate(&wk->thrd, bashPrgTreeLeaf, wk))
+					wk->leaf = 0;
+			}
+			bashPrgTreeLeaf(bashPrgTreeWk(st, 0));
+			for (t = 1; t < k; ++t)
+			{
+				wk = bashPrgTreeWk(st, t);
+				if (wk->leaf)
+					mtThrdJoin(&wk->thrd);
+				else
+					wk->leaf = (const octet*)buf + t * BASH_PRG_TREE_LEAF,
+					bashPrgTreeLeaf(wk);
+			}
+			// загрузить хэш-значения листьев в корень
+			for (t = 0; t < k; ++t)
+				bashPrgAbsorbStep(bashPrgTreeWk(st, t)->y, st->l / 4,
+					bashPrgTreeRoot(st));
+			st->n += k;
+			buf = (const octet*)buf + k * BASH_PRG_TREE_LEAF;
+			count -= k * BASH_PRG_TREE_LEAF;
+			// начать следующий лист
+			bashPrgTreeLeafStart(st->l, st->d, st->n,
+				bashPrgTreeCur(st));
+			continue;
+		}
+		// последовательная обработка
+		k = MIN2(count, BASH_PRG_TREE_LEAF - st->pos);
+		bashPrgAbsorbStep(buf, k, bashPrgTreeCur(st));
+		buf = (const octet*)buf + k, count -= k;
+		if ((st->pos += k) == BASH_PRG_TREE_LEAF)
+		{
+			bashPrgTreeLeafClose(state);
+			bashPrgTreeLeafStart(st->l, st->d, st->n,
+				bashPrgTreeCur(st));
+		}
+	}
+}
+
+void bashPrgTreeStepG(octet hash[], size_t hash_len, void* state)
+{
+	bash_prg_tree_st* st = (bash_prg_tree_st*)state;
+	octet n[8];
+	ASSERT(hash_len <= st->l / 4);
+	ASSERT(memIsDisjoint2(hash, hash_len, state,
+		bashPrgTree_keep(st->threads)));
+	// завершить неполный (или единственный пустой) лист
+	if (st->pos || st->n == 0)
+		bashPrgTreeLeafClose(state);
+	// загрузить число листьев
+	u64To(n, 8, &st->n);
+	bashPrgAbsorbStep(n, 8, bashPrgTreeRoot(st));
+	// выгрузить хэш-значение
+	bashPrgSqueeze(hash, hash_len, bashPrgTreeRoot(st));
+}
+
+err_t bashPrgTreeHash(octet hash[], size_t l, size_t d, const void* src,
+	size_t count, size_t threads)
+{
+	void* state;
+	// проверить входные данные
+	if (l != 128 && l != 192 && l != 256 || d != 1 && d != 2)
+		return ERR_BAD_PARAMS;
+	if (!memIsValid(src, count) || !memIsValid(hash, l / 4))
+		return ERR_BAD_INPUT;
+	// создать состояние
+	state = blobCreate(bashPrgTree_keep(threads));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// вычислить хэш-значение
+	bashPrgTreeStart(state, l, d, threads);
+	bashPrgTreeStepH(src, count, state);
+	bashPrgTreeStepG(hash, l / 4, state);
+	// завершить
+	blobClose(state);
+	return ERR_OK;
+}
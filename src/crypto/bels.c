@@ -4,7 +4,7 @@
 \brief STB 34.101.60 (bels): secret sharing algorithms
 \project bee2 [cryptographic library]
 \created 2013.05.14
-\version 2021.04.15
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,8 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/u32.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/bels.h"
@@ -83,7 +85,7 @@ err_t belsValM(const octet m0[], size_t len)
 		return ERR_BAD_INPUT;
 	// создать состояние
 	n = W_OF_O(len);
-	state = blobCreate(n + 1 + ppIsIrred_deep(n + 1));
+	state = stackCreate(O_OF_W(n + 1) + ppIsIrred_deep(n + 1));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// раскладка состояния
@@ -95,7 +97,7 @@ err_t belsValM(const octet m0[], size_t len)
 	// неприводим?
 	code = ppIsIrred(f0, n + 1, stack) ? ERR_OK : ERR_BAD_PUBKEY;
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
@@ -123,7 +125,7 @@ err_t belsGenM0(octet m0[], size_t len, gen_i ang, void* ang_state)
 		return ERR_BAD_INPUT;
 	// создать состояние
 	n = W_OF_O(len);
-	state = blobCreate(n + 1 + ppIsIrred_deep(n + 1));
+	state = stackCreate(O_OF_W(n + 1) + ppIsIrred_deep(n + 1));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// раскладка состояния
@@ -142,7 +144,7 @@ err_t belsGenM0(octet m0[], size_t len, gen_i ang, void* ang_state)
 		}
 	}
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return reps != SIZE_MAX ? ERR_OK : ERR_BAD_ANG;
 }
 
@@ -166,7 +168,7 @@ err_t belsGenMi(octet mi[], size_t len, const octet m0[], gen_i ang,
 	EXPECT(belsValM(m0, len) == ERR_OK);
 	// создать состояние
 	n = W_OF_O(len);
-	state = blobCreate(O_OF_W(2 * n + 2) + ppMinPolyMod_deep(n + 1));
+	state = stackCreate(O_OF_W(2 * n + 2) + ppMinPolyMod_deep(n + 1));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// раскладка состояния
@@ -198,7 +200,7 @@ err_t belsGenMi(octet mi[], size_t len, const octet m0[], gen_i ang,
 		code = ERR_BAD_ANG;
 	else 
 		code = ERR_BAD_PUBKEY;
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
@@ -219,7 +221,7 @@ err_t belsGenMid(octet mid[], size_t len, const octet m0[], const octet id[],
 	EXPECT(belsValM(m0, len) == ERR_OK);
 	// создать состояние
 	n = W_OF_O(len);
-	state = blobCreate(O_OF_W(2 * n + 2) + 32 + O_PER_W +
+	state = stackCreate(O_OF_W(2 * n + 2) + 32 + O_PER_W +
 		utilMax(2, 
 			beltHash_keep(),
 			ppMinPolyMod_deep(n + 1)));
@@ -254,10 +256,145 @@ err_t belsGenMid(octet mid[], size_t len, const octet m0[], const octet id[],
 		zzAddW2(u, n, 1);
 	}
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return reps != SIZE_MAX ? ERR_OK : ERR_BAD_PUBKEY;
 }
 
+/*
+*******************************************************************************
+Пакетная генерация и проверка открытых ключей
+
+Открытый ключ пользователя номер i генерируется функцией belsGenMid()
+по идентификатору seed || <i>_32. Поэтому результат определяется только
+затравкой seed и номером i и не зависит от порядка выполнения задач.
+Для каждого ключа ставится задача belsMTask(). Задачи выполняются в пуле
+потоков pool или, если pool == 0, последовательно. Память под состояния
+функций belsGenMid(), belsValM() выделяется в самих функциях, память
+задач (с идентификаторами) размещается в одном блобе.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	octet* mi;				/*< открытый ключ пользователя (при генерации) */
+	const octet* m;			/*< открытый ключ (при проверке) */
+	size_t len;				/*< длина ключа в октетах */
+	const octet* m0;		/*< общий открытый ключ (при генерации) */
+	const octet* id;		/*< идентификатор (при генерации) */
+	size_t id_len;			/*< длина идентификатора */
+	err_t code;				/*< код результата */
+} bels_m_task_st;
+
+static void belsMTask(void* arg, void* scratch)
+{
+	bels_m_task_st* task = (bels_m_task_st*)arg;
+	if (task->m0)
+		task->code = belsGenMid(task->mi, task->len, task->m0, task->id,
+			task->id_len);
+	else
+		task->code = belsValM(task->m, task->len);
+}
+
+static err_t belsMRun(bels_m_task_st tasks[], size_t count, mt_pool_t* pool)
+{
+	size_t i;
+	if (pool)
+	{
+		for (i = 0; i < count; ++i)
+			mtPoolSubmit(pool, belsMTask, tasks + i);
+		mtPoolWait(pool);
+	}
+	else
+		for (i = 0; i < count; ++i)
+			belsMTask(tasks + i, 0);
+	for (i = 0; i < count; ++i)
+		if (tasks[i].code != ERR_OK)
+			return tasks[i].code;
+	return ERR_OK;
+}
+
+err_t belsGenMiBatch(octet mi[], size_t count, size_t len, const octet m0[],
+	const octet seed[], size_t seed_len, mt_pool_t* pool)
+{
+	size_t i, j;
+	err_t code;
+	void* state;
+	bels_m_task_st* tasks;
+	octet* ids;
+	// проверить входные данные
+	if ((len != 16 && len != 24 && len != 32) ||
+		count > SIZE_MAX / len || seed_len > SIZE_MAX - 4 ||
+		!memIsValid(m0, len) || !memIsValid(seed, seed_len) ||
+		!memIsValid(mi, count * len))
+		return ERR_BAD_INPUT;
+	EXPECT(belsValM(m0, len) == ERR_OK);
+	if (count == 0)
+		return ERR_OK;
+	// создать состояние
+	if (count > SIZE_MAX / (sizeof(bels_m_task_st) + seed_len + 4))
+		return ERR_OUTOFMEMORY;
+	state = blobCreate(count * (sizeof(bels_m_task_st) + seed_len + 4));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// раскладка состояния
+	tasks = (bels_m_task_st*)state;
+	ids = (octet*)(tasks + count);
+	// задачи: id_i <- seed || <i>_32
+	for (i = 0; i < count; ++i)
+	{
+		u32 num = (u32)i;
+		tasks[i].mi = mi + i * len;
+		tasks[i].len = len;
+		tasks[i].m0 = m0;
+		tasks[i].id = ids + i * (seed_len + 4);
+		tasks[i].id_len = seed_len + 4;
+		memCopy(ids + i * (seed_len + 4), seed, seed_len);
+		u32To(ids + i * (seed_len + 4) + seed_len, 4, &num);
+	}
+	// выполнить задачи
+	code = belsMRun(tasks, count, pool);
+	// ключи различны?
+	for (i = 0; code == ERR_OK && i < count; ++i)
+		for (j = i + 1; code == ERR_OK && j < count; ++j)
+			if (memEq(mi + i * len, mi + j * len, len))
+				code = ERR_BAD_PUBKEY;
+	// завершение
+	blobClose(state);
+	return code;
+}
+
+err_t belsValMBatch(const octet m[], size_t count, size_t len,
+	mt_pool_t* pool)
+{
+	size_t i;
+	err_t code;
+	bels_m_task_st* tasks;
+	// проверить входные данные
+	if ((len != 16 && len != 24 && len != 32) ||
+		count > SIZE_MAX / len || !memIsValid(m, count * len))
+		return ERR_BAD_INPUT;
+	if (count == 0)
+		return ERR_OK;
+	// создать состояние
+	if (count > SIZE_MAX / sizeof(bels_m_task_st))
+		return ERR_OUTOFMEMORY;
+	tasks = (bels_m_task_st*)blobCreate(count * sizeof(bels_m_task_st));
+	if (tasks == 0)
+		return ERR_OUTOFMEMORY;
+	// задачи
+	for (i = 0; i < count; ++i)
+	{
+		tasks[i].m = m + i * len;
+		tasks[i].len = len;
+		tasks[i].m0 = 0;
+	}
+	// выполнить задачи
+	code = belsMRun(tasks, count, pool);
+	// завершение
+	blobClose(tasks);
+	return code;
+}
+
 /*
 *******************************************************************************
 Генерация одноразового ключа
@@ -333,7 +470,7 @@ err_t belsShare(octet si[], size_t count, size_t threshold, size_t len,
 	EXPECT(belsValM(m0, len) == ERR_OK);
 	// создать состояние
 	n = W_OF_O(len);
-	state = blobCreate(O_OF_W(2 * threshold * n + 1) + 
+	state = stackCreate(O_OF_W(2 * threshold * n + 1) + 
 		utilMax(2, 
 			ppMul_deep(threshold * n - n, n),
 			ppMod_deep(threshold * n, n + 1)));
@@ -365,7 +502,7 @@ err_t belsShare(octet si[], size_t count, size_t threshold, size_t len,
 		wwTo(si + i * len, len, f);
 	}
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return ERR_OK;
 }
 
@@ -388,7 +525,7 @@ err_t belsShare2(octet si[], size_t count, size_t threshold, size_t len,
 		return ERR_BAD_INPUT;
 	// создать состояние
 	n = W_OF_O(len);
-	state = blobCreate(O_OF_W(2 * threshold * n + 1) +
+	state = stackCreate(O_OF_W(2 * threshold * n + 1) +
 		utilMax(2,
 			ppMul_deep(threshold * n - n, n),
 			ppMod_deep(threshold * n, n + 1)));
@@ -422,7 +559,7 @@ err_t belsShare2(octet si[], size_t count, size_t threshold, size_t len,
 		si[i * (len + 1)] = (octet)(i + 1);
 	}
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return ERR_OK;
 }
 
@@ -435,7 +572,7 @@ err_t belsShare3(octet si[], size_t count, size_t threshold, size_t len,
 	if ((len != 16 && len != 24 && len != 32) || !memIsValid(s, len)) 
 		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(belsGenk_keep());
+	state = stackCreate(belsGenk_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// запустить генератор
@@ -443,135 +580,363 @@ err_t belsShare3(octet si[], size_t count, size_t threshold, size_t len,
 	// разделить секрет
 	code = belsShare2(si, count, threshold, len, s, belsGenkStepR, state);
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
 /*
 *******************************************************************************
-Восстановление секрета
+Пакетное разделение
+
+Многочлены c_j(x) = (x^l + m0(x))k_j(x) + s_j(x) строятся для всех секретов
+s_j в вызывающем потоке (генератор rng вызывается последовательно). Затем
+для каждого пользователя i ставится задача belsShareTask(): многочлен
+f_i(x) = x^l + mi(x) строится однократно и используется для редукции всех
+c_j(x). Задачи выполняются в пуле потоков pool или, если pool == 0,
+последовательно.
 
-\todo Организовать вычисления так, чтобы не было медленных (без Карацубы)
-умножений "маленького" многочлена на "большой".
+Многочлены c_j(x) и память задач размещаются в одном блобе. У каждой
+задачи собственная память: память потоков пула (mtPoolCreate()::scratch)
+не используется, поскольку ее размер задается вне bels.
 *******************************************************************************
 */
 
-err_t belsRecover(octet s[], size_t count, size_t len, const octet si[], 
-	const octet m0[], const octet mi[])
+typedef struct
+{
+	size_t num;				/*< число секретов */
+	size_t count;			/*< число пользователей */
+	size_t threshold;		/*< пороговое число */
+	size_t len;				/*< длина секрета в октетах */
+	const word* c;			/*< [num * threshold * n]многочлены c_j(x) */
+	const octet* mi;		/*< открытые ключи пользователей */
+	octet* si;				/*< частичные секреты */
+} bels_batch_st;
+
+typedef struct
 {
-	size_t n, i, deep;
+	const bels_batch_st* batch;	/*< общие данные */
+	size_t i;					/*< номер пользователя */
+	word* stack;				/*< память задачи */
+} bels_task_st;
+
+static size_t belsShareTask_keep(size_t threshold, size_t len)
+{
+	const size_t n = W_OF_O(len);
+	return O_OF_W(2 * n + 2) + ppMod_deep(threshold * n, n + 1);
+}
+
+static void belsShareTask(void* arg, void* scratch)
+{
+	const bels_task_st* task = (const bels_task_st*)arg;
+	const bels_batch_st* b = task->batch;
+	const size_t n = W_OF_O(b->len);
+	const size_t m = b->threshold * n;
+	word* f = task->stack;
+	word* r = f + n + 1;
+	void* stack = r + n + 1;
+	size_t j;
+	// f(x) <- x^l + mi(x)
+	EXPECT(belsValM(b->mi + task->i * b->len, b->len) == ERR_OK);
+	wwFrom(f, b->mi + task->i * b->len, b->len);
+	f[n] = 1;
+	// s_ji(x) <- c_j(x) mod f(x)
+	for (j = 0; j < b->num; ++j)
+	{
+		ppMod(r, b->c + j * m, m, f, n + 1, stack);
+		wwTo(b->si + (j * b->count + task->i) * b->len, b->len, r);
+	}
+	wwSetZero(r, n + 1);
+}
+
+err_t belsShareBatch(octet si[], size_t num, size_t count, size_t threshold,
+	size_t len, const octet s[], const octet m0[], const octet mi[],
+	gen_i rng, void* rng_state, mt_pool_t* pool)
+{
+	size_t n, j, i;
+	size_t task_keep;
 	void* state;
-	word* f;
-	word* g;
-	word* d;
-	word* u;
-	word* v;
 	word* c;
-	word* t;
-	void* stack;
+	word* f;
+	word* k;
+	bels_batch_st batch[1];
+	bels_task_st* tasks;
+	octet* stack;
+	// проверить генератор
+	if (rng == 0)
+		return ERR_BAD_RNG;
 	// проверить входные данные
-	if ((len != 16 && len != 24 && len != 32) || count == 0 || 
-		!memIsValid(si, count * len) || !memIsValid(m0, len) || 
-		!memIsValid(mi, len * count) || !memIsValid(s, len))
+	if ((len != 16 && len != 24 && len != 32) ||
+		threshold == 0 || count < threshold ||
+		num > SIZE_MAX / count / len ||
+		!memIsValid(s, num * len) || !memIsValid(m0, len) ||
+		!memIsValid(mi, len * count) || !memIsValid(si, num * count * len))
 		return ERR_BAD_INPUT;
 	EXPECT(belsValM(m0, len) == ERR_OK);
-	// расчет глубины стека
-	n = W_OF_O(len);
-	deep = utilMax(2, 
-		ppMul_deep(n, n), 
-		ppMod_deep(count * n, n + 1));
-	for (i = 1; i < count; ++i)
-		deep = utilMax(6, 
-			deep, 
-			ppExGCD_deep(n + 1, i * n + 1),
-			ppMul_deep(i * n, i * n),
-			ppMul_deep(2 * i * n, n),
-			ppMul_deep(2 * n, i * n),
-			ppMod_deep((2 * i + 1) * n, (i + 1) * n + 1));
-	deep += O_OF_W(
-		n + 1 +			
-		count * n + 1 +
-		(count - 1) * n + 1 +
-		(count - 1) * n + 1 +
-		n + 1 +
-		(2 * count - 1) * n + 
-		MAX2((2 * count - 2) * n, (count + 1) * n));
+	if (num == 0)
+		return ERR_OK;
 	// создать состояние
-	state = blobCreate(deep);
+	n = W_OF_O(len);
+	task_keep = belsShareTask_keep(threshold, len);
+	state = blobCreate(O_OF_W(num * threshold * n + n + 1 + threshold * n) +
+		utilMax(2,
+			ppMul_deep(threshold * n - n, n),
+			count * (sizeof(bels_task_st) + task_keep)));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// раскладка состояния
-	f = (word*)state;
-	g = f + n + 1;
-	d = g + count * n + 1;
-	u = d + (count - 1) * n + 1;
-	v = u + (count - 1) * n + 1;
-	c = v + n + 1;
-	t = c + (2 * count - 1) * n;
-	stack = t + MAX2((2 * count - 2) * n, (count + 1) * n);
-	// [n]c(x) <- s1(x)
-	wwFrom(c, si, len);
-	// [n + 1]g(x) <- x^l + m1(x)
-	wwFrom(g, mi, len), g[n] = 1;
+	c = (word*)state;
+	f = c + num * threshold * n;
+	k = f + n + 1;
+	stack = (octet*)(k + threshold * n);
+	// c_j(x) <- (x^l + m0(x))k_j(x) + s_j(x)
+	wwFrom(f, m0, len);
+	for (j = 0; j < num; ++j)
+	{
+		word* cj = c + j * threshold * n;
+		rng(k, threshold * len - len, rng_state);
+		wwFrom(k, k, threshold * len - len);
+		ppMul(cj, k, threshold * n - n, f, n, stack);
+		wwXor2(cj + n, k, threshold * n - n);
+		wwFrom(k, s + j * len, len);
+		wwXor2(cj, k, n);
+	}
+	wwSetZero(k, threshold * n);
+	// задачи
+	batch->num = num, batch->count = count, batch->threshold = threshold;
+	batch->len = len, batch->c = c, batch->mi = mi, batch->si = si;
+	tasks = (bels_task_st*)stack;
+	stack += count * sizeof(bels_task_st);
+	for (i = 0; i < count; ++i)
+	{
+		tasks[i].batch = batch;
+		tasks[i].i = i;
+		tasks[i].stack = (word*)(stack + i * task_keep);
+	}
+	// выполнить задачи
+	if (pool)
+	{
+		for (i = 0; i < count; ++i)
+			mtPoolSubmit(pool, belsShareTask, tasks + i);
+		mtPoolWait(pool);
+	}
+	else
+		for (i = 0; i < count; ++i)
+			belsShareTask(tasks + i, 0);
+	// завершение
+	blobClose(state);
+	return ERR_OK;
+}
+
+/*
+*******************************************************************************
+Восстановление секрета
+
+Пусть f_i(x) = x^l + m_i(x), i = 1, 2,..., t, -- модули пользователей,
+F(x) = f_1(x)...f_t(x), M_i(x) = F(x) / f_i(x). Многочлен c(x) степени
+меньше t * l, для которого c(x) = s_i(x) \mod f_i(x), определяется
+по формуле Лагранжа:
+	c(x) = \sum_i r_i(x)M_i(x), r_i(x) = s_i(x)v_i(x) \mod f_i(x),
+где v_i(x) = M_i(x)^{-1} \mod f_i(x). Каждое слагаемое имеет степень
+меньше t * l, поэтому дополнительная редукция по модулю F(x) не нужна.
+Следовательно,
+	s(x) = c(x) \mod f_0(x) = \sum_i r_i(x)w_i(x) \mod f_0(x),
+где w_i(x) = M_i(x) \mod f_0(x).
+
+Многочлены v_i(x), w_i(x) зависят только от открытых ключей и
+рассчитываются в belsRecoverStart(). При этом используется то, что все
+модули имеют одинаковую степень l и старший коэффициент 1:
+	f_j(x) \mod f_i(x) = m_i(x) + m_j(x),
+и поэтому
+	M_i(x) \mod f_i(x) = \prod_{j != i} (m_i(x) + m_j(x)) \mod f_i(x),
+	w_i(x) = \prod_{j != i} (m_0(x) + m_j(x)) \mod f_0(x).
+Предвычисление требует O(t^2) умножений многочленов степени меньше l
+и t обращений по модулям f_i(x). Восстановление секрета после
+предвычисления требует O(t) таких умножений.
+
+Взаимная простота модулей f_i(x) проверяется при обращении M_i(x).
+*******************************************************************************
+*/
+
+typedef struct
+{
+	size_t count;		/*< число пользователей */
+	size_t len;			/*< длина секрета в октетах */
+	word data[];		/*< f0, f_i, v_i, w_i, рабочая память */
+} bels_recover_st;
+
+#define belsRecoverF0(st, n) ((st)->data)
+#define belsRecoverF(st, n, i) ((st)->data + (n) + 1 + (i) * ((n) + 1))
+#define belsRecoverV(st, n, i)\
+	((st)->data + ((st)->count + 1) * ((n) + 1) + (i) * (n))
+#define belsRecoverW(st, n, i)\
+	((st)->data + ((st)->count + 1) * ((n) + 1) + ((st)->count + (i)) * (n))
+#define belsRecoverStack(st, n)\
+	((st)->data + ((st)->count + 1) * ((n) + 1) + 2 * (st)->count * (n))
+
+static size_t belsRecoverStack_deep(size_t n)
+{
+	return O_OF_W(2 * n + 2 * n + 6 * (n + 1)) +
+		utilMax(3,
+			ppMul_deep(n, n),
+			ppMod_deep(2 * n, n + 1),
+			ppExGCD_deep(n, n + 1));
+}
+
+size_t belsRecover_keep(size_t count, size_t len)
+{
+	const size_t n = W_OF_O(len);
+	return sizeof(bels_recover_st) +
+		O_OF_W((count + 1) * (n + 1) + 2 * count * n) +
+		belsRecoverStack_deep(n);
+}
+
+err_t belsRecoverStart(void* state, size_t count, size_t len,
+	const octet m0[], const octet mi[])
+{
+	bels_recover_st* st = (bels_recover_st*)state;
+	size_t n, i, j;
+	word* f0;
+	word* a;
+	word* b;
+	word* e;
+	word* d;
+	word* da;
+	word* db;
+	word* prod;
+	void* stack;
+	// проверить входные данные
+	if ((len != 16 && len != 24 && len != 32) || count == 0 ||
+		!memIsValid(state, belsRecover_keep(count, len)) ||
+		!memIsValid(m0, len) || !memIsValid(mi, len * count))
+		return ERR_BAD_INPUT;
+	EXPECT(belsValM(m0, len) == ERR_OK);
+	// раскладка состояния
+	n = W_OF_O(len);
+	st->count = count, st->len = len;
+	f0 = belsRecoverF0(st, n);
+	a = belsRecoverStack(st, n);
+	b = a + n + 1;
+	e = b + n + 1;
+	d = e + n + 1;
+	da = d + n + 1;
+	db = da + n + 1;
+	prod = db + n + 1;
+	stack = prod + 4 * n;
+	// f0 <- x^l + m0(x), f_i <- x^l + m_i(x)
+	wwFrom(f0, m0, len), f0[n] = 1;
+	for (i = 0; i < count; ++i)
+	{
+		EXPECT(belsValM(mi + i * len, len) == ERR_OK);
+		wwFrom(belsRecoverF(st, n, i), mi + i * len, len);
+		belsRecoverF(st, n, i)[n] = 1;
+	}
 	// цикл по пользователям
-	for (f[n] = 1, i = 1; i < count; ++i)
+	for (i = 0; i < count; ++i)
 	{
-		// [n + 1]f(x) <- x^l + mi(x)
-		wwFrom(f, mi + i * len, len);
-		// найти d(x) = \gcd(f(x), g(x)) и коэфф. Безу [i * n]u(x), [n]v(x)
-		ppExGCD(d, u, v, f, n + 1, g, i * n + 1, stack);
-		ASSERT(u[i * n] == 0 && v[n] == 0);
-		// d(x) != 1? 
-		if (wwCmpW(d, i * n + 1, 1) != 0)
+		word* fi = belsRecoverF(st, n, i);
+		// a(x) <- M_i(x) \mod f_i(x), b(x) <- M_i(x) \mod f_0(x)
+		wwSetW(a, n, 1), wwSetW(b, n, 1);
+		for (j = 0; j < count; ++j)
+		{
+			if (j == i)
+				continue;
+			wwXor(e, fi, belsRecoverF(st, n, j), n);
+			ppMul(prod, a, n, e, n, stack);
+			ppMod(a, prod, 2 * n, fi, n + 1, stack);
+			wwXor(e, f0, belsRecoverF(st, n, j), n);
+			ppMul(prod, b, n, e, n, stack);
+			ppMod(b, prod, 2 * n, f0, n + 1, stack);
+		}
+		// v_i(x) <- a(x)^{-1} \mod f_i(x)
+		if (wwIsZero(a, n))
+		{
+			memWipe(a, belsRecoverStack_deep(n));
+			return ERR_BAD_PUBKEY;
+		}
+		ppExGCD(d, da, db, a, n, fi, n + 1, stack);
+		if (wwCmpW(d, n, 1) != 0)
 		{
-			blobClose(state);
+			memWipe(a, belsRecoverStack_deep(n));
 			return ERR_BAD_PUBKEY;
 		}
-		// [2 * i * n]c(x) <- u(x)f(x)c(x)
-		// (с помощью [2 * i * n]t)
-		ppMul(t, u, i * n, c, i * n, stack);
-		ppMul(c, t, 2 * i * n, f, n, stack);
-		wwXor2(c + n, t, 2 * i * n);
-		// c(x) <- c(x) + v(x)g(x)si(x)
-		// (с помощью [2 * n]d и [(i + 2) * n]t)
-		wwFrom(t, si + i * len, len);
-		ppMul(d, v, n, t, n, stack);
-		ppMul(t, d, 2 * n, g, i * n, stack);
-		wwXor2(t + i * n, d, 2 * n);
-		wwXor2(c, t, (i + 2) * n);
-		// [(i + 1) * n + 1]g(x) <- g(x)f(x)
-		// (с помощью [(i + 1) * n]t)
-		ppMul(t, f, n, g, i * n, stack);
-		wwXor2(t + n, g, i * n);
-		wwXor2(t + i * n, f, n);
-		wwCopy(g, t, (i + 1) * n);
-		g[(i + 1) * n] = 1;
-		// [(i + 1) * n]c(x) <- c(x) mod g(x)
-		ppMod(c, c, (2 * i + 1) * n, g, (i + 1) * n + 1, stack);
-		ASSERT(c[(i + 1) * n] == 0);
+		ASSERT(da[n] == 0);
+		wwCopy(belsRecoverV(st, n, i), da, n);
+		// w_i(x) <- b(x)
+		wwCopy(belsRecoverW(st, n, i), b, n);
 	}
-	// [n]s(x) <- c(x) mod (x^l + m0(x))
-	wwFrom(f, m0, len), f[n] = 1;
-	ppMod(c, c, count * n, f, n + 1, stack);
-	ASSERT(c[n] == 0);
-	wwTo(s, len, c);
 	// завершение
-	blobClose(state);
+	memWipe(a, belsRecoverStack_deep(n));
 	return ERR_OK;
 }
 
-err_t belsRecover2(octet s[], size_t count, size_t len, const octet si[])
+void belsRecoverStepR(octet s[], const octet si[], void* state)
 {
-	size_t n, i, j, deep;
-	void* state;
-	word* f;
-	word* g;
-	word* d;
-	word* u;
-	word* v;
+	bels_recover_st* st = (bels_recover_st*)state;
+	size_t n, i;
 	word* c;
-	word* t;
+	word* r;
+	word* prod;
 	void* stack;
+	// pre
+	ASSERT(memIsValid(st, sizeof(bels_recover_st)));
+	ASSERT(memIsValid(state, belsRecover_keep(st->count, st->len)));
+	ASSERT(memIsValid(si, st->count * st->len));
+	ASSERT(memIsValid(s, st->len));
+	// раскладка состояния
+	n = W_OF_O(st->len);
+	c = belsRecoverStack(st, n);
+	r = c + 2 * n;
+	prod = r + n + 1;
+	stack = prod + 2 * n;
+	// c(x) <- \sum_i (s_i(x)v_i(x) \mod f_i(x))w_i(x)
+	wwSetZero(c, 2 * n);
+	for (i = 0; i < st->count; ++i)
+	{
+		wwFrom(r, si + i * st->len, st->len);
+		ppMul(prod, r, n, belsRecoverV(st, n, i), n, stack);
+		ppMod(r, prod, 2 * n, belsRecoverF(st, n, i), n + 1, stack);
+		ASSERT(r[n] == 0);
+		ppMul(prod, r, n, belsRecoverW(st, n, i), n, stack);
+		wwXor2(c, prod, 2 * n);
+	}
+	// s(x) <- c(x) \mod f_0(x)
+	ppMod(r, c, 2 * n, belsRecoverF0(st, n), n + 1, stack);
+	ASSERT(r[n] == 0);
+	wwTo(s, st->len, r);
+	// очистка
+	memWipe(c, belsRecoverStack_deep(n));
+}
+
+err_t belsRecover(octet s[], size_t count, size_t len, const octet si[], 
+	const octet m0[], const octet mi[])
+{
+	void* state;
+	err_t code;
+	// проверить входные данные
+	if ((len != 16 && len != 24 && len != 32) || count == 0 || 
+		!memIsValid(si, count * len) || !memIsValid(m0, len) || 
+		!memIsValid(mi, len * count) || !memIsValid(s, len))
+		return ERR_BAD_INPUT;
+	// создать состояние
+	state = stackCreate(belsRecover_keep(count, len));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// восстановить секрет
+	code = belsRecoverStart(state, count, len, m0, mi);
+	if (code == ERR_OK)
+		belsRecoverStepR(s, si, state);
+	// завершение
+	stackClose(state);
+	return code;
+}
+
+err_t belsRecover2(octet s[], size_t count, size_t len, const octet si[])
+{
+	size_t i, j;
+	void* state;
+	octet* m;
+	octet* sj;
+	err_t code;
 	// проверить входные данные
 	if ((len != 16 && len != 24 && len != 32) || count == 0 || count > 16 ||
 		!memIsValid(si, count * (len + 1)) || !memIsValid(s, len))
@@ -585,90 +950,24 @@ err_t belsRecover2(octet s[], size_t count, size_t len, const octet si[])
 			if (si[i * (len + 1)] == si[j * (len + 1)])
 				return ERR_BAD_PUBKEY;
 	}
-	// расчет глубины стека
-	n = W_OF_O(len);
-	deep = utilMax(2,
-		ppMul_deep(n, n),
-		ppMod_deep(count * n, n + 1));
-	for (i = 1; i < count; ++i)
-		deep = utilMax(6,
-			deep,
-			ppExGCD_deep(n + 1, i * n + 1),
-			ppMul_deep(i * n, i * n),
-			ppMul_deep(2 * i * n, n),
-			ppMul_deep(2 * n, i * n),
-			ppMod_deep((2 * i + 1) * n, (i + 1) * n + 1));
-	deep += O_OF_W(
-		n + 1 +
-		count * n + 1 +
-		(count - 1) * n + 1 +
-		(count - 1) * n + 1 +
-		n + 1 +
-		(2 * count - 1) * n +
-		MAX2((2 * count - 2) * n, (count + 1) * n));
 	// создать состояние
-	state = blobCreate(deep);
+	state = stackCreate(belsRecover_keep(count, len) + 2 * (count + 1) * len);
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
-	// раскладка состояния
-	f = (word*)state;
-	g = f + n + 1;
-	d = g + count * n + 1;
-	u = d + (count - 1) * n + 1;
-	v = u + (count - 1) * n + 1;
-	c = v + n + 1;
-	t = c + (2 * count - 1) * n;
-	stack = t + MAX2((2 * count - 2) * n, (count + 1) * n);
-	// [n]c(x) <- s1(x)
-	wwFrom(c, si + 1, len);
-	// [n + 1]g(x) <- x^l + m1(x)
-	belsStdM((octet*)g, len, si[0]);
-	wwFrom(g, g, len), g[n] = 1;
-	// цикл по пользователям
-	for (f[n] = 1, i = 1; i < count; ++i)
+	m = (octet*)state + belsRecover_keep(count, len);
+	sj = m + (count + 1) * len;
+	// стандартные открытые ключи и частичные секреты без номеров
+	belsStdM(m, len, 0);
+	for (i = 0; i < count; ++i)
 	{
-		// [n + 1]f(x) <- x^l + mi(x)
-		belsStdM((octet*)f, len, si[i * (len + 1)]);
-		wwFrom(f, f, len);
-		// найти d(x) = \gcd(f(x), g(x)) и коэфф. Безу [i * n]u(x), [n]v(x)
-		ppExGCD(d, u, v, f, n + 1, g, i * n + 1, stack);
-		ASSERT(u[i * n] == 0 && v[n] == 0);
-		// d(x) != 1? 
-		if (wwCmpW(d, i * n + 1, 1) != 0)
-		{
-			blobClose(state);
-			return ERR_BAD_PUBKEY;
-		}
-		// [2 * i * n]c(x) <- u(x)f(x)c(x)
-		// (с помощью [2 * i * n]t)
-		ppMul(t, u, i * n, c, i * n, stack);
-		ppMul(c, t, 2 * i * n, f, n, stack);
-		wwXor2(c + n, t, 2 * i * n);
-		// c(x) <- c(x) + v(x)g(x)si(x)
-		// (с помощью [2 * n]d и [(i + 2) * n]t)
-		wwFrom(t, si + i * (len + 1) + 1, len);
-		ppMul(d, v, n, t, n, stack);
-		ppMul(t, d, 2 * n, g, i * n, stack);
-		wwXor2(t + i * n, d, 2 * n);
-		wwXor2(c, t, (i + 2) * n);
-		// [(i + 1) * n + 1]g(x) <- g(x)f(x)
-		// (с помощью [(i + 1) * n]t)
-		ppMul(t, f, n, g, i * n, stack);
-		wwXor2(t + n, g, i * n);
-		wwXor2(t + i * n, f, n);
-		wwCopy(g, t, (i + 1) * n);
-		g[(i + 1) * n] = 1;
-		// [(i + 1) * n]c(x) <- c(x) mod g(x)
-		ppMod(c, c, (2 * i + 1) * n, g, (i + 1) * n + 1, stack);
-		ASSERT(c[(i + 1) * n] == 0);
+		belsStdM(m + (i + 1) * len, len, si[i * (len + 1)]);
+		memCopy(sj + i * len, si + i * (len + 1) + 1, len);
 	}
-	// [n]s(x) <- c(x) mod (x^l + m0(x))
-	belsStdM((octet*)f, len, 0);
-	wwFrom(f, f, len), f[n] = 1;
-	ppMod(c, c, count * n, f, n + 1, stack);
-	ASSERT(c[n] == 0);
-	wwTo(s, len, c);
+	// восстановить секрет
+	code = belsRecoverStart(state, count, len, m, m + len);
+	if (code == ERR_OK)
+		belsRecoverStepR(s, sj, state);
 	// завершение
-	blobClose(state);
-	return ERR_OK;
+	stackClose(state);
+	return code;
 }
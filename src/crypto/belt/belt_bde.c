@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): BDE (Blockwise Disk Encryption)
 \project bee2 [cryptographic library]
 \created 2018.06.28
-\version 2020.03.24
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -28,6 +28,9 @@ typedef struct
 	u32 key[8];			/*< форматированный ключ */
 	u32 s[4];			/*< переменная s */
 	octet block[16];	/*< вспомогательный блок */
+	u32 blocks[16];		/*< четверка блоков данных */
+	u32 ss[16];			/*< четверка значений s */
+	u32 ctr[4];			/*< номер сектора */
 } belt_bde_st;
 
 size_t beltBDE_keep()
@@ -50,6 +53,22 @@ void beltBDEStepE(void* buf, size_t count, void* state)
 	belt_bde_st* st = (belt_bde_st*)state;
 	ASSERT(count % 16 == 0);
 	ASSERT(memIsDisjoint2(buf, count, state, beltBDE_keep()));
+	// цикл по четверкам блоков
+	for (; count >= 64; count -= 64)
+	{
+		size_t i;
+		for (i = 0; i < 16; i += 4)
+		{
+			beltBlockMulC(st->s);
+			beltBlockCopy(st->ss + i, st->s);
+		}
+		u32From(st->blocks, buf, 64);
+		beltBlocksXor2(st->blocks, st->ss, 4);
+		beltBlockEncrN(st->blocks, 4, st->key);
+		beltBlocksXor2(st->blocks, st->ss, 4);
+		u32To(buf, 64, st->blocks);
+		buf = (octet*)buf + 64;
+	}
 	// цикл по блокам
 	while(count >= 16)
 	{
@@ -68,6 +87,22 @@ void beltBDEStepD(void* buf, size_t count, void* state)
 	belt_bde_st* st = (belt_bde_st*)state;
 	ASSERT(count % 16 == 0);
 	ASSERT(memIsDisjoint2(buf, count, state, beltBDE_keep()));
+	// цикл по четверкам блоков
+	for (; count >= 64; count -= 64)
+	{
+		size_t i;
+		for (i = 0; i < 16; i += 4)
+		{
+			beltBlockMulC(st->s);
+			beltBlockCopy(st->ss + i, st->s);
+		}
+		u32From(st->blocks, buf, 64);
+		beltBlocksXor2(st->blocks, st->ss, 4);
+		beltBlockDecrN(st->blocks, 4, st->key);
+		beltBlocksXor2(st->blocks, st->ss, 4);
+		u32To(buf, 64, st->blocks);
+		buf = (octet*)buf + 64;
+	}
 	// цикл по блокам
 	while(count >= 16)
 	{
@@ -130,3 +165,65 @@ err_t beltBDEDecr(void* dest, const void* src, size_t count,
 	blobClose(state);
 	return ERR_OK;
 }
+
+/*
+*******************************************************************************
+Шифрование секторов в режиме BDE
+
+Синхропосылка сектора интерпретируется как номер сектора, записанный 
+по правилам little-endian. Номер сектора хранится в st->ctr. 
+Инициализация st->s для очередного сектора выполняется без повторного 
+разбора ключа.
+*******************************************************************************
+*/
+
+static err_t beltBDESectors(void* dest, const void* src, size_t count,
+	size_t sector_len, const octet key[], size_t len, const octet iv[16],
+	void (*step)(void*, size_t, void*))
+{
+	void* state;
+	belt_bde_st* st;
+	// проверить входные данные
+	if (sector_len % 16 != 0 || sector_len < 16 ||
+		count % sector_len != 0 || count < sector_len ||
+		len != 16 && len != 24 && len != 32 ||
+		!memIsValid(src, count) ||
+		!memIsValid(key, len) ||
+		!memIsValid(iv, 16) ||
+		!memIsValid(dest, count))
+		return ERR_BAD_INPUT;
+	// создать состояние
+	state = blobCreate(beltBDE_keep());
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	st = (belt_bde_st*)state;
+	// обработать секторы
+	beltKeyExpand2(st->key, key, len);
+	u32From(st->ctr, iv, 16);
+	memMove(dest, src, count);
+	for (; count; count -= sector_len)
+	{
+		beltBlockCopy(st->s, st->ctr);
+		beltBlockEncr2(st->s, st->key);
+		step(dest, sector_len, state);
+		beltBlockIncU32(st->ctr);
+		dest = (octet*)dest + sector_len;
+	}
+	// завершить
+	blobClose(state);
+	return ERR_OK;
+}
+
+err_t beltBDEEncrSectors(void* dest, const void* src, size_t count,
+	size_t sector_len, const octet key[], size_t len, const octet iv[16])
+{
+	return beltBDESectors(dest, src, count, sector_len, key, len, iv, 
+		beltBDEStepE);
+}
+
+err_t beltBDEDecrSectors(void* dest, const void* src, size_t count,
+	size_t sector_len, const octet key[], size_t len, const octet iv[16])
+{
+	return beltBDESectors(dest, src, count, sector_len, key, len, iv, 
+		beltBDEStepD);
+}
@@ -4,16 +4,18 @@
 \brief STB 34.101.31 (belt): block encryption
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2024.02.26
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include "bee2/core/err.h"
 #include "bee2/core/mem.h"
 #include "bee2/core/u32.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
+#include "bee2/crypto/prov.h"
 #include "belt_lcl.h"
 
 /*
@@ -108,6 +110,20 @@ void beltKeyExpand2(u32 key_[8], const octet key[], size_t len)
 	}
 }
 
+size_t beltKey_keep()
+{
+	return sizeof(belt_key_st);
+}
+
+void beltKeyStart(void* skey, const octet key[], size_t len)
+{
+	belt_key_st* sk = (belt_key_st*)skey;
+	ASSERT(memIsValid(skey, beltKey_keep()));
+	beltKeyExpand2(sk->key, key, len);
+	beltBlockSetZero(sk->r);
+	beltBlockEncr2(sk->r, sk->key);
+}
+
 /*
 *******************************************************************************
 Расширенные H-блоки
@@ -289,6 +305,129 @@ a <-> b, c <-> d, a <-> d.
 	*c ^= *d, *d ^= *c, *c ^= *d;\
 	*a ^= *d, *d ^= *a, *a ^= *d;\
 
+/*
+*******************************************************************************
+Такты обработки четырех блоков
+
+Макросы R4, E4, D4 реализуют одновременное зашифрование (расшифрование)
+четырех независимых блоков t[0], t[1], t[2], t[3]. Шаги алгоритма
+выполняются над блоками поочередно. Поэтому цепочки зависимостей
+по данным, которые образуют обращения к таблицам H5, H13, H21, H29,
+чередуются и процессор может обрабатывать их параллельно.
+
+В отличие от макроса R, регистры a, b, c, d задаются не указателями,
+а номерами слов блоков. Окончательные перестановки регистров реализуются
+макросом S4. Макрос KS выбирает ключ блока: блоки могут обрабатываться
+как на общем ключе, так и на разных ключах.
+*******************************************************************************
+*/
+/*
+*******************************************************************************
+Выбор ключей
+
+Макрос key1 задает общий ключ для всех блоков, макрос key4 -- свой ключ
+для каждого блока.
+*******************************************************************************
+*/
+#define key1(K, j) (K)
+#define key4(K, j) (K)[j]
+
+#define G4(t, x, op, G, y, KS, K, i, j, subkey, e)\
+	t[0][x] op G(t[0][y] + subkey(KS(K, 0), i, j)) ^ (e),\
+	t[1][x] op G(t[1][y] + subkey(KS(K, 1), i, j)) ^ (e),\
+	t[2][x] op G(t[2][y] + subkey(KS(K, 2), i, j)) ^ (e),\
+	t[3][x] op G(t[3][y] + subkey(KS(K, 3), i, j)) ^ (e)\
+
+#define A4(t, x, op, y)\
+	t[0][x] op t[0][y],\
+	t[1][x] op t[1][y],\
+	t[2][x] op t[2][y],\
+	t[3][x] op t[3][y]\
+
+#define S4(t, x, y)\
+	A4(t, x, ^=, y), A4(t, y, ^=, x), A4(t, x, ^=, y)\
+
+#define R4(t, a, b, c, d, KS, K, i, subkey)\
+	G4(t, b, ^=, G5, a, KS, K, i, 0, subkey, 0);\
+	G4(t, c, ^=, G21, d, KS, K, i, 1, subkey, 0);\
+	G4(t, a, -=, G13, b, KS, K, i, 2, subkey, 0);\
+	A4(t, c, +=, b);\
+	G4(t, b, +=, G21, c, KS, K, i, 3, subkey, i);\
+	A4(t, c, -=, b);\
+	G4(t, d, +=, G13, c, KS, K, i, 4, subkey, 0);\
+	G4(t, b, ^=, G21, a, KS, K, i, 5, subkey, 0);\
+	G4(t, c, ^=, G5, d, KS, K, i, 6, subkey, 0);\
+
+#define E4(t, KS, K)\
+	R4(t, 0, 1, 2, 3, KS, K, 1, subkey_e);\
+	R4(t, 1, 3, 0, 2, KS, K, 2, subkey_e);\
+	R4(t, 3, 2, 1, 0, KS, K, 3, subkey_e);\
+	R4(t, 2, 0, 3, 1, KS, K, 4, subkey_e);\
+	R4(t, 0, 1, 2, 3, KS, K, 5, subkey_e);\
+	R4(t, 1, 3, 0, 2, KS, K, 6, subkey_e);\
+	R4(t, 3, 2, 1, 0, KS, K, 7, subkey_e);\
+	R4(t, 2, 0, 3, 1, KS, K, 8, subkey_e);\
+	S4(t, 0, 1);\
+	S4(t, 2, 3);\
+	S4(t, 1, 2);\
+
+#define D4(t, KS, K)\
+	R4(t, 0, 1, 2, 3, KS, K, 8, subkey_d);\
+	R4(t, 2, 0, 3, 1, KS, K, 7, subkey_d);\
+	R4(t, 3, 2, 1, 0, KS, K, 6, subkey_d);\
+	R4(t, 1, 3, 0, 2, KS, K, 5, subkey_d);\
+	R4(t, 0, 1, 2, 3, KS, K, 4, subkey_d);\
+	R4(t, 2, 0, 3, 1, KS, K, 3, subkey_d);\
+	R4(t, 3, 2, 1, 0, KS, K, 2, subkey_d);\
+	R4(t, 1, 3, 0, 2, KS, K, 1, subkey_d);\
+	S4(t, 0, 1);\
+	S4(t, 2, 3);\
+	S4(t, 0, 3);\
+
+/*
+*******************************************************************************
+Такты обработки двух блоков
+
+Макросы R2, E2 аналогичны макросам R4, E4, но обрабатывают два блока
+t[0], t[1] на разных ключах K[0], K[1]. Чередование цепочек зависимостей
+сокращает критический путь, когда блоков всего два (см. beltCompr()).
+*******************************************************************************
+*/
+#define G2(t, x, op, G, y, K, i, j, subkey, e)\
+	t[0][x] op G(t[0][y] + subkey(K[0], i, j)) ^ (e),\
+	t[1][x] op G(t[1][y] + subkey(K[1], i, j)) ^ (e)\
+
+#define A2(t, x, op, y)\
+	t[0][x] op t[0][y],\
+	t[1][x] op t[1][y]\
+
+#define S2(t, x, y)\
+	A2(t, x, ^=, y), A2(t, y, ^=, x), A2(t, x, ^=, y)\
+
+#define R2(t, a, b, c, d, K, i, subkey)\
+	G2(t, b, ^=, G5, a, K, i, 0, subkey, 0);\
+	G2(t, c, ^=, G21, d, K, i, 1, subkey, 0);\
+	G2(t, a, -=, G13, b, K, i, 2, subkey, 0);\
+	A2(t, c, +=, b);\
+	G2(t, b, +=, G21, c, K, i, 3, subkey, i);\
+	A2(t, c, -=, b);\
+	G2(t, d, +=, G13, c, K, i, 4, subkey, 0);\
+	G2(t, b, ^=, G21, a, K, i, 5, subkey, 0);\
+	G2(t, c, ^=, G5, d, K, i, 6, subkey, 0);\
+
+#define E2(t, K)\
+	R2(t, 0, 1, 2, 3, K, 1, subkey_e);\
+	R2(t, 1, 3, 0, 2, K, 2, subkey_e);\
+	R2(t, 3, 2, 1, 0, K, 3, subkey_e);\
+	R2(t, 2, 0, 3, 1, K, 4, subkey_e);\
+	R2(t, 0, 1, 2, 3, K, 5, subkey_e);\
+	R2(t, 1, 3, 0, 2, K, 6, subkey_e);\
+	R2(t, 3, 2, 1, 0, K, 7, subkey_e);\
+	R2(t, 2, 0, 3, 1, K, 8, subkey_e);\
+	S2(t, 0, 1);\
+	S2(t, 2, 3);\
+	S2(t, 1, 2);\
+
 /*
 *******************************************************************************
 Зашифрование блока
@@ -323,6 +462,41 @@ void beltBlockEncr3(u32* a, u32* b, u32* c, u32* d, const u32 key[8])
 	E(a, b, c, d, key);
 }
 
+static void beltBlockEncrNTable(u32 blocks[], size_t count,
+	const u32 key[8])
+{
+	u32 t[4][4];
+	ASSERT(memIsDisjoint2(blocks, 16 * count, key, 32));
+	// обработать четверки блоков
+	for (; count >= 4; count -= 4, blocks += 16)
+	{
+		memCopy(t, blocks, 64);
+		E4(t, key1, key);
+		memCopy(blocks, t, 64);
+	}
+	// обработать оставшиеся блоки
+	for (; count; --count, blocks += 4)
+	{
+		E((blocks + 0), (blocks + 1), (blocks + 2), (blocks + 3), key);
+	}
+}
+
+void beltBlockEncr4(u32 blocks[16], const u32* keys[4])
+{
+	u32 t[4][4];
+	memCopy(t, blocks, 64);
+	E4(t, key4, keys);
+	memCopy(blocks, t, 64);
+}
+
+void beltBlockEncr2X2(u32 blocks[8], const u32* keys[2])
+{
+	u32 t[2][4];
+	memCopy(t, blocks, 32);
+	E2(t, keys);
+	memCopy(blocks, t, 32);
+}
+
 /*
 *******************************************************************************
 Расшифрование блока
@@ -356,3 +530,101 @@ void beltBlockDecr3(u32* a, u32* b, u32* c, u32* d, const u32 key[8])
 {
 	D(a, b, c, d, key);
 }
+
+static void beltBlockDecrNTable(u32 blocks[], size_t count,
+	const u32 key[8])
+{
+	u32 t[4][4];
+	ASSERT(memIsDisjoint2(blocks, 16 * count, key, 32));
+	// обработать четверки блоков
+	for (; count >= 4; count -= 4, blocks += 16)
+	{
+		memCopy(t, blocks, 64);
+		D4(t, key1, key);
+		memCopy(blocks, t, 64);
+	}
+	// обработать оставшиеся блоки
+	for (; count; --count, blocks += 4)
+	{
+		D((blocks + 0), (blocks + 1), (blocks + 2), (blocks + 3), key);
+	}
+}
+
+/*
+*******************************************************************************
+Реализации
+
+Функции beltBlockEncrN(), beltBlockDecrN() обращаются к таблице реализаций
+belt_block_o. Реализация по умолчанию (BELT_TABLE) построена на расширенных
+H-блоках.
+
+В режиме BELT_AUTO в библиотеку дополнительно включаются векторные реализации
+BELT_AVX2 (8 блоков) и BELT_AVX512 (16 блоков, требуется AVX512VBMI),
+которые компилируются в отдельных единицах трансляции со своими наборами
+инструкций. Векторные реализации не обращаются к памяти по секретным
+индексам. Реализация выбирается при первом обращении по наборам
+инструкций, которые поддерживает процессор (см. cpuHas()).
+*******************************************************************************
+*/
+
+typedef struct {
+	const char* name;		/*< название */
+	void (*encrN)(u32 blocks[], size_t count, const u32 key[8]);
+	void (*decrN)(u32 blocks[], size_t count, const u32 key[8]);
+} belt_block_o;
+
+static const belt_block_o _table =
+	{ "BELT_TABLE", beltBlockEncrNTable, beltBlockDecrNTable };
+
+#if defined(BELT_AUTO)
+
+#include "bee2/core/cpu.h"
+#include "bee2/core/mt.h"
+
+static const belt_block_o _avx2 =
+	{ "BELT_AVX2", beltBlockEncrNAVX2, beltBlockDecrNAVX2 };
+static const belt_block_o _avx512 =
+	{ "BELT_AVX512", beltBlockEncrNAVX512, beltBlockDecrNAVX512 };
+
+static size_t _once;
+static const belt_block_o* _impl = &_table;
+
+static void beltBlockInit()
+{
+	if (cpuHas(CPU_AVX2))
+		_impl = &_avx2;
+	if (cpuHas(CPU_AVX512F | CPU_AVX512BW | CPU_AVX512VBMI))
+		_impl = &_avx512;
+}
+
+#define beltBlockImpl()\
+	(_once == 1 ? _impl : (mtCallOnce(&_once, beltBlockInit), _impl))
+
+#else
+
+#define beltBlockImpl() (&_table)
+
+#endif // BELT_AUTO
+
+void beltBlockEncrN(u32 blocks[], size_t count, const u32 key[8])
+{
+	const prov_o* prov = provActive();
+	if (prov && prov->block_encr &&
+		prov->block_encr(blocks, count, key, prov->state) == ERR_OK)
+		return;
+	beltBlockImpl()->encrN(blocks, count, key);
+}
+
+void beltBlockDecrN(u32 blocks[], size_t count, const u32 key[8])
+{
+	const prov_o* prov = provActive();
+	if (prov && prov->block_decr &&
+		prov->block_decr(blocks, count, key, prov->state) == ERR_OK)
+		return;
+	beltBlockImpl()->decrN(blocks, count, key);
+}
+
+const char* beltBlockPlatform()
+{
+	return beltBlockImpl()->name;
+}
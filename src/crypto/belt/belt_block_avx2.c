@@ -0,0 +1,227 @@
+/*
+*******************************************************************************
+\file belt_block_avx2.c
+\brief STB 34.101.31 (belt): block encryption optimized for AVX2
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "bee2/defs.h"
+
+#if !defined(__AVX2__)
+	#error "The compiler does not support AVX2 intrinsics"
+#endif
+
+#if (OCTET_ORDER == BIG_ENDIAN)
+	#error "AVX2 contradicts big-endianness"
+#endif
+
+#include <immintrin.h>
+
+#include "bee2/core/mem.h"
+#include "bee2/core/util.h"
+#include "bee2/crypto/belt.h"
+#include "belt_lcl.h"
+
+/*
+*******************************************************************************
+Векторная реализация
+
+Одновременно обрабатываются 8 блоков. Слова a, b, c, d восьми блоков
+размещаются в четырех 256-разрядных регистрах (транспонирование выполняется
+макросом T8).
+
+Подстановка H реализуется без обращений к памяти по секретным индексам.
+Таблица H разбивается на 16 строк по 16 октетов. Каждая строка
+индексируется младшей тетрадой октета с помощью инструкции vpshufb,
+после чего нужная строка выбирается по битам старшей тетрады цепочкой
+инструкций vpblendvb. Время обработки не зависит от данных.
+*******************************************************************************
+*/
+
+#define W __m256i
+#define XOR _mm256_xor_si256
+#define ADD _mm256_add_epi32
+#define SUB _mm256_sub_epi32
+#define SET1 _mm256_set1_epi32
+#define SHUF _mm256_shuffle_epi8
+#define BLEND _mm256_blendv_epi8
+#define SL16 _mm256_slli_epi16
+#define ROL(x, r)\
+	_mm256_or_si256(_mm256_slli_epi32(x, r), _mm256_srli_epi32(x, 32 - r))
+
+#define HSEL(T, l, x, i)\
+	BLEND(SHUF(T[i], l), SHUF(T[i + 8], l), x)
+
+static W beltHX8(W x, const W T[16])
+{
+	W l, v0, v1, v2, v3, v4, v5, v6, v7, m;
+	l = _mm256_and_si256(x, _mm256_set1_epi8(15));
+	// бит 3 старшей тетрады
+	v0 = HSEL(T, l, x, 0), v1 = HSEL(T, l, x, 1);
+	v2 = HSEL(T, l, x, 2), v3 = HSEL(T, l, x, 3);
+	v4 = HSEL(T, l, x, 4), v5 = HSEL(T, l, x, 5);
+	v6 = HSEL(T, l, x, 6), v7 = HSEL(T, l, x, 7);
+	// бит 2
+	m = SL16(x, 1);
+	v0 = BLEND(v0, v4, m), v1 = BLEND(v1, v5, m);
+	v2 = BLEND(v2, v6, m), v3 = BLEND(v3, v7, m);
+	// бит 1
+	m = SL16(x, 2);
+	v0 = BLEND(v0, v2, m), v1 = BLEND(v1, v3, m);
+	// бит 0
+	m = SL16(x, 3);
+	return BLEND(v0, v1, m);
+}
+
+#define G(x, r) ROL(beltHX8(x, T), r)
+
+/*
+*******************************************************************************
+Такты
+
+Макросы повторяют макросы R, E, D из belt_block.c. Окончательная перестановка
+регистров выполняется при выгрузке блоков.
+*******************************************************************************
+*/
+
+#define R(a, b, c, d, K, i, subkey)\
+	b = XOR(b, G(ADD(a, subkey(K, i, 0)), 5));\
+	c = XOR(c, G(ADD(d, subkey(K, i, 1)), 21));\
+	a = SUB(a, G(ADD(b, subkey(K, i, 2)), 13));\
+	c = ADD(c, b);\
+	b = ADD(b, XOR(G(ADD(c, subkey(K, i, 3)), 21), SET1(i)));\
+	c = SUB(c, b);\
+	d = ADD(d, G(ADD(c, subkey(K, i, 4)), 13));\
+	b = XOR(b, G(ADD(a, subkey(K, i, 5)), 21));\
+	c = XOR(c, G(ADD(d, subkey(K, i, 6)), 5));\
+
+#define subkey_e(K, i, j) K[(7 * (i) - 7 + (j)) % 8]
+#define subkey_d(K, i, j) K[(7 * (i) - 1 - (j)) % 8]
+
+#define E(a, b, c, d, K)\
+	R(a, b, c, d, K, 1, subkey_e);\
+	R(b, d, a, c, K, 2, subkey_e);\
+	R(d, c, b, a, K, 3, subkey_e);\
+	R(c, a, d, b, K, 4, subkey_e);\
+	R(a, b, c, d, K, 5, subkey_e);\
+	R(b, d, a, c, K, 6, subkey_e);\
+	R(d, c, b, a, K, 7, subkey_e);\
+	R(c, a, d, b, K, 8, subkey_e);\
+
+#define D(a, b, c, d, K)\
+	R(a, b, c, d, K, 8, subkey_d);\
+	R(c, a, d, b, K, 7, subkey_d);\
+	R(d, c, b, a, K, 6, subkey_d);\
+	R(b, d, a, c, K, 5, subkey_d);\
+	R(a, b, c, d, K, 4, subkey_d);\
+	R(c, a, d, b, K, 3, subkey_d);\
+	R(d, c, b, a, K, 2, subkey_d);\
+	R(b, d, a, c, K, 1, subkey_d);\
+
+/*
+*******************************************************************************
+Транспонирование
+
+Макрос T8 транспонирует матрицы 4 x 4 из 32-разрядных слов в каждой
+128-разрядной половине регистров r0, r1, r2, r3. Транспонирование
+является инволюцией и используется как при загрузке, так и при выгрузке.
+*******************************************************************************
+*/
+
+#define T8(r0, r1, r2, r3)\
+{\
+	W t0 = _mm256_unpacklo_epi32(r0, r1);\
+	W t1 = _mm256_unpackhi_epi32(r0, r1);\
+	W t2 = _mm256_unpacklo_epi32(r2, r3);\
+	W t3 = _mm256_unpackhi_epi32(r2, r3);\
+	r0 = _mm256_unpacklo_epi64(t0, t2);\
+	r1 = _mm256_unpackhi_epi64(t0, t2);\
+	r2 = _mm256_unpacklo_epi64(t1, t3);\
+	r3 = _mm256_unpackhi_epi64(t1, t3);\
+}\
+
+#define LOAD(p) _mm256_loadu_si256((const W*)(p))
+#define STORE(p, x) _mm256_storeu_si256((W*)(p), x)
+
+/*
+*******************************************************************************
+Обработка блоков
+*******************************************************************************
+*/
+
+static void beltBlockPrepare(W T[16], W K[8], const u32 key[8])
+{
+	size_t i;
+	for (i = 0; i < 16; ++i)
+		T[i] = _mm256_broadcastsi128_si256(
+			_mm_loadu_si128((const __m128i*)(beltH() + 16 * i)));
+	for (i = 0; i < 8; ++i)
+		K[i] = SET1(key[i]);
+}
+
+static void beltBlockEncr8(u32 blocks[32], const W T[16], const W K[8])
+{
+	W a = LOAD(blocks), b = LOAD(blocks + 8);
+	W c = LOAD(blocks + 16), d = LOAD(blocks + 24);
+	T8(a, b, c, d);
+	E(a, b, c, d, K);
+	// abcd -> bdac
+	T8(b, d, a, c);
+	STORE(blocks, b), STORE(blocks + 8, d);
+	STORE(blocks + 16, a), STORE(blocks + 24, c);
+}
+
+static void beltBlockDecr8(u32 blocks[32], const W T[16], const W K[8])
+{
+	W a = LOAD(blocks), b = LOAD(blocks + 8);
+	W c = LOAD(blocks + 16), d = LOAD(blocks + 24);
+	T8(a, b, c, d);
+	D(a, b, c, d, K);
+	// abcd -> cadb
+	T8(c, a, d, b);
+	STORE(blocks, c), STORE(blocks + 8, a);
+	STORE(blocks + 16, d), STORE(blocks + 24, b);
+}
+
+void beltBlockEncrNAVX2(u32 blocks[], size_t count, const u32 key[8])
+{
+	W T[16], K[8];
+	u32 t[32];
+	ASSERT(memIsDisjoint2(blocks, 16 * count, key, 32));
+	beltBlockPrepare(T, K, key);
+	for (; count >= 8; count -= 8, blocks += 32)
+		beltBlockEncr8(blocks, T, K);
+	if (count)
+	{
+		memCopy(t, blocks, 16 * count);
+		memSetZero(t + 4 * count, 16 * (8 - count));
+		beltBlockEncr8(t, T, K);
+		memCopy(blocks, t, 16 * count);
+		memWipe(t, sizeof(t));
+	}
+	memWipe(K, sizeof(K));
+}
+
+void beltBlockDecrNAVX2(u32 blocks[], size_t count, const u32 key[8])
+{
+	W T[16], K[8];
+	u32 t[32];
+	ASSERT(memIsDisjoint2(blocks, 16 * count, key, 32));
+	beltBlockPrepare(T, K, key);
+	for (; count >= 8; count -= 8, blocks += 32)
+		beltBlockDecr8(blocks, T, K);
+	if (count)
+	{
+		memCopy(t, blocks, 16 * count);
+		memSetZero(t + 4 * count, 16 * (8 - count));
+		beltBlockDecr8(t, T, K);
+		memCopy(blocks, t, 16 * count);
+		memWipe(t, sizeof(t));
+	}
+	memWipe(K, sizeof(K));
+}
@@ -0,0 +1,206 @@
+/*
+*******************************************************************************
+\file belt_block_avx512.c
+\brief STB 34.101.31 (belt): block encryption optimized for AVX512
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "bee2/defs.h"
+
+#if !defined(__AVX512F__) || !defined(__AVX512BW__) ||\
+	!defined(__AVX512VBMI__)
+	#error "The compiler does not support AVX512VBMI intrinsics"
+#endif
+
+#if (OCTET_ORDER == BIG_ENDIAN)
+	#error "AVX512 contradicts big-endianness"
+#endif
+
+#include <immintrin.h>
+
+#include "bee2/core/mem.h"
+#include "bee2/core/util.h"
+#include "bee2/crypto/belt.h"
+#include "belt_lcl.h"
+
+/*
+*******************************************************************************
+Векторная реализация
+
+Одновременно обрабатываются 16 блоков. Слова a, b, c, d шестнадцати блоков
+размещаются в четырех 512-разрядных регистрах (транспонирование выполняется
+макросом T16).
+
+Подстановка H реализуется без обращений к памяти по секретным индексам.
+Таблица H целиком размещается в четырех регистрах. Инструкция vpermi2b
+(AVX512VBMI) выбирает октеты из половин таблицы по младшим 7 битам индексов,
+старший бит индекса выбирает половину (инструкции vpmovb2m, vpblendmb).
+Время обработки не зависит от данных.
+*******************************************************************************
+*/
+
+#define W __m512i
+#define XOR _mm512_xor_si512
+#define ADD _mm512_add_epi32
+#define SUB _mm512_sub_epi32
+#define SET1 _mm512_set1_epi32
+#define ROL _mm512_rol_epi32
+
+static W beltHX16(W x, const W T[4])
+{
+	return _mm512_mask_blend_epi8(_mm512_movepi8_mask(x),
+		_mm512_permutex2var_epi8(T[0], x, T[1]),
+		_mm512_permutex2var_epi8(T[2], x, T[3]));
+}
+
+#define G(x, r) ROL(beltHX16(x, T), r)
+
+/*
+*******************************************************************************
+Такты
+
+Макросы повторяют макросы R, E, D из belt_block.c. Окончательная перестановка
+регистров выполняется при выгрузке блоков.
+*******************************************************************************
+*/
+
+#define R(a, b, c, d, K, i, subkey)\
+	b = XOR(b, G(ADD(a, subkey(K, i, 0)), 5));\
+	c = XOR(c, G(ADD(d, subkey(K, i, 1)), 21));\
+	a = SUB(a, G(ADD(b, subkey(K, i, 2)), 13));\
+	c = ADD(c, b);\
+	b = ADD(b, XOR(G(ADD(c, subkey(K, i, 3)), 21), SET1(i)));\
+	c = SUB(c, b);\
+	d = ADD(d, G(ADD(c, subkey(K, i, 4)), 13));\
+	b = XOR(b, G(ADD(a, subkey(K, i, 5)), 21));\
+	c = XOR(c, G(ADD(d, subkey(K, i, 6)), 5));\
+
+#define subkey_e(K, i, j) K[(7 * (i) - 7 + (j)) % 8]
+#define subkey_d(K, i, j) K[(7 * (i) - 1 - (j)) % 8]
+
+#define E(a, b, c, d, K)\
+	R(a, b, c, d, K, 1, subkey_e);\
+	R(b, d, a, c, K, 2, subkey_e);\
+	R(d, c, b, a, K, 3, subkey_e);\
+	R(c, a, d, b, K, 4, subkey_e);\
+	R(a, b, c, d, K, 5, subkey_e);\
+	R(b, d, a, c, K, 6, subkey_e);\
+	R(d, c, b, a, K, 7, subkey_e);\
+	R(c, a, d, b, K, 8, subkey_e);\
+
+#define D(a, b, c, d, K)\
+	R(a, b, c, d, K, 8, subkey_d);\
+	R(c, a, d, b, K, 7, subkey_d);\
+	R(d, c, b, a, K, 6, subkey_d);\
+	R(b, d, a, c, K, 5, subkey_d);\
+	R(a, b, c, d, K, 4, subkey_d);\
+	R(c, a, d, b, K, 3, subkey_d);\
+	R(d, c, b, a, K, 2, subkey_d);\
+	R(b, d, a, c, K, 1, subkey_d);\
+
+/*
+*******************************************************************************
+Транспонирование
+
+Макрос T16 транспонирует матрицы 4 x 4 из 32-разрядных слов в каждой
+128-разрядной четверти регистров r0, r1, r2, r3. Транспонирование
+является инволюцией и используется как при загрузке, так и при выгрузке.
+*******************************************************************************
+*/
+
+#define T16(r0, r1, r2, r3)\
+{\
+	W t0 = _mm512_unpacklo_epi32(r0, r1);\
+	W t1 = _mm512_unpackhi_epi32(r0, r1);\
+	W t2 = _mm512_unpacklo_epi32(r2, r3);\
+	W t3 = _mm512_unpackhi_epi32(r2, r3);\
+	r0 = _mm512_unpacklo_epi64(t0, t2);\
+	r1 = _mm512_unpackhi_epi64(t0, t2);\
+	r2 = _mm512_unpacklo_epi64(t1, t3);\
+	r3 = _mm512_unpackhi_epi64(t1, t3);\
+}\
+
+#define LOAD(p) _mm512_loadu_si512((const W*)(p))
+#define STORE(p, x) _mm512_storeu_si512((W*)(p), x)
+
+/*
+*******************************************************************************
+Обработка блоков
+*******************************************************************************
+*/
+
+static void beltBlockPrepare(W T[4], W K[8], const u32 key[8])
+{
+	size_t i;
+	for (i = 0; i < 4; ++i)
+		T[i] = LOAD(beltH() + 64 * i);
+	for (i = 0; i < 8; ++i)
+		K[i] = SET1(key[i]);
+}
+
+static void beltBlockEncr16(u32 blocks[64], const W T[4], const W K[8])
+{
+	W a = LOAD(blocks), b = LOAD(blocks + 16);
+	W c = LOAD(blocks + 32), d = LOAD(blocks + 48);
+	T16(a, b, c, d);
+	E(a, b, c, d, K);
+	// abcd -> bdac
+	T16(b, d, a, c);
+	STORE(blocks, b), STORE(blocks + 16, d);
+	STORE(blocks + 32, a), STORE(blocks + 48, c);
+}
+
+static void beltBlockDecr16(u32 blocks[64], const W T[4], const W K[8])
+{
+	W a = LOAD(blocks), b = LOAD(blocks + 16);
+	W c = LOAD(blocks + 32), d = LOAD(blocks + 48);
+	T16(a, b, c, d);
+	D(a, b, c, d, K);
+	// abcd -> cadb
+	T16(c, a, d, b);
+	STORE(blocks, c), STORE(blocks + 16, a);
+	STORE(blocks + 32, d), STORE(blocks + 48, b);
+}
+
+void beltBlockEncrNAVX512(u32 blocks[], size_t count, const u32 key[8])
+{
+	W T[4], K[8];
+	u32 t[64];
+	ASSERT(memIsDisjoint2(blocks, 16 * count, key, 32));
+	beltBlockPrepare(T, K, key);
+	for (; count >= 16; count -= 16, blocks += 64)
+		beltBlockEncr16(blocks, T, K);
+	if (count)
+	{
+		memCopy(t, blocks, 16 * count);
+		memSetZero(t + 4 * count, 16 * (16 - count));
+		beltBlockEncr16(t, T, K);
+		memCopy(blocks, t, 16 * count);
+		memWipe(t, sizeof(t));
+	}
+	memWipe(K, sizeof(K));
+}
+
+void beltBlockDecrNAVX512(u32 blocks[], size_t count, const u32 key[8])
+{
+	W T[4], K[8];
+	u32 t[64];
+	ASSERT(memIsDisjoint2(blocks, 16 * count, key, 32));
+	beltBlockPrepare(T, K, key);
+	for (; count >= 16; count -= 16, blocks += 64)
+		beltBlockDecr16(blocks, T, K);
+	if (count)
+	{
+		memCopy(t, blocks, 16 * count);
+		memSetZero(t + 4 * count, 16 * (16 - count));
+		beltBlockDecr16(t, T, K);
+		memCopy(blocks, t, 16 * count);
+		memWipe(t, sizeof(t));
+	}
+	memWipe(K, sizeof(K));
+}
@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): CBC encryption
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2020.03.24
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,7 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
 #include "belt_lcl.h"
@@ -20,6 +21,13 @@
 /*
 *******************************************************************************
 Шифрование в режиме CBС
+
+При расшифровании все блоки шифртекста известны заранее. Поэтому блоки
+расшифровываются четверками с помощью функции beltBlockDecrN(), а затем
+складываются с предыдущими блоками шифртекста.
+
+Функции beltCBCStepETo(), beltCBCStepDTo() копируют src в dest фрагментами
+по 1024 октета и обрабатывают фрагменты на месте (см. belt_ecb.c).
 *******************************************************************************
 */
 typedef struct
@@ -27,6 +35,7 @@ typedef struct
 	u32 key[8];			/*< форматированный ключ */
 	octet block[16];	/*< вспомогательный блок */
 	octet block2[16];	/*< еще один вспомогательный блок */
+	octet blocks[64];	/*< четверка вспомогательных блоков */
 } belt_cbc_st;
 
 size_t beltCBC_keep()
@@ -43,6 +52,15 @@ void beltCBCStart(void* state, const octet key[], size_t len,
 	beltBlockCopy(st->block, iv);
 }
 
+void beltCBCStartK(void* state, const void* skey, const octet iv[16])
+{
+	belt_cbc_st* st = (belt_cbc_st*)state;
+	ASSERT(memIsDisjoint2(iv, 16, state, beltCBC_keep()));
+	ASSERT(memIsDisjoint2(skey, beltKey_keep(), state, beltCBC_keep()));
+	memCopy(st->key, ((const belt_key_st*)skey)->key, 32);
+	beltBlockCopy(st->block, iv);
+}
+
 void beltCBCStepE(void* buf, size_t count, void* state)
 {
 	belt_cbc_st* st = (belt_cbc_st*)state;
@@ -66,11 +84,52 @@ void beltCBCStepE(void* buf, size_t count, void* state)
 	}
 }
 
+void beltCBCStepETo(void* dest, const void* src, size_t count,
+	void* state)
+{
+	ASSERT(count >= 16);
+	ASSERT(memIsSameOrDisjoint(src, dest, count));
+	if (dest == src)
+	{
+		beltCBCStepE(dest, count, state);
+		return;
+	}
+	// цикл по фрагментам
+	while (count >= 1024 + 32)
+	{
+		memCopy(dest, src, 1024);
+		beltCBCStepE(dest, 1024, state);
+		dest = (octet*)dest + 1024;
+		src = (const octet*)src + 1024;
+		count -= 1024;
+	}
+	// последний фрагмент
+	memCopy(dest, src, count);
+	beltCBCStepE(dest, count, state);
+}
+
 void beltCBCStepD(void* buf, size_t count, void* state)
 {
 	belt_cbc_st* st = (belt_cbc_st*)state;
 	ASSERT(count >= 16);
 	ASSERT(memIsDisjoint2(buf, count, state, beltCBC_keep()));
+	// цикл по четверкам блоков
+	while(count >= 80 || count == 64)
+	{
+		memCopy(st->blocks, buf, 64);
+#if (OCTET_ORDER == BIG_ENDIAN)
+		beltBlocksRevU32(buf, 4);
+#endif
+		beltBlockDecrN((u32*)buf, 4, st->key);
+#if (OCTET_ORDER == BIG_ENDIAN)
+		beltBlocksRevU32(buf, 4);
+#endif
+		beltBlockXor2(buf, st->block);
+		memXor2((octet*)buf + 16, st->blocks, 48);
+		beltBlockCopy(st->block, st->blocks + 48);
+		buf = (octet*)buf + 64;
+		count -= 64;
+	}
 	// цикл по полным блокам
 	while(count >= 32 || count == 16)
 	{
@@ -93,6 +152,30 @@ void beltCBCStepD(void* buf, size_t count, void* state)
 	}
 }
 
+void beltCBCStepDTo(void* dest, const void* src, size_t count,
+	void* state)
+{
+	ASSERT(count >= 16);
+	ASSERT(memIsSameOrDisjoint(src, dest, count));
+	if (dest == src)
+	{
+		beltCBCStepD(dest, count, state);
+		return;
+	}
+	// цикл по фрагментам
+	while (count >= 1024 + 32)
+	{
+		memCopy(dest, src, 1024);
+		beltCBCStepD(dest, 1024, state);
+		dest = (octet*)dest + 1024;
+		src = (const octet*)src + 1024;
+		count -= 1024;
+	}
+	// последний фрагмент
+	memCopy(dest, src, count);
+	beltCBCStepD(dest, count, state);
+}
+
 err_t beltCBCEncr(void* dest, const void* src, size_t count,
 	const octet key[], size_t len, const octet iv[16])
 {
@@ -109,11 +192,18 @@ err_t beltCBCEncr(void* dest, const void* src, size_t count,
 	state = blobCreate(beltCBC_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltCBCEncr");
 	// зашифровать
 	beltCBCStart(state, key, len, iv);
-	memMove(dest, src, count);
-	beltCBCStepE(dest, count, state);
+	if (memIsSameOrDisjoint(src, dest, count))
+		beltCBCStepETo(dest, src, count, state);
+	else
+	{
+		memMove(dest, src, count);
+		beltCBCStepE(dest, count, state);
+	}
 	// завершить
+	tmTraceEnd("beltCBCEncr");
 	blobClose(state);
 	return ERR_OK;
 }
@@ -134,11 +224,18 @@ err_t beltCBCDecr(void* dest, const void* src, size_t count,
 	state = blobCreate(beltCBC_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltCBCDecr");
 	// расшифровать
 	beltCBCStart(state, key, len, iv);
-	memMove(dest, src, count);
-	beltCBCStepD(dest, count, state);
+	if (memIsSameOrDisjoint(src, dest, count))
+		beltCBCStepDTo(dest, src, count, state);
+	else
+	{
+		memMove(dest, src, count);
+		beltCBCStepD(dest, count, state);
+	}
 	// завершить
+	tmTraceEnd("beltCBCDecr");
 	blobClose(state);
 	return ERR_OK;
 }
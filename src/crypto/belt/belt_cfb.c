@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): CFB encryption
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2020.03.24
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,7 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
 #include "belt_lcl.h"
@@ -20,6 +21,10 @@
 /*
 *******************************************************************************
 Шифрование в режиме CFB
+
+При расшифровании все блоки шифртекста известны заранее. Поэтому
+блоки гаммы, которые являются зашифрованными блоками шифртекста,
+вырабатываются четверками с помощью функции beltBlockEncrN().
 *******************************************************************************
 */
 typedef struct
@@ -27,6 +32,7 @@ typedef struct
 	u32 key[8];			/*< форматированный ключ */
 	octet block[16];	/*< блок гаммы */
 	size_t reserved;	/*< резерв октетов гаммы */
+	octet blocks[64];	/*< четверка блоков гаммы */
 } belt_cfb_st;
 
 size_t beltCFB_keep()
@@ -44,84 +50,132 @@ void beltCFBStart(void* state, const octet key[], size_t len,
 	st->reserved = 0;
 }
 
-void beltCFBStepE(void* buf, size_t count, void* state)
+void beltCFBStartK(void* state, const void* skey, const octet iv[16])
+{
+	belt_cfb_st* st = (belt_cfb_st*)state;
+	ASSERT(memIsDisjoint2(iv, 16, state, beltCFB_keep()));
+	ASSERT(memIsDisjoint2(skey, beltKey_keep(), state, beltCFB_keep()));
+	memCopy(st->key, ((const belt_key_st*)skey)->key, 32);
+	beltBlockCopy(st->block, iv);
+	st->reserved = 0;
+}
+
+void beltCFBStepETo(void* dest, const void* src, size_t count,
+	void* state)
 {
 	belt_cfb_st* st = (belt_cfb_st*)state;
-	ASSERT(memIsDisjoint2(buf, count, state, beltCFB_keep()));
+	ASSERT(memIsSameOrDisjoint(src, dest, count));
+	ASSERT(memIsDisjoint2(dest, count, state, beltCFB_keep()));
+	ASSERT(memIsDisjoint2(src, count, state, beltCFB_keep()));
 	// есть резерв гаммы?
 	if (st->reserved)
 	{
 		if (st->reserved >= count)
 		{
-			memXor2(st->block + 16 - st->reserved, buf, count);
-			memCopy(buf, st->block + 16 - st->reserved, count);
+			memXor2(st->block + 16 - st->reserved, src, count);
+			memCopy(dest, st->block + 16 - st->reserved, count);
 			st->reserved -= count;
 			return;
 		}
-		memXor2(st->block + 16 - st->reserved, buf, st->reserved);
-		memCopy(buf, st->block + 16 - st->reserved, st->reserved);
+		memXor2(st->block + 16 - st->reserved, src, st->reserved);
+		memCopy(dest, st->block + 16 - st->reserved, st->reserved);
 		count -= st->reserved;
-		buf = (octet*)buf + st->reserved;
+		dest = (octet*)dest + st->reserved;
+		src = (const octet*)src + st->reserved;
 		st->reserved = 0;
 	}
 	// цикл по полным блокам
 	while (count >= 16)
 	{
 		beltBlockEncr(st->block, st->key);
-		beltBlockXor2(st->block, buf);
-		beltBlockCopy(buf, st->block);
-		buf = (octet*)buf + 16;
+		beltBlockXor2(st->block, src);
+		beltBlockCopy(dest, st->block);
+		dest = (octet*)dest + 16;
+		src = (const octet*)src + 16;
 		count -= 16;
 	}
 	// неполный блок?
 	if (count)
 	{
 		beltBlockEncr(st->block, st->key);
-		memXor2(st->block, buf, count);
-		memCopy(buf, st->block, count);
+		memXor2(st->block, src, count);
+		memCopy(dest, st->block, count);
 		st->reserved = 16 - count;
 	}
 }
 
-void beltCFBStepD(void* buf, size_t count, void* state)
+void beltCFBStepE(void* buf, size_t count, void* state)
+{
+	beltCFBStepETo(buf, buf, count, state);
+}
+
+void beltCFBStepDTo(void* dest, const void* src, size_t count,
+	void* state)
 {
 	belt_cfb_st* st = (belt_cfb_st*)state;
-	ASSERT(memIsDisjoint2(buf, count, state, beltCFB_keep()));
+	ASSERT(memIsSameOrDisjoint(src, dest, count));
+	ASSERT(memIsDisjoint2(dest, count, state, beltCFB_keep()));
+	ASSERT(memIsDisjoint2(src, count, state, beltCFB_keep()));
 	// есть резерв гаммы?
 	if (st->reserved)
 	{
 		if (st->reserved >= count)
 		{
-			memXor2(buf, st->block + 16 - st->reserved, count);
-			memXor2(st->block + 16 - st->reserved, buf, count);
+			memXor(dest, src, st->block + 16 - st->reserved, count);
+			memXor2(st->block + 16 - st->reserved, dest, count);
 			st->reserved -= count;
 			return;
 		}
-		memXor2(buf, st->block + 16 - st->reserved, st->reserved);
-		memXor2(st->block + 16 - st->reserved, buf, st->reserved);
+		memXor(dest, src, st->block + 16 - st->reserved, st->reserved);
+		memXor2(st->block + 16 - st->reserved, dest, st->reserved);
 		count -= st->reserved;
-		buf = (octet*)buf + st->reserved;
+		dest = (octet*)dest + st->reserved;
+		src = (const octet*)src + st->reserved;
 		st->reserved = 0;
 	}
+	// цикл по четверкам блоков
+	while (count >= 64)
+	{
+		beltBlockCopy(st->blocks, st->block);
+		memCopy(st->blocks + 16, src, 48);
+		beltBlockCopy(st->block, (const octet*)src + 48);
+#if (OCTET_ORDER == BIG_ENDIAN)
+		beltBlocksRevU32(st->blocks, 4);
+#endif
+		beltBlockEncrN((u32*)st->blocks, 4, st->key);
+#if (OCTET_ORDER == BIG_ENDIAN)
+		beltBlocksRevU32(st->blocks, 4);
+#endif
+		memXor(dest, src, st->blocks, 64);
+		dest = (octet*)dest + 64;
+		src = (const octet*)src + 64;
+		count -= 64;
+	}
 	// цикл по полным блокам
 	while (count >= 16)
 	{
 		beltBlockEncr(st->block, st->key);
-		beltBlockXor2(buf, st->block);
-		beltBlockXor2(st->block, buf);
-		buf = (octet*)buf + 16;
+		beltBlockXor(dest, src, st->block);
+		beltBlockXor2(st->block, dest);
+		dest = (octet*)dest + 16;
+		src = (const octet*)src + 16;
 		count -= 16;
 	}
 	// неполный блок?
 	if (count)
 	{
 		beltBlockEncr(st->block, st->key);
-		memXor2(buf, st->block, count);
-		memXor2(st->block, buf, count);
+		memXor(dest, src, st->block, count);
+		memXor2(st->block, dest, count);
 		st->reserved = 16 - count;
 	}
 }
 
+void beltCFBStepD(void* buf, size_t count, void* state)
+{
+	beltCFBStepDTo(buf, buf, count, state);
+}
+
 err_t beltCFBEncr(void* dest, const void* src, size_t count,
 	const octet key[], size_t len, const octet iv[16])
 {
@@ -137,11 +191,18 @@ err_t beltCFBEncr(void* dest, const void* src, size_t count,
 	state = blobCreate(beltCFB_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltCFBEncr");
 	// зашифровать
 	beltCFBStart(state, key, len, iv);
-	memMove(dest, src, count);
-	beltCFBStepE(dest, count, state);
+	if (memIsSameOrDisjoint(src, dest, count))
+		beltCFBStepETo(dest, src, count, state);
+	else
+	{
+		memMove(dest, src, count);
+		beltCFBStepE(dest, count, state);
+	}
 	// завершить
+	tmTraceEnd("beltCFBEncr");
 	blobClose(state);
 	return ERR_OK;
 }
@@ -161,11 +222,18 @@ err_t beltCFBDecr(void* dest, const void* src, size_t count,
 	state = blobCreate(beltCFB_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltCFBDecr");
 	// расшифровать
 	beltCFBStart(state, key, len, iv);
-	memMove(dest, src, count);
-	beltCFBStepD(dest, count, state);
+	if (memIsSameOrDisjoint(src, dest, count))
+		beltCFBStepDTo(dest, src, count, state);
+	else
+	{
+		memMove(dest, src, count);
+		beltCFBStepD(dest, count, state);
+	}
 	// завершить
+	tmTraceEnd("beltCFBDecr");
 	blobClose(state);
 	return ERR_OK;
 }
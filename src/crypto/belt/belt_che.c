@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): CHE (Ctr-Hash-Encrypt) authenticated encryption
 \project bee2 [cryptographic library]
 \created 2020.03.20
-\version 2020.07.31
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,7 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
 #include "bee2/math/ww.h"
@@ -21,6 +22,10 @@
 /*
 *******************************************************************************
 Аутентифицированное шифрование данных (CHE)
+
+Полные блоки аутентифицируемых данных обрабатываются восьмерками
+с помощью функции beltPolyMul8(). Используются степени r, r^2,..., r^8,
+которые рассчитываются при инициализации.
 *******************************************************************************
 */
 
@@ -29,6 +34,7 @@ typedef struct
 	u32 key[8];				/*< форматированный ключ */
 	u32 s[4];				/*< переменная s */
 	word r[W_OF_B(128)];	/*< переменная r */
+	word rr[8 * W_OF_B(128)];/*< степени r, r^2,..., r^8 */
 	word t[W_OF_B(128)];	/*< переменная t */
 	word t1[W_OF_B(128)];	/*< копия t/имитовставка */
 	word len[W_OF_B(128)];	/*< обработано открытых || критических данных */
@@ -41,22 +47,19 @@ typedef struct
 
 size_t beltCHE_keep()
 {
-	return sizeof(belt_che_st) + beltPolyMul_deep();
+	return sizeof(belt_che_st) + beltPolyMul8_deep();
 }
 
-void beltCHEStart(void* state, const octet key[], size_t len, 
-	const octet iv[16])
+static void beltCHEStartS(void* state, bool_t powers)
 {
 	belt_che_st* st = (belt_che_st*)state;
-	ASSERT(memIsDisjoint2(iv, 16, state, beltCHE_keep()));
-	// разобрать key и iv
-	beltKeyExpand2(st->key, key, len);
-	beltBlockCopy(st->r, iv);
-	beltBlockEncr((octet*)st->r, st->key);
-	u32From(st->s, st->r, 16);
+	// r <- s
+	u32To(st->r, 16, st->s);
 #if (OCTET_ORDER == BIG_ENDIAN)
 	beltBlockRevW(st->r);
 #endif
+	if (powers)
+		beltPolyPowers(st->rr, st->r, st->stack);
 	// подготовить t
 	wwFrom(st->t, beltH(), 16);
 	// обнулить счетчики
@@ -65,22 +68,53 @@ void beltCHEStart(void* state, const octet key[], size_t len,
 	st->filled = 0;
 }
 
-void beltCHEStepE(void* buf, size_t count, void* state)
+static void beltCHEStart_internal(void* state, const octet iv[16])
 {
 	belt_che_st* st = (belt_che_st*)state;
-	ASSERT(memIsDisjoint2(buf, count, state, beltCHE_keep()));
+	// s <- belt-block(iv)
+	u32From(st->s, iv, 16);
+	beltBlockEncr2(st->s, st->key);
+	beltCHEStartS(state, TRUE);
+}
+
+void beltCHEStart(void* state, const octet key[], size_t len, 
+	const octet iv[16])
+{
+	belt_che_st* st = (belt_che_st*)state;
+	ASSERT(memIsDisjoint2(iv, 16, state, beltCHE_keep()));
+	beltKeyExpand2(st->key, key, len);
+	beltCHEStart_internal(state, iv);
+}
+
+void beltCHEStartK(void* state, const void* skey, const octet iv[16])
+{
+	belt_che_st* st = (belt_che_st*)state;
+	ASSERT(memIsDisjoint2(iv, 16, state, beltCHE_keep()));
+	ASSERT(memIsDisjoint2(skey, beltKey_keep(), state, beltCHE_keep()));
+	memCopy(st->key, ((const belt_key_st*)skey)->key, 32);
+	beltCHEStart_internal(state, iv);
+}
+
+void beltCHEStepETo(void* dest, const void* src, size_t count,
+	void* state)
+{
+	belt_che_st* st = (belt_che_st*)state;
+	ASSERT(memIsSameOrDisjoint(src, dest, count));
+	ASSERT(memIsDisjoint2(dest, count, state, beltCHE_keep()));
+	ASSERT(memIsDisjoint2(src, count, state, beltCHE_keep()));
 	// есть резерв гаммы?
 	if (st->reserved)
 	{
 		if (st->reserved >= count)
 		{
-			memXor2(buf, st->block1 + 16 - st->reserved, count);
+			memXor(dest, src, st->block1 + 16 - st->reserved, count);
 			st->reserved -= count;
 			return;
 		}
-		memXor2(buf, st->block1 + 16 - st->reserved, st->reserved);
+		memXor(dest, src, st->block1 + 16 - st->reserved, st->reserved);
 		count -= st->reserved;
-		buf = (octet*)buf + st->reserved;
+		dest = (octet*)dest + st->reserved;
+		src = (const octet*)src + st->reserved;
 		st->reserved = 0;
 	}
 	// цикл по полным блокам
@@ -92,8 +126,9 @@ void beltCHEStepE(void* buf, size_t count, void* state)
 #if (OCTET_ORDER == BIG_ENDIAN)
 		beltBlockRevU32(st->block1);
 #endif
-		beltBlockXor2(buf, st->block1);
-		buf = (octet*)buf + 16;
+		beltBlockXor(dest, src, st->block1);
+		dest = (octet*)dest + 16;
+		src = (const octet*)src + 16;
 		count -= 16;
 	}
 	// неполный блок?
@@ -105,11 +140,16 @@ void beltCHEStepE(void* buf, size_t count, void* state)
 #if (OCTET_ORDER == BIG_ENDIAN)
 		beltBlockRevU32(st->block1);
 #endif
-		memXor2(buf, st->block1, count);
+		memXor(dest, src, st->block1, count);
 		st->reserved = 16 - count;
 	}
 }
 
+void beltCHEStepE(void* buf, size_t count, void* state)
+{
+	beltCHEStepETo(buf, buf, count, state);
+}
+
 void beltCHEStepI(const void* buf, size_t count, void* state)
 {
 	belt_che_st* st = (belt_che_st*)state;
@@ -137,6 +177,13 @@ void beltCHEStepI(const void* buf, size_t count, void* state)
 		beltPolyMul(st->t, st->t, st->r, st->stack);
 		st->filled = 0;
 	}
+	// цикл по восьмеркам блоков
+	while (count >= 128)
+	{
+		beltPolyMul8(st->t, st->rr, buf, st->stack);
+		buf = (const octet*)buf + 128;
+		count -= 128;
+	}
 	// цикл по полным блокам
 	while (count >= 16)
 	{
@@ -191,6 +238,13 @@ void beltCHEStepA(const void* buf, size_t count, void* state)
 		beltPolyMul(st->t, st->t, st->r, st->stack);
 		st->filled = 0;
 	}
+	// цикл по восьмеркам блоков
+	while (count >= 128)
+	{
+		beltPolyMul8(st->t, st->rr, buf, st->stack);
+		buf = (const octet*)buf + 128;
+		count -= 128;
+	}
 	// цикл по полным блокам
 	while (count >= 16)
 	{
@@ -210,10 +264,16 @@ void beltCHEStepA(const void* buf, size_t count, void* state)
 
 void beltCHEStepD(void* buf, size_t count, void* state)
 {
-	beltCHEStepE(buf, count, state);
+	beltCHEStepETo(buf, buf, count, state);
 }
 
-static void beltCHEStepG_internal(void* state)
+void beltCHEStepDTo(void* dest, const void* src, size_t count,
+	void* state)
+{
+	beltCHEStepETo(dest, src, count, state);
+}
+
+static void beltCHEStepT_internal(void* state)
 {
 	belt_che_st* st = (belt_che_st*)state;
 	ASSERT(memIsValid(state, beltCHE_keep()));
@@ -233,6 +293,12 @@ static void beltCHEStepG_internal(void* state)
 #if (OCTET_ORDER == BIG_ENDIAN)
 	beltBlockRevW(st->t1);
 #endif
+}
+
+static void beltCHEStepG_internal(void* state)
+{
+	belt_che_st* st = (belt_che_st*)state;
+	beltCHEStepT_internal(state);
 	beltBlockEncr((octet*)st->t1, st->key);
 }
 
@@ -270,14 +336,24 @@ err_t beltCHEWrap(void* dest, octet mac[8], const void* src1, size_t count1,
 	state = blobCreate(beltCHE_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltCHEWrap");
 	// установить защиту (I перед E из-за разрешенного пересечения src2 и dest)
 	beltCHEStart(state, key, len, iv);
 	beltCHEStepI(src2, count2, state);
-	memMove(dest, src1, count1);
-	beltCHEStepE(dest, count1, state);
-	beltCHEStepA(dest, count1, state);
+	// обрабатывать критические данные фрагментами
+	if (dest != src1 && !memIsDisjoint2(dest, count1, src1, count1))
+		memMove(dest, src1, count1), src1 = dest;
+	while (count1)
+	{
+		size_t count = MIN2(count1, 1024);
+		beltCHEStepETo(dest, src1, count, state);
+		beltCHEStepA(dest, count, state);
+		dest = (octet*)dest + count, count1 -= count;
+		src1 = (const octet*)src1 + count;
+	}
 	beltCHEStepG(mac, state);
 	// завершить
+	tmTraceEnd("beltCHEWrap");
 	blobClose(state);
 	return ERR_OK;
 }
@@ -297,21 +373,318 @@ err_t beltCHEUnwrap(void* dest, const void* src1, size_t count1,
 		!memIsValid(dest, count1))
 		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(beltDWP_keep());
+	state = blobCreate(beltCHE_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltCHEUnwrap");
 	// снять защиту
 	beltCHEStart(state, key, len, iv);
 	beltCHEStepI(src2, count2, state);
+	// dest не пересекается с src1, src2 и mac? обрабатывать фрагментами
+	if (memIsDisjoint2(dest, count1, src1, count1) &&
+		memIsDisjoint2(dest, count1, src2, count2) &&
+		memIsDisjoint2(dest, count1, mac, 8))
+	{
+		octet* d = (octet*)dest;
+		size_t c = count1;
+		while (c)
+		{
+			size_t count = MIN2(c, 1024);
+			beltCHEStepA(src1, count, state);
+			memCopy(d, src1, count);
+			beltCHEStepD(d, count, state);
+			d += count, c -= count;
+			src1 = (const octet*)src1 + count;
+		}
+		if (!beltCHEStepV(mac, state))
+		{
+			memSetZero(dest, count1);
+			tmTraceEnd("beltCHEUnwrap");
+			blobClose(state);
+			return ERR_BAD_MAC;
+		}
+		tmTraceEnd("beltCHEUnwrap");
+		blobClose(state);
+		return ERR_OK;
+	}
 	beltCHEStepA(src1, count1, state);
 	if (!beltCHEStepV(mac, state))
 	{
+		tmTraceEnd("beltCHEUnwrap");
 		blobClose(state);
 		return ERR_BAD_MAC;
 	}
-	memMove(dest, src1, count1);
-	beltCHEStepD(dest, count1, state);
+	if (memIsSameOrDisjoint(src1, dest, count1))
+		beltCHEStepDTo(dest, src1, count1, state);
+	else
+	{
+		memMove(dest, src1, count1);
+		beltCHEStepD(dest, count1, state);
+	}
 	// завершить
+	tmTraceEnd("beltCHEUnwrap");
 	blobClose(state);
 	return ERR_OK;
 }
+
+/*
+*******************************************************************************
+Пакетная обработка
+
+Пакеты обрабатываются порциями: не более BELT_CHE_BATCH_LANES пакетов,
+суммарно не более BELT_CHE_BATCH_BLOCKS блоков гаммы. Пакет с более длинной
+гаммой образует отдельную порцию, его гамма вырабатывается фрагментами
+по BELT_CHE_BATCH_BLOCKS блоков.
+
+Синхропосылки, счетчики и имитовставки пакетов порции зашифровываются
+совместными вызовами beltBlockEncrN(). Поэтому векторные реализации
+belt-block задействуются и для коротких пакетов. Имитозащита выполняется
+для пакетов порции по очереди в одном состоянии CHE. Степени r, r^2,...,
+r^8 рассчитываются только для пакетов, в которых есть восьмерки блоков.
+*******************************************************************************
+*/
+
+#define BELT_CHE_BATCH_LANES 16
+#define BELT_CHE_BATCH_BLOCKS 128
+
+typedef struct
+{
+	u32 s[BELT_CHE_BATCH_LANES][4];		/*< начальные значения s */
+	u32 t[BELT_CHE_BATCH_LANES][4];		/*< имитовставки */
+	u32 c[4];							/*< счетчик */
+	u32 ks[BELT_CHE_BATCH_BLOCKS][4];	/*< гамма */
+	octet che[];						/*< [beltCHE_keep()] состояние CHE */
+} belt_che_batch_st;
+
+static void beltCHEBatchCtr(u32 ks[][4], u32 c[4], size_t m)
+{
+	for (; m--; ++ks)
+	{
+		beltBlockMulC(c), c[0] ^= 0x00000001;
+		beltBlockCopy(ks[0], c);
+	}
+}
+
+static void beltCHEBatchEncr(u32 ks[][4], size_t m, const u32 key[8])
+{
+	beltBlockEncrN(ks[0], m, key);
+#if (OCTET_ORDER == BIG_ENDIAN)
+	beltBlocksRevU32(ks, m);
+#endif
+}
+
+static size_t beltCHEBatchRound(const size_t count1[], size_t n)
+{
+	size_t j, m;
+	for (j = m = 0; j < n && j < BELT_CHE_BATCH_LANES; ++j)
+	{
+		if (j && m + (count1[j] + 15) / 16 > BELT_CHE_BATCH_BLOCKS)
+			break;
+		m += (count1[j] + 15) / 16;
+	}
+	return j;
+}
+
+static void beltCHEBatchStart(belt_che_batch_st* bt, const size_t count1[],
+	const size_t count2[], size_t k)
+{
+	belt_che_st* st = (belt_che_st*)bt->che;
+	beltBlockCopy(st->s, bt->s[k]);
+	beltCHEStartS(st, count1[k] >= 128 || count2[k] >= 128);
+}
+
+static bool_t beltCHEBatchCheck(const void* const dest[],
+	const void* const src1[], const size_t count1[],
+	const void* const src2[], const size_t count2[], size_t n,
+	const octet key[], size_t len, const octet iv[], const void* mac)
+{
+	size_t i;
+	if (len != 16 && len != 24 && len != 32 ||
+		!memIsValid(key, len) ||
+		!memIsValid(dest, n * sizeof(void*)) ||
+		!memIsValid(src1, n * sizeof(const void*)) ||
+		!memIsValid(count1, n * O_PER_S) ||
+		!memIsValid(src2, n * sizeof(const void*)) ||
+		!memIsValid(count2, n * O_PER_S) ||
+		!memIsValid(iv, 16 * n) ||
+		!memIsValid(mac, 8 * n))
+		return FALSE;
+	for (i = 0; i < n; ++i)
+		if (!memIsValid(src1[i], count1[i]) ||
+			!memIsValid(src2[i], count2[i]) ||
+			!memIsValid(dest[i], count1[i]))
+			return FALSE;
+	return TRUE;
+}
+
+err_t beltCHEWrapBatch(void* const dest[], octet mac[],
+	const void* const src1[], const size_t count1[],
+	const void* const src2[], const size_t count2[], size_t n,
+	const octet key[], size_t len, const octet iv[])
+{
+	belt_che_batch_st* bt;
+	belt_che_st* st;
+	size_t i, j, k, m;
+	// проверить входные данные
+	if (!beltCHEBatchCheck((const void* const*)dest, src1, count1, src2,
+		count2, n, key, len, iv, mac))
+		return ERR_BAD_INPUT;
+	// создать состояние
+	bt = (belt_che_batch_st*)blobCreate(sizeof(belt_che_batch_st) +
+		beltCHE_keep());
+	if (bt == 0)
+		return ERR_OUTOFMEMORY;
+	st = (belt_che_st*)bt->che;
+	beltKeyExpand2(st->key, key, len);
+	// цикл по порциям
+	for (i = 0; i < n; i += j)
+	{
+		j = beltCHEBatchRound(count1 + i, n - i);
+		// s <- belt-block(iv)
+		for (k = 0; k < j; ++k)
+			u32From(bt->s[k], iv + 16 * (i + k), 16);
+		beltBlockEncrN(bt->s[0], j, st->key);
+		// выработать гамму коротких пакетов
+		for (k = m = 0; k < j; m += (count1[i + k] + 15) / 16, ++k)
+			if (m + (count1[i + k] + 15) / 16 <= BELT_CHE_BATCH_BLOCKS)
+			{
+				beltBlockCopy(bt->c, bt->s[k]);
+				beltCHEBatchCtr(bt->ks + m, bt->c, (count1[i + k] + 15) / 16);
+			}
+		if (m <= BELT_CHE_BATCH_BLOCKS)
+			beltCHEBatchEncr(bt->ks, m, st->key);
+		// обработать пакеты
+		for (k = m = 0; k < j; m += (count1[i + k] + 15) / 16, ++k)
+		{
+			octet* d = (octet*)dest[i + k];
+			const octet* s = (const octet*)src1[i + k];
+			size_t c = count1[i + k];
+			// установить защиту (I перед E, как в beltCHEWrap())
+			beltCHEBatchStart(bt, count1 + i, count2 + i, k);
+			beltCHEStepI(src2[i + k], count2[i + k], st);
+			if (!memIsSameOrDisjoint(s, d, c))
+				memMove(d, s, c), s = d;
+			// короткий пакет?
+			if (m + (c + 15) / 16 <= BELT_CHE_BATCH_BLOCKS)
+			{
+				memXor(d, s, bt->ks + m, c);
+				beltCHEStepA(d, c, st);
+			}
+			// длинный пакет: гамма фрагментами
+			else
+			{
+				ASSERT(j == 1);
+				beltBlockCopy(bt->c, bt->s[k]);
+				while (c)
+				{
+					size_t count = MIN2(c, 16 * BELT_CHE_BATCH_BLOCKS);
+					beltCHEBatchCtr(bt->ks, bt->c, (count + 15) / 16);
+					beltCHEBatchEncr(bt->ks, (count + 15) / 16, st->key);
+					memXor(d, s, bt->ks, count);
+					beltCHEStepA(d, count, st);
+					d += count, s += count, c -= count;
+				}
+			}
+			beltCHEStepT_internal(st);
+			u32From(bt->t[k], st->t1, 16);
+		}
+		// выработать имитовставки
+		beltBlockEncrN(bt->t[0], j, st->key);
+		for (k = 0; k < j; ++k)
+			u32To(mac + 8 * (i + k), 8, bt->t[k]);
+	}
+	// завершить
+	blobClose(bt);
+	return ERR_OK;
+}
+
+err_t beltCHEUnwrapBatch(void* const dest[], bool_t valid[],
+	const void* const src1[], const size_t count1[],
+	const void* const src2[], const size_t count2[], const octet mac[],
+	size_t n, const octet key[], size_t len, const octet iv[])
+{
+	err_t code = ERR_OK;
+	belt_che_batch_st* bt;
+	belt_che_st* st;
+	size_t i, j, k, m;
+	// проверить входные данные
+	if (!beltCHEBatchCheck((const void* const*)dest, src1, count1, src2,
+		count2, n, key, len, iv, mac) ||
+		!memIsValid(valid, n * sizeof(bool_t)))
+		return ERR_BAD_INPUT;
+	// создать состояние
+	bt = (belt_che_batch_st*)blobCreate(sizeof(belt_che_batch_st) +
+		beltCHE_keep());
+	if (bt == 0)
+		return ERR_OUTOFMEMORY;
+	st = (belt_che_st*)bt->che;
+	beltKeyExpand2(st->key, key, len);
+	// цикл по порциям
+	for (i = 0; i < n; i += j)
+	{
+		j = beltCHEBatchRound(count1 + i, n - i);
+		// s <- belt-block(iv)
+		for (k = 0; k < j; ++k)
+			u32From(bt->s[k], iv + 16 * (i + k), 16);
+		beltBlockEncrN(bt->s[0], j, st->key);
+		// проверить имитовставки
+		for (k = 0; k < j; ++k)
+		{
+			beltCHEBatchStart(bt, count1 + i, count2 + i, k);
+			beltCHEStepI(src2[i + k], count2[i + k], st);
+			beltCHEStepA(src1[i + k], count1[i + k], st);
+			beltCHEStepT_internal(st);
+			u32From(bt->t[k], st->t1, 16);
+		}
+		beltBlockEncrN(bt->t[0], j, st->key);
+		for (k = 0; k < j; ++k)
+		{
+			u32To(bt->c, 8, bt->t[k]);
+			if (!(valid[i + k] = memEq(bt->c, mac + 8 * (i + k), 8)))
+				code = ERR_BAD_MAC;
+		}
+		// выработать гамму коротких пакетов
+		for (k = m = 0; k < j; ++k)
+			if (valid[i + k] &&
+				m + (count1[i + k] + 15) / 16 <= BELT_CHE_BATCH_BLOCKS)
+			{
+				beltBlockCopy(bt->c, bt->s[k]);
+				beltCHEBatchCtr(bt->ks + m, bt->c, (count1[i + k] + 15) / 16);
+				m += (count1[i + k] + 15) / 16;
+			}
+		if (m)
+			beltCHEBatchEncr(bt->ks, m, st->key);
+		// расшифровать пакеты
+		for (k = m = 0; k < j; ++k)
+		{
+			octet* d = (octet*)dest[i + k];
+			const octet* s = (const octet*)src1[i + k];
+			size_t c = count1[i + k];
+			if (!valid[i + k])
+				continue;
+			if (!memIsSameOrDisjoint(s, d, c))
+				memMove(d, s, c), s = d;
+			// короткий пакет?
+			if (m + (c + 15) / 16 <= BELT_CHE_BATCH_BLOCKS)
+			{
+				memXor(d, s, bt->ks + m, c);
+				m += (c + 15) / 16;
+				continue;
+			}
+			// длинный пакет: гамма фрагментами
+			ASSERT(j == 1);
+			beltBlockCopy(bt->c, bt->s[k]);
+			while (c)
+			{
+				size_t count = MIN2(c, 16 * BELT_CHE_BATCH_BLOCKS);
+				beltCHEBatchCtr(bt->ks, bt->c, (count + 15) / 16);
+				beltCHEBatchEncr(bt->ks, (count + 15) / 16, st->key);
+				memXor(d, s, bt->ks, count);
+				d += count, s += count, c -= count;
+			}
+		}
+	}
+	// завершить
+	blobClose(bt);
+	return code;
+}
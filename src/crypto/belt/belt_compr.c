@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): compression
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2019.06.26
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -22,43 +22,52 @@
 
 h и X разбиваются на половинки:
 	[8]h = [4]h0 || [4]h1, [8]X = [4]X0 || [4]X1.
+
+Зашифрования X0 на ключе K1 и X1 на ключе K2 не зависят друг от друга
+и выполняются одновременно с помощью beltBlockEncr2X2(). Чтобы оба ключа
+были доступны одновременно, они размещаются в стеке раздельно:
+	[16]buf = [4]buf0 || [4]buf1 || [4]buf2 || [4]buf3,
+	K1 = buf0 || buf1, K2 = buf2 || buf3.
 *******************************************************************************
 */
 
+static void beltComprFinish(u32 h[8], const u32 X[8], u32 buf[16])
+{
+	const u32* keys[2];
+	// buf1 <- h1 [buf01 == K1]
+	beltBlockCopy(buf + 4, h + 4);
+	// buf2 <- ~buf0, buf3 <- h0 [buf23 == K2]
+	beltBlockNeg(buf + 8, buf);
+	beltBlockCopy(buf + 12, h);
+	// h0 <- beltBlock(X0, K1) + X0, h1 <- beltBlock(X1, K2) + X1
+	beltBlockCopy(h, X);
+	beltBlockCopy(h + 4, X + 4);
+	keys[0] = buf, keys[1] = buf + 8;
+	beltBlockEncr2X2(h, keys);
+	beltBlockXor2(h, X);
+	beltBlockXor2(h + 4, X + 4);
+}
+
 void beltCompr(u32 h[8], const u32 X[8], void* stack)
 {
-	// [12]buf = [4]buf0 || [4]buf1 || [4]buf2
 	u32* buf = (u32*)stack;
 	// буферы не пересекаются?
-	ASSERT(memIsDisjoint3(h, 32, X, 32, buf, 48));
+	ASSERT(memIsDisjoint3(h, 32, X, 32, buf, 64));
 	// buf0, buf1 <- h0 + h1
 	beltBlockXor(buf, h, h + 4);
 	beltBlockCopy(buf + 4, buf);
 	// buf0 <- beltBlock(buf0, X) + buf1
 	beltBlockEncr2(buf, X);
 	beltBlockXor2(buf, buf + 4);
-	// buf2 <- h0
-	beltBlockCopy(buf + 8, h);
-	// buf1 <- h1 [buf01 == K1]
-	beltBlockCopy(buf + 4, h + 4);
-	// h0 <- beltBlock(X0, buf01) + X0
-	beltBlockCopy(h, X);
-	beltBlockEncr2(h, buf);
-	beltBlockXor2(h, X);
-	// buf1 <- ~buf0 [buf12 == K2]
-	beltBlockNeg(buf + 4, buf);
-	// h1 <- beltBlock(X1, buf12) + X1
-	beltBlockCopy(h + 4, X + 4);
-	beltBlockEncr2(h + 4, buf + 4);
-	beltBlockXor2(h + 4, X + 4);
+	// h0 <- beltBlock(X0, K1) + X0, h1 <- beltBlock(X1, K2) + X1
+	beltComprFinish(h, X, buf);
 }
 
 void beltCompr2(u32 s[4], u32 h[8], const u32 X[8], void* stack)
 {
-	// [12]buf = [4]buf0 || [4]buf1 || [4]buf2
 	u32* buf = (u32*)stack;
 	// буферы не пересекаются?
-	ASSERT(memIsDisjoint4(s, 16, h, 32, X, 32, buf, 48));
+	ASSERT(memIsDisjoint4(s, 16, h, 32, X, 32, buf, 64));
 	// buf0, buf1 <- h0 + h1
 	beltBlockXor(buf, h, h + 4);
 	beltBlockCopy(buf + 4, buf);
@@ -67,23 +76,74 @@ void beltCompr2(u32 s[4], u32 h[8], const u32 X[8], void* stack)
 	beltBlockXor2(buf, buf + 4);
 	// s <- s ^ buf0
 	beltBlockXor2(s, buf);
-	// buf2 <- h0
-	beltBlockCopy(buf + 8, h);
-	// buf1 <- h1 [buf01 == K1]
-	beltBlockCopy(buf + 4, h + 4);
-	// h0 <- beltBlock(X0, buf01) + X0
-	beltBlockCopy(h, X);
-	beltBlockEncr2(h, buf);
-	beltBlockXor2(h, X);
-	// buf1 <- ~buf0 [buf12 == K2]
-	beltBlockNeg(buf + 4, buf);
-	// h1 <- beltBlock(X1, buf12) + X1
-	beltBlockCopy(h + 4, X + 4);
-	beltBlockEncr2(h + 4, buf + 4);
-	beltBlockXor2(h + 4, X + 4);
+	// h0 <- beltBlock(X0, K1) + X0, h1 <- beltBlock(X1, K2) + X1
+	beltComprFinish(h, X, buf);
 }
 
 size_t beltCompr_deep()
 {
-	return 12 * 4;
+	return 16 * 4;
+}
+
+/*
+*******************************************************************************
+Сжатие четырех независимых наборов данных
+
+Выполняется одновременное сжатие наборов (s[j], h[j], X[j]), j = 0, 1, 2, 3.
+Шаги алгоритма сжатия выполняются над всеми наборами, при этом блоки
+зашифровываются четверками с помощью beltBlockEncr4() (на разных ключах).
+
+Для каждого набора в стеке размещается буфер
+	[12]buf_j = [4]buf0_j || [4]buf1_j || [4]buf2_j,
+ключи K1_j и K2_j последовательно размещаются в buf01_j и buf12_j. Еще один
+буфер [16]blocks используется для зашифрования четверок блоков.
+*******************************************************************************
+*/
+
+void beltCompr2X4(u32* s[4], u32* h[4], const u32* X[4], void* stack)
+{
+	u32* buf = (u32*)stack;
+	u32* blocks = buf + 48;
+	const u32* keys[4];
+	size_t j;
+	// buf0_j, buf1_j <- h0_j + h1_j
+	for (j = 0; j < 4; ++j)
+	{
+		beltBlockXor(blocks + 4 * j, h[j], h[j] + 4);
+		beltBlockCopy(buf + 12 * j + 4, blocks + 4 * j);
+		keys[j] = X[j];
+	}
+	// buf0_j <- beltBlock(buf0_j, X_j) + buf1_j, s_j <- s_j ^ buf0_j
+	beltBlockEncr4(blocks, keys);
+	for (j = 0; j < 4; ++j)
+	{
+		u32* b = buf + 12 * j;
+		beltBlockXor(b, blocks + 4 * j, b + 4);
+		beltBlockXor2(s[j], b);
+		// buf2_j <- h0_j, buf1_j <- h1_j [buf01_j == K1_j]
+		beltBlockCopy(b + 8, h[j]);
+		beltBlockCopy(b + 4, h[j] + 4);
+		beltBlockCopy(blocks + 4 * j, X[j]);
+		keys[j] = b;
+	}
+	// h0_j <- beltBlock(X0_j, buf01_j) + X0_j
+	beltBlockEncr4(blocks, keys);
+	for (j = 0; j < 4; ++j)
+	{
+		u32* b = buf + 12 * j;
+		beltBlockXor(h[j], blocks + 4 * j, X[j]);
+		// buf1_j <- ~buf0_j [buf12_j == K2_j]
+		beltBlockNeg(b + 4, b);
+		beltBlockCopy(blocks + 4 * j, X[j] + 4);
+		keys[j] = b + 4;
+	}
+	// h1_j <- beltBlock(X1_j, buf12_j) + X1_j
+	beltBlockEncr4(blocks, keys);
+	for (j = 0; j < 4; ++j)
+		beltBlockXor(h[j] + 4, blocks + 4 * j, X[j] + 4);
+}
+
+size_t beltCompr2X4_deep()
+{
+	return (4 * 12 + 16) * 4;
 }
@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): CTR encryption
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2020.03.24
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,8 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/u32.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
@@ -27,9 +29,32 @@
 не используется реверс октетов  даже на платформах BIG_ENDIAN.
 Реверс применяется только перед использованием зашифрованного счетчика
 в качестве гаммы.
+
+Полные блоки гаммы вырабатываются четверками с помощью функции
+beltBlockEncrN(), в которой вычисления над блоками чередуются.
+
+Начальное значение счетчика (зашифрованная синхропосылка) сохраняется
+в ctr0. Для текста из offset октетов счетчик равняется
+ctr0 + \lceil offset / 16\rceil \bmod 2^128, а резерв гаммы составляет
+(16 - offset \bmod 16) \bmod 16 октетов последнего блока гаммы.
+Функция beltCTRSeek() восстанавливает эти значения.
 *******************************************************************************
 */
 
+static void beltCTRAdd(u32 ctr[4], size_t q)
+{
+	u32 carry = 0;
+	size_t i;
+	for (i = 0; i < 4; ++i)
+	{
+		ctr[i] += carry;
+		carry = (ctr[i] < carry);
+		ctr[i] += (u32)q;
+		carry |= (ctr[i] < (u32)q);
+		q = q >> 16 >> 16;
+	}
+}
+
 size_t beltCTR_keep()
 {
 	return sizeof(belt_ctr_st);
@@ -43,27 +68,82 @@ void beltCTRStart(void* state, const octet key[], size_t len,
 	beltKeyExpand2(st->key, key, len);
 	u32From(st->ctr, iv, 16);
 	beltBlockEncr2(st->ctr, st->key);
+	beltBlockCopy(st->ctr0, st->ctr);
 	st->reserved = 0;
 }
 
-void beltCTRStepE(void* buf, size_t count, void* state)
+void beltCTRStartK(void* state, const void* skey, const octet iv[16])
+{
+	belt_ctr_st* st = (belt_ctr_st*)state;
+	ASSERT(memIsDisjoint2(iv, 16, state, beltCTR_keep()));
+	ASSERT(memIsDisjoint2(skey, beltKey_keep(), state, beltCTR_keep()));
+	memCopy(st->key, ((const belt_key_st*)skey)->key, 32);
+	u32From(st->ctr, iv, 16);
+	beltBlockEncr2(st->ctr, st->key);
+	beltBlockCopy(st->ctr0, st->ctr);
+	st->reserved = 0;
+}
+
+void beltCTRSeek(void* state, size_t offset)
+{
+	belt_ctr_st* st = (belt_ctr_st*)state;
+	ASSERT(memIsValid(state, beltCTR_keep()));
+	beltBlockCopy(st->ctr, st->ctr0);
+	beltCTRAdd(st->ctr, offset / 16);
+	st->reserved = 0;
+	// неполный блок?
+	if (offset %= 16)
+	{
+		beltBlockIncU32(st->ctr);
+		beltBlockCopy(st->block, st->ctr);
+		beltBlockEncr2((u32*)st->block, st->key);
+#if (OCTET_ORDER == BIG_ENDIAN)
+		beltBlockRevU32(st->block);
+#endif
+		st->reserved = 16 - offset;
+	}
+}
+
+void beltCTRStepETo(void* dest, const void* src, size_t count,
+	void* state)
 {
 	belt_ctr_st* st = (belt_ctr_st*)state;
-	ASSERT(memIsDisjoint2(buf, count, state, beltCTR_keep()));
+	ASSERT(memIsSameOrDisjoint(src, dest, count));
+	ASSERT(memIsDisjoint2(dest, count, state, beltCTR_keep()));
+	ASSERT(memIsDisjoint2(src, count, state, beltCTR_keep()));
 	// есть резерв гаммы?
 	if (st->reserved)
 	{
 		if (st->reserved >= count)
 		{
-			memXor2(buf, st->block + 16 - st->reserved, count);
+			memXor(dest, src, st->block + 16 - st->reserved, count);
 			st->reserved -= count;
 			return;
 		}
-		memXor2(buf, st->block + 16 - st->reserved, st->reserved);
+		memXor(dest, src, st->block + 16 - st->reserved, st->reserved);
 		count -= st->reserved;
-		buf = (octet*)buf + st->reserved;
+		dest = (octet*)dest + st->reserved;
+		src = (const octet*)src + st->reserved;
 		st->reserved = 0;
 	}
+	// цикл по четверкам блоков
+	while (count >= 64)
+	{
+		size_t i;
+		for (i = 0; i < 16; i += 4)
+		{
+			beltBlockIncU32(st->ctr);
+			beltBlockCopy(st->gamma + i, st->ctr);
+		}
+		beltBlockEncrN(st->gamma, 4, st->key);
+#if (OCTET_ORDER == BIG_ENDIAN)
+		beltBlocksRevU32(st->gamma, 4);
+#endif
+		memXor(dest, src, st->gamma, 64);
+		dest = (octet*)dest + 64;
+		src = (const octet*)src + 64;
+		count -= 64;
+	}
 	// цикл по полным блокам
 	while (count >= 16)
 	{
@@ -73,8 +153,9 @@ void beltCTRStepE(void* buf, size_t count, void* state)
 #if (OCTET_ORDER == BIG_ENDIAN)
 		beltBlockRevU32(st->block);
 #endif
-		beltBlockXor2(buf, st->block);
-		buf = (octet*)buf + 16;
+		memXor(dest, src, st->block, 16);
+		dest = (octet*)dest + 16;
+		src = (const octet*)src + 16;
 		count -= 16;
 	}
 	// неполный блок?
@@ -86,11 +167,16 @@ void beltCTRStepE(void* buf, size_t count, void* state)
 #if (OCTET_ORDER == BIG_ENDIAN)
 		beltBlockRevU32(st->block);
 #endif
-		memXor2(buf, st->block, count);
+		memXor(dest, src, st->block, count);
 		st->reserved = 16 - count;
 	}
 }
 
+void beltCTRStepE(void* buf, size_t count, void* state)
+{
+	beltCTRStepETo(buf, buf, count, state);
+}
+
 err_t beltCTR(void* dest, const void* src, size_t count,
 	const octet key[], size_t len, const octet iv[16])
 {
@@ -106,11 +192,120 @@ err_t beltCTR(void* dest, const void* src, size_t count,
 	state = blobCreate(beltCTR_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltCTR");
 	// зашифровать
 	beltCTRStart(state, key, len, iv);
-	memMove(dest, src, count);
-	beltCTRStepE(dest, count, state);
+	if (memIsSameOrDisjoint(src, dest, count))
+		beltCTRStepETo(dest, src, count, state);
+	else
+	{
+		memMove(dest, src, count);
+		beltCTRStepE(dest, count, state);
+	}
+	// завершить
+	tmTraceEnd("beltCTR");
+	blobClose(state);
+	return ERR_OK;
+}
+
+/*
+*******************************************************************************
+Шифрование в режиме CTR в пуле потоков
+
+Текст разбивается на фрагменты длины chunk, кратной 64 (последний
+фрагмент может быть короче). Для каждого фрагмента ставится задача
+beltCTRTask(): копия начального состояния позиционируется на начало
+фрагмента (beltCTRSeek()) и фрагмент зашифровывается. Фрагментов
+примерно в 4 раза больше, чем потоков пула, но не меньше
+BELT_CTR_CHUNK_MIN октетов в каждом.
+
+Фрагменты шифруются из src в dest (beltCTRStepETo()). Если буферы
+частично пересекаются, то текст предварительно копируется в dest
+в вызывающем потоке.
+
+Задачи и их состояния размещаются в одном блобе, который очищается
+при закрытии.
+*******************************************************************************
+*/
+
+#define BELT_CTR_CHUNK_MIN 16384
+
+typedef struct
+{
+	const belt_ctr_st* st;		/*< начальное состояние */
+	octet* dest;				/*< результат */
+	const octet* src;			/*< текст */
+	size_t offset;				/*< начало фрагмента */
+	size_t count;				/*< длина фрагмента */
+	belt_ctr_st* state;			/*< состояние задачи */
+} belt_ctr_task_st;
+
+static void beltCTRTask(void* arg, void* scratch)
+{
+	belt_ctr_task_st* task = (belt_ctr_task_st*)arg;
+	memCopy(task->state, task->st, sizeof(belt_ctr_st));
+	beltCTRSeek(task->state, task->offset);
+	beltCTRStepETo(task->dest + task->offset, task->src + task->offset,
+		task->count, task->state);
+}
+
+err_t beltCTRPool(void* dest, const void* src, size_t count,
+	const octet key[], size_t len, const octet iv[16], mt_pool_t* pool)
+{
+	size_t chunk, num, i;
+	void* state;
+	belt_ctr_st* st;
+	belt_ctr_task_st* tasks;
+	// проверить входные данные
+	if (len != 16 && len != 24 && len != 32 ||
+		!memIsValid(src, count) ||
+		!memIsValid(key, len) ||
+		!memIsValid(iv, 16) ||
+		!memIsValid(dest, count))
+		return ERR_BAD_INPUT;
+	// фрагменты
+	num = pool ? 4 * mtPoolThreads(pool) : 1;
+	chunk = (count + num - 1) / num;
+	chunk = MAX2(chunk, BELT_CTR_CHUNK_MIN);
+	chunk = (chunk + 63) / 64 * 64;
+	num = pool && count ? (count - 1) / chunk + 1 : 1;
+	// создать состояние
+	state = blobCreate(sizeof(belt_ctr_st) +
+		num * (sizeof(belt_ctr_task_st) + sizeof(belt_ctr_st)));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltCTRPool");
+	// раскладка состояния
+	st = (belt_ctr_st*)state;
+	tasks = (belt_ctr_task_st*)(st + 1);
+	// начальное состояние
+	beltCTRStart(st, key, len, iv);
+	if (!memIsSameOrDisjoint(src, dest, count))
+	{
+		memMove(dest, src, count);
+		src = dest;
+	}
+	// задачи
+	for (i = 0; i < num; ++i)
+	{
+		tasks[i].st = st;
+		tasks[i].dest = (octet*)dest;
+		tasks[i].src = (const octet*)src;
+		tasks[i].offset = i * chunk;
+		tasks[i].count = MIN2(chunk, count - i * chunk);
+		tasks[i].state = (belt_ctr_st*)(tasks + num) + i;
+	}
+	// выполнить задачи
+	if (pool && num > 1)
+	{
+		for (i = 0; i < num; ++i)
+			mtPoolSubmit(pool, beltCTRTask, tasks + i);
+		mtPoolWait(pool);
+	}
+	else
+		beltCTRStepETo(dest, src, count, st);
 	// завершить
+	tmTraceEnd("beltCTRPool");
 	blobClose(state);
 	return ERR_OK;
 }
@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): DWP (datawrap = data encryption + authentication)
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2020.03.24
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,7 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
 #include "bee2/math/ww.h"
@@ -21,6 +22,10 @@
 /*
 *******************************************************************************
 Шифрование и имитозащита данных (DWP)
+
+Полные блоки аутентифицируемых данных обрабатываются восьмерками
+с помощью функции beltPolyMul8(). Используются степени r, r^2,..., r^8,
+которые рассчитываются при инициализации.
 *******************************************************************************
 */
 
@@ -28,6 +33,7 @@ typedef struct
 {
 	belt_ctr_st ctr[1];		/*< состояние функций CTR */
 	word r[W_OF_B(128)];	/*< переменная r */
+	word rr[8 * W_OF_B(128)];/*< степени r, r^2,..., r^8 */
 	word t[W_OF_B(128)];	/*< переменная t */
 	word t1[W_OF_B(128)];	/*< копия t/имитовставка */
 	word len[W_OF_B(128)];	/*< обработано открытых || критических данных */
@@ -38,16 +44,12 @@ typedef struct
 
 size_t beltDWP_keep()
 {
-	return sizeof(belt_dwp_st) + beltPolyMul_deep();
+	return sizeof(belt_dwp_st) + beltPolyMul8_deep();
 }
 
-void beltDWPStart(void* state, const octet key[], size_t len, 
-	const octet iv[16])
+static void beltDWPStart_internal(void* state)
 {
 	belt_dwp_st* st = (belt_dwp_st*)state;
-	ASSERT(memIsDisjoint2(iv, 16, state, beltDWP_keep()));
-	// настроить CTR
-	beltCTRStart(st->ctr, key, len, iv);
 	// установить r, s
 	beltBlockCopy(st->r, st->ctr->ctr);
 	beltBlockEncr2((u32*)st->r, st->ctr->key);
@@ -55,17 +57,56 @@ void beltDWPStart(void* state, const octet key[], size_t len,
 	beltBlockRevU32(st->r);
 	beltBlockRevW(st->r);
 #endif
+	beltPolyPowers(st->rr, st->r, st->stack);
 	wwFrom(st->t, beltH(), 16);
 	// обнулить счетчики
 	memSetZero(st->len, sizeof(st->len));
 	st->filled = 0;
 }
 
+void beltDWPStart(void* state, const octet key[], size_t len, 
+	const octet iv[16])
+{
+	belt_dwp_st* st = (belt_dwp_st*)state;
+	ASSERT(memIsDisjoint2(iv, 16, state, beltDWP_keep()));
+	// настроить CTR
+	beltCTRStart(st->ctr, key, len, iv);
+	// завершить настройку
+	beltDWPStart_internal(state);
+}
+
+void beltDWPStartK(void* state, const void* skey, const octet iv[16])
+{
+	belt_dwp_st* st = (belt_dwp_st*)state;
+	ASSERT(memIsDisjoint2(iv, 16, state, beltDWP_keep()));
+	ASSERT(memIsDisjoint2(skey, beltKey_keep(), state, beltDWP_keep()));
+	// настроить CTR
+	beltCTRStartK(st->ctr, skey, iv);
+	// завершить настройку
+	beltDWPStart_internal(state);
+}
+
 void beltDWPStepE(void* buf, size_t count, void* state)
 {
 	beltCTRStepE(buf, count, state);
 }
 
+void beltDWPStepEV(void* const buf[], const size_t count[], size_t n,
+	void* state)
+{
+	size_t i;
+	ASSERT(memIsValid(buf, n * sizeof(void*)));
+	ASSERT(memIsValid(count, n * sizeof(size_t)));
+	for (i = 0; i < n; ++i)
+		beltCTRStepE(buf[i], count[i], state);
+}
+
+void beltDWPStepETo(void* dest, const void* src, size_t count,
+	void* state)
+{
+	beltCTRStepETo(dest, src, count, state);
+}
+
 void beltDWPStepI(const void* buf, size_t count, void* state)
 {
 	belt_dwp_st* st = (belt_dwp_st*)state;
@@ -93,6 +134,13 @@ void beltDWPStepI(const void* buf, size_t count, void* state)
 		beltPolyMul(st->t, st->t, st->r, st->stack);
 		st->filled = 0;
 	}
+	// цикл по восьмеркам блоков
+	while (count >= 128)
+	{
+		beltPolyMul8(st->t, st->rr, buf, st->stack);
+		buf = (const octet*)buf + 128;
+		count -= 128;
+	}
 	// цикл по полным блокам
 	while (count >= 16)
 	{
@@ -147,6 +195,13 @@ void beltDWPStepA(const void* buf, size_t count, void* state)
 		beltPolyMul(st->t, st->t, st->r, st->stack);
 		st->filled = 0;
 	}
+	// цикл по восьмеркам блоков
+	while (count >= 128)
+	{
+		beltPolyMul8(st->t, st->rr, buf, st->stack);
+		buf = (const octet*)buf + 128;
+		count -= 128;
+	}
 	// цикл по полным блокам
 	while (count >= 16)
 	{
@@ -164,11 +219,27 @@ void beltDWPStepA(const void* buf, size_t count, void* state)
 		memCopy(st->block, buf, st->filled = count);
 }
 
+void beltDWPStepAV(const void* const buf[], const size_t count[], size_t n,
+	void* state)
+{
+	size_t i;
+	ASSERT(memIsValid(buf, n * sizeof(const void*)));
+	ASSERT(memIsValid(count, n * sizeof(size_t)));
+	for (i = 0; i < n; ++i)
+		beltDWPStepA(buf[i], count[i], state);
+}
+
 void beltDWPStepD(void* buf, size_t count, void* state)
 {
 	beltCTRStepD(buf, count, state);
 }
 
+void beltDWPStepDTo(void* dest, const void* src, size_t count,
+	void* state)
+{
+	beltCTRStepETo(dest, src, count, state);
+}
+
 static void beltDWPStepG_internal(void* state)
 {
 	belt_dwp_st* st = (belt_dwp_st*)state;
@@ -226,14 +297,24 @@ err_t beltDWPWrap(void* dest, octet mac[8], const void* src1, size_t count1,
 	state = blobCreate(beltDWP_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltDWPWrap");
 	// установить защиту (I перед E из-за разрешенного пересечения src2 и dest)
 	beltDWPStart(state, key, len, iv);
 	beltDWPStepI(src2, count2, state);
-	memMove(dest, src1, count1);
-	beltDWPStepE(dest, count1, state);
-	beltDWPStepA(dest, count1, state);
+	// обрабатывать критические данные фрагментами
+	if (dest != src1 && !memIsDisjoint2(dest, count1, src1, count1))
+		memMove(dest, src1, count1), src1 = dest;
+	while (count1)
+	{
+		size_t count = MIN2(count1, 1024);
+		beltDWPStepETo(dest, src1, count, state);
+		beltDWPStepA(dest, count, state);
+		dest = (octet*)dest + count, count1 -= count;
+		src1 = (const octet*)src1 + count;
+	}
 	beltDWPStepG(mac, state);
 	// завершить
+	tmTraceEnd("beltDWPWrap");
 	blobClose(state);
 	return ERR_OK;
 }
@@ -256,18 +337,53 @@ err_t beltDWPUnwrap(void* dest, const void* src1, size_t count1,
 	state = blobCreate(beltDWP_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltDWPUnwrap");
 	// снять защиту
 	beltDWPStart(state, key, len, iv);
 	beltDWPStepI(src2, count2, state);
+	// dest не пересекается с src1, src2 и mac? обрабатывать фрагментами
+	if (memIsDisjoint2(dest, count1, src1, count1) &&
+		memIsDisjoint2(dest, count1, src2, count2) &&
+		memIsDisjoint2(dest, count1, mac, 8))
+	{
+		octet* d = (octet*)dest;
+		size_t c = count1;
+		while (c)
+		{
+			size_t count = MIN2(c, 1024);
+			beltDWPStepA(src1, count, state);
+			memCopy(d, src1, count);
+			beltDWPStepD(d, count, state);
+			d += count, c -= count;
+			src1 = (const octet*)src1 + count;
+		}
+		if (!beltDWPStepV(mac, state))
+		{
+			memSetZero(dest, count1);
+			tmTraceEnd("beltDWPUnwrap");
+			blobClose(state);
+			return ERR_BAD_MAC;
+		}
+		tmTraceEnd("beltDWPUnwrap");
+		blobClose(state);
+		return ERR_OK;
+	}
 	beltDWPStepA(src1, count1, state);
 	if (!beltDWPStepV(mac, state))
 	{
+		tmTraceEnd("beltDWPUnwrap");
 		blobClose(state);
 		return ERR_BAD_MAC;
 	}
-	memMove(dest, src1, count1);
-	beltDWPStepD(dest, count1, state);
+	if (memIsSameOrDisjoint(src1, dest, count1))
+		beltDWPStepDTo(dest, src1, count1, state);
+	else
+	{
+		memMove(dest, src1, count1);
+		beltDWPStepD(dest, count1, state);
+	}
 	// завершить
+	tmTraceEnd("beltDWPUnwrap");
 	blobClose(state);
 	return ERR_OK;
 }
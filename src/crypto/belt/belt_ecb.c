@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): ECB encryption
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2020.03.24
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,12 +13,19 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
+#include "belt_lcl.h"
 
 /*
 *******************************************************************************
 Шифрование в режиме ECB
+
+Функции beltECBStepETo(), beltECBStepDTo() копируют src в dest фрагментами
+по 1024 октета и обрабатывают фрагменты на месте, пока они находятся
+в кэше. Последний фрагмент содержит не менее двух блоков, что позволяет
+выполнить кражу блока.
 *******************************************************************************
 */
 typedef struct
@@ -38,6 +45,14 @@ void beltECBStart(void* state, const octet key[], size_t len)
 	beltKeyExpand2(st->key, key, len);
 }
 
+void beltECBStartK(void* state, const void* skey)
+{
+	belt_ecb_st* st = (belt_ecb_st*)state;
+	ASSERT(memIsValid(state, beltECB_keep()));
+	ASSERT(memIsDisjoint2(skey, beltKey_keep(), state, beltECB_keep()));
+	memCopy(st->key, ((const belt_key_st*)skey)->key, 32);
+}
+
 void beltECBStepE(void* buf, size_t count, void* state)
 {
 	belt_ecb_st* st = (belt_ecb_st*)state;
@@ -58,6 +73,30 @@ void beltECBStepE(void* buf, size_t count, void* state)
 	}
 }
 
+void beltECBStepETo(void* dest, const void* src, size_t count,
+	void* state)
+{
+	ASSERT(count >= 16);
+	ASSERT(memIsSameOrDisjoint(src, dest, count));
+	if (dest == src)
+	{
+		beltECBStepE(dest, count, state);
+		return;
+	}
+	// цикл по фрагментам
+	while (count >= 1024 + 32)
+	{
+		memCopy(dest, src, 1024);
+		beltECBStepE(dest, 1024, state);
+		dest = (octet*)dest + 1024;
+		src = (const octet*)src + 1024;
+		count -= 1024;
+	}
+	// последний фрагмент
+	memCopy(dest, src, count);
+	beltECBStepE(dest, count, state);
+}
+
 void beltECBStepD(void* buf, size_t count, void* state)
 {
 	belt_ecb_st* st = (belt_ecb_st*)state;
@@ -78,6 +117,30 @@ void beltECBStepD(void* buf, size_t count, void* state)
 	}
 }
 
+void beltECBStepDTo(void* dest, const void* src, size_t count,
+	void* state)
+{
+	ASSERT(count >= 16);
+	ASSERT(memIsSameOrDisjoint(src, dest, count));
+	if (dest == src)
+	{
+		beltECBStepD(dest, count, state);
+		return;
+	}
+	// цикл по фрагментам
+	while (count >= 1024 + 32)
+	{
+		memCopy(dest, src, 1024);
+		beltECBStepD(dest, 1024, state);
+		dest = (octet*)dest + 1024;
+		src = (const octet*)src + 1024;
+		count -= 1024;
+	}
+	// последний фрагмент
+	memCopy(dest, src, count);
+	beltECBStepD(dest, count, state);
+}
+
 err_t beltECBEncr(void* dest, const void* src, size_t count,
 	const octet key[], size_t len)
 {
@@ -93,11 +156,18 @@ err_t beltECBEncr(void* dest, const void* src, size_t count,
 	state = blobCreate(beltECB_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltECBEncr");
 	// зашифровать
 	beltECBStart(state, key, len);
-	memMove(dest, src, count);
-	beltECBStepE(dest, count, state);
+	if (memIsSameOrDisjoint(src, dest, count))
+		beltECBStepETo(dest, src, count, state);
+	else
+	{
+		memMove(dest, src, count);
+		beltECBStepE(dest, count, state);
+	}
 	// завершить
+	tmTraceEnd("beltECBEncr");
 	blobClose(state);
 	return ERR_OK;
 }
@@ -117,11 +187,18 @@ err_t beltECBDecr(void* dest, const void* src, size_t count,
 	state = blobCreate(beltECB_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltECBDecr");
 	// расшифровать
 	beltECBStart(state, key, len);
-	memMove(dest, src, count);
-	beltECBStepD(dest, count, state);
+	if (memIsSameOrDisjoint(src, dest, count))
+		beltECBStepDTo(dest, src, count, state);
+	else
+	{
+		memMove(dest, src, count);
+		beltECBStepD(dest, count, state);
+	}
 	// завершить
+	tmTraceEnd("beltECBDecr");
 	blobClose(state);
 	return ERR_OK;
 }
@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): FMT (format preserving encryption)
 \project bee2 [cryptographic library]
 \created 2017.09.28
-\version 2021.01.21
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -174,14 +174,22 @@ static void belt32BlockEncr(octet block[24], const u32 key[8])
 /*
 *******************************************************************************
 Конвертации
+
+Цифры обрабатываются группами по k, где mod^k -- наибольшая степень mod,
+которая умещается в слово word (при mod == 10 и B_PER_W == 64 k == 19).
+Степень modk = mod^k рассчитывается в beltFMTStart(). В beltStr2Bin()
+на одну группу приходится одно умножение многословного числа, в
+beltBin2StrAdd(), beltBin2StrSub() -- одно деление (zzDivW() возвращает
+одновременно частное и остаток). Цифры группы обрабатываются в одном слове.
 *******************************************************************************
 */
 
-static void beltStr2Bin(octet bin[], size_t b, u32 mod, 
+static void beltStr2Bin(octet bin[], size_t b, u32 mod, size_t k, word modk,
 	const u16 str[], size_t count)
 {
+	register word w;
 	word* a;
-	size_t m;
+	size_t m, g;
 	// подготовить память
 	memSetZero(bin, 8 * b);
 	// особый случай: mod может не уложиться в word
@@ -192,27 +200,31 @@ static void beltStr2Bin(octet bin[], size_t b, u32 mod,
 	}
 	// конвертировать
 	ASSERT(2 <= mod && mod < 65536);
-	ASSERT(count >= 1);
-	--count;
-	EXPECT(str[count] < mod);
+	ASSERT(count >= 1 && k >= 1);
 	a = (word*)bin;
 	m = W_OF_O(8 * b);
-	a[0] = (word)str[count];
-	while (count--)
+	for (g = (count - 1) % k + 1; count; g = k)
 	{
-		zzMulW(a, a, m, mod);
-		EXPECT(str[count] < mod);
-		zzAddW2(a, m, (word)str[count]);
+		count -= g;
+		for (w = 0; g--;)
+		{
+			EXPECT(str[count + g] < mod);
+			w = w * (word)mod + (word)str[count + g];
+		}
+		zzMulW(a, a, m, modk);
+		zzAddW2(a, m, w);
 	}
+	w = 0;
 	wwTo(bin, 8 * b, a);
 }
 
-static void beltBin2StrAdd(u32 mod, u16 str[], size_t count, 
-	octet bin[], size_t b)
+static void beltBin2StrAdd(u32 mod, size_t k, word modk, u16 str[],
+	size_t count, octet bin[], size_t b)
 {
 	register u32 t;
+	register word r;
 	word* a;
-	size_t m;
+	size_t m, g;
 	// особый случай: mod может не уложиться в word
 	if (mod == 65536)
 	{
@@ -228,22 +240,28 @@ static void beltBin2StrAdd(u32 mod, u16 str[], size_t count,
 	wwFrom(a, bin, 8 * b);
 	// конвертировать и сложить
 	ASSERT(2 <= mod && mod < 65536);
-	while (count--)
+	ASSERT(k >= 1);
+	while (count)
 	{
-		t = (u32)zzModW(a, m, mod);
-		t += str[0], t %= mod;
-		str[0] = (u16)t, ++str;
-		zzDivW(a, a, m, mod);
+		g = MIN2(count, k), count -= g;
+		r = zzDivW(a, a, m, modk);
+		for (; g--; ++str, r /= (word)mod)
+		{
+			t = (u32)(r % (word)mod);
+			t += str[0], t %= mod;
+			str[0] = (u16)t;
+		}
 	}
-	t = 0;
+	t = 0, r = 0;
 }
 
-static void beltBin2StrSub(word mod, u16 str[], size_t count, 
-	octet bin[], size_t b)
+static void beltBin2StrSub(u32 mod, size_t k, word modk, u16 str[],
+	size_t count, octet bin[], size_t b)
 {
 	register u32 t;
+	register word r;
 	word* a;
-	size_t m;
+	size_t m, g;
 	// особый случай: mod может не уложиться в word
 	if (mod == 65536)
 	{
@@ -258,15 +276,20 @@ static void beltBin2StrSub(word mod, u16 str[], size_t count,
 	a = (word*)bin;
 	wwFrom(a, bin, 8 * b);
 	// конвертировать и вычесть
-	ASSERT(2 <= mod && mod <= 65536);
-	while (count--)
+	ASSERT(2 <= mod && mod < 65536);
+	ASSERT(k >= 1);
+	while (count)
 	{
-		t = (u32)zzModW(a, m, mod);
-		t = str[0] + mod - t, t %= mod;
-		str[0] = (u16)t, ++str;
-		zzDivW(a, a, m, mod);
+		g = MIN2(count, k), count -= g;
+		r = zzDivW(a, a, m, modk);
+		for (; g--; ++str, r /= (word)mod)
+		{
+			t = (u32)(r % (word)mod);
+			t = str[0] + mod - t, t %= mod;
+			str[0] = (u16)t;
+		}
 	}
-	t = 0;
+	t = 0, r = 0;
 }
 
 /*
@@ -279,9 +302,20 @@ static void beltBin2StrSub(word mod, u16 str[], size_t count,
 \code
 	st->kwp->round = 0;
 \endcode
+
+\remark В beltFMTStepEN(), beltFMTStepDN() строки обрабатываются порциями
+по BELT_FMT_LANES. Если половинки строк умещаются в 1 или 2 блока
+(b1, b2 <= 2), то такт выполняется сразу для всех строк порции:
+блоки строк зашифровываются одним вызовом beltBlockEncrN() (в belt-32block
+-- тремя вызовами, по одному на каждый раунд). Слова раунда r
+(r = 0, 1, 2) belt-32block имеют номера a, a + 1, a + 2, a + 3 (mod 6),
+где a = 2 + 2r (mod 6). Буферы порции (belt_fmt_batch_st) размещаются
+в стеке, чтобы не увеличивать состояние beltFMT_keep().
 *******************************************************************************
 */
 
+#define BELT_FMT_LANES 16
+
 typedef struct
 {
 	belt_wbl_st wbl[1];		/*< состояние механизма WBL */
@@ -290,10 +324,19 @@ typedef struct
 	size_t n2;				/*< длина правой половинки */
 	size_t b1;				/*< число блоков для обработки левой половинки */
 	size_t b2;				/*< число блоков для обработки правой половинки */
+	size_t k;				/*< число цифр в группе */
+	word modk;				/*< mod^k */
 	octet iv[4 + 16 + 4];	/*< формат || синхропосылка || формат */
 	octet buf[];			/*< вспомогательный буфер */
 } belt_fmt_st;
 
+typedef struct
+{
+	word lanes[BELT_FMT_LANES][W_OF_O(24)];	/*< буферы строк порции */
+	u32 blocks[BELT_FMT_LANES][4];			/*< блоки порции */
+	octet ivs[BELT_FMT_LANES][24];			/*< синхропосылки порции */
+} belt_fmt_batch_st;
+
 size_t beltFMT_keep(u32 mod, size_t count)
 {
 	ASSERT(2 <= mod && mod <= 65536);
@@ -315,6 +358,11 @@ void beltFMTStart(void* state, u32 mod, size_t count, const octet key[],
 	st->n2 = count / 2;
 	st->b1 = beltFMTCalcB(mod, st->n1);
 	st->b2 = beltFMTCalcB(mod, st->n2);
+	// modk <- mod^k, где k -- наибольшее, при котором mod^k < 2^B_PER_W
+	st->k = 0, st->modk = 0;
+	if (mod < 65536)
+		for (st->k = 1, st->modk = (word)mod; st->modk <= WORD_MAX / mod;
+			++st->k, st->modk *= (word)mod);
 #if (OCTET_ORDER == LITTLE_ENDIAN)
 	((u16*)st->iv)[0] = (u16)mod;
 	((u16*)st->iv)[1] = (u16)count;
@@ -325,6 +373,99 @@ void beltFMTStart(void* state, u32 mod, size_t count, const octet key[],
 	memCopy(st->iv + 20, st->iv, 4);
 }
 
+/*
+*******************************************************************************
+Такт FMT: половинка [n_dest]dest обновляется по половинке [n_src]src,
+которая обрабатывается в b блоках. Используются 4 октета beltH() и 4 октета
+синхропосылки, начиная с позиции pos.
+*******************************************************************************
+*/
+
+static void beltFMTRound(belt_fmt_st* st, u16 dest[], size_t n_dest,
+	const u16 src[], size_t n_src, size_t b, size_t pos, bool_t add)
+{
+	beltStr2Bin(st->buf, b, st->mod, st->k, st->modk, src, n_src);
+	memCopy(st->buf + b * 8, beltH() + pos, 4);
+	memCopy(st->buf + b * 8 + 4, st->iv + pos, 4);
+	if (b == 1)
+		beltBlockEncr(st->buf, st->wbl->key);
+	else if (b == 2)
+		belt32BlockEncr(st->buf, st->wbl->key);
+	else
+		beltWBLStepE(st->buf, 8 * b + 8, st->wbl);
+	if (add)
+		beltBin2StrAdd(st->mod, st->k, st->modk, dest, n_dest, st->buf, b + 1);
+	else
+		beltBin2StrSub(st->mod, st->k, st->modk, dest, n_dest, st->buf, b + 1);
+}
+
+static void beltFMTRoundN(belt_fmt_st* st, belt_fmt_batch_st* bt,
+	u16 buf[], size_t g, size_t dest, size_t n_dest, size_t src,
+	size_t n_src, size_t b, size_t pos, bool_t add)
+{
+	const size_t count = st->n1 + st->n2;
+	size_t j, r, a, l;
+	ASSERT(b == 1 || b == 2);
+	ASSERT(g <= BELT_FMT_LANES);
+	// подготовить блоки
+	for (j = 0; j < g; ++j)
+	{
+		octet* lane = (octet*)bt->lanes[j];
+		beltStr2Bin(lane, b, st->mod, st->k, st->modk,
+			buf + count * j + src, n_src);
+		memCopy(lane + b * 8, beltH() + pos, 4);
+		memCopy(lane + b * 8 + 4, bt->ivs[j] + pos, 4);
+		u32From((u32*)lane, lane, 8 * b + 8);
+	}
+	// belt-block
+	if (b == 1)
+	{
+		for (j = 0; j < g; ++j)
+			memCopy(bt->blocks[j], bt->lanes[j], 16);
+		beltBlockEncrN(bt->blocks[0], g, st->wbl->key);
+		for (j = 0; j < g; ++j)
+			memCopy(bt->lanes[j], bt->blocks[j], 16);
+	}
+	// belt-32block
+	else for (r = 0; r < 3; ++r)
+	{
+		a = (2 + 2 * r) % 6;
+		for (j = 0; j < g; ++j)
+		{
+			u32* t = (u32*)bt->lanes[j];
+			for (l = 0; l < 4; ++l)
+				bt->blocks[j][l] = t[(a + l) % 6];
+		}
+		beltBlockEncrN(bt->blocks[0], g, st->wbl->key);
+		for (j = 0; j < g; ++j)
+		{
+			u32* t = (u32*)bt->lanes[j];
+			for (l = 0; l < 4; ++l)
+				t[(a + l) % 6] = bt->blocks[j][l];
+			t[a] ^= (u32)(r + 1);
+			t[(a + 4) % 6] ^= t[a], t[(a + 5) % 6] ^= t[(a + 1) % 6];
+		}
+	}
+	// обновить половинки
+	for (j = 0; j < g; ++j)
+	{
+		octet* lane = (octet*)bt->lanes[j];
+		u32To(lane, 8 * b + 8, (u32*)lane);
+		if (add)
+			beltBin2StrAdd(st->mod, st->k, st->modk, buf + count * j + dest,
+				n_dest, lane, b + 1);
+		else
+			beltBin2StrSub(st->mod, st->k, st->modk, buf + count * j + dest,
+				n_dest, lane, b + 1);
+	}
+}
+
+/*
+*******************************************************************************
+Зашифрование / расшифрование
+*******************************************************************************
+*/
+
 void beltFMTStepE(u16 buf[], const octet iv[16], void* state)
 {
 	belt_fmt_st* st = (belt_fmt_st*)state;
@@ -342,27 +483,11 @@ void beltFMTStepE(u16 buf[], const octet iv[16], void* state)
 	for (i = 0; i < 3; ++i)
 	{
 		// первая половинка
-		beltStr2Bin(st->buf, st->b2, st->mod, buf + st->n1, st->n2);
-		memCopy(st->buf + st->b2 * 8, beltH() + 8 * i, 4);
-		memCopy(st->buf + st->b2 * 8 + 4, st->iv + 8 * i, 4);
-		if (st->b2 == 1)
-			beltBlockEncr(st->buf, st->wbl->key);
-		else if (st->b2 == 2)
-			belt32BlockEncr(st->buf, st->wbl->key);
-		else
-			beltWBLStepE(st->buf, 8 * st->b2 + 8, st->wbl);
-		beltBin2StrAdd(st->mod, buf, st->n1, st->buf, st->b2 + 1);
+		beltFMTRound(st, buf, st->n1, buf + st->n1, st->n2, st->b2, 8 * i,
+			TRUE);
 		// вторая половинка
-		beltStr2Bin(st->buf, st->b1, st->mod, buf, st->n1);
-		memCopy(st->buf + st->b1 * 8, beltH() + 8 * i + 4, 4);
-		memCopy(st->buf + st->b1 * 8 + 4, st->iv + 8 * i + 4, 4);
-		if (st->b1 == 1)
-			beltBlockEncr(st->buf, st->wbl->key);
-		else if (st->b1 == 2)
-			belt32BlockEncr(st->buf, st->wbl->key);
-		else
-			beltWBLStepE(st->buf, 8 * st->b1 + 8, st->wbl);
-		beltBin2StrAdd(st->mod, buf + st->n1, st->n2, st->buf, st->b1 + 1);
+		beltFMTRound(st, buf + st->n1, st->n2, buf, st->n1, st->b1,
+			8 * i + 4, TRUE);
 	}
 }
 
@@ -383,30 +508,81 @@ void beltFMTStepD(u16 buf[], const octet iv[16], void* state)
 	for (i = 3; i--;)
 	{
 		// вторая половинка
-		beltStr2Bin(st->buf, st->b1, st->mod, buf, st->n1);
-		memCopy(st->buf + st->b1 * 8, beltH() + 8 * i + 4, 4);
-		memCopy(st->buf + st->b1 * 8 + 4, st->iv + 8 * i + 4, 4);
-		if (st->b1 == 1)
-			beltBlockEncr(st->buf, st->wbl->key);
-		else if (st->b1 == 2)
-			belt32BlockEncr(st->buf, st->wbl->key);
-		else
-			beltWBLStepE(st->buf, 8 * st->b1 + 8, st->wbl);
-		beltBin2StrSub(st->mod, buf + st->n1, st->n2, st->buf, st->b1 + 1);
+		beltFMTRound(st, buf + st->n1, st->n2, buf, st->n1, st->b1,
+			8 * i + 4, FALSE);
 		// первая половинка
-		beltStr2Bin(st->buf, st->b2, st->mod, buf + st->n1, st->n2);
-		memCopy(st->buf + st->b2 * 8, beltH() + 8 * i, 4);
-		memCopy(st->buf + st->b2 * 8 + 4, st->iv + 8 * i, 4);
-		if (st->b2 == 1)
-			beltBlockEncr(st->buf, st->wbl->key);
-		else if (st->b2 == 2)
-			belt32BlockEncr(st->buf, st->wbl->key);
-		else
-			beltWBLStepE(st->buf, 8 * st->b2 + 8, st->wbl);
-		beltBin2StrSub(st->mod, buf, st->n1, st->buf, st->b2 + 1);
+		beltFMTRound(st, buf, st->n1, buf + st->n1, st->n2, st->b2, 8 * i,
+			FALSE);
 	}	
 }
 
+static void beltFMTStepN(u16 buf[], size_t n, const octet iv[], void* state,
+	bool_t encr)
+{
+	belt_fmt_st* st = (belt_fmt_st*)state;
+	belt_fmt_batch_st bt[1];
+	const size_t count = st->n1 + st->n2;
+	size_t g, i, j;
+	ASSERT(memIsValid(state, sizeof(belt_fmt_st)));
+	ASSERT(memIsValid(state, beltFMT_keep(st->mod, count)));
+	ASSERT(memIsNullOrValid(iv, 16 * n));
+	ASSERT(memIsValid(buf, 2 * count * n));
+	// длинные половинки: последовательная обработка
+	if (st->b1 > 2 || st->b2 > 2)
+	{
+		for (j = 0; j < n; ++j)
+			if (encr)
+				beltFMTStepE(buf + count * j, iv ? iv + 16 * j : 0, state);
+			else
+				beltFMTStepD(buf + count * j, iv ? iv + 16 * j : 0, state);
+		return;
+	}
+	// цикл по порциям
+	for (; n; n -= g, buf += count * g, iv = iv ? iv + 16 * g : 0)
+	{
+		g = MIN2(n, BELT_FMT_LANES);
+		// подготовить синхропосылки
+		for (j = 0; j < g; ++j)
+		{
+			memCopy(bt->ivs[j], st->iv, 4);
+			if (iv)
+				memCopy(bt->ivs[j] + 4, iv + 16 * j, 16);
+			else
+				memSetZero(bt->ivs[j] + 4, 16);
+			memCopy(bt->ivs[j] + 20, st->iv, 4);
+		}
+		// такты зашифрования
+		if (encr)
+			for (i = 0; i < 3; ++i)
+			{
+				beltFMTRoundN(st, bt, buf, g, 0, st->n1, st->n1, st->n2,
+					st->b2, 8 * i, TRUE);
+				beltFMTRoundN(st, bt, buf, g, st->n1, st->n2, 0, st->n1,
+					st->b1, 8 * i + 4, TRUE);
+			}
+		// такты расшифрования
+		else
+			for (i = 3; i--;)
+			{
+				beltFMTRoundN(st, bt, buf, g, st->n1, st->n2, 0, st->n1,
+					st->b1, 8 * i + 4, FALSE);
+				beltFMTRoundN(st, bt, buf, g, 0, st->n1, st->n1, st->n2,
+					st->b2, 8 * i, FALSE);
+			}
+	}
+	memWipe(bt, sizeof(bt));
+}
+
+void beltFMTStepEN(u16 buf[], size_t n, const octet iv[], void* state)
+{
+	beltFMTStepN(buf, n, iv, state, TRUE);
+}
+
+void beltFMTStepDN(u16 buf[], size_t n, const octet iv[], void* state)
+{
+	beltFMTStepN(buf, n, iv, state, FALSE);
+}
+
 err_t beltFMTEncr(u16 dest[], u32 mod, const u16 src[], size_t count,
 	const octet key[], size_t len, const octet iv[16])
 {
@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): hashing
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2022.07.18
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,9 +13,12 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/stack.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/u32.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
+#include "bee2/crypto/prov.h"
 #include "belt_lcl.h"
 
 /*
@@ -72,8 +75,7 @@ void beltHashStepH(const void* buf, size_t count, void* state)
 		count -= 32 - st->filled;
 		buf = (const octet*)buf + (32 - st->filled);
 #if (OCTET_ORDER == BIG_ENDIAN)
-		beltBlockRevU32(st->block);
-		beltBlockRevU32(st->block + 16);
+		beltBlocksRevU32(st->block, 2);
 #endif
 		beltCompr2(st->ls + 4, st->h, (u32*)st->block, st->stack);
 		st->filled = 0;
@@ -84,8 +86,7 @@ void beltHashStepH(const void* buf, size_t count, void* state)
 		beltBlockCopy(st->block, buf);
 		beltBlockCopy(st->block + 16, (const octet*)buf + 16);
 #if (OCTET_ORDER == BIG_ENDIAN)
-		beltBlockRevU32(st->block);
-		beltBlockRevU32(st->block + 16);
+		beltBlocksRevU32(st->block, 2);
 #endif
 		beltCompr2(st->ls + 4, st->h, (u32*)st->block, st->stack);
 		buf = (const octet*)buf + 32;
@@ -96,6 +97,16 @@ void beltHashStepH(const void* buf, size_t count, void* state)
 		memCopy(st->block, buf, st->filled = count);
 }
 
+void beltHashStepHV(const void* const buf[], const size_t count[], size_t n,
+	void* state)
+{
+	size_t i;
+	ASSERT(memIsValid(buf, n * sizeof(const void*)));
+	ASSERT(memIsValid(count, n * sizeof(size_t)));
+	for (i = 0; i < n; ++i)
+		beltHashStepH(buf[i], count[i], state);
+}
+
 static void beltHashStepG_internal(void* state)
 {
 	belt_hash_st* st = (belt_hash_st*)state;
@@ -110,13 +121,11 @@ static void beltHashStepG_internal(void* state)
 	{
 		memSetZero(st->block + st->filled, 32 - st->filled);
 #if (OCTET_ORDER == BIG_ENDIAN)
-		beltBlockRevU32(st->block);
-		beltBlockRevU32(st->block + 16);
+		beltBlocksRevU32(st->block, 2);
 #endif
 		beltCompr2(st->ls + 4, st->h1, (u32*)st->block, st->stack);
 #if (OCTET_ORDER == BIG_ENDIAN)
-		beltBlockRevU32(st->block + 16);
-		beltBlockRevU32(st->block);
+		beltBlocksRevU32(st->block, 2);
 #endif
 	}
 	// последний блок
@@ -148,8 +157,7 @@ bool_t beltHashStepV(const octet hash[32], void* state)
 	ASSERT(memIsValid(hash, 32));
 	beltHashStepG_internal(state);
 #if (OCTET_ORDER == BIG_ENDIAN)
-	beltBlockRevU32(st->h1);
-	beltBlockRevU32(st->h1 + 4);
+	beltBlocksRevU32(st->h1, 2);
 #endif
 	return memEq(hash, st->h1, 32);
 }
@@ -161,8 +169,7 @@ bool_t beltHashStepV2(const octet hash[], size_t hash_len, void* state)
 	ASSERT(memIsValid(hash, hash_len));
 	beltHashStepG_internal(state);
 #if (OCTET_ORDER == BIG_ENDIAN)
-	beltBlockRevU32(st->h1);
-	beltBlockRevU32(st->h1 + 4);
+	beltBlocksRevU32(st->h1, 2);
 #endif
 	return memEq(hash, st->h1, hash_len);
 }
@@ -174,14 +181,255 @@ err_t beltHash(octet hash[32], const void* src, size_t count)
 	if (!memIsValid(src, count) || !memIsValid(hash, 32))
 		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(beltHash_keep());
+	state = stackCreate(beltHash_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltHash");
 	// вычислить хэш-значение
 	beltHashStart(state);
 	beltHashStepH(src, count, state);
 	beltHashStepG(hash, state);
 	// завершить
+	tmTraceEnd("beltHash");
+	stackClose(state);
+	return ERR_OK;
+}
+
+/*
+*******************************************************************************
+Экспорт / импорт
+
+\remark При импорте проверяется, что число накопленных октетов согласовано
+с длиной обработанных данных, а незаполненная часть блока нулевая.
+*******************************************************************************
+*/
+
+void beltHashExport(octet buf[], const void* state)
+{
+	const belt_hash_st* st = (const belt_hash_st*)state;
+	ASSERT(memIsValid(state, beltHash_keep()));
+	ASSERT(memIsValid(buf, BELT_HASH_EXPORT_LEN));
+	ASSERT(st->filled < 32);
+	buf[0] = 0x31, buf[1] = 0x01, buf[2] = (octet)st->filled;
+	u32To(buf + 3, 32, st->ls);
+	u32To(buf + 35, 32, st->h);
+	memCopy(buf + 67, st->block, st->filled);
+	memSetZero(buf + 67 + st->filled, 32 - st->filled);
+}
+
+err_t beltHashImport(void* state, const octet buf[])
+{
+	belt_hash_st* st = (belt_hash_st*)state;
+	// проверить входные данные
+	if (!memIsValid(buf, BELT_HASH_EXPORT_LEN) ||
+		!memIsValid(state, beltHash_keep()))
+		return ERR_BAD_INPUT;
+	// проверить формат
+	if (buf[0] != 0x31 || buf[1] != 0x01 || buf[2] >= 32 ||
+		buf[3] != (octet)(8 * buf[2]) ||
+		!memIsZero(buf + 67 + buf[2], 32 - buf[2]))
+		return ERR_BAD_FORMAT;
+	// восстановить состояние
+	u32From(st->ls, buf + 3, 32);
+	u32From(st->h, buf + 35, 32);
+	memCopy(st->block, buf + 67, st->filled = buf[2]);
+	return ERR_OK;
+}
+
+/*
+*******************************************************************************
+Хэширование нескольких сообщений
+
+Сообщения образуют очередь заданий. Задания распределяются по четырем
+дорожкам (lanes). Если на каждой дорожке есть полный необработанный
+блок, то блоки дорожек сжимаются одновременно с помощью beltCompr2X4().
+Если на дорожке остался неполный блок, то обработка задания дорожки
+завершается и дорожка получает следующее задание. Если очередь пуста
+и дорожек с полными блоками меньше четырех, то блоки сжимаются
+по отдельности.
+*******************************************************************************
+*/
+
+typedef struct {
+	u32 ls[8];				/*< блок [4]len || [4]s */
+	u32 h[8];				/*< переменная h */
+	u32 X[8];				/*< блок данных */
+	octet block[32];		/*< неполный блок данных */
+	size_t job;				/*< номер задания */
+	size_t pos;				/*< обработано октетов задания */
+	bool_t busy;			/*< дорожка занята? */
+} belt_hash_lane_st;
+
+err_t beltHashMB(octet hash[], const void* const src[], const size_t count[],
+	size_t n)
+{
+	const prov_o* prov;
+	void* state;
+	belt_hash_lane_st* lanes;
+	void* stack;
+	size_t next;
+	size_t i;
+	// проверить входные данные
+	if (!memIsValid(src, n * sizeof(const void*)) ||
+		!memIsValid(count, n * O_PER_S) ||
+		!memIsValid(hash, 32 * n))
+		return ERR_BAD_INPUT;
+	for (i = 0; i < n; ++i)
+		if (!memIsValid(src[i], count[i]))
+			return ERR_BAD_INPUT;
+	// передать провайдеру
+	prov = provActive();
+	if (prov && prov->hash_mb)
+	{
+		err_t code = prov->hash_mb(hash, src, count, n, prov->state);
+		if (code != ERR_NOT_IMPLEMENTED)
+			return code;
+	}
+	// создать состояние
+	state = blobCreate(4 * sizeof(belt_hash_lane_st) + beltCompr2X4_deep());
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	lanes = (belt_hash_lane_st*)state;
+	stack = lanes + 4;
+	// цикл обработки очереди
+	for (next = 0;;)
+	{
+		size_t active = 0, full = 0, finished = 0;
+		size_t j;
+		// назначить задания свободным дорожкам
+		for (j = 0; j < 4; ++j)
+		{
+			belt_hash_lane_st* lane = lanes + j;
+			if (!lane->busy && next < n)
+			{
+				lane->job = next++, lane->pos = 0, lane->busy = TRUE;
+				beltBlockSetZero(lane->ls);
+				beltBlockSetZero(lane->ls + 4);
+				beltBlockAddBitSizeU32(lane->ls, count[lane->job]);
+				u32From(lane->h, beltH(), 32);
+			}
+			if (lane->busy)
+			{
+				++active;
+				if (count[lane->job] - lane->pos >= 32)
+					++full;
+			}
+		}
+		if (active == 0)
+			break;
+		// одновременное сжатие
+		if (full == 4)
+		{
+			u32* s[4];
+			u32* h[4];
+			const u32* X[4];
+			for (j = 0; j < 4; ++j)
+			{
+				belt_hash_lane_st* lane = lanes + j;
+				u32From(lane->X, (const octet*)src[lane->job] + lane->pos, 32);
+				lane->pos += 32;
+				s[j] = lane->ls + 4, h[j] = lane->h, X[j] = lane->X;
+			}
+			beltCompr2X4(s, h, X, stack);
+			continue;
+		}
+		// завершить задания
+		for (j = 0; j < 4; ++j)
+		{
+			belt_hash_lane_st* lane = lanes + j;
+			size_t rest;
+			if (!lane->busy || (rest = count[lane->job] - lane->pos) >= 32)
+				continue;
+			if (rest)
+			{
+				memSetZero(lane->block, 32);
+				memCopy(lane->block,
+					(const octet*)src[lane->job] + lane->pos, rest);
+				u32From(lane->X, lane->block, 32);
+				beltCompr2(lane->ls + 4, lane->h, lane->X, stack);
+			}
+			beltCompr(lane->h, lane->ls, stack);
+			u32To(hash + 32 * lane->job, 32, lane->h);
+			lane->busy = FALSE, ++finished;
+		}
+		if (finished)
+			continue;
+		// очередь пуста: сжатие по отдельности
+		for (j = 0; j < 4; ++j)
+		{
+			belt_hash_lane_st* lane = lanes + j;
+			if (!lane->busy)
+				continue;
+			u32From(lane->X, (const octet*)src[lane->job] + lane->pos, 32);
+			lane->pos += 32;
+			beltCompr2(lane->ls + 4, lane->h, lane->X, stack);
+		}
+	}
+	// завершить
 	blobClose(state);
 	return ERR_OK;
 }
+
+/*
+*******************************************************************************
+Асинхронное хэширование
+
+Пакет запросов обрабатывается одним вызовом beltHashMB(). Запросы
+с некорректными буферами завершаются с кодом ERR_BAD_INPUT, в пакете
+вместо них хэшируются пустые сообщения.
+*******************************************************************************
+*/
+
+static void beltHashAsyncBatch(mt_req_t* const reqs[], size_t count,
+	void* scratch)
+{
+	void* state;
+	const void** srcs;
+	size_t* lens;
+	octet* hashes;
+	err_t code;
+	size_t i;
+	// создать состояние
+	state = blobCreate(count * (sizeof(const void*) + O_PER_S + 32));
+	if (state == 0)
+	{
+		for (i = 0; i < count; ++i)
+			reqs[i]->code = ERR_OUTOFMEMORY;
+		return;
+	}
+	srcs = (const void**)state;
+	lens = (size_t*)(srcs + count);
+	hashes = (octet*)(lens + count);
+	// собрать пакет
+	for (i = 0; i < count; ++i)
+	{
+		const belt_hash_req_t* r = (const belt_hash_req_t*)reqs[i];
+		if (!memIsValid(r->src, r->count) || !memIsValid(r->hash, 32))
+		{
+			reqs[i]->code = ERR_BAD_INPUT;
+			srcs[i] = 0, lens[i] = 0;
+		}
+		else
+			srcs[i] = r->src, lens[i] = r->count;
+	}
+	// хэшировать
+	code = beltHashMB(hashes, srcs, lens, count);
+	for (i = 0; i < count; ++i)
+		if (reqs[i]->code == ERR_OK)
+		{
+			reqs[i]->code = code;
+			if (code == ERR_OK)
+				memCopy(((belt_hash_req_t*)reqs[i])->hash, hashes + 32 * i,
+					32);
+		}
+	// завершить
+	blobClose(state);
+}
+
+void beltHashAsync(mt_async_t* as, belt_hash_req_t* req)
+{
+	ASSERT(memIsValid(req, sizeof(belt_hash_req_t)));
+	req->req.batch = beltHashAsyncBatch;
+	req->req.key = 0;
+	mtAsyncSubmit(as, &req->req);
+}
@@ -4,15 +4,16 @@
 \brief STB 34.101.31 (belt): HMAC message authentication
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2022.07.18
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
-#include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/stack.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/u32.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
@@ -52,8 +53,7 @@ void beltHMACStart(void* state, const octet key[], size_t len)
 		memCopy(st->block, key, len);
 		memSetZero(st->block + len, 32 - len);
 #if (OCTET_ORDER == BIG_ENDIAN)
-		beltBlockRevU32(st->block);
-		beltBlockRevU32(st->block + 16);
+		beltBlocksRevU32(st->block, 2);
 #endif
 	}
 	// key <- beltHash(key)
@@ -68,8 +68,7 @@ void beltHMACStart(void* state, const octet key[], size_t len)
 			beltBlockCopy(st->block, key);
 			beltBlockCopy(st->block + 16, key + 16);
 #if (OCTET_ORDER == BIG_ENDIAN)
-			beltBlockRevU32(st->block);
-			beltBlockRevU32(st->block + 16);
+			beltBlocksRevU32(st->block, 2);
 #endif
 			beltCompr2(st->ls_in + 4, st->h_in, (u32*)st->block, st->stack);
 			key += 32;
@@ -80,8 +79,7 @@ void beltHMACStart(void* state, const octet key[], size_t len)
 			memCopy(st->block, key, len);
 			memSetZero(st->block + len, 32 - len);
 #if (OCTET_ORDER == BIG_ENDIAN)
-			beltBlockRevU32(st->block);
-			beltBlockRevU32(st->block + 16);
+			beltBlocksRevU32(st->block, 2);
 #endif
 			beltCompr2(st->ls_in + 4, st->h_in, (u32*)st->block, st->stack);
 		}
@@ -110,6 +108,44 @@ void beltHMACStart(void* state, const octet key[], size_t len)
 	beltCompr2(st->ls_out + 4, st->h_out, (u32*)st->block, st->stack);
 }
 
+/*
+*******************************************************************************
+Подготовленный ключ HMAC
+
+В подготовленном ключе сохраняются состояния внутреннего и внешнего
+хэширования после обработки блоков key ^ ipad и key ^ opad. Начало работы
+с подготовленным ключом сводится к копированию этих состояний.
+*******************************************************************************
+*/
+size_t beltHMACKey_keep()
+{
+	return sizeof(belt_hmac_key_st);
+}
+
+void beltHMACKeyPrepare(void* hkey, const void* state)
+{
+	const belt_hmac_st* st = (const belt_hmac_st*)state;
+	belt_hmac_key_st* hk = (belt_hmac_key_st*)hkey;
+	ASSERT(memIsDisjoint2(hkey, beltHMACKey_keep(), state, beltHMAC_keep()));
+	ASSERT(st->filled == 0);
+	memCopy(hk->ls_in, st->ls_in, 32);
+	memCopy(hk->h_in, st->h_in, 32);
+	memCopy(hk->ls_out, st->ls_out, 32);
+	memCopy(hk->h_out, st->h_out, 32);
+}
+
+void beltHMACStartPrepared(void* state, const void* hkey)
+{
+	belt_hmac_st* st = (belt_hmac_st*)state;
+	const belt_hmac_key_st* hk = (const belt_hmac_key_st*)hkey;
+	ASSERT(memIsDisjoint2(hkey, beltHMACKey_keep(), state, beltHMAC_keep()));
+	memCopy(st->ls_in, hk->ls_in, 32);
+	memCopy(st->h_in, hk->h_in, 32);
+	memCopy(st->ls_out, hk->ls_out, 32);
+	memCopy(st->h_out, hk->h_out, 32);
+	st->filled = 0;
+}
+
 void beltHMACStepA(const void* buf, size_t count, void* state)
 {
 	belt_hmac_st* st = (belt_hmac_st*)state;
@@ -129,8 +165,7 @@ void beltHMACStepA(const void* buf, size_t count, void* state)
 		count -= 32 - st->filled;
 		buf = (const octet*)buf + (32 - st->filled);
 #if (OCTET_ORDER == BIG_ENDIAN)
-		beltBlockRevU32(st->block);
-		beltBlockRevU32(st->block + 16);
+		beltBlocksRevU32(st->block, 2);
 #endif
 		beltCompr2(st->ls_in + 4, st->h_in, (u32*)st->block, st->stack);
 		st->filled = 0;
@@ -141,8 +176,7 @@ void beltHMACStepA(const void* buf, size_t count, void* state)
 		beltBlockCopy(st->block, buf);
 		beltBlockCopy(st->block + 16, (const octet*)buf + 16);
 #if (OCTET_ORDER == BIG_ENDIAN)
-		beltBlockRevU32(st->block);
-		beltBlockRevU32(st->block + 16);
+		beltBlocksRevU32(st->block, 2);
 #endif
 		beltCompr2(st->ls_in + 4, st->h_in, (u32*)st->block, st->stack);
 		buf = (const octet*)buf + 32;
@@ -153,6 +187,16 @@ void beltHMACStepA(const void* buf, size_t count, void* state)
 		memCopy(st->block, buf, st->filled = count);
 }
 
+void beltHMACStepAV(const void* const buf[], const size_t count[], size_t n,
+	void* state)
+{
+	size_t i;
+	ASSERT(memIsValid(buf, n * sizeof(const void*)));
+	ASSERT(memIsValid(count, n * sizeof(size_t)));
+	for (i = 0; i < n; ++i)
+		beltHMACStepA(buf[i], count[i], state);
+}
+
 static void beltHMACStepG_internal(void* state)
 {
 	belt_hmac_st* st = (belt_hmac_st*)state;
@@ -167,13 +211,11 @@ static void beltHMACStepG_internal(void* state)
 	{
 		memSetZero(st->block + st->filled, 32 - st->filled);
 #if (OCTET_ORDER == BIG_ENDIAN)
-		beltBlockRevU32(st->block);
-		beltBlockRevU32(st->block + 16);
+		beltBlocksRevU32(st->block, 2);
 #endif
 		beltCompr2(st->ls_in + 4, st->h1_in, (u32*)st->block, st->stack);
 #if (OCTET_ORDER == BIG_ENDIAN)
-		beltBlockRevU32(st->block + 16);
-		beltBlockRevU32(st->block);
+		beltBlocksRevU32(st->block, 2);
 #endif
 	}
 	// последний блок внутреннего хэширования
@@ -215,8 +257,7 @@ bool_t beltHMACStepV(const octet mac[32], void* state)
 	ASSERT(memIsValid(mac, 32));
 	beltHMACStepG_internal(state);
 #if (OCTET_ORDER == BIG_ENDIAN)
-	beltBlockRevU32(st->h1_out);
-	beltBlockRevU32(st->h1_out + 4);
+	beltBlocksRevU32(st->h1_out, 2);
 #endif
 	return memEq(mac, st->h1_out, 32);
 }
@@ -228,8 +269,7 @@ bool_t beltHMACStepV2(const octet mac[], size_t mac_len, void* state)
 	ASSERT(memIsValid(mac, mac_len));
 	beltHMACStepG_internal(state);
 #if (OCTET_ORDER == BIG_ENDIAN)
-	beltBlockRevU32(st->h1_out);
-	beltBlockRevU32(st->h1_out + 4);
+	beltBlocksRevU32(st->h1_out, 2);
 #endif
 	return memEq(mac, st->h1_out, mac_len);
 }
@@ -244,14 +284,16 @@ err_t beltHMAC(octet mac[32], const void* src, size_t count,
 		!memIsValid(mac, 32))
 		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(beltHMAC_keep());
+	state = stackCreate(beltHMAC_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltHMAC");
 	// выработать имитовставку
 	beltHMACStart(state, key, len);
 	beltHMACStepA(src, count, state);
 	beltHMACStepG(mac, state);
 	// завершить
-	blobClose(state);
+	tmTraceEnd("beltHMAC");
+	stackClose(state);
 	return ERR_OK;
 }
@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): KRP (keyrep = key diversification + meshing)
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2020.03.24
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,7 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/u32.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
@@ -21,6 +22,14 @@
 /*
 *******************************************************************************
 Преобразование ключа
+
+В функции beltKRPStepGN() ключи строятся четверками: блоки
+r || level || header_j и копии первоначального ключа сжимаются
+одновременно с помощью beltCompr2X4(). Чтобы не увеличивать состояние,
+четверки размещаются в стеке, который создается функцией stackCreate(),
+вместе со стеком beltCompr2X4(): для каждого j = 0, 1, 2, 3 -- 
+[8]X_j, [8]h_j, [4]s_j (s_j не используются). Если стек создать
+не удалось, то ключи строятся по одному.
 *******************************************************************************
 */
 
@@ -69,6 +78,56 @@ void beltKRPStepG(octet key_[], size_t key_len, const octet header[16],
 	u32To(key_, key_len, st->key_new);
 }
 
+void beltKRPStepGN(octet keys[], size_t key_len, const octet headers[],
+	size_t n, void* state)
+{
+	belt_krp_st* st = (belt_krp_st*)state;
+	u32* X;
+	u32* h;
+	u32* s;
+	const u32* xs[4];
+	u32* hs[4];
+	u32* ss[4];
+	size_t j;
+	// pre
+	ASSERT(memIsValid(state, beltKRP_keep()));
+	ASSERT(key_len == 16 || key_len == 24 || key_len == 32);
+	ASSERT(key_len <= st->len);
+	ASSERT(memIsDisjoint2(keys, key_len * n, state, beltKRP_keep()));
+	ASSERT(memIsDisjoint2(headers, 16 * n, state, beltKRP_keep()));
+	// создать стек
+	if (n < 4 || 
+		!(X = (u32*)stackCreate(4 * 20 * 4 + beltCompr2X4_deep())))
+	{
+		for (; n; --n, headers += 16, keys += key_len)
+			beltKRPStepG(keys, key_len, headers, state);
+		return;
+	}
+	h = X + 32, s = h + 32;
+	// полностью определить st->block (кроме заголовка)
+	u32From(st->block, beltH() + 4 * (st->len - 16) + 2 * (key_len - 16), 4);
+	// четверки ключей
+	for (j = 0; j < 4; ++j)
+		xs[j] = X + 8 * j, hs[j] = h + 8 * j, ss[j] = s + 4 * j;
+	for (; n >= 4; n -= 4, headers += 64, keys += 4 * key_len)
+	{
+		for (j = 0; j < 4; ++j)
+		{
+			beltBlockCopy(X + 8 * j, st->block);
+			u32From(X + 8 * j + 4, headers + 16 * j, 16);
+			beltBlockCopy(hs[j], st->key);
+			beltBlockCopy(hs[j] + 4, st->key + 4);
+		}
+		beltCompr2X4(ss, hs, xs, s + 16);
+		for (j = 0; j < 4; ++j)
+			u32To(keys + key_len * j, key_len, hs[j]);
+	}
+	stackClose(X);
+	// остальные ключи
+	for (; n; --n, headers += 16, keys += key_len)
+		beltKRPStepG(keys, key_len, headers, state);
+}
+
 err_t beltKRP(octet dest[], size_t m, const octet src[], size_t n,
 	const octet level[12], const octet header[16])
 {
@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): KWP (keywrap = key encryption + authentication)
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2019.06.26
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,7 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
 #include "belt_lcl.h"
@@ -40,6 +41,7 @@ err_t beltKWPWrap(octet dest[], const octet src[], size_t count,
 	state = blobCreate(beltKWP_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltKWPWrap");
 	// установить защиту
 	beltKWPStart(state, key, len);
 	memMove(dest, src, count);
@@ -49,6 +51,7 @@ err_t beltKWPWrap(octet dest[], const octet src[], size_t count,
 		memSetZero(dest + count, 16);
 	beltKWPStepE(dest, count + 16, state);
 	// завершить
+	tmTraceEnd("beltKWPWrap");
 	blobClose(state);
 	return ERR_OK;
 }
@@ -70,6 +73,7 @@ err_t beltKWPUnwrap(octet dest[], const octet src[], size_t count,
 	state = blobCreate(beltKWP_keep() + 16);
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltKWPUnwrap");
 	header2 = (octet*)state + beltKWP_keep();
 	// снять защиту
 	beltKWPStart(state, key, len);
@@ -80,10 +84,88 @@ err_t beltKWPUnwrap(octet dest[], const octet src[], size_t count,
 		header == 0 && !memIsZero(header2, 16))
 	{
 		memSetZero(dest, count - 16);
+		tmTraceEnd("beltKWPUnwrap");
 		blobClose(state);
 		return ERR_BAD_KEYTOKEN;
 	}
 	// завершить
+	tmTraceEnd("beltKWPUnwrap");
 	blobClose(state);
 	return ERR_OK;
 }
+
+/*
+*******************************************************************************
+Пакетная обработка ключей
+
+Используется состояние, подготовленное вызывающей стороной. Защита
+устанавливается для четверок ключей одновременно с помощью beltWBLStepE4().
+Динамическая память не используется.
+*******************************************************************************
+*/
+
+err_t beltKWPWrapN(octet dest[], const octet src[], size_t count, size_t n,
+	const octet header[16], void* state)
+{
+	size_t i;
+	// проверить входные данные
+	if (count < 16 ||
+		!memIsValid(src, count * n) ||
+		!memIsNullOrValid(header, 16) ||
+		!memIsValid(state, beltKWP_keep()) ||
+		!memIsValid(dest, (count + 16) * n) ||
+		!memIsDisjoint2(dest, (count + 16) * n, src, count * n) ||
+		header && !memIsDisjoint2(dest, (count + 16) * n, header, 16) ||
+		!memIsDisjoint2(dest, (count + 16) * n, state, beltKWP_keep()))
+		return ERR_BAD_INPUT;
+	// сформировать блоки [count]src || header
+	for (i = 0; i < n; ++i)
+	{
+		octet* d = dest + (count + 16) * i;
+		memCopy(d, src + count * i, count);
+		if (header)
+			memCopy(d + count, header, 16);
+		else
+			memSetZero(d + count, 16);
+	}
+	// установить защиту
+	if (count % 16 == 0)
+		for (; n >= 4; n -= 4, dest += 4 * (count + 16))
+			beltWBLStepE4(dest, count + 16, state);
+	for (; n; --n, dest += count + 16)
+		beltKWPStepE(dest, count + 16, state);
+	return ERR_OK;
+}
+
+err_t beltKWPUnwrapN(octet dest[], const octet src[], size_t count, size_t n,
+	const octet header[16], void* state)
+{
+	octet header2[16];
+	size_t i;
+	// проверить входные данные
+	if (count < 32 ||
+		!memIsValid(src, count * n) ||
+		!memIsNullOrValid(header, 16) ||
+		!memIsValid(state, beltKWP_keep()) ||
+		!memIsValid(dest, (count - 16) * n) ||
+		!memIsDisjoint2(dest, (count - 16) * n, src, count * n) ||
+		!memIsDisjoint2(dest, (count - 16) * n, state, beltKWP_keep()))
+		return ERR_BAD_INPUT;
+	// снять защиту
+	for (i = 0; i < n; ++i)
+	{
+		octet* d = dest + (count - 16) * i;
+		memCopy(header2, src + count * i + count - 16, 16);
+		memCopy(d, src + count * i, count - 16);
+		beltKWPStepD2(d, header2, count, state);
+		if (header && !memEq(header, header2, 16) ||
+			header == 0 && !memIsZero(header2, 16))
+		{
+			memSetZero(dest, (count - 16) * n);
+			memSetZero(header2, 16);
+			return ERR_BAD_KEYTOKEN;
+		}
+	}
+	memSetZero(header2, 16);
+	return ERR_OK;
+}
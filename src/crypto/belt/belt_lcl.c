@@ -4,12 +4,13 @@
 \brief STB 34.101.31 (belt): local functions
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2020.03.20
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include "bee2/core/cpu.h"
 #include "bee2/core/mem.h"
 #include "bee2/core/u32.h"
 #include "bee2/core/util.h"
@@ -87,19 +88,109 @@ void beltHalfBlockAddBitSizeW(word block[W_OF_B(64)], size_t count)
 	carry = 0;
 }
 
+/*
+*******************************************************************************
+Умножение многочленов без переносов
+
+Если платформа поддерживает инструкции умножения без переносов
+(PCLMULQDQ на x86, PMULL на AArch64), то произведение 128-битовых
+многочленов вычисляется с их помощью по схеме
+	(a1 x^64 + a0)(b1 x^64 + b0) =
+		a1 b1 x^128 + (a1 b0 + a0 b1) x^64 + a0 b0.
+Приведение по модулю выполняется так же, как и в общем случае
+(функция ppRedBelt()).
+
+На платформе x86 наличие PCLMULQDQ проверяется во время выполнения
+(cpuHas()). На платформе AArch64 функция beltClMul() с PMULL включается
+во время компиляции (макрос __ARM_FEATURE_CRYPTO), а во время выполнения
+проверяется только, что набор PMULL не снят (cpuHas()).
+*******************************************************************************
+*/
+
+#if (OCTET_ORDER == LITTLE_ENDIAN) &&\
+	((defined(__GNUC__) || defined(__clang__)) &&\
+		(defined(__i386__) || defined(__x86_64__)) ||\
+	(_MSC_VER >= 1600) && (defined(_M_IX86) || defined(_M_X64)))
+
+#define BELT_CLMUL
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+	#define BELT_CLMUL_TARGET
+#else
+	#define BELT_CLMUL_TARGET __attribute__((target("sse2,pclmul")))
+#endif
+#include <wmmintrin.h>
+
+#define beltClMulIsAvail() cpuHas(CPU_PCLMUL)
+
+BELT_CLMUL_TARGET
+static void beltClMul(word c[], const word a[], const word b[])
+{
+	__m128i x = _mm_loadu_si128((const __m128i*)a);
+	__m128i y = _mm_loadu_si128((const __m128i*)b);
+	__m128i lo = _mm_clmulepi64_si128(x, y, 0x00);
+	__m128i hi = _mm_clmulepi64_si128(x, y, 0x11);
+	__m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(x, y, 0x01),
+		_mm_clmulepi64_si128(x, y, 0x10));
+	lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+	hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+	_mm_storeu_si128((__m128i*)c, lo);
+	_mm_storeu_si128((__m128i*)c + 1, hi);
+}
+
+#elif (OCTET_ORDER == LITTLE_ENDIAN) && defined(__aarch64__) &&\
+	defined(__ARM_FEATURE_CRYPTO)
+
+#define BELT_CLMUL
+
+#include <arm_neon.h>
+
+#define beltClMulIsAvail() cpuHas(CPU_PMULL)
+
+static void beltClMul(word c[], const word a[], const word b[])
+{
+	const u64* x = (const u64*)a;
+	const u64* y = (const u64*)b;
+	u64* z = (u64*)c;
+	uint64x2_t lo = vreinterpretq_u64_p128(vmull_p64(x[0], y[0]));
+	uint64x2_t hi = vreinterpretq_u64_p128(vmull_p64(x[1], y[1]));
+	uint64x2_t mid = veorq_u64(
+		vreinterpretq_u64_p128(vmull_p64(x[0], y[1])),
+		vreinterpretq_u64_p128(vmull_p64(x[1], y[0])));
+	z[0] = vgetq_lane_u64(lo, 0);
+	z[1] = vgetq_lane_u64(lo, 1) ^ vgetq_lane_u64(mid, 0);
+	z[2] = vgetq_lane_u64(hi, 0) ^ vgetq_lane_u64(mid, 1);
+	z[3] = vgetq_lane_u64(hi, 1);
+}
+
+#endif
+
 /*
 *******************************************************************************
 Арифметика многочленов
 *******************************************************************************
 */
 
+static void beltPolyMulRaw(word c[], const word a[], const word b[],
+	void* stack)
+{
+	const size_t n = W_OF_B(128);
+#ifdef BELT_CLMUL
+	if (beltClMulIsAvail())
+		beltClMul(c, a, b);
+	else
+#endif
+		ppMul(c, a, n, b, n, stack);
+}
+
 void beltPolyMul(word c[], const word a[], const word b[], void* stack)
 {
 	const size_t n = W_OF_B(128);
 	word* prod = (word*)stack;
 	stack = prod + 2 * n;
 	// умножить
-	ppMul(prod, a, n, b, n, stack);
+	beltPolyMulRaw(prod, a, b, stack);
 	// привести по модулю
 	ppRedBelt(prod);
 	wwCopy(c, prod, n);
@@ -111,6 +202,58 @@ size_t beltPolyMul_deep()
 	return O_OF_W(2 * n) + ppMul_deep(n, n);
 }
 
+/*
+*******************************************************************************
+Обработка восьми блоков
+
+Выполняется преобразование
+	t <- (((t + X1) r + X2) r + ... + X8) r =
+		(t + X1) r^8 + X2 r^7 + ... + X8 r.
+Произведения во второй строке накапливаются без приведения. Приведение
+выполняется один раз. Степени r^i хранятся в rr[i - 1].
+*******************************************************************************
+*/
+
+void beltPolyMul8(word t[], const word rr[], const void* buf, void* stack)
+{
+	const size_t n = W_OF_B(128);
+	size_t i;
+	word* acc = (word*)stack;
+	word* prod = acc + 2 * n;
+	word* block = prod + 2 * n;
+	stack = block + n;
+	// (t + X1) r^8
+	wwFrom(block, buf, 16);
+	beltBlockXor2(block, t);
+	beltPolyMulRaw(acc, block, rr + 7 * n, stack);
+	// + X2 r^7 + ... + X8 r
+	for (i = 1; i < 8; ++i)
+	{
+		buf = (const octet*)buf + 16;
+		wwFrom(block, buf, 16);
+		beltPolyMulRaw(prod, block, rr + (7 - i) * n, stack);
+		wwXor2(acc, prod, 2 * n);
+	}
+	// привести по модулю
+	ppRedBelt(acc);
+	wwCopy(t, acc, n);
+}
+
+size_t beltPolyMul8_deep()
+{
+	const size_t n = W_OF_B(128);
+	return O_OF_W(5 * n) + ppMul_deep(n, n);
+}
+
+void beltPolyPowers(word rr[], const word r[], void* stack)
+{
+	const size_t n = W_OF_B(128);
+	size_t i;
+	wwCopy(rr, r, n);
+	for (i = 1; i < 8; ++i)
+		beltPolyMul(rr + i * n, rr + (i - 1) * n, r, stack);
+}
+
 /*
 *******************************************************************************
 Умножение на многочлен C(x) = x mod (x^128 + x^7 + x^2 + x + 1)
@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): local definitions
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2020.03.20
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,7 @@
 #ifndef __BELT_LCL_H
 #define __BELT_LCL_H
 
+#include "bee2/core/mem.h"
 #include "bee2/core/word.h"
 #include "bee2/core/u32.h"
 
@@ -187,11 +188,22 @@ extern "C" {
 	#error "Unsupported word size"
 #endif // B_PER_W
 
+// сложение серий из n блоков (векторные ядра memXor(), memXor2())
+#define beltBlocksXor(dest, src1, src2, n)\
+	memXor(dest, src1, src2, 16 * (n))\
+
+#define beltBlocksXor2(dest, src, n)\
+	memXor2(dest, src, 16 * (n))\
+
 #define beltBlockRevU32(block)\
-	((u32*)(block))[0] = u32Rev(((u32*)(block))[0]),\
-	((u32*)(block))[1] = u32Rev(((u32*)(block))[1]),\
-	((u32*)(block))[2] = u32Rev(((u32*)(block))[2]),\
-	((u32*)(block))[3] = u32Rev(((u32*)(block))[3])\
+	((u32*)(block))[0] = u32Rev_(((u32*)(block))[0]),\
+	((u32*)(block))[1] = u32Rev_(((u32*)(block))[1]),\
+	((u32*)(block))[2] = u32Rev_(((u32*)(block))[2]),\
+	((u32*)(block))[3] = u32Rev_(((u32*)(block))[3])\
+
+// реверс серии из n блоков (векторный цикл u32Rev2())
+#define beltBlocksRevU32(blocks, n)\
+	u32Rev2((u32*)(blocks), 4 * (n))\
 
 #define beltBlockIncU32(block)\
 	if ((((u32*)(block))[0] += 1) == 0 &&\
@@ -209,7 +221,9 @@ typedef struct
 {
 	u32 key[8];			/*< форматированный ключ */
 	u32 ctr[4];			/*< счетчик */
+	u32 ctr0[4];		/*< начальный счетчик */
 	octet block[16];	/*< блок гаммы */
+	u32 gamma[16];		/*< четверка блоков гаммы */
 	size_t reserved;	/*< резерв октетов гаммы */
 } belt_ctr_st;
 
@@ -221,16 +235,58 @@ typedef struct
 	word round;			/*< номер такта */
 } belt_wbl_st;
 
+/*
+*******************************************************************************
+Подготовленный ключ (используется в функциях beltXXXStartK())
+*******************************************************************************
+*/
+
+typedef struct
+{
+	u32 key[8];			/*< форматированный ключ */
+	u32 r[4];			/*< переменная r режима MAC */
+} belt_key_st;
+
+/*
+*******************************************************************************
+Подготовленный ключ HMAC (используется в PBKDF2)
+*******************************************************************************
+*/
+
+typedef struct
+{
+	u32 ls_in[8];		/*< блок [4]len || [4]s внутреннего хэширования */
+	u32 h_in[8];		/*< переменная h внутреннего хэширования */
+	u32 ls_out[8];		/*< блок [4]len || [4]s внешнего хэширования */
+	u32 h_out[8];		/*< переменная h внешнего хэширования */
+} belt_hmac_key_st;
+
 /*
 *******************************************************************************
 Вспомогательные функции
 *******************************************************************************
 */
 
+void beltBlockEncr4(u32 blocks[16], const u32* keys[4]);
+void beltBlockEncr2X2(u32 blocks[8], const u32* keys[2]);
+
+#if defined(BELT_AUTO)
+void beltBlockEncrNAVX2(u32 blocks[], size_t count, const u32 key[8]);
+void beltBlockDecrNAVX2(u32 blocks[], size_t count, const u32 key[8]);
+void beltBlockEncrNAVX512(u32 blocks[], size_t count, const u32 key[8]);
+void beltBlockDecrNAVX512(u32 blocks[], size_t count, const u32 key[8]);
+#endif
+void beltWBLStepE4(void* buf, size_t count, void* state);
+void beltWBLStepD4(void* buf, size_t count, void* state);
+void beltCompr2X4(u32* s[4], u32* h[4], const u32* X[4], void* stack);
+size_t beltCompr2X4_deep();
 void beltBlockAddBitSizeU32(u32 block[4], size_t count);
 void beltHalfBlockAddBitSizeW(word block[W_OF_B(64)], size_t count);
 void beltPolyMul(word c[], const word a[], const word b[], void* stack);
 size_t beltPolyMul_deep();
+void beltPolyMul8(word t[], const word rr[], const void* buf, void* stack);
+size_t beltPolyMul8_deep();
+void beltPolyPowers(word rr[], const word r[], void* stack);
 void beltBlockMulC(u32 block[4]);
 
 
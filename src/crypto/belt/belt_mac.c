@@ -4,15 +4,16 @@
 \brief STB 34.101.31 (belt): MAC (message authentication)
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2020.03.24
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
-#include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/stack.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/u32.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
@@ -55,6 +56,18 @@ void beltMACStart(void* state, const octet key[], size_t len)
 	st->filled = 0;
 }
 
+void beltMACStartK(void* state, const void* skey)
+{
+	belt_mac_st* st = (belt_mac_st*)state;
+	const belt_key_st* sk = (const belt_key_st*)skey;
+	ASSERT(memIsValid(state, beltMAC_keep()));
+	ASSERT(memIsDisjoint2(skey, beltKey_keep(), state, beltMAC_keep()));
+	memCopy(st->key, sk->key, 32);
+	beltBlockSetZero(st->s);
+	memCopy(st->r, sk->r, 16);
+	st->filled = 0;
+}
+
 void beltMACStepA(const void* buf, size_t count, void* state)
 {
 	belt_mac_st* st = (belt_mac_st*)state;
@@ -98,6 +111,16 @@ void beltMACStepA(const void* buf, size_t count, void* state)
 	}
 }
 
+void beltMACStepAV(const void* const buf[], const size_t count[], size_t n,
+	void* state)
+{
+	size_t i;
+	ASSERT(memIsValid(buf, n * sizeof(const void*)));
+	ASSERT(memIsValid(count, n * sizeof(size_t)));
+	for (i = 0; i < n; ++i)
+		beltMACStepA(buf[i], count[i], state);
+}
+
 static void beltMACStepG_internal(void* state)
 {
 	belt_mac_st* st = (belt_mac_st*)state;
@@ -190,14 +213,186 @@ err_t beltMAC(octet mac[8], const void* src, size_t count,
 		!memIsValid(mac, 8))
 		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(beltMAC_keep());
+	state = stackCreate(beltMAC_keep());
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltMAC");
 	// выработать имитовставку
 	beltMACStart(state, key, len);
 	beltMACStepA(src, count, state);
 	beltMACStepG(mac, state);
 	// завершить
-	blobClose(state);
+	tmTraceEnd("beltMAC");
+	stackClose(state);
+	return ERR_OK;
+}
+
+/*
+*******************************************************************************
+Имитозащита нескольких сообщений
+
+Сообщения образуют очередь заданий, которые распределяются по четырем
+дорожкам (lanes), как в beltHashMB(). Выработка имитовставки сообщения
+сводится к последовательности зашифрований блоков на ключе сообщения:
+-	зашифрование нулевого блока (определение r);
+-	зашифрование s ^ X для каждого неокончательного блока X;
+-	зашифрование s ^ X* ^ phi(r) для окончательного (дополненного) блока X*.
+На каждом шаге дорожка готовит очередной блок. Если заняты все четыре
+дорожки, то их блоки зашифровываются одновременно с помощью
+beltBlockEncr4() (на разных ключах). Если очередь пуста и занятых дорожек
+меньше четырех, то блоки зашифровываются по отдельности. Обработка
+окончательных блоков также выполняется четверками. Дорожка, завершившая
+задание, сразу получает следующее.
+*******************************************************************************
+*/
+
+typedef struct {
+	u32 key[8];				/*< форматированный ключ */
+	u32 s[4];				/*< переменная s */
+	u32 r[4];				/*< переменная r */
+	u32 X[4];				/*< зашифровываемый блок */
+	size_t job;				/*< номер задания */
+	size_t pos;				/*< обработано октетов задания */
+	bool_t started;			/*< r определена? */
+	bool_t busy;			/*< дорожка занята? */
+} belt_mac_lane_st;
+
+static void beltMACLanePrepare(belt_mac_lane_st* lane, const octet* src,
+	size_t count)
+{
+	octet block[16];
+	size_t rest = count - lane->pos;
+	// определение r
+	if (!lane->started)
+	{
+		beltBlockSetZero(lane->X);
+		return;
+	}
+	// неокончательный блок
+	if (rest > 16)
+	{
+		u32From(lane->X, src + lane->pos, 16);
+		beltBlockXor2(lane->X, lane->s);
+		return;
+	}
+	// окончательный блок
+	memCopy(block, src + lane->pos, rest);
+	if (rest < 16)
+	{
+		block[rest] = 0x80;
+		memSetZero(block + rest + 1, 16 - rest - 1);
+	}
+	u32From(lane->X, block, 16);
+	beltBlockXor2(lane->X, lane->s);
+	if (rest == 16)
+	{
+		lane->X[0] ^= lane->r[1];
+		lane->X[1] ^= lane->r[2];
+		lane->X[2] ^= lane->r[3];
+		lane->X[3] ^= lane->r[0] ^ lane->r[1];
+	}
+	else
+	{
+		lane->X[0] ^= lane->r[0] ^ lane->r[3];
+		lane->X[1] ^= lane->r[0];
+		lane->X[2] ^= lane->r[1];
+		lane->X[3] ^= lane->r[2];
+	}
+	memWipe(block, 16);
+}
+
+static void beltMACLaneFinish(belt_mac_lane_st* lane, octet mac[8],
+	size_t count)
+{
+	// определена r
+	if (!lane->started)
+		beltBlockCopy(lane->r, lane->X), lane->started = TRUE;
+	// обработан неокончательный блок
+	else if (count - lane->pos > 16)
+		beltBlockCopy(lane->s, lane->X), lane->pos += 16;
+	// выработана имитовставка
+	else
+		u32To(mac, 8, lane->X), lane->busy = FALSE;
+}
+
+err_t beltMACMB(octet mac[], const void* const src[], const size_t count[],
+	const octet* const key[], const size_t len[], size_t n)
+{
+	belt_mac_lane_st* lanes;
+	size_t next;
+	size_t i;
+	// проверить входные данные
+	if (!memIsValid(src, n * sizeof(const void*)) ||
+		!memIsValid(count, n * O_PER_S) ||
+		!memIsValid(key, n * sizeof(const octet*)) ||
+		!memIsValid(len, n * O_PER_S) ||
+		!memIsValid(mac, 8 * n))
+		return ERR_BAD_INPUT;
+	for (i = 0; i < n; ++i)
+		if (len[i] != 16 && len[i] != 24 && len[i] != 32 ||
+			!memIsValid(src[i], count[i]) ||
+			!memIsValid(key[i], len[i]))
+			return ERR_BAD_INPUT;
+	// создать состояние
+	lanes = (belt_mac_lane_st*)stackCreate(4 * sizeof(belt_mac_lane_st));
+	if (lanes == 0)
+		return ERR_OUTOFMEMORY;
+	tmTraceBegin("beltMACMB");
+	// цикл обработки очереди
+	for (next = 0;;)
+	{
+		size_t active = 0;
+		size_t j;
+		// назначить задания свободным дорожкам
+		for (j = 0; j < 4; ++j)
+		{
+			belt_mac_lane_st* lane = lanes + j;
+			if (!lane->busy && next < n)
+			{
+				lane->job = next++, lane->pos = 0;
+				lane->started = FALSE, lane->busy = TRUE;
+				beltKeyExpand2(lane->key, key[lane->job], len[lane->job]);
+				beltBlockSetZero(lane->s);
+			}
+			if (lane->busy)
+			{
+				beltMACLanePrepare(lane, (const octet*)src[lane->job],
+					count[lane->job]);
+				++active;
+			}
+		}
+		if (active == 0)
+			break;
+		// одновременное зашифрование
+		if (active == 4)
+		{
+			u32 blocks[16];
+			const u32* keys[4];
+			for (j = 0; j < 4; ++j)
+			{
+				beltBlockCopy(blocks + 4 * j, lanes[j].X);
+				keys[j] = lanes[j].key;
+			}
+			beltBlockEncr4(blocks, keys);
+			for (j = 0; j < 4; ++j)
+				beltBlockCopy(lanes[j].X, blocks + 4 * j);
+			memWipe(blocks, sizeof(blocks));
+		}
+		// очередь пуста: зашифрование по отдельности
+		else for (j = 0; j < 4; ++j)
+			if (lanes[j].busy)
+				beltBlockEncr2(lanes[j].X, lanes[j].key);
+		// обработать результаты
+		for (j = 0; j < 4; ++j)
+		{
+			belt_mac_lane_st* lane = lanes + j;
+			if (lane->busy)
+				beltMACLaneFinish(lane, mac + 8 * lane->job,
+					count[lane->job]);
+		}
+	}
+	// завершить
+	tmTraceEnd("beltMACMB");
+	stackClose(lanes);
 	return ERR_OK;
 }
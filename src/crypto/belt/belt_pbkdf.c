@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): PBKDF (password-based key derivation)
 \project bee2 [cryptographic library]
 \created 2012.12.18
-\version 2017.09.28
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,7 +13,10 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/u32.h"
+#include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
+#include "belt_lcl.h"
 
 /*
 *******************************************************************************
@@ -25,6 +28,7 @@ err_t beltPBKDF2(octet key[32], const octet pwd[], size_t pwd_len,
 	size_t iter, const octet salt[], size_t salt_len)
 {
 	void* state;
+	void* hkey;
 	octet* t;
 	// проверить входные данные
 	if (iter == 0 ||
@@ -33,12 +37,15 @@ err_t beltPBKDF2(octet key[32], const octet pwd[], size_t pwd_len,
 		!memIsValid(key, 32))
 		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(beltHMAC_keep() + 32);
+	state = blobCreate(beltHMAC_keep() + beltHMACKey_keep() + 32);
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
-	t = (octet*)state + beltHMAC_keep();
-	// key <- HMAC(pwd, salt || 00000001)
+	hkey = (octet*)state + beltHMAC_keep();
+	t = (octet*)hkey + beltHMACKey_keep();
+	// подготовить ключ
 	beltHMACStart(state, pwd, pwd_len);
+	beltHMACKeyPrepare(hkey, state);
+	// key <- HMAC(pwd, salt || 00000001)
 	beltHMACStepA(salt, salt_len, state);
 	*(u32*)key = 0, key[3] = 1;
 	beltHMACStepA(key, 4, state);
@@ -47,7 +54,7 @@ err_t beltPBKDF2(octet key[32], const octet pwd[], size_t pwd_len,
 	memCopy(t, key, 32);
 	while (--iter)
 	{
-		beltHMACStart(state, pwd, pwd_len);
+		beltHMACStartPrepared(state, hkey);
 		beltHMACStepA(t, 32, state);
 		beltHMACStepG(t, state);
 		memXor2(key, t, 32);
@@ -56,3 +63,224 @@ err_t beltPBKDF2(octet key[32], const octet pwd[], size_t pwd_len,
 	blobClose(state);
 	return ERR_OK;
 }
+
+/*
+*******************************************************************************
+Построение ключей по нескольким паролям
+
+Цепочки итераций для четверки паролей обрабатываются одновременно
+на дорожках beltCompr2X4(). Каждая итерация HMAC(pwd, t) над 32-октетным
+t сводится к четырем сжатиям:
+1)	ls <- ls_in, len(ls) += 256, h <- h_in, beltCompr2(ls + 4, h, t);
+2)	beltCompr(h, ls) [h -- результат внутреннего хэширования];
+3)	ls <- ls_out, h1 <- h_out, beltCompr2(ls + 4, h1, h);
+4)	beltCompr(h1, ls) [h1 -- результат HMAC].
+Сжатия beltCompr() выполняются также с помощью beltCompr2X4(), при этом
+изменения s сбрасываются в вспомогательный блок s1.
+
+Первая итерация выполняется для каждого пароля отдельно с помощью
+обычных функций HMAC. В неполной последней четверке свободные дорожки
+повторяют вычисления по первому паролю четверки, результаты этих
+вычислений отбрасываются. Если же последняя четверка состоит из одного
+пароля, то ключ по нему строится обычной функцией beltPBKDF2(): дорожки
+beltCompr2X4() не дают выигрыша, а только добавляют работу (например,
+при разборе 5 контейнеров с частичными секретами).
+*******************************************************************************
+*/
+
+typedef struct
+{
+	belt_hmac_key_st hk;	/*< подготовленный ключ */
+	u32 ls[8];				/*< блок [4]len || [4]s */
+	u32 h[8];				/*< результат внутреннего хэширования */
+	u32 h1[8];				/*< результат внешнего хэширования */
+	u32 s1[4];				/*< вспомогательный блок */
+	u32 t[8];				/*< текущая имитовставка */
+	u32 key[8];				/*< накопленный ключ */
+} belt_pbkdf_lane_st;
+
+err_t beltPBKDF2MB(octet keys[], const octet* const pwds[], 
+	const size_t pwd_lens[], size_t iter, const octet* const salts[], 
+	const size_t salt_lens[], size_t n)
+{
+	void* state;
+	belt_pbkdf_lane_st* lanes;
+	void* hmac;
+	void* stack;
+	size_t i;
+	err_t code = ERR_OK;
+	// проверить входные данные
+	if (iter == 0 ||
+		!memIsValid(pwds, n * sizeof(const octet*)) ||
+		!memIsValid(pwd_lens, n * O_PER_S) ||
+		!memIsValid(salts, n * sizeof(const octet*)) ||
+		!memIsValid(salt_lens, n * O_PER_S) ||
+		!memIsValid(keys, 32 * n))
+		return ERR_BAD_INPUT;
+	for (i = 0; i < n; ++i)
+		if (!memIsValid(pwds[i], pwd_lens[i]) ||
+			!memIsValid(salts[i], salt_lens[i]))
+			return ERR_BAD_INPUT;
+	// создать состояние
+	state = blobCreate(4 * sizeof(belt_pbkdf_lane_st) + beltHMAC_keep() + 
+		beltCompr2X4_deep());
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	lanes = (belt_pbkdf_lane_st*)state;
+	hmac = lanes + 4;
+	stack = (octet*)hmac + beltHMAC_keep();
+	// цикл по четверкам паролей
+	for (i = 0; i < n; i += 4)
+	{
+		u32* s[4];
+		u32* h[4];
+		const u32* X[4];
+		size_t j, k;
+		// последний пароль без пары?
+		if (i + 1 == n)
+		{
+			code = beltPBKDF2(keys + 32 * i, pwds[i], pwd_lens[i], iter,
+				salts[i], salt_lens[i]);
+			break;
+		}
+		// первая итерация: t <- HMAC(pwd, salt || 00000001)
+		for (j = 0; j < 4; ++j)
+		{
+			belt_pbkdf_lane_st* lane = lanes + j;
+			size_t pos = i + j < n ? i + j : i;
+			octet* key = keys + 32 * pos;
+			beltHMACStart(hmac, pwds[pos], pwd_lens[pos]);
+			beltHMACKeyPrepare(&lane->hk, hmac);
+			beltHMACStepA(salts[pos], salt_lens[pos], hmac);
+			*(u32*)key = 0, key[3] = 1;
+			beltHMACStepA(key, 4, hmac);
+			beltHMACStepG(key, hmac);
+			u32From(lane->t, key, 32);
+			memCopy(lane->key, lane->t, 32);
+		}
+		// остальные итерации
+		for (k = iter; --k; )
+		{
+			// внутреннее хэширование
+			for (j = 0; j < 4; ++j)
+			{
+				belt_pbkdf_lane_st* lane = lanes + j;
+				memCopy(lane->ls, lane->hk.ls_in, 32);
+				beltBlockAddBitSizeU32(lane->ls, 32);
+				memCopy(lane->h, lane->hk.h_in, 32);
+				s[j] = lane->ls + 4, h[j] = lane->h, X[j] = lane->t;
+			}
+			beltCompr2X4(s, h, X, stack);
+			for (j = 0; j < 4; ++j)
+				s[j] = lanes[j].s1, X[j] = lanes[j].ls;
+			beltCompr2X4(s, h, X, stack);
+			// внешнее хэширование
+			for (j = 0; j < 4; ++j)
+			{
+				belt_pbkdf_lane_st* lane = lanes + j;
+				memCopy(lane->ls, lane->hk.ls_out, 32);
+				memCopy(lane->h1, lane->hk.h_out, 32);
+				s[j] = lane->ls + 4, h[j] = lane->h1, X[j] = lane->h;
+			}
+			beltCompr2X4(s, h, X, stack);
+			for (j = 0; j < 4; ++j)
+				s[j] = lanes[j].s1, X[j] = lanes[j].ls;
+			beltCompr2X4(s, h, X, stack);
+			// t <- h1, key <- key ^ t
+			for (j = 0; j < 4; ++j)
+			{
+				memCopy(lanes[j].t, lanes[j].h1, 32);
+				memXor2(lanes[j].key, lanes[j].t, 32);
+			}
+		}
+		// сохранить ключи
+		for (j = 0; j < 4 && i + j < n; ++j)
+			u32To(keys + 32 * (i + j), 32, lanes[j].key);
+	}
+	// завершить
+	blobClose(state);
+	return code;
+}
+
+/*
+*******************************************************************************
+Асинхронное построение ключей
+
+Запросы пакета группируются по числу итераций, ключи каждой группы
+строятся одним вызовом beltPBKDF2MB().
+*******************************************************************************
+*/
+
+static void beltPBKDF2AsyncBatch(mt_req_t* const reqs[], size_t count,
+	void* scratch)
+{
+	void* state;
+	const octet** pwds;
+	size_t* pwd_lens;
+	const octet** salts;
+	size_t* salt_lens;
+	size_t* idx;
+	octet* keys;
+	octet* taken;
+	size_t i, j, m;
+	// создать состояние
+	state = blobCreate(count * (2 * sizeof(const octet*) + 3 * O_PER_S +
+		32 + 1));
+	if (state == 0)
+	{
+		for (i = 0; i < count; ++i)
+			reqs[i]->code = ERR_OUTOFMEMORY;
+		return;
+	}
+	pwds = (const octet**)state;
+	salts = pwds + count;
+	pwd_lens = (size_t*)(salts + count);
+	salt_lens = pwd_lens + count;
+	idx = salt_lens + count;
+	keys = (octet*)(idx + count);
+	taken = keys + 32 * count;
+	// проверить запросы
+	for (i = 0; i < count; ++i)
+	{
+		const belt_pbkdf2_req_t* r = (const belt_pbkdf2_req_t*)reqs[i];
+		taken[i] = !memIsValid(r->key, 32);
+		if (taken[i])
+			reqs[i]->code = ERR_BAD_INPUT;
+	}
+	// обработать группы с одинаковым числом итераций
+	for (i = 0; i < count; ++i)
+	{
+		size_t iter;
+		err_t code;
+		if (taken[i])
+			continue;
+		iter = ((const belt_pbkdf2_req_t*)reqs[i])->iter;
+		for (j = i, m = 0; j < count; ++j)
+		{
+			const belt_pbkdf2_req_t* r = (const belt_pbkdf2_req_t*)reqs[j];
+			if (taken[j] || r->iter != iter)
+				continue;
+			pwds[m] = r->pwd, pwd_lens[m] = r->pwd_len;
+			salts[m] = r->salt, salt_lens[m] = r->salt_len;
+			idx[m++] = j, taken[j] = TRUE;
+		}
+		code = beltPBKDF2MB(keys, pwds, pwd_lens, iter, salts, salt_lens, m);
+		for (j = 0; j < m; ++j)
+		{
+			reqs[idx[j]]->code = code;
+			if (code == ERR_OK)
+				memCopy(((belt_pbkdf2_req_t*)reqs[idx[j]])->key,
+					keys + 32 * j, 32);
+		}
+	}
+	// завершить
+	blobClose(state);
+}
+
+void beltPBKDF2Async(mt_async_t* as, belt_pbkdf2_req_t* req)
+{
+	ASSERT(memIsValid(req, sizeof(belt_pbkdf2_req_t)));
+	req->req.batch = beltPBKDF2AsyncBatch;
+	req->req.key = 0;
+	mtAsyncSubmit(as, &req->req);
+}
@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): SDE (Sectorwise Disk Encryption)
 \project bee2 [cryptographic library]
 \created 2018.09.01
-\version 2020.03.24
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -27,6 +27,8 @@ typedef struct
 {
 	belt_wbl_st wbl[1];	/*< состояние механизма WBL */
 	octet s[16];		/*< переменная s */
+	u32 ss[16];			/*< переменные s четверки секторов */
+	u32 ctr[4];			/*< номер сектора */
 } belt_sde_st;
 
 size_t beltSDE_keep()
@@ -120,3 +122,93 @@ err_t beltSDEDecr(void* dest, const void* src, size_t count,
 	blobClose(state);
 	return ERR_OK;
 }
+
+/*
+*******************************************************************************
+Шифрование секторов в режиме SDE
+
+Синхропосылка сектора интерпретируется как номер сектора, записанный 
+по правилам little-endian. Номер сектора хранится в st->ctr.
+
+Четверки секторов обрабатываются одновременно: синхропосылки 
+зашифровываются одним вызовом beltBlockEncrN(), широкие блоки 
+обрабатываются функциями beltWBLStepE4() / beltWBLStepD4().
+*******************************************************************************
+*/
+
+static err_t beltSDESectors(void* dest, const void* src, size_t count,
+	size_t sector_len, const octet key[], size_t len, const octet iv[16],
+	bool_t encr)
+{
+	void* state;
+	belt_sde_st* st;
+	// проверить входные данные
+	if (sector_len % 16 != 0 || sector_len < 32 ||
+		count % sector_len != 0 || count < sector_len ||
+		len != 16 && len != 24 && len != 32 ||
+		!memIsValid(src, count) ||
+		!memIsValid(key, len) ||
+		!memIsValid(iv, 16) ||
+		!memIsValid(dest, count))
+		return ERR_BAD_INPUT;
+	// создать состояние
+	state = blobCreate(beltSDE_keep());
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	st = (belt_sde_st*)state;
+	// обработать секторы
+	beltSDEStart(state, key, len);
+	u32From(st->ctr, iv, 16);
+	memMove(dest, src, count);
+	// цикл по четверкам секторов
+	if (sector_len >= (encr ? 64u : 80u))
+		for (; count >= 4 * sector_len; count -= 4 * sector_len)
+		{
+			size_t i;
+			// зашифровать синхропосылки
+			for (i = 0; i < 16; i += 4)
+			{
+				beltBlockCopy(st->ss + i, st->ctr);
+				beltBlockIncU32(st->ctr);
+			}
+			beltBlockEncrN(st->ss, 4, st->wbl->key);
+			// каскад XEX
+			for (i = 0; i < 4; ++i)
+			{
+				u32To(st->s, 16, st->ss + 4 * i);
+				beltBlockXor2((octet*)dest + i * sector_len, st->s);
+			}
+			(encr ? beltWBLStepE4 : beltWBLStepD4)(dest, sector_len, st->wbl);
+			for (i = 0; i < 4; ++i)
+			{
+				u32To(st->s, 16, st->ss + 4 * i);
+				beltBlockXor2((octet*)dest + i * sector_len, st->s);
+			}
+			dest = (octet*)dest + 4 * sector_len;
+		}
+	// цикл по оставшимся секторам
+	for (; count; count -= sector_len)
+	{
+		octet* block = (octet*)st->ss;
+		u32To(block, 16, st->ctr);
+		encr ? beltSDEStepE(dest, sector_len, block, state) :
+			beltSDEStepD(dest, sector_len, block, state);
+		beltBlockIncU32(st->ctr);
+		dest = (octet*)dest + sector_len;
+	}
+	// завершить
+	blobClose(state);
+	return ERR_OK;
+}
+
+err_t beltSDEEncrSectors(void* dest, const void* src, size_t count,
+	size_t sector_len, const octet key[], size_t len, const octet iv[16])
+{
+	return beltSDESectors(dest, src, count, sector_len, key, len, iv, TRUE);
+}
+
+err_t beltSDEDecrSectors(void* dest, const void* src, size_t count,
+	size_t sector_len, const octet key[], size_t len, const octet iv[16])
+{
+	return beltSDESectors(dest, src, count, sector_len, key, len, iv, FALSE);
+}
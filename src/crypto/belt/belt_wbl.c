@@ -4,7 +4,7 @@
 \brief STB 34.101.31 (belt): wide block encryption
 \project bee2 [cryptographic library]
 \created 2017.11.03
-\version 2020.03.24
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,7 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/u32.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
 #include "belt_lcl.h"
@@ -198,6 +199,128 @@ void beltWBLStepDOpt(void* buf, size_t count, void* state)
 	}
 }
 
+/*
+*******************************************************************************
+Шифрование четверки широких блоков
+
+Обрабатываются 4 широких блока одинаковой длины count, размещенные в buf
+последовательно. Такты оптимизированных алгоритмов для всех блоков 
+выполняются одновременно, шифрование блоков на каждом такте выполняется 
+одним вызовом beltBlockEncrN(). Длина count должна быть кратна 16.
+Кроме этого, при зашифровании count >= 32 (алгоритм beltWBLStepEOpt() 
+корректен уже при n = 2), а при расшифровании count >= 80, как 
+в beltWBLStepDOpt().
+*******************************************************************************
+*/
+
+void beltWBLStepE4(void* buf, size_t count, void* state)
+{
+	belt_wbl_st* st = (belt_wbl_st*)state;
+	word n = ((word)count + 15) / 16;
+	octet sums[64];
+	octet blocks[64];
+	u32 t[16];
+	size_t i, j;
+	ASSERT(count >= 32 && count % 16 == 0);
+	ASSERT(memIsDisjoint2(buf, 4 * count, state, beltWBL_keep()));
+	// sum_j <- r1 + ... + r_{n-1}
+	for (j = 0; j < 4; ++j)
+	{
+		octet* r = (octet*)buf + j * count;
+		beltBlockCopy(sums + 16 * j, r);
+		for (i = 16; i + 16 < count; i += 16)
+			beltBlockXor2(sums + 16 * j, r + i);
+	}
+	// 2 * n итераций
+	for (st->round = 0, i = 0; st->round < 2 * n; i = (i + 16) % count)
+	{
+		// block_j <- beltBlockEncr(sum_j) + <round>
+		u32From(t, sums, 64);
+		beltBlockEncrN(t, 4, st->key);
+		u32To(blocks, 64, t);
+		st->round++;
+#if (OCTET_ORDER == BIG_ENDIAN)
+		st->round = wordRev(st->round);
+#endif
+		for (j = 0; j < 4; ++j)
+		{
+			octet* r = (octet*)buf + j * count;
+			octet* sum = sums + 16 * j;
+			memXor2(blocks + 16 * j, &st->round, O_PER_W);
+			// r*_j <- r*_j + block_j
+			beltBlockXor2(r + (i + count - 16) % count, blocks + 16 * j);
+			// запомнить sum_j и пересчитать его
+			beltBlockCopy(blocks + 16 * j, sum);
+			beltBlockXor2(sum, r + (i + count - 16) % count);
+			beltBlockXor2(sum, r + i);
+			// сохранить sum_j
+			beltBlockCopy(r + i, blocks + 16 * j);
+		}
+#if (OCTET_ORDER == BIG_ENDIAN)
+		st->round = wordRev(st->round);
+#endif
+	}
+	// очистка
+	memWipe(sums, sizeof(sums));
+	memWipe(blocks, sizeof(blocks));
+	memWipe(t, sizeof(t));
+}
+
+void beltWBLStepD4(void* buf, size_t count, void* state)
+{
+	belt_wbl_st* st = (belt_wbl_st*)state;
+	word n = ((word)count + 15) / 16;
+	octet sums[64];
+	octet blocks[64];
+	u32 t[16];
+	size_t i, j;
+	ASSERT(count >= 80 && count % 16 == 0);
+	ASSERT(memIsDisjoint2(buf, 4 * count, state, beltWBL_keep()));
+	// sum_j <- r1 + ... + r_{n-2}
+	for (j = 0; j < 4; ++j)
+	{
+		octet* r = (octet*)buf + j * count;
+		beltBlockCopy(sums + 16 * j, r);
+		for (i = 16; i + 32 < count; i += 16)
+			beltBlockXor2(sums + 16 * j, r + i);
+	}
+	// 2 * n итераций
+	for (st->round = 2 * n, i = count - 16; st->round; --st->round)
+	{
+		// block_j <- beltBlockEncr(r*_j) + <round>
+		for (j = 0; j < 4; ++j)
+			beltBlockCopy(blocks + 16 * j, (octet*)buf + j * count + i);
+		u32From(t, blocks, 64);
+		beltBlockEncrN(t, 4, st->key);
+		u32To(blocks, 64, t);
+#if (OCTET_ORDER == BIG_ENDIAN)
+		st->round = wordRev(st->round);
+#endif
+		for (j = 0; j < 4; ++j)
+		{
+			octet* r = (octet*)buf + j * count;
+			octet* sum = sums + 16 * j;
+			memXor2(blocks + 16 * j, &st->round, O_PER_W);
+			// r*_j <- r*_j + block_j
+			beltBlockXor2(r + (i + count - 16) % count, blocks + 16 * j);
+			// r1_j <- pre r*_j + sum_j
+			beltBlockXor2(r + i, sum);
+			// пересчитать sum_j
+			beltBlockXor2(sum, r + (i + count - 32) % count);
+			beltBlockXor2(sum, r + i);
+		}
+#if (OCTET_ORDER == BIG_ENDIAN)
+		st->round = wordRev(st->round);
+#endif
+		// назад
+		i = (i + count - 16) % count;
+	}
+	// очистка
+	memWipe(sums, sizeof(sums));
+	memWipe(blocks, sizeof(blocks));
+	memWipe(t, sizeof(t));
+}
+
 void beltWBLStepE(void* buf, size_t count, void* state)
 {
 	belt_wbl_st* st = (belt_wbl_st*)state;
@@ -0,0 +1,220 @@
+/*
+*******************************************************************************
+\file bign_cache.c
+\brief STB 34.101.45 (bign): cache of public keys for verification
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "bee2/core/blob.h"
+#include "bee2/core/err.h"
+#include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
+#include "bee2/core/util.h"
+#include "bee2/crypto/bign.h"
+#include "bee2/math/ww.h"
+#include "bign_lcl.h"
+
+/*
+*******************************************************************************
+Кэш открытых ключей
+
+Кэш состоит из count ячеек. В ячейке хранятся уровень стойкости l
+(l == 0 для пустой ячейки), открытый ключ [2 * no]pubkey и аффинные малые
+кратные [2 * n * BIGN_VCACHE_COUNT]pa соответствующей точки Q
+(см. ecNAFPrecompA()). Кратные хранятся в том представлении координат,
+которое используется в описании кривой, построенном в bignStart().
+Кэшируются только ключи стандартных кривых, поэтому уровень l однозначно
+определяет кривую.
+
+Ячейки распределены по BIGN_VCACHE_STRIPES полосам. Полоса ключа
+определяется по его признаку (tag) -- свертке октетов ключа. Каждая полоса
+защищена собственным мьютексом, так что потоки, которые обращаются к ключам
+разных полос, не блокируют друг друга. При поиске сначала сравниваются
+признаки, и только при их совпадении -- ключи.
+
+Внутри полосы ячейки вытесняются по правилу LRU: при каждом обращении
+ячейке назначается очередное значение счетчика полосы (stamp), при
+добавлении ключа в заполненную полосу вытесняется ячейка с наименьшим
+значением.
+
+Малые кратные рассчитываются вне критической секции, при поиске кратные
+копируются из ячейки внутри критической секции.
+
+Указатель на кэш читается и записывается атомарно (mtAtomicLoadPtr(),
+mtAtomicCmpSwapPtr()).
+*******************************************************************************
+*/
+
+#define BIGN_VCACHE_STRIPES 16
+
+typedef struct
+{
+	size_t l;				/*< уровень стойкости (0 -- пустая ячейка) */
+	size_t stamp;			/*< момент последнего обращения */
+	word tag;				/*< признак ключа */
+	octet pubkey[128];		/*< открытый ключ */
+	word pa[2 * W_OF_B(512) * BIGN_VCACHE_COUNT];	/*< малые кратные */
+} bign_vcache_entry;
+
+typedef struct
+{
+	mt_mtx_t mtx;				/*< мьютекс */
+	size_t count;				/*< число ячеек */
+	size_t tick;				/*< счетчик обращений */
+	bign_vcache_entry* entries;	/*< ячейки */
+} bign_vcache_stripe;
+
+typedef struct
+{
+	bign_vcache_stripe stripes[BIGN_VCACHE_STRIPES];	/*< полосы */
+	bign_vcache_entry entries[];						/*< ячейки */
+} bign_vcache_st;
+
+static void* _vcache;
+
+static word bignVerifyCacheTag(const octet pubkey[], size_t len)
+{
+	register word tag = 0;
+	for (; len--; ++pubkey)
+		tag = tag * 31 + *pubkey;
+	return tag;
+}
+
+err_t bignVerifyCacheCreate(size_t count)
+{
+	bign_vcache_st* cache;
+	bign_vcache_entry* entries;
+	size_t i, c;
+	// проверить входные данные
+	if (count == 0)
+		return ERR_BAD_INPUT;
+	count = MAX2(count, BIGN_VCACHE_STRIPES);
+	if (mtAtomicLoadPtr(&_vcache))
+		return ERR_ALREADY_EXISTS;
+	// создать кэш
+	cache = (bign_vcache_st*)blobCreate(
+		sizeof(bign_vcache_st) + count * sizeof(bign_vcache_entry));
+	if (cache == 0)
+		return ERR_OUTOFMEMORY;
+	// распределить ячейки по полосам
+	for (i = 0, entries = cache->entries; i < BIGN_VCACHE_STRIPES; ++i)
+	{
+		c = count / BIGN_VCACHE_STRIPES +
+			(i < count % BIGN_VCACHE_STRIPES);
+		if (!mtMtxCreate(&cache->stripes[i].mtx))
+		{
+			while (i--)
+				mtMtxClose(&cache->stripes[i].mtx);
+			blobClose(cache);
+			return ERR_OUTOFMEMORY;
+		}
+		cache->stripes[i].count = c;
+		cache->stripes[i].entries = entries;
+		entries += c;
+	}
+	// установить кэш
+	if (mtAtomicCmpSwapPtr(&_vcache, 0, cache) != 0)
+	{
+		for (i = 0; i < BIGN_VCACHE_STRIPES; ++i)
+			mtMtxClose(&cache->stripes[i].mtx);
+		blobClose(cache);
+		return ERR_ALREADY_EXISTS;
+	}
+	return ERR_OK;
+}
+
+void bignVerifyCacheClose()
+{
+	bign_vcache_st* cache;
+	size_t i;
+	cache = (bign_vcache_st*)mtAtomicLoadPtr(&_vcache);
+	if (cache == 0 || mtAtomicCmpSwapPtr(&_vcache, cache, 0) != cache)
+		return;
+	for (i = 0; i < BIGN_VCACHE_STRIPES; ++i)
+		mtMtxClose(&cache->stripes[i].mtx);
+	blobClose(cache);
+}
+
+bool_t bignVerifyCacheIsOn()
+{
+	return mtAtomicLoadPtr(&_vcache) != 0;
+}
+
+bool_t bignVerifyCacheGet(word pa[], size_t l, const octet pubkey[])
+{
+	const size_t no = O_OF_B(2 * l);
+	bign_vcache_st* cache;
+	bign_vcache_stripe* stripe;
+	bign_vcache_entry* e;
+	word tag;
+	size_t i;
+	bool_t found = FALSE;
+	// кэш создан?
+	cache = (bign_vcache_st*)mtAtomicLoadPtr(&_vcache);
+	if (cache == 0)
+		return FALSE;
+	ASSERT(l == 128 || l == 192 || l == 256);
+	ASSERT(memIsValid(pubkey, 2 * no));
+	// найти ключ
+	tag = bignVerifyCacheTag(pubkey, 2 * no);
+	stripe = cache->stripes + tag % BIGN_VCACHE_STRIPES;
+	mtMtxLock(&stripe->mtx);
+	for (i = 0, e = stripe->entries; i < stripe->count; ++i, ++e)
+		if (e->tag == tag && e->l == l && memEq(e->pubkey, pubkey, 2 * no))
+		{
+			wwCopy(pa, e->pa, 2 * W_OF_B(2 * l) * BIGN_VCACHE_COUNT);
+			e->stamp = ++stripe->tick;
+			found = TRUE;
+			break;
+		}
+	mtMtxUnlock(&stripe->mtx);
+	return found;
+}
+
+void bignVerifyCacheAdd(size_t l, const octet pubkey[], const word pa[])
+{
+	const size_t no = O_OF_B(2 * l);
+	bign_vcache_st* cache;
+	bign_vcache_stripe* stripe;
+	bign_vcache_entry* e;
+	bign_vcache_entry* victim;
+	word tag;
+	size_t i;
+	// кэш создан?
+	cache = (bign_vcache_st*)mtAtomicLoadPtr(&_vcache);
+	if (cache == 0)
+		return;
+	ASSERT(l == 128 || l == 192 || l == 256);
+	ASSERT(memIsValid(pubkey, 2 * no));
+	// выбрать ячейку
+	tag = bignVerifyCacheTag(pubkey, 2 * no);
+	stripe = cache->stripes + tag % BIGN_VCACHE_STRIPES;
+	mtMtxLock(&stripe->mtx);
+	victim = stripe->entries;
+	for (i = 0, e = stripe->entries; i < stripe->count; ++i, ++e)
+	{
+		// ключ уже добавлен в другом потоке?
+		if (e->tag == tag && e->l == l && memEq(e->pubkey, pubkey, 2 * no))
+		{
+			victim = 0;
+			break;
+		}
+		if (victim->l != 0 && (e->l == 0 || e->stamp < victim->stamp))
+			victim = e;
+	}
+	// заполнить ячейку
+	if (victim)
+	{
+		victim->l = l;
+		victim->tag = tag;
+		victim->stamp = ++stripe->tick;
+		memCopy(victim->pubkey, pubkey, 2 * no);
+		wwCopy(victim->pa, pa, 2 * W_OF_B(2 * l) * BIGN_VCACHE_COUNT);
+	}
+	mtMtxUnlock(&stripe->mtx);
+}
@@ -0,0 +1,137 @@
+/*
+*******************************************************************************
+\file bign_comb_gen.c
+\brief STB 34.101.45 (bign): generator of comb tables
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include <stdio.h>
+#include "bee2/core/blob.h"
+#include "bee2/core/err.h"
+#include "bee2/core/obj.h"
+#include "bee2/core/util.h"
+#include "bee2/crypto/bign.h"
+#include "bee2/math/ec.h"
+#include "bign_lcl.h"
+
+/*
+*******************************************************************************
+Генератор таблиц гребенчатого метода
+
+Программа рассчитывает таблицы кратных базовой точки стандартных кривых
+bign-curve128v1, bign-curve192v1, bign-curve256v1 (см. bignMulBase())
+и записывает их в заголовочный файл, имя которого передается в командной
+строке. Заголовок включается в bign_lcl.c при сборке с директивой
+BIGN_PRECOMP (опция CMake BIGN_PRECOMP).
+
+Таблицы записываются в том представлении координат, которое используется
+в описаниях кривых, построенных в bignStart(). Представление зависит от
+длины машинного слова, поэтому генератор собирается и запускается с той же
+конфигурацией, что и библиотека. Длина слова фиксируется в заголовке
+и проверяется при компиляции.
+*******************************************************************************
+*/
+
+static const char* const _names[3] = {
+	"1.2.112.0.2.0.34.101.45.3.1",
+	"1.2.112.0.2.0.34.101.45.3.2",
+	"1.2.112.0.2.0.34.101.45.3.3",
+};
+
+static size_t bignCombGen_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return O_OF_W(2 * n * BIGN_COMB_COUNT) +
+		ecCombPrecompA_deep(n, ec_d, ec_deep);
+}
+
+static void bignCombGenWord(FILE* fp, word w)
+{
+	int pos;
+	fprintf(fp, "0x");
+	for (pos = B_PER_W - 4; pos >= 0; pos -= 4)
+		fprintf(fp, "%X", (unsigned)(w >> pos & 15));
+}
+
+static err_t bignCombGen(FILE* fp, size_t i)
+{
+	err_t code;
+	bign_params params[1];
+	void* state;
+	ec_o* ec;
+	word* pre;
+	size_t count, pos;
+	ASSERT(i < 3);
+	// построить кривую
+	code = bignParamsStd(params, _names[i]);
+	ERR_CALL_CHECK(code);
+	state = blobCreate(bignStart_keep(params->l, bignCombGen_deep));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	code = bignStart(state, params);
+	ERR_CALL_HANDLE(code, blobClose(state));
+	ec = (ec_o*)state;
+	// рассчитать таблицу
+	pre = objEnd(ec, word);
+	count = 2 * ec->f->n * BIGN_COMB_COUNT;
+	if (!ecCombPrecompA(pre, ec->base, ec, BIGN_COMB_W, ec->f->n,
+		pre + count))
+	{
+		blobClose(state);
+		return ERR_BAD_PARAMS;
+	}
+	// записать таблицу
+	fprintf(fp, "\nstatic const word _comb%u[%u] = {",
+		(unsigned)params->l, (unsigned)count);
+	for (pos = 0; pos < count; ++pos)
+	{
+		fprintf(fp, pos % 4 ? " " : "\n\t");
+		bignCombGenWord(fp, pre[pos]);
+		fprintf(fp, ",");
+	}
+	fprintf(fp, "\n};\n");
+	blobClose(state);
+	return ERR_OK;
+}
+
+int main(int argc, char* argv[])
+{
+	err_t code = ERR_OK;
+	FILE* fp;
+	size_t i;
+	// открыть файл
+	if (argc != 2)
+	{
+		fprintf(stderr, "Usage: bign_comb_gen <header>\n");
+		return -1;
+	}
+	fp = fopen(argv[1], "w");
+	if (!fp)
+	{
+		fprintf(stderr, "bign_comb_gen: failed to open %s\n", argv[1]);
+		return -1;
+	}
+	// заголовок
+	fprintf(fp,
+		"/* Generated by bign_comb_gen. Do not edit. */\n\n"
+		"#if (B_PER_W != %u || BIGN_COMB_W != %u)\n"
+		"\t#error \"Comb tables were generated for another configuration\"\n"
+		"#endif\n", (unsigned)B_PER_W, (unsigned)BIGN_COMB_W);
+	// таблицы
+	for (i = 0; code == ERR_OK && i < 3; ++i)
+		code = bignCombGen(fp, i);
+	if (fclose(fp) != 0 && code == ERR_OK)
+		code = ERR_FILE_WRITE;
+	if (code != ERR_OK)
+	{
+		fprintf(stderr, "bign_comb_gen: %s\n", errMsg(code));
+		remove(argv[1]);
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,266 @@
+/*
+*******************************************************************************
+\file bign_eph.c
+\brief STB 34.101.45 (bign): pool of ephemeral keys
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "bee2/core/err.h"
+#include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
+#include "bee2/core/stack.h"
+#include "bee2/core/util.h"
+#include "bee2/crypto/belt.h"
+#include "bee2/crypto/bign.h"
+#include "bee2/math/ecp.h"
+#include "bee2/math/ww.h"
+#include "bee2/math/zz.h"
+#include "bign_lcl.h"
+
+#ifdef OS_UNIX
+	#include <unistd.h>
+	#define bignEphPid() ((long)getpid())
+#else
+	#define bignEphPid() 0l
+#endif
+
+/*
+*******************************************************************************
+Пул одноразовых ключей
+
+Пул состоит из count ячеек. В ячейке хранится пара (k, k G): одноразовый
+личный ключ [n]k и аффинная точка [2 * n]V. Состояние ячейки:
+-	BIGN_EPH_EMPTY: ячейка пуста;
+-	BIGN_EPH_BUSY: в ячейке строится пара (вне критической секции);
+-	BIGN_EPH_READY: пара построена и может быть выдана.
+
+Ячейка выдается не более одного раза: пара копируется, ячейка очищается
+и переводится в состояние BIGN_EPH_EMPTY в одной критической секции.
+Кратные точки вычисляются вне критической секции.
+
+В пуле хранится идентификатор процесса, в котором строились пары. Если
+идентификатор не совпадает с текущим (пул унаследован дочерним процессом
+после fork()), то в bignEphForkCheck() все пары стираются, а ячейки
+переводятся в состояние BIGN_EPH_EMPTY. Тем самым родительский и дочерний
+процессы не выдают одинаковые одноразовые ключи. Проверка выполняется
+в критической секции при каждом обращении к ячейкам.
+*******************************************************************************
+*/
+
+#define BIGN_EPH_EMPTY	0
+#define BIGN_EPH_BUSY	1
+#define BIGN_EPH_READY	2
+
+typedef struct
+{
+	mt_mtx_t mtx;				/*< мьютекс */
+	const void* ctx;			/*< контекст bign */
+	gen_i rng;					/*< генератор случайных чисел */
+	void* rng_state;			/*< состояние генератора */
+	size_t count;				/*< число ячеек */
+	size_t ready;				/*< число готовых пар */
+	long pid;					/*< процесс, в котором строились пары */
+	octet* flags;				/*< [count] состояния ячеек */
+	word data[];				/*< [count * 3 * n] пары (k, V) */
+} bign_eph_st;
+
+#define bignEphN(st)\
+	(((const ec_o*)((const bign_ctx_st*)(st)->ctx)->ec)->f->n)
+
+#define bignEphK(st, i)\
+	((st)->data + (i) * 3 * bignEphN(st))
+
+#define bignEphV(st, i)\
+	(bignEphK(st, i) + bignEphN(st))
+
+static void bignEphForkCheck(bign_eph_st* st)
+{
+	const long pid = bignEphPid();
+	if (st->pid != pid)
+	{
+		memWipe(st->data, st->count * O_OF_W(3 * bignEphN(st)));
+		memSetZero(st->flags, st->count);
+		st->ready = 0, st->pid = pid;
+	}
+}
+
+static size_t bignEph_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return O_OF_W(3 * n) + bignMulBase_deep(n, ec_d, ec_deep);
+}
+
+size_t bignEph_keep(size_t l, size_t count)
+{
+	const size_t n = W_OF_B(2 * l);
+	ASSERT(l == 128 || l == 192 || l == 256);
+	return sizeof(bign_eph_st) + count * (O_OF_W(3 * n) + 1);
+}
+
+err_t bignEphStart(void* eph, const void* ctx, size_t count, gen_i rng,
+	void* rng_state)
+{
+	bign_eph_st* st = (bign_eph_st*)eph;
+	size_t n;
+	// проверить входные данные
+	if (!bignCtxIsOperable(ctx) || count == 0)
+		return ERR_BAD_INPUT;
+	if (!memIsValid(eph,
+		bignEph_keep(((const bign_ctx_st*)ctx)->params->l, count)))
+		return ERR_BAD_INPUT;
+	if (rng == 0)
+		return ERR_BAD_RNG;
+	// создать мьютекс
+	if (!mtMtxCreate(&st->mtx))
+		return ERR_OUTOFMEMORY;
+	// настроить пул
+	st->ctx = ctx;
+	st->rng = rng;
+	st->rng_state = rng_state;
+	st->count = count;
+	st->ready = 0;
+	st->pid = bignEphPid();
+	n = bignEphN(st);
+	st->flags = (octet*)(st->data + count * 3 * n);
+	memSetZero(st->flags, count);
+	return ERR_OK;
+}
+
+/*
+	Построение пары (k, k G).
+*/
+static err_t bignEphGen(word k[], word V[], const void* ctx, gen_i rng,
+	void* rng_state, void* stack)
+{
+	const bign_ctx_st* bign = (const bign_ctx_st*)ctx;
+	const ec_o* ec = (const ec_o*)bign->ec;
+	if (!zzRandNZMod(k, ec->order, ec->f->n, rng, rng_state))
+		return ERR_BAD_RNG;
+	if (!bignMulBase(V, bign->params, ec, k, ec->f->n, stack))
+		return ERR_BAD_PARAMS;
+	return ERR_OK;
+}
+
+size_t bignEphFill(void* eph, size_t max)
+{
+	bign_eph_st* st = (bign_eph_st*)eph;
+	size_t n, i, filled = 0;
+	word* k;
+	void* stack;
+	ASSERT(memIsValid(eph, sizeof(bign_eph_st)));
+	n = bignEphN(st);
+	// рабочая память
+	k = (word*)stackCreate(bignCtxStack_keep(st->ctx, bignEph_deep));
+	if (k == 0)
+		return 0;
+	stack = k + 3 * n;
+	// заполнять пустые ячейки
+	for (i = 0; i < st->count && filled < max; ++i)
+	{
+		// занять ячейку
+		mtMtxLock(&st->mtx);
+		bignEphForkCheck(st);
+		if (st->flags[i] != BIGN_EPH_EMPTY)
+		{
+			mtMtxUnlock(&st->mtx);
+			continue;
+		}
+		st->flags[i] = BIGN_EPH_BUSY;
+		mtMtxUnlock(&st->mtx);
+		// построить пару
+		if (bignEphGen(k, k + n, st->ctx, st->rng, st->rng_state,
+			stack) != ERR_OK)
+		{
+			mtMtxLock(&st->mtx);
+			st->flags[i] = BIGN_EPH_EMPTY;
+			mtMtxUnlock(&st->mtx);
+			break;
+		}
+		// разместить пару в ячейке
+		mtMtxLock(&st->mtx);
+		wwCopy(bignEphK(st, i), k, 3 * n);
+		st->flags[i] = BIGN_EPH_READY;
+		++st->ready;
+		mtMtxUnlock(&st->mtx);
+		++filled;
+	}
+	// завершение
+	memWipe(k, O_OF_W(3 * n));
+	stackClose(k);
+	return filled;
+}
+
+void bignEphFillTask(void* eph, void* scratch)
+{
+	bignEphFill(eph, SIZE_MAX);
+}
+
+size_t bignEphReady(void* eph)
+{
+	bign_eph_st* st = (bign_eph_st*)eph;
+	size_t ready;
+	ASSERT(memIsValid(eph, sizeof(bign_eph_st)));
+	mtMtxLock(&st->mtx);
+	bignEphForkCheck(st);
+	ready = st->ready;
+	mtMtxUnlock(&st->mtx);
+	return ready;
+}
+
+void bignEphClose(void* eph)
+{
+	bign_eph_st* st = (bign_eph_st*)eph;
+	ASSERT(memIsValid(eph, sizeof(bign_eph_st)));
+	mtMtxClose(&st->mtx);
+	memWipe(st->data, st->count * O_OF_W(3 * bignEphN(st)));
+	memSetZero(st->flags, st->count);
+	st->ready = 0;
+}
+
+bool_t bignEphIsOperable(const void* eph)
+{
+	const bign_eph_st* st = (const bign_eph_st*)eph;
+	return memIsValid(eph, sizeof(bign_eph_st)) &&
+		bignCtxIsOperable(st->ctx);
+}
+
+const void* bignEphCtx(const void* eph)
+{
+	ASSERT(bignEphIsOperable(eph));
+	return ((const bign_eph_st*)eph)->ctx;
+}
+
+err_t bignEphPop(word k[], word V[], void* eph, void* stack)
+{
+	bign_eph_st* st = (bign_eph_st*)eph;
+	size_t n, i;
+	ASSERT(bignEphIsOperable(eph));
+	n = bignEphN(st);
+	// найти и освободить готовую ячейку
+	mtMtxLock(&st->mtx);
+	bignEphForkCheck(st);
+	for (i = 0; st->ready && i < st->count; ++i)
+		if (st->flags[i] == BIGN_EPH_READY)
+		{
+			wwCopy(k, bignEphK(st, i), n);
+			wwCopy(V, bignEphV(st, i), 2 * n);
+			memWipe(bignEphK(st, i), O_OF_W(3 * n));
+			st->flags[i] = BIGN_EPH_EMPTY;
+			--st->ready;
+			mtMtxUnlock(&st->mtx);
+			return ERR_OK;
+		}
+	mtMtxUnlock(&st->mtx);
+	// пул пуст: построить пару на месте
+	return bignEphGen(k, V, st->ctx, st->rng, st->rng_state, stack);
+}
+
+size_t bignEphPop_deep(size_t n, size_t f_deep, size_t ec_d, size_t ec_deep)
+{
+	return bignMulBase_deep(n, ec_d, ec_deep);
+}
@@ -4,16 +4,16 @@
 \brief STB 34.101.45 (bign): identity-based signature
 \project bee2 [cryptographic library]
 \created 2012.04.27
-\version 2023.09.20
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
-#include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
 #include "bee2/core/oid.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
 #include "bee2/crypto/bign.h"
@@ -34,7 +34,7 @@ static size_t bignIdExtract_deep(size_t n, size_t f_deep, size_t ec_d,
 	return O_OF_W(4 * n) +
 		utilMax(2,
 			beltHash_keep(),
-			ecAddMulA_deep(n, ec_d, ec_deep, 2, n, n / 2 + 1));
+			bignAddMulBase_deep(n, ec_d, ec_deep, n / 2 + 1));
 }
 
 err_t bignIdExtract(octet id_privkey[], octet id_pubkey[], 
@@ -61,12 +61,12 @@ err_t bignIdExtract(octet id_privkey[], octet id_pubkey[],
 	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
 		return ERR_BAD_OID;
 	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignIdExtract_deep));
+	state = stackCreate(bignStart_keep(params->l, bignIdExtract_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	no  = ec->f->no;
@@ -79,7 +79,7 @@ err_t bignIdExtract(octet id_privkey[], octet id_pubkey[],
 		!memIsValid(id_privkey, no) ||
 		!memIsValid(id_pubkey, 2 * no))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -91,14 +91,14 @@ err_t bignIdExtract(octet id_privkey[], octet id_pubkey[],
 	if (!qrFrom(ecX(Q), pubkey, ec->f, stack) ||
 		!qrFrom(ecY(Q, n), pubkey + no, ec->f, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PUBKEY;
 	}
 	// загрузить и проверить s1
 	wwFrom(s1, sig + no / 2, no);
 	if (wwCmp(s1, ec->order, n) >= 0)
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_SIG;
 	}
 	// s1 <- (s1 + H) mod q
@@ -114,9 +114,9 @@ err_t bignIdExtract(octet id_privkey[], octet id_pubkey[],
 	wwFrom(s0, sig, no);
 	s0[n / 2] = 1;
 	// R <- s1 G + (s0 + 2^l) Q
-	if (!ecAddMulA(R, ec, stack, 2, ec->base, s1, n, Q, s0, n / 2 + 1))
+	if (!bignAddMulBase(R, params, ec, s1, n, Q, s0, n / 2 + 1, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_SIG;
 	}
 	qrTo((octet*)R, ecX(R), ec->f, stack);
@@ -134,7 +134,7 @@ err_t bignIdExtract(octet id_privkey[], octet id_pubkey[],
 	else
 		code = ERR_BAD_SIG;
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
@@ -144,15 +144,72 @@ err_t bignIdExtract(octet id_privkey[], octet id_pubkey[],
 *******************************************************************************
 */
 
-static size_t bignIdSign_deep(size_t n, size_t f_deep, size_t ec_d,
+static size_t bignIdSignCore_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(4 * n) +
-		utilMax(4,
-			beltHash_keep(),
-			ecMulA_deep(n, ec_d, ec_deep, n),
+		utilMax(3,
+			bignMulBase_deep(n, ec_d, ec_deep),
 			zzMul_deep(n / 2, n),
-			zzMod_deep(n + n / 2 + 1, n));
+			bignModQ_deep(n));
+}
+
+/*
+	Выработка идентификационной ЭЦП на личном ключе [n]e. Состояние
+	hash_state содержит результат хэширования oid и изменяется.
+*/
+static err_t bignIdSignCore(octet id_sig[], const bign_params* params,
+	const ec_o* ec, void* hash_state, const octet id_hash[],
+	const octet hash[], const word e[], gen_i rng, void* rng_state,
+	void* stack)
+{
+	const size_t no = ec->f->no;
+	const size_t n = ec->f->n;
+	// состояние (буферы могут пересекаться)
+	word* k;				/* [n] одноразовый личный ключ */
+	word* V;				/* [2n] точка V */
+	word* s0;				/* [n/2] первая часть подписи */
+	word* s1;				/* [n] вторая часть подписи */
+	ASSERT(n % 2 == 0);
+	// раскладка состояния
+	s1 = (word*)stack;
+	k = s1 + n;
+	V = k + n;
+	s0 = V + n + n / 2;
+	stack = V + 2 * n;
+	// сгенерировать k с помощью rng
+	if (!zzRandNZMod(k, ec->order, n, rng, rng_state))
+		return ERR_BAD_RNG;
+	// V <- k G
+	if (!bignMulBase(V, params, ec, k, n, stack))
+		return ERR_BAD_PARAMS;
+	qrTo((octet*)V, ecX(V), ec->f, stack);
+	// s0 <- belt-hash(oid || V || H0 || H) mod 2^l
+	beltHashStepH(V, no, hash_state);
+	beltHashStepH(id_hash, no, hash_state);
+	beltHashStepH(hash, no, hash_state);
+	beltHashStepG2(id_sig, no / 2, hash_state);
+	wwFrom(s0, id_sig, no / 2);
+	// V <- (s0 + 2^l) e
+	zzMul(V, s0, n / 2, e, n, stack);
+	V[n + n / 2] = zzAdd(V + n / 2, V + n / 2, e, n);
+	// s1 <- V mod q
+	bignModQ(s1, V, n + n / 2 + 1, ec, stack);
+	// s1 <- (k - s1 - H) mod q
+	zzSubMod(s1, k, s1, ec->order, n);
+	wwFrom(k, hash, no);
+	zzSubMod(s1, s1, k, ec->order, n);
+	// выгрузить s1
+	wwTo(id_sig + no / 2, no, s1);
+	// все нормально
+	return ERR_OK;
+}
+
+static size_t bignIdSign_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return O_OF_W(n) + beltHash_keep() +
+		bignIdSignCore_deep(n, f_deep, ec_d, ec_deep);
 }
 
 err_t bignIdSign(octet id_sig[], const bign_params* params, 
@@ -161,14 +218,11 @@ err_t bignIdSign(octet id_sig[], const bign_params* params,
 {
 	err_t code;
 	size_t no, n;
-	// состояние (буферы могут пересекаться)
+	// состояние
 	void* state;
 	ec_o* ec;				/* описание эллиптической кривой */
 	word* e;				/* [n] личный ключ */
-	word* k;				/* [n] одноразовый личный ключ */
-	word* V;				/* [2n] точка V */
-	word* s0;				/* [n/2] первая часть подписи */
-	word* s1;				/* [n] вторая часть подписи */
+	octet* hash_state;		/* [beltHash_keep] состояние хэширования */
 	octet* stack;
 	// проверить params
 	if (!memIsValid(params, sizeof(bign_params)))
@@ -182,12 +236,12 @@ err_t bignIdSign(octet id_sig[], const bign_params* params,
 	if (rng == 0)
 		return ERR_BAD_RNG;
 	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignIdSign_deep));
+	state = stackCreate(bignStart_keep(params->l, bignIdSign_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	no  = ec->f->no;
@@ -199,57 +253,29 @@ err_t bignIdSign(octet id_sig[], const bign_params* params,
 		!memIsValid(id_privkey, no) ||
 		!memIsValid(id_sig, no + no / 2))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
-	e = s1 = objEnd(ec, word);
-	k = e + n;
-	V = k + n;
-	s0 = V + n + n / 2;
-	stack = (octet*)(V + 2 * n);
+	e = objEnd(ec, word);
+	hash_state = (octet*)(e + n);
+	stack = hash_state + beltHash_keep();
 	// загрузить e
 	wwFrom(e, id_privkey, no);
 	if (wwCmp(e, ec->order, n) >= 0)
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PRIVKEY;
 	}
-	// сгенерировать k с помощью rng
-	if (!zzRandNZMod(k, ec->order, n, rng, rng_state))
-	{
-		blobClose(state);
-		return ERR_BAD_RNG;
-	}
-	// V <- k G
-	if (!ecMulA(V, ec->base, ec, k, n, stack))
-	{
-		blobClose(state);
-		return ERR_BAD_PARAMS;
-	}
-	qrTo((octet*)V, ecX(V), ec->f, stack);
-	// s0 <- belt-hash(oid || V || H0 || H) mod 2^l
-	beltHashStart(stack);
-	beltHashStepH(oid_der, oid_len, stack);
-	beltHashStepH(V, no, stack);
-	beltHashStepH(id_hash, no, stack);
-	beltHashStepH(hash, no, stack);
-	beltHashStepG2(id_sig, no / 2, stack);
-	wwFrom(s0, id_sig, no / 2);
-	// V <- (s0 + 2^l) e
-	zzMul(V, s0, n / 2, e, n, stack);
-	V[n + n / 2] = zzAdd(V + n / 2, V + n / 2, e, n);
-	// s1 <- V mod q
-	zzMod(s1, V, n + n / 2 + 1, ec->order, n, stack);
-	// s1 <- (k - s1 - H) mod q
-	zzSubMod(s1, k, s1, ec->order, n);
-	wwFrom(k, hash, no);
-	zzSubMod(s1, s1, k, ec->order, n);
-	// выгрузить s1
-	wwTo(id_sig + no / 2, no, s1);
-	// все нормально
-	blobClose(state);
-	return ERR_OK;
+	// хэшировать oid
+	beltHashStart(hash_state);
+	beltHashStepH(oid_der, oid_len, hash_state);
+	// выработать подпись
+	code = bignIdSignCore(id_sig, params, ec, hash_state, id_hash, hash, e,
+		rng, rng_state, stack);
+	// завершение
+	stackClose(state);
+	return code;
 }
 
 static size_t bignIdSign2_deep(size_t n, size_t f_deep, size_t ec_d,
@@ -260,9 +286,9 @@ static size_t bignIdSign2_deep(size_t n, size_t f_deep, size_t ec_d,
 			beltHash_keep(),
 			32,
 			beltWBL_keep(),
-			ecMulA_deep(n, ec_d, ec_deep, n),
+			bignMulBase_deep(n, ec_d, ec_deep),
 			zzMul_deep(n / 2, n),
-			zzMod_deep(n + n / 2 + 1, n));
+			bignModQ_deep(n));
 }
 
 err_t bignIdSign2(octet id_sig[], const bign_params* params, 
@@ -293,12 +319,12 @@ err_t bignIdSign2(octet id_sig[], const bign_params* params,
 	if (!memIsNullOrValid(t, t_len))
 		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignIdSign2_deep));
+	state = stackCreate(bignStart_keep(params->l, bignIdSign2_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	no  = ec->f->no;
@@ -310,7 +336,7 @@ err_t bignIdSign2(octet id_sig[], const bign_params* params,
 		!memIsValid(id_privkey, no) ||
 		!memIsValid(id_sig, no + no / 2))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -324,7 +350,7 @@ err_t bignIdSign2(octet id_sig[], const bign_params* params,
 	wwFrom(e, id_privkey, no);
 	if (wwCmp(e, ec->order, n) >= 0)
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PRIVKEY;
 	}
 	// хэшировать oid
@@ -353,9 +379,9 @@ err_t bignIdSign2(octet id_sig[], const bign_params* params,
 		}
 	}
 	// V <- k G
-	if (!ecMulA(V, ec->base, ec, k, n, stack))
+	if (!bignMulBase(V, params, ec, k, n, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	qrTo((octet*)V, ecX(V), ec->f, stack);
@@ -369,7 +395,7 @@ err_t bignIdSign2(octet id_sig[], const bign_params* params,
 	zzMul(V, s0, n / 2, e, n, stack);
 	V[n + n / 2] = zzAdd(V + n / 2, V + n / 2, e, n);
 	// s1 <- V mod q
-	zzMod(s1, V, n + n / 2 + 1, ec->order, n, stack);
+	bignModQ(s1, V, n + n / 2 + 1, ec, stack);
 	// s1 <- (k - s1 - H) mod q
 	zzSubMod(s1, k, s1, ec->order, n);
 	wwFrom(k, hash, no);
@@ -377,7 +403,7 @@ err_t bignIdSign2(octet id_sig[], const bign_params* params,
 	// выгрузить s1
 	wwTo(id_sig + no / 2, no, s1);
 	// все нормально
-	blobClose(state);
+	stackClose(state);
 	return ERR_OK;
 }
 
@@ -387,97 +413,68 @@ err_t bignIdSign2(octet id_sig[], const bign_params* params,
 *******************************************************************************
 */
 
-static size_t bignIdVerify_deep(size_t n, size_t f_deep, size_t ec_d,
+static size_t bignIdVerifyCore_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(7 * n + 2) + beltHash_keep() +
-		utilMax(5,
+		utilMax(9,
 			beltHash_keep(),
 			ecpIsOnA_deep(n, f_deep),
 			zzMul_deep(n / 2, n / 2),
-			zzMod_deep(n + 1, n),
-			ecAddMulA_deep(n, ec_d, ec_deep, 3, n, n / 2 + 1, n));
+			bignModQ_deep(n),
+			ecAddMulA_deep(n, ec_d, ec_deep, 3, n, n / 2 + 1, n),
+			bignAddMulBase_deep(n, ec_d, ec_deep, n / 2 + 1),
+			ecCombMulA_deep(n, ec_d, ec_deep),
+			ecpAddAA_deep(n, f_deep),
+			O_OF_W(2 * n));
 }
 
-err_t bignIdVerify(const bign_params* params, const octet oid_der[], 
-	size_t oid_len, const octet id_hash[], const octet hash[], 
-	const octet id_sig[], const octet id_pubkey[], const octet pubkey[])
+/*
+	Проверка идентификационной ЭЦП на открытом ключе [2n]Q доверенной
+	стороны. Состояние hash_state содержит результат хэширования oid
+	и не изменяется.
+
+	Если задана таблица [2n * BIGN_COMB_COUNT]preQ гребенчатого метода
+	для Q, то сумма кратных s1 G + (s0 + 2^l) R вычисляется в bignAddMulBase()
+	и к ней прибавляется кратная t Q, вычисленная по таблице preQ. Иначе
+	сумма трех кратных вычисляется в ecAddMulA().
+*/
+static err_t bignIdVerifyCore(const bign_params* params, const ec_o* ec,
+	const void* hash_state, const octet id_hash[], const octet hash[],
+	const octet id_sig[], const octet id_pubkey[], const word Q[],
+	const word preQ[], void* stack)
 {
-	err_t code;
-	size_t no, n;
+	const size_t no = ec->f->no;
+	const size_t n = ec->f->n;
 	// состояние (буферы R и V совпадают)
-	void* state;
-	ec_o* ec;			/* описание эллиптической кривой */	
 	word* R;			/* [2n] открытый ключ R */
-	word* Q;			/* [2n] открытый ключ Q */
 	word* V;			/* [2n] точка V (V == R) */
+	word* W;			/* [2n] кратная t Q */
 	word* s0;			/* [n / 2 + 1] первая часть подписи */
 	word* s1;			/* [n] вторая часть подписи */
 	word* t;			/* [n / 2] переменная t */
 	word* t1;			/* [n + 1] произведение (s0 + 2^l)(t + 2^l) */
-	octet* hash_state;	/* [beltHash_keep] состояние хэширования */
-	octet* stack;
-	// проверить params
-	if (!memIsValid(params, sizeof(bign_params)))
-		return ERR_BAD_INPUT;
-	if (!bignIsOperable(params))
-		return ERR_BAD_PARAMS;
-	// проверить oid_der
-	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
-		return ERR_BAD_OID;
-	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignIdVerify_deep));
-	if (state == 0)
-		return ERR_OUTOFMEMORY;
-	// старт
-	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
-	ec = (ec_o*)state;
-	// размерности
-	no  = ec->f->no;
-	n = ec->f->n;
+	octet* hs;			/* [beltHash_keep] состояние хэширования */
+	bool_t ok;
 	ASSERT(n % 2 == 0);
-	// проверить входные указатели
-	if (!memIsValid(id_hash, no) ||
-		!memIsValid(hash, no) ||
-		!memIsValid(id_sig, no + no / 2) ||
-		!memIsValid(id_pubkey, 2 * no) ||
-		!memIsValid(pubkey, 2 * no))
-	{
-		blobClose(state);
-		return ERR_BAD_INPUT;
-	}
 	// раскладка состояния
-	R = V = objEnd(ec, word);
-	Q = R + 2 * n;
-	s0 = Q + 2 * n;
+	R = V = (word*)stack;
+	W = R + 2 * n;
+	s0 = W + 2 * n;
 	s1 = s0 + n / 2 + 1;
 	t = s1 + n;
 	t1 = t + n / 2;
-	hash_state = (octet*)(t1 + n + 1);
-	stack = hash_state + beltHash_keep();
+	hs = (octet*)(t1 + n + 1);
+	stack = hs + beltHash_keep();
 	// загрузить R
 	if (!qrFrom(ecX(R), id_pubkey, ec->f, stack) ||
 		!qrFrom(ecY(R, n), id_pubkey + no, ec->f, stack) ||
 		!ecpIsOnA(R, ec, stack))
-	{
-		blobClose(state);
 		return ERR_BAD_PUBKEY;
-	}
-	// загрузить Q
-	if (!qrFrom(ecX(Q), pubkey, ec->f, stack) ||
-		!qrFrom(ecY(Q, n), pubkey + no, ec->f, stack))
-	{
-		blobClose(state);
-		return ERR_BAD_PUBKEY;
-	}
 	// загрузить и проверить s1
 	wwFrom(s1, id_sig + no / 2, no);
 	if (wwCmp(s1, ec->order, n) >= 0)
-	{
-		blobClose(state);
 		return ERR_BAD_SIG;
-	}
 	// s1 <- (s1 + H) mod q
 	wwFrom(t, hash, no);
 	if (wwCmp(t, ec->order, n) >= 0)
@@ -491,8 +488,7 @@ err_t bignIdVerify(const bign_params* params, const octet oid_der[],
 	wwFrom(s0, id_sig, no / 2);
 	s0[n / 2] = 1;
 	// belt-hash(oid...)
-	beltHashStart(hash_state);
-	beltHashStepH(oid_der, oid_len, hash_state);
+	memCopy(hs, hash_state, beltHash_keep());
 	// t <- belt-hash(oid || R || H0) mod 2^l
 	memCopy(stack, hash_state, beltHash_keep());
 	beltHashStepH(id_pubkey, no, stack);
@@ -504,22 +500,335 @@ err_t bignIdVerify(const bign_params* params, const octet oid_der[],
 	t1[n] = zzAdd2(t1 + n / 2, t, n / 2);
 	t1[n] += zzAdd2(t1 + n / 2, s0, n / 2);
 	++t1[n];
-	zzMod(t1, t1, n + 1, ec->order, n, stack);
+	bignModQ(t1, t1, n + 1, ec, stack);
 	zzNegMod(t1, t1, ec->order, n);
 	// V <- s1 G + (s0 + 2^l) R + t Q
-	if (!ecAddMulA(V, ec, stack,
-		3, ec->base, s1, n, R, s0, n / 2 + 1, Q, t1, n))
+	if (preQ)
 	{
-		blobClose(state);
-		return ERR_BAD_SIG;
+		// W <- t Q, V <- s1 G + (s0 + 2^l) R
+		bool_t okW = ecCombMulA(W, preQ, ec, BIGN_COMB_W, t1, n, stack);
+		ok = bignAddMulBase(V, params, ec, s1, n, R, s0, n / 2 + 1, stack);
+		// V <- V + W
+		if (okW && ok)
+			ok = ecpAddAA(V, V, W, ec, stack);
+		else if (okW)
+			wwCopy(V, W, 2 * n), ok = TRUE;
 	}
+	else
+		ok = ecAddMulA(V, ec, stack,
+			3, ec->base, s1, n, R, s0, n / 2 + 1, Q, t1, n);
+	if (!ok)
+		return ERR_BAD_SIG;
 	qrTo((octet*)V, ecX(V), ec->f, stack);
 	// s0 == belt-hash(oid || V || H0 || H) mod 2^l?
-	beltHashStepH(V, no, hash_state);
-	beltHashStepH(id_hash, no, hash_state);
-	beltHashStepH(hash, no, hash_state);
-	code = beltHashStepV2(id_sig, no / 2, hash_state) ? ERR_OK : ERR_BAD_SIG;
+	beltHashStepH(V, no, hs);
+	beltHashStepH(id_hash, no, hs);
+	beltHashStepH(hash, no, hs);
+	return beltHashStepV2(id_sig, no / 2, hs) ? ERR_OK : ERR_BAD_SIG;
+}
+
+static size_t bignIdVerify_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return O_OF_W(2 * n) + beltHash_keep() +
+		utilMax(2,
+			bignIdVerifyCore_deep(n, f_deep, ec_d, ec_deep),
+			beltHash_keep());
+}
+
+err_t bignIdVerify(const bign_params* params, const octet oid_der[], 
+	size_t oid_len, const octet id_hash[], const octet hash[], 
+	const octet id_sig[], const octet id_pubkey[], const octet pubkey[])
+{
+	err_t code;
+	size_t no, n;
+	// состояние
+	void* state;
+	ec_o* ec;			/* описание эллиптической кривой */	
+	word* Q;			/* [2n] открытый ключ Q */
+	octet* hash_state;	/* [beltHash_keep] состояние хэширования */
+	octet* stack;
+	// проверить params
+	if (!memIsValid(params, sizeof(bign_params)))
+		return ERR_BAD_INPUT;
+	if (!bignIsOperable(params))
+		return ERR_BAD_PARAMS;
+	// проверить oid_der
+	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
+		return ERR_BAD_OID;
+	// создать состояние
+	state = stackCreate(bignStart_keep(params->l, bignIdVerify_deep));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// старт
+	code = bignStart(state, params);
+	ERR_CALL_HANDLE(code, stackClose(state));
+	ec = (ec_o*)state;
+	// размерности
+	no  = ec->f->no;
+	n = ec->f->n;
+	ASSERT(n % 2 == 0);
+	// проверить входные указатели
+	if (!memIsValid(id_hash, no) ||
+		!memIsValid(hash, no) ||
+		!memIsValid(id_sig, no + no / 2) ||
+		!memIsValid(id_pubkey, 2 * no) ||
+		!memIsValid(pubkey, 2 * no))
+	{
+		stackClose(state);
+		return ERR_BAD_INPUT;
+	}
+	// раскладка состояния
+	Q = objEnd(ec, word);
+	hash_state = (octet*)(Q + 2 * n);
+	stack = hash_state + beltHash_keep();
+	// загрузить Q
+	if (!qrFrom(ecX(Q), pubkey, ec->f, stack) ||
+		!qrFrom(ecY(Q, n), pubkey + no, ec->f, stack))
+	{
+		stackClose(state);
+		return ERR_BAD_PUBKEY;
+	}
+	// belt-hash(oid...)
+	beltHashStart(hash_state);
+	beltHashStepH(oid_der, oid_len, hash_state);
+	// проверить подпись
+	code = bignIdVerifyCore(params, ec, hash_state, id_hash, hash, id_sig,
+		id_pubkey, Q, 0, stack);
+	// завершение
+	stackClose(state);
+	return code;
+}
+
+/*
+*******************************************************************************
+Подготовленные состояния
+
+В состоянии подписанта сохраняются личный ключ e, хэш-значение
+идентификатора и состояние belt-hash после обработки oid.
+
+В состоянии проверяющего сохраняются открытый ключ Q доверенной стороны,
+таблица гребенчатого метода для Q и состояние belt-hash после обработки
+oid. Данные размещаются в data: [2n]Q || [2n * BIGN_COMB_COUNT]preQ ||
+[beltHash_keep()]hash_state.
+
+Состояния после создания не изменяются.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	const void* ctx;			/*< контекст bign */
+	word e[W_OF_B(512)];		/*< личный ключ */
+	octet id_hash[64];			/*< хэш-значение идентификатора */
+	octet hash_state[];			/*< [beltHash_keep()] состояние хэширования */
+} bign_id_priv_st;
+
+typedef struct
+{
+	const void* ctx;			/*< контекст bign */
+	word data[];				/*< Q || preQ || hash_state */
+} bign_id_pub_st;
+
+#define bignIdPubN(st)\
+	(((const ec_o*)((const bign_ctx_st*)(st)->ctx)->ec)->f->n)
+
+#define bignIdPubQ(st) ((st)->data)
+
+#define bignIdPubPre(st) ((st)->data + 2 * bignIdPubN(st))
+
+#define bignIdPubHash(st)\
+	(bignIdPubPre(st) + 2 * bignIdPubN(st) * BIGN_COMB_COUNT)
+
+size_t bignIdPriv_keep()
+{
+	return sizeof(bign_id_priv_st) + beltHash_keep();
+}
+
+err_t bignIdPrivStart(void* priv, const void* ctx, const octet oid_der[],
+	size_t oid_len, const octet id_hash[], const octet id_privkey[])
+{
+	bign_id_priv_st* st = (bign_id_priv_st*)priv;
+	const ec_o* ec;
+	// проверить ctx и priv
+	if (!bignCtxIsOperable(ctx) || !memIsValid(priv, bignIdPriv_keep()))
+		return ERR_BAD_INPUT;
+	ec = (const ec_o*)((const bign_ctx_st*)ctx)->ec;
+	// проверить oid_der
+	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
+		return ERR_BAD_OID;
+	// проверить входные указатели
+	if (!memIsValid(id_hash, ec->f->no) ||
+		!memIsValid(id_privkey, ec->f->no))
+		return ERR_BAD_INPUT;
+	// загрузить e
+	wwFrom(st->e, id_privkey, ec->f->no);
+	if (wwCmp(st->e, ec->order, ec->f->n) >= 0)
+		return ERR_BAD_PRIVKEY;
+	// сохранить H0 и хэшировать oid
+	memCopy(st->id_hash, id_hash, ec->f->no);
+	beltHashStart(st->hash_state);
+	beltHashStepH(oid_der, oid_len, st->hash_state);
+	st->ctx = ctx;
+	return ERR_OK;
+}
+
+static size_t bignIdSignPriv_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return beltHash_keep() + bignIdSignCore_deep(n, f_deep, ec_d, ec_deep);
+}
+
+err_t bignIdSignPriv(octet id_sig[], const void* priv, const octet hash[],
+	gen_i rng, void* rng_state)
+{
+	const bign_id_priv_st* st = (const bign_id_priv_st*)priv;
+	const bign_ctx_st* bign;
+	const ec_o* ec;
+	err_t code;
+	octet* hash_state;
+	// проверить priv
+	if (!memIsValid(priv, bignIdPriv_keep()) || !bignCtxIsOperable(st->ctx))
+		return ERR_BAD_INPUT;
+	bign = (const bign_ctx_st*)st->ctx;
+	ec = (const ec_o*)bign->ec;
+	// проверить rng
+	if (rng == 0)
+		return ERR_BAD_RNG;
+	// проверить входные указатели
+	if (!memIsValid(hash, ec->f->no) ||
+		!memIsValid(id_sig, ec->f->no + ec->f->no / 2))
+		return ERR_BAD_INPUT;
+	// создать стек
+	hash_state = (octet*)stackCreate(bignCtxStack_keep(bign,
+		bignIdSignPriv_deep));
+	if (hash_state == 0)
+		return ERR_OUTOFMEMORY;
+	memCopy(hash_state, st->hash_state, beltHash_keep());
+	// выработать подпись
+	code = bignIdSignCore(id_sig, bign->params, ec, hash_state, st->id_hash,
+		hash, st->e, rng, rng_state, hash_state + beltHash_keep());
+	// завершение
+	stackClose(hash_state);
+	return code;
+}
+
+size_t bignIdPub_keep(size_t l)
+{
+	const size_t n = W_OF_B(2 * l);
+	ASSERT(l == 128 || l == 192 || l == 256);
+	return sizeof(bign_id_pub_st) + O_OF_W(2 * n * (1 + BIGN_COMB_COUNT)) +
+		beltHash_keep();
+}
+
+static size_t bignIdPubStart_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return utilMax(2,
+		ecpIsOnA_deep(n, f_deep),
+		ecCombPrecompA_deep(n, ec_d, ec_deep));
+}
+
+err_t bignIdPubStart(void* pub, const void* ctx, const octet oid_der[],
+	size_t oid_len, const octet pubkey[])
+{
+	bign_id_pub_st* st = (bign_id_pub_st*)pub;
+	const bign_ctx_st* bign = (const bign_ctx_st*)ctx;
+	const ec_o* ec;
+	size_t no, n;
+	word* Q;
+	void* stack;
+	// проверить ctx и pub
+	if (!bignCtxIsOperable(ctx) ||
+		!memIsValid(pub, bignIdPub_keep(bign->params->l)))
+		return ERR_BAD_INPUT;
+	ec = (const ec_o*)bign->ec;
+	no = ec->f->no, n = ec->f->n;
+	// проверить oid_der
+	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
+		return ERR_BAD_OID;
+	// проверить pubkey
+	if (!memIsValid(pubkey, 2 * no))
+		return ERR_BAD_INPUT;
+	// создать стек
+	stack = stackCreate(bignCtxStack_keep(ctx, bignIdPubStart_deep));
+	if (stack == 0)
+		return ERR_OUTOFMEMORY;
+	// загрузить и проверить Q
+	st->ctx = ctx;
+	Q = bignIdPubQ(st);
+	if (!qrFrom(ecX(Q), pubkey, ec->f, stack) ||
+		!qrFrom(ecY(Q, n), pubkey + no, ec->f, stack) ||
+		!ecpIsOnA(Q, ec, stack) ||
+		!ecCombPrecompA(bignIdPubPre(st), Q, ec, BIGN_COMB_W, n, stack))
+	{
+		stackClose(stack);
+		st->ctx = 0;
+		return ERR_BAD_PUBKEY;
+	}
+	stackClose(stack);
+	// хэшировать oid
+	beltHashStart(bignIdPubHash(st));
+	beltHashStepH(oid_der, oid_len, bignIdPubHash(st));
+	return ERR_OK;
+}
+
+static bool_t bignIdPubIsOperable(const void* pub)
+{
+	const bign_id_pub_st* st = (const bign_id_pub_st*)pub;
+	return memIsValid(pub, sizeof(bign_id_pub_st)) &&
+		bignCtxIsOperable(st->ctx) &&
+		memIsValid(pub,
+			bignIdPub_keep(((const bign_ctx_st*)st->ctx)->params->l));
+}
+
+err_t bignIdVerifyPub(const void* pub, const octet id_hash[],
+	const octet hash[], const octet id_sig[], const octet id_pubkey[])
+{
+	return bignIdVerifyBatch(0, pub, 1, id_hash, hash, id_sig, id_pubkey);
+}
+
+err_t bignIdVerifyBatch(size_t* bad, const void* pub, size_t count,
+	const octet id_hashes[], const octet hashes[], const octet id_sigs[],
+	const octet id_pubkeys[])
+{
+	const bign_id_pub_st* st = (const bign_id_pub_st*)pub;
+	const bign_ctx_st* bign;
+	const ec_o* ec;
+	err_t code = ERR_OK;
+	size_t no, i;
+	void* stack;
+	// проверить pub
+	if (!bignIdPubIsOperable(pub))
+		return ERR_BAD_INPUT;
+	bign = (const bign_ctx_st*)st->ctx;
+	ec = (const ec_o*)bign->ec;
+	no = ec->f->no;
+	// проверить входные указатели
+	if (!memIsNullOrValid(bad, sizeof(size_t)) ||
+		count > SIZE_MAX / (2 * no) ||
+		!memIsValid(id_hashes, count * no) ||
+		!memIsValid(hashes, count * no) ||
+		!memIsValid(id_sigs, count * (no + no / 2)) ||
+		!memIsValid(id_pubkeys, count * 2 * no))
+		return ERR_BAD_INPUT;
+	// создать стек
+	stack = stackCreate(bignCtxStack_keep(bign, bignIdVerifyCore_deep));
+	if (stack == 0)
+		return ERR_OUTOFMEMORY;
+	// проверить подписи
+	for (i = 0; i < count; ++i)
+	{
+		code = bignIdVerifyCore(bign->params, ec, bignIdPubHash(st),
+			id_hashes + i * no, hashes + i * no, id_sigs + i * (no + no / 2),
+			id_pubkeys + i * 2 * no, bignIdPubQ(st), bignIdPubPre(st),
+			stack);
+		if (code != ERR_OK)
+			break;
+	}
+	if (bad)
+		*bad = i;
 	// завершение
-	blobClose(state);
+	stackClose(stack);
 	return code;
 }
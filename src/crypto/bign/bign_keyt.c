@@ -4,7 +4,7 @@
 \brief STB 34.101.45 (bign): key transport
 \project bee2 [cryptographic library]
 \created 2012.04.27
-\version 2023.09.20
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,9 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
+#include "bee2/core/stack.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
 #include "bee2/crypto/bign.h"
@@ -28,28 +31,90 @@
 *******************************************************************************
 */
 
-static size_t bignKeyWrap_deep(size_t n, size_t f_deep, size_t ec_d,
+size_t bignKeyWrap_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(3 * n) + 32 +
 		utilMax(2,
-			ecMulA_deep(n, ec_d, ec_deep, n),
+			bignMulBase_deep(n, ec_d, ec_deep),
 			beltKWP_keep());
 }
 
+/*
+	Создание токена на одноразовом личном ключе k.
+*/
+static err_t bignKeyWrapCore(octet token[], const bign_params* params,
+	const ec_o* ec, const octet key[], size_t len, const octet header[16],
+	const octet pubkey[], const word k[], void* stack)
+{
+	const size_t no = ec->f->no;
+	const size_t n = ec->f->n;
+	// состояние
+	word* R;				/* [2n] точка R */
+	octet* theta;			/* [32] ключ защиты */
+	// раскладка состояния
+	R = (word*)stack;
+	theta = (octet*)(R + 2 * n);
+	stack = theta + 32;
+	// R <- k Q
+	if (!qrFrom(ecX(R), pubkey, ec->f, stack) ||
+		!qrFrom(ecY(R, n), pubkey + no, ec->f, stack))
+		return ERR_BAD_PUBKEY;
+	if (!ecMulACT(R, R, ec, k, n, stack))
+		return ERR_BAD_PARAMS;
+	// theta <- <R>_{256}
+	qrTo(theta, ecX(R), ec->f, stack);
+	// R <- k G
+	if (!bignMulBase(R, params, ec, k, n, stack))
+		return ERR_BAD_PARAMS;
+	qrTo((octet*)R, ecX(R), ec->f, stack);
+	// сформировать блок для шифрования
+	// (буферы key, header и token могут пересекаться)
+	if (header)
+		memCopy(R + n, header, 16);
+	else
+		memSetZero(R + n, 16);
+	memMove(token + no, key, len);
+	memCopy(token + no + len, R + n, 16);
+	// зашифровать
+	beltKWPStart(stack, theta, 32);
+	beltKWPStepE(token + no, len + 16, stack);
+	// доопределить токен
+	memCopy(token, R, no);
+	// все нормально
+	return ERR_OK;
+}
+
+static err_t bignKeyWrapStep(octet token[], const bign_params* params,
+	const ec_o* ec, const octet key[], size_t len, const octet header[16],
+	const octet pubkey[], gen_i rng, void* rng_state, void* stack)
+{
+	const size_t no = ec->f->no;
+	const size_t n = ec->f->n;
+	// состояние
+	word* k;				/* [n] одноразовый личный ключ */
+	// проверить входные указатели
+	if (!memIsValid(pubkey, 2 * no) ||
+		!memIsValid(token, 16 + no + len))
+		return ERR_BAD_INPUT;
+	// раскладка состояния
+	k = (word*)stack;
+	stack = k + n;
+	// сгенерировать k
+	if (!zzRandNZMod(k, ec->order, n, rng, rng_state))
+		return ERR_BAD_RNG;
+	// создать токен
+	return bignKeyWrapCore(token, params, ec, key, len, header, pubkey, k,
+		stack);
+}
+
 err_t bignKeyWrap(octet token[], const bign_params* params, const octet key[],
 	size_t len, const octet header[16], const octet pubkey[],
 	gen_i rng, void* rng_state)
 {
 	err_t code;
-	size_t no, n;
-	// состояние
 	void* state;
 	ec_o* ec;				/* описание эллиптической кривой */
-	word* k;				/* [n] одноразовый личный ключ */
-	word* R;				/* [2n] точка R */
-	octet* theta;			/* [32] ключ защиты */
-	octet* stack;
 	// проверить params
 	if (!memIsValid(params, sizeof(bign_params)))
 		return ERR_BAD_INPUT;
@@ -64,71 +129,191 @@ err_t bignKeyWrap(octet token[], const bign_params* params, const octet key[],
 		!memIsNullOrValid(header, 16))
 		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignKeyWrap_deep));
+	state = stackCreate(bignStart_keep(params->l, bignKeyWrap_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
+	tmTraceBegin("bignKeyWrap");
 	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, (tmTraceEnd("bignKeyWrap"), stackClose(state)));
 	ec = (ec_o*)state;
-	// размерности
-	no  = ec->f->no;
-	n = ec->f->n;
-	// проверить входные указатели
-	if (!memIsValid(pubkey, 2 * no) ||
-		!memIsValid(token, 16 + no + len))
-	{
-		blobClose(state);
+	// создать токен
+	code = bignKeyWrapStep(token, params, ec, key, len, header, pubkey,
+		rng, rng_state, objEnd(ec, void));
+	tmTraceEnd("bignKeyWrap");
+	// завершение
+	stackClose(state);
+	return code;
+}
+
+err_t bignKeyWrapWs(octet token[], const void* ctx, void* ws,
+	const octet key[], size_t len, const octet header[16],
+	const octet pubkey[], gen_i rng, void* rng_state)
+{
+	const bign_ctx_st* st = (const bign_ctx_st*)ctx;
+	// проверить ctx и ws
+	if (!bignCtxIsOperable(ctx) || !memIsValid(ws, bignWs_keep(ctx)))
 		return ERR_BAD_INPUT;
-	}
-	// раскладка состояния
-	k = objEnd(ec, word);
-	R = k + n;
-	theta = (octet*)(R + 2 * n);
-	stack = theta + 32;
-	// сгенерировать k
-	if (!zzRandNZMod(k, ec->order, n, rng, rng_state))
-	{
-		blobClose(state);
+	// проверить rng
+	if (rng == 0)
 		return ERR_BAD_RNG;
-	}
-	// R <- k Q
-	if (!qrFrom(ecX(R), pubkey, ec->f, stack) ||
-		!qrFrom(ecY(R, n), pubkey + no, ec->f, stack))
-	{
-		blobClose(state);
-		return ERR_BAD_PUBKEY;
-	}
-	if (!ecMulA(R, R, ec, k, n, stack))
+	// проверить header и key
+	if (len < 16 ||
+		!memIsValid(key, len) ||
+		!memIsNullOrValid(header, 16))
+		return ERR_BAD_INPUT;
+	// создать токен
+	return tmTraceCall("bignKeyWrapWs", bignKeyWrapStep(token, st->params,
+		(const ec_o*)st->ec, key, len, header, pubkey, rng, rng_state, ws));
+}
+
+err_t bignKeyWrapCtx(octet token[], const void* ctx, const octet key[],
+	size_t len, const octet header[16], const octet pubkey[],
+	gen_i rng, void* rng_state)
+{
+	err_t code;
+	void* ws;
+	// проверить ctx
+	if (!bignCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// создать рабочую память
+	ws = stackCreate(bignWs_keep(ctx));
+	if (ws == 0)
+		return ERR_OUTOFMEMORY;
+	// создать токен
+	code = bignKeyWrapWs(token, ctx, ws, key, len, header, pubkey, rng,
+		rng_state);
+	// завершение
+	stackClose(ws);
+	return code;
+}
+
+/*
+*******************************************************************************
+Пакетное создание токенов
+
+Одноразовые личные ключи k_i строятся в вызывающем потоке (генератор rng
+вызывается последовательно, в том же порядке, что и при count вызовах
+bignKeyWrapCtx()). Затем для каждого получателя ставится задача
+bignKeyWrapTask(): кратные k_i Q_i (переменная точка) и k_i G (по таблице
+базовой точки) вычисляются и ключ зашифровывается. Задачи выполняются
+в пуле потоков pool или, если pool == 0, последовательно.
+
+Ключи k_i и память задач размещаются в одном блобе, который очищается
+при закрытии.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	const bign_ctx_st* ctx;		/*< контекст */
+	const octet* key;			/*< транспортируемый ключ */
+	size_t len;					/*< длина ключа */
+	const octet* header;		/*< заголовок ключа */
+	const octet* pubkeys;		/*< открытые ключи получателей */
+	octet* tokens;				/*< токены */
+	const word* k;				/*< одноразовые личные ключи */
+} bign_wrap_batch_st;
+
+typedef struct
+{
+	const bign_wrap_batch_st* batch;	/*< общие данные */
+	size_t i;					/*< номер получателя */
+	void* stack;				/*< память задачи */
+	err_t code;					/*< код возврата */
+} bign_wrap_task_st;
+
+static void bignKeyWrapTask(void* arg, void* scratch)
+{
+	bign_wrap_task_st* task = (bign_wrap_task_st*)arg;
+	const bign_wrap_batch_st* b = task->batch;
+	const ec_o* ec = (const ec_o*)b->ctx->ec;
+	const size_t no = ec->f->no;
+	task->code = bignKeyWrapCore(b->tokens + task->i * (no + b->len + 16),
+		b->ctx->params, ec, b->key, b->len, b->header,
+		b->pubkeys + task->i * 2 * no, b->k + task->i * ec->f->n,
+		task->stack);
+}
+
+err_t bignKeyWrapBatch(octet tokens[], const void* ctx, const octet key[],
+	size_t len, const octet header[16], size_t count, const octet pubkeys[],
+	gen_i rng, void* rng_state, mt_pool_t* pool)
+{
+	const bign_ctx_st* st = (const bign_ctx_st*)ctx;
+	const ec_o* ec;
+	size_t no, n, i;
+	size_t task_keep;
+	err_t code;
+	void* state;
+	word* k;
+	bign_wrap_batch_st batch[1];
+	bign_wrap_task_st* tasks;
+	octet* stack;
+	// проверить ctx
+	if (!bignCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	ec = (const ec_o*)st->ec;
+	no = ec->f->no, n = ec->f->n;
+	// проверить rng
+	if (rng == 0)
+		return ERR_BAD_RNG;
+	// проверить входные данные
+	if (len < 16 ||
+		count > SIZE_MAX / (no + len + 16) ||
+		!memIsValid(key, len) ||
+		!memIsNullOrValid(header, 16) ||
+		!memIsValid(pubkeys, count * 2 * no) ||
+		!memIsValid(tokens, count * (no + len + 16)) ||
+		!memIsDisjoint2(key, len, tokens, count * (no + len + 16)) ||
+		(header && !memIsDisjoint2(header, 16, tokens,
+			count * (no + len + 16))))
+		return ERR_BAD_INPUT;
+	if (count == 0)
+		return ERR_OK;
+	// создать состояние
+	task_keep = bignCtxStack_keep(ctx, bignKeyWrap_deep);
+	state = blobCreate(O_OF_W(count * n) +
+		count * (sizeof(bign_wrap_task_st) + task_keep));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// раскладка состояния
+	k = (word*)state;
+	tasks = (bign_wrap_task_st*)(k + count * n);
+	stack = (octet*)(tasks + count);
+	// сгенерировать k_i
+	for (i = 0; i < count; ++i)
+		if (!zzRandNZMod(k + i * n, ec->order, n, rng, rng_state))
+		{
+			blobClose(state);
+			return ERR_BAD_RNG;
+		}
+	// задачи
+	batch->ctx = st, batch->key = key, batch->len = len;
+	batch->header = header, batch->pubkeys = pubkeys;
+	batch->tokens = tokens, batch->k = k;
+	for (i = 0; i < count; ++i)
 	{
-		blobClose(state);
-		return ERR_BAD_PARAMS;
+		tasks[i].batch = batch;
+		tasks[i].i = i;
+		tasks[i].stack = stack + i * task_keep;
+		tasks[i].code = ERR_OK;
 	}
-	// theta <- <R>_{256}
-	qrTo(theta, ecX(R), ec->f, stack);
-	// R <- k G
-	if (!ecMulA(R, ec->base, ec, k, n, stack))
+	// выполнить задачи
+	if (pool)
 	{
-		blobClose(state);
-		return ERR_BAD_PARAMS;
+		for (i = 0; i < count; ++i)
+			mtPoolSubmit(pool, bignKeyWrapTask, tasks + i);
+		mtPoolWait(pool);
 	}
-	qrTo((octet*)R, ecX(R), ec->f, stack);
-	// сформировать блок для шифрования
-	// (буферы key, header и token могут пересекаться)
-	if (header)
-		memCopy(R + n, header, 16);
 	else
-		memSetZero(R + n, 16);
-	memMove(token + no, key, len);
-	memCopy(token + no + len, R + n, 16);
-	// зашифровать
-	beltKWPStart(stack, theta, 32);
-	beltKWPStepE(token + no, len + 16, stack);
-	// доопределить токен
-	memCopy(token, R, no);
-	// все нормально
+		for (i = 0; i < count; ++i)
+			bignKeyWrapTask(tasks + i, 0);
+	// первая ошибка
+	for (code = ERR_OK, i = 0; code == ERR_OK && i < count; ++i)
+		code = tasks[i].code;
+	// завершение
 	blobClose(state);
-	return ERR_OK;
+	return code;
 }
 
 /*
@@ -137,66 +322,38 @@ err_t bignKeyWrap(octet token[], const bign_params* params, const octet key[],
 *******************************************************************************
 */
 
-static size_t bignKeyUnwrap_deep(size_t n, size_t f_deep, size_t ec_d,
+size_t bignKeyUnwrap_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return MAX2(O_OF_W(5 * n), 32 + 16) +
 		utilMax(3,
 			beltKWP_keep(),
 			qrPower_deep(n, n, f_deep),
-			ecMulA_deep(n, ec_d, ec_deep, n));
+			ecMulACT_deep(n, ec_d, ec_deep));
 }
 
-err_t bignKeyUnwrap(octet key[], const bign_params* params, const octet token[], 
-	size_t len, const octet header[16], const octet privkey[])
+static err_t bignKeyUnwrapStep(octet key[], const ec_o* ec,
+	const octet token[], size_t len, const octet header[16],
+	const octet privkey[], void* stack)
 {
-	err_t code;
-	size_t no, n;
+	const size_t no = ec->f->no;
+	const size_t n = ec->f->n;
 	// состояние (буферы могут пересекаться)
-	void* state;
-	ec_o* ec;				/* описание эллиптической кривой */
 	word* d;				/* [n] личный ключ */
 	word* R;				/* [2n] точка R */
 	word* t1;				/* [n] вспомогательное число */
 	word* t2;				/* [n] вспомогательное число */
 	octet* theta;			/* [32] ключ защиты */
 	octet* header2;			/* [16] заголовок2 */
-	void* stack;			/* граница стека */
-	// проверить params
-	if (!memIsValid(params, sizeof(bign_params)))
-		return ERR_BAD_INPUT;
-	if (!bignIsOperable(params))
-		return ERR_BAD_PARAMS;
-	// проверить token и header
-	if (!memIsValid(token, len) ||
-		!memIsNullOrValid(header, 16))
-		return ERR_BAD_INPUT;
-	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignKeyUnwrap_deep));
-	if (state == 0)
-		return ERR_OUTOFMEMORY;
-	// старт
-	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
-	ec = (ec_o*)state;
-	// размерности
-	no  = ec->f->no;
-	n = ec->f->n;
 	// проверить длину токена
 	if (len < 32 + no)
-	{
-		blobClose(state);
 		return ERR_BAD_KEYTOKEN;
-	}
 	// проверить входные указатели
 	if (!memIsValid(privkey, no) ||
 		!memIsValid(key, len - 16 - no))
-	{
-		blobClose(state);
 		return ERR_BAD_INPUT;
-	}
 	// раскладка состояния
-	d = objEnd(ec, word);
+	d = (word*)stack;
 	R = d + n;
 	t1 = R + 2 * n;
 	t2 = t1 + n;
@@ -209,16 +366,10 @@ err_t bignKeyUnwrap(octet key[], const bign_params* params, const octet token[],
 	// загрузить d
 	wwFrom(d, privkey, no);
 	if (wwIsZero(d, n) || wwCmp(d, ec->order, n) >= 0)
-	{
-		blobClose(state);
 		return ERR_BAD_PRIVKEY;
-	}
 	// xR <- x
 	if (!qrFrom(R, token, ec->f, stack))
-	{
-		blobClose(state);
 		return ERR_BAD_KEYTOKEN;
-	}
 	// t1 <- x^3 + a x + b
 	qrSqr(t1, R, ec->f, stack);
 	zmAdd(t1, t1, ec->A, ec->f);
@@ -233,16 +384,10 @@ err_t bignKeyUnwrap(octet key[], const bign_params* params, const octet token[],
 	qrSqr(t2, R + n, ec->f, stack);
 	// (xR, yR) на кривой? t1 == t2?
 	if (!wwEq(t1, t2, n))
-	{
-		blobClose(state);
 		return ERR_BAD_KEYTOKEN;
-	}
 	// R <- d R
-	if (!ecMulA(R, R, ec, d, n, stack))
-	{
-		blobClose(state);
+	if (!ecMulACT(R, R, ec, d, n, stack))
 		return ERR_BAD_PARAMS;
-	}
 	// theta <- <R>_{256}
 	qrTo(theta, ecX(R), ec->f, stack);
 	// сформировать данные для расшифрования
@@ -256,10 +401,78 @@ err_t bignKeyUnwrap(octet key[], const bign_params* params, const octet token[],
 		header == 0 && !memIsZero(header2, 16))
 	{
 		memSetZero(key, len - no - 16);
-		code = ERR_BAD_KEYTOKEN;
+		return ERR_BAD_KEYTOKEN;
 	}
+	// все нормально
+	return ERR_OK;
+}
+
+err_t bignKeyUnwrap(octet key[], const bign_params* params, const octet token[], 
+	size_t len, const octet header[16], const octet privkey[])
+{
+	err_t code;
+	void* state;
+	ec_o* ec;				/* описание эллиптической кривой */
+	// проверить params
+	if (!memIsValid(params, sizeof(bign_params)))
+		return ERR_BAD_INPUT;
+	if (!bignIsOperable(params))
+		return ERR_BAD_PARAMS;
+	// проверить token и header
+	if (!memIsValid(token, len) ||
+		!memIsNullOrValid(header, 16))
+		return ERR_BAD_INPUT;
+	// создать состояние
+	state = stackCreate(bignStart_keep(params->l, bignKeyUnwrap_deep));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// старт
+	tmTraceBegin("bignKeyUnwrap");
+	code = bignStart(state, params);
+	ERR_CALL_HANDLE(code, (tmTraceEnd("bignKeyUnwrap"), stackClose(state)));
+	ec = (ec_o*)state;
+	// разобрать токен
+	code = bignKeyUnwrapStep(key, ec, token, len, header, privkey,
+		objEnd(ec, void));
+	tmTraceEnd("bignKeyUnwrap");
 	// завершение
-	blobClose(state);
+	stackClose(state);
+	return code;
+}
+
+err_t bignKeyUnwrapWs(octet key[], const void* ctx, void* ws,
+	const octet token[], size_t len, const octet header[16],
+	const octet privkey[])
+{
+	// проверить ctx и ws
+	if (!bignCtxIsOperable(ctx) || !memIsValid(ws, bignWs_keep(ctx)))
+		return ERR_BAD_INPUT;
+	// проверить token и header
+	if (!memIsValid(token, len) ||
+		!memIsNullOrValid(header, 16))
+		return ERR_BAD_INPUT;
+	// разобрать токен
+	return tmTraceCall("bignKeyUnwrapWs", bignKeyUnwrapStep(key,
+		(const ec_o*)((const bign_ctx_st*)ctx)->ec, token, len, header,
+		privkey, ws));
+}
+
+err_t bignKeyUnwrapCtx(octet key[], const void* ctx, const octet token[], 
+	size_t len, const octet header[16], const octet privkey[])
+{
+	err_t code;
+	void* ws;
+	// проверить ctx
+	if (!bignCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// создать рабочую память
+	ws = stackCreate(bignWs_keep(ctx));
+	if (ws == 0)
+		return ERR_OUTOFMEMORY;
+	// разобрать токен
+	code = bignKeyUnwrapWs(key, ctx, ws, token, len, header, privkey);
+	// завершение
+	stackClose(ws);
 	return code;
 }
 
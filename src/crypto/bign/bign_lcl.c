@@ -4,18 +4,23 @@
 \brief STB 34.101.45 (bign): local definitions
 \project bee2 [cryptographic library]
 \created 2012.04.27
-\version 2023.09.19
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
+#include "bee2/core/obj.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/util.h"
 #include "bee2/math/gfp.h"
 #include "bee2/math/ecp.h"
 #include "bee2/math/ww.h"
+#include "bee2/math/zm.h"
 #include "bee2/math/zz.h"
 #include "bign_lcl.h"
 
@@ -73,7 +78,7 @@ err_t bignStart(void* state, const bign_params* params)
 	no = O_OF_B(2 * params->l);
 	n = W_OF_B(2 * params->l);
 	f_keep = gfpCreate_keep(no);
-	ec_keep = ecpCreateJ_keep(n);
+	ec_keep = ecpCreateJ_keep(n) + O_OF_W(n + 2);
 	// создать поле
 	f = (qr_o*)((octet*)state + ec_keep);
 	stack = (octet*)f + f_keep;
@@ -88,6 +93,10 @@ err_t bignStart(void* state, const bign_params* params)
 		return ERR_BAD_PARAMS;
 	ASSERT(wwBitSize(ec->order, n) == params->l * 2);
 	ASSERT(zzIsOdd(ec->order, n));
+	// разместить параметр Барретта для q в конце ec
+	ec->params = objEnd(ec, word);
+	zzRedBarrStart((word*)ec->params, ec->order, n, stack);
+	ec->hdr.keep += O_OF_W(n + 2);
 	// присоединить f к ec
 	objAppend(ec, f, 0);
 	// все нормально
@@ -102,13 +111,400 @@ size_t bignStart_keep(size_t l, bign_deep_i deep)
 	size_t f_keep = gfpCreate_keep(no);
 	size_t f_deep = gfpCreate_deep(no);
 	size_t ec_d = 3;
-	size_t ec_keep = ecpCreateJ_keep(n);
+	size_t ec_keep = ecpCreateJ_keep(n) + O_OF_W(n + 2);
 	size_t ec_deep = ecpCreateJ_deep(n, f_deep);
 	// расчет
 	return f_keep + ec_keep +
-		utilMax(3,
+		utilMax(4,
 			ec_deep,
 			ecCreateGroup_deep(f_deep),
+			zzRedBarrStart_deep(n),
 			deep ? deep(n, f_deep, ec_d, ec_deep) : 0);
 }
 
+
+/*
+*******************************************************************************
+Редукция по модулю q
+
+Параметр Барретта для порядка q размещается в bignStart() в конце описания
+кривой и адресуется указателем ec->params. Параметр не содержит ссылок,
+поэтому остается корректным при копировании описания (objCopy()).
+Регулярная редукция Барретта заменяет деление zzMod(), время работы
+которого зависит от делимого (например, от личного ключа в bignSign()).
+*******************************************************************************
+*/
+
+void bignModQ(word b[], const word a[], size_t m, const ec_o* ec,
+	void* stack)
+{
+	const size_t n = ec->f->n;
+	word* t = (word*)stack;
+	ASSERT(ecIsOperable(ec) && ec->params);
+	ASSERT(m <= 2 * n);
+	ASSERT(wwIsValid(a, m) && wwIsValid(b, n));
+	stack = t + 2 * n;
+	// t <- a
+	wwCopy(t, a, m);
+	wwSetZero(t + m, 2 * n - m);
+	// b <- t mod q
+	zzRedBarr(t, ec->order, n, (const word*)ec->params, stack);
+	wwCopy(b, t, n);
+	wwSetZero(t, n);
+}
+
+size_t bignModQ_deep(size_t n)
+{
+	return O_OF_W(2 * n) + zzRedBarr_deep(n);
+}
+
+
+/*
+*******************************************************************************
+Контекст
+
+Контекст -- это копия долговременных параметров и описание кривой,
+построенное по ним в bignStart(). Описание кривой копируется в контекст
+функцией objCopy(), которая корректирует внутренние указатели описания.
+*******************************************************************************
+*/
+
+size_t bignCtx_keep(size_t l)
+{
+	ASSERT(l == 128 || l == 192 || l == 256);
+	return sizeof(bign_ctx_st) + ecpCreateJ_keep(W_OF_B(2 * l)) +
+		O_OF_W(W_OF_B(2 * l) + 2) + gfpCreate_keep(O_OF_B(2 * l));
+}
+
+err_t bignCtxStart(void* ctx, const bign_params* params)
+{
+	err_t code;
+	bign_ctx_st* st = (bign_ctx_st*)ctx;
+	void* state;
+	// проверить params
+	if (!memIsValid(params, sizeof(bign_params)))
+		return ERR_BAD_INPUT;
+	if (!bignIsOperable(params))
+		return ERR_BAD_PARAMS;
+	// проверить ctx
+	if (!memIsValid(ctx, bignCtx_keep(params->l)))
+		return ERR_BAD_INPUT;
+	// построить описание кривой
+	state = stackCreate(bignStart_keep(params->l, 0));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	code = bignStart(state, params);
+	// скопировать параметры и описание кривой в контекст
+	if (code == ERR_OK)
+	{
+		ASSERT(objKeep(state) + sizeof(bign_ctx_st) <= 
+			bignCtx_keep(params->l));
+		memCopy(st->params, params, sizeof(bign_params));
+		objCopy(st->ec, state);
+	}
+	stackClose(state);
+	return code;
+}
+
+void bignCtxCopy(void* dest, const void* src)
+{
+	bign_ctx_st* d = (bign_ctx_st*)dest;
+	const bign_ctx_st* s = (const bign_ctx_st*)src;
+	ASSERT(bignCtxIsOperable(src));
+	ASSERT(memIsValid(dest, bignCtx_keep(s->params->l)));
+	memCopy(d->params, s->params, sizeof(bign_params));
+	objCopy(d->ec, s->ec);
+}
+
+bool_t bignCtxIsOperable(const void* ctx)
+{
+	const bign_ctx_st* st = (const bign_ctx_st*)ctx;
+	return memIsValid(ctx, sizeof(bign_ctx_st)) &&
+		bignIsOperable(st->params) &&
+		ecIsOperable((const ec_o*)st->ec) &&
+		((const ec_o*)st->ec)->f->no == O_OF_B(2 * st->params->l);
+}
+
+size_t bignCtxStack_keep(const void* ctx, bign_deep_i deep)
+{
+	const ec_o* ec = (const ec_o*)((const bign_ctx_st*)ctx)->ec;
+	ASSERT(bignCtxIsOperable(ctx));
+	return deep(ec->f->n, ec->f->deep, ec->d, ec->deep);
+}
+
+size_t bignWs_keep(const void* ctx)
+{
+	ASSERT(bignCtxIsOperable(ctx));
+	return utilMax(6,
+		bignCtxStack_keep(ctx, bignSign_deep),
+		bignCtxStack_keep(ctx, bignSign2_deep),
+		bignCtxStack_keep(ctx, bignVerify_deep),
+		bignCtxStack_keep(ctx, bignDH_deep),
+		bignCtxStack_keep(ctx, bignKeyWrap_deep),
+		bignCtxStack_keep(ctx, bignKeyUnwrap_deep));
+}
+
+/*
+*******************************************************************************
+Кратные базовой точки
+
+Для стандартных кривых bign-curve128v1, bign-curve192v1, bign-curve256v1
+базовая точка умножается гребенчатым методом (см. ecCombMulA()) с гребенкой
+из BIGN_COMB_W строк. Таблицы кривых рассчитываются при первом обращении
+(однократно, с помощью mtCallOnce()) и затем только читаются, в том числе
+из разных потоков.
+
+Таблица рассчитывается по описанию кривой, построенному в bignStart().
+Описание однозначно определяется параметрами, поэтому таблица пригодна
+для любого описания, построенного по тем же параметрам. Параметры params
+признаются стандартными, если совпадают с параметрами одной из стандартных
+кривых в используемых октетах полей p, a, b, q, yG.
+
+Для остальных параметров, а также если таблицу построить не удалось,
+используется регулярное умножение ecMulACT().
+
+При сборке с директивой BIGN_PRECOMP (опция CMake BIGN_PRECOMP) таблицы
+не рассчитываются, а берутся из заголовка bign_comb.h, который строится
+во время сборки программой bign_comb_gen (см. bign_comb_gen.c). Таблицы
+размещаются в сегменте констант: они не требуют инициализации и
+разделяются процессами, которые используют библиотеку.
+
+В bignAddMulBase() при наличии таблицы используется ecCombAddMulA():
+столбцы гребенки d обрабатываются в цепочке удвоений для e a. Для e
+длины l битов (проверка подписи) требуется около l удвоений вместо 2l
+удвоений совместного умножения в ecAddMulA().
+
+В bignAddMulBase8() по той же таблице одновременно вычисляются 8 сумм
+(ecpCombAddMulA8()). Функция используется при пакетной проверке подписей,
+если умножения 8-наборов zm8Mul() выполняются векторными инструкциями.
+*******************************************************************************
+*/
+
+static const char* const _comb_names[3] = {
+	"1.2.112.0.2.0.34.101.45.3.1",
+	"1.2.112.0.2.0.34.101.45.3.2",
+	"1.2.112.0.2.0.34.101.45.3.3",
+};
+
+#ifdef BIGN_PRECOMP
+
+#include "bign_comb.h"
+
+static const word* const _combs[3] = { _comb128, _comb192, _comb256 };
+
+#else
+
+static word _comb128[2 * W_OF_B(256) * BIGN_COMB_COUNT];
+static word _comb192[2 * W_OF_B(384) * BIGN_COMB_COUNT];
+static word _comb256[2 * W_OF_B(512) * BIGN_COMB_COUNT];
+static word* const _combs[3] = { _comb128, _comb192, _comb256 };
+static bool_t _comb_inited[3];
+static size_t _comb_once[3];
+
+static size_t bignCombInit_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return ecCombPrecompA_deep(n, ec_d, ec_deep);
+}
+
+static void bignCombInit(size_t i)
+{
+	bign_params params[1];
+	void* state;
+	ec_o* ec;
+	ASSERT(i < 3);
+	if (bignParamsStd(params, _comb_names[i]) != ERR_OK)
+		return;
+	state = blobCreate(bignStart_keep(params->l, bignCombInit_deep));
+	if (state == 0)
+		return;
+	if (bignStart(state, params) == ERR_OK)
+	{
+		ec = (ec_o*)state;
+		_comb_inited[i] = ecCombPrecompA(_combs[i], ec->base, ec,
+			BIGN_COMB_W, ec->f->n, objEnd(ec, void));
+	}
+	blobClose(state);
+}
+
+static void bignCombInit128()
+{
+	bignCombInit(0);
+}
+
+static void bignCombInit192()
+{
+	bignCombInit(1);
+}
+
+static void bignCombInit256()
+{
+	bignCombInit(2);
+}
+
+static void (*const _comb_inits[3])() = {
+	bignCombInit128, bignCombInit192, bignCombInit256
+};
+
+#endif /* BIGN_PRECOMP */
+
+static const word* bignComb(const bign_params* params)
+{
+	bign_params std[1];
+	size_t no, i;
+	ASSERT(bignIsOperable(params));
+	// стандартные параметры?
+	i = params->l / 64 - 2, no = O_OF_B(2 * params->l);
+	if (bignParamsStd(std, _comb_names[i]) != ERR_OK ||
+		!memEq(params->p, std->p, no) ||
+		!memEq(params->a, std->a, no) ||
+		!memEq(params->b, std->b, no) ||
+		!memEq(params->q, std->q, no) ||
+		!memEq(params->yG, std->yG, no))
+		return 0;
+	// таблица
+#ifndef BIGN_PRECOMP
+	if (!mtCallOnce(_comb_once + i, _comb_inits[i]) || !_comb_inited[i])
+		return 0;
+#endif
+	return _combs[i];
+}
+
+bool_t bignMulBase(word b[], const bign_params* params, const ec_o* ec,
+	const word d[], size_t m, void* stack)
+{
+	const word* pre;
+	ASSERT(ecIsOperable(ec) && m == ec->f->n);
+	pre = bignComb(params);
+	if (pre)
+		return ecCombMulA(b, pre, ec, BIGN_COMB_W, d, m, stack);
+	return ecMulACT(b, ec->base, ec, d, m, stack);
+}
+
+size_t bignMulBase_deep(size_t n, size_t ec_d, size_t ec_deep)
+{
+	return utilMax(2,
+		ecMulACT_deep(n, ec_d, ec_deep),
+		ecCombMulA_deep(n, ec_d, ec_deep));
+}
+
+bool_t bignMulBaseBatch(word b[], const bign_params* params, const ec_o* ec,
+	const word d[], size_t m, size_t count, void* stack)
+{
+	const size_t n = ec->f->n;
+	const word* pre;
+	word* t;
+	size_t i;
+	ASSERT(ecIsOperable(ec) && m == ec->f->n);
+	pre = bignComb(params);
+	// нет таблицы G?
+	if (!pre)
+	{
+		for (i = 0; i < count; ++i)
+			if (!bignMulBase(b + 2 * n * i, params, ec, d + m * i, m, stack))
+				return FALSE;
+		return TRUE;
+	}
+	// t_i <- d_i G (проективные точки)
+	t = (word*)stack;
+	stack = t + ec->d * n * count;
+	for (i = 0; i < count; ++i)
+		ecCombMul(t + ec->d * n * i, pre, ec, BIGN_COMB_W, d + m * i, m,
+			stack);
+	// к аффинным координатам
+	return ecToABatch(b, t, count, ec, stack);
+}
+
+size_t bignMulBaseBatch_deep(size_t n, size_t ec_d, size_t ec_deep,
+	size_t count)
+{
+	return utilMax(2,
+		bignMulBase_deep(n, ec_d, ec_deep),
+		O_OF_W(ec_d * n * count) +
+			utilMax(2,
+				ecCombMul_deep(n, ec_d, ec_deep),
+				ecToABatch_deep(n, ec_deep, count)));
+}
+
+bool_t bignAddMulBase(word b[], const bign_params* params, const ec_o* ec,
+	const word d[], size_t m, const word a[], const word e[], size_t k,
+	void* stack)
+{
+	const word* pre;
+	ASSERT(ecIsOperable(ec) && m == ec->f->n);
+	pre = bignComb(params);
+	if (pre)
+		return ecCombAddMulA(b, pre, ec, BIGN_COMB_W, d, m, a, e, k, stack);
+	return ecAddMulA(b, ec, stack, 2, ec->base, d, m, a, e, k);
+}
+
+size_t bignAddMulBase_deep(size_t n, size_t ec_d, size_t ec_deep, size_t k)
+{
+	return utilMax(2,
+		ecAddMulA_deep(n, ec_d, ec_deep, 2, n, k),
+		ecCombAddMulA_deep(n, ec_d, ec_deep, k));
+}
+
+bool_t bignAddMulPubkey(word b[], const bign_params* params,
+	const ec_o* ec, const word d[], size_t m, const word a[],
+	const octet pubkey[], const word e[], size_t k, void* stack)
+{
+	const size_t n = ec->f->n;
+	const word* pre;
+	word* pa;
+	ASSERT(ecIsOperable(ec) && m == ec->f->n);
+	// нет таблицы G или кэша?
+	pre = bignComb(params);
+	if (!pre || !bignVerifyCacheIsOn())
+		return bignAddMulBase(b, params, ec, d, m, a, e, k, stack);
+	// раскладка stack
+	pa = (word*)stack;
+	stack = pa + 2 * n * BIGN_VCACHE_COUNT;
+	// малые кратные Q: из кэша или расчет с добавлением в кэш
+	if (!bignVerifyCacheGet(pa, params->l, pubkey))
+	{
+		if (!ecpIsOnA(a, ec, stack) ||
+			!ecNAFPrecompA(pa, a, BIGN_VCACHE_W, ec, stack))
+			return ecCombAddMulA(b, pre, ec, BIGN_COMB_W, d, m, a, e, k,
+				stack);
+		bignVerifyCacheAdd(params->l, pubkey, pa);
+	}
+	return ecCombAddMulNAFA(b, pre, ec, BIGN_COMB_W, d, m, pa,
+		BIGN_VCACHE_W, e, k, stack);
+}
+
+size_t bignAddMulPubkey_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep, size_t k)
+{
+	return utilMax(2,
+		bignAddMulBase_deep(n, ec_d, ec_deep, k),
+		O_OF_W(2 * n * BIGN_VCACHE_COUNT) +
+			utilMax(3,
+				ecpIsOnA_deep(n, f_deep),
+				ecNAFPrecompA_deep(n, ec_d, ec_deep, BIGN_VCACHE_W),
+				ecCombAddMulNAFA_deep(n, ec_d, ec_deep, k)));
+}
+
+size_t bignAddMulBase8(word b[], const bign_params* params, const ec_o* ec,
+	const word d[], size_t m, const word a[], const word e[], size_t k,
+	void* stack)
+{
+#ifdef U64_SUPPORT
+	const word* pre;
+	ASSERT(ecIsOperable(ec) && m == ec->f->n);
+	if (!zm8IsFast() || (pre = bignComb(params)) == 0)
+		return 0;
+	return ecpCombAddMulA8(b, pre, ec, BIGN_COMB_W, d, m, a, e, k, stack);
+#else
+	return 0;
+#endif
+}
+
+size_t bignAddMulBase8_deep(size_t n, size_t f_deep, size_t k)
+{
+#ifdef U64_SUPPORT
+	return ecpCombAddMulA8_deep(n, f_deep, BIGN_COMB_W, k);
+#else
+	return 0;
+#endif
+}
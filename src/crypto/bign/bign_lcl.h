@@ -4,7 +4,7 @@
 \brief STB 34.101.45 (bign): local declarations
 \project bee2 [cryptographic library]
 \created 2014.04.03
-\version 2023.09.25
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -93,6 +93,329 @@ err_t bignStart(
 	const bign_params* params	/*!< [in] долговременные параметры */
 );
 
+/*!	\brief Редукция по модулю q
+
+	Определяется остаток [n]b от деления числа [m]a на порядок ec->order
+	группы точек кривой ec, построенной в bignStart(). Используется
+	регулярная редукция Барретта с параметром, который подготовлен
+	в bignStart() и размещен по адресу ec->params.
+	\pre Описание ec построено в bignStart().
+	\pre m <= 2 * ec->f->n.
+	\pre Буфер b либо не пересекается, либо совпадает с буфером a.
+	\deep{stack} bignModQ_deep(ec->f->n).
+*/
+void bignModQ(
+	word b[],				/*!< [out] остаток */
+	const word a[],			/*!< [in] делимое */
+	size_t m,				/*!< [in] длина a в машинных словах */
+	const ec_o* ec,			/*!< [in] описание кривой */
+	void* stack				/*!< [in] вспомогательная память */
+);
+
+size_t bignModQ_deep(size_t n);
+
+/*!	\brief Контекст
+
+	Контекст содержит копию долговременных параметров params и описание ec
+	эллиптической кривой, построенное по ним в bignStart(). Контекст
+	создается функцией bignCtxStart() и затем только читается.
+*/
+typedef struct
+{
+	bign_params params[1];	/*!< долговременные параметры */
+	octet ec[];				/*!< описание кривой */
+} bign_ctx_st;
+
+/*!	\brief Контекст работоспособен?
+
+	Проверяется работоспособность контекста ctx, созданного функцией
+	bignCtxStart().
+	\return Признак работоспособности.
+*/
+bool_t bignCtxIsOperable(
+	const void* ctx				/*!< [in] контекст */
+);
+
+/*!	\brief Длина стека для работы с контекстом
+
+	Определяется глубина стека, который требуется высокоуровневой функции
+	с потребностями deep для работы с контекстом ctx.
+	\pre bignCtxIsOperable(ctx).
+	\return Глубина стека.
+*/
+size_t bignCtxStack_keep(
+	const void* ctx,			/*!< [in] контекст */
+	bign_deep_i deep			/*!< [in] потребности в стековой памяти */
+);
+
+/*!	\brief Потребности высокоуровневых функций в стековой памяти
+
+	Функции определяют глубину стека, который требуется функциям
+	bignSign(), bignSign2(), bignVerify(), bignDH(), bignKeyWrap()
+	и bignKeyUnwrap() (а также их версиям с контекстом).
+*/
+size_t bignSign_deep(size_t n, size_t f_deep, size_t ec_d, size_t ec_deep);
+size_t bignSign2_deep(size_t n, size_t f_deep, size_t ec_d, size_t ec_deep);
+size_t bignVerify_deep(size_t n, size_t f_deep, size_t ec_d, size_t ec_deep);
+size_t bignDH_deep(size_t n, size_t f_deep, size_t ec_d, size_t ec_deep);
+size_t bignKeyWrap_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep);
+size_t bignKeyUnwrap_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep);
+
+/*!	\brief Число строк гребенки
+
+	Число строк гребенки в таблицах гребенчатого метода (см. ecCombMulA()),
+	которые строятся для базовой точки стандартных кривых и для
+	фиксированных открытых ключей.
+	\remark При сборке с директивой BEE2_LOW_MEMORY число строк
+	уменьшается до 4.
+*/
+#ifdef BEE2_LOW_MEMORY
+	#define BIGN_COMB_W 4
+#else
+	#define BIGN_COMB_W 6
+#endif
+
+/*!	\brief Число точек в таблице гребенчатого метода */
+#define BIGN_COMB_COUNT ((SIZE_1 << BIGN_COMB_W) - 1)
+
+/*!	\brief Кратная базовой точки
+
+	Определяется аффинная точка [2 * ec->f->n]b, которая является
+	[m]d-кратной базовой точки ec->base кривой ec, построенной
+	по параметрам params:
+	\code
+		b <- d G.
+	\endcode
+	Для стандартных параметров используется заранее рассчитанная таблица
+	кратных G (гребенчатый метод), для остальных -- ecMulACT().
+	\pre Описание ec построено в bignStart() по параметрам params.
+	\pre m == ec->f->n.
+	\return TRUE, если кратная точка является аффинной, и FALSE в противном
+	случае (b == O).
+	\pre d < ec->order.
+	\remark bignMulBase_deep(n, ec_d, ec_deep) не превосходит
+	ecMulACT_deep(n, ec_d, ec_deep).
+	\deep{stack} bignMulBase_deep(ec->f->n, ec->d, ec->deep).
+*/
+bool_t bignMulBase(
+	word b[],					/*!< [out] кратная точка */
+	const bign_params* params,	/*!< [in] долговременные параметры */
+	const ec_o* ec,				/*!< [in] описание кривой */
+	const word d[],				/*!< [in] кратность */
+	size_t m,					/*!< [in] длина d в машинных словах */
+	void* stack					/*!< [in] вспомогательная память */
+);
+
+size_t bignMulBase_deep(size_t n, size_t ec_d, size_t ec_deep);
+
+/*!	\brief Пакет кратных базовой точки
+
+	Определяются аффинные точки [count * 2 * ec->f->n]b, которые являются
+	[m]d_i-кратными базовой точки ec->base кривой ec, построенной
+	по параметрам params. Кратности d_i последовательно записаны
+	в массив [count * m]d.
+	Для стандартных параметров кратные вычисляются в проективных координатах
+	по таблице гребенчатого метода и затем переводятся в аффинные координаты
+	одним вызовом ecToABatch(), для остальных -- по одной в bignMulBase().
+	\pre Описание ec построено в bignStart() по параметрам params.
+	\pre m == ec->f->n.
+	\pre 0 < d_i < ec->order.
+	\return TRUE, если все кратные точки являются аффинными, и FALSE
+	в противном случае.
+	\deep{stack} bignMulBaseBatch_deep(ec->f->n, ec->d, ec->deep, count).
+*/
+bool_t bignMulBaseBatch(
+	word b[],					/*!< [out] кратные точки */
+	const bign_params* params,	/*!< [in] долговременные параметры */
+	const ec_o* ec,				/*!< [in] описание кривой */
+	const word d[],				/*!< [in] кратности */
+	size_t m,					/*!< [in] длина d_i в машинных словах */
+	size_t count,				/*!< [in] число кратностей */
+	void* stack					/*!< [in] вспомогательная память */
+);
+
+size_t bignMulBaseBatch_deep(size_t n, size_t ec_d, size_t ec_deep,
+	size_t count);
+
+/*!	\brief Сумма кратных базовой и произвольной точек
+
+	Определяется аффинная точка [2 * ec->f->n]b, которая является суммой
+	[m]d-кратной базовой точки ec->base кривой ec, построенной
+	по параметрам params, и [k]e-кратной аффинной точки [2 * ec->f->n]a:
+	\code
+		b <- d G + e a.
+	\endcode
+	Для стандартных параметров используется ecCombAddMulA() с заранее
+	рассчитанной таблицей G, для остальных -- ecAddMulA().
+	\pre Описание ec построено в bignStart() по параметрам params.
+	\pre m == ec->f->n.
+	\pre Координаты a лежат в базовом поле.
+	\return TRUE, если сумма является аффинной точкой, и FALSE в противном
+	случае (b == O).
+	\deep{stack} bignAddMulBase_deep(ec->f->n, ec->d, ec->deep, k).
+*/
+bool_t bignAddMulBase(
+	word b[],					/*!< [out] сумма кратных */
+	const bign_params* params,	/*!< [in] долговременные параметры */
+	const ec_o* ec,				/*!< [in] описание кривой */
+	const word d[],				/*!< [in] кратность G */
+	size_t m,					/*!< [in] длина d в машинных словах */
+	const word a[],				/*!< [in] точка */
+	const word e[],				/*!< [in] кратность a */
+	size_t k,					/*!< [in] длина e в машинных словах */
+	void* stack					/*!< [in] вспомогательная память */
+);
+
+size_t bignAddMulBase_deep(size_t n, size_t ec_d, size_t ec_deep, size_t k);
+
+/*!	\brief Длина окна NAF для кэшируемых открытых ключей */
+#ifdef BEE2_LOW_MEMORY
+	#define BIGN_VCACHE_W 4
+#else
+	#define BIGN_VCACHE_W 6
+#endif
+
+/*!	\brief Число малых кратных кэшируемого открытого ключа */
+#define BIGN_VCACHE_COUNT (SIZE_1 << (BIGN_VCACHE_W - 2))
+
+/*!	\brief Кэш открытых ключей создан?
+
+	Проверяется, что создан кэш открытых ключей (см.
+	bignVerifyCacheCreate()).
+	\return Признак создания.
+*/
+bool_t bignVerifyCacheIsOn();
+
+/*!	\brief Поиск открытого ключа в кэше
+
+	В кэше (см. bignVerifyCacheCreate()) ищется открытый ключ
+	[2 * no]pubkey стандартной кривой уровня l. Если ключ найден, то
+	его малые кратные копируются в [2 * n * BIGN_VCACHE_COUNT]pa.
+	\return Признак успеха. Если кэш не создан, то FALSE.
+*/
+bool_t bignVerifyCacheGet(
+	word pa[],					/*!< [out] малые кратные */
+	size_t l,					/*!< [in] уровень стойкости */
+	const octet pubkey[]		/*!< [in] открытый ключ */
+);
+
+/*!	\brief Добавление открытого ключа в кэш
+
+	В кэш (если он создан) добавляется открытый ключ [2 * no]pubkey
+	стандартной кривой уровня l с малыми кратными
+	[2 * n * BIGN_VCACHE_COUNT]pa (см. ecNAFPrecompA()).
+*/
+void bignVerifyCacheAdd(
+	size_t l,					/*!< [in] уровень стойкости */
+	const octet pubkey[],		/*!< [in] открытый ключ */
+	const word pa[]				/*!< [in] малые кратные */
+);
+
+/*!	\brief Сумма кратных базовой точки и открытого ключа
+
+	Определяется аффинная точка [2 * ec->f->n]b = d G + e Q, как
+	в bignAddMulBase(), где Q -- точка [2 * ec->f->n]a открытого ключа
+	pubkey. Если кривая стандартная и создан кэш открытых ключей, то малые
+	кратные Q берутся из кэша. Если ключа в кэше нет, то кратные
+	рассчитываются и ключ добавляется в кэш (только если Q лежит на ec).
+	\pre Описание ec построено в bignStart() по параметрам params.
+	\pre m == ec->f->n.
+	\pre Координаты a лежат в базовом поле.
+	\pre Точка a загружена из pubkey.
+	\return TRUE, если сумма является аффинной точкой, и FALSE в противном
+	случае (b == O).
+	\deep{stack} bignAddMulPubkey_deep(ec->f->n, ec->f->deep, ec->d,
+	ec->deep, k).
+*/
+bool_t bignAddMulPubkey(
+	word b[],					/*!< [out] сумма кратных */
+	const bign_params* params,	/*!< [in] долговременные параметры */
+	const ec_o* ec,				/*!< [in] описание кривой */
+	const word d[],				/*!< [in] кратность G */
+	size_t m,					/*!< [in] длина d в машинных словах */
+	const word a[],				/*!< [in] точка Q */
+	const octet pubkey[],		/*!< [in] открытый ключ */
+	const word e[],				/*!< [in] кратность Q */
+	size_t k,					/*!< [in] длина e в машинных словах */
+	void* stack					/*!< [in] вспомогательная память */
+);
+
+size_t bignAddMulPubkey_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep, size_t k);
+
+/*!	\brief Восемь сумм кратных базовой и произвольных точек
+
+	Для j = 0, 1,..., 7 определяются аффинные точки [2 * ec->f->n]b_j:
+	\code
+		b_j <- d_j G + e_j a_j,
+	\endcode
+	где [m]d_j, [k]e_j -- кратности, [2 * ec->f->n]a_j -- аффинные точки.
+	Точки и кратности размещаются подряд в массивах b, a, d, e.
+	Суммы вычисляются одновременно функцией ecpCombAddMulA8(), если
+	параметры стандартные (имеется таблица кратных G) и zm8IsFast() == TRUE.
+	\pre Описание ec построено в bignStart() по параметрам params.
+	\pre m == ec->f->n.
+	\pre Координаты a_j лежат в базовом поле.
+	\return Маска дорожек: бит j маски равен 1, если точка b_j вычислена.
+	Если маска нулевая, то, возможно, одновременное вычисление
+	не поддерживается. Невычисленные суммы следует рассчитать с помощью
+	bignAddMulBase().
+	\deep{stack} bignAddMulBase8_deep(ec->f->n, ec->f->deep, k).
+*/
+size_t bignAddMulBase8(
+	word b[],					/*!< [out] суммы кратных */
+	const bign_params* params,	/*!< [in] долговременные параметры */
+	const ec_o* ec,				/*!< [in] описание кривой */
+	const word d[],				/*!< [in] кратности G */
+	size_t m,					/*!< [in] длина d_j в машинных словах */
+	const word a[],				/*!< [in] точки */
+	const word e[],				/*!< [in] кратности a_j */
+	size_t k,					/*!< [in] длина e_j в машинных словах */
+	void* stack					/*!< [in] вспомогательная память */
+);
+
+size_t bignAddMulBase8_deep(size_t n, size_t f_deep, size_t k);
+
+/*!	\brief Пул одноразовых ключей работоспособен?
+
+	Проверяется работоспособность пула eph, созданного функцией
+	bignEphStart().
+	\return Признак работоспособности.
+*/
+bool_t bignEphIsOperable(
+	const void* eph				/*!< [in] пул */
+);
+
+/*!	\brief Контекст пула одноразовых ключей
+
+	Возвращается контекст bign, с которым создан пул eph.
+	\pre bignEphIsOperable(eph).
+	\return Контекст.
+*/
+const void* bignEphCtx(
+	const void* eph				/*!< [in] пул */
+);
+
+/*!	\brief Выдача одноразового ключа
+
+	Из пула eph выдается пара: одноразовый личный ключ [n]k и аффинная
+	точка [2 * n]V = k G, n = ec->f->n. Выданная пара удаляется из пула.
+	Если пул пуст, то пара строится на месте с помощью генератора пула.
+	\pre bignEphIsOperable(eph).
+	\return ERR_OK, если пара выдана, и код ошибки в противном случае.
+	\deep{stack} bignEphPop_deep(n, ec->f->deep, ec->d, ec->deep).
+*/
+err_t bignEphPop(
+	word k[],					/*!< [out] одноразовый личный ключ */
+	word V[],					/*!< [out] кратная точка */
+	void* eph,					/*!< [in,out] пул */
+	void* stack					/*!< [in] вспомогательная память */
+);
+
+size_t bignEphPop_deep(size_t n, size_t f_deep, size_t ec_d, size_t ec_deep);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,17 +4,18 @@
 \brief STB 34.101.45 (bign): miscellaneous (OIDs, keys, DH)
 \project bee2 [cryptographic library]
 \created 2012.04.27
-\version 2023.09.22
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
-#include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
 #include "bee2/core/oid.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/str.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/bign.h"
 #include "bee2/math/ecp.h"
@@ -59,7 +60,7 @@ static size_t bignKeypairGen_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(n + 2 * n) +
-		ecMulA_deep(n, ec_d, ec_deep, n);
+		bignMulBase_deep(n, ec_d, ec_deep);
 }
 
 err_t bignKeypairGen(octet privkey[], octet pubkey[],
@@ -82,12 +83,14 @@ err_t bignKeypairGen(octet privkey[], octet pubkey[],
 	if (rng == 0)
 		return ERR_BAD_RNG;
 	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignKeypairGen_deep));
+	state = stackCreate(bignStart_keep(params->l, bignKeypairGen_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
+	tmTraceBegin("bignKeypairGen");
 	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code,
+		(tmTraceEnd("bignKeypairGen"), stackClose(state)));
 	ec = (ec_o*)state;
 	// размерности
 	no  = ec->f->no;
@@ -95,7 +98,8 @@ err_t bignKeypairGen(octet privkey[], octet pubkey[],
 	// проверить входные указатели
 	if (!memIsValid(privkey, no) || !memIsValid(pubkey, 2 * no))
 	{
-		blobClose(state);
+		tmTraceEnd("bignKeypairGen");
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -105,11 +109,12 @@ err_t bignKeypairGen(octet privkey[], octet pubkey[],
 	// d <-R {1,2,..., q - 1}
 	if (!zzRandNZMod(d, ec->f->mod, n, rng, rng_state))
 	{
-		blobClose(state);
+		tmTraceEnd("bignKeypairGen");
+		stackClose(state);
 		return ERR_BAD_RNG;
 	}
 	// Q <- d G
-	if (ecMulA(Q, ec->base, ec, d, n, stack))
+	if (bignMulBase(Q, params, ec, d, n, stack))
 	{
 		// выгрузить ключи
 		wwTo(privkey, no, d);
@@ -118,8 +123,9 @@ err_t bignKeypairGen(octet privkey[], octet pubkey[],
 	}
 	else
 		code = ERR_BAD_PARAMS;
+	tmTraceEnd("bignKeypairGen");
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
@@ -133,7 +139,7 @@ static size_t bignKeypairVal_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(n + 2 * n) +
-		ecMulA_deep(n, ec_d, ec_deep, n);
+		bignMulBase_deep(n, ec_d, ec_deep);
 }
 
 err_t bignKeypairVal(const bign_params* params, const octet privkey[],
@@ -153,12 +159,12 @@ err_t bignKeypairVal(const bign_params* params, const octet privkey[],
 	if (!bignIsOperable(params))
 		return ERR_BAD_PARAMS;
 	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignKeypairVal_deep));
+	state = stackCreate(bignStart_keep(params->l, bignKeypairVal_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	no = ec->f->no;
@@ -166,7 +172,7 @@ err_t bignKeypairVal(const bign_params* params, const octet privkey[],
 	// проверить входные указатели
 	if (!memIsValid(privkey, no) || !memIsValid(pubkey, 2 * no))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -179,11 +185,11 @@ err_t bignKeypairVal(const bign_params* params, const octet privkey[],
 	wwFrom(Q, params->q, no);
 	if (wwIsZero(d, n) || wwCmp(d, Q, n) >= 0)
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PRIVKEY;
 	}
 	// Q <- d G
-	if (ecMulA(Q, ec->base, ec, d, n, stack))
+	if (bignMulBase(Q, params, ec, d, n, stack))
 	{
 		// Q == pubkey?
 		wwTo(Q, 2 * no, Q);
@@ -193,7 +199,7 @@ err_t bignKeypairVal(const bign_params* params, const octet privkey[],
 	else
 		code = ERR_BAD_PARAMS;
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
@@ -219,12 +225,12 @@ err_t bignPubkeyVal(const bign_params* params, const octet pubkey[])
 	if (!bignIsOperable(params))
 		return ERR_BAD_PARAMS;
 	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignPubkeyVal_deep));
+	state = stackCreate(bignStart_keep(params->l, bignPubkeyVal_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	no  = ec->f->no;
@@ -232,7 +238,7 @@ err_t bignPubkeyVal(const bign_params* params, const octet pubkey[])
 	// проверить входные указатели
 	if (!memIsValid(pubkey, 2 * no))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -242,13 +248,104 @@ err_t bignPubkeyVal(const bign_params* params, const octet pubkey[])
 	if (!qrFrom(ecX(Q), pubkey, ec->f, stack) ||
 		!qrFrom(ecY(Q, n), pubkey + no, ec->f, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PUBKEY;
 	}
 	// Q \in ec?
 	code = ecpIsOnA(Q, ec, stack) ? ERR_OK : ERR_BAD_PUBKEY;
 	// завершение
-	blobClose(state);
+	stackClose(state);
+	return code;
+}
+
+/*
+*******************************************************************************
+Пакетная проверка открытых ключей
+
+Ключи обрабатываются группами по BIGN_VAL_BATCH: координаты ключей группы
+загружаются в массив Q (ключи с координатами вне поля заменяются нулевыми
+точками и отмечаются как некорректные), затем все точки группы проверяются
+одним вызовом ecpIsOnABatch(). Кривая строится однократно для всего пакета.
+*******************************************************************************
+*/
+
+#define BIGN_VAL_BATCH 32
+
+static size_t bignPubkeyValBatch_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return O_OF_W(2 * n * BIGN_VAL_BATCH) +
+		2 * BIGN_VAL_BATCH * sizeof(bool_t) +
+		ecpIsOnABatch_deep(n, f_deep);
+}
+
+err_t bignPubkeyValBatch(err_t codes[], const bign_params* params,
+	size_t count, const octet pubkeys[])
+{
+	err_t code;
+	size_t no, n, i, j, k;
+	// состояние
+	void* state;
+	ec_o* ec;			/* описание эллиптической кривой */
+	word* Q;			/* [2n * BIGN_VAL_BATCH] открытые ключи */
+	bool_t* loaded;		/* [BIGN_VAL_BATCH] координаты загружены? */
+	bool_t* rets;		/* [BIGN_VAL_BATCH] точки на кривой? */
+	void* stack;
+	// проверить params
+	if (!memIsValid(params, sizeof(bign_params)))
+		return ERR_BAD_INPUT;
+	if (!bignIsOperable(params))
+		return ERR_BAD_PARAMS;
+	// проверить входные указатели
+	no = params->l / 4;
+	if (count > SIZE_MAX / (2 * no) ||
+		!memIsValid(pubkeys, count * 2 * no) ||
+		!memIsNullOrValid(codes, count * sizeof(err_t)))
+		return ERR_BAD_INPUT;
+	if (count == 0)
+		return ERR_OK;
+	// создать состояние
+	state = stackCreate(bignStart_keep(params->l, bignPubkeyValBatch_deep));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// старт
+	code = bignStart(state, params);
+	ERR_CALL_HANDLE(code, stackClose(state));
+	ec = (ec_o*)state;
+	n = ec->f->n;
+	ASSERT(no == ec->f->no);
+	// раскладка состояния
+	Q = objEnd(ec, word);
+	loaded = (bool_t*)(Q + 2 * n * BIGN_VAL_BATCH);
+	rets = loaded + BIGN_VAL_BATCH;
+	stack = rets + BIGN_VAL_BATCH;
+	// обработать группы
+	for (i = 0; i < count; i += k)
+	{
+		k = MIN2(count - i, BIGN_VAL_BATCH);
+		// загрузить ключи
+		for (j = 0; j < k; ++j)
+		{
+			const octet* pubkey = pubkeys + (i + j) * 2 * no;
+			word* Qj = Q + 2 * n * j;
+			loaded[j] = qrFrom(ecX(Qj), pubkey, ec->f, stack) &&
+				qrFrom(ecY(Qj, n), pubkey + no, ec->f, stack);
+			if (!loaded[j])
+				wwSetZero(Qj, 2 * n);
+		}
+		// проверить ключи
+		ecpIsOnABatch(rets, Q, k, ec, stack);
+		for (j = 0; j < k; ++j)
+		{
+			err_t c = loaded[j] && rets[j] ? ERR_OK : ERR_BAD_PUBKEY;
+			if (codes)
+				codes[i + j] = c;
+			if (c != ERR_OK)
+				code = c;
+		}
+	}
+	// завершение
+	stackClose(state);
 	return code;
 }
 
@@ -262,7 +359,7 @@ static size_t bignPubkeyCalc_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(n + 2 * n) +
-		ecMulA_deep(n, ec_d, ec_deep, n);
+		bignMulBase_deep(n, ec_d, ec_deep);
 }
 
 err_t bignPubkeyCalc(octet pubkey[], const bign_params* params,
@@ -282,12 +379,12 @@ err_t bignPubkeyCalc(octet pubkey[], const bign_params* params,
 	if (!bignIsOperable(params))
 		return ERR_BAD_PARAMS;
 	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignPubkeyCalc_deep));
+	state = stackCreate(bignStart_keep(params->l, bignPubkeyCalc_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	no  = ec->f->no;
@@ -295,7 +392,7 @@ err_t bignPubkeyCalc(octet pubkey[], const bign_params* params,
 	// проверить входные указатели
 	if (!memIsValid(privkey, no) || !memIsValid(pubkey, 2 * no))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -306,11 +403,11 @@ err_t bignPubkeyCalc(octet pubkey[], const bign_params* params,
 	wwFrom(d, privkey, no);
 	if (wwIsZero(d, n) || wwCmp(d, ec->order, n) >= 0)
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PRIVKEY;
 	}
 	// Q <- d G
-	if (ecMulA(Q, ec->base, ec, d, n, stack))
+	if (bignMulBase(Q, params, ec, d, n, stack))
 	{
 		// выгрузить открытый ключ
 		qrTo(pubkey, ecX(Q), ec->f, stack);
@@ -319,7 +416,7 @@ err_t bignPubkeyCalc(octet pubkey[], const bign_params* params,
 	else
 		code = ERR_BAD_PARAMS;
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
@@ -329,87 +426,110 @@ err_t bignPubkeyCalc(octet pubkey[], const bign_params* params,
 *******************************************************************************
 */
 
-static size_t bignDH_deep(size_t n, size_t f_deep, size_t ec_d,
+size_t bignDH_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(n + 2 * n) +
 		utilMax(2,
 			ecpIsOnA_deep(n, f_deep),
-			ecMulA_deep(n, ec_d, ec_deep, n));
+			ecMulACT_deep(n, ec_d, ec_deep));
 }
 
-err_t bignDH(octet key[], const bign_params* params, const octet privkey[],
-	const octet pubkey[], size_t key_len)
+static err_t bignDHStep(octet key[], const ec_o* ec, const octet privkey[],
+	const octet pubkey[], size_t key_len, void* stack)
 {
-	err_t code;
-	size_t no, n;
+	const size_t no = ec->f->no;
+	const size_t n = ec->f->n;
 	// состояние
-	void* state;
-	ec_o* ec;				/* описание эллиптической кривой */
 	word* d;				/* [n] личный ключ */
 	word* Q;				/* [2n] открытый ключ */
-	void* stack;
-	// проверить params
-	if (!memIsValid(params, sizeof(bign_params)))
-		return ERR_BAD_INPUT;
-	if (!bignIsOperable(params))
-		return ERR_BAD_PARAMS;
-	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignDH_deep));
-	if (state == 0)
-		return ERR_OUTOFMEMORY;
-	// старт
-	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
-	ec = (ec_o*)state;
-	// размерности
-	no  = ec->f->no;
-	n = ec->f->n;
 	// проверить длину key
 	if (key_len > 2 * no)
-	{
-		blobClose(state);
 		return ERR_BAD_SHAREDKEY;
-	}
 	// проверить входные указатели
 	if (!memIsValid(privkey, no) || 
 		!memIsValid(pubkey, 2 * no) ||
 		!memIsValid(key, key_len))
-	{
-		blobClose(state);
 		return ERR_BAD_INPUT;
-	}
 	// раскладка состояния
-	d = objEnd(ec, word);
+	d = (word*)stack;
 	Q = d + n;
 	stack = Q + 2 * n;
 	// загрузить d
 	wwFrom(d, privkey, no);
 	if (wwIsZero(d, n) || wwCmp(d, ec->order, n) >= 0)
-	{
-		blobClose(state);
 		return ERR_BAD_PRIVKEY;
-	}
 	// загрузить Q
 	if (!qrFrom(ecX(Q), pubkey, ec->f, stack) ||
 		!qrFrom(ecY(Q, n), pubkey + no, ec->f, stack) ||
 		!ecpIsOnA(Q, ec, stack))
-	{
-		blobClose(state);
 		return ERR_BAD_PUBKEY;
-	}
 	// Q <- d Q
-	if (ecMulA(Q, Q, ec, d, n, stack))
-	{
-		// выгрузить общий ключ
-		qrTo((octet*)Q, ecX(Q), ec->f, stack);
-		if (key_len > no)
-			qrTo((octet*)Q + no, ecY(Q, n), ec->f, stack);
-		memCopy(key, Q, key_len);
-	}
-	else
-		code = ERR_BAD_PARAMS;
+	if (!ecMulACT(Q, Q, ec, d, n, stack))
+		return ERR_BAD_PARAMS;
+	// выгрузить общий ключ
+	qrTo((octet*)Q, ecX(Q), ec->f, stack);
+	if (key_len > no)
+		qrTo((octet*)Q + no, ecY(Q, n), ec->f, stack);
+	memCopy(key, Q, key_len);
+	return ERR_OK;
+}
+
+err_t bignDH(octet key[], const bign_params* params, const octet privkey[],
+	const octet pubkey[], size_t key_len)
+{
+	err_t code;
+	void* state;
+	ec_o* ec;				/* описание эллиптической кривой */
+	// проверить params
+	if (!memIsValid(params, sizeof(bign_params)))
+		return ERR_BAD_INPUT;
+	if (!bignIsOperable(params))
+		return ERR_BAD_PARAMS;
+	// создать состояние
+	state = stackCreate(bignStart_keep(params->l, bignDH_deep));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// старт
+	tmTraceBegin("bignDH");
+	code = bignStart(state, params);
+	ERR_CALL_HANDLE(code, (tmTraceEnd("bignDH"), stackClose(state)));
+	ec = (ec_o*)state;
+	// вычислить общий ключ
+	code = bignDHStep(key, ec, privkey, pubkey, key_len, objEnd(ec, void));
+	tmTraceEnd("bignDH");
+	// завершение
+	stackClose(state);
+	return code;
+}
+
+err_t bignDHWs(octet key[], const void* ctx, void* ws,
+	const octet privkey[], const octet pubkey[], size_t key_len)
+{
+	// проверить ctx и ws
+	if (!bignCtxIsOperable(ctx) || !memIsValid(ws, bignWs_keep(ctx)))
+		return ERR_BAD_INPUT;
+	// вычислить общий ключ
+	return tmTraceCall("bignDHWs", bignDHStep(key,
+		(const ec_o*)((const bign_ctx_st*)ctx)->ec, privkey, pubkey, key_len,
+		ws));
+}
+
+err_t bignDHCtx(octet key[], const void* ctx, const octet privkey[],
+	const octet pubkey[], size_t key_len)
+{
+	err_t code;
+	void* ws;
+	// проверить ctx
+	if (!bignCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// создать рабочую память
+	ws = stackCreate(bignWs_keep(ctx));
+	if (ws == 0)
+		return ERR_OUTOFMEMORY;
+	// вычислить общий ключ
+	code = bignDHWs(key, ctx, ws, privkey, pubkey, key_len);
 	// завершение
-	blobClose(state);
+	stackClose(ws);
 	return code;
 }
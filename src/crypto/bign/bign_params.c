@@ -4,16 +4,17 @@
 \brief STB 34.101.45 (bign): public parameters
 \project bee2 [cryptographic library]
 \created 2012.04.27
-\version 2024.02.28
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
-#include "bee2/core/blob.h"
 #include "bee2/core/der.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/str.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
@@ -234,6 +235,101 @@ err_t bignParamsStd(bign_params* params, const char* name)
 	return ERR_FILE_NOT_FOUND;
 }
 
+/*
+*******************************************************************************
+Кэш проверенных параметров
+
+Стандартные параметры признаются корректными без проверки, если совпадают
+с параметрами одной из стандартных кривых во всех используемых октетах
+(включая seed). Остальные параметры после успешной проверки запоминаются
+хэш-значениями belt-hash. Хэшируется непрерывный участок params от p
+до seed включительно: неиспользуемые октеты p, a, b, q, yG обнулены
+(bignIsOperable()), уровень l однозначно определяется по p.
+
+Кэш содержит до BIGN_PARAMS_CACHE хэш-значений и при переполнении
+заполняется по кругу. Обращения к кэшу защищены мьютексом, который
+создается однократно (mtCallOnce()) и закрывается при завершении
+программы (utilOnExit()). Если мьютекс создать не удалось, то кэш не
+используется. Отрицательные результаты проверки не запоминаются.
+*******************************************************************************
+*/
+
+#define BIGN_PARAMS_CACHE 16
+
+static size_t _cache_once;					/*< триггер однократности */
+static bool_t _cache_inited;				/*< флаг инициализации */
+static mt_mtx_t _cache_mtx[1];				/*< мьютекс */
+static octet _cache[BIGN_PARAMS_CACHE][32];	/*< хэш-значения */
+static size_t _cache_count;					/*< число хэш-значений */
+static size_t _cache_pos;					/*< позиция для записи */
+
+static void bignParamsCacheClose()
+{
+	mtMtxClose(_cache_mtx);
+}
+
+static void bignParamsCacheInit()
+{
+	if (!mtMtxCreate(_cache_mtx))
+		return;
+	if (!utilOnExit(bignParamsCacheClose))
+	{
+		mtMtxClose(_cache_mtx);
+		return;
+	}
+	_cache_inited = TRUE;
+}
+
+static bool_t bignParamsIsStd(const bign_params* params)
+{
+	static const char* const names[3] = {
+		_curve128v1_name, _curve192v1_name, _curve256v1_name,
+	};
+	bign_params std[1];
+	size_t no;
+	ASSERT(bignIsOperable(params));
+	no = O_OF_B(2 * params->l);
+	return bignParamsStd(std, names[params->l / 64 - 2]) == ERR_OK &&
+		memEq(params->p, std->p, no) &&
+		memEq(params->a, std->a, no) &&
+		memEq(params->b, std->b, no) &&
+		memEq(params->q, std->q, no) &&
+		memEq(params->yG, std->yG, no) &&
+		memEq(params->seed, std->seed, 8);
+}
+
+static bool_t bignParamsHash(octet hash[32], const bign_params* params)
+{
+	ASSERT(bignIsOperable(params));
+	return beltHash(hash, params->p,
+		(size_t)(params->seed + 8 - params->p)) == ERR_OK;
+}
+
+static bool_t bignParamsCacheHas(const octet hash[32])
+{
+	bool_t ret = FALSE;
+	size_t i;
+	if (!mtCallOnce(&_cache_once, bignParamsCacheInit) || !_cache_inited)
+		return FALSE;
+	mtMtxLock(_cache_mtx);
+	for (i = 0; !ret && i < _cache_count; ++i)
+		ret = memEq(_cache[i], hash, 32);
+	mtMtxUnlock(_cache_mtx);
+	return ret;
+}
+
+static void bignParamsCacheAdd(const octet hash[32])
+{
+	if (!mtCallOnce(&_cache_once, bignParamsCacheInit) || !_cache_inited)
+		return;
+	mtMtxLock(_cache_mtx);
+	memCopy(_cache[_cache_pos], hash, 32);
+	_cache_pos = (_cache_pos + 1) % BIGN_PARAMS_CACHE;
+	if (_cache_count < BIGN_PARAMS_CACHE)
+		++_cache_count;
+	mtMtxUnlock(_cache_mtx);
+}
+
 /*
 *******************************************************************************
 Проверка параметров
@@ -283,6 +379,8 @@ err_t bignParamsVal(const bign_params* params)
 {
 	err_t code;
 	size_t no, n;
+	octet digest[32];
+	bool_t cached;
 	// состояние (буферы могут пересекаться)
 	void* state;
 	ec_o* ec;				/* описание эллиптической кривой */
@@ -295,13 +393,19 @@ err_t bignParamsVal(const bign_params* params)
 		return ERR_BAD_INPUT;
 	if (!bignIsOperable(params))
 		return ERR_BAD_PARAMS;
+	// стандартные или ранее проверенные параметры?
+	if (bignParamsIsStd(params))
+		return ERR_OK;
+	cached = bignParamsHash(digest, params);
+	if (cached && bignParamsCacheHas(digest))
+		return ERR_OK;
 	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignParamsVal_deep));
+	state = stackCreate(bignStart_keep(params->l, bignParamsVal_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	no  = ec->f->no;
@@ -350,8 +454,11 @@ err_t bignParamsVal(const bign_params* params)
 	}
 	else
 		code = ERR_BAD_PARAMS;
+	// запомнить параметры
+	if (code == ERR_OK && cached)
+		bignParamsCacheAdd(digest);
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
@@ -473,7 +580,7 @@ err_t bignParamsGen(bign_params* params, bign_pgen_calc_q calc_q,
 		!memIsZero(params->a + no, sizeof(params->a) - no))
 		return ERR_BAD_PARAMS;
 	// создать состояние
-	st = blobCreate(bignParamsGen_deep(n));
+	st = stackCreate(bignParamsGen_deep(n));
 	if (st == 0)
 		return ERR_OUTOFMEMORY;
 	// раскладка состояния
@@ -491,7 +598,7 @@ err_t bignParamsGen(bign_params* params, bign_pgen_calc_q calc_q,
 	ASSERT(wwGetBits(p, 0, 2) == 3);
 	if (!priIsPrime(p, n, stack))
 	{
-		blobClose(st);
+		stackClose(st);
 		return ERR_BAD_PARAMS;
 	}
 	// загрузить a
@@ -508,7 +615,7 @@ err_t bignParamsGen(bign_params* params, bign_pgen_calc_q calc_q,
 		if (on_seed)
 		{
 			code = on_seed(params, state);
-			ERR_CALL_HANDLE(code, blobClose(st));
+			ERR_CALL_HANDLE(code, stackClose(st));
 		}
 		// belt-hash(p || a ||..)
 		beltHashStart(hash_state);
@@ -537,7 +644,7 @@ err_t bignParamsGen(bign_params* params, bign_pgen_calc_q calc_q,
 		code = calc_q(params, state);
 		if (code == ERR_NO_RESULT)
 			continue;
-		ERR_CALL_HANDLE(code, blobClose(st));
+		ERR_CALL_HANDLE(code, stackClose(st));
 		// загрузить и проверить q
 		wwFrom(q, params->q, no);
 		if (wwBitSize(q, n) == params->l * 2 &&
@@ -558,7 +665,7 @@ err_t bignParamsGen(bign_params* params, bign_pgen_calc_q calc_q,
 	wwTo(params->yG, no, yG);
 	memSetZero(params->yG + no, sizeof(params->yG) - no);
 	// завершение
-	blobClose(st);
+	stackClose(st);
 	return code;
 }
 
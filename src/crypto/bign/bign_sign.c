@@ -4,7 +4,7 @@
 \brief STB 34.101.45 (bign): digital signature
 \project bee2 [cryptographic library]
 \created 2012.04.27
-\version 2023.09.20
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -14,10 +14,14 @@
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
 #include "bee2/core/oid.h"
+#include "bee2/core/rng.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/str.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
 #include "bee2/crypto/bign.h"
+#include "bee2/crypto/prov.h"
 #include "bee2/math/ecp.h"
 #include "bee2/math/ww.h"
 #include "bee2/math/zz.h"
@@ -29,88 +33,62 @@
 *******************************************************************************
 */
 
-static size_t bignSign_deep(size_t n, size_t f_deep, size_t ec_d,
+size_t bignSign_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(4 * n) +
 		utilMax(4,
 			beltHash_keep(),
-			ecMulA_deep(n, ec_d, ec_deep, n),
+			bignMulBase_deep(n, ec_d, ec_deep),
 			zzMul_deep(n / 2, n),
-			zzMod_deep(n + n / 2 + 1, n));
+			bignModQ_deep(n));
 }
 
-err_t bignSign(octet sig[], const bign_params* params, const octet oid_der[],
-	size_t oid_len, const octet hash[], const octet privkey[], gen_i rng, 
-	void* rng_state)
+static err_t bignSignStep(octet sig[], const bign_params* params,
+	const ec_o* ec, const octet oid_der[], size_t oid_len,
+	const octet hash[], const octet privkey[], gen_i rng, void* rng_state,
+	void* eph, void* stack)
 {
 	err_t code;
-	size_t no, n;
+	const size_t no = ec->f->no;
+	const size_t n = ec->f->n;
 	// состояние (буферы могут пересекаться)
-	void* state;			
-	ec_o* ec;				/* описание эллиптической кривой */
 	word* d;				/* [n] личный ключ */
 	word* k;				/* [n] одноразовый личный ключ */
 	word* R;				/* [2n] точка R */
 	word* s0;				/* [n/2] первая часть подписи */
 	word* s1;				/* [n] вторая часть подписи */
-	octet* stack;
-	// проверить params
-	if (!memIsValid(params, sizeof(bign_params)))
-		return ERR_BAD_INPUT;
-	if (!bignIsOperable(params))
-		return ERR_BAD_PARAMS;
-	// проверить oid_der
-	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
-		return ERR_BAD_OID;
-	// проверить rng
-	if (rng == 0)
-		return ERR_BAD_RNG;
-	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignSign_deep));
-	if (state == 0)
-		return ERR_OUTOFMEMORY;
-	// старт
-	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
-	ec = (ec_o*)state;
-	// размерности
-	no  = ec->f->no;
-	n = ec->f->n;
 	ASSERT(n % 2 == 0);
 	// проверить входные указатели
 	if (!memIsValid(hash, no) ||
 		!memIsValid(privkey, no) ||
 		!memIsValid(sig, no + no / 2) ||
 		!memIsDisjoint2(hash, no, sig, no + no / 2))
-	{
-		blobClose(state);
 		return ERR_BAD_INPUT;
-	}
 	// раскладка состояния
-	d = s1 = objEnd(ec, word);
+	d = s1 = (word*)stack;
 	k = d + n;
 	R = k + n;
 	s0 = R + n + n / 2;
-	stack = (octet*)(R + 2 * n);
+	stack = R + 2 * n;
 	// загрузить d
 	wwFrom(d, privkey, no);
 	if (wwIsZero(d, n) || wwCmp(d, ec->order, n) >= 0)
-	{
-		blobClose(state);
 		return ERR_BAD_PRIVKEY;
-	}
-	// сгенерировать k с помощью rng
-	if (!zzRandNZMod(k, ec->order, n, rng, rng_state))
+	// (k, R) <- пара из пула
+	if (eph)
 	{
-		blobClose(state);
-		return ERR_BAD_RNG;
+		code = bignEphPop(k, R, eph, stack);
+		ERR_CALL_CHECK(code);
 	}
-	// R <- k G
-	if (!ecMulA(R, ec->base, ec, k, n, stack))
+	else
 	{
-		blobClose(state);
-		return ERR_BAD_PARAMS;
+		// сгенерировать k с помощью rng
+		if (!zzRandNZMod(k, ec->order, n, rng, rng_state))
+			return ERR_BAD_RNG;
+		// R <- k G
+		if (!bignMulBase(R, params, ec, k, n, stack))
+			return ERR_BAD_PARAMS;
 	}
 	qrTo((octet*)R, ecX(R), ec->f, stack);
 	// s0 <- belt-hash(oid || R || H) mod 2^l
@@ -124,7 +102,7 @@ err_t bignSign(octet sig[], const bign_params* params, const octet oid_der[],
 	zzMul(R, s0, n / 2, d, n, stack);
 	R[n + n / 2] = zzAdd(R + n / 2, R + n / 2, d, n);
 	// s1 <- R mod q
-	zzMod(s1, R, n + n / 2 + 1, ec->order, n, stack);
+	bignModQ(s1, R, n + n / 2 + 1, ec, stack);
 	// s1 <- (k - s1 - H) mod q
 	zzSubMod(s1, k, s1, ec->order, n);
 	wwFrom(k, hash, no);
@@ -132,39 +110,16 @@ err_t bignSign(octet sig[], const bign_params* params, const octet oid_der[],
 	// выгрузить s1
 	wwTo(sig + no / 2, no, s1);
 	// все нормально
-	blobClose(state);
 	return ERR_OK;
 }
 
-static size_t bignSign2_deep(size_t n, size_t f_deep, size_t ec_d,
-	size_t ec_deep)
-{
-	return O_OF_W(4 * n) + beltHash_keep() +
-		utilMax(6,
-			beltHash_keep(),
-			32,
-			beltWBL_keep(),
-			ecMulA_deep(n, ec_d, ec_deep, n),
-			zzMul_deep(n / 2, n),
-			zzMod_deep(n + n / 2 + 1, n));
-}
-
-err_t bignSign2(octet sig[], const bign_params* params, const octet oid_der[],
-	size_t oid_len, const octet hash[], const octet privkey[], const void* t, 
-	size_t t_len)
+err_t bignSign(octet sig[], const bign_params* params, const octet oid_der[],
+	size_t oid_len, const octet hash[], const octet privkey[], gen_i rng, 
+	void* rng_state)
 {
 	err_t code;
-	size_t no, n;
-	// состояние (буферы могут пересекаться)
 	void* state;
 	ec_o* ec;				/* описание эллиптической кривой */
-	word* d;				/* [n] личный ключ */
-	word* k;				/* [n] одноразовый личный ключ */
-	word* R;				/* [2n] точка R */
-	word* s0;				/* [n/2] первая часть подписи */
-	word* s1;				/* [n] вторая часть подписи */
-	octet* hash_state;		/* [beltHash_keep] состояние хэширования */
-	octet* stack;
 	// проверить params
 	if (!memIsValid(params, sizeof(bign_params)))
 		return ERR_BAD_INPUT;
@@ -173,75 +128,170 @@ err_t bignSign2(octet sig[], const bign_params* params, const octet oid_der[],
 	// проверить oid_der
 	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
 		return ERR_BAD_OID;
-	// проверить t
-	if (!memIsNullOrValid(t, t_len))
-		return ERR_BAD_INPUT;
+	// проверить rng
+	if (rng == 0)
+		return ERR_BAD_RNG;
 	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignSign2_deep));
+	state = stackCreate(bignStart_keep(params->l, bignSign_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
+	tmTraceBegin("bignSign");
 	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, (tmTraceEnd("bignSign"), stackClose(state)));
 	ec = (ec_o*)state;
-	// размерности
-	no  = ec->f->no;
-	n = ec->f->n;
-	ASSERT(n % 2 == 0);
-	// проверить входные указатели
-	if (!memIsValid(hash, no) ||
-		!memIsValid(privkey, no) ||
-		!memIsValid(sig, no + no / 2) ||
-		!memIsDisjoint2(hash, no, sig, no + no / 2))
-	{
-		blobClose(state);
+	// выработать подпись
+	code = bignSignStep(sig, params, ec, oid_der, oid_len, hash, privkey,
+		rng, rng_state, 0, objEnd(ec, void));
+	tmTraceEnd("bignSign");
+	// завершение
+	stackClose(state);
+	return code;
+}
+
+err_t bignSignWs(octet sig[], const void* ctx, void* ws,
+	const octet oid_der[], size_t oid_len, const octet hash[],
+	const octet privkey[], gen_i rng, void* rng_state)
+{
+	const bign_ctx_st* st = (const bign_ctx_st*)ctx;
+	// проверить ctx и ws
+	if (!bignCtxIsOperable(ctx) || !memIsValid(ws, bignWs_keep(ctx)))
 		return ERR_BAD_INPUT;
-	}
-	// раскладка состояния
-	d = s1 = objEnd(ec, word);
-	k = d + n;
-	R = k + n;
-	s0 = R + n + n / 2;
-	hash_state = (octet*)(R + 2 * n);
-	stack = hash_state + beltHash_keep();
-	// загрузить d
-	wwFrom(d, privkey, no);
-	if (wwIsZero(d, n) || wwCmp(d, ec->order, n) >= 0)
-	{
-		blobClose(state);
-		return ERR_BAD_PRIVKEY;
-	}
+	// проверить oid_der
+	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
+		return ERR_BAD_OID;
+	// проверить rng
+	if (rng == 0)
+		return ERR_BAD_RNG;
+	// выработать подпись
+	return tmTraceCall("bignSignWs", bignSignStep(sig, st->params,
+		(const ec_o*)st->ec, oid_der, oid_len, hash, privkey, rng, rng_state,
+		0, ws));
+}
+
+err_t bignSignCtx(octet sig[], const void* ctx, const octet oid_der[],
+	size_t oid_len, const octet hash[], const octet privkey[], gen_i rng, 
+	void* rng_state)
+{
+	err_t code;
+	void* ws;
+	// проверить ctx
+	if (!bignCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// создать рабочую память
+	ws = stackCreate(bignWs_keep(ctx));
+	if (ws == 0)
+		return ERR_OUTOFMEMORY;
+	// выработать подпись
+	code = bignSignWs(sig, ctx, ws, oid_der, oid_len, hash, privkey, rng,
+		rng_state);
+	// завершение
+	stackClose(ws);
+	return code;
+}
+
+err_t bignSignEph(octet sig[], void* eph, const octet oid_der[],
+	size_t oid_len, const octet hash[], const octet privkey[])
+{
+	err_t code;
+	const bign_ctx_st* st;
+	void* stack;
+	// проверить eph
+	if (!bignEphIsOperable(eph))
+		return ERR_BAD_INPUT;
+	st = (const bign_ctx_st*)bignEphCtx(eph);
+	// проверить oid_der
+	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
+		return ERR_BAD_OID;
+	// создать стек
+	stack = stackCreate(bignCtxStack_keep(st, bignSign_deep));
+	if (stack == 0)
+		return ERR_OUTOFMEMORY;
+	// выработать подпись
+	code = tmTraceCall("bignSignEph", bignSignStep(sig, st->params,
+		(const ec_o*)st->ec, oid_der, oid_len, hash, privkey, 0, 0, eph,
+		stack));
+	// завершение
+	stackClose(stack);
+	return code;
+}
+
+size_t bignSign2_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return O_OF_W(n) + beltHash_keep() + beltWBL_keep() +
+		utilMax(2,
+			beltHash_keep() + 32,
+			O_OF_W(4 * n) +
+				utilMax(3,
+					bignMulBase_deep(n, ec_d, ec_deep),
+					zzMul_deep(n / 2, n),
+					bignModQ_deep(n)));
+}
+
+/*
+	Подготовка к детерминированной выработке ЭЦП: в hash_state
+	сохраняется состояние belt-hash после обработки oid, в wbl -- состояние
+	beltWBL на ключе theta = belt-hash(oid || d || t).
+
+	\remark Ни hash_state, ни wbl не зависят от подписываемого
+	хэш-значения.
+*/
+static void bignSign2Prep(void* hash_state, void* wbl, const octet oid_der[],
+	size_t oid_len, const octet privkey[], size_t no, const void* t,
+	size_t t_len, void* stack)
+{
 	// хэшировать oid
 	beltHashStart(hash_state);
 	beltHashStepH(oid_der, oid_len, hash_state);
+	// theta <- belt-hash(oid || d || t)
+	memCopy(stack, hash_state, beltHash_keep());
+	beltHashStepH(privkey, no, stack);
+	if (t != 0)
+		beltHashStepH(t, t_len, stack);
+	beltHashStepG(stack, stack);
+	// инициализировать beltWBL ключом theta
+	beltWBLStart(wbl, stack, 32);
+	memWipe(stack, beltHash_keep());
+}
+
+/*
+	Детерминированная выработка ЭЦП по подготовленным состояниям
+	hash_state и wbl (см. bignSign2Prep()). Состояния изменяются.
+*/
+static err_t bignSign2Core(octet sig[], const bign_params* params,
+	const ec_o* ec, const octet hash[], const word d[], void* hash_state,
+	void* wbl, void* stack)
+{
+	const size_t no = ec->f->no;
+	const size_t n = ec->f->n;
+	// состояние (буферы могут пересекаться)
+	word* k;				/* [n] одноразовый личный ключ */
+	word* R;				/* [2n] точка R */
+	word* s0;				/* [n/2] первая часть подписи */
+	word* s1;				/* [n] вторая часть подписи */
+	ASSERT(n % 2 == 0);
+	// раскладка состояния
+	s1 = (word*)stack;
+	k = s1 + n;
+	R = k + n;
+	s0 = R + n + n / 2;
+	stack = R + 2 * n;
 	// сгенерировать k по алгоритму 6.3.3
+	// k <- H
+	memCopy(k, hash, no);
+	// k <- beltWBL(k, theta) пока k \notin {1,..., q - 1}
+	while (1)
 	{
-		// theta <- belt-hash(oid || d || t)
-		memCopy(stack, hash_state, beltHash_keep());
-		beltHashStepH(privkey, no, stack);
-		if (t != 0)
-			beltHashStepH(t, t_len, stack);
-		beltHashStepG(stack, stack);
-		// инициализировать beltWBL ключом theta
-		beltWBLStart(stack, stack, 32);
-		// k <- H
-		memCopy(k, hash, no);
-		// k <- beltWBL(k, theta) пока k \notin {1,..., q - 1}
-		while (1)
-		{
-			beltWBLStepE(k, no, stack);
-			wwFrom(k, k, no);
-			if (!wwIsZero(k, n) && wwCmp(k, ec->order, n) < 0)
-				break;
-			wwTo(k, no, k);
-		}
+		beltWBLStepE(k, no, wbl);
+		wwFrom(k, k, no);
+		if (!wwIsZero(k, n) && wwCmp(k, ec->order, n) < 0)
+			break;
+		wwTo(k, no, k);
 	}
 	// R <- k G
-	if (!ecMulA(R, ec->base, ec, k, n, stack))
-	{
-		blobClose(state);
+	if (!bignMulBase(R, params, ec, k, n, stack))
 		return ERR_BAD_PARAMS;
-	}
 	qrTo((octet*)R, ecX(R), ec->f, stack);
 	// s0 <- belt-hash(oid || R || H) mod 2^l
 	beltHashStepH(R, no, hash_state);
@@ -252,7 +302,7 @@ err_t bignSign2(octet sig[], const bign_params* params, const octet oid_der[],
 	zzMul(R, s0, n / 2, d, n, stack);
 	R[n + n / 2] = zzAdd(R + n / 2, R + n / 2, d, n);
 	// s1 <- R mod q
-	zzMod(s1, R, n + n / 2 + 1, ec->order, n, stack);
+	bignModQ(s1, R, n + n / 2 + 1, ec, stack);
 	// s1 <- (k - s1 - H) mod q
 	zzSubMod(s1, k, s1, ec->order, n);
 	wwFrom(k, hash, no);
@@ -260,39 +310,48 @@ err_t bignSign2(octet sig[], const bign_params* params, const octet oid_der[],
 	// выгрузить s1
 	wwTo(sig + no / 2, no, s1);
 	// все нормально
-	blobClose(state);
 	return ERR_OK;
 }
 
-/*
-*******************************************************************************
-Проверка ЭЦП
-*******************************************************************************
-*/
-
-static size_t bignVerify_deep(size_t n, size_t f_deep, size_t ec_d,
-	size_t ec_deep)
+static err_t bignSign2Step(octet sig[], const bign_params* params,
+	const ec_o* ec, const octet oid_der[], size_t oid_len,
+	const octet hash[], const octet privkey[], const void* t, size_t t_len,
+	void* stack)
 {
-	return O_OF_W(4 * n) +
-		utilMax(2,
-			beltHash_keep(),
-			ecAddMulA_deep(n, ec_d, ec_deep, 2, n, n / 2 + 1));
+	const size_t no = ec->f->no;
+	const size_t n = ec->f->n;
+	// состояние
+	word* d;				/* [n] личный ключ */
+	octet* hash_state;		/* [beltHash_keep] состояние хэширования */
+	octet* wbl;				/* [beltWBL_keep] состояние beltWBL */
+	// проверить входные указатели
+	if (!memIsValid(hash, no) ||
+		!memIsValid(privkey, no) ||
+		!memIsValid(sig, no + no / 2) ||
+		!memIsDisjoint2(hash, no, sig, no + no / 2))
+		return ERR_BAD_INPUT;
+	// раскладка состояния
+	d = (word*)stack;
+	hash_state = (octet*)(d + n);
+	wbl = hash_state + beltHash_keep();
+	stack = wbl + beltWBL_keep();
+	// загрузить d
+	wwFrom(d, privkey, no);
+	if (wwIsZero(d, n) || wwCmp(d, ec->order, n) >= 0)
+		return ERR_BAD_PRIVKEY;
+	// подготовить состояния и выработать подпись
+	bignSign2Prep(hash_state, wbl, oid_der, oid_len, privkey, no, t, t_len,
+		stack);
+	return bignSign2Core(sig, params, ec, hash, d, hash_state, wbl, stack);
 }
 
-err_t bignVerify(const bign_params* params, const octet oid_der[],
-	size_t oid_len, const octet hash[], const octet sig[], const octet pubkey[])
+err_t bignSign2(octet sig[], const bign_params* params, const octet oid_der[],
+	size_t oid_len, const octet hash[], const octet privkey[], const void* t, 
+	size_t t_len)
 {
 	err_t code;
-	size_t no, n;
-	// состояние (буферы могут пересекаться)
 	void* state;
-	ec_o* ec;			/* описание эллиптической кривой */	
-	word* Q;			/* [2n] открытый ключ */
-	word* R;			/* [2n] точка R */
-	word* H;			/* [n] хэш-значение */
-	word* s0;			/* [n / 2 + 1] первая часть подписи */
-	word* s1;			/* [n] вторая часть подписи */
-	octet* stack;
+	ec_o* ec;				/* описание эллиптической кривой */
 	// проверить params
 	if (!memIsValid(params, sizeof(bign_params)))
 		return ERR_BAD_INPUT;
@@ -301,71 +360,1085 @@ err_t bignVerify(const bign_params* params, const octet oid_der[],
 	// проверить oid_der
 	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
 		return ERR_BAD_OID;
+	// проверить t
+	if (!memIsNullOrValid(t, t_len))
+		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(bignStart_keep(params->l, bignVerify_deep));
+	state = stackCreate(bignStart_keep(params->l, bignSign2_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
+	tmTraceBegin("bignSign2");
 	code = bignStart(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, (tmTraceEnd("bignSign2"), stackClose(state)));
 	ec = (ec_o*)state;
-	// размерности
-	no  = ec->f->no;
-	n = ec->f->n;
-	ASSERT(n % 2 == 0);
-	// проверить входные указатели
-	if (!memIsValid(hash, no) ||
-		!memIsValid(sig, no + no / 2) ||
-		!memIsValid(pubkey, 2 * no))
-	{
-		blobClose(state);
+	// выработать подпись
+	code = bignSign2Step(sig, params, ec, oid_der, oid_len, hash, privkey,
+		t, t_len, objEnd(ec, void));
+	tmTraceEnd("bignSign2");
+	// завершение
+	stackClose(state);
+	return code;
+}
+
+err_t bignSign2Ws(octet sig[], const void* ctx, void* ws,
+	const octet oid_der[], size_t oid_len, const octet hash[],
+	const octet privkey[], const void* t, size_t t_len)
+{
+	const bign_ctx_st* st = (const bign_ctx_st*)ctx;
+	// проверить ctx и ws
+	if (!bignCtxIsOperable(ctx) || !memIsValid(ws, bignWs_keep(ctx)))
 		return ERR_BAD_INPUT;
-	}
-	// раскладка состояния
-	Q = R = objEnd(ec, word);
-	H = s0 = Q + 2 * n;
-	s1 = H + n;
-	stack = (octet*)(s1 + n);
-	// загрузить Q
-	if (!qrFrom(ecX(Q), pubkey, ec->f, stack) ||
-		!qrFrom(ecY(Q, n), pubkey + no, ec->f, stack))
-	{
-		blobClose(state);
-		return ERR_BAD_PUBKEY;
-	}
-	// загрузить и проверить s1
-	wwFrom(s1, sig + no / 2, no);
-	if (wwCmp(s1, ec->order, n) >= 0)
-	{
-		blobClose(state);
-		return ERR_BAD_SIG;
-	}
-	// s1 <- (s1 + H) mod q
-	wwFrom(H, hash, no);
-	if (wwCmp(H, ec->order, n) >= 0)
-	{
-		zzSub2(H, ec->order, n);
-		// 2^{l - 1} < q < 2^l, H < 2^l => H - q < q
-		ASSERT(wwCmp(H, ec->order, n) < 0);
-	}
-	zzAddMod(s1, s1, H, ec->order, n);
-	// загрузить s0
-	wwFrom(s0, sig, no / 2);
-	s0[n / 2] = 1;
-	// R <- s1 G + (s0 + 2^l) Q
-	if (!ecAddMulA(R, ec, stack, 2, ec->base, s1, n, Q, s0, n / 2 + 1))
-	{
-		blobClose(state);
-		return ERR_BAD_SIG;
-	}
-	qrTo((octet*)R, ecX(R), ec->f, stack);
-	// s0 == belt-hash(oid || R || H) mod 2^l?
-	beltHashStart(stack);
-	beltHashStepH(oid_der, oid_len, stack);
-	beltHashStepH(R, no, stack);
-	beltHashStepH(hash, no, stack);
-	code = beltHashStepV2(sig, no / 2, stack) ? ERR_OK : ERR_BAD_SIG;
+	// проверить oid_der
+	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
+		return ERR_BAD_OID;
+	// проверить t
+	if (!memIsNullOrValid(t, t_len))
+		return ERR_BAD_INPUT;
+	// выработать подпись
+	return tmTraceCall("bignSign2Ws", bignSign2Step(sig, st->params,
+		(const ec_o*)st->ec, oid_der, oid_len, hash, privkey, t, t_len, ws));
+}
+
+err_t bignSign2Ctx(octet sig[], const void* ctx, const octet oid_der[],
+	size_t oid_len, const octet hash[], const octet privkey[], const void* t, 
+	size_t t_len)
+{
+	err_t code;
+	void* ws;
+	// проверить ctx
+	if (!bignCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// создать рабочую память
+	ws = stackCreate(bignWs_keep(ctx));
+	if (ws == 0)
+		return ERR_OUTOFMEMORY;
+	// выработать подпись
+	code = bignSign2Ws(sig, ctx, ws, oid_der, oid_len, hash, privkey, t,
+		t_len);
 	// завершение
-	blobClose(state);
+	stackClose(ws);
 	return code;
 }
+
+/*
+*******************************************************************************
+Подготовленная детерминированная выработка ЭЦП
+
+В состоянии сохраняются личный ключ d, состояние belt-hash после обработки
+oid и состояние beltWBL на ключе theta. Состояние не изменяется: при
+выработке подписи обе части копируются в стек.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	const void* ctx;			/*< контекст bign */
+	word d[W_OF_B(512)];		/*< личный ключ */
+	octet data[];				/*< [beltHash_keep() + beltWBL_keep()] */
+} bign_det_st;
+
+static size_t bignSignDet_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return beltHash_keep() + beltWBL_keep() + O_OF_W(4 * n) +
+		utilMax(3,
+			bignMulBase_deep(n, ec_d, ec_deep),
+			zzMul_deep(n / 2, n),
+			bignModQ_deep(n));
+}
+
+size_t bignDet_keep()
+{
+	return sizeof(bign_det_st) + beltHash_keep() + beltWBL_keep();
+}
+
+err_t bignDetStart(void* det, const void* ctx, const octet oid_der[],
+	size_t oid_len, const octet privkey[], const void* t, size_t t_len)
+{
+	bign_det_st* st = (bign_det_st*)det;
+	const ec_o* ec;
+	void* stack;
+	// проверить ctx и det
+	if (!bignCtxIsOperable(ctx) || !memIsValid(det, bignDet_keep()))
+		return ERR_BAD_INPUT;
+	ec = (const ec_o*)((const bign_ctx_st*)ctx)->ec;
+	// проверить oid_der
+	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
+		return ERR_BAD_OID;
+	// проверить t и privkey
+	if (!memIsNullOrValid(t, t_len) || !memIsValid(privkey, ec->f->no))
+		return ERR_BAD_INPUT;
+	// загрузить d
+	wwFrom(st->d, privkey, ec->f->no);
+	if (wwIsZero(st->d, ec->f->n) || wwCmp(st->d, ec->order, ec->f->n) >= 0)
+		return ERR_BAD_PRIVKEY;
+	// подготовить состояния
+	stack = stackCreate(beltHash_keep() + 32);
+	if (stack == 0)
+		return ERR_OUTOFMEMORY;
+	bignSign2Prep(st->data, st->data + beltHash_keep(), oid_der, oid_len,
+		privkey, ec->f->no, t, t_len, stack);
+	stackClose(stack);
+	st->ctx = ctx;
+	return ERR_OK;
+}
+
+err_t bignSignDet(octet sig[], const void* det, const octet hash[])
+{
+	const bign_det_st* st = (const bign_det_st*)det;
+	const bign_ctx_st* bign;
+	const ec_o* ec;
+	err_t code;
+	octet* hash_state;
+	void* stack;
+	// проверить det
+	if (!memIsValid(det, bignDet_keep()) || !bignCtxIsOperable(st->ctx))
+		return ERR_BAD_INPUT;
+	bign = (const bign_ctx_st*)st->ctx;
+	ec = (const ec_o*)bign->ec;
+	// проверить входные указатели
+	if (!memIsValid(hash, ec->f->no) ||
+		!memIsValid(sig, ec->f->no + ec->f->no / 2) ||
+		!memIsDisjoint2(hash, ec->f->no, sig, ec->f->no + ec->f->no / 2))
+		return ERR_BAD_INPUT;
+	// создать стек
+	hash_state = (octet*)stackCreate(bignCtxStack_keep(bign,
+		bignSignDet_deep));
+	if (hash_state == 0)
+		return ERR_OUTOFMEMORY;
+	stack = hash_state + beltHash_keep() + beltWBL_keep();
+	// скопировать состояния
+	memCopy(hash_state, st->data, beltHash_keep() + beltWBL_keep());
+	// выработать подпись
+	code = tmTraceCall("bignSignDet", bignSign2Core(sig, bign->params, ec,
+		hash, st->d, hash_state, hash_state + beltHash_keep(), stack));
+	// завершение
+	stackClose(hash_state);
+	return code;
+}
+
+/*
+*******************************************************************************
+Пакетная выработка ЭЦП
+
+Подписи вырабатываются группами по BIGN_SIGN_BATCH. Для подписей группы:
+-	по порядку загружаются личные ключи и генерируются одноразовые ключи k_j
+	(генератор вызывается так же, как при последовательных вызовах
+	bignSignCtx());
+-	точки R_j = k_j G вычисляются в проективных координатах и переводятся
+	в аффинные одним вызовом ecToABatch(), т.е. с одним обращением
+	в базовом поле (метод Монтгомери) вместо BIGN_SIGN_BATCH обращений;
+-	хэш-значения belt-hash(oid || x(R_j) || H_j) вычисляются одновременно
+	в beltHashMB().
+
+Подписи, для которых загрузка завершилась ошибкой, заменяются фиктивными
+(k = 1), их результаты отбрасываются. Сообщения для хэширования
+размещаются в начале стека, их длина зависит от oid_len и поэтому
+учитывается отдельно от bignSignBatch_deep().
+*******************************************************************************
+*/
+
+#define BIGN_SIGN_BATCH 8
+
+static size_t bignSignBatch_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return O_OF_W(BIGN_SIGN_BATCH * 3 * n) + BIGN_SIGN_BATCH * 32 +
+		utilMax(3,
+			bignMulBaseBatch_deep(n, ec_d, ec_deep, BIGN_SIGN_BATCH),
+			f_deep,
+			O_OF_W(4 * n + 1) +
+				utilMax(2,
+					zzMul_deep(n / 2, n),
+					bignModQ_deep(n)));
+}
+
+static void bignSignBatchStep(err_t codes[], octet sigs[],
+	const bign_params* params, const ec_o* ec, const octet oid_der[],
+	size_t oid_len, size_t count, const octet hashes[],
+	const octet privkeys[], gen_i rng, void* rng_state, octet msgs[],
+	void* stack)
+{
+	const size_t no = ec->f->no;
+	const size_t n = ec->f->n;
+	const size_t len = oid_len + 2 * no;
+	const void* src[BIGN_SIGN_BATCH];
+	size_t lens[BIGN_SIGN_BATCH];
+	err_t code;
+	size_t j;
+	// состояние
+	word* k;			/* [8 * n] одноразовые личные ключи */
+	word* R;			/* [8 * 2n] точки R */
+	octet* h;			/* [8 * 32] хэш-значения */
+	word* d;			/* [n] личный ключ */
+	word* s0;			/* [n / 2] первая часть подписи */
+	word* s1;			/* [n] вторая часть подписи */
+	word* t;			/* [n + n / 2 + 1] произведение */
+	ASSERT(n % 2 == 0 && 0 < count && count <= BIGN_SIGN_BATCH);
+	// раскладка состояния
+	k = (word*)stack;
+	R = k + BIGN_SIGN_BATCH * n;
+	h = (octet*)(R + BIGN_SIGN_BATCH * 2 * n);
+	stack = h + BIGN_SIGN_BATCH * 32;
+	d = (word*)stack;
+	// загрузить личные ключи и сгенерировать одноразовые
+	for (j = 0; j < count; ++j)
+	{
+		word* k_j = k + j * n;
+		codes[j] = ERR_OK;
+		wwFrom(d, privkeys + j * no, no);
+		if (wwIsZero(d, n) || wwCmp(d, ec->order, n) >= 0)
+			codes[j] = ERR_BAD_PRIVKEY;
+		else if (!zzRandNZMod(k_j, ec->order, n, rng, rng_state))
+			codes[j] = ERR_BAD_RNG;
+		if (codes[j] != ERR_OK)
+			wwSetW(k_j, n, 1);
+	}
+	// R_j <- k_j G
+	code = bignMulBaseBatch(R, params, ec, k, n, count, stack) ?
+		ERR_OK : ERR_BAD_PARAMS;
+	// msg_j <- oid || x(R_j) || H_j
+	for (j = 0; code == ERR_OK && j < count; ++j)
+	{
+		octet* msg = msgs + j * len;
+		memCopy(msg, oid_der, oid_len);
+		qrTo(msg + oid_len, ecX(R + j * 2 * n), ec->f, stack);
+		memCopy(msg + oid_len + no, hashes + j * no, no);
+		src[j] = msg, lens[j] = len;
+	}
+	// h_j <- belt-hash(msg_j)
+	if (code == ERR_OK)
+		code = beltHashMB(h, src, lens, count);
+	// завершить подписи
+	s0 = d + n;
+	s1 = s0 + n / 2;
+	t = s1 + n;
+	stack = t + n + n / 2 + 1;
+	for (j = 0; j < count; ++j)
+	{
+		octet* sig = sigs + j * (no + no / 2);
+		if (codes[j] != ERR_OK)
+			continue;
+		if (code != ERR_OK)
+		{
+			codes[j] = code;
+			continue;
+		}
+		// s0 <- belt-hash(oid || R || H) mod 2^l
+		memCopy(sig, h + j * 32, no / 2);
+		wwFrom(s0, sig, no / 2);
+		// t <- (s0 + 2^l) d
+		wwFrom(d, privkeys + j * no, no);
+		zzMul(t, s0, n / 2, d, n, stack);
+		t[n + n / 2] = zzAdd(t + n / 2, t + n / 2, d, n);
+		// s1 <- t mod q
+		bignModQ(s1, t, n + n / 2 + 1, ec, stack);
+		// s1 <- (k - s1 - H) mod q
+		zzSubMod(s1, k + j * n, s1, ec->order, n);
+		wwFrom(t, hashes + j * no, no);
+		zzSubMod(s1, s1, t, ec->order, n);
+		// выгрузить s1
+		wwTo(sig + no / 2, no, s1);
+	}
+}
+
+err_t bignSignBatch(err_t codes[], octet sigs[], const void* ctx,
+	const octet oid_der[], size_t oid_len, size_t count,
+	const octet hashes[], const octet privkeys[], gen_i rng, void* rng_state)
+{
+	const bign_ctx_st* st = (const bign_ctx_st*)ctx;
+	const prov_o* prov;
+	const ec_o* ec;
+	err_t c[BIGN_SIGN_BATCH];
+	err_t code = ERR_OK;
+	size_t no, len, i, j, t;
+	octet* msgs;
+	void* stack;
+	// проверить ctx
+	if (!bignCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	ec = (const ec_o*)st->ec;
+	no = ec->f->no;
+	// проверить oid_der
+	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
+		return ERR_BAD_OID;
+	// проверить rng
+	if (rng == 0)
+		return ERR_BAD_RNG;
+	// проверить входные указатели
+	if (count > SIZE_MAX / (2 * no) ||
+		!memIsNullOrValid(codes, count * sizeof(err_t)) ||
+		!memIsValid(hashes, count * no) ||
+		!memIsValid(privkeys, count * no) ||
+		!memIsValid(sigs, count * (no + no / 2)) ||
+		!memIsDisjoint2(hashes, count * no, sigs, count * (no + no / 2)))
+		return ERR_BAD_INPUT;
+	if (count == 0)
+		return ERR_OK;
+	// передать провайдеру
+	prov = provActive();
+	if (prov && prov->sign_batch)
+	{
+		code = prov->sign_batch(codes, sigs, st->params, oid_der, oid_len,
+			count, hashes, privkeys, rng, rng_state, prov->state);
+		if (code != ERR_NOT_IMPLEMENTED)
+			return code;
+		code = ERR_OK;
+	}
+	// создать стек
+	len = O_OF_W(W_OF_O(BIGN_SIGN_BATCH * (oid_len + 2 * no)));
+	msgs = (octet*)stackCreate(len +
+		bignCtxStack_keep(ctx, bignSignBatch_deep));
+	if (msgs == 0)
+	{
+		for (i = 0; codes && i < count; ++i)
+			codes[i] = ERR_OUTOFMEMORY;
+		return ERR_OUTOFMEMORY;
+	}
+	stack = msgs + len;
+	// выработать подписи группами
+	tmTraceBegin("bignSignBatch");
+	for (i = 0; i < count; i += j)
+	{
+		j = MIN2(count - i, BIGN_SIGN_BATCH);
+		bignSignBatchStep(c, sigs + i * (no + no / 2), st->params, ec,
+			oid_der, oid_len, j, hashes + i * no, privkeys + i * no, rng,
+			rng_state, msgs, stack);
+		if (codes)
+			memCopy(codes + i, c, j * sizeof(err_t));
+		for (t = 0; code == ERR_OK && t < j; ++t)
+			code = c[t];
+	}
+	tmTraceEnd("bignSignBatch");
+	// завершение
+	stackClose(msgs);
+	return code;
+}
+
+/*
+*******************************************************************************
+Очередь выработки ЭЦП
+
+Запросы накапливаются в очереди: хэш-значения и личные ключи копируются,
+для подписей и кодов возврата сохраняются адреса. Очередь обрабатывается
+в bignSignBatch(), когда число запросов достигает max либо когда
+с момента постановки первого запроса прошло не менее delay тактов
+таймера tmTicks().
+*******************************************************************************
+*/
+
+typedef struct
+{
+	const void* ctx;			/*< контекст bign */
+	const octet* oid_der;		/*< идентификатор хэш-алгоритма */
+	size_t oid_len;				/*< длина oid_der */
+	gen_i rng;					/*< генератор случайных чисел */
+	void* rng_state;			/*< состояние генератора */
+	size_t max;					/*< максимальное число запросов */
+	tm_ticks_t delay;			/*< максимальная задержка (в тактах) */
+	tm_ticks_t since;			/*< время постановки первого запроса */
+	size_t count;				/*< число запросов */
+	octet** sig_ptrs;			/*< [max] адреса подписей */
+	err_t** code_ptrs;			/*< [max] адреса кодов возврата */
+	err_t* codes;				/*< [max] коды возврата */
+	octet* hashes;				/*< [max * no] хэш-значения */
+	octet* privkeys;			/*< [max * no] личные ключи */
+	octet* sigs;				/*< [max * (no + no / 2)] подписи */
+	word data[];				/*< память для массивов */
+} bign_sq_st;
+
+size_t bignSignQueue_keep(size_t l, size_t max)
+{
+	const size_t no = O_OF_B(2 * l);
+	ASSERT(l == 128 || l == 192 || l == 256);
+	return sizeof(bign_sq_st) + max * (sizeof(octet*) + sizeof(err_t*) +
+		sizeof(err_t) + 2 * no + no + no / 2);
+}
+
+err_t bignSignQueueStart(void* queue, const void* ctx,
+	const octet oid_der[], size_t oid_len, size_t max, size_t delay_ms,
+	gen_i rng, void* rng_state)
+{
+	bign_sq_st* st = (bign_sq_st*)queue;
+	size_t no;
+	// проверить входные данные
+	if (!bignCtxIsOperable(ctx) || max == 0)
+		return ERR_BAD_INPUT;
+	if (!memIsValid(queue,
+		bignSignQueue_keep(((const bign_ctx_st*)ctx)->params->l, max)))
+		return ERR_BAD_INPUT;
+	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
+		return ERR_BAD_OID;
+	if (rng == 0)
+		return ERR_BAD_RNG;
+	// настроить очередь
+	st->ctx = ctx;
+	st->oid_der = oid_der, st->oid_len = oid_len;
+	st->rng = rng, st->rng_state = rng_state;
+	st->max = max;
+	st->delay = (tm_ticks_t)(tmFreq() * (tm_ticks_t)delay_ms / 1000);
+	st->since = 0;
+	st->count = 0;
+	// разметить память
+	no = ((const ec_o*)((const bign_ctx_st*)ctx)->ec)->f->no;
+	st->sig_ptrs = (octet**)st->data;
+	st->code_ptrs = (err_t**)(st->sig_ptrs + max);
+	st->codes = (err_t*)(st->code_ptrs + max);
+	st->hashes = (octet*)(st->codes + max);
+	st->privkeys = st->hashes + max * no;
+	st->sigs = st->privkeys + max * no;
+	return ERR_OK;
+}
+
+err_t bignSignQueueFlush(void* queue)
+{
+	bign_sq_st* st = (bign_sq_st*)queue;
+	const size_t no = O_OF_B(2 * ((const bign_ctx_st*)st->ctx)->params->l);
+	err_t code;
+	size_t i;
+	ASSERT(memIsValid(queue, sizeof(bign_sq_st)));
+	if (st->count == 0)
+		return ERR_OK;
+	// обработать запросы
+	code = bignSignBatch(st->codes, st->sigs, st->ctx, st->oid_der,
+		st->oid_len, st->count, st->hashes, st->privkeys, st->rng,
+		st->rng_state);
+	// выдать результаты
+	for (i = 0; i < st->count; ++i)
+	{
+		if (st->codes[i] == ERR_OK)
+			memCopy(st->sig_ptrs[i], st->sigs + i * (no + no / 2),
+				no + no / 2);
+		if (st->code_ptrs[i])
+			*st->code_ptrs[i] = st->codes[i];
+	}
+	// очистить очередь
+	memWipe(st->privkeys, st->count * no);
+	st->count = 0;
+	return code;
+}
+
+err_t bignSignQueueAdd(void* queue, octet sig[], err_t* code,
+	const octet hash[], const octet privkey[])
+{
+	bign_sq_st* st = (bign_sq_st*)queue;
+	size_t no;
+	ASSERT(memIsValid(queue, sizeof(bign_sq_st)));
+	no = O_OF_B(2 * ((const bign_ctx_st*)st->ctx)->params->l);
+	// проверить входные данные
+	if (!memIsValid(hash, no) ||
+		!memIsValid(privkey, no) ||
+		!memIsValid(sig, no + no / 2) ||
+		!memIsNullOrValid(code, sizeof(err_t)))
+		return ERR_BAD_INPUT;
+	// поставить запрос в очередь
+	if (st->count == 0)
+		st->since = tmTicks();
+	memCopy(st->hashes + st->count * no, hash, no);
+	memCopy(st->privkeys + st->count * no, privkey, no);
+	st->sig_ptrs[st->count] = sig;
+	st->code_ptrs[st->count] = code;
+	++st->count;
+	// обработать очередь?
+	if (st->count == st->max || tmTicks() - st->since >= st->delay)
+		return bignSignQueueFlush(queue);
+	return ERR_OK;
+}
+
+err_t bignSignQueuePoll(void* queue)
+{
+	bign_sq_st* st = (bign_sq_st*)queue;
+	ASSERT(memIsValid(queue, sizeof(bign_sq_st)));
+	if (st->count && tmTicks() - st->since >= st->delay)
+		return bignSignQueueFlush(queue);
+	return ERR_OK;
+}
+
+size_t bignSignQueuePending(const void* queue)
+{
+	const bign_sq_st* st = (const bign_sq_st*)queue;
+	ASSERT(memIsValid(queue, sizeof(bign_sq_st)));
+	return st->count;
+}
+
+void bignSignQueueClose(void* queue)
+{
+	bign_sq_st* st = (bign_sq_st*)queue;
+	ASSERT(memIsValid(queue, sizeof(bign_sq_st)));
+	memWipe(st->privkeys, st->max *
+		O_OF_B(2 * ((const bign_ctx_st*)st->ctx)->params->l));
+	st->count = 0;
+}
+
+/*
+*******************************************************************************
+Проверка ЭЦП
+*******************************************************************************
+*/
+
+size_t bignVerify_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return O_OF_W(4 * n) +
+		utilMax(2,
+			beltHash_keep(),
+			bignAddMulPubkey_deep(n, f_deep, ec_d, ec_deep, n / 2 + 1));
+}
+
+static err_t bignVerifyLoad(word Q[], word s0[], word s1[], const ec_o* ec,
+	const octet hash[], const octet sig[], const octet pubkey[], void* stack)
+{
+	const size_t no = ec->f->no;
+	const size_t n = ec->f->n;
+	// состояние
+	word* H;			/* [n] хэш-значение */
+	// загрузить Q
+	if (!qrFrom(ecX(Q), pubkey, ec->f, stack) ||
+		!qrFrom(ecY(Q, n), pubkey + no, ec->f, stack))
+		return ERR_BAD_PUBKEY;
+	// загрузить и проверить s1 (открытые данные: ускоренные сравнения)
+	wwFrom(s1, sig + no / 2, no);
+	if (FAST(wwCmp)(s1, ec->order, n) >= 0)
+		return ERR_BAD_SIG;
+	// s1 <- (s1 + H) mod q
+	H = (word*)stack;
+	wwFrom(H, hash, no);
+	if (FAST(wwCmp)(H, ec->order, n) >= 0)
+	{
+		zzSub2(H, ec->order, n);
+		// 2^{l - 1} < q < 2^l, H < 2^l => H - q < q
+		ASSERT(FAST(wwCmp)(H, ec->order, n) < 0);
+	}
+	zzAddMod(s1, s1, H, ec->order, n);
+	// загрузить s0
+	wwFrom(s0, sig, no / 2);
+	s0[n / 2] = 1;
+	return ERR_OK;
+}
+
+static err_t bignVerifyHash(word R[], const ec_o* ec, const octet oid_der[],
+	size_t oid_len, const octet hash[], const octet sig[], void* stack)
+{
+	const size_t no = ec->f->no;
+	qrTo((octet*)R, ecX(R), ec->f, stack);
+	// s0 == belt-hash(oid || R || H) mod 2^l?
+	beltHashStart(stack);
+	beltHashStepH(oid_der, oid_len, stack);
+	beltHashStepH(R, no, stack);
+	beltHashStepH(hash, no, stack);
+	return beltHashStepV2(sig, no / 2, stack) ? ERR_OK : ERR_BAD_SIG;
+}
+
+static err_t bignVerifyStep(const bign_params* params, const ec_o* ec,
+	const octet oid_der[], size_t oid_len, const octet hash[],
+	const octet sig[], const octet pubkey[], void* stack)
+{
+	const size_t n = ec->f->n;
+	err_t code;
+	// состояние (буферы могут пересекаться)
+	word* Q;			/* [2n] открытый ключ */
+	word* R;			/* [2n] точка R */
+	word* s0;			/* [n / 2 + 1] первая часть подписи */
+	word* s1;			/* [n] вторая часть подписи */
+	// раскладка состояния
+	Q = R = (word*)stack;
+	s0 = Q + 2 * n;
+	s1 = s0 + n;
+	stack = s1 + n;
+	// загрузить Q, s0 и s1
+	code = bignVerifyLoad(Q, s0, s1, ec, hash, sig, pubkey, stack);
+	ERR_CALL_CHECK(code);
+	// R <- s1 G + (s0 + 2^l) Q
+	if (!bignAddMulPubkey(R, params, ec, s1, n, Q, pubkey, s0, n / 2 + 1,
+		stack))
+		return ERR_BAD_SIG;
+	return bignVerifyHash(R, ec, oid_der, oid_len, hash, sig, stack);
+}
+
+err_t bignVerify(const bign_params* params, const octet oid_der[],
+	size_t oid_len, const octet hash[], const octet sig[], const octet pubkey[])
+{
+	err_t code;
+	size_t no;
+	// состояние
+	void* state;
+	ec_o* ec;			/* описание эллиптической кривой */	
+	// проверить params
+	if (!memIsValid(params, sizeof(bign_params)))
+		return ERR_BAD_INPUT;
+	if (!bignIsOperable(params))
+		return ERR_BAD_PARAMS;
+	// проверить oid_der
+	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
+		return ERR_BAD_OID;
+	// создать состояние
+	state = stackCreate(bignStart_keep(params->l, bignVerify_deep));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// старт
+	tmTraceBegin("bignVerify");
+	code = bignStart(state, params);
+	ERR_CALL_HANDLE(code, (tmTraceEnd("bignVerify"), stackClose(state)));
+	ec = (ec_o*)state;
+	// размерности
+	no  = ec->f->no;
+	ASSERT(ec->f->n % 2 == 0);
+	// проверить входные указатели
+	if (!memIsValid(hash, no) ||
+		!memIsValid(sig, no + no / 2) ||
+		!memIsValid(pubkey, 2 * no))
+	{
+		tmTraceEnd("bignVerify");
+		stackClose(state);
+		return ERR_BAD_INPUT;
+	}
+	// проверить подпись
+	code = bignVerifyStep(params, ec, oid_der, oid_len, hash, sig, pubkey,
+		objEnd(ec, void));
+	tmTraceEnd("bignVerify");
+	// завершение
+	stackClose(state);
+	return code;
+}
+
+err_t bignVerifyWs(const void* ctx, void* ws, const octet oid_der[],
+	size_t oid_len, const octet hash[], const octet sig[],
+	const octet pubkey[])
+{
+	const bign_ctx_st* st = (const bign_ctx_st*)ctx;
+	const ec_o* ec;
+	size_t no;
+	// проверить ctx и ws
+	if (!bignCtxIsOperable(ctx) || !memIsValid(ws, bignWs_keep(ctx)))
+		return ERR_BAD_INPUT;
+	ec = (const ec_o*)st->ec;
+	// проверить oid_der
+	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
+		return ERR_BAD_OID;
+	// проверить входные указатели
+	no = ec->f->no;
+	if (!memIsValid(hash, no) ||
+		!memIsValid(sig, no + no / 2) ||
+		!memIsValid(pubkey, 2 * no))
+		return ERR_BAD_INPUT;
+	// проверить подпись
+	return tmTraceCall("bignVerifyWs", bignVerifyStep(st->params, ec, oid_der,
+		oid_len, hash, sig, pubkey, ws));
+}
+
+err_t bignVerifyCtx(const void* ctx, const octet oid_der[], size_t oid_len,
+	const octet hash[], const octet sig[], const octet pubkey[])
+{
+	err_t code;
+	void* ws;
+	// проверить ctx
+	if (!bignCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// создать рабочую память
+	ws = stackCreate(bignWs_keep(ctx));
+	if (ws == 0)
+		return ERR_OUTOFMEMORY;
+	// проверить подпись
+	code = bignVerifyWs(ctx, ws, oid_der, oid_len, hash, sig, pubkey);
+	// завершение
+	stackClose(ws);
+	return code;
+}
+
+/*
+*******************************************************************************
+Пакетная проверка ЭЦП
+
+Подпись bign содержит не точку R, а ее хэш-значение s0. Поэтому проверочные
+уравнения нескольких подписей нельзя объединить в одно (случайной линейной
+комбинацией), и каждая подпись проверяется отдельно. Экономия достигается
+за счет того, что описание кривой строится один раз, а для стандартных
+кривых кратные G вычисляются по заранее рассчитанной таблице.
+
+Кроме этого, подписи обрабатываются группами по 8: точки R восьми подписей
+вычисляются одновременно в bignAddMulBase8(). Подписи группы, для которых
+загрузка завершилась ошибкой, заменяются фиктивными (Q = G, s1 = 0), точки R
+подписей, не вычисленные в bignAddMulBase8(), пересчитываются
+в bignAddMulBase(). Затем подписи группы проверяются по порядку, так что
+номер первой некорректной подписи и код ошибки такие же, как при
+последовательной проверке. Остаток пакета (менее 8 подписей)
+проверяется последовательно.
+*******************************************************************************
+*/
+
+#define BIGN_BATCH 8
+
+static size_t bignVerifyBatch_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return utilMax(2,
+		bignVerify_deep(n, f_deep, ec_d, ec_deep),
+		O_OF_W(BIGN_BATCH * (5 * n + n / 2 + 1)) +
+			utilMax(4,
+				O_OF_W(n) + f_deep,
+				beltHash_keep(),
+				bignAddMulBase_deep(n, ec_d, ec_deep, n / 2 + 1),
+				bignAddMulBase8_deep(n, f_deep, n / 2 + 1)));
+}
+
+static err_t bignVerifyBatchStep(size_t* bad, const bign_params* params,
+	const ec_o* ec, const octet oid_der[], size_t oid_len,
+	const octet hashes[], const octet sigs[], const octet pubkeys[],
+	void* stack)
+{
+	const size_t no = ec->f->no;
+	const size_t n = ec->f->n;
+	err_t codes[BIGN_BATCH];
+	size_t mask, j;
+	// состояние
+	word* Q;			/* [8 * 2n] открытые ключи */
+	word* R;			/* [8 * 2n] точки R */
+	word* s0;			/* [8 * (n / 2 + 1)] первые части подписей */
+	word* s1;			/* [8 * n] вторые части подписей */
+	// раскладка состояния
+	Q = (word*)stack;
+	R = Q + BIGN_BATCH * 2 * n;
+	s0 = R + BIGN_BATCH * 2 * n;
+	s1 = s0 + BIGN_BATCH * (n / 2 + 1);
+	stack = s1 + BIGN_BATCH * n;
+	// загрузить подписи
+	for (j = 0; j < BIGN_BATCH; ++j)
+	{
+		word* s0_j = s0 + j * (n / 2 + 1);
+		codes[j] = bignVerifyLoad(Q + j * 2 * n, s0_j, s1 + j * n, ec,
+			hashes + j * no, sigs + j * (no + no / 2), pubkeys + j * 2 * no,
+			stack);
+		if (codes[j] != ERR_OK)
+		{
+			wwCopy(Q + j * 2 * n, ec->base, 2 * n);
+			wwSetZero(s0_j, n / 2), s0_j[n / 2] = 1;
+			wwSetZero(s1 + j * n, n);
+		}
+	}
+	// R_j <- s1_j G + (s0_j + 2^l) Q_j
+	mask = bignAddMulBase8(R, params, ec, s1, n, Q, s0, n / 2 + 1, stack);
+	// проверить подписи по порядку
+	for (j = 0; j < BIGN_BATCH; ++j)
+	{
+		if (codes[j] != ERR_OK)
+			break;
+		if (!(mask >> j & 1) &&
+			!bignAddMulBase(R + j * 2 * n, params, ec, s1 + j * n, n,
+				Q + j * 2 * n, s0 + j * (n / 2 + 1), n / 2 + 1, stack))
+		{
+			codes[j] = ERR_BAD_SIG;
+			break;
+		}
+		codes[j] = bignVerifyHash(R + j * 2 * n, ec, oid_der, oid_len,
+			hashes + j * no, sigs + j * (no + no / 2), stack);
+		if (codes[j] != ERR_OK)
+			break;
+	}
+	*bad = j;
+	return j < BIGN_BATCH ? codes[j] : ERR_OK;
+}
+
+err_t bignVerifyBatch(size_t* bad, const bign_params* params,
+	const octet oid_der[], size_t oid_len, size_t count, const octet hashes[],
+	const octet sigs[], const octet pubkeys[])
+{
+	err_t code = ERR_OK;
+	const prov_o* prov;
+	size_t no, i, j;
+	// состояние
+	void* state;
+	ec_o* ec;			/* описание эллиптической кривой */	
+	// проверить params
+	if (!memIsValid(params, sizeof(bign_params)))
+		return ERR_BAD_INPUT;
+	if (!bignIsOperable(params))
+		return ERR_BAD_PARAMS;
+	// проверить oid_der
+	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
+		return ERR_BAD_OID;
+	// проверить входные указатели
+	no = O_OF_B(2 * params->l);
+	if (!memIsNullOrValid(bad, sizeof(size_t)) ||
+		count > SIZE_MAX / (2 * no) ||
+		!memIsValid(hashes, count * no) ||
+		!memIsValid(sigs, count * (no + no / 2)) ||
+		!memIsValid(pubkeys, count * 2 * no))
+		return ERR_BAD_INPUT;
+	// передать провайдеру
+	prov = provActive();
+	if (prov && prov->verify_batch)
+	{
+		code = prov->verify_batch(bad, params, oid_der, oid_len, count,
+			hashes, sigs, pubkeys, prov->state);
+		if (code != ERR_NOT_IMPLEMENTED)
+			return code;
+		code = ERR_OK;
+	}
+	// создать состояние
+	state = stackCreate(bignStart_keep(params->l, bignVerifyBatch_deep));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// старт
+	tmTraceBegin("bignVerifyBatch");
+	code = bignStart(state, params);
+	ERR_CALL_HANDLE(code, (tmTraceEnd("bignVerifyBatch"), stackClose(state)));
+	ec = (ec_o*)state;
+	ASSERT(ec->f->no == no);
+	// проверить подписи группами
+	for (i = 0; count - i >= BIGN_BATCH; i += BIGN_BATCH)
+	{
+		code = bignVerifyBatchStep(&j, params, ec, oid_der, oid_len,
+			hashes + i * no, sigs + i * (no + no / 2), pubkeys + i * 2 * no,
+			objEnd(ec, void));
+		if (code != ERR_OK)
+		{
+			i += j;
+			break;
+		}
+	}
+	// проверить оставшиеся подписи
+	for (; code == ERR_OK && i < count; ++i)
+	{
+		code = bignVerifyStep(params, ec, oid_der, oid_len,
+			hashes + i * no, sigs + i * (no + no / 2), pubkeys + i * 2 * no,
+			objEnd(ec, void));
+		if (code != ERR_OK)
+			break;
+	}
+	if (bad)
+		*bad = i;
+	tmTraceEnd("bignVerifyBatch");
+	// завершение
+	stackClose(state);
+	return code;
+}
+
+/*
+*******************************************************************************
+Асинхронная обработка
+
+Пакет запросов проверки (выработки) ЭЦП разбивается на группы запросов
+с одинаковым идентификатором хэш-алгоритма. Данные запросов группы
+собираются в последовательные массивы и передаются bignVerifyBatch()
+(bignSignBatch()). После первой некорректной подписи проверка
+продолжается со следующей подписи группы.
+
+Запросы с некорректными буферами завершаются с кодом ERR_BAD_INPUT
+и в группы не попадают.
+*******************************************************************************
+*/
+
+static bool_t bignAsyncOidEq(const octet oid_der[], size_t oid_len,
+	const octet oid_der1[], size_t oid_len1)
+{
+	return oid_len == oid_len1 && memEq(oid_der, oid_der1, oid_len);
+}
+
+static void bignVerifyAsyncBatch(mt_req_t* const reqs[], size_t count,
+	void* scratch)
+{
+	const bign_params* params = ((bign_verify_req_t*)reqs[0])->params;
+	void* state;
+	octet* hashes;
+	octet* sigs;
+	octet* pubkeys;
+	size_t* idx;
+	octet* taken;
+	size_t no, i, j, m, k;
+	// проверить параметры
+	if (!memIsValid(params, sizeof(bign_params)))
+	{
+		for (i = 0; i < count; ++i)
+			reqs[i]->code = ERR_BAD_INPUT;
+		return;
+	}
+	if (params->l != 128 && params->l != 192 && params->l != 256)
+	{
+		for (i = 0; i < count; ++i)
+			reqs[i]->code = ERR_BAD_PARAMS;
+		return;
+	}
+	no = O_OF_B(2 * params->l);
+	// создать состояние
+	state = blobCreate(count * (O_PER_S + 1 + no + no + no / 2 + 2 * no));
+	if (state == 0)
+	{
+		for (i = 0; i < count; ++i)
+			reqs[i]->code = ERR_OUTOFMEMORY;
+		return;
+	}
+	idx = (size_t*)state;
+	hashes = (octet*)(idx + count);
+	sigs = hashes + count * no;
+	pubkeys = sigs + count * (no + no / 2);
+	taken = pubkeys + count * 2 * no;
+	// проверить запросы
+	for (i = 0; i < count; ++i)
+	{
+		const bign_verify_req_t* r = (const bign_verify_req_t*)reqs[i];
+		taken[i] = r->oid_len == SIZE_MAX ||
+			!memIsValid(r->oid_der, r->oid_len) ||
+			!memIsValid(r->hash, no) ||
+			!memIsValid(r->sig, no + no / 2) ||
+			!memIsValid(r->pubkey, 2 * no);
+		if (taken[i])
+			reqs[i]->code = ERR_BAD_INPUT;
+	}
+	// обработать группы с одинаковым идентификатором
+	for (i = 0; i < count; ++i)
+	{
+		const bign_verify_req_t* r0 = (const bign_verify_req_t*)reqs[i];
+		if (taken[i])
+			continue;
+		// собрать группу
+		for (j = i, m = 0; j < count; ++j)
+		{
+			const bign_verify_req_t* r = (const bign_verify_req_t*)reqs[j];
+			if (taken[j] ||
+				!bignAsyncOidEq(r->oid_der, r->oid_len, r0->oid_der,
+					r0->oid_len))
+				continue;
+			memCopy(hashes + m * no, r->hash, no);
+			memCopy(sigs + m * (no + no / 2), r->sig, no + no / 2);
+			memCopy(pubkeys + m * 2 * no, r->pubkey, 2 * no);
+			idx[m++] = j, taken[j] = TRUE;
+		}
+		// проверить подписи
+		for (k = 0; k < m;)
+		{
+			size_t bad = SIZE_MAX;
+			err_t code = bignVerifyBatch(&bad, params, r0->oid_der,
+				r0->oid_len, m - k, hashes + k * no, sigs + k * (no + no / 2),
+				pubkeys + k * 2 * no);
+			if (code == ERR_OK)
+			{
+				for (; k < m; ++k)
+					reqs[idx[k]]->code = ERR_OK;
+				break;
+			}
+			// ошибка входных данных: код распространяется на группу
+			if (bad == SIZE_MAX)
+			{
+				for (; k < m; ++k)
+					reqs[idx[k]]->code = code;
+				break;
+			}
+			for (j = 0; j < bad; ++j)
+				reqs[idx[k + j]]->code = ERR_OK;
+			reqs[idx[k + bad]]->code = code;
+			k += bad + 1;
+		}
+	}
+	// завершить
+	blobClose(state);
+}
+
+void bignVerifyAsync(mt_async_t* as, bign_verify_req_t* req)
+{
+	ASSERT(memIsValid(req, sizeof(bign_verify_req_t)));
+	req->req.batch = bignVerifyAsyncBatch;
+	req->req.key = req->params;
+	mtAsyncSubmit(as, &req->req);
+}
+
+static void bignSignAsyncBatch(mt_req_t* const reqs[], size_t count,
+	void* scratch)
+{
+	const void* ctx = ((bign_sign_req_t*)reqs[0])->ctx;
+	void* state;
+	err_t* codes;
+	size_t* idx;
+	octet* hashes;
+	octet* privkeys;
+	octet* sigs;
+	octet* taken;
+	size_t no, i, j, m;
+	// проверить контекст и генератор
+	if (!bignCtxIsOperable(ctx) || !rngIsValid())
+	{
+		err_t code = bignCtxIsOperable(ctx) ? ERR_BAD_RNG : ERR_BAD_INPUT;
+		for (i = 0; i < count; ++i)
+			reqs[i]->code = code;
+		return;
+	}
+	no = O_OF_B(2 * ((const bign_ctx_st*)ctx)->params->l);
+	// создать состояние
+	state = blobCreate(count * (O_PER_S + sizeof(err_t) + 1 + no + no +
+		no + no / 2));
+	if (state == 0)
+	{
+		for (i = 0; i < count; ++i)
+			reqs[i]->code = ERR_OUTOFMEMORY;
+		return;
+	}
+	idx = (size_t*)state;
+	codes = (err_t*)(idx + count);
+	hashes = (octet*)(codes + count);
+	privkeys = hashes + count * no;
+	sigs = privkeys + count * no;
+	taken = sigs + count * (no + no / 2);
+	// проверить запросы
+	for (i = 0; i < count; ++i)
+	{
+		const bign_sign_req_t* r = (const bign_sign_req_t*)reqs[i];
+		taken[i] = r->oid_len == SIZE_MAX ||
+			!memIsValid(r->oid_der, r->oid_len) ||
+			!memIsValid(r->hash, no) ||
+			!memIsValid(r->privkey, no) ||
+			!memIsValid(r->sig, no + no / 2);
+		if (taken[i])
+			reqs[i]->code = ERR_BAD_INPUT;
+	}
+	// обработать группы с одинаковым идентификатором
+	for (i = 0; i < count; ++i)
+	{
+		const bign_sign_req_t* r0 = (const bign_sign_req_t*)reqs[i];
+		err_t code;
+		if (taken[i])
+			continue;
+		// собрать группу
+		for (j = i, m = 0; j < count; ++j)
+		{
+			const bign_sign_req_t* r = (const bign_sign_req_t*)reqs[j];
+			if (taken[j] ||
+				!bignAsyncOidEq(r->oid_der, r->oid_len, r0->oid_der,
+					r0->oid_len))
+				continue;
+			memCopy(hashes + m * no, r->hash, no);
+			memCopy(privkeys + m * no, r->privkey, no);
+			codes[m] = ERR_OK;
+			idx[m++] = j, taken[j] = TRUE;
+		}
+		// выработать подписи
+		code = bignSignBatch(codes, sigs, ctx, r0->oid_der, r0->oid_len, m,
+			hashes, privkeys, rngStepR3, 0);
+		memWipe(privkeys, m * no);
+		// ошибка входных данных: коды подписей не установлены
+		if (code != ERR_OK)
+		{
+			for (j = 0; j < m && codes[j] == ERR_OK; ++j);
+			if (j == m)
+				for (j = 0; j < m; ++j)
+					codes[j] = code;
+		}
+		// выдать результаты
+		for (j = 0; j < m; ++j)
+		{
+			bign_sign_req_t* r = (bign_sign_req_t*)reqs[idx[j]];
+			r->req.code = codes[j];
+			if (codes[j] == ERR_OK)
+				memCopy(r->sig, sigs + j * (no + no / 2), no + no / 2);
+		}
+	}
+	// завершить
+	blobClose(state);
+}
+
+void bignSignAsync(mt_async_t* as, bign_sign_req_t* req)
+{
+	ASSERT(memIsValid(req, sizeof(bign_sign_req_t)));
+	req->req.batch = bignSignAsyncBatch;
+	req->req.key = req->ctx;
+	mtAsyncSubmit(as, &req->req);
+}
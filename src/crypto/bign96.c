@@ -4,17 +4,17 @@
 \brief Experimental Bign level 96 signatures
 \project bee2 [cryptographic library]
 \created 2021.01.20
-\version 2023.09.22
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
-#include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/der.h"
 #include "bee2/core/mem.h"
 #include "bee2/core/oid.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/str.h"
 #include "bee2/core/u32.h"
 #include "bee2/core/util.h"
@@ -242,12 +242,12 @@ err_t bign96ParamsVal(const bign_params* params)
 	if (params->l != 96)
 		return ERR_BAD_PARAMS;
 	// создать состояние
-	state = blobCreate(bign96Start_keep(bign96ParamsVal_deep));
+	state = stackCreate(bign96Start_keep(bign96ParamsVal_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bign96Start(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	n = ec->f->n;
@@ -298,7 +298,7 @@ err_t bign96ParamsVal(const bign_params* params)
 	else
 		code = ERR_BAD_PARAMS;
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
@@ -335,19 +335,19 @@ err_t bign96KeypairGen(octet privkey[24], octet pubkey[48],
 	if (rng == 0)
 		return ERR_BAD_RNG;
 	// создать состояние
-	state = blobCreate(bign96Start_keep(bign96KeypairGen_deep));
+	state = stackCreate(bign96Start_keep(bign96KeypairGen_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bign96Start(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	n = ec->f->n;
 	// проверить входные указатели
 	if (!memIsValid(privkey, 24) || !memIsValid(pubkey, 48))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -357,7 +357,7 @@ err_t bign96KeypairGen(octet privkey[24], octet pubkey[48],
 	// d <-R {1,2,..., q - 1}
 	if (!zzRandNZMod(d, ec->f->mod, n, rng, rng_state))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_RNG;
 	}
 	// Q <- d G
@@ -371,7 +371,7 @@ err_t bign96KeypairGen(octet privkey[24], octet pubkey[48],
 	else
 		code = ERR_BAD_PARAMS;
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
@@ -399,19 +399,19 @@ err_t bign96KeypairVal(const bign_params* params, const octet privkey[24],
 	if (params->l != 96)
 		return ERR_BAD_PARAMS;
 	// создать состояние
-	state = blobCreate(bign96Start_keep(bign96KeypairVal_deep));
+	state = stackCreate(bign96Start_keep(bign96KeypairVal_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bign96Start(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	n = ec->f->n;
 	// проверить входные указатели
 	if (!memIsValid(privkey, 24) || !memIsValid(pubkey, 48))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -424,7 +424,7 @@ err_t bign96KeypairVal(const bign_params* params, const octet privkey[24],
 	wwFrom(Q, params->q, 24);
 	if (wwIsZero(d, n) || wwCmp(d, Q, n) >= 0)
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PRIVKEY;
 	}
 	// Q <- d G
@@ -438,7 +438,7 @@ err_t bign96KeypairVal(const bign_params* params, const octet privkey[24],
 	else
 		code = ERR_BAD_PARAMS;
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
@@ -464,19 +464,19 @@ err_t bign96PubkeyVal(const bign_params* params, const octet pubkey[48])
 	if (params->l != 96)
 		return ERR_BAD_PARAMS;
 	// создать состояние
-	state = blobCreate(bign96Start_keep(bign96PubkeyVal_deep));
+	state = stackCreate(bign96Start_keep(bign96PubkeyVal_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bign96Start(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	n = ec->f->n;
 	// проверить входные указатели
 	if (!memIsValid(pubkey, 48))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -486,13 +486,13 @@ err_t bign96PubkeyVal(const bign_params* params, const octet pubkey[48])
 	if (!qrFrom(ecX(Q), pubkey, ec->f, stack) ||
 		!qrFrom(ecY(Q, n), pubkey + 24, ec->f, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PUBKEY;
 	}
 	// Q \in ec?
 	code = ecpIsOnA(Q, ec, stack) ? ERR_OK : ERR_BAD_PUBKEY;
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
@@ -520,19 +520,19 @@ err_t bign96PubkeyCalc(octet pubkey[48], const bign_params* params,
 	if (params->l != 96)
 		return ERR_BAD_PARAMS;
 	// создать состояние
-	state = blobCreate(bign96Start_keep(bign96PubkeyCalc_deep));
+	state = stackCreate(bign96Start_keep(bign96PubkeyCalc_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bign96Start(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	n = ec->f->n;
 	// проверить входные указатели
 	if (!memIsValid(privkey, 24) || !memIsValid(pubkey, 48))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -543,7 +543,7 @@ err_t bign96PubkeyCalc(octet pubkey[48], const bign_params* params,
 	wwFrom(d, privkey, 24);
 	if (wwIsZero(d, n) || wwCmp(d, ec->order, n) >= 0)
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PRIVKEY;
 	}
 	// Q <- d G
@@ -556,7 +556,7 @@ err_t bign96PubkeyCalc(octet pubkey[48], const bign_params* params,
 	else
 		code = ERR_BAD_PARAMS;
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
@@ -604,12 +604,12 @@ err_t bign96Sign(octet sig[34], const bign_params* params,
 	if (rng == 0)
 		return ERR_BAD_RNG;
 	// создать состояние
-	state = blobCreate(bign96Start_keep(bign96Sign_deep));
+	state = stackCreate(bign96Start_keep(bign96Sign_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bign96Start(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	n = ec->f->n;
@@ -619,7 +619,7 @@ err_t bign96Sign(octet sig[34], const bign_params* params,
 		!memIsValid(sig, 34) ||
 		!memIsDisjoint2(hash, 24, sig, 34))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -632,19 +632,19 @@ err_t bign96Sign(octet sig[34], const bign_params* params,
 	wwFrom(d, privkey, 24);
 	if (wwIsZero(d, n) || wwCmp(d, ec->order, n) >= 0)
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PRIVKEY;
 	}
 	// сгенерировать k с помощью rng
 	if (!zzRandNZMod(k, ec->order, n, rng, rng_state))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_RNG;
 	}
 	// R <- k G
 	if (!ecMulA(R, ec->base, ec, k, n, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	qrTo((octet*)R, ecX(R), ec->f, stack);
@@ -667,7 +667,7 @@ err_t bign96Sign(octet sig[34], const bign_params* params,
 	// выгрузить s1
 	wwTo(sig + 10, 24, s1);
 	// все нормально
-	blobClose(state);
+	stackClose(state);
 	return ERR_OK;
 }
 
@@ -714,12 +714,12 @@ err_t bign96Sign2(octet sig[34], const bign_params* params,
 	if (!memIsNullOrValid(t, t_len))
 		return ERR_BAD_INPUT;
 	// создать состояние
-	state = blobCreate(bign96Start_keep(bign96Sign2_deep));
+	state = stackCreate(bign96Start_keep(bign96Sign2_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bign96Start(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	n = ec->f->n;
@@ -729,7 +729,7 @@ err_t bign96Sign2(octet sig[34], const bign_params* params,
 		!memIsValid(sig, 34) ||
 		!memIsDisjoint2(hash, 24, sig, 34))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -743,7 +743,7 @@ err_t bign96Sign2(octet sig[34], const bign_params* params,
 	wwFrom(d, privkey, 24);
 	if (wwIsZero(d, n) || wwCmp(d, ec->order, n) >= 0)
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PRIVKEY;
 	}
 	// хэшировать oid
@@ -773,7 +773,7 @@ err_t bign96Sign2(octet sig[34], const bign_params* params,
 	// R <- k G
 	if (!ecMulA(R, ec->base, ec, k, n, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	qrTo((octet*)R, ecX(R), ec->f, stack);
@@ -794,7 +794,7 @@ err_t bign96Sign2(octet sig[34], const bign_params* params,
 	// выгрузить s1
 	wwTo(sig + 10, 24, s1);
 	// все нормально
-	blobClose(state);
+	stackClose(state);
 	return ERR_OK;
 }
 
@@ -837,12 +837,12 @@ err_t bign96Verify(const bign_params* params, const octet oid_der[],
 	if (oid_len == SIZE_MAX || oidFromDER(0, oid_der, oid_len)  == SIZE_MAX)
 		return ERR_BAD_OID;
 	// создать состояние
-	state = blobCreate(bign96Start_keep(bign96Verify_deep));
+	state = stackCreate(bign96Start_keep(bign96Verify_deep));
 	if (state == 0)
 		return ERR_OUTOFMEMORY;
 	// старт
 	code = bign96Start(state, params);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	ec = (ec_o*)state;
 	// размерности
 	n = ec->f->n;
@@ -851,7 +851,7 @@ err_t bign96Verify(const bign_params* params, const octet oid_der[],
 		!memIsValid(sig, 34) ||
 		!memIsValid(pubkey, 48))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_INPUT;
 	}
 	// раскладка состояния
@@ -863,14 +863,14 @@ err_t bign96Verify(const bign_params* params, const octet oid_der[],
 	if (!qrFrom(ecX(Q), pubkey, ec->f, stack) ||
 		!qrFrom(ecY(Q, n), pubkey + 24, ec->f, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PUBKEY;
 	}
 	// загрузить и проверить s1
 	wwFrom(s1, sig + 10, 24);
 	if (wwCmp(s1, ec->order, n) >= 0)
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_SIG;
 	}
 	// s1 <- (s1 + H) mod q
@@ -889,7 +889,7 @@ err_t bign96Verify(const bign_params* params, const octet oid_der[],
 	// R <- s1 G + (s0 + 2^l) Q
 	if (!ecAddMulA(R, ec, stack, 2, ec->base, s1, n, Q, s0, (size_t)W_OF_O(13)))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_SIG;
 	}
 	qrTo((octet*)R, ecX(R), ec->f, stack);
@@ -900,6 +900,6 @@ err_t bign96Verify(const bign_params* params, const octet oid_der[],
 	beltHashStepH(hash, 24, stack);
 	code = beltHashStepV2(sig, 10, stack) ? ERR_OK : ERR_BAD_SIG;
 	// завершение
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
@@ -4,7 +4,7 @@
 \brief STB 34.101.47/botp: OTP algorithms
 \project bee2 [cryptographic library]
 \created 2015.11.02
-\version 2020.03.24
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -23,6 +23,7 @@
 #include "bee2/math/zz.h"
 #include "bee2/crypto/belt.h"
 #include "bee2/crypto/botp.h"
+#include "belt/belt_lcl.h"
 
 /*
 *******************************************************************************
@@ -103,6 +104,130 @@ void botpCtrNext(octet ctr[8])
 	carry = 0;
 }
 
+/*
+*******************************************************************************
+Четверки паролей
+
+Функция botpOTPX4() строит пароли для четырех счетчиков на подготовленных
+ключах HMAC (см. belt_hmac_key_st). Счетчик занимает неполный блок, поэтому
+вычисление имитовставки HMAC сводится к четырем сжатиям: обработке
+блока ctr || 0 и блока длины во внутреннем хэшировании, обработке
+внутреннего хэш-значения и блока длины во внешнем хэшировании. Сжатия
+выполняются над четырьмя дорожками с помощью beltCompr2X4(). При сжатии
+блоков длины переменная s не используется и заменяется фиктивной.
+
+Функция botpKeyX4() подготавливает четыре ключа HMAC длины не более 32:
+блоки key ^ ipad и key ^ opad обрабатываются на дорожках beltCompr2X4().
+В дорожках с более длинными ключами обрабатываются нулевые ключи, длинные
+ключи затем подготавливаются отдельно с помощью beltHMACKeyPrepare().
+
+Дорожки и стек beltCompr2X4() размещаются в структуре botp_lanes_st.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	struct
+	{
+		u32 ls_in[8];	/*< блок [4]len || [4]s внутреннего хэширования */
+		u32 h_in[8];	/*< переменная h внутреннего хэширования */
+		u32 ls_out[8];	/*< блок [4]len || [4]s внешнего хэширования */
+		u32 h_out[8];	/*< переменная h внешнего хэширования */
+		u32 X[8];		/*< блок ctr || 0 (key ^ pad) */
+		u32 s[4];		/*< фиктивная переменная s */
+	} lanes[4];			/*< дорожки */
+	const belt_hmac_key_st* hkey[4];	/*< подготовленные ключи */
+	size_t digit[4];	/*< длины паролей */
+	octet ctr[4][8];	/*< счетчики */
+	char otp[4][10];	/*< пароли */
+	octet mac[32];		/*< имитовставка */
+	u32 stack[64];		/*< [beltCompr2X4_deep()] стек beltCompr2X4() */
+} botp_lanes_st;
+
+static void botpOTPX4(botp_lanes_st* st)
+{
+	u32* ss[4];
+	u32* h[4];
+	const u32* X[4];
+	size_t j;
+	ASSERT(sizeof(st->stack) >= beltCompr2X4_deep());
+	// ls_in <- len(key || ctr), h_in <- hk, X <- ctr || 0
+	for (j = 0; j < 4; ++j)
+	{
+		memCopy(st->lanes[j].ls_in, st->hkey[j]->ls_in, 32);
+		beltBlockAddBitSizeU32(st->lanes[j].ls_in, 8);
+		memCopy(st->lanes[j].h_in, st->hkey[j]->h_in, 32);
+		memCopy(st->lanes[j].ls_out, st->hkey[j]->ls_out, 32);
+		memCopy(st->lanes[j].h_out, st->hkey[j]->h_out, 32);
+		memSetZero(st->lanes[j].X, 32);
+		u32From(st->lanes[j].X, st->ctr[j], 8);
+		ss[j] = st->lanes[j].ls_in + 4;
+		h[j] = st->lanes[j].h_in, X[j] = st->lanes[j].X;
+	}
+	// обработать ctr || 0
+	beltCompr2X4(ss, h, X, st->stack);
+	// завершить внутреннее хэширование
+	for (j = 0; j < 4; ++j)
+		ss[j] = st->lanes[j].s, X[j] = st->lanes[j].ls_in;
+	beltCompr2X4(ss, h, X, st->stack);
+	// обработать внутреннее хэш-значение
+	for (j = 0; j < 4; ++j)
+	{
+		ss[j] = st->lanes[j].ls_out + 4;
+		h[j] = st->lanes[j].h_out, X[j] = st->lanes[j].h_in;
+	}
+	beltCompr2X4(ss, h, X, st->stack);
+	// завершить внешнее хэширование
+	for (j = 0; j < 4; ++j)
+		ss[j] = st->lanes[j].s, X[j] = st->lanes[j].ls_out;
+	beltCompr2X4(ss, h, X, st->stack);
+	// построить пароли
+	for (j = 0; j < 4; ++j)
+	{
+		u32To(st->mac, 32, st->lanes[j].h_out);
+		botpDT(st->otp[j], st->digit[j], st->mac, 32);
+	}
+}
+
+static void botpKeyX4(belt_hmac_key_st hk[4], const octet* const key[4],
+	const size_t key_len[4], botp_lanes_st* st)
+{
+	u32* ss[4];
+	u32* h[4];
+	const u32* X[4];
+	size_t j;
+	size_t i;
+	// X <- key ^ ipad
+	for (j = 0; j < 4; ++j)
+	{
+		memSetZero(st->lanes[j].X, 32);
+		if (key_len[j] <= 32)
+			u32From(st->lanes[j].X, key[j], key_len[j]);
+		for (i = 0; i < 8; ++i)
+			st->lanes[j].X[i] ^= 0x36363636;
+		beltBlockSetZero(hk[j].ls_in);
+		beltBlockAddBitSizeU32(hk[j].ls_in, 32);
+		beltBlockSetZero(hk[j].ls_in + 4);
+		u32From(hk[j].h_in, beltH(), 32);
+		ss[j] = hk[j].ls_in + 4, h[j] = hk[j].h_in, X[j] = st->lanes[j].X;
+	}
+	// начать внутреннее хэширование
+	beltCompr2X4(ss, h, X, st->stack);
+	// X <- key ^ opad [0x36 ^ 0x5C == 0x6A]
+	for (j = 0; j < 4; ++j)
+	{
+		for (i = 0; i < 8; ++i)
+			st->lanes[j].X[i] ^= 0x6A6A6A6A;
+		beltBlockSetZero(hk[j].ls_out);
+		beltBlockAddBitSizeU32(hk[j].ls_out, 32 * 2);
+		beltBlockSetZero(hk[j].ls_out + 4);
+		u32From(hk[j].h_out, beltH(), 32);
+		ss[j] = hk[j].ls_out + 4, h[j] = hk[j].h_out;
+	}
+	// начать внешнее хэширование
+	beltCompr2X4(ss, h, X, st->stack);
+}
+
 /*
 *******************************************************************************
 Режим HOTP
@@ -116,12 +241,12 @@ typedef struct
 	octet ctr1[8];		/*< копия счетчика */
 	octet mac[32];		/*< имитовставка */
 	char otp[10];		/*< текущий пароль */
-	octet stack[];		/*< [2 * beltHMAC_deep()] */
+	octet stack[];		/*< [beltHMAC_keep() + beltHMACKey_keep()] */
 } botp_hotp_st;
 
 size_t botpHOTP_keep()
 {
-	return sizeof(botp_hotp_st) + 2 * beltHMAC_keep();
+	return sizeof(botp_hotp_st) + beltHMAC_keep() + beltHMACKey_keep();
 }
 
 void botpHOTPStart(void* state, size_t digit, const octet key[], 
@@ -131,7 +256,8 @@ void botpHOTPStart(void* state, size_t digit, const octet key[],
 	ASSERT(6 <= digit && digit <= 8);
 	ASSERT(memIsDisjoint2(key, key_len, state, botpHOTP_keep()));
 	st->digit = digit;
-	beltHMACStart(st->stack + beltHMAC_keep(), key, key_len);
+	beltHMACStart(st->stack, key, key_len);
+	beltHMACKeyPrepare(st->stack + beltHMAC_keep(), st->stack);
 }
 
 void botpHOTPStepS(void* state, const octet ctr[8])
@@ -148,7 +274,7 @@ void botpHOTPStepR(char* otp, void* state)
 	ASSERT(memIsDisjoint2(otp, st->digit + 1, state, botpHOTP_keep()) || 
 		otp == st->otp);
 	// вычислить имитовставку
-	memCopy(st->stack, st->stack + beltHMAC_keep(), beltHMAC_keep());
+	beltHMACStartPrepared(st->stack, st->stack + beltHMAC_keep());
 	beltHMACStepA(st->ctr, 8, st->stack);
 	beltHMACStepG(st->mac, st->stack);
 	// построить пароль
@@ -174,6 +300,52 @@ bool_t botpHOTPStepV(const char* otp, void* state)
 	return FALSE;
 }
 
+bool_t botpHOTPStepW(size_t* offset, const char* otp, size_t window,
+	void* state)
+{
+	botp_hotp_st* st = (botp_hotp_st*)state;
+	botp_lanes_st lanes[1];
+	bool_t found = FALSE;
+	size_t i;
+	size_t j;
+	// pre
+	ASSERT(strIsValid(otp));
+	ASSERT(memIsDisjoint2(otp, strLen(otp) + 1, state, botpHOTP_keep()));
+	ASSERT(memIsNullOrValid(offset, O_PER_S));
+	// подготовить дорожки
+	for (j = 0; j < 4; ++j)
+	{
+		lanes->hkey[j] = (const belt_hmac_key_st*)(st->stack + beltHMAC_keep());
+		lanes->digit[j] = st->digit;
+	}
+	// цикл по четверкам счетчиков
+	memCopy(st->ctr1, st->ctr, 8);
+	for (i = 0; ; i += 4)
+	{
+		for (j = 0; j < 4; ++j)
+		{
+			memCopy(lanes->ctr[j], st->ctr1, 8);
+			botpCtrNext(st->ctr1);
+		}
+		botpOTPX4(lanes);
+		for (j = 0; j < 4 && j <= window - i; ++j)
+			if (strEq(lanes->otp[j], otp) && !found)
+			{
+				found = TRUE;
+				if (offset)
+					*offset = i + j;
+				memCopy(st->ctr, lanes->ctr[j], 8);
+			}
+		if (window - i < 4)
+			break;
+	}
+	// инкремент совпавшего счетчика
+	if (found)
+		botpCtrNext(st->ctr);
+	memWipe(lanes, sizeof(lanes));
+	return found;
+}
+
 void botpHOTPStepG(octet ctr[8], const void* state)
 {
 	const botp_hotp_st* st = (const botp_hotp_st*)state;
@@ -228,6 +400,32 @@ err_t botpHOTPVerify(const char* otp, const octet key[], size_t key_len,
 	return success ? ERR_OK : ERR_BAD_PWD;
 }
 
+err_t botpHOTPVerifyWindow(size_t* offset, const char* otp,
+	const octet key[], size_t key_len, octet ctr[8], size_t window)
+{
+	void* state;
+	bool_t success;
+	// проверить входные данные
+	if (!strIsValid(otp) || strLen(otp) < 6 || strLen(otp) > 8)
+		return ERR_BAD_PWD;
+	if (!memIsNullOrValid(offset, O_PER_S) ||
+		!memIsValid(key, key_len) || !memIsValid(ctr, 8))
+		return ERR_BAD_INPUT;
+	// создать состояние
+	state = blobCreate(botpHOTP_keep());
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// проверить пароль и синхронизировать счетчик
+	botpHOTPStart(state, strLen(otp), key, key_len);
+	botpHOTPStepS(state, ctr);
+	success = botpHOTPStepW(offset, otp, window, state);
+	if (success)
+		botpHOTPStepG(ctr, state);
+	// завершить
+	blobClose(state);
+	return success ? ERR_OK : ERR_BAD_PWD;
+}
+
 /*
 *******************************************************************************
 Режим TOTP
@@ -240,12 +438,12 @@ typedef struct
 	octet t[8];			/*< округленная отметка времени */
 	octet mac[32];		/*< имитовставка */
 	char otp[10];		/*< текущий пароль */
-	octet stack[];		/*< [2 * beltHMAC_deep()] */
+	octet stack[];		/*< [beltHMAC_keep() + beltHMACKey_keep()] */
 } botp_totp_st;
 
 size_t botpTOTP_keep()
 {
-	return sizeof(botp_totp_st) + 2 * beltHMAC_keep();
+	return sizeof(botp_totp_st) + beltHMAC_keep() + beltHMACKey_keep();
 }
 
 void botpTOTPStart(void* state, size_t digit, const octet key[], 
@@ -255,7 +453,8 @@ void botpTOTPStart(void* state, size_t digit, const octet key[],
 	ASSERT(6 <= digit && digit <= 8);
 	ASSERT(memIsDisjoint2(key, key_len, state, botpTOTP_keep()));
 	st->digit = digit;
-	beltHMACStart(st->stack + beltHMAC_keep(), key, key_len);
+	beltHMACStart(st->stack, key, key_len);
+	beltHMACKeyPrepare(st->stack + beltHMAC_keep(), st->stack);
 }
 
 void botpTOTPStepR(char* otp, tm_time_t t, void* state)
@@ -266,7 +465,7 @@ void botpTOTPStepR(char* otp, tm_time_t t, void* state)
 	ASSERT(memIsDisjoint2(otp, st->digit + 1, state, botpHOTP_keep()) || 
 		otp == st->otp);
 	// вычислить имитовставку
-	memCopy(st->stack, st->stack + beltHMAC_keep(), beltHMAC_keep());
+	beltHMACStartPrepared(st->stack, st->stack + beltHMAC_keep());
 	botpTimeToCtr(st->t, t);
 	beltHMACStepA(st->t, 8, st->stack);
 	beltHMACStepG(st->mac, st->stack);
@@ -286,6 +485,54 @@ bool_t botpTOTPStepV(const char* otp, tm_time_t t, void* state)
 	return strEq(st->otp, otp);
 }
 
+bool_t botpTOTPStepW(tm_time_t* t1, const char* otp, tm_time_t t,
+	size_t window, void* state)
+{
+	botp_totp_st* st = (botp_totp_st*)state;
+	botp_lanes_st lanes[1];
+	tm_time_t ts[4];
+	bool_t found = FALSE;
+	size_t i;
+	size_t j;
+	// pre
+	ASSERT(strIsValid(otp));
+	ASSERT(t != TIME_ERR);
+	ASSERT(window <= SIZE_MAX / 2 - 2);
+	ASSERT(memIsDisjoint2(otp, strLen(otp) + 1, state, botpTOTP_keep()));
+	ASSERT(memIsNullOrValid(t1, sizeof(tm_time_t)));
+	// подготовить дорожки
+	for (j = 0; j < 4; ++j)
+	{
+		lanes->hkey[j] = (const belt_hmac_key_st*)(st->stack + beltHMAC_keep());
+		lanes->digit[j] = st->digit;
+	}
+	// цикл по четверкам отметок: t, t - 1, t + 1, t - 2, t + 2,...
+	for (i = 0; i <= 2 * window; i += 4)
+	{
+		for (j = 0; j < 4; ++j)
+		{
+			size_t d = (i + j + 1) / 2;
+			if ((i + j) % 2 == 0)
+				ts[j] = t + (tm_time_t)d;
+			else if ((tm_time_t)d <= t)
+				ts[j] = t - (tm_time_t)d;
+			else
+				ts[j] = TIME_ERR;
+			botpTimeToCtr(lanes->ctr[j], ts[j] == TIME_ERR ? t : ts[j]);
+		}
+		botpOTPX4(lanes);
+		for (j = 0; j < 4 && i + j <= 2 * window; ++j)
+			if (strEq(lanes->otp[j], otp) && ts[j] != TIME_ERR && !found)
+			{
+				found = TRUE;
+				if (t1)
+					*t1 = ts[j];
+			}
+	}
+	memWipe(lanes, sizeof(lanes));
+	return found;
+}
+
 err_t botpTOTPRand(char* otp, size_t digit, const octet key[], size_t key_len, 
 	tm_time_t t)
 {
@@ -334,6 +581,222 @@ err_t botpTOTPVerify(const char* otp, const octet key[], size_t key_len,
 	return success ? ERR_OK : ERR_BAD_PWD;
 }
 
+err_t botpTOTPVerifyWindow(tm_time_t* t1, const char* otp,
+	const octet key[], size_t key_len, tm_time_t t, size_t window)
+{
+	void* state;
+	bool_t success;
+	// проверить входные данные
+	if (!strIsValid(otp) || strLen(otp) < 6 || strLen(otp) > 8)
+		return ERR_BAD_PWD;
+	if (t == TIME_ERR)
+		return ERR_BAD_TIME;
+	if (window > SIZE_MAX / 2 - 2)
+		return ERR_BAD_PARAMS;
+	if (!memIsNullOrValid(t1, sizeof(tm_time_t)) ||
+		!memIsValid(key, key_len))
+		return ERR_BAD_INPUT;
+	// создать состояние
+	state = blobCreate(botpTOTP_keep());
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// проверить пароль
+	botpTOTPStart(state, strLen(otp), key, key_len);
+	success = botpTOTPStepW(t1, otp, t, window, state);
+	// завершить
+	blobClose(state);
+	return success ? ERR_OK : ERR_BAD_PWD;
+}
+
+/*
+*******************************************************************************
+Пакетная проверка
+
+Элементы пакета обрабатываются четверками: ключи четверки подготавливаются
+с помощью botpKeyX4() (длинные ключи -- отдельно), пароли строятся
+с помощью botpOTPX4(). Неполная четверка дополняется копиями последнего
+элемента. Дорожки, подготовленные ключи и состояние HMAC размещаются
+в одном блобе, который создается для всего пакета.
+
+Пароль неверного формата, а также неверная отметка времени в режиме TOTP
+не считаются ошибками пакета: для соответствующего элемента возвращается
+признак FALSE. Чтобы сохранить регулярность, пароли для таких элементов
+строятся на фиктивных данных.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	botp_lanes_st lanes[1];		/*< дорожки */
+	belt_hmac_key_st hk[4];		/*< подготовленные ключи */
+	octet stack[];				/*< [beltHMAC_keep()] */
+} botp_batch_st;
+
+static err_t botpVerifyBatch(bool_t success[], size_t count,
+	const char* const otp[], const octet* const key[], const size_t key_len[],
+	octet ctr[][8], const tm_time_t t[])
+{
+	botp_batch_st* st;
+	const octet* keys[4];
+	size_t lens[4];
+	bool_t valid[4];
+	size_t i;
+	size_t j;
+	// проверить входные данные
+	if (count == 0)
+		return ERR_OK;
+	if (!memIsValid(success, count * sizeof(bool_t)) ||
+		!memIsValid(otp, count * sizeof(const char*)) ||
+		!memIsValid(key, count * sizeof(const octet*)) ||
+		!memIsValid(key_len, count * O_PER_S) ||
+		!memIsNullOrValid(ctr, count * 8) ||
+		!memIsNullOrValid(t, count * sizeof(tm_time_t)))
+		return ERR_BAD_INPUT;
+	for (i = 0; i < count; ++i)
+		if (!memIsValid(key[i], key_len[i]))
+			return ERR_BAD_INPUT;
+	// создать состояние
+	st = (botp_batch_st*)blobCreate(sizeof(botp_batch_st) + beltHMAC_keep());
+	if (st == 0)
+		return ERR_OUTOFMEMORY;
+	// цикл по четверкам
+	for (i = 0; i < count; i += 4)
+	{
+		// подготовить дорожки
+		for (j = 0; j < 4; ++j)
+		{
+			size_t k = MIN2(i + j, count - 1);
+			keys[j] = key[k], lens[j] = key_len[k];
+			valid[j] = strIsValid(otp[k]) &&
+				strLen(otp[k]) >= 6 && strLen(otp[k]) <= 8;
+			st->lanes->hkey[j] = st->hk + j;
+			st->lanes->digit[j] = valid[j] ? strLen(otp[k]) : 6;
+			if (ctr)
+				memCopy(st->lanes->ctr[j], ctr[k], 8);
+			else
+			{
+				valid[j] &= (t[k] != TIME_ERR);
+				botpTimeToCtr(st->lanes->ctr[j], t[k] != TIME_ERR ? t[k] : 0);
+			}
+		}
+		// подготовить ключи
+		botpKeyX4(st->hk, keys, lens, st->lanes);
+		for (j = 0; j < 4; ++j)
+			if (lens[j] > 32)
+			{
+				beltHMACStart(st->stack, keys[j], lens[j]);
+				beltHMACKeyPrepare(st->hk + j, st->stack);
+			}
+		// построить и проверить пароли
+		botpOTPX4(st->lanes);
+		for (j = 0; j < 4 && i + j < count; ++j)
+		{
+			success[i + j] = valid[j] && strEq(st->lanes->otp[j], otp[i + j]);
+			if (success[i + j] && ctr)
+				botpCtrNext(ctr[i + j]);
+		}
+	}
+	// завершить
+	blobClose(st);
+	return ERR_OK;
+}
+
+err_t botpHOTPVerifyBatch(bool_t success[], size_t count,
+	const char* const otp[], const octet* const key[], const size_t key_len[],
+	octet ctr[][8])
+{
+	if (count && !memIsValid(ctr, count * 8))
+		return ERR_BAD_INPUT;
+	return botpVerifyBatch(success, count, otp, key, key_len, ctr, 0);
+}
+
+err_t botpTOTPVerifyBatch(bool_t success[], size_t count,
+	const char* const otp[], const octet* const key[], const size_t key_len[],
+	const tm_time_t t[])
+{
+	if (count && !memIsValid(t, count * sizeof(tm_time_t)))
+		return ERR_BAD_INPUT;
+	return botpVerifyBatch(success, count, otp, key, key_len, 0, t);
+}
+
+/*
+*******************************************************************************
+Пакетная генерация
+
+Ключ HMAC подготавливается однократно и используется на всех дорожках.
+Пароли строятся с помощью botpOTPX4() для четверок последовательных
+счетчиков. Пароли неполной последней четверки строятся, но не выводятся.
+*******************************************************************************
+*/
+
+static err_t botpRandBatch(char* otps, size_t count, size_t digit,
+	const octet key[], size_t key_len, const octet ctr[8])
+{
+	botp_batch_st* st;
+	size_t i;
+	size_t j;
+	// проверить входные данные
+	if (digit < 6 || digit > 8)
+		return ERR_BAD_PARAMS;
+	if (count == 0)
+		return ERR_OK;
+	if (count > SIZE_MAX / (digit + 1) ||
+		!memIsValid(otps, count * (digit + 1)) ||
+		!memIsValid(key, key_len))
+		return ERR_BAD_INPUT;
+	// создать состояние
+	st = (botp_batch_st*)blobCreate(sizeof(botp_batch_st) + beltHMAC_keep());
+	if (st == 0)
+		return ERR_OUTOFMEMORY;
+	// подготовить ключ и дорожки
+	beltHMACStart(st->stack, key, key_len);
+	beltHMACKeyPrepare(st->hk, st->stack);
+	for (j = 0; j < 4; ++j)
+		st->lanes->hkey[j] = st->hk, st->lanes->digit[j] = digit;
+	memCopy(st->lanes->ctr[3], ctr, 8);
+	// цикл по четверкам
+	for (i = 0; i < count; i += 4)
+	{
+		// ctr[j] <- ctr + i + j
+		memCopy(st->lanes->ctr[0], st->lanes->ctr[3], 8);
+		if (i)
+			botpCtrNext(st->lanes->ctr[0]);
+		for (j = 1; j < 4; ++j)
+		{
+			memCopy(st->lanes->ctr[j], st->lanes->ctr[j - 1], 8);
+			botpCtrNext(st->lanes->ctr[j]);
+		}
+		// построить пароли
+		botpOTPX4(st->lanes);
+		for (j = 0; j < 4 && i + j < count; ++j)
+			memCopy(otps + (i + j) * (digit + 1), st->lanes->otp[j],
+				digit + 1);
+	}
+	// завершить
+	blobClose(st);
+	return ERR_OK;
+}
+
+err_t botpHOTPRandBatch(char* otps, size_t count, size_t digit,
+	const octet key[], size_t key_len, const octet ctr[8])
+{
+	if (!memIsValid(ctr, 8))
+		return ERR_BAD_INPUT;
+	return botpRandBatch(otps, count, digit, key, key_len, ctr);
+}
+
+err_t botpTOTPRandBatch(char* otps, size_t count, size_t digit,
+	const octet key[], size_t key_len, tm_time_t t)
+{
+	octet ctr[8];
+	if (digit < 6 || digit > 8)
+		return ERR_BAD_PARAMS;
+	if (t == TIME_ERR)
+		return ERR_BAD_TIME;
+	botpTimeToCtr(ctr, t);
+	return botpRandBatch(otps, count, digit, key, key_len, ctr);
+}
+
 /*
 *******************************************************************************
 Режим OCRA
@@ -371,139 +834,180 @@ static const char ocra_sha1[] = "SHA1";
 static const char ocra_sha256[] = "SHA256";
 static const char ocra_sha512[] = "SHA512";
 
-bool_t botpOCRAStart(void* state, const char* suite, const octet key[], 
-	size_t key_len)
+bool_t botpOCRASuiteParse(botp_ocra_suite_t* suite, const char* str)
 {
-	botp_ocra_st* st = (botp_ocra_st*)state;
-	const char* suite_save = suite;
+	const char* str_save = str;
 	// pre
-	ASSERT(strIsValid(suite));
-	ASSERT(memIsDisjoint2(suite, strLen(suite) + 1, state, botpOCRA_keep()));
-	ASSERT(memIsDisjoint2(key, key_len, state, botpOCRA_keep()));
-	// подготовить state
-	memSetZero(st, botpOCRA_keep());
-	// разбор suite: префикс
-	if (!strStartsWith(suite, ocra_prefix))
+	ASSERT(memIsValid(suite, sizeof(botp_ocra_suite_t)));
+	ASSERT(strIsValid(str));
+	// подготовить suite
+	memSetZero(suite, sizeof(botp_ocra_suite_t));
+	if (strLen(str) >= sizeof(suite->str))
+		return FALSE;
+	// разбор: префикс
+	if (!strStartsWith(str, ocra_prefix))
 		return FALSE;
-	suite += strLen(ocra_prefix);
-	if (!strStartsWith(suite, ocra_hbelt))
+	str += strLen(ocra_prefix);
+	if (!strStartsWith(str, ocra_hbelt))
 		return FALSE;
-	suite += strLen(ocra_hbelt);
-	if (*suite++ != '-')
+	str += strLen(ocra_hbelt);
+	if (*str++ != '-')
 		return FALSE;
-	// разбор suite: digit
-	if (*suite < '4' || *suite > '9')
+	// разбор: digit
+	if (*str < '4' || *str > '9')
 		return FALSE;
-	st->digit = (size_t)(*suite++ - '0');
-	// разбор suite: DataInput
-	if (*suite++ != ':')
+	suite->digit = (size_t)(*str++ - '0');
+	// разбор: DataInput
+	if (*str++ != ':')
 		return FALSE;
-	// разбор suite: ctr
-	if (*suite == 'C')
+	// разбор: ctr
+	if (*str == 'C')
 	{
-		if (*++suite != '-')
+		if (*++str != '-')
 			return FALSE;
-		++suite;
-		st->ctr_len = 8;
+		++str;
+		suite->ctr_len = 8;
 	}
-	// разбор suite: q
-	if (*suite++ != 'Q')
+	// разбор: q
+	if (*str++ != 'Q')
 		return FALSE;
-	switch (*suite)
+	switch (*str)
 	{
 	case 'A':
 	case 'N':
 	case 'H':
-		st->q_type = *suite++;
+		suite->q_type = *str++;
 		break;
 	default:
 		return FALSE;
 	}
-	if (suite[0] < '0' || suite[0] > '9' || suite[1] < '0' || suite[1] > '9')
+	if (str[0] < '0' || str[0] > '9' || str[1] < '0' || str[1] > '9')
 		return FALSE;
-	st->q_max = (size_t)(suite[0] - '0');
-	st->q_max *= 10, st->q_max += (size_t)(suite[1] - '0');
-	if (st->q_max < 4 || st->q_max > 64)
+	suite->q_max = (size_t)(str[0] - '0');
+	suite->q_max *= 10, suite->q_max += (size_t)(str[1] - '0');
+	if (suite->q_max < 4 || suite->q_max > 64)
 		return FALSE;
-	suite += 2;
-	// разбор suite: p
-	if (strStartsWith(suite, "-P"))
+	str += 2;
+	// разбор: p
+	if (strStartsWith(str, "-P"))
 	{
-		suite += 2;
-		if (strStartsWith(suite, ocra_hbelt))
+		str += 2;
+		if (strStartsWith(str, ocra_hbelt))
 		{
-			suite += strLen(ocra_hbelt);
-			st->p_len = 32;
+			str += strLen(ocra_hbelt);
+			suite->p_len = 32;
 		}
-		else if (strStartsWith(suite, ocra_sha1))
+		else if (strStartsWith(str, ocra_sha1))
 		{
-			suite += strLen(ocra_sha1);
-			st->p_len = 20;
+			str += strLen(ocra_sha1);
+			suite->p_len = 20;
 		}
-		else if (strStartsWith(suite, ocra_sha256))
+		else if (strStartsWith(str, ocra_sha256))
 		{
-			suite += strLen(ocra_sha256);
-			st->p_len = 32;
+			str += strLen(ocra_sha256);
+			suite->p_len = 32;
 		}
-		else if (strStartsWith(suite, ocra_sha512))
+		else if (strStartsWith(str, ocra_sha512))
 		{
-			suite += strLen(ocra_sha512);
-			st->p_len = 64;
+			str += strLen(ocra_sha512);
+			suite->p_len = 64;
 		}
 		else
 			return FALSE;
 	}
-	// разбор suite: s
-	if (strStartsWith(suite, "-S"))
+	// разбор: s
+	if (strStartsWith(str, "-S"))
 	{
-		suite += 2;
-		if (suite[0] < '0' || suite[0] > '9' || 
-			suite[1] < '0' || suite[1] > '9' ||
-			suite[2] < '0' || suite[2] > '9')
+		str += 2;
+		if (str[0] < '0' || str[0] > '9' || 
+			str[1] < '0' || str[1] > '9' ||
+			str[2] < '0' || str[2] > '9')
 			return FALSE;
-		st->s_len = (size_t)(suite[0] - '0');
-		st->s_len *= 10, st->s_len += (size_t)(suite[1] - '0');
-		st->s_len *= 10, st->s_len += (size_t)(suite[2] - '0');
-		if (st->s_len > 512)
+		suite->s_len = (size_t)(str[0] - '0');
+		suite->s_len *= 10, suite->s_len += (size_t)(str[1] - '0');
+		suite->s_len *= 10, suite->s_len += (size_t)(str[2] - '0');
+		if (suite->s_len > 512)
 			return FALSE;
-		suite += 3;
+		str += 3;
 	}
-	// разбор suite: t
-	if (strStartsWith(suite, "-T"))
+	// разбор: t
+	if (strStartsWith(str, "-T"))
 	{
-		suite += 2;
-		if (*suite < '1' || *suite > '9')
+		str += 2;
+		if (*str < '1' || *str > '9')
 			return FALSE;
-		st->ts = (size_t)(*suite++ - '0');
-		if (*suite >= '0' && *suite <= '9')
-			st->ts *= 10, st->ts += (size_t)(*suite++ - '0');
-		switch (*suite++)
+		suite->ts = (size_t)(*str++ - '0');
+		if (*str >= '0' && *str <= '9')
+			suite->ts *= 10, suite->ts += (size_t)(*str++ - '0');
+		switch (*str++)
 		{
 		case 'S':
-			if (st->ts > 59)
+			if (suite->ts > 59)
 				return FALSE;
 			break;
 		case 'M':
-			if (st->ts > 59)
+			if (suite->ts > 59)
 				return FALSE;
-			st->ts *= 60;
+			suite->ts *= 60;
 			break;
 		case 'H':
-			if (st->ts > 48)
+			if (suite->ts > 48)
 				return FALSE;
-			st->ts *= 3600;
+			suite->ts *= 3600;
 			break;
 		default:
 			return FALSE;
 		}
 	}
-	// разбор suite: окончание
-	if (*suite)
+	// разбор: окончание
+	if (*str)
 		return FALSE;
+	// сохранить описатель
+	strCopy(suite->str, str_save);
+	return TRUE;
+}
+
+void botpOCRAStart2(void* state, const botp_ocra_suite_t* suite,
+	const octet key[], size_t key_len)
+{
+	botp_ocra_st* st = (botp_ocra_st*)state;
+	// pre
+	ASSERT(memIsValid(suite, sizeof(botp_ocra_suite_t)));
+	ASSERT(strIsValid(suite->str) && strLen(suite->str) > 0);
+	ASSERT(memIsDisjoint2(suite, sizeof(botp_ocra_suite_t), state,
+		botpOCRA_keep()));
+	ASSERT(memIsDisjoint2(key, key_len, state, botpOCRA_keep()));
+	// подготовить state
+	memSetZero(st, botpOCRA_keep());
+	st->digit = suite->digit;
+	st->ctr_len = suite->ctr_len;
+	st->q_type = suite->q_type;
+	st->q_max = suite->q_max;
+	st->p_len = suite->p_len;
+	st->s_len = suite->s_len;
+	st->ts = suite->ts;
 	// запуск HMAC 
 	beltHMACStart(st->stack + beltHMAC_keep(), key, key_len);
-	beltHMACStepA(suite_save, strLen(suite_save) + 1,
+	beltHMACStepA(suite->str, strLen(suite->str) + 1,
 		st->stack + beltHMAC_keep());
+}
+
+bool_t botpOCRAStart(void* state, const char* suite, const octet key[], 
+	size_t key_len)
+{
+	botp_ocra_suite_t s[1];
+	// pre
+	ASSERT(strIsValid(suite));
+	ASSERT(memIsDisjoint2(suite, strLen(suite) + 1, state, botpOCRA_keep()));
+	ASSERT(memIsDisjoint2(key, key_len, state, botpOCRA_keep()));
+	// разобрать описатель
+	if (!botpOCRASuiteParse(s, suite))
+	{
+		memSetZero(state, botpOCRA_keep());
+		return FALSE;
+	}
+	// запустить механизм
+	botpOCRAStart2(state, s, key, key_len);
 	return TRUE;
 }
 
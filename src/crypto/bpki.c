@@ -4,17 +4,19 @@
 \brief STB 34.101.78 (bpki): PKI helpers
 \project bee2 [cryptographic library]
 \created 2021.04.03
-\version 2023.12.19
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
-#include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/der.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
 #include "bee2/core/rng.h"
+#include "bee2/core/stack.h"
+#include "bee2/core/tm.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/belt.h"
 #include "bee2/crypto/bign.h"
@@ -307,31 +309,242 @@ static size_t bpkiEdataDec(octet edata[], size_t* edata_len, octet salt[8],
 
 /*
 *******************************************************************************
-Контейнер с личным ключом
+Кэш ключей защиты
+
+Элемент кэша содержит ключ защиты key, построенный с помощью PBKDF2,
+время его размещения t и идентификатор id, вычисленный как
+	belt-hash(salt || iter || pwd).
+Число итераций iter хешируется в представлении size_t. Идентификатор
+не покидает процесс, поэтому переносимость представления не требуется.
+
+Элементы с истекшим временем жизни очищаются при каждом обращении к кэшу.
+Если свободных элементов нет, то новый ключ замещает самый старый.
 *******************************************************************************
 */
 
-err_t bpkiPrivkeyWrap(octet epki[], size_t* epki_len, const octet privkey[],
-	size_t privkey_len, const octet pwd[], size_t pwd_len,
-	const octet salt[8], size_t iter)
+typedef struct
 {
-	size_t pki_len, edata_len, count;
-	octet* key;
-	err_t code;
+	octet id[32];				/*< идентификатор */
+	octet key[32];				/*< ключ защиты */
+	tm_time_t t;				/*< время размещения */
+	size_t used;				/*< элемент занят? */
+} bpki_kek_entry;
+
+typedef struct
+{
+	mt_mtx_t mtx;				/*< мьютекс */
+	size_t count;				/*< число элементов */
+	tm_time_t ttl;				/*< время жизни ключей */
+	bpki_kek_entry entries[];	/*< элементы */
+} bpki_kek_cache_st;
+
+size_t bpkiKEKCache_keep(size_t count)
+{
+	return sizeof(bpki_kek_cache_st) + count * sizeof(bpki_kek_entry);
+}
+
+err_t bpkiKEKCacheStart(void* cache, size_t count, size_t ttl)
+{
+	bpki_kek_cache_st* st = (bpki_kek_cache_st*)cache;
 	// проверить входные данные
+	if (count == 0 || ttl == 0 ||
+		!memIsValid(cache, bpkiKEKCache_keep(count)))
+		return ERR_BAD_INPUT;
+	// создать мьютекс
+	if (!mtMtxCreate(&st->mtx))
+		return ERR_OUTOFMEMORY;
+	// настроить кэш
+	st->count = count;
+	st->ttl = (tm_time_t)ttl;
+	memSetZero(st->entries, count * sizeof(bpki_kek_entry));
+	return ERR_OK;
+}
+
+void bpkiKEKCacheClose(void* cache)
+{
+	bpki_kek_cache_st* st = (bpki_kek_cache_st*)cache;
+	ASSERT(memIsValid(cache, sizeof(bpki_kek_cache_st)));
+	mtMtxClose(&st->mtx);
+	memWipe(st->entries, st->count * sizeof(bpki_kek_entry));
+}
+
+/*
+	Очистка элементов с истекшим временем жизни.
+	\pre Мьютекс кэша заблокирован.
+*/
+static void bpkiKEKCachePurge(bpki_kek_cache_st* st, tm_time_t now)
+{
+	size_t i;
+	for (i = 0; i < st->count; ++i)
+		if (st->entries[i].used &&
+			(now == TIME_ERR || now < st->entries[i].t ||
+				now - st->entries[i].t >= st->ttl))
+			memWipe(st->entries + i, sizeof(bpki_kek_entry));
+}
+
+static bool_t bpkiKEKCacheGet(octet key[32], void* cache, const octet id[32])
+{
+	bpki_kek_cache_st* st = (bpki_kek_cache_st*)cache;
+	bool_t found = FALSE;
+	size_t i;
+	mtMtxLock(&st->mtx);
+	bpkiKEKCachePurge(st, tmTime());
+	for (i = 0; i < st->count; ++i)
+		if (st->entries[i].used && memEq(st->entries[i].id, id, 32))
+		{
+			memCopy(key, st->entries[i].key, 32);
+			found = TRUE;
+			break;
+		}
+	mtMtxUnlock(&st->mtx);
+	return found;
+}
+
+static void bpkiKEKCachePut(void* cache, const octet id[32],
+	const octet key[32])
+{
+	bpki_kek_cache_st* st = (bpki_kek_cache_st*)cache;
+	tm_time_t now = tmTime();
+	size_t i, pos;
+	if (now == TIME_ERR)
+		return;
+	mtMtxLock(&st->mtx);
+	bpkiKEKCachePurge(st, now);
+	// найти свободный или самый старый элемент
+	for (i = pos = 0; i < st->count; ++i)
+	{
+		if (!st->entries[i].used)
+		{
+			pos = i;
+			break;
+		}
+		if (st->entries[i].t < st->entries[pos].t)
+			pos = i;
+	}
+	// разместить ключ
+	memCopy(st->entries[pos].id, id, 32);
+	memCopy(st->entries[pos].key, key, 32);
+	st->entries[pos].t = now;
+	st->entries[pos].used = 1;
+	mtMtxUnlock(&st->mtx);
+}
+
+/*
+*******************************************************************************
+Снятие защиты с edata
+
+Ключ защиты строится с помощью PBKDF2 или (при наличии cache) берется
+из кэша. Ключ, построенный с помощью PBKDF2, размещается в кэше только
+после успешного снятия защиты, т.е. после подтверждения пароля.
+*******************************************************************************
+*/
+
+static err_t bpkiEdataUnwrap(octet edata[], size_t edata_len,
+	const octet salt[8], size_t iter, const octet pwd[], size_t pwd_len,
+	void* cache)
+{
+	err_t code;
+	bool_t hit = FALSE;
+	void* state;
+	octet* key;
+	octet* id;
+	void* hash_state;
+	// создать состояние
+	state = stackCreate(32 + 32 + beltHash_keep());
+	if (!state)
+		return ERR_OUTOFMEMORY;
+	key = (octet*)state;
+	id = key + 32;
+	hash_state = id + 32;
+	// найти ключ защиты в кэше
+	if (cache)
+	{
+		beltHashStart(hash_state);
+		beltHashStepH(salt, 8, hash_state);
+		beltHashStepH(&iter, sizeof(iter), hash_state);
+		beltHashStepH(pwd, pwd_len, hash_state);
+		beltHashStepG(id, hash_state);
+		hit = bpkiKEKCacheGet(key, cache, id);
+	}
+	// построить ключ защиты
+	if (!hit)
+	{
+		code = beltPBKDF2(key, pwd, pwd_len, iter, salt, 8);
+		ERR_CALL_HANDLE(code, stackClose(state));
+	}
+	// снять защиту
+	code = beltKWPUnwrap(edata, edata, edata_len, 0, key, 32);
+	// сохранить ключ в кэше
+	if (code == ERR_OK && cache && !hit)
+		bpkiKEKCachePut(cache, id, key);
+	// завершить
+	memWipe(key, 32);
+	stackClose(state);
+	return code;
+}
+
+/*
+*******************************************************************************
+Контейнер с личным ключом
+*******************************************************************************
+*/
+
+/*
+	Длины pki и epki для личного ключа длины privkey_len.
+*/
+static err_t bpkiPrivkeyWrapLen(size_t* pki_len, size_t* epki_len,
+	const octet privkey[], size_t privkey_len, size_t iter)
+{
 	if (iter < 10000)
 		return ERR_BAD_INPUT;
 	if (privkey_len != 32 && privkey_len != 24 && privkey_len != 48 && 
 		privkey_len != 64)
 		return ERR_BAD_PRIVKEY;
-	// определить длину epki
-	pki_len = bpkiPrivkeyEnc(0, privkey, privkey_len);
-	if (pki_len == SIZE_MAX)
+	*pki_len = bpkiPrivkeyEnc(0, privkey, privkey_len);
+	if (*pki_len == SIZE_MAX)
 		return ERR_BAD_FORMAT;
-	edata_len = pki_len + 16;
-	count = bpkiEdataEnc(0, 0, edata_len, 0, iter);
-	if (count == SIZE_MAX)
+	*epki_len = bpkiEdataEnc(0, 0, *pki_len + 16, 0, iter);
+	if (*epki_len == SIZE_MAX)
 		return ERR_BAD_FORMAT;
+	return ERR_OK;
+}
+
+/*
+	Создание контейнера [count]epki на ключе key, построенном по паролю.
+	Длина pki_len кода pki определена в bpkiPrivkeyWrapLen().
+*/
+static err_t bpkiPrivkeyWrapKey(octet epki[], size_t count, size_t pki_len,
+	const octet privkey[], size_t privkey_len, const octet key[32],
+	const octet salt[8], size_t iter)
+{
+	size_t edata_len = pki_len + 16;
+	err_t code;
+	// кодировать pki
+	code = bpkiPrivkeyEnc(epki + count - pki_len, privkey, privkey_len) ==
+		pki_len ? ERR_OK : ERR_BAD_PRIVKEY;
+	ERR_CALL_HANDLE(code, memWipe(epki, count));
+	// зашифровать pki
+	code = beltKWPWrap(epki + count - pki_len - 16,
+		epki + count - pki_len,	pki_len, 0, key, 32);
+	ERR_CALL_HANDLE(code, memWipe(epki, count));
+	// кодировать edata и epki
+	count = bpkiEdataEnc(epki, epki + count - edata_len, edata_len,
+		salt, iter);
+	code = count != SIZE_MAX ? ERR_OK : ERR_BAD_FORMAT;
+	ERR_CALL_HANDLE(code, memWipe(epki, count));
+	return ERR_OK;
+}
+
+err_t bpkiPrivkeyWrap(octet epki[], size_t* epki_len, const octet privkey[],
+	size_t privkey_len, const octet pwd[], size_t pwd_len,
+	const octet salt[8], size_t iter)
+{
+	size_t pki_len, count;
+	octet* key;
+	err_t code;
+	// определить длину epki
+	code = bpkiPrivkeyWrapLen(&pki_len, &count, privkey, privkey_len, iter);
+	ERR_CALL_CHECK(code);
 	if (epki_len)
 	{
 		if (!memIsValid(epki_len, O_PER_S))
@@ -347,106 +560,191 @@ err_t bpkiPrivkeyWrap(octet epki[], size_t* epki_len, const octet privkey[],
 		!memIsValid(salt, 8))
 		return ERR_BAD_INPUT;
 	// сгенерировать ключ
-	key = (octet*)blobCreate(32);
+	key = (octet*)stackCreate(32);
 	if (!key)
 		return ERR_OUTOFMEMORY;
 	code = beltPBKDF2(key, pwd, pwd_len, iter, salt, 8);
-	ERR_CALL_HANDLE(code, blobClose(key));
-	// кодировать pki
-	pki_len = bpkiPrivkeyEnc(epki + count - pki_len, privkey, privkey_len);
-	code = pki_len != SIZE_MAX ? ERR_OK : ERR_BAD_PRIVKEY;
-	ERR_CALL_HANDLE(code, (memWipe(epki, count), blobClose(key)));
-	// зашифровать pki
-	code = beltKWPWrap(epki + count - pki_len - 16,
-		epki + count - pki_len,	pki_len, 0, key, 32);
-	ERR_CALL_HANDLE(code, (memWipe(epki, count), blobClose(key)));
-	// кодировать edata и epki
-	count = bpkiEdataEnc(epki, epki + count - edata_len, edata_len,
-		salt, iter);
-	code = count != SIZE_MAX ? ERR_OK : ERR_BAD_FORMAT;
-	ERR_CALL_HANDLE(code, (memWipe(epki, count), blobClose(key)));
-	// все нормально
-	blobClose(key);
-	return ERR_OK;
+	ERR_CALL_HANDLE(code, stackClose(key));
+	// создать контейнер
+	code = bpkiPrivkeyWrapKey(epki, count, pki_len, privkey, privkey_len,
+		key, salt, iter);
+	stackClose(key);
+	return code;
 }
 
-err_t bpkiPrivkeyUnwrap(octet privkey[], size_t* privkey_len,
-	const octet epki[], size_t epki_len, const octet pwd[], size_t pwd_len)
+err_t bpkiPrivkeyWrapMB(octet epkis[], size_t* epki_len,
+	const octet privkeys[], size_t privkey_len, const octet pwd[],
+	size_t pwd_len, const octet salts[], size_t iter, size_t n)
+{
+	size_t pki_len, count, i;
+	octet* keys;
+	const octet** pwds;
+	const octet** salts_ptr;
+	size_t* lens;
+	size_t* salt_lens;
+	err_t code;
+	// определить длину epki
+	code = bpkiPrivkeyWrapLen(&pki_len, &count, privkeys, privkey_len, iter);
+	ERR_CALL_CHECK(code);
+	if (epki_len)
+	{
+		if (!memIsValid(epki_len, O_PER_S))
+			return ERR_BAD_INPUT;
+		*epki_len = count;
+	}
+	if (!epkis || n == 0)
+		return ERR_OK;
+	// проверить указатели
+	if (n > SIZE_MAX / count || n > SIZE_MAX / privkey_len ||
+		!memIsValid(privkeys, n * privkey_len) ||
+		!memIsValid(epkis, n * count) ||
+		!memIsValid(pwd, pwd_len) ||
+		!memIsValid(salts, 8 * n))
+		return ERR_BAD_INPUT;
+	// выделить и разметить память
+	keys = (octet*)stackCreate(n * (32 + 2 * sizeof(octet*) +
+		2 * sizeof(size_t)));
+	if (!keys)
+		return ERR_OUTOFMEMORY;
+	pwds = (const octet**)(keys + 32 * n);
+	salts_ptr = pwds + n;
+	lens = (size_t*)(salts_ptr + n);
+	salt_lens = lens + n;
+	for (i = 0; i < n; ++i)
+		pwds[i] = pwd, lens[i] = pwd_len,
+			salts_ptr[i] = salts + 8 * i, salt_lens[i] = 8;
+	// сгенерировать ключи (одновременно)
+	code = beltPBKDF2MB(keys, pwds, lens, iter, salts_ptr, salt_lens, n);
+	ERR_CALL_HANDLE(code, stackClose(keys));
+	// создать контейнеры
+	for (i = 0; code == ERR_OK && i < n; ++i)
+		code = bpkiPrivkeyWrapKey(epkis + i * count, count, pki_len,
+			privkeys + i * privkey_len, privkey_len, keys + 32 * i,
+			salts + 8 * i, iter);
+	if (code != ERR_OK)
+		memWipe(epkis, n * count);
+	memWipe(keys, 32 * n);
+	stackClose(keys);
+	return code;
+}
+
+err_t bpkiPrivkeyUnwrap2(octet privkey[], size_t* privkey_len,
+	const octet epki[], size_t epki_len, const octet pwd[], size_t pwd_len,
+	void* cache)
 {
 	size_t edata_len, pki_len, count, iter;
 	void* state;
 	octet* salt;
-	octet* key;
 	octet* edata;
 	err_t code;
 	// проверить входные данные
 	if (epki_len == SIZE_MAX || !memIsValid(epki, epki_len) ||
 		!memIsValid(pwd, pwd_len) ||
-		privkey_len && !memIsValid(privkey_len, O_PER_S))
+		privkey_len && !memIsValid(privkey_len, O_PER_S) ||
+		cache && !memIsValid(cache, sizeof(bpki_kek_cache_st)))
 		return ERR_BAD_INPUT;
 	// определить размер edata
 	count = bpkiEdataDec(0, &edata_len, 0, 0, epki, epki_len);
 	if (count != epki_len)
 		return ERR_BAD_FORMAT;
 	// подготовить буферы для параметров PBKDF2
-	state = blobCreate(8 + 32 + edata_len);
+	state = stackCreate(8 + edata_len);
 	if (!state)
 		return ERR_OUTOFMEMORY;
 	salt = (octet*)state;
-	key = salt + 8;
-	edata = key + 32;
+	edata = salt + 8;
 	// выделить edata
 	count = bpkiEdataDec(edata, 0, salt, &iter, epki, epki_len);
 	ASSERT(count == epki_len);
-	// построить ключ защиты 
-	code = beltPBKDF2(key, pwd, pwd_len, iter, salt, 8);
-	ERR_CALL_HANDLE(code, blobClose(state));
 	// снять защиту
-	code = beltKWPUnwrap(edata, edata, edata_len, 0, key, 32);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	code = bpkiEdataUnwrap(edata, edata_len, salt, iter, pwd, pwd_len,
+		cache);
+	ERR_CALL_HANDLE(code, stackClose(state));
 	pki_len = edata_len - 16;
 	// определить длину privkey
 	count = bpkiPrivkeyDec(privkey, &edata_len, edata, pki_len);
 	code = count == pki_len ? ERR_OK : ERR_BAD_FORMAT;
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	// проверить указатель share 
 	code = memIsNullOrValid(privkey, edata_len) ? ERR_OK : ERR_BAD_INPUT;
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	// декодировать pki
 	count = bpkiPrivkeyDec(privkey, privkey_len, edata, pki_len);
 	ASSERT(count == pki_len);
 	// завершить
-	blobClose(state);
+	stackClose(state);
 	return code;
 }
 
+err_t bpkiPrivkeyUnwrap(octet privkey[], size_t* privkey_len,
+	const octet epki[], size_t epki_len, const octet pwd[], size_t pwd_len)
+{
+	return bpkiPrivkeyUnwrap2(privkey, privkey_len, epki, epki_len,
+		pwd, pwd_len, 0);
+}
+
 /*
 *******************************************************************************
 Контейнер с частичным секретом
 *******************************************************************************
 */
 
-err_t bpkiShareWrap(octet epki[], size_t* epki_len, const octet share[],
-	size_t share_len, const octet pwd[], size_t pwd_len,
-	const octet salt[8], size_t iter)
+/*
+	Длины pki и epki для частичного секрета длины share_len.
+*/
+static err_t bpkiShareWrapLen(size_t* pki_len, size_t* epki_len,
+	const octet share[], size_t share_len, size_t iter)
 {
-	size_t pki_len, edata_len, count;
-	octet* key;
-	err_t code;
-	// проверить входные данные
 	if (iter < 10000)
 		return ERR_BAD_INPUT;
 	if (share_len != 17 && share_len != 25 && share_len != 33 ||
 		share && (!memIsValid(share, 1) || share[0] == 0 || share[0] > 16))
 		return ERR_BAD_SECKEY;
-	// определить длину epki
-	pki_len = bpkiShareEnc(0, share, share_len);
-	if (pki_len == SIZE_MAX)
+	*pki_len = bpkiShareEnc(0, share, share_len);
+	if (*pki_len == SIZE_MAX)
 		return ERR_BAD_FORMAT;
-	edata_len = pki_len + 16;
-	count = bpkiEdataEnc(0, 0, edata_len, 0, iter);
-	if (count == SIZE_MAX)
+	*epki_len = bpkiEdataEnc(0, 0, *pki_len + 16, 0, iter);
+	if (*epki_len == SIZE_MAX)
 		return ERR_BAD_FORMAT;
+	return ERR_OK;
+}
+
+/*
+	Создание контейнера [count]epki на ключе key, построенном по паролю.
+	Длина pki_len кода pki определена в bpkiShareWrapLen().
+*/
+static err_t bpkiShareWrapKey(octet epki[], size_t count, size_t pki_len,
+	const octet share[], size_t share_len, const octet key[32],
+	const octet salt[8], size_t iter)
+{
+	size_t edata_len = pki_len + 16;
+	err_t code;
+	// кодировать pki
+	code = bpkiShareEnc(epki + count - pki_len, share, share_len) ==
+		pki_len ? ERR_OK : ERR_BAD_PRIVKEY;
+	ERR_CALL_HANDLE(code, memWipe(epki, count));
+	// зашифровать pki
+	code = beltKWPWrap(epki + count - pki_len - 16,
+		epki + count - pki_len, pki_len, 0, key, 32);
+	ERR_CALL_HANDLE(code, memWipe(epki, count));
+	// кодировать edata и epki
+	count = bpkiEdataEnc(epki, epki + count - edata_len, edata_len,
+		salt, iter);
+	code = count != SIZE_MAX ? ERR_OK : ERR_BAD_FORMAT;
+	ERR_CALL_HANDLE(code, memWipe(epki, count));
+	return ERR_OK;
+}
+
+err_t bpkiShareWrap(octet epki[], size_t* epki_len, const octet share[],
+	size_t share_len, const octet pwd[], size_t pwd_len,
+	const octet salt[8], size_t iter)
+{
+	size_t pki_len, count;
+	octet* key;
+	err_t code;
+	// определить длину epki
+	code = bpkiShareWrapLen(&pki_len, &count, share, share_len, iter);
+	ERR_CALL_CHECK(code);
 	if (epki_len)
 	{
 		if (!memIsValid(epki_len, O_PER_S))
@@ -462,71 +760,118 @@ err_t bpkiShareWrap(octet epki[], size_t* epki_len, const octet share[],
 		!memIsValid(salt, 8))
 		return ERR_BAD_INPUT;
 	// сгенерировать ключ
-	key = (octet*)blobCreate(32);
+	key = (octet*)stackCreate(32);
 	if (!key)
 		return ERR_OUTOFMEMORY;
 	code = beltPBKDF2(key, pwd, pwd_len, iter, salt, 8);
-	ERR_CALL_HANDLE(code, blobClose(key));
-	// кодировать pki
-	pki_len = bpkiShareEnc(epki + count - pki_len, share, share_len);
-	code = pki_len != SIZE_MAX ? ERR_OK : ERR_BAD_PRIVKEY;
-	ERR_CALL_HANDLE(code, (memWipe(epki, count), blobClose(key)));
-	// зашифровать pki
-	code = beltKWPWrap(epki + count - pki_len - 16,
-		epki + count - pki_len, pki_len, 0, key, 32);
-	ERR_CALL_HANDLE(code, (memWipe(epki, count), blobClose(key)));
-	// кодировать edata и epki
-	count = bpkiEdataEnc(epki, epki + count - edata_len, edata_len,
+	ERR_CALL_HANDLE(code, stackClose(key));
+	// создать контейнер
+	code = bpkiShareWrapKey(epki, count, pki_len, share, share_len, key,
 		salt, iter);
-	code = count != SIZE_MAX ? ERR_OK : ERR_BAD_FORMAT;
-	ERR_CALL_HANDLE(code, (memWipe(epki, count), blobClose(key)));
-	// все нормально
-	blobClose(key);
-	return ERR_OK;
+	stackClose(key);
+	return code;
 }
 
-err_t bpkiShareUnwrap(octet share[], size_t* share_len,
-	const octet epki[], size_t epki_len, const octet pwd[], size_t pwd_len)
+err_t bpkiShareWrapMB(octet epkis[], size_t* epki_len, const octet shares[],
+	size_t share_len, const octet pwd[], size_t pwd_len, const octet salts[],
+	size_t iter, size_t n)
+{
+	size_t pki_len, count, i;
+	octet* keys;
+	const octet** pwds;
+	const octet** salts_ptr;
+	size_t* lens;
+	size_t* salt_lens;
+	err_t code;
+	// определить длину epki
+	code = bpkiShareWrapLen(&pki_len, &count, 0, share_len, iter);
+	ERR_CALL_CHECK(code);
+	if (epki_len)
+	{
+		if (!memIsValid(epki_len, O_PER_S))
+			return ERR_BAD_INPUT;
+		*epki_len = count;
+	}
+	if (!epkis || n == 0)
+		return ERR_OK;
+	// проверить указатели
+	if (n > SIZE_MAX / count || n > SIZE_MAX / share_len ||
+		!memIsValid(shares, n * share_len) ||
+		!memIsValid(epkis, n * count) ||
+		!memIsValid(pwd, pwd_len) ||
+		!memIsValid(salts, 8 * n))
+		return ERR_BAD_INPUT;
+	// проверить номера частичных секретов
+	for (i = 0; i < n; ++i)
+		if (shares[i * share_len] == 0 || shares[i * share_len] > 16)
+			return ERR_BAD_SECKEY;
+	// выделить и разметить память
+	keys = (octet*)stackCreate(n * (32 + 2 * sizeof(octet*) +
+		2 * sizeof(size_t)));
+	if (!keys)
+		return ERR_OUTOFMEMORY;
+	pwds = (const octet**)(keys + 32 * n);
+	salts_ptr = pwds + n;
+	lens = (size_t*)(salts_ptr + n);
+	salt_lens = lens + n;
+	for (i = 0; i < n; ++i)
+		pwds[i] = pwd, lens[i] = pwd_len,
+			salts_ptr[i] = salts + 8 * i, salt_lens[i] = 8;
+	// сгенерировать ключи (одновременно)
+	code = beltPBKDF2MB(keys, pwds, lens, iter, salts_ptr, salt_lens, n);
+	ERR_CALL_HANDLE(code, stackClose(keys));
+	// создать контейнеры
+	for (i = 0; code == ERR_OK && i < n; ++i)
+		code = bpkiShareWrapKey(epkis + i * count, count, pki_len,
+			shares + i * share_len, share_len, keys + 32 * i,
+			salts + 8 * i, iter);
+	if (code != ERR_OK)
+		memWipe(epkis, n * count);
+	memWipe(keys, 32 * n);
+	stackClose(keys);
+	return code;
+}
+
+err_t bpkiShareUnwrap2(octet share[], size_t* share_len,
+	const octet epki[], size_t epki_len, const octet pwd[], size_t pwd_len,
+	void* cache)
 {
 	size_t edata_len, pki_len, count, iter;
 	void* state;
 	octet* salt;
-	octet* key;
 	octet* edata;
 	err_t code;
 	// проверить входные данные
 	if (epki_len == SIZE_MAX || !memIsValid(epki, epki_len) ||
 		!memIsValid(pwd, pwd_len) ||
-		share_len && !memIsValid(share_len, O_PER_S))
+		share_len && !memIsValid(share_len, O_PER_S) ||
+		cache && !memIsValid(cache, sizeof(bpki_kek_cache_st)))
 		return ERR_BAD_INPUT;
 	// определить размер edata
 	count = bpkiEdataDec(0, &edata_len, 0, 0, epki, epki_len);
 	if (count != epki_len)
 		return ERR_BAD_FORMAT;
 	// подготовить буферы для параметров PBKDF2
-	state = blobCreate(8 + 32 + edata_len);
+	state = stackCreate(8 + edata_len);
 	if (!state)
 		return ERR_OUTOFMEMORY;
 	salt = (octet*)state;
-	key = salt + 8;
-	edata = key + 32;
+	edata = salt + 8;
 	// выделить edata
 	count = bpkiEdataDec(edata, 0, salt, &iter, epki, epki_len);
 	ASSERT(count == epki_len);
-	// построить ключ защиты 
-	code = beltPBKDF2(key, pwd, pwd_len, iter, salt, 8);
-	ERR_CALL_HANDLE(code, blobClose(state));
 	// снять защиту
-	code = beltKWPUnwrap(edata, edata, edata_len, 0, key, 32);
-	ERR_CALL_HANDLE(code, blobClose(state));
+	code = bpkiEdataUnwrap(edata, edata_len, salt, iter, pwd, pwd_len,
+		cache);
+	ERR_CALL_HANDLE(code, stackClose(state));
 	pki_len = edata_len - 16;
 	// определить длину share
 	count = bpkiShareDec(share, &edata_len, edata, pki_len);
 	code = count == pki_len ? ERR_OK : ERR_BAD_FORMAT;
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	// проверить указатель share 
 	code = memIsNullOrValid(share, edata_len) ? ERR_OK : ERR_BAD_INPUT;
-	ERR_CALL_HANDLE(code, blobClose(state));
+	ERR_CALL_HANDLE(code, stackClose(state));
 	// декодировать pki
 	count = bpkiShareDec(share, share_len, edata, pki_len);
 	ASSERT(count == pki_len);
@@ -534,7 +879,126 @@ err_t bpkiShareUnwrap(octet share[], size_t* share_len,
 	code = !share || 1 <= share[0] && share[0] <= 16 ?
 		ERR_OK : ERR_BAD_SHAREKEY;
 	// завершить
-	blobClose(state);
+	stackClose(state);
+	return code;
+}
+
+err_t bpkiShareUnwrap(octet share[], size_t* share_len,
+	const octet epki[], size_t epki_len, const octet pwd[], size_t pwd_len)
+{
+	return bpkiShareUnwrap2(share, share_len, epki, epki_len,
+		pwd, pwd_len, 0);
+}
+
+/*
+	Контейнеры разбиваются на группы с одинаковым числом итераций PBKDF2,
+	ключи защиты контейнеров группы строятся одновременно. Обычно все
+	контейнеры создаются с одним числом итераций и образуют одну группу.
+*/
+err_t bpkiShareUnwrapMB(octet shares[], size_t share_len,
+	const octet* const epkis[], const size_t epki_lens[], const octet pwd[],
+	size_t pwd_len, size_t n)
+{
+	size_t pki_len, edata_len, count, len, i, j, m;
+	void* state;
+	octet* edatas;
+	octet* salts;
+	octet* keys;
+	octet* done;
+	size_t* iters;
+	size_t* idx;
+	const octet** pwds;
+	const octet** salts_ptr;
+	size_t* lens;
+	size_t* salt_lens;
+	err_t code = ERR_OK;
+	// проверить входные данные
+	if (share_len != 17 && share_len != 25 && share_len != 33)
+		return ERR_BAD_SECKEY;
+	if (n == 0)
+		return ERR_OK;
+	if (n > SIZE_MAX / share_len ||
+		!memIsValid(shares, n * share_len) ||
+		!memIsValid(epkis, n * sizeof(const octet*)) ||
+		!memIsValid(epki_lens, n * O_PER_S) ||
+		!memIsValid(pwd, pwd_len))
+		return ERR_BAD_INPUT;
+	// проверить длины контейнеров
+	pki_len = bpkiShareEnc(0, 0, share_len);
+	if (pki_len == SIZE_MAX)
+		return ERR_BAD_FORMAT;
+	for (i = 0; i < n; ++i)
+	{
+		if (epki_lens[i] == SIZE_MAX || !memIsValid(epkis[i], epki_lens[i]))
+			return ERR_BAD_INPUT;
+		count = bpkiEdataDec(0, &edata_len, 0, 0, epkis[i], epki_lens[i]);
+		if (count != epki_lens[i] || edata_len != pki_len + 16)
+			return ERR_BAD_FORMAT;
+	}
+	edata_len = pki_len + 16;
+	// выделить и разметить память
+	state = stackCreate(n * (edata_len + 8 + 32 + 1 +
+		4 * sizeof(size_t) + 2 * sizeof(octet*)));
+	if (!state)
+		return ERR_OUTOFMEMORY;
+	pwds = (const octet**)state;
+	salts_ptr = pwds + n;
+	iters = (size_t*)(salts_ptr + n);
+	idx = iters + n;
+	lens = idx + n;
+	salt_lens = lens + n;
+	keys = (octet*)(salt_lens + n);
+	edatas = keys + 32 * n;
+	salts = edatas + edata_len * n;
+	done = salts + 8 * n;
+	// выделить edata
+	for (i = 0; i < n; ++i)
+	{
+		count = bpkiEdataDec(edatas + i * edata_len, 0, salts + 8 * i,
+			iters + i, epkis[i], epki_lens[i]);
+		ASSERT(count == epki_lens[i]);
+		done[i] = 0;
+	}
+	// обработать группы
+	for (i = 0; code == ERR_OK && i < n; ++i)
+	{
+		if (done[i])
+			continue;
+		// составить группу
+		for (m = 0, j = i; j < n; ++j)
+			if (!done[j] && iters[j] == iters[i])
+			{
+				pwds[m] = pwd, lens[m] = pwd_len;
+				salts_ptr[m] = salts + 8 * j, salt_lens[m] = 8;
+				idx[m++] = j, done[j] = 1;
+			}
+		// построить ключи защиты (одновременно)
+		code = beltPBKDF2MB(keys, pwds, lens, iters[i], salts_ptr, salt_lens,
+			m);
+		// снять защиту и декодировать частичные секреты
+		for (j = 0; code == ERR_OK && j < m; ++j)
+		{
+			octet* edata = edatas + idx[j] * edata_len;
+			octet* share = shares + idx[j] * share_len;
+			code = beltKWPUnwrap(edata, edata, edata_len, 0, keys + 32 * j,
+				32);
+			if (code != ERR_OK)
+				break;
+			count = bpkiShareDec(0, &len, edata, pki_len);
+			code = count == pki_len && len == share_len ?
+				ERR_OK : ERR_BAD_FORMAT;
+			if (code != ERR_OK)
+				break;
+			count = bpkiShareDec(share, 0, edata, pki_len);
+			ASSERT(count == pki_len);
+			code = 1 <= share[0] && share[0] <= 16 ? ERR_OK : ERR_BAD_SHAREKEY;
+		}
+		memWipe(keys, 32 * m);
+	}
+	// завершить
+	if (code != ERR_OK)
+		memSetZero(shares, n * share_len);
+	stackClose(state);
 	return code;
 }
 
@@ -638,15 +1102,15 @@ err_t bpkiCSRRewrap(octet csr[], size_t csr_len, const octet privkey[],
 	code = bignOidToDER(oid_der, &oid_len, oid_belt_hash);
 	ERR_CALL_CHECK(code);
 	// хэшировать
-	if (!(hash = blobCreate(32)))
+	if (!(hash = stackCreate(32)))
 		return ERR_OUTOFMEMORY;
 	code = beltHash(hash, csr + ci->body_offset, ci->body_len);
-	ERR_CALL_HANDLE(code, blobClose(hash));
+	ERR_CALL_HANDLE(code, stackClose(hash));
 	// подписать
 	code = bignSign2(csr + ci->sig_offset, params, oid_der, oid_len,
 		hash, privkey, csr + ci->sig_offset, 48);
 	// завершить
-	blobClose(hash);
+	stackClose(hash);
 	return code;
 }
 
@@ -674,14 +1138,14 @@ err_t bpkiCSRUnwrap(octet pubkey[], size_t* pubkey_len, const octet csr[],
 	code = bignOidToDER(oid_der, &oid_len, oid_belt_hash);
 	ERR_CALL_CHECK(code);
 	// хэшировать
-	if (!(hash = blobCreate(32)))
+	if (!(hash = stackCreate(32)))
 		return ERR_OUTOFMEMORY;
 	code = beltHash(hash, csr + ci->body_offset, ci->body_len);
-	ERR_CALL_HANDLE(code, blobClose(hash));
+	ERR_CALL_HANDLE(code, stackClose(hash));
 	// проверить подпись
 	code = bignVerify(params, oid_der, oid_len, hash, csr + ci->sig_offset,
 		csr + ci->pubkey_offset);
-	blobClose(hash);
+	stackClose(hash);
 	ERR_CALL_CHECK(code);
 	// завершить
 	if (pubkey_len)
@@ -696,3 +1160,124 @@ err_t bpkiCSRUnwrap(octet pubkey[], size_t* pubkey_len, const octet csr[],
 	}
 	return ERR_OK;
 }
+
+err_t bpkiCSRUnwrapBatch(err_t codes[], octet pubkeys[],
+	const octet* const csrs[], const size_t csr_lens[], size_t n)
+{
+	err_t code;
+	size_t count, bad, i, j, m;
+	bpki_csr_info_t ci[1];
+	bign_params params[1];
+	octet oid_der[16];
+	size_t oid_len = sizeof(oid_der);
+	void* state;
+	const void** srcs;
+	size_t* lens;
+	size_t* idx;
+	err_t* vals;
+	octet* hashes;
+	octet* sigs;
+	octet* pks;
+	// входной контроль
+	if (n == 0)
+		return ERR_OK;
+	if (n > SIZE_MAX / 64 ||
+		!memIsValid(codes, n * sizeof(err_t)) ||
+		!memIsNullOrValid(pubkeys, n * 64) ||
+		!memIsValid(csrs, n * sizeof(const octet*)) ||
+		!memIsValid(csr_lens, n * O_PER_S))
+		return ERR_BAD_INPUT;
+	// загрузить стандартные параметры
+	code = bignParamsStd(params, oid_bign_curve256v1);
+	ERR_CALL_CHECK(code);
+	// кодировать идентификатор алгоритма хэширования
+	code = bignOidToDER(oid_der, &oid_len, oid_belt_hash);
+	ERR_CALL_CHECK(code);
+	// выделить и разметить память
+	state = stackCreate(n * (sizeof(const void*) + 2 * sizeof(size_t) +
+		sizeof(err_t) + 32 + 48 + 64));
+	if (!state)
+		return ERR_OUTOFMEMORY;
+	srcs = (const void**)state;
+	lens = (size_t*)(srcs + n);
+	idx = lens + n;
+	vals = (err_t*)(idx + n);
+	hashes = (octet*)(vals + n);
+	sigs = hashes + 32 * n;
+	pks = sigs + 48 * n;
+	// разобрать запросы
+	for (i = m = 0; i < n; ++i)
+	{
+		if (csr_lens[i] == SIZE_MAX || !memIsValid(csrs[i], csr_lens[i]))
+		{
+			codes[i] = ERR_BAD_INPUT;
+			continue;
+		}
+		count = bpkiCSRDec(ci, csrs[i], csr_lens[i]);
+		if (count == SIZE_MAX || count != csr_lens[i])
+		{
+			codes[i] = ERR_BAD_FORMAT;
+			continue;
+		}
+		codes[i] = ERR_OK;
+		srcs[m] = csrs[i] + ci->body_offset, lens[m] = ci->body_len;
+		memCopy(sigs + 48 * m, csrs[i] + ci->sig_offset, 48);
+		memCopy(pks + 64 * m, csrs[i] + ci->pubkey_offset, 64);
+		idx[m++] = i;
+	}
+	// проверить открытые ключи (одновременно) и исключить некорректные
+	code = bignPubkeyValBatch(vals, params, m, pks);
+	if (code != ERR_OK && code != ERR_BAD_PUBKEY)
+	{
+		stackClose(state);
+		return code;
+	}
+	for (i = j = 0; i < m; ++i)
+	{
+		if (vals[i] != ERR_OK)
+		{
+			codes[idx[i]] = vals[i];
+			continue;
+		}
+		if (i != j)
+		{
+			srcs[j] = srcs[i], lens[j] = lens[i], idx[j] = idx[i];
+			memCopy(sigs + 48 * j, sigs + 48 * i, 48);
+			memCopy(pks + 64 * j, pks + 64 * i, 64);
+		}
+		++j;
+	}
+	m = j;
+	// хэшировать (одновременно)
+	code = beltHashMB(hashes, srcs, lens, m);
+	ERR_CALL_HANDLE(code, stackClose(state));
+	// проверить подписи пакетами, исключая некорректные
+	for (j = 0; j < m; j += bad + 1)
+	{
+		code = bignVerifyBatch(&bad, params, oid_der, oid_len, m - j,
+			hashes + 32 * j, sigs + 48 * j, pks + 64 * j);
+		if (code == ERR_OK)
+			break;
+		if (bad >= m - j)
+		{
+			for (; j < m; ++j)
+				codes[idx[j]] = code;
+			break;
+		}
+		codes[idx[j + bad]] = code;
+	}
+	// возвратить открытые ключи
+	if (pubkeys)
+	{
+		memSetZero(pubkeys, n * 64);
+		for (j = 0; j < m; ++j)
+			if (codes[idx[j]] == ERR_OK)
+				memCopy(pubkeys + 64 * idx[j], pks + 64 * j, 64);
+	}
+	stackClose(state);
+	// код первой ошибки
+	for (i = 0; i < n; ++i)
+		if (codes[i] != ERR_OK)
+			return codes[i];
+	return ERR_OK;
+}
@@ -4,7 +4,7 @@
 \brief STB 34.101.47 (brng): algorithms of pseudorandom number generation
 \project bee2 [cryptographic library]
 \created 2013.01.31
-\version 2018.07.09
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,10 +13,12 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/u32.h"
 #include "bee2/core/util.h"
 #include "bee2/core/word.h"
 #include "bee2/crypto/belt.h"
 #include "bee2/crypto/brng.h"
+#include "belt/belt_lcl.h"
 
 /*
 *******************************************************************************
@@ -56,6 +58,42 @@ static void brngBlockInc(octet block[32])
 	i = 0;
 }
 
+/*
+*******************************************************************************
+Дорожки
+
+Четверки выходных блоков обрабатываются на дорожках beltCompr2X4().
+Дорожка хранит переменные belt-hash: блок ls = [4]len || [4]s и переменную h,
+а также блок данных X и вспомогательные переменные h1, s1. Сжатия
+beltCompr() выполняются с помощью beltCompr2X4(), при этом изменения s
+сбрасываются в s1 (см. beltPBKDF2MB()).
+
+Дорожки и стек beltCompr2X4() размещаются в структуре brng_lanes_st
+в автоматической памяти функций обработки четверок и очищаются после
+использования. Поэтому длины состояний brng не увеличиваются.
+
+Дорожки используются при генерации не менее BRNG_LANES_MIN октетов.
+*******************************************************************************
+*/
+
+#define BRNG_LANES_MIN (4 * 32)
+
+typedef struct
+{
+	struct
+	{
+		u32 ls[8];		/*< блок [4]len || [4]s */
+		u32 h[8];		/*< переменная h */
+		u32 h1[8];		/*< вспомогательная переменная h */
+		u32 X[8];		/*< блок данных */
+		u32 s1[4];		/*< вспомогательный блок */
+	} lanes[4];			/*< дорожки */
+	u32 ls[8];			/*< вспомогательный блок [4]len || [4]s */
+	u32 h[8];			/*< вспомогательная переменная h */
+	u32 X[8];			/*< общий блок данных */
+	u32 stack[64];		/*< [beltCompr2X4_deep()] стек beltCompr2X4() */
+} brng_lanes_st;
+
 /*
 *******************************************************************************
 Генерация в режиме CTR
@@ -63,6 +101,12 @@ static void brngBlockInc(octet block[32])
 В brng_ctr_st::state_ex размещаются два beltHash-состояния:
 -	вспомогательное состояние;
 -	состояние beltHash(key ||....).
+
+В переменных hk, sk сохраняются значения h и s belt-hash после обработки
+key. При генерации четверки полных блоков Y_t,..., Y_{t + 3} сжатия блоков
+s и X_t,..., X_{t + 3} выполняются одновременно на четырех дорожках:
+эти блоки не зависят от r. Сжатия блока r и последние сжатия выполняются
+последовательно, поскольку r зависит от предыдущих выходных блоков.
 *******************************************************************************
 */
 typedef struct
@@ -71,6 +115,8 @@ typedef struct
 	octet r[32];		/*< переменная r */
 	octet block[32];	/*< блок выходных данных */
 	size_t reserved;	/*< резерв выходных октетов */
+	u32 hk[8];			/*< переменная h после обработки key */
+	u32 sk[4];			/*< переменная s после обработки key */
 	octet state_ex[];	/*< [2 beltHash_keep()] хэш-состояния */
 } brng_ctr_st;
 
@@ -87,6 +133,12 @@ void brngCTRStart(void* state, const octet key[32], const octet iv[32])
 	// обработать key
 	beltHashStart(s->state_ex + beltHash_keep());
 	beltHashStepH(key, 32, s->state_ex + beltHash_keep());
+	// (hk, sk) <- переменные belt-hash после обработки key
+	// [вспомогательное состояние -- блок key и стек beltCompr2()]
+	u32From((u32*)s->state_ex, key, 32);
+	u32From(s->hk, beltH(), 32);
+	beltBlockSetZero(s->sk);
+	beltCompr2(s->sk, s->hk, (u32*)s->state_ex, s->state_ex + 32);
 	//	сохранить iv
 	if (iv)
 		memCopy(s->s, iv, 32);
@@ -98,6 +150,53 @@ void brngCTRStart(void* state, const octet key[32], const octet iv[32])
 	s->reserved = 0;
 }
 
+static void brngCTRStepR4(octet buf[], size_t n, brng_ctr_st* s)
+{
+	brng_lanes_st st[1];
+	u32* ss[4];
+	u32* h[4];
+	const u32* X[4];
+	size_t j;
+	ASSERT(sizeof(st->stack) >= utilMax(2,
+		beltCompr_deep(),
+		beltCompr2X4_deep()));
+	// подготовить дорожки
+	for (j = 0; j < 4; ++j)
+		ss[j] = st->lanes[j].ls + 4, h[j] = st->lanes[j].h,
+			X[j] = st->lanes[j].X;
+	// цикл по четверкам блоков
+	for (; n--; buf += 128)
+	{
+		// ls <- len(key || s || X || r) || sk, h <- hk, X <- s
+		for (j = 0; j < 4; ++j)
+		{
+			beltBlockSetZero(st->lanes[j].ls);
+			beltBlockAddBitSizeU32(st->lanes[j].ls, 32 * 4);
+			beltBlockCopy(st->lanes[j].ls + 4, s->sk);
+			beltBlockCopy(st->lanes[j].h, s->hk);
+			beltBlockCopy(st->lanes[j].h + 4, s->hk + 4);
+			u32From(st->lanes[j].X, s->s, 32);
+			brngBlockInc(s->s);
+		}
+		beltCompr2X4(ss, h, X, st->stack);
+		// обработать X_t
+		for (j = 0; j < 4; ++j)
+			u32From(st->lanes[j].X, buf + 32 * j, 32);
+		beltCompr2X4(ss, h, X, st->stack);
+		// обработать r и завершить хэширование
+		for (j = 0; j < 4; ++j)
+		{
+			u32From(st->lanes[j].X, s->r, 32);
+			beltCompr2(st->lanes[j].ls + 4, st->lanes[j].h, st->lanes[j].X,
+				st->stack);
+			beltCompr(st->lanes[j].h, st->lanes[j].ls, st->stack);
+			u32To(buf + 32 * j, 32, st->lanes[j].h);
+			brngBlockXor2(s->r, buf + 32 * j);
+		}
+	}
+	memWipe(st, sizeof(st));
+}
+
 void brngCTRStepR(void* buf, size_t count, void* state)
 {
 	brng_ctr_st* s = (brng_ctr_st*)state;
@@ -116,6 +215,11 @@ void brngCTRStepR(void* buf, size_t count, void* state)
 		buf = (octet*)buf + s->reserved;
 		s->reserved = 0;
 	}
+	// цикл по четверкам полных блоков
+	if (count >= BRNG_LANES_MIN)
+		brngCTRStepR4(buf, count / 128, s);
+	buf = (octet*)buf + count / 128 * 128;
+	count %= 128;
 	// цикл по полным блокам
 	while (count >= 32)
 	{
@@ -183,9 +287,16 @@ err_t brngCTRRand(void* buf, size_t count, const octet key[32], octet iv[32])
 *******************************************************************************
 Генерация в режиме HMAC
 
-В brng_hmac_st::state_ex размещаются два beltHMAC-состояния:
--	вспомогательное состояние;
--	состояние beltHMAC(key, ...).
+В brng_hmac_st::state_ex размещаются beltHMAC-состояние и подготовленный
+ключ beltHMAC(key, ...).
+
+Выходной блок Y_t определяется как beltHMAC(key, r || iv), где r --
+значение переменной до ее обновления: при вычислении нового значения
+beltHMAC(key, r) и при вычислении Y_t используется общее состояние
+внутреннего хэширования после обработки r. Новые значения r вычисляются
+последовательно, состояния сохраняются на дорожках. После обработки
+четырех очередных r хэширование iv и завершение вычисления выходных
+блоков выполняются одновременно на четырех дорожках.
 
 \remark Учитывается инкрементальность beltHMAC
 *******************************************************************************
@@ -198,12 +309,85 @@ typedef struct
 	octet r[32];				/*< переменная r */
 	octet block[32];			/*< блок выходных данных */
 	size_t reserved;			/*< резерв выходных октетов */
-	octet state_ex[];			/*< [2 * beltHMAC_keep()] hmac-состояния */
+	octet state_ex[];			/*< hmac-состояние и подготовленный ключ */
 } brng_hmac_st;
 
 size_t brngHMAC_keep()
 {
-	return sizeof(brng_hmac_st) + 2 * beltHMAC_keep();
+	return sizeof(brng_hmac_st) + beltHMAC_keep() + beltHMACKey_keep();
+}
+
+static void brngHMACStepR4(octet buf[], size_t n, brng_hmac_st* s)
+{
+	const belt_hmac_key_st* hk =
+		(const belt_hmac_key_st*)(s->state_ex + beltHMAC_keep());
+	brng_lanes_st st[1];
+	u32* ss[4];
+	u32* h[4];
+	const u32* X[4];
+	size_t j, pos;
+	ASSERT(sizeof(st->stack) >= utilMax(2,
+		beltCompr_deep(),
+		beltCompr2X4_deep()));
+	// цикл по четверкам блоков
+	for (; n--; buf += 128)
+	{
+		// (ls, h) <- внутреннее хэширование после обработки r
+		// r <- beltHMAC(key, r)
+		for (j = 0; j < 4; ++j)
+		{
+			u32From(st->lanes[j].X, s->r, 32);
+			memCopy(st->lanes[j].ls, hk->ls_in, 32);
+			memCopy(st->lanes[j].h, hk->h_in, 32);
+			beltCompr2(st->lanes[j].ls + 4, st->lanes[j].h, st->lanes[j].X,
+				st->stack);
+			memCopy(st->lanes[j].X, st->lanes[j].ls, 32);
+			beltBlockAddBitSizeU32(st->lanes[j].X, 32);
+			memCopy(st->lanes[j].h1, st->lanes[j].h, 32);
+			beltCompr(st->lanes[j].h1, st->lanes[j].X, st->stack);
+			memCopy(st->ls, hk->ls_out, 32);
+			memCopy(st->h, hk->h_out, 32);
+			beltCompr2(st->ls + 4, st->h, st->lanes[j].h1, st->stack);
+			beltCompr(st->h, st->ls, st->stack);
+			u32To(s->r, 32, st->h);
+			beltBlockAddBitSizeU32(st->lanes[j].ls, 32);
+			beltBlockAddBitSizeU32(st->lanes[j].ls, s->iv_len);
+			ss[j] = st->lanes[j].ls + 4, h[j] = st->lanes[j].h, X[j] = st->X;
+		}
+		// внутреннее хэширование: обработать iv [общий блок X]
+		for (pos = 0; pos + 32 <= s->iv_len; pos += 32)
+		{
+			u32From(st->X, s->iv + pos, 32);
+			beltCompr2X4(ss, h, X, st->stack);
+		}
+		if (pos < s->iv_len)
+		{
+			memSetZero(s->block, 32);
+			memCopy(s->block, s->iv + pos, s->iv_len - pos);
+			u32From(st->X, s->block, 32);
+			beltCompr2X4(ss, h, X, st->stack);
+		}
+		// внутреннее хэширование: последний блок
+		for (j = 0; j < 4; ++j)
+			ss[j] = st->lanes[j].s1, X[j] = st->lanes[j].ls;
+		beltCompr2X4(ss, h, X, st->stack);
+		// внешнее хэширование
+		for (j = 0; j < 4; ++j)
+		{
+			memCopy(st->lanes[j].ls, hk->ls_out, 32);
+			memCopy(st->lanes[j].h1, hk->h_out, 32);
+			ss[j] = st->lanes[j].ls + 4, h[j] = st->lanes[j].h1,
+				X[j] = st->lanes[j].h;
+		}
+		beltCompr2X4(ss, h, X, st->stack);
+		for (j = 0; j < 4; ++j)
+			ss[j] = st->lanes[j].s1, X[j] = st->lanes[j].ls;
+		beltCompr2X4(ss, h, X, st->stack);
+		// Y_t <- h1
+		for (j = 0; j < 4; ++j)
+			u32To(buf + 32 * j, 32, st->lanes[j].h1);
+	}
+	memWipe(st, sizeof(st));
 }
 
 void brngHMACStart(void* state, const octet key[], size_t key_len, 
@@ -221,9 +405,9 @@ void brngHMACStart(void* state, const octet key[], size_t key_len,
 	else
 		s->iv = iv;
 	// обработать key
-	beltHMACStart(s->state_ex + beltHMAC_keep(), key, key_len);
+	beltHMACStart(s->state_ex, key, key_len);
+	beltHMACKeyPrepare(s->state_ex + beltHMAC_keep(), s->state_ex);
 	// r <- beltHMAC(key, iv)
-	memCopy(s->state_ex, s->state_ex + beltHMAC_keep(), beltHMAC_keep());
 	beltHMACStepA(iv, iv_len, s->state_ex);
 	beltHMACStepG(s->r, s->state_ex);
 	// нет выходных данных
@@ -248,11 +432,16 @@ void brngHMACStepR(void* buf, size_t count, void* state)
 		buf = (octet*)buf + s->reserved;
 		s->reserved = 0;
 	}
+	// цикл по четверкам полных блоков
+	if (count >= BRNG_LANES_MIN)
+		brngHMACStepR4(buf, count / 128, s);
+	buf = (octet*)buf + count / 128 * 128;
+	count %= 128;
 	// цикл по полным блокам
 	while (count >= 32)
 	{
 		// r <- beltHMAC(key, r) 
-		memCopy(s->state_ex, s->state_ex + beltHMAC_keep(), beltHMAC_keep());
+		beltHMACStartPrepared(s->state_ex, s->state_ex + beltHMAC_keep());
 		beltHMACStepA(s->r, 32, s->state_ex);
 		beltHMACStepG(s->r, s->state_ex);
 		// Y_t <- beltHMAC(key, r || iv)
@@ -266,7 +455,7 @@ void brngHMACStepR(void* buf, size_t count, void* state)
 	if (count)
 	{
 		// r <- beltHMAC(key, r) 
-		memCopy(s->state_ex, s->state_ex + beltHMAC_keep(), beltHMAC_keep());
+		beltHMACStartPrepared(s->state_ex, s->state_ex + beltHMAC_keep());
 		beltHMACStepA(s->r, 32, s->state_ex);
 		beltHMACStepG(s->r, s->state_ex);
 		// Y_t <- left(beltHMAC(key, r || iv))
@@ -4,7 +4,7 @@
 \brief STB 34.101.79 (btok): BAUTH protocol
 \project bee2 [cryptographic library]
 \created 2022.02.22
-\version 2023.09.20
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -14,6 +14,7 @@
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
 #include "bee2/core/obj.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/bake.h"
 #include "bee2/crypto/belt.h"
@@ -176,6 +177,8 @@ err_t btokBAuthTStart(void* state, const bign_params* params,
 	s->hdr.o_count = 1;
 	// загрузить личный ключ
 	wwFrom(s->d, privkey, no);
+	if (wwIsZero(s->d, n) || wwCmp(s->d, s->ec->order, n) >= 0)
+		return ERR_BAD_PRIVKEY;
 	// раскладка стека
 	Q = objEnd(s, word);
 	stack = Q + 2 * n;
@@ -248,6 +251,8 @@ err_t btokBAuthCTStart(void* state, const bign_params* params,
 	s->hdr.o_count = 1;
 	// загрузить личный ключ
 	wwFrom(s->d, privkey, no);
+	if (wwIsZero(s->d, n) || wwCmp(s->d, s->ec->order, n) >= 0)
+		return ERR_BAD_PRIVKEY;
 	// раскладка стека
 	Q = objEnd(s, word);
 	stack = Q + 2 * n;
@@ -273,6 +278,122 @@ static size_t btokBAuthCTStart_deep(size_t n, size_t f_deep, size_t ec_d,
 			ecpIsOnA_deep(n, f_deep));
 }
 
+/*
+*******************************************************************************
+Контекст терминала
+
+Контекст содержит копию сертификата, загруженный личный ключ и контекст
+bign (описание кривой). Проверки параметров, личного ключа и сертификата
+выполняются один раз при создании контекста. В btokBAuthTStart2() описание
+кривой копируется в состояние без повторного построения.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	bake_cert cert[1];			/*< сертификат */
+	word d[W_OF_B(512)];		/*< долговременный личный ключ */
+	octet bign[];				/*< контекст bign */
+} btok_bauth_tctx_st;
+
+size_t btokBAuthTCtx_keep(size_t l)
+{
+	return sizeof(btok_bauth_tctx_st) + bignCtx_keep(l);
+}
+
+err_t btokBAuthTCtxStart(void* ctx, const bign_params* params,
+	const octet privkey[], const bake_cert* cert)
+{
+	err_t code;
+	btok_bauth_tctx_st* st = (btok_bauth_tctx_st*)ctx;
+	const ec_o* ec;
+	size_t n, no;
+	// стек
+	word* Q;
+	void* stack;
+	// проверить входные данные
+	if (!memIsValid(params, sizeof(bign_params)))
+		return ERR_BAD_INPUT;
+	if (!bignIsOperable(params))
+		return ERR_BAD_PARAMS;
+	if (!memIsValid(ctx, btokBAuthTCtx_keep(params->l)) ||
+		!memIsValid(privkey, params->l / 4) ||
+		!memIsValid(cert, sizeof(bake_cert)) ||
+		!memIsValid(cert->data, cert->len) ||
+		cert->val == 0)
+		return ERR_BAD_INPUT;
+	// построить контекст bign
+	code = bignCtxStart(st->bign, params);
+	ERR_CALL_CHECK(code);
+	ec = (const ec_o*)((const bign_ctx_st*)st->bign)->ec;
+	n = ec->f->n, no = ec->f->no;
+	// загрузить личный ключ
+	wwFrom(st->d, privkey, no);
+	if (wwIsZero(st->d, n) || wwCmp(st->d, ec->order, n) >= 0)
+		return ERR_BAD_PRIVKEY;
+	// проверить сертификат и его открытый ключ
+	Q = (word*)stackCreate(bignCtxStack_keep(st->bign,
+		btokBAuthTStart_deep));
+	if (Q == 0)
+		return ERR_OUTOFMEMORY;
+	stack = Q + 2 * n;
+	code = cert->val((octet*)Q, params, cert->data, cert->len);
+	if (code == ERR_OK &&
+		(!qrFrom(ecX(Q), (octet*)Q, ec->f, stack) ||
+		!qrFrom(ecY(Q, n), (octet*)Q + no, ec->f, stack) ||
+		!ecpIsOnA(Q, ec, stack)))
+		code = ERR_BAD_CERT;
+	stackClose(Q);
+	ERR_CALL_CHECK(code);
+	// сохранить сертификат
+	memCopy(st->cert, cert, sizeof(bake_cert));
+	return code;
+}
+
+err_t btokBAuthTStart2(void* state, const void* ctx,
+	const bake_settings* settings)
+{
+	bake_bauth_t_o* s = (bake_bauth_t_o*)state;
+	const btok_bauth_tctx_st* st = (const btok_bauth_tctx_st*)ctx;
+	const bign_ctx_st* bign;
+	size_t n, no;
+	// проверить входные данные
+	if (!memIsValid(settings, sizeof(bake_settings)) ||
+		settings->kca != TRUE ||
+		!memIsNullOrValid(settings->helloa, settings->helloa_len) ||
+		!memIsNullOrValid(settings->hellob, settings->hellob_len))
+		return ERR_BAD_INPUT;
+	if (settings->rng == 0)
+		return ERR_BAD_RNG;
+	if (!memIsValid(ctx, sizeof(btok_bauth_tctx_st)) ||
+		!bignCtxIsOperable(st->bign))
+		return ERR_BAD_INPUT;
+	bign = (const bign_ctx_st*)st->bign;
+	// загрузить параметры
+	objCopy(s->data, bign->ec);
+	s->ec = (ec_o*)s->data;
+	n = s->ec->f->n, no = s->ec->f->no;
+	// сохранить параметры
+	memCopy(s->params, bign->params, sizeof(bign_params));
+	// сохранить настройки
+	memCopy(s->settings, settings, sizeof(bake_settings));
+	// настроить указатели
+	s->d = objEnd(s->ec, word);
+	s->Vct = s->d + n;
+	s->R = (octet*)(s->Vct + 2 * n);
+	// настроить заголовок
+	s->hdr.keep = sizeof(bake_bauth_t_o) + objKeep(s->ec) +
+		3 * O_OF_W(n) + no / 2;
+	s->hdr.p_count = 3;
+	s->hdr.o_count = 1;
+	// загрузить личный ключ
+	wwCopy(s->d, st->d, n);
+	// сохранить сертификат
+	memCopy(s->cert, st->cert, sizeof(bake_cert));
+	// все нормально
+	return ERR_OK;
+}
+
 /*
 *******************************************************************************
 Шаги
@@ -317,10 +438,10 @@ err_t btokBAuthCTStep2(octet out[], const bake_cert* certt, void* state)
 		s->settings->rng_state))
 		return ERR_BAD_RNG;
 	// Vct <- uct G
-	if (!ecMulA(Vct, s->ec->base, s->ec, s->u, n, stack))
+	if (!bignMulBase(Vct, s->params, s->ec, s->u, n, stack))
 		return ERR_BAD_PARAMS;
 	// K <- uct Qt
-	if (!ecMulA(K, Qt, s->ec, s->u, n, stack))
+	if (!ecMulACT(K, Qt, s->ec, s->u, n, stack))
 		return ERR_BAD_PARAMS;
 	// сохранить ecX(Vct)
 	qrTo(s->V, ecX(Vct), s->ec->f, stack);
@@ -338,9 +459,10 @@ static size_t btokBAuthCTStep2_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(6 * n) +
-		utilMax(2,
+		utilMax(3,
 			f_deep,
-			ecMulA_deep(n, ec_d, ec_deep, n));
+			bignMulBase_deep(n, ec_d, ec_deep),
+			ecMulACT_deep(n, ec_d, ec_deep));
 }
 
 err_t btokBAuthTStep3(octet out[], const octet in[], void* state)
@@ -378,7 +500,7 @@ err_t btokBAuthTStep3(octet out[], const octet in[], void* state)
 		!ecpIsOnA(s->Vct, s->ec, stack))
 		return ERR_BAD_POINT;
 	// K <- dt Vct
-	if (!ecMulA(K, s->Vct, s->ec, s->d, n, stack))
+	if (!ecMulACT(K, s->Vct, s->ec, s->d, n, stack))
 		return ERR_BAD_PARAMS;
 	memSetZero(hdr, 16);
 	qrTo((octet*)K, ecX(K), s->ec->f, stack);
@@ -436,7 +558,7 @@ static size_t btokBAuthTStep3_deep(size_t n, size_t f_deep, size_t ec_d,
 	return MAX2(O_OF_W(2 * n), 32 + 16 + 16) +
 		utilMax(5,
 			f_deep,
-			ecMulA_deep(n, ec_d, ec_deep, n),
+			ecMulACT_deep(n, ec_d, ec_deep),
 			beltHash_keep(),
 			beltKRP_keep(),
 			beltMAC_keep());
@@ -538,7 +660,7 @@ static size_t btokBAuthCTStep4_deep(size_t n, size_t f_deep, size_t ec_d,
 	return 16 + 32 + 32 + O_OF_W(2 * n + 1) +
 		utilMax(5,
 			f_deep,
-			ecMulA_deep(n, ec_d, ec_deep, n),
+			ecMulACT_deep(n, ec_d, ec_deep),
 			beltHash_keep(),
 			beltKRP_keep(),
 			beltMAC_keep());
@@ -584,7 +706,7 @@ err_t btokBAuthTStep5(const octet in[], size_t in_len, bake_certval_i val_ct,
 	{
 		blob_t Zct;
 		// sct || cert_ct <- beltCFBDecr(Zct, K2, 0^128)
-		if ((Zct = blobCreate(in_len)) == 0)
+		if ((Zct = stackCreate(in_len)) == 0)
 			return ERR_OUTOFMEMORY;
 		memCopy(Zct, in, in_len);
 		memSet(block0, 0, 16);
@@ -594,17 +716,17 @@ err_t btokBAuthTStep5(const octet in[], size_t in_len, bake_certval_i val_ct,
 		wwFrom(sct, Zct, no);
 		if (wwCmp(sct, s->ec->order, n) >= 0)
 		{
-			blobClose(Zct);
+			stackClose(Zct);
 			return ERR_AUTH;
 		}
 		// проверить cert_ct
 		code = val_ct((octet*)Qct, s->params, (octet*)Zct + no, in_len - no);
-		ERR_CALL_HANDLE(code, blobClose(Zct));
+		ERR_CALL_HANDLE(code, stackClose(Zct));
 		if (!qrFrom(ecX(Qct), (octet*)Qct, s->ec->f, stack) ||
 			!qrFrom(ecY(Qct, n), (octet*)Qct + no, s->ec->f, stack) ||
 			!ecpIsOnA(Qct, s->ec, stack))
 			code = ERR_BAD_CERT;
-		blobClose(Zct);
+		stackClose(Zct);
 		ERR_CALL_CHECK(code);
 	}
 	// t <- <beltHash(<Vct>_2l || <Rt>)>_l
@@ -616,8 +738,8 @@ err_t btokBAuthTStep5(const octet in[], size_t in_len, bake_certval_i val_ct,
 	wwFrom(t, t, no / 2);
 	// sct G + (2^l + t)Qct == Vct?
 	t[n / 2] = 1;
-	if (!ecAddMulA(Qct, s->ec, stack, 2, s->ec->base, sct, n, Qct, t,
-		n / 2 + 1))
+	if (!bignAddMulBase(Qct, s->params, s->ec, sct, n, Qct, t, n / 2 + 1,
+		stack))
 		return ERR_BAD_PARAMS;
 	if (!wwEq(Qct, s->Vct, 2 * n))
 		return ERR_AUTH;
@@ -635,7 +757,7 @@ static size_t btokBAuthTStep5_deep(size_t n, size_t f_deep, size_t ec_d,
 			beltCFB_keep(),
 			f_deep,
 			ecpIsOnA_deep(n, f_deep),
-			ecAddMulA_deep(n, ec_d, ec_deep, 2, n, n / 2 + 1));
+			bignAddMulBase_deep(n, ec_d, ec_deep, n / 2 + 1));
 }
 
 static size_t btokBAuthCT_deep(size_t n, size_t f_deep, size_t ec_d,
@@ -4,7 +4,7 @@
 \brief STB 34.101.79 (btok): CV certificates
 \project bee2 [cryptographic library]
 \created 2022.07.04
-\version 2023.12.19
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -14,8 +14,10 @@
 #include "bee2/core/err.h"
 #include "bee2/core/der.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
 #include "bee2/core/hex.h"
 #include "bee2/core/rng.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/str.h"
 #include "bee2/core/tm.h"
 #include "bee2/core/util.h"
@@ -103,7 +105,7 @@ static err_t btokKeypairVal(const octet privkey[], size_t privkey_len,
 }
 
 static err_t btokSign(octet sig[], const void* buf, size_t count,
-	const octet privkey[], size_t privkey_len)
+	const octet privkey[], size_t privkey_len, const void* ctx)
 {
 	err_t code;
 	bign_params params[1];
@@ -118,7 +120,7 @@ static err_t btokSign(octet sig[], const void* buf, size_t count,
 	code = btokParamsStd(params, privkey_len);
 	ERR_CALL_CHECK(code);
 	// создать и разметить стек
-	stack = blobCreate(2 * privkey_len + 
+	stack = stackCreate(2 * privkey_len + 
 		(privkey_len <= 32 ? beltHash_keep() : bashHash_keep()));
 	if (!stack)
 		return ERR_OUTOFMEMORY;
@@ -132,7 +134,7 @@ static err_t btokSign(octet sig[], const void* buf, size_t count,
 		beltHashStepH(buf, count, state);
 		beltHashStepG2(hash, privkey_len, state);
 		code = bignOidToDER(oid_der, &oid_len, "1.2.112.0.2.0.34.101.31.81");
-		ERR_CALL_HANDLE(code, blobClose(state));
+		ERR_CALL_HANDLE(code, stackClose(stack));
 		ASSERT(oid_len == 11);
 	}
 	else
@@ -142,7 +144,7 @@ static err_t btokSign(octet sig[], const void* buf, size_t count,
 		bashHashStepG(hash, privkey_len, state);
 		code = bignOidToDER(oid_der, &oid_len, privkey_len == 48 ? 
 			"1.2.112.0.2.0.34.101.77.12" : "1.2.112.0.2.0.34.101.77.13");
-		ERR_CALL_HANDLE(code, blobClose(state));
+		ERR_CALL_HANDLE(code, stackClose(stack));
 		ASSERT(oid_len == 11);
 	}
 	// получить случайные числа
@@ -151,19 +153,25 @@ static err_t btokSign(octet sig[], const void* buf, size_t count,
 	else
 		t_len = 0;
 	// подписать
-	if (privkey_len == 24)
+	if (ctx)
+	{
+		ASSERT(privkey_len != 24);
+		code = bignSign2Ctx(sig, ctx, oid_der, oid_len, hash, privkey,
+			t, t_len);
+	}
+	else if (privkey_len == 24)
 		code = bign96Sign2(sig, params, oid_der, oid_len, hash, privkey,
 			t, t_len);
 	else
 		code = bignSign2(sig, params, oid_der, oid_len, hash, privkey,
 			t, t_len);
 	// завершить
-	blobClose(stack);
+	stackClose(stack);
 	return code;
 }
 
 static err_t btokVerify(const void* buf, size_t count, const octet sig[],
-	const octet pubkey[], size_t pubkey_len)
+	const octet pubkey[], size_t pubkey_len, const void* ctx)
 {
 	err_t code;
 	bign_params params[1];
@@ -178,7 +186,7 @@ static err_t btokVerify(const void* buf, size_t count, const octet sig[],
 	// загрузить параметры
 	code = btokParamsStd(params, pubkey_len / 2);
 	// создать и разметить стек
-	stack = blobCreate(pubkey_len / 2 +
+	stack = stackCreate(pubkey_len / 2 +
 		(pubkey_len <= 64 ? beltHash_keep() : bashHash_keep()));
 	if (!stack)
 		return ERR_OUTOFMEMORY;
@@ -191,7 +199,7 @@ static err_t btokVerify(const void* buf, size_t count, const octet sig[],
 		beltHashStepH(buf, count, state);
 		beltHashStepG2(hash, pubkey_len / 2, state);
 		code = bignOidToDER(oid_der, &oid_len, "1.2.112.0.2.0.34.101.31.81");
-		ERR_CALL_HANDLE(code, blobClose(state));
+		ERR_CALL_HANDLE(code, stackClose(stack));
 		ASSERT(oid_len == 11);
 	}
 	else
@@ -201,22 +209,30 @@ static err_t btokVerify(const void* buf, size_t count, const octet sig[],
 		bashHashStepG(hash, pubkey_len / 2, state);
 		code = bignOidToDER(oid_der, &oid_len, pubkey_len == 96 ? 
 			"1.2.112.0.2.0.34.101.77.12" : "1.2.112.0.2.0.34.101.77.13");
-		ERR_CALL_HANDLE(code, blobClose(state));
+		ERR_CALL_HANDLE(code, stackClose(stack));
 		ASSERT(oid_len == 11);
 	}
+	// проверить подпись на проверенном ранее ключе
+	if (ctx)
+	{
+		ASSERT(pubkey_len != 48);
+		code = bignVerifyCtx(ctx, oid_der, oid_len, hash, sig, pubkey);
+		stackClose(stack);
+		return code;
+	}
 	// проверить открытый ключ
 	if (pubkey_len == 48)
 		code = bign96PubkeyVal(params, pubkey);
 	else
 		code = bignPubkeyVal(params, pubkey);
-	ERR_CALL_HANDLE(code, blobClose(stack));
+	ERR_CALL_HANDLE(code, stackClose(stack));
 	// проверить подпись
 	if (pubkey_len == 48)
 		code = bign96Verify(params, oid_der, oid_len, hash, sig, pubkey);
 	else
 		code = bignVerify(params, oid_der, oid_len, hash, sig, pubkey);
 	// завершить
-	blobClose(stack);
+	stackClose(stack);
 	return code;
 }
 
@@ -450,32 +466,15 @@ SEQ[APPLICATION 33] CVCertificate
 *******************************************************************************
 */
 
-err_t btokCVCWrap(octet cert[], size_t* cert_len, btok_cvc_t* cvc,
-	const octet privkey[], size_t privkey_len)
+static err_t btokCVCWrapCtx(octet cert[], size_t* cert_len, btok_cvc_t* cvc,
+	const octet privkey[], size_t privkey_len, const void* ctx)
 {
 	err_t code;
 	der_anchor_t CVCert[1];
 	size_t count = 0;
 	size_t t;
-	// проверить входные данные
-	if (!memIsValid(cvc, sizeof(btok_cvc_t)) ||
-		privkey_len != 24 && 
-			privkey_len != 32 && privkey_len != 48 && privkey_len != 64 ||
-		!memIsValid(privkey, privkey_len) ||
-		!memIsNullOrValid(cert_len, O_PER_S))
-		return ERR_BAD_INPUT;
-	// построить открытый ключ
-	if (cvc->pubkey_len == 0)
-	{
-		code = btokPubkeyCalc(cvc->pubkey, privkey, privkey_len);
-		ERR_CALL_CHECK(code);
-		cvc->pubkey_len = 2 * privkey_len;
-		memSetZero(cvc->pubkey + cvc->pubkey_len,
-			sizeof(cvc->pubkey) - cvc->pubkey_len);
-	}
-	// проверить содержимое сертификата
-	code = btokCVCCheck(cvc);
-	ERR_CALL_CHECK(code);
+	// pre
+	ASSERT(btokCVCSeemsValid(cvc));
 	// начать кодирование...
 	t = derTSEQEncStart(CVCert, cert, count, 0x7F21);
 	ASSERT(t != SIZE_MAX);
@@ -485,7 +484,7 @@ err_t btokCVCWrap(octet cert[], size_t* cert_len, btok_cvc_t* cvc,
 	ASSERT(t != SIZE_MAX);
 	if (cert)
 	{
-		code = btokSign(cvc->sig, cert, t, privkey, privkey_len);
+		code = btokSign(cvc->sig, cert, t, privkey, privkey_len, ctx);
 		ERR_CALL_CHECK(code);
 	}
 	cert = cert ? cert + t : 0, count += t;
@@ -507,8 +506,35 @@ err_t btokCVCWrap(octet cert[], size_t* cert_len, btok_cvc_t* cvc,
 	return ERR_OK;
 }
 
-err_t btokCVCUnwrap(btok_cvc_t* cvc, const octet cert[], size_t cert_len,
-	const octet pubkey[], size_t pubkey_len)
+err_t btokCVCWrap(octet cert[], size_t* cert_len, btok_cvc_t* cvc,
+	const octet privkey[], size_t privkey_len)
+{
+	err_t code;
+	// проверить входные данные
+	if (!memIsValid(cvc, sizeof(btok_cvc_t)) ||
+		privkey_len != 24 && 
+			privkey_len != 32 && privkey_len != 48 && privkey_len != 64 ||
+		!memIsValid(privkey, privkey_len) ||
+		!memIsNullOrValid(cert_len, O_PER_S))
+		return ERR_BAD_INPUT;
+	// построить открытый ключ
+	if (cvc->pubkey_len == 0)
+	{
+		code = btokPubkeyCalc(cvc->pubkey, privkey, privkey_len);
+		ERR_CALL_CHECK(code);
+		cvc->pubkey_len = 2 * privkey_len;
+		memSetZero(cvc->pubkey + cvc->pubkey_len,
+			sizeof(cvc->pubkey) - cvc->pubkey_len);
+	}
+	// проверить содержимое сертификата
+	code = btokCVCCheck(cvc);
+	ERR_CALL_CHECK(code);
+	// создать сертификат
+	return btokCVCWrapCtx(cert, cert_len, cvc, privkey, privkey_len, 0);
+}
+
+static err_t btokCVCUnwrapCtx(btok_cvc_t* cvc, const octet cert[],
+	size_t cert_len, const octet pubkey[], size_t pubkey_len, const void* ctx)
 {
 	err_t code;
 	der_anchor_t CVCert[1];
@@ -561,7 +587,7 @@ err_t btokCVCUnwrap(btok_cvc_t* cvc, const octet cert[], size_t cert_len,
 	// ...проверить подпись...
 	if (pubkey_len)
 	{
-		code = btokVerify(body, body_len, cvc->sig, pubkey, pubkey_len);
+		code = btokVerify(body, body_len, cvc->sig, pubkey, pubkey_len, ctx);
 		ERR_CALL_CHECK(code);
 	}
 	// ...завершить декодирование
@@ -575,6 +601,171 @@ err_t btokCVCUnwrap(btok_cvc_t* cvc, const octet cert[], size_t cert_len,
 	return btokCVCCheck(cvc);
 }
 
+err_t btokCVCUnwrap(btok_cvc_t* cvc, const octet cert[], size_t cert_len,
+	const octet pubkey[], size_t pubkey_len)
+{
+	return btokCVCUnwrapCtx(cvc, cert, cert_len, pubkey, pubkey_len, 0);
+}
+
+/*
+*******************************************************************************
+Представление CV-сертификата
+
+Представление строится тем же проходом по DER-коду, что и в
+btokCVCBodyDec() / btokCVCUnwrapCtx(), но значения полей не копируются:
+запоминаются их смещения относительно начала сертификата.
+*******************************************************************************
+*/
+
+static size_t btokCVCBodyView(btok_cvc_view_t* view, const octet cert[],
+	const octet body[], size_t count)
+{
+	der_anchor_t CertBody[1];
+	der_anchor_t PubKey[1];
+	der_anchor_t CertHAT[1];
+	der_anchor_t CVExt[1];
+	der_anchor_t DDT[1];
+	const octet* ptr = body;
+	const octet* val;
+	size_t len;
+	// начать разбор...
+	derDecStep(derTSEQDecStart(CertBody, ptr, count, 0x7F4E), ptr, count);
+	derDecStep(derTSIZEDec2(ptr, count, 0x5F29, 0), ptr, count);
+	// ...authority...
+	derDecStep(derDec2(&val, &len, ptr, count, 0x42), ptr, count);
+	if (len < 8 || len > 12)
+		return SIZE_MAX;
+	view->authority = (size_t)(val - cert), view->authority_len = len;
+	// ...PubKey...
+	derDecStep(derTSEQDecStart(PubKey, ptr, count, 0x7F49), ptr, count);
+	derDecStep(derOIDDec2(ptr, count, oid_bign_pubkey), ptr, count);
+	derDecStep(derDec2(&val, &len, ptr, count, 0x03), ptr, count);
+	if (len != 49 && len != 65 && len != 97 && len != 129 || val[0] != 0)
+		return SIZE_MAX;
+	view->pubkey = (size_t)(val + 1 - cert), view->pubkey_len = len - 1;
+	derDecStep(derTSEQDecStop(ptr, PubKey), ptr, count);
+	// ...holder...
+	derDecStep(derDec2(&val, &len, ptr, count, 0x5F20), ptr, count);
+	if (len < 8 || len > 12)
+		return SIZE_MAX;
+	view->holder = (size_t)(val - cert), view->holder_len = len;
+	// ...CertHAT...
+	if (derStartsWith(ptr, count, 0x7F4C))
+	{
+		derDecStep(derTSEQDecStart(CertHAT, ptr, count, 0x7F4C), ptr, count);
+		derDecStep(derOIDDec2(ptr, count, oid_eid_access), ptr, count);
+		derDecStep(derDec3(&val, ptr, count, 0x04, 5), ptr, count);
+		view->hat_eid = (size_t)(val - cert);
+		derDecStep(derTSEQDecStop(ptr, CertHAT), ptr, count);
+	}
+	// ...from/until...
+	derDecStep(derDec3(&val, ptr, count, 0x5F25, 6), ptr, count);
+	view->from = (size_t)(val - cert);
+	derDecStep(derDec3(&val, ptr, count, 0x5F24, 6), ptr, count);
+	view->until = (size_t)(val - cert);
+	// ...CVExt...
+	if (derStartsWith(ptr, count, 0x65))
+	{
+		derDecStep(derTSEQDecStart(CVExt, ptr, count, 0x65), ptr, count);
+		derDecStep(derTSEQDecStart(DDT, ptr, count, 0x73), ptr, count);
+		derDecStep(derOIDDec2(ptr, count, oid_esign_auth_ext), ptr, count);
+		derDecStep(derTSEQDecStart(CertHAT, ptr, count, 0x7F4C), ptr, count);
+		derDecStep(derOIDDec2(ptr, count, oid_esign_access), ptr, count);
+		derDecStep(derDec3(&val, ptr, count, 0x04, 2), ptr, count);
+		view->hat_esign = (size_t)(val - cert);
+		derDecStep(derTSEQDecStop(ptr, CertHAT), ptr, count);
+		derDecStep(derTSEQDecStop(ptr, DDT), ptr, count);
+		derDecStep(derTSEQDecStop(ptr, CVExt), ptr, count);
+	}
+	// ...завершить разбор
+	derDecStep(derTSEQDecStop(ptr, CertBody), ptr, count);
+	return ptr - body;
+}
+
+err_t btokCVCView(btok_cvc_view_t* view, const octet cert[], size_t cert_len)
+{
+	der_anchor_t CVCert[1];
+	const octet* ptr = cert;
+	const octet* val;
+	size_t len;
+	size_t t;
+	// проверить входные данные
+	if (!memIsValid(view, sizeof(btok_cvc_view_t)) ||
+		!memIsValid(cert, cert_len))
+		return ERR_BAD_INPUT;
+	memSetZero(view, sizeof(btok_cvc_view_t));
+	// начать разбор...
+	t = derTSEQDecStart(CVCert, ptr, cert_len, 0x7F21);
+	if (t == SIZE_MAX)
+		return ERR_BAD_FORMAT;
+	ptr += t, cert_len -= t;
+	// ...основная часть...
+	t = btokCVCBodyView(view, cert, ptr, cert_len);
+	if (t == SIZE_MAX)
+		return ERR_BAD_FORMAT;
+	view->body = (size_t)(ptr - cert), view->body_len = t;
+	ptr += t, cert_len -= t;
+	// ...подпись...
+	t = derDec2(&val, &len, ptr, cert_len, 0x5F37);
+	if (t == SIZE_MAX || len != 34 && len != 48 && len != 72 && len != 96)
+		return ERR_BAD_FORMAT;
+	view->sig = (size_t)(val - cert), view->sig_len = len;
+	ptr += t, cert_len -= t;
+	// ...завершить разбор
+	t = derTSEQDecStop(ptr, CVCert);
+	if (t == SIZE_MAX || t != cert_len)
+		return ERR_BAD_FORMAT;
+	return ERR_OK;
+}
+
+void btokCVCViewAuthority(char authority[13], const btok_cvc_view_t* view,
+	const octet cert[])
+{
+	ASSERT(memIsValid(view, sizeof(btok_cvc_view_t)));
+	ASSERT(view->authority_len <= 12);
+	ASSERT(memIsValid(authority, view->authority_len + 1));
+	memCopy(authority, cert + view->authority, view->authority_len);
+	authority[view->authority_len] = 0;
+}
+
+void btokCVCViewHolder(char holder[13], const btok_cvc_view_t* view,
+	const octet cert[])
+{
+	ASSERT(memIsValid(view, sizeof(btok_cvc_view_t)));
+	ASSERT(view->holder_len <= 12);
+	ASSERT(memIsValid(holder, view->holder_len + 1));
+	memCopy(holder, cert + view->holder, view->holder_len);
+	holder[view->holder_len] = 0;
+}
+
+bool_t btokCVCViewIsHolder(const btok_cvc_view_t* view, const octet cert[],
+	const char* name)
+{
+	ASSERT(memIsValid(view, sizeof(btok_cvc_view_t)));
+	ASSERT(strIsValid(name));
+	return strLen(name) == view->holder_len &&
+		memEq(cert + view->holder, name, view->holder_len);
+}
+
+err_t btokCVCViewVerify(const btok_cvc_view_t* view, const octet cert[],
+	const octet pubkey[], size_t pubkey_len)
+{
+	// проверить входные данные
+	if (!memIsValid(view, sizeof(btok_cvc_view_t)) ||
+		pubkey_len != 48 && pubkey_len != 64 &&
+			pubkey_len != 96 && pubkey_len != 128 ||
+		!memIsValid(pubkey, pubkey_len) ||
+		!memIsValid(cert, view->sig + view->sig_len) ||
+		!memIsValid(cert, view->body + view->body_len))
+		return ERR_BAD_INPUT;
+	// длина подписи соответствует ключу?
+	if (view->sig_len != (pubkey_len == 48 ? 34 : pubkey_len - pubkey_len / 4))
+		return ERR_BAD_SIG;
+	// проверить подпись
+	return btokVerify(cert + view->body, view->body_len, cert + view->sig,
+		pubkey, pubkey_len, 0);
+}
+
 /*
 *******************************************************************************
 Выпуск CV-сертификата
@@ -588,22 +779,143 @@ err_t btokCVCIss(octet cert[], size_t* cert_len, btok_cvc_t* cvc,
 	err_t code;
 	btok_cvc_t* cvca;
 	// разобрать сертификат издателя
-	cvca = (btok_cvc_t*)blobCreate(sizeof(btok_cvc_t));
+	cvca = (btok_cvc_t*)stackCreate(sizeof(btok_cvc_t));
 	if (!cvca)
 		return ERR_OUTOFMEMORY;
 	code = btokCVCUnwrap(cvca, certa, certa_len, 0, 0);
-	ERR_CALL_HANDLE(code, blobClose(cvca));
+	ERR_CALL_HANDLE(code, stackClose(cvca));
 	// проверить содержимое выпускаемого сертификата
 	code = btokCVCCheck2(cvc, cvca);
-	ERR_CALL_HANDLE(code, blobClose(cvca));
+	ERR_CALL_HANDLE(code, stackClose(cvca));
 	// проверить ключи издателя
 	code = btokKeypairVal(privkeya, privkeya_len, cvca->pubkey,
 		cvca->pubkey_len);
-	ERR_CALL_HANDLE(code, blobClose(cvca));
+	ERR_CALL_HANDLE(code, stackClose(cvca));
 	// создать сертификат
 	code = btokCVCWrap(cert, cert_len, cvc, privkeya, privkeya_len);
 	// завершить
-	blobClose(cvca);
+	stackClose(cvca);
+	return code;
+}
+
+/*
+*******************************************************************************
+Пакетный выпуск CV-сертификатов
+
+Сертификат издателя разбирается, а ключи издателя проверяются однократно.
+Для ключей на кривых bign-curveXXXv1 однократно строится контекст bign
+(см. bignCtxStart()), подписи вырабатываются с помощью bignSign2Ctx().
+
+Содержание сертификатов проверяется и длины сертификатов определяются
+последовательно. Затем для каждого сертификата ставится задача
+btokCVCIssTask(), которая кодирует и подписывает сертификат в отведенной
+ему части выходного буфера. Задачи выполняются в пуле потоков pool или,
+если pool == 0, последовательно.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	btok_cvc_t* cvc;			/*< содержание сертификата */
+	octet* cert;				/*< сертификат */
+	const octet* privkeya;		/*< личный ключ издателя */
+	size_t privkeya_len;		/*< длина privkeya в октетах */
+	const void* ctx;			/*< контекст bign */
+	err_t code;					/*< код ошибки */
+} btok_iss_task_st;
+
+static void btokCVCIssTask(void* arg, void* scratch)
+{
+	btok_iss_task_st* task = (btok_iss_task_st*)arg;
+	task->code = btokCVCWrapCtx(task->cert, 0, task->cvc, task->privkeya,
+		task->privkeya_len, task->ctx);
+}
+
+err_t btokCVCIssBatch(octet certs[], size_t cert_len[], size_t count,
+	btok_cvc_t cvcs[], const octet certa[], size_t certa_len,
+	const octet privkeya[], size_t privkeya_len, mt_pool_t* pool)
+{
+	err_t code;
+	void* state;
+	btok_cvc_t* cvca;
+	void* ctx = 0;
+	btok_iss_task_st* tasks;
+	size_t i, pos;
+	// входной контроль
+	if (count == 0 || count > SIZE_MAX / sizeof(btok_iss_task_st) ||
+		!memIsValid(cvcs, count * sizeof(btok_cvc_t)) ||
+		!memIsValid(cert_len, count * O_PER_S) ||
+		privkeya_len != 24 && privkeya_len != 32 && 
+			privkeya_len != 48 && privkeya_len != 64 ||
+		!memIsValid(privkeya, privkeya_len))
+		return ERR_BAD_INPUT;
+	// выделить и разметить память
+	state = blobCreate(sizeof(btok_cvc_t) + count * sizeof(btok_iss_task_st) +
+		(privkeya_len == 24 ? 0 : bignCtx_keep(privkeya_len * 4)));
+	if (!state)
+		return ERR_OUTOFMEMORY;
+	tasks = (btok_iss_task_st*)state;
+	cvca = (btok_cvc_t*)(tasks + count);
+	if (privkeya_len != 24)
+		ctx = cvca + 1;
+	// разобрать сертификат издателя
+	code = btokCVCUnwrap(cvca, certa, certa_len, 0, 0);
+	ERR_CALL_HANDLE(code, blobClose(state));
+	// проверить ключи издателя
+	code = btokKeypairVal(privkeya, privkeya_len, cvca->pubkey,
+		cvca->pubkey_len);
+	ERR_CALL_HANDLE(code, blobClose(state));
+	// построить контекст
+	if (ctx)
+	{
+		bign_params params[1];
+		code = btokParamsStd(params, privkeya_len);
+		ERR_CALL_HANDLE(code, blobClose(state));
+		code = bignCtxStart(ctx, params);
+		ERR_CALL_HANDLE(code, blobClose(state));
+	}
+	// проверить содержание сертификатов и определить их длины
+	for (i = pos = 0; i < count; ++i)
+	{
+		code = btokCVCCheck2(cvcs + i, cvca);
+		ERR_CALL_HANDLE(code, blobClose(state));
+		code = btokCVCWrapCtx(0, cert_len + i, cvcs + i, privkeya,
+			privkeya_len, ctx);
+		ERR_CALL_HANDLE(code, blobClose(state));
+		tasks[i].cvc = cvcs + i;
+		tasks[i].cert = certs ? certs + pos : 0;
+		tasks[i].privkeya = privkeya;
+		tasks[i].privkeya_len = privkeya_len;
+		tasks[i].ctx = ctx;
+		tasks[i].code = ERR_OK;
+		pos += cert_len[i];
+	}
+	// только длины?
+	if (!certs)
+	{
+		blobClose(state);
+		return ERR_OK;
+	}
+	if (!memIsValid(certs, pos))
+	{
+		blobClose(state);
+		return ERR_BAD_INPUT;
+	}
+	// выпустить сертификаты
+	if (pool)
+	{
+		for (i = 0; i < count; ++i)
+			mtPoolSubmit(pool, btokCVCIssTask, tasks + i);
+		mtPoolWait(pool);
+	}
+	else
+		for (i = 0; i < count; ++i)
+			btokCVCIssTask(tasks + i, 0);
+	// собрать коды ошибок
+	for (i = 0; i < count && code == ERR_OK; ++i)
+		code = tasks[i].code;
+	// завершить
+	blobClose(state);
 	return code;
 }
 
@@ -637,19 +949,19 @@ err_t btokCVCVal(const octet cert[], size_t cert_len,
 	if (!memIsNullOrValid(date, 6))
 		return ERR_BAD_INPUT;
 	// выделить и разметить память
-	stack = blobCreate(2 * sizeof(btok_cvc_t));
+	stack = stackCreate(2 * sizeof(btok_cvc_t));
 	if (!stack)
 		return ERR_OUTOFMEMORY;
 	cvc = (btok_cvc_t*)stack;
 	cvca = cvc + 1;
 	// разобрать сертификаты
 	code = btokCVCUnwrap(cvca, certa, certa_len, 0, 0);
-	ERR_CALL_HANDLE(code, blobClose(stack));
+	ERR_CALL_HANDLE(code, stackClose(stack));
 	code = btokCVCUnwrap(cvc, cert, cert_len, cvca->pubkey, cvca->pubkey_len);
-	ERR_CALL_HANDLE(code, blobClose(stack));
+	ERR_CALL_HANDLE(code, stackClose(stack));
 	// проверить соответствие
 	code = btokCVCCheck2(cvc, cvca);
-	ERR_CALL_HANDLE(code, blobClose(stack));
+	ERR_CALL_HANDLE(code, stackClose(stack));
 	// проверить дату
 	if (date)
 	{
@@ -659,7 +971,7 @@ err_t btokCVCVal(const octet cert[], size_t cert_len,
 			code = ERR_OUTOFRANGE;
 	}
 	// завершить
-	blobClose(stack);
+	stackClose(stack);
 	return code;
 }
 
@@ -676,17 +988,17 @@ err_t btokCVCVal2(btok_cvc_t* cvc, const octet cert[], size_t cert_len,
 	// выделить память
 	if (!cvc)
 	{
-		stack = blobCreate(sizeof(btok_cvc_t));
+		stack = stackCreate(sizeof(btok_cvc_t));
 		if (!stack)
 			return ERR_OUTOFMEMORY;
 		cvc = (btok_cvc_t*)stack;
 	}
 	// разобрать сертификат
 	code = btokCVCUnwrap(cvc, cert, cert_len, cvca->pubkey, cvca->pubkey_len);
-	ERR_CALL_HANDLE(code, blobClose(stack));
+	ERR_CALL_HANDLE(code, stackClose(stack));
 	// проверить соответствие
 	code = btokCVCCheck2(cvc, cvca);
-	ERR_CALL_HANDLE(code, blobClose(stack));
+	ERR_CALL_HANDLE(code, stackClose(stack));
 	// проверить дату
 	if (date)
 	{
@@ -696,7 +1008,7 @@ err_t btokCVCVal2(btok_cvc_t* cvc, const octet cert[], size_t cert_len,
 			code = ERR_OUTOFRANGE;
 	}
 	// завершить
-	blobClose(stack);
+	stackClose(stack);
 	return code;
 }
 
@@ -712,15 +1024,267 @@ err_t btokCVCMatch(const octet cert[], size_t cert_len, const octet privkey[],
 	err_t code;
 	btok_cvc_t* cvc;
 	// выделить память
-	cvc = (btok_cvc_t*)blobCreate(sizeof(btok_cvc_t));
+	cvc = (btok_cvc_t*)stackCreate(sizeof(btok_cvc_t));
 	if (!cvc)
 		return ERR_OUTOFMEMORY;
 	// разобрать сертификат
 	code = btokCVCUnwrap(cvc, cert, cert_len, 0, 0);
-	ERR_CALL_HANDLE(code, blobClose(cvc));
+	ERR_CALL_HANDLE(code, stackClose(cvc));
 	// проверить соответствие
 	code = btokKeypairVal(privkey, privkey_len, cvc->pubkey, cvc->pubkey_len);
 	// завершить
-	blobClose(cvc);
+	stackClose(cvc);
+	return code;
+}
+
+/*
+*******************************************************************************
+Хранилище якорей
+
+Якоря хранятся в массиве st->anchor, упорядоченном по именам владельцев.
+Издатель проверяемого сертификата находится двоичным поиском.
+
+Открытые ключи якорей проверяются однократно при добавлении. Для ключей
+на кривых bign-curveXXXv1 строятся (также однократно) контексты bign
+(см. bignCtxStart()), подписи проверяются с помощью bignVerifyCtx().
+Для ключей на кривой bign-curve192v1 контекст не строится.
+
+В кэше st->hit сохраняются хэш-значения (belt-hash) успешно проверенных
+сертификатов и сроки их действия. Для сертификата, найденного в кэше,
+подпись и соответствие издателю повторно не проверяются. Элемент кэша
+освобождается, если на дату проверки срок действия сертификата истек.
+При отсутствии свободных элементов вытесняется элемент st->next (по кругу).
+*******************************************************************************
+*/
+
+typedef struct
+{
+	octet hash[32];			/*< хэш-значение сертификата */
+	octet from[6];			/*< дата начала действия */
+	octet until[6];			/*< дата окончания действия */
+	bool_t used;			/*< элемент занят? */
+} btok_cvc_hit_st;
+
+typedef struct
+{
+	size_t anchors;			/*< емкость массива якорей */
+	size_t count;			/*< число якорей */
+	size_t cache;			/*< число элементов кэша */
+	size_t next;			/*< вытесняемый элемент кэша */
+	btok_cvc_t* anchor;		/*< якоря */
+	btok_cvc_hit_st* hit;	/*< кэш */
+	void* ctx[3];			/*< контексты bign (l = 128, 192, 256) */
+	bool_t ready[3];		/*< контексты построены? */
+	octet data[];			/*< память для якорей, кэша и контекстов */
+} btok_cvc_store_st;
+
+#define btokCVCStoreAlign(size)\
+	(((size) + sizeof(word) - 1) / sizeof(word) * sizeof(word))
+
+size_t btokCVCStore_keep(size_t anchors, size_t cache)
+{
+	return btokCVCStoreAlign(sizeof(btok_cvc_store_st)) +
+		anchors * sizeof(btok_cvc_t) + cache * sizeof(btok_cvc_hit_st) +
+		btokCVCStoreAlign(bignCtx_keep(128)) +
+		btokCVCStoreAlign(bignCtx_keep(192)) +
+		btokCVCStoreAlign(bignCtx_keep(256));
+}
+
+err_t btokCVCStoreStart(void* state, size_t anchors, size_t cache)
+{
+	btok_cvc_store_st* st = (btok_cvc_store_st*)state;
+	octet* ptr;
+	// входной контроль
+	if (anchors == 0 ||
+		!memIsValid(state, btokCVCStore_keep(anchors, cache)))
+		return ERR_BAD_INPUT;
+	// разметить память
+	memSetZero(st, btokCVCStore_keep(anchors, cache));
+	st->anchors = anchors, st->cache = cache;
+	ptr = (octet*)st + btokCVCStoreAlign(sizeof(btok_cvc_store_st));
+	st->ctx[0] = ptr, ptr += btokCVCStoreAlign(bignCtx_keep(128));
+	st->ctx[1] = ptr, ptr += btokCVCStoreAlign(bignCtx_keep(192));
+	st->ctx[2] = ptr, ptr += btokCVCStoreAlign(bignCtx_keep(256));
+	st->anchor = (btok_cvc_t*)ptr, ptr += anchors * sizeof(btok_cvc_t);
+	st->hit = (btok_cvc_hit_st*)ptr;
+	return ERR_OK;
+}
+
+static size_t btokCVCStoreFind(const btok_cvc_store_st* st, const char* name)
+{
+	size_t lo = 0, hi = st->count;
+	// двоичный поиск: позиция вставки или совпадения
+	while (lo < hi)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+		if (strCmp(st->anchor[mid].holder, name) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static const btok_cvc_t* btokCVCStoreGet(const btok_cvc_store_st* st,
+	const char* name)
+{
+	size_t pos = btokCVCStoreFind(st, name);
+	if (pos < st->count && strEq(st->anchor[pos].holder, name))
+		return st->anchor + pos;
+	return 0;
+}
+
+static const void* btokCVCStoreCtx(const btok_cvc_store_st* st,
+	size_t pubkey_len)
+{
+	ASSERT(pubkey_len == 48 || pubkey_len == 64 || 
+		pubkey_len == 96 || pubkey_len == 128);
+	if (pubkey_len == 48 || !st->ready[pubkey_len / 32 - 2])
+		return 0;
+	return st->ctx[pubkey_len / 32 - 2];
+}
+
+err_t btokCVCStoreAdd2(void* state, const btok_cvc_t* cvca)
+{
+	btok_cvc_store_st* st = (btok_cvc_store_st*)state;
+	err_t code;
+	size_t pos;
+	// входной контроль
+	if (!memIsValid(st, sizeof(btok_cvc_store_st)) ||
+		!memIsValid(state, btokCVCStore_keep(st->anchors, st->cache)))
+		return ERR_BAD_INPUT;
+	// проверить якорь (в том числе открытый ключ)
+	code = btokCVCCheck(cvca);
+	ERR_CALL_CHECK(code);
+	// найти позицию
+	pos = btokCVCStoreFind(st, cvca->holder);
+	if (pos < st->count && strEq(st->anchor[pos].holder, cvca->holder))
+		return ERR_BAD_ANCHOR;
+	if (st->count == st->anchors)
+		return ERR_OUTOFMEMORY;
+	// построить контекст
+	if (cvca->pubkey_len != 48 && !st->ready[cvca->pubkey_len / 32 - 2])
+	{
+		bign_params params[1];
+		code = btokParamsStd(params, cvca->pubkey_len / 2);
+		ERR_CALL_CHECK(code);
+		code = bignCtxStart(st->ctx[cvca->pubkey_len / 32 - 2], params);
+		ERR_CALL_CHECK(code);
+		st->ready[cvca->pubkey_len / 32 - 2] = TRUE;
+	}
+	// вставить якорь
+	memMove(st->anchor + pos + 1, st->anchor + pos,
+		(st->count - pos) * sizeof(btok_cvc_t));
+	memCopy(st->anchor + pos, cvca, sizeof(btok_cvc_t));
+	st->count++;
+	return ERR_OK;
+}
+
+err_t btokCVCStoreAdd(void* state, const octet certa[], size_t certa_len)
+{
+	err_t code;
+	btok_cvc_t* cvca;
+	// выделить память
+	cvca = (btok_cvc_t*)stackCreate(sizeof(btok_cvc_t));
+	if (!cvca)
+		return ERR_OUTOFMEMORY;
+	// разобрать сертификат
+	code = btokCVCUnwrap(cvca, certa, certa_len, 0, 0);
+	ERR_CALL_HANDLE(code, stackClose(cvca));
+	// добавить якорь
+	code = btokCVCStoreAdd2(state, cvca);
+	// завершить
+	stackClose(cvca);
+	return code;
+}
+
+err_t btokCVCStoreVal(btok_cvc_t* cvc, void* state, const octet cert[],
+	size_t cert_len, const octet* date)
+{
+	btok_cvc_store_st* st = (btok_cvc_store_st*)state;
+	err_t code;
+	void* stack = 0;
+	const btok_cvc_t* cvca;
+	btok_cvc_hit_st* hit = 0;
+	btok_cvc_view_t view[1];
+	char authority[13];
+	octet hash[32];
+	size_t i;
+	// входной контроль
+	if (!memIsNullOrValid(cvc, sizeof(btok_cvc_t)) || 
+		!memIsValid(st, sizeof(btok_cvc_store_st)) ||
+		!memIsValid(state, btokCVCStore_keep(st->anchors, st->cache)) ||
+		!memIsValid(cert, cert_len) ||
+		!memIsNullOrValid(date, 6))
+		return ERR_BAD_INPUT;
+	if (date && !tmDateIsValid2(date))
+		return ERR_BAD_DATE;
+	// искать в кэше
+	code = beltHash(hash, cert, cert_len);
+	ERR_CALL_CHECK(code);
+	for (i = 0; i < st->cache; ++i)
+		if (st->hit[i].used && memEq(st->hit[i].hash, hash, 32))
+		{
+			hit = st->hit + i;
+			break;
+		}
+	// сертификат из кэша: разобрать без проверки подписи
+	if (hit && cvc)
+	{
+		code = btokCVCUnwrap(cvc, cert, cert_len, 0, 0);
+		ERR_CALL_CHECK(code);
+	}
+	if (!hit)
+	{
+		// найти издателя по представлению (без разбора полей)
+		code = btokCVCView(view, cert, cert_len);
+		ERR_CALL_CHECK(code);
+		btokCVCViewAuthority(authority, view, cert);
+		cvca = btokCVCStoreGet(st, authority);
+		if (!cvca)
+			return ERR_BAD_ANCHOR;
+		// выделить память
+		if (!cvc)
+		{
+			stack = stackCreate(sizeof(btok_cvc_t));
+			if (!stack)
+				return ERR_OUTOFMEMORY;
+			cvc = (btok_cvc_t*)stack;
+		}
+		// разобрать с проверкой подписи
+		code = btokCVCUnwrapCtx(cvc, cert, cert_len, cvca->pubkey,
+			cvca->pubkey_len, btokCVCStoreCtx(st, cvca->pubkey_len));
+		ERR_CALL_HANDLE(code, stackClose(stack));
+		// проверить соответствие
+		code = btokCVCCheck2(cvc, cvca);
+		ERR_CALL_HANDLE(code, stackClose(stack));
+		// сохранить в кэше
+		if (st->cache)
+		{
+			for (i = 0; i < st->cache && st->hit[i].used; ++i);
+			if (i == st->cache)
+				i = st->next, st->next = (st->next + 1) % st->cache;
+			memCopy(st->hit[i].hash, hash, 32);
+			memCopy(st->hit[i].from, cvc->from, 6);
+			memCopy(st->hit[i].until, cvc->until, 6);
+			st->hit[i].used = TRUE;
+		}
+	}
+	// проверить дату
+	if (date)
+	{
+		const octet* from = hit ? hit->from : cvc->from;
+		const octet* until = hit ? hit->until : cvc->until;
+		if (!tmDateLeq2(date, until))
+		{
+			if (hit)
+				hit->used = FALSE;
+			code = ERR_OUTOFRANGE;
+		}
+		else if (!tmDateLeq2(from, date))
+			code = ERR_OUTOFRANGE;
+	}
+	// завершить
+	stackClose(stack);
 	return code;
 }
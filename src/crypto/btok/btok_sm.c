@@ -4,7 +4,7 @@
 \brief STB 34.101.79 (btok): Secure Messaging
 \project bee2 [cryptographic library]
 \created 2022.10.31
-\version 2023.06.19
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -39,8 +39,8 @@ typedef struct {
 
 size_t btokSM_keep()
 {
-	return sizeof(btok_sm_st) + utilMax(3,
-		beltKRP_keep(), beltMAC_keep(), beltCFB_keep());
+	return sizeof(btok_sm_st) + utilMax(2,
+		beltKRP_keep(), beltMAC_keep() + beltCFB_keep());
 }
 
 void btokSMStart(void* state, const octet key[32])
@@ -78,26 +78,153 @@ APDU
 *******************************************************************************
 */
 
-static size_t apduCmdCDFLenLen(const apdu_cmd_t* cmd)
+static size_t apduCmdRDFLenLen(size_t cdf_len, size_t rdf_len)
 {
-	ASSERT(apduCmdIsValid(cmd));
-	if (cmd->cdf_len == 0)
+	ASSERT(cdf_len < 65536 && rdf_len <= 65536);
+	if (rdf_len == 0)
 		return 0;
-	if (cmd->cdf_len < 256 && cmd->rdf_len <= 256)
+	if (cdf_len < 256 && rdf_len <= 256)
 		return 1;
+	if (cdf_len != 0)
+		return 2;
 	return 3;
 }
 
-static size_t apduCmdRDFLenLen(const apdu_cmd_t* cmd)
+#define apduCmdSizeof(cmd) (sizeof(apdu_cmd_t) + (cmd)->cdf_len)
+
+/*
+*******************************************************************************
+Защита команды на месте
+
+Функция btokSMCmdLayout() определяет длину защищенной команды, длину Lc* и
+позицию Y в защищенной команде. Шифртекст Y занимает в защищенной команде
+позицию открытого текста CDF, поэтому если CDF заранее размещено в этой
+позиции (см. btokSMCmdCDFOffset()), то зашифрование выполняется на месте.
+
+Зашифрование CDF и вычисление имитовставки объединены в один проход:
+данные обрабатываются фрагментами по BTOK_SM_CHUNK октетов, и каждый
+фрагмент сразу после зашифрования обрабатывается belt-mac, пока находится
+в кэше. Состояния belt-cfb и belt-mac размещаются в st->stack рядом.
+*******************************************************************************
+*/
+
+#define BTOK_SM_CHUNK 256
+
+static size_t btokSMCmdLayout(size_t* cdf_len_len, size_t* cdf_offset,
+	size_t cdf_len, size_t rdf_len)
 {
-	ASSERT(apduCmdIsValid(cmd));
-	if (cmd->rdf_len == 0)
-		return 0;
-	if (cmd->cdf_len < 256 && cmd->rdf_len <= 256)
-		return 1;
-	if (cmd->cdf_len != 0)
-		return 2;
-	return 3;
+	size_t len = 0;
+	size_t c;
+	ASSERT(cdf_len < 65536 && rdf_len <= 65536);
+	// длина нового поля cdf
+	if (cdf_len)
+	{
+		c = derTLEnc(0, 0x87, cdf_len + 1);
+		ASSERT(c != SIZE_MAX);
+		len += c + 1 + cdf_len;
+	}
+	if (rdf_len)
+	{
+		c = derEnc(0, 0x97, 0, apduCmdRDFLenLen(cdf_len, rdf_len));
+		ASSERT(c != SIZE_MAX);
+		len += c;
+	}
+	c = derEnc(0, 0x8E, 0, 8);
+	ASSERT(c != SIZE_MAX);
+	len += c;
+	// длина длины нового поля cdf
+	c = len < 256 ? 1 : 3;
+	if (cdf_len_len)
+		*cdf_len_len = c;
+	// позиция зашифрованного cdf
+	if (cdf_offset)
+	{
+		*cdf_offset = 4 + c;
+		if (cdf_len)
+			*cdf_offset += derTLEnc(0, 0x87, cdf_len + 1) + 1;
+	}
+	// общая длина
+	return 4 + c + len + 1;
+}
+
+static void btokSMCmdProtect(octet apdu[], const octet hdr[4],
+	size_t cdf_len, size_t rdf_len, btok_sm_st* st)
+{
+	void* mac_state = st->stack;
+	void* cfb_state = st->stack + beltMAC_keep();
+	size_t len;
+	size_t cdf_len_len;
+	size_t offset;
+	size_t c;
+	// разметка
+	len = btokSMCmdLayout(&cdf_len_len, &offset, cdf_len, rdf_len);
+	len -= 4 + cdf_len_len + 1;
+	// кодировать заголовок
+	apdu[0] = hdr[0] | 0x04, apdu[1] = hdr[1];
+	apdu[2] = hdr[2], apdu[3] = hdr[3];
+	// кодировать Lc*
+	ASSERT(cdf_len_len == 1 || cdf_len_len == 3);
+	if (cdf_len_len == 1)
+		apdu[4] = (octet)len;
+	else
+	{
+		apdu[4] = 0;
+		apdu[5] = (octet)(len / 256);
+		apdu[6] = (octet)len;
+	}
+	// начать вычисление имитовставки
+	beltMACStart(mac_state, st->key1, 32);
+	beltMACStepA(st->ctr, 16, mac_state);
+	beltMACStepA(apdu, 4, mac_state);
+	// зашифровать cdf и обработать шифртекст
+	if (cdf_len)
+	{
+		c = derTLEnc(apdu + 4 + cdf_len_len, 0x87, cdf_len + 1);
+		ASSERT(c != SIZE_MAX);
+		apdu[4 + cdf_len_len + c] = 0x02;
+		ASSERT(offset == 4 + cdf_len_len + c + 1);
+		beltMACStepA(apdu + 4 + cdf_len_len, c + 1, mac_state);
+		beltCFBStart(cfb_state, st->key2, 32, st->ctr);
+		for (len = cdf_len; len; len -= c, offset += c)
+		{
+			c = MIN2(len, BTOK_SM_CHUNK);
+			beltCFBStepE(apdu + offset, c, cfb_state);
+			beltMACStepA(apdu + offset, c, mac_state);
+		}
+	}
+	// кодировать длину rdf
+	if (rdf_len)
+	{
+		size_t l = apduCmdRDFLenLen(cdf_len, rdf_len);
+		// кодировать TL
+		c = derTLEnc(apdu + offset, 0x97, l);
+		ASSERT(c != SIZE_MAX);
+		// кодировать значение
+		ASSERT(1 <= l && l <= 3);
+		if (l == 1)
+			apdu[offset + c] = (octet)rdf_len;
+		else if (l == 2)
+		{
+			apdu[offset + c] = (octet)(rdf_len / 256);
+			apdu[offset + c + 1] = (octet)rdf_len;
+		}
+		else
+		{
+			apdu[offset + c] = 0;
+			apdu[offset + c + 1] = (octet)(rdf_len / 256);
+			apdu[offset + c + 2] = (octet)rdf_len;
+		}
+		beltMACStepA(apdu + offset, c + l, mac_state);
+		offset += c + l;
+	}
+	// кодировать имитовставку
+	c = derTLEnc(apdu + offset, 0x8E, 8);
+	ASSERT(c != SIZE_MAX);
+	offset += c;
+	beltMACStepG(apdu + offset, mac_state);
+	offset += 8;
+	// кодировать Le*
+	apdu[offset] = 0;
 }
 
 /*
@@ -119,20 +246,20 @@ static size_t apduCmdRDFLenLen(const apdu_cmd_t* cmd)
 Le* всегда устанавливается в 0x00, а Lc* определяется обычным образом:
    len(Lc*) = 1, если len(CDF*) < 256, и len(Lc*) = 3 в противном случае.
 
+Команда не кодируется предварительно без защиты: данные cmd->cdf
+копируются сразу в позицию Y, после чего выполняется btokSMCmdProtect().
+
 \remark Минимальная длина защищенной команды:
   4 (hdr) + 1 (cdf_len_len) + 10 (mac) + 1 (Le*) = 16.
 *******************************************************************************
 */
 
-#define apduCmdSizeof(cmd) (sizeof(apdu_cmd_t) + (cmd)->cdf_len)
-
 err_t btokSMCmdWrap(octet apdu[], size_t* count, const apdu_cmd_t* cmd,
 	void* state)
 {
-	size_t cdf_len;
-	size_t cdf_len_len;
 	size_t offset;
-	size_t c;
+	size_t cdf_offset;
+	octet hdr[4];
 	btok_sm_st* st;
 	// pre
 	ASSERT(memIsNullOrValid(state, btokSM_keep()));
@@ -140,13 +267,13 @@ err_t btokSMCmdWrap(octet apdu[], size_t* count, const apdu_cmd_t* cmd,
 	// некорректная команда? команду нужно защитить, а она уже защищена?
 	if (!apduCmdIsValid(cmd) || state && (cmd->cla & 0x04))
 		return ERR_BAD_APDU;
-	// кодировать без защиты
-	offset = apduCmdEnc(apdu, cmd);
-	if (offset == SIZE_MAX)
-		return ERR_BAD_APDU;
 	// состояние не задано, т.е. защита не нужна?
 	if (!state)
 	{
+		// кодировать без защиты
+		offset = apduCmdEnc(apdu, cmd);
+		if (offset == SIZE_MAX)
+			return ERR_BAD_APDU;
 		if (count)
 		{
 			ASSERT(memIsDisjoint2(count, O_PER_S, cmd, apduCmdSizeof(cmd)));
@@ -155,27 +282,8 @@ err_t btokSMCmdWrap(octet apdu[], size_t* count, const apdu_cmd_t* cmd,
 		return ERR_OK;
 	}
 	ASSERT(memIsDisjoint2(state, btokSM_keep(), cmd, apduCmdSizeof(cmd)));
-	// новая длина cdf
-	cdf_len = cmd->cdf_len;
-	if (cmd->cdf_len)
-	{
-		c = derTLEnc(0, 0x87, cmd->cdf_len + 1);
-		ASSERT(c != SIZE_MAX);
-		cdf_len += c + 1;
-	}
-	if (cmd->rdf_len)
-	{
-		c = derEnc(0, 0x97, 0, apduCmdRDFLenLen(cmd));
-		ASSERT(c != SIZE_MAX);
-		cdf_len += c;
-	}
-	c = derEnc(0, 0x8E, 0, 8);
-	ASSERT(c != SIZE_MAX);
-	cdf_len += c;
-	// новая длина длины cdf
-	cdf_len_len = cdf_len < 256 ? 1 : 3;
 	// общая длина
-	offset = 4 + cdf_len_len + cdf_len + 1;
+	offset = btokSMCmdLayout(0, &cdf_offset, cmd->cdf_len, cmd->rdf_len);
 	// не задан выходной буфер, т.е. нужно определить только его длину?
 	if (!apdu)
 	{
@@ -193,95 +301,81 @@ err_t btokSMCmdWrap(octet apdu[], size_t* count, const apdu_cmd_t* cmd,
 	st = (btok_sm_st*)state;
 	if (st->ctr[0] % 2 != 1)
 		return ERR_BAD_LOGIC;
-	// уточнить заголовок
-	offset = 0;
-	apdu[0] |= 0x04;
-	offset += 4;
-	// перейти к cdf
-	offset += cdf_len_len;
-	// обработать cdf
-	if (cmd->cdf_len)
-	{
-		c = derTLEnc(0, 0x87, cmd->cdf_len + 1);
-		ASSERT(c != SIZE_MAX);
-		// подготовить значение
-		memMove(apdu + offset + c + 1,
-			apdu + 4 + apduCmdCDFLenLen(cmd), cmd->cdf_len);
-		apdu[offset + c] = 0x02;
-		// кодировать TL
-		c = derTLEnc(apdu + offset, 0x87, cmd->cdf_len + 1);
-		ASSERT(c != SIZE_MAX);
-		offset += c + 1;
-		// зашифровать
-		beltCFBStart(st->stack, st->key2, 32, st->ctr);
-		beltCFBStepE(apdu + offset, cmd->cdf_len, st->stack);
-		// дальше
-		offset += cmd->cdf_len;
-	}
-	// теперь можно перекодировать Lc
-	ASSERT(cdf_len_len == 1 || cdf_len_len == 3);
-	if (cdf_len_len == 1)
-		apdu[4] = (octet)cdf_len;
-	else
+	// разместить cdf и установить защиту
+	hdr[0] = cmd->cla, hdr[1] = cmd->ins, hdr[2] = cmd->p1, hdr[3] = cmd->p2;
+	memCopy(apdu + cdf_offset, cmd->cdf, cmd->cdf_len);
+	btokSMCmdProtect(apdu, hdr, cmd->cdf_len, cmd->rdf_len, st);
+	// возвратить длину
+	if (count)
 	{
-		apdu[4] = 0;
-		apdu[5] = (octet)(cdf_len / 256);
-		apdu[6] = (octet)cdf_len;
+		ASSERT(memIsDisjoint2(count, O_PER_S, state, btokSM_keep()));
+		ASSERT(memIsDisjoint2(count, O_PER_S, cmd, apduCmdSizeof(cmd)));
+		ASSERT(memIsDisjoint2(count, O_PER_S, apdu, offset));
+		*count = offset;
 	}
-	// обработать длину rdf
-	if (cmd->rdf_len)
+	// завершить
+	return ERR_OK;
+}
+
+size_t btokSMCmdCDFOffset(size_t cdf_len, size_t rdf_len)
+{
+	size_t cdf_offset;
+	if (cdf_len >= 65536 || rdf_len > 65536)
+		return SIZE_MAX;
+	btokSMCmdLayout(0, &cdf_offset, cdf_len, rdf_len);
+	return cdf_offset;
+}
+
+err_t btokSMCmdWrap2(octet apdu[], size_t* count, const octet hdr[4],
+	size_t cdf_len, size_t rdf_len, void* state)
+{
+	size_t offset;
+	btok_sm_st* st = (btok_sm_st*)state;
+	// pre
+	ASSERT(memIsValid(state, btokSM_keep()));
+	ASSERT(memIsNullOrValid(count, O_PER_S));
+	// некорректная команда? команда уже защищена?
+	if (!memIsValid(hdr, 4) || (hdr[0] & 0x04) ||
+		cdf_len >= 65536 || rdf_len > 65536)
+		return ERR_BAD_APDU;
+	// общая длина
+	offset = btokSMCmdLayout(0, 0, cdf_len, rdf_len);
+	// установить защиту
+	if (apdu)
 	{
-		size_t l = apduCmdRDFLenLen(cmd);
-		// кодировать TL
-		c = derTLEnc(apdu + offset, 0x97, l);
-		ASSERT(c != SIZE_MAX);
-		offset += c;
-		// кодировать значение
-		ASSERT(1 <= l && l <= 3);
-		if (l == 1)
-			apdu[offset] = (octet)(cmd->rdf_len);
-		else if (l == 2)
-		{
-			apdu[offset] = (octet)(cmd->rdf_len / 256);
-			apdu[offset + 1] = (octet)cmd->rdf_len;
-		}
-		else
-		{
-			apdu[offset] = 0;
-			apdu[offset + 1] = (octet)(cmd->rdf_len / 256);
-			apdu[offset + 2] = (octet)cmd->rdf_len;
-		}
-		// дальше
-		offset += l;
+		ASSERT(memIsValid(apdu, offset));
+		ASSERT(memIsDisjoint2(apdu, offset, state, btokSM_keep()));
+		ASSERT(hdr == apdu || memIsDisjoint2(apdu, offset, hdr, 4));
+		if (st->ctr[0] % 2 != 1)
+			return ERR_BAD_LOGIC;
+		btokSMCmdProtect(apdu, hdr, cdf_len, rdf_len, st);
 	}
-	// вычислить имитовставку
-	beltMACStart(st->stack, st->key1, 32);
-	beltMACStepA(st->ctr, 16, st->stack);
-	beltMACStepA(apdu, 4, st->stack);
-	ASSERT(offset >= 4 + cdf_len_len);
-	beltMACStepA(apdu + 4 + cdf_len_len, offset - 4 - cdf_len_len, st->stack);
-	c = derTLEnc(apdu + offset, 0x8E, 8);
-	ASSERT(c != SIZE_MAX);
-	offset += c;
-	beltMACStepG(apdu + offset, st->stack);
-	offset += 8;
-	// кодировать новую длину rdf
-	memSetZero(apdu + offset, 1);
-	offset += 1;
 	// возвратить длину
 	if (count)
 	{
 		ASSERT(memIsDisjoint2(count, O_PER_S, state, btokSM_keep()));
-		ASSERT(memIsDisjoint2(count, O_PER_S, cmd, apduCmdSizeof(cmd)));
-		ASSERT(memIsDisjoint2(count, O_PER_S, apdu, offset));
 		*count = offset;
 	}
-	// завершить
 	return ERR_OK;
 }
 
-err_t btokSMCmdUnwrap(apdu_cmd_t* cmd, size_t* size, const octet apdu[],
-	size_t count, void* state)
+/*
+*******************************************************************************
+Разбор защищенной команды
+
+Разбирается код защищенной команды [count]apdu:
+  CLA* INS P1 P2 Lc* [der(0x87, 0x02 Y)] [der(0x97, Le)] der(0x8E, T) Le*.
+Определяются смещение auth защищенного поля CDF*, длина auth_len его
+части, которая покрывается имитовставкой, позиция и длина шифртекста Y,
+длина le данных ответа и позиция имитовставки T.
+
+\pre count >= 16.
+*******************************************************************************
+*/
+
+static err_t btokSMCmdParse(size_t* auth, size_t* auth_len,
+	const octet** y, size_t* y_len, size_t* le, const octet** t,
+	const octet apdu[], size_t count)
 {
 	size_t len;
 	size_t offset;
@@ -291,34 +385,7 @@ err_t btokSMCmdUnwrap(apdu_cmd_t* cmd, size_t* size, const octet apdu[],
 	const octet* cdf;
 	size_t rdf_len;
 	const octet* mac;
-	btok_sm_st* st;
-	// pre
-	ASSERT(memIsValid(apdu, count));
-	ASSERT(memIsNullOrValid(state, btokSM_keep()));
-	ASSERT(memIsNullOrValid(cmd, sizeof(apdu_cmd_t)));
-	// слишком короткая команда?
-	// нужно снять защиту с незащищенной команды?
-	// невозможно снять защиту?
-	if (count < 4 || state && count < 16 ||
-		state && (apdu[0] & 0x04) == 0 ||
-		!state && (apdu[0] & 0x04) != 0)
-		return ERR_BAD_APDU;
-	// декодировать без снятия защиты?
-	if (!state)
-	{
-		offset = apduCmdDec(cmd, apdu, count);
-		if (offset == SIZE_MAX)
-			return ERR_BAD_APDU;
-		if (size)
-		{
-			ASSERT(memIsDisjoint2(size, O_PER_S, apdu, count));
-			ASSERT(cmd == 0 ||
-				memIsDisjoint2(size, O_PER_S, cmd, apduCmdSizeof(cmd)));
-			*size = offset;
-		}
-		return ERR_OK;
-	}
-	ASSERT(memIsDisjoint2(state, btokSM_keep(), apdu, count));
+	ASSERT(count >= 16);
 	// разобрать длину защищенного поля cdf
 	if (apdu[4] != 0)
 	{
@@ -386,6 +453,55 @@ err_t btokSMCmdUnwrap(apdu_cmd_t* cmd, size_t* size, const octet apdu[],
 	c3 = derDec3(&mac, apdu + offset + c1 + c2, len - c1 - c2, 0x8E, 8);
 	if (c3 == SIZE_MAX || c1 + c2 + c3 != len)
 		return ERR_BAD_APDU;
+	// возвратить результаты разбора
+	*auth = offset, *auth_len = c1 + c2;
+	*y = cdf, *y_len = cdf_len;
+	*le = rdf_len, *t = mac;
+	return ERR_OK;
+}
+
+err_t btokSMCmdUnwrap(apdu_cmd_t* cmd, size_t* size, const octet apdu[],
+	size_t count, void* state)
+{
+	err_t code;
+	size_t len;
+	size_t offset;
+	size_t cdf_len;
+	const octet* cdf;
+	size_t rdf_len;
+	const octet* mac;
+	btok_sm_st* st;
+	// pre
+	ASSERT(memIsValid(apdu, count));
+	ASSERT(memIsNullOrValid(state, btokSM_keep()));
+	ASSERT(memIsNullOrValid(cmd, sizeof(apdu_cmd_t)));
+	// слишком короткая команда?
+	// нужно снять защиту с незащищенной команды?
+	// невозможно снять защиту?
+	if (count < 4 || state && count < 16 ||
+		state && (apdu[0] & 0x04) == 0 ||
+		!state && (apdu[0] & 0x04) != 0)
+		return ERR_BAD_APDU;
+	// декодировать без снятия защиты?
+	if (!state)
+	{
+		offset = apduCmdDec(cmd, apdu, count);
+		if (offset == SIZE_MAX)
+			return ERR_BAD_APDU;
+		if (size)
+		{
+			ASSERT(memIsDisjoint2(size, O_PER_S, apdu, count));
+			ASSERT(cmd == 0 ||
+				memIsDisjoint2(size, O_PER_S, cmd, apduCmdSizeof(cmd)));
+			*size = offset;
+		}
+		return ERR_OK;
+	}
+	ASSERT(memIsDisjoint2(state, btokSM_keep(), apdu, count));
+	// разобрать защищенную команду
+	code = btokSMCmdParse(&offset, &len, &cdf, &cdf_len, &rdf_len, &mac,
+		apdu, count);
+	ERR_CALL_CHECK(code);
 	// ограничиться проверкой формата?
 	if (!cmd)
 	{
@@ -404,7 +520,7 @@ err_t btokSMCmdUnwrap(apdu_cmd_t* cmd, size_t* size, const octet apdu[],
 	beltMACStart(st->stack, st->key1, 32);
 	beltMACStepA(st->ctr, 16, st->stack);
 	beltMACStepA(apdu, 4, st->stack);
-	beltMACStepA(apdu + offset, c1 + c2, st->stack);
+	beltMACStepA(apdu + offset, len, st->stack);
 	if (!beltMACStepV(mac, st->stack))
 		return ERR_BAD_MAC;
 	// заполнить поля команды
@@ -434,6 +550,81 @@ err_t btokSMCmdUnwrap(apdu_cmd_t* cmd, size_t* size, const octet apdu[],
 	return ERR_OK;
 }
 
+/*
+*******************************************************************************
+Снятие защиты команды на месте
+
+Как и в btokSMRespUnwrap2(), проверка имитовставки и расшифрование CDF
+объединены в один проход по фрагментам шифртекста Y.
+*******************************************************************************
+*/
+
+err_t btokSMCmdUnwrap2(apdu_cmd_view_t* view, octet apdu[], size_t count,
+	void* state)
+{
+	err_t code;
+	size_t offset;
+	size_t len;
+	size_t cdf_len;
+	const octet* cdf;
+	size_t rdf_len;
+	const octet* mac;
+	size_t pos;
+	size_t c;
+	btok_sm_st* st = (btok_sm_st*)state;
+	void* mac_state;
+	void* cfb_state;
+	// pre
+	ASSERT(memIsValid(apdu, count));
+	ASSERT(memIsValid(state, btokSM_keep()));
+	ASSERT(memIsDisjoint2(state, btokSM_keep(), apdu, count));
+	ASSERT(memIsNullOrValid(view, sizeof(apdu_cmd_view_t)));
+	// слишком короткая команда? команда не защищена?
+	if (count < 16 || (apdu[0] & 0x04) == 0)
+		return ERR_BAD_APDU;
+	// разобрать защищенную команду
+	code = btokSMCmdParse(&offset, &len, &cdf, &cdf_len, &rdf_len, &mac,
+		apdu, count);
+	ERR_CALL_CHECK(code);
+	// проверить счетчик
+	if (st->ctr[0] % 2 != 1)
+		return ERR_BAD_LOGIC;
+	// проверить имитовставку и расшифровать cdf
+	mac_state = st->stack;
+	cfb_state = st->stack + beltMAC_keep();
+	pos = cdf_len ? (size_t)(cdf - apdu) : offset;
+	beltMACStart(mac_state, st->key1, 32);
+	beltMACStepA(st->ctr, 16, mac_state);
+	beltMACStepA(apdu, 4, mac_state);
+	beltMACStepA(apdu + offset, pos - offset, mac_state);
+	if (cdf_len)
+		beltCFBStart(cfb_state, st->key2, 32, st->ctr);
+	for (c = cdf_len; c; )
+	{
+		size_t t = MIN2(c, BTOK_SM_CHUNK);
+		beltMACStepA(apdu + pos, t, mac_state);
+		beltCFBStepD(apdu + pos, t, cfb_state);
+		pos += t, c -= t;
+	}
+	beltMACStepA(apdu + pos, offset + len - pos, mac_state);
+	if (!beltMACStepV(mac, mac_state))
+	{
+		memWipe(apdu + pos - cdf_len, cdf_len);
+		return ERR_BAD_MAC;
+	}
+	// заполнить представление
+	if (view)
+	{
+		ASSERT(memIsDisjoint2(view, sizeof(apdu_cmd_view_t), apdu, count));
+		view->cla = apdu[0] & 0xFB;
+		view->ins = apdu[1], view->p1 = apdu[2], view->p2 = apdu[3];
+		view->rdf_len = rdf_len;
+		view->cdf_len = cdf_len;
+		view->cdf = apdu + pos - cdf_len;
+	}
+	return ERR_OK;
+}
+
 /*
 *******************************************************************************
 Кодирование и защита ответов
@@ -553,6 +744,71 @@ err_t btokSMRespWrap(octet apdu[], size_t* count, const apdu_resp_t* resp,
 	return ERR_OK;
 }
 
+size_t btokSMRespRDFOffset(size_t rdf_len)
+{
+	size_t c;
+	if (rdf_len > 65536)
+		return SIZE_MAX;
+	if (rdf_len == 0)
+		return 0;
+	c = derTLEnc(0, 0x87, rdf_len + 1);
+	ASSERT(c != SIZE_MAX);
+	return c + 1;
+}
+
+err_t btokSMRespWrap2(octet apdu[], size_t* count, size_t rdf_len,
+	octet sw1, octet sw2, void* state)
+{
+	size_t offset;
+	size_t c;
+	octet sw[2];
+	btok_sm_st* st = (btok_sm_st*)state;
+	// pre
+	ASSERT(memIsValid(state, btokSM_keep()));
+	ASSERT(memIsNullOrValid(count, O_PER_S));
+	// корректный ответ?
+	offset = btokSMRespRDFOffset(rdf_len);
+	if (offset == SIZE_MAX)
+		return ERR_BAD_APDU;
+	// установить защиту
+	if (apdu)
+	{
+		ASSERT(memIsValid(apdu, offset + rdf_len + 12));
+		ASSERT(memIsDisjoint2(apdu, offset + rdf_len + 12,
+			state, btokSM_keep()));
+		if (st->ctr[0] % 2 != 0)
+			return ERR_BAD_LOGIC;
+		// кодировать TL и зашифровать rdf
+		if (rdf_len)
+		{
+			c = derTLEnc(apdu, 0x87, rdf_len + 1);
+			ASSERT(c + 1 == offset);
+			apdu[c] = 0x02;
+			beltCFBStart(st->stack, st->key2, 32, st->ctr);
+			beltCFBStepE(apdu + offset, rdf_len, st->stack);
+		}
+		// вычислить имитовставку
+		sw[0] = sw1, sw[1] = sw2;
+		beltMACStart(st->stack, st->key1, 32);
+		beltMACStepA(st->ctr, 16, st->stack);
+		beltMACStepA(apdu, offset + rdf_len, st->stack);
+		beltMACStepA(sw, 2, st->stack);
+		c = derTLEnc(apdu + offset + rdf_len, 0x8E, 8);
+		ASSERT(c == 2);
+		beltMACStepG(apdu + offset + rdf_len + c, st->stack);
+		// кодировать статусы
+		apdu[offset + rdf_len + 10] = sw1;
+		apdu[offset + rdf_len + 11] = sw2;
+	}
+	// возвратить длину
+	if (count)
+	{
+		ASSERT(memIsDisjoint2(count, O_PER_S, state, btokSM_keep()));
+		*count = offset + rdf_len + 12;
+	}
+	return ERR_OK;
+}
+
 err_t btokSMRespUnwrap(apdu_resp_t* resp, size_t* size, const octet apdu[],
 	size_t count, void* state)
 {
@@ -643,3 +899,87 @@ err_t btokSMRespUnwrap(apdu_resp_t* resp, size_t* size, const octet apdu[],
 	// завершить
 	return ERR_OK;
 }
+
+/*
+*******************************************************************************
+Снятие защиты ответа на месте
+
+Проверка имитовставки и расшифрование RDF объединены в один проход:
+каждый фрагмент шифртекста Y сначала обрабатывается belt-mac, а затем
+расшифровывается на месте. Если имитовставка неверна, то расшифрованные
+данные стираются.
+*******************************************************************************
+*/
+
+err_t btokSMRespUnwrap2(size_t* rdf_offset, size_t* rdf_len, octet apdu[],
+	size_t count, void* state)
+{
+	size_t c1, c2;
+	size_t len;
+	size_t offset;
+	size_t c;
+	const octet* rdf;
+	const octet* mac;
+	btok_sm_st* st = (btok_sm_st*)state;
+	void* mac_state;
+	void* cfb_state;
+	// pre
+	ASSERT(memIsValid(apdu, count));
+	ASSERT(memIsValid(state, btokSM_keep()));
+	ASSERT(memIsDisjoint2(state, btokSM_keep(), apdu, count));
+	ASSERT(memIsNullOrValid(rdf_offset, O_PER_S));
+	ASSERT(memIsNullOrValid(rdf_len, O_PER_S));
+	// слишком короткий ответ?
+	if (count < 12)
+		return ERR_BAD_APDU;
+	// разобрать защищенное поле rdf: шифртекст
+	c1 = derDec2(&rdf, &len, apdu, count - 2, 0x87);
+	if (c1 != SIZE_MAX)
+	{
+		if (len < 2 || rdf[0] != 0x02)
+			return ERR_BAD_APDU;
+		++rdf, --len;
+	}
+	else
+		c1 = len = 0;
+	// разобрать защищенное поле rdf: имитовставка
+	c2 = derDec3(&mac, apdu + c1, count - 2 - c1, 0x8E, 8);
+	if (c2 == SIZE_MAX || c1 + c2 + 2 != count)
+		return ERR_BAD_APDU;
+	// проверить счетчик
+	if (st->ctr[0] % 2 != 0)
+		return ERR_BAD_LOGIC;
+	// проверить имитовставку и расшифровать rdf
+	mac_state = st->stack;
+	cfb_state = st->stack + beltMAC_keep();
+	offset = c1 - len;
+	beltMACStart(mac_state, st->key1, 32);
+	beltMACStepA(st->ctr, 16, mac_state);
+	beltMACStepA(apdu, offset, mac_state);
+	if (len)
+		beltCFBStart(cfb_state, st->key2, 32, st->ctr);
+	for (c1 = len; c1; c1 -= c, offset += c)
+	{
+		c = MIN2(c1, BTOK_SM_CHUNK);
+		beltMACStepA(apdu + offset, c, mac_state);
+		beltCFBStepD(apdu + offset, c, cfb_state);
+	}
+	beltMACStepA(apdu + count - 2, 2, mac_state);
+	if (!beltMACStepV(mac, mac_state))
+	{
+		memWipe(apdu + offset - len, len);
+		return ERR_BAD_MAC;
+	}
+	// возвратить позицию и длину rdf
+	if (rdf_offset)
+	{
+		ASSERT(memIsDisjoint2(rdf_offset, O_PER_S, apdu, count));
+		*rdf_offset = offset - len;
+	}
+	if (rdf_len)
+	{
+		ASSERT(memIsDisjoint2(rdf_len, O_PER_S, apdu, count));
+		*rdf_len = len;
+	}
+	return ERR_OK;
+}
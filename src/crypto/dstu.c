@@ -4,15 +4,15 @@
 \brief DSTU 4145-2002 (Ukraine): digital signature algorithms
 \project bee2 [cryptographic library]
 \created 2012.04.27
-\version 2023.09.22
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
-#include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/str.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/dstu.h"
@@ -460,7 +460,7 @@ static err_t dstuEcCreate(
 	ec_keep = ec2CreateLD_keep(n);
 	ec_deep = ec2CreateLD_deep(n, f_deep);
 	// создать состояние
-	state = blobCreate(
+	state = stackCreate(
 		f_keep + ec_keep +
 		utilMax(4,
 			4 * sizeof(size_t) + f_deep,
@@ -479,7 +479,7 @@ static err_t dstuEcCreate(
 	stack = p + 4;
 	if (!gf2Create(f, p, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// создать кривую и группу
@@ -492,7 +492,7 @@ static err_t dstuEcCreate(
 		!ecCreateGroup(ec, params->P, params->P + ec->f->no, params->n, 
 			ec->f->no, params->c, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// присоединить f к ec
@@ -510,7 +510,7 @@ static err_t dstuEcCreate(
 
 void dstuEcClose(ec_o* ec)
 {
-	blobClose(ec);
+	stackClose(ec);
 }
 
 /*
@@ -780,8 +780,9 @@ err_t dstuPointRecover(octet point[], const dstu_params* params,
 		// b <- b^{2^{m - 1}}
 		while (--m)
 			qrSqr(ec->B, ec->B, ec->f, stack);
-		// выгрузить y-координату
-		qrTo(point + ec->f->n, ec->B, ec->f, stack);
+		// выгрузить точку (0, b)
+		qrTo(point, x, ec->f, stack);
+		qrTo(point + ec->f->no, ec->B, ec->f, stack);
 		// все нормально
 		dstuEcClose(ec);
 		return ERR_OK;
@@ -821,6 +822,230 @@ err_t dstuPointRecover(octet point[], const dstu_params* params,
 	return code;
 }
 
+/*
+*******************************************************************************
+Пакетные сжатие и восстановление
+
+Точки обрабатываются пакетами по DSTU_BATCH штук. В каждом пакете
+x-координаты обращаются одновременно (трюк Монтгомери, см. qrInvBatch()).
+
+При восстановлении квадратные уравнения z^2 + z = c решаются как
+z = htr(c). Расчет таблицы полуследов (gf2HTrPrecomp()) стоит примерно
+(m + 1) / 2 вычислений полуследа прямым способом (gf2QSolve()), а
+вычисление по таблице (gf2HTr()) -- в десятки раз дешевле прямого.
+Поэтому таблица рассчитывается, только если число точек не меньше
+(m + 1) / 2.
+*******************************************************************************
+*/
+
+#define DSTU_BATCH 32
+
+static size_t dstuPointCompressBatch_deep(size_t n, size_t f_deep, 
+	size_t ec_d, size_t ec_deep)
+{
+	return O_OF_W(3 * DSTU_BATCH * n) + qrInvBatch_deep(n, f_deep);
+}
+
+err_t dstuPointCompressBatch(octet xpoints[], err_t codes[], 
+	const dstu_params* params, size_t count, const octet points[])
+{
+	err_t code;
+	err_t cs[DSTU_BATCH];
+	size_t n, no, k, i;
+	// состояние
+	ec_o* ec = 0;
+	word* xs;
+	word* ys;
+	word* is;
+	void* stack;
+	// старт
+	code = dstuEcCreate(&ec, params, dstuPointCompressBatch_deep);
+	ERR_CALL_CHECK(code);
+	n = ec->f->n, no = ec->f->no;
+	// проверить входные указатели
+	if (!memIsValid(points, count * 2 * no) || 
+		!memIsValid(xpoints, count * no) ||
+		!memIsNullOrValid(codes, count * sizeof(err_t)))
+	{
+		dstuEcClose(ec);
+		return ERR_BAD_INPUT;
+	}
+	// раскладка состояния
+	xs = objEnd(ec, word);
+	ys = xs + DSTU_BATCH * n;
+	is = ys + DSTU_BATCH * n;
+	stack = is + DSTU_BATCH * n;
+	// обработать пакеты
+	for (; count; count -= k)
+	{
+		k = MIN2(count, DSTU_BATCH);
+		// загрузить точки
+		for (i = 0; i < k; ++i)
+			if (qrFrom(xs + n * i, points + 2 * no * i, ec->f, stack) &&
+				qrFrom(ys + n * i, points + 2 * no * i + no, ec->f, stack))
+				cs[i] = ERR_OK;
+			else
+			{
+				cs[i] = code = ERR_BAD_POINT;
+				qrSetZero(xs + n * i, ec->f);
+			}
+		// is[i] <- xs[i]^{-1}
+		qrInvBatch(is, xs, k, ec->f, stack);
+		// xpoint <- x(point), xpoint_0 <- tr(y / x)
+		for (i = 0; i < k; ++i)
+		{
+			if (cs[i] != ERR_OK)
+				continue;
+			qrTo(xpoints + no * i, xs + n * i, ec->f, stack);
+			if (qrIsZero(xs + n * i, ec->f))
+				continue;
+			qrMul(ys + n * i, ys + n * i, is + n * i, ec->f, stack);
+			xpoints[no * i] &= 0xFE;
+			xpoints[no * i] |= gf2Tr(ys + n * i, ec->f, stack);
+		}
+		// к следующему пакету
+		if (codes)
+			memCopy(codes, cs, k * sizeof(err_t)), codes += k;
+		points += 2 * no * k, xpoints += no * k;
+	}
+	// завершение
+	dstuEcClose(ec);
+	return code;
+}
+
+static size_t dstuPointRecoverBatch_deep(size_t n, size_t f_deep, 
+	size_t ec_d, size_t ec_deep)
+{
+	return O_OF_W(2 * DSTU_BATCH * n + 3 * n + n * B_PER_W / 2 * n) +
+		utilMax(4,
+			qrInvBatch_deep(n, f_deep),
+			gf2HTrPrecomp_deep(n, f_deep),
+			gf2HTr_deep(n, f_deep),
+			gf2QSolve_deep(n, f_deep));
+}
+
+err_t dstuPointRecoverBatch(octet points[], err_t codes[], 
+	const dstu_params* params, size_t count, const octet xpoints[])
+{
+	err_t code;
+	err_t cs[DSTU_BATCH];
+	bool_t trace[DSTU_BATCH];
+	size_t m, n, no, k, i;
+	bool_t sb_ready = FALSE;
+	// состояние
+	ec_o* ec = 0;
+	word* xs;
+	word* is;
+	word* y;
+	word* z;
+	word* sb;
+	word* tab = 0;
+	void* stack;
+	// старт
+	code = dstuEcCreate(&ec, params, dstuPointRecoverBatch_deep);
+	ERR_CALL_CHECK(code);
+	m = gf2Deg(ec->f), n = ec->f->n, no = ec->f->no;
+	// проверить входные указатели
+	if (!memIsValid(xpoints, count * no) || 
+		!memIsValid(points, count * 2 * no) ||
+		!memIsDisjoint2(xpoints, count * no, points, count * 2 * no) ||
+		!memIsNullOrValid(codes, count * sizeof(err_t)))
+	{
+		dstuEcClose(ec);
+		return ERR_BAD_INPUT;
+	}
+	// раскладка состояния
+	xs = objEnd(ec, word);
+	is = xs + DSTU_BATCH * n;
+	y = is + DSTU_BATCH * n;
+	z = y + n;
+	sb = z + n;
+	stack = sb + n;
+	// рассчитать таблицу полуследов
+	if (count >= (m + 1) / 2)
+	{
+		tab = (word*)stack;
+		stack = tab + (m + 1) / 2 * n;
+		gf2HTrPrecomp(tab, ec->f, stack);
+	}
+	// обработать пакеты
+	for (; count; count -= k)
+	{
+		k = MIN2(count, DSTU_BATCH);
+		// загрузить сжатые точки, восстановить первые разряды x
+		for (i = 0; i < k; ++i)
+			if (qrFrom(xs + n * i, xpoints + no * i, ec->f, stack))
+			{
+				cs[i] = ERR_OK;
+				if (qrIsZero(xs + n * i, ec->f))
+					continue;
+				trace[i] = wwTestBit(xs + n * i, 0);
+				wwSetBit(xs + n * i, 0, 0);
+				if (gf2Tr(xs + n * i, ec->f, stack) != (bool_t)params->A)
+					wwSetBit(xs + n * i, 0, 1);
+			}
+			else
+			{
+				cs[i] = ERR_BAD_POINT;
+				qrSetZero(xs + n * i, ec->f);
+			}
+		// is[i] <- xs[i]^{-1}
+		qrInvBatch(is, xs, k, ec->f, stack);
+		// восстановить точки
+		for (i = 0; i < k; ++i)
+		{
+			if (cs[i] != ERR_OK)
+				continue;
+			// x == 0?
+			if (qrIsZero(xs + n * i, ec->f))
+			{
+				// sb <- b^{2^{m - 1}}
+				if (!sb_ready)
+				{
+					size_t j;
+					qrCopy(sb, ec->B, ec->f);
+					for (j = m; --j;)
+						qrSqr(sb, sb, ec->f, stack);
+					sb_ready = TRUE;
+				}
+				qrTo(points + 2 * no * i, xs + n * i, ec->f, stack);
+				qrTo(points + 2 * no * i + no, sb, ec->f, stack);
+				continue;
+			}
+			// y <- x + a + b / x^2
+			qrSqr(y, is + n * i, ec->f, stack);
+			qrMul(y, y, ec->B, ec->f, stack);
+			gf2Add2(y, xs + n * i, ec->f);
+			if (params->A)
+				wwFlipBit(y, 0);
+			// Solve[z^2 + z == y]
+			if (tab && gf2Tr(y, ec->f, stack) ||
+				!tab && !gf2QSolve(z, ec->f->unity, y, ec->f, stack))
+			{
+				cs[i] = code = ERR_BAD_POINT;
+				continue;
+			}
+			if (tab)
+				gf2HTr(z, y, tab, ec->f, stack);
+			// tr(z) != trace => z <- z + 1
+			if (gf2Tr(z, ec->f, stack) != trace[i])
+				wwFlipBit(z, 0);
+			// y <- z * x
+			qrMul(y, z, xs + n * i, ec->f, stack);
+			// выгрузить точку
+			qrTo(points + 2 * no * i, xs + n * i, ec->f, stack);
+			qrTo(points + 2 * no * i + no, y, ec->f, stack);
+		}
+		// к следующему пакету
+		if (codes)
+			memCopy(codes, cs, k * sizeof(err_t)), codes += k;
+		points += 2 * no * k, xpoints += no * k;
+	}
+	// завершение
+	dstuEcClose(ec);
+	return code;
+}
+
 /*
 *******************************************************************************
 Управление ключами
@@ -831,7 +1056,7 @@ static size_t dstuKeypairGen_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(3 * n) + 
-		ecMulA_deep(n, ec_d, ec_deep, n);
+		ec2MulALadder_deep(n, ec_d, ec_deep);
 }
 
 err_t dstuKeypairGen(octet privkey[], octet pubkey[], 
@@ -881,7 +1106,7 @@ err_t dstuKeypairGen(octet privkey[], octet pubkey[],
 			break;
 	}
 	// Q <- d G
-	if (!ecMulA(x, ec->base, ec, d, order_n, stack))
+	if (!ec2MulALadder(x, ec->base, ec, d, order_n, stack))
 	{
 		// если params корректны, то этого быть не должно
 		dstuEcClose(ec);
@@ -901,39 +1126,47 @@ err_t dstuKeypairGen(octet privkey[], octet pubkey[],
 /*
 *******************************************************************************
 ЭЦП
+
+Кратные базовой точки вычисляются в функциях dstuSignStep() и
+dstuVerifyStep(). Если задана таблица pre, то используются гребенчатые
+функции ecCombMulA() и ecCombAddMulA(), в противном случае --
+ec2MulALadder() и ecAddMulA(). Таблица рассчитывается в dstuCtxStart().
+
+Кратные базовой точки с секретными кратностями (личный ключ, эфемерный
+личный ключ) без таблицы вычисляются регулярной лестницей Монтгомери
+ec2MulALadder().
 *******************************************************************************
 */
 
+#ifdef BEE2_LOW_MEMORY
+	#define DSTU_COMB_W 4
+#else
+	#define DSTU_COMB_W 6
+#endif
+#define DSTU_COMB_COUNT ((SIZE_1 << DSTU_COMB_W) - 1)
+
 static size_t dstuSign_deep(size_t n, size_t f_deep, size_t ec_d, 
 	size_t ec_deep)
 {
 	return O_OF_W(6 * n) + 
-		utilMax(2,
-			ecMulA_deep(n, ec_d, ec_deep, n),
+		utilMax(3,
+			ec2MulALadder_deep(n, ec_d, ec_deep),
+			ecCombMulA_deep(n, ec_d, ec_deep),
 			zzMulMod_deep(n));
 }
 
-err_t dstuSign(octet sig[], const dstu_params* params, size_t ld, 
-	const octet hash[], size_t hash_len, const octet privkey[], 
-	gen_i rng, void* rng_state)
+static err_t dstuSignStep(octet sig[], const ec_o* ec, const word pre[],
+	size_t ld, const octet hash[], size_t hash_len, const octet privkey[],
+	gen_i rng, void* rng_state, void* stack)
 {
-	err_t code;
 	size_t order_n, order_no, order_nb;
 	// состояние
-	ec_o* ec = 0;
 	word* e;		/* эфемерный лк */
 	word* h;		/* хэш-значение как элемент поля */
 	word* x;		/* х-координата эфемерного ок */
 	word* y;		/* y-координата эфемерного ок */
 	word* r;		/* первая часть ЭЦП */
 	word* s;		/* вторая часть ЭЦП */
-	void* stack;
-	// проверить rng
-	if (rng == 0)
-		return ERR_BAD_RNG;
-	// старт
-	code = dstuEcCreate(&ec, params, dstuSign_deep);
-	ERR_CALL_CHECK(code);
 	// размерности order
 	order_nb = wwBitSize(ec->order, ec->f->n);
 	order_no = O_OF_B(order_nb);
@@ -945,12 +1178,9 @@ err_t dstuSign(octet sig[], const dstu_params* params, size_t ld,
 		ld % 16 != 0 || ld < 16 * order_no ||
 		!memIsValid(hash, hash_len) ||
 		!memIsValid(sig, O_OF_B(ld)))
-	{
-		dstuEcClose(ec);
 		return ERR_BAD_INPUT;
-	}
 	// раскладка состояния
-	e = objEnd(ec, word);
+	e = (word*)stack;
 	h = e + ec->f->n;
 	x = h + ec->f->n;
 	y = x + ec->f->n;
@@ -988,12 +1218,10 @@ step8:
 			break;
 	}
 	// шаг 8: (x, y) <- e G
-	if (!ecMulA(x, ec->base, ec, e, order_n, stack))
-	{
+	if (pre ? !ecCombMulA(x, pre, ec, DSTU_COMB_W, e, order_n, stack) :
+		!ec2MulALadder(x, ec->base, ec, e, order_n, stack))
 		// если params корректны, то этого быть не должно
-		dstuEcClose(ec);
 		return ERR_BAD_PARAMS;
-	}
 	// шаг 8: если x == 0, то повторить генерацию
 	if (qrIsZero(x, ec->f))
 		goto step8;
@@ -1020,6 +1248,25 @@ step8:
 	wwTo(sig, order_no, r);
 	wwTo(sig + ld / 16, order_no, s);
 	// все нормально
+	return ERR_OK;
+}
+
+err_t dstuSign(octet sig[], const dstu_params* params, size_t ld, 
+	const octet hash[], size_t hash_len, const octet privkey[], 
+	gen_i rng, void* rng_state)
+{
+	err_t code;
+	ec_o* ec = 0;
+	// проверить rng
+	if (rng == 0)
+		return ERR_BAD_RNG;
+	// старт
+	code = dstuEcCreate(&ec, params, dstuSign_deep);
+	ERR_CALL_CHECK(code);
+	// выработать подпись
+	code = dstuSignStep(sig, ec, 0, ld, hash, hash_len, privkey, rng,
+		rng_state, objEnd(ec, void));
+	// завершение
 	dstuEcClose(ec);
 	return code;
 }
@@ -1028,25 +1275,22 @@ static size_t dstuVerify_deep(size_t n, size_t f_deep, size_t ec_d,
 	size_t ec_deep)
 {
 	return O_OF_W(5 * n) + 
-		ecAddMulA_deep(n, ec_d, ec_deep, 2, n, n);
+		utilMax(2,
+			ecAddMulA_deep(n, ec_d, ec_deep, 2, n, n),
+			ecCombAddMulA_deep(n, ec_d, ec_deep, n));
 }
 
-err_t dstuVerify(const dstu_params* params, size_t ld, const octet hash[], 
-	size_t hash_len, const octet sig[], const octet pubkey[])
+static err_t dstuVerifyStep(const ec_o* ec, const word pre[], size_t ld,
+	const octet hash[], size_t hash_len, const octet sig[],
+	const octet pubkey[], void* stack)
 {
-	err_t code;
 	size_t order_n, order_no, order_nb, i;
 	// состояние
-	ec_o* ec = 0;
 	word* h;		/* хэш-значение как элемент поля */
 	word* x;		/* х-координата эфемерного ок */
 	word* y;		/* y-координата эфемерного ок */
 	word* r;		/* первая часть ЭЦП */
 	word* s;		/* вторая часть ЭЦП */
-	void* stack;
-	// старт
-	code = dstuEcCreate(&ec, params, dstuVerify_deep);
-	ERR_CALL_CHECK(code);
 	// размерности order
 	order_nb = wwBitSize(ec->order, ec->f->n);
 	order_no = O_OF_B(order_nb);
@@ -1056,13 +1300,11 @@ err_t dstuVerify(const dstu_params* params, size_t ld, const octet hash[],
 	// шаг 3: проверить ld
 	if (!memIsValid(pubkey, 2 * ec->f->no) || 
 		ld % 16 != 0 || ld < 16 * order_no ||
-		!memIsValid(hash, hash_len))
-	{
-		dstuEcClose(ec);
+		!memIsValid(hash, hash_len) ||
+		!memIsValid(sig, O_OF_B(ld)))
 		return ERR_BAD_INPUT;
-	}
 	// раскладка состояния
-	h = objEnd(ec, word);
+	h = (word*)stack;
 	x = h + ec->f->n;
 	y = x + ec->f->n;
 	r = y + ec->f->n;
@@ -1073,10 +1315,7 @@ err_t dstuVerify(const dstu_params* params, size_t ld, const octet hash[],
 	// [минимальная проверка принадлежности координат базовому полю]
 	if (!qrFrom(x, pubkey, ec->f, stack) || 
 		!qrFrom(y, pubkey + ec->f->no, ec->f, stack))
-	{
-		dstuEcClose(ec);
 		return ERR_BAD_PUBKEY;
-	}
 	// шаги 6, 7: хэширование
 	// шаг 8: перевести hash в элемент основного поля h
 	// [алгоритм из раздела 5.9 ДСТУ]
@@ -1100,25 +1339,19 @@ err_t dstuVerify(const dstu_params* params, size_t ld, const octet hash[],
 	wwFrom(s, sig + ld / 16, order_no);
 	for (i = order_no; i < ld / 16; ++i)
 		if (sig[i] || sig[i + ld / 16])
-		{
-			dstuEcClose(ec);
 			return ERR_BAD_SIG;
-		}
-	// шаги 10, 11: проверить r и s
-	if (wwIsZero(r, order_n) ||
-		wwIsZero(s, order_n) ||
-		wwCmp(r, ec->order, order_n) >= 0 ||
-		wwCmp(s, ec->order, order_n) >= 0)
-	{
-		dstuEcClose(ec);
+	// шаги 10, 11: проверить r и s (открытые данные: ускоренные сравнения)
+	if (FAST(wwIsZero)(r, order_n) ||
+		FAST(wwIsZero)(s, order_n) ||
+		FAST(wwCmp)(r, ec->order, order_n) >= 0 ||
+		FAST(wwCmp)(s, ec->order, order_n) >= 0)
 		return ERR_BAD_SIG;
-	}
 	// шаг 12: R <- sP + rQ
-	if (!ecAddMulA(x, ec, stack, 2, ec->base, s, order_n, x, r, order_n))
-	{
-		dstuEcClose(ec);
+	if (pre ? 
+		!ecCombAddMulA(x, pre, ec, DSTU_COMB_W, s, order_n, x, r, order_n,
+			stack) :
+		!ecAddMulA(x, ec, stack, 2, ec->base, s, order_n, x, r, order_n))
 		return ERR_BAD_SIG;
-	}
 	// шаг 13: y <- h * x
 	qrMul(y, x, h, ec->f, stack);
 	// шаг 14: r' <- \bar{y}
@@ -1127,9 +1360,159 @@ err_t dstuVerify(const dstu_params* params, size_t ld, const octet hash[],
 	wwFrom(s, s, order_no);
 	wwTrimHi(s, order_n, order_nb - 1);
 	// шаг 15:
-	if (!wwEq(r, s, order_n))
-		code = ERR_BAD_SIG;
+	if (!FAST(wwEq)(r, s, order_n))
+		return ERR_BAD_SIG;
 	// все нормально
+	return ERR_OK;
+}
+
+err_t dstuVerify(const dstu_params* params, size_t ld, const octet hash[], 
+	size_t hash_len, const octet sig[], const octet pubkey[])
+{
+	err_t code;
+	ec_o* ec = 0;
+	// старт
+	code = dstuEcCreate(&ec, params, dstuVerify_deep);
+	ERR_CALL_CHECK(code);
+	// проверить подпись
+	code = dstuVerifyStep(ec, 0, ld, hash, hash_len, sig, pubkey,
+		objEnd(ec, void));
+	// завершение
+	dstuEcClose(ec);
+	return code;
+}
+
+/*
+*******************************************************************************
+Контекст
+
+Контекст содержит копию долговременных параметров, таблицу гребенки
+[2 * n * DSTU_COMB_COUNT]pre для базовой точки и описание кривой,
+построенное в dstuEcCreate(). Таблица рассчитывается для кратностей
+длины order_n слов (длина порядка группы точек). Описание кривой
+копируется в контекст функцией objCopy(), которая корректирует внутренние
+указатели описания.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	dstu_params params[1];	/* долговременные параметры */
+	word stack[];			/* таблица pre и описание кривой */
+} dstu_ctx_st;
+
+size_t dstuCtx_keep(size_t m)
+{
+	const size_t n = W_OF_B(m);
+	ASSERT(160 <= m && m <= 509);
+	return sizeof(dstu_ctx_st) + O_OF_W(2 * n * DSTU_COMB_COUNT) +
+		ec2CreateLD_keep(n) + gf2Create_keep(m);
+}
+
+static size_t dstuCtxStart_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return ecCombPrecompA_deep(n, ec_d, ec_deep);
+}
+
+err_t dstuCtxStart(void* ctx, const dstu_params* params)
+{
+	err_t code;
+	dstu_ctx_st* st = (dstu_ctx_st*)ctx;
+	size_t m, n;
+	ec_o* ec = 0;
+	// проверить params
+	if (!memIsValid(params, sizeof(dstu_params)))
+		return ERR_BAD_INPUT;
+	if ((m = params->p[0]) < 160 || m > 509)
+		return ERR_BAD_PARAMS;
+	// проверить ctx
+	if (!memIsValid(ctx, dstuCtx_keep(m)))
+		return ERR_BAD_INPUT;
+	// построить описание кривой
+	code = dstuEcCreate(&ec, params, dstuCtxStart_deep);
+	ERR_CALL_CHECK(code);
+	n = ec->f->n;
+	ASSERT(n == W_OF_B(m));
+	ASSERT(sizeof(dstu_ctx_st) + O_OF_W(2 * n * DSTU_COMB_COUNT) + 
+		objKeep(ec) <= dstuCtx_keep(m));
+	// рассчитать таблицу
+	if (!ecCombPrecompA(st->stack, ec->base, ec, DSTU_COMB_W,
+		W_OF_B(wwBitSize(ec->order, n)), objEnd(ec, void)))
+		code = ERR_BAD_PARAMS;
+	// скопировать параметры и описание кривой в контекст
+	else
+	{
+		memCopy(st->params, params, sizeof(dstu_params));
+		objCopy(st->stack + 2 * n * DSTU_COMB_COUNT, ec);
+	}
 	dstuEcClose(ec);
 	return code;
 }
+
+static const ec_o* dstuCtxEc(const void* ctx)
+{
+	const dstu_ctx_st* st = (const dstu_ctx_st*)ctx;
+	const size_t n = W_OF_B(st->params->p[0]);
+	return (const ec_o*)(st->stack + 2 * n * DSTU_COMB_COUNT);
+}
+
+static bool_t dstuCtxIsOperable(const void* ctx)
+{
+	const dstu_ctx_st* st = (const dstu_ctx_st*)ctx;
+	return memIsValid(ctx, sizeof(dstu_ctx_st)) &&
+		160 <= st->params->p[0] && st->params->p[0] <= 509 &&
+		ecIsOperable(dstuCtxEc(ctx)) &&
+		dstuCtxEc(ctx)->f->n == W_OF_B((size_t)st->params->p[0]);
+}
+
+static size_t dstuCtxStack_keep(const void* ctx, dstu_deep_i deep)
+{
+	const ec_o* ec = dstuCtxEc(ctx);
+	ASSERT(dstuCtxIsOperable(ctx));
+	return deep(ec->f->n, ec->f->deep, ec->d, ec->deep);
+}
+
+err_t dstuSignCtx(octet sig[], const void* ctx, size_t ld, 
+	const octet hash[], size_t hash_len, const octet privkey[], 
+	gen_i rng, void* rng_state)
+{
+	err_t code;
+	void* stack;
+	// проверить ctx
+	if (!dstuCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// проверить rng
+	if (rng == 0)
+		return ERR_BAD_RNG;
+	// создать стек
+	stack = stackCreate(dstuCtxStack_keep(ctx, dstuSign_deep));
+	if (stack == 0)
+		return ERR_OUTOFMEMORY;
+	// выработать подпись
+	code = dstuSignStep(sig, dstuCtxEc(ctx), ((const dstu_ctx_st*)ctx)->stack,
+		ld, hash, hash_len, privkey, rng, rng_state, stack);
+	// завершение
+	stackClose(stack);
+	return code;
+}
+
+err_t dstuVerifyCtx(const void* ctx, size_t ld, const octet hash[], 
+	size_t hash_len, const octet sig[], const octet pubkey[])
+{
+	err_t code;
+	void* stack;
+	// проверить ctx
+	if (!dstuCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// создать стек
+	stack = stackCreate(dstuCtxStack_keep(ctx, dstuVerify_deep));
+	if (stack == 0)
+		return ERR_OUTOFMEMORY;
+	// проверить подпись
+	code = dstuVerifyStep(dstuCtxEc(ctx), ((const dstu_ctx_st*)ctx)->stack,
+		ld, hash, hash_len, sig, pubkey, stack);
+	// завершение
+	stackClose(stack);
+	return code;
+}
@@ -4,15 +4,15 @@
 \brief GOST R 34.10-94 (Russia): digital signature algorithms
 \project bee2 [cryptographic library]
 \created 2012.07.09
-\version 2023.11.08
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
-#include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/str.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/g12s.h"
@@ -624,7 +624,7 @@ static err_t g12sEcCreate(
 	ec_keep = ecpCreateJ_keep(no);
 	ec_deep = ecpCreateJ_deep(no, f_deep);
 	// создать состояние
-	state = blobCreate(
+	state = stackCreate(
 		f_keep + ec_keep +
 		utilMax(3,
 			ec_deep,
@@ -637,7 +637,7 @@ static err_t g12sEcCreate(
 	stack = (octet*)f + f_keep;
 	if (!gfpCreate(f, params->p, no, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// проверить длину p
@@ -645,7 +645,7 @@ static err_t g12sEcCreate(
 	if (params->l == 256 && nb <= 253 ||
 		params->l == 512 && nb <= 507)
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// создать кривую и группу
@@ -654,7 +654,7 @@ static err_t g12sEcCreate(
 		!ecCreateGroup(ec, params->xP, params->yP, params->q, 
 			params->l / 8, params->n, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// проверить q
@@ -664,7 +664,7 @@ static err_t g12sEcCreate(
 		params->l == 512 && nb <= 508 ||
 		zzIsEven(ec->order, n))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// присоединить f к ec
@@ -682,7 +682,7 @@ static err_t g12sEcCreate(
 
 void g12sEcClose(ec_o* ec)
 {
-	blobClose(ec);
+	stackClose(ec);
 }
 
 /*
@@ -803,6 +803,24 @@ err_t g12sKeypairGen(octet privkey[], octet pubkey[],
 	return ERR_OK;
 }
 
+/*
+*******************************************************************************
+ЭЦП
+
+Кратные базовой точки вычисляются в функциях g12sSignStep() и
+g12sVerifyStep(). Если задана таблица pre, то используются гребенчатые
+функции ecCombMulA() и ecCombAddMulA(), в противном случае -- ecMulA()
+и ecAddMulA(). Таблица рассчитывается в g12sCtxStart().
+*******************************************************************************
+*/
+
+#ifdef BEE2_LOW_MEMORY
+	#define G12S_COMB_W 4
+#else
+	#define G12S_COMB_W 6
+#endif
+#define G12S_COMB_COUNT ((SIZE_1 << G12S_COMB_W) - 1)
+
 /*
 *******************************************************************************
 Выработка ЭЦП
@@ -814,45 +832,35 @@ static size_t g12sSign_deep(size_t n, size_t f_deep, size_t ec_d,
 {
 	const size_t m = n;
 	return 	O_OF_W(3 * m + 2 * n) +
-		utilMax(3,
+		utilMax(4,
 			zzMod_deep(m, m),
 			ecMulA_deep(n, ec_d, ec_deep, n),
+			ecCombMulA_deep(n, ec_d, ec_deep),
 			zzMulMod_deep(m));
 }
 
-err_t g12sSign(octet sig[], const g12s_params* params, const octet hash[],
-	const octet privkey[], gen_i rng, void* rng_stack)
+static err_t g12sSignStep(octet sig[], const ec_o* ec, const word pre[],
+	size_t l, const octet hash[], const octet privkey[], gen_i rng,
+	void* rng_stack, void* stack)
 {
-	err_t code;
 	size_t m, mo;
 	// состояние
-	ec_o* ec = 0;
 	word* d;		/* [m] личный ключ */
 	word* e;		/* [m] обработанное хэш-значение */
 	word* k;		/* [m] одноразовый ключ */
 	word* C;		/* [2n] вспомогательная точка */
 	word* r;		/* [m] первая (старшая) часть подписи */
 	word* s;		/* [m] вторая часть подписи */
-	void* stack;
-	// проверить rng
-	if (rng == 0)
-		return ERR_BAD_RNG;
-	// старт
-	code = g12sEcCreate(&ec, params, g12sSign_deep);
-	ERR_CALL_CHECK(code);
 	// размерности order
-	m = W_OF_B(params->l);
-	mo = O_OF_B(params->l);
+	m = W_OF_B(l);
+	mo = O_OF_B(l);
 	// проверить входные указатели
 	if (!memIsValid(hash, mo) ||
 		!memIsValid(privkey, mo) ||
 		!memIsValid(sig, 2 * mo))
-	{
-		g12sEcClose(ec);
 		return ERR_BAD_INPUT;
-	}
 	// раскладка состояния
-	d = objEnd(ec, word);
+	d = (word*)stack;
 	e = d + m;
 	k = e + m;
 	C = k + m;
@@ -863,10 +871,7 @@ err_t g12sSign(octet sig[], const g12s_params* params, const octet hash[],
 	wwFrom(d, privkey, mo);
 	if (wwIsZero(d, m) || 
 		wwCmp(d, ec->order, m) >= 0)
-	{
-		g12sEcClose(ec);
 		return ERR_BAD_PRIVKEY;
-	}
 	// e <- hash \mod q
 	memCopy(e, hash, mo);
 	memRev(e, mo);
@@ -878,17 +883,12 @@ err_t g12sSign(octet sig[], const g12s_params* params, const octet hash[],
 	// k <-R {1,2,..., q - 1}
 gen_k:
 	if (!zzRandNZMod(k, ec->order, m, rng, rng_stack))
-	{
-		g12sEcClose(ec);
 		return ERR_BAD_RNG;
-	}
 	// C <- k P
-	if (!ecMulA(C, ec->base, ec, k, m, stack))
-	{
+	if (pre ? !ecCombMulA(C, pre, ec, G12S_COMB_W, k, m, stack) :
+		!ecMulA(C, ec->base, ec, k, m, stack))
 		// если params корректны, то этого быть не должно
-		g12sEcClose(ec);
 		return ERR_BAD_INPUT;
-	}
 	// r <- x_C \mod q
 	qrTo((octet*)C, ecX(C), ec->f, stack);
 	wwFrom(r, C, ec->f->no);
@@ -905,10 +905,28 @@ gen_k:
 	wwTo(sig + mo, mo, r);
 	memRev(sig, 2 * mo);
 	// все нормально
-	g12sEcClose(ec);
 	return ERR_OK;
 }
 
+err_t g12sSign(octet sig[], const g12s_params* params, const octet hash[],
+	const octet privkey[], gen_i rng, void* rng_stack)
+{
+	err_t code;
+	ec_o* ec = 0;
+	// проверить rng
+	if (rng == 0)
+		return ERR_BAD_RNG;
+	// старт
+	code = g12sEcCreate(&ec, params, g12sSign_deep);
+	ERR_CALL_CHECK(code);
+	// выработать подпись
+	code = g12sSignStep(sig, ec, 0, params->l, hash, privkey, rng,
+		rng_stack, objEnd(ec, void));
+	// завершение
+	g12sEcClose(ec);
+	return code;
+}
+
 /*
 *******************************************************************************
 Проверка ЭЦП
@@ -920,41 +938,34 @@ static size_t g12sVerify_deep(size_t n, size_t f_deep, size_t ec_d,
 {
 	const size_t m = n;
 	return O_OF_W(5 * m + 2 * n) +
-		utilMax(4,
+		utilMax(5,
 			zzMod_deep(m, m),
 			zzMulMod_deep(m),
 			zzInvMod_deep(m),
-			ecAddMulA_deep(n, ec_d, ec_deep, 2, m, m));
+			ecAddMulA_deep(n, ec_d, ec_deep, 2, m, m),
+			ecCombAddMulA_deep(n, ec_d, ec_deep, m));
 }
 
-err_t g12sVerify(const g12s_params* params, const octet hash[], 
-	const octet sig[], const octet pubkey[])
+static err_t g12sVerifyStep(const ec_o* ec, const word pre[], size_t l,
+	const octet hash[], const octet sig[], const octet pubkey[], void* stack)
 {
 	err_t code;
 	size_t m, mo;
 	// состояние
-	ec_o* ec = 0;
 	word* Q;		/* [2n] открытый ключ / точка R */
 	word* r;		/* [m] первая (старшая) часть подписи */
 	word* s;		/* [m] вторая часть подписи */
 	word* e;		/* [m] обработанное хэш-значение, v */
-	void* stack;
-	// старт
-	code = g12sEcCreate(&ec, params, g12sVerify_deep);
-	ERR_CALL_CHECK(code);
 	// размерности order
-	m = W_OF_B(params->l);
-	mo = O_OF_B(params->l);
+	m = W_OF_B(l);
+	mo = O_OF_B(l);
 	// проверить входные указатели
 	if (!memIsValid(hash, mo) ||
 		!memIsValid(sig, 2 * mo) ||
 		!memIsValid(pubkey, 2 * ec->f->no))
-	{
-		g12sEcClose(ec);
 		return ERR_BAD_INPUT;
-	}
 	// раскладка состояния
-	Q = objEnd(ec, word);
+	Q = (word*)stack;
 	r = Q + 2 * ec->f->n;
 	s = r + m;
 	e = s + m;
@@ -962,10 +973,7 @@ err_t g12sVerify(const g12s_params* params, const octet hash[],
 	// загрузить Q
 	if (!qrFrom(ecX(Q), pubkey, ec->f, stack) ||
 		!qrFrom(ecY(Q, ec->f->n), pubkey + ec->f->no, ec->f, stack))
-	{
-		g12sEcClose(ec);
 		return ERR_BAD_PUBKEY;
-	}
 	// загрузить r и s
 	memCopy(s, sig + mo, mo);
 	memRev(s, mo);
@@ -973,42 +981,198 @@ err_t g12sVerify(const g12s_params* params, const octet hash[],
 	memCopy(r, sig, mo);
 	memRev(r, mo);
 	wwFrom(r, r, mo);
-	if (wwIsZero(s, m) || 
-		wwIsZero(r, m) || 
-		wwCmp(s, ec->order, m) >= 0 ||
-		wwCmp(r, ec->order, m) >= 0)
-	{
-		g12sEcClose(ec);
+	// [открытые данные: ускоренные сравнения]
+	if (FAST(wwIsZero)(s, m) ||
+		FAST(wwIsZero)(r, m) ||
+		FAST(wwCmp)(s, ec->order, m) >= 0 ||
+		FAST(wwCmp)(r, ec->order, m) >= 0)
 		return ERR_BAD_SIG;
-	}
 	// e <- hash \mod q
 	memCopy(e, hash, mo);
 	memRev(e, mo);
 	wwFrom(e, e, mo);
 	zzMod(e, e, m, ec->order, m, stack);
 	// e == 0 => e <- 1
-	if (wwIsZero(e, m))
+	if (FAST(wwIsZero)(e, m))
 		e[0] = 1;
-	// e <- e^{-1} \mod q [v]
+	// e <- e^{-1} \mod q [v] (регулярное обращение быстрее ускоренного)
 	zzInvMod(e, e, ec->order, m, stack);
 	// s <- s e \mod q [z1]
 	zzMulMod(s, s, e, ec->order, m, stack);
 	// e <- - e r \mod q [z2]
 	zzMulMod(e, e, r, ec->order, m, stack);
-	zzNegMod(e, e, ec->order, m);
+	FAST(zzNegMod)(e, e, ec->order, m);
 	// Q <- s P + e Q [z1 P + z2 Q = R]
-	if (!ecAddMulA(Q, ec, stack, 2, ec->base, s, m, Q, e, m))
-	{
-		g12sEcClose(ec);
+	if (pre ? 
+		!ecCombAddMulA(Q, pre, ec, G12S_COMB_W, s, m, Q, e, m, stack) :
+		!ecAddMulA(Q, ec, stack, 2, ec->base, s, m, Q, e, m))
 		return ERR_BAD_PARAMS;
-	}
 	// s <- x_Q \mod q [x_R \mod q]
 	qrTo((octet*)Q, ecX(Q), ec->f, stack);
 	wwFrom(Q, Q, ec->f->no);
 	zzMod(s, Q, ec->f->n, ec->order, m, stack);
 	// s == r?
-	code = wwEq(r, s, m) ? ERR_OK : ERR_BAD_SIG;
+	code = FAST(wwEq)(r, s, m) ? ERR_OK : ERR_BAD_SIG;
+	// завершение
+	return code;
+}
+
+err_t g12sVerify(const g12s_params* params, const octet hash[], 
+	const octet sig[], const octet pubkey[])
+{
+	err_t code;
+	ec_o* ec = 0;
+	// старт
+	code = g12sEcCreate(&ec, params, g12sVerify_deep);
+	ERR_CALL_CHECK(code);
+	// проверить подпись
+	code = g12sVerifyStep(ec, 0, params->l, hash, sig, pubkey, 
+		objEnd(ec, void));
 	// завершение
 	g12sEcClose(ec);
 	return code;
 }
+
+/*
+*******************************************************************************
+Контекст
+
+Контекст содержит копию долговременных параметров, таблицу гребенки
+[2 * n * G12S_COMB_COUNT]pre для базовой точки и описание кривой,
+построенное в g12sEcCreate(). Таблица рассчитывается для кратностей
+длины W_OF_B(l) слов (длина порядка q). Описание кривой копируется 
+в контекст функцией objCopy(), которая корректирует внутренние указатели 
+описания.
+
+Длина p не превосходит l битов (см. g12sEcCreate()), поэтому
+n <= W_OF_B(l) и g12sCtx_keep() рассчитывается по l.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	g12s_params params[1];	/* долговременные параметры */
+	word stack[];			/* таблица pre и описание кривой */
+} g12s_ctx_st;
+
+size_t g12sCtx_keep(size_t l)
+{
+	const size_t no = O_OF_B(l);
+	const size_t n = W_OF_B(l);
+	ASSERT(l == 256 || l == 512);
+	return sizeof(g12s_ctx_st) + O_OF_W(2 * n * G12S_COMB_COUNT) +
+		ecpCreateJ_keep(no) + gfpCreate_keep(no);
+}
+
+static size_t g12sCtxStart_deep(size_t n, size_t f_deep, size_t ec_d,
+	size_t ec_deep)
+{
+	return ecCombPrecompA_deep(n, ec_d, ec_deep);
+}
+
+err_t g12sCtxStart(void* ctx, const g12s_params* params)
+{
+	err_t code;
+	g12s_ctx_st* st = (g12s_ctx_st*)ctx;
+	size_t n;
+	ec_o* ec = 0;
+	// проверить params
+	if (!memIsValid(params, sizeof(g12s_params)))
+		return ERR_BAD_INPUT;
+	if (params->l != 256 && params->l != 512)
+		return ERR_BAD_PARAMS;
+	// проверить ctx
+	if (!memIsValid(ctx, g12sCtx_keep(params->l)))
+		return ERR_BAD_INPUT;
+	// построить описание кривой
+	code = g12sEcCreate(&ec, params, g12sCtxStart_deep);
+	ERR_CALL_CHECK(code);
+	n = ec->f->n;
+	ASSERT(n <= W_OF_B(params->l));
+	ASSERT(sizeof(g12s_ctx_st) + O_OF_W(2 * n * G12S_COMB_COUNT) + 
+		objKeep(ec) <= g12sCtx_keep(params->l));
+	// рассчитать таблицу
+	if (!ecCombPrecompA(st->stack, ec->base, ec, G12S_COMB_W,
+		W_OF_B(params->l), objEnd(ec, void)))
+		code = ERR_BAD_PARAMS;
+	// скопировать параметры и описание кривой в контекст
+	else
+	{
+		memCopy(st->params, params, sizeof(g12s_params));
+		objCopy(st->stack + 2 * n * G12S_COMB_COUNT, ec);
+	}
+	g12sEcClose(ec);
+	return code;
+}
+
+/*
+	Размерность n базового поля хранится в описании кривой, а описание 
+	размещается после таблицы длины 2 * n * G12S_COMB_COUNT слов. Поэтому n 
+	определяется по p так же, как в g12sEcCreate().
+*/
+static const ec_o* g12sCtxEc(const void* ctx)
+{
+	const g12s_ctx_st* st = (const g12s_ctx_st*)ctx;
+	const size_t n = W_OF_O(memNonZeroSize(st->params->p,
+		sizeof(st->params->p) * st->params->l / 512));
+	return (const ec_o*)(st->stack + 2 * n * G12S_COMB_COUNT);
+}
+
+static bool_t g12sCtxIsOperable(const void* ctx)
+{
+	const g12s_ctx_st* st = (const g12s_ctx_st*)ctx;
+	return memIsValid(ctx, sizeof(g12s_ctx_st)) &&
+		(st->params->l == 256 || st->params->l == 512) &&
+		ecIsOperable(g12sCtxEc(ctx));
+}
+
+static size_t g12sCtxStack_keep(const void* ctx, g12s_deep_i deep)
+{
+	const ec_o* ec = g12sCtxEc(ctx);
+	ASSERT(g12sCtxIsOperable(ctx));
+	return deep(ec->f->n, ec->f->deep, ec->d, ec->deep);
+}
+
+err_t g12sSignCtx(octet sig[], const void* ctx, const octet hash[],
+	const octet privkey[], gen_i rng, void* rng_stack)
+{
+	err_t code;
+	void* stack;
+	// проверить ctx
+	if (!g12sCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// проверить rng
+	if (rng == 0)
+		return ERR_BAD_RNG;
+	// создать стек
+	stack = stackCreate(g12sCtxStack_keep(ctx, g12sSign_deep));
+	if (stack == 0)
+		return ERR_OUTOFMEMORY;
+	// выработать подпись
+	code = g12sSignStep(sig, g12sCtxEc(ctx), ((const g12s_ctx_st*)ctx)->stack,
+		((const g12s_ctx_st*)ctx)->params->l, hash, privkey, rng, rng_stack,
+		stack);
+	// завершение
+	stackClose(stack);
+	return code;
+}
+
+err_t g12sVerifyCtx(const void* ctx, const octet hash[], const octet sig[],
+	const octet pubkey[])
+{
+	err_t code;
+	void* stack;
+	// проверить ctx
+	if (!g12sCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// создать стек
+	stack = stackCreate(g12sCtxStack_keep(ctx, g12sVerify_deep));
+	if (stack == 0)
+		return ERR_OUTOFMEMORY;
+	// проверить подпись
+	code = g12sVerifyStep(g12sCtxEc(ctx), ((const g12s_ctx_st*)ctx)->stack,
+		((const g12s_ctx_st*)ctx)->params->l, hash, sig, pubkey, stack);
+	// завершение
+	stackClose(stack);
+	return code;
+}
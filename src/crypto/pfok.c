@@ -4,16 +4,17 @@
 \brief Draft of RD_RB: key establishment protocols in finite fields
 \project bee2 [cryptographic library]
 \created 2014.07.01
-\version 2024.03.04
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
-#include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
 #include "bee2/core/prng.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/str.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/pfok.h"
@@ -572,31 +573,95 @@ Proof:
 	ord g = 1 => g = e  => g^(q) = e
 	ord g = 2 => g = -e => g^(q) = g
 	ord g = q           => g^(q) = e
+
+Состояние генерации pfok_gen_st не содержит указателей: простые числа
+цепочки хранятся в массиве qi, который размещается в data вслед
+за состоянием генератора СТБ, текущее простое определяется номером i
+в цепочке li и смещением offset в qi. Поэтому состояние можно сохранить
+(например, в файл) и продолжить генерацию по сохраненной копии.
+
+Число слов qw для хранения цепочки не превосходит W_OF_B(5 * l) + 21:
+li[j + 1] < 4 li[j] / 5, поэтому сумма li[j] меньше 5 l, а цепочка
+содержит не более 20 чисел (плюс слово для минимального простого).
 *******************************************************************************
 */
 
-err_t pfokParamsGen(pfok_params* params, const pfok_seed* seed, 
-	pfok_on_q_i on_q)
+typedef struct
+{
+	pfok_seed seed[1];	/*< затравочные параметры */
+	size_t qw;			/*< число слов для хранения qi */
+	size_t i;			/*< номер текущего простого в цепочке */
+	size_t offset;		/*< смещение текущего простого в qi */
+	size_t num;			/*< число построенных кандидатов q */
+	bool_t found;		/*< p построено? */
+	word data[];		/*< [prngSTB_keep()]stb || [qw]qi */
+} pfok_gen_st;
+
+static size_t pfokParamsGenQW(const pfok_seed* seed)
 {
+	size_t i, qw;
+	for (i = 1, qw = W_OF_B(seed->li[0]); seed->li[i] > 32; ++i)
+		qw += W_OF_B(seed->li[i]);
+	ASSERT(seed->li[i] > 16);
+	ASSERT(W_OF_B(seed->li[i]) == 1);
+	return qw + 1;
+}
+
+size_t pfokParamsGen_keep(size_t l)
+{
+	return sizeof(pfok_gen_st) + O_OF_W(W_OF_O(prngSTB_keep())) +
+		O_OF_W(W_OF_B(5 * l) + 21);
+}
+
+err_t pfokParamsGenStart(void* state, const pfok_seed* seed)
+{
+	pfok_gen_st* st = (pfok_gen_st*)state;
 	err_t code;
-	size_t num = 0;
+	// проверить входные данные
+	code = pfokSeedVal(seed);
+	ERR_CALL_CHECK(code);
+	if (!memIsValid(state, pfokParamsGen_keep(seed->l)))
+		return ERR_BAD_INPUT;
+	// настроить состояние
+	memCopy(st->seed, seed, sizeof(pfok_seed));
+	st->qw = pfokParamsGenQW(seed);
+	ASSERT(st->qw <= W_OF_B(5 * seed->l) + 21);
+	for (st->i = 1; seed->li[st->i] > 32; ++st->i);
+	st->offset = st->qw - 1;
+	st->num = 0;
+	st->found = FALSE;
+	prngSTBStart(st->data, seed->zi);
+	wwSetZero(st->data + W_OF_O(prngSTB_keep()), st->qw);
+	return ERR_OK;
+}
+
+err_t pfokParamsGenStep(pfok_params* params, void* state, size_t max,
+	size_t threads, pfok_on_q_i on_q)
+{
+	pfok_gen_st* st = (pfok_gen_st*)state;
+	const pfok_seed* seed;
+	size_t count = 0;
 	size_t i;
 	size_t n, no;
-	size_t qw;			/* число слов для хранения qi */
-	size_t offset;
 	size_t trials;
 	size_t base_count;
 	// состояние 
-	void* state;
+	void* mem;
 	octet* stb_state;
 	word* qi;
 	word* p;
 	word* g;
 	qr_o* qr;
 	void* stack;
-	// проверить seed
-	code = pfokSeedVal(seed);
-	ERR_CALL_CHECK(code);
+	// проверить состояние
+	if (!memIsValid(st, sizeof(pfok_gen_st)) ||
+		pfokSeedVal(st->seed) != ERR_OK ||
+		!memIsValid(st, pfokParamsGen_keep(st->seed->l)) ||
+		st->qw != pfokParamsGenQW(st->seed) ||
+		st->i >= COUNT_OF(st->seed->li) || st->seed->li[st->i] == 0 ||
+		st->offset >= st->qw)
+		return ERR_BAD_INPUT;
+	seed = st->seed;
 	// подготовить params
 	if (!memIsValid(params, sizeof(pfok_params)))
 		return ERR_BAD_INPUT;
@@ -607,92 +672,95 @@ err_t pfokParamsGen(pfok_params* params, const pfok_seed* seed,
 			break;
 	ASSERT(i != COUNT_OF(_ls));
 	params->r = _rs[i], params->n = 256;
-	// определить qw
-	for (i = 1, qw = W_OF_B(seed->li[0]); seed->li[i] > 32; ++i)
-		qw += W_OF_B(seed->li[i]);
-	ASSERT(seed->li[i] > 16);
-	ASSERT(W_OF_B(seed->li[i]) == 1);
-	qw += 1;
 	// размерности
 	n = W_OF_B(params->l), no = O_OF_B(params->l);
 	ASSERT(W_OF_B(seed->li[0]) == n);
-	// создать состояние
-	state = blobCreate(
-		prngSTB_keep() + O_OF_W(qw + 2 * n) + zmMontCreate_keep(no) +
+	// создать стек
+	mem = stackCreate(O_OF_W(2 * n) + zmMontCreate_keep(no) +
 		utilMax(6,
 			priNextPrimeW_deep(),
-			priExtendPrime_deep(params->l, W_OF_B(seed->li[1]),
-				(seed->li[0] + 3) / 4),
+			priExtendPrimeMT_deep(params->l, W_OF_B(seed->li[1]),
+				(seed->li[0] + 3) / 4, threads),
 			priIsSieved_deep((seed->li[0] + 3) / 4),
 			priIsSGPrime_deep(n),
 			zmMontCreate_deep(no), 
 			qrPower_deep(n, n, zmMontCreate_deep(no))));
-	if (state == 0)
+	if (mem == 0)
 		return ERR_OUTOFMEMORY;
-	// раскладка состояния
-	stb_state = (octet*)state;
-	qi = (word*)(stb_state + prngSTB_keep());
-	p = qi + qw;
+	// раскладка
+	stb_state = (octet*)st->data;
+	qi = st->data + W_OF_O(prngSTB_keep());
+	p = (word*)mem;
 	g = p + n;
 	qr = (qr_o*)(g + n);
 	stack = (octet*)qr + zmMontCreate_keep(no);
-	// запустить генератор
-	prngSTBStart(stb_state, seed->zi);
 	// основной цикл
-	offset = qw - 1;
-	while (1)
+	for (i = st->i; !st->found;)
 	{
+		// прервать генерацию?
+		if (count == max)
+		{
+			stackClose(mem);
+			return ERR_NOT_READY;
+		}
 		// первое (минимальное) простое?
 		if (seed->li[i] <= 32)
 		{
 			do
 			{
-				prngSTBStepR(qi + offset, O_OF_B(seed->li[i]), stb_state);
-				wwFrom(qi + offset, qi + offset, O_OF_B(seed->li[i]));
-				wwTrimHi(qi + offset, W_OF_B(seed->li[i]), seed->li[i] - 1);
-				wwSetBit(qi + offset, seed->li[i] - 1, 1);
+				prngSTBStepR(qi + st->offset, O_OF_B(seed->li[i]), stb_state);
+				wwFrom(qi + st->offset, qi + st->offset, O_OF_B(seed->li[i]));
+				wwTrimHi(qi + st->offset, W_OF_B(seed->li[i]),
+					seed->li[i] - 1);
+				wwSetBit(qi + st->offset, seed->li[i] - 1, 1);
 			}
-			while (!priNextPrimeW(qi + offset, qi[offset], stack));
+			while (!priNextPrimeW(qi + st->offset, qi[st->offset], stack));
 			// к следующему простому
-			offset -= W_OF_B(seed->li[--i]);
+			st->offset -= W_OF_B(seed->li[--i]);
+			st->i = i;
 			continue;
 		}
 		// обычное простое
 		trials = (i == 0) ? 4 * seed->li[i] * seed->li[i] : 4 * seed->li[i];
-		base_count = (seed->li[i] + 3) / 4;
 		// потенциальное отступление от Проекта, не влияющее на результат
-		if (base_count > priBaseSize())
-			base_count = priBaseSize();
+		base_count = MIN2((seed->li[i] + 3) / 4, priBaseSize());
 		// не удается построить новое простое?
-		if (!priExtendPrime(qi + offset, seed->li[i],
-				qi + offset + W_OF_B(seed->li[i]), W_OF_B(seed->li[i + 1]),
-				trials, base_count, prngSTBStepR, stb_state, stack))
+		if (!priExtendPrimeMT(qi + st->offset, seed->li[i],
+				qi + st->offset + W_OF_B(seed->li[i]), W_OF_B(seed->li[i + 1]),
+				trials, base_count, threads, prngSTBStepR, stb_state, stack))
 		{
 			// к предыдущему простому
-			offset += W_OF_B(seed->li[i++]);
+			st->offset += W_OF_B(seed->li[i++]);
+			st->i = i;
 			continue;
 		}
 		// последнее простое?
 		if (i == 0)
 		{
 			// обработать новое q
-			on_q ? on_q(qi, W_OF_B(seed->li[0]), ++num) : 0;
+			++st->num, ++count;
+			on_q ? on_q(qi, n, st->num) : 0;
 			// p <- 2 * q + 1
-			ASSERT(W_OF_B(seed->li[0]) == n);
 			wwCopy(p, qi, n);
 			wwShHi(p, n, 1);
 			p[0] |= 1;
 			// p -- простое?
-			if (priIsSieved(p, n, base_count, stack) && 
-				priIsSGPrime(qi, n, stack))
-				break;
+			st->found = priIsSieved(p, n, base_count, stack) && 
+				priIsSGPrime(qi, n, stack);
 		}
 		// нет, к следующему простому
 		else
-			offset -= W_OF_B(seed->li[--i]);
+		{
+			st->offset -= W_OF_B(seed->li[--i]);
+			st->i = i;
+		}
 	}
 	// информировать о завершении
-	on_q ? on_q(qi, W_OF_B(seed->li[0]), 0) : 0;
+	on_q ? on_q(qi, n, 0) : 0;
+	// p <- 2 * q + 1
+	wwCopy(p, qi, n);
+	wwShHi(p, n, 1);
+	p[0] |= 1;
 	// сохранить p
 	wwTo(params->p, no, p);
 	// построить кольцо Монтгомери
@@ -704,7 +772,7 @@ err_t pfokParamsGen(pfok_params* params, const pfok_seed* seed,
 	while (1)
 	{
 		// g^(q) != e && g^(q) != g?
-		qrPower(p, g, qi, W_OF_B(seed->li[0]), qr, stack);
+		qrPower(p, g, qi, n, qr, stack);
 		if (!qrIsUnity(p, qr) && qrCmp(p, g, qr) != 0)
 			break;
 		// g <- g + 1
@@ -713,10 +781,31 @@ err_t pfokParamsGen(pfok_params* params, const pfok_seed* seed,
 	// сохранить g
 	wwTo(params->g, no, g);
 	// все нормально
-	blobClose(state);
+	stackClose(mem);
 	return ERR_OK;
 }
 
+err_t pfokParamsGen(pfok_params* params, const pfok_seed* seed, 
+	pfok_on_q_i on_q)
+{
+	err_t code;
+	void* state;
+	// проверить seed
+	code = pfokSeedVal(seed);
+	ERR_CALL_CHECK(code);
+	// создать состояние
+	state = stackCreate(pfokParamsGen_keep(seed->l));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// генерировать
+	code = pfokParamsGenStart(state, seed);
+	if (code == ERR_OK)
+		code = pfokParamsGenStep(params, state, SIZE_MAX, mtCPUs(), on_q);
+	// завершение
+	stackClose(state);
+	return code;
+}
+
 err_t pfokParamsVal(const pfok_params* params)
 {
 	size_t n, no;
@@ -736,7 +825,7 @@ err_t pfokParamsVal(const pfok_params* params)
 	// размерности
 	no = O_OF_B(params->l), n = W_OF_B(params->l);
 	// создать состояние
-	state = blobCreate(
+	state = stackCreate(
 		O_OF_W(2 * n) + zmMontCreate_keep(no) +  
 		utilMax(3,
 			priIsPrime_deep(n),
@@ -753,14 +842,14 @@ err_t pfokParamsVal(const pfok_params* params)
 	wwFrom(p, params->p, no);
 	if (!priIsPrime(p, n, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// q -- простое?
 	wwShLo(q = p, n, 1);
 	if (!priIsPrime(q, n, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// построить кольцо Монтгомери
@@ -771,73 +860,146 @@ err_t pfokParamsVal(const pfok_params* params)
 		qrIsUnity(p, qr) || 
 		qrCmp(p, g, qr) == 0)
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// все нормально
-	blobClose(state);
+	stackClose(state);
 	return ERR_OK;
 }
 
+/*
+*******************************************************************************
+Степени g
+
+Степени g^x вычисляются в функции pfokPowerG(). Если задана таблица pre,
+то используется гребенчатый метод (функция qrCombPowerCT()), в противном
+случае -- метод фиксированного окна (функция qrPowerCT()). Таблица
+рассчитывается в pfokCtxStart().
+
+Функции pfokXXXStep() реализуют функции pfokXXX() в кольце Монтгомери qr,
+которое построено по параметрам params. Память для кольца резервируется
+в функции pfokStateCreate().
+*******************************************************************************
+*/
+
+#ifdef BEE2_LOW_MEMORY
+	#define PFOK_COMB_W 4
+#else
+	#define PFOK_COMB_W 6
+#endif
+
+static void pfokPowerG(word y[], const pfok_params* params, const qr_o* qr,
+	const word pre[], const word x[], size_t m, void* stack)
+{
+	if (pre)
+		qrCombPowerCT(y, pre, PFOK_COMB_W, x, m, qr, stack);
+	else
+	{
+		wwFrom(y, params->g, qr->no);
+		qrPowerCT(y, y, x, m, qr, stack);
+	}
+}
+
+static size_t pfokPowerG_deep(size_t n, size_t m, size_t r_deep)
+{
+	return utilMax(2,
+		qrPowerCT_deep(n, m, r_deep),
+		qrCombPowerCT_deep(n, r_deep));
+}
+
+static void* pfokStateCreate(qr_o** qr, const pfok_params* params, 
+	size_t deep)
+{
+	const size_t no = O_OF_B(params->l);
+	void* state;
+	state = stackCreate(zmMontCreate_keep(no) + 
+		utilMax(2,
+			zmMontCreate_deep(no),
+			deep));
+	if (state)
+	{
+		*qr = (qr_o*)state;
+		zmMontCreate(*qr, params->p, no, params->l + 2, 
+			(octet*)state + zmMontCreate_keep(no));
+	}
+	return state;
+}
+
+static void* pfokStateStack(const pfok_params* params, void* state)
+{
+	return (octet*)state + zmMontCreate_keep(O_OF_B(params->l));
+}
+
 /*
 *******************************************************************************
 Управление ключами
 *******************************************************************************
 */
 
-err_t pfokKeypairGen(octet privkey[], octet pubkey[], 
-	const pfok_params* params, gen_i rng, void* rng_state)
+static size_t pfokKeypairGen_deep(size_t n, size_t m, size_t r_deep)
+{
+	return O_OF_W(n + m) + pfokPowerG_deep(n, m, r_deep);
+}
+
+static err_t pfokKeypairGenStep(octet privkey[], octet pubkey[],
+	const pfok_params* params, const qr_o* qr, const word pre[], gen_i rng,
+	void* rng_state, void* stack)
 {
 	size_t n, no;
 	size_t m, mo;
 	// состояние
-	void* state;
 	word* x;				/* [m] личный ключ */
 	word* y;				/* [n] открытый ключ */
-	qr_o* qr;				/* описание кольца Монтгомери */
-	void* stack;
-	// проверить params
-	if (!memIsValid(params, sizeof(pfok_params)))
-		return ERR_BAD_INPUT;
-	// работоспособные параметры?
-	if (!pfokParamsIsOperable(params))
-		return ERR_BAD_PARAMS;
 	// размерности
 	n = W_OF_B(params->l), no = O_OF_B(params->l);
 	m = W_OF_B(params->r), mo = O_OF_B(params->r);
-	// проверить остальные входные данные
+	// проверить входные данные
 	if (!memIsValid(privkey, mo) || !memIsValid(pubkey, no) || rng == 0)
 		return ERR_BAD_INPUT;
-	// создать состояние
-	state = blobCreate(
-		O_OF_W(n) + O_OF_W(m) + zmMontCreate_keep(no) +  
-		utilMax(2,
-			zmMontCreate_deep(no),
-			qrPower_deep(n, n, zmMontCreate_deep(no))));
-	if (state == 0)
-		return ERR_OUTOFMEMORY;
 	// раскладка состояния
-	x = (word*)state;
+	x = (word*)stack;
 	y = x + m;
-	qr = (qr_o*)(y + n);
-	stack = (octet*)qr + zmMontCreate_keep(no);
-	// построить кольцо Монтгомери
-	zmMontCreate(qr, params->p, no, params->l + 2, stack);
+	stack = y + n;
 	// x <-R {0, 1,..., 2^r - 1}
 	rng(x, mo, rng_state);
 	wwFrom(x, x, mo);
 	wwTrimHi(x, m, params->r);
 	// y <- g^(x)
-	wwFrom(y, params->g, no);
-	qrPower(y, y, x, m, qr, stack);
+	pfokPowerG(y, params, qr, pre, x, m, stack);
 	// выгрузить ключи
 	wwTo(privkey, mo, x);
 	qrTo(pubkey, y, qr, stack);
 	// все нормально
-	blobClose(state);
 	return ERR_OK;
 }
 
+err_t pfokKeypairGen(octet privkey[], octet pubkey[], 
+	const pfok_params* params, gen_i rng, void* rng_state)
+{
+	err_t code;
+	void* state;
+	qr_o* qr;				/* описание кольца Монтгомери */
+	// проверить params
+	if (!memIsValid(params, sizeof(pfok_params)))
+		return ERR_BAD_INPUT;
+	// работоспособные параметры?
+	if (!pfokParamsIsOperable(params))
+		return ERR_BAD_PARAMS;
+	// создать состояние
+	state = pfokStateCreate(&qr, params, pfokKeypairGen_deep(
+		W_OF_B(params->l), W_OF_B(params->r), 
+		zmMontCreate_deep(O_OF_B(params->l))));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// сгенерировать ключи
+	code = pfokKeypairGenStep(privkey, pubkey, params, qr, 0, rng, 
+		rng_state, pfokStateStack(params, state));
+	// завершение
+	stackClose(state);
+	return code;
+}
+
 err_t pfokPubkeyVal(const pfok_params* params, const octet pubkey[])
 {
 	size_t no;
@@ -859,200 +1021,189 @@ err_t pfokPubkeyVal(const pfok_params* params, const octet pubkey[])
 	return ERR_OK;
 }
 
-err_t pfokPubkeyCalc(octet pubkey[], const pfok_params* params, 
-	const octet privkey[])
+static size_t pfokPubkeyCalc_deep(size_t n, size_t m, size_t r_deep)
+{
+	return O_OF_W(n + m) + pfokPowerG_deep(n, m, r_deep);
+}
+
+static err_t pfokPubkeyCalcStep(octet pubkey[], const pfok_params* params,
+	const qr_o* qr, const word pre[], const octet privkey[], void* stack)
 {
 	size_t n, no;
 	size_t m, mo;
 	// состояние
-	void* state;
 	word* x;				/* [m] личный ключ */
 	word* y;				/* [n] открытый ключ */
-	qr_o* qr;				/* описание кольца Монтгомери */
-	void* stack;
-	// проверить params
-	if (!memIsValid(params, sizeof(pfok_params)))
-		return ERR_BAD_INPUT;
-	// работоспособные параметры?
-	if (!pfokParamsIsOperable(params))
-		return ERR_BAD_PARAMS;
 	// размерности
 	n = W_OF_B(params->l), no = O_OF_B(params->l);
 	m = W_OF_B(params->r), mo = O_OF_B(params->r);
-	// проверить остальные входные данные
+	// проверить входные данные
 	if (!memIsValid(privkey, mo) || !memIsValid(pubkey, no))
 		return ERR_BAD_INPUT;
-	// создать состояние
-	state = blobCreate(
-		O_OF_W(n) + O_OF_W(m) + zmMontCreate_keep(no) +  
-		utilMax(2,
-			zmMontCreate_deep(no),
-			qrPower_deep(n, n, zmMontCreate_deep(no))));
-	if (state == 0)
-		return ERR_OUTOFMEMORY;
 	// раскладка состояния
-	x = (word*)state;
+	x = (word*)stack;
 	y = x + m;
-	qr = (qr_o*)(y + n);
-	stack = (octet*)qr + zmMontCreate_keep(no);
-	// построить кольцо Монтгомери
-	zmMontCreate(qr, params->p, no, params->l + 2, stack);
+	stack = y + n;
 	// x <- privkey
 	wwFrom(x, privkey, mo);
 	if (wwGetBits(x, params->r, B_OF_W(m) - params->r) != 0)
-	{
-		blobClose(state);
 		return ERR_BAD_PRIVKEY;
-	}
 	// y <- g^(x)
-	wwFrom(y, params->g, no);
-	qrPower(y, y, x, m, qr, stack);
+	pfokPowerG(y, params, qr, pre, x, m, stack);
 	// выгрузить открытый ключ
 	qrTo(pubkey, y, qr, stack);
 	// все нормально
-	blobClose(state);
 	return ERR_OK;
 }
 
+err_t pfokPubkeyCalc(octet pubkey[], const pfok_params* params, 
+	const octet privkey[])
+{
+	err_t code;
+	void* state;
+	qr_o* qr;				/* описание кольца Монтгомери */
+	// проверить params
+	if (!memIsValid(params, sizeof(pfok_params)))
+		return ERR_BAD_INPUT;
+	// работоспособные параметры?
+	if (!pfokParamsIsOperable(params))
+		return ERR_BAD_PARAMS;
+	// создать состояние
+	state = pfokStateCreate(&qr, params, pfokPubkeyCalc_deep(
+		W_OF_B(params->l), W_OF_B(params->r), 
+		zmMontCreate_deep(O_OF_B(params->l))));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// построить открытый ключ
+	code = pfokPubkeyCalcStep(pubkey, params, qr, 0, privkey,
+		pfokStateStack(params, state));
+	// завершение
+	stackClose(state);
+	return code;
+}
+
 /*
 *******************************************************************************
 Протоколы
 *******************************************************************************
 */
 
-err_t pfokDH(octet sharekey[], const pfok_params* params, 
-	const octet privkey[], const octet pubkey[])
+static size_t pfokDH_deep(size_t n, size_t m, size_t r_deep)
+{
+	return O_OF_W(n + m) + qrPowerCT_deep(n, m, r_deep);
+}
+
+static err_t pfokDHStep(octet sharekey[], const pfok_params* params,
+	const qr_o* qr, const octet privkey[], const octet pubkey[], void* stack)
 {
 	size_t n, no;
 	size_t m, mo;
 	// состояние
-	void* state;
 	word* x;				/* [m] личный ключ */
 	word* y;				/* [n] открытый ключ визави */
-	qr_o* qr;				/* описание кольца Монтгомери */
-	void* stack;
-	// проверить params
-	if (!memIsValid(params, sizeof(pfok_params)))
-		return ERR_BAD_INPUT;
-	// работоспособные параметры?
-	if (!pfokParamsIsOperable(params))
-		return ERR_BAD_PARAMS;
 	// размерности
 	n = W_OF_B(params->l), no = O_OF_B(params->l);
 	m = W_OF_B(params->r), mo = O_OF_B(params->r);
-	// проверить остальные входные данные
+	// проверить входные данные
 	if (!memIsValid(privkey, mo) || 
 		!memIsValid(pubkey, no) ||
 		!memIsValid(sharekey, O_OF_B(params->n)))
 		return ERR_BAD_INPUT;
-	// создать состояние
-	state = blobCreate(
-		O_OF_W(n) + O_OF_W(m) + zmMontCreate_keep(no) +  
-		utilMax(2,
-			zmMontCreate_deep(no),
-			qrPower_deep(n, n, zmMontCreate_deep(no))));
-	if (state == 0)
-		return ERR_OUTOFMEMORY;
 	// раскладка состояния
-	x = (word*)state;
+	x = (word*)stack;
 	y = x + m;
-	qr = (qr_o*)(y + n);
-	stack = (octet*)qr + zmMontCreate_keep(no);
-	// построить кольцо Монтгомери
-	zmMontCreate(qr, params->p, no, params->l + 2, stack);
+	stack = y + n;
 	// x <- privkey
 	wwFrom(x, privkey, mo);
 	if (wwGetBits(x, params->r, B_OF_W(m) - params->r) != 0)
-	{
-		blobClose(state);
 		return ERR_BAD_PRIVKEY;
-	}
 	// y <- pubkey
 	wwFrom(y, pubkey, no);
 	if (wwIsZero(y, n) || wwCmp(y, qr->mod, n) >= 0)
-	{
-		blobClose(state);
 		return ERR_BAD_PUBKEY;
-	}
-	qrPower(y, y, x, m, qr, stack);
+	qrPowerCT(y, y, x, m, qr, stack);
 	// выгрузить открытый ключ
 	qrTo((octet*)y, y, qr, stack);
 	memCopy(sharekey, y, O_OF_B(params->n));
 	if (params->n % 8)
 		sharekey[params->n / 8] &= (octet)255 >> (8 - params->n % 8);
 	// все нормально
-	blobClose(state);
 	return ERR_OK;
 }
 
-err_t pfokMTI(octet sharekey[], const pfok_params* params, 
-	const octet privkey[], const octet privkey1[], 
-	const octet pubkey[], const octet pubkey1[])
+err_t pfokDH(octet sharekey[], const pfok_params* params, 
+	const octet privkey[], const octet pubkey[])
 {
-	size_t n, no;
-	size_t m, mo;
-	// состояние
+	err_t code;
 	void* state;
-	word* x;				/* [m] личный ключ */
-	word* u;				/* [m] одноразовый личный ключ */
-	word* y;				/* [n] открытый ключ визави */
-	word* v;				/* [n] одноразовый открытый ключ визави */
 	qr_o* qr;				/* описание кольца Монтгомери */
-	void* stack;
 	// проверить params
 	if (!memIsValid(params, sizeof(pfok_params)))
 		return ERR_BAD_INPUT;
 	// работоспособные параметры?
 	if (!pfokParamsIsOperable(params))
 		return ERR_BAD_PARAMS;
+	// создать состояние
+	state = pfokStateCreate(&qr, params, pfokDH_deep(
+		W_OF_B(params->l), W_OF_B(params->r), 
+		zmMontCreate_deep(O_OF_B(params->l))));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// построить общий ключ
+	code = pfokDHStep(sharekey, params, qr, privkey, pubkey,
+		pfokStateStack(params, state));
+	// завершение
+	stackClose(state);
+	return code;
+}
+
+static size_t pfokMTI_deep(size_t n, size_t m, size_t r_deep)
+{
+	return O_OF_W(2 * n + 2 * m) + qrPowerCT_deep(n, m, r_deep);
+}
+
+static err_t pfokMTIStep(octet sharekey[], const pfok_params* params,
+	const qr_o* qr, const octet privkey[], const octet privkey1[], 
+	const octet pubkey[], const octet pubkey1[], void* stack)
+{
+	size_t n, no;
+	size_t m, mo;
+	// состояние
+	word* x;				/* [m] личный ключ */
+	word* u;				/* [m] одноразовый личный ключ */
+	word* y;				/* [n] открытый ключ визави */
+	word* v;				/* [n] одноразовый открытый ключ визави */
 	// размерности
 	n = W_OF_B(params->l), no = O_OF_B(params->l);
 	m = W_OF_B(params->r), mo = O_OF_B(params->r);
-	// проверить остальные входные данные
+	// проверить входные данные
 	if (!memIsValid(privkey, mo) || 
 		!memIsValid(privkey1, mo) || 
 		!memIsValid(pubkey, no) ||
 		!memIsValid(pubkey1, no) ||
 		!memIsValid(sharekey, O_OF_B(params->n)))
 		return ERR_BAD_INPUT;
-	// создать состояние
-	state = blobCreate(
-		2 * O_OF_W(n) + 2 * O_OF_W(m) + zmMontCreate_keep(no) +  
-		utilMax(2,
-			zmMontCreate_deep(no),
-			qrPower_deep(n, n, zmMontCreate_deep(no))));
-	if (state == 0)
-		return ERR_OUTOFMEMORY;
 	// раскладка состояния
-	x = (word*)state;
+	x = (word*)stack;
 	u = x + m;
 	y = u + m;
 	v = y + n;
-	qr = (qr_o*)(v + n);
-	stack = (octet*)qr + zmMontCreate_keep(no);
-	// построить кольцо Монтгомери
-	zmMontCreate(qr, params->p, no, params->l + 2, stack);
+	stack = v + n;
 	// x <- privkey, u <- privkey1
 	wwFrom(x, privkey, mo);
 	wwFrom(u, privkey1, mo);
 	if (wwGetBits(x, params->r, B_OF_W(m) - params->r) != 0 ||
 		wwGetBits(u, params->r, B_OF_W(m) - params->r) != 0)
-	{
-		blobClose(state);
 		return ERR_BAD_PRIVKEY;
-	}
 	// y <- pubkey, v <- pubkey1
 	wwFrom(y, pubkey, no);
 	wwFrom(v, pubkey1, no);
 	if (wwIsZero(y, n) || wwCmp(y, qr->mod, n) >= 0 ||
 		wwIsZero(v, n) || wwCmp(v, qr->mod, n) >= 0)
-	{
-		blobClose(state);
 		return ERR_BAD_PUBKEY;
-	}
 	// y <- y^u, v <- v^x
-	qrPower(y, y, u, m, qr, stack);
-	qrPower(v, v, x, m, qr, stack);
+	qrPowerCT(y, y, u, m, qr, stack);
+	qrPowerCT(v, v, x, m, qr, stack);
 	// выгрузить открытый ключ
 	qrTo((octet*)y, y, qr, stack);
 	qrTo((octet*)v, v, qr, stack);
@@ -1061,6 +1212,199 @@ err_t pfokMTI(octet sharekey[], const pfok_params* params,
 	if (params->n % 8)
 		sharekey[params->n / 8] &= (octet)255 >> (8 - params->n % 8);
 	// все нормально
-	blobClose(state);
 	return ERR_OK;
 }
+
+err_t pfokMTI(octet sharekey[], const pfok_params* params, 
+	const octet privkey[], const octet privkey1[], 
+	const octet pubkey[], const octet pubkey1[])
+{
+	err_t code;
+	void* state;
+	qr_o* qr;				/* описание кольца Монтгомери */
+	// проверить params
+	if (!memIsValid(params, sizeof(pfok_params)))
+		return ERR_BAD_INPUT;
+	// работоспособные параметры?
+	if (!pfokParamsIsOperable(params))
+		return ERR_BAD_PARAMS;
+	// создать состояние
+	state = pfokStateCreate(&qr, params, pfokMTI_deep(
+		W_OF_B(params->l), W_OF_B(params->r), 
+		zmMontCreate_deep(O_OF_B(params->l))));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	// построить общий ключ
+	code = pfokMTIStep(sharekey, params, qr, privkey, privkey1, pubkey, 
+		pubkey1, pfokStateStack(params, state));
+	// завершение
+	stackClose(state);
+	return code;
+}
+
+/*
+*******************************************************************************
+Контекст
+
+Контекст содержит копию долговременных параметров, таблицу гребенки
+[n * 2^PFOK_COMB_W]pre для g и описание кольца Монтгомери. Таблица
+рассчитывается для показателей длины W_OF_B(r) слов (длина личного ключа).
+Кольцо строится непосредственно в контексте.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	pfok_params params[1];	/* долговременные параметры */
+	word stack[];			/* таблица pre и описание кольца */
+} pfok_ctx_st;
+
+size_t pfokCtx_keep(size_t l)
+{
+	return sizeof(pfok_ctx_st) + O_OF_W(W_OF_B(l) << PFOK_COMB_W) +
+		zmMontCreate_keep(O_OF_B(l));
+}
+
+static const qr_o* pfokCtxQr(const void* ctx)
+{
+	const pfok_ctx_st* st = (const pfok_ctx_st*)ctx;
+	return (const qr_o*)(st->stack + (W_OF_B(st->params->l) << PFOK_COMB_W));
+}
+
+err_t pfokCtxStart(void* ctx, const pfok_params* params)
+{
+	pfok_ctx_st* st = (pfok_ctx_st*)ctx;
+	size_t n, no;
+	qr_o* qr;
+	word* g;
+	void* stack;
+	// проверить params
+	if (!memIsValid(params, sizeof(pfok_params)))
+		return ERR_BAD_INPUT;
+	// работоспособные параметры?
+	if (!pfokParamsIsOperable(params))
+		return ERR_BAD_PARAMS;
+	// проверить ctx
+	if (!memIsValid(ctx, pfokCtx_keep(params->l)))
+		return ERR_BAD_INPUT;
+	// размерности
+	n = W_OF_B(params->l), no = O_OF_B(params->l);
+	// создать стек
+	g = (word*)stackCreate(
+		utilMax(2,
+			zmMontCreate_deep(no),
+			O_OF_W(n) + qrCombPrecomp_deep(n, zmMontCreate_deep(no))));
+	if (g == 0)
+		return ERR_OUTOFMEMORY;
+	stack = g + n;
+	// построить кольцо
+	memCopy(st->params, params, sizeof(pfok_params));
+	qr = (qr_o*)(st->stack + (W_OF_B(params->l) << PFOK_COMB_W));
+	zmMontCreate(qr, params->p, no, params->l + 2, g);
+	// рассчитать таблицу
+	wwFrom(g, params->g, no);
+	qrCombPrecomp(st->stack, g, PFOK_COMB_W, W_OF_B(params->r), qr, stack);
+	// завершение
+	stackClose(g);
+	return ERR_OK;
+}
+
+static bool_t pfokCtxIsOperable(const void* ctx)
+{
+	const pfok_ctx_st* st = (const pfok_ctx_st*)ctx;
+	return memIsValid(ctx, sizeof(pfok_ctx_st)) &&
+		pfokParamsIsOperable(st->params) &&
+		memIsValid(ctx, pfokCtx_keep(st->params->l)) &&
+		qrIsOperable(pfokCtxQr(ctx)) &&
+		pfokCtxQr(ctx)->n == W_OF_B(st->params->l);
+}
+
+static void* pfokCtxStackCreate(const void* ctx,
+	size_t (*deep)(size_t, size_t, size_t))
+{
+	const pfok_ctx_st* st = (const pfok_ctx_st*)ctx;
+	ASSERT(pfokCtxIsOperable(ctx));
+	return stackCreate(deep(W_OF_B(st->params->l), W_OF_B(st->params->r),
+		pfokCtxQr(ctx)->deep));
+}
+
+err_t pfokKeypairGenCtx(octet privkey[], octet pubkey[], const void* ctx,
+	gen_i rng, void* rng_state)
+{
+	err_t code;
+	void* stack;
+	// проверить ctx
+	if (!pfokCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// создать стек
+	stack = pfokCtxStackCreate(ctx, pfokKeypairGen_deep);
+	if (stack == 0)
+		return ERR_OUTOFMEMORY;
+	// сгенерировать ключи
+	code = pfokKeypairGenStep(privkey, pubkey,
+		((const pfok_ctx_st*)ctx)->params, pfokCtxQr(ctx),
+		((const pfok_ctx_st*)ctx)->stack, rng, rng_state, stack);
+	// завершение
+	stackClose(stack);
+	return code;
+}
+
+err_t pfokPubkeyCalcCtx(octet pubkey[], const void* ctx,
+	const octet privkey[])
+{
+	err_t code;
+	void* stack;
+	// проверить ctx
+	if (!pfokCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// создать стек
+	stack = pfokCtxStackCreate(ctx, pfokPubkeyCalc_deep);
+	if (stack == 0)
+		return ERR_OUTOFMEMORY;
+	// построить открытый ключ
+	code = pfokPubkeyCalcStep(pubkey, ((const pfok_ctx_st*)ctx)->params,
+		pfokCtxQr(ctx), ((const pfok_ctx_st*)ctx)->stack, privkey, stack);
+	// завершение
+	stackClose(stack);
+	return code;
+}
+
+err_t pfokDHCtx(octet sharekey[], const void* ctx, const octet privkey[],
+	const octet pubkey[])
+{
+	err_t code;
+	void* stack;
+	// проверить ctx
+	if (!pfokCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// создать стек
+	stack = pfokCtxStackCreate(ctx, pfokDH_deep);
+	if (stack == 0)
+		return ERR_OUTOFMEMORY;
+	// построить общий ключ
+	code = pfokDHStep(sharekey, ((const pfok_ctx_st*)ctx)->params,
+		pfokCtxQr(ctx), privkey, pubkey, stack);
+	// завершение
+	stackClose(stack);
+	return code;
+}
+
+err_t pfokMTICtx(octet sharekey[], const void* ctx, const octet privkey[],
+	const octet privkey1[], const octet pubkey[], const octet pubkey1[])
+{
+	err_t code;
+	void* stack;
+	// проверить ctx
+	if (!pfokCtxIsOperable(ctx))
+		return ERR_BAD_INPUT;
+	// создать стек
+	stack = pfokCtxStackCreate(ctx, pfokMTI_deep);
+	if (stack == 0)
+		return ERR_OUTOFMEMORY;
+	// построить общий ключ
+	code = pfokMTIStep(sharekey, ((const pfok_ctx_st*)ctx)->params,
+		pfokCtxQr(ctx), privkey, privkey1, pubkey, pubkey1, stack);
+	// завершение
+	stackClose(stack);
+	return code;
+}
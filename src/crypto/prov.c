@@ -0,0 +1,115 @@
+/*
+*******************************************************************************
+\file prov.c
+\brief Cryptographic providers
+\project bee2 [cryptographic library]
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "bee2/core/err.h"
+#include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
+#include "bee2/core/str.h"
+#include "bee2/core/util.h"
+#include "bee2/crypto/prov.h"
+
+/*
+*******************************************************************************
+Реестр провайдеров
+
+Зарегистрированные провайдеры хранятся в массиве _provs. Провайдеры
+добавляются под защитой мьютекса _mtx, который создается однократно.
+Сначала заполняется ячейка _provs[_count], затем атомарно увеличивается
+_count. Заполненные ячейки больше не изменяются и читаются без мьютекса.
+
+Активный провайдер задается номером _active: 0 -- программная
+реализация, i > 0 -- провайдер _provs[i - 1]. Номер читается
+и записывается атомарно. Поэтому перехват операций стоит одного
+атомарного чтения.
+*******************************************************************************
+*/
+
+#define PROV_MAX 8
+
+static const prov_o* _provs[PROV_MAX];
+static size_t _count;
+static size_t _active;
+static size_t _once;
+static bool_t _inited;
+static mt_mtx_t _mtx[1];
+
+static void provInit()
+{
+	_inited = mtMtxCreate(_mtx);
+}
+
+err_t provRegister(const prov_o* prov)
+{
+	size_t i;
+	err_t code = ERR_OK;
+	// проверить входные данные
+	if (!memIsValid(prov, sizeof(prov_o)) ||
+		!strIsValid(prov->name) || strLen(prov->name) == 0 ||
+		strEq(prov->name, "BEE2"))
+		return ERR_BAD_INPUT;
+	// создать мьютекс
+	if (!mtCallOnce(&_once, provInit) || !_inited)
+		return ERR_SYS;
+	// уже зарегистрирован?
+	mtMtxLock(_mtx);
+	for (i = 0; i < _count; ++i)
+		if (_provs[i] == prov || strEq(_provs[i]->name, prov->name))
+		{
+			code = ERR_ALREADY_EXISTS;
+			break;
+		}
+	// занять свободную ячейку
+	if (code == ERR_OK && _count == PROV_MAX)
+		code = ERR_OVERFLOW;
+	if (code == ERR_OK)
+	{
+		_provs[_count] = prov;
+		mtAtomicStore(&_count, _count + 1);
+	}
+	mtMtxUnlock(_mtx);
+	return code;
+}
+
+err_t provSelect(const char* name)
+{
+	size_t count;
+	size_t i;
+	// программная реализация?
+	if (name == 0 || strEq(name, "BEE2"))
+	{
+		mtAtomicStore(&_active, 0);
+		return ERR_OK;
+	}
+	if (!strIsValid(name))
+		return ERR_BAD_INPUT;
+	// найти провайдер
+	count = mtAtomicLoad(&_count);
+	for (i = 0; i < count; ++i)
+		if (strEq(_provs[i]->name, name))
+		{
+			mtAtomicStore(&_active, i + 1);
+			return ERR_OK;
+		}
+	return ERR_NOT_FOUND;
+}
+
+const prov_o* provActive()
+{
+	size_t i = mtAtomicLoad(&_active);
+	return i ? _provs[i - 1] : 0;
+}
+
+const char* provName()
+{
+	const prov_o* p = provActive();
+	return p ? p->name : "BEE2";
+}
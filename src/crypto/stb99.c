@@ -4,7 +4,7 @@
 \brief STB 1176.2-99: generation of parameters
 \project bee2 [cryptographic library]
 \created 2023.08.01
-\version 2024.02.29
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,7 +13,9 @@
 #include "bee2/core/blob.h"
 #include "bee2/core/err.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
 #include "bee2/core/prng.h"
+#include "bee2/core/stack.h"
 #include "bee2/core/str.h"
 #include "bee2/core/util.h"
 #include "bee2/crypto/stb99.h"
@@ -615,7 +617,13 @@ err_t stb99SeedAdj(stb99_seed* seed)
 *******************************************************************************
 */
 
-err_t stb99ParamsGen(stb99_params* params, const stb99_seed* seed)
+static bool_t stb99IsStopped(const size_t* winner)
+{
+	return winner && mtAtomicLoad(winner) != SIZE_MAX;
+}
+
+static err_t stb99ParamsGenStep(stb99_params* params, const stb99_seed* seed,
+	size_t threads, const size_t* winner)
 {
 	err_t code;
 	size_t i;
@@ -668,15 +676,15 @@ err_t stb99ParamsGen(stb99_params* params, const stb99_seed* seed)
 	m = W_OF_B(params->r), mo = O_OF_B(params->r);
 	ASSERT(n <= gw);
 	// создать состояние
-	state = blobCreate(
+	state = stackCreate(
 		prngSTB_keep() + O_OF_W(gw) +
 		O_OF_W(W_OF_B(seed->di[0]) + 2 * n) + zmMontCreate_keep(no) +
 		utilMax(6,
 			priNextPrimeW_deep(),
-			priExtendPrime_deep(params->l, W_OF_B(seed->di[1]),
-				(seed->di[0] + 3) / 4),
-			priExtendPrime2_deep(params->l, W_OF_B(seed->di[0]),
-				W_OF_B(seed->ri[0]), (params->l + 3) / 4),
+			priExtendPrimeMT_deep(params->l, W_OF_B(seed->di[1]),
+				(seed->di[0] + 3) / 4, threads),
+			priExtendPrime2MT_deep(params->l, W_OF_B(seed->di[0]),
+				W_OF_B(seed->ri[0]), (params->l + 3) / 4, threads),
 			zmMontCreate_deep(no),
 			zzDiv_deep(n, m),
 			qrPower_deep(n, n, zmMontCreate_deep(no))));
@@ -709,6 +717,12 @@ err_t stb99ParamsGen(stb99_params* params, const stb99_seed* seed)
 			}
 			while (!priNextPrimeW(gi + offset, gi[offset], stack));
 		}
+		// поиск прекращен?
+		else if (stb99IsStopped(winner))
+		{
+			stackClose(state);
+			return ERR_NO_RESULT;
+		}
 		// обычное gi
 		else
 		{
@@ -718,9 +732,9 @@ err_t stb99ParamsGen(stb99_params* params, const stb99_seed* seed)
 			if (base_count > priBaseSize())
 				base_count = priBaseSize();
 			// не удается построить новое простое?
-			if (!priExtendPrime(gi + offset, seed->di[i],
+			if (!priExtendPrimeMT(gi + offset, seed->di[i],
 				gi + offset + W_OF_B(seed->di[i]), W_OF_B(seed->di[i + 1]),
-				trials, base_count, prngSTBStepR, stb_state, stack))
+				trials, base_count, threads, prngSTBStepR, stb_state, stack))
 			{
 				// к предыдущему простому
 				offset += W_OF_B(seed->di[i++]);
@@ -755,6 +769,12 @@ err_t stb99ParamsGen(stb99_params* params, const stb99_seed* seed)
 				}
 				while (!priNextPrimeW(fi + offset, fi[offset], stack));
 			}
+			// поиск прекращен?
+			else if (stb99IsStopped(winner))
+			{
+				stackClose(state);
+				return ERR_NO_RESULT;
+			}
 			// обычное fi
 			else
 			{
@@ -764,9 +784,10 @@ err_t stb99ParamsGen(stb99_params* params, const stb99_seed* seed)
 				if (base_count > priBaseSize())
 					base_count = priBaseSize();
 				// не удается построить новое простое?
-				if (!priExtendPrime(fi + offset, seed->ri[i],
+				if (!priExtendPrimeMT(fi + offset, seed->ri[i],
 					fi + offset + W_OF_B(seed->ri[i]), W_OF_B(seed->ri[i + 1]),
-					trials, base_count, prngSTBStepR, stb_state, stack))
+					trials, base_count, threads, prngSTBStepR, stb_state,
+					stack))
 				{
 					// к предыдущему простому
 					offset += W_OF_B(seed->ri[i++]);
@@ -779,13 +800,19 @@ err_t stb99ParamsGen(stb99_params* params, const stb99_seed* seed)
 			// к следующему простому
 			offset -= W_OF_B(seed->ri[--i]);
 		}
+		// поиск прекращен?
+		if (stb99IsStopped(winner))
+		{
+			stackClose(state);
+			return ERR_NO_RESULT;
+		}
 		// построить p
 		trials = 4 * seed->di[0];
 		base_count = (seed->di[0] + 3) / 4;
 		if (base_count > priBaseSize())
 			base_count = priBaseSize();
-		if (priExtendPrime2(p, params->l, g0, W_OF_B(seed->di[0]),
-			fi, W_OF_B(seed->ri[0]), trials, base_count,
+		if (priExtendPrime2MT(p, params->l, g0, W_OF_B(seed->di[0]),
+			fi, W_OF_B(seed->ri[0]), trials, base_count, threads,
 			prngSTBStepR, stb_state, stack))
 			break;
 
@@ -817,10 +844,121 @@ err_t stb99ParamsGen(stb99_params* params, const stb99_seed* seed)
 	wwTo(params->a, no, a);
 	wwTo(params->d, no, d);
 	// все нормально
-	blobClose(state);
+	stackClose(state);
 	return ERR_OK;
 }
 
+err_t stb99ParamsGen(stb99_params* params, const stb99_seed* seed)
+{
+	return stb99ParamsGenStep(params, seed, mtCPUs(), 0);
+}
+
+/*
+*******************************************************************************
+Генерация параметров по нескольким затравкам
+
+Задача с номером j строит параметры по затравке seed_j, которая отличается
+от seed только числом zi[0]: zi[0] сдвигается на j по циклу 
+{1, 2,..., 65256}. В пуле каждая задача выполняется в одном потоке.
+
+Первая завершившаяся задача записывает свой номер в winner с помощью 
+mtAtomicCmpSwap(). Остальные задачи обнаруживают, что winner установлен,
+между построениями простых цепочек и прекращают работу с кодом 
+ERR_NO_RESULT.
+
+Без пула задачи выполняются последовательно (с распределением проверки
+кандидатов между mtCPUs() потоками, как в stb99ParamsGen()). Первой 
+завершается задача 0, остальные прекращаются сразу. Поэтому результат совпадает
+с stb99ParamsGen(params, seed).
+*******************************************************************************
+*/
+
+typedef struct
+{
+	size_t threads;				/*< число потоков задачи */
+	size_t winner;				/*< номер первой завершившейся задачи */
+} stb99_gen_batch_st;
+
+typedef struct
+{
+	stb99_gen_batch_st* batch;	/*< общие данные */
+	size_t j;					/*< номер задачи */
+	stb99_seed seed[1];			/*< затравка задачи */
+	stb99_params params[1];		/*< параметры задачи */
+	err_t code;					/*< код возврата */
+} stb99_gen_task_st;
+
+static void stb99ParamsGenTask(void* arg, void* scratch)
+{
+	stb99_gen_task_st* task = (stb99_gen_task_st*)arg;
+	stb99_gen_batch_st* batch = task->batch;
+	task->code = stb99ParamsGenStep(task->params, task->seed, batch->threads,
+		&batch->winner);
+	if (task->code == ERR_OK &&
+		mtAtomicCmpSwap(&batch->winner, SIZE_MAX, task->j) != SIZE_MAX)
+		task->code = ERR_NO_RESULT;
+}
+
+err_t stb99ParamsGenMT(stb99_params* params, stb99_seed* seed, size_t count,
+	mt_pool_t* pool)
+{
+	err_t code;
+	size_t j;
+	void* state;
+	stb99_gen_batch_st* batch;
+	stb99_gen_task_st* tasks;
+	// проверить входные данные
+	code = stb99SeedVal(seed);
+	ERR_CALL_CHECK(code);
+	if (!memIsValid(params, sizeof(stb99_params)) || 
+		count == 0 || count > 65256)
+		return ERR_BAD_INPUT;
+	// создать состояние
+	state = blobCreate(sizeof(stb99_gen_batch_st) + 
+		count * sizeof(stb99_gen_task_st));
+	if (state == 0)
+		return ERR_OUTOFMEMORY;
+	batch = (stb99_gen_batch_st*)state;
+	tasks = (stb99_gen_task_st*)(batch + 1);
+	batch->threads = pool ? 1 : mtCPUs();
+	batch->winner = SIZE_MAX;
+	// подготовить задачи
+	for (j = 0; j < count; ++j)
+	{
+		tasks[j].batch = batch;
+		tasks[j].j = j;
+		memCopy(tasks[j].seed, seed, sizeof(stb99_seed));
+		tasks[j].seed->zi[0] = (u16)((seed->zi[0] - 1 + j) % 65256 + 1);
+		tasks[j].code = ERR_OK;
+	}
+	// выполнить задачи
+	if (pool)
+	{
+		for (j = 0; j < count; ++j)
+			mtPoolSubmit(pool, stb99ParamsGenTask, tasks + j);
+		mtPoolWait(pool);
+	}
+	else
+		for (j = 0; j < count; ++j)
+			stb99ParamsGenTask(tasks + j, 0);
+	// выбрать результат
+	if (batch->winner != SIZE_MAX)
+	{
+		memCopy(params, tasks[batch->winner].params, sizeof(stb99_params));
+		memCopy(seed, tasks[batch->winner].seed, sizeof(stb99_seed));
+	}
+	else
+		for (j = 0, code = ERR_NO_RESULT; j < count; ++j)
+			if (tasks[j].code != ERR_NO_RESULT)
+			{
+				code = tasks[j].code;
+				break;
+			}
+	// завершение
+	blobClose(state);
+	return code;
+}
+
 /*
 *******************************************************************************
 Проверка параметров
@@ -853,7 +991,7 @@ err_t stb99ParamsVal(const stb99_params* params)
 	n = W_OF_B(params->l), no = O_OF_B(params->l);
 	m = W_OF_B(params->r), mo = O_OF_B(params->r);
 	// создать состояние
-	state = blobCreate(
+	state = stackCreate(
 		O_OF_W(3 * n + 1) + zmMontCreate_keep(no) +  
 		utilMax(4,
 			priIsPrime_deep(n),
@@ -874,7 +1012,7 @@ err_t stb99ParamsVal(const stb99_params* params)
 	if (!memIsZero(params->p + no, sizeof(params->p) - no) ||
 		wwBitSize(p, n) != params->l || !priIsPrime(p, n, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// q -- r-битовое простое?
@@ -882,7 +1020,7 @@ err_t stb99ParamsVal(const stb99_params* params)
 	if (!memIsZero(params->q + mo, sizeof(params->q) - mo) ||
 		wwBitSize(q, m) != params->r || !priIsPrime(q, m, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// t <- (p - 1) div q
@@ -891,7 +1029,7 @@ err_t stb99ParamsVal(const stb99_params* params)
 	// q | p - 1?
 	if (!wwIsZero(p, m))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// построить кольцо Монтгомери
@@ -900,14 +1038,14 @@ err_t stb99ParamsVal(const stb99_params* params)
 	if (!memIsZero(params->d + no, sizeof(params->d) - no) ||
 		!qrFrom(d, params->d, qr, stack))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// d <- d^((p - 1)/q) \neq e?
 	qrPower(d, d, t, n - m + 1, qr, stack);
 	if (qrIsUnity(d, qr))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// a == params->a?
@@ -915,10 +1053,10 @@ err_t stb99ParamsVal(const stb99_params* params)
 	if (!memIsZero(params->a + no, sizeof(params->a) - no) ||
 		!wwEq(a, d, n))
 	{
-		blobClose(state);
+		stackClose(state);
 		return ERR_BAD_PARAMS;
 	}
 	// все нормально
-	blobClose(state);
+	stackClose(state);
 	return ERR_OK;
 }
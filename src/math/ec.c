@@ -4,7 +4,7 @@
 \brief Elliptic curves
 \project bee2 [cryptographic library]
 \created 2014.03.04
-\version 2015.11.09
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -19,6 +19,38 @@
 #include "bee2/math/ww.h"
 #include "bee2/math/zz.h"
 
+/*
+*******************************************************************************
+Вызовы через локальные указатели
+
+В некоторых функциях сложение и вычитание точек вызываются через локальные
+указатели (ec->add или ec->adda, ec->sub или ec->suba). Макросы
+ecCallAdd() и ecCallSub() выполняют такие вызовы и, при сборке с
+директивой BEE2_INSTRUMENT, увеличивают соответствующие счетчики
+(см. opcnt.h).
+*******************************************************************************
+*/
+
+#ifdef BEE2_INSTRUMENT
+
+#define ecCallAdd(add, c, a, b, ec, stack)\
+	((add) == (ec)->adda ? opcntInc(ec_adda) : opcntInc(ec_add),\
+		(add)(c, a, b, ec, stack))
+
+#define ecCallSub(sub, c, a, b, ec, stack)\
+	((sub) == (ec)->suba ? opcntInc(ec_suba) : opcntInc(ec_sub),\
+		(sub)(c, a, b, ec, stack))
+
+#else
+
+#define ecCallAdd(add, c, a, b, ec, stack)\
+	(add)(c, a, b, ec, stack)
+
+#define ecCallSub(sub, c, a, b, ec, stack)\
+	(sub)(c, a, b, ec, stack)
+
+#endif /* BEE2_INSTRUMENT */
+
 /*
 *******************************************************************************
 Управление описанием кривой
@@ -98,6 +130,125 @@ bool_t ecIsOperableGroup(const ec_o* ec)
 		ec->cofactor != 0;
 }
 
+/*
+*******************************************************************************
+Пакетный экспорт
+*******************************************************************************
+*/
+
+bool_t ecToABatch(word b[], const word a[], size_t count, const ec_o* ec,
+	void* stack)
+{
+	const size_t n = ec->f->n;
+	bool_t ret = TRUE;
+	size_t i;
+	// pre
+	ASSERT(ecIsOperable(ec));
+	ASSERT(wwIsDisjoint2(a, ec->d * n * count, b, 2 * n * count));
+	// пакетный экспорт
+	if (ec->toan)
+	{
+#ifdef BEE2_INSTRUMENT
+		opcntInc(ec_toan);
+#endif
+		return ec->toan(b, a, count, ec, stack);
+	}
+	// экспорт по одной точке
+	for (i = 0; i < count; ++i)
+		ret &= ecToA(b + 2 * n * i, a + ec->d * n * i, ec, stack);
+	return ret;
+}
+
+size_t ecToABatch_deep(size_t n, size_t ec_deep, size_t count)
+{
+	return O_OF_W(2 * n * count) + ec_deep;
+}
+
+/*
+*******************************************************************************
+Кратное удвоение
+
+Серии удвоений возникают при обработке нулевых символов NAF, а также окон
+в методах Пиппенджера и гребенки. Функция ec->dbln выполняет серию как одну
+операцию и может переносить между удвоениями промежуточные значения
+(см. ecpDblNJ() в ecp.c).
+*******************************************************************************
+*/
+
+void ecDblN(word b[], const word a[], size_t k, const ec_o* ec, void* stack)
+{
+	// pre
+	ASSERT(ecIsOperable(ec));
+	ASSERT(wwIsSameOrDisjoint(a, b, ec->d * ec->f->n));
+	// k == 0?
+	if (k == 0)
+	{
+		wwCopy(b, a, ec->d * ec->f->n);
+		return;
+	}
+	// кратное удвоение
+	if (ec->dbln && k > 1)
+	{
+#ifdef BEE2_INSTRUMENT
+		opcntInc(ec_dbln);
+#endif
+		ec->dbln(b, a, k, ec, stack);
+		return;
+	}
+	// удвоения по одному
+	ecDbl(b, a, ec, stack);
+	while (--k)
+		ecDbl(b, b, ec, stack);
+}
+
+/*
+*******************************************************************************
+Малые кратные
+
+Функция ecNAFPrecomp() рассчитывает малые кратные pre[i] = (2i + 1)a,
+i = 0, 1,..., count - 1, в проективных координатах и затем переводит их
+в аффинные координаты функцией ecToABatch(). Если среди малых кратных
+встречается O (это возможно, только если порядок a мал), то кратные
+остаются проективными. Буфер pre должен вмещать count проективных точек.
+
+Функция возвращает TRUE, если кратные аффинные (занимают по 2 * n слов),
+и FALSE, если проективные (по ec->d * n слов).
+*******************************************************************************
+*/
+
+static bool_t ecNAFPrecomp(word pre[], const word a[], size_t count,
+	const ec_o* ec, void* stack)
+{
+	const size_t n = ec->f->n;
+	size_t i;
+	// переменные в stack
+	word* t = (word*)stack;
+	word* pa = t + ec->d * n;
+	stack = pa + 2 * n * count;
+	// pre
+	ASSERT(count > 1);
+	// pre[0] <- a
+	ecFromA(pre, a, ec, stack);
+	// t <- 2a, pre[i] <- t + pre[i - 1]
+	ecDblA(t, pre, ec, stack);
+	ecAddA(pre + ec->d * n, t, pre, ec, stack);
+	for (i = 2; i < count; ++i)
+		ecAdd(pre + i * ec->d * n, t, pre + (i - 1) * ec->d * n, ec, stack);
+	// среди кратных есть O => остаться в проективных координатах
+	if (!ecToABatch(pa, pre, count, ec, stack))
+		return FALSE;
+	// pre <- pa
+	wwCopy(pre, pa, 2 * n * count);
+	return TRUE;
+}
+
+static size_t ecNAFPrecomp_deep(size_t n, size_t ec_d, size_t ec_deep,
+	size_t count)
+{
+	return O_OF_W(ec_d * n + 2 * n * count) +
+		ecToABatch_deep(n, ec_deep, count);
+}
+
 /*
 *******************************************************************************
 Кратная точка
@@ -134,100 +285,124 @@ Springer, 2004].
 
 В практических диапазонах размерностей при использовании наиболее эффективных
 координат (якобиановых для кривых над GF(p) и Лопеса -- Дахаба для кривых 
-над GF(2^m)) первые две стратегии являются проигрышными. Реализована только 
-третья стратегия. 
+над GF(2^m)) первые две стратегии в чистом виде являются проигрышными.
+Реализована комбинация второй и третьей стратегий: малые кратные 
+рассчитываются в проективных координатах, а затем одновременно переводятся
+в аффинные функцией ecToABatch() с помощью трюка Монтгомери (одно обращение 
+в базовом поле вместо 2^{w-2}, см. qrInvBatch()). После этого в основном 
+цикле выполняются только сложения (P <- P + A):
+	c4(l, w) = c3(l, w) - l/(w + 1)(P <- P + P) + l/(w + 1)(P <- P + A) +
+		1(I) + 2^{w-2}(6M + 1S),
+где (I), (M), (S) -- время обращения, умножения и возведения в квадрат
+в базовом поле (оценка приведена для якобиановых координат).
 
 Оптимальная длина окна выбирается как решение следующей оптимизационной 
 задачи:
 	(2^{w - 2} - 2) + l / (w + 1) -> min.
 
-\todo Усилить вторую стратегию. Рассчитать малые кратные в проективных 
-координатах, а затем быстро перейти к аффинным координатам с помощью 
-трюка Монтгомери [Algorithm 11.15 Simultaneous inversion, CohenFrey, p. 209]:
-	U_1 <- Z_1
-	for t = 2,..., T: U_t <- U_{t-1} Z_t
-	V <- U_T^{-1}
-	for t = T,..., 2: 
-		Z_t^{-1} <- V U_{t-1}
-		V <- V Z_t
-	Z_1^{-1} <- V
+Кодирование кратности (функция ecNAFCode()) отделено от вычисления
+кратной точки (функция ecMulANAF()). Если одна и та же кратность (например,
+долговременный личный ключ) умножается на разные точки, то ее можно
+закодировать один раз.
+Длина окна определяется по длине кратности m, поэтому при кодировании
+и умножении должно использоваться одно и то же m. В code[0] сохраняется
+число символов NAF, далее следует кодированное представление NAF.
+
+При сборке с директивой BEE2_LOW_MEMORY длина окна ограничивается
+величиной EC_W_MAX = 4 (4 малых кратных вместо 16). Ограничение действует
+также на регулярное окно (ecRegWidth()).
 *******************************************************************************
 */
 
+#ifdef BEE2_LOW_MEMORY
+	#define EC_W_MAX 4
+#else
+	#define EC_W_MAX 6
+#endif
+
 static size_t ecNAFWidth(size_t l)
 {
+	size_t w = 3;
 	if (l >= 336)
-		return 6;
+		w = 6;
 	else if (l >= 120)
-		return 5;
+		w = 5;
 	else if (l >= 40)
-		return 4;
-	return 3;
+		w = 4;
+	return MIN2(w, EC_W_MAX);
 }
 
-bool_t ecMulA(word b[], const word a[], const ec_o* ec, const word d[],
+void ecNAFCode(word code[], const word d[], size_t m)
+{
+	const size_t naf_width = ecNAFWidth(B_OF_W(m));
+	ASSERT(wwIsDisjoint2(code, 2 * m + 2, d, m));
+	code[0] = (word)wwNAF(code + 1, d, m, naf_width);
+}
+
+bool_t ecMulANAF(word b[], const word a[], const ec_o* ec, const word code[],
 	size_t m, void* stack)
 {
 	const size_t n = ec->f->n;
 	const size_t naf_width = ecNAFWidth(B_OF_W(m));
 	const size_t naf_count = SIZE_1 << (naf_width - 2);
 	const word naf_hi = WORD_1 << (naf_width - 1);
-	register size_t naf_size;
+	const word* naf = code + 1;
+	register size_t naf_size = (size_t)code[0];
 	register size_t i;
 	register word w;
+	size_t k;
+	size_t step;
+	ec_add_i add;
+	ec_sub_i sub;
 	// переменные в stack
-	word* naf;			/* NAF */
 	word* t;			/* вспомогательная точка */
 	word* pre;			/* pre[i] = (2i + 1)a (naf_count элементов) */
 	// pre
 	ASSERT(ecIsOperable(ec));
+	ASSERT(wwIsValid(code, 2 * m + 2));
+	ASSERT(naf_width >= 3);
 	// раскладка stack
-	naf = (word*)stack;
-	t = naf + 2 * m + 1;
+	t = (word*)stack;
 	pre = t + ec->d * n;
 	stack = pre + naf_count * ec->d * n;
-	// расчет NAF
-	ASSERT(naf_width >= 3);
-	naf_size = wwNAF(naf, d, m, naf_width);
 	// d == O => b <- O
 	if (naf_size == 0)
 		return FALSE;
-	// pre[0] <- a
-	ecFromA(pre, a, ec, stack);
-	// расчет pre[i]: t <- 2a, pre[i] <- t + pre[i - 1]
-	ASSERT(naf_count > 1);
-	ecDblA(t, pre, ec, stack);
-	ecAddA(pre + ec->d * n, t, pre, ec, stack);
-	for (i = 2; i < naf_count; ++i)
-		ecAdd(pre + i * ec->d * n, t, pre + (i - 1) * ec->d * n, ec, stack);
+	// расчет pre[i]
+	if (ecNAFPrecomp(pre, a, naf_count, ec, stack))
+		add = ec->adda, sub = ec->suba, step = 2 * n;
+	else
+		add = ec->add, sub = ec->sub, step = ec->d * n;
 	// t <- a[naf[l - 1]]
 	w = wwGetBits(naf, 0, naf_width);
 	ASSERT((w & 1) == 1 && (w & naf_hi) == 0);
-	wwCopy(t, pre + (w >> 1) * ec->d * n, ec->d * n);
-	// цикл по символам NAF
-	i = naf_width;
+	if (step == 2 * n)
+		ecFromA(t, pre + (w >> 1) * step, ec, stack);
+	else
+		wwCopy(t, pre + (w >> 1) * step, step);
+	// цикл по символам NAF (k -- длина серии удвоений)
+	i = naf_width, k = 0;
 	while (--naf_size)
 	{
-		w = wwGetBits(naf, i, naf_width);
+		w = wwGetBits(naf, i, naf_width), ++k;
 		if (w & 1)
 		{
-			// t <- 2 t
-			ecDbl(t, t, ec, stack);
+			// t <- 2^k t
+			ecDblN(t, t, k, ec, stack), k = 0;
 			// t <- t \pm pre[naf[w]]
-			if (w == 1)
-				ecAddA(t, t, pre, ec, stack);
-			else if (w == (naf_hi ^ 1))
-				ecSubA(t, t, pre, ec, stack);
-			else if (w & naf_hi)
-				ecSub(t, t, pre + ((w ^ naf_hi) >> 1) * ec->d * n, ec, stack);
+			if (w & naf_hi)
+				ecCallSub(sub, t, t, pre + ((w ^ naf_hi) >> 1) * step, ec,
+					stack);
 			else
-				ecAdd(t, t, pre + (w >> 1) * ec->d * n, ec, stack);
+				ecCallAdd(add, t, t, pre + (w >> 1) * step, ec, stack);
 			// к следующему разряду naf
 			i += naf_width;
 		}
 		else
-			ecDbl(t, t, ec, stack), ++i;
+			++i;
 	}
+	// t <- 2^k t
+	ecDblN(t, t, k, ec, stack);
 	// очистка
 	w = 0;
 	i = 0;
@@ -235,14 +410,615 @@ bool_t ecMulA(word b[], const word a[], const ec_o* ec, const word d[],
 	return ecToA(b, t, ec, stack);
 }
 
-size_t ecMulA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t m)
+size_t ecMulANAF_deep(size_t n, size_t ec_d, size_t ec_deep, size_t m)
 {
 	const size_t naf_width = ecNAFWidth(B_OF_W(m));
 	const size_t naf_count = SIZE_1 << (naf_width - 2);
-	return O_OF_W(2 * m + 1) + 
-		O_OF_W(ec_d * n) + 
+	return O_OF_W(ec_d * n) + 
 		O_OF_W(ec_d * n * naf_count) + 
-		ec_deep;
+		ecNAFPrecomp_deep(n, ec_d, ec_deep, naf_count);
+}
+
+bool_t ecMulA(word b[], const word a[], const ec_o* ec, const word d[],
+	size_t m, void* stack)
+{
+	bool_t ret;
+	// переменные в stack
+	word* code = (word*)stack;
+	stack = code + 2 * m + 2;
+	// pre
+	ASSERT(ecIsOperable(ec));
+	// кодирование и умножение
+	ecNAFCode(code, d, m);
+	ret = ecMulANAF(b, a, ec, code, m, stack);
+	// очистка
+	wwSetZero(code, 2 * m + 2);
+	return ret;
+}
+
+size_t ecMulA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t m)
+{
+	return O_OF_W(2 * m + 2) + ecMulANAF_deep(n, ec_d, ec_deep, m);
+}
+
+/*
+*******************************************************************************
+Кратная точка: цепочки с двойной базой
+
+Кратность d представляется цепочкой с двойной базой (2, 3):
+	d = 2^{a_0}3^{b_0}(2^{a_1}3^{b_1}(...(2^{a_k}3^{b_k}s + c_k)...) + c_1),
+где s, c_i -- символы оконной NAF (нечетные по модулю меньше 2^{w-1},
+c_i может быть нулевым только при i = 0), w = ecNAFWidth(l), l = B_OF_W(m).
+Поэтому при умножении используются те же малые кратные, что и в
+ecMulANAF(): удвоения (ec->dbl), утроения (ec->tpl) и сложения
+с малыми кратными.
+
+Цепочка строится жадным деревом [Doche C., Habsieger L. A Tree-Based
+Approach for Computing Double-Base Chains. ACISP 2008, LNCS 5107]:
+на каждом уровне сохраняется EC_DB_NODES вершин v, для каждой вершины
+перебираются символы c и числа v - c освобождаются от множителей 2 и 3.
+Оценка кандидата -- стоимость уже построенной цепочки плюс стоимость
+оставшихся битов (одно удвоение и 1 / (w + 1) сложения на бит), 2-
+и 3-валюации оцениваются по младшему слову v и остатку v по модулю 3^k3
+(3^k3 < 2^B_PER_W). Точно вычисляются только EC_DB_NODES лучших
+кандидатов. Стоимости утроения и сложения задаются в 1/16 удвоения.
+Число уровней не превосходит l: если s = 2^{w - 1} - 1, то на каждом
+уровне v - s уменьшается по меньшей мере вдвое.
+
+Элемент представления -- тройка (c, a, b) из w + 2 * lw битов, где
+lw -- битовая длина l. В code[0] сохраняется число элементов, далее
+следуют элементы: (s, 0, 0), (c_k, a_k, b_k),..., (0, a_0, b_0).
+В истории дерева к элементу добавляются 2 бита номера родительской вершины.
+
+Цепочки нерегулярны и поэтому используются только для открытых кратностей.
+ecMulA() продолжает использовать NAF: на кривых bign в якобиановых
+координатах утроение стоит 2.05 -- 2.17 удвоения (больше log2(3) ~ 1.58),
+сложение с аффинной точкой -- 1.13 -- 1.33 удвоения, и при таких
+соотношениях цепочки выигрывают у NAF не более 0.6% операций.
+Для кривых над GF(2^m) утроение не реализовано.
+*******************************************************************************
+*/
+
+#define EC_DB_NODES 4
+
+static size_t ecDBFieldWidth(size_t l)
+{
+	size_t lw = 1;
+	while ((SIZE_1 << lw) <= l)
+		++lw;
+	return lw;
+}
+
+static void ecDBSet(word buf[], size_t pos, size_t w, size_t lw, word c,
+	size_t a, size_t b)
+{
+	wwSetBits(buf, pos, w, c);
+	wwSetBits(buf, pos + w, lw, (word)a);
+	wwSetBits(buf, pos + w + lw, lw, (word)b);
+}
+
+static word ecDBGet(const word buf[], size_t pos, size_t w, size_t lw,
+	size_t* a, size_t* b)
+{
+	*a = (size_t)wwGetBits(buf, pos + w, lw);
+	*b = (size_t)wwGetBits(buf, pos + w + lw, lw);
+	return wwGetBits(buf, pos, w);
+}
+
+size_t ecDBCode_size(size_t m)
+{
+	const size_t l = B_OF_W(m);
+	const size_t e = ecNAFWidth(l) + 2 * ecDBFieldWidth(l);
+	return 1 + W_OF_B((l + 2) * e);
+}
+
+void ecDBCode(word code[], const word d[], size_t m, size_t tpl, size_t add,
+	void* stack)
+{
+	const size_t l = B_OF_W(m);
+	const size_t w = ecNAFWidth(l);
+	const word naf_hi = WORD_1 << (w - 1);
+	const size_t lw = ecDBFieldWidth(l);
+	const size_t e = w + 2 * lw;
+	const size_t k3 = B_PER_W * 5 / 8;
+	const size_t wt = 16 + add / (w + 1);
+	word p3;
+	size_t count, lv, i, j, f;
+	size_t cost[EC_DB_NODES];
+	size_t ncost[EC_DB_NODES];
+	size_t cand_est[EC_DB_NODES];
+	size_t cand_node[EC_DB_NODES];
+	word cand_c[EC_DB_NODES];
+	size_t nc;
+	// переменные в stack
+	word* v = (word*)stack;
+	word* nv = v + EC_DB_NODES * (m + 1);
+	word* hist = nv + EC_DB_NODES * (m + 1);
+	stack = hist + W_OF_B((l + 1) * EC_DB_NODES * (e + 2));
+	// pre
+	ASSERT(wwIsDisjoint2(code, ecDBCode_size(m), d, m));
+	// d == 0?
+	if (wwIsZero(d, m))
+	{
+		code[0] = 0;
+		return;
+	}
+	// p3 <- 3^k3
+	for (p3 = 1, i = 0; i < k3; ++i)
+		p3 *= 3;
+	// уровень 0: v <- d / (2^a 3^b)
+	wwCopy(v, d, m), v[m] = 0;
+	i = wwLoZeroBits(v, m + 1), wwShLo(v, m + 1, i);
+	for (j = 0; zzModW(v, m + 1, 3) == 0; ++j)
+		zzDivW(v, v, m + 1, 3);
+	cost[0] = 16 * i + tpl * j;
+	ecDBSet(hist, 0, w, lw, 0, i, j);
+	wwSetBits(hist, e, 2, 0);
+	count = 1;
+	// уровни дерева
+	for (lv = 0;; ++lv)
+	{
+		// есть терминальная вершина?
+		for (f = count, i = 0; i < count; ++i)
+			if (wwCmpW(v + i * (m + 1), m + 1, naf_hi) < 0 &&
+				(f == count || cost[i] < cost[f]))
+				f = i;
+		if (f < count)
+			break;
+		ASSERT(lv < l);
+		// оценить кандидатов
+		for (nc = i = 0; i < count; ++i)
+		{
+			const word* vi = v + i * (m + 1);
+			const word r3 = zzModW(vi, m + 1, p3);
+			const size_t rem = 16 * wwBitSize(vi, m + 1);
+			word s;
+			for (s = 1; s < naf_hi; s += 2)
+			{
+				size_t neg;
+				for (neg = 0; neg < 2; ++neg)
+				{
+					word lo = neg ? vi[0] + s : vi[0] - s;
+					word y3;
+					size_t a, b, red, est;
+					// 2- и 3-валюации v - c
+					if (neg)
+						y3 = r3 + s, y3 = y3 >= p3 ? y3 - p3 : y3;
+					else
+						y3 = r3 >= s ? r3 - s : r3 + (p3 - s);
+					a = lo ? wordCTZ(lo) : B_PER_W;
+					if (y3 == 0)
+						b = k3;
+					else
+						for (b = 0; y3 % 3 == 0; ++b)
+							y3 /= 3;
+					// оценка
+					est = cost[i] + add + 16 * a + tpl * b;
+					red = 16 * a + 25 * b;
+					if (rem > red)
+						est += (rem - red) * wt / 16;
+					// вставка в список лучших
+					if (nc == EC_DB_NODES && est >= cand_est[nc - 1])
+						continue;
+					j = nc < EC_DB_NODES ? nc++ : nc - 1;
+					for (; j && cand_est[j - 1] > est; --j)
+					{
+						cand_est[j] = cand_est[j - 1];
+						cand_node[j] = cand_node[j - 1];
+						cand_c[j] = cand_c[j - 1];
+					}
+					cand_est[j] = est, cand_node[j] = i;
+					cand_c[j] = neg ? s | naf_hi : s;
+				}
+			}
+		}
+		// вычислить лучших кандидатов
+		for (f = j = 0; j < nc; ++j)
+		{
+			const word* vi = v + cand_node[j] * (m + 1);
+			word* z = nv + f * (m + 1);
+			size_t a, b, t;
+			if (cand_c[j] & naf_hi)
+				zzAddW(z, vi, m + 1, cand_c[j] ^ naf_hi);
+			else
+				zzSubW(z, vi, m + 1, cand_c[j]);
+			a = wwLoZeroBits(z, m + 1), wwShLo(z, m + 1, a);
+			for (b = 0; zzModW(z, m + 1, 3) == 0; ++b)
+				zzDivW(z, z, m + 1, 3);
+			// повтор?
+			for (t = 0; t < f; ++t)
+				if (wwEq(z, nv + t * (m + 1), m + 1))
+					break;
+			if (t < f)
+				continue;
+			ncost[f] = cost[cand_node[j]] + add + 16 * a + tpl * b;
+			t = ((lv + 1) * EC_DB_NODES + f) * (e + 2);
+			ecDBSet(hist, t, w, lw, cand_c[j], a, b);
+			wwSetBits(hist, t + e, 2, (word)cand_node[j]);
+			++f;
+		}
+		// к следующему уровню
+		wwCopy(v, nv, f * (m + 1));
+		for (count = f, i = 0; i < count; ++i)
+			cost[i] = ncost[i];
+	}
+	// обратный проход
+	code[0] = (word)(lv + 2);
+	ecDBSet(code + 1, 0, w, lw, v[f * (m + 1)], 0, 0);
+	for (i = 1; i <= lv + 1; ++i)
+	{
+		size_t a, b;
+		const size_t t = ((lv + 1 - i) * EC_DB_NODES + f) * (e + 2);
+		word c = ecDBGet(hist, t, w, lw, &a, &b);
+		ecDBSet(code + 1, i * e, w, lw, c, a, b);
+		f = (size_t)wwGetBits(hist, t + e, 2);
+	}
+	// очистка
+	wwSetZero(v, 2 * EC_DB_NODES * (m + 1));
+	wwSetZero(hist, W_OF_B((l + 1) * EC_DB_NODES * (e + 2)));
+}
+
+size_t ecDBCode_deep(size_t m)
+{
+	const size_t l = B_OF_W(m);
+	const size_t e = ecNAFWidth(l) + 2 * ecDBFieldWidth(l);
+	return O_OF_W(2 * EC_DB_NODES * (m + 1) +
+		W_OF_B((l + 1) * EC_DB_NODES * (e + 2)));
+}
+
+bool_t ecMulADB(word b[], const word a[], const ec_o* ec, const word code[],
+	size_t m, void* stack)
+{
+	const size_t n = ec->f->n;
+	const size_t l = B_OF_W(m);
+	const size_t naf_width = ecNAFWidth(l);
+	const size_t naf_count = SIZE_1 << (naf_width - 2);
+	const word naf_hi = WORD_1 << (naf_width - 1);
+	const size_t lw = ecDBFieldWidth(l);
+	const size_t e = naf_width + 2 * lw;
+	size_t count = (size_t)code[0];
+	size_t i, da, db;
+	word c;
+	size_t step;
+	ec_add_i add;
+	ec_sub_i sub;
+	// переменные в stack
+	word* t;			/* вспомогательная точка */
+	word* pre;			/* pre[i] = (2i + 1)a (naf_count элементов) */
+	// pre
+	ASSERT(ecIsOperable(ec));
+	ASSERT(ec->tpl != 0);
+	ASSERT(wwIsValid(code, ecDBCode_size(m)));
+	// раскладка stack
+	t = (word*)stack;
+	pre = t + ec->d * n;
+	stack = pre + naf_count * ec->d * n;
+	// d == O => b <- O
+	if (count == 0)
+		return FALSE;
+	// расчет pre[i]
+	if (ecNAFPrecomp(pre, a, naf_count, ec, stack))
+		add = ec->adda, sub = ec->suba, step = 2 * n;
+	else
+		add = ec->add, sub = ec->sub, step = ec->d * n;
+	// t <- s a
+	c = ecDBGet(code + 1, 0, naf_width, lw, &da, &db);
+	ASSERT((c & 1) == 1 && (c & naf_hi) == 0);
+	if (step == 2 * n)
+		ecFromA(t, pre + (c >> 1) * step, ec, stack);
+	else
+		wwCopy(t, pre + (c >> 1) * step, step);
+	// цикл по элементам цепочки
+	for (i = 1; i < count; ++i)
+	{
+		c = ecDBGet(code + 1, i * e, naf_width, lw, &da, &db);
+		// t <- 2^da 3^db t
+		ecDblN(t, t, da, ec, stack);
+		while (db--)
+			ec->tpl(t, t, ec, stack);
+		// t <- t \pm pre[c]
+		if (c & naf_hi)
+			ecCallSub(sub, t, t, pre + ((c ^ naf_hi) >> 1) * step, ec,
+				stack);
+		else if (c)
+			ecCallAdd(add, t, t, pre + (c >> 1) * step, ec, stack);
+	}
+	// к аффинным координатам
+	return ecToA(b, t, ec, stack);
+}
+
+size_t ecMulADB_deep(size_t n, size_t ec_d, size_t ec_deep, size_t m)
+{
+	return ecMulANAF_deep(n, ec_d, ec_deep, m);
+}
+
+/*
+*******************************************************************************
+Таблицы точек в формате SoA
+
+В таблице в формате SoA (structure of arrays) слова точек
+переставлены: сначала идут младшие слова x-координат всех точек, затем
+следующие слова x-координат и т.д., затем слова y-координат (и z-координат
+проективных точек). Слово j точки i размещается по индексу j * count + i.
+
+При выборе точки с маскированием (ecSoASelect()) маски точек
+рассчитываются один раз, после чего каждое слово результата накапливается
+по непрерывному участку из count слов таблицы. Такой цикл (AND с маской,
+OR в аккумулятор) компилятор разворачивает в векторные инструкции.
+Одновременно обрабатываются 4 слова результата: маски загружаются один раз
+на 4 участка, цепочки зависимостей по аккумуляторам независимы.
+
+При обычной раскладке (array of structures) маска пересчитывается для
+каждой точки, а каждое слово результата читается и записывается count раз.
+На кривых bign-curve256v1 и bign-curve512v1 (32 малых кратных по 8 и 16
+слов) выбор из таблицы SoA выполняется примерно в 1,5 раза быстрее.
+*******************************************************************************
+*/
+
+void ecSoAFrom(word soa[], const word pre[], size_t count, size_t step)
+{
+	size_t i, j;
+	ASSERT(wwIsValid(pre, count * step));
+	ASSERT(wwIsValid(soa, count * step));
+	ASSERT(wwIsDisjoint(soa, pre, count * step));
+	for (i = 0; i < count; ++i, pre += step)
+		for (j = 0; j < step; ++j)
+			soa[j * count + i] = pre[j];
+}
+
+void ecSoATo(word pre[], const word soa[], size_t count, size_t step)
+{
+	size_t i, j;
+	ASSERT(wwIsValid(pre, count * step));
+	ASSERT(wwIsValid(soa, count * step));
+	ASSERT(wwIsDisjoint(soa, pre, count * step));
+	for (i = 0; i < count; ++i, pre += step)
+		for (j = 0; j < step; ++j)
+			pre[j] = soa[j * count + i];
+}
+
+void ecSoASelect(word b[], const word soa[], size_t count, size_t step,
+	size_t idx)
+{
+	word masks[64];
+	register word acc0, acc1, acc2, acc3;
+	register word mask;
+	const word* row;
+	size_t c, i, j, k;
+	ASSERT(idx < count);
+	ASSERT(wwIsValid(soa, count * step));
+	ASSERT(wwIsValid(b, step));
+	wwSetZero(b, step);
+	// обработать блоки из не более чем 64 точек
+	for (k = 0; k < count; k += c, soa += c)
+	{
+		c = MIN2(count - k, COUNT_OF(masks));
+		// masks[i] <- (k + i == idx) ? WORD_MAX : 0
+		for (i = 0; i < c; ++i)
+		{
+			mask = (word)((k + i) ^ idx);
+			masks[i] = ((mask | (WORD_0 - mask)) >> (B_PER_W - 1)) - WORD_1;
+		}
+		// b[j..j + 3] |= \sum_i masks[i] & soa[(j..j + 3) * count + i]
+		for (j = 0; j + 4 <= step; j += 4)
+		{
+			row = soa + j * count;
+			acc0 = acc1 = acc2 = acc3 = 0;
+			for (i = 0; i < c; ++i)
+			{
+				acc0 |= masks[i] & row[i];
+				acc1 |= masks[i] & row[count + i];
+				acc2 |= masks[i] & row[2 * count + i];
+				acc3 |= masks[i] & row[3 * count + i];
+			}
+			b[j] |= acc0, b[j + 1] |= acc1, b[j + 2] |= acc2, b[j + 3] |= acc3;
+		}
+		// b[j] |= \sum_i masks[i] & soa[j * count + i]
+		for (; j < step; ++j)
+		{
+			row = soa + j * count;
+			acc0 = 0;
+			for (i = 0; i < c; ++i)
+				acc0 |= masks[i] & row[i];
+			b[j] |= acc0;
+		}
+	}
+	// очистка
+	memWipe(masks, sizeof(masks));
+	acc0 = acc1 = acc2 = acc3 = mask = 0, idx = 0;
+}
+
+/*
+*******************************************************************************
+Регулярная кратная точка
+
+Для определения b = da с секретной кратностью d используется регулярное
+знаковое оконное представление [Joye M., Tunstall M. Exponent recoding and
+regular exponentiation algorithms. AFRICACRYPT 2009] с длиной окна w.
+
+Кратность d заменяется на нечетное число k: k = d, если d нечетно,
+и k = d + q в противном случае (q -- порядок группы точек, da = ka).
+Выбор выполняется по маске. Число k записывается в виде
+	k = \sum_{i=0}^{t-1} k_i 2^{wi},
+где k_i -- нечетные числа из интервала (-2^w, 2^w), k_{t-1} > 0. При этом
+	k_i = (u_i | 1) - 2^w, i < t - 1,
+	k_{t-1} = u_{t-1} | 1,
+где u_i -- число, составленное из битов k с номерами wi,..., wi + w.
+Таким образом, символ k_i определяется по фиксированной позиции
+и без ветвлений, число символов t фиксировано (определяется длиной q).
+
+Рассчитываются малые кратные pre[j] = (2j + 1)a и pre[count + j] =
+-(2j + 1)a, j = 0, 1,..., count - 1, где count = 2^{w-1}. Символ k_i
+определяет номер малого кратного, которое затем выбирается из pre
+полным просмотром таблицы с маскированием. Аффинные кратные хранятся
+в формате SoA и выбираются функцией ecSoASelect(). Если среди кратных
+оказалась O (только для точек малого порядка), то pre остается таблицей
+проективных точек в обычном формате (функция ecRegSelect()).
+В основном цикле на каждый символ выполняется w удвоений и одно сложение.
+
+Время вычислений и обращения к памяти не зависят от d при условии, что
+функции сложения и удвоения регулярны на неисключительных входах.
+Исключительные входы (сложение совпадающих или противоположных точек)
+возникают с пренебрежимо малой вероятностью, если d выбирается случайно.
+
+Длина окна зависит только от длины n элементов базового поля.
+*******************************************************************************
+*/
+
+static size_t ecRegWidth(size_t l)
+{
+	size_t w = 3;
+	if (l >= 120)
+		w = 5;
+	else if (l >= 40)
+		w = 4;
+	return MIN2(w, EC_W_MAX);
+}
+
+static bool_t ecRegPrecomp(word pre[], const word a[], size_t count,
+	const ec_o* ec, void* stack)
+{
+	const size_t n = ec->f->n;
+	const size_t step = ec->d * n;
+	size_t i;
+	// переменные в stack
+	word* t = (word*)stack;
+	word* pa = t + step;
+	stack = pa + 2 * n * 2 * count;
+	// pre
+	ASSERT(count > 1);
+	// pre[0] <- a
+	ecFromA(pre, a, ec, stack);
+	// t <- 2a, pre[i] <- t + pre[i - 1]
+	ecDblA(t, pre, ec, stack);
+	ecAddA(pre + step, t, pre, ec, stack);
+	for (i = 2; i < count; ++i)
+		ecAdd(pre + i * step, t, pre + (i - 1) * step, ec, stack);
+	// pre[count + i] <- -pre[i]
+	for (i = 0; i < count; ++i)
+		ecNeg(pre + (count + i) * step, pre + i * step, ec, stack);
+	// среди кратных есть O => остаться в проективных координатах
+	if (!ecToABatch(pa, pre, 2 * count, ec, stack))
+		return FALSE;
+	// pre <- SoA(pa)
+	ecSoAFrom(pre, pa, 2 * count, 2 * n);
+	return TRUE;
+}
+
+static size_t ecRegPrecomp_deep(size_t n, size_t ec_d, size_t ec_deep,
+	size_t count)
+{
+	return O_OF_W(ec_d * n + 2 * n * 2 * count) +
+		ecToABatch_deep(n, ec_deep, 2 * count);
+}
+
+/*	b <- pre[idx] (полный просмотр [count * step]pre с маскированием). */
+static void ecRegSelect(word b[], const word pre[], size_t count,
+	size_t step, register size_t idx)
+{
+	register word mask;
+	size_t i, j;
+	ASSERT(idx < count);
+	wwSetZero(b, step);
+	for (i = 0; i < count; ++i, pre += step)
+	{
+		// mask <- (i == idx) ? WORD_MAX : 0
+		mask = (word)(i ^ idx);
+		mask = ((mask | (WORD_0 - mask)) >> (B_PER_W - 1)) - WORD_1;
+		for (j = 0; j < step; ++j)
+			b[j] |= mask & pre[j];
+	}
+	mask = 0, idx = 0;
+}
+
+bool_t ecMulACT(word b[], const word a[], const ec_o* ec, const word d[],
+	size_t m, void* stack)
+{
+	const size_t n = ec->f->n;
+	const size_t w = ecRegWidth(B_OF_W(n));
+	const size_t count = SIZE_1 << (w - 1);
+	size_t t_count;
+	register word u;
+	register word mask;
+	size_t step, i, j;
+	ec_add_i add;
+	// переменные в stack
+	word* k;			/* нечетная кратность */
+	word* t;			/* вспомогательная точка */
+	word* r;			/* выбранное малое кратное */
+	word* pre;			/* pre[i] = \pm(2i + 1)a (2 * count элементов) */
+	// pre
+	ASSERT(ecIsOperable(ec) && ecIsOperableGroup(ec));
+	ASSERT(0 < m && m <= n + 1);
+	ASSERT(wwCmp2(d, m, ec->order, n + 1) < 0);
+	// раскладка stack
+	k = (word*)stack;
+	t = k + n + 2;
+	r = t + ec->d * n;
+	pre = r + ec->d * n;
+	stack = pre + 2 * count * ec->d * n;
+	// число символов
+	t_count = (wwBitSize(ec->order, n + 1) + w) / w;
+	ASSERT(w * t_count + 1 <= B_OF_W(n + 2));
+	// k <- d, d четно => k <- d + q
+	wwCopy(k, d, m);
+	wwSetZero(k + m, n + 2 - m);
+	mask = (d[0] & 1) - WORD_1;
+	for (i = 0; i < n + 1; ++i)
+		r[i] = ec->order[i] & mask;
+	k[n + 1] = zzAdd2(k, r, n + 1);
+	ASSERT(k[0] & 1);
+	// расчет pre[i]
+	if (ecRegPrecomp(pre, a, count, ec, stack))
+		add = ec->adda, step = 2 * n;
+	else
+		add = ec->add, step = ec->d * n;
+	// t <- pre[k_{t-1}]
+	u = wwGetBits(k, w * (t_count - 1), w + 1) | 1;
+	ASSERT(u < WORD_BIT_POS(w));
+	if (step == 2 * n)
+	{
+		ecSoASelect(r, pre, 2 * count, step, (size_t)(u >> 1));
+		ecFromA(t, r, ec, stack);
+	}
+	else
+	{
+		ecRegSelect(r, pre, 2 * count, step, (size_t)(u >> 1));
+		wwCopy(t, r, step);
+	}
+	// цикл по символам
+	for (i = t_count - 1; i--;)
+	{
+		// t <- 2^w t
+		for (j = 0; j < w; ++j)
+			ecDbl(t, t, ec, stack);
+		// u <- номер k_i в pre
+		u = (wwGetBits(k, w * i, w + 1) | 1) >> 1;
+		mask = (u >> (w - 1)) - WORD_1;
+		u ^= (word)count ^ ((word)(count - 1) & mask);
+		// t <- t + pre[u]
+		if (step == 2 * n)
+			ecSoASelect(r, pre, 2 * count, step, (size_t)u);
+		else
+			ecRegSelect(r, pre, 2 * count, step, (size_t)u);
+		ecCallAdd(add, t, t, r, ec, stack);
+	}
+	// очистка
+	u = mask = 0;
+	wwSetZero(k, n + 2);
+	wwSetZero(r, ec->d * n);
+	// к аффинным координатам
+	return ecToA(b, t, ec, stack);
+}
+
+size_t ecMulACT_deep(size_t n, size_t ec_d, size_t ec_deep)
+{
+	const size_t w = ecRegWidth(B_OF_W(n));
+	const size_t count = SIZE_1 << (w - 1);
+	return O_OF_W(n + 2) +
+		O_OF_W(2 * ec_d * n) +
+		O_OF_W(2 * count * ec_d * n) +
+		ecRegPrecomp_deep(n, ec_d, ec_deep, count);
 }
 
 /*
@@ -276,24 +1052,28 @@ Elliptic Curve Cryptography, Springer, 2004] (interleaving with NAF).
 
 Для каждого d[i] строится naf[i] длиной l[i] с шириной окна w[i].
 
-Сложность алгоритма:
+Малые кратные каждой точки a[i] рассчитываются функцией ecNAFPrecomp()
+и переводятся в аффинные координаты. Сложность алгоритма:
 	max l[i](P <- 2P) + \sum {i=1}^k
-		[1(P <- 2A) + (2^{w[i]-2}-2)(P <- P + P) + l[i]/(w[i]+1)(P <- P + P)].
+		[1(P <- 2A) + (2^{w[i]-2}-2)(P <- P + P) + 1(I) + 2^{w[i]-2}(6M + 1S)
+		+ l[i]/(w[i]+1)(P <- P + A)].
 *******************************************************************************
 */
 
-bool_t ecAddMulA(word b[], const ec_o* ec, void* stack, size_t k, ...)
+static bool_t ecStrausA(word b[], const ec_o* ec, size_t k,
+	const word* const as[], const word* const ds[], const size_t ms[],
+	void* stack)
 {
 	const size_t n = ec->f->n;
 	register word w;
-	size_t i, naf_max_size = 0;
-	va_list marker;
+	size_t i, e = 0, naf_max_size = 0;
 	// переменные в stack
 	word* t;			/* проективная точка */
 	size_t* m;			/* длины d[i] */
 	size_t* naf_width;	/* размеры NAF-окон */
 	size_t* naf_size;	/* длины NAF */
 	size_t* naf_pos;	/* позиция в NAF-представлении */
+	size_t* pre_step;	/* размеры предвычисленных точек */
 	word** naf;			/* NAF */
 	word** pre;			/* предвычисленные точки */
 	// pre
@@ -305,54 +1085,39 @@ bool_t ecAddMulA(word b[], const ec_o* ec, void* stack, size_t k, ...)
 	naf_width = m + k;
 	naf_size = naf_width + k;
 	naf_pos = naf_size + k;
-	naf = (word**)(naf_pos + k);
+	pre_step = naf_pos + k;
+	naf = (word**)(pre_step + k);
 	pre = naf + k;
 	stack = pre + k;
-	// обработать параметры (a[i], d[i], m[i])
-	va_start(marker, k);
+	// обработать (a[i], d[i], m[i])
 	for (i = 0; i < k; ++i)
 	{
-		const word* a;
-		const word* d;
-		size_t naf_count, j;
-		// a <- a[i]
-		a = va_arg(marker, const word*);
-		// d <- d[i]
-		d = va_arg(marker, const word*);
-		// прочитать m[i]
-		m[i] = va_arg(marker, size_t);
+		size_t naf_count;
 		// подправить m[i]
-		m[i] = wwWordSize(d, m[i]);
+		m[i] = wwWordSize(ds[i], ms[i]);
 		// расчет naf[i]
 		naf_width[i] = ecNAFWidth(B_OF_W(m[i]));
 		naf_count = SIZE_1 << (naf_width[i] - 2);
 		naf[i] = (word*)stack;
 		stack = naf[i] + 2 * m[i] + 1;
-		naf_size[i] = wwNAF(naf[i], d, m[i], naf_width[i]);
+		naf_size[i] = wwNAF(naf[i], ds[i], m[i], naf_width[i]);
 		if (naf_size[i] > naf_max_size)
 			naf_max_size = naf_size[i];
 		naf_pos[i] = 0;
 		// резервируем память для pre[i]
 		pre[i] = (word*)stack;
 		stack = pre[i] + ec->d * n * naf_count;
-		// pre[i][0] <- a[i]
-		ecFromA(pre[i], a, ec, stack);
-		// расчет pre[i][j]: t <- 2a[i], pre[i][j] <- t + pre[i][j - 1]
-		ASSERT(naf_count > 1);
-		ecDblA(t, pre[i], ec, stack);
-		ecAddA(pre[i] + ec->d * n, t, pre[i], ec, stack);
-		for (j = 2; j < naf_count; ++j)
-			ecAdd(pre[i] + j * ec->d * n, t, pre[i] + (j - 1) * ec->d * n, ec,
-				stack);
+		// расчет pre[i][j]
+		pre_step[i] = ecNAFPrecomp(pre[i], as[i], naf_count, ec, stack) ?
+			2 * n : ec->d * n;
 	}
-	va_end(marker);
 	// t <- O
 	ecSetO(t, ec);
-	// основной цикл
+	// основной цикл (удвоения t откладываются до очередного сложения,
+	// e -- число отложенных удвоений)
 	for (; naf_max_size; --naf_max_size)
 	{
-		// t <- 2 t
-		ecDbl(t, t, ec, stack);
+		++e;
 		// цикл по (a[i], naf[i])
 		for (i = 0; i < k; ++i)
 		{
@@ -366,16 +1131,22 @@ bool_t ecAddMulA(word b[], const ec_o* ec, void* stack, size_t k, ...)
 			naf_hi = WORD_1 << (naf_width[i] - 1);
 			if (w & 1)
 			{
+				// t <- 2^e t
+				ecDblN(t, t, e, ec, stack), e = 0;
 				// t <- t \pm pre[i][naf[i][w]]
-				if (w == 1)
-					ecAddA(t, t, pre[i], ec, stack);
-				else if (w == (naf_hi ^ 1))
-					ecSubA(t, t, pre[i], ec, stack);
-				else if (w & naf_hi)
-					w ^= naf_hi,
-					ecSub(t, t, pre[i] + (w >> 1) * ec->d * n, ec, stack);
+				if (w & naf_hi)
+				{
+					w ^= naf_hi;
+					if (pre_step[i] == 2 * n)
+						ecSubA(t, t, pre[i] + (w >> 1) * 2 * n, ec, stack);
+					else
+						ecSub(t, t, pre[i] + (w >> 1) * pre_step[i], ec,
+							stack);
+				}
+				else if (pre_step[i] == 2 * n)
+					ecAddA(t, t, pre[i] + (w >> 1) * 2 * n, ec, stack);
 				else
-					ecAdd(t, t, pre[i] + (w >> 1) * ec->d * n, ec, stack);
+					ecAdd(t, t, pre[i] + (w >> 1) * pre_step[i], ec, stack);
 				// к следующему символу naf[i]
 				naf_pos[i] += naf_width[i];
 			}
@@ -383,18 +1154,62 @@ bool_t ecAddMulA(word b[], const ec_o* ec, void* stack, size_t k, ...)
 				++naf_pos[i];
 		}
 	}
+	// t <- 2^e t
+	ecDblN(t, t, e, ec, stack);
 	// очистка
 	w = 0;
 	// к аффинным координатам
 	return ecToA(b, t, ec, stack);
 }
 
+static size_t ecStrausA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t k,
+	size_t m)
+{
+	const size_t naf_width = ecNAFWidth(B_OF_W(m));
+	const size_t naf_count = SIZE_1 << (naf_width - 2);
+	return O_OF_W(ec_d * n) +
+		5 * sizeof(size_t) * k +
+		2 * sizeof(word**) * k +
+		k * O_OF_W(2 * m + 1 + ec_d * n * naf_count) +
+		ecNAFPrecomp_deep(n, ec_d, ec_deep, naf_count);
+}
+
+bool_t ecAddMulA(word b[], const ec_o* ec, void* stack, size_t k, ...)
+{
+	size_t i;
+	va_list marker;
+	// переменные в stack
+	const word** as;	/* точки */
+	const word** ds;	/* кратности */
+	size_t* ms;			/* длины кратностей */
+	// pre
+	ASSERT(ecIsOperable(ec));
+	ASSERT(k > 0);
+	// раскладка stack
+	as = (const word**)stack;
+	ds = as + k;
+	ms = (size_t*)(ds + k);
+	stack = ms + k;
+	// прочитать параметры (a[i], d[i], m[i])
+	va_start(marker, k);
+	for (i = 0; i < k; ++i)
+	{
+		as[i] = va_arg(marker, const word*);
+		ds[i] = va_arg(marker, const word*);
+		ms[i] = va_arg(marker, size_t);
+	}
+	va_end(marker);
+	// вычислить сумму
+	return ecStrausA(b, ec, k, as, ds, ms, stack);
+}
+
 size_t ecAddMulA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t k, ...)
 {
-	size_t i, ret;
+	size_t i, ret, pre_deep = 0;
 	va_list marker;
-	ret = O_OF_W(ec_d * n);
-	ret += 4 * sizeof(size_t) * k;
+	ret = 2 * sizeof(const word*) * k + sizeof(size_t) * k;
+	ret += O_OF_W(ec_d * n);
+	ret += 5 * sizeof(size_t) * k;
 	ret += 2 * sizeof(word**) * k;
 	va_start(marker, k);
 	for (i = 0; i < k; ++i)
@@ -404,8 +1219,453 @@ size_t ecAddMulA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t k, ...)
 		size_t naf_count = SIZE_1 << (naf_width - 2);
 		ret += O_OF_W(2 * m + 1);
 		ret += O_OF_W(ec_d * n * naf_count);
+		pre_deep = MAX2(pre_deep,
+			ecNAFPrecomp_deep(n, ec_d, ec_deep, naf_count));
 	}
 	va_end(marker);
-	ret += ec_deep;
+	ret += pre_deep;
 	return ret;
 }
+
+/*
+*******************************************************************************
+Сумма многих кратных
+
+При небольшом k функция ecMultiMulA() вызывает ecStrausA() (как
+ecAddMulA()). При большом k используется метод Пиппенджера [Bernstein D.J.,
+Doumen J., Lange T., Oosterwijk J.-J. Faster batch forgery identification,
+INDOCRYPT 2012, раздел 4]:
+-	кратности d[i] разбиваются на окна по c битов;
+-	окна обрабатываются от старших к младшим: накопленная сумма t
+	умножается на 2^c, точки a[i] складываются в корзины bkt[v - 1]
+	по значениям v очередных окон d[i], к t добавляется \sum v bkt[v - 1]
+	(рассчитывается нарастающими суммами по v от 2^c - 1 до 1).
+
+Сложность метода Пиппенджера (число сложений):
+	\ceil(l / c)(k + 2^{c + 1}),
+а сложность ecStrausA() примерно равна
+	k (2^{w - 2} + l / (w + 1)),
+где l -- битовая длина кратностей, w = ecNAFWidth(l). Функция
+ecPippengerWidth() определяет c, минимизирующее первую оценку. Вторая
+оценка не учитывает предвычислений в ecStrausA() (в том числе обращения
+при переходе к аффинным координатам), которые, по замерам на кривых bign,
+примерно удваивают ее. Поэтому метод Пиппенджера выбирается, если его
+оценка меньше удвоенной второй оценки (на кривых bign-curve256v1 --
+начиная с k = 64).
+*******************************************************************************
+*/
+
+#ifdef BEE2_LOW_MEMORY
+	#define EC_PIPPENGER_MAX_C 6
+#else
+	#define EC_PIPPENGER_MAX_C 10
+#endif
+
+static size_t ecPippengerWidth(size_t l, size_t k)
+{
+	size_t c, c_best = 1, cost, cost_best = SIZE_MAX;
+	for (c = 1; c <= EC_PIPPENGER_MAX_C; ++c)
+	{
+		cost = (l + c - 1) / c * (k + (SIZE_1 << (c + 1)));
+		if (cost < cost_best)
+			cost_best = cost, c_best = c;
+	}
+	return c_best;
+}
+
+static bool_t ecIsPippenger(size_t l, size_t k)
+{
+	const size_t c = ecPippengerWidth(l, k);
+	const size_t w = ecNAFWidth(l);
+	return (l + c - 1) / c * (k + (SIZE_1 << (c + 1))) <
+		2 * k * ((SIZE_1 << (w - 2)) + l / (w + 1));
+}
+
+static bool_t ecPippengerA(word b[], const word a[], const word d[],
+	size_t m, size_t k, const ec_o* ec, void* stack)
+{
+	const size_t n = ec->f->n;
+	const size_t l = B_OF_W(m);
+	const size_t c = ecPippengerWidth(l, k);
+	const size_t count = (SIZE_1 << c) - 1;
+	size_t pos, i, v;
+	// переменные в stack
+	word* t = (word*)stack;		/* накопленная сумма */
+	word* r = t + ec->d * n;	/* нарастающая сумма корзин */
+	word* u = r + ec->d * n;	/* сумма окна */
+	word* bkt = u + ec->d * n;	/* корзины */
+	stack = bkt + ec->d * n * count;
+	// t <- O
+	wwSetZero(t, ec->d * n);
+	// цикл по окнам
+	for (pos = (l + c - 1) / c * c; pos;)
+	{
+		pos -= c;
+		// t <- 2^c t
+		ecDblN(t, t, c, ec, stack);
+		// bkt[v - 1] <- \sum_{i: окно d[i] == v} a[i]
+		wwSetZero(bkt, ec->d * n * count);
+		for (i = 0; i < k; ++i)
+		{
+			v = (size_t)wwGetBits(d + m * i, pos, MIN2(c, l - pos));
+			if (v)
+				ecAddA(bkt + ec->d * n * (v - 1), bkt + ec->d * n * (v - 1),
+					a + 2 * n * i, ec, stack);
+		}
+		// u <- \sum v bkt[v - 1]
+		wwSetZero(r, ec->d * n);
+		wwSetZero(u, ec->d * n);
+		for (v = count; v; --v)
+		{
+			ecAdd(r, r, bkt + ec->d * n * (v - 1), ec, stack);
+			ecAdd(u, u, r, ec, stack);
+		}
+		// t <- t + u
+		ecAdd(t, t, u, ec, stack);
+	}
+	// к аффинным координатам
+	return ecToA(b, t, ec, stack);
+}
+
+static size_t ecPippengerA_deep(size_t n, size_t ec_d, size_t ec_deep,
+	size_t m, size_t k)
+{
+	const size_t c = ecPippengerWidth(B_OF_W(m), k);
+	return O_OF_W(ec_d * n * (3 + (SIZE_1 << c) - 1)) + ec_deep;
+}
+
+bool_t ecMultiMulA(word b[], const word a[], const word d[], size_t m,
+	size_t k, const ec_o* ec, void* stack)
+{
+	const size_t n = ec->f->n;
+	size_t i;
+	// переменные в stack
+	const word** as;	/* точки */
+	const word** ds;	/* кратности */
+	size_t* ms;			/* длины кратностей */
+	// pre
+	ASSERT(ecIsOperable(ec));
+	ASSERT(k > 0 && m > 0);
+	ASSERT(wwIsValid(a, 2 * n * k) && wwIsValid(d, m * k));
+	// метод Пиппенджера
+	if (ecIsPippenger(B_OF_W(m), k))
+		return ecPippengerA(b, a, d, m, k, ec, stack);
+	// метод Штрауса
+	as = (const word**)stack;
+	ds = as + k;
+	ms = (size_t*)(ds + k);
+	stack = ms + k;
+	for (i = 0; i < k; ++i)
+		as[i] = a + 2 * n * i, ds[i] = d + m * i, ms[i] = m;
+	return ecStrausA(b, ec, k, as, ds, ms, stack);
+}
+
+size_t ecMultiMulA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t m,
+	size_t k)
+{
+	if (ecIsPippenger(B_OF_W(m), k))
+		return ecPippengerA_deep(n, ec_d, ec_deep, m, k);
+	return 2 * sizeof(const word*) * k + sizeof(size_t) * k +
+		ecStrausA_deep(n, ec_d, ec_deep, k, m);
+}
+
+/*
+*******************************************************************************
+Гребенчатый метод
+
+Реализован гребенчатый метод Лима -- Ли [Lim C., Lee P. More Flexible
+Exponentiation with Precomputation, CRYPTO 1994] с одной гребенкой
+(алгоритм 3.44 [Hankerson D., Menezes A., Vanstone S. Guide to Elliptic
+Curve Cryptography, Springer, 2004]).
+
+Кратность d длины l = B_OF_W(m) битов записывается по столбцам матрицы
+из w строк и s = \ceil(l / w) столбцов: в i-й строке размещаются биты
+d_{is},..., d_{is + s - 1}. Заранее рассчитываются аффинные точки
+	pre[j - 1] = \sum_{i: j_i = 1} 2^{is} a,	j = 1, 2,..., 2^w - 1.
+При вычислении d a столбцы матрицы обрабатываются от старших к младшим.
+Обработка столбца состоит в удвоении накопленной точки и прибавлении к ней
+pre[j - 1], где j -- число, составленное из битов столбца (если j != 0).
+
+Для расчета d a требуется s удвоений и не более s сложений с аффинными
+точками. Таблица pre не зависит от d и может рассчитываться один раз
+для фиксированной точки a (например, для базовой точки группы).
+*******************************************************************************
+*/
+
+bool_t ecCombPrecompA(word pre[], const word a[], const ec_o* ec, size_t w,
+	size_t m, void* stack)
+{
+	const size_t n = ec->f->n;
+	const size_t s = (B_OF_W(m) + w - 1) / w;
+	size_t i, j, hi;
+	// переменные в stack
+	word* t = (word*)stack;
+	stack = t + ec->d * n;
+	// pre
+	ASSERT(ecIsOperable(ec));
+	ASSERT(1 <= w && w < B_PER_S && m > 0);
+	ASSERT(wwIsValid(pre, 2 * n * ((SIZE_1 << w) - 1)));
+	// pre[2^i - 1] <- 2^{is} a
+	wwCopy(pre, a, 2 * n);
+	for (i = 1; i < w; ++i)
+	{
+		ecFromA(t, pre + 2 * n * ((SIZE_1 << (i - 1)) - 1), ec, stack);
+		ecDblN(t, t, s, ec, stack);
+		if (!ecToA(pre + 2 * n * ((SIZE_1 << i) - 1), t, ec, stack))
+			return FALSE;
+	}
+	// pre[j - 1] <- pre[j - hi - 1] + pre[hi - 1], hi -- старший бит j
+	for (j = 3, hi = 2; j < (SIZE_1 << w); ++j)
+	{
+		if (j == 2 * hi)
+		{
+			hi = j;
+			continue;
+		}
+		ecFromA(t, pre + 2 * n * (j - hi - 1), ec, stack);
+		ecAddA(t, t, pre + 2 * n * (hi - 1), ec, stack);
+		if (!ecToA(pre + 2 * n * (j - 1), t, ec, stack))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+size_t ecCombPrecompA_deep(size_t n, size_t ec_d, size_t ec_deep)
+{
+	return O_OF_W(ec_d * n) + ec_deep;
+}
+
+void ecCombMul(word b[], const word pre[], const ec_o* ec, size_t w,
+	const word d[], size_t m, void* stack)
+{
+	const size_t n = ec->f->n;
+	const size_t l = B_OF_W(m);
+	const size_t s = (l + w - 1) / w;
+	register size_t j;
+	size_t col, i, pos;
+	// pre
+	ASSERT(ecIsOperable(ec));
+	ASSERT(1 <= w && w < B_PER_S && m > 0);
+	ASSERT(wwIsValid(pre, 2 * n * ((SIZE_1 << w) - 1)));
+	ASSERT(wwIsValid(d, m));
+	ASSERT(wwIsDisjoint2(b, ec->d * n, pre, 2 * n * ((SIZE_1 << w) - 1)));
+	// b <- O
+	wwSetZero(b, ec->d * n);
+	// цикл по столбцам
+	for (col = s; col--;)
+	{
+		// b <- 2 b
+		ecDbl(b, b, ec, stack);
+		// j <- столбец d
+		for (i = w, j = 0; i--;)
+		{
+			pos = i * s + col;
+			j = j << 1 | (pos < l && wwTestBit(d, pos));
+		}
+		// b <- b + pre[j - 1]
+		if (j)
+			ecAddA(b, b, pre + 2 * n * (j - 1), ec, stack);
+	}
+	// очистка
+	j = 0;
+}
+
+size_t ecCombMul_deep(size_t n, size_t ec_d, size_t ec_deep)
+{
+	return ec_deep;
+}
+
+bool_t ecCombMulA(word b[], const word pre[], const ec_o* ec, size_t w,
+	const word d[], size_t m, void* stack)
+{
+	// переменные в stack
+	word* t = (word*)stack;
+	stack = t + ec->d * ec->f->n;
+	// t <- d a
+	ecCombMul(t, pre, ec, w, d, m, stack);
+	// к аффинным координатам
+	return ecToA(b, t, ec, stack);
+}
+
+size_t ecCombMulA_deep(size_t n, size_t ec_d, size_t ec_deep)
+{
+	return O_OF_W(ec_d * n) + ec_deep;
+}
+
+/*
+*******************************************************************************
+Сумма кратных фиксированной и произвольной точек
+
+Для вычисления d g + e a, где g -- фиксированная точка с таблицей pre
+гребенчатого метода, строится NAF-представление e (как в ecMulA())
+и рассчитываются аффинные малые кратные a. Затем выполняется общая
+цепочка удвоений: на позиции pos обрабатываются символ NAF(e)
+с номером pos (если он есть) и столбец гребенки d с номером pos
+(если pos < s).
+
+Корректность следует из того, что столбец col гребенки входит
+в d g с весом 2^col. Поэтому достаточно max(s, |NAF(e)|) удвоений вместо
+s + |NAF(e)| при раздельном вычислении слагаемых и не требуется отдельного
+перехода к аффинным координатам для каждого слагаемого.
+
+Метод JSF (Joint Sparse Form) совместного представления d и e не
+используется: его плотность (1/2) выше, чем суммарная плотность
+чередующихся оконных NAF (2 / (w + 1)) при w > 3, а для g
+таблица гребенки эффективнее любой оконной.
+
+В ecCombAddMulNAFA() малые кратные a передаются готовыми (они рассчитываются
+в ecNAFPrecompA() с произвольной длиной окна), общая цепочка удвоений
+реализована в ecCombAddMulCore().
+*******************************************************************************
+*/
+
+static bool_t ecCombAddMulCore(word b[], const word pre[], const ec_o* ec,
+	size_t w, const word d[], size_t m, const word pa[], size_t step,
+	ec_add_i add, ec_sub_i sub, const word naf[], size_t naf_size,
+	size_t naf_width, void* stack)
+{
+	const size_t n = ec->f->n;
+	const size_t l = B_OF_W(m);
+	const size_t s = (l + w - 1) / w;
+	const word naf_hi = WORD_1 << (naf_width - 1);
+	size_t naf_pos, pos, i;
+	register word v;
+	// переменные в stack
+	word* t = (word*)stack;		/* проективная точка */
+	stack = t + ec->d * n;
+	// общая цепочка удвоений
+	ecSetO(t, ec);
+	for (naf_pos = 0, pos = MAX2(naf_size, s); pos--;)
+	{
+		// t <- 2 t
+		ecDbl(t, t, ec, stack);
+		// t <- t \pm pa[naf[pos]]
+		if (pos < naf_size)
+		{
+			v = wwGetBits(naf, naf_pos, naf_width);
+			if (v & 1)
+			{
+				if (v & naf_hi)
+					ecCallSub(sub, t, t, pa + ((v ^ naf_hi) >> 1) * step, ec,
+						stack);
+				else
+					ecCallAdd(add, t, t, pa + (v >> 1) * step, ec,
+						stack);
+				naf_pos += naf_width;
+			}
+			else
+				++naf_pos;
+		}
+		// t <- t + pre[столбец pos гребенки d - 1]
+		if (pos < s)
+		{
+			for (i = w, v = 0; i--;)
+				v = v << 1 | (i * s + pos < l && wwTestBit(d, i * s + pos));
+			if (v)
+				ecAddA(t, t, pre + 2 * n * (v - 1), ec, stack);
+		}
+	}
+	// к аффинным координатам
+	v = 0;
+	return ecToA(b, t, ec, stack);
+}
+
+bool_t ecCombAddMulA(word b[], const word pre[], const ec_o* ec, size_t w,
+	const word d[], size_t m, const word a[], const word e[], size_t k,
+	void* stack)
+{
+	const size_t n = ec->f->n;
+	size_t naf_width, naf_count, naf_size, step;
+	ec_add_i add;
+	ec_sub_i sub;
+	// переменные в stack
+	word* naf;			/* NAF */
+	word* pa;			/* малые кратные a */
+	// pre
+	ASSERT(ecIsOperable(ec));
+	ASSERT(1 <= w && w < B_PER_S && m > 0);
+	ASSERT(wwIsValid(pre, 2 * n * ((SIZE_1 << w) - 1)));
+	ASSERT(wwIsValid(d, m) && wwIsValid(e, k));
+	// раскладка stack
+	naf = (word*)stack;
+	pa = naf + 2 * k + 1;
+	// расчет NAF(e)
+	k = wwWordSize(e, k);
+	naf_width = ecNAFWidth(B_OF_W(k));
+	naf_count = SIZE_1 << (naf_width - 2);
+	stack = pa + ec->d * n * naf_count;
+	naf_size = wwNAF(naf, e, k, naf_width);
+	// расчет малых кратных a
+	add = ec->adda, sub = ec->suba, step = 2 * n;
+	if (naf_size && !ecNAFPrecomp(pa, a, naf_count, ec, stack))
+		add = ec->add, sub = ec->sub, step = ec->d * n;
+	// d g + e a
+	return ecCombAddMulCore(b, pre, ec, w, d, m, pa, step, add, sub,
+		naf, naf_size, naf_width, stack);
+}
+
+size_t ecCombAddMulA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t k)
+{
+	const size_t naf_width = ecNAFWidth(B_OF_W(k));
+	const size_t naf_count = SIZE_1 << (naf_width - 2);
+	return O_OF_W(2 * k + 1) +
+		O_OF_W(ec_d * n * naf_count) +
+		utilMax(2,
+			ecNAFPrecomp_deep(n, ec_d, ec_deep, naf_count),
+			O_OF_W(ec_d * n) + ec_deep);
+}
+
+bool_t ecNAFPrecompA(word pa[], const word a[], size_t w, const ec_o* ec,
+	void* stack)
+{
+	const size_t n = ec->f->n;
+	const size_t count = SIZE_1 << (w - 2);
+	// переменные в stack
+	word* pre = (word*)stack;
+	stack = pre + ec->d * n * count;
+	// pre
+	ASSERT(ecIsOperable(ec));
+	ASSERT(3 <= w && w < B_PER_W);
+	ASSERT(wwIsValid(pa, 2 * n * count));
+	// малые кратные
+	if (!ecNAFPrecomp(pre, a, count, ec, stack))
+		return FALSE;
+	wwCopy(pa, pre, 2 * n * count);
+	return TRUE;
+}
+
+size_t ecNAFPrecompA_deep(size_t n, size_t ec_d, size_t ec_deep, size_t w)
+{
+	const size_t count = SIZE_1 << (w - 2);
+	return O_OF_W(ec_d * n * count) +
+		ecNAFPrecomp_deep(n, ec_d, ec_deep, count);
+}
+
+bool_t ecCombAddMulNAFA(word b[], const word pre[], const ec_o* ec,
+	size_t w, const word d[], size_t m, const word pa[], size_t naf_w,
+	const word e[], size_t k, void* stack)
+{
+	const size_t n = ec->f->n;
+	size_t naf_size;
+	// переменные в stack
+	word* naf = (word*)stack;
+	stack = naf + 2 * k + 1;
+	// pre
+	ASSERT(ecIsOperable(ec));
+	ASSERT(1 <= w && w < B_PER_S && m > 0);
+	ASSERT(3 <= naf_w && naf_w < B_PER_W);
+	ASSERT(wwIsValid(pre, 2 * n * ((SIZE_1 << w) - 1)));
+	ASSERT(wwIsValid(pa, 2 * n * (SIZE_1 << (naf_w - 2))));
+	ASSERT(wwIsValid(d, m) && wwIsValid(e, k));
+	// d g + e a
+	k = wwWordSize(e, k);
+	naf_size = wwNAF(naf, e, k, naf_w);
+	return ecCombAddMulCore(b, pre, ec, w, d, m, pa, 2 * n, ec->adda,
+		ec->suba, naf, naf_size, naf_w, stack);
+}
+
+size_t ecCombAddMulNAFA_deep(size_t n, size_t ec_d, size_t ec_deep,
+	size_t k)
+{
+	return O_OF_W(2 * k + 1) + O_OF_W(ec_d * n) + ec_deep;
+}
@@ -4,7 +4,7 @@
 \brief Elliptic curves over binary fields
 \project bee2 [cryptographic library]
 \created 2012.06.26
-\version 2014.07.15
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,7 @@
 #include "bee2/core/mem.h"
 #include "bee2/core/stack.h"
 #include "bee2/core/util.h"
+#include "bee2/core/word.h"
 #include "bee2/math/ec2.h"
 #include "bee2/math/gf2.h"
 #include "bee2/math/pri.h"
@@ -167,6 +168,47 @@ static size_t ec2ToALD_deep(size_t n, size_t f_deep)
 	return O_OF_W(n) + f_deep;
 }
 
+// [count * 2n]b <- [count * 3n]a (A <- P)
+static bool_t ec2ToANLD(word b[], const word a[], size_t count, const ec_o* ec,
+	void* stack)
+{
+	const size_t n = ec->f->n;
+	bool_t ret = TRUE;
+	size_t i;
+	// переменные в stack
+	word* z = (word*)stack;
+	word* t = z + n * count;
+	stack = t + n * count;
+	// pre
+	ASSERT(ecIsOperable(ec) && ec->d == 3);
+	ASSERT(wwIsDisjoint2(a, 3 * n * count, b, 2 * n * count));
+	// z[i] <- za[i]
+	for (i = 0; i < count; ++i)
+	{
+		ASSERT(ec2SeemsOn3(a + 3 * n * i, ec));
+		qrCopy(z + n * i, ecZ(a + 3 * n * i, n), ec->f);
+	}
+	// t[i] <- z[i]^{-1}
+	qrInvBatch(t, z, count, ec->f, stack);
+	// b[i] <- a[i]
+	for (i = 0; i < count; ++i, a += 3 * n, b += 2 * n)
+	{
+		// a[i] == O => b[i] не определена
+		if (qrIsZero(ecZ(a, n), ec->f))
+		{
+			ret = FALSE;
+			continue;
+		}
+		// xb[i] <- xa[i] t[i]
+		qrMul(ecX(b), ecX(a), t + n * i, ec->f, stack);
+		// t[i] <- t[i]^2
+		qrSqr(t + n * i, t + n * i, ec->f, stack);
+		// yb[i] <- ya[i] t[i]
+		qrMul(ecY(b, n), ecY(a, n), t + n * i, ec->f, stack);
+	}
+	return ret;
+}
+
 // [3n]b <- -[3n]a (P <- -P)
 static void ec2NegLD(word b[], const word a[], const ec_o* ec, void* stack)
 {
@@ -555,6 +597,7 @@ bool_t ec2CreateLD(ec_o* ec, const qr_o* f, const octet A[], const octet B[],
 	// настроить интерфейсы
 	ec->froma = ec2FromALD;
 	ec->toa = ec2ToALD;
+	ec->toan = ec2ToANLD;
 	ec->neg = ec2NegLD;
 	ec->add = ec2AddLD;
 	ec->adda = ec2AddALD;
@@ -858,3 +901,161 @@ size_t ec2SubAA_deep(size_t n, size_t f_deep)
 {
 	return O_OF_W(2 * n) + ec2AddAA_deep(n, f_deep);
 }
+
+/*
+*******************************************************************************
+Лестница Монтгомери
+
+Реализован алгоритм Лопеса -- Дахаба [López J., Dahab R. Fast
+multiplication on elliptic curves over GF(2^m) without precomputation.
+CHES 1999] (см. также [Hankerson D., Menezes A., Vanstone S. Guide
+to Elliptic Curve Cryptography, алгоритм 3.40]).
+
+Поддерживаются точки R0 = (X1 : Z1) и R1 = (X2 : Z2) с инвариантом
+R1 - R0 = a. Используются только x-координаты: x(R0) = X1 / Z1,
+x(R1) = X2 / Z2. Сложение R1 <- R0 + R1 (Madd) и удвоение R0 <- 2 R0
+(Mdouble) выполняются по формулам
+	Z2 <- (X1 Z2 + X2 Z1)^2, X2 <- xa Z2 + (X1 Z2)(X2 Z1),
+	Z1 <- X1^2 Z1^2, X1 <- X1^4 + B Z1^4.
+Сложность шага: 5M + 1*B + 5S \approx 6M.
+
+Кратность d заменяется на число k = d + q или k = d + 2q длины
+l + 1, где l = wwBitSize(q) (выбор выполняется по маске). В начале
+R0 <- a, R1 <- 2a, затем обрабатываются биты k с номерами l - 1,..., 0.
+Если очередной бит равен 1, то R0 и R1 предварительно меняются
+местами, а после шага меняются обратно. Обмены выполняются по маске,
+поэтому время вычислений и обращения к памяти не зависят от d.
+
+На завершающем этапе по x-координатам R0 = k a и R1 = (k + 1) a
+и координатам a восстанавливается y-координата k a. Для этого
+используется одно обращение в GF(2^m).
+*******************************************************************************
+*/
+
+/*	(a, b) <- (b, a), если bit == 1. */
+static void ec2CSwap(word a[], word b[], size_t n, register word bit)
+{
+	register word mask = WORD_0 - bit;
+	register word t;
+	size_t i;
+	for (i = 0; i < n; ++i)
+		t = (a[i] ^ b[i]) & mask, a[i] ^= t, b[i] ^= t;
+	mask = t = 0;
+}
+
+bool_t ec2MulALadder(word b[], const word a[], const ec_o* ec,
+	const word d[], size_t m, void* stack)
+{
+	const size_t n = ec->f->n;
+	size_t l, i;
+	register word bit;
+	register word mask;
+	// переменные в stack
+	word* k;			/* [n + 2] расширенная кратность */
+	word* r;			/* [n + 1] порядок по маске */
+	word* x1;			/* [2n] (X1, Z1) */
+	word* x2;			/* [2n] (X2, Z2) */
+	word* t1;			/* [n] вспомогательный элемент */
+	word* t2;			/* [n] вспомогательный элемент */
+	// pre
+	ASSERT(ecIsOperable(ec) && ecIsOperableGroup(ec));
+	ASSERT(ec2SeemsOnA(a, ec));
+	ASSERT(0 < m && m <= n + 1);
+	ASSERT(wwCmp2(d, m, ec->order, n + 1) < 0);
+	// xa == 0 => порядок a равняется 2
+	if (qrIsZero(ecX(a), ec->f))
+		return ecMulA(b, a, ec, d, m, stack);
+	// раскладка stack
+	k = (word*)stack;
+	r = k + n + 2;
+	x1 = r + n + 1;
+	x2 = x1 + 2 * n;
+	t1 = x2 + 2 * n;
+	t2 = t1 + n;
+	stack = t2 + n;
+	// k <- d + q, k < 2^l => k <- k + q
+	l = wwBitSize(ec->order, n + 1);
+	wwCopy(k, d, m);
+	wwSetZero(k + m, n + 2 - m);
+	k[n + 1] = zzAdd2(k, ec->order, n + 1);
+	mask = (word)wwTestBit(k, l) - WORD_1;
+	for (i = 0; i < n + 1; ++i)
+		r[i] = ec->order[i] & mask;
+	k[n + 1] += zzAdd2(k, r, n + 1);
+	ASSERT(wwTestBit(k, l) && wwBitSize(k, n + 2) == l + 1);
+	// R0 <- a, R1 <- 2a
+	qrCopy(x1, ecX(a), ec->f);
+	qrSetUnity(x1 + n, ec->f);
+	qrSqr(x2 + n, ecX(a), ec->f, stack);
+	qrSqr(x2, x2 + n, ec->f, stack);
+	gf2Add2(x2, ec->B, ec->f);
+	// цикл по битам k
+	for (i = l; i--;)
+	{
+		bit = (word)wwTestBit(k, i);
+		ec2CSwap(x1, x2, 2 * n, bit);
+		// R1 <- R0 + R1
+		qrMul(t1, x1, x2 + n, ec->f, stack);
+		qrMul(t2, x2, x1 + n, ec->f, stack);
+		gf2Add(x2 + n, t1, t2, ec->f);
+		qrSqr(x2 + n, x2 + n, ec->f, stack);
+		qrMul(t1, t1, t2, ec->f, stack);
+		qrMul(x2, ecX(a), x2 + n, ec->f, stack);
+		gf2Add2(x2, t1, ec->f);
+		// R0 <- 2 R0
+		qrSqr(t1, x1, ec->f, stack);
+		qrSqr(t2, x1 + n, ec->f, stack);
+		qrMul(x1 + n, t1, t2, ec->f, stack);
+		qrSqr(t1, t1, ec->f, stack);
+		qrSqr(t2, t2, ec->f, stack);
+		qrMul(t2, t2, ec->B, ec->f, stack);
+		gf2Add(x1, t1, t2, ec->f);
+		ec2CSwap(x1, x2, 2 * n, bit);
+	}
+	// очистка
+	bit = mask = 0;
+	wwSetZero(k, n + 2);
+	wwSetZero(r, n + 1);
+	// k a == O?
+	if (qrIsZero(x1 + n, ec->f))
+		return FALSE;
+	// (k + 1) a == O => k a = -a
+	if (qrIsZero(x2 + n, ec->f))
+	{
+		ec2NegA(b, a, ec);
+		return TRUE;
+	}
+	// r <- x(a) Z2, t1 <- (x(a) Z1 Z2)^{-1}
+	qrMul(r, ecX(a), x2 + n, ec->f, stack);
+	qrMul(t1, r, x1 + n, ec->f, stack);
+	qrInv(t1, t1, ec->f, stack);
+	// x2 <- X2 + x(a) Z2
+	gf2Add2(x2, r, ec->f);
+	// r <- x(b) = X1 x(a) Z2 / (x(a) Z1 Z2)
+	qrMul(r, r, x1, ec->f, stack);
+	qrMul(r, r, t1, ec->f, stack);
+	// x1 <- X1 + x(a) Z1
+	qrMul(t2, ecX(a), x1 + n, ec->f, stack);
+	gf2Add2(x1, t2, ec->f);
+	// x2 <- (X1 + x(a) Z1)(X2 + x(a) Z2) + (x(a)^2 + y(a)) Z1 Z2
+	qrMul(x2, x2, x1, ec->f, stack);
+	qrSqr(t2, ecX(a), ec->f, stack);
+	gf2Add2(t2, ecY(a, n), ec->f);
+	qrMul(t2, t2, x1 + n, ec->f, stack);
+	qrMul(t2, t2, x2 + n, ec->f, stack);
+	gf2Add2(x2, t2, ec->f);
+	// y(b) <- (x(a) + x(b)) x2 / (x(a) Z1 Z2) + y(a)
+	gf2Add(t2, ecX(a), r, ec->f);
+	qrMul(t2, t2, x2, ec->f, stack);
+	qrMul(t2, t2, t1, ec->f, stack);
+	gf2Add(ecY(b, n), t2, ecY(a, n), ec->f);
+	qrCopy(ecX(b), r, ec->f);
+	return TRUE;
+}
+
+size_t ec2MulALadder_deep(size_t n, size_t ec_d, size_t ec_deep)
+{
+	return utilMax(2,
+		ecMulA_deep(n, ec_d, ec_deep, n + 1),
+		O_OF_W(8 * n + 3) + ec_deep);
+}
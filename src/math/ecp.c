@@ -4,7 +4,7 @@
 \brief Elliptic curves over prime fields
 \project bee2 [cryptographic library]
 \created 2012.06.26
-\version 2023.09.24
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,11 +13,13 @@
 #include "bee2/core/mem.h"
 #include "bee2/core/stack.h"
 #include "bee2/core/util.h"
+#include "bee2/core/word.h"
 #include "bee2/math/ecp.h"
 #include "bee2/math/gfp.h"
 #include "bee2/math/pri.h"
 #include "bee2/math/ww.h"
 #include "bee2/math/zz.h"
+#include "zm_lcl.h"
 
 /*
 *******************************************************************************
@@ -80,6 +82,17 @@ on a 16-bit Microcomputer. Public Key Cryptography, 1998].
 \todo Сравнить dbl-1998-hnm2 с dbl-2001-b, сложность которого
 	3M +5S + 8add + 1*4 + 2*8 + 1*3.
 
+В функции ecpDblNJ() выполняется k-кратное удвоение P <- 2^k P.
+Реализован алгоритм [Itoh K., Takenaka M., Torii N., Temma S., Kurihara Y.
+Fast Implementation of Public-Key Cryptography on a DSP TMS320C6201.
+CHES 1999]: между удвоениями переносится величина W = A Z^4, по которой
+W' = A Z'^4 = 2 (8Y^4) W. Сложность алгоритма:
+	k(4M + 4S) + 1M + 2S + 1*A + k(6add + 3*2 + 1half).
+Удвоение ecpDblJ() выполняется за 4M + 6S (с учетом умножения на A), т.е.
+каждое следующее удвоение серии экономит 2S. При A = -3 величина A Z^4
+не используется и функция ecpDblNJ() не применяется: серия удвоений
+выполняется вызовами ecpDblJA3().
+
 В функции ecpDblAJ() выполняется удвоение P <- 2A. Реализован алгоритм 
 mdbl-2007-bl [Bernstein-Lange, 2007]. Сложность алгоритма:
 	1M + 5S + 7add + 1*8 + 3*2 + 1*3 \approx 6M.
@@ -180,6 +193,49 @@ static size_t ecpToAJ_deep(size_t n, size_t f_deep)
 	return O_OF_W(2 * n) + f_deep;
 }
 
+// [count * 2n]b <- [count * 3n]a (A <- P)
+static bool_t ecpToANJ(word b[], const word a[], size_t count, const ec_o* ec,
+	void* stack)
+{
+	const size_t n = ec->f->n;
+	bool_t ret = TRUE;
+	size_t i;
+	// переменные в stack
+	word* z = (word*)stack;
+	word* t = z + n * count;
+	stack = t + n * count;
+	// pre
+	ASSERT(ecIsOperable(ec) && ec->d == 3);
+	ASSERT(wwIsDisjoint2(a, 3 * n * count, b, 2 * n * count));
+	// z[i] <- za[i]
+	for (i = 0; i < count; ++i)
+	{
+		ASSERT(ecpSeemsOn3(a + 3 * n * i, ec));
+		qrCopy(z + n * i, ecZ(a + 3 * n * i, n), ec->f);
+	}
+	// t[i] <- z[i]^{-1}
+	qrInvBatch(t, z, count, ec->f, stack);
+	// b[i] <- a[i]
+	for (i = 0; i < count; ++i, a += 3 * n, b += 2 * n)
+	{
+		// a[i] == O => b[i] не определена
+		if (qrIsZero(ecZ(a, n), ec->f))
+		{
+			ret = FALSE;
+			continue;
+		}
+		// z[i] <- t[i]^2
+		qrSqr(z + n * i, t + n * i, ec->f, stack);
+		// xb[i] <- xa[i] z[i]
+		qrMul(ecX(b), ecX(a), z + n * i, ec->f, stack);
+		// z[i] <- t[i] z[i]
+		qrMul(z + n * i, t + n * i, z + n * i, ec->f, stack);
+		// yb[i] <- ya[i] z[i]
+		qrMul(ecY(b, n), ecY(a, n), z + n * i, ec->f, stack);
+	}
+	return ret;
+}
+
 // [3n]b <- -[3n]a (P <- -P)
 static void ecpNegJ(word b[], const word a[], const ec_o* ec, void* stack)
 {
@@ -324,6 +380,79 @@ static size_t ecpDblJA3_deep(size_t n, size_t f_deep)
 	return O_OF_W(2 * n) + f_deep;
 }
 
+// [3n]b <- 2^k[3n]a (P <- 2^k P)
+static void ecpDblNJ(word b[], const word a[], size_t k, const ec_o* ec,
+	void* stack)
+{
+	const size_t n = ec->f->n;
+	// переменные в stack
+	word* t1 = (word*)stack;
+	word* t2 = t1 + n;
+	word* w = t2 + n;
+	stack = w + n;
+	// pre
+	ASSERT(ecIsOperable(ec) && ec->d == 3);
+	ASSERT(ecpSeemsOn3(a, ec));
+	ASSERT(wwIsSameOrDisjoint(a, b, 3 * n));
+	// za == 0? => b <- O
+	if (qrIsZero(ecZ(a, n), ec->f))
+	{
+		qrSetZero(ecZ(b, n), ec->f);
+		return;
+	}
+	// b <- a
+	wwCopy(b, a, 3 * n);
+	// w <- A zb^4
+	qrSqr(w, ecZ(b, n), ec->f, stack);
+	qrSqr(w, w, ec->f, stack);
+	qrMul(w, ec->A, w, ec->f, stack);
+	// цикл по удвоениям
+	while (k--)
+	{
+		// yb == 0? => b <- O
+		if (qrIsZero(ecY(b, n), ec->f))
+		{
+			qrSetZero(ecZ(b, n), ec->f);
+			return;
+		}
+		// zb <- 2 yb zb
+		qrMul(ecZ(b, n), ecY(b, n), ecZ(b, n), ec->f, stack);
+		gfpDouble(ecZ(b, n), ecZ(b, n), ec->f);
+		// t1 <- 3 xb^2 + w
+		qrSqr(t2, ecX(b), ec->f, stack);
+		zmAdd(t1, t2, w, ec->f);
+		gfpDouble(t2, t2, ec->f);
+		zmAdd(t1, t1, t2, ec->f);
+		// yb <- (2 yb)^2
+		gfpDouble(ecY(b, n), ecY(b, n), ec->f);
+		qrSqr(ecY(b, n), ecY(b, n), ec->f, stack);
+		// t2 <- yb^2 / 2 (= 8 ya^4)
+		qrSqr(t2, ecY(b, n), ec->f, stack);
+		gfpHalf(t2, t2, ec->f);
+		// yb <- yb xb (= 4 xa ya^2)
+		qrMul(ecY(b, n), ecY(b, n), ecX(b), ec->f, stack);
+		// w <- 2 t2 w
+		if (k)
+		{
+			qrMul(w, t2, w, ec->f, stack);
+			gfpDouble(w, w, ec->f);
+		}
+		// xb <- t1^2 - 2 yb
+		qrSqr(ecX(b), t1, ec->f, stack);
+		zmSub(ecX(b), ecX(b), ecY(b, n), ec->f);
+		zmSub(ecX(b), ecX(b), ecY(b, n), ec->f);
+		// yb <- (yb - xb) t1 - t2
+		zmSub(ecY(b, n), ecY(b, n), ecX(b), ec->f);
+		qrMul(ecY(b, n), ecY(b, n), t1, ec->f, stack);
+		zmSub(ecY(b, n), ecY(b, n), t2, ec->f);
+	}
+}
+
+static size_t ecpDblNJ_deep(size_t n, size_t f_deep)
+{
+	return O_OF_W(3 * n) + f_deep;
+}
+
 // [3n]b <- 2[2n]a (P <- 2A)
 static void ecpDblAJ(word b[], const word a[], const ec_o* ec, void* stack)
 {
@@ -801,6 +930,306 @@ size_t ecpTplJA3_deep(size_t n, size_t f_deep)
 	return O_OF_W(7 * n) + f_deep;
 }
 
+/*
+*******************************************************************************
+Фиксированные размерности
+
+Для кривых с A = -3 над полями с редукцией Крэндалла при длине модуля
+192, 256, 384 и 512 битов (к ним относятся стандартные кривые
+СТБ 34.101.45, в том числе кривая bign-curve96v1 пониженной стойкости)
+функции удвоения, сложения и вычитания реализуются отдельно для каждой длины.
+В этих функциях умножения и возведения в квадрат вызываются напрямую
+(функции zmMulCrandXXX(), zmSqrCrandXXX() из zm_lcl.h) без обращения
+к указателям qr_o::mul, qr_o::sqr, а длина элементов поля является
+константой. Алгоритмы и раскладка стека такие же, как в ecpDblJA3(),
+ecpAddJ(), ecpAddAJ(), ecpSubJ(), ecpSubAJ(). При совпадении слагаемых
+в сложениях вызываются специализированные удвоения.
+
+Сложения, результаты которых используются только как сомножители,
+выполняются лениво (_ECP_ADDL, функции zmAddLazyXXX()): результат
+не приводится к вычету, меньшему модуля. Ленивые сложения не применяются
+к координатам результата и к слагаемым последующих сложений и вычитаний.
+
+Специализированные функции устанавливаются в ecpCreateJ(), если A = -3
+и f->mul == zmMulCrandXXX.
+
+При сборке с директивой BEE2_INSTRUMENT операции в поле, выполняемые
+специализированными функциями напрямую, минуя интерфейсы qr_o,
+учитываются в тех же счетчиках, что и вызовы через интерфейсы
+(см. opcnt.h).
+*******************************************************************************
+*/
+
+#if (B_PER_W == 32 || B_PER_W == 64)
+
+#ifdef BEE2_INSTRUMENT
+
+#define _ECP_MUL(bits, c, a, b)\
+	(opcntInc(qr_mul), zmMulCrand##bits(c, a, b, ec->f, stack))
+
+#define _ECP_SQR(bits, b, a)\
+	(opcntInc(qr_sqr), zmSqrCrand##bits(b, a, ec->f, stack))
+
+#define _ECP_ADD(bits, c, a, b)\
+	(opcntInc(qr_add), zmAddMod##bits(c, a, b, ec->f->mod))
+
+#define _ECP_ADDL(bits, c, a, b)\
+	(opcntInc(qr_add), zmAddLazy##bits(c, a, b, ec->f->mod))
+
+#define _ECP_SUB(bits, c, a, b)\
+	(opcntInc(qr_sub), zmSubCrand##bits(c, a, b, ec->f->mod))
+
+#else
+
+#define _ECP_MUL(bits, c, a, b)\
+	zmMulCrand##bits(c, a, b, ec->f, stack)
+
+#define _ECP_SQR(bits, b, a)\
+	zmSqrCrand##bits(b, a, ec->f, stack)
+
+#define _ECP_ADD(bits, c, a, b)\
+	zmAddMod##bits(c, a, b, ec->f->mod)
+
+#define _ECP_ADDL(bits, c, a, b)\
+	zmAddLazy##bits(c, a, b, ec->f->mod)
+
+#define _ECP_SUB(bits, c, a, b)\
+	zmSubCrand##bits(c, a, b, ec->f->mod)
+
+#endif /* BEE2_INSTRUMENT */
+
+#define ECP_FIX(bits)\
+static void ecpDblJA3_##bits(word b[], const word a[], const ec_o* ec,\
+	void* stack)\
+{\
+	const size_t n = bits / B_PER_W;\
+	word* t1 = (word*)stack;\
+	word* t2 = t1 + n;\
+	stack = t2 + n;\
+	ASSERT(ecIsOperable(ec) && ec->d == 3 && ec->f->n == n);\
+	ASSERT(ecpSeemsOn3(a, ec));\
+	ASSERT(wwIsSameOrDisjoint(a, b, 3 * n));\
+	if (wwIsZero(ecZ(a, n), n) || wwIsZero(ecY(a, n), n))\
+	{\
+		wwSetZero(ecZ(b, n), n);\
+		return;\
+	}\
+	_ECP_SQR(bits, t1, ecZ(a, n));\
+	_ECP_MUL(bits, ecZ(b, n), ecY(a, n), ecZ(a, n));\
+	_ECP_ADD(bits, ecZ(b, n), ecZ(b, n), ecZ(b, n));\
+	_ECP_SUB(bits, t2, ecX(a), t1);\
+	_ECP_ADDL(bits, t1, ecX(a), t1);\
+	_ECP_MUL(bits, t2, t1, t2);\
+	_ECP_ADD(bits, t1, t2, t2);\
+	_ECP_ADDL(bits, t1, t1, t2);\
+	_ECP_ADDL(bits, ecY(b, n), ecY(a, n), ecY(a, n));\
+	_ECP_SQR(bits, ecY(b, n), ecY(b, n));\
+	_ECP_SQR(bits, t2, ecY(b, n));\
+	zmHalfMod##bits(t2, t2, ec->f->mod);\
+	_ECP_MUL(bits, ecY(b, n), ecY(b, n), ecX(a));\
+	_ECP_SQR(bits, ecX(b), t1);\
+	_ECP_SUB(bits, ecX(b), ecX(b), ecY(b, n));\
+	_ECP_SUB(bits, ecX(b), ecX(b), ecY(b, n));\
+	_ECP_SUB(bits, ecY(b, n), ecY(b, n), ecX(b));\
+	_ECP_MUL(bits, ecY(b, n), ecY(b, n), t1);\
+	_ECP_SUB(bits, ecY(b, n), ecY(b, n), t2);\
+}\
+\
+static void ecpAddJ_##bits(word c[], const word a[], const word b[],\
+	const ec_o* ec, void* stack)\
+{\
+	const size_t n = bits / B_PER_W;\
+	word* t1 = (word*)stack;\
+	word* t2 = t1 + n;\
+	word* t3 = t2 + n;\
+	word* t4 = t3 + n;\
+	stack = t4 + n;\
+	ASSERT(ecIsOperable(ec) && ec->d == 3 && ec->f->n == n);\
+	ASSERT(ecpSeemsOn3(a, ec));\
+	ASSERT(ecpSeemsOn3(b, ec));\
+	ASSERT(wwIsSameOrDisjoint(a, c, 3 * n));\
+	ASSERT(wwIsSameOrDisjoint(b, c, 3 * n));\
+	if (wwIsZero(ecZ(a, n), n))\
+	{\
+		wwCopy(c, b, 3 * n);\
+		return;\
+	}\
+	if (wwIsZero(ecZ(b, n), n))\
+	{\
+		wwCopy(c, a, 3 * n);\
+		return;\
+	}\
+	_ECP_SQR(bits, t1, ecZ(a, n));\
+	_ECP_SQR(bits, t2, ecZ(b, n));\
+	_ECP_MUL(bits, t3, ecZ(b, n), t2);\
+	_ECP_MUL(bits, t3, ecY(a, n), t3);\
+	_ECP_MUL(bits, t4, ecZ(a, n), t1);\
+	_ECP_MUL(bits, t4, ecY(b, n), t4);\
+	_ECP_ADDL(bits, ecZ(c, n), ecZ(a, n), ecZ(b, n));\
+	_ECP_SQR(bits, ecZ(c, n), ecZ(c, n));\
+	_ECP_SUB(bits, ecZ(c, n), ecZ(c, n), t1);\
+	_ECP_SUB(bits, ecZ(c, n), ecZ(c, n), t2);\
+	_ECP_MUL(bits, t1, ecX(b), t1);\
+	_ECP_MUL(bits, t2, ecX(a), t2);\
+	_ECP_SUB(bits, t1, t1, t2);\
+	if (wwIsZero(t1, n))\
+	{\
+		if (wwEq(t3, t4, n))\
+			ecpDblJA3_##bits(c, c == a ? b : a, ec, stack);\
+		else\
+			wwSetZero(ecZ(c, n), n);\
+		return;\
+	}\
+	_ECP_MUL(bits, ecZ(c, n), ecZ(c, n), t1);\
+	_ECP_SUB(bits, t4, t4, t3);\
+	_ECP_ADDL(bits, t4, t4, t4);\
+	_ECP_ADDL(bits, ecY(c, n), t1, t1);\
+	_ECP_SQR(bits, ecY(c, n), ecY(c, n));\
+	_ECP_MUL(bits, t1, t1, ecY(c, n));\
+	_ECP_MUL(bits, ecY(c, n), t2, ecY(c, n));\
+	_ECP_ADD(bits, t2, ecY(c, n), ecY(c, n));\
+	_ECP_SQR(bits, ecX(c), t4);\
+	_ECP_SUB(bits, ecX(c), ecX(c), t1);\
+	_ECP_SUB(bits, ecX(c), ecX(c), t2);\
+	_ECP_SUB(bits, ecY(c, n), ecY(c, n), ecX(c));\
+	_ECP_MUL(bits, ecY(c, n), t4, ecY(c, n));\
+	_ECP_ADDL(bits, t3, t3, t3);\
+	_ECP_MUL(bits, t3, t3, t1);\
+	_ECP_SUB(bits, ecY(c, n), ecY(c, n), t3);\
+}\
+\
+static void ecpAddAJ_##bits(word c[], const word a[], const word b[],\
+	const ec_o* ec, void* stack)\
+{\
+	const size_t n = bits / B_PER_W;\
+	word* t1 = (word*)stack;\
+	word* t2 = t1 + n;\
+	word* t3 = t2 + n;\
+	word* t4 = t3 + n;\
+	stack = t4 + n;\
+	ASSERT(ecIsOperable(ec) && ec->d == 3 && ec->f->n == n);\
+	ASSERT(ecpSeemsOn3(a, ec));\
+	ASSERT(ecpSeemsOnA(b, ec));\
+	ASSERT(wwIsSameOrDisjoint(a,  c, 3 * n));\
+	ASSERT(b == c || wwIsDisjoint2(b, 2 * n, c, 3 * n));\
+	if (wwIsZero(ecZ(a, n), n))\
+	{\
+		wwCopy(ecX(c), ecX(b), n);\
+		wwCopy(ecY(c, n), ecY(b, n), n);\
+		wwCopy(ecZ(c, n), ec->f->unity, n);\
+		return;\
+	}\
+	_ECP_SQR(bits, t1, ecZ(a, n));\
+	_ECP_MUL(bits, t2, t1, ecZ(a, n));\
+	_ECP_MUL(bits, t1, t1, ecX(b));\
+	_ECP_MUL(bits, t2, t2, ecY(b, n));\
+	_ECP_SUB(bits, t1, t1, ecX(a));\
+	_ECP_SUB(bits, t2, t2, ecY(a, n));\
+	if (wwIsZero(t1, n))\
+	{\
+		if (wwIsZero(t2, n))\
+			ecpDblAJ(c, b, ec, stack);\
+		else\
+			wwSetZero(ecZ(c, n), n);\
+		return;\
+	}\
+	_ECP_MUL(bits, ecZ(c, n), t1, ecZ(a, n));\
+	_ECP_SQR(bits, t3, t1);\
+	_ECP_MUL(bits, t4, t1, t3);\
+	_ECP_MUL(bits, t3, t3, ecX(a));\
+	_ECP_ADD(bits, t1, t3, t3);\
+	_ECP_SQR(bits, ecX(c), t2);\
+	_ECP_SUB(bits, ecX(c), ecX(c), t1);\
+	_ECP_SUB(bits, ecX(c), ecX(c), t4);\
+	_ECP_SUB(bits, t3, t3, ecX(c));\
+	_ECP_MUL(bits, t3, t3, t2);\
+	_ECP_MUL(bits, t4, t4, ecY(a, n));\
+	_ECP_SUB(bits, ecY(c, n), t3, t4);\
+}\
+\
+static void ecpSubJ_##bits(word c[], const word a[], const word b[],\
+	const ec_o* ec, void* stack)\
+{\
+	const size_t n = bits / B_PER_W;\
+	word* t = (word*)stack;\
+	stack = t + 3 * n;\
+	ASSERT(ecIsOperable(ec) && ec->d == 3 && ec->f->n == n);\
+	ASSERT(wwIsSameOrDisjoint(a, c, 3 * n));\
+	ASSERT(wwIsSameOrDisjoint(b, c, 3 * n));\
+	wwCopy(ecX(t), ecX(b), n);\
+	zmNeg(ecY(t, n), ecY(b, n), ec->f);\
+	wwCopy(ecZ(t, n), ecZ(b, n), n);\
+	ecpAddJ_##bits(c, a, t, ec, stack);\
+}\
+\
+static void ecpSubAJ_##bits(word c[], const word a[], const word b[],\
+	const ec_o* ec, void* stack)\
+{\
+	const size_t n = bits / B_PER_W;\
+	word* t = (word*)stack;\
+	stack = t + 2 * n;\
+	ASSERT(ecIsOperable(ec) && ec->d == 3 && ec->f->n == n);\
+	ASSERT(wwIsSameOrDisjoint(a,  c, 3 * n));\
+	ASSERT(b == c || wwIsDisjoint2(b, 2 * n, c, 3 * n));\
+	wwCopy(ecX(t), ecX(b), n);\
+	zmNeg(ecY(t, n), ecY(b, n), ec->f);\
+	ecpAddAJ_##bits(c, a, t, ec, stack);\
+}\
+
+#define ECP_ISONA_FIX(bits)\
+static bool_t ecpIsOnA_##bits(const word a[], const ec_o* ec, void* stack)\
+{\
+	const size_t n = bits / B_PER_W;\
+	word* t1 = (word*)stack;\
+	word* t2 = t1 + n;\
+	stack = t2 + n;\
+	ASSERT(ecIsOperable(ec) && ec->f->n == n);\
+	if (!zmIsIn(ecX(a), ec->f) || !zmIsIn(ecY(a, n), ec->f))\
+		return FALSE;\
+	_ECP_SQR(bits, t1, ecX(a));\
+	_ECP_ADD(bits, t1, t1, ec->A);\
+	_ECP_MUL(bits, t1, t1, ecX(a));\
+	_ECP_ADD(bits, t1, t1, ec->B);\
+	_ECP_SQR(bits, t2, ecY(a, n));\
+	return wwEq(t1, t2, n);\
+}\
+
+ECP_FIX(192)
+ECP_FIX(256)
+ECP_FIX(384)
+ECP_FIX(512)
+
+ECP_ISONA_FIX(192)
+ECP_ISONA_FIX(256)
+ECP_ISONA_FIX(384)
+ECP_ISONA_FIX(512)
+
+static void ecpFixJA3(ec_o* ec)
+{
+	if (ec->f->mul == zmMulCrand192)
+		ec->add = ecpAddJ_192, ec->adda = ecpAddAJ_192,
+		ec->sub = ecpSubJ_192, ec->suba = ecpSubAJ_192,
+		ec->dbl = ecpDblJA3_192;
+	else if (ec->f->mul == zmMulCrand256)
+		ec->add = ecpAddJ_256, ec->adda = ecpAddAJ_256,
+		ec->sub = ecpSubJ_256, ec->suba = ecpSubAJ_256,
+		ec->dbl = ecpDblJA3_256;
+	else if (ec->f->mul == zmMulCrand384)
+		ec->add = ecpAddJ_384, ec->adda = ecpAddAJ_384,
+		ec->sub = ecpSubJ_384, ec->suba = ecpSubAJ_384,
+		ec->dbl = ecpDblJA3_384;
+	else if (ec->f->mul == zmMulCrand512)
+		ec->add = ecpAddJ_512, ec->adda = ecpAddAJ_512,
+		ec->sub = ecpSubJ_512, ec->suba = ecpSubAJ_512,
+		ec->dbl = ecpDblJA3_512;
+}
+
+#else
+
+#define ecpFixJA3(ec)
+
+#endif
+
 bool_t ecpCreateJ(ec_o* ec, const qr_o* f, const octet A[], const octet B[], 
 	void* stack)
 {
@@ -838,6 +1267,7 @@ bool_t ecpCreateJ(ec_o* ec, const qr_o* f, const octet A[], const octet B[],
 	// настроить интерфейсы
 	ec->froma = ecpFromAJ;
 	ec->toa = ecpToAJ;
+	ec->toan = ecpToANJ;
 	ec->neg = ecpNegJ;
 	ec->add = ecpAddJ;
 	ec->adda = ecpAddAJ;
@@ -845,8 +1275,11 @@ bool_t ecpCreateJ(ec_o* ec, const qr_o* f, const octet A[], const octet B[],
 	ec->suba = ecpSubAJ;
 	ec->dbl = bA3 ? ecpDblJA3 : ecpDblJ;
 	ec->dbla = ecpDblAJ;
+	ec->dbln = bA3 ? 0 : ecpDblNJ;
 	ec->tpl = bA3 ? ecpTplJA3 : ecpTplJ;
-	ec->deep = utilMax(8,
+	if (bA3)
+		ecpFixJA3(ec);
+	ec->deep = utilMax(9,
 		ecpToAJ_deep(f->n, f->deep),
 		ecpAddJ_deep(f->n, f->deep),
 		ecpAddAJ_deep(f->n, f->deep),
@@ -854,6 +1287,7 @@ bool_t ecpCreateJ(ec_o* ec, const qr_o* f, const octet A[], const octet B[],
 		ecpSubAJ_deep(f->n, f->deep),
 		bA3 ? ecpDblJA3_deep(f->n, f->deep) : ecpDblJ_deep(f->n, f->deep),
 		ecpDblAJ_deep(f->n, f->deep),
+		bA3 ? 0 : ecpDblNJ_deep(f->n, f->deep),
 		bA3 ? ecpTplJA3_deep(f->n, f->deep) : ecpTplJ_deep(f->n, f->deep));
 	// настроить
 	ec->hdr.keep = sizeof(ec_o) + O_OF_W(5 * f->n + 1);
@@ -871,7 +1305,7 @@ size_t ecpCreateJ_keep(size_t n)
 
 size_t ecpCreateJ_deep(size_t n, size_t f_deep)
 {
-	return utilMax(11,
+	return utilMax(12,
 		O_OF_W(n),
 		ecpToAJ_deep(n, f_deep),
 		ecpAddJ_deep(n, f_deep),
@@ -880,6 +1314,7 @@ size_t ecpCreateJ_deep(size_t n, size_t f_deep)
 		ecpSubAJ_deep(n, f_deep),
 		ecpDblJ_deep(n, f_deep),
 		ecpDblJA3_deep(n, f_deep),
+		ecpDblNJ_deep(n, f_deep),
 		ecpDblAJ_deep(n, f_deep),
 		ecpTplJ_deep(n, f_deep),
 		ecpTplJA3_deep(n, f_deep));
@@ -1073,6 +1508,53 @@ size_t ecpIsOnA_deep(size_t n, size_t f_deep)
 	return O_OF_W(2 * n) + f_deep;
 }
 
+/*
+*******************************************************************************
+Пакетная проверка принадлежности
+
+В ecpIsOnABatch() проверки выполняются так же, как в ecpIsOnA(), но для
+полей с редукцией Крэндалла при длине модуля 192, 256, 384 и 512 битов
+умножения и возведения в квадрат вызываются напрямую (функции
+ecpIsOnA_XXX(), см. ECP_ISONA_FIX), а длина элементов поля является
+константой. Выбор реализации выполняется однократно для всего пакета.
+Проверяются открытые данные, поэтому точки сравниваются функцией wwEq().
+*******************************************************************************
+*/
+
+size_t ecpIsOnABatch(bool_t rets[], const word a[], size_t count,
+	const ec_o* ec, void* stack)
+{
+	const size_t n = ec->f->n;
+	bool_t (*is_on)(const word a[], const ec_o* ec, void* stack) = ecpIsOnA;
+	size_t valid = 0;
+	size_t i;
+	// pre
+	ASSERT(ecIsOperable(ec));
+	ASSERT(memIsValid(rets, count * sizeof(bool_t)));
+	ASSERT(wwIsValid(a, 2 * n * count));
+	// выбрать реализацию
+#if (B_PER_W == 32 || B_PER_W == 64)
+	if (ec->f->mul == zmMulCrand192)
+		is_on = ecpIsOnA_192;
+	else if (ec->f->mul == zmMulCrand256)
+		is_on = ecpIsOnA_256;
+	else if (ec->f->mul == zmMulCrand384)
+		is_on = ecpIsOnA_384;
+	else if (ec->f->mul == zmMulCrand512)
+		is_on = ecpIsOnA_512;
+#endif
+	// проверить точки
+	for (i = 0; i < count; ++i, a += 2 * n)
+		if ((rets[i] = is_on(a, ec, stack)))
+			++valid;
+	return valid;
+}
+
+size_t ecpIsOnABatch_deep(size_t n, size_t f_deep)
+{
+	return ecpIsOnA_deep(n, f_deep);
+}
+
 void ecpNegA(word b[], const word a[], const ec_o* ec)
 {
 	const size_t n = ec->f->n;
@@ -1203,21 +1685,51 @@ size_t ecpSubAA_deep(size_t n, size_t f_deep)
 *******************************************************************************
 Алгоритм SWU
 
+Пусть t = -a^2, N = -B(1 + t + t^2), D = A(t + t^2). В алгоритме SWU
+определяются x1 = N / D (x1 = 0, если D = 0), y = x1^3 + A x1 + B,
+x2 = x1 t, а также c = y^{(3p - 5) / 4}. По c проверяется, является ли y
+квадратичным вычетом (c^2 y = 1), и определяются квадратные корни из y или
+из x2^3 + A x2 + B.
+
+В прямолинейной реализации выполняются два возведения в степень:
+D^{p - 2} и y^{(3p - 5) / 4}. Они объединяются в одно. Пусть D != 0,
+U = N^3 + A N D^2 + B D^3, так что y = U / D^3. Пусть z = U D (z = D,
+если U = 0) и h = z^{(p - 3) / 4}. Тогда по малой теореме Ферма
+	1 / z = h^4 z,
+	1 / D = U / z (1 / D = 1 / z, если U = 0),
+	c = h^3 z D^2 (c = 0, если U = 0).
+Если D = 0, то вместо (N, D) используется (0, 1): при этом x1 = 0 и c
+рассчитывается по тем же формулам.
+
 \todo Регуляризировать (qrIsUnitySafe).
 *******************************************************************************
 */
 
+/*	a <- mask ? b : a. */
+static void ecpSWUSel(word a[], const word b[], register word mask, size_t n)
+{
+	size_t i;
+	for (i = 0; i < n; ++i)
+		a[i] ^= mask & (a[i] ^ b[i]);
+}
+
 void ecpSWU(word b[], const word a[], const ec_o* ec, void* stack)
 {
 	const size_t n = ec->f->n;
 	register size_t mask;
+	register word mask1;
+	size_t i;
 	// переменные в stack [x2 после x1, s после y!]
 	word* t = (word*)stack;
 	word* x1 = t + n;
 	word* x2 = x1 + n;
 	word* y = x2 + n;
 	word* s = y + n; 
-	stack = s + n;
+	word* u = s + n;
+	word* z = u + n;
+	word* h = z + n;
+	word* c = h + n;
+	stack = c + n;
 	// pre
 	ASSERT(ecIsOperable(ec));
 	ASSERT(zmIsIn(a, ec->f));
@@ -1226,18 +1738,51 @@ void ecpSWU(word b[], const word a[], const ec_o* ec, void* stack)
 	// t <- -a^2
 	qrSqr(t, a, ec->f, stack);
 	zmNeg(t, t, ec->f);
-	// s <- p - 2
-	wwCopy(s, ec->f->mod, n);
-	zzSubW2(s, n, 2);
-	// x1 <- -B(1 + t + t^2)(A(t + t^2))^{p - 2} 
+	// x1 <- D = A(t + t^2), y <- N = -B(1 + t + t^2)
 	qrSqr(x2, t, ec->f, stack);
 	qrAdd(x2, x2, t, ec->f);
 	qrMul(x1, x2, ec->A, ec->f, stack);
-	qrPower(x1, x1, s, n, ec->f, stack);
 	qrAddUnity(x2, x2, ec->f);
-	qrMul(x1, x1, x2, ec->f, stack);
-	qrMul(x1, x1, ec->B, ec->f, stack);
-	zmNeg(x1, x1, ec->f);
+	qrMul(y, x2, ec->B, ec->f, stack);
+	zmNeg(y, y, ec->f);
+	// D == 0 => (N, D) <- (0, 1)
+	mask1 = WORD_0 - (word)qrIsZero(x1, ec->f);
+	ecpSWUSel(x1, ec->f->unity, mask1, n);
+	for (i = 0; i < n; ++i)
+		y[i] &= ~mask1;
+	// u <- U = N^3 + A N D^2 + B D^3
+	qrSqr(s, x1, ec->f, stack);
+	qrMul(u, y, ec->A, ec->f, stack);
+	qrMul(u, u, s, ec->f, stack);
+	qrMul(z, s, x1, ec->f, stack);
+	qrMul(z, z, ec->B, ec->f, stack);
+	qrAdd(u, u, z, ec->f);
+	qrSqr(z, y, ec->f, stack);
+	qrMul(z, z, y, ec->f, stack);
+	qrAdd(u, u, z, ec->f);
+	// z <- U D, U == 0 => z <- D
+	mask1 = WORD_0 - (word)qrIsZero(u, ec->f);
+	qrMul(z, u, x1, ec->f, stack);
+	ecpSWUSel(z, x1, mask1, n);
+	// h <- z^{(p - 3) / 4}
+	wwCopy(s, ec->f->mod, n);
+	wwShLo(s, n, 2);
+	qrPower(h, z, s, n, ec->f, stack);
+	// c <- h^3 z D^2, U == 0 => c <- 0
+	qrSqr(s, h, ec->f, stack);
+	qrMul(c, s, h, ec->f, stack);
+	qrMul(c, c, z, ec->f, stack);
+	qrMul(c, c, x1, ec->f, stack);
+	qrMul(c, c, x1, ec->f, stack);
+	for (i = 0; i < n; ++i)
+		c[i] &= ~mask1;
+	// s <- 1 / z = h^4 z, h <- 1 / D = U / z (U == 0 => h <- 1 / z)
+	qrSqr(s, s, ec->f, stack);
+	qrMul(s, s, z, ec->f, stack);
+	qrMul(h, s, u, ec->f, stack);
+	ecpSWUSel(h, s, mask1, n);
+	// x1 <- N / D
+	qrMul(x1, y, h, ec->f, stack);
 	// y <- (x1)^3 + A x1 + B
 	qrSqr(x2, x1, ec->f, stack);
 	qrMul(x2, x2, x1, ec->f, stack);
@@ -1246,11 +1791,8 @@ void ecpSWU(word b[], const word a[], const ec_o* ec, void* stack)
 	qrAdd(y, y, ec->B, ec->f);
 	// x2 <- x1 t
 	qrMul(x2, x1, t, ec->f, stack);
-	// t <- y^{(p - 1) - (p + 1) / 4} = y^{s - (p - 3) / 4}
-	wwCopy(t, ec->f->mod, n);
-	wwShLo(t, n, 2);
-	zzSub(s, s, t, n);
-	qrPower(t, y, s, n, ec->f, stack);
+	// t <- c = y^{(p - 1) - (p + 1) / 4}
+	qrCopy(t, c, ec->f);
 	// s <- a^3 y
 	qrSqr(s, a, ec->f, stack);
 	qrMul(s, s, a, ec->f, stack);
@@ -1263,13 +1805,550 @@ void ecpSWU(word b[], const word a[], const ec_o* ec, void* stack)
 	qrCopy(ecX(b), x1 + (mask & n), ec->f);
 	qrMul(ecY(b, n), t, y + (mask & n), ec->f, stack);
 	// очистка
-	mask = 0;
+	mask = 0, mask1 = 0;
 }
 
 size_t ecpSWU_deep(size_t n, size_t f_deep)
 {
-	return O_OF_W(5 * n) + 
+	return O_OF_W(9 * n) + 
 		utilMax(2,
 			f_deep,
 			qrPower_deep(n, n, f_deep));
 }
+
+/*
+*******************************************************************************
+Сжатие точек
+
+Аффинная точка (x, y) сжимается до пары (x, ybit), где ybit -- младший бит
+числа, которое представляет y. По x определяется y^2 = x^3 + A x + B и
+извлекается квадратный корень. Если четность корня не совпадает с ybit,
+то корень заменяется на противоположный.
+*******************************************************************************
+*/
+
+bool_t ecpDecompress(word b[], const word x[], bool_t ybit, const ec_o* ec,
+	void* stack)
+{
+	const size_t n = ec->f->n;
+	// переменные в stack
+	word* y = (word*)stack;
+	octet* o = (octet*)(y + n);
+	stack = o + O_OF_W(n);
+	// pre
+	ASSERT(ecIsOperable(ec));
+	ASSERT(zmIsIn(x, ec->f));
+	ASSERT(x == b || wwIsDisjoint2(x, n, b, 2 * n));
+	// y <- x^3 + A x + B
+	qrCopy(ecX(b), x, ec->f);
+	qrSqr(y, ecX(b), ec->f, stack);
+	qrMul(y, y, ecX(b), ec->f, stack);
+	qrMul(ecY(b, n), ecX(b), ec->A, ec->f, stack);
+	qrAdd(y, y, ecY(b, n), ec->f);
+	qrAdd(y, y, ec->B, ec->f);
+	// y <- \sqrt(y)
+	if (!gfpSqrt(ecY(b, n), y, ec->f, stack))
+		return FALSE;
+	// скорректировать четность
+	qrTo(o, ecY(b, n), ec->f, stack);
+	if ((o[0] & 1) != (ybit ? 1 : 0))
+	{
+		if (qrIsZero(ecY(b, n), ec->f))
+			return FALSE;
+		zmNeg(ecY(b, n), ecY(b, n), ec->f);
+	}
+	return TRUE;
+}
+
+size_t ecpDecompress_deep(size_t n, size_t f_deep)
+{
+	return O_OF_W(2 * n) +
+		utilMax(2,
+			f_deep,
+			gfpSqrt_deep(n, f_deep));
+}
+
+/*
+*******************************************************************************
+Восемь сумм кратных
+
+Координаты точек 8 дорожек хранятся в 8-наборах (см. zm8Start()).
+Проективная точка задается 8-наборами X, Y, Z, которые размещаются
+подряд, аффинная -- 8-наборами X, Y.
+
+Удвоения и сложения:
+-	ecp8DblJA3(): P <- 2P при A = -3 (dbl-2001-b), 3M + 5S;
+-	ecp8DblJ(): P <- 2P (dbl-2007-bl), 1M + 8S + 1*A;
+-	ecp8AddJ(): P <- P + P (add-2007-bl), 11M + 5S;
+-	ecp8AddAJ(): P <- P + A (madd-2007-bl), 7M + 4S.
+В сложениях не проверяется, совпадают ли слагаемые и равны ли они O.
+Вместо этого возвращается маска дорожек, в которых H = 0 (слагаемые
+совпадают или противоположны). Дорожки, в которых накопитель равен O,
+отслеживаются маской inf: в них вместо сложения выполняется
+присваивание.
+
+В ecpCombAddMulA8() цепочка удвоений строится так же, как в
+ecCombAddMulA(). На позиции pos обрабатываются столбец pos гребенки d_j
+(если pos < s) и символ с номером pos / ECP8_W представления e_j
+(если pos делится на ECP8_W). Представление e_j состоит из символов
+из интервала [-2^{ECP8_W - 1}, 2^{ECP8_W - 1}] (знаковые окна
+фиксированной ширины ECP8_W). Позиции символов всех дорожек совпадают.
+В отличие от NAF, где позиции ненулевых символов разных дорожек разные
+и сложения пришлось бы выполнять почти на каждой позиции.
+
+Малые кратные a_j, 2 a_j,..., 2^{ECP8_W - 1} a_j хранятся
+в проективных координатах: переход к аффинным не окупается. Таблица
+гребенки pre переводится в 52-битовые разряды один раз при вызове.
+Из таблиц для каждой дорожки выбирается своя строка.
+*******************************************************************************
+*/
+
+#ifdef U64_SUPPORT
+
+#define ECP8_W 5
+#define ECP8_COUNT (SIZE_1 << (ECP8_W - 1))
+
+static void ecp8DblJA3(u64 b[], const u64 a[], const void* st, u64* t,
+	size_t l8, void* stack)
+{
+	u64* t0 = t;
+	u64* t1 = t0 + l8;
+	u64* t2 = t1 + l8;
+	u64* t3 = t2 + l8;
+	u64* t4 = t3 + l8;
+	// delta <- Z^2, gamma <- Y^2, beta <- X gamma
+	zm8Sqr(t0, a + 2 * l8, st, stack);
+	zm8Sqr(t1, a + l8, st, stack);
+	zm8Mul(t2, a, t1, st, stack);
+	// alpha <- 3 (X - delta)(X + delta)
+	zm8Sub(t3, a, t0, st);
+	zm8Add(t4, a, t0, st);
+	zm8Mul(t3, t3, t4, st, stack);
+	zm8Add(t4, t3, t3, st);
+	zm8Add(t3, t4, t3, st);
+	// Z3 <- (Y + Z)^2 - gamma - delta
+	zm8Add(t4, a + l8, a + 2 * l8, st);
+	zm8Sqr(t4, t4, st, stack);
+	zm8Sub(t4, t4, t1, st);
+	zm8Sub(b + 2 * l8, t4, t0, st);
+	// X3 <- alpha^2 - 8 beta
+	zm8Add(t2, t2, t2, st);
+	zm8Add(t2, t2, t2, st);
+	zm8Sqr(t4, t3, st, stack);
+	zm8Sub(t4, t4, t2, st);
+	zm8Sub(b, t4, t2, st);
+	// Y3 <- alpha (4 beta - X3) - 8 gamma^2
+	zm8Sub(t2, t2, b, st);
+	zm8Mul(t2, t3, t2, st, stack);
+	zm8Sqr(t1, t1, st, stack);
+	zm8Add(t1, t1, t1, st);
+	zm8Add(t1, t1, t1, st);
+	zm8Add(t1, t1, t1, st);
+	zm8Sub(b + l8, t2, t1, st);
+}
+
+static void ecp8DblJ(u64 b[], const u64 a[], const u64 A[], const void* st,
+	u64* t, size_t l8, void* stack)
+{
+	u64* t0 = t;
+	u64* t1 = t0 + l8;
+	u64* t2 = t1 + l8;
+	u64* t3 = t2 + l8;
+	u64* t4 = t3 + l8;
+	u64* t5 = t4 + l8;
+	// XX <- X^2, YY <- Y^2, YYYY <- YY^2, ZZ <- Z^2
+	zm8Sqr(t0, a, st, stack);
+	zm8Sqr(t1, a + l8, st, stack);
+	zm8Sqr(t2, t1, st, stack);
+	zm8Sqr(t3, a + 2 * l8, st, stack);
+	// S <- 2 ((X + YY)^2 - XX - YYYY)
+	zm8Add(t4, a, t1, st);
+	zm8Sqr(t4, t4, st, stack);
+	zm8Sub(t4, t4, t0, st);
+	zm8Sub(t4, t4, t2, st);
+	zm8Add(t4, t4, t4, st);
+	// M <- 3 XX + A ZZ^2
+	zm8Sqr(t5, t3, st, stack);
+	zm8Mul(t5, t5, A, st, stack);
+	zm8Add(t5, t5, t0, st);
+	zm8Add(t5, t5, t0, st);
+	zm8Add(t0, t5, t0, st);
+	// Z3 <- (Y + Z)^2 - YY - ZZ
+	zm8Add(t5, a + l8, a + 2 * l8, st);
+	zm8Sqr(t5, t5, st, stack);
+	zm8Sub(t5, t5, t1, st);
+	zm8Sub(b + 2 * l8, t5, t3, st);
+	// X3 <- M^2 - 2 S
+	zm8Sqr(t5, t0, st, stack);
+	zm8Sub(t5, t5, t4, st);
+	zm8Sub(b, t5, t4, st);
+	// Y3 <- M (S - X3) - 8 YYYY
+	zm8Sub(t4, t4, b, st);
+	zm8Mul(t4, t0, t4, st, stack);
+	zm8Add(t2, t2, t2, st);
+	zm8Add(t2, t2, t2, st);
+	zm8Add(t2, t2, t2, st);
+	zm8Sub(b + l8, t4, t2, st);
+}
+
+static size_t ecp8AddJ(u64 c[], const u64 a[], const u64 b[],
+	const void* st, u64* t, size_t l8, void* stack)
+{
+	size_t mask;
+	u64* t0 = t;
+	u64* t1 = t0 + l8;
+	u64* t2 = t1 + l8;
+	u64* t3 = t2 + l8;
+	u64* t4 = t3 + l8;
+	u64* t5 = t4 + l8;
+	u64* t6 = t5 + l8;
+	// Z1Z1 <- Z1^2, Z2Z2 <- Z2^2, U1 <- X1 Z2Z2, U2 <- X2 Z1Z1
+	zm8Sqr(t0, a + 2 * l8, st, stack);
+	zm8Sqr(t1, b + 2 * l8, st, stack);
+	zm8Mul(t2, a, t1, st, stack);
+	zm8Mul(t3, b, t0, st, stack);
+	// S1 <- Y1 Z2 Z2Z2, S2 <- Y2 Z1 Z1Z1
+	zm8Mul(t4, a + l8, b + 2 * l8, st, stack);
+	zm8Mul(t4, t4, t1, st, stack);
+	zm8Mul(t5, b + l8, a + 2 * l8, st, stack);
+	zm8Mul(t5, t5, t0, st, stack);
+	// H <- U2 - U1
+	zm8Sub(t3, t3, t2, st);
+	mask = zm8Zeros(t3, st);
+	// Z3 <- ((Z1 + Z2)^2 - Z1Z1 - Z2Z2) H
+	zm8Add(t6, a + 2 * l8, b + 2 * l8, st);
+	zm8Sqr(t6, t6, st, stack);
+	zm8Sub(t6, t6, t0, st);
+	zm8Sub(t6, t6, t1, st);
+	zm8Mul(c + 2 * l8, t6, t3, st, stack);
+	// I <- (2 H)^2, J <- H I, r <- 2 (S2 - S1), V <- U1 I
+	zm8Add(t0, t3, t3, st);
+	zm8Sqr(t0, t0, st, stack);
+	zm8Mul(t1, t3, t0, st, stack);
+	zm8Sub(t5, t5, t4, st);
+	zm8Add(t5, t5, t5, st);
+	zm8Mul(t2, t2, t0, st, stack);
+	// X3 <- r^2 - J - 2 V
+	zm8Sqr(t0, t5, st, stack);
+	zm8Sub(t0, t0, t1, st);
+	zm8Sub(t0, t0, t2, st);
+	zm8Sub(c, t0, t2, st);
+	// Y3 <- r (V - X3) - 2 S1 J
+	zm8Sub(t2, t2, c, st);
+	zm8Mul(t2, t5, t2, st, stack);
+	zm8Mul(t4, t4, t1, st, stack);
+	zm8Add(t4, t4, t4, st);
+	zm8Sub(c + l8, t2, t4, st);
+	return mask;
+}
+
+static size_t ecp8AddAJ(u64 c[], const u64 a[], const u64 b[],
+	const void* st, u64* t, size_t l8, void* stack)
+{
+	size_t mask;
+	u64* t0 = t;
+	u64* t1 = t0 + l8;
+	u64* t2 = t1 + l8;
+	u64* t3 = t2 + l8;
+	u64* t4 = t3 + l8;
+	// Z1Z1 <- Z1^2, U2 <- X2 Z1Z1, S2 <- Y2 Z1 Z1Z1
+	zm8Sqr(t0, a + 2 * l8, st, stack);
+	zm8Mul(t1, b, t0, st, stack);
+	zm8Mul(t2, b + l8, a + 2 * l8, st, stack);
+	zm8Mul(t2, t2, t0, st, stack);
+	// H <- U2 - X1, HH <- H^2
+	zm8Sub(t1, t1, a, st);
+	mask = zm8Zeros(t1, st);
+	zm8Sqr(t3, t1, st, stack);
+	// Z3 <- (Z1 + H)^2 - Z1Z1 - HH
+	zm8Add(t4, a + 2 * l8, t1, st);
+	zm8Sqr(t4, t4, st, stack);
+	zm8Sub(t4, t4, t0, st);
+	zm8Sub(c + 2 * l8, t4, t3, st);
+	// I <- 4 HH, J <- H I, r <- 2 (S2 - Y1), V <- X1 I
+	zm8Add(t3, t3, t3, st);
+	zm8Add(t3, t3, t3, st);
+	zm8Mul(t0, t1, t3, st, stack);
+	zm8Sub(t2, t2, a + l8, st);
+	zm8Add(t2, t2, t2, st);
+	zm8Mul(t3, a, t3, st, stack);
+	// t1 <- 2 Y1 J
+	zm8Mul(t1, a + l8, t0, st, stack);
+	zm8Add(t1, t1, t1, st);
+	// X3 <- r^2 - J - 2 V
+	zm8Sqr(t4, t2, st, stack);
+	zm8Sub(t4, t4, t0, st);
+	zm8Sub(t4, t4, t3, st);
+	zm8Sub(c, t4, t3, st);
+	// Y3 <- r (V - X3) - 2 Y1 J
+	zm8Sub(t3, t3, c, st);
+	zm8Mul(t3, t2, t3, st, stack);
+	zm8Sub(c + l8, t3, t1, st);
+	return mask;
+}
+
+/*
+	Загрузка и выгрузка элементов поля: w[j] -- число, которое
+	представляет элемент a + j * step (см. qrTo(), qrFrom()).
+*/
+
+static void ecp8Load(u64 b[], const word a[], size_t step, const ec_o* ec,
+	const void* st, word* w, void* stack)
+{
+	const size_t n = ec->f->n;
+	octet* o = (octet*)(w + 8 * n);
+	size_t j;
+	for (j = 0; j < 8; ++j)
+	{
+		qrTo(o, a + j * step, ec->f, stack);
+		wwFrom(w + j * n, o, ec->f->no);
+	}
+	zm8From(b, w, st, stack);
+}
+
+static void ecp8Store(word b[], size_t step, const u64 a[], size_t mask,
+	const ec_o* ec, const void* st, word* w, void* stack)
+{
+	const size_t n = ec->f->n;
+	octet* o = (octet*)(w + 8 * n);
+	size_t j;
+	zm8To(w, a, st, stack);
+	for (j = 0; j < 8; ++j)
+		if (mask >> j & 1)
+		{
+			wwTo(o, ec->f->no, w + j * n);
+			qrFrom(b + j * step, o, ec->f, stack);
+		}
+}
+
+/*
+	Копирование дорожки j 8-наборов
+*/
+
+static void ecp8Lane(u64 b[], const u64 a[], size_t j, size_t count,
+	size_t l8)
+{
+	size_t i;
+	for (; count--; b += l8, a += l8)
+		for (i = j; i < l8; i += 8)
+			b[i] = a[i];
+}
+
+size_t ecpCombAddMulA8(word b[], const word pre[], const ec_o* ec, size_t w,
+	const word d[], size_t m, const word a[], const word e[], size_t k,
+	void* stack)
+{
+	const size_t n = ec->f->n;
+	const size_t l8 = 8 * zm8Len(n);
+	const size_t l = B_OF_W(m);
+	const size_t s = (l + w - 1) / w;
+	const size_t count = (SIZE_1 << w) - 1;
+	const size_t nd = (B_OF_W(k) + ECP8_W) / ECP8_W;
+	size_t inf = 0xFF, bad = 0, act, neg, mask;
+	size_t pos, i, j, v;
+	bool_t a3;
+	// переменные в stack
+	void* st;			/* состояние zm8 */
+	u64* one;			/* [l8] единицы */
+	u64* A;				/* [l8] коэффициенты A */
+	u64* p;				/* [3 * l8] накопитель */
+	u64* pa;			/* [ECP8_COUNT * 3 * l8] малые кратные a_j */
+	u64* q;				/* [3 * l8] слагаемое */
+	u64* r;				/* [3 * l8] сумма */
+	u64* t;				/* [7 * l8] вспомогательные 8-наборы */
+	u64* pg;			/* [count * l8 / 4] таблица гребенки */
+	word* ww;			/* [9 * n] числа */
+	octet* dig;			/* [8 * nd] символы представлений e_j */
+	// pre
+	ASSERT(ecIsOperable(ec) && ec->d == 3);
+	ASSERT(zzIsOdd(ec->f->mod, n));
+	ASSERT(1 <= w && w < B_PER_S && m > 0);
+	ASSERT(wwIsValid(pre, 2 * n * count));
+	ASSERT(wwIsValid(d, 8 * m) && wwIsValid(e, 8 * k));
+	ASSERT(wwIsValid(a, 16 * n) && wwIsValid(b, 16 * n));
+	// раскладка stack
+	one = (u64*)stack;
+	A = one + l8;
+	p = A + l8;
+	pa = p + 3 * l8;
+	q = pa + ECP8_COUNT * 3 * l8;
+	r = q + 3 * l8;
+	t = r + 3 * l8;
+	pg = t + 7 * l8;
+	st = pg + count * l8 / 4;
+	ww = (word*)((octet*)st + zm8Start_keep(n));
+	dig = (octet*)(ww + 9 * n);
+	stack = dig + O_OF_W(W_OF_O(8 * nd));
+	// подготовить кольцо
+	zm8Start(st, ec->f->mod, n, stack);
+	wwSetZero(ww, 8 * n);
+	for (j = 0; j < 8; ++j)
+		ww[j * n] = 1;
+	zm8From(one, ww, st, stack);
+	// A == -3?
+	qrTo((octet*)(ww + 8 * n), ec->A, ec->f, stack);
+	wwFrom(ww, ww + 8 * n, ec->f->no);
+	zzAddW2(ww, n, 3);
+	a3 = wwEq(ww, ec->f->mod, n);
+	if (!a3)
+		ecp8Load(A, ec->A, 0, ec, st, ww, stack);
+	// перевести таблицу гребенки в разряды
+	for (i = 0; i < count; i += 8)
+	{
+		for (v = 0; v < 2; ++v)
+		{
+			for (j = 0; j < 8; ++j)
+			{
+				qrTo((octet*)(ww + 8 * n),
+					pre + 2 * n * MIN2(i + j, count - 1) + v * n, ec->f, stack);
+				wwFrom(ww + j * n, ww + 8 * n, ec->f->no);
+			}
+			zm8From(r + v * l8, ww, st, stack);
+		}
+		for (j = 0; j < 8 && i + j < count; ++j)
+			for (v = 0; v < l8 / 8; ++v)
+			{
+				pg[(i + j) * l8 / 4 + v] = r[8 * v + j];
+				pg[(i + j) * l8 / 4 + l8 / 8 + v] = r[l8 + 8 * v + j];
+			}
+	}
+	// pa[0] <- a_j
+	ecp8Load(pa, a, 2 * n, ec, st, ww, stack);
+	ecp8Load(pa + l8, a + n, 2 * n, ec, st, ww, stack);
+	memCopy(pa + 2 * l8, one, sizeof(u64) * l8);
+	// pa[i] <- (i + 1) a_j
+	for (i = 1; i < ECP8_COUNT; ++i)
+	{
+		if (i % 2)
+		{
+			if (a3)
+				ecp8DblJA3(pa + 3 * l8 * i, pa + 3 * l8 * (i / 2), st, t, l8,
+					stack);
+			else
+				ecp8DblJ(pa + 3 * l8 * i, pa + 3 * l8 * (i / 2), A, st, t, l8,
+					stack);
+		}
+		else
+			bad |= ecp8AddAJ(pa + 3 * l8 * i, pa + 3 * l8 * (i - 1), pa, st,
+				t, l8, stack);
+		bad |= zm8Zeros(pa + 3 * l8 * i + 2 * l8, st);
+	}
+	// символы e_j
+	for (j = 0; j < 8; ++j)
+		for (v = 0, i = 0; i < nd; ++i)
+		{
+			for (pos = ECP8_W; pos--;)
+				v += (size_t)(ECP8_W * i + pos < B_OF_W(k) &&
+					wwTestBit(e + j * k, ECP8_W * i + pos)) << pos;
+			if (v > ECP8_COUNT)
+				dig[8 * i + j] = (octet)(0x80 | (2 * ECP8_COUNT - v)), v = 1;
+			else
+				dig[8 * i + j] = (octet)v, v = 0;
+		}
+	// общая цепочка удвоений
+	memSetZero(p, sizeof(u64) * 3 * l8);
+	for (pos = MAX2(s, ECP8_W * (nd - 1) + 1); pos--;)
+	{
+		// p <- 2 p
+		if (inf != 0xFF)
+		{
+			if (a3)
+				ecp8DblJA3(p, p, st, t, l8, stack);
+			else
+				ecp8DblJ(p, p, A, st, t, l8, stack);
+		}
+		// p <- p \pm pa[|dig_j| - 1]
+		if (pos % ECP8_W == 0 && pos / ECP8_W < nd)
+		{
+			const octet* di = dig + 8 * (pos / ECP8_W);
+			for (act = neg = 0, j = 0; j < 8; ++j)
+			{
+				v = di[j] & 0x7F;
+				act |= (size_t)(v != 0) << j;
+				neg |= (size_t)(di[j] >> 7) << j;
+				ecp8Lane(q, pa + 3 * l8 * (v ? v - 1 : 0), j, 3, l8);
+			}
+			if (act)
+			{
+				memSetZero(r, sizeof(u64) * l8);
+				zm8Sub(r, r, q + l8, st);
+				zm8Select(q + l8, q + l8, r, neg, st);
+				mask = act & ~inf;
+				if (mask)
+					bad |= ecp8AddJ(r, p, q, st, t, l8, stack) & mask;
+				for (i = 0; i < 3; ++i)
+				{
+					zm8Select(p + i * l8, p + i * l8, r + i * l8, mask, st);
+					zm8Select(p + i * l8, p + i * l8, q + i * l8, act & inf,
+						st);
+				}
+				inf &= ~act;
+			}
+		}
+		// p <- p + pre[столбец pos гребенки d_j - 1]
+		if (pos < s)
+		{
+			for (act = 0, j = 0; j < 8; ++j)
+			{
+				for (i = w, v = 0; i--;)
+					v = v << 1 | (i * s + pos < l &&
+						wwTestBit(d + j * m, i * s + pos));
+				act |= (size_t)(v != 0) << j;
+				v = v ? v - 1 : 0;
+				for (i = 0; i < l8 / 8; ++i)
+				{
+					q[8 * i + j] = pg[v * l8 / 4 + i];
+					q[l8 + 8 * i + j] = pg[v * l8 / 4 + l8 / 8 + i];
+				}
+			}
+			if (act)
+			{
+				memCopy(q + 2 * l8, one, sizeof(u64) * l8);
+				mask = act & ~inf;
+				if (mask)
+					bad |= ecp8AddAJ(r, p, q, st, t, l8, stack) & mask;
+				for (i = 0; i < 3; ++i)
+				{
+					zm8Select(p + i * l8, p + i * l8, r + i * l8, mask, st);
+					zm8Select(p + i * l8, p + i * l8, q + i * l8, act & inf,
+						st);
+				}
+				inf &= ~act;
+			}
+		}
+	}
+	bad |= inf | zm8Zeros(p + 2 * l8, st);
+	// к аффинным координатам
+	wwCopy(ww, ec->f->mod, n);
+	zzSubW2(ww, n, 2);
+	zm8Power(t, p + 2 * l8, ww, n, st, stack);
+	zm8Sqr(t + l8, t, st, stack);
+	zm8Mul(r, p, t + l8, st, stack);
+	zm8Mul(t + l8, t + l8, t, st, stack);
+	zm8Mul(r + l8, p + l8, t + l8, st, stack);
+	mask = ~bad & 0xFF;
+	ecp8Store(b, 2 * n, r, mask, ec, st, ww, stack);
+	ecp8Store(b + n, 2 * n, r + l8, mask, ec, st, ww, stack);
+	return mask;
+}
+
+size_t ecpCombAddMulA8_deep(size_t n, size_t f_deep, size_t w, size_t k)
+{
+	const size_t l8 = 8 * zm8Len(n);
+	const size_t count = (SIZE_1 << w) - 1;
+	const size_t nd = (B_OF_W(k) + ECP8_W) / ECP8_W;
+	return sizeof(u64) * l8 * (2 + 3 * ECP8_COUNT + 3 + 3 + 3 + 7) +
+		sizeof(u64) * count * l8 / 4 +
+		zm8Start_keep(n) +
+		O_OF_W(9 * n) +
+		O_OF_W(W_OF_O(8 * nd)) +
+		utilMax(6,
+			f_deep,
+			zm8Start_deep(n),
+			zm8From_deep(n),
+			zm8To_deep(n),
+			zm8Mul_deep(n),
+			zm8Power_deep(n, n));
+}
+
+#endif /* U64_SUPPORT */
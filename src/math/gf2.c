@@ -4,7 +4,7 @@
 \brief Binary fields
 \project bee2 [cryptographic library]
 \created 2012.04.17
-\version 2023.03.20
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -14,6 +14,7 @@
 #include "bee2/core/mem.h"
 #include "bee2/core/stack.h"
 #include "bee2/core/util.h"
+#include "bee2/core/word.h"
 #include "bee2/math/gf2.h"
 #include "bee2/math/pp.h"
 #include "bee2/math/ww.h"
@@ -378,6 +379,53 @@ static size_t gf2Div_deep(size_t n)
 	return O_OF_W(n + 1) + ppDivMod_deep(n + 1);
 }
 
+/*
+*******************************************************************************
+Маска следа
+
+След линеен: \tr(a) = \sum a_i \tr(x^i). Поэтому при создании поля
+рассчитывается маска следа -- элемент tr, i-й разряд которого равняется
+\tr(x^i). В gf2Tr() след определяется как четность веса a & tr.
+
+Элементы \tr(x^i) -- это степенные суммы s_i корней p(x). Если
+	p(x) = x^m + e_1 x^{m - 1} + ... + e_m,
+то по тождествам Ньютона (в поле характеристики 2):
+	s_0 = m \mod 2,
+	s_i = e_1 s_{i - 1} + ... + e_{i - 1} s_1 + i e_i, 0 < i < m.
+Для трех- и пятичленов ненулевыми являются только коэффициенты e_{m - k},
+e_{m - l}, e_{m - l1} и e_m, поэтому маска рассчитывается за O(m)
+операций.
+
+Маска размещается в описании поля сразу после unity.
+*******************************************************************************
+*/
+
+#define gf2TrMask(f) ((f)->unity + (f)->n)
+
+static void gf2TrPrecomp(word tr[], const size_t p[4], size_t n)
+{
+	const size_t m = p[0];
+	size_t i, j;
+	wwSetZero(tr, n);
+	wwSetBit(tr, 0, (bool_t)(m & 1));
+	for (i = 1; i < m; ++i)
+	{
+		bool_t bit = FALSE;
+		for (j = 1; j < 4; ++j)
+		{
+			size_t d;
+			if (p[j] == 0)
+				continue;
+			d = m - p[j];
+			if (d < i)
+				bit ^= wwTestBit(tr, i - d);
+			else if (d == i)
+				bit ^= (bool_t)(i & 1);
+		}
+		wwSetBit(tr, i, bit);
+	}
+}
+
 /*
 *******************************************************************************
 Управление описанием поля
@@ -415,11 +463,12 @@ bool_t gf2Create(qr_o* f, const size_t p[4], void* stack)
 		wwSetBit(f->mod, p[0], 1);
 		wwSetBit(f->mod, p[1], 1);
 		wwSetBit(f->mod, 0, 1);
-		// сформировать unity
+		// сформировать unity и маску следа
 		f->unity = f->mod + n1;
 		wwSetW(f->unity, f->n, 1);
+		gf2TrPrecomp(gf2TrMask(f), p, f->n);
 		// сформировать params
-		f->params = (size_t*)(f->unity + f->n);
+		f->params = (size_t*)(gf2TrMask(f) + f->n);
 		t = (gf2_trinom_st*)f->params;
 		t->m = p[0];
 		t->k = p[1];
@@ -439,7 +488,8 @@ bool_t gf2Create(qr_o* f, const size_t p[4], void* stack)
 		f->inv = gf2Inv;
 		f->div = gf2Div;
 		// заголовок
-		f->hdr.keep = sizeof(qr_o) + O_OF_W(n1 + f->n) + sizeof(gf2_trinom_st);
+		f->hdr.keep = sizeof(qr_o) + O_OF_W(n1 + 2 * f->n) +
+			sizeof(gf2_trinom_st);
 		f->hdr.p_count = 3;
 		f->hdr.o_count = 0;
 		// глубина стека
@@ -480,11 +530,12 @@ bool_t gf2Create(qr_o* f, const size_t p[4], void* stack)
 		wwSetBit(f->mod, p[2], 1);
 		wwSetBit(f->mod, p[3], 1);
 		wwSetBit(f->mod, 0, 1);
-		// сформировать unity
+		// сформировать unity и маску следа
 		f->unity = f->mod + n1;
 		wwSetW(f->unity, f->n, 1);
+		gf2TrPrecomp(gf2TrMask(f), p, f->n);
 		// сформировать params
-		f->params = (size_t*)(f->unity + f->n);
+		f->params = (size_t*)(gf2TrMask(f) + f->n);
 		t = (gf2_pentanom_st*)f->params;
 		t->m = p[0];
 		t->k = p[1];
@@ -509,7 +560,7 @@ bool_t gf2Create(qr_o* f, const size_t p[4], void* stack)
 		f->inv = gf2Inv;
 		f->div = gf2Div;
 		// заголовок
-		f->hdr.keep = sizeof(qr_o) + O_OF_W(n1 + f->n) + 
+		f->hdr.keep = sizeof(qr_o) + O_OF_W(n1 + 2 * f->n) +
 			sizeof(gf2_pentanom_st);
 		f->hdr.p_count = 3;
 		f->hdr.o_count = 0;
@@ -527,7 +578,7 @@ size_t gf2Create_keep(size_t m)
 {
 	const size_t n = W_OF_B(m);
 	const size_t n1 = n + (m % B_PER_W == 0);
-	return sizeof(qr_o) + O_OF_W(n1 + n) + 
+	return sizeof(qr_o) + O_OF_W(n1 + 2 * n) +
 		utilMax(2, 
 			sizeof(gf2_trinom_st),
 			sizeof(gf2_pentanom_st));
@@ -587,6 +638,10 @@ bool_t gf2IsValid(const qr_o* f, void* stack)
 		wwSetBit(mod, 0, 1);
 		if (!wwEq(mod, f->mod, n1))
 			return FALSE;
+		// маска следа
+		gf2TrPrecomp(mod, p, f->n);
+		if (!wwEq(mod, gf2TrMask(f), f->n))
+			return FALSE;
 		// неприводимость
 		return ppIsIrred(f->mod, n1, stack);
 	}
@@ -608,36 +663,37 @@ size_t gf2Deg(const qr_o* f)
 *******************************************************************************
 Дополнительные функции
 
+В gf2Tr() используется маска следа (см. gf2TrPrecomp()).
+
 В gf2QSolve() реализован алгоритм из раздела 6.7 ДСТУ 4145-2002.
+
+Полуслед htr(a) = \sum_{k = 0}^{(m - 1) / 2} a^{4^k} линеен по a, поэтому
+в gf2HTr() он вычисляется как сумма полуследов мономов x^i, входящих
+в a. Таблица содержит полуследы только мономов 1 и x^i с нечетными i.
+Мономы с четными i = 2j исключаются по правилу
+	htr(x^{2j}) = htr(x^j)^2 = htr(x^j) + x^j + tr(x^j)
+при просмотре a от старших разрядов к младшим [Fong K., Hankerson D.,
+Lopez J., Menezes A. Field inversion and point halving revisited, 2004].
 *******************************************************************************
 */
 
 bool_t gf2Tr(const word a[], const qr_o* f, void* stack)
 {
-	size_t m = gf2Deg(f);
-	word* t = (word*)stack;
-	stack = t + f->n;
+	const word* tr = gf2TrMask(f);
+	register word w = 0;
+	size_t i;
 	// pre
 	ASSERT(gf2IsOperable(f));
 	ASSERT(gf2IsIn(a, f));
-	// t <- sum_{i = 0}^{m - 1} a^{2^i}
-	qrCopy(t, a, f);
-	while (--m)
-	{
-		qrSqr(t, t, f, stack);
-		gf2Add2(t, a, f);
-	}
-	// t == 0?
-	if (qrIsZero(t, f))
-		return FALSE;
-	// t == 1?
-	ASSERT(qrIsUnity(t, f));
-	return TRUE;
+	// w <- a & tr (свертка)
+	for (i = 0; i < f->n; ++i)
+		w ^= a[i] & tr[i];
+	return wordParity(w);
 }
 
 size_t gf2Tr_deep(size_t n, size_t f_deep)
 {
-	return O_OF_W(n) + f_deep;
+	return 0;
 }
 
 bool_t gf2QSolve(word x[], const word a[], const word b[],
@@ -692,3 +748,76 @@ size_t gf2QSolve_deep(size_t n, size_t f_deep)
 {
 	return O_OF_W(n) + f_deep;
 }
+
+void gf2HTrPrecomp(word tab[], const qr_o* f, void* stack)
+{
+	const size_t m = gf2Deg(f);
+	size_t j, k;
+	word* t = (word*)stack;
+	stack = t + f->n;
+	// pre
+	ASSERT(gf2IsOperable(f));
+	ASSERT(m % 2);
+	ASSERT(wwIsValid(tab, (m + 1) / 2 * f->n));
+	// tab[j] <- htr(x^{2j - 1}), tab[0] <- htr(1)
+	for (j = 0; j <= m / 2; ++j, tab += f->n)
+	{
+		qrSetZero(t, f);
+		wwSetBit(t, j ? 2 * j - 1 : 0, 1);
+		qrCopy(tab, t, f);
+		for (k = m / 2; k--;)
+		{
+			qrSqr(t, t, f, stack);
+			qrSqr(t, t, f, stack);
+			gf2Add2(tab, t, f);
+		}
+	}
+	// очистка
+	qrSetZero(t, f);
+}
+
+size_t gf2HTrPrecomp_deep(size_t n, size_t f_deep)
+{
+	return O_OF_W(n) + f_deep;
+}
+
+void gf2HTr(word b[], const word a[], const word tab[], const qr_o* f,
+	void* stack)
+{
+	const size_t m = gf2Deg(f);
+	const word* tr = gf2TrMask(f);
+	size_t i;
+	word* t = (word*)stack;
+	stack = t + f->n;
+	// pre
+	ASSERT(gf2IsOperable(f));
+	ASSERT(gf2IsIn(a, f));
+	ASSERT(m % 2);
+	ASSERT(wwIsValid(tab, (m + 1) / 2 * f->n));
+	ASSERT(wwIsDisjoint2(b, f->n, tab, (m + 1) / 2 * f->n));
+	// t <- a, b <- 0
+	qrCopy(t, a, f);
+	qrSetZero(b, f);
+	// исключить четные степени
+	for (i = m - 1; i; i -= 2)
+		if (wwTestBit(t, i))
+		{
+			wwFlipBit(t, i / 2);
+			wwFlipBit(b, i / 2);
+			if (wwTestBit(tr, i / 2))
+				wwFlipBit(b, 0);
+		}
+	// b <- b + \sum tab[.]
+	if (wwTestBit(t, 0))
+		gf2Add2(b, tab, f);
+	for (i = 1; i < m; i += 2)
+		if (wwTestBit(t, i))
+			gf2Add2(b, tab + (i + 1) / 2 * f->n, f);
+	// очистка
+	qrSetZero(t, f);
+}
+
+size_t gf2HTr_deep(size_t n, size_t f_deep)
+{
+	return O_OF_W(n);
+}
@@ -4,7 +4,7 @@
 \brief Prime fields
 \project bee2 [cryptographic library]
 \created 2012.07.11
-\version 2014.04.17
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -15,6 +15,7 @@
 #include "bee2/math/gfp.h"
 #include "bee2/math/pri.h"
 #include "bee2/math/ww.h"
+#include "bee2/math/zz.h"
 
 /*
 *******************************************************************************
@@ -77,3 +78,137 @@ size_t gfpIsValid_deep(size_t n)
 {
 	return priIsPrime_deep(n);
 }
+
+/*
+*******************************************************************************
+Квадратные корни
+
+Пусть p - 1 = 2^s q, q -- нечетное. Способ извлечения корня определяется
+по s:
+-	s = 1 (p \equiv 3 \mod 4): b <- a^{(p + 1) / 4};
+-	s = 2 (p \equiv 5 \mod 8): алгоритм Аткина [Atkin A.O.L. Probabilistic
+	primality testing, 1992]:
+		v <- (2a)^{(p - 5) / 8}, i <- 2a v^2, b <- a v (i - 1);
+-	s > 2: алгоритм Тонелли -- Шенкса [Cohen H. A Course in Computational
+	Algebraic Number Theory, алгоритм 1.5.1]:
+		z <- невычет, c <- z^q, t <- a^q, b <- a^{(q + 1) / 2}, m <- s
+		пока (t != 1)
+			i <- min{i: t^{2^i} = 1}
+			если (i == m)
+				return FALSE // a -- невычет
+			c <- c^{2^{m - i - 1}}, b <- b c, c <- c^2, t <- t c, m <- i
+В первых двух случаях вычисляется одна степень. В конце проверяется, что
+b^2 == a: проверка отсеивает невычеты (в первых двух случаях) и
+ошибки из-за непростого модуля.
+
+Невычет z ищется перебором z = 2, 3,... по символу Якоби. Для простых Ферма
+и других простых с большим s невычет обычно находится за несколько шагов.
+
+Показатели степеней вычисляются сдвигами модуля: (p + 1) / 4 = (p >> 2) + 1,
+(p - 5) / 8 = p >> 3, (q + 1) / 2 = (q >> 1) + 1. Расчет показателей
+ничтожен по сравнению с возведением в степень, поэтому показатели
+не хранятся в описании поля.
+*******************************************************************************
+*/
+
+bool_t gfpSqrt(word b[], const word a[], const qr_o* f, void* stack)
+{
+	const size_t n = f->n;
+	size_t s, m, i;
+	// переменные в stack
+	word* e = (word*)stack;
+	word* x = e + n;
+	word* t = x + n;
+	word* c = t + n;
+	stack = c + n;
+	// pre
+	ASSERT(gfpIsOperable(f));
+	ASSERT(zmIsIn(a, f));
+	ASSERT(wwIsSameOrDisjoint(a, b, n));
+	// a == 0?
+	if (qrIsZero(a, f))
+	{
+		qrSetZero(b, f);
+		return TRUE;
+	}
+	// e <- p - 1, s <- max_{2^i | p - 1} i
+	wwCopy(e, f->mod, n);
+	e[0] ^= 1;
+	s = wwLoZeroBits(e, n);
+	// p \equiv 3 \mod 4: x <- a^{(p + 1) / 4}
+	if (s == 1)
+	{
+		wwShLo(e, n, 2);
+		zzAddW2(e, n, 1);
+		qrPower(x, a, e, n, f, stack);
+	}
+	// p \equiv 5 \mod 8: x <- a v (i - 1)
+	else if (s == 2)
+	{
+		wwShLo(e, n, 3);
+		// t <- 2a, c <- v = t^{(p - 5) / 8}
+		qrAdd(t, a, a, f);
+		qrPower(c, t, e, n, f, stack);
+		// x <- i - 1 = t v^2 - 1
+		qrSqr(x, c, f, stack);
+		qrMul(x, x, t, f, stack);
+		qrSubUnity(x, f);
+		// x <- a v (i - 1)
+		qrMul(x, x, c, f, stack);
+		qrMul(x, x, a, f, stack);
+	}
+	// алгоритм Тонелли -- Шенкса
+	else
+	{
+		word z = 1;
+		// e <- q
+		wwShLo(e, n, s);
+		// t <- z (невычет)
+		qrSetUnity(t, f);
+		do
+		{
+			if (++z == 0 || wwCmpW(f->mod, n, z) <= 0)
+				return FALSE;
+			qrAddUnity(t, t, f);
+		}
+		while (zzJacobi(&z, 1, f->mod, n, stack) != -1);
+		// c <- z^q, t <- a^q, x <- a^{(q + 1) / 2}
+		qrPower(c, t, e, n, f, stack);
+		qrPower(t, a, e, n, f, stack);
+		wwShLo(e, n, 1);
+		zzAddW2(e, n, 1);
+		qrPower(x, a, e, n, f, stack);
+		// основной цикл
+		for (m = s; !qrIsUnity(t, f); m = i)
+		{
+			// i <- min{i: t^{2^i} = 1}
+			qrSqr(e, t, f, stack);
+			for (i = 1; i < m && !qrIsUnity(e, f); ++i)
+				qrSqr(e, e, f, stack);
+			if (i == m)
+				return FALSE;
+			// c <- c^{2^{m - i - 1}}
+			while (m-- > i + 1)
+				qrSqr(c, c, f, stack);
+			// x <- x c, c <- c^2, t <- t c
+			qrMul(x, x, c, f, stack);
+			qrSqr(c, c, f, stack);
+			qrMul(t, t, c, f, stack);
+		}
+	}
+	// x^2 == a?
+	qrSqr(t, x, f, stack);
+	if (!wwEq(t, a, n))
+		return FALSE;
+	qrCopy(b, x, f);
+	return TRUE;
+}
+
+size_t gfpSqrt_deep(size_t n, size_t f_deep)
+{
+	return O_OF_W(4 * n) +
+		utilMax(3,
+			f_deep,
+			qrPower_deep(n, n, f_deep),
+			zzJacobi_deep(1, n));
+}
@@ -0,0 +1,93 @@
+/*
+*******************************************************************************
+\file opcnt.c
+\brief Operation counters for rings and elliptic curves
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
+#include "bee2/core/util.h"
+#include "bee2/math/opcnt.h"
+
+/*
+*******************************************************************************
+Счетчики
+
+Счетчики потока размещаются в куче при первом обращении и закрепляются
+за потоком с помощью ключа (см. mtKeyCreate()). Ключ создается
+однократно. Деструктор ключа освобождает счетчики при завершении потока.
+Если ключ создать не удалось или не удалось разместить счетчики, то
+используются общие счетчики _common.
+*******************************************************************************
+*/
+
+#ifdef BEE2_INSTRUMENT
+
+static size_t _once;
+static bool_t _inited;
+static mt_key_t _key;
+static opcnt_t _common;
+
+static void MT_CALLBACK opcntClose(void* c)
+{
+	memFree(c);
+}
+
+static void opcntInit()
+{
+	_inited = mtKeyCreate(&_key, opcntClose);
+}
+
+opcnt_t* opcntCounters()
+{
+	opcnt_t* c;
+	if (!mtCallOnce(&_once, opcntInit) || !_inited)
+		return &_common;
+	c = (opcnt_t*)mtKeyGet(&_key);
+	if (c)
+		return c;
+	c = (opcnt_t*)memAlloc(sizeof(opcnt_t));
+	if (!c)
+		return &_common;
+	memSetZero(c, sizeof(opcnt_t));
+	if (!mtKeySet(&_key, c))
+	{
+		memFree(c);
+		return &_common;
+	}
+	return c;
+}
+
+#endif /* BEE2_INSTRUMENT */
+
+bool_t opcntIsEnabled()
+{
+#ifdef BEE2_INSTRUMENT
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+void opcntReset()
+{
+#ifdef BEE2_INSTRUMENT
+	memSetZero(opcntCounters(), sizeof(opcnt_t));
+#endif
+}
+
+void opcntGet(opcnt_t* c)
+{
+	ASSERT(memIsValid(c, sizeof(opcnt_t)));
+#ifdef BEE2_INSTRUMENT
+	memCopy(c, opcntCounters(), sizeof(opcnt_t));
+#else
+	memSetZero(c, sizeof(opcnt_t));
+#endif
+}
@@ -4,7 +4,7 @@
 \brief Binary polynomials: other functions
 \project bee2 [cryptographic library]
 \created 2012.03.01
-\version 2023.11.09
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -12,6 +12,7 @@
 
 #include "bee2/core/mem.h"
 #include "bee2/core/util.h"
+#include "bee2/core/word.h"
 #include "bee2/math/pp.h"
 #include "bee2/math/ww.h"
 
@@ -26,6 +27,74 @@ size_t ppDeg(const word a[], size_t n)
 	return wwBitSize(a, n) - SIZE_1;
 }
 
+/*
+*******************************************************************************
+Редукция Барретта
+
+Реализована редукция Барретта [Barrett P. Implementing the Rivest Shamir
+and Adleman public key encryption algorithm on a standard digital signal
+processor. CRYPTO 1986, 311--323]. Для многочленов c степени меньше 2l,
+где l = \deg(mod), редукция точна:
+	c \mod mod = c + ((c div x^l) * mu div x^l) * mod,
+	mu = x^{2l} div mod,
+и требует двух умножений ppMul() (с умножением без переносов, если оно
+поддерживается платформой) вместо деления ppMod(). Выигрыш значителен,
+если умножений по одному модулю много: mu рассчитывается однократно.
+*******************************************************************************
+*/
+
+static void ppBarrettStart(word mu[], const word mod[], size_t n,
+	void* stack)
+{
+	const size_t l = ppDeg(mod, n);
+	const size_t m = W_OF_B(2 * l + 1);
+	// переменные в stack
+	word* x = (word*)stack;
+	word* r = x + m;
+	stack = r + n;
+	// mu <- x^{2l} div mod
+	wwSetZero(x, m);
+	wwSetBit(x, 2 * l, 1);
+	wwSetZero(mu, n + 1);
+	ppDiv(mu, r, x, m, mod, n, stack);
+}
+
+static size_t ppBarrettStart_deep(size_t n)
+{
+	return O_OF_W(3 * n) + ppDiv_deep(2 * n, n);
+}
+
+static void ppMulModBarrett(word c[], const word a[], const word b[],
+	const word mod[], const word mu[], size_t n, void* stack)
+{
+	const size_t l = ppDeg(mod, n);
+	// переменные в stack
+	word* prod = (word*)stack;
+	word* q = prod + 2 * n;
+	word* t = q + 2 * n + 2;
+	stack = t + 2 * n;
+	// prod <- a * b
+	ppMul(prod, a, n, b, n, stack);
+	// q <- ((prod div x^l) * mu) div x^l
+	wwCopy(t, prod, 2 * n);
+	wwShLo(t, 2 * n, l);
+	ppMul(q, t, n, mu, n + 1, stack);
+	wwShLo(q, 2 * n + 1, l);
+	// c <- prod + q * mod
+	ppMul(t, q, n, mod, n, stack);
+	wwXor2(prod, t, n);
+	ASSERT(wwIsZero(prod + n, n) || wwEq(prod + n, t + n, n));
+	wwCopy(c, prod, n);
+}
+
+static size_t ppMulModBarrett_deep(size_t n)
+{
+	return O_OF_W(6 * n + 2) +
+		utilMax(2,
+			ppMul_deep(n, n),
+			ppMul_deep(n, n + 1));
+}
+
 /*
 *******************************************************************************
 Неприводимость
@@ -51,51 +120,170 @@ Irreducible Polynomials over Finite Fields] этот алгоритм обраб
 		если (a, x^{2^i} - x) != 1
 			возвратить 0
 	возвратить 1
+
+Возведение в квадрат по модулю a -- линейное отображение над GF(2).
+Если h = \sum_j h_j x^j, то h^2 = \sum_j h_j x^{2j}. При 2j < m
+одночлены x^{2j} не требуют приведения, поэтому младшая половина h
+возводится в квадрат функцией ppSqr() без деления. Для старшей половины
+(j >= k = \lceil m / 2\rceil) заранее рассчитываются столбцы
+x^{2j} \mod a матрицы возведения в квадрат, и h^2 \mod a получается
+сложением столбцов, которые соответствуют ненулевым h_j.
+
+Наибольшие общие делители -- основная часть затрат. Случайный
+многочлен с вероятностью около 1 / i имеет неприводимый делитель
+степени i [Gao, Panario], поэтому на первых PP_IRRED_SINGLE итерациях
+н.о.д. вычисляется на каждой итерации: приводимые многочлены
+отбраковываются как можно раньше. На остальных итерациях многочлены
+x^{2^i} - x перемножаются по модулю a (с редукцией Барретта), а н.о.д.
+вычисляется один раз на PP_IRRED_BLOCK итераций. Если произведение имеет
+общий делитель с a, то он есть и у одного из сомножителей, т.е. у a есть
+неприводимый делитель степени не выше m div 2. В частности, если
+произведение стало нулевым, то a делит произведение многочленов
+x^{2^i} - x, i <= m div 2, и является приводимым.
 *******************************************************************************
 */
 
+#define PP_IRRED_SINGLE 8
+#define PP_IRRED_BLOCK 16
+
+static void ppIsIrredPre(word q[], const word a[], size_t m, size_t n)
+{
+	const size_t k = (m + 1) / 2;
+	size_t j;
+	// q <- x^{2(k - 1)}
+	wwSetZero(q, n);
+	wwSetBit(q, 2 * (k - 1), 1);
+	// столбцы x^{2j} \mod a, k <= j < m
+	for (j = k; j < m; ++j, q += n)
+	{
+		if (j > k)
+			wwCopy(q, q - n, n);
+		// q <- q * x^2 \mod a
+		wwShHi(q, n, 1);
+		if (wwTestBit(q, m))
+			wwXor2(q, a, n);
+		wwShHi(q, n, 1);
+		if (wwTestBit(q, m))
+			wwXor2(q, a, n);
+	}
+}
+
+static void ppIsIrredSqr(word h[], const word q[], size_t m, size_t n,
+	void* stack)
+{
+	const size_t k = (m + 1) / 2;
+	size_t j;
+	// переменные в stack
+	word* s = (word*)stack;
+	word* t = s + 2 * n;
+	stack = t + n;
+	// s <- (h \mod x^k)^2
+	wwCopy(t, h, n);
+	wwTrimHi(t, n, k);
+	ppSqr(s, t, W_OF_B(k), stack);
+	if (2 * W_OF_B(k) < n)
+		wwSetZero(s + 2 * W_OF_B(k), n - 2 * W_OF_B(k));
+	// s <- s + \sum_{j >= k} h_j x^{2j} \mod a
+	for (j = k; j < m; ++j, q += n)
+		if (h[j / B_PER_W] >> j % B_PER_W & 1)
+			wwXor2(s, q, n);
+	wwCopy(h, s, n);
+}
+
 bool_t ppIsIrred(const word a[], size_t n, void* stack)
 {
-	size_t i;
+	size_t m, i;
+	// переменные в stack
 	word* h = (word*)stack;
-	word* d = h + n;
-	stack = d + n;
+	word* p = h + n;
+	word* d = p + n;
+	word* mu = d + n;
+	word* q = mu + n + 1;
 	// нормализация (нужна для \mod a)
 	n = wwWordSize(a, n);
 	// постоянный многочлен не является неприводимым
 	if (wwCmpW(a, n, 1) <= 0)
 		return FALSE;
-	// h <- x^2
+	m = ppDeg(a, n);
+	stack = q + (m - (m + 1) / 2) * n;
+	// матрица возведения в квадрат
+	ppIsIrredPre(q, a, m, n);
+	// h <- x^2, p <- 1
 	wwSetW(h, n, 4);
+	wwSetW(p, n, 1);
 	// основной цикл
-	for (i = ppDeg(a, n) / 2; i; --i)
+	for (i = 1; i <= m / 2; ++i)
 	{
-		// (h + x, a) == 1?
-		wwFlipBit(h, 1);
-		if (wwIsZero(h, n))
-			return FALSE;
-		ppGCD(d, h, n, a, n, stack);
-		if (wwCmpW(d, n, 1) != 0)
-			return FALSE;
-		wwFlipBit(h, 1);
 		// h <- h^2 \mod a
 		if (i > 1)
-			ppSqrMod(h, h, a, n, stack);
+			ppIsIrredSqr(h, q, m, n, stack);
+		wwFlipBit(h, 1);
+		// (h + x, a) == 1?
+		if (i <= PP_IRRED_SINGLE)
+		{
+			if (wwIsZero(h, n))
+				return FALSE;
+			ppGCD(d, h, n, a, n, stack);
+			if (wwCmpW(d, n, 1) != 0)
+				return FALSE;
+		}
+		// (p, a) == 1?
+		else
+		{
+			// mu <- x^{2m} div a
+			if (i == PP_IRRED_SINGLE + 1)
+				ppBarrettStart(mu, a, n, stack);
+			ppMulModBarrett(p, p, h, a, mu, n, stack);
+			if ((i - PP_IRRED_SINGLE) % PP_IRRED_BLOCK == 0 || i == m / 2)
+			{
+				if (wwIsZero(p, n))
+					return FALSE;
+				ppGCD(d, p, n, a, n, stack);
+				if (wwCmpW(d, n, 1) != 0)
+					return FALSE;
+			}
+		}
+		wwFlipBit(h, 1);
 	}
 	return TRUE;
 }
 
 size_t ppIsIrred_deep(size_t n)
 {
-	return O_OF_W(2 * n);
+	return O_OF_W(4 * n + 1 + n * B_PER_W / 2 * n) +
+		utilMax(4,
+			O_OF_W(3 * n) + ppSqr_deep(n),
+			ppBarrettStart_deep(n),
+			ppMulModBarrett_deep(n),
+			ppGCD_deep(n, n));
 }
 
 /*
 *******************************************************************************
 Минимальные многочлены
 
-Реализован следующий алгоритм определения минимального многочлена
-последовательности:
+Основной алгоритм определения минимального многочлена последовательности
+s_0, s_1,..., s_{2l - 1} -- алгоритм Берлекэмпа -- Мэсси
+[Massey J.L. Shift-register synthesis and BCH decoding. IEEE Trans.
+Inform. Theory, 15, 1969, 122--127]:
+	C <- 1, B <- 1, L <- 0, m <- 1
+	для (k = 0,..., 2l - 1)
+		d <- s_k + \sum_{i = 1}^L c_i s_{k - i}
+		если (d == 0)
+			m <- m + 1
+		иначе если (2L <= k)
+			(C, B) <- (C + x^m B, C), L <- k + 1 - L, m <- 1
+		иначе
+			C <- C + x^m B, m <- m + 1
+	вернуть x^L C(1/x)
+Невязка d вычисляется пословно: окно r = s_k + s_{k - 1} x +... + s_0 x^k
+сдвигается на один разряд на каждом шаге, d -- четность слов C & r.
+Обновление C + x^m B также выполняется пословно. Трудоемкость --
+O(l^2 / B_PER_W) операций со словами.
+
+Если линейная сложность L последовательности превышает l, то
+минимальный многочлен (в смысле ppMinPoly()) определяется резервным
+алгоритмом, основанным на алгоритме Евклида:
 	aa <- a
 	bb <- x^{2l}
 	da <- 1, db <- 0
@@ -113,10 +301,76 @@ The Berlekamp-Massey Algorithm Revisited, AAECC (2006) 17: 75–82] и
 and Algebra]. В последней работе можно найти обоснование алгоритма:
 теорема 17.8, п. 17.5.1, рассуждения после теоремы 18.2.
 Из этого обоснования, в частности, следует, что \deg da, \deg db <= l.
+
+В ppMinPolyMod() члены последовательности -- младшие коэффициенты
+a^i \mod mod, i = 1, 2,..., 2l. Степени a рассчитываются умножениями
+с редукцией Барретта.
 *******************************************************************************
 */
 
-void ppMinPoly(word b[], const word a[], size_t l, void* stack)
+static bool_t ppMinPolyBM(word b[], const word a[], size_t l, void* stack)
+{
+	const size_t m = W_OF_B(2 * l + 1);
+	size_t L = 0, shift = 1, k, i;
+	// переменные в stack
+	word* c = (word*)stack;
+	word* bb = c + m;
+	word* t = bb + m;
+	word* r = t + m;
+	stack = r + m;
+	// C <- 1, B <- 1, r <- 0
+	wwSetW(c, m, 1);
+	wwSetW(bb, m, 1);
+	wwSetZero(r, m);
+	// основной цикл
+	for (k = 0; k < 2 * l; ++k)
+	{
+		const size_t nc = W_OF_B(L + 1);
+		register word d;
+		// r <- r x + s_k
+		wwShHi(r, MIN2(nc + 1, m), 1);
+		r[0] |= (word)wwTestBit(a, 2 * l - 1 - k);
+		// d <- <C, r>
+		for (d = 0, i = 0; i < nc; ++i)
+			d ^= c[i] & r[i];
+		if (!wordParity(d))
+		{
+			++shift;
+			continue;
+		}
+		// t <- x^m B
+		wwCopy(t, bb, m);
+		wwShHi(t, m, shift);
+		if (2 * L <= k)
+		{
+			// (C, B) <- (C + x^m B, C)
+			wwCopy(bb, c, m);
+			wwXor2(c, t, m);
+			L = k + 1 - L, shift = 1;
+		}
+		else
+			// C <- C + x^m B
+			wwXor2(c, t, m), ++shift;
+	}
+	// сложность больше l?
+	if (L > l)
+		return FALSE;
+	// b <- x^L C(1/x)
+	wwSetZero(b, W_OF_B(l + 1));
+	for (i = 0; i <= L; ++i)
+		if (wwTestBit(c, i))
+			wwSetBit(b, L - i, 1);
+	// очистка
+	wwSetZero(c, 4 * m);
+	return TRUE;
+}
+
+static size_t ppMinPolyBM_deep(size_t l)
+{
+	return O_OF_W(4 * W_OF_B(2 * l + 1));
+}
+
+static void ppMinPolyEuclid(word b[], const word a[], size_t l, void* stack)
 {
 	const size_t n = W_OF_B(l);
 	const size_t m = W_OF_B(l + 1);
@@ -129,8 +383,6 @@ void ppMinPoly(word b[], const word a[], size_t l, void* stack)
 	word* da = r + 2 * n;
 	word* db = da + m;
 	stack = db + m + n + 2;
-	// pre
-	ASSERT(wwIsValid(b, m) && wwIsValid(a, 2 * n));
 	// aa <- a
 	wwCopy(aa, a, 2 * n);
 	wwTrimHi(aa, 2 * n, 2 * l);
@@ -168,13 +420,29 @@ void ppMinPoly(word b[], const word a[], size_t l, void* stack)
 	wwCopy(b, da, m);
 }
 
-size_t ppMinPoly_deep(size_t l)
+static size_t ppMinPolyEuclid_deep(size_t l)
 {
 	const size_t n = W_OF_B(l);
 	const size_t m = W_OF_B(l + 1);
 	return O_OF_W(8 * n + 2 * m + 5) + ppAddMulW_deep(m);
 }
 
+void ppMinPoly(word b[], const word a[], size_t l, void* stack)
+{
+	// pre
+	ASSERT(wwIsValid(b, W_OF_B(l + 1)) && wwIsValid(a, 2 * W_OF_B(l)));
+	// Берлекэмп -- Мэсси или резервный алгоритм
+	if (!ppMinPolyBM(b, a, l, stack))
+		ppMinPolyEuclid(b, a, l, stack);
+}
+
+size_t ppMinPoly_deep(size_t l)
+{
+	return utilMax(2,
+		ppMinPolyBM_deep(l),
+		ppMinPolyEuclid_deep(l));
+}
+
 void ppMinPolyMod(word b[], const word a[], const word mod[], size_t n,
 	void* stack)
 {
@@ -182,26 +450,34 @@ void ppMinPolyMod(word b[], const word a[], const word mod[], size_t n,
 	// раскладка стека
 	word* t = (word*)stack;
 	word* s = t + n;
-	stack = s + 2 * n;
+	word* mu = s + 2 * n;
+	stack = mu + n + 1;
 	// pre
 	ASSERT(wwIsValid(b, n) && wwIsValid(a, n) && wwIsValid(mod, n));
 	ASSERT(wwCmpW(mod, n, 1) > 0 && wwCmp(a, mod, n) < 0);
 	// l <- \deg(mod)
+	n = wwWordSize(mod, n);
 	l = ppDeg(mod, n);
+	// mu <- x^{2l} div mod
+	ppBarrettStart(mu, mod, n, stack);
 	// s[2 * l - 1 - i] <- a(x)^i при x = 0
 	wwCopy(t, a, n);
+	wwSetZero(s, 2 * n);
 	wwSetBit(s, 2 * l - 1, wwTestBit(t, 0));
 	for (i = 2 * l - 1; i--;)
 	{
-		ppMulMod(t, t, a, mod, n, stack);
+		ppMulModBarrett(t, t, a, mod, mu, n, stack);
 		wwSetBit(s, i, wwTestBit(t, 0));
 	}
-	wwTrimHi(s, 2 * n, 2 * l);
 	// b <- минимальный многочлен s
 	ppMinPoly(b, s, l, stack);
 }
 
 size_t ppMinPolyMod_deep(size_t n)
 {
-	return ppMulMod_deep(n) + ppMinPoly_deep(n * B_PER_W);
+	return O_OF_W(4 * n + 1) +
+		utilMax(3,
+			ppBarrettStart_deep(n),
+			ppMulModBarrett_deep(n),
+			ppMinPoly_deep(n * B_PER_W));
 }
@@ -4,12 +4,13 @@
 \brief Binary polynomials: multiplicative operations
 \project bee2 [cryptographic library]
 \created 2012.03.01
-\version 2023.11.09
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include "bee2/core/cpu.h"
 #include "bee2/core/mem.h"
 #include "bee2/core/util.h"
 #include "bee2/math/pp.h"
@@ -773,6 +774,138 @@ static size_t ppMul9_deep()
 	return O_OF_W(18) + ppMul3_deep();
 }
 
+/*
+*******************************************************************************
+Умножение без переносов
+
+Если B_PER_W == 64 и платформа поддерживает инструкции умножения без
+переносов (PCLMULQDQ на x86-64, PMULL на AArch64), то функции ppMulW(),
+ppAddMulW(), ppMul() и ppSqr() используют их вместо оконных макросов
+и таблицы _squares. На платформе x86-64 наличие PCLMULQDQ проверяется
+во время выполнения (cpuHas()). На платформе AArch64 функции с PMULL
+включаются во время компиляции (макрос __ARM_FEATURE_CRYPTO), как и
+в belt_lcl.c, а во время выполнения проверяется только, что набор PMULL
+не снят (cpuHas()).
+
+Макрос _CLMUL(lo, hi, a, b) определяет произведение (hi, lo) слов a и b.
+Инструкции выполняются за время, которое не зависит от операндов. Поэтому,
+в частности, возведение в квадрат выполняется без обращений к памяти
+по секретным индексам.
+
+Умножение многочленов выполняется по схеме "столбиков" (product scanning):
+	c_k <- lo(\sum_{i + j = k} a_i b_j) + hi(\sum_{i + j = k - 1} a_i b_j).
+При n, m <= 9 (поля размерности до 571) это быстрее, чем алгоритм
+Карацубы над _CLMUL. Вспомогательная память не используется.
+*******************************************************************************
+*/
+
+#if (B_PER_W == 64) && (OCTET_ORDER == LITTLE_ENDIAN) &&\
+	((defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__) ||\
+	(_MSC_VER >= 1600) && defined(_M_X64))
+
+#define PP_CLMUL
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+	#define PP_CLMUL_TARGET
+#else
+	#define PP_CLMUL_TARGET __attribute__((target("sse2,pclmul")))
+#endif
+#include <wmmintrin.h>
+
+#define ppClMulIsAvail() cpuHas(CPU_PCLMUL)
+
+#define _CLMUL(lo, hi, a, b)\
+{\
+	__m128i t = _mm_clmulepi64_si128(_mm_cvtsi64_si128((long long)(a)),\
+		_mm_cvtsi64_si128((long long)(b)), 0x00);\
+	(lo) = (word)_mm_cvtsi128_si64(t);\
+	(hi) = (word)_mm_cvtsi128_si64(_mm_unpackhi_epi64(t, t));\
+}\
+
+#elif (B_PER_W == 64) && (OCTET_ORDER == LITTLE_ENDIAN) &&\
+	defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+
+#define PP_CLMUL
+
+#include <arm_neon.h>
+
+#define PP_CLMUL_TARGET
+#define ppClMulIsAvail() cpuHas(CPU_PMULL)
+
+#define _CLMUL(lo, hi, a, b)\
+{\
+	uint64x2_t t = vreinterpretq_u64_p128(\
+		vmull_p64((poly64_t)(a), (poly64_t)(b)));\
+	(lo) = (word)vgetq_lane_u64(t, 0);\
+	(hi) = (word)vgetq_lane_u64(t, 1);\
+}\
+
+#endif
+
+#ifdef PP_CLMUL
+
+PP_CLMUL_TARGET
+static word ppMulWClMul(word b[], const word a[], size_t n, word w)
+{
+	word lo, hi, carry = 0;
+	size_t i;
+	for (i = 0; i < n; ++i)
+	{
+		_CLMUL(lo, hi, a[i], w);
+		b[i] = carry ^ lo;
+		carry = hi;
+	}
+	lo = hi = 0;
+	return carry;
+}
+
+PP_CLMUL_TARGET
+static word ppAddMulWClMul(word b[], const word a[], size_t n, word w)
+{
+	word lo, hi, carry = 0;
+	size_t i;
+	for (i = 0; i < n; ++i)
+	{
+		_CLMUL(lo, hi, a[i], w);
+		b[i] ^= carry ^ lo;
+		carry = hi;
+	}
+	lo = hi = 0;
+	return carry;
+}
+
+PP_CLMUL_TARGET
+static void ppMulClMul(word c[], const word a[], size_t n, const word b[],
+	size_t m)
+{
+	word lo, hi, acc_lo, acc_hi, carry = 0;
+	size_t i, k;
+	for (k = 0; k + 1 < n + m; ++k)
+	{
+		acc_lo = acc_hi = 0;
+		for (i = k < m ? 0 : k - m + 1; i < n && i <= k; ++i)
+		{
+			_CLMUL(lo, hi, a[i], b[k - i]);
+			acc_lo ^= lo, acc_hi ^= hi;
+		}
+		c[k] = carry ^ acc_lo;
+		carry = acc_hi;
+	}
+	c[k] = carry;
+	lo = hi = acc_lo = acc_hi = carry = 0;
+}
+
+PP_CLMUL_TARGET
+static void ppSqrClMul(word b[], const word a[], size_t n)
+{
+	size_t i;
+	for (i = 0; i < n; ++i)
+		_CLMUL(b[i + i], b[i + i + 1], a[i], a[i]);
+}
+
+#endif
+
 /*
 *******************************************************************************
 Умножение на слово
@@ -786,6 +919,10 @@ word ppMulW(word b[], const word a[], size_t n, register word w,
 	size_t i;
 	word* t = (word*)stack;
 	ASSERT(wwIsSameOrDisjoint(a, b, n));
+#ifdef PP_CLMUL
+	if (ppClMulIsAvail())
+		return ppMulWClMul(b, a, n, w);
+#endif
 	_MUL_PRE_S4(t, w);
 	for (i = 0; i < n; ++i)
 	{
@@ -810,6 +947,10 @@ word ppAddMulW(word b[], const word a[], size_t n, register word w,
 	size_t i;
 	word* t = (word*)stack;
 	ASSERT(wwIsSameOrDisjoint(a, b, n));
+#ifdef PP_CLMUL
+	if (ppClMulIsAvail())
+		return ppAddMulWClMul(b, a, n, w);
+#endif
 	_MUL_PRE_S4(t, w);
 	for (i = 0; i < n; ++i)
 	{
@@ -924,6 +1065,14 @@ void ppMul(word c[], const word a[], size_t n, const word b[], size_t m,
 		wwSetZero(c, n + m);
 		return;
 	}
+#ifdef PP_CLMUL
+	// умножение без переносов
+	if (ppClMulIsAvail())
+	{
+		ppMulClMul(c, a, n, b, m);
+		return;
+	}
+#endif
 	// умножение многочленов одинаковой длины
 	if (n == m)
 		ppMulEq(c, a, b, n, stack);
@@ -1092,6 +1241,13 @@ void ppSqr(word b[], const word a[], size_t n, void* stack)
 {
 	size_t i;
 	ASSERT(wwIsDisjoint2(a, n, b, 2 * n));
+#ifdef PP_CLMUL
+	if (ppClMulIsAvail())
+	{
+		ppSqrClMul(b, a, n);
+		return;
+	}
+#endif
 	for (i = 0; i < n; ++i)
 		b[i + i] = _SQR_LO(a[i]),
 		b[i + i + 1] = _SQR_HI(a[i]);
@@ -4,13 +4,15 @@
 \brief Prime numbers
 \project bee2 [cryptographic library]
 \created 2012.08.13
-\version 2024.06.14
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include "bee2/core/cpu.h"
 #include "bee2/core/mem.h"
+#include "bee2/core/mt.h"
 #include "bee2/core/prng.h"
 #include "bee2/core/util.h"
 #include "bee2/core/word.h"
@@ -375,6 +377,141 @@ static const pri_prod_t _prods[] =
 #endif
 };
 
+/*
+*******************************************************************************
+Остатки от деления на простые факторной базы: AVX512IFMA
+
+При поддержке процессором наборов AVX512F и AVX512IFMA (см. cpuHas())
+остатки от деления на простые p_i факторной базы вычисляются одновременно
+для 8 простых (64-битовая дорожка на простое). Число a разбивается на
+32-битовые части D_{l-1},..., D_0 и обрабатывается по схеме Горнера:
+	r_i <- 0,
+	r_i <- (r_i 2^32 + D_k) \mod p_i, k = l - 1,..., 0.
+
+Поскольку p_i < 2^13, x = r_i 2^32 + D_k < 2^45 (вычисляется сдвигом).
+Используется редукция Барретта с m_i = \lfloor 2^52 / p_i \rfloor:
+	q <- (x m_i) >> 52, r_i <- x - q p_i.
+Старшие и младшие 52 бита произведений вычисляются инструкциями
+vpmadd52huq, vpmadd52luq. Частное q занижено не более чем на 1, поэтому
+r_i < 2 p_i и сводится к [0, p_i) одним условным вычитанием:
+r_i <- min(r_i, r_i - p_i) для беззнаковых r_i.
+
+Чтобы скрыть задержки умножений, простые обрабатываются блоками
+по 32 (4 независимых вектора), оставшиеся -- по 8. Последние
+count % 8 простых обрабатываются функцией zzModW().
+
+Константы p_i, m_i вычисляются однократно (см. mtCallOnce()).
+
+\remark Реализация на AVX2 (8 32-битовых дорожек, умножения vpmulld)
+оказалась не быстрее скалярной: в скалярной реализации одно деление
+обслуживает несколько простых (см. _prods).
+*******************************************************************************
+*/
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__) ||\
+	(_MSC_VER >= 1910) && defined(_M_X64)
+
+#define PRI_IFMA
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+	#define PRI_IFMA_TARGET
+#else
+	#define PRI_IFMA_TARGET __attribute__((target("avx512f,avx512ifma")))
+#endif
+
+static size_t _once;
+static u64 _base_p[COUNT_OF(_base)];	/*< p_i */
+static u64 _base_m[COUNT_OF(_base)];	/*< \lfloor 2^52 / p_i \rfloor */
+
+static void priBaseInit()
+{
+	size_t i;
+	for (i = 0; i < COUNT_OF(_base); ++i)
+	{
+		_base_p[i] = (u64)_base[i];
+		_base_m[i] = ((u64)1 << 52) / _base_p[i];
+	}
+}
+
+#if (B_PER_W == 16)
+	#define priDigit32(a, n, k)\
+		((u32)(a)[2 * (k)] |\
+			(2 * (k) + 1 < (n) ? (u32)(a)[2 * (k) + 1] << 16 : 0))
+#elif (B_PER_W == 32)
+	#define priDigit32(a, n, k) ((u32)(a)[k])
+#else
+	#define priDigit32(a, n, k) ((u32)((a)[(k) / 2] >> ((k) % 2 * 32)))
+#endif
+
+#define priBaseModIFMALoad(r, m, p, i)\
+	r = _mm512_setzero_si512(),\
+	m = _mm512_loadu_si512(_base_m + (i)),\
+	p = _mm512_loadu_si512(_base_p + (i))
+
+#define priBaseModIFMAStep(r, m, p, d, z)\
+{\
+	__m512i x = _mm512_or_si512(_mm512_slli_epi64(r, 32), d);\
+	__m512i q = _mm512_madd52hi_epu64(z, x, m);\
+	x = _mm512_sub_epi64(x, _mm512_madd52lo_epu64(z, q, p));\
+	r = _mm512_min_epu64(x, _mm512_sub_epi64(x, p));\
+}
+
+#define priBaseModIFMAStore(mods, r)\
+{\
+	u64 t[8];\
+	size_t j;\
+	_mm512_storeu_si512(t, r);\
+	for (j = 0; j < 8; ++j)\
+		(mods)[j] = (word)t[j];\
+}
+
+PRI_IFMA_TARGET
+static size_t priBaseModIFMA(word mods[], const word a[], size_t n,
+	size_t count)
+{
+	const size_t l = (n * B_PER_W + 31) / 32;
+	const __m512i z = _mm512_setzero_si512();
+	__m512i r0, m0, p0, r1, m1, p1, r2, m2, p2, r3, m3, p3;
+	__m512i d;
+	size_t i, k;
+	// блоки по 32 простых
+	for (i = 0; i + 32 <= count; i += 32)
+	{
+		priBaseModIFMALoad(r0, m0, p0, i);
+		priBaseModIFMALoad(r1, m1, p1, i + 8);
+		priBaseModIFMALoad(r2, m2, p2, i + 16);
+		priBaseModIFMALoad(r3, m3, p3, i + 24);
+		for (k = l; k--;)
+		{
+			d = _mm512_set1_epi64((long long)priDigit32(a, n, k));
+			priBaseModIFMAStep(r0, m0, p0, d, z);
+			priBaseModIFMAStep(r1, m1, p1, d, z);
+			priBaseModIFMAStep(r2, m2, p2, d, z);
+			priBaseModIFMAStep(r3, m3, p3, d, z);
+		}
+		priBaseModIFMAStore(mods + i, r0);
+		priBaseModIFMAStore(mods + i + 8, r1);
+		priBaseModIFMAStore(mods + i + 16, r2);
+		priBaseModIFMAStore(mods + i + 24, r3);
+	}
+	// блоки по 8 простых
+	for (; i + 8 <= count; i += 8)
+	{
+		priBaseModIFMALoad(r0, m0, p0, i);
+		for (k = l; k--;)
+		{
+			d = _mm512_set1_epi64((long long)priDigit32(a, n, k));
+			priBaseModIFMAStep(r0, m0, p0, d, z);
+		}
+		priBaseModIFMAStore(mods + i, r0);
+	}
+	return i;
+}
+
+#endif
+
 void priBaseMod(word mods[], const word a[], size_t n, size_t count)
 {
 	size_t i, j;
@@ -382,6 +519,17 @@ void priBaseMod(word mods[], const word a[], size_t n, size_t count)
 	ASSERT(wwIsValid(a, n));
 	ASSERT(count <= priBaseSize());
 	ASSERT(wwIsValid(mods, count));
+#ifdef PRI_IFMA
+	// векторная реализация
+	if (count >= 8 && cpuHas(CPU_AVX512F | CPU_AVX512IFMA))
+	{
+		if (_once != 1)
+			mtCallOnce(&_once, priBaseInit);
+		for (i = priBaseModIFMA(mods, a, n, count); i < count; ++i)
+			mods[i] = zzModW(a, n, _base[i]);
+		return;
+	}
+#endif
 	// пробегаем произведения простых из факторной базы
 	for (i = j = 0; i < count && j < COUNT_OF(_prods); ++j)
 	{
@@ -582,6 +730,81 @@ size_t priIsPrimeW_deep()
 	return zzPowerModW_deep();
 }
 
+/*
+*******************************************************************************
+Параллельная проверка кандидатов
+
+Кандидаты, прошедшие проверку на факторной базе, собираются в пакеты
+по threads штук и тестируются одновременно: первый кандидат пакета
+обрабатывается в вызывающем потоке, остальные -- в дополнительных. Если
+дополнительный поток создать не удалось, то его кандидат обрабатывается
+в вызывающем потоке.
+
+Номер first первого (минимального) кандидата пакета, оказавшегося простым,
+обновляется атомарно. Проверка кандидата с номером, большим first,
+прекращается досрочно: ее результат уже не влияет на итог. Поэтому
+результат поиска не зависит от числа потоков и совпадает с результатом
+последовательного поиска.
+
+В pri_wk::stack размещаются кандидат и память для его тестирования.
+*******************************************************************************
+*/
+
+typedef struct pri_wk_st pri_wk;
+
+struct pri_wk_st
+{
+	size_t i;						/*< номер кандидата в пакете */
+	size_t* first;					/*< номер первого простого кандидата */
+	bool_t (*test)(const pri_wk*);	/*< тест простоты */
+	const void* arg;				/*< общие параметры теста */
+	word* p;						/*< кандидат */
+	void* stack;					/*< вспомогательная память */
+	bool_t thrd_ok;					/*< поток создан? */
+	mt_thrd_t thrd;					/*< поток */
+};
+
+static bool_t priWkIsLate(const pri_wk* wk)
+{
+	return wk && mtAtomicCmpSwap(wk->first, SIZE_MAX, SIZE_MAX) < wk->i;
+}
+
+static void priWkRun(void* arg)
+{
+	pri_wk* wk = (pri_wk*)arg;
+	size_t first, prev;
+	// меньший кандидат уже оказался простым?
+	if (priWkIsLate(wk) || !wk->test(wk))
+		return;
+	// first <- min(first, i)
+	first = mtAtomicCmpSwap(wk->first, SIZE_MAX, SIZE_MAX);
+	while (first > wk->i)
+	{
+		prev = mtAtomicCmpSwap(wk->first, first, wk->i);
+		if (prev == first)
+			break;
+		first = prev;
+	}
+}
+
+static size_t priWkBatch(pri_wk wk[], size_t k)
+{
+	size_t first = SIZE_MAX;
+	size_t t;
+	ASSERT(k > 0);
+	for (t = 0; t < k; ++t)
+		wk[t].i = t, wk[t].first = &first;
+	for (t = 1; t < k; ++t)
+		wk[t].thrd_ok = mtThrdCreate(&wk[t].thrd, priWkRun, wk + t);
+	priWkRun(wk);
+	for (t = 1; t < k; ++t)
+		if (wk[t].thrd_ok)
+			mtThrdJoin(&wk[t].thrd);
+		else
+			priWkRun(wk + t);
+	return first;
+}
+
 /*
 *******************************************************************************
 Тест Рабина -- Миллера
@@ -597,7 +820,8 @@ B_PER_IMPOSSLIBLE / log_2(24) <= B_PER_IMPOSSLIBLE / 4.5.
 *******************************************************************************
 */
 
-bool_t priRMTest(const word a[], size_t n, size_t iter, void* stack)
+static bool_t priRMTestWk(const word a[], size_t n, size_t iter,
+	const pri_wk* wk, void* stack)
 {
 	register size_t s;
 	register size_t m;
@@ -632,6 +856,12 @@ bool_t priRMTest(const word a[], size_t n, size_t iter, void* stack)
 	// итерации
 	while (iter--)
 	{
+		// проверка больше не нужна?
+		if (priWkIsLate(wk))
+		{
+			s = m = 0;
+			return FALSE;
+		}
 		// base <-R {1, \ldots, a - 1} \ {\pm one}
 		i = 0;
 		do
@@ -670,6 +900,11 @@ bool_t priRMTest(const word a[], size_t n, size_t iter, void* stack)
 	return TRUE;
 }
 
+bool_t priRMTest(const word a[], size_t n, size_t iter, void* stack)
+{
+	return priRMTestWk(a, n, iter, 0, stack);
+}
+
 size_t priRMTest_deep(size_t n)
 {
 	size_t qr_deep = zmCreate_deep(O_OF_W(n));
@@ -773,20 +1008,43 @@ size_t priNextPrimeW_deep()
 	return priIsPrimeW_deep();
 }
 
-bool_t priNextPrime(word p[], const word a[], size_t n, size_t trials,
-	size_t base_count, size_t iter, void* stack)
+typedef struct
+{
+	size_t n;			/*< длина кандидатов в словах */
+	size_t iter;		/*< число итераций теста Рабина -- Миллера */
+} pri_rm_arg;
+
+static bool_t priWkRM(const pri_wk* wk)
+{
+	const pri_rm_arg* arg = (const pri_rm_arg*)wk->arg;
+	return priRMTestWk(wk->p, arg->n, arg->iter, wk, wk->stack);
+}
+
+bool_t priNextPrimeMT(word p[], const word a[], size_t n, size_t trials,
+	size_t base_count, size_t iter, size_t threads, void* stack)
 {
 	size_t l;
-	size_t i;
-	bool_t base_success;
+	size_t i, k, first;
+	bool_t base_success, stop;
+	pri_rm_arg arg[1];
 	// переменные в stack
+	pri_wk* wk;
 	word* mods;
 	// pre
 	ASSERT(wwIsSameOrDisjoint(a, p, n));
 	ASSERT(base_count <= priBaseSize());
+	threads = MAX2(threads, 1);
 	// раскладка stack
-	mods = (word*)stack;
+	wk = (pri_wk*)stack;
+	mods = (word*)(wk + threads);
 	stack = mods + base_count;
+	for (k = 0; k < threads; ++k)
+	{
+		wk[k].test = priWkRM, wk[k].arg = arg;
+		wk[k].p = (word*)stack + k * (n + W_OF_O(priRMTest_deep(n)));
+		wk[k].stack = wk[k].p + n;
+	}
+	arg->n = n, arg->iter = iter;
 	// l <- битовая длина a
 	l = wwBitSize(a, n);
 	// 0-битовых и 1-битовых простых не существует
@@ -808,31 +1066,64 @@ bool_t priNextPrime(word p[], const word a[], size_t n, size_t trials,
 			base_success = FALSE;
 			break;
 		}
-	// попытки
-	while (trials == SIZE_MAX || trials--)
+	// пакеты кандидатов
+	for (stop = FALSE; !stop;)
 	{
-		// проверка простоты
-		if (base_success && priRMTest(p, n, iter, stack))
-			return TRUE;
-		// к следующему кандидату
-		if (zzAddW2(p, n, 2) || wwBitSize(p, n) > l)
-			return FALSE;
-		for (i = 0, base_success = TRUE; i < base_count; ++i)
+		// собрать пакет
+		for (k = 0; k < threads;)
+		{
+			// попытки исчерпаны?
+			if (trials != SIZE_MAX && trials-- == 0)
+			{
+				stop = TRUE;
+				break;
+			}
+			// кандидат прошел проверку на факторной базе?
+			if (base_success)
+				wwCopy(wk[k++].p, p, n);
+			// к следующему кандидату
+			if (zzAddW2(p, n, 2) || wwBitSize(p, n) > l)
+			{
+				stop = TRUE;
+				break;
+			}
+			for (i = 0, base_success = TRUE; i < base_count; ++i)
+			{
+				if (mods[i] < _base[i] - 2)
+					mods[i] += 2;
+				else if (mods[i] == _base[i] - 1)
+					mods[i] = 1;
+				else
+					mods[i] = 0, base_success = FALSE;
+			}
+		}
+		// проверить пакет
+		if (k && (first = priWkBatch(wk, k)) < k)
 		{
-			if (mods[i] < _base[i] - 2)
-				mods[i] += 2;
-			else if (mods[i] == _base[i] - 1)
-				mods[i] = 1;
-			else
-				mods[i] = 0, base_success = FALSE;
+			wwCopy(p, wk[first].p, n);
+			return TRUE;
 		}
 	}
 	return FALSE;
 }
 
+size_t priNextPrimeMT_deep(size_t n, size_t base_count, size_t threads)
+{
+	threads = MAX2(threads, 1);
+	return threads * (sizeof(pri_wk) + 
+			O_OF_W(n + W_OF_O(priRMTest_deep(n)))) +
+		O_OF_W(base_count);
+}
+
+bool_t priNextPrime(word p[], const word a[], size_t n, size_t trials,
+	size_t base_count, size_t iter, void* stack)
+{
+	return priNextPrimeMT(p, a, n, trials, base_count, iter, 1, stack);
+}
+
 size_t priNextPrime_deep(size_t n, size_t base_count)
 {
-	return base_count * O_PER_W + priRMTest_deep(n);
+	return priNextPrimeMT_deep(n, base_count, 1);
 }
 
 /*
@@ -878,22 +1169,156 @@ size_t priNextPrime_deep(size_t n, size_t base_count)
 *******************************************************************************
 */
 
-bool_t priExtendPrime2(word p[], size_t l, const word q[], size_t n,
-	const word a[], size_t m, size_t trials, size_t base_count, gen_i rng, 
-	void* rng_state, void* stack)
+typedef struct
+{
+	const word* q;		/*< базовое простое */
+	size_t n;			/*< длина q в словах */
+	const word* a;		/*< дополнительный делитель p - 1 */
+	size_t m;			/*< длина a в словах */
+	size_t np;			/*< длина кандидатов в словах */
+	size_t nr;			/*< длина кратностей r в словах */
+} pri_demytko_arg;
+
+static bool_t priWkDemytko(const pri_wk* wk)
+{
+	const pri_demytko_arg* arg = (const pri_demytko_arg*)wk->arg;
+	const size_t npo = O_OF_B(wwBitSize(wk->p, arg->np));
+	// переменные в stack
+	word* r;		/* [nr] */
+	word* t;		/* [np] */
+	word* four;		/* [np] */
+	qr_o* qr;
+	void* stack;
+	// раскладка stack
+	r = (word*)wk->stack;
+	t = r + arg->nr;
+	four = t + arg->np;
+	qr = (qr_o*)(four + arg->np);
+	stack = (octet*)qr + zmCreate_keep(O_OF_W(arg->np));
+	// создать кольцо вычетов \mod p
+	wwTo(t, npo, wk->p);
+	zmCreate(qr, (octet*)t, npo, stack);
+	// four <- 4 [в кольце qr]
+	qrAdd(four, qr->unity, qr->unity, qr);
+	qrAdd(four, four, four, qr);
+	// (4^r)^a \mod p != 1?
+	qrPower(t, four, r, arg->nr, qr, stack);
+	if (priWkIsLate(wk))
+		return FALSE;
+	qrPower(t, t, arg->a, arg->m, qr, stack);
+	if (qrCmp(t, qr->unity, qr) == 0 || priWkIsLate(wk))
+		return FALSE;
+	// ((4^r)^a)^q \mod p == 1?
+	qrPower(t, t, arg->q, arg->n, qr, stack);
+	return qrCmp(t, qr->unity, qr) == 0;
+}
+
+static size_t priWkDemytko_deep(size_t np, size_t nr)
+{
+	const size_t npo = O_OF_W(np);
+	const size_t qr_deep = zmCreate_deep(npo);
+	return O_OF_W(nr + 2 * np) + zmCreate_keep(npo) +
+		utilMax(2,
+			qr_deep,
+			qrPower_deep(np, np, qr_deep));
+}
+
+/*
+*******************************************************************************
+Решето серии кандидатов
+
+Кандидаты серии имеют вид p + 2j qa, j = 0, 1, .... Если mods[i] =
+p \mod b, mods1[i] = 2qa \mod b != 0 и inv1[i] = mods1[i]^{-1} \mod b, где
+b = _base[i], то на простое b делятся кандидаты с номерами
+	j \equiv -mods[i] inv1[i] \mod b.
+Функция priSieveWindow() отмечает в решете [W_OF_B(PRI_SIEVE_W)]sieve
+такие номера j < PRI_SIEVE_W для всех простых факторной базы. Каждое
+простое обрабатывается одним умножением и PRI_SIEVE_W / b установками
+битов, без операций над длинными числами.
+
+Функция priSeriesStep() переходит от p к p + 2g qa (одним умножением
+на малое число) и корректирует r и счетчик попыток trials точно так же,
+как при g отдельных шагах. Функция возвращает PRI_STEP_OVER, если битовая
+длина кандидата превысила l, и PRI_STEP_STOP, если исчерпаны попытки.
+*******************************************************************************
+*/
+
+#define PRI_SIEVE_W 1024
+
+#define PRI_STEP_OK		0
+#define PRI_STEP_OVER	1
+#define PRI_STEP_STOP	2
+
+static void priSieveWindow(word sieve[], const word mods[],
+	const word mods1[], const word inv1[], size_t base_count)
+{
+	size_t i, j;
+	word b;
+	wwSetZero(sieve, W_OF_B(PRI_SIEVE_W));
+	for (i = 0; i < base_count; ++i)
+	{
+		b = _base[i];
+		// все кандидаты дают одинаковые вычеты?
+		if (mods1[i] == 0)
+		{
+			if (mods[i] == 0)
+			{
+				memSet(sieve, 0xFF, O_OF_B(PRI_SIEVE_W));
+				return;
+			}
+			continue;
+		}
+		// j <- -mods[i] inv1[i] \mod b
+		j = mods[i] ? (size_t)((dword)(b - mods[i]) * inv1[i] % b) : 0;
+		for (; j < PRI_SIEVE_W; j += b)
+			wwSetBit(sieve, j, 1);
+	}
+}
+
+static int priSeriesStep(word p[], size_t np, size_t l, const word qa[],
+	size_t nqa, word r[], size_t nr, size_t g, size_t* trials)
+{
+	ASSERT(2 * g <= WORD_MAX);
+	// g <- число шагов до исчерпания попыток
+	if (*trials != SIZE_MAX && g > *trials)
+		g = *trials + 1;
+	// p <- p + 2g qa, переполнение?
+	if (zzAddW2(p + nqa, np - nqa, zzAddMulW(p, qa, nqa, (word)(2 * g))) ||
+		wwBitSize(p, np) > l)
+		return PRI_STEP_OVER;
+	// r <- r + g, без переполнения
+	VERIFY(zzAddW2(r, nr, (word)g) == 0);
+	// попытки исчерпаны?
+	if (*trials != SIZE_MAX)
+	{
+		if (g > *trials)
+			return PRI_STEP_STOP;
+		*trials -= g;
+	}
+	return PRI_STEP_OK;
+}
+
+bool_t priExtendPrime2MT(word p[], size_t l, const word q[], size_t n,
+	const word a[], size_t m, size_t trials, size_t base_count, 
+	size_t threads, gen_i rng, void* rng_state, void* stack)
 {
 	const size_t np = W_OF_B(l);
 	const size_t npo = O_OF_B(l);
-	size_t i;
+	const size_t nr = np - n - m + 3;
+	const size_t wk_size = np + W_OF_O(priWkDemytko_deep(np, nr));
+	size_t i, j, g, k, first;
 	size_t nqa;
+	int step;
+	pri_demytko_arg arg[1];
 	// переменные в stack
+	pri_wk* wk;		/* [threads] */
 	word* qa;		/* [n + m] */
 	word* t;		/* [np + 2] */
-	word* r;		/* [np - n - m + 3] */
-	word* four;		/* [np] */
-	word* mods;		/* base_count */
-	word* mods1;	/* base_count */
-	qr_o* qr;
+	word* r;		/* [nr] */
+	word* mods;		/* [base_count] */
+	word* mods1;	/* [base_count] */
+	word* inv1;		/* [base_count] */
+	word* sieve;	/* [W_OF_B(PRI_SIEVE_W)] */
 	// pre
 	ASSERT(wwIsDisjoint2(p, np, q, n));
 	ASSERT(wwIsValid(a, m));
@@ -903,15 +1328,24 @@ bool_t priExtendPrime2(word p[], size_t l, const word q[], size_t n,
 	ASSERT(l <= 2 * wwBitSize(q, n));
 	ASSERT(base_count <= priBaseSize());
 	ASSERT(rng != 0);
+	threads = MAX2(threads, 1);
 	// раскладка stack
-	qa = (word*)stack;
+	wk = (pri_wk*)stack;
+	qa = (word*)(wk + threads);
 	t = qa + n + m;
 	r = t + np + 2;
-	four = r + np - n - m + 3;
-	mods = four + np;
+	mods = r + nr;
 	mods1 = mods + base_count;
-	qr = (qr_o*)(mods1 + base_count);
-	stack = (octet*)qr + zmCreate_keep(npo);
+	inv1 = mods1 + base_count;
+	sieve = inv1 + base_count;
+	stack = sieve + W_OF_B(PRI_SIEVE_W);
+	for (k = 0; k < threads; ++k)
+	{
+		wk[k].test = priWkDemytko, wk[k].arg = arg;
+		wk[k].p = (word*)stack + k * wk_size;
+		wk[k].stack = wk[k].p + np;
+	}
+	stack = (word*)stack + threads * wk_size;
 	// малое p?
 	if (l < B_PER_W)
 		// при необходимости уменьшить факторную базу
@@ -922,6 +1356,19 @@ bool_t priExtendPrime2(word p[], size_t l, const word q[], size_t n,
 	zzMul(qa, q, n, a, m, stack); 
 	ASSERT(wwBitSize(qa, n + m) + 1 <= l);
 	nqa = wwWordSize(qa, n + m);
+	// общие параметры теста
+	arg->q = q, arg->n = n, arg->a = a, arg->m = m;
+	arg->np = np, arg->nr = np - nqa + 1;
+	ASSERT(arg->nr <= nr);
+	// рассчитать вычеты 2qa и обратные к ним по малым модулям
+	priBaseMod(mods1, qa, nqa, base_count);
+	for (i = 0; i < base_count; ++i)
+	{
+		if ((mods1[i] += mods1[i]) >= _base[i])
+			mods1[i] -= _base[i];
+		inv1[i] = mods1[i] ? 
+			zzPowerModW(mods1[i], _base[i] - 2, _base[i], stack) : 0;
+	}
 	// попытки
 	while (trials == SIZE_MAX || trials--)
 	{
@@ -942,77 +1389,93 @@ bool_t priExtendPrime2(word p[], size_t l, const word q[], size_t n,
 		wwShHi(p, np, 1);
 		++p[0];
 		ASSERT(wwBitSize(p, np) == l);
-		// рассчитать вычеты p, 2qa по малым модулям
+		// рассчитать вычеты p по малым модулям
 		priBaseMod(mods, p, np, base_count);
-		priBaseMod(mods1, qa, nqa, base_count);
-		for (i = 0; i < base_count; ++i)
-			if ((mods1[i] += mods1[i]) >= _base[i])
-				mods1[i] -= _base[i];
-		// проверка простоты
-		while (1)
+		// окна серии p, p + 2qa, p + 4qa,...
+		for (step = PRI_STEP_OK; step == PRI_STEP_OK;)
 		{
-			// p делится на малые простые?
-			for (i = 0; i < base_count; ++i)
-				if (mods[i] == 0)
-					break;
-			// не делится: тест Демитко
-			if (i == base_count)
+			priSieveWindow(sieve, mods, mods1, inv1, base_count);
+			for (j = k = 0; step == PRI_STEP_OK && j < PRI_SIEVE_W;)
 			{
-				// создать кольцо вычетов \mod p
-				wwTo(t, npo, p);
-				zmCreate(qr, (octet*)t, npo, stack);
-				// four <- 4 [в кольце qr]
-				qrAdd(four, qr->unity, qr->unity, qr);
-				qrAdd(four, four, four, qr);
-				// (4^r)^a \mod p != 1?
-				qrPower(t, four, r, np - nqa + 1, qr, stack);
-				qrPower(t, t, a, m, qr, stack);
-				if (qrCmp(t, qr->unity, qr) != 0)
+				// пропустить кандидатов, делящихся на малые простые
+				for (g = 0; j + g < PRI_SIEVE_W && wwTestBit(sieve, j + g);
+					++g);
+				if (g)
 				{
-					// ((4^r)^a)^q \mod p == 1?
-					qrPower(t, t, q, n, qr, stack);
-					if (qrCmp(t, qr->unity, qr) == 0)
-						return TRUE;
+					step = priSeriesStep(p, np, l, qa, nqa, r, arg->nr, g,
+						&trials);
+					j += g;
+					continue;
 				}
+				// кандидат -- в пакет
+				wwCopy(wk[k].p, p, np);
+				wwCopy(wk[k].stack, r, arg->nr);
+				++k, ++j;
+				step = priSeriesStep(p, np, l, qa, nqa, r, arg->nr, 1,
+					&trials);
+				// пакет собран?
+				if (k < threads)
+					continue;
+				// тест Демитко
+				if ((first = priWkBatch(wk, k)) < k)
+				{
+					wwCopy(p, wk[first].p, np);
+					return TRUE;
+				}
+				k = 0;
 			}
-			// p <- p + 2 * qa, переполнение?
-			if (zzAddW2(p + nqa, np - nqa, zzAdd2(p, qa, nqa)) ||
-				zzAddW2(p + nqa, np - nqa, zzAdd2(p, qa, nqa)) ||
-				wwBitSize(p, np) > l)
-				break;
-			// r <- r + 1, без переполнения
-			VERIFY(zzAddW2(r, np - nqa + 1, 1) == 0);
-			// пересчитать mods
-			for (i = 0; i < base_count; ++i)
-				if ((mods[i] += mods1[i]) >= _base[i])
-					mods[i] -= _base[i];
-			// к следующей попытке
-			if (trials != SIZE_MAX && trials-- == 0)
-				return FALSE;
+			// тест Демитко для неполного пакета
+			if (k && (first = priWkBatch(wk, k)) < k)
+			{
+				wwCopy(p, wk[first].p, np);
+				return TRUE;
+			}
+			// перейти к следующему окну: mods <- mods + PRI_SIEVE_W mods1
+			if (step == PRI_STEP_OK)
+				for (i = 0; i < base_count; ++i)
+					mods[i] = (word)((mods[i] + 
+						(dword)(PRI_SIEVE_W % _base[i]) * mods1[i]) % _base[i]);
 		}
+		if (step == PRI_STEP_STOP)
+			return FALSE;
 	}
 	return FALSE;
 }
 
-size_t priExtendPrime2_deep(size_t l, size_t n, size_t m, size_t base_count)
+size_t priExtendPrime2MT_deep(size_t l, size_t n, size_t m,
+	size_t base_count, size_t threads)
 {
 	const size_t np = W_OF_B(l);
-	const size_t npo = O_OF_B(l);
-	const size_t qr_deep = zmCreate_deep(npo);
+	const size_t nr = np - n - m + 3;
 	ASSERT(np >= n);
 	ASSERT(np + 3 >= n + m);
-	return O_OF_W(3 * np + 5 + 2 * base_count) + 
-		zmCreate_keep(npo) +
-		utilMax(5,
+	threads = MAX2(threads, 1);
+	return threads * (sizeof(pri_wk) +
+			O_OF_W(np + W_OF_O(priWkDemytko_deep(np, nr)))) +
+		O_OF_W(n + m + np + 2 + nr + 3 * base_count + W_OF_B(PRI_SIEVE_W)) +
+		utilMax(4,
 			zzMul_deep(n, m),
 			zzDiv_deep(np, n + m),
-			zzMul_deep(n + m, np - n - m + 3),
-			qr_deep,
-			qrPower_deep(np, np, qr_deep));
+			zzMul_deep(n + m, nr),
+			zzPowerModW_deep());
 }
 
-bool_t priExtendPrime(word p[], size_t l, const word q[], size_t n,
-	size_t trials, size_t base_count, gen_i rng, void* rng_state, void* stack)
+bool_t priExtendPrime2(word p[], size_t l, const word q[], size_t n,
+	const word a[], size_t m, size_t trials, size_t base_count, gen_i rng, 
+	void* rng_state, void* stack)
+{
+	return priExtendPrime2MT(p, l, q, n, a, m, trials, base_count, 1,
+		rng, rng_state, stack);
+}
+
+size_t priExtendPrime2_deep(size_t l, size_t n, size_t m, size_t base_count)
+{
+	return priExtendPrime2MT_deep(l, n, m, base_count, 1);
+}
+
+bool_t priExtendPrimeMT(word p[], size_t l, const word q[], size_t n,
+	size_t trials, size_t base_count, size_t threads, gen_i rng,
+	void* rng_state, void* stack)
 {
 	word* a;
 	// pre
@@ -1021,11 +1484,24 @@ bool_t priExtendPrime(word p[], size_t l, const word q[], size_t n,
 	a = (word*)stack;
 	a[0] = 1;
 	// расширить
-	return priExtendPrime2(p, l, q, n, a, 1, trials, base_count, 
+	return priExtendPrime2MT(p, l, q, n, a, 1, trials, base_count, threads, 
 		rng, rng_state, a + 1);
 }
 
+size_t priExtendPrimeMT_deep(size_t l, size_t n, size_t base_count,
+	size_t threads)
+{
+	return O_OF_W(1) + priExtendPrime2MT_deep(l, n, 1, base_count, threads);
+}
+
+bool_t priExtendPrime(word p[], size_t l, const word q[], size_t n,
+	size_t trials, size_t base_count, gen_i rng, void* rng_state, void* stack)
+{
+	return priExtendPrimeMT(p, l, q, n, trials, base_count, 1, rng,
+		rng_state, stack);
+}
+
 size_t priExtendPrime_deep(size_t l, size_t n, size_t base_count)
 {
-	return  O_OF_W(1) + priExtendPrime2_deep(l, n, 1, base_count);
+	return priExtendPrimeMT_deep(l, n, base_count, 1);
 }
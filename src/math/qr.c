@@ -4,7 +4,7 @@
 \brief Quotient rings
 \project bee2 [cryptographic library]
 \created 2013.09.14
-\version 2014.04.17
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -12,6 +12,7 @@
 
 #include "bee2/core/mem.h"
 #include "bee2/core/util.h"
+#include "bee2/core/word.h"
 #include "bee2/math/qr.h"
 #include "bee2/math/ww.h"
 
@@ -77,7 +78,8 @@ ICISC 2002], что l = wwBitSize(b) и доля ненулевых b_i для 
 зависит от l и не зависит от w.
 
 В функции qrCalcSlideWidth() определяется w, которое доставляет
-минимум целевой функции 2^{w - 1} + (l - w) / (w + 1).
+минимум целевой функции 2^{w - 1} + (l - w) / (w + 1). При сборке
+с директивой BEE2_LOW_MEMORY w не превосходит 4.
 *******************************************************************************
 */
 
@@ -86,6 +88,9 @@ static size_t qrCalcSlideWidth(size_t m)
 	m = B_OF_W(m);
 	if (m <= 79)
 		return 3;
+#ifdef BEE2_LOW_MEMORY
+	return 4;
+#else
 	if (m <= 239)
 		return 4;
 	if (m <= 671)
@@ -93,6 +98,7 @@ static size_t qrCalcSlideWidth(size_t m)
 	if (m <= 1791)
 		return 6;
 	return 7;
+#endif
 }
 
 void qrPower(word c[], const word a[], const word b[], size_t m, 
@@ -182,3 +188,405 @@ size_t qrPower_deep(size_t n, size_t m, size_t r_deep)
 	const size_t powers_count = SIZE_1 << (qrCalcSlideWidth(m) - 1);
 	return O_OF_W(n + n * powers_count) + r_deep;
 }
+
+/*
+*******************************************************************************
+Регулярное возведение в степень
+
+В функции qrPowerCT() реализован метод фиксированного окна. Предварительно
+рассчитываются все малые степени
+	a^0, a^1,..., a^{2^w - 1},
+где w --- величина окна. Затем показатель b, дополненный до B_OF_W(m)
+битов, разбивается на фрагменты (окна) по w битов (старший фрагмент может
+быть короче). Обработка окна состоит в w возведениях в квадрат
+и последующем умножении на малую степень, номер которой равняется окну.
+Умножение выполняется и для нулевых окон (на a^0 = r->unity).
+
+Малая степень выбирается из таблицы функцией qrPowerSelect(): читаются
+все элементы таблицы, ненужные обнуляются масками. Таким образом, ни
+последовательность операций, ни адреса обращений к памяти не зависят от b.
+
+Для расчета малых степеней требуется 2^w - 2 умножения, для обработки окон
+еще около l / w умножений, где l = B_OF_W(m). В функции qrCalcFixedWidth()
+определяется w, которое доставляет минимум 2^w + l / w (при сборке
+с директивой BEE2_LOW_MEMORY -- не больше 4).
+*******************************************************************************
+*/
+
+static size_t qrCalcFixedWidth(size_t m)
+{
+	m = B_OF_W(m);
+	if (m <= 96)
+		return 3;
+#ifdef BEE2_LOW_MEMORY
+	return 4;
+#else
+	if (m <= 320)
+		return 4;
+	if (m <= 960)
+		return 5;
+	return 6;
+#endif
+}
+
+static void qrPowerSelect(word c[], const word powers[], size_t count,
+	register size_t i, size_t n)
+{
+	register word mask;
+	size_t j, k;
+	ASSERT(i < count);
+	wwSetZero(c, n);
+	for (j = 0; j < count; ++j, powers += n)
+	{
+		// mask <- (i == j) ? WORD_MAX : 0
+		mask = WORD_0 - (((word)(i ^ j) - WORD_1) >> (B_PER_W - 1));
+		for (k = 0; k < n; ++k)
+			c[k] |= powers[k] & mask;
+	}
+	mask = 0, i = 0;
+}
+
+void qrPowerCT(word c[], const word a[], const word b[], size_t m,
+	const qr_o* r, void* stack)
+{
+	const size_t w = qrCalcFixedWidth(m);
+	const size_t powers_count = SIZE_1 << w;
+	size_t pos, i;
+	// переменные в stack
+	word* power;
+	word* t;
+	word* powers;
+	// pre
+	ASSERT(qrIsOperable(r));
+	ASSERT(wwIsValid(a, r->n));
+	ASSERT(wwIsValid(b, m));
+	ASSERT(wwIsValid(c, r->n));
+	ASSERT(m > 0);
+	// раскладка stack
+	power = (word*)stack;
+	t = power + r->n;
+	powers = t + r->n;
+	stack = powers + r->n * powers_count;
+	// powers[i] <- a^i
+	wwCopy(powers, r->unity, r->n);
+	wwCopy(powers + r->n, a, r->n);
+	for (i = 2; i < powers_count; ++i)
+		qrMul(powers + r->n * i, powers + r->n * i - r->n, a, r, stack);
+	// pos <- позиция старшего окна
+	pos = (B_OF_W(m) - 1) / w * w;
+	// power <- powers[старшее окно b]
+	qrPowerSelect(power, powers, powers_count,
+		(size_t)wwGetBits(b, pos, B_OF_W(m) - pos), r->n);
+	// остальные окна
+	while (pos)
+	{
+		pos -= w;
+		for (i = 0; i < w; ++i)
+			qrSqr(power, power, r, stack);
+		qrPowerSelect(t, powers, powers_count, (size_t)wwGetBits(b, pos, w),
+			r->n);
+		qrMul(power, power, t, r, stack);
+	}
+	// очистка и возврат
+	wwCopy(c, power, r->n);
+	wwSetZero(t, r->n);
+	wwSetZero(powers, r->n * powers_count);
+}
+
+size_t qrPowerCT_deep(size_t n, size_t m, size_t r_deep)
+{
+	const size_t powers_count = SIZE_1 << qrCalcFixedWidth(m);
+	return O_OF_W(2 * n + n * powers_count) + r_deep;
+}
+
+/*
+*******************************************************************************
+Возведение в степень фиксированного основания
+
+В функциях qrCombPrecomp(), qrCombPowerCT() реализован гребенчатый метод
+(см. ecCombPrecompA(), ecCombMulA()). Показатель b длины l = B_OF_W(m)
+битов записывается в виде таблицы из w строк и s = \ceil(l / w) столбцов:
+бит с номером i * s + col размещается в строке i и столбце col.
+Для каждого w-битового значения j столбца заранее рассчитывается
+	pre[j] <- \prod_{i: j_i = 1} a^{2^{is}},	j = 0, 1,..., 2^w - 1.
+Тогда a^b определяется за s возведений в квадрат и s умножений
+(вместо l возведений в квадрат и l / w умножений в qrPowerCT()).
+
+Элементы таблицы выбираются функцией qrPowerSelect(). Поэтому, как
+и в qrPowerCT(), ни последовательность операций, ни адреса обращений
+к памяти не зависят от b.
+*******************************************************************************
+*/
+
+void qrCombPrecomp(word pre[], const word a[], size_t w, size_t m,
+	const qr_o* r, void* stack)
+{
+	const size_t s = (B_OF_W(m) + w - 1) / w;
+	size_t i, j, hi;
+	// pre
+	ASSERT(qrIsOperable(r));
+	ASSERT(1 <= w && w < B_PER_S && m > 0);
+	ASSERT(wwIsValid(pre, r->n << w));
+	ASSERT(wwIsValid(a, r->n));
+	// pre[0] <- 1, pre[2^i] <- a^{2^{is}}
+	wwCopy(pre, r->unity, r->n);
+	wwCopy(pre + r->n, a, r->n);
+	for (i = 1; i < w; ++i)
+	{
+		wwCopy(pre + (r->n << i), pre + (r->n << (i - 1)), r->n);
+		for (j = 0; j < s; ++j)
+			qrSqr(pre + (r->n << i), pre + (r->n << i), r, stack);
+	}
+	// pre[j] <- pre[j - hi] * pre[hi], hi -- старший бит j
+	for (j = 3, hi = 2; j < (SIZE_1 << w); ++j)
+	{
+		if (j == 2 * hi)
+		{
+			hi = j;
+			continue;
+		}
+		qrMul(pre + r->n * j, pre + r->n * (j - hi), pre + r->n * hi, r,
+			stack);
+	}
+}
+
+size_t qrCombPrecomp_deep(size_t n, size_t r_deep)
+{
+	return r_deep;
+}
+
+void qrCombPowerCT(word c[], const word pre[], size_t w, const word b[],
+	size_t m, const qr_o* r, void* stack)
+{
+	const size_t l = B_OF_W(m);
+	const size_t s = (l + w - 1) / w;
+	register size_t j;
+	size_t col, i, pos;
+	// переменные в stack
+	word* power;
+	word* t;
+	// pre
+	ASSERT(qrIsOperable(r));
+	ASSERT(1 <= w && w < B_PER_S && m > 0);
+	ASSERT(wwIsValid(pre, r->n << w));
+	ASSERT(wwIsValid(b, m));
+	ASSERT(wwIsValid(c, r->n));
+	// раскладка stack
+	power = (word*)stack;
+	t = power + r->n;
+	stack = t + r->n;
+	// цикл по столбцам
+	wwCopy(power, r->unity, r->n);
+	for (col = s; col--;)
+	{
+		// power <- power^2
+		qrSqr(power, power, r, stack);
+		// j <- столбец b
+		for (i = w, j = 0; i--;)
+		{
+			pos = i * s + col;
+			j = j << 1 | (pos < l ? (size_t)wwTestBit(b, pos) : 0);
+		}
+		// power <- power * pre[j]
+		qrPowerSelect(t, pre, SIZE_1 << w, j, r->n);
+		qrMul(power, power, t, r, stack);
+	}
+	// очистка и возврат
+	j = 0;
+	wwCopy(c, power, r->n);
+	wwSetZero(t, r->n);
+}
+
+size_t qrCombPowerCT_deep(size_t n, size_t r_deep)
+{
+	return O_OF_W(2 * n) + r_deep;
+}
+
+/*
+*******************************************************************************
+Совместное возведение в степень
+
+В функции qrPower2() реализован метод Штрауса с чередующимися скользящими
+окнами (c = a^b d^e). Для каждого основания рассчитываются малые нечетные
+степени (как в qrPower()) с величиной окна qrCalcSlideWidth().
+
+Биты показателей пробегаются одновременно, от старших к младшим. Каждый
+бит обрабатывается одним возведением c в квадрат. Если в показателе
+начинается слайд, то запоминается его значение и позиция младшего бита.
+При достижении этой позиции c умножается на соответствующую малую степень.
+
+По сравнению с раздельным вычислением a^b и d^e число возведений в квадрат
+сокращается примерно вдвое, число умножений не меняется.
+*******************************************************************************
+*/
+
+static void qrPower2Prepare(word powers[], const word a[], size_t count,
+	const qr_o* r, void* stack)
+{
+	size_t i;
+	ASSERT(count > 0);
+	if (count == 1)
+		wwCopy(powers, a, r->n);
+	else
+	{
+		// powers[0] <- a^2, powers[i] <- a^{2i + 1}
+		qrSqr(powers, a, r, stack);
+		qrMul(powers + r->n, a, powers, r, stack);
+		for (i = 2; i < count; ++i)
+			qrMul(powers + r->n * i, powers + r->n * i - r->n, powers, r,
+				stack);
+		wwCopy(powers, a, r->n);
+	}
+}
+
+void qrPower2(word c[], const word a[], const word b[], size_t m,
+	const word d[], const word e[], size_t k, const qr_o* r, void* stack)
+{
+	const size_t wb = qrCalcSlideWidth(m);
+	const size_t we = qrCalcSlideWidth(k);
+	size_t lb, le;
+	size_t pos, pos_b, pos_e;
+	word slide_b, slide_e;
+	size_t slide_size;
+	bool_t is_unity;
+	// переменные в stack
+	word* power;
+	word* powers_b;
+	word* powers_e;
+	// pre
+	ASSERT(qrIsOperable(r));
+	ASSERT(wwIsValid(a, r->n) && wwIsValid(b, m));
+	ASSERT(wwIsValid(d, r->n) && wwIsValid(e, k));
+	ASSERT(wwIsValid(c, r->n));
+	// раскладка stack
+	power = (word*)stack;
+	powers_b = power + r->n;
+	powers_e = powers_b + (r->n << (wb - 1));
+	stack = powers_e + (r->n << (we - 1));
+	// расчет малых степеней
+	lb = wwBitSize(b, m), le = wwBitSize(e, k);
+	if (lb)
+		qrPower2Prepare(powers_b, a, SIZE_1 << (wb - 1), r, stack);
+	if (le)
+		qrPower2Prepare(powers_e, d, SIZE_1 << (we - 1), r, stack);
+	// пробегаем биты показателей
+	wwCopy(power, r->unity, r->n);
+	is_unity = TRUE;
+	pos_b = pos_e = SIZE_MAX;
+	slide_b = slide_e = 0;
+	for (pos = MAX2(lb, le); pos--;)
+	{
+		// power <- power^2
+		if (!is_unity)
+			qrSqr(power, power, r, stack);
+		// начинается слайд b?
+		if (pos_b == SIZE_MAX && pos < lb && wwTestBit(b, pos))
+		{
+			slide_size = MIN2(pos + 1, wb);
+			slide_b = wwGetBits(b, pos - slide_size + 1, slide_size);
+			while (slide_b % 2 == 0)
+				slide_b >>= 1, slide_size--;
+			pos_b = pos - slide_size + 1;
+		}
+		// начинается слайд e?
+		if (pos_e == SIZE_MAX && pos < le && wwTestBit(e, pos))
+		{
+			slide_size = MIN2(pos + 1, we);
+			slide_e = wwGetBits(e, pos - slide_size + 1, slide_size);
+			while (slide_e % 2 == 0)
+				slide_e >>= 1, slide_size--;
+			pos_e = pos - slide_size + 1;
+		}
+		// завершается слайд b?
+		if (pos_b == pos)
+		{
+			if (is_unity)
+				wwCopy(power, powers_b + r->n * (slide_b / 2), r->n);
+			else
+				qrMul(power, power, powers_b + r->n * (slide_b / 2), r,
+					stack);
+			is_unity = FALSE, pos_b = SIZE_MAX;
+		}
+		// завершается слайд e?
+		if (pos_e == pos)
+		{
+			if (is_unity)
+				wwCopy(power, powers_e + r->n * (slide_e / 2), r->n);
+			else
+				qrMul(power, power, powers_e + r->n * (slide_e / 2), r,
+					stack);
+			is_unity = FALSE, pos_e = SIZE_MAX;
+		}
+	}
+	// очистка и возврат
+	slide_b = slide_e = 0, slide_size = 0;
+	wwCopy(c, power, r->n);
+}
+
+size_t qrPower2_deep(size_t n, size_t m, size_t k, size_t r_deep)
+{
+	const size_t powers_count = (SIZE_1 << (qrCalcSlideWidth(m) - 1)) +
+		(SIZE_1 << (qrCalcSlideWidth(k) - 1));
+	return O_OF_W(n + n * powers_count) + r_deep;
+}
+
+/*
+*******************************************************************************
+Пакетное обращение
+
+Реализован трюк Монтгомери [Algorithm 11.15 Simultaneous inversion,
+CohenFrey, p. 209]:
+	u_0 <- a_0
+	for t = 1,..., T - 1: u_t <- u_{t-1} a_t
+	v <- u_{T-1}^{-1}
+	for t = T - 1,..., 1:
+		a_t^{-1} <- v u_{t-1}
+		v <- v a_t
+	a_0^{-1} <- v.
+Произведения u_t сохраняются в b. Нулевые a_t в произведения
+не включаются.
+*******************************************************************************
+*/
+
+void qrInvBatch(word b[], const word a[], size_t count, const qr_o* r,
+	void* stack)
+{
+	const size_t n = r->n;
+	size_t first, i;
+	// переменные в stack
+	word* v = (word*)stack;
+	stack = v + n;
+	// pre
+	ASSERT(qrIsOperable(r));
+	ASSERT(wwIsValid(a, n * count) && wwIsValid(b, n * count));
+	ASSERT(wwIsDisjoint(a, b, n * count));
+	// пропустить начальные нулевые a[i]
+	for (first = 0; first < count && qrIsZero(a + n * first, r); ++first)
+		qrSetZero(b + n * first, r);
+	if (first == count)
+		return;
+	// b[i] <- a[first] ... a[i] (без нулевых a[j])
+	wwCopy(b + n * first, a + n * first, n);
+	for (i = first + 1; i < count; ++i)
+		if (qrIsZero(a + n * i, r))
+			wwCopy(b + n * i, b + n * i - n, n);
+		else
+			qrMul(b + n * i, b + n * i - n, a + n * i, r, stack);
+	// v <- b[count - 1]^{-1}
+	qrInv(v, b + n * (count - 1), r, stack);
+	// b[i] <- a[i]^{-1}
+	for (i = count - 1; i > first; --i)
+		if (qrIsZero(a + n * i, r))
+			qrSetZero(b + n * i, r);
+		else
+		{
+			qrMul(b + n * i, v, b + n * i - n, r, stack);
+			qrMul(v, v, a + n * i, r, stack);
+		}
+	wwCopy(b + n * first, v, n);
+}
+
+size_t qrInvBatch_deep(size_t n, size_t r_deep)
+{
+	return O_OF_W(n) + r_deep;
+}
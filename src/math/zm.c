@@ -4,7 +4,7 @@
 \brief Quotient rings of integers modulo m
 \project bee2 [cryptographic library]
 \created 2013.09.14
-\version 2016.07.04
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -16,6 +16,7 @@
 #include "bee2/math/ww.h"
 #include "bee2/math/zm.h"
 #include "bee2/math/zz.h"
+#include "zm_lcl.h"
 
 /*
 *******************************************************************************
@@ -178,6 +179,401 @@ size_t zmCreatePlain_deep(size_t no)
 		zmDiv_deep(n));
 }
 
+/*
+*******************************************************************************
+Фиксированные размерности
+
+Для модулей длины 192, 256, 384 и 512 битов (n = 3, 4, 6, 8 при
+B_PER_W == 64, n = 6, 8, 12, 16 при B_PER_W == 32) умножение и возведение
+в квадрат в кольцах с редукциями Крэндалла и Монтгомери реализуются
+отдельными функциями с фиксированной размерностью. Размерность передается
+вспомогательным функциям как константа, и компилятор полностью разворачивает
+циклы.
+
+Умножение и возведение в квадрат выполняются так же, как в zzMul() и zzSqr(),
+но удвоение перекрестных произведений при возведении в квадрат совмещается
+со сложением с квадратами слов.
+
+Редукции выполняются без ветвлений, зависящих от данных. Финальное
+вычитание модуля выполняется по маске.
+
+Кроме этого, для модулей указанных длин реализуются сложение, вычитание
+и деление на 2 (zmAddModXXX(), zmSubModXXX(), zmHalfModXXX()). Эти функции,
+а также zmMulCrandXXX() и zmSqrCrandXXX(), объявлены в zm_lcl.h: они
+вызываются напрямую в ecp.c.
+
+Для модулей Крэндалла p = B^n - c дополнительно реализуются ленивое
+сложение zmAddLazyXXX() и вычитание zmSubCrandXXX(). Если a, b < p
+и при сложении возник перенос, то a + b - B^n + c < p. Поэтому в ленивом
+сложении при переносе к сумме добавляется c, а сравнение с p не
+выполняется: результат меньше B^n, но может быть не меньше p. Такие
+результаты допускаются на входе zmMulCrandXXX() и zmSqrCrandXXX():
+редукция Крэндалла корректна для любых сомножителей, меньших B^n.
+Аналогично, если при вычитании возник заем, то от разности отнимается c,
+и результат сразу оказывается меньше p.
+*******************************************************************************
+*/
+
+#if (B_PER_W == 32 || B_PER_W == 64)
+
+static void zmMulFix(word c[], const word a[], const word b[], size_t n)
+{
+	register dword t;
+	register word carry;
+	size_t i, j;
+	for (j = 0, carry = 0; j < n; ++j)
+	{
+		t = (dword)a[0] * b[j] + carry;
+		c[j] = (word)t, carry = (word)(t >> B_PER_W);
+	}
+	c[n] = carry;
+	for (i = 1; i < n; ++i)
+	{
+		for (j = 0, carry = 0; j < n; ++j)
+		{
+			t = (dword)a[i] * b[j] + c[i + j] + carry;
+			c[i + j] = (word)t, carry = (word)(t >> B_PER_W);
+		}
+		c[i + n] = carry;
+	}
+	t = 0, carry = 0;
+}
+
+static void zmSqrFix(word b[], const word a[], size_t n)
+{
+	register dword t;
+	register word carry, lo, hi;
+	size_t i, j;
+	// b <- \sum_{i < j} a_i a_j B^{i + j}
+	b[0] = 0;
+	for (j = 1, carry = 0; j < n; ++j)
+	{
+		t = (dword)a[0] * a[j] + carry;
+		b[j] = (word)t, carry = (word)(t >> B_PER_W);
+	}
+	b[n] = carry;
+	for (i = 1; i < n; ++i)
+	{
+		for (j = i + 1, carry = 0; j < n; ++j)
+		{
+			t = (dword)a[i] * a[j] + b[i + j] + carry;
+			b[i + j] = (word)t, carry = (word)(t >> B_PER_W);
+		}
+		b[i + n] = carry;
+	}
+	// b <- 2 b + \sum a_i^2 B^{2i}
+	for (i = 0, carry = 0; i < n; ++i)
+	{
+		lo = b[2 * i], hi = b[2 * i + 1];
+		t = (dword)a[i] * a[i] + carry + (word)(lo << 1);
+		b[2 * i] = (word)t, t >>= B_PER_W;
+		t += (word)(hi << 1 | lo >> (B_PER_W - 1));
+		b[2 * i + 1] = (word)t;
+		carry = (word)(t >> B_PER_W) + (hi >> (B_PER_W - 1));
+	}
+	t = 0, carry = lo = hi = 0;
+}
+
+/*	Выбор по маске: a <- mask ? b : a. */
+static void zmFixSel(word a[], const word b[], register word mask, size_t n)
+{
+	size_t i;
+	for (i = 0; i < n; ++i)
+		a[i] ^= mask & (a[i] ^ b[i]);
+}
+
+/*	[n]a <- [2n]a \mod (B^n - c) (см. zzRedCrand()). */
+static void zmRedCrandFix(word a[], register word c, size_t n)
+{
+	word s[16];
+	register dword t;
+	register word carry = 0;
+	size_t i;
+	// iter1: a <- a0 + a1 c
+	for (i = 0; i < n; ++i)
+	{
+		t = (dword)a[n + i] * c + a[i] + carry;
+		a[i] = (word)t, carry = (word)(t >> B_PER_W);
+	}
+	// iter2: a <- a0 + a1 c
+	t = (dword)carry * c + a[0];
+	a[0] = (word)t, carry = (word)(t >> B_PER_W);
+	for (i = 1; i < n; ++i)
+	{
+		t = (dword)a[i] + carry;
+		a[i] = (word)t, carry = (word)(t >> B_PER_W);
+	}
+	// s <- a + c \mod B^n, a >= B^n - c <=> перенос в s
+	t = (dword)a[0] + c;
+	s[0] = (word)t, t >>= B_PER_W;
+	for (i = 1; i < n; ++i)
+	{
+		t += a[i];
+		s[i] = (word)t, t >>= B_PER_W;
+	}
+	// correct
+	zmFixSel(a, s, WORD_0 - (carry | (word)t), n);
+	// очистка
+	t = 0, carry = 0;
+}
+
+/*	[n]a <- [2n]a B^{-n} \mod mod (см. zzRedMont()). */
+static void zmRedMontFix(word a[], const word mod[], register word m0,
+	size_t n)
+{
+	word s[16];
+	register dword t;
+	register word w, hi, carry = 0;
+	size_t i, j;
+	// редукция в редакции Дуссе -- Калиски
+	for (i = 0; i < n; ++i)
+	{
+		w = a[i] * m0, hi = 0;
+		for (j = 0; j < n; ++j)
+		{
+			t = (dword)w * mod[j] + a[i + j] + hi;
+			a[i + j] = (word)t, hi = (word)(t >> B_PER_W);
+		}
+		t = (dword)a[i + n] + hi + carry;
+		a[i + n] = (word)t, carry = (word)(t >> B_PER_W);
+	}
+	// a <- a / B^n, s <- a - mod
+	for (i = 0, w = 0; i < n; ++i)
+	{
+		a[i] = a[n + i];
+		t = (dword)a[i] - mod[i] - w;
+		s[i] = (word)t, w = (word)(t >> B_PER_W) & 1;
+	}
+	// a >= mod => a <- s
+	zmFixSel(a, s, WORD_0 - (carry | (w ^ 1)), n);
+	// очистка
+	t = 0, w = hi = carry = 0;
+}
+
+/*	c <- a + b \mod mod. */
+static void zmAddModFix(word c[], const word a[], const word b[],
+	const word mod[], size_t n)
+{
+	word s[16];
+	register dword t;
+	register word carry = 0, borrow = 0;
+	size_t i;
+	for (i = 0; i < n; ++i)
+	{
+		t = (dword)a[i] + b[i] + carry;
+		c[i] = (word)t, carry = (word)(t >> B_PER_W);
+	}
+	for (i = 0; i < n; ++i)
+	{
+		t = (dword)c[i] - mod[i] - borrow;
+		s[i] = (word)t, borrow = (word)(t >> B_PER_W) & 1;
+	}
+	// c >= mod => c <- s
+	zmFixSel(c, s, WORD_0 - (carry | (borrow ^ 1)), n);
+	t = 0, carry = borrow = 0;
+}
+
+/*	c <- a - b \mod mod. */
+static void zmSubModFix(word c[], const word a[], const word b[],
+	const word mod[], size_t n)
+{
+	word s[16];
+	register dword t;
+	register word carry = 0, borrow = 0;
+	size_t i;
+	for (i = 0; i < n; ++i)
+	{
+		t = (dword)a[i] - b[i] - borrow;
+		c[i] = (word)t, borrow = (word)(t >> B_PER_W) & 1;
+	}
+	for (i = 0; i < n; ++i)
+	{
+		t = (dword)c[i] + mod[i] + carry;
+		s[i] = (word)t, carry = (word)(t >> B_PER_W);
+	}
+	// a < b => c <- s
+	zmFixSel(c, s, WORD_0 - borrow, n);
+	t = 0, carry = borrow = 0;
+}
+
+/*	c <- a + b \mod (B^n - c0) без финальной редукции: c < B^n. */
+static void zmAddLazyFix(word c[], const word a[], const word b[],
+	register word c0, size_t n)
+{
+	register dword t;
+	register word carry = 0;
+	size_t i;
+	for (i = 0; i < n; ++i)
+	{
+		t = (dword)a[i] + b[i] + carry;
+		c[i] = (word)t, carry = (word)(t >> B_PER_W);
+	}
+	// перенос => c <- c + c0 (вычитание B^n - c0 по модулю B^n)
+	t = (dword)c[0] + (c0 & (WORD_0 - carry));
+	c[0] = (word)t, carry = (word)(t >> B_PER_W);
+	for (i = 1; i < n; ++i)
+	{
+		t = (dword)c[i] + carry;
+		c[i] = (word)t, carry = (word)(t >> B_PER_W);
+	}
+	ASSERT(carry == 0);
+	t = 0, carry = 0;
+}
+
+/*	c <- a - b \mod (B^n - c0). */
+static void zmSubCrandFix(word c[], const word a[], const word b[],
+	register word c0, size_t n)
+{
+	register dword t;
+	register word borrow = 0;
+	size_t i;
+	for (i = 0; i < n; ++i)
+	{
+		t = (dword)a[i] - b[i] - borrow;
+		c[i] = (word)t, borrow = (word)(t >> B_PER_W) & 1;
+	}
+	// заем => c <- c - c0 (сложение с B^n - c0 по модулю B^n)
+	t = (dword)c[0] - (c0 & (WORD_0 - borrow));
+	c[0] = (word)t, borrow = (word)(t >> B_PER_W) & 1;
+	for (i = 1; i < n; ++i)
+	{
+		t = (dword)c[i] - borrow;
+		c[i] = (word)t, borrow = (word)(t >> B_PER_W) & 1;
+	}
+	ASSERT(borrow == 0);
+	t = 0, borrow = 0;
+}
+
+/*	b <- a / 2 \mod mod (mod -- нечетный). */
+static void zmHalfModFix(word b[], const word a[], const word mod[],
+	size_t n)
+{
+	register dword t;
+	register word mask = WORD_0 - (a[0] & 1), carry = 0;
+	size_t i;
+	// b <- a + (a нечетное ? mod : 0)
+	for (i = 0; i < n; ++i)
+	{
+		t = (dword)a[i] + (mod[i] & mask) + carry;
+		b[i] = (word)t, carry = (word)(t >> B_PER_W);
+	}
+	// b <- b / 2
+	for (i = 0; i + 1 < n; ++i)
+		b[i] = b[i] >> 1 | b[i + 1] << (B_PER_W - 1);
+	b[n - 1] = b[n - 1] >> 1 | carry << (B_PER_W - 1);
+	t = 0, mask = carry = 0;
+}
+
+#define ZM_FIX(bits)\
+void zmAddMod##bits(word c[], const word a[], const word b[],\
+	const word mod[])\
+{\
+	zmAddModFix(c, a, b, mod, bits / B_PER_W);\
+}\
+\
+void zmSubMod##bits(word c[], const word a[], const word b[],\
+	const word mod[])\
+{\
+	zmSubModFix(c, a, b, mod, bits / B_PER_W);\
+}\
+\
+void zmHalfMod##bits(word b[], const word a[], const word mod[])\
+{\
+	zmHalfModFix(b, a, mod, bits / B_PER_W);\
+}\
+\
+void zmAddLazy##bits(word c[], const word a[], const word b[],\
+	const word mod[])\
+{\
+	zmAddLazyFix(c, a, b, WORD_0 - mod[0], bits / B_PER_W);\
+}\
+\
+void zmSubCrand##bits(word c[], const word a[], const word b[],\
+	const word mod[])\
+{\
+	zmSubCrandFix(c, a, b, WORD_0 - mod[0], bits / B_PER_W);\
+}\
+\
+void zmMulCrand##bits(word c[], const word a[], const word b[],\
+	const qr_o* r, void* stack)\
+{\
+	word prod[2 * bits / B_PER_W];\
+	ASSERT(zmIsOperable(r) && r->n == bits / B_PER_W);\
+	ASSERT(wwIsValid(a, bits / B_PER_W) && wwIsValid(b, bits / B_PER_W));\
+	zmMulFix(prod, a, b, bits / B_PER_W);\
+	zmRedCrandFix(prod, WORD_0 - r->mod[0], bits / B_PER_W);\
+	wwCopy(c, prod, bits / B_PER_W);\
+}\
+\
+void zmSqrCrand##bits(word b[], const word a[], const qr_o* r,\
+	void* stack)\
+{\
+	word prod[2 * bits / B_PER_W];\
+	ASSERT(zmIsOperable(r) && r->n == bits / B_PER_W);\
+	ASSERT(wwIsValid(a, bits / B_PER_W));\
+	zmSqrFix(prod, a, bits / B_PER_W);\
+	zmRedCrandFix(prod, WORD_0 - r->mod[0], bits / B_PER_W);\
+	wwCopy(b, prod, bits / B_PER_W);\
+}\
+\
+static void zmMulMont##bits(word c[], const word a[], const word b[],\
+	const qr_o* r, void* stack)\
+{\
+	word prod[2 * bits / B_PER_W];\
+	ASSERT(zmIsOperable(r) && r->n == bits / B_PER_W);\
+	ASSERT(zmIsIn(a, r) && zmIsIn(b, r));\
+	zmMulFix(prod, a, b, bits / B_PER_W);\
+	zmRedMontFix(prod, r->mod, *(const word*)r->params, bits / B_PER_W);\
+	wwCopy(c, prod, bits / B_PER_W);\
+}\
+\
+static void zmSqrMont##bits(word b[], const word a[], const qr_o* r,\
+	void* stack)\
+{\
+	word prod[2 * bits / B_PER_W];\
+	ASSERT(zmIsOperable(r) && r->n == bits / B_PER_W);\
+	ASSERT(zmIsIn(a, r));\
+	zmSqrFix(prod, a, bits / B_PER_W);\
+	zmRedMontFix(prod, r->mod, *(const word*)r->params, bits / B_PER_W);\
+	wwCopy(b, prod, bits / B_PER_W);\
+}\
+
+ZM_FIX(192)
+ZM_FIX(256)
+ZM_FIX(384)
+ZM_FIX(512)
+
+static void zmFixCrand(qr_o* r)
+{
+	if (r->no == 24)
+		r->mul = zmMulCrand192, r->sqr = zmSqrCrand192;
+	else if (r->no == 32)
+		r->mul = zmMulCrand256, r->sqr = zmSqrCrand256;
+	else if (r->no == 48)
+		r->mul = zmMulCrand384, r->sqr = zmSqrCrand384;
+	else if (r->no == 64)
+		r->mul = zmMulCrand512, r->sqr = zmSqrCrand512;
+}
+
+static void zmFixMont(qr_o* r)
+{
+	if (r->no == 24)
+		r->mul = zmMulMont192, r->sqr = zmSqrMont192;
+	else if (r->no == 32)
+		r->mul = zmMulMont256, r->sqr = zmSqrMont256;
+	else if (r->no == 48)
+		r->mul = zmMulMont384, r->sqr = zmSqrMont384;
+	else if (r->no == 64)
+		r->mul = zmMulMont512, r->sqr = zmSqrMont512;
+}
+
+#else
+
+#define zmFixCrand(r)
+#define zmFixMont(r)
+
+#endif
+
 /*
 *******************************************************************************
 Кольцо с редукцией Крэндалла
@@ -252,6 +648,7 @@ void zmCreateCrand(qr_o* r, const octet mod[], size_t no, void* stack)
 	r->sqr = zmSqrCrand;
 	r->inv = zmInv;
 	r->div = zmDiv;
+	zmFixCrand(r);
 	r->deep = utilMax(4,
 		zmMulCrand_deep(r->n),
 		zmSqrCrand_deep(r->n),
@@ -386,11 +783,10 @@ size_t zmCreateBarr_deep(size_t no)
 Функция zmFromMont() задает переход a -> a R (\mod mod), R = B^n.
 Функция zmToMont() задает обратный переход a -> a R^{-1} (\mod mod).
 
-\todo В функции zmInvMont() переход от a^{-1} 2^k \mod mod к
-a^{-1} R^2 \mod mod реализуется последовательными удвоениями по модулю mod.
-Можно ускорить расчеты, если предварительно вычислить R^2 \mod mod.
-Подробнее см. [E. Savas, K. Koc. The Montgomery Modular Inverse --
-Revisited. IEEE Transactions on Computers, 49(7):763–766, 2000].
+Для элемента a R (\mod mod) функция zmInvMont() определяет
+a^{-1} R \mod mod как частное от деления R^2 \mod mod на a R (\mod mod).
+Число R^2 \mod mod рассчитывается при создании кольца и хранится в
+параметрах вслед за словом -mod^{-1} \mod B.
 *******************************************************************************
 */
 
@@ -474,21 +870,15 @@ static size_t zmSqrMont_deep(size_t n)
 
 static void zmInvMont(word b[], const word a[], const qr_o* r, void* stack)
 {
-	register size_t k;
 	ASSERT(zmIsOperable(r));
 	ASSERT(zmIsIn(a, r));
-	// b <- a^{-1} 2^k \mod mod
-	k = zzAlmostInvMod(b, a, r->mod, r->n, stack);
-	ASSERT(wwBitSize(r->mod, r->n) <= k);
-	ASSERT(k <= 2 * wwBitSize(r->mod, r->n));
-	// b <- a^{-1} R^2 \mod mod
-	for (; k < 2 * r->n * B_PER_W; ++k)
-		zzDoubleMod(b, b, r->mod, r->n);
+	// b <- R^2 / a \mod mod
+	zzDivMod(b, (const word*)r->params + 1, a, r->mod, r->n, stack);
 }
 
 static size_t zmInvMont_deep(size_t n)
 {
-	return zzAlmostInvMod_deep(n);
+	return zzDivMod_deep(n);
 }
 
 static void zmDivMont(word b[], const word divident[], const word a[],
@@ -529,9 +919,13 @@ void zmCreateMont(qr_o* r, const octet mod[], size_t no, void* stack)
 	wwSetZero(r->unity, r->n);
 	zzSub2(r->unity, r->mod, r->n);
 	zzMod(r->unity, r->unity, r->n, r->mod, r->n, stack);
-	// подготовить параметры
+	// подготовить параметры: -mod^{-1} \mod B, R^2 \mod mod
 	r->params = r->unity + r->n;
 	*((word*)r->params) = wordNegInv(r->mod[0]);
+	wwSetZero((word*)stack, r->n);
+	wwCopy((word*)stack + r->n, r->unity, r->n);
+	zzMod((word*)r->params + 1, (word*)stack, 2 * r->n, r->mod, r->n,
+		(word*)stack + 2 * r->n);
 	// настроить функции
 	r->from = zmFromMont;
 	r->to = zmToMont;
@@ -542,6 +936,7 @@ void zmCreateMont(qr_o* r, const octet mod[], size_t no, void* stack)
 	r->sqr = zmSqrMont;
 	r->inv = zmInvMont;
 	r->div = zmDivMont;
+	zmFixMont(r);
 	r->deep = utilMax(6,
 		zmFromMont_deep(r->n),
 		zmToMont_deep(r->n),
@@ -550,7 +945,7 @@ void zmCreateMont(qr_o* r, const octet mod[], size_t no, void* stack)
 		zmInvMont_deep(r->n),
 		zmDivMont_deep(r->n));
 	// настроить заголовок
-	r->hdr.keep = sizeof(qr_o) + O_OF_W(2 * r->n + 1);
+	r->hdr.keep = sizeof(qr_o) + O_OF_W(3 * r->n + 1);
 	r->hdr.p_count = 3;
 	r->hdr.o_count = 0;
 }
@@ -558,14 +953,15 @@ void zmCreateMont(qr_o* r, const octet mod[], size_t no, void* stack)
 size_t zmCreateMont_keep(size_t no)
 {
 	const size_t n = W_OF_O(no);
-	return sizeof(qr_o) + O_OF_W(2 * n + 1);
+	return sizeof(qr_o) + O_OF_W(3 * n + 1);
 }
 
 size_t zmCreateMont_deep(size_t no)
 {
 	const size_t n = W_OF_O(no);
-	return utilMax(7,
+	return utilMax(8,
 		zzMod_deep(n, n),
+		O_OF_W(2 * n) + zzMod_deep(2 * n, n),
 		zmFromMont_deep(n),
 		zmToMont_deep(n),
 		zmMulMont_deep(n),
@@ -577,29 +973,63 @@ size_t zmCreateMont_deep(size_t no)
 /*
 *******************************************************************************
 Создание оптимального кольца
+
+Редукция выбирается по форме модуля и его длине n в машинных словах:
+-	модуль Крэндалла B^n - c, n >= 2: редукция Крэндалла;
+-	нечетный модуль, ZM_MONT_THRESHOLD <= n < ZM_PLAIN_THRESHOLD:
+	редукция Монтгомери;
+-	четный модуль, ZM_BARR_THRESHOLD <= n < ZM_PLAIN_THRESHOLD:
+	редукция Барретта;
+-	остальные модули: обычная редукция.
+
+На длинных модулях обычная редукция может опередить редукции Монтгомери
+и Барретта: в ней произведения вычисляются по алгоритму Карацубы (zzMul()),
+а редукции Монтгомери и Барретта остаются квадратичными.
+
+Пороги подобраны на x86-64 с помощью замеров zmBench (bee2bench zmBench).
+Замеры печатают пороги, оптимальные для текущей платформы. Эти пороги
+можно передать при сборке. На x86-64 (2026.10.14):
+-	редукция Монтгомери опережает обычную редукцию на модулях любой длины
+	от одного слова (на 128-битовых модулях -- в 3 раза);
+-	редукция Барретта опережает обычную на четных модулях от двух слов;
+-	на модулях длиной до 4096 битов обычная редукция не опережает
+	редукцию Монтгомери, несмотря на умножение Карацубы.
 *******************************************************************************
 */
 
+#ifndef ZM_MONT_THRESHOLD
+	#define ZM_MONT_THRESHOLD 1
+#endif
+
+#ifndef ZM_BARR_THRESHOLD
+	#define ZM_BARR_THRESHOLD 2
+#endif
+
+#ifndef ZM_PLAIN_THRESHOLD
+	#define ZM_PLAIN_THRESHOLD SIZE_MAX
+#endif
+
 void zmCreate(qr_o* r, const octet mod[], size_t no, void* stack)
 {
+	const size_t n = W_OF_O(no);
 	ASSERT(memIsValid(r, sizeof(qr_o)));
 	ASSERT(memIsValid(mod, no));
 	ASSERT(no > 0 && mod[no - 1] > 0);
-	// короткий модуль?
-	if (no <= 2 * O_PER_W)
-		zmCreatePlain(r, mod, no, stack);
 	// подходит редукция Крэндалла?
-	else if (no % O_PER_W == 0 && no >= 2 * O_PER_W &&
+	if (no % O_PER_W == 0 && no >= 2 * O_PER_W &&
 		!memIsZero(mod, O_PER_W) &&
 		memIsRep(mod + O_PER_W, no - O_PER_W, 0xFF))
 		zmCreateCrand(r, mod, no, stack);
+	// длинный модуль?
+	else if (n >= ZM_PLAIN_THRESHOLD)
+		zmCreatePlain(r, mod, no, stack);
 	// подходит редукция Монтгомери?
-	else if (mod[0] % 2)
+	else if (mod[0] % 2 && n >= ZM_MONT_THRESHOLD)
 		zmCreateMont(r, mod, no, stack);
-	// длинный модуль?
-	else if (no >= 4 * O_PER_W)
+	// подходит редукция Барретта?
+	else if (mod[0] % 2 == 0 && n >= ZM_BARR_THRESHOLD)
 		zmCreateBarr(r, mod, no, stack);
-	// средний четный модуль
+	// короткий модуль
 	else
 		zmCreatePlain(r, mod, no, stack);
 }
@@ -710,18 +1140,16 @@ static void zmInvMont2(word b[], const word a[], const qr_o* r, void* stack)
 	ASSERT(zmIsOperable(r));
 	ASSERT(zmIsIn(a, r));
 	params = (const zm_mont_params_st*)r->params;
-	// b <- a^{-1} 2^k \mod mod
-	k = zzAlmostInvMod(b, a, r->mod, r->n, stack);
-	ASSERT(wwBitSize(r->mod, r->n) <= k);
-	ASSERT(k <= 2 * wwBitSize(r->mod, r->n));
+	// b <- a^{-1} \mod mod
+	zzInvMod(b, a, r->mod, r->n, stack);
 	// b <- a^{-1} R^2 \mod mod
-	for (; k < 2 * params->l; ++k)
+	for (k = 0; k < 2 * params->l; ++k)
 		zzDoubleMod(b, b, r->mod, r->n);
 }
 
 static size_t zmInvMont2_deep(size_t n)
 {
-	return zzAlmostInvMod_deep(n);
+	return zzInvMod_deep(n);
 }
 
 static void zmDivMont2(word b[], const word divident[], const word a[],
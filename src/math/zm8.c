@@ -0,0 +1,492 @@
+/*
+*******************************************************************************
+\file zm8.c
+\brief Quotient rings of integers modulo m: 8 lanes
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "bee2/core/mem.h"
+#include "bee2/core/util.h"
+#include "bee2/math/ww.h"
+#include "bee2/math/zm.h"
+#include "bee2/math/zz.h"
+
+#ifdef U64_SUPPORT
+
+/*
+*******************************************************************************
+Состояние
+
+Состояние содержит длину модуля n, число разрядов l = zm8Len(n),
+число mp = -mod^{-1} \mod 2^52 и 8-наборы, все элементы которых равны
+mod (разряды модуля) и R^2 \mod mod (для перехода к форме Монтгомери).
+
+Умножение Монтгомери выполняется по схеме CIOS (Coarsely Integrated
+Operand Scanning): на шаге i к накопителю t добавляются a b_i и q mod,
+где q = t_0 mp \mod 2^52, после чего младший (нулевой) разряд t
+отбрасывается. После l шагов t < 2 mod и требуется не более одного
+вычитания mod.
+
+В режиме ZM8_AUTO в библиотеку дополнительно включаются функции
+zm8MulIFMA(), zm8AddIFMA(), zm8SubIFMA() (zm8_ifma.c), которые
+обрабатывают 8 дорожек одновременно инструкциями AVX512F, AVX512IFMA.
+Поддержка инструкций определяется с помощью cpuHas().
+*******************************************************************************
+*/
+
+#define ZM8_MASK ((u64)0x000FFFFFFFFFFFFF)
+
+typedef struct
+{
+	size_t n;			/*< длина модуля в словах */
+	size_t l;			/*< число разрядов */
+	u64 mp;				/*< -mod^{-1} \mod 2^52 */
+	u64 data[];			/*< [8 * l]mod || [8 * l]R^2 */
+} zm8_st;
+
+#define zm8Mod(st) ((st)->data)
+#define zm8R2(st) ((st)->data + 8 * (st)->l)
+
+#if defined(ZM8_AUTO)
+
+#include "bee2/core/cpu.h"
+
+extern void zm8MulIFMA(u64 c[], const u64 a[], const u64 b[],
+	const u64 mod[], u64 mp, size_t l, void* stack);
+extern void zm8AddIFMA(u64 c[], const u64 a[], const u64 b[],
+	const u64 mod[], size_t l);
+extern void zm8SubIFMA(u64 c[], const u64 a[], const u64 b[],
+	const u64 mod[], size_t l);
+
+#define zm8IFMA() cpuHas(CPU_AVX512F | CPU_AVX512IFMA)
+
+#else
+
+#define zm8IFMA() FALSE
+
+#endif // ZM8_AUTO
+
+size_t zm8Len(size_t n)
+{
+	return (n * B_PER_W + 51) / 52;
+}
+
+/*
+*******************************************************************************
+Переход между словами и разрядами
+
+Число [n]a разбивается на l 52-битовых разрядов, которые записываются
+в позиции 0, 8, 16,... массива b (в дорожку 0). Дорожки j выбираются
+смещением указателей.
+*******************************************************************************
+*/
+
+static void zm8Split(u64 b[], const word a[], size_t n, size_t l)
+{
+	u64 acc = 0;
+	size_t bits = 0;
+	size_t i = 0;
+	for (; n--; ++a)
+	{
+		word w = *a;
+		size_t rest = B_PER_W;
+		while (rest)
+		{
+			size_t take = MIN2(52 - bits, rest);
+			acc |= ((u64)w & (((u64)1 << take) - 1)) << bits;
+			rest -= take;
+			w = rest ? w >> take : 0;
+			if ((bits += take) == 52)
+			{
+				ASSERT(i < l);
+				b[8 * i++] = acc;
+				acc = 0, bits = 0;
+			}
+		}
+	}
+	if (bits)
+		b[8 * i++] = acc;
+	for (; i < l; ++i)
+		b[8 * i] = 0;
+	acc = 0;
+}
+
+static void zm8Join(word b[], const u64 a[], size_t n)
+{
+	size_t i = 0;
+	size_t bits = 0;
+	for (; n--; ++b)
+	{
+		size_t filled = 0;
+		*b = 0;
+		while (filled < B_PER_W)
+		{
+			size_t take = MIN2(52 - bits, B_PER_W - filled);
+			*b |= (word)((a[8 * i] >> bits) & (((u64)1 << take) - 1)) <<
+				filled;
+			filled += take;
+			if ((bits += take) == 52)
+				++i, bits = 0;
+		}
+	}
+}
+
+/*
+*******************************************************************************
+Умножение Монтгомери: последовательная обработка дорожек
+
+Произведения 52-битовых разрядов вычисляются умножениями 26-битовых
+половин.
+*******************************************************************************
+*/
+
+static void zm8Mul52(u64* lo, u64* hi, u64 a, u64 b)
+{
+	const u64 a0 = a & 0x3FFFFFF, a1 = a >> 26;
+	const u64 b0 = b & 0x3FFFFFF, b1 = b >> 26;
+	u64 mid = a0 * b1 + a1 * b0;
+	u64 t = a0 * b0 + ((mid & 0x3FFFFFF) << 26);
+	*lo = t & ZM8_MASK;
+	*hi = a1 * b1 + (mid >> 26) + (t >> 52);
+}
+
+static void zm8MulPort(u64 c[], const u64 a[], const u64 b[],
+	const zm8_st* st, void* stack)
+{
+	const size_t l = st->l;
+	const u64* mod = zm8Mod(st);
+	size_t i, j, k;
+	u64 lo, hi, carry, s, q;
+	// раскладка стека
+	u64* t = (u64*)stack;
+	// цикл по дорожкам
+	for (j = 0; j < 8; ++j)
+	{
+		for (k = 0; k < l + 2; ++k)
+			t[k] = 0;
+		for (i = 0; i < l; ++i)
+		{
+			// t <- t + a b_i
+			for (carry = 0, k = 0; k < l; ++k)
+			{
+				zm8Mul52(&lo, &hi, a[8 * k + j], b[8 * i + j]);
+				s = t[k] + lo + carry;
+				t[k] = s & ZM8_MASK, carry = hi + (s >> 52);
+			}
+			s = t[l] + carry;
+			t[l] = s & ZM8_MASK, t[l + 1] = s >> 52;
+			// t <- (t + q mod) / 2^52
+			q = (t[0] * st->mp) & ZM8_MASK;
+			zm8Mul52(&lo, &hi, q, mod[0]);
+			s = t[0] + lo;
+			ASSERT((s & ZM8_MASK) == 0);
+			carry = hi + (s >> 52);
+			for (k = 1; k < l; ++k)
+			{
+				zm8Mul52(&lo, &hi, q, mod[8 * k]);
+				s = t[k] + lo + carry;
+				t[k - 1] = s & ZM8_MASK, carry = hi + (s >> 52);
+			}
+			s = t[l] + carry;
+			t[l - 1] = s & ZM8_MASK, t[l] = t[l + 1] + (s >> 52);
+		}
+		// t >= mod => t <- t - mod
+		for (carry = 0, k = 0; k < l; ++k)
+			carry = (t[k] - mod[8 * k] - carry) >> 63;
+		q = (u64)0 - (u64)(t[l] >= carry);
+		for (carry = 0, k = 0; k < l; ++k)
+		{
+			s = t[k] - (mod[8 * k] & q) - carry;
+			c[8 * k + j] = s & ZM8_MASK, carry = s >> 63;
+		}
+	}
+	lo = hi = s = q = 0;
+	memWipe(t, sizeof(u64) * (l + 2));
+}
+
+/*
+*******************************************************************************
+Начало вычислений
+*******************************************************************************
+*/
+
+void zm8Start(void* state, const word mod[], size_t n, void* stack)
+{
+	zm8_st* st = (zm8_st*)state;
+	size_t l, i, j;
+	u64 x;
+	// раскладка стека
+	word* r = (word*)stack;
+	stack = r + W_OF_B(104 * zm8Len(n)) + 1;
+	// pre
+	ASSERT(memIsValid(state, zm8Start_keep(n)));
+	ASSERT(wwIsValid(mod, n) && n > 0);
+	ASSERT(zzIsOdd(mod, n) && wwCmpW(mod, n, 1) > 0);
+	// размерности
+	st->n = n, st->l = l = zm8Len(n);
+	// разряды mod
+	zm8Split(zm8Mod(st), mod, n, l);
+	// mp <- -mod^{-1} \mod 2^52
+	x = st->mp = zm8Mod(st)[0];
+	for (i = 0; i < 5; ++i)
+		st->mp *= 2 - x * st->mp;
+	st->mp = (0 - st->mp) & ZM8_MASK;
+	// R^2 \mod mod
+	i = W_OF_B(104 * l) + 1;
+	wwSetZero(r, i);
+	wwSetBit(r, 104 * l, 1);
+	j = wwWordSize(mod, n);
+	zzMod(r, r, i, mod, j, stack);
+	wwSetZero(r + j, n - j);
+	zm8Split(zm8R2(st), r, n, l);
+	// размножить по дорожкам
+	for (i = 0; i < l; ++i)
+		for (j = 1; j < 8; ++j)
+		{
+			zm8Mod(st)[8 * i + j] = zm8Mod(st)[8 * i];
+			zm8R2(st)[8 * i + j] = zm8R2(st)[8 * i];
+		}
+}
+
+size_t zm8Start_keep(size_t n)
+{
+	return sizeof(zm8_st) + sizeof(u64) * 16 * zm8Len(n);
+}
+
+size_t zm8Start_deep(size_t n)
+{
+	const size_t m = W_OF_B(104 * zm8Len(n)) + 1;
+	return O_OF_W(m) + zzMod_deep(m, n);
+}
+
+/*
+*******************************************************************************
+Арифметика
+*******************************************************************************
+*/
+
+void zm8Mul(u64 c[], const u64 a[], const u64 b[], const void* state,
+	void* stack)
+{
+	const zm8_st* st = (const zm8_st*)state;
+#if defined(ZM8_AUTO)
+	if (zm8IFMA())
+	{
+		zm8MulIFMA(c, a, b, zm8Mod(st), st->mp, st->l, stack);
+		return;
+	}
+#endif
+	zm8MulPort(c, a, b, st, stack);
+}
+
+size_t zm8Mul_deep(size_t n)
+{
+	return sizeof(u64) * 8 * (2 * zm8Len(n) + 1);
+}
+
+void zm8Add(u64 c[], const u64 a[], const u64 b[], const void* state)
+{
+	const zm8_st* st = (const zm8_st*)state;
+	const u64* mod = zm8Mod(st);
+	u64 carry[8], borrow[8], mask[8];
+	size_t i, j;
+#if defined(ZM8_AUTO)
+	if (zm8IFMA())
+	{
+		zm8AddIFMA(c, a, b, mod, st->l);
+		return;
+	}
+#endif
+	// c <- a + b
+	for (j = 0; j < 8; ++j)
+		carry[j] = borrow[j] = 0;
+	for (i = 0; i < 8 * st->l; i += 8)
+		for (j = 0; j < 8; ++j)
+		{
+			u64 s = a[i + j] + b[i + j] + carry[j];
+			carry[j] = s >> 52;
+			c[i + j] = s & ZM8_MASK;
+		}
+	// c >= mod?
+	for (i = 0; i < 8 * st->l; i += 8)
+		for (j = 0; j < 8; ++j)
+			borrow[j] = (c[i + j] - mod[i + j] - borrow[j]) >> 63;
+	for (j = 0; j < 8; ++j)
+		mask[j] = (u64)0 - (u64)(carry[j] >= borrow[j]), borrow[j] = 0;
+	// c >= mod => c <- c - mod
+	for (i = 0; i < 8 * st->l; i += 8)
+		for (j = 0; j < 8; ++j)
+		{
+			u64 s = c[i + j] - (mod[i + j] & mask[j]) - borrow[j];
+			borrow[j] = s >> 63;
+			c[i + j] = s & ZM8_MASK;
+		}
+}
+
+void zm8Sub(u64 c[], const u64 a[], const u64 b[], const void* state)
+{
+	const zm8_st* st = (const zm8_st*)state;
+	const u64* mod = zm8Mod(st);
+	u64 borrow[8], carry[8], mask[8];
+	size_t i, j;
+#if defined(ZM8_AUTO)
+	if (zm8IFMA())
+	{
+		zm8SubIFMA(c, a, b, mod, st->l);
+		return;
+	}
+#endif
+	// c <- a - b
+	for (j = 0; j < 8; ++j)
+		borrow[j] = carry[j] = 0;
+	for (i = 0; i < 8 * st->l; i += 8)
+		for (j = 0; j < 8; ++j)
+		{
+			u64 s = a[i + j] - b[i + j] - borrow[j];
+			borrow[j] = s >> 63;
+			c[i + j] = s & ZM8_MASK;
+		}
+	// a < b => c <- c + mod
+	for (j = 0; j < 8; ++j)
+		mask[j] = (u64)0 - borrow[j];
+	for (i = 0; i < 8 * st->l; i += 8)
+		for (j = 0; j < 8; ++j)
+		{
+			u64 s = c[i + j] + (mod[i + j] & mask[j]) + carry[j];
+			carry[j] = s >> 52;
+			c[i + j] = s & ZM8_MASK;
+		}
+}
+
+void zm8Select(u64 c[], const u64 a[], const u64 b[], size_t mask,
+	const void* state)
+{
+	const zm8_st* st = (const zm8_st*)state;
+	u64 m[8];
+	size_t i, j;
+	for (j = 0; j < 8; ++j)
+		m[j] = (u64)0 - (u64)(mask >> j & 1);
+	for (i = 0; i < 8 * st->l; i += 8)
+		for (j = 0; j < 8; ++j)
+			c[i + j] = a[i + j] ^ ((a[i + j] ^ b[i + j]) & m[j]);
+}
+
+size_t zm8Zeros(const u64 a[], const void* state)
+{
+	const zm8_st* st = (const zm8_st*)state;
+	u64 acc[8];
+	size_t i, j, mask = 0;
+	for (j = 0; j < 8; ++j)
+		acc[j] = 0;
+	for (i = 0; i < 8 * st->l; i += 8)
+		for (j = 0; j < 8; ++j)
+			acc[j] |= a[i + j];
+	for (j = 0; j < 8; ++j)
+		mask |= (size_t)((acc[j] | (0 - acc[j])) >> 63 ^ 1) << j;
+	return mask;
+}
+
+/*
+*******************************************************************************
+Преобразования
+*******************************************************************************
+*/
+
+void zm8From(u64 b[], const word a[], const void* state, void* stack)
+{
+	const zm8_st* st = (const zm8_st*)state;
+	size_t j;
+	for (j = 0; j < 8; ++j)
+		zm8Split(b + j, a + j * st->n, st->n, st->l);
+	zm8Mul(b, b, zm8R2(st), state, stack);
+}
+
+size_t zm8From_deep(size_t n)
+{
+	return zm8Mul_deep(n);
+}
+
+void zm8To(word b[], const u64 a[], const void* state, void* stack)
+{
+	const zm8_st* st = (const zm8_st*)state;
+	size_t i, j;
+	// раскладка стека
+	u64* t = (u64*)stack;
+	stack = t + 8 * st->l;
+	// t <- a * 1 / R
+	for (i = 0; i < 8 * st->l; ++i)
+		t[i] = 0;
+	for (j = 0; j < 8; ++j)
+		t[j] = 1;
+	zm8Mul(t, a, t, state, stack);
+	for (j = 0; j < 8; ++j)
+		zm8Join(b + j * st->n, t + j, st->n);
+}
+
+size_t zm8To_deep(size_t n)
+{
+	return sizeof(u64) * 8 * zm8Len(n) + zm8Mul_deep(n);
+}
+
+/*
+*******************************************************************************
+Возведение в степень
+
+Используется метод окон фиксированной ширины 4: рассчитываются степени
+a^1, a^2,..., a^15, показатель обрабатывается тетрадами, начиная
+со старших.
+*******************************************************************************
+*/
+
+void zm8Power(u64 b[], const u64 a[], const word d[], size_t m,
+	const void* state, void* stack)
+{
+	const zm8_st* st = (const zm8_st*)state;
+	const size_t l8 = 8 * st->l;
+	size_t pos, i;
+	// раскладка стека
+	u64* t = (u64*)stack;
+	stack = t + 16 * l8;
+	// t[i] <- a^i
+	for (i = 0; i < l8; ++i)
+		t[i] = 0;
+	for (i = 0; i < 8; ++i)
+		t[i] = 1;
+	zm8Mul(t, t, zm8R2(st), state, stack);
+	memCopy(t + l8, a, sizeof(u64) * l8);
+	for (i = 2; i < 16; ++i)
+		zm8Mul(t + i * l8, t + (i - 1) * l8, a, state, stack);
+	// b <- a^d
+	memCopy(b, t, sizeof(u64) * l8);
+	for (pos = B_OF_W(m); pos; )
+	{
+		pos -= 4;
+		for (i = 0; i < 4; ++i)
+			zm8Sqr(b, b, state, stack);
+		zm8Mul(b, b, t + wwGetBits(d, pos, 4) * l8, state, stack);
+	}
+	memWipe(t, sizeof(u64) * 16 * l8);
+}
+
+size_t zm8Power_deep(size_t n, size_t m)
+{
+	return sizeof(u64) * 16 * 8 * zm8Len(n) + zm8Mul_deep(n);
+}
+
+/*
+*******************************************************************************
+Реализация
+*******************************************************************************
+*/
+
+bool_t zm8IsFast()
+{
+	return zm8IFMA();
+}
+
+#endif // U64_SUPPORT
@@ -0,0 +1,292 @@
+/*
+*******************************************************************************
+\file zm8_ifma.c
+\brief Quotient rings of integers modulo m: 8 lanes with AVX512IFMA
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include "bee2/defs.h"
+
+#if !defined(__AVX512F__) || !defined(__AVX512IFMA__)
+	#error "The compiler does not support AVX512IFMA intrinsics"
+#endif
+
+#include <immintrin.h>
+
+#include "bee2/core/util.h"
+
+/*
+*******************************************************************************
+Векторная реализация
+
+Разряды с номером i элементов 8-наборов размещаются в 512-разрядном
+регистре (8 дорожек по 64 бита). Младшие и старшие половины произведений
+52-битовых разрядов добавляются к разрядам накопителя инструкциями
+vpmadd52luq и vpmadd52huq.
+
+Разряды накопителя не нормализуются (не приводятся к 52 битам) до
+окончания умножения: на каждом из l шагов к разряду добавляется не более
+4 слагаемых длины 52, так что при l < 2^10 переполнений не возникает.
+Инструкции vpmadd52luq, vpmadd52huq используют только младшие 52 бита
+множителей, поэтому при вычислении q = t_0 mp \mod 2^52 ненормализованный
+разряд t_0 не мешает. Перенос из t_0 учитывается перед его отбрасыванием.
+
+На шаге i используются разряды накопителя t[i],..., t[i + l], так что
+отбрасывание младшего разряда сводится к сдвигу индекса. Для l <=
+ZM8_IFMA_MAX (модули до 520 битов) умножение выполняется функциями
+zm8MulIFMA1(),..., zm8MulIFMA10() с фиксированным l: циклы полностью
+развертываются, и накопитель размещается в регистрах. Для больших l
+накопитель размещается в stack (zm8MulIFMAVar()).
+
+Функции вызываются из zm8.c (см. ZM8_AUTO).
+*******************************************************************************
+*/
+
+#define W __m512i
+#define LOAD(p) _mm512_loadu_si512((const void*)(p))
+#define STORE(p, x) _mm512_storeu_si512((void*)(p), x)
+
+#if defined(__GNUC__) && (__GNUC__ >= 8) || defined(__clang__)
+	#define ZM8_UNROLL _Pragma("GCC unroll 16")
+#else
+	#define ZM8_UNROLL
+#endif
+
+#define ZM8_IFMA_MAX 10
+
+static inline __attribute__((always_inline)) void zm8MulIFMAFix(u64 c[],
+	const u64 a[], const u64 b[], const u64 mod[], u64 mp, const size_t l)
+{
+	const W mask = _mm512_set1_epi64(0x000FFFFFFFFFFFFF);
+	const W zero = _mm512_setzero_si512();
+	const W vmp = _mm512_set1_epi64((long long)mp);
+	W t[2 * ZM8_IFMA_MAX + 1];
+	W bi, q, x, borrow;
+	__mmask8 keep;
+	size_t i, k;
+	// t <- 0
+	ZM8_UNROLL
+	for (k = 0; k < 2 * l + 1; ++k)
+		t[k] = zero;
+	// основной цикл
+	ZM8_UNROLL
+	for (i = 0; i < l; ++i)
+	{
+		// t <- t + a b_i
+		bi = LOAD(b + 8 * i);
+		ZM8_UNROLL
+		for (k = 0; k < l; ++k)
+		{
+			x = LOAD(a + 8 * k);
+			t[i + k] = _mm512_madd52lo_epu64(t[i + k], x, bi);
+			t[i + k + 1] = _mm512_madd52hi_epu64(t[i + k + 1], x, bi);
+		}
+		// t <- t + q mod
+		q = _mm512_and_si512(_mm512_madd52lo_epu64(zero, t[i], vmp), mask);
+		ZM8_UNROLL
+		for (k = 0; k < l; ++k)
+		{
+			x = LOAD(mod + 8 * k);
+			t[i + k] = _mm512_madd52lo_epu64(t[i + k], x, q);
+			t[i + k + 1] = _mm512_madd52hi_epu64(t[i + k + 1], x, q);
+		}
+		// перенос из t_i
+		t[i + 1] = _mm512_add_epi64(t[i + 1], _mm512_srli_epi64(t[i], 52));
+	}
+	// нормализация
+	ZM8_UNROLL
+	for (k = l; k < 2 * l; ++k)
+	{
+		t[k + 1] = _mm512_add_epi64(t[k + 1], _mm512_srli_epi64(t[k], 52));
+		t[k] = _mm512_and_si512(t[k], mask);
+	}
+	// t >= mod?
+	borrow = zero;
+	ZM8_UNROLL
+	for (k = 0; k < l; ++k)
+		borrow = _mm512_srli_epi64(_mm512_sub_epi64(
+			_mm512_sub_epi64(t[l + k], LOAD(mod + 8 * k)), borrow), 63);
+	keep = _mm512_cmplt_epu64_mask(t[2 * l], borrow);
+	// t >= mod => c <- t - mod, иначе c <- t
+	borrow = zero;
+	ZM8_UNROLL
+	for (k = 0; k < l; ++k)
+	{
+		x = _mm512_sub_epi64(_mm512_sub_epi64(t[l + k],
+			_mm512_maskz_loadu_epi64((__mmask8)~keep, mod + 8 * k)), borrow);
+		borrow = _mm512_srli_epi64(x, 63);
+		STORE(c + 8 * k, _mm512_and_si512(x, mask));
+	}
+}
+
+static void zm8MulIFMAVar(u64 c[], const u64 a[], const u64 b[],
+	const u64 mod[], u64 mp, size_t l, void* stack)
+{
+	const W mask = _mm512_set1_epi64(0x000FFFFFFFFFFFFF);
+	const W zero = _mm512_setzero_si512();
+	const W vmp = _mm512_set1_epi64((long long)mp);
+	W bi, q, x, borrow;
+	__mmask8 keep;
+	size_t i, k;
+	// раскладка стека
+	W* t = (W*)stack;
+	// pre
+	ASSERT(l > 0);
+	// t <- 0
+	for (k = 0; k < 2 * l + 1; ++k)
+		STORE(t + k, zero);
+	// основной цикл
+	for (i = 0; i < l; ++i, ++t)
+	{
+		// t <- t + a b_i
+		bi = LOAD(b + 8 * i);
+		for (k = 0; k < l; ++k)
+		{
+			x = LOAD(a + 8 * k);
+			STORE(t + k, _mm512_madd52lo_epu64(LOAD(t + k), x, bi));
+			STORE(t + k + 1, _mm512_madd52hi_epu64(LOAD(t + k + 1), x, bi));
+		}
+		// t <- t + q mod
+		q = _mm512_and_si512(_mm512_madd52lo_epu64(zero, LOAD(t), vmp), mask);
+		for (k = 0; k < l; ++k)
+		{
+			x = LOAD(mod + 8 * k);
+			STORE(t + k, _mm512_madd52lo_epu64(LOAD(t + k), x, q));
+			STORE(t + k + 1, _mm512_madd52hi_epu64(LOAD(t + k + 1), x, q));
+		}
+		// перенос из t_0
+		STORE(t + 1, _mm512_add_epi64(LOAD(t + 1),
+			_mm512_srli_epi64(LOAD(t), 52)));
+	}
+	// нормализация
+	for (k = 0; k < l; ++k)
+	{
+		x = LOAD(t + k);
+		STORE(t + k + 1, _mm512_add_epi64(LOAD(t + k + 1),
+			_mm512_srli_epi64(x, 52)));
+		STORE(t + k, _mm512_and_si512(x, mask));
+	}
+	// t >= mod?
+	borrow = zero;
+	for (k = 0; k < l; ++k)
+		borrow = _mm512_srli_epi64(_mm512_sub_epi64(
+			_mm512_sub_epi64(LOAD(t + k), LOAD(mod + 8 * k)), borrow), 63);
+	keep = _mm512_cmplt_epu64_mask(LOAD(t + l), borrow);
+	// t >= mod => t <- t - mod
+	borrow = zero;
+	for (k = 0; k < l; ++k)
+	{
+		x = _mm512_sub_epi64(_mm512_sub_epi64(LOAD(t + k),
+			_mm512_maskz_loadu_epi64((__mmask8)~keep, mod + 8 * k)), borrow);
+		borrow = _mm512_srli_epi64(x, 63);
+		STORE(c + 8 * k, _mm512_and_si512(x, mask));
+	}
+	// очистка
+	t -= l;
+	for (k = 0; k < 2 * l + 1; ++k)
+		STORE(t + k, zero);
+	bi = q = x = zero;
+}
+
+#define ZM8_IFMA_FIX(l)\
+static void zm8MulIFMA##l(u64 c[], const u64 a[], const u64 b[],\
+	const u64 mod[], u64 mp)\
+{\
+	zm8MulIFMAFix(c, a, b, mod, mp, l);\
+}\
+
+ZM8_IFMA_FIX(1)
+ZM8_IFMA_FIX(2)
+ZM8_IFMA_FIX(3)
+ZM8_IFMA_FIX(4)
+ZM8_IFMA_FIX(5)
+ZM8_IFMA_FIX(6)
+ZM8_IFMA_FIX(7)
+ZM8_IFMA_FIX(8)
+ZM8_IFMA_FIX(9)
+ZM8_IFMA_FIX(10)
+
+void zm8MulIFMA(u64 c[], const u64 a[], const u64 b[], const u64 mod[],
+	u64 mp, size_t l, void* stack)
+{
+	switch (l)
+	{
+	case 1: zm8MulIFMA1(c, a, b, mod, mp); break;
+	case 2: zm8MulIFMA2(c, a, b, mod, mp); break;
+	case 3: zm8MulIFMA3(c, a, b, mod, mp); break;
+	case 4: zm8MulIFMA4(c, a, b, mod, mp); break;
+	case 5: zm8MulIFMA5(c, a, b, mod, mp); break;
+	case 6: zm8MulIFMA6(c, a, b, mod, mp); break;
+	case 7: zm8MulIFMA7(c, a, b, mod, mp); break;
+	case 8: zm8MulIFMA8(c, a, b, mod, mp); break;
+	case 9: zm8MulIFMA9(c, a, b, mod, mp); break;
+	case 10: zm8MulIFMA10(c, a, b, mod, mp); break;
+	default: zm8MulIFMAVar(c, a, b, mod, mp, l, stack);
+	}
+}
+
+void zm8AddIFMA(u64 c[], const u64 a[], const u64 b[], const u64 mod[],
+	size_t l)
+{
+	const W mask = _mm512_set1_epi64(0x000FFFFFFFFFFFFF);
+	W carry, borrow, x;
+	__mmask8 keep;
+	size_t k;
+	// c <- a + b
+	carry = _mm512_setzero_si512();
+	for (k = 0; k < l; ++k)
+	{
+		x = _mm512_add_epi64(_mm512_add_epi64(LOAD(a + 8 * k),
+			LOAD(b + 8 * k)), carry);
+		carry = _mm512_srli_epi64(x, 52);
+		STORE(c + 8 * k, _mm512_and_si512(x, mask));
+	}
+	// c >= mod?
+	borrow = _mm512_setzero_si512();
+	for (k = 0; k < l; ++k)
+		borrow = _mm512_srli_epi64(_mm512_sub_epi64(
+			_mm512_sub_epi64(LOAD(c + 8 * k), LOAD(mod + 8 * k)), borrow), 63);
+	keep = _mm512_cmplt_epu64_mask(carry, borrow);
+	// c >= mod => c <- c - mod
+	borrow = _mm512_setzero_si512();
+	for (k = 0; k < l; ++k)
+	{
+		x = _mm512_sub_epi64(_mm512_sub_epi64(LOAD(c + 8 * k),
+			_mm512_maskz_loadu_epi64((__mmask8)~keep, mod + 8 * k)), borrow);
+		borrow = _mm512_srli_epi64(x, 63);
+		STORE(c + 8 * k, _mm512_and_si512(x, mask));
+	}
+}
+
+void zm8SubIFMA(u64 c[], const u64 a[], const u64 b[], const u64 mod[],
+	size_t l)
+{
+	const W mask = _mm512_set1_epi64(0x000FFFFFFFFFFFFF);
+	W carry, borrow, x;
+	__mmask8 add;
+	size_t k;
+	// c <- a - b
+	borrow = _mm512_setzero_si512();
+	for (k = 0; k < l; ++k)
+	{
+		x = _mm512_sub_epi64(_mm512_sub_epi64(LOAD(a + 8 * k),
+			LOAD(b + 8 * k)), borrow);
+		borrow = _mm512_srli_epi64(x, 63);
+		STORE(c + 8 * k, _mm512_and_si512(x, mask));
+	}
+	// a < b => c <- c + mod
+	add = _mm512_test_epi64_mask(borrow, borrow);
+	carry = _mm512_setzero_si512();
+	for (k = 0; k < l; ++k)
+	{
+		x = _mm512_add_epi64(_mm512_add_epi64(LOAD(c + 8 * k),
+			_mm512_maskz_loadu_epi64(add, mod + 8 * k)), carry);
+		carry = _mm512_srli_epi64(x, 52);
+		STORE(c + 8 * k, _mm512_and_si512(x, mask));
+	}
+}
@@ -0,0 +1,75 @@
+/*
+*******************************************************************************
+\file zm_lcl.h
+\brief Quotient rings of integers modulo m: local definitions
+\project bee2 [cryptographic library]
+\created 2026.10.14
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#ifndef __ZM_LCL_H
+#define __ZM_LCL_H
+
+#include "bee2/math/qr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+*******************************************************************************
+Фиксированные размерности
+
+Сложение, вычитание и деление на 2 по модулю mod, умножение и возведение
+в квадрат в кольцах с редукцией Крэндалла для модулей длины 192, 256, 384
+и 512 битов (см. zm.c). Функции zmMulCrandXXX(), zmSqrCrandXXX()
+устанавливаются в описание кольца функцией zmCreateCrand(). Все функции вызываются напрямую
+из специализированных функций ecp.c (см. ecpCreateJ()).
+
+В функциях zmAddModXXX(), zmSubModXXX() слагаемые (уменьшаемое
+и вычитаемое) должны быть меньше mod. В функции zmHalfModXXX() модуль
+должен быть нечетным.
+
+Функции zmAddLazyXXX(), zmSubCrandXXX() применяются только к модулям
+Крэндалла mod = B^n - c, их аргументы должны быть меньше mod. Функция
+zmSubCrandXXX() возвращает вычет, меньший mod. Функция zmAddLazyXXX()
+(ленивое сложение) возвращает число, меньшее B^n и сравнимое с суммой
+по модулю mod. Результат ленивого сложения можно передавать только
+в zmMulCrandXXX(), zmSqrCrandXXX(): эти функции принимают любые
+сомножители, меньшие B^n.
+
+\remark Реализованы в zm.c при B_PER_W == 32 || B_PER_W == 64.
+*******************************************************************************
+*/
+
+#if (B_PER_W == 32 || B_PER_W == 64)
+
+#define ZM_FIX_DECL(bits)\
+void zmAddMod##bits(word c[], const word a[], const word b[],\
+	const word mod[]);\
+void zmSubMod##bits(word c[], const word a[], const word b[],\
+	const word mod[]);\
+void zmHalfMod##bits(word b[], const word a[], const word mod[]);\
+void zmAddLazy##bits(word c[], const word a[], const word b[],\
+	const word mod[]);\
+void zmSubCrand##bits(word c[], const word a[], const word b[],\
+	const word mod[]);\
+void zmMulCrand##bits(word c[], const word a[], const word b[],\
+	const qr_o* r, void* stack);\
+void zmSqrCrand##bits(word b[], const word a[], const qr_o* r, void* stack);\
+
+ZM_FIX_DECL(192)
+ZM_FIX_DECL(256)
+ZM_FIX_DECL(384)
+ZM_FIX_DECL(512)
+
+#endif
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __ZM_LCL_H */
@@ -4,7 +4,7 @@
 \brief Multiple-precision unsigned integers: other functions
 \project bee2 [cryptographic library]
 \created 2012.04.22
-\version 2021.06.30
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -88,8 +88,31 @@ word zzSubAndW(word b[], const word a[], size_t n, register word w)
 *******************************************************************************
 Квадратичные вычеты
 
-Реализован алгоритм 2.148 из [Menezes A., van Oorschot P., Vanstone S.
-Handbook of Applied Cryptography] в редакции CТБ 34.101.45 (приложение Ж).
+Реализован бинарный алгоритм вычисления символа Якоби [Brent R., Zimmermann
+P. Modern Computer Arithmetic, 2010, упр. 1.59; Cohen H. A Course in
+Computational Algebraic Number Theory, алгоритм 1.4.10]:
+	u <- a \mod b, v <- b, t <- 1
+	пока (u != 0)
+		u <- u / 2^s, где 2^s || u
+		если (s -- нечетное и v \equiv 3, 5 \mod 8)
+			t <- -t
+		если (u < v)
+			u <-> v
+			если (u \equiv v \equiv 3 \mod 4)
+				t <- -t
+		u <- u - v
+	return v == 1 ? t : 0
+Корректность следует из свойств символа Якоби:
+	(2 / v) = (-1)^{(v^2 - 1) / 8},
+	(u / v) = (-1)^{(u - 1) / 2 (v - 1) / 2}(v / u) (u, v -- нечетные),
+	(u / v) = ((u - v) / v).
+В конце v = \gcd(a, b) и (a / b) = 0, если v != 1.
+
+В отличие от алгоритма 2.148 из [Menezes A., van Oorschot P., Vanstone S.
+Handbook of Applied Cryptography], который применяется в СТБ 34.101.45
+(приложение Ж), деление выполняется только на первом шаге. В цикле
+выполняются только вычитания и сдвиги, а после того как u и v уместятся
+в слово -- операции со словами.
 
 В некоторых приложениях область определения символа Якоби расширяется
 до любых b по следующим правилам:
@@ -108,9 +131,11 @@ int zzJacobi(const word a[], size_t n, const word b[], size_t m, void* stack)
 {
 	register int t = 1;
 	register size_t s;
+	register word x, y;
+	size_t nu;
 	// переменные в stack
 	word* u = (word*)stack;
-	word* v = u + n;
+	word* v = u + m;
 	stack = v + m;
 	// pre
 	ASSERT(wwIsValid(a, n));
@@ -120,47 +145,60 @@ int zzJacobi(const word a[], size_t n, const word b[], size_t m, void* stack)
 	m = wwWordSize(v, m);
 	// u <- a \mod b
 	zzMod(u, a, n, v, m, stack);
-	n = wwWordSize(u, m);
-	// основной цикл
-	while (wwCmpW(v, m, 1) > 0)
+	nu = wwWordSize(u, m);
+	// длинные u, v
+	while (nu > 1 || m > 1)
 	{
 		// u == 0 => (u / v) <- 0
-		if (wwIsZero(u, n))
+		if (nu == 0)
+			return 0;
+		// s <- max_{2^i | u}i, u <- u / 2^s
+		s = wwLoZeroBits(u, nu);
+		if (s)
 		{
-			t = 0;
-			break;
+			if (s % 2 && ((v[0] & 7) == 3 || (v[0] & 7) == 5))
+				t = -t;
+			wwShLo(u, nu, s);
+			nu = wwWordSize(u, nu);
 		}
-		// u == 1 => (u / v) <- s
-		if (wwIsW(u, n, 1))
-			break;
-		// s <- max_{2^i | u}i
-		s = wwLoZeroBits(u, n);
-		// s -- нечетное, v \equiv 3, 5 \mod 8 => t <- -t
-		if (s % 2 && ((v[0] & 7) == 3 || (v[0] & 7) == 5))
-			t = -t;
-		// u <- u / 2^s
-		wwShLo(u, n, s);
-		n = wwWordSize(u, n);
-		// u, v \equiv 3 \mod 4 => t <- -t
-		if ((u[0] & 3) == 3 && (v[0] & 3) == 3)
+		// u < v => u <-> v
+		if (wwCmp2(u, nu, v, m) < 0)
+		{
+			word* w = u;
+			u = v, v = w;
+			s = nu, nu = m, m = s;
+			if ((u[0] & v[0] & 3) == 3)
+				t = -t;
+		}
+		// u <- u - v
+		zzSubW2(u + m, nu - m, zzSub2(u, v, m));
+		nu = wwWordSize(u, nu);
+	}
+	// короткие u, v
+	x = nu ? u[0] : 0, y = v[0];
+	while (x)
+	{
+		s = wordCTZ(x);
+		if (s % 2 && ((y & 7) == 3 || (y & 7) == 5))
 			t = -t;
-		// v <- v \mod u
-		zzMod(v, v, m, u, n, stack);
-		m = wwWordSize(v, n);
-		// v <-> u
-		wwSwap(u, v, n);
-		s = m, m = n, n = s;
+		x >>= s;
+		if (x < y)
+		{
+			register word w = x;
+			x = y, y = w;
+			if ((x & y & 3) == 3)
+				t = -t;
+		}
+		x -= y;
 	}
-	// символ Якоби
+	t = (y == 1) ? t : 0;
+	x = y = 0;
 	return t;
 }
 
 size_t zzJacobi_deep(size_t n, size_t m)
 {
-	return O_OF_W(n + m) + 
-		utilMax(2, 
-			zzMod_deep(n, m), 
-			zzMod_deep(m, n));
+	return O_OF_W(2 * m) + zzMod_deep(n, m);
 }
 
 /*
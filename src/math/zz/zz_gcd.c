@@ -4,7 +4,7 @@
 \brief Multiple-precision unsigned integers: Euclidian gcd algorithms
 \project bee2 [cryptographic library]
 \created 2012.04.22
-\version 2023.03.07
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -12,8 +12,10 @@
 
 #include "bee2/core/mem.h"
 #include "bee2/core/util.h"
+#include "bee2/core/word.h"
 #include "bee2/math/ww.h"
 #include "bee2/math/zz.h"
+#include "zz_lcl.h"
 
 /*
 *******************************************************************************
@@ -78,6 +80,214 @@
 *******************************************************************************
 */
 
+/*
+*******************************************************************************
+Алгоритм Лемера
+
+Для длинных чисел (не короче ZZ_GCD_LEHMER_THRESHOLD слов) в zzGCD(),
+zzExGCD() используется алгоритм Лемера в редакции [Knuth, TAOCP, v.2,
+4.5.2, Algorithm L]. Шаги алгоритма Евклида моделируются на ведущих
+p = B_PER_W - 1 битах uh, vh чисел u >= v (биты берутся с одинаковых
+позиций). Одновременно накапливаются по модулю коэффициенты матрицы
+перехода (A B; C D), знаки которых чередуются:
+	u' = (-1)^k (A u - B v),
+	v' = (-1)^k (D v - C u),
+где k -- число смоделированных шагов. Шаг с частным q принимается, если
+q совпадает с частными (uh + A) / (vh + C) и (uh + B) / (vh + D)
+(числа A, B, C, D здесь со знаками). Кнут доказал, что при этом все
+промежуточные величины укладываются в p битов. Затем матрица применяется
+к длинным числам: за один проход по u, v выполняется несколько шагов
+Евклида. Если не удалось смоделировать ни одного шага (B == 0), то
+выполняется полный шаг с делением: (u, v) <- (v, u \mod v).
+
+В zzGCDLehmer() дополнительно пересчитываются абсолютные величины xu, xv
+коэффициентов Безу при a:
+	u = (-1)^par xu a \mod b,
+	v = -(-1)^par xv a \mod b.
+Абсолютные величины пересчитываются сложениями, поскольку знаки
+коэффициентов чередуются. Выполняется 0 <= xu, xv <= b. Коэффициент
+при b определяется в zzExGCD() точным делением.
+
+Алгоритм Лемера выполняет O(n^2) операций над словами, как и бинарный
+алгоритм, но за один проход по длинным числам выполняется около p / 2
+шагов Евклида, а не один шаг. На x86-64 алгоритм Лемера опережает
+бинарный в zzGCD() в 2.5 раза на 128-битовых числах и в 9 раз
+на 4096-битовых (в zzExGCD() -- в 3 и в 23 раза соответственно).
+
+\remark Субквадратичный алгоритм half-GCD выигрывает у алгоритма Лемера
+только на числах, намного более длинных, чем используются в библиотеке.
+Кроме того, ему требуется быстрое умножение, а в библиотеке реализовано
+только умножение Карацубы.
+
+\remark На коротких числах (менее ZZ_GCD_LEHMER_THRESHOLD слов) сохранен
+бинарный алгоритм: ему почти не требуется память в стеке, а выигрыш
+алгоритма Лемера на таких числах невелик в абсолютном выражении.
+Порог можно переопределить при сборке.
+*******************************************************************************
+*/
+
+#ifndef ZZ_GCD_LEHMER_THRESHOLD
+	#define ZZ_GCD_LEHMER_THRESHOLD (256 / B_PER_W)
+#endif
+
+#define ZZ_LEHMER_P (B_PER_W - 1)
+
+/*
+	t[nu + 1] <- neg ? b v - a u : a u - b v, где nu >= nv.
+	\pre Разность неотрицательна.
+*/
+static void zzLehmerLin(word t[], const word u[], size_t nu, register word a,
+	const word v[], size_t nv, register word b, bool_t neg)
+{
+	ASSERT(nu >= nv);
+	if (!neg)
+	{
+		t[nu] = zzMulW(t, u, nu, a);
+		zzSubW2(t + nv, nu + 1 - nv, zzSubMulW(t, v, nv, b));
+	}
+	else
+	{
+		wwSetZero(t + nv, nu + 1 - nv);
+		t[nv] = zzMulW(t, v, nv, b);
+		t[nu] -= zzSubMulW(t, u, nu, a);
+	}
+	ASSERT(t[nu] >> (B_PER_W - 1) == 0);
+}
+
+/*
+	[n]t <- a x + b y.
+*/
+static void zzLehmerLinX(word t[], const word x[], register word a,
+	const word y[], register word b, size_t n)
+{
+	register word carry;
+	carry = zzMulW(t, x, n, a);
+	carry += zzAddMulW(t, y, n, b);
+	ASSERT(carry == 0);
+	carry = 0;
+}
+
+static size_t zzGCDLehmer(word g[], word x[], bool_t* neg, const word a[],
+	size_t n, const word b[], size_t m, void* stack)
+{
+	const size_t nn = MAX2(n, m) + 1;
+	const size_t nx = m + 1;
+	register word A, B, C, D;
+	register word uh, vh, q, w;
+	bool_t k, par = FALSE;
+	size_t nu, nv, nq, sh;
+	word* p;
+	// переменные в stack
+	word* u = (word*)stack;
+	word* v = u + nn;
+	word* t = v + nn;
+	word* t1 = t + nn;
+	word* xu = t1 + nn;
+	word* xv = xu + nx;
+	word* xt = xv + nx;
+	word* xt1 = xt + nx;
+	word* qt = xt1 + nx;
+	word* prod = qt + nn;
+	stack = prod + nn + nx;
+	// u <- a, v <- b, xu <- 1, xv <- 0
+	wwCopy(u, a, n), nu = wwWordSize(u, n);
+	wwCopy(v, b, m), nv = wwWordSize(v, m);
+	ASSERT(nu > 0 && nv > 0);
+	wwSetW(xu, nx, 1), wwSetZero(xv, nx);
+	// u < v? (u, v) <- (v, u)
+	if (wwCmp2(u, nu, v, nv) < 0)
+	{
+		p = u, u = v, v = p, SWAP(nu, nv);
+		p = xu, xu = xv, xv = p, par = TRUE;
+	}
+	wwSetZero(v + nv, nn - nv);
+	// итерации
+	while (nv)
+	{
+		ASSERT(wwCmp2(u, nu, v, nv) >= 0);
+		// ведущие биты
+		sh = wwBitSize(u, nu);
+		sh = sh > ZZ_LEHMER_P ? sh - ZZ_LEHMER_P : 0;
+		uh = wwGetBits(u, sh, ZZ_LEHMER_P);
+		vh = wwGetBits(v, sh, ZZ_LEHMER_P);
+		// моделирование шагов Евклида
+		A = D = 1, B = C = 0, k = FALSE;
+		while (1)
+		{
+			// q <- (uh + A) / (vh + C) == (uh + B) / (vh + D)?
+			w = (word)(vh + (k ? C : WORD_0 - C));
+			if (w == 0)
+				break;
+			q = (word)(uh + (k ? WORD_0 - A : A)) / w;
+			w = (word)(vh + (k ? WORD_0 - D : D));
+			if (w == 0 || q != (word)(uh + (k ? B : WORD_0 - B)) / w)
+				break;
+			// (A, B, C, D) <- (C, D, A + q C, B + q D)
+			w = A + q * C, A = C, C = w;
+			w = B + q * D, B = D, D = w;
+			// (uh, vh) <- (vh, uh - q vh)
+			w = uh - q * vh, uh = vh, vh = w;
+			k = !k;
+		}
+		// полный шаг: (u, v) <- (v, u \mod v)
+		if (B == 0)
+		{
+			zzDiv(qt, t, u, nu, v, nv, stack);
+			if (x)
+			{
+				// xt <- xu + q xv
+				nq = wwWordSize(qt, nu - nv + 1);
+				zzMul(prod, qt, nq, xv, nx, stack);
+				ASSERT(wwIsZero(prod + nx, nq));
+				VERIFY(zzAdd(xt, xu, prod, nx) == 0);
+				p = xu, xu = xv, xv = xt, xt = p;
+			}
+			p = u, u = v, v = t, t = p;
+			nu = nv, nv = wwWordSize(v, nv);
+			par = !par;
+		}
+		// шаги Лемера
+		else
+		{
+			zzLehmerLin(t, u, nu, A, v, nv, B, k);
+			zzLehmerLin(t1, u, nu, C, v, nv, D, !k);
+			if (x)
+			{
+				zzLehmerLinX(xt, xu, A, xv, B, nx);
+				zzLehmerLinX(xt1, xu, C, xv, D, nx);
+				p = xu, xu = xt, xt = p;
+				p = xv, xv = xt1, xt1 = p;
+			}
+			p = u, u = t, t = p;
+			p = v, v = t1, t1 = p;
+			nv = wwWordSize(v, nu + 1);
+			nu = wwWordSize(u, nu + 1);
+			par ^= k;
+		}
+		wwSetZero(v + nv, nn - nv);
+	}
+	// g <- u, x <- xu
+	wwCopy(g, u, nu);
+	if (x)
+	{
+		wwCopy(x, xu, nx);
+		*neg = par;
+	}
+	// очистка
+	A = B = C = D = uh = vh = q = w = 0;
+	return nu;
+}
+
+static size_t zzGCDLehmer_deep(size_t n, size_t m)
+{
+	const size_t nn = MAX2(n, m) + 1;
+	const size_t nx = m + 1;
+	return O_OF_W(5 * nn + 4 * nx + nn + nx) +
+		utilMax(2,
+			zzDiv_deep(nn, nn),
+			zzMul_deep(nn, nx));
+}
+
 void zzGCD(word d[], const word a[], size_t n, const word b[], size_t m,
 	void* stack)
 {
@@ -92,6 +302,12 @@ void zzGCD(word d[], const word a[], size_t n, const word b[], size_t m,
 	ASSERT(!wwIsZero(a, n) && !wwIsZero(b, m));
 	// d <- 0
 	wwSetZero(d, MIN2(n, m));
+	// длинные числа?
+	if (MIN2(n, m) >= ZZ_GCD_LEHMER_THRESHOLD)
+	{
+		zzGCDLehmer(d, 0, 0, a, n, b, m, stack);
+		return;
+	}
 	// u <- a, v <- b
 	wwCopy(u, a, n);
 	wwCopy(v, b, m);
@@ -127,6 +343,8 @@ void zzGCD(word d[], const word a[], size_t n, const word b[], size_t m,
 
 size_t zzGCD_deep(size_t n, size_t m)
 {
+	if (MIN2(n, m) >= ZZ_GCD_LEHMER_THRESHOLD)
+		return zzGCDLehmer_deep(n, m);
 	return O_OF_W(n + m);
 }
 
@@ -189,6 +407,52 @@ size_t zzLCM_deep(size_t n, size_t m)
 			zzMod_deep(n + m, MIN2(n, m)));
 }
 
+/*
+	Расширенный алгоритм Лемера: d <- \gcd(a, b), da <- x или b - x,
+	db <- (da a - d) / b. Если da == 0, то d == b и da <- 1.
+*/
+static void zzExGCDLehmer(word d[], word da[], word db[], const word a[],
+	size_t n, const word b[], size_t m, void* stack)
+{
+	size_t nd, mb;
+	bool_t neg;
+	// переменные в stack
+	word* x = (word*)stack;
+	word* prod = x + m + 1;
+	word* q = prod + n + m;
+	word* r = q + n + m + 1;
+	stack = r + m;
+	// d <- \gcd(a, b), x: d = \pm x a \mod b
+	nd = zzGCDLehmer(d, x, &neg, a, n, b, m, stack);
+	ASSERT(x[m] == 0 && wwCmp(x, b, m) <= 0);
+	// da <- \pm x \mod b
+	if (neg)
+		zzSub(da, b, x, m);
+	else
+		wwCopy(da, x, m);
+	if (wwIsZero(da, m))
+		wwSetW(da, m, 1);
+	// db <- (da a - d) / b
+	zzMul(prod, da, m, a, n, stack);
+	zzSubW2(prod + nd, n + m - nd, zzSub2(prod, d, nd));
+	mb = wwWordSize(b, m);
+	zzDiv(q, r, prod, n + m, b, mb, stack);
+	ASSERT(wwIsZero(r, mb));
+	ASSERT(wwIsZero(q + n, m + 1 - mb));
+	wwCopy(db, q, n);
+	// очистка
+	nd = mb = 0;
+}
+
+static size_t zzExGCDLehmer_deep(size_t n, size_t m)
+{
+	return O_OF_W(m + 1 + n + m + n + m + 1 + m) +
+		utilMax(3,
+			zzGCDLehmer_deep(n, m),
+			zzMul_deep(m, n),
+			zzDiv_deep(n + m, m));
+}
+
 void zzExGCD(word d[], word da[], word db[], const word a[], size_t n,
 	const word b[], size_t m, void* stack)
 {
@@ -211,6 +475,13 @@ void zzExGCD(word d[], word da[], word db[], const word a[], size_t n,
 	ASSERT(wwIsDisjoint2(a, n, db, n));
 	ASSERT(wwIsDisjoint2(b, m, db, n));
 	ASSERT(!wwIsZero(a, n) && !wwIsZero(b, m));
+	// длинные числа?
+	if (MIN2(n, m) >= ZZ_GCD_LEHMER_THRESHOLD)
+	{
+		wwSetZero(d, MIN2(n, m));
+		zzExGCDLehmer(d, da, db, a, n, b, m, stack);
+		return;
+	}
 	// d <- 0, da <- 1, db <- 0, da1 <- 0, db1 <- 1
 	wwSetZero(d, MIN2(n, m));
 	wwSetW(da, m, 1);
@@ -294,6 +565,8 @@ void zzExGCD(word d[], word da[], word db[], const word a[], size_t n,
 
 size_t zzExGCD_deep(size_t n, size_t m)
 {
+	if (MIN2(n, m) >= ZZ_GCD_LEHMER_THRESHOLD)
+		return zzExGCDLehmer_deep(n, m);
 	return O_OF_W(3 * n + 3 * m);
 }
 
@@ -309,7 +582,7 @@ size_t zzExGCD_deep(size_t n, size_t m)
 *******************************************************************************
 */
 
-void zzDivMod(word b[], const word divident[], const word a[],
+void FAST(zzDivMod)(word b[], const word divident[], const word a[],
 	const word mod[], size_t n, void* stack)
 {
 	register size_t nu, nv;
@@ -383,9 +656,199 @@ void zzDivMod(word b[], const word divident[], const word a[],
 	nu = nv = 0;
 }
 
+/*
+*******************************************************************************
+Регулярное деление по модулю
+
+В SAFE(zzDivMod) реализован алгоритм Бернштейна -- Янга [D.J.Bernstein,
+B.-Y.Yang. Fast constant-time gcd computation and modular inversion.
+IACR TCHES, 2019(3):340–398]. Алгоритм строится на шаге divstep:
+	если (delta > 0 и g -- нечетное)
+		(delta, f, g) <- (1 - delta, g, (g - f) / 2)
+	иначе если (g -- нечетное)
+		(delta, f, g) <- (1 + delta, f, (g + f) / 2)
+	иначе
+		(delta, f, g) <- (1 + delta, f, g / 2)
+Шаги выполняются над тройкой (1, mod, a). В [Theorem 11.2] доказано, что
+если f -- нечетное, f, |g| < 2^d и число шагов не меньше
+	iter(d) = (49 d + 57) / 17 (d >= 46), (49 d + 80) / 17 (d < 46),
+то в конце концов g == 0 и f == \pm\gcd(mod, a). Дополнительные шаги
+над g == 0 не меняют f.
+
+Шаги объединяются в пакеты по s = B_PER_W - 2 шагов. Шаги пакета
+выполняются над младшими словами f и g (функция zzDivStepsW()): парность
+g на j-м шаге определяется младшими j + 1 битами первоначальных f и g.
+Одновременно рассчитывается матрица перехода (u v; q r):
+	f' 2^s = u f + v g,
+	g' 2^s = q f + r g.
+Элементы матрицы -- слова со знаком: |u| + |v|, |q| + |r| <= 2^s.
+После пакета матрица применяется к длинным f и g, а также к коэффициентам
+d и e, для которых поддерживаются инварианты
+	f * divident = d * a \mod mod,
+	g * divident = e * a \mod mod.
+Первоначально d = 0, e = divident. Деление на 2^s при пересчете d и e
+выполняется по модулю mod, как в редукции Монтгомери.
+
+Числа f, g, d, e хранятся в (n + 1)-словных буферах в дополнительном
+коде. Выполняются соотношения |f|, |g| < B^n, 0 <= d, e < mod.
+
+Число пакетов определяется только длиной mod, условных переходов,
+зависящих от a и divident, нет.
+*******************************************************************************
+*/
+
+#define ZZ_DIVSTEPS (B_PER_W - 2)
+
+static word zzDivStepsW(word t[4], register word delta, register word f,
+	register word g)
+{
+	register word u = 1, v = 0, q = 0, r = 1;
+	register word c, o, x;
+	size_t i;
+	ASSERT(f % 2);
+	for (i = 0; i < ZZ_DIVSTEPS; ++i)
+	{
+		// o <- g -- нечетное ? WORD_MAX : 0
+		o = WORD_0 - (g & WORD_1);
+		// c <- delta > 0 && o ? WORD_MAX : 0
+		c = o & (WORD_0 - ((word)(WORD_0 - delta) >> (B_PER_W - 1)));
+		// c? (delta, f, g, u, v, q, r) <- (-delta, g, -f, q, r, -u, -v)
+		delta = (word)((delta ^ c) - c);
+		x = (f ^ g) & c, f ^= x, g ^= x, g = (word)((g ^ c) - c);
+		x = (u ^ q) & c, u ^= x, q ^= x, q = (word)((q ^ c) - c);
+		x = (v ^ r) & c, v ^= x, r ^= x, r = (word)((r ^ c) - c);
+		// o? (g, q, r) <- (g + f, q + u, r + v)
+		g += f & o, q += u & o, r += v & o;
+		// (delta, g, u, v) <- (delta + 1, g / 2, 2 u, 2 v)
+		++delta, g >>= 1, u <<= 1, v <<= 1;
+	}
+	t[0] = u, t[1] = v, t[2] = q, t[3] = r;
+	u = v = q = r = c = o = x = f = g = 0;
+	return delta;
+}
+
+/*
+	Сложение с произведением [n]a на w, где a, w и b -- числа со знаком
+	(в дополнительном коде): [n + 1]b <- b + a * w.
+*/
+static void zzAddMulSW(word b[], const word a[], size_t n, register word w)
+{
+	register word ma = WORD_0 - (a[n - 1] >> (B_PER_W - 1));
+	register word mw = WORD_0 - (w >> (B_PER_W - 1));
+	b[n] += zzAddMulW(b, a, n, w);
+	b[n] -= w & ma;
+	zzSubAndW(b + 1, a, n, mw);
+	ma = mw = w = 0;
+}
+
+/*
+	Линейная комбинация: [n + 2]c <- u * [n + 1]a + v * [n + 1]b.
+*/
+static void zzLinSW(word c[], const word a[], word u, const word b[],
+	word v, size_t n)
+{
+	wwSetZero(c, n + 2);
+	zzAddMulSW(c, a, n + 1, u);
+	zzAddMulSW(c, b, n + 1, v);
+}
+
+/*
+	Редукция: [n + 1]c <- [n + 2]c / 2^s \mod [n]mod, где |c| < 2^s mod,
+	m0 == -mod^{-1} \mod B.
+*/
+static void zzDivStepsRed(word c[], const word mod[], size_t n,
+	register word m0)
+{
+	register word bit;
+	// c <- c + k mod, где k: c + k mod == 0 \mod 2^s
+	m0 = (word)(c[0] * m0);
+	m0 &= (WORD_1 << ZZ_DIVSTEPS) - 1;
+	zzAddW2(c + n, 2, zzAddMulW(c, mod, n, m0));
+	ASSERT(wwGetBits(c, 0, ZZ_DIVSTEPS) == 0);
+	// c <- c / 2^s, здесь -mod < c < 2 mod
+	wwShLo(c, n + 2, ZZ_DIVSTEPS);
+	// c < 0? c <- c + mod
+	bit = c[n] >> (B_PER_W - 1);
+	c[n] += zzAddMulW(c, mod, n, bit);
+	// c <- c - mod, c < 0? c <- c + mod
+	c[n] -= zzSubMulW(c, mod, n, WORD_1);
+	bit = c[n] >> (B_PER_W - 1);
+	c[n] += zzAddMulW(c, mod, n, bit);
+	ASSERT(c[n] == 0 && wwCmp(c, mod, n) < 0);
+	bit = m0 = 0;
+}
+
+void SAFE(zzDivMod)(word b[], const word divident[], const word a[],
+	const word mod[], size_t n, void* stack)
+{
+	register word delta = 1;
+	register word mask;
+	register word m0;
+	size_t d, iter, i;
+	word t[4];
+	// переменные в stack
+	word* f = (word*)stack;
+	word* g = f + n + 1;
+	word* da = g + n + 1;
+	word* ea = da + n + 1;
+	word* c = ea + n + 1;
+	word* c1 = c + n + 2;
+	stack = c1 + n + 2;
+	// pre
+	ASSERT(wwCmp(a, mod, n) < 0);
+	ASSERT(wwCmp(divident, mod, n) < 0);
+	ASSERT(wwIsDisjoint(b, mod, n));
+	ASSERT(zzIsOdd(mod, n) && mod[n - 1] != 0);
+	// f <- mod, g <- a, da <- 0, ea <- divident
+	m0 = wordNegInv(mod[0]);
+	wwCopy(f, mod, n), f[n] = 0;
+	wwCopy(g, a, n), g[n] = 0;
+	wwSetZero(da, n + 1);
+	wwCopy(ea, divident, n), ea[n] = 0;
+	// число пакетов
+	d = wwBitSize(mod, n);
+	iter = d >= 46 ? (49 * d + 57 + 16) / 17 : (49 * d + 80 + 16) / 17;
+	iter = (iter + ZZ_DIVSTEPS - 1) / ZZ_DIVSTEPS;
+	// пакеты шагов
+	while (iter--)
+	{
+		delta = zzDivStepsW(t, delta, f[0], g[0]);
+		// (f, g) <- (u f + v g, q f + r g) / 2^s
+		zzLinSW(c, f, t[0], g, t[1], n);
+		zzLinSW(c1, f, t[2], g, t[3], n);
+		ASSERT(wwGetBits(c, 0, ZZ_DIVSTEPS) == 0);
+		ASSERT(wwGetBits(c1, 0, ZZ_DIVSTEPS) == 0);
+		wwShLo(c, n + 2, ZZ_DIVSTEPS), wwCopy(f, c, n + 1);
+		wwShLo(c1, n + 2, ZZ_DIVSTEPS), wwCopy(g, c1, n + 1);
+		// (da, ea) <- (u da + v ea, q da + r ea) / 2^s \mod mod
+		zzLinSW(c, da, t[0], ea, t[1], n);
+		zzLinSW(c1, da, t[2], ea, t[3], n);
+		zzDivStepsRed(c, mod, n, m0);
+		zzDivStepsRed(c1, mod, n, m0);
+		wwCopy(da, c, n + 1);
+		wwCopy(ea, c1, n + 1);
+	}
+	// здесь g == 0, f == \pm\gcd(a, mod)
+	ASSERT(wwIsZero(g, n + 1));
+	// f < 0? da <- -da \mod mod
+	mask = WORD_0 - (f[n] >> (B_PER_W - 1));
+	zzNegMod(c, da, mod, n);
+	for (i = 0; i < n; ++i)
+		b[i] = da[i] ^ ((da[i] ^ c[i]) & mask);
+	// gcd(a, mod) != 1? b <- 0
+	mask = (word)(wwIsW(f, n + 1, 1) | wwIsRepW(f, n + 1, WORD_MAX));
+	EXPECT(mask == WORD_1);
+	mask = WORD_0 - mask;
+	for (i = 0; i < n; ++i)
+		b[i] &= mask;
+	// очистка
+	delta = mask = m0 = 0;
+	t[0] = t[1] = t[2] = t[3] = 0;
+}
+
 size_t zzDivMod_deep(size_t n)
 {
-	return O_OF_W(4 * n);
+	return O_OF_W(6 * n + 8);
 }
 
 /*
@@ -4,7 +4,7 @@
 \brief Multiple-precision unsigned integers: modular arithmetic
 \project bee2 [cryptographic library]
 \created 2012.04.22
-\version 2022.09.23
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -251,13 +251,22 @@ size_t zzSqrMod_deep(size_t n)
 			zzMod_deep(2 * n, n));
 }
 
-void zzInvMod(word b[], const word a[], const word mod[], size_t n,
+void SAFE(zzInvMod)(word b[], const word a[], const word mod[], size_t n,
 	void* stack)
 {
 	word* divident = (word*)stack;
 	stack = divident + n;
 	wwSetW(divident, n, 1);
-	zzDivMod(b, divident, a, mod, n, stack);
+	SAFE(zzDivMod)(b, divident, a, mod, n, stack);
+}
+
+void FAST(zzInvMod)(word b[], const word a[], const word mod[], size_t n,
+	void* stack)
+{
+	word* divident = (word*)stack;
+	stack = divident + n;
+	wwSetW(divident, n, 1);
+	FAST(zzDivMod)(b, divident, a, mod, n, stack);
 }
 
 size_t zzInvMod_deep(size_t n)
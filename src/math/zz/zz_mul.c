@@ -4,7 +4,7 @@
 \brief Multiple-precision unsigned integers: multiplicative operations
 \project bee2 [cryptographic library]
 \created 2012.04.22
-\version 2019.06.26
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -17,12 +17,153 @@
 #include "bee2/math/zz.h"
 #include "zz_lcl.h"
 
+/*
+*******************************************************************************
+Умножение на слово: MULX / ADCX / ADOX
+
+Если B_PER_W == 64 и компилятор (GCC, Clang) поддерживает ассемблерные
+вставки на платформе x86-64, то функции zzMulW(), zzAddMulW(), zzSubMulW()
+при поддержке процессором наборов BMI2 и ADX (см. cpuHas()) используют
+инструкции:
+-	mulx -- умножение без изменения флагов;
+-	adcx -- сложение с переносом через флаг CF;
+-	adox -- сложение с переносом через флаг OF.
+
+В zzAddMulW() ведутся две независимые цепочки переносов:
+	b_i <- b_i + lo(w a_i) + CF   (adcx),
+	b_i <- b_i + hi(w a_{i - 1}) + OF   (adox).
+В zzSubMulW() цепочкой OF собирается произведение p = w a, а цепочкой CF
+к b прибавляется дополнение ~p + 1 (вычитание без инструкции sbb,
+которая изменяет OF). В zzMulW() используется только цепочка CF.
+
+Цикл обрабатывает по 4 слова, остаток -- по одному слову. Счетчик цикла
+изменяется инструкцией lea и проверяется инструкцией jrcxz, которые
+не изменяют флаги. Старшие половины произведений поочередно размещаются
+в регистрах h0, h1. Время выполнения не зависит от значений слов.
+
+Функция zzRedMont() использует zzAddMulW() и поэтому также ускоряется.
+
+Для остальных платформ используется реализация на языке C. В частности,
+на платформе AArch64 компиляторы преобразуют _MUL для 128-битового dword
+в пару инструкций mul / umulh со сложениями adds / adc.
+*******************************************************************************
+*/
+
+#if (B_PER_W == 64) && (defined(__GNUC__) || defined(__clang__)) &&\
+	defined(__x86_64__)
+
+#include "bee2/core/cpu.h"
+
+#define ZZ_MULX
+#define zzMulXIsAvail() cpuHas(CPU_BMI2 | CPU_ADX)
+
+#define ZZ_MULX_STEP(k, op, hp, hn)\
+	"mulx " #k "(%[a]), %[lo], %[" #hn "]\n\t"\
+	op(k, hp)\
+	"movq %[lo], " #k "(%[b])\n\t"
+
+#define ZZ_MULX_LOOP(op)\
+	"jrcxz 2f\n"\
+	"1:\n\t"\
+	ZZ_MULX_STEP(0, op, h0, h1)\
+	ZZ_MULX_STEP(8, op, h1, h0)\
+	ZZ_MULX_STEP(16, op, h0, h1)\
+	ZZ_MULX_STEP(24, op, h1, h0)\
+	"lea 32(%[a]), %[a]\n\t"\
+	"lea 32(%[b]), %[b]\n\t"\
+	"lea 1(%%rcx), %%rcx\n\t"\
+	"jrcxz 2f\n\t"\
+	"jmp 1b\n"\
+	"2:\n\t"\
+	"movq %[rem], %%rcx\n\t"\
+	"jrcxz 4f\n"\
+	"3:\n\t"\
+	ZZ_MULX_STEP(0, op, h0, h1)\
+	"movq %[h1], %[h0]\n\t"\
+	"lea 8(%[a]), %[a]\n\t"\
+	"lea 8(%[b]), %[b]\n\t"\
+	"lea 1(%%rcx), %%rcx\n\t"\
+	"jrcxz 4f\n\t"\
+	"jmp 3b\n"\
+	"4:\n\t"
+
+// lo <- lo + hp + CF
+#define ZZ_MULX_OP_MUL(k, hp)\
+	"adcx %[" #hp "], %[lo]\n\t"
+
+// lo <- lo + b_k + CF + hp + OF
+#define ZZ_MULX_OP_ADDMUL(k, hp)\
+	"adcx " #k "(%[b]), %[lo]\n\t"\
+	"adox %[" #hp "], %[lo]\n\t"
+
+// lo <- b_k + ~(lo + hp + OF) + CF
+#define ZZ_MULX_OP_SUBMUL(k, hp)\
+	"adox %[" #hp "], %[lo]\n\t"\
+	"notq %[lo]\n\t"\
+	"adcx " #k "(%[b]), %[lo]\n\t"
+
+static word zzMulWMulX(word b[], const word a[], size_t n, word w)
+{
+	word h0, h1, lo;
+	size_t cnt = (size_t)0 - (n >> 2);
+	size_t rem = (size_t)0 - (n & 3);
+	__asm__ __volatile__ (
+		"xorl %k[h0], %k[h0]\n\t"
+		ZZ_MULX_LOOP(ZZ_MULX_OP_MUL)
+		"movl $0, %k[lo]\n\t"
+		"adcx %[lo], %[h0]\n\t"
+		: [h0] "=&r"(h0), [h1] "=&r"(h1), [lo] "=&r"(lo),
+			[a] "+r"(a), [b] "+r"(b), "+c"(cnt)
+		: [rem] "r"(rem), "d"(w)
+		: "cc", "memory");
+	return h0;
+}
+
+static word zzAddMulWMulX(word b[], const word a[], size_t n, word w)
+{
+	word h0, h1, lo;
+	size_t cnt = (size_t)0 - (n >> 2);
+	size_t rem = (size_t)0 - (n & 3);
+	__asm__ __volatile__ (
+		"xorl %k[h0], %k[h0]\n\t"
+		ZZ_MULX_LOOP(ZZ_MULX_OP_ADDMUL)
+		"movl $0, %k[lo]\n\t"
+		"adcx %[lo], %[h0]\n\t"
+		"adox %[lo], %[h0]\n\t"
+		: [h0] "=&r"(h0), [h1] "=&r"(h1), [lo] "=&r"(lo),
+			[a] "+r"(a), [b] "+r"(b), "+c"(cnt)
+		: [rem] "r"(rem), "d"(w)
+		: "cc", "memory");
+	return h0;
+}
+
+static word zzSubMulWMulX(word b[], const word a[], size_t n, word w)
+{
+	word h0, h1, lo;
+	size_t cnt = (size_t)0 - (n >> 2);
+	size_t rem = (size_t)0 - (n & 3);
+	__asm__ __volatile__ (
+		"xorl %k[h0], %k[h0]\n\t"
+		"stc\n\t"
+		ZZ_MULX_LOOP(ZZ_MULX_OP_SUBMUL)
+		"movl $0, %k[lo]\n\t"
+		"adox %[lo], %[h0]\n\t"
+		"notq %[h0]\n\t"
+		"adcx %[lo], %[h0]\n\t"
+		: [h0] "=&r"(h0), [h1] "=&r"(h1), [lo] "=&r"(lo),
+			[a] "+r"(a), [b] "+r"(b), "+c"(cnt)
+		: [rem] "r"(rem), "d"(w)
+		: "cc", "memory");
+	return WORD_0 - h0;
+}
+
+#endif
+
 /*
 *******************************************************************************
 Умножение / возведение в квадрат
 
 \todo Возведение в квадрат за один проход (?), сначала с квадратов (?).
-\todo Умножение Карацубы.
 *******************************************************************************
 */
 
@@ -32,6 +173,10 @@ word zzMulW(word b[], const word a[], size_t n, register word w)
 	register dword prod;
 	size_t i;
 	ASSERT(wwIsSameOrDisjoint(a, b, n));
+#ifdef ZZ_MULX
+	if (n && zzMulXIsAvail())
+		return zzMulWMulX(b, a, n, w);
+#endif
 	for (i = 0; i < n; ++i)
 	{
 		_MUL(prod, w, a[i]);
@@ -49,6 +194,10 @@ word zzAddMulW(word b[], const word a[], size_t n, register word w)
 	register dword prod;
 	size_t i;
 	ASSERT(wwIsSameOrDisjoint(a, b, n));
+#ifdef ZZ_MULX
+	if (n && zzMulXIsAvail())
+		return zzAddMulWMulX(b, a, n, w);
+#endif
 	for (i = 0; i < n; ++i)
 	{
 		_MUL(prod, w, a[i]);
@@ -67,6 +216,10 @@ word zzSubMulW(word b[], const word a[], size_t n, register word w)
 	register dword prod;
 	size_t i;
 	ASSERT(wwIsSameOrDisjoint(a, b, n));
+#ifdef ZZ_MULX
+	if (n && zzMulXIsAvail())
+		return zzSubMulWMulX(b, a, n, w);
+#endif
 	for (i = 0; i < n; ++i)
 	{
 		_MUL(prod, w, a[i]);
@@ -80,84 +233,190 @@ word zzSubMulW(word b[], const word a[], size_t n, register word w)
 	return borrow;
 }
 
-void zzMul(word c[], const word a[], size_t n, const word b[], size_t m, 
-	void* stack)
+static void zzMulSchool(word c[], const word a[], size_t n, const word b[],
+	size_t m)
 {
-	register word carry = 0;
-	register dword prod;
-	size_t i, j;
-	ASSERT(wwIsDisjoint2(a, n, c, n + m));
-	ASSERT(wwIsDisjoint2(b, m, c, n + m));
+	size_t i;
 	wwSetZero(c, n + m);
 	for (i = 0; i < n; ++i)
-	{
-		for (j = 0; j < m; ++j)
-		{
-			_MUL(prod, a[i], b[j]);
-			prod += carry;
-			prod += c[i + j];
-			c[i + j] = (word)prod;
-			carry = (word)(prod >> B_PER_W);
-		}
-		c[i + j] = carry;
-		carry = 0;
-	}
-	prod = 0;
+		c[i + m] = zzAddMulW(c + i, b, m, a[i]);
 }
 
-size_t zzMul_deep(size_t n, size_t m)
-{
-	return 0;
-}
-
-void zzSqr(word b[], const word a[], size_t n, void* stack)
+static void zzSqrSchool(word b[], const word a[], size_t n)
 {
 	register word carry = 0;
-	register word carry1;
+	register word lo, hi;
 	register dword prod;
-	size_t i, j;
-	ASSERT(wwIsDisjoint2(a, n, b, n + n));
+	size_t i;
 	// b <- \sum_{i < j} a_i a_j B^{i + j}
 	wwSetZero(b, n + n);
 	for (i = 0; i < n; ++i)
-	{
-		for (j = i + 1; j < n; ++j)
-		{
-			_MUL(prod, a[i], a[j]);
-			prod += carry;
-			prod += b[i + j];
-			b[i + j] = (word)prod;
-			carry = (word)(prod >> B_PER_W);
-		}
-		b[i + j] = carry;
-		carry = 0;
-	}
-	// b <- 2 b
-	for (i = 0; i < n + n; ++i)
-	{
-		carry1 = b[i] >> (B_PER_W - 1);
-		b[i] = (b[i] << 1) | carry;
-		carry = carry1;
-	}
-	// b <- b + \sum_i a_i^2 B^{i + i}
+		b[i + n] = zzAddMulW(b + i + i + 1, a + i + 1, n - i - 1, a[i]);
+	// b <- 2 b + \sum_i a_i^2 B^{i + i} (удвоение совмещено со сложением)
 	for (i = 0; i < n; ++i)
 	{
+		lo = b[i + i], hi = b[i + i + 1];
 		_MUL(prod, a[i], a[i]);
 		prod += carry;
-		prod += b[i + i];
+		prod += (word)(lo << 1);
 		b[i + i] = (word)prod;
 		prod >>= B_PER_W;
-		prod += b[i + i + 1];
+		prod += (word)(hi << 1 | lo >> (B_PER_W - 1));
 		b[i + i + 1] = (word)prod;
-		carry = (word)(prod >> B_PER_W);
+		carry = (word)(prod >> B_PER_W) + (hi >> (B_PER_W - 1));
 	}
 	prod = 0;
-	carry = carry1 = 0;
+	carry = lo = hi = 0;
+}
+
+/*
+*******************************************************************************
+Умножение Карацубы
+
+[input]     a = a1 B^h + a0, b = b1 B^h + b0, h = n / 2, h1 = n - h
+[c0, c1]    c <- a1 b1 B^{2h} + a0 b0
+[s]         s <- (a0 + a1)(b0 + b1) - a0 b0 - a1 b1 = a0 b1 + a1 b0
+[c]         c <- c + s B^h
+
+Возведение в квадрат выполняется аналогично: s <- (a0 + a1)^2 - a0^2 - a1^2.
+
+Суммы a0 + a1, b0 + b1 занимают h1 + 1 слов, их произведение s -- 2 h1 + 2
+слов, но s < 2 B^n, поэтому при h >= 2 сложение c + s B^h не выходит
+за пределы c. Произведения половин вычисляются рекурсивно с помощью zzMul()
+(zzSqr()), которые переходят к школьным алгоритмам на числах из менее
+чем ZZ_KARATSUBA_THRESHOLD (ZZ_KARATSUBA_THRESHOLD_SQR) слов.
+
+Алгоритм Карацубы не содержит ветвлений, зависящих от данных.
+
+\remark Пороги подобраны на x86-64. Пороги можно переопределить
+при сборке.
+*******************************************************************************
+*/
+
+#ifndef ZZ_KARATSUBA_THRESHOLD
+	#define ZZ_KARATSUBA_THRESHOLD (2048 / B_PER_W)
+#endif
+
+#ifndef ZZ_KARATSUBA_THRESHOLD_SQR
+	#define ZZ_KARATSUBA_THRESHOLD_SQR (2048 / B_PER_W)
+#endif
+
+#if (ZZ_KARATSUBA_THRESHOLD < 4 || ZZ_KARATSUBA_THRESHOLD_SQR < 4)
+	#error "Karatsuba thresholds are too low"
+#endif
+
+static void zzKaratsubaAdd(word c[], size_t n, word s[], size_t h,
+	const word c0[], size_t n0, const word c1[], size_t n1, size_t ns)
+{
+	register word w;
+	// s <- s - c0 - c1
+	w = zzSub2(s, c0, n0);
+	zzSubW2(s + n0, ns - n0, w);
+	w = zzSub2(s, c1, n1);
+	zzSubW2(s + n1, ns - n1, w);
+	// c <- c + s B^h
+	ns = MIN2(ns, n - h);
+	w = zzAdd2(c + h, s, ns);
+	zzAddW2(c + h + ns, n - h - ns, w);
+	w = 0;
+}
+
+static void zzMulKaratsuba(word c[], const word a[], const word b[],
+	size_t n, void* stack)
+{
+	const size_t h = n / 2, h1 = n - h;
+	// переменные в stack
+	word* sa = (word*)stack;
+	word* sb = sa + h1 + 1;
+	word* s = sb + h1 + 1;
+	stack = s + 2 * h1 + 2;
+	// c <- a1 b1 B^{2h} + a0 b0
+	zzMul(c, a, h, b, h, stack);
+	zzMul(c + 2 * h, a + h, h1, b + h, h1, stack);
+	// sa <- a0 + a1, sb <- b0 + b1
+	wwCopy(sa, a + h, h1);
+	sa[h1] = zzAddW2(sa + h, h1 - h, zzAdd2(sa, a, h));
+	wwCopy(sb, b + h, h1);
+	sb[h1] = zzAddW2(sb + h, h1 - h, zzAdd2(sb, b, h));
+	// s <- sa sb
+	zzMul(s, sa, h1 + 1, sb, h1 + 1, stack);
+	// c <- c + (s - a0 b0 - a1 b1) B^h
+	zzKaratsubaAdd(c, 2 * n, s, h, c, 2 * h, c + 2 * h, 2 * h1, 2 * h1 + 2);
+}
+
+static size_t zzMulKaratsuba_deep(size_t n)
+{
+	const size_t h1 = n - n / 2;
+	return O_OF_W(4 * h1 + 4) + zzMul_deep(h1 + 1, h1 + 1);
+}
+
+static void zzSqrKaratsuba(word b[], const word a[], size_t n, void* stack)
+{
+	const size_t h = n / 2, h1 = n - h;
+	// переменные в stack
+	word* sa = (word*)stack;
+	word* s = sa + h1 + 1;
+	stack = s + 2 * h1 + 2;
+	// b <- a1^2 B^{2h} + a0^2
+	zzSqr(b, a, h, stack);
+	zzSqr(b + 2 * h, a + h, h1, stack);
+	// sa <- a0 + a1
+	wwCopy(sa, a + h, h1);
+	sa[h1] = zzAddW2(sa + h, h1 - h, zzAdd2(sa, a, h));
+	// s <- sa^2
+	zzSqr(s, sa, h1 + 1, stack);
+	// b <- b + (s - a0^2 - a1^2) B^h
+	zzKaratsubaAdd(b, 2 * n, s, h, b, 2 * h, b + 2 * h, 2 * h1, 2 * h1 + 2);
+}
+
+static size_t zzSqrKaratsuba_deep(size_t n)
+{
+	const size_t h1 = n - n / 2;
+	return O_OF_W(3 * h1 + 3) + zzSqr_deep(h1 + 1);
+}
+
+/*
+*******************************************************************************
+Умножение / возведение в квадрат: выбор алгоритма
+
+Алгоритм Карацубы применяется к числам одинаковой длины. Глубина стека
+zzMul_deep(n, m) оценивается по max(n, m): при нормализации
+длин (см., например, zzLCM()) числа могут стать одинаковой длины.
+*******************************************************************************
+*/
+
+void zzMul(word c[], const word a[], size_t n, const word b[], size_t m, 
+	void* stack)
+{
+	ASSERT(wwIsDisjoint2(a, n, c, n + m));
+	ASSERT(wwIsDisjoint2(b, m, c, n + m));
+	if (n == m && n >= ZZ_KARATSUBA_THRESHOLD)
+		zzMulKaratsuba(c, a, b, n, stack);
+	else
+		zzMulSchool(c, a, n, b, m);
+}
+
+size_t zzMul_deep(size_t n, size_t m)
+{
+	if (MIN2(n, m) < ZZ_KARATSUBA_THRESHOLD)
+		return 0;
+	return zzMulKaratsuba_deep(MAX2(n, m));
+}
+
+void zzSqr(word b[], const word a[], size_t n, void* stack)
+{
+	ASSERT(wwIsDisjoint2(a, n, b, n + n));
+	if (n >= ZZ_KARATSUBA_THRESHOLD_SQR)
+		zzSqrKaratsuba(b, a, n, stack);
+	else
+		zzSqrSchool(b, a, n);
 }
 
 size_t zzSqr_deep(size_t n)
 {
-	return 0;
+	if (n < ZZ_KARATSUBA_THRESHOLD_SQR)
+		return 0;
+	return zzSqrKaratsuba_deep(n);
 }
 
 /*
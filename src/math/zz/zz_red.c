@@ -4,7 +4,7 @@
 \brief Multiple-precision unsigned integers: modular reductions
 \project bee2 [cryptographic library]
 \created 2012.04.22
-\version 2019.06.26
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -229,6 +229,10 @@ DSP56000. Advances in Cryptology -- EUROCRYPT 90, LNCS 473, 230–244. 1990]:
                a <- a / B^n
              if (a >= mod)
                a <- a - mod
+
+Перенос из слова a[i + n] не распространяется сразу по старшим словам,
+а накапливается (carry) и добавляется к a[i + n + 1] на следующем шаге.
+Поэтому шаг сводится к вызову zzAddMulW() и одному сложению слов.
 *******************************************************************************
 */
 
@@ -237,6 +241,7 @@ void FAST(zzRedMont)(word a[], const word mod[], size_t n,
 {
 	register word carry = 0;
 	register word w;
+	register dword prod;
 	size_t i;
 	// pre
 	ASSERT(wwIsDisjoint2(a, 2 * n, mod, n));
@@ -246,7 +251,11 @@ void FAST(zzRedMont)(word a[], const word mod[], size_t n,
 	for (i = 0; i < n; ++i)
 	{
 		_MUL_LO(w, a[i], mont_param);
-		carry |= zzAddW2(a + i + n, n - i, zzAddMulW(a + i, mod, n, w));
+		prod = zzAddMulW(a + i, mod, n, w);
+		prod += carry;
+		prod += a[i + n];
+		a[i + n] = (word)prod;
+		carry = (word)(prod >> B_PER_W);
 	}
 	ASSERT(wwIsZero(a, n));
 	// a <- a / B^n
@@ -257,6 +266,7 @@ void FAST(zzRedMont)(word a[], const word mod[], size_t n,
 		// a <- a - mod
 		zzSub2(a, mod, n);
 	// очистка
+	prod = 0;
 	carry = w = 0;
 }
 
@@ -265,6 +275,7 @@ void SAFE(zzRedMont)(word a[], const word mod[], size_t n,
 {
 	register word carry = 0;
 	register word w = 0;
+	register dword prod;
 	size_t i;
 	// pre
 	ASSERT(wwIsDisjoint2(a, 2 * n, mod, n));
@@ -274,7 +285,11 @@ void SAFE(zzRedMont)(word a[], const word mod[], size_t n,
 	for (i = 0; i < n; ++i)
 	{
 		_MUL_LO(w, a[i], mont_param);
-		carry |= zzAddW2(a + i + n, n - i, zzAddMulW(a + i, mod, n, w));
+		prod = zzAddMulW(a + i, mod, n, w);
+		prod += carry;
+		prod += a[i + n];
+		a[i + n] = (word)prod;
+		carry = (word)(prod >> B_PER_W);
 	}
 	ASSERT(wwIsZero(a, n));
 	// a <- a / B^n, a >= mod?
@@ -287,6 +302,7 @@ void SAFE(zzRedMont)(word a[], const word mod[], size_t n,
 	w |= carry, w = WORD_0 - w;
 	zzSubAndW(a, mod, n, w);
 	// очистка
+	prod = 0;
 	carry = w = 0;
 }
 
@@ -0,0 +1,276 @@
+/*
+*******************************************************************************
+\file bench.c
+\brief Bee2 benchmarking
+\project bee2/test
+\created 2026.10.14
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <bee2/core/dec.h>
+#include <bee2/core/str.h>
+#include <bee2/core/tm.h>
+#include <bee2/core/util.h>
+#include "bench.h"
+
+#if defined(OS_WIN)
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <sched.h>
+#endif
+
+/*
+*******************************************************************************
+Параметры замеров
+
+Выборка должна длиться не менее BENCH_MIN_TICKS тактов, число операций
+в выборке не превышает BENCH_MAX_ITERS.
+*******************************************************************************
+*/
+
+#define BENCH_TEXT	0
+#define BENCH_CSV	1
+#define BENCH_JSON	2
+
+#define BENCH_MAX_REPS	1001
+#define BENCH_MIN_TICKS	((tm_ticks_t)1 << 18)
+#define BENCH_MAX_ITERS	((size_t)1 << 20)
+
+static int _fmt = BENCH_TEXT;
+static size_t _reps = 31;
+static size_t _warmup = 3;
+static char** _filters;
+static int _filters_count;
+static size_t _records;
+static double _samples[BENCH_MAX_REPS];
+
+/*
+*******************************************************************************
+Разбор командной строки
+*******************************************************************************
+*/
+
+static bool_t benchParseSize(size_t* val, const char* str)
+{
+	if (!str || !decIsValid(str) || strLen(str) == 0 || strLen(str) > 9)
+		return FALSE;
+	*val = (size_t)decToU32(str);
+	return TRUE;
+}
+
+static bool_t benchPin(size_t cpu)
+{
+#if defined(OS_WIN)
+	if (cpu >= 8 * sizeof(DWORD_PTR))
+		return FALSE;
+	return SetThreadAffinityMask(GetCurrentThread(),
+		(DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+	cpu_set_t set;
+	if (cpu >= CPU_SETSIZE)
+		return FALSE;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+	return FALSE;
+#endif
+}
+
+bool_t benchInit(int argc, char* argv[])
+{
+	size_t cpu;
+	// пропустить имя программы
+	--argc, ++argv;
+	// разбор опций
+	for (; argc && strStartsWith(argv[0], "-"); --argc, ++argv)
+		if (strEq(argv[0], "-json"))
+			_fmt = BENCH_JSON;
+		else if (strEq(argv[0], "-csv"))
+			_fmt = BENCH_CSV;
+		else if (strEq(argv[0], "-quick"))
+			_reps = 3, _warmup = 0;
+		else if (strEq(argv[0], "-reps") && argc > 1)
+		{
+			if (!benchParseSize(&_reps, argv[1]) || _reps == 0 ||
+				_reps > BENCH_MAX_REPS)
+				return FALSE;
+			--argc, ++argv;
+		}
+		else if (strEq(argv[0], "-warmup") && argc > 1)
+		{
+			if (!benchParseSize(&_warmup, argv[1]))
+				return FALSE;
+			--argc, ++argv;
+		}
+		else if (strEq(argv[0], "-cpu") && argc > 1)
+		{
+			if (!benchParseSize(&cpu, argv[1]) || !benchPin(cpu))
+				return FALSE;
+			--argc, ++argv;
+		}
+		else
+			return FALSE;
+	// фильтры
+	_filters = argv, _filters_count = argc;
+	// заголовки
+	if (_fmt == BENCH_CSV)
+		printf("group,name,size,reps,iters,min,median,p99,cpb,speed\n");
+	else if (_fmt == BENCH_JSON)
+		printf("[");
+	return TRUE;
+}
+
+bool_t benchIsSelected(const char* group, const char* name)
+{
+	int i;
+	if (_filters_count == 0)
+		return TRUE;
+	for (i = 0; i < _filters_count; ++i)
+		if (strstr(group, _filters[i]) || strstr(name, _filters[i]))
+			return TRUE;
+	return FALSE;
+}
+
+/*
+*******************************************************************************
+Замеры
+*******************************************************************************
+*/
+
+static tm_ticks_t benchSample(bench_op_i op, void* ctx, size_t iters)
+{
+	tm_ticks_t ticks;
+	for (ticks = tmTicks(); iters--;)
+		op(ctx);
+	return tmTicks() - ticks;
+}
+
+static int benchCmp(const void* a, const void* b)
+{
+	const double* x = (const double*)a;
+	const double* y = (const double*)b;
+	return *x < *y ? -1 : (*x > *y ? 1 : 0);
+}
+
+double benchRun(const char* group, const char* name, size_t size,
+	bench_op_i op, void* ctx)
+{
+	size_t iters, i;
+	double min, med, p99, speed;
+	if (!benchIsSelected(group, name))
+		return 0;
+	// калибровка (первый прогрев)
+	for (iters = 1; iters < BENCH_MAX_ITERS; iters *= 2)
+		if (benchSample(op, ctx, iters) >= BENCH_MIN_TICKS)
+			break;
+	// прогрев
+	for (i = 0; i < _warmup; ++i)
+		benchSample(op, ctx, iters);
+	// выборки
+	for (i = 0; i < _reps; ++i)
+		_samples[i] = (double)benchSample(op, ctx, iters) / iters;
+	qsort(_samples, _reps, sizeof(double), benchCmp);
+	min = _samples[0];
+	med = _samples[_reps / 2];
+	p99 = _samples[(99 * _reps + 99) / 100 - 1];
+	// скорость: октетов или операций в секунду
+	speed = med > 0 ? (double)tmFreq() / med : 0;
+	if (size)
+		speed *= (double)size / 1024;
+	// печать
+	if (_fmt == BENCH_CSV)
+		printf("%s,%s,%u,%u,%u,%.1f,%.1f,%.1f,%.2f,%.0f\n",
+			group, name, (unsigned)size, (unsigned)_reps, (unsigned)iters,
+			min, med, p99, size ? med / size : 0.0, speed);
+	else if (_fmt == BENCH_JSON)
+		printf("%s\n  {\"group\": \"%s\", \"name\": \"%s\", \"size\": %u, "
+			"\"reps\": %u, \"iters\": %u, \"min\": %.1f, \"median\": %.1f, "
+			"\"p99\": %.1f, \"%s\": %.0f}",
+			_records ? "," : "", group, name, (unsigned)size,
+			(unsigned)_reps, (unsigned)iters, min, med, p99,
+			size ? "kbytes_per_sec" : "ops_per_sec", speed);
+	else if (size)
+		printf("%s::%s[%u]: %.2f cpb (p99 %.2f) [%.0f kBytes/sec]\n",
+			group, name, (unsigned)size, med / size, p99 / size, speed);
+	else
+		printf("%s::%s: %.0f cycles/op (p99 %.0f) [%.0f ops/sec]\n",
+			group, name, med, p99, speed);
+	++_records;
+	return med;
+}
+
+void benchNote(const char* group, const char* name, const char* value)
+{
+	if (_fmt == BENCH_CSV)
+		printf("# %s::%s = %s\n", group, name, value);
+	else if (_fmt == BENCH_JSON)
+		printf("%s\n  {\"group\": \"%s\", \"note\": \"%s\", \"value\": \"%s\"}",
+			_records++ ? "," : "", group, name, value);
+	else
+		printf("%s::%s = %s\n", group, name, value);
+}
+
+void benchClose()
+{
+	if (_fmt == BENCH_JSON)
+		printf("\n]\n");
+}
+
+/*
+*******************************************************************************
+main
+*******************************************************************************
+*/
+
+extern bool_t ecpBench();
+extern bool_t zmBench();
+extern bool_t beltBench();
+extern bool_t bashBench();
+extern bool_t keepBench();
+extern bool_t deepBench();
+extern bool_t mtBench();
+extern bool_t pkBench();
+
+static int benchUsage()
+{
+	printf(
+		"bee2bench: benchmarks of the Bee2 library\n"
+		"Usage:\n"
+		"  bee2bench [options] [filter ...]\n"
+		"  options:\n"
+		"    -json, -csv -- output format (text by default)\n"
+		"    -reps N -- number of samples (31 by default)\n"
+		"    -warmup N -- number of warmup samples (3 by default)\n"
+		"    -cpu K -- pin the thread to the processor K\n"
+		"    -quick -- 3 samples without warmup\n"
+		"  filter: a substring of benchmark names\n"
+	);
+	return -1;
+}
+
+int main(int argc, char* argv[])
+{
+	int ret = 0;
+	if (!benchInit(argc, argv))
+		return benchUsage();
+	ret |= !ecpBench();
+	ret |= !zmBench();
+	ret |= !beltBench();
+	ret |= !bashBench();
+	ret |= !keepBench();
+	ret |= !deepBench();
+	ret |= !mtBench();
+	ret |= !pkBench();
+	benchClose();
+	return ret;
+}
@@ -0,0 +1,120 @@
+/*
+*******************************************************************************
+\file bench.h
+\brief Benchmark harness
+\project bee2/test
+\created 2026.10.14
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+/*!
+*******************************************************************************
+\file bench.h
+\brief Замеры производительности
+
+Замер состоит из прогрева и серии повторов (выборок). В каждой выборке
+операция выполняется iters раз, где iters подбирается при прогреве так,
+чтобы продолжительность выборки была не меньше порога. По выборкам
+определяются минимальное, медианное и 99-процентильное числа тактов
+на операцию.
+
+Результаты печатаются в текстовом формате, в формате CSV или в формате JSON
+(массив объектов). Формат и параметры замеров задаются в командной строке
+bee2bench (см. benchInit()).
+
+Скорость обработки определяется по медианному числу тактов по правилам
+tmSpeed().
+*******************************************************************************
+*/
+
+#ifndef __BEE2_TEST_BENCH_H
+#define __BEE2_TEST_BENCH_H
+
+#include <bee2/defs.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!	\brief Операция
+
+	Операция выполняется над контекстом ctx.
+*/
+typedef void (*bench_op_i)(
+	void* ctx			/*!< [in,out] контекст */
+);
+
+/*!	\brief Инициализация замеров
+
+	Разбираются параметры командной строки [argc]argv:
+	- -json, -csv -- формат вывода (по умолчанию текстовый);
+	- -reps N -- число выборок (по умолчанию 31);
+	- -warmup N -- число прогревочных выборок (по умолчанию 3);
+	- -cpu K -- закрепить поток за процессором K;
+	- -quick -- быстрый режим (3 выборки без прогрева);
+	- остальные параметры -- подстроки имен (групп) замеров, которые следует
+	  выполнить (по умолчанию выполняются все замеры).
+	.
+	\return Признак успеха.
+*/
+bool_t benchInit(
+	int argc,			/*!< [in] число параметров */
+	char* argv[]		/*!< [in] параметры */
+);
+
+/*!	\brief Замер выбран?
+
+	Проверяется, что замер name группы group не исключен в benchInit().
+	\remark Функция предназначена для замеров, которые выполняются
+	не через benchRun().
+	\return Признак выбора.
+*/
+bool_t benchIsSelected(
+	const char* group,	/*!< [in] группа замеров */
+	const char* name	/*!< [in] название замера */
+);
+
+/*!	\brief Замер производительности
+
+	В группе замеров group выполняется замер name операции op() над
+	контекстом ctx, обрабатывающей size октетов данных. Результаты
+	печатаются.
+	\remark Если size == 0, то печатается число операций в секунду,
+	в противном случае -- число тактов на октет и скорость обработки данных.
+	\remark Замер не выполняется, если он исключен в benchInit().
+	\return Медианное число тактов на операцию или 0, если замер
+	не выполнялся.
+*/
+double benchRun(
+	const char* group,	/*!< [in] группа замеров */
+	const char* name,	/*!< [in] название замера */
+	size_t size,		/*!< [in] число октетов, обрабатываемых op() */
+	bench_op_i op,		/*!< [in] операция */
+	void* ctx			/*!< [in,out] контекст */
+);
+
+/*!	\brief Примечание
+
+	В группе замеров group печатается примечание name = value
+	(например, используемая платформа).
+*/
+void benchNote(
+	const char* group,	/*!< [in] группа замеров */
+	const char* name,	/*!< [in] название */
+	const char* value	/*!< [in] значение */
+);
+
+/*!	\brief Завершение замеров
+
+	Завершается вывод результатов.
+*/
+void benchClose();
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __BEE2_TEST_BENCH_H */
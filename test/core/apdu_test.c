@@ -4,7 +4,7 @@
 \brief Tests for APDU formats
 \project bee2/test
 \created 2022.10.31
-\version 2023.03.30
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -31,7 +31,10 @@ bool_t apduTest()
 	apdu_cmd_t* cmd1 = (apdu_cmd_t*)(stack + 1024);
 	apdu_resp_t* resp = (apdu_resp_t*)stack;
 	apdu_resp_t* resp1 = (apdu_resp_t*)(stack + 1024);
+	apdu_cmd_view_t cview[1];
+	apdu_resp_view_t rview[1];
 	octet apdu[1024];
+	octet apdu1[1024];
 	size_t count;
 	size_t count1;
 	// cmd: точечный тест
@@ -66,6 +69,27 @@ bool_t apduTest()
 				apduCmdDec(cmd1, apdu, count) != count1 ||
 				!memEq(cmd, cmd1, count1))
 				return FALSE;
+			// представление и кодирование на месте
+			if (!apduCmdView(cview, apdu, count) ||
+				cview->cla != cmd->cla || cview->ins != cmd->ins ||
+				cview->p1 != cmd->p1 || cview->p2 != cmd->p2 ||
+				cview->cdf_len != cmd->cdf_len ||
+				cview->rdf_len != cmd->rdf_len ||
+				cview->cdf != apdu +
+					apduCmdCDFOffset(cmd->cdf_len, cmd->rdf_len) ||
+				apduCmdView(0, apdu, count - 1) !=
+					(apduCmdDec(0, apdu, count - 1) != SIZE_MAX))
+				return FALSE;
+			memCopy(apdu1 + apduCmdCDFOffset(cmd->cdf_len, cmd->rdf_len),
+				cmd->cdf, cmd->cdf_len);
+			if (apduCmdEnc2(0, apdu, cmd->cdf_len, cmd->rdf_len) != count ||
+				apduCmdEnc2(apdu1, apdu, cmd->cdf_len, cmd->rdf_len) !=
+					count ||
+				!memEq(apdu1, apdu, count) ||
+				apduCmdEnc2(apdu1, apdu1, cmd->cdf_len, cmd->rdf_len) !=
+					count ||
+				!memEq(apdu1, apdu, count))
+				return FALSE;
 		}
 	// resp: точечный тест
 	memSetZero(resp, sizeof(apdu_resp_t));
@@ -84,6 +108,16 @@ bool_t apduTest()
 		apduRespDec(resp1, apdu, count) != count1 ||
 		!memEq(resp, resp1, count1))
 		return FALSE;
+	if (!apduRespView(rview, apdu, count) ||
+		rview->sw1 != 0x90 || rview->sw2 != 0x00 ||
+		rview->rdf_len != 20 || rview->rdf != apdu ||
+		apduRespView(0, apdu, 1))
+		return FALSE;
+	memCopy(apdu1, resp->rdf, 20);
+	if (apduRespEnc2(0, 20, 0x90, 0x00) != count ||
+		apduRespEnc2(apdu1, 20, 0x90, 0x00) != count ||
+		!memEq(apdu1, apdu, count))
+		return FALSE;
 	// все нормально
 	return TRUE;
 }
@@ -4,7 +4,7 @@
 \brief Tests for base64 encoding
 \project bee2/test
 \created 2016.06.16
-\version 2016.06.16
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -51,6 +51,18 @@ bool_t b64Test()
 		if (!memEq(buf, beltH(), count))
 			return FALSE;
 	}
+	// декодирование с проверкой (в том числе векторное)
+	for (count = 1; count < 256; ++count)
+	{
+		size_t t = sizeof(buf);
+		bool_t valid = ('A' <= count && count <= 'Z') ||
+			('a' <= count && count <= 'z') || ('0' <= count && count <= '9') ||
+			count == '+' || count == '/';
+		b64From(b64, beltH(), 60);
+		b64[count % 80] = (char)count;
+		if (b64IsValid(b64) != valid || b64To(buf, &t, b64) != valid)
+			return FALSE;
+	}
 	// все нормально
 	return TRUE;
 }
@@ -4,7 +4,7 @@
 \brief Tests for blob functions
 \project bee2/test
 \created 2023.03.21
-\version 2023.03.23
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -23,6 +23,9 @@ bool_t blobTest()
 {
 	blob_t b1 = 0;
 	blob_t b2 = 0;
+	blob_stat_t stat[1];
+	blob_stat_t stat1[1];
+	size_t size;
 	// create / resize
 	b1 = blobCreate(123);		
 	b2 = blobResize(b2, 120);
@@ -58,5 +61,72 @@ bool_t blobTest()
 	blobWipe(b2);
 	blobClose(b2);
 	blobClose(b1);
+	// size classes / resize
+	blobStat(stat);
+	for (size = 1, b1 = 0; size <= 100000; size = 3 * size + 1)
+	{
+		if (!(b2 = blobCreate(size)) || !memIsZero(b2, size) ||
+			!memIsAligned(b2, BLOB_ALIGN))
+		{
+			blobClose(b2), blobClose(b1);
+			return FALSE;
+		}
+		memSet(b2, 0xA5, size);
+		blobClose(b2);
+		if (!(b2 = blobResize(b1, size)))
+		{
+			blobClose(b1);
+			return FALSE;
+		}
+		b1 = b2;
+		if (blobSize(b1) != size || ((octet*)b1)[size - 1] != 0 ||
+			!memIsRep(b1, size / 3, 0x36))
+		{
+			blobClose(b1);
+			return FALSE;
+		}
+		memSet(b1, 0x36, size);
+	}
+	b1 = blobResize(b1, 10);
+	if (!b1 || !memIsRep(b1, 10, 0x36))
+	{
+		blobClose(b1);
+		return FALSE;
+	}
+	blobClose(b1);
+	// statistics
+	blobStat(stat1);
+	if (stat1->created < stat->created + 11 ||
+		stat1->closed < stat->closed + 11 ||
+		stat1->pooled < stat->pooled + 7 ||
+		stat1->locked > stat1->arenas)
+		return FALSE;
+	// large blobs (page mappings)
+	size = ((size_t)1 << 21) + 1000;
+	if (!(b1 = blobCreate(size)) || !memIsZero(b1, size) ||
+		!memIsAligned(b1, BLOB_ALIGN))
+	{
+		blobClose(b1);
+		return FALSE;
+	}
+	memSet(b1, 0x36, size);
+	b2 = blobResize(b1, size + 1000);
+	if (!b2 || !memIsRep(b2, size, 0x36) || !memIsZero((octet*)b2 + size, 1000))
+	{
+		blobClose(b2 ? b2 : b1);
+		return FALSE;
+	}
+	b1 = blobResize(b2, 100);
+	if (!b1 || !memIsRep(b1, 100, 0x36))
+	{
+		blobClose(b1);
+		return FALSE;
+	}
+	blobClose(b1);
+	blobStat(stat);
+	if (stat->mapped < stat1->mapped ||
+		stat->huge_size != stat1->huge_size ||
+		stat->thp_size != stat1->thp_size)
+		return FALSE;
 	return TRUE;
 }
@@ -0,0 +1,52 @@
+/*
+*******************************************************************************
+\file cpu_test.c
+\brief Tests for CPU features
+\project bee2/test
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include <bee2/core/cpu.h>
+#include <bee2/core/str.h>
+
+/*
+*******************************************************************************
+Тестирование
+
+Проверяется, что наборы определяются однократно, что зависимые наборы
+поддерживаются только вместе с базовыми и что у всех флагов есть имена.
+*******************************************************************************
+*/
+
+bool_t cpuTest()
+{
+	u32 f = cpuFeatures();
+	u32 feature;
+	// однократность
+	if (cpuFeatures() != f || !cpuHas(0) || !cpuHas(f) ||
+		cpuHas(f | 0x80000000))
+		return FALSE;
+	// зависимости
+	if (cpuHas(CPU_AVX2) && !cpuHas(CPU_AVX | CPU_SSE2) ||
+		cpuHas(CPU_AVX512F) && !cpuHas(CPU_AVX) ||
+		cpuHas(CPU_AVX512BW) && !cpuHas(CPU_AVX512F) ||
+		cpuHas(CPU_AVX512VBMI) && !cpuHas(CPU_AVX512F) ||
+		cpuHas(CPU_AVX512IFMA) && !cpuHas(CPU_AVX512F) ||
+		cpuHas(CPU_PMULL) && !cpuHas(CPU_NEON) ||
+		cpuHas(CPU_SSE2) && cpuHas(CPU_NEON))
+		return FALSE;
+	// имена
+	for (feature = 1; feature <= CPU_PMULL; feature <<= 1)
+		if ((f & feature) && (!cpuName(feature) ||
+			!strIsValid(cpuName(feature))))
+			return FALSE;
+	if (!strEq(cpuName(CPU_AVX2), "avx2") || cpuName(0) ||
+		cpuName(CPU_AVX | CPU_AVX2))
+		return FALSE;
+	// все нормально
+	return TRUE;
+}
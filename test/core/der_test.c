@@ -4,7 +4,7 @@
 \brief Tests for DER encoding rules
 \project bee2/test
 \created 2021.04.12
-\version 2022.11.01
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -41,6 +41,21 @@
 	(ptr) += t, (count) -= t;\
 }\
 
+#define derCurStep(step, cur, der, fed, count)\
+{\
+	size_t t;\
+	while ((t = (step)) == SIZE_MAX && (cur)->need)\
+	{\
+		if ((fed) == (count))\
+			return FALSE;\
+		++(fed);\
+		derCurFeed(cur, (der) + (cur)->pos, (fed) - (cur)->pos, (cur)->pos,\
+			(fed) == (count));\
+	}\
+	if (t == SIZE_MAX)\
+		return FALSE;\
+}\
+
 
 bool_t derTest()
 {
@@ -223,6 +238,68 @@ bool_t derTest()
 		if (count != 0)
 			return FALSE;
 	}
+	// курсор: Seq2
+	{
+		der_cur_t cur[1];
+		const octet* ptr;
+		size_t fed;
+		// разобрать
+		derCurStart(cur, buf, 132);
+		if (derCurPeek(&tag, &len, cur) != 3 || tag != 0x30 || len != 129 ||
+			derCurEnter(cur, 0x30) != 3 ||
+			derCurLeave(cur) != SIZE_MAX ||
+			derCurNext(&tag, &ptr, &len, cur) != 129 ||
+			tag != 0x04 || ptr != buf + 5 || len != 127 ||
+			derCurNext(0, 0, 0, cur) != 0 ||
+			derCurLeave(cur) != 0 ||
+			derCurNext(0, 0, 0, cur) != 0 ||
+			derCurLeave(cur) != SIZE_MAX)
+			return FALSE;
+		// проверить тег
+		derCurStart(cur, buf, 132);
+		if (derCurEnter(cur, 0x31) != SIZE_MAX ||
+			derCurEnter(cur, 0x04) != SIZE_MAX ||
+			derCurEnter(cur, 0x30) != 3 ||
+			derCurNext2(&ptr, &len, cur, 0x05) != SIZE_MAX ||
+			derCurNext2(&ptr, &len, cur, 0x04) != 129 || len != 127 ||
+			derCurNext2(&ptr, &len, cur, 0x04) != SIZE_MAX)
+			return FALSE;
+		// обрезанный код
+		derCurStart(cur, buf, 131);
+		if (derCurEnter(cur, 0x30) != SIZE_MAX || cur->need != 0)
+			return FALSE;
+		derCurFeed(cur, buf, 3, 0, FALSE);
+		if (derCurEnter(cur, 0x30) != 3 ||
+			derCurNext(0, 0, 0, cur) != SIZE_MAX || cur->need != 1)
+			return FALSE;
+		derCurFeed(cur, buf, 131, 0, TRUE);
+		if (derCurNext(0, 0, 0, cur) != SIZE_MAX || cur->need != 0)
+			return FALSE;
+		// разобрать поток (по одному октету)
+		derCurStart(cur, buf, 0);
+		derCurFeed(cur, buf, 0, 0, FALSE);
+		fed = 0;
+		derCurStep(derCurEnter(cur, 0x30), cur, buf, fed, 132);
+		if (fed != 3)
+			return FALSE;
+		derCurStep(derCurNext(&tag, &ptr, &len, cur), cur, buf, fed, 132);
+		if (fed != 132 || tag != 0x04 || len != 127 ||
+			!memIsZero(ptr, 127))
+			return FALSE;
+		derCurStep(derCurLeave(cur), cur, buf, fed, 132);
+		if (derCurNext(0, 0, 0, cur) != 0)
+			return FALSE;
+		// глубина вложенности
+		for (count = 0; count <= DER_CUR_DEPTH; ++count)
+			buf[2 * count] = 0x30, buf[2 * count + 1] =
+				(octet)(2 * (DER_CUR_DEPTH - count));
+		derCurStart(cur, buf, 2 * count);
+		for (count = 0; count < DER_CUR_DEPTH; ++count)
+			if (derCurEnter(cur, 0x30) != 2)
+				return FALSE;
+		if (derCurEnter(cur, 0x30) != SIZE_MAX)
+			return FALSE;
+	}
 	// все нормально
 	return TRUE;
 }
@@ -4,7 +4,7 @@
 \brief Tests for hexadecimal strings
 \project bee2/test
 \created 2016.06.17
-\version 2016.06.17
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -54,6 +54,22 @@ bool_t hexTest()
 		if (!strEq(hex, hex1))
 			return FALSE;
 	}
+	// декодирование с проверкой (в том числе векторное)
+	for (count = 0; count < 256; ++count)
+	{
+		bool_t valid = ('0' <= count && count <= '9') ||
+			('A' <= count && count <= 'F') || ('a' <= count && count <= 'f');
+		hexFrom(hex, beltH(), 40);
+		hex[count % 80] = (char)count;
+		if (count && (hexIsValid(hex) != valid || hexTo(buf, hex) != valid ||
+			hexToRev(buf, hex) != valid))
+			return FALSE;
+	}
+	hexFrom(hex, beltH(), 40);
+	hexLower(hex);
+	if (!hexTo(buf, hex) || !memEq(buf, beltH(), 40) ||
+		hexTo(buf, "123") || hexToRev(buf, "123"))
+		return FALSE;
 	// все нормально
 	return TRUE;
 }
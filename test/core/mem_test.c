@@ -4,7 +4,7 @@
 \brief Tests for memory functions
 \project bee2/test
 \created 2014.02.01
-\version 2023.03.06
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -33,9 +33,12 @@ bool_t memTest()
 	octet buf[16];
 	octet buf1[16];
 	octet buf2[16];
+	octet lbuf[300];
+	octet lbuf1[300];
+	octet lbuf2[300];
 	void* p;
 	void* p1;
-	size_t i;
+	size_t i, j, k;
 	// pre
 	CASSERT(sizeof(buf) == sizeof(buf1));
 	memSetZero(buf, sizeof(buf));
@@ -168,6 +171,30 @@ bool_t memTest()
 	memXor2(buf2, buf, 8);
 	if (!memIsRep(buf2, 8, 0) || buf2[8] != 0x08)
 		return FALSE;
+	// xor / eq / zero: длинные буферы (векторные ядра)
+	for (i = 0; i < sizeof(lbuf); ++i)
+		lbuf[i] = (octet)i, lbuf1[i] = (octet)(7 * i + 1);
+	for (i = 0; i < 4; ++i)
+		for (j = 0; i + j <= 290; j += 17)
+		{
+			memXor(lbuf2, lbuf + i, lbuf1, j);
+			for (k = 0; k < j; ++k)
+				if (lbuf2[k] != (lbuf[i + k] ^ lbuf1[k]))
+					return FALSE;
+			memXor2(lbuf2, lbuf1, j);
+			if (!SAFE(memEq)(lbuf2, lbuf + i, j) ||
+				!FAST(memEq)(lbuf2, lbuf + i, j))
+				return FALSE;
+			if (j == 0)
+				continue;
+			lbuf2[j - 1] ^= 1;
+			if (SAFE(memEq)(lbuf2, lbuf + i, j))
+				return FALSE;
+			memXor2(lbuf2, lbuf + i, j);
+			if (SAFE(memIsZero)(lbuf2, j) || FAST(memIsZero)(lbuf2, j) ||
+				!SAFE(memIsZero)(lbuf2, j - 1))
+				return FALSE;
+		}
 	// все нормально
 	return TRUE;
 }
@@ -4,14 +4,75 @@
 \brief Tests for multithreading
 \project bee2/test
 \created 2021.05.15
-\version 2021.05.18
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include <bee2/core/err.h>
+#include <bee2/core/mem.h>
 #include <bee2/core/mt.h>
 
+/*
+*******************************************************************************
+Пул потоков
+
+Задача проверяет, что память задачи очищена, заполняет ее, увеличивает
+общий счетчик и, на первом уровне вложенности, ставит подзадачу.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	mt_pool_t* pool;
+	size_t sum;
+	size_t dirty;
+} mt_test_pool_st;
+
+#define MT_TEST_SCRATCH 64
+
+static void poolTask2(void* arg, void* scratch)
+{
+	mt_test_pool_st* st = (mt_test_pool_st*)arg;
+	size_t i;
+	for (i = 0; i < MT_TEST_SCRATCH; ++i)
+		if (((octet*)scratch)[i])
+			mtAtomicIncr(&st->dirty);
+	memSet(scratch, 0x5C, MT_TEST_SCRATCH);
+	mtAtomicFetchAdd(&st->sum, 2);
+}
+
+static void poolTask(void* arg, void* scratch)
+{
+	mt_test_pool_st* st = (mt_test_pool_st*)arg;
+	poolTask2(arg, scratch);
+	mtAtomicFetchAdd(&st->sum, SIZE_MAX);
+	mtPoolSubmit(st->pool, poolTask2, st);
+}
+
+static bool_t poolTest(size_t threads, size_t n, size_t flags)
+{
+	mt_test_pool_st st[1];
+	size_t i;
+	if (!(st->pool = mtPoolCreate(threads, MT_TEST_SCRATCH, flags)))
+		return FALSE;
+	st->sum = st->dirty = 0;
+	for (i = 0; i < n; ++i)
+		mtPoolSubmit(st->pool, poolTask, st);
+	mtPoolWait(st->pool);
+	if (st->sum != 3 * n || st->dirty)
+	{
+		mtPoolClose(st->pool);
+		return FALSE;
+	}
+	// повторное использование
+	for (i = 0; i < n; ++i)
+		mtPoolSubmit(st->pool, poolTask2, st);
+	mtPoolClose(st->pool);
+	return st->sum == 5 * n && st->dirty == 0;
+}
+
 /*
 *******************************************************************************
 Тестирование
@@ -25,10 +86,136 @@ void init()
 	_inited = TRUE;
 }
 
+static mt_key_t _key;
+static size_t _closed;
+
+static void MT_CALLBACK keyClose(void* val)
+{
+	mtAtomicIncr((size_t*)val);
+}
+
+static void keyThrd(void* arg)
+{
+	// закрепить значение, которое будет закрыто при завершении потока
+	if (mtKeyGet(&_key) == 0 && mtKeySet(&_key, &_closed))
+		*(bool_t*)arg = (mtKeyGet(&_key) == &_closed);
+}
+
+typedef struct
+{
+	mt_mtx_t mtx[1];
+	mt_cnd_t cnd[1];
+	size_t ready;
+	void* obj;
+} mt_test_cnd_st;
+
+static void cndThrd(void* arg)
+{
+	mt_test_cnd_st* st = (mt_test_cnd_st*)arg;
+	// опубликовать объект
+	mtAtomicStorePtr(&st->obj, st);
+	// оповестить
+	mtMtxLock(st->mtx);
+	st->ready = 1;
+	mtCndSignal(st->cnd);
+	mtMtxUnlock(st->mtx);
+}
+
+/*
+*******************************************************************************
+Асинхронные запросы
+
+Запросы с двумя разными признаками совместимости обрабатываются
+с обратным вызовом и через очередь завершений. Проверяется, что
+пакеты однородны, не превышают максимального размера и что каждый
+запрос завершается ровно один раз.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	mt_req_t req;				/*< заголовок */
+	size_t val;					/*< входные данные */
+	size_t res;					/*< результат */
+	size_t done;				/*< число завершений */
+} mt_test_req_st;
+
+static octet _async_keys[2];
+static size_t _async_max;
+static size_t _async_bad;
+static size_t _async_done;
+
+static void asyncBatch(mt_req_t* const reqs[], size_t count, void* scratch)
+{
+	size_t i;
+	if (count == 0 || count > _async_max)
+		mtAtomicIncr(&_async_bad);
+	for (i = 0; i < count; ++i)
+	{
+		mt_test_req_st* r = (mt_test_req_st*)reqs[i];
+		if (reqs[i]->key != reqs[0]->key)
+			mtAtomicIncr(&_async_bad);
+		r->res = r->val + (reqs[i]->key == _async_keys ? 1 : 2);
+		reqs[i]->code = r->val % 7 ? ERR_OK : ERR_BAD_INPUT;
+	}
+}
+
+static void asyncDone(mt_req_t* req)
+{
+	((mt_test_req_st*)req)->done++;
+	mtAtomicIncr(&_async_done);
+}
+
+static bool_t asyncTest(size_t threads, size_t n, size_t max, bool_t poll)
+{
+	mt_pool_t* pool = 0;
+	mt_async_t* as;
+	mt_test_req_st* reqs;
+	mt_req_t* req;
+	size_t polled = 0;
+	size_t i;
+	bool_t ok;
+	if (threads && !(pool = mtPoolCreate(threads, MT_TEST_SCRATCH, 0)))
+		return FALSE;
+	reqs = (mt_test_req_st*)memAlloc(n * sizeof(mt_test_req_st));
+	if (!reqs || !(as = mtAsyncCreate(pool, max)))
+	{
+		memFree(reqs);
+		mtPoolClose(pool);
+		return FALSE;
+	}
+	_async_max = max ? max : 1, _async_bad = _async_done = 0;
+	// поставить запросы
+	for (i = 0; i < n; ++i)
+	{
+		reqs[i].req.batch = asyncBatch;
+		reqs[i].req.key = _async_keys + (i % 3 ? 0 : 1);
+		reqs[i].req.done = poll ? 0 : asyncDone;
+		reqs[i].val = i, reqs[i].res = 0, reqs[i].done = 0;
+		mtAsyncSubmit(as, &reqs[i].req);
+		if (poll && (req = mtAsyncPoll(as)))
+			((mt_test_req_st*)req)->done++, ++polled;
+	}
+	// дождаться завершения
+	mtAsyncWait(as);
+	while ((req = mtAsyncPoll(as)))
+		((mt_test_req_st*)req)->done++, ++polled;
+	ok = _async_bad == 0 && (poll ? polled : _async_done) == n;
+	for (i = 0; ok && i < n; ++i)
+		ok = reqs[i].done == 1 &&
+			reqs[i].res == i + (i % 3 ? 1 : 2) &&
+			reqs[i].req.code == (i % 7 ? ERR_OK : ERR_BAD_INPUT);
+	mtAsyncClose(as);
+	memFree(reqs);
+	mtPoolClose(pool);
+	return ok;
+}
+
 bool_t mtTest()
 {
 	mt_mtx_t mtx[1];
 	size_t ctr[1] = { SIZE_0 };
+	void* ptr = 0;
 	// мьютексы
 	if (!mtMtxCreate(mtx))
 		return FALSE;
@@ -46,6 +233,93 @@ bool_t mtTest()
 		return FALSE;
 	if (!mtCallOnce(&_once, init) || !_inited)
 		return FALSE;
+	// атомарные операции: чтение, запись, прибавление
+	mtAtomicStore(ctr, 5);
+	if (mtAtomicLoad(ctr) != 5 ||
+		mtAtomicFetchAdd(ctr, 3) != 5 ||
+		mtAtomicLoad(ctr) != 8 ||
+		mtAtomicFetchAdd(ctr, SIZE_MAX) != 8 ||
+		mtAtomicLoad(ctr) != 7)
+		return FALSE;
+	// атомарные операции над указателями
+	mtAtomicStorePtr(&ptr, ctr);
+	if (mtAtomicLoadPtr(&ptr) != ctr ||
+		mtAtomicCmpSwapPtr(&ptr, 0, mtx) != ctr ||
+		mtAtomicCmpSwapPtr(&ptr, ctr, 0) != ctr ||
+		mtAtomicLoadPtr(&ptr) != 0)
+		return FALSE;
+	// ключи потоков
+	if (mtKeyCreate(&_key, keyClose))
+	{
+		mt_thrd_t thrd[1];
+		bool_t ok = FALSE;
+		if (mtKeyGet(&_key) != 0 ||
+			!mtKeySet(&_key, ctr) ||
+			mtKeyGet(&_key) != ctr ||
+			!mtThrdCreate(thrd, keyThrd, &ok))
+			return FALSE;
+		mtThrdJoin(thrd);
+		if (!ok || mtAtomicLoad(&_closed) != 1 || mtKeyGet(&_key) != ctr ||
+			!mtKeySet(&_key, 0))
+			return FALSE;
+		mtKeyClose(&_key);
+	}
+	// условные переменные
+	{
+		mt_test_cnd_st st[1];
+		mt_thrd_t thrd[1];
+		st->ready = 0, st->obj = 0;
+		if (!mtMtxCreate(st->mtx))
+			return FALSE;
+		if (!mtCndCreate(st->cnd))
+		{
+			mtMtxClose(st->mtx);
+			return FALSE;
+		}
+		if (!mtThrdCreate(thrd, cndThrd, st))
+		{
+			mtCndClose(st->cnd);
+			mtMtxClose(st->mtx);
+			return FALSE;
+		}
+		mtMtxLock(st->mtx);
+		while (!st->ready)
+			mtCndWait(st->cnd, st->mtx);
+		mtMtxUnlock(st->mtx);
+		mtThrdJoin(thrd);
+		mtCndClose(st->cnd);
+		mtMtxClose(st->mtx);
+		if (mtAtomicLoadPtr(&st->obj) != st)
+			return FALSE;
+	}
+	mtThrdYield();
+	// пул потоков
+	if (!poolTest(1, 100, MT_POOL_PIN) || !poolTest(4, 3000, MT_POOL_PIN) ||
+		!poolTest(0, 10, MT_POOL_PIN) || !poolTest(4, 3000, MT_POOL_NUMA))
+		return FALSE;
+	// асинхронные запросы
+	if (!asyncTest(0, 100, 8, FALSE) || !asyncTest(0, 100, 0, TRUE) ||
+		!asyncTest(1, 100, 16, TRUE) || !asyncTest(4, 3000, 32, FALSE) ||
+		!asyncTest(4, 3000, 7, TRUE))
+		return FALSE;
+	// узлы NUMA и реплики
+	if (mtNodes() == 0 || mtNodeCur() >= mtNodes())
+		return FALSE;
+	{
+		octet obj[32];
+		const octet* copy;
+		mt_rep_t* rep;
+		memSet(obj, 0x36, sizeof(obj));
+		if (!(rep = mtRepCreate(obj, sizeof(obj), 0)))
+			return FALSE;
+		copy = (const octet*)mtRepGet(rep);
+		if (!memEq(copy, obj, sizeof(obj)) || mtRepGet(rep) != copy)
+		{
+			mtRepClose(rep);
+			return FALSE;
+		}
+		mtRepClose(rep);
+	}
 	// все нормально
 	return TRUE;
 }
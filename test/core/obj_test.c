@@ -4,7 +4,7 @@
 \brief Tests for compound objects
 \project bee2/test
 \created 2013.04.16
-\version 2023.03.30
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -80,6 +80,23 @@ bool_t objTest()
 	// проверить
 	if (memCmp(objPtr(t, 1, void), obj2->a2, sizeof(obj2->a2)) != 0)
 		return FALSE;
+	// упаковать buf и распаковать по другому адресу
+	if (objKeep(buf) + sizeof(size_t) > sizeof(buf) ||
+		objPack(obj2) ||
+		!objPack(buf))
+		return FALSE;
+	t = buf + sizeof(size_t);
+	memMove(t, buf, objKeep(buf));
+	if (objUnpack(t, objKeep(t) - 1) ||
+		!objUnpack(t, objKeep(t)) ||
+		!objIsOperable(t))
+		return FALSE;
+	if (memCmp(objPtr(t, 1, void), obj2->a2, sizeof(obj2->a2)) != 0)
+		return FALSE;
+	t = objPtr(objPtr(t, 0, void), 0, void);
+	if (memCmp(objPtr(t, 0, void), obj1->a1, sizeof(obj1->a1)) != 0 ||
+		memCmp(objPtr(t, 1, void), obj1->a2, sizeof(obj1->a2)) != 0)
+		return FALSE;
 	// все нормально
 	return TRUE;
 }
@@ -4,16 +4,18 @@
 \brief Tests for object identifiers
 \project bee2/test
 \created 2013.04.01
-\version 2021.07.07
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include <bee2/core/der.h>
 #include <bee2/core/mem.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/oid.h>
 #include <bee2/core/str.h>
+#include <bee2/core/util.h>
 
 /*
 *******************************************************************************
@@ -23,12 +25,43 @@
 *******************************************************************************
 */
 
+static const char* const _oids[] =
+{
+	"1.2.112.0.2.0.1176.2.3.10.1",
+	"1.2.112.0.2.0.1176.2.3.10.2",
+	"1.2.112.0.2.0.1176.2.3.3.1",
+	"1.2.112.0.2.0.1176.2.3.3.2",
+	"1.2.112.0.2.0.1176.2.3.6.1",
+	"1.2.112.0.2.0.1176.2.3.6.2",
+	"1.2.112.0.2.0.34.101.31.73",
+	"1.2.112.0.2.0.34.101.31.81",
+	"1.2.112.0.2.0.34.101.45.12",
+	"1.2.112.0.2.0.34.101.45.2.1",
+	"1.2.112.0.2.0.34.101.45.3.0",
+	"1.2.112.0.2.0.34.101.45.3.1",
+	"1.2.112.0.2.0.34.101.45.3.2",
+	"1.2.112.0.2.0.34.101.45.3.3",
+	"1.2.112.0.2.0.34.101.45.4.1",
+	"1.2.112.0.2.0.34.101.47.12",
+	"1.2.112.0.2.0.34.101.60.11",
+	"1.2.112.0.2.0.34.101.60.2.1",
+	"1.2.112.0.2.0.34.101.60.2.2",
+	"1.2.112.0.2.0.34.101.60.2.3",
+	"1.2.112.0.2.0.34.101.77.11",
+	"1.2.112.0.2.0.34.101.77.12",
+	"1.2.112.0.2.0.34.101.77.13",
+	"1.2.112.0.2.0.34.101.79.6.1",
+	"1.2.112.0.2.0.34.101.79.6.2",
+	"1.2.112.0.2.0.34.101.79.8.1"
+};
+
 bool_t oidTest()
 {
 	octet buf[1024];
 	char str[2048];
 	char str1[2048];
 	size_t count;
+	size_t i;
 	// length octet 0x00
 	hexTo(buf, "060000");
 	if (oidFromDER(0, buf, 3) != SIZE_MAX)
@@ -105,6 +138,23 @@ bool_t oidTest()
 		oidFromDER(str, buf, count) != strLen(str1) ||
 		!strEq(str, str1))
 		return FALSE;
+	// реестр
+	for (i = 0; i < COUNT_OF(_oids); ++i)
+	{
+		const octet* der = oidRegDER(&count, _oids[i]);
+		const char* oid;
+		if (!der || count != derOIDEnc(buf, _oids[i]) ||
+			!memEq(der, buf, count) ||
+			!(oid = oidRegFind(buf, count)) || !strEq(oid, _oids[i]) ||
+			oidFromDER(str, buf, count) != strLen(_oids[i]) ||
+			!strEq(str, _oids[i]))
+			return FALSE;
+	}
+	if (oidRegDER(0, "1.2.112.0.2.0.34.101.31") ||
+		oidRegFind(buf, count - 1) ||
+		oidToDER(buf, "1.2.112.0.2.0.34.101.31.81") != 11 ||
+		!hexEq(buf, "06092A7000020022651F51"))
+		return FALSE;
 	// все нормально
 	return TRUE;
 }
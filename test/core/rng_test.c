@@ -4,19 +4,86 @@
 \brief Tests for random number generators
 \project bee2/test
 \created 2014.10.10
-\version 2023.12.16
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
 #include <stdio.h>
+#include <bee2/core/err.h>
 #include <bee2/core/mem.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/prng.h>
 #include <bee2/core/rng.h>
 #include <bee2/core/util.h>
 
+/*
+*******************************************************************************
+Дочерний процесс
+
+Родительский и дочерний процессы после fork() вырабатывают по 64 октета
+функциями rngStepR2() и rngStepR3(). Дочерний процесс передает свои октеты
+родителю через канал. Октеты процессов должны различаться.
+*******************************************************************************
+*/
+
+#ifdef OS_UNIX
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+static bool_t rngForkTest()
+{
+	octet buf[64];
+	octet buf2[64];
+	int fd[2];
+	pid_t pid;
+	int status;
+	size_t count;
+	if (rngCreate(0, 0) != ERR_OK)
+		return FALSE;
+	rngStepR3(buf, 32, 0);
+	if (pipe(fd) != 0)
+	{
+		rngClose();
+		return FALSE;
+	}
+	pid = fork();
+	if (pid == 0)
+	{
+		close(fd[0]);
+		rngStepR2(buf, 32, 0);
+		rngStepR3(buf + 32, 32, 0);
+		_exit(write(fd[1], buf, 64) == 64 ? 0 : 1);
+	}
+	close(fd[1]);
+	rngStepR2(buf, 32, 0);
+	rngStepR3(buf + 32, 32, 0);
+	count = 0;
+	if (pid > 0)
+	{
+		ssize_t r;
+		while (count < 64 &&
+			(r = read(fd[0], buf2 + count, 64 - count)) > 0)
+			count += (size_t)r;
+		waitpid(pid, &status, 0);
+	}
+	close(fd[0]);
+	rngClose();
+	return pid > 0 && count == 64 &&
+		!memEq(buf, buf2, 32) && !memEq(buf + 32, buf2 + 32, 32);
+}
+
+#else
+
+static bool_t rngForkTest()
+{
+	return TRUE;
+}
+
+#endif
+
 /*
 *******************************************************************************
 Тестирование
@@ -66,6 +133,9 @@ bool_t rngTest()
 		rngTestFIPS2(buf) ? '+' : '-',
 		rngTestFIPS3(buf) ? '+' : '-',
 		rngTestFIPS4(buf) ? '+' : '-');
+	rngSetParanoid(TRUE);
+	rngStepR(buf, 32, 0);
+	rngSetParanoid(FALSE);
 	rngRekey();
 	rngStepR2(buf, 2500, 0);
 	hexFrom(hex, buf, 16);
@@ -75,6 +145,25 @@ bool_t rngTest()
 		rngTestFIPS2(buf) ? '+' : '-',
 		rngTestFIPS3(buf) ? '+' : '-',
 		rngTestFIPS4(buf) ? '+' : '-');
+	rngStepR3(buf, 2500, 0);
+	hexFrom(hex, buf, 16);
+	printf("rngStepR3:        %s... [FIPS: 1%c 2%c 3%c 4%c]\n",
+		hex,
+		rngTestFIPS1(buf) ? '+' : '-',
+		rngTestFIPS2(buf) ? '+' : '-',
+		rngTestFIPS3(buf) ? '+' : '-',
+		rngTestFIPS4(buf) ? '+' : '-');
+	// генератор потока после смены ключа
+	memCopy(buf + 2500 - 32, buf, 32);
+	rngRekey();
+	rngStepR3(buf, 32, 0);
+	if (memEq(buf, buf + 2500 - 32, 32))
+		return FALSE;
+	// системные источники: хранимые и временные дескрипторы
+	for (pos = 2; pos < 4; ++pos)
+		if (rngESRead(&read, buf, 32, sources[pos]) == ERR_OK &&
+			read != 32)
+			return FALSE;
 	if (rngCreate(0, 0) != ERR_OK)
 		return FALSE;
 	rngClose();
@@ -83,6 +172,42 @@ bool_t rngTest()
 	rngClose();
 	if (rngIsValid())
 		return FALSE;
+	for (pos = 2; pos < 4; ++pos)
+		if (rngESRead(&read, buf, 32, sources[pos]) == ERR_OK &&
+			read != 32)
+			return FALSE;
+	// механизм bash-prg
+	if (rngCreate2(0, 0, "bash") != ERR_OK)
+		return FALSE;
+	if (rngCreate2(0, 0, "belt") != ERR_BAD_PARAMS ||
+		rngCreate2(0, 0, "bake") != ERR_BAD_PARAMS)
+		return FALSE;
+	if (rngCreate(0, 0) != ERR_OK)
+		return FALSE;
+	rngClose();
+	rngStepR(buf, 2500, 0);
+	if (!rngTestFIPS1(buf) || !rngTestFIPS2(buf) ||
+		!rngTestFIPS3(buf) || !rngTestFIPS4(buf))
+		return FALSE;
+	rngStepR2(buf, 2500, 0);
+	if (!rngTestFIPS1(buf) || !rngTestFIPS2(buf) ||
+		!rngTestFIPS3(buf) || !rngTestFIPS4(buf))
+		return FALSE;
+	rngStepR3(buf, 2500, 0);
+	if (!rngTestFIPS1(buf) || !rngTestFIPS2(buf) ||
+		!rngTestFIPS3(buf) || !rngTestFIPS4(buf))
+		return FALSE;
+	memCopy(buf + 2500 - 32, buf, 32);
+	rngRekey();
+	rngStepR3(buf, 32, 0);
+	if (memEq(buf, buf + 2500 - 32, 32))
+		return FALSE;
+	rngClose();
+	if (rngIsValid())
+		return FALSE;
+	// дочерний процесс
+	if (!rngForkTest())
+		return FALSE;
 	// все нормально
 	return TRUE;
 }
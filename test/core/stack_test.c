@@ -0,0 +1,102 @@
+/*
+*******************************************************************************
+\file stack_test.c
+\brief Tests for the thread stack
+\project bee2/test
+\created 2026.10.14
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
+#include <bee2/core/stack.h>
+
+/*
+*******************************************************************************
+Тестирование
+*******************************************************************************
+*/
+
+static bool_t stackTestThrd()
+{
+	octet* s1;
+	octet* s2;
+	octet* s3;
+	bool_t ok;
+	// вложенные стеки
+	s1 = (octet*)stackCreate(100);
+	s2 = (octet*)stackCreate(200);
+	if (!s1 || !s2 || !memIsZero(s1, 100) || !memIsZero(s2, 200) ||
+		!memIsDisjoint2(s1, 100, s2, 200) ||
+		!memIsAligned(s1, STACK_ALIGN) || !memIsAligned(s2, STACK_ALIGN))
+	{
+		stackClose(s2), stackClose(s1);
+		return FALSE;
+	}
+	memSet(s1, 0x36, 100), memSet(s2, 0x5C, 200);
+	// повторное использование
+	stackClose(s2);
+	s3 = (octet*)stackCreate(150);
+	ok = s3 == s2 && memIsZero(s3, 150);
+	stackClose(s3);
+	// стек в куче
+	s2 = (octet*)stackCreate(STACK_MAX_DEFAULT + 1);
+	ok = ok && s2 && memIsZero(s2, STACK_MAX_DEFAULT + 1) &&
+		memIsAligned(s2, STACK_ALIGN);
+	stackClose(s2);
+	ok = ok && memIsValid(s1, 100) && s1[99] == 0x36;
+	stackClose(s1);
+	return ok;
+}
+
+static void stackTestThrdMain(void* arg)
+{
+	*(bool_t*)arg = stackTestThrd();
+}
+
+bool_t stackTest()
+{
+	mt_thrd_t thrd[1];
+	bool_t ok;
+	void* s;
+	// в текущем потоке
+	if (!stackTestThrd())
+		return FALSE;
+	// в другом потоке
+	ok = FALSE;
+	if (!mtThrdCreate(thrd, stackTestThrdMain, &ok))
+		return FALSE;
+	mtThrdJoin(thrd);
+	if (!ok)
+		return FALSE;
+	// без буфера потока
+	stackSetMax(0);
+	s = stackCreate(100);
+	ok = s && memIsZero(s, 100);
+	stackClose(s);
+	stackSetMax(STACK_MAX_DEFAULT);
+	if (!ok)
+		return FALSE;
+	// профилирование
+	if (stackProfIsEnabled())
+	{
+		stack_prof_t p[1];
+		stackProfReset();
+		s = stackCreate(100);
+		ok = s && memIsZero(s, 100);
+		if (s)
+			memSet(s, 0x5C, 40);
+		stackClose(s);
+		stackProfGet(p);
+		if (!ok || p->count != 1 || p->used != 40 || p->max_used != 40 ||
+			p->declared < 100 || p->max_decl != p->declared)
+			return FALSE;
+		s = stackCreate(100);
+		ok = s && memIsZero(s, 100);
+		stackClose(s);
+	}
+	return ok;
+}
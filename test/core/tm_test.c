@@ -4,15 +4,18 @@
 \brief Tests for time management
 \project bee2/test
 \created 2014.10.13
-\version 2022.07.12
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
 #include <stdio.h>
+#include <string.h>
+#include <bee2/core/blob.h>
 #include <bee2/core/mt.h>
 #include <bee2/core/tm.h>
+#include <bee2/crypto/belt.h>
 
 /*
 *******************************************************************************
@@ -49,6 +52,48 @@ bool_t tmTest()
 		printf("tm::date: %04u-%02u-%02u\n",
 			(unsigned)y, (unsigned)m, (unsigned)d);
 	}
+	// трассировка
+	{
+		octet hash[32];
+		char ph[9];
+		char* json;
+		const char* pos;
+		size_t len, i;
+		if (!tmTraceStart())
+			return FALSE;
+		tmTraceBegin("tmTest");
+		if (beltHash(hash, hash, 0) != ERR_OK ||
+			tmTraceCall("tmTest2", beltHash(hash, hash, 32)) != ERR_OK)
+			return FALSE;
+		tmTraceEnd("tmTest");
+		tmTraceStop();
+		tmTraceBegin("tmTest3");
+		len = tmTraceExport(0, 0);
+		if (len == 0 || !(json = (char*)blobCreate(len + 1)))
+			return FALSE;
+		if (tmTraceExport(json, len) != len || json[0] != '\0' ||
+			tmTraceExport(json, len + 1) != len || strlen(json) != len ||
+			strncmp(json, "{\"traceEvents\":[", 16) != 0 ||
+			!strstr(json, "{\"name\":\"tmTest\",\"ph\":\"B\"") ||
+			!strstr(json, "{\"name\":\"tmTest2\",\"ph\":\"E\"") ||
+			!strstr(json, "{\"name\":\"beltHash\",\"ph\":\"E\"") ||
+			strstr(json, "tmTest3"))
+		{
+			blobClose(json);
+			return FALSE;
+		}
+		// события: tmTest{beltHash{} tmTest2{beltHash{}}}
+		for (pos = json, i = 0; i < 8; ++i)
+			ph[i] = (pos && (pos = strstr(pos, "\"ph\":\""))) ?
+				(pos += 6)[0] : '?';
+		ph[8] = '\0';
+		if (strcmp(ph, "BBEBBEEE") != 0 || !pos || strstr(pos, "\"ph\":\""))
+		{
+			blobClose(json);
+			return FALSE;
+		}
+		blobClose(json);
+	}
 	// все нормально
 	return TRUE;
 }
@@ -4,7 +4,7 @@
 \brief Tests for utilities
 \project bee2/test
 \created 2017.01.17
-\version 2021.05.18
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -22,13 +22,18 @@
 const char* utilInfo()
 {
 	static char descr[128];
-	sprintf(descr, "%s,B_PER_W=%d,B_PER_S=%d,%s",
+	sprintf(descr, "%s,B_PER_W=%d,B_PER_S=%d,%s%s",
 		(OCTET_ORDER == LITTLE_ENDIAN) ? "LITTLE_ENDIAN" : "BIG_ENDIAN",
 		B_PER_W, B_PER_S,
 #ifdef SAFE_FAST
-		"FAST"
+		"FAST",
 #else
-		"SAFE"
+		"SAFE",
+#endif
+#ifdef BEE2_LOW_MEMORY
+		",LOW_MEMORY"
+#else
+		""
 #endif
 		);
 	return descr;
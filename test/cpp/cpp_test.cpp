@@ -0,0 +1,197 @@
+/*
+*******************************************************************************
+\file cpp_test.cpp
+\brief Tests for C++ wrappers
+\project bee2/test
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include <array>
+#include <utility>
+#include <vector>
+#include <bee2/core/mem.h>
+#include <bee2/core/prng.h>
+#include <bee2/cpp/bake.hpp>
+#include <bee2/cpp/bash.hpp>
+#include <bee2/cpp/belt.hpp>
+#include <bee2/cpp/bign.hpp>
+
+/*
+*******************************************************************************
+Тестирование
+
+Результаты оберток сравниваются с результатами функций C.
+*******************************************************************************
+*/
+
+static err_t cppTestCertVal(octet* pubkey, const bign_params* params,
+	const octet* data, size_t len)
+{
+	if (len != params->l / 2)
+		return ERR_BAD_CERT;
+	if (pubkey)
+		memCopy(pubkey, data, len);
+	return ERR_OK;
+}
+
+static bool_t cppTestBelt()
+{
+	bee2::cbytes h(beltH(), 256);
+	std::array<octet, 32> hash;
+	octet buf[48];
+	octet buf1[48];
+	octet mac[8];
+	octet mac1[8];
+	// belt-hash + перемещение
+	bee2::belt_hash hs;
+	hs.update(h.first(13)).update(h.subspan(13, 35));
+	bee2::belt_hash hs1(std::move(hs));
+	if (hs.state() != 0)
+		return FALSE;
+	hs1.final(hash);
+	if (beltHash(buf, beltH(), 48) != ERR_OK ||
+		!memEq(hash.data(), buf, 32) ||
+		!hs1.verify(bee2::cbytes(buf, 16)))
+		return FALSE;
+	// belt-mac
+	bee2::belt_mac ms(h.subspan(128, 32));
+	ms.update(h.first(48)).final(bee2::bytes(mac, 8));
+	if (beltMAC(mac1, beltH(), 48, beltH() + 128, 32) != ERR_OK ||
+		!memEq(mac, mac1, 8))
+		return FALSE;
+	// belt-hmac
+	bee2::belt_hmac hm(h.subspan(128, 32));
+	hm.update(h.first(48)).final(hash);
+	if (beltHMAC(buf, beltH(), 48, beltH() + 128, 32) != ERR_OK ||
+		!memEq(hash.data(), buf, 32))
+		return FALSE;
+	// belt-che
+	bee2::belt_che che(h.subspan(128, 32), h.subspan(192, 16));
+	che.auth(h.subspan(64, 32)).encrypt(buf, h.first(11));
+	che.encrypt(bee2::bytes(buf + 11, 37), h.subspan(11, 37)).final(mac);
+	if (beltCHEWrap(buf1, mac1, beltH(), 48, beltH() + 64, 32,
+			beltH() + 128, 32, beltH() + 192) != ERR_OK ||
+		!memEq(buf, buf1, 48) || !memEq(mac, mac1, 8))
+		return FALSE;
+	bee2::belt_che che1(h.subspan(128, 32), h.subspan(192, 16));
+	che1.auth(h.subspan(64, 32)).decrypt(buf);
+	if (!che1.verify(mac) || !memEq(buf, beltH(), 48))
+		return FALSE;
+	// belt-dwp
+	bee2::belt_dwp dwp(h.subspan(128, 32), h.subspan(192, 16));
+	memCopy(buf, beltH(), 48);
+	dwp.auth(h.subspan(64, 32)).encrypt(buf);
+	dwp.final(mac);
+	if (beltDWPWrap(buf1, mac1, beltH(), 48, beltH() + 64, 32,
+			beltH() + 128, 32, beltH() + 192) != ERR_OK ||
+		!memEq(buf, buf1, 48) || !memEq(mac, mac1, 8))
+		return FALSE;
+	bee2::belt_dwp dwp1(h.subspan(128, 32), h.subspan(192, 16));
+	dwp1.auth(h.subspan(64, 32)).decrypt(buf1, bee2::cbytes(buf));
+	return dwp1.verify(mac) && memEq(buf1, beltH(), 48);
+}
+
+static bool_t cppTestBash()
+{
+	std::vector<octet> data(beltH(), beltH() + 100);
+	octet hash[64];
+	octet hash1[64];
+	bee2::bash_hash hs(256);
+	hs.update(data).final(hash);
+	return bashHash(hash1, 256, beltH(), 100) == ERR_OK &&
+		memEq(hash, hash1, 64) && hs.verify(bee2::cbytes(hash1, 20));
+}
+
+static bool_t cppTestBign()
+{
+	bign_params params[1];
+	octet oid_der[16];
+	size_t oid_len = sizeof(oid_der);
+	octet privkey[32];
+	octet pubkey[64];
+	octet privkeyb[32];
+	octet pubkeyb[64];
+	octet sig[48];
+	octet sig1[48];
+	octet key[32];
+	octet key1[32];
+	octet combo_state[32];
+	bake_cert certa[1];
+	bake_cert certb[1];
+	bake_settings settings[1];
+	octet msg[128];
+	// подготовить данные
+	if (sizeof(combo_state) < prngCOMBO_keep() ||
+		bignParamsStd(params, "1.2.112.0.2.0.34.101.45.3.1") != ERR_OK ||
+		bignOidToDER(oid_der, &oid_len, "1.2.112.0.2.0.34.101.31.81") !=
+			ERR_OK)
+		return FALSE;
+	prngCOMBOStart(combo_state, utilNonce32());
+	if (bignKeypairGen(privkey, pubkey, params, prngCOMBOStepR,
+			combo_state) != ERR_OK ||
+		bignKeypairGen(privkeyb, pubkeyb, params, prngCOMBOStepR,
+			combo_state) != ERR_OK)
+		return FALSE;
+	// bign
+	bee2::bign_ctx ctx(*params);
+	bee2::cbytes oid(oid_der, oid_len);
+	bee2::cbytes hash(beltH(), 32);
+	if (ctx.sign2(sig, oid, hash, privkey) != ERR_OK ||
+		bignSign2(sig1, params, oid_der, oid_len, beltH(), privkey, 0, 0) !=
+			ERR_OK ||
+		!memEq(sig, sig1, 48) ||
+		ctx.verify(oid, hash, sig, pubkey) != ERR_OK ||
+		ctx.dh(key, privkey, pubkeyb) != ERR_OK ||
+		bignDH(key1, params, privkeyb, pubkey, 32) != ERR_OK ||
+		!memEq(key, key1, 32))
+		return FALSE;
+	sig[0] ^= 1;
+	if (ctx.verify(oid, hash, sig, pubkey) == ERR_OK)
+		return FALSE;
+	// bign: ошибка параметров
+	try
+	{
+		bign_params bad[1];
+		memCopy(bad, params, sizeof(bign_params));
+		bad->p[0] ^= 1;
+		bee2::bign_ctx ctx1(*bad);
+		return FALSE;
+	}
+	catch (const bee2::error& e)
+	{
+		if (e.code() != ERR_BAD_PARAMS)
+			return FALSE;
+	}
+	// bake-bmqv
+	certa->data = pubkey, certa->len = 64, certa->val = cppTestCertVal;
+	certb->data = pubkeyb, certb->len = 64, certb->val = cppTestCertVal;
+	memSetZero(settings, sizeof(bake_settings));
+	settings->kca = settings->kcb = TRUE;
+	settings->rng = prngCOMBOStepR, settings->rng_state = combo_state;
+	bee2::bake_ctx ctxa(*params, bee2::cbytes(privkey), *certa);
+	bee2::bake_ctx ctxb(*params, bee2::cbytes(privkeyb), *certb);
+	bee2::bake_bmqv a(ctxa, *settings);
+	bee2::bake_bmqv b(ctxb, *settings);
+	return b.step2(msg) == ERR_OK &&
+		a.step3(msg, msg, *certb) == ERR_OK &&
+		b.step4(msg, msg, *certa) == ERR_OK &&
+		a.step5(msg) == ERR_OK &&
+		a.key(key) == ERR_OK && b.key(key1) == ERR_OK &&
+		memEq(key, key1, 32);
+}
+
+extern "C" bool_t cppTest()
+{
+	try
+	{
+		return cppTestBelt() && cppTestBash() && cppTestBign();
+	}
+	catch (...)
+	{
+		return FALSE;
+	}
+}
@@ -4,7 +4,7 @@
 \brief Tests for STB 34.101.66 (bake)
 \project bee2/test
 \created 2014.04.23
-\version 2023.09.22
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -184,6 +184,43 @@ static err_t bakeTestCertVal(octet* pubkey, const bign_params* params,
 	return ERR_OK;
 }
 
+static size_t _certval_count;
+
+static err_t bakeTestCertVal2(octet* pubkey, const bign_params* params,
+	const octet* data, size_t len)
+{
+	++_certval_count;
+	return bakeTestCertVal(pubkey, params, data, len);
+}
+
+/*
+*******************************************************************************
+Выполнение протокола через драйверы
+
+Сторона B начинает протокол. Сообщение, сформированное одной стороной,
+передается другой стороне.
+*******************************************************************************
+*/
+
+static bool_t bakeTestDrv(void* drva, void* drvb)
+{
+	octet buf[2][1024];
+	void* drv[2];
+	size_t len = 0;
+	size_t i = 0;
+	drv[0] = drvb, drv[1] = drva;
+	while (!bakeDrvIsOver(drv[i]))
+	{
+		if (bakeDrvOutLen(drv[i]) > sizeof(buf[i]) ||
+			bakeDrvStep(buf[i], &len, buf[1 - i], len, drv[i]) != ERR_OK)
+			return FALSE;
+		i = 1 - i;
+		if (len == 0)
+			break;
+	}
+	return bakeDrvIsOver(drva) && bakeDrvIsOver(drvb);
+}
+
 /*
 *******************************************************************************
 Самотестирование
@@ -217,6 +254,15 @@ bool_t bakeTest()
 	octet keyb[32];
 	octet secret[32];
 	octet iv[64];
+	octet ctxa[2048];
+	octet ctxb[2048];
+	octet statea[10000];
+	octet stateb[10000];
+	octet buf[1024];
+	size_t len;
+	octet drva[256];
+	octet drvb[256];
+	octet eph[1024];
 	// подготовить память
 	if (sizeof(echoa) < prngEcho_keep())
 		return FALSE;
@@ -292,6 +338,50 @@ bool_t bakeTest()
 			"78EF2C56BD6DA2116BB5BEE80CEE5C05"
 			"394E7609183CF7F76DF0C2DCFB25C4AD"))
 		return FALSE;
+	// тест Б.2 с контекстами
+	if (sizeof(ctxa) < bakeCtx_keep(128) ||
+		bakeCtxStart(ctxa, params, da, certa) != ERR_OK ||
+		bakeCtxStart(ctxb, params, db, certb) != ERR_OK ||
+		sizeof(statea) < bakeBMQV2_keep(ctxa) ||
+		sizeof(statea) < bakeBSTS2_keep(ctxa))
+		return FALSE;
+	hexTo(randa, _bmqv_randa);
+	hexTo(randb, _bmqv_randb);
+	prngEchoStart(echoa, randa, strLen(_bmqv_randb) / 2);
+	prngEchoStart(echob, randb, strLen(_bmqv_randb) / 2);
+	if (bakeBMQVStart2(statea, ctxa, settingsa) != ERR_OK ||
+		bakeBMQVStart2(stateb, ctxb, settingsb) != ERR_OK ||
+		bakeBMQVStep2(buf, stateb) != ERR_OK ||
+		bakeBMQVStep3(buf, buf, certb, statea) != ERR_OK ||
+		bakeBMQVStep4(buf, buf, certa, stateb) != ERR_OK ||
+		bakeBMQVStep5(buf, statea) != ERR_OK ||
+		bakeBMQVStepG(keya, statea) != ERR_OK ||
+		bakeBMQVStepG(keyb, stateb) != ERR_OK ||
+		!memEq(keya, keyb, 32) ||
+		!hexEq(keya,
+			"C6F86D0E468D5EF1A9955B2EE0CF0581"
+			"050C81D1B47727092408E863C7EEB48C"))
+		return FALSE;
+	// тест Б.3 с контекстами
+	hexTo(randa, _bsts_randa);
+	hexTo(randb, _bsts_randb);
+	prngEchoStart(echoa, randa, strLen(_bsts_randb) / 2);
+	prngEchoStart(echob, randb, strLen(_bsts_randb) / 2);
+	len = 64 + 32 + certa->len + 8;
+	if (bakeBSTSStart2(statea, ctxa, settingsa) != ERR_OK ||
+		bakeBSTSStart2(stateb, ctxb, settingsb) != ERR_OK ||
+		bakeBSTSStep2(buf, stateb) != ERR_OK ||
+		bakeBSTSStep3(buf, buf, statea) != ERR_OK ||
+		bakeBSTSStep4(buf, buf, len, bakeTestCertVal, stateb) != ERR_OK ||
+		bakeBSTSStep5(buf, 32 + certb->len + 8, bakeTestCertVal,
+			statea) != ERR_OK ||
+		bakeBSTSStepG(keya, statea) != ERR_OK ||
+		bakeBSTSStepG(keyb, stateb) != ERR_OK ||
+		!memEq(keya, keyb, 32) ||
+		!hexEq(keya,
+			"78EF2C56BD6DA2116BB5BEE80CEE5C05"
+			"394E7609183CF7F76DF0C2DCFB25C4AD"))
+		return FALSE;
 	// тест Б.4
 	hexTo(randa, _bpace_randa);
 	hexTo(randb, _bpace_randb);
@@ -317,6 +407,172 @@ bool_t bakeTest()
 			"DAC4D8F411F9C523D28BBAAB32A5270E"
 			"4DFA1F0F757EF8E0F30AF08FBDE1E7F4"))
 		return FALSE;
+	// тест Б.4 с контекстом
+	if (sizeof(ctxa) < bakeBPACECtx_keep(128) ||
+		bakeBPACECtxStart(ctxa, params, (const octet*)pwd,
+			strLen(pwd)) != ERR_OK ||
+		sizeof(statea) < bakeBPACE2_keep(ctxa))
+		return FALSE;
+	prngEchoStart(echoa, randa, strLen(_bpace_randb) / 2);
+	prngEchoStart(echob, randb, strLen(_bpace_randb) / 2);
+	if (bakeBPACEStart2(statea, ctxa, settingsa) != ERR_OK ||
+		bakeBPACEStart2(stateb, ctxa, settingsb) != ERR_OK ||
+		bakeBPACEStep2(buf, stateb) != ERR_OK ||
+		bakeBPACEStep3(buf + 512, buf, statea) != ERR_OK ||
+		bakeBPACEStep4(buf, buf + 512, stateb) != ERR_OK ||
+		bakeBPACEStep5(buf + 512, buf, statea) != ERR_OK ||
+		bakeBPACEStep6(buf + 512, stateb) != ERR_OK ||
+		bakeBPACEStepG(keya, statea) != ERR_OK ||
+		bakeBPACEStepG(keyb, stateb) != ERR_OK ||
+		!memEq(keya, keyb, 32) ||
+		!hexEq(keya,
+			"DAC4D8F411F9C523D28BBAAB32A5270E"
+			"4DFA1F0F757EF8E0F30AF08FBDE1E7F4"))
+		return FALSE;
+	// тесты Б.2 -- Б.4 через драйверы
+	if (sizeof(drva) < bakeDrv_keep() ||
+		sizeof(statea) < bakeBMQV_keep(128) ||
+		sizeof(statea) < bakeBSTS_keep(128) ||
+		sizeof(statea) < bakeBPACE_keep(128))
+		return FALSE;
+	hexTo(randa, _bmqv_randa);
+	hexTo(randb, _bmqv_randb);
+	prngEchoStart(echoa, randa, strLen(_bmqv_randb) / 2);
+	prngEchoStart(echob, randb, strLen(_bmqv_randb) / 2);
+	if (bakeBMQVStart(statea, params, settingsa, da, certa) != ERR_OK ||
+		bakeBMQVStart(stateb, params, settingsb, db, certb) != ERR_OK ||
+		bakeDrvStart(drva, BAKE_DRV_BMQV_A, statea, certb, 0) != ERR_OK ||
+		bakeDrvStart(drvb, BAKE_DRV_BMQV_B, stateb, certa, 0) != ERR_OK ||
+		bakeDrvInLen(drvb) != 0 || bakeDrvOutLen(drvb) != 64 ||
+		!bakeTestDrv(drva, drvb) ||
+		bakeDrvStep(buf, &len, buf, 0, drva) != ERR_BAD_LOGIC ||
+		bakeDrvStepG(keya, drva) != ERR_OK ||
+		bakeDrvStepG(keyb, drvb) != ERR_OK ||
+		!memEq(keya, keyb, 32) ||
+		!hexEq(keya,
+			"C6F86D0E468D5EF1A9955B2EE0CF0581"
+			"050C81D1B47727092408E863C7EEB48C"))
+		return FALSE;
+	hexTo(randa, _bsts_randa);
+	hexTo(randb, _bsts_randb);
+	prngEchoStart(echoa, randa, strLen(_bsts_randb) / 2);
+	prngEchoStart(echob, randb, strLen(_bsts_randb) / 2);
+	if (bakeBSTSStart(statea, params, settingsa, da, certa) != ERR_OK ||
+		bakeBSTSStart(stateb, params, settingsb, db, certb) != ERR_OK ||
+		bakeDrvStart(drva, BAKE_DRV_BSTS_A, statea, 0,
+			bakeTestCertVal) != ERR_OK ||
+		bakeDrvStart(drvb, BAKE_DRV_BSTS_B, stateb, 0,
+			bakeTestCertVal) != ERR_OK ||
+		!bakeTestDrv(drva, drvb) ||
+		bakeDrvStepG(keya, drva) != ERR_OK ||
+		bakeDrvStepG(keyb, drvb) != ERR_OK ||
+		!memEq(keya, keyb, 32) ||
+		!hexEq(keya,
+			"78EF2C56BD6DA2116BB5BEE80CEE5C05"
+			"394E7609183CF7F76DF0C2DCFB25C4AD"))
+		return FALSE;
+	hexTo(randa, _bpace_randa);
+	hexTo(randb, _bpace_randb);
+	prngEchoStart(echoa, randa, strLen(_bpace_randb) / 2);
+	prngEchoStart(echob, randb, strLen(_bpace_randb) / 2);
+	if (bakeBPACEStart(statea, params, settingsa, (const octet*)pwd,
+			strLen(pwd)) != ERR_OK ||
+		bakeBPACEStart(stateb, params, settingsb, (const octet*)pwd,
+			strLen(pwd)) != ERR_OK ||
+		bakeDrvStart(drva, BAKE_DRV_BPACE_A, statea, 0, 0) != ERR_OK ||
+		bakeDrvStart(drvb, BAKE_DRV_BPACE_B, stateb, 0, 0) != ERR_OK ||
+		bakeDrvStepG(keya, drva) != ERR_BAD_LOGIC ||
+		!bakeTestDrv(drva, drvb) ||
+		bakeDrvStepG(keya, drva) != ERR_OK ||
+		bakeDrvStepG(keyb, drvb) != ERR_OK ||
+		!memEq(keya, keyb, 32) ||
+		!hexEq(keya,
+			"DAC4D8F411F9C523D28BBAAB32A5270E"
+			"4DFA1F0F757EF8E0F30AF08FBDE1E7F4"))
+		return FALSE;
+	// тесты Б.2, Б.3 с пулом одноразовых ключей
+	if (bignCtxStart(ctxb, params) != ERR_OK ||
+		sizeof(eph) < bignEph_keep(128, 1) ||
+		bignEphStart(eph, ctxb, 1, prngEchoStepR, echob) != ERR_OK)
+		return FALSE;
+	hexTo(randa, _bmqv_randa);
+	hexTo(randb, _bmqv_randb);
+	prngEchoStart(echoa, randa, strLen(_bmqv_randb) / 2);
+	prngEchoStart(echob, randb, strLen(_bmqv_randb) / 2);
+	if (bignEphFill(eph, 1) != 1 ||
+		bakeBMQVStart(statea, params, settingsa, da, certa) != ERR_OK ||
+		bakeBMQVStart(stateb, params, settingsb, db, certb) != ERR_OK ||
+		bakeBMQVStep2Eph(buf, eph, stateb) != ERR_OK ||
+		bakeBMQVStep3(buf, buf, certb, statea) != ERR_OK ||
+		bakeBMQVStep4(buf, buf, certa, stateb) != ERR_OK ||
+		bakeBMQVStep5(buf, statea) != ERR_OK ||
+		bakeBMQVStepG(keya, statea) != ERR_OK ||
+		bakeBMQVStepG(keyb, stateb) != ERR_OK ||
+		!memEq(keya, keyb, 32) ||
+		!hexEq(keya,
+			"C6F86D0E468D5EF1A9955B2EE0CF0581"
+			"050C81D1B47727092408E863C7EEB48C"))
+		return FALSE;
+	hexTo(randa, _bsts_randa);
+	hexTo(randb, _bsts_randb);
+	prngEchoStart(echoa, randa, strLen(_bsts_randb) / 2);
+	prngEchoStart(echob, randb, strLen(_bsts_randb) / 2);
+	len = 64 + 32 + certa->len + 8;
+	if (bignEphFill(eph, 1) != 1 ||
+		bakeBSTSStart(statea, params, settingsa, da, certa) != ERR_OK ||
+		bakeBSTSStart(stateb, params, settingsb, db, certb) != ERR_OK ||
+		bakeBSTSStep2Eph(buf, eph, stateb) != ERR_OK ||
+		bakeBSTSStep3(buf, buf, statea) != ERR_OK ||
+		bakeBSTSStep4(buf, buf, len, bakeTestCertVal, stateb) != ERR_OK ||
+		bakeBSTSStep5(buf, 32 + certb->len + 8, bakeTestCertVal,
+			statea) != ERR_OK ||
+		bakeBSTSStepG(keya, statea) != ERR_OK ||
+		bakeBSTSStepG(keyb, stateb) != ERR_OK ||
+		!memEq(keya, keyb, 32) ||
+		!hexEq(keya,
+			"78EF2C56BD6DA2116BB5BEE80CEE5C05"
+			"394E7609183CF7F76DF0C2DCFB25C4AD"))
+		return FALSE;
+	bignEphClose(eph);
+	// тест Б.2 с кэшем сертификатов
+	if (bakeCertCacheCreate(0, 0) == ERR_OK ||
+		bakeCertCacheCreate(4, 3600) != ERR_OK ||
+		bakeCertCacheCreate(4, 3600) == ERR_OK)
+		return FALSE;
+	certa->val = certb->val = bakeTestCertVal2;
+	for (_certval_count = 0, len = 0; len < 2; ++len)
+	{
+		hexTo(randa, _bmqv_randa);
+		hexTo(randb, _bmqv_randb);
+		prngEchoStart(echoa, randa, strLen(_bmqv_randb) / 2);
+		prngEchoStart(echob, randb, strLen(_bmqv_randb) / 2);
+		if (bakeBMQVStart(statea, params, settingsa, da, certa) != ERR_OK ||
+			bakeBMQVStart(stateb, params, settingsb, db, certb) != ERR_OK ||
+			bakeBMQVStep2(buf, stateb) != ERR_OK ||
+			bakeBMQVStep3(buf, buf, certb, statea) != ERR_OK ||
+			bakeBMQVStep4(buf, buf, certa, stateb) != ERR_OK ||
+			bakeBMQVStep5(buf, statea) != ERR_OK ||
+			bakeBMQVStepG(keya, statea) != ERR_OK ||
+			bakeBMQVStepG(keyb, stateb) != ERR_OK ||
+			!memEq(keya, keyb, 32) ||
+			!hexEq(keya,
+				"C6F86D0E468D5EF1A9955B2EE0CF0581"
+				"050C81D1B47727092408E863C7EEB48C"))
+			return FALSE;
+	}
+	if (_certval_count != 2)
+		return FALSE;
+	certdataa[0] ^= 1;
+	if (bakeBMQVStart(statea, params, settingsa, da, certa) != ERR_OK ||
+		_certval_count != 3)
+		return FALSE;
+	certdataa[0] ^= 1;
+	certdataa[certa->len - 1] ^= 1;
+	if (bakeBMQVStart(statea, params, settingsa, da, certa) == ERR_OK)
+		return FALSE;
+	certdataa[certa->len - 1] ^= 1;
+	bakeCertCacheClose();
+	certa->val = certb->val = bakeTestCertVal;
 	// тест bakeKDF (по данным из теста Б.4)
 	hexTo(secret, 
 		"723356E335ED70620FFB1842752092C3"
@@ -4,107 +4,125 @@
 \brief Benchmarks for STB 34.101.77 (bash)
 \project bee2/test
 \created 2014.07.15
-\version 2023.03.30
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
 #include <stdio.h>
+#include <bee2/core/err.h>
 #include <bee2/core/prng.h>
-#include <bee2/core/tm.h>
+#include <bee2/core/rng.h>
 #include <bee2/core/util.h>
 #include <bee2/crypto/bash.h>
 #include <bee2/crypto/belt.h>
-#include <bee2/math/pp.h>
-#include <bee2/math/ww.h>
+#include "../bench.h"
 
 /*
 *******************************************************************************
 Замер производительности
+
+Операцией является обработка фрагмента из 1024 октетов на шаге хэширования,
+загрузки или зашифрования.
 *******************************************************************************
 */
 
-extern const char bash_platform[];
+typedef struct {
+	octet buf[1024];		/*< фрагмент */
+	octet state[1024];		/*< состояние */
+} bash_bench_ctx;
+
+static void beltBenchHashOp(void* ctx)
+{
+	bash_bench_ctx* c = (bash_bench_ctx*)ctx;
+	beltHashStepH(c->buf, sizeof(c->buf), c->state);
+}
+
+static void bashBenchHashOp(void* ctx)
+{
+	bash_bench_ctx* c = (bash_bench_ctx*)ctx;
+	bashHashStepH(c->buf, sizeof(c->buf), c->state);
+}
+
+static void bashBenchAbsorbOp(void* ctx)
+{
+	bash_bench_ctx* c = (bash_bench_ctx*)ctx;
+	bashPrgAbsorbStep(c->buf, sizeof(c->buf), c->state);
+}
+
+static void bashBenchRngOp(void* ctx)
+{
+	bash_bench_ctx* c = (bash_bench_ctx*)ctx;
+	rngStepR2(c->buf, sizeof(c->buf), 0);
+}
+
+static void bashBenchEncrOp(void* ctx)
+{
+	bash_bench_ctx* c = (bash_bench_ctx*)ctx;
+	bashPrgEncrStep(c->buf, sizeof(c->buf), c->state);
+}
 
 bool_t bashBench()
 {
-	octet belt_state[256];
-	octet bash_state[1024];
 	octet combo_state[256];
-	octet buf[1024];
-	octet hash[64];
+	bash_bench_ctx ctx[1];
+	octet key[32];
+	char name[32];
 	size_t l, d;
 	// подготовить память
-	if (sizeof(belt_state) < beltHash_keep() ||
-		sizeof(bash_state) < bashPrg_keep() ||
-		sizeof(bash_state) < bashHash_keep() ||
+	if (sizeof(ctx->state) < beltHash_keep() ||
+		sizeof(ctx->state) < bashPrg_keep() ||
+		sizeof(ctx->state) < bashHash_keep() ||
 		sizeof(combo_state) < prngCOMBO_keep())
 		return FALSE;
-	// заполнить buf псевдослучайными числами
+	// заполнить buf и key псевдослучайными числами
 	prngCOMBOStart(combo_state, utilNonce32());
-	prngCOMBOStepR(buf, sizeof(buf), combo_state);
+	prngCOMBOStepR(ctx->buf, sizeof(ctx->buf), combo_state);
+	prngCOMBOStepR(key, sizeof(key), combo_state);
 	// платформа
-	printf("bashBench::platform = %s\n", bash_platform);
-	// оценить скорость хэширования
+	benchNote("bashBench", "platform", bashPlatform());
+	// эксперимент c belt
+	beltHashStart(ctx->state);
+	benchRun("bashBench", "belt-hash", sizeof(ctx->buf), beltBenchHashOp,
+		ctx);
+	// эксперимент c bashLLL
+	for (l = 128; l <= 256; l += 64)
+	{
+		sprintf(name, "bash%u", (unsigned)(2 * l));
+		bashHashStart(ctx->state, l);
+		benchRun("bashBench", name, sizeof(ctx->buf), bashBenchHashOp, ctx);
+	}
+	// эксперимент с bash-prg-hashLLLD
+	for (l = 128; l <= 256; l += 64)
+	for (d = 1; d <= 2; ++d)
+	{
+		sprintf(name, "bash-prg-hash%u%u", (unsigned)(2 * l), (unsigned)d);
+		bashPrgStart(ctx->state, l, d, 0, 0, 0, 0);
+		bashPrgAbsorbStart(ctx->state);
+		benchRun("bashBench", name, sizeof(ctx->buf), bashBenchAbsorbOp,
+			ctx);
+	}
+	// эксперимент с bash-prg-aeLLLD
+	for (l = 128; l <= 256; l += 64)
+	for (d = 1; d <= 2; ++d)
+	{
+		sprintf(name, "bash-prg-ae%u%u", (unsigned)l, (unsigned)d);
+		bashPrgStart(ctx->state, l, d, 0, 0, key, l / 8);
+		bashPrgEncrStart(ctx->state);
+		benchRun("bashBench", name, sizeof(ctx->buf), bashBenchEncrOp, ctx);
+	}
+	// эксперимент с механизмами генератора
+	for (l = 0; l < 2; ++l)
 	{
-		const size_t reps = 2000;
-		size_t i;
-		tm_ticks_t ticks;
-		// эксперимент c belt
-		beltHashStart(belt_state);
-		for (i = 0, ticks = tmTicks(); i < reps; ++i)
-			beltHashStepH(buf, sizeof(buf), belt_state);
-		beltHashStepG(hash, belt_state);
-		ticks = tmTicks() - ticks;
-		printf("bashBench::belt-hash: %3u cpb [%5u kBytes/sec]\n",
-			(unsigned)(ticks / 1024 / reps),
-			(unsigned)tmSpeed(reps, ticks));
-		// эксперимент c bashHashLLL
-		for (l = 128; l <= 256; l += 64)
-		{
-			bashHashStart(bash_state, l);
-			for (i = 0, ticks = tmTicks(); i < reps; ++i)
-				bashHashStepH(buf, sizeof(buf), bash_state);
-			bashHashStepG(hash, l / 4, bash_state);
-			ticks = tmTicks() - ticks;
-			printf("bashBench::bash%u: %3u cpb [%5u kBytes/sec]\n",
-				(unsigned)(2 * l),
-				(unsigned)(ticks / sizeof(buf) / reps),
-				(unsigned)tmSpeed(reps, ticks));
-		}
-		// эксперимент с bash-prg-hashLLLD
-		for (l = 128; l <= 256; l += 64)
-		for (d = 1; d <= 2; ++d)
-		{
-			bashPrgStart(bash_state, l, d, hash, l / 8, 0, 0);
-			bashPrgAbsorbStart(bash_state);
-			for (i = 0, ticks = tmTicks(); i < reps; ++i)
-				bashPrgAbsorbStep(buf, 1024, bash_state);
-			bashPrgSqueeze(hash, l / 4, bash_state);
-			ticks = tmTicks() - ticks;
-			printf("bashBench::bash-prg-hash%u%u: %3u cpb [%5u kBytes/sec]\n",
-				(unsigned)(2 * l), (unsigned)d,
-				(unsigned)(ticks / sizeof(buf) / reps),
-				(unsigned)tmSpeed(reps, ticks));
-		}
-		// эксперимент с bash-prg-aeLLLD
-		for (l = 128; l <= 256; l += 64)
-		for (d = 1; d <= 2; ++d)
-		{
-			bashPrgStart(bash_state, l, d, 0, 0, hash, l / 8);
-			bashPrgEncrStart(bash_state);
-			for (i = 0, ticks = tmTicks(); i < reps; ++i)
-				bashPrgEncrStep(buf, 1024, bash_state);
-			bashPrgDecrStart(bash_state);
-			for (i = 0, ticks = tmTicks(); i < reps; ++i)
-				bashPrgDecrStep(buf, 1024, bash_state);
-			ticks = tmTicks() - ticks;
-			printf("bashBench::bash-prg-ae%u%u: %3u cpb [%5u kBytes/sec]\n",
-				(unsigned)l, (unsigned)d,
-				(unsigned)(ticks / (2 * sizeof(buf)) / reps),
-				(unsigned)tmSpeed(2 * reps, ticks));
-		}
+		const char* engine = l ? "bash" : "belt";
+		sprintf(name, "rngStepR2[%s]", engine);
+		if (!benchIsSelected("bashBench", name))
+			continue;
+		if (rngCreate2(0, 0, engine) != ERR_OK)
+			return FALSE;
+		benchRun("bashBench", name, sizeof(ctx->buf), bashBenchRngOp, ctx);
+		rngClose();
 	}
 	// все нормально
 	return TRUE;
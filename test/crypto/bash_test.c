@@ -4,12 +4,14 @@
 \brief Tests for STB 34.101.77 (bash)
 \project bee2/test
 \created 2015.09.22
-\version 2023.03.30
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include <bee2/core/blob.h>
+#include <bee2/core/err.h>
 #include <bee2/core/mem.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/str.h>
@@ -31,10 +33,17 @@ bool_t bashTest()
 	octet hash[64];
 	octet state[1024];
 	octet state1[1024];
+	octet blocks[9 * 192];
+	const void* srcs[11];
+	size_t lens[11];
 	size_t pos;
+	size_t l;
+	octet* msg;
+	void* tree;
 	// подготовить память
-	if (sizeof(state) < utilMax(3,
+	if (sizeof(state) < utilMax(4,
 			bashF_deep(),
+			bashFN_deep(),
 			bashHash_keep(),
 			bashPrg_keep()) ||
 		sizeof(state) != sizeof(state1))
@@ -293,6 +302,172 @@ bool_t bashTest()
 	bashPrgSqueezeStep(buf + 14, 32 - 14, state);
 	if (!memEq(buf, hash, 32))
 		return FALSE;
+	// A.6: зашифрование / расшифрование с выводом в отдельный буфер
+	memSetZero(blocks, 192);
+	bashPrgStart(state, 256, 1, beltH(), 16, beltH() + 32, 32);
+	bashPrgAbsorb(beltH() + 64, 49, state);
+	bashPrgEncrStart(state);
+	bashPrgEncrStep2(blocks + 192, blocks, 7, state);
+	bashPrgEncrStep2(blocks + 199, blocks + 7, 185, state);
+	bashPrgSqueeze(buf, 32, state);
+	if (!memEq(buf, hash, 32))
+		return FALSE;
+	bashPrgStart(state, 256, 1, beltH(), 16, beltH() + 32, 32);
+	bashPrgAbsorb(beltH() + 64, 49, state);
+	bashPrgEncr(blocks, 192, state);
+	if (!memEq(blocks, blocks + 192, 192))
+		return FALSE;
+	bashPrgStart(state, 256, 1, beltH(), 16, beltH() + 32, 32);
+	bashPrgAbsorb(beltH() + 64, 49, state);
+	bashPrgDecr2(blocks + 384, blocks, 192, state);
+	bashPrgSqueeze(buf, 32, state);
+	if (!memIsZero(blocks + 384, 192) || !memEq(buf, hash, 32))
+		return FALSE;
+	// A.6: восстановление по снимку
+	if (bashPrgSnapshot_keep() > sizeof(state1))
+		return FALSE;
+	bashPrgStart(state, 256, 1, beltH(), 16, beltH() + 32, 32);
+	bashPrgAbsorbStart(state);
+	bashPrgSnapshot(state1, state);
+	for (pos = 0; pos < 2; ++pos)
+	{
+		bashPrgRestore(state, state1);
+		bashPrgAbsorbStep(beltH() + 64, 49, state);
+		memSetZero(buf, 192);
+		bashPrgEncr(buf, 192, state);
+		if (!memEq(buf, blocks + 192, 192))
+			return FALSE;
+		bashPrgSqueeze(buf, 32, state);
+		if (!memEq(buf, hash, 32))
+			return FALSE;
+	}
+	// bash-f: несколько состояний
+	for (pos = 0; pos < 9; ++pos)
+	{
+		memCopy(blocks + 192 * pos, beltH(), 192);
+		blocks[192 * pos] ^= (octet)pos;
+	}
+	bashFN(blocks, 9, state);
+	for (pos = 0; pos < 9; ++pos)
+	{
+		memCopy(buf, beltH(), 192);
+		buf[0] ^= (octet)pos;
+		bashF(buf, state);
+		if (!memEq(buf, blocks + 192 * pos, 192))
+			return FALSE;
+	}
+	// bash-hash: несколько сообщений
+	for (pos = 0; pos < 11; ++pos)
+		srcs[pos] = blocks + 37 * pos, 
+			lens[pos] = (pos % 2) ? 131 * pos : 128 * pos;
+	if (bashHashMB(state1, 128, srcs, lens, 11) != ERR_OK)
+		return FALSE;
+	for (pos = 0; pos < 11; ++pos)
+	{
+		bashHash(hash, 128, srcs[pos], lens[pos]);
+		if (!memEq(hash, state1 + 32 * pos, 32))
+			return FALSE;
+	}
+	if (bashHashMB(state1, 256, srcs, lens, 11) != ERR_OK)
+		return FALSE;
+	for (pos = 0; pos < 11; ++pos)
+	{
+		bashHash(hash, 256, srcs[pos], lens[pos]);
+		if (!memEq(hash, state1 + 64 * pos, 64))
+			return FALSE;
+	}
+	// bash-prg-tree: пустое сообщение
+	memCopy(buf, "LEAF", 4), memSetZero(buf + 4, 8);
+	bashPrgStart(state, 256, 1, buf, 12, 0, 0);
+	bashPrgAbsorb(0, 0, state);
+	bashPrgSqueeze(buf + 12, 64, state);
+	buf[76] = 1, memSetZero(buf + 77, 7);
+	bashPrgStart(state, 256, 1, (const octet*)"ROOT", 4, 0, 0);
+	bashPrgAbsorb(buf + 12, 72, state);
+	bashPrgSqueeze(hash, 64, state);
+	if (bashPrgTreeHash(buf, 256, 1, 0, 0, 3) != ERR_OK ||
+		!memEq(buf, hash, 64))
+		return FALSE;
+	// bash-prg-tree: независимость от числа потоков и фрагментации
+	msg = (octet*)blobCreate(3 * BASH_PRG_TREE_LEAF + 1000);
+	tree = blobCreate(bashPrgTree_keep(4));
+	if (!msg || !tree)
+	{
+		blobClose(tree), blobClose(msg);
+		return FALSE;
+	}
+	for (pos = 0; pos < 3 * BASH_PRG_TREE_LEAF + 1000; pos += 192)
+		memCopy(msg + pos, beltH(),
+			MIN2(192, 3 * BASH_PRG_TREE_LEAF + 1000 - pos)),
+		msg[pos] = (octet)(pos / 192);
+	for (l = 2 * BASH_PRG_TREE_LEAF; l <= 3 * BASH_PRG_TREE_LEAF + 1000;
+		l += BASH_PRG_TREE_LEAF + 1000)
+	{
+		bashPrgTreeHash(hash, 192, 2, msg, l, 1);
+		bashPrgTreeHash(buf, 192, 2, msg, l, 4);
+		if (!memEq(buf, hash, 48))
+			break;
+		bashPrgTreeStart(tree, 192, 2, 4);
+		bashPrgTreeStepH(msg, 12345, tree);
+		bashPrgTreeStepH(msg + 12345, BASH_PRG_TREE_LEAF - 12345, tree);
+		bashPrgTreeStepH(msg + BASH_PRG_TREE_LEAF, l - BASH_PRG_TREE_LEAF,
+			tree);
+		bashPrgTreeStepG(buf, 48, tree);
+		if (!memEq(buf, hash, 48))
+			break;
+	}
+	blobClose(tree), blobClose(msg);
+	if (l <= 3 * BASH_PRG_TREE_LEAF + 1000)
+		return FALSE;
+	// bash-hash: фрагменты
+	lens[0] = 7, lens[1] = 0, lens[2] = 121, lens[3] = 64;
+	for (srcs[0] = beltH(), pos = 1; pos < 4; ++pos)
+		srcs[pos] = (const octet*)srcs[pos - 1] + lens[pos - 1];
+	bashHashStart(state, 128);
+	bashHashStepHV(srcs, lens, 4, state);
+	bashHashStepG(hash, 32, state);
+	bashHash(buf, 128, beltH(), 192);
+	if (!memEq(hash, buf, 32))
+		return FALSE;
+	// bash-hash: экспорт / импорт
+	bashHash(hash, 192, beltH(), 192);
+	for (pos = 0; pos <= 192; pos += 48)
+	{
+		bashHashStart(state, 192);
+		bashHashStepH(beltH(), pos, state);
+		bashHashExport(state1, state);
+		memSetZero(state, sizeof(state));
+		if (bashHashImport(state, state1) != ERR_OK)
+			return FALSE;
+		bashHashStepH(beltH() + pos, 192 - pos, state);
+		if (!bashHashStepV(hash, 48, state))
+			return FALSE;
+		state1[1] = 0x02;
+		if (bashHashImport(state, state1) != ERR_BAD_FORMAT)
+			return FALSE;
+	}
+	// bash-prg: экспорт / импорт
+	bashPrgStart(state, 192, 2, beltH(), 16, beltH() + 32, 32);
+	bashPrgAbsorb(beltH() + 64, 100, state);
+	bashPrgSqueeze(hash, 48, state);
+	for (l = 0; l < 2; ++l)
+	{
+		bashPrgStart(state, 192, 2, beltH(), 16, l ? 0 : beltH() + 32,
+			l ? 0 : 32);
+		bashPrgAbsorbStart(state);
+		bashPrgAbsorbStep(beltH() + 64, 55, state);
+		bashPrgExport(state1, state);
+		memSetZero(state, sizeof(state));
+		if (bashPrgImport(state, state1) != ERR_OK)
+			return FALSE;
+		bashPrgAbsorbStep(beltH() + 64 + 55, 45, state);
+		bashPrgSqueeze(buf, 48, state);
+		if (memEq(buf, hash, 48) != (l == 0))
+			return FALSE;
+		state1[5] = 0xFF;
+		if (bashPrgImport(state, state1) != ERR_BAD_FORMAT)
+			return FALSE;
+	}
 	// все нормально
 	return TRUE;
 }
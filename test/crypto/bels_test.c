@@ -4,13 +4,15 @@
 \brief Tests for STB 34.101.60 (bels)
 \project bee2/test
 \created 2013.06.27
-\version 2023.03.29
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include <bee2/core/err.h>
 #include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/prng.h>
 #include <bee2/core/str.h>
@@ -274,6 +276,90 @@ bool_t belsTest()
 			"003EEBDF90E803BA37CBA4FF8D9A724F"))
 			return FALSE;
 	}
+	// пакетное разделение
+	for (len = 16; len <= 32; len += 8)
+	{
+		octet sj[3 * 5 * 32];
+		octet sb[3 * 5 * 32];
+		octet recover_state[2048];
+		mt_pool_t* pool;
+		bool_t success;
+		// загрузить открытые ключи
+		belsStdM(m0, len, 0);
+		for (num = 0; num < 5; ++num)
+			belsStdM(mi + num * len, len, num + 1);
+		// разделить секреты по одному
+		prngEchoStart(echo_state, beltH() + 128, 128);
+		for (num = 0; num < 3; ++num)
+			if (belsShare(sj + num * 5 * len, 5, 3, len, beltH() + num * len,
+				m0, mi, prngEchoStepR, echo_state) != ERR_OK)
+				return FALSE;
+		// разделить секреты пакетом
+		prngEchoStart(echo_state, beltH() + 128, 128);
+		if (belsShareBatch(sb, 3, 5, 3, len, beltH(), m0, mi,
+				prngEchoStepR, echo_state, 0) != ERR_OK ||
+			!memEq(sb, sj, 3 * 5 * len))
+			return FALSE;
+		// разделить секреты пакетом в пуле потоков
+		if (!(pool = mtPoolCreate(2, 0, 0)))
+			return FALSE;
+		memSetZero(sb, sizeof(sb));
+		prngEchoStart(echo_state, beltH() + 128, 128);
+		success = belsShareBatch(sb, 3, 5, 3, len, beltH(), m0, mi,
+			prngEchoStepR, echo_state, pool) == ERR_OK;
+		mtPoolClose(pool);
+		if (!success || !memEq(sb, sj, 3 * 5 * len))
+			return FALSE;
+		// восстановить секрет
+		if (belsRecover(s, 3, len, sb + 2 * 5 * len, m0, mi) != ERR_OK ||
+			!memEq(s, beltH() + 2 * len, len))
+			return FALSE;
+		// восстановить секреты по предвычислениям
+		if (sizeof(recover_state) < belsRecover_keep(3, len) ||
+			belsRecoverStart(recover_state, 3, len, m0, mi + 2 * len) !=
+				ERR_OK)
+			return FALSE;
+		for (num = 0; num < 3; ++num)
+		{
+			memCopy(sj, sb + (num * 5 + 2) * len, 3 * len);
+			belsRecoverStepR(s, sj, recover_state);
+			if (!memEq(s, beltH() + num * len, len))
+				return FALSE;
+		}
+		// повторяющиеся открытые ключи
+		memCopy(sj, mi, len);
+		memCopy(sj + len, mi, len);
+		if (belsRecoverStart(recover_state, 2, len, m0, sj) != ERR_BAD_PUBKEY)
+			return FALSE;
+		// сгенерировать открытые ключи пакетом
+		if (belsGenMiBatch(sj, 5, len, m0, (const octet*)id, strLen(id),
+				0) != ERR_OK ||
+			belsValMBatch(sj, 5, len, 0) != ERR_OK)
+			return FALSE;
+		for (num = 0; num < 5; ++num)
+		{
+			memCopy(s, id, strLen(id));
+			s[strLen(id)] = (octet)num;
+			memSetZero(s + strLen(id) + 1, 3);
+			if (belsGenMid(sb, len, m0, s, strLen(id) + 4) != ERR_OK ||
+				!memEq(sb, sj + num * len, len))
+				return FALSE;
+		}
+		// сгенерировать и проверить открытые ключи пакетом в пуле потоков
+		if (!(pool = mtPoolCreate(2, 0, 0)))
+			return FALSE;
+		memSetZero(sb, sizeof(sb));
+		success = belsGenMiBatch(sb, 5, len, m0, (const octet*)id,
+				strLen(id), pool) == ERR_OK &&
+			memEq(sb, sj, 5 * len) &&
+			belsValMBatch(sb, 5, len, pool) == ERR_OK;
+		sb[3 * len] ^= 1;
+		success = success &&
+			belsValMBatch(sb, 5, len, pool) == ERR_BAD_PUBKEY;
+		mtPoolClose(pool);
+		if (!success)
+			return FALSE;
+	}
 	// разделение и сборка на стандартных открытых ключах
 	for (len = 16; len <= 32; len += 8)
 	{
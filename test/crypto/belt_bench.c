@@ -4,40 +4,260 @@
 \brief Benchmarks for STB 34.101.31 (belt)
 \project bee2/test
 \created 2014.11.18
-\version 2023.03.30
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
-#include <stdio.h>
+#include <bee2/core/blob.h>
+#include <bee2/core/mem.h>
 #include <bee2/core/prng.h>
-#include <bee2/core/tm.h>
 #include <bee2/core/util.h>
 #include <bee2/crypto/belt.h>
-#include <bee2/math/pp.h>
-#include <bee2/math/ww.h>
+#include "../bench.h"
+
+/*
+*******************************************************************************
+Режимы
+
+Каждая функция beltBenchXXX() обрабатывает одно сообщение [count]buf:
+инициализирует состояние на ключе key (и синхропосылке iv), выполняет
+основную операцию режима и, если предусмотрено, вычисляет имитовставку
+или хэш-значение. Таким образом, в замеры включаются накладные расходы
+на инициализацию, существенные для коротких сообщений.
+
+Функция beltBenchXXX() возвращает FALSE, если режим не применим
+к сообщениям длины count.
+*******************************************************************************
+*/
+
+typedef bool_t (*belt_bench_i)(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state);
+
+static bool_t beltBenchECB(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	if (count < 16)
+		return FALSE;
+	beltECBStart(state, key, 32);
+	beltECBStepE(buf, count, state);
+	return TRUE;
+}
+
+static bool_t beltBenchCBC(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	if (count < 16)
+		return FALSE;
+	beltCBCStart(state, key, 32, iv);
+	beltCBCStepE(buf, count, state);
+	return TRUE;
+}
+
+static bool_t beltBenchCFB(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	beltCFBStart(state, key, 32, iv);
+	beltCFBStepE(buf, count, state);
+	return TRUE;
+}
+
+static bool_t beltBenchCTR(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	beltCTRStart(state, key, 32, iv);
+	beltCTRStepE(buf, count, state);
+	return TRUE;
+}
+
+static bool_t beltBenchMAC(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	octet mac[8];
+	beltMACStart(state, key, 32);
+	beltMACStepA(buf, count, state);
+	beltMACStepG(mac, state);
+	return TRUE;
+}
+
+static bool_t beltBenchMACMB(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	const void* src[8];
+	size_t lens[8];
+	const octet* keys[8];
+	size_t key_lens[8];
+	octet mac[8 * 8];
+	size_t i;
+	// 8 сообщений длины count / 8
+	if (count < 8)
+		return FALSE;
+	for (i = 0; i < 8; ++i)
+	{
+		src[i] = buf + i * (count / 8), lens[i] = count / 8;
+		keys[i] = key, key_lens[i] = 32;
+	}
+	return beltMACMB(mac, src, lens, keys, key_lens, 8) == ERR_OK;
+}
+
+static bool_t beltBenchDWP(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	octet mac[8];
+	beltDWPStart(state, key, 32, iv);
+	beltDWPStepE(buf, count, state);
+	beltDWPStepA(buf, count, state);
+	beltDWPStepG(mac, state);
+	return TRUE;
+}
+
+static bool_t beltBenchCHE(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	octet mac[8];
+	beltCHEStart(state, key, 32, iv);
+	beltCHEStepE(buf, count, state);
+	beltCHEStepA(buf, count, state);
+	beltCHEStepG(mac, state);
+	return TRUE;
+}
+
+static bool_t beltBenchKWP(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	if (count < 16)
+		return FALSE;
+	// буфер buf зарезервирован с запасом для заголовка
+	beltKWPStart(state, key, 32);
+	memCopy(buf + count, iv, 16);
+	beltKWPStepE(buf, count + 16, state);
+	return TRUE;
+}
+
+static bool_t beltBenchWBL(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	if (count < 32)
+		return FALSE;
+	beltWBLStart(state, key, 32);
+	beltWBLStepE(buf, count, state);
+	return TRUE;
+}
+
+static bool_t beltBenchBDE(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	if (count < 16 || count % 16)
+		return FALSE;
+	beltBDEStart(state, key, 32, iv);
+	beltBDEStepE(buf, count, state);
+	return TRUE;
+}
+
+static bool_t beltBenchSDE(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	if (count < 32 || count % 16)
+		return FALSE;
+	beltSDEStart(state, key, 32);
+	beltSDEStepE(buf, count, iv, state);
+	return TRUE;
+}
+
+static bool_t beltBenchFMT(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	// алфавит из 10 символов, символы занимают по 2 октета
+	count /= 2;
+	if (count < 2 || count > 600 || beltFMT_keep(10, count) > 4096)
+		return FALSE;
+	memSetZero(buf, 2 * count);
+	beltFMTStart(state, 10, count, key, 32);
+	beltFMTStepE((u16*)buf, iv, state);
+	return TRUE;
+}
+
+static bool_t beltBenchHMAC(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	octet mac[32];
+	beltHMACStart(state, key, 32);
+	beltHMACStepA(buf, count, state);
+	beltHMACStepG(mac, state);
+	return TRUE;
+}
+
+static bool_t beltBenchHash(octet buf[], size_t count, const octet key[32],
+	const octet iv[16], void* state)
+{
+	octet hash[32];
+	beltHashStart(state);
+	beltHashStepH(buf, count, state);
+	beltHashStepG(hash, state);
+	return TRUE;
+}
+
+static const struct {
+	const char* name;
+	belt_bench_i fn;
+} _modes[] = {
+	{ "belt-ecb", beltBenchECB },
+	{ "belt-cbc", beltBenchCBC },
+	{ "belt-cfb", beltBenchCFB },
+	{ "belt-ctr", beltBenchCTR },
+	{ "belt-mac", beltBenchMAC },
+	{ "belt-mac-mb", beltBenchMACMB },
+	{ "belt-dwp", beltBenchDWP },
+	{ "belt-che", beltBenchCHE },
+	{ "belt-kwp", beltBenchKWP },
+	{ "belt-wbl", beltBenchWBL },
+	{ "belt-bde", beltBenchBDE },
+	{ "belt-sde", beltBenchSDE },
+	{ "belt-fmt", beltBenchFMT },
+	{ "belt-hmac", beltBenchHMAC },
+	{ "belt-hash", beltBenchHash },
+};
 
 /*
 *******************************************************************************
 Замер производительности
+
+Каждый режим замеряется на сообщениях длины 16, 64, 256, ..., 1048576
+октетов. Замеры выполняются с помощью benchRun(): операцией является
+обработка одного сообщения.
 *******************************************************************************
 */
 
+static const size_t _max_size = 1048576;
+
+typedef struct {
+	belt_bench_i fn;		/*< режим */
+	octet* buf;				/*< сообщение */
+	size_t count;			/*< длина сообщения */
+	const octet* key;		/*< ключ */
+	const octet* iv;		/*< синхропосылка */
+	void* state;			/*< состояние */
+} belt_bench_ctx;
+
+static void beltBenchOp(void* ctx)
+{
+	belt_bench_ctx* c = (belt_bench_ctx*)ctx;
+	c->fn(c->buf, c->count, c->key, c->iv, c->state);
+}
+
 bool_t beltBench()
 {
-	const size_t reps = 5000;
-	octet belt_state[512];
+	octet belt_state[4096];
 	octet combo_state[256];
-	octet buf[1024];
+	octet* buf;
 	octet key[32];
 	octet iv[16];
-	octet hash[32];
-	size_t i;
-	tm_ticks_t ticks;
+	belt_bench_ctx ctx[1];
+	size_t m;
 	// подготовить стек
 	if (sizeof(combo_state) < prngCOMBO_keep() ||
-		sizeof(belt_state) < utilMax(10,
+		sizeof(belt_state) < utilMax(13,
 			beltECB_keep(),
 			beltCBC_keep(),
 			beltCFB_keep(),
@@ -45,107 +265,35 @@ bool_t beltBench()
 			beltMAC_keep(),
 			beltDWP_keep(),
 			beltCHE_keep(),
-			beltHash_keep(),
+			beltKWP_keep(),
+			beltWBL_keep(),
 			beltBDE_keep(),
-			beltSDE_keep()))
+			beltSDE_keep(),
+			beltHMAC_keep(),
+			beltHash_keep()))
+		return FALSE;
+	// подготовить буфер (с запасом для заголовка KWP)
+	if (!(buf = (octet*)blobCreate(_max_size + 16)))
 		return FALSE;
 	// псевдослучайная генерация объектов
 	prngCOMBOStart(combo_state, utilNonce32());
-	prngCOMBOStepR(buf, sizeof(buf), combo_state);
+	prngCOMBOStepR(buf, _max_size, combo_state);
 	prngCOMBOStepR(key, sizeof(key), combo_state);
 	prngCOMBOStepR(iv, sizeof(iv), combo_state);
-	// cкорость belt-ecb
-	beltECBStart(belt_state, key, 32);
-	for (i = 0, ticks = tmTicks(); i < reps; ++i)
-		beltECBStepE(buf, 1024, belt_state),
-		beltECBStepD(buf, 1024, belt_state);
-	ticks = tmTicks() - ticks;
-	printf("beltBench::belt-ecb:  %3u cpb [%5u kBytes/sec]\n",
-		(unsigned)(ticks / 2048 / reps),
-		(unsigned)tmSpeed(2 * reps, ticks));
-	// cкорость belt-cbc
-	beltCBCStart(belt_state, key, 32, iv);
-	for (i = 0, ticks = tmTicks(); i < reps; ++i)
-		beltCBCStepE(buf, 1024, belt_state),
-		beltCBCStepD(buf, 1024, belt_state);
-	ticks = tmTicks() - ticks;
-	printf("beltBench::belt-cbc:  %3u cpb [%5u kBytes/sec]\n",
-		(unsigned)(ticks / 2048 / reps),
-		(unsigned)tmSpeed(2 * reps, ticks));
-	// cкорость belt-cfb
-	beltCFBStart(belt_state, key, 32, iv);
-	for (i = 0, ticks = tmTicks(); i < reps; ++i)
-		beltCFBStepE(buf, 1024, belt_state),
-		beltCFBStepD(buf, 1024, belt_state);
-	ticks = tmTicks() - ticks;
-	printf("beltBench::belt-cfb:  %3u cpb [%5u kBytes/sec]\n",
-		(unsigned)(ticks / 2048 / reps),
-		(unsigned)tmSpeed(2 * reps, ticks));
-	// cкорость belt-ctr
-	beltCTRStart(belt_state, key, 32, iv);
-	for (i = 0, ticks = tmTicks(); i < reps; ++i)
-		beltCTRStepE(buf, 1024, belt_state),
-		beltCTRStepD(buf, 1024, belt_state);
-	ticks = tmTicks() - ticks;
-	printf("beltBench::belt-ctr:  %3u cpb [%5u kBytes/sec]\n",
-		(unsigned)(ticks / 2048 / reps),
-		(unsigned)tmSpeed(2 * reps, ticks));
-	// cкорость belt-mac
-	beltMACStart(belt_state, key, 32);
-	for (i = 0, ticks = tmTicks(); i < reps; ++i)
-		beltMACStepA(buf, 1024, belt_state);
-	beltMACStepG(hash, belt_state);
-	ticks = tmTicks() - ticks;
-	printf("beltBench::belt-mac:  %3u cpb [%5u kBytes/sec]\n",
-		(unsigned)(ticks / 1024 / reps),
-		(unsigned)tmSpeed(reps, ticks));
-	// cкорость belt-dwp
-	beltDWPStart(belt_state, key, 32, iv);
-	for (i = 0, ticks = tmTicks(); i < reps; ++i)
-		beltDWPStepE(buf, 1024, belt_state),
-		beltDWPStepA(buf, 1024, belt_state);
-	beltDWPStepG(hash, belt_state);
-	ticks = tmTicks() - ticks;
-	printf("beltBench::belt-dwp:  %3u cpb [%5u kBytes/sec]\n",
-		(unsigned)(ticks / 1024 / reps),
-		(unsigned)tmSpeed(reps, ticks));
-	// cкорость belt-che
-	beltCHEStart(belt_state, key, 32, iv);
-	for (i = 0, ticks = tmTicks(); i < reps; ++i)
-		beltCHEStepE(buf, 1024, belt_state),
-		beltCHEStepA(buf, 1024, belt_state);
-	beltCHEStepG(hash, belt_state);
-	ticks = tmTicks() - ticks;
-	printf("beltBench::belt-che:  %3u cpb [%5u kBytes/sec]\n",
-		(unsigned)(ticks / 1024 / reps),
-		(unsigned)tmSpeed(reps, ticks));
-	// cкорость belt-hash
-	beltHashStart(belt_state);
-	for (i = 0, ticks = tmTicks(); i < reps; ++i)
-		beltHashStepH(buf, 1024, belt_state);
-	beltHashStepG(hash, belt_state);
-	ticks = tmTicks() - ticks;
-	printf("beltBench::belt-hash: %3u cpb [%5u kBytes/sec]\n",
-		(unsigned)(ticks / 1024 / reps),
-		(unsigned)tmSpeed(reps, ticks));
-	// cкорость belt-bde
-	beltBDEStart(belt_state, key, 32, iv);
-	for (i = 0, ticks = tmTicks(); i < reps; ++i)
-		beltBDEStepE(buf, 1024, belt_state),
-		beltBDEStepD(buf, 1024, belt_state);
-	ticks = tmTicks() - ticks;
-	printf("beltBench::belt-bde:  %3u cpb [%5u kBytes/sec]\n",
-		(unsigned)(ticks / 2048 / reps),
-		(unsigned)tmSpeed(2 * reps, ticks));
-	// cкорость belt-sde
-	beltSDEStart(belt_state, key, 32);
-	for (i = 0, ticks = tmTicks(); i < reps; ++i)
-		beltSDEStepE(buf, 1024, iv, belt_state),
-		beltSDEStepD(buf, 1024, iv, belt_state);
-	ticks = tmTicks() - ticks;
-	printf("beltBench::belt-sde:  %3u cpb [%5u kBytes/sec]\n",
-		(unsigned)(ticks / 2048 / reps),
-		(unsigned)tmSpeed(2 * reps, ticks));
-	// все нормально
+	// платформа
+	benchNote("beltBench", "platform", beltBlockPlatform());
+	// замеры
+	ctx->buf = buf, ctx->key = key, ctx->iv = iv, ctx->state = belt_state;
+	for (m = 0; m < COUNT_OF(_modes); ++m)
+		for (ctx->count = 16; ctx->count <= _max_size; ctx->count *= 4)
+		{
+			ctx->fn = _modes[m].fn;
+			if (!ctx->fn(buf, ctx->count, key, iv, belt_state))
+				continue;
+			benchRun("beltBench", _modes[m].name, ctx->count, beltBenchOp,
+				ctx);
+		}
+	// завершить
+	blobClose(buf);
 	return TRUE;
 }
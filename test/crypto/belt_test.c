@@ -4,13 +4,15 @@
 \brief Tests for STB 34.101.31 (belt)
 \project bee2/test
 \created 2012.06.20
-\version 2024.01.25
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include <bee2/core/err.h>
 #include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/u32.h>
 #include <bee2/core/util.h>
@@ -129,10 +131,25 @@ bool_t beltTest()
 	octet hash[32];
 	octet hash1[32];
 	u32 key[8];
+	u32 skey[16];
 	u32 block[4];
 	octet level[12];
 	octet state[1024];
-	size_t count;
+	const void* srcs[8];
+	const void* srcs1[8];
+	void* bufs[8];
+	size_t lens[8];
+	size_t lens1[8];
+	const octet* keys[8];
+	size_t key_lens[8];
+	bool_t valid[8];
+	const octet* pwds[5];
+	const octet* salts[5];
+	size_t salt_lens[5];
+	size_t count, total, i;
+	octet* ctr_buf;
+	mt_pool_t* pool;
+	bool_t ok;
 	// подготовить память
 	if (sizeof(state) < utilMax(17,
 		256,
@@ -188,6 +205,43 @@ bool_t beltTest()
 	u32To(buf, 16, block);
 	if (!memEq(buf, beltH(), 16))
 		return FALSE;
+	// belt-block: несколько блоков
+	u32From((u32*)buf, beltH(), 112);
+	beltBlockEncrN((u32*)buf, 7, key);
+	for (count = 0; count < 7; ++count)
+	{
+		u32From(block, beltH() + 16 * count, 16);
+		beltBlockEncr2(block, key);
+		if (!memEq(block, buf + 16 * count, 16))
+			return FALSE;
+	}
+	beltBlockDecrN((u32*)buf, 7, key);
+	u32To(buf, 112, (u32*)buf);
+	if (!memEq(buf, beltH(), 112))
+		return FALSE;
+	// belt-block: несколько блоков (векторные реализации)
+	for (count = 0; count < 37; ++count)
+	{
+		u32From((u32*)state + 4 * count, beltH() + 16 * (count % 16), 16);
+		((u32*)state)[4 * count] ^= (u32)count;
+	}
+	beltBlockEncrN((u32*)state, 37, key);
+	for (count = 0; count < 37; ++count)
+	{
+		u32From(block, beltH() + 16 * (count % 16), 16);
+		block[0] ^= (u32)count;
+		beltBlockEncr2(block, key);
+		if (!memEq(block, (u32*)state + 4 * count, 16))
+			return FALSE;
+	}
+	beltBlockDecrN((u32*)state, 37, key);
+	for (count = 0; count < 37; ++count)
+	{
+		u32From(block, beltH() + 16 * (count % 16), 16);
+		block[0] ^= (u32)count;
+		if (!memEq(block, (u32*)state + 4 * count, 16))
+			return FALSE;
+	}
 	// belt-block: тест A.4
 	memCopy(buf, beltH() + 64, 16);
 	beltKeyExpand2(key, beltH() + 128 + 32, 32);
@@ -370,6 +424,14 @@ bool_t beltTest()
 		beltH() + 192 + 16);
 	if (!memEq(buf, buf1, 36))
 		return FALSE;
+	// belt-cbc: длинные сообщения
+	for (count = 64; count <= 128; count += 9)
+	{
+		beltCBCEncr(buf, beltH(), count, beltH() + 128, 32, beltH() + 192);
+		beltCBCDecr(buf1, buf, count, beltH() + 128, 32, beltH() + 192);
+		if (!memEq(buf1, beltH(), count))
+			return FALSE;
+	}
 	// belt-cfb: тест A.13
 	memCopy(buf, beltH(), 48);
 	beltCFBStart(state, beltH() + 128, 32, beltH() + 192);
@@ -399,6 +461,13 @@ bool_t beltTest()
 		beltH() + 192 + 16);
 	if (!memEq(buf, buf1, 48))
 		return FALSE;
+	// belt-cfb: длинные сообщения
+	beltCFBEncr(buf, beltH(), 128, beltH() + 128, 32, beltH() + 192);
+	beltCFBStart(state, beltH() + 128, 32, beltH() + 192);
+	beltCFBStepD(buf, 7, state);
+	beltCFBStepD(buf + 7, 121, state);
+	if (!memEq(buf, beltH(), 128))
+		return FALSE;
 	// belt-ctr: тест A.15
 	memCopy(buf, beltH(), 48);
 	beltCTRStart(state, beltH() + 128, 32, beltH() + 192);
@@ -428,6 +497,92 @@ bool_t beltTest()
 		beltH() + 192 + 16);
 	if (!memEq(buf, buf1, 44))
 		return FALSE;
+	// belt-ctr: длинные сообщения
+	memCopy(buf, beltH(), 128);
+	beltCTRStart(state, beltH() + 128, 32, beltH() + 192);
+	for (count = 0; count < 128; count += 16)
+		beltCTRStepE(buf + count, 16, state);
+	beltCTR(buf1, beltH(), 128, beltH() + 128, 32, beltH() + 192);
+	if (!memEq(buf, buf1, 128))
+		return FALSE;
+	beltCTRStart(state, beltH() + 128, 32, beltH() + 192);
+	beltCTRStepE(buf1, 5, state);
+	beltCTRStepE(buf1 + 5, 123, state);
+	if (!memEq(buf1, beltH(), 128))
+		return FALSE;
+	// belt-ctr: позиционирование
+	beltCTR(buf, beltH(), 128, beltH() + 128, 32, beltH() + 192);
+	for (count = 0; count <= 128; count += 7)
+	{
+		memCopy(buf1, beltH(), 128);
+		beltCTRStart(state, beltH() + 128, 32, beltH() + 192);
+		beltCTRStepE(hash, 3, state);
+		beltCTRSeek(state, count);
+		beltCTRStepE(buf1 + count, 128 - count, state);
+		if (!memEq(buf1 + count, buf + count, 128 - count))
+			return FALSE;
+	}
+	// belt-ctr: пул потоков
+	count = 3 * 16384 + 37;
+	if (!(ctr_buf = (octet*)memAlloc(2 * count)))
+		return FALSE;
+	for (i = 0; i < count; ++i)
+		ctr_buf[i] = (octet)i;
+	beltCTR(ctr_buf + count, ctr_buf, count, beltH() + 128, 32,
+		beltH() + 192);
+	if (!(pool = mtPoolCreate(2, 0, 0)))
+	{
+		memFree(ctr_buf);
+		return FALSE;
+	}
+	ok = beltCTRPool(ctr_buf, ctr_buf, count, beltH() + 128, 32,
+			beltH() + 192, pool) == ERR_OK &&
+		memEq(ctr_buf, ctr_buf + count, count) &&
+		beltCTRPool(ctr_buf, ctr_buf, count, beltH() + 128, 32,
+			beltH() + 192, 0) == ERR_OK &&
+		ctr_buf[count - 1] == (octet)(count - 1);
+	mtPoolClose(pool);
+	memFree(ctr_buf);
+	if (!ok)
+		return FALSE;
+	// belt-ecb, belt-cbc, belt-cfb, belt-ctr: выходной буфер
+	beltECBEncr(buf1, beltH(), 47, beltH() + 128, 32);
+	beltECBStart(state, beltH() + 128, 32);
+	beltECBStepETo(buf, beltH(), 16, state);
+	beltECBStepETo(buf + 16, beltH() + 16, 31, state);
+	if (!memEq(buf, buf1, 47))
+		return FALSE;
+	beltECBStart(state, beltH() + 128, 32);
+	beltECBStepDTo(buf, buf1, 47, state);
+	if (!memEq(buf, beltH(), 47))
+		return FALSE;
+	beltCBCEncr(buf1, beltH(), 47, beltH() + 128, 32, beltH() + 192);
+	beltCBCStart(state, beltH() + 128, 32, beltH() + 192);
+	beltCBCStepETo(buf, beltH(), 16, state);
+	beltCBCStepETo(buf + 16, beltH() + 16, 31, state);
+	if (!memEq(buf, buf1, 47))
+		return FALSE;
+	beltCBCStart(state, beltH() + 128, 32, beltH() + 192);
+	beltCBCStepDTo(buf, buf1, 47, state);
+	if (!memEq(buf, beltH(), 47))
+		return FALSE;
+	beltCFBEncr(buf1, beltH(), 128, beltH() + 128, 32, beltH() + 192);
+	beltCFBStart(state, beltH() + 128, 32, beltH() + 192);
+	beltCFBStepETo(buf, beltH(), 7, state);
+	beltCFBStepETo(buf + 7, beltH() + 7, 121, state);
+	if (!memEq(buf, buf1, 128))
+		return FALSE;
+	beltCFBStart(state, beltH() + 128, 32, beltH() + 192);
+	beltCFBStepDTo(buf, buf1, 77, state);
+	beltCFBStepDTo(buf + 77, buf1 + 77, 51, state);
+	if (!memEq(buf, beltH(), 128))
+		return FALSE;
+	beltCTR(buf1, beltH(), 128, beltH() + 128, 32, beltH() + 192);
+	beltCTRStart(state, beltH() + 128, 32, beltH() + 192);
+	beltCTRStepETo(buf, beltH(), 5, state);
+	beltCTRStepETo(buf + 5, beltH() + 5, 123, state);
+	if (!memEq(buf, buf1, 128))
+		return FALSE;
 	// belt-mac: тест A.17-1
 	beltMACStart(state, beltH() + 128, 32);
 	beltMACStepA(beltH(), 13, state);
@@ -541,6 +696,102 @@ bool_t beltTest()
 		beltH() + 128 + 32, 32, beltH() + 192 + 16);
 	if (!memEq(buf1, beltH() + 64, 20) || !memEq(mac, mac1, 8))
 		return FALSE;
+	// belt-dwp/belt-che: длинные сообщения
+	beltDWPStart(state, beltH() + 128, 32, beltH() + 192);
+	beltDWPStepI(beltH(), 200, state);
+	beltDWPStepA(beltH() + 17, 239, state);
+	beltDWPStepG(mac, state);
+	beltDWPStart(state, beltH() + 128, 32, beltH() + 192);
+	for (count = 0; count < 200; count += 8)
+		beltDWPStepI(beltH() + count, 8, state);
+	for (count = 17; count < 256; count += 16)
+		beltDWPStepA(beltH() + count, MIN2(16, 256 - count), state);
+	if (!beltDWPStepV(mac, state))
+		return FALSE;
+	beltCHEStart(state, beltH() + 128, 32, beltH() + 192);
+	beltCHEStepI(beltH(), 200, state);
+	beltCHEStepA(beltH() + 17, 239, state);
+	beltCHEStepG(mac, state);
+	beltCHEStart(state, beltH() + 128, 32, beltH() + 192);
+	for (count = 0; count < 200; count += 8)
+		beltCHEStepI(beltH() + count, 8, state);
+	for (count = 17; count < 256; count += 16)
+		beltCHEStepA(beltH() + count, MIN2(16, 256 - count), state);
+	if (!beltCHEStepV(mac, state))
+		return FALSE;
+	// belt-dwp/belt-che: снятие защиты с неверной имитовставкой
+	beltDWPWrap(buf, mac, beltH(), 128, beltH() + 128, 32,
+		beltH() + 128, 32, beltH() + 192);
+	mac[0] ^= 1;
+	memSet(buf1, 0xAA, 128);
+	if (beltDWPUnwrap(buf1, buf, 128, beltH() + 128, 32, mac,
+			beltH() + 128, 32, beltH() + 192) != ERR_BAD_MAC ||
+		!memIsZero(buf1, 128))
+		return FALSE;
+	mac[0] ^= 1;
+	if (beltDWPUnwrap(buf, buf, 128, beltH() + 128, 32, mac,
+			beltH() + 128, 32, beltH() + 192) != ERR_OK ||
+		!memEq(buf, beltH(), 128))
+		return FALSE;
+	beltCHEWrap(buf, mac, beltH(), 128, beltH() + 128, 32,
+		beltH() + 128, 32, beltH() + 192);
+	mac[0] ^= 1;
+	if (beltCHEUnwrap(buf1, buf, 128, beltH() + 128, 32, mac,
+			beltH() + 128, 32, beltH() + 192) != ERR_BAD_MAC ||
+		!memIsZero(buf1, 128))
+		return FALSE;
+	mac[0] ^= 1;
+	if (beltCHEUnwrap(buf1, buf, 128, beltH() + 128, 32, mac,
+			beltH() + 128, 32, beltH() + 192) != ERR_OK ||
+		!memEq(buf1, beltH(), 128))
+		return FALSE;
+	// belt-dwp/belt-che: имитовставка внутри dest
+	memCopy(buf1 + 64, mac, 8);
+	if (beltCHEUnwrap(buf1, buf, 128, beltH() + 128, 32, buf1 + 64,
+			beltH() + 128, 32, beltH() + 192) != ERR_OK ||
+		!memEq(buf1, beltH(), 128))
+		return FALSE;
+	beltDWPWrap(buf, mac, beltH(), 128, beltH() + 128, 32,
+		beltH() + 128, 32, beltH() + 192);
+	memCopy(buf1 + 64, mac, 8);
+	if (beltDWPUnwrap(buf1, buf, 128, beltH() + 128, 32, buf1 + 64,
+			beltH() + 128, 32, beltH() + 192) != ERR_OK ||
+		!memEq(buf1, beltH(), 128))
+		return FALSE;
+	// belt-che: пакетная обработка
+	lens[0] = 0, lens[1] = 1, lens[2] = 100, lens[3] = 333;
+	lens[4] = 1400, lens[5] = 16, lens[6] = 5000, lens[7] = 47;
+	for (total = i = 0; i < 8; total += lens[i++]);
+	if (!(ctr_buf = (octet*)memAlloc(3 * total + 128)))
+		return FALSE;
+	for (i = 0; i < 3 * total + 128; ++i)
+		ctr_buf[i] = (octet)(7 * i);
+	for (count = i = 0; i < 8; count += lens[i++])
+	{
+		srcs[i] = ctr_buf + count;
+		bufs[i] = ctr_buf + total + count;
+		srcs1[i] = beltH() + 7 * i;
+		lens1[i] = (29 * i) % 200;
+	}
+	ok = beltCHEWrapBatch(bufs, buf, srcs, lens, srcs1, lens1, 8,
+		beltH() + 128, 32, ctr_buf + 3 * total) == ERR_OK;
+	for (count = i = 0; ok && i < 8; count += lens[i++])
+		ok = beltCHEWrap(ctr_buf + 2 * total + count, mac, srcs[i], lens[i],
+				srcs1[i], lens1[i], beltH() + 128, 32,
+				ctr_buf + 3 * total + 16 * i) == ERR_OK &&
+			memEq(ctr_buf + 2 * total + count, bufs[i], lens[i]) &&
+			memEq(mac, buf + 8 * i, 8);
+	buf[8 * 3] ^= 1;
+	ok = ok && beltCHEUnwrapBatch(bufs, valid, (const void* const*)bufs,
+		lens, srcs1, lens1, buf, 8, beltH() + 128, 32,
+		ctr_buf + 3 * total) == ERR_BAD_MAC;
+	for (i = 0; ok && i < 8; ++i)
+		ok = valid[i] == (i != 3) &&
+			memEq(bufs[i], i != 3 ? srcs[i] : ctr_buf + 2 * total +
+				((const octet*)srcs[3] - ctr_buf), lens[i]);
+	memFree(ctr_buf);
+	if (!ok)
+		return FALSE;
 	// belt-kwp: тест A.21
 	beltKWPStart(state, beltH() + 128, 32);
 	memCopy(buf, beltH(), 32);
@@ -569,6 +820,25 @@ bool_t beltTest()
 		beltH() + 128 + 32, 32) != ERR_OK ||
 		!memEq(buf, buf1, 32))
 		return FALSE;
+	// belt-kwp: несколько ключей
+	beltKWPStart(state, beltH() + 128, 32);
+	if (beltKWPWrapN(state + 512, beltH(), 32, 5, beltH() + 200, 
+			state) != ERR_OK)
+		return FALSE;
+	for (count = 0; count < 5; ++count)
+	{
+		beltKWPWrap(buf, beltH() + 32 * count, 32, beltH() + 200, 
+			beltH() + 128, 32);
+		if (!memEq(buf, state + 512 + 48 * count, 48))
+			return FALSE;
+	}
+	if (beltKWPUnwrapN(state + 768, state + 512, 48, 5, beltH() + 200, 
+			state) != ERR_OK ||
+		!memEq(state + 768, beltH(), 160) ||
+		beltKWPUnwrapN(state + 768, state + 512, 48, 5, beltH() + 199, 
+			state) != ERR_BAD_KEYTOKEN ||
+		!memIsZero(state + 768, 160))
+		return FALSE;
 	// belt-hash: тест A.23-1
 	beltHashStart(state);
 	beltHashStepH(beltH(), 13, state);
@@ -668,6 +938,41 @@ bool_t beltTest()
 	beltSDEEncr(buf, buf1, 48, beltH() + 128 + 32, 32, beltH() + 192 + 16);
 	if (!memEq(buf, beltH() + 64, 48))
 		return FALSE;
+	// belt-bde/belt-sde: секторы
+	memCopy(state, beltH(), 256);
+	memCopy(state + 256, beltH(), 224);
+	memSetZero(hash, 16);
+	hash[0] = 0xFE;
+	if (beltBDEEncrSectors(state + 512, state, 480, 96, beltH() + 128, 32, 
+			hash) != ERR_OK ||
+		beltSDEEncrSectors(buf1, state, 96, 96, beltH() + 128, 32, 
+			hash) != ERR_OK)
+		return FALSE;
+	for (count = 0; count < 5; ++count)
+	{
+		memSetZero(hash1, 16);
+		hash1[0] = (octet)(0xFE + count), hash1[1] = (octet)(count >= 2);
+		beltBDEEncr(buf, state + 96 * count, 96, beltH() + 128, 32, hash1);
+		if (!memEq(buf, state + 512 + 96 * count, 96))
+			return FALSE;
+	}
+	if (beltBDEDecrSectors(state + 512, state + 512, 480, 96, beltH() + 128, 
+			32, hash) != ERR_OK || !memEq(state + 512, state, 480))
+		return FALSE;
+	if (beltSDEEncrSectors(state + 512, state, 480, 96, beltH() + 128, 32, 
+			hash) != ERR_OK || !memEq(state + 512, buf1, 96))
+		return FALSE;
+	for (count = 0; count < 5; ++count)
+	{
+		memSetZero(hash1, 16);
+		hash1[0] = (octet)(0xFE + count), hash1[1] = (octet)(count >= 2);
+		beltSDEEncr(buf, state + 96 * count, 96, beltH() + 128, 32, hash1);
+		if (!memEq(buf, state + 512 + 96 * count, 96))
+			return FALSE;
+	}
+	if (beltSDEDecrSectors(state + 512, state + 512, 480, 96, beltH() + 128, 
+			32, hash) != ERR_OK || !memEq(state + 512, state, 480))
+		return FALSE;
 	// belt-fmt: тест A.26
 	{
 		u16 str[21] = {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,};
@@ -720,6 +1025,36 @@ bool_t beltTest()
 		if (!memEq(str, str1, 9 * 2))
 			return FALSE;
 	}
+	// belt-fmt: пакетная обработка
+	{
+		const u32 mods[3] = { 58, 10, 65536 };
+		const size_t counts[3] = { 21, 38, 17 };
+		u16 strs[18 * 38];
+		u16 strs1[18 * 38];
+		octet ivs[18 * 16];
+		memCopy(ivs, beltH(), 256);
+		memCopy(ivs + 256, beltH(), 18 * 16 - 256);
+		for (i = 0; i < 3; ++i)
+		{
+			for (count = 0; count < 18 * counts[i]; ++count)
+				strs[count] = (u16)((count * 7919) % mods[i]);
+			beltFMTStart(state, mods[i], counts[i], beltH() + 128, 32);
+			memCopy(strs1, strs, 2 * 18 * counts[i]);
+			beltFMTStepEN(strs1, 18, ivs, state);
+			for (count = 0; count < 18; ++count)
+			{
+				beltFMTStepD(strs1 + counts[i] * count, ivs + 16 * count,
+					state);
+				if (!memEq(strs1 + counts[i] * count,
+						strs + counts[i] * count, 2 * counts[i]))
+					return FALSE;
+				beltFMTStepE(strs1 + counts[i] * count, 0, state);
+			}
+			beltFMTStepDN(strs1, 18, 0, state);
+			if (!memEq(strs1, strs, 2 * 18 * counts[i]))
+				return FALSE;
+		}
+	}
 	// belt-keyexpand: тест A.27-1
 	beltKeyExpand(buf, beltH() + 128, 16);
 	if (!hexEq(buf,
@@ -762,6 +1097,41 @@ bool_t beltTest()
 	beltKRP(buf1, 32, beltH() + 128, 32, level, beltH() + 32);
 	if (!memEq(buf, buf1, 32))
 		return FALSE;
+	// belt-keyrep: несколько заголовков
+	beltKRPStepGN(buf1, 24, beltH(), 5, state);
+	for (count = 0; count < 5; ++count)
+	{
+		beltKRPStepG(buf, 24, beltH() + 16 * count, state);
+		if (!memEq(buf, buf1 + 24 * count, 24))
+			return FALSE;
+	}
+	// belt-hash: несколько сообщений
+	for (count = 0; count < 8; ++count)
+		srcs[count] = beltH() + count, lens[count] = 29 * count;
+	if (beltHashMB(state, srcs, lens, 8) != ERR_OK)
+		return FALSE;
+	for (count = 0; count < 8; ++count)
+	{
+		beltHash(hash, beltH() + count, 29 * count);
+		if (!memEq(hash, state + 32 * count, 32))
+			return FALSE;
+	}
+	// belt-mac: несколько сообщений (разные и совпадающие ключи)
+	for (count = 0; count < 8; ++count)
+	{
+		srcs[count] = beltH() + count, lens[count] = 8 * count;
+		keys[count] = beltH() + 128 + (count % 3);
+		key_lens[count] = 16 + 8 * (count % 3);
+	}
+	if (beltMACMB(state, srcs, lens, keys, key_lens, 8) != ERR_OK)
+		return FALSE;
+	for (count = 0; count < 8; ++count)
+	{
+		beltMAC(mac, beltH() + count, lens[count], keys[count],
+			key_lens[count]);
+		if (!memEq(mac, state + 8 * count, 8))
+			return FALSE;
+	}
 	// belt-hmac: тест Б.1-1
 	beltHMACStart(state, beltH() + 128, 29);
 	beltHMACStepA(beltH() + 128 + 64, 32, state);
@@ -798,6 +1168,189 @@ bool_t beltTest()
 	beltHMAC(hash1, beltH() + 128 + 64, 32, beltH() + 128, 42);
 	if (!memEq(hash, hash1, 32))
 		return FALSE;
+	// belt-hmac: подготовленный ключ
+	if (sizeof(state) < beltHMAC_keep() + beltHMACKey_keep())
+		return FALSE;
+	beltHMACStart(state, beltH() + 128, 42);
+	beltHMACKeyPrepare(state + beltHMAC_keep(), state);
+	beltHMACStepA(beltH(), 13, state);
+	beltHMACStartPrepared(state, state + beltHMAC_keep());
+	beltHMACStepA(beltH() + 128 + 64, 32, state);
+	if (!beltHMACStepV(hash, state))
+		return FALSE;
+	// belt-pbkdf: сразу несколько паролей
+	for (count = 0; count < 5; ++count)
+	{
+		pwds[count] = beltH() + 7 * count, lens[count] = 3 + 11 * count;
+		salts[count] = beltH() + 128 + count, salt_lens[count] = 8 + count;
+	}
+	if (beltPBKDF2MB(state, pwds, lens, 100, salts, salt_lens, 5) != ERR_OK)
+		return FALSE;
+	for (count = 0; count < 5; ++count)
+	{
+		beltPBKDF2(hash, pwds[count], lens[count], 100, salts[count], 
+			salt_lens[count]);
+		if (!memEq(hash, state + 32 * count, 32))
+			return FALSE;
+	}
+	// belt-hash, belt-pbkdf: асинхронная обработка
+	{
+		mt_pool_t* pool;
+		mt_async_t* as;
+		belt_hash_req_t hreqs[8];
+		belt_pbkdf2_req_t preqs[5];
+		if (!(pool = mtPoolCreate(4, 0, 0)))
+			return FALSE;
+		if (!(as = mtAsyncCreate(pool, 3)))
+		{
+			mtPoolClose(pool);
+			return FALSE;
+		}
+		for (count = 0; count < 8; ++count)
+		{
+			hreqs[count].req.done = 0;
+			hreqs[count].src = beltH() + count;
+			hreqs[count].count = 29 * count;
+			hreqs[count].hash = state + 32 * count;
+			beltHashAsync(as, hreqs + count);
+		}
+		for (count = 0; count < 5; ++count)
+		{
+			preqs[count].req.done = 0;
+			preqs[count].key = state + 256 + 32 * count;
+			preqs[count].pwd = pwds[count], preqs[count].pwd_len = lens[count];
+			preqs[count].iter = count % 2 ? 100 : 50;
+			preqs[count].salt = salts[count];
+			preqs[count].salt_len = salt_lens[count];
+			beltPBKDF2Async(as, preqs + count);
+		}
+		mtAsyncClose(as);
+		mtPoolClose(pool);
+		for (count = 0; count < 8; ++count)
+		{
+			beltHash(hash, beltH() + count, 29 * count);
+			if (hreqs[count].req.code != ERR_OK ||
+				!memEq(hash, state + 32 * count, 32))
+				return FALSE;
+		}
+		for (count = 0; count < 5; ++count)
+		{
+			beltPBKDF2(hash, pwds[count], lens[count], preqs[count].iter,
+				salts[count], salt_lens[count]);
+			if (preqs[count].req.code != ERR_OK ||
+				!memEq(hash, state + 256 + 32 * count, 32))
+				return FALSE;
+		}
+	}
+	// belt-hash, belt-mac, belt-hmac, belt-dwp: фрагменты
+	lens[0] = 1, lens[1] = 31, lens[2] = 16, lens[3] = 0;
+	lens[4] = 45, lens[5] = 3, lens[6] = 32, lens[7] = 0;
+	for (srcs[0] = beltH(), count = 1; count < 8; ++count)
+		srcs[count] = (const octet*)srcs[count - 1] + lens[count - 1];
+	beltHashStart(state);
+	beltHashStepHV(srcs, lens, 8, state);
+	beltHashStepG(hash, state);
+	beltHash(hash1, beltH(), 128);
+	if (!memEq(hash, hash1, 32))
+		return FALSE;
+	beltMACStart(state, beltH() + 128, 32);
+	beltMACStepAV(srcs, lens, 8, state);
+	beltMACStepG(buf, state);
+	beltMAC(buf1, beltH(), 128, beltH() + 128, 32);
+	if (!memEq(buf, buf1, 8))
+		return FALSE;
+	beltHMACStart(state, beltH() + 128, 32);
+	beltHMACStepAV(srcs, lens, 8, state);
+	beltHMACStepG(hash, state);
+	beltHMAC(hash1, beltH(), 128, beltH() + 128, 32);
+	if (!memEq(hash, hash1, 32))
+		return FALSE;
+	memCopy(buf, beltH(), 128);
+	for (count = 0; count < 8; ++count)
+	{
+		bufs[count] = buf + ((const octet*)srcs[count] - beltH());
+		srcs[count] = bufs[count];
+	}
+	beltDWPStart(state, beltH() + 128, 32, beltH() + 192);
+	beltDWPStepEV(bufs, lens, 8, state);
+	beltDWPStepAV(srcs, lens, 8, state);
+	beltDWPStepG(mac, state);
+	beltDWPWrap(buf1, mac1, beltH(), 128, 0, 0, beltH() + 128, 32,
+		beltH() + 192);
+	if (!memEq(buf, buf1, 128) || !memEq(mac, mac1, 8))
+		return FALSE;
+	// подготовленный ключ
+	if (beltKey_keep() > sizeof(skey))
+		return FALSE;
+	beltKeyStart(skey, beltH() + 128, 24);
+	beltECBStartK(state, skey);
+	memCopy(buf, beltH(), 48);
+	beltECBStepE(buf, 48, state);
+	beltECBEncr(buf1, beltH(), 48, beltH() + 128, 24);
+	if (!memEq(buf, buf1, 48))
+		return FALSE;
+	beltCBCStartK(state, skey, beltH() + 192);
+	memCopy(buf, beltH(), 48);
+	beltCBCStepE(buf, 48, state);
+	beltCBCEncr(buf1, beltH(), 48, beltH() + 128, 24, beltH() + 192);
+	if (!memEq(buf, buf1, 48))
+		return FALSE;
+	beltCFBStartK(state, skey, beltH() + 192);
+	memCopy(buf, beltH(), 47);
+	beltCFBStepE(buf, 47, state);
+	beltCFBEncr(buf1, beltH(), 47, beltH() + 128, 24, beltH() + 192);
+	if (!memEq(buf, buf1, 47))
+		return FALSE;
+	beltCTRStartK(state, skey, beltH() + 192);
+	memCopy(buf, beltH(), 47);
+	beltCTRStepE(buf, 47, state);
+	beltCTR(buf1, beltH(), 47, beltH() + 128, 24, beltH() + 192);
+	if (!memEq(buf, buf1, 47))
+		return FALSE;
+	beltMACStartK(state, skey);
+	beltMACStepA(beltH(), 47, state);
+	beltMACStepG(mac, state);
+	beltMAC(mac1, beltH(), 47, beltH() + 128, 24);
+	if (!memEq(mac, mac1, 8))
+		return FALSE;
+	beltDWPStartK(state, skey, beltH() + 192);
+	memCopy(buf, beltH(), 47);
+	beltDWPStepE(buf, 47, state);
+	beltDWPStepI(beltH() + 64, 19, state);
+	beltDWPStepA(buf, 47, state);
+	beltDWPStepG(mac, state);
+	beltDWPWrap(buf1, mac1, beltH(), 47, beltH() + 64, 19, beltH() + 128, 24,
+		beltH() + 192);
+	if (!memEq(buf, buf1, 47) || !memEq(mac, mac1, 8))
+		return FALSE;
+	beltCHEStartK(state, skey, beltH() + 192);
+	memCopy(buf, beltH(), 47);
+	beltCHEStepE(buf, 47, state);
+	beltCHEStepI(beltH() + 64, 19, state);
+	beltCHEStepA(buf, 47, state);
+	beltCHEStepG(mac, state);
+	beltCHEWrap(buf1, mac1, beltH(), 47, beltH() + 64, 19, beltH() + 128, 24,
+		beltH() + 192);
+	if (!memEq(buf, buf1, 47) || !memEq(mac, mac1, 8))
+		return FALSE;
+	// belt-hash: экспорт / импорт
+	beltHash(hash1, beltH(), 128);
+	for (count = 0; count <= 128; count += 37)
+	{
+		beltHashStart(state);
+		beltHashStepH(beltH(), count, state);
+		beltHashExport(buf, state);
+		memSetZero(state, sizeof(state));
+		if (beltHashImport(state, buf) != ERR_OK)
+			return FALSE;
+		beltHashStepH(beltH() + count, 128 - count, state);
+		beltHashStepG(hash, state);
+		if (!memEq(hash, hash1, 32))
+			return FALSE;
+		buf[3] ^= 8;
+		if (beltHashImport(state, buf) != ERR_BAD_FORMAT)
+			return FALSE;
+	}
 	// zerosum
 	if (!beltTestZerosum())
 		return FALSE;
@@ -4,14 +4,17 @@
 \brief Tests for STB 34.101.45 (bign)
 \project bee2/test
 \created 2012.08.27
-\version 2023.09.25
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include <bee2/core/blob.h>
 #include <bee2/core/err.h>
 #include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
+#include <bee2/core/rng.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/str.h>
 #include <bee2/core/util.h>
@@ -100,6 +103,79 @@ static err_t _calc_q(bign_params* params, void* state)
 	return ERR_OK;
 }
 
+/*
+*******************************************************************************
+Пул одноразовых ключей и fork()
+
+Родительский процесс заполняет пул из трех пар и вызывает fork(). Дочерний
+процесс вырабатывает ЭЦП с помощью пула и передает ее родителю через
+канал. Родитель вырабатывает три ЭЦП на парах пула. Первая часть ЭЦП
+определяется одноразовым ключом k. Поэтому первая часть ЭЦП дочернего
+процесса должна отличаться от первых частей ЭЦП родителя.
+*******************************************************************************
+*/
+
+#ifdef OS_UNIX
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+static bool_t bignEphForkTest(const void* ctx, const octet der[],
+	size_t count, const octet hash[32], const octet privkey[32])
+{
+	octet eph[1024];
+	octet sig[48];
+	octet sig1[48];
+	int fd[2];
+	pid_t pid;
+	int status;
+	size_t i, read_count = 0;
+	bool_t ok;
+	if (sizeof(eph) < bignEph_keep(128, 3) || rngCreate(0, 0) != ERR_OK)
+		return FALSE;
+	if (bignEphStart(eph, ctx, 3, rngStepR, 0) != ERR_OK ||
+		bignEphFill(eph, SIZE_MAX) != 3 || pipe(fd) != 0)
+	{
+		rngClose();
+		return FALSE;
+	}
+	pid = fork();
+	if (pid == 0)
+	{
+		close(fd[0]);
+		if (bignSignEph(sig, eph, der, count, hash, privkey) != ERR_OK)
+			_exit(1);
+		_exit(write(fd[1], sig, 48) == 48 ? 0 : 1);
+	}
+	close(fd[1]);
+	if (pid > 0)
+	{
+		ssize_t r;
+		while (read_count < 48 &&
+			(r = read(fd[0], sig1 + read_count, 48 - read_count)) > 0)
+			read_count += (size_t)r;
+		waitpid(pid, &status, 0);
+	}
+	close(fd[0]);
+	ok = pid > 0 && read_count == 48 && bignEphReady(eph) == 3;
+	for (i = 0; ok && i < 3; ++i)
+		ok = bignSignEph(sig, eph, der, count, hash, privkey) == ERR_OK &&
+			!memEq(sig, sig1, 16);
+	bignEphClose(eph);
+	rngClose();
+	return ok;
+}
+
+#else
+
+static bool_t bignEphForkTest(const void* ctx, const octet der[],
+	size_t count, const octet hash[32], const octet privkey[32])
+{
+	return TRUE;
+}
+
+#endif
+
 /*
 *******************************************************************************
 Самотестирование
@@ -160,6 +236,13 @@ bool_t bignTest()
 		bignParamsDec(params1, der, count) != ERR_OK ||
 		!memEq(params, params1, sizeof(bign_params)))
 		return FALSE;
+	// некорректные параметры не запоминаются
+	params1->seed[0] ^= 1;
+	if (bignParamsVal(params1) == ERR_OK || bignParamsVal(params1) == ERR_OK)
+		return FALSE;
+	params1->seed[0] ^= 1;
+	if (bignParamsVal(params1) != ERR_OK)
+		return FALSE;
 	// генерация таблицы Б.1
 	if (bignParamsStd(params1, "1.2.112.0.2.0.34.101.45.3.1") != ERR_OK)
 		return FALSE;
@@ -233,6 +316,403 @@ bool_t bignTest()
 	if (bignVerify(params, der, count, hash, sig, pubkey) == ERR_OK)
 		return FALSE;
 	pubkey[0] ^= 1;
+	// кэш открытых ключей
+	{
+		size_t i;
+		if (bignVerifyCacheCreate(0) == ERR_OK ||
+			bignVerifyCacheCreate(4) != ERR_OK ||
+			bignVerifyCacheCreate(4) == ERR_OK)
+			return FALSE;
+		for (i = 0; i < 2; ++i)
+		{
+			if (bignVerify(params, der, count, hash, sig, pubkey) != ERR_OK)
+				return FALSE;
+			sig[0] ^= 1;
+			if (bignVerify(params, der, count, hash, sig, pubkey) == ERR_OK)
+				return FALSE;
+			sig[0] ^= 1, pubkey[0] ^= 1;
+			if (bignVerify(params, der, count, hash, sig, pubkey) == ERR_OK)
+				return FALSE;
+			pubkey[0] ^= 1;
+		}
+		bignVerifyCacheClose();
+	}
+	// пакетная проверка
+	{
+		octet hashes[9 * 32], sigs[9 * 48], pubkeys[9 * 64];
+		size_t bad, i;
+		for (i = 0; i < 9; ++i)
+		{
+			memCopy(hashes + 32 * i, hash, 32);
+			hashes[32 * i] ^= (octet)i;
+			if (bignSign2(sigs + 48 * i, params, der, count, hashes + 32 * i,
+				privkey, 0, 0) != ERR_OK)
+				return FALSE;
+			memCopy(pubkeys + 64 * i, pubkey, 64);
+		}
+		if (bignVerifyBatch(&bad, params, der, count, 9, hashes, sigs,
+				pubkeys) != ERR_OK || bad != 9 ||
+			bignVerifyBatch(&bad, params, der, count, 3, hashes, sigs,
+				pubkeys) != ERR_OK || bad != 3 ||
+			bignVerifyBatch(&bad, params, der, count, 0, hashes, sigs,
+				pubkeys) != ERR_OK || bad != 0)
+			return FALSE;
+		sigs[48 * 8 + 47] ^= 1;
+		if (bignVerifyBatch(&bad, params, der, count, 9, hashes, sigs,
+				pubkeys) != ERR_BAD_SIG || bad != 8)
+			return FALSE;
+		memSet(pubkeys + 64 * 6, 0xFF, 32);
+		if (bignVerifyBatch(&bad, params, der, count, 9, hashes, sigs,
+				pubkeys) != ERR_BAD_PUBKEY || bad != 6)
+			return FALSE;
+		sigs[48 * 2 + 47] ^= 1;
+		if (bignVerifyBatch(&bad, params, der, count, 9, hashes, sigs,
+				pubkeys) != ERR_BAD_SIG || bad != 2)
+			return FALSE;
+		hashes[32] ^= 2;
+		if (bignVerifyBatch(0, params, der, count, 9, hashes, sigs,
+				pubkeys) == ERR_OK ||
+			bignVerifyBatch(&bad, params, der, count, 3, hashes, sigs,
+				pubkeys) == ERR_OK || bad != 1)
+			return FALSE;
+	}
+	// асинхронная проверка
+	{
+		octet hashes[9 * 32], sigs[9 * 48];
+		bign_verify_req_t reqs[9];
+		mt_pool_t* pool;
+		mt_async_t* as;
+		size_t i;
+		for (i = 0; i < 9; ++i)
+		{
+			memCopy(hashes + 32 * i, hash, 32);
+			hashes[32 * i] ^= (octet)i;
+			if (bignSign2(sigs + 48 * i, params, der, count, hashes + 32 * i,
+				privkey, 0, 0) != ERR_OK)
+				return FALSE;
+			reqs[i].req.done = 0;
+			reqs[i].params = params;
+			reqs[i].oid_der = der, reqs[i].oid_len = i == 7 ? 1 : count;
+			reqs[i].hash = hashes + 32 * i;
+			reqs[i].sig = sigs + 48 * i;
+			reqs[i].pubkey = pubkey;
+		}
+		sigs[48 * 5 + 47] ^= 1;
+		if (!(pool = mtPoolCreate(4, 0, 0)))
+			return FALSE;
+		if (!(as = mtAsyncCreate(pool, 4)))
+		{
+			mtPoolClose(pool);
+			return FALSE;
+		}
+		for (i = 0; i < 9; ++i)
+			bignVerifyAsync(as, reqs + i);
+		mtAsyncClose(as);
+		mtPoolClose(pool);
+		for (i = 0; i < 9; ++i)
+			if (reqs[i].req.code != (i == 5 ? ERR_BAD_SIG :
+				i == 7 ? ERR_BAD_OID : ERR_OK))
+				return FALSE;
+	}
+	// пакетная проверка открытых ключей
+	{
+		octet pubkeys[40 * 64];
+		err_t codes[40];
+		size_t i;
+		for (i = 0; i < 40; ++i)
+			memCopy(pubkeys + 64 * i, pubkey, 64);
+		if (bignPubkeyValBatch(codes, params, 40, pubkeys) != ERR_OK ||
+			bignPubkeyValBatch(0, params, 0, pubkeys) != ERR_OK)
+			return FALSE;
+		for (i = 0; i < 40; ++i)
+			if (codes[i] != ERR_OK)
+				return FALSE;
+		pubkeys[64 * 5] ^= 1;
+		memSet(pubkeys + 64 * 33, 0xFF, 32);
+		memSetZero(pubkeys + 64 * 39, 64);
+		if (bignPubkeyValBatch(codes, params, 40, pubkeys) != ERR_BAD_PUBKEY ||
+			bignPubkeyValBatch(0, params, 40, pubkeys) != ERR_BAD_PUBKEY)
+			return FALSE;
+		for (i = 0; i < 40; ++i)
+			if (codes[i] != bignPubkeyVal(params, pubkeys + 64 * i) ||
+				(codes[i] == ERR_OK) != (i != 5 && i != 33 && i != 39))
+				return FALSE;
+	}
+	// контекст
+	{
+		octet ctx[4096], sig1[48], sig2[48], key1[32], key2[32];
+		octet state[sizeof(brng_state)];
+		void* ws;
+		bool_t ok;
+		if (sizeof(ctx) < bignCtx_keep(128) ||
+			bignCtxStart(ctx, params) != ERR_OK)
+			return FALSE;
+		if (bignSign2(sig1, params, der, count, hash, privkey, 0, 0)
+				!= ERR_OK ||
+			bignSign2Ctx(sig2, ctx, der, count, hash, privkey, 0, 0)
+				!= ERR_OK ||
+			!memEq(sig1, sig2, 48) ||
+			bignVerifyCtx(ctx, der, count, hash, sig2, pubkey) != ERR_OK)
+			return FALSE;
+		sig2[0] ^= 1;
+		if (bignVerifyCtx(ctx, der, count, hash, sig2, pubkey) == ERR_OK)
+			return FALSE;
+		if (bignDH(key1, params, privkey, pubkey, 32) != ERR_OK ||
+			bignDHCtx(key2, ctx, privkey, pubkey, 32) != ERR_OK ||
+			!memEq(key1, key2, 32))
+			return FALSE;
+		// не затрагивать генератор brng_state последующих тестов
+		memCopy(state, brng_state, sizeof(state));
+		if (bignKeyWrapCtx(token, ctx, key1, 32, beltH(), pubkey,
+				brngCTRXStepR, state) != ERR_OK ||
+			bignKeyUnwrapCtx(key2, ctx, token, 32 + 16 + 32, beltH(),
+				privkey) != ERR_OK ||
+			!memEq(key1, key2, 32))
+			return FALSE;
+		token[0] ^= 1;
+		if (bignKeyUnwrapCtx(key2, ctx, token, 32 + 16 + 32, beltH(),
+				privkey) == ERR_OK)
+			return FALSE;
+		// пакетное создание токенов
+		{
+			octet pubkeys[3 * 64], tokens[3 * 80], tokens1[3 * 80];
+			octet state1[sizeof(brng_state)];
+			mt_pool_t* pool;
+			size_t i;
+			memCopy(state, brng_state, sizeof(state));
+			memCopy(state1, brng_state, sizeof(state));
+			for (i = 0; i < 3; ++i)
+			{
+				memCopy(pubkeys + 64 * i, pubkey, 64);
+				if (bignKeyWrapCtx(tokens1 + 80 * i, ctx, key1, 32, beltH(),
+						pubkey, brngCTRXStepR, state1) != ERR_OK)
+					return FALSE;
+			}
+			if (bignKeyWrapBatch(tokens, ctx, key1, 32, beltH(), 3, pubkeys,
+					brngCTRXStepR, state, 0) != ERR_OK ||
+				!memEq(tokens, tokens1, sizeof(tokens)))
+				return FALSE;
+			if ((pool = mtPoolCreate(2, 0, 0)) != 0)
+			{
+				memCopy(state, brng_state, sizeof(state));
+				ok = bignKeyWrapBatch(tokens, ctx, key1, 32, beltH(), 3,
+					pubkeys, brngCTRXStepR, state, pool) == ERR_OK &&
+					memEq(tokens, tokens1, sizeof(tokens));
+				mtPoolClose(pool);
+				if (!ok)
+					return FALSE;
+			}
+			if (bignKeyUnwrapCtx(key2, ctx, tokens + 160, 80, beltH(),
+					privkey) != ERR_OK ||
+				!memEq(key1, key2, 32))
+				return FALSE;
+			memSet(pubkeys + 64, 0xFF, 32);
+			if (bignKeyWrapBatch(tokens, ctx, key1, 32, beltH(), 3, pubkeys,
+					brngCTRXStepR, state, 0) != ERR_BAD_PUBKEY)
+				return FALSE;
+		}
+		// рабочая память
+		ws = blobCreate(bignWs_keep(ctx));
+		if (!ws)
+			return FALSE;
+		ok = bignSign2Ws(sig2, ctx, ws, der, count, hash, privkey, 0, 0)
+				== ERR_OK &&
+			memEq(sig1, sig2, 48) &&
+			bignVerifyWs(ctx, ws, der, count, hash, sig2, pubkey) == ERR_OK &&
+			bignDHWs(key2, ctx, ws, privkey, pubkey, 32) == ERR_OK &&
+			memEq(key1, key2, 32) &&
+			bignSign2Ws(sig2, ctx, 0, der, count, hash, privkey, 0, 0)
+				== ERR_BAD_INPUT;
+		blobClose(ws);
+		if (!ok)
+			return FALSE;
+		// подготовленная детерминированная ЭЦП
+		{
+			octet det[1024];
+			if (sizeof(det) < bignDet_keep() ||
+				bignDetStart(det, ctx, der, count, privkey, 0, 0) != ERR_OK ||
+				bignSignDet(sig2, det, hash) != ERR_OK ||
+				!memEq(sig1, sig2, 48) ||
+				bignDetStart(det, ctx, der, count, privkey, beltH() + 192,
+					23) != ERR_OK ||
+				bignSign2(sig1, params, der, count, hash, privkey,
+					beltH() + 192, 23) != ERR_OK ||
+				bignSignDet(sig2, det, hash) != ERR_OK ||
+				!memEq(sig1, sig2, 48) ||
+				bignSignDet(sig2, det, beltH()) != ERR_OK ||
+				bignVerifyCtx(ctx, der, count, beltH(), sig2, pubkey)
+					!= ERR_OK)
+				return FALSE;
+			memWipe(det, sizeof(det));
+		}
+		// пул одноразовых ключей
+		{
+			octet eph[1024];
+			octet state1[sizeof(brng_state)];
+			mt_pool_t* pool;
+			if (sizeof(eph) < bignEph_keep(128, 3))
+				return FALSE;
+			memCopy(state, brng_state, sizeof(state));
+			memCopy(state1, brng_state, sizeof(state));
+			if (bignSign(sig1, params, der, count, hash, privkey,
+					brngCTRXStepR, state1) != ERR_OK ||
+				bignEphStart(eph, ctx, 3, brngCTRXStepR, state) != ERR_OK)
+				return FALSE;
+			ok = bignEphReady(eph) == 0 &&
+				bignEphFill(eph, 1) == 1 &&
+				bignEphReady(eph) == 1 &&
+				bignSignEph(sig2, eph, der, count, hash, privkey) == ERR_OK &&
+				memEq(sig1, sig2, 48) &&
+				bignEphReady(eph) == 0 &&
+				bignEphFill(eph, SIZE_MAX) == 3 &&
+				bignEphFill(eph, SIZE_MAX) == 0;
+			// пополнение в пуле потоков
+			if (ok && (pool = mtPoolCreate(1, 0, 0)) != 0)
+			{
+				ok = bignSignEph(sig2, eph, der, count, hash, privkey)
+					== ERR_OK && bignEphReady(eph) == 2;
+				mtPoolSubmit(pool, bignEphFillTask, eph);
+				mtPoolWait(pool);
+				mtPoolClose(pool);
+				ok = ok && bignEphReady(eph) == 3 &&
+					bignVerifyCtx(ctx, der, count, hash, sig2, pubkey)
+						== ERR_OK;
+			}
+			// пустой пул: пара строится на месте
+			ok = ok &&
+				bignSignEph(sig2, eph, der, count, hash, privkey) == ERR_OK &&
+				bignSignEph(sig2, eph, der, count, hash, privkey) == ERR_OK &&
+				bignSignEph(sig2, eph, der, count, hash, privkey) == ERR_OK &&
+				bignEphReady(eph) == 0 &&
+				bignSignEph(sig2, eph, der, count, hash, privkey) == ERR_OK &&
+				bignVerifyCtx(ctx, der, count, hash, sig2, pubkey) == ERR_OK;
+			bignEphClose(eph);
+			if (!ok || !bignEphForkTest(ctx, der, count, hash, privkey))
+				return FALSE;
+		}
+		// пакетная выработка ЭЦП
+		{
+			octet hashes[9 * 32], privkeys[9 * 32];
+			octet sigs[9 * 48], sigs1[9 * 48];
+			octet state1[sizeof(brng_state)];
+			err_t codes[9], codes1[9];
+			size_t i;
+			for (i = 0; i < 9; ++i)
+			{
+				memCopy(hashes + 32 * i, hash, 32);
+				hashes[32 * i] ^= (octet)i;
+				memCopy(privkeys + 32 * i, privkey, 32);
+			}
+			memSet(privkeys + 32 * 4, 0xFF, 32);
+			memCopy(state, brng_state, sizeof(state));
+			memCopy(state1, brng_state, sizeof(state));
+			for (i = 0; i < 9; ++i)
+				codes1[i] = bignSignCtx(sigs1 + 48 * i, ctx, der, count,
+					hashes + 32 * i, privkeys + 32 * i, brngCTRXStepR, state1);
+			if (bignSignBatch(codes, sigs, ctx, der, count, 9, hashes,
+					privkeys, brngCTRXStepR, state) != ERR_BAD_PRIVKEY ||
+				!memEq(codes, codes1, sizeof(codes)) ||
+				codes[4] != ERR_BAD_PRIVKEY || codes[8] != ERR_OK ||
+				!memEq(sigs, sigs1, 4 * 48) ||
+				!memEq(sigs + 5 * 48, sigs1 + 5 * 48, 4 * 48) ||
+				bignVerifyCtx(ctx, der, count, hashes + 32 * 8, sigs + 48 * 8,
+					pubkey) != ERR_OK)
+				return FALSE;
+			memCopy(privkeys + 32 * 4, privkey, 32);
+			if (bignSignBatch(0, sigs, ctx, der, count, 9, hashes, privkeys,
+					brngCTRXStepR, state) != ERR_OK ||
+				bignSignBatch(0, sigs, ctx, der, count, 0, hashes, privkeys,
+					brngCTRXStepR, state) != ERR_OK ||
+				bignSignBatch(0, sigs, ctx, der, count, 1, sigs, privkeys,
+					brngCTRXStepR, state) != ERR_BAD_INPUT)
+				return FALSE;
+			for (i = 0; i < 9; ++i)
+				if (bignVerifyCtx(ctx, der, count, hashes + 32 * i,
+						sigs + 48 * i, pubkey) != ERR_OK)
+					return FALSE;
+		}
+		// асинхронная выработка ЭЦП
+		{
+			octet hashes[5 * 32], sigs[5 * 48];
+			bign_sign_req_t reqs[5];
+			mt_pool_t* pool;
+			mt_async_t* as;
+			bool_t rng = rngCreate(0, 0) == ERR_OK;
+			size_t i;
+			if (!(pool = mtPoolCreate(4, 0, 0)))
+				return FALSE;
+			if (!(as = mtAsyncCreate(pool, 2)))
+			{
+				mtPoolClose(pool);
+				return FALSE;
+			}
+			for (i = 0; i < 5; ++i)
+			{
+				memCopy(hashes + 32 * i, hash, 32);
+				hashes[32 * i] ^= (octet)i;
+				reqs[i].req.done = 0;
+				reqs[i].ctx = ctx;
+				reqs[i].oid_der = der, reqs[i].oid_len = count;
+				reqs[i].hash = hashes + 32 * i;
+				reqs[i].privkey = privkey;
+				reqs[i].sig = sigs + 48 * i;
+				bignSignAsync(as, reqs + i);
+			}
+			mtAsyncClose(as);
+			mtPoolClose(pool);
+			if (rng)
+				rngClose();
+			for (i = 0; i < 5; ++i)
+				if (reqs[i].req.code != (rng ? ERR_OK : ERR_BAD_RNG) ||
+					rng && bignVerifyCtx(ctx, der, count, hashes + 32 * i,
+						sigs + 48 * i, pubkey) != ERR_OK)
+					return FALSE;
+		}
+		// очередь выработки ЭЦП
+		{
+			octet queue[2048], sigs[5 * 48];
+			err_t codes[5];
+			size_t i;
+			if (sizeof(queue) < bignSignQueue_keep(128, 4) ||
+				bignSignQueueStart(queue, ctx, der, count, 4, 60000,
+					brngCTRXStepR, state) != ERR_OK)
+				return FALSE;
+			for (i = 0; i < 5; ++i)
+				codes[i] = ERR_NOT_READY;
+			for (i = 0; i < 3; ++i)
+				if (bignSignQueueAdd(queue, sigs + 48 * i, codes + i,
+						hash, privkey) != ERR_OK)
+					return FALSE;
+			ok = bignSignQueuePending(queue) == 3 &&
+				bignSignQueuePoll(queue) == ERR_OK &&
+				codes[0] == ERR_NOT_READY &&
+				bignSignQueueAdd(queue, sigs + 48 * 3, codes + 3, hash,
+					privkey) == ERR_OK &&
+				bignSignQueuePending(queue) == 0 &&
+				bignSignQueueAdd(queue, sigs + 48 * 4, codes + 4, hash,
+					privkey) == ERR_OK &&
+				bignSignQueuePending(queue) == 1 &&
+				codes[4] == ERR_NOT_READY &&
+				bignSignQueueFlush(queue) == ERR_OK &&
+				bignSignQueuePending(queue) == 0;
+			for (i = 0; ok && i < 5; ++i)
+				ok = codes[i] == ERR_OK &&
+					bignVerifyCtx(ctx, der, count, hash, sigs + 48 * i,
+						pubkey) == ERR_OK;
+			bignSignQueueClose(queue);
+			if (!ok)
+				return FALSE;
+			// нулевая задержка: обработка при постановке
+			memSet(sigs, 0, 48);
+			if (bignSignQueueStart(queue, ctx, der, count, 4, 0,
+					brngCTRXStepR, state) != ERR_OK ||
+				bignSignQueueAdd(queue, sigs, 0, hash, privkey) != ERR_OK ||
+				bignSignQueuePending(queue) != 0 ||
+				bignVerifyCtx(ctx, der, count, hash, sigs, pubkey) != ERR_OK)
+				return FALSE;
+			bignSignQueueClose(queue);
+		}
+	}
 	// тест Г.8
 	memCopy(id_hash, hash, 32);
 	if (bignIdExtract(id_privkey, id_pubkey, params, der, count, 
@@ -393,6 +873,58 @@ bool_t bignTest()
 		id_pubkey, pubkey) == ERR_OK)
 		return FALSE;
 	id_pubkey[0] ^= 1;
+	// подготовленные состояния идентификационной ЭЦП
+	{
+		octet ctx[4096], priv[1024], state[sizeof(brng_state)];
+		octet id_sigs[3 * 48], id_hashes[3 * 32], hashes[3 * 32];
+		octet id_pubkeys[3 * 64];
+		void* pub;
+		size_t i, bad;
+		bool_t ok;
+		if (sizeof(ctx) < bignCtx_keep(128) ||
+			sizeof(priv) < bignIdPriv_keep() ||
+			bignCtxStart(ctx, params) != ERR_OK ||
+			bignIdPrivStart(priv, ctx, der, count, id_hash, id_privkey)
+				!= ERR_OK)
+			return FALSE;
+		memCopy(state, brng_state, sizeof(state));
+		if (bignIdSign(id_sig, params, der, count, id_hash, hash,
+				id_privkey, brngCTRXStepR, brng_state) != ERR_OK ||
+			bignIdSignPriv(id_sigs, priv, hash, brngCTRXStepR, state)
+				!= ERR_OK ||
+			!memEq(id_sig, id_sigs, 48))
+			return FALSE;
+		for (i = 0; i < 3; ++i)
+		{
+			memCopy(id_hashes + 32 * i, id_hash, 32);
+			memCopy(hashes + 32 * i, hash, 32);
+			memCopy(id_pubkeys + 64 * i, id_pubkey, 64);
+			if (bignIdSignPriv(id_sigs + 48 * i, priv, hash,
+					brngCTRXStepR, brng_state) != ERR_OK)
+				return FALSE;
+		}
+		memWipe(priv, sizeof(priv));
+		pub = blobCreate(bignIdPub_keep(128));
+		if (!pub)
+			return FALSE;
+		ok = bignIdPubStart(pub, ctx, der, count, pubkey) == ERR_OK &&
+			bignIdVerifyPub(pub, id_hash, hash, id_sig, id_pubkey)
+				== ERR_OK &&
+			bignIdVerifyBatch(&bad, pub, 3, id_hashes, hashes, id_sigs,
+				id_pubkeys) == ERR_OK && bad == 3;
+		id_sigs[48] ^= 1;
+		ok = ok &&
+			bignIdVerifyBatch(&bad, pub, 3, id_hashes, hashes, id_sigs,
+				id_pubkeys) == ERR_BAD_SIG && bad == 1;
+		id_sigs[48] ^= 1, id_pubkeys[128] ^= 1;
+		ok = ok &&
+			bignIdVerifyBatch(&bad, pub, 3, id_hashes, hashes, id_sigs,
+				id_pubkeys) != ERR_OK && bad == 2 &&
+			bignIdPubStart(pub, ctx, der, count, id_hash) == ERR_BAD_PUBKEY;
+		blobClose(pub);
+		if (!ok)
+			return FALSE;
+	}
 	// тест E.5
 	beltPBKDF2(key, (const octet*)pwd, strLen(pwd), iter, 
 		beltH() + 128 + 64, 8);
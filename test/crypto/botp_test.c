@@ -4,11 +4,12 @@
 \brief Tests for STB 34.101.47/botp
 \project bee2/test
 \created 2015.11.06
-\version 2023.03.29
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
+#include <bee2/core/err.h>
 
 #include <bee2/core/mem.h>
 #include <bee2/core/hex.h>
@@ -28,13 +29,26 @@
 bool_t botpTest()
 {
 	octet ctr[8];
+	octet ctr1[8];
+	size_t offset;
+	char otps[6][16];
+	const char* otpp[6];
+	const octet* keys[6];
+	size_t lens[6];
+	octet ctrs[6][8];
+	tm_time_t ts[6];
+	bool_t success[6];
+	size_t i;
 	char otp[16], otp1[16], otp2[16], otp3[16];
+	char codes[5 * 9];
 	const char suite[] = "OCRA-1:HOTP-HBELT-8:C-QN08-PHBELT-S064-T1M";
 	char q[32];
 	octet p[32];
 	char p_str[72];
 	char s_str[136];
 	tm_time_t t;
+	tm_time_t t1;
+	botp_ocra_suite_t ocra[1];
 	octet state[2048];
 	// подготовить память
 	if (sizeof(state) < utilMax(3,
@@ -66,6 +80,64 @@ bool_t botpTest()
 	if (!strEq(otp3, "26078636"))
 		return FALSE;
 	botpHOTPStepG(ctr, state);
+	// HOTP.window
+	memCopy(ctr1, beltH() + 192, 8);
+	botpHOTPStepS(state, ctr1);
+	if (botpHOTPStepW(&offset, otp3, 1, state) ||
+		!botpHOTPStepW(&offset, otp3, 5, state) || offset != 2)
+		return FALSE;
+	botpHOTPStepG(ctr1, state);
+	if (!memEq(ctr1, ctr, 8))
+		return FALSE;
+	memCopy(ctr1, beltH() + 192, 8);
+	if (botpHOTPVerifyWindow(&offset, otp2, beltH() + 128, 32, ctr1, 0) !=
+			ERR_BAD_PWD ||
+		botpHOTPVerifyWindow(&offset, otp2, beltH() + 128, 32, ctr1, 9) !=
+			ERR_OK || offset != 1 ||
+		botpHOTPVerifyWindow(0, otp3, beltH() + 128, 32, ctr1, 0) != ERR_OK ||
+		!memEq(ctr1, ctr, 8))
+		return FALSE;
+	// HOTP.batch
+	for (i = 0; i < 6; ++i)
+	{
+		keys[i] = beltH() + 16 * i, lens[i] = 24 + 8 * i;
+		memCopy(ctrs[i], beltH() + 192 + i, 8);
+		botpHOTPRand(otps[i], 6 + i % 3, keys[i], lens[i], ctrs[i]);
+		otpp[i] = otps[i];
+	}
+	otps[4][0] ^= 1, otps[5][8] = '0';
+	if (botpHOTPVerifyBatch(success, 6, otpp, keys, lens, ctrs) != ERR_OK ||
+		!success[0] || !success[1] || !success[2] || !success[3] ||
+		success[4] || success[5])
+		return FALSE;
+	for (i = 0; i < 4; ++i)
+	{
+		memCopy(ctr1, beltH() + 192 + i, 8);
+		botpCtrNext(ctr1);
+		if (!memEq(ctrs[i], ctr1, 8))
+			return FALSE;
+	}
+	if (!memEq(ctrs[4], beltH() + 196, 8))
+		return FALSE;
+	// HOTP.rand_batch
+	if (botpHOTPRandBatch(codes, 5, 8, beltH() + 128, 32, beltH() + 192) !=
+			ERR_OK ||
+		!strEq(codes, "21157984") ||
+		!strEq(codes + 9, "17877985") ||
+		!strEq(codes + 18, "26078636"))
+		return FALSE;
+	memCopy(ctr1, beltH() + 192, 8);
+	for (i = 0; i < 5; ++i)
+	{
+		botpHOTPRand(otp, 8, beltH() + 128, 32, ctr1);
+		if (!strEq(codes + 9 * i, otp))
+			return FALSE;
+		botpCtrNext(ctr1);
+	}
+	if (botpHOTPRandBatch(codes, 0, 8, beltH() + 128, 32, ctr1) != ERR_OK ||
+		botpHOTPRandBatch(codes, 1, 9, beltH() + 128, 32, ctr1) !=
+			ERR_BAD_PARAMS)
+		return FALSE;
 	// TOTP.1
 	t = 1449165288;
 	ASSERT(t != TIME_ERR);
@@ -79,6 +151,36 @@ bool_t botpTest()
 	if (!strEq(otp, "97660664") ||
 		botpTOTPVerify(otp, beltH() + 128, 32, t / 60) != ERR_OK)
 		return FALSE;
+	// TOTP.window
+	if (botpTOTPStepW(&t1, otp, t / 60 + 2, 1, state) ||
+		!botpTOTPStepW(&t1, otp, t / 60 + 2, 3, state) || t1 != t / 60 ||
+		!botpTOTPStepW(&t1, otp, t / 60 - 6, 6, state) || t1 != t / 60 ||
+		botpTOTPVerifyWindow(&t1, otp, beltH() + 128, 32, t / 60 - 1, 0) !=
+			ERR_BAD_PWD ||
+		botpTOTPVerifyWindow(&t1, otp, beltH() + 128, 32, t / 60 - 1, 1) !=
+			ERR_OK || t1 != t / 60)
+		return FALSE;
+	// TOTP.batch
+	for (i = 0; i < 5; ++i)
+	{
+		keys[i] = beltH() + 128 - 16 * i, lens[i] = 32 + 8 * i;
+		ts[i] = t / 60 + i;
+		botpTOTPRand(otps[i], 8 - i % 3, keys[i], lens[i], ts[i]);
+		otpp[i] = otps[i];
+	}
+	ts[3] = TIME_ERR;
+	if (botpTOTPVerifyBatch(success, 5, otpp, keys, lens, ts) != ERR_OK ||
+		!success[0] || !success[1] || !success[2] || success[3] ||
+		!success[4] || !strEq(otps[0], "97660664"))
+		return FALSE;
+	// TOTP.rand_batch
+	if (botpTOTPRandBatch(codes, 3, 8, beltH() + 128, 32, t / 60) != ERR_OK ||
+		!strEq(codes, "97660664") ||
+		!strEq(codes + 9, "94431522") ||
+		!strEq(codes + 18, "55973851") ||
+		botpTOTPRandBatch(codes, 1, 8, beltH() + 128, 32, TIME_ERR) !=
+			ERR_BAD_TIME)
+		return FALSE;
 	// TOTP.2
 	t /= 60, ++t, t *= 60;
 	botpTOTPStart(state, 8, beltH() + 128, 32);
@@ -127,6 +229,16 @@ bool_t botpTest()
 	if (botpOCRAVerify(otp, suite, beltH() + 128, 32, (const octet*)q, strLen(q), 
 		ctr, p, beltH(), t) != ERR_OK)
 		return FALSE;
+	// OCRA.suite
+	if (botpOCRASuiteParse(ocra, "OCRA-1:HOTP-HBELT-8:C-QN08-T1M-") ||
+		!botpOCRASuiteParse(ocra, suite) || ocra->digit != 8 ||
+		ocra->ctr_len != 8 || ocra->q_type != 'N' || ocra->q_max != 8 ||
+		ocra->p_len != 32 || ocra->s_len != 64 || ocra->ts != 60)
+		return FALSE;
+	botpOCRAStart2(state, ocra, beltH() + 128, 32);
+	botpOCRAStepS(state, ctr, p, beltH());
+	if (!botpOCRAStepV("85199085", (const octet*)q, strLen(q), t, state))
+		return FALSE;
 	// OCRA.2
 	strCopy(q, otp2);
 	strCopy(q + strLen(q), otp3);
@@ -4,12 +4,13 @@
 \brief Tests for STB 34.101.78 (bpki) helpers
 \project bee2/test
 \created 2021.04.13
-\version 2024.05.08
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include <bee2/core/err.h>
 #include <bee2/core/mem.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/str.h>
@@ -149,6 +150,129 @@ static bool_t bpkiContTest()
 	return TRUE;
 }
 
+static bool_t bpkiContMBTest()
+{
+	octet epkis[5 * 160];
+	octet epki[160];
+	octet pwd[] = { 'z', 'e', 'd' };
+	octet shares[5 * 17];
+	octet shares1[5 * 17];
+	const octet* ptrs[5];
+	size_t lens[5];
+	size_t epki_len, epki_len1;
+	size_t i;
+	// создать 5 контейнеров с личными ключами (l = 128)
+	if (bpkiPrivkeyWrapMB(0, &epki_len, 0, 32, 0, 0, 0, 10000, 5) !=
+			ERR_OK ||
+		epki_len > sizeof(epki) ||
+		bpkiPrivkeyWrapMB(epkis, &epki_len1, beltH(), 32,
+			pwd, sizeof(pwd), beltH() + 160, 10000, 5) != ERR_OK ||
+		epki_len1 != epki_len)
+		return FALSE;
+	// сравнить с последовательным созданием
+	for (i = 0; i < 5; ++i)
+		if (bpkiPrivkeyWrap(epki, 0, beltH() + 32 * i, 32,
+				pwd, sizeof(pwd), beltH() + 160 + 8 * i, 10000) != ERR_OK ||
+			!memEq(epki, epkis + epki_len * i, epki_len))
+			return FALSE;
+	// создать 5 контейнеров с частичными секретами (l = 128)
+	for (i = 0; i < 5; ++i)
+	{
+		memCopy(shares + 17 * i, beltH() + 17 * i, 17);
+		shares[17 * i] = (octet)(i + 1);
+	}
+	if (bpkiShareWrapMB(0, &epki_len, 0, 17, 0, 0, 0, 10000, 5) !=
+			ERR_OK ||
+		epki_len > sizeof(epki) ||
+		bpkiShareWrapMB(epkis, &epki_len1, shares, 17,
+			pwd, sizeof(pwd), beltH() + 160, 10000, 5) != ERR_OK ||
+		epki_len1 != epki_len)
+		return FALSE;
+	// сравнить с последовательным созданием
+	for (i = 0; i < 5; ++i)
+		if (bpkiShareWrap(epki, 0, shares + 17 * i, 17,
+				pwd, sizeof(pwd), beltH() + 160 + 8 * i, 10000) != ERR_OK ||
+			!memEq(epki, epkis + epki_len * i, epki_len))
+			return FALSE;
+	// разобрать контейнеры (последний -- с другим числом итераций)
+	for (i = 0; i < 4; ++i)
+		ptrs[i] = epkis + epki_len * i, lens[i] = epki_len;
+	if (bpkiShareWrap(epki, &lens[4], shares + 17 * 4, 17,
+			pwd, sizeof(pwd), beltH() + 160 + 32, 10001) != ERR_OK)
+		return FALSE;
+	ptrs[4] = epki;
+	if (bpkiShareUnwrapMB(shares1, 17, ptrs, lens, pwd, sizeof(pwd), 5) !=
+			ERR_OK ||
+		!memEq(shares, shares1, sizeof(shares)))
+		return FALSE;
+	// неверный пароль
+	if (bpkiShareUnwrapMB(shares1, 17, ptrs, lens, pwd, 2, 5) == ERR_OK ||
+		!memIsZero(shares1, sizeof(shares1)))
+		return FALSE;
+	// все нормально
+	return TRUE;
+}
+
+/*
+*******************************************************************************
+Кэш ключей защиты
+*******************************************************************************
+*/
+
+static bool_t bpkiKEKCacheTest()
+{
+	octet cache[1024];
+	octet epki[1024];
+	octet key[64];
+	octet pwd[] = { 'z', 'e', 'd' };
+	octet pwd1[] = { 'z', 'e', 'e' };
+	size_t epki_len;
+	size_t key_len;
+	bool_t ret;
+	// создать контейнер с личным ключом (l = 128)
+	if (bpkiPrivkeyWrap(0, &epki_len, beltH(), 32,
+			pwd, sizeof(pwd), beltH() + 32, 10001) != ERR_OK ||
+		epki_len > sizeof(epki) ||
+		bpkiPrivkeyWrap(epki, &epki_len, beltH(), 32,
+			pwd, sizeof(pwd), beltH() + 32, 10001) != ERR_OK)
+		return FALSE;
+	// создать кэш
+	if (sizeof(cache) < bpkiKEKCache_keep(4) ||
+		bpkiKEKCacheStart(cache, 0, 60) == ERR_OK ||
+		bpkiKEKCacheStart(cache, 4, 0) == ERR_OK ||
+		bpkiKEKCacheStart(cache, 4, 60) != ERR_OK)
+		return FALSE;
+	// неверный пароль не засоряет кэш, ключ защиты берется из кэша
+	ret = bpkiPrivkeyUnwrap2(key, &key_len, epki, epki_len,
+			pwd1, sizeof(pwd1), cache) != ERR_OK &&
+		bpkiPrivkeyUnwrap2(key, &key_len, epki, epki_len,
+			pwd, sizeof(pwd), cache) == ERR_OK &&
+		key_len == 32 && memEq(key, beltH(), 32) &&
+		bpkiPrivkeyUnwrap2(0, &key_len, epki, epki_len,
+			pwd, sizeof(pwd), cache) == ERR_OK &&
+		key_len == 32 &&
+		bpkiPrivkeyUnwrap2(key, &key_len, epki, epki_len,
+			pwd, sizeof(pwd), cache) == ERR_OK &&
+		key_len == 32 && memEq(key, beltH(), 32) &&
+		bpkiPrivkeyUnwrap2(key, &key_len, epki, epki_len,
+			pwd1, sizeof(pwd1), cache) != ERR_OK;
+	// контейнер с частичным секретом (l = 128)
+	if (ret)
+	{
+		memCopy(key + 1, beltH(), 16), key[0] = 1;
+		ret = bpkiShareWrap(epki, &epki_len, key, 17,
+				pwd, sizeof(pwd), beltH() + 64, 10003) == ERR_OK &&
+			bpkiShareUnwrap2(key, &key_len, epki, epki_len,
+				pwd, sizeof(pwd), cache) == ERR_OK &&
+			bpkiShareUnwrap2(key, &key_len, epki, epki_len,
+				pwd, sizeof(pwd), cache) == ERR_OK &&
+			key_len == 17 && memEq(key + 1, beltH(), 16) && key[0] == 1;
+	}
+	// закрыть кэш
+	bpkiKEKCacheClose(cache);
+	return ret;
+}
+
 /*
 *******************************************************************************
 Запрос на выпуск сертификата
@@ -177,6 +301,12 @@ static bool_t bpkiContTest()
 static bool_t bpkiCSRTest()
 {
 	octet csr[382];
+	octet csr0[382];
+	octet csr1[382];
+	octet pubkeys[4 * 64];
+	err_t codes[4];
+	const octet* csrs[4];
+	size_t csr_lens[4];
 	octet privkey[32];
 	octet pubkey[64];
 	size_t pubkey_len;
@@ -218,6 +348,7 @@ static bool_t bpkiCSRTest()
 		"1F66B5B84B7339674533F0329C74F218"
 		"34281FED0732429E0C79235FC273E269");
 	// перевыпустить запрос
+	memCopy(csr0, csr, sizeof(csr));
 	if (bpkiCSRRewrap(csr, sizeof(csr), privkey, 32) != ERR_OK)
 		return FALSE;
 	// повторно разобрать запрос
@@ -228,6 +359,25 @@ static bool_t bpkiCSRTest()
 			"7AC6A60361E8C8173491686D461B2826"
 			"190C2EDA5909054A9AB84D2AB9D99A90"))
 		return FALSE;
+	// пакетный разбор: корректные запросы, испорченная подпись, усечение
+	memCopy(csr1, csr, sizeof(csr));
+	csr1[sizeof(csr1) - 1] ^= 1;
+	csrs[0] = csr0, csr_lens[0] = sizeof(csr0);
+	csrs[1] = csr1, csr_lens[1] = sizeof(csr1);
+	csrs[2] = csr, csr_lens[2] = sizeof(csr) - 1;
+	csrs[3] = csr, csr_lens[3] = sizeof(csr);
+	if (bpkiCSRUnwrapBatch(codes, pubkeys, csrs, csr_lens, 4) !=
+			ERR_BAD_SIG ||
+		codes[0] != ERR_OK || codes[1] != ERR_BAD_SIG ||
+		codes[2] != ERR_BAD_FORMAT || codes[3] != ERR_OK ||
+		!memEq(pubkeys + 192, pubkey, 64) ||
+		!memIsZero(pubkeys + 64, 128) ||
+		bpkiCSRUnwrap(pubkey, 0, csr0, sizeof(csr0)) != ERR_OK ||
+		!memEq(pubkeys, pubkey, 64))
+		return FALSE;
+	if (bpkiCSRUnwrapBatch(codes, 0, csrs + 3, csr_lens + 3, 1) != ERR_OK ||
+		codes[0] != ERR_OK)
+		return FALSE;
 	// все нормально
 	return TRUE;
 }
@@ -240,5 +390,6 @@ static bool_t bpkiCSRTest()
 
 bool_t bpkiTest()
 {
-	return bpkiContTest() && bpkiCSRTest();
+	return bpkiContTest() && bpkiContMBTest() && bpkiKEKCacheTest() &&
+		bpkiCSRTest();
 }
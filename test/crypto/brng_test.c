@@ -4,7 +4,7 @@
 \brief Tests for STB 34.101.47 (brng)
 \project bee2/test
 \created 2013.04.01
-\version 2023.03.29
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -37,6 +37,7 @@ bool_t brngTest()
 	octet iv[128];
 	octet iv1[32];
 	octet state[1024];
+	size_t i;
 	// подготовить память
 	if (sizeof(state) < brngCTR_keep() ||
 		sizeof(state) < brngHMAC_keep())
@@ -95,6 +96,21 @@ bool_t brngTest()
 	brngHMACRand(buf1, 96, beltH() + 128, 32, beltH() + 128 + 64, 32);
 	if (!memEq(buf, buf1, 96)) 
 		return FALSE;
+	// дополнительный тест: четверки блоков (дорожки) и отдельные блоки
+	brngHMACStart(state, beltH() + 128, 32, beltH() + 128 + 64, 32);
+	brngHMACStepR(buf1, 256, state);
+	brngHMACStart(state, beltH() + 128, 32, beltH() + 128 + 64, 32);
+	for (i = 0; i < 256; i += 32)
+		brngHMACStepR(buf + i, 32, state);
+	if (!memEq(buf, buf1, 256) ||
+		!hexEq(buf, 
+		"AF907A0E470A3A1B268ECCCCC0B90F23"
+		"9FE94A2DC6E014179FC789CB3C3887E4"
+		"695C6B96B84948F8D76924E22260859D"
+		"B9B5FE757BEDA2E17103EE44655A9FEF"
+		"648077CCC5002E0561C6EF512C513B8C"
+		"24B4F3A157221CFBC1597E969778C1E4"))
+		return FALSE;
 	// дополнительный тест: короткие ключ, синхропосылка и выходной блок
 	brngHMACStart(state, beltH() + 128, 1, beltH() + 128 + 64, 1);
 	brngHMACStepR(buf, 2, state);
@@ -4,7 +4,7 @@
 \brief Tests for STB 34.101.79 (btok)
 \project bee2/test
 \created 2022.07.07
-\version 2023.12.19
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -13,6 +13,7 @@
 #include <bee2/core/err.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
 #include <bee2/core/prng.h>
 #include <bee2/core/str.h>
 #include <bee2/core/util.h>
@@ -123,6 +124,15 @@ static bool_t btokCVCTest()
 	size_t cert2_len, cert2_len1;
 	octet cert3[400];
 	size_t cert3_len, cert3_len1;
+	btok_cvc_t cvcs[2];
+	octet certs[800];
+	size_t lens[2];
+	mt_pool_t* pool;
+	err_t code;
+	octet store[8192];
+	btok_cvc_view_t view[1];
+	char name[13];
+	size_t i;
 	// запустить ГПСЧ
 	prngEchoStart(echo, beltH(), 256);
 	// определить максимальную длину сертификата
@@ -260,6 +270,88 @@ static bool_t btokCVCTest()
 		btokCVCVal2(cvc2, cert2, cert2_len, cvc1, cvc0->until) == ERR_OK ||
 		btokCVCVal2(cvc3, cert3, cert3_len, cvc1, 0) != ERR_OK)
 		return FALSE;
+	// выпустить cert2 и cert3 пакетом
+	memCopy(cvcs, cvc2, sizeof(btok_cvc_t));
+	memCopy(cvcs + 1, cvc3, sizeof(btok_cvc_t));
+	if (btokCVCIssBatch(0, lens, 2, cvcs, cert1, cert1_len,
+			privkey1, 48 + 1, 0) == ERR_OK ||
+		btokCVCIssBatch(0, lens, 2, cvcs, cert1, cert1_len,
+			privkey1, 48, 0) != ERR_OK ||
+		lens[0] != cert2_len || lens[1] != cert3_len ||
+		lens[0] + lens[1] > sizeof(certs) ||
+		btokCVCIssBatch(certs, lens, 2, cvcs, cert1, cert1_len,
+			privkey1, 48, 0) != ERR_OK ||
+		btokCVCVal(certs, lens[0], cert1, cert1_len, 0) != ERR_OK ||
+		btokCVCVal(certs + lens[0], lens[1], cert1, cert1_len, 0) != ERR_OK)
+		return FALSE;
+	if (!(pool = mtPoolCreate(2, 0, 0)))
+		return FALSE;
+	memSetZero(certs, sizeof(certs));
+	code = btokCVCIssBatch(certs, lens, 2, cvcs, cert1, cert1_len,
+		privkey1, 48, pool);
+	mtPoolClose(pool);
+	if (code != ERR_OK ||
+		btokCVCVal(certs, lens[0], cert1, cert1_len, 0) != ERR_OK ||
+		btokCVCVal(certs + lens[0], lens[1], cert1, cert1_len, 0) != ERR_OK)
+		return FALSE;
+	// построить представления
+	if (btokCVCView(view, cert2, cert2_len - 1) == ERR_OK ||
+		btokCVCView(view, cert2, cert2_len) != ERR_OK ||
+		view->pubkey_len != cvc2->pubkey_len ||
+		!memEq(cert2 + view->pubkey, cvc2->pubkey, view->pubkey_len) ||
+		!memEq(cert2 + view->from, cvc2->from, 6) ||
+		!memEq(cert2 + view->until, cvc2->until, 6) ||
+		!view->hat_eid ||
+		!memEq(cert2 + view->hat_eid, cvc2->hat_eid, 5) ||
+		!view->hat_esign ||
+		!memEq(cert2 + view->hat_esign, cvc2->hat_esign, 2) ||
+		view->sig_len != 72 ||
+		!btokCVCViewIsHolder(view, cert2, cvc2->holder) ||
+		btokCVCViewIsHolder(view, cert2, cvc2->authority) ||
+		btokCVCViewVerify(view, cert2, cvc1->pubkey, 96) != ERR_OK ||
+		btokCVCViewVerify(view, cert2, cvc2->pubkey, 64) == ERR_OK)
+		return FALSE;
+	btokCVCViewAuthority(name, view, cert2);
+	if (!strEq(name, cvc2->authority))
+		return FALSE;
+	btokCVCViewHolder(name, view, cert2);
+	if (!strEq(name, cvc2->holder))
+		return FALSE;
+	cert2[view->sig] ^= 1;
+	code = btokCVCViewVerify(view, cert2, cvc1->pubkey, 96);
+	cert2[view->sig] ^= 1;
+	if (code == ERR_OK ||
+		btokCVCView(view, cert3, cert3_len) != ERR_OK ||
+		view->hat_eid || view->hat_esign || view->sig_len != 72 ||
+		view->pubkey_len != 48 ||
+		btokCVCViewVerify(view, cert3, cvc1->pubkey, 96) != ERR_OK)
+		return FALSE;
+	// проверить сертификаты по хранилищу
+	if (sizeof(store) < btokCVCStore_keep(2, 4) ||
+		btokCVCStoreStart(store, 2, 4) != ERR_OK ||
+		btokCVCStoreVal(0, store, cert1, cert1_len, 0) != ERR_BAD_ANCHOR ||
+		btokCVCStoreAdd(store, cert0, cert0_len) != ERR_OK ||
+		btokCVCStoreAdd(store, cert0, cert0_len) != ERR_BAD_ANCHOR ||
+		btokCVCStoreVal(cvc1, store, cert1, cert1_len, 0) != ERR_OK ||
+		btokCVCStoreVal(0, store, cert2, cert2_len, 0) != ERR_BAD_ANCHOR ||
+		btokCVCStoreAdd2(store, cvc1) != ERR_OK ||
+		btokCVCStoreAdd2(store, cvc2) != ERR_OUTOFMEMORY)
+		return FALSE;
+	for (i = 0; i < 2; ++i)
+		if (btokCVCStoreVal(cvc2, store, cert2, cert2_len, 0) != ERR_OK ||
+			btokCVCStoreVal(0, store, cert2, cert2_len, cvc2->from) != 
+				ERR_OK ||
+			btokCVCStoreVal(0, store, cert3, cert3_len, 0) != ERR_OK ||
+			btokCVCStoreVal(cvc3, store, cert3, cert3_len, cvc3->until) !=
+				ERR_OK)
+			return FALSE;
+	cert2[cert2_len - 1] ^= 1;
+	if (btokCVCStoreVal(0, store, cert2, cert2_len, 0) == ERR_OK)
+		return FALSE;
+	cert2[cert2_len - 1] ^= 1;
+	if (btokCVCStoreVal(0, store, cert2, cert2_len, cvc0->until) == ERR_OK ||
+		btokCVCStoreVal(0, store, cert2, cert2_len, 0) != ERR_OK)
+		return FALSE;
 	// все хорошо
 	return TRUE;
 }
@@ -280,6 +372,8 @@ static bool_t btokSMTest()
 	apdu_resp_t* resp = (apdu_resp_t*)(stack + 2 * 1024);
 	apdu_resp_t* resp1 = (apdu_resp_t*)(stack + 3 * 1024);
 	octet apdu[1024];
+	octet apdu1[1024];
+	apdu_cmd_view_t view[1];
 	size_t count, count1;
 	size_t size, size1;
 	// подготовить состояния
@@ -377,6 +471,14 @@ static bool_t btokSMTest()
 				btokSMCmdWrap(apdu, &count1, cmd, state_t) != ERR_OK ||
 				count1 != count)
 				return FALSE;
+			apdu1[0] = cmd->cla, apdu1[1] = cmd->ins;
+			apdu1[2] = cmd->p1, apdu1[3] = cmd->p2;
+			memCopy(apdu1 + btokSMCmdCDFOffset(cmd->cdf_len, cmd->rdf_len),
+				cmd->cdf, cmd->cdf_len);
+			if (btokSMCmdWrap2(apdu1, &count1, apdu1, cmd->cdf_len,
+					cmd->rdf_len, state_t) != ERR_OK ||
+				count1 != count || !memEq(apdu1, apdu, count))
+				return FALSE;
 			btokSMCtrInc(state_ct);
 			if (btokSMCmdUnwrap(0, &size, apdu, count, state_ct) != ERR_OK ||
 				size > sizeof(stack) / 4 ||
@@ -384,6 +486,19 @@ static bool_t btokSMTest()
 					!= ERR_OK ||
 				size1 != size || !memEq(cmd, cmd1, size))
 				return FALSE;
+			memCopy(apdu1, apdu, count);
+			if (btokSMCmdUnwrap2(view, apdu1, count, state_ct) != ERR_OK ||
+				view->cla != cmd->cla || view->ins != cmd->ins ||
+				view->p1 != cmd->p1 || view->p2 != cmd->p2 ||
+				view->cdf_len != cmd->cdf_len ||
+				view->rdf_len != cmd->rdf_len ||
+				!memEq(view->cdf, cmd->cdf, cmd->cdf_len))
+				return FALSE;
+			memCopy(apdu1, apdu, count);
+			apdu1[count - 2] ^= 1;
+			if (btokSMCmdUnwrap2(view, apdu1, count, state_ct) !=
+					ERR_BAD_MAC)
+				return FALSE;
 			resp->rdf_len = cmd->rdf_len;
 			btokSMCtrInc(state_ct);
 			if (btokSMRespWrap(0, &count, resp, state_ct) != ERR_OK ||
@@ -391,6 +506,15 @@ static bool_t btokSMTest()
 				btokSMRespWrap(apdu, &count1, resp, state_ct) != ERR_OK ||
 				count1 != count)
 				return FALSE;
+			memCopy(apdu1 + btokSMRespRDFOffset(resp->rdf_len), resp->rdf,
+				resp->rdf_len);
+			if (btokSMRespWrap2(0, &count1, resp->rdf_len, resp->sw1,
+					resp->sw2, state_ct) != ERR_OK ||
+				count1 != count ||
+				btokSMRespWrap2(apdu1, &count1, resp->rdf_len, resp->sw1,
+					resp->sw2, state_ct) != ERR_OK ||
+				count1 != count || !memEq(apdu1, apdu, count))
+				return FALSE;
 			btokSMCtrInc(state_t);
 			if (btokSMRespUnwrap(0, &size, apdu, count, state_t) != ERR_OK ||
 				size > sizeof(stack) / 4 ||
@@ -398,6 +522,16 @@ static bool_t btokSMTest()
 					!= ERR_OK ||
 				size1 != size || !memEq(resp, resp1, size))
 				return FALSE;
+			memCopy(apdu1, apdu, count);
+			if (btokSMRespUnwrap2(&size, &size1, apdu1, count, state_t) !=
+					ERR_OK ||
+				size1 != resp->rdf_len ||
+				!memEq(apdu1 + size, resp->rdf, size1))
+				return FALSE;
+			apdu[count - 3] ^= 1;
+			if (btokSMRespUnwrap2(&size, &size1, apdu, count, state_t) !=
+					ERR_BAD_MAC)
+				return FALSE;
 		}
 	// все хорошо
 	return TRUE;
@@ -465,14 +599,17 @@ static bool_t btokBAUTHTest()
 	octet keyb[32];
 	octet statea[20000];
 	octet stateb[20000];
+	octet ctxa[4096];
 	octet buf[1000];
+	size_t i;
 	// загрузить долговременные параметры
 	if (bignParamsStd(params, "1.2.112.0.2.0.34.101.45.3.1") != ERR_OK)
 		return FALSE;
 	// подготовить память
 	if (sizeof(echoa) < prngEcho_keep() ||
 		sizeof(statea) < btokBAuthT_keep(128) ||
-		sizeof(stateb) < btokBAuthCT_keep(128))
+		sizeof(stateb) < btokBAuthCT_keep(128) ||
+		sizeof(ctxa) < btokBAuthTCtx_keep(128))
 		return FALSE;
 	// загрузить личные ключи
 	hexTo(da, _da);
@@ -547,6 +684,31 @@ static bool_t btokBAUTHTest()
 		btokBAuthTStepG(keya, statea) != ERR_OK ||
 		!memEq(keya, keyb, 32))
 		return FALSE;
+	// контекст терминала
+	if (btokBAuthTCtxStart(ctxa, params, da, certa) != ERR_OK)
+		return FALSE;
+	// несколько сеансов с контекстом, с аутентификацией КТ
+	settingsa->kcb = settingsb->kcb = TRUE;
+	prngEchoStart(echoa, beltH(), 128);
+	prngEchoStart(echob, beltH() + 128, 128);
+	for (i = 0; i < 2; ++i)
+	{
+		memSetZero(statea, sizeof(statea));
+		memSetZero(keya, sizeof(keya));
+		if (btokBAuthTStart2(statea, ctxa, settingsa) != ERR_OK ||
+			btokBAuthCTStart(stateb, params, settingsb, db, certb) != ERR_OK)
+			return FALSE;
+		if (btokBAuthCTStep2(buf, certa, stateb) != ERR_OK ||
+			btokBAuthTStep3(buf, buf, statea) != ERR_OK ||
+			btokBAuthCTStep4(buf, buf, stateb) != ERR_OK ||
+			btokBAuthTStep5(buf, 8 + 32 + certb->len,
+				bakeTestCertVal, statea) != ERR_OK)
+			return FALSE;
+		if (btokBAuthCTStepG(keyb, stateb) != ERR_OK ||
+			btokBAuthTStepG(keya, statea) != ERR_OK ||
+			!memEq(keya, keyb, 32))
+			return FALSE;
+	}
 	// все нормально
 	return TRUE;
 }
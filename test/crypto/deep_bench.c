@@ -0,0 +1,190 @@
+/*
+*******************************************************************************
+\file deep_bench.c
+\brief Actual versus declared stack depth of the top-level functions
+\project bee2/test
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include <stdio.h>
+#include <bee2/core/mem.h>
+#include <bee2/core/prng.h>
+#include <bee2/core/stack.h>
+#include <bee2/core/str.h>
+#include <bee2/core/util.h>
+#include <bee2/crypto/bels.h>
+#include <bee2/crypto/bign.h>
+#include <bee2/crypto/bign96.h>
+#include <bee2/crypto/dstu.h>
+#include <bee2/crypto/g12s.h>
+#include "../bench.h"
+
+/*
+*******************************************************************************
+Глубина стека
+
+Для основных функций сообщается фактическая глубина контролируемого стека
+в сравнении с объявленной (см. stackProfReset()): печатается
+"used / declared (percent%)" для стека максимальной фактической глубины,
+а если функция создала несколько стеков -- еще и их число.
+Профилирование возможно, только если библиотека собрана с директивой
+BEE2_INSTRUMENT. Функция считается выполненной, если она вернула ERR_OK.
+*******************************************************************************
+*/
+
+static bool_t deepBenchNote(const char* name, size_t l, err_t code)
+{
+	stack_prof_t p[1];
+	char label[48];
+	char value[64];
+	stackProfGet(p);
+	if (code != ERR_OK)
+		return FALSE;
+	sprintf(label, "%s[%u]", name, (unsigned)l);
+	if (p->count == 0)
+		sprintf(value, "-");
+	else
+		sprintf(value, "%u / %u (%u%%)", (unsigned)p->max_used,
+			(unsigned)p->max_decl,
+			(unsigned)(100 * p->max_used / MAX2(p->max_decl, 1)));
+	if (p->count > 1)
+		sprintf(value + strLen(value), ", %u stacks", (unsigned)p->count);
+	benchNote("deepBench", label, value);
+	return TRUE;
+}
+
+#define deepBenchRun(name, l, call)\
+	(stackProfReset(), deepBenchNote(name, l, call))
+
+static bool_t deepBenchBign(const char* curve, octet* combo_state)
+{
+	bign_params params[1];
+	octet oid_der[16];
+	size_t oid_len = sizeof(oid_der);
+	octet privkey[64];
+	octet pubkey[128];
+	octet hash[64];
+	octet sig[96];
+	octet key[32];
+	octet token[32 + 16 + 64];
+	size_t l;
+	if (bignParamsStd(params, curve) != ERR_OK ||
+		bignOidToDER(oid_der, &oid_len, "1.2.112.0.2.0.34.101.31.81") !=
+			ERR_OK)
+		return FALSE;
+	l = params->l;
+	prngCOMBOStepR(hash, l / 4, combo_state);
+	prngCOMBOStepR(key, 32, combo_state);
+	return deepBenchRun("bignKeypairGen", l, bignKeypairGen(privkey, pubkey,
+			params, prngCOMBOStepR, combo_state)) &&
+		deepBenchRun("bignPubkeyVal", l, bignPubkeyVal(params, pubkey)) &&
+		deepBenchRun("bignSign", l, bignSign(sig, params, oid_der, oid_len,
+			hash, privkey, prngCOMBOStepR, combo_state)) &&
+		deepBenchRun("bignSign2", l, bignSign2(sig, params, oid_der, oid_len,
+			hash, privkey, 0, 0)) &&
+		deepBenchRun("bignVerify", l, bignVerify(params, oid_der, oid_len,
+			hash, sig, pubkey)) &&
+		deepBenchRun("bignKeyWrap", l, bignKeyWrap(token, params, key, 32,
+			0, pubkey, prngCOMBOStepR, combo_state)) &&
+		deepBenchRun("bignKeyUnwrap", l, bignKeyUnwrap(key, params, token,
+			32 + 16 + l / 4, 0, privkey));
+}
+
+static bool_t deepBenchBign96(octet* combo_state)
+{
+	bign_params params[1];
+	octet oid_der[16];
+	size_t oid_len = sizeof(oid_der);
+	octet privkey[24];
+	octet pubkey[48];
+	octet hash[24];
+	octet sig[34];
+	if (bign96ParamsStd(params, "1.2.112.0.2.0.34.101.45.3.0") != ERR_OK ||
+		bignOidToDER(oid_der, &oid_len, "1.2.112.0.2.0.34.101.31.81") !=
+			ERR_OK)
+		return FALSE;
+	prngCOMBOStepR(hash, 24, combo_state);
+	return deepBenchRun("bign96KeypairGen", 96, bign96KeypairGen(privkey,
+			pubkey, params, prngCOMBOStepR, combo_state)) &&
+		deepBenchRun("bign96Sign", 96, bign96Sign(sig, params, oid_der,
+			oid_len, hash, privkey, prngCOMBOStepR, combo_state)) &&
+		deepBenchRun("bign96Verify", 96, bign96Verify(params, oid_der,
+			oid_len, hash, sig, pubkey));
+}
+
+static bool_t deepBenchDstu(const char* curve, size_t l, octet* combo_state)
+{
+	dstu_params params[1];
+	octet privkey[64];
+	octet pubkey[128];
+	octet hash[32];
+	octet sig[128];
+	size_t ld;
+	if (dstuParamsStd(params, curve) != ERR_OK ||
+		dstuPointGen(params->P, params, prngCOMBOStepR, combo_state) !=
+			ERR_OK)
+		return FALSE;
+	ld = (2 * l + 31) / 16 * 16;
+	prngCOMBOStepR(hash, 32, combo_state);
+	return deepBenchRun("dstuKeypairGen", l, dstuKeypairGen(privkey, pubkey,
+			params, prngCOMBOStepR, combo_state)) &&
+		deepBenchRun("dstuSign", l, dstuSign(sig, params, ld, hash, 32,
+			privkey, prngCOMBOStepR, combo_state)) &&
+		deepBenchRun("dstuVerify", l, dstuVerify(params, ld, hash, 32, sig,
+			pubkey));
+}
+
+static bool_t deepBenchG12s(const char* curve, octet* combo_state)
+{
+	g12s_params params[1];
+	octet privkey[64];
+	octet pubkey[128];
+	octet hash[64];
+	octet sig[128];
+	if (g12sParamsStd(params, curve) != ERR_OK)
+		return FALSE;
+	prngCOMBOStepR(hash, params->l / 8, combo_state);
+	return deepBenchRun("g12sKeypairGen", params->l, g12sKeypairGen(privkey,
+			pubkey, params, prngCOMBOStepR, combo_state)) &&
+		deepBenchRun("g12sSign", params->l, g12sSign(sig, params, hash,
+			privkey, prngCOMBOStepR, combo_state)) &&
+		deepBenchRun("g12sVerify", params->l, g12sVerify(params, hash, sig,
+			pubkey));
+}
+
+static bool_t deepBenchBels(size_t len, octet* combo_state)
+{
+	octet s[32];
+	octet si[5 * 33];
+	prngCOMBOStepR(s, len, combo_state);
+	return deepBenchRun("belsShare2", 8 * len, belsShare2(si, 5, 3, len, s,
+			prngCOMBOStepR, combo_state)) &&
+		deepBenchRun("belsRecover2", 8 * len, belsRecover2(s, 3, len, si));
+}
+
+bool_t deepBench()
+{
+	octet combo_state[64];
+	if (!stackProfIsEnabled())
+	{
+		benchNote("deepBench", "profile", "disabled (BEE2_INSTRUMENT)");
+		return TRUE;
+	}
+	if (sizeof(combo_state) < prngCOMBO_keep())
+		return FALSE;
+	prngCOMBOStart(combo_state, utilNonce32());
+	return deepBenchBign("1.2.112.0.2.0.34.101.45.3.1", combo_state) &&
+		deepBenchBign("1.2.112.0.2.0.34.101.45.3.2", combo_state) &&
+		deepBenchBign("1.2.112.0.2.0.34.101.45.3.3", combo_state) &&
+		deepBenchBign96(combo_state) &&
+		deepBenchDstu("1.2.804.2.1.1.1.1.3.1.1.1.2.5", 233, combo_state) &&
+		deepBenchDstu("1.2.804.2.1.1.1.1.3.1.1.1.2.9", 431, combo_state) &&
+		deepBenchG12s("1.2.643.2.2.35.1", combo_state) &&
+		deepBenchG12s("1.2.643.7.1.2.1.2.1", combo_state) &&
+		deepBenchBels(16, combo_state) &&
+		deepBenchBels(32, combo_state);
+}
@@ -4,12 +4,14 @@
 \brief Tests for DSTU 4145-2002 (Ukraine)
 \project bee2/test
 \created 2012.03.01
-\version 2024.02.29
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include <bee2/core/blob.h>
+#include <bee2/core/err.h>
 #include <bee2/core/mem.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/prng.h>
@@ -37,6 +39,66 @@ COMBO-генератор
 *******************************************************************************
 */
 
+static bool_t dstuTestBatchRun(const dstu_params* params, size_t count,
+	octet pts[], octet pts1[], octet xpts[], err_t codes[], void* state)
+{
+	const size_t m = params->p[0];
+	const size_t no = O_OF_B(m);
+	octet pt[2 * DSTU_SIZE];
+	size_t i;
+	// сжатие
+	for (i = 0; i < count; ++i)
+		if (dstuPointGen(pts + 2 * no * i, params, combo_rng, 
+				state) != ERR_OK)
+			return FALSE;
+	memSet(pts + 2 * no * 5, 0xFF, no);
+	if (dstuPointCompressBatch(xpts, codes, params, count, pts) != 
+			ERR_BAD_POINT ||
+		codes[5] != ERR_BAD_POINT)
+		return FALSE;
+	for (i = 0; i < count; ++i)
+		if (i != 5 && (codes[i] != ERR_OK ||
+			dstuPointCompress(pt, params, pts + 2 * no * i) != ERR_OK ||
+			!memEq(pt, xpts + no * i, no)))
+			return FALSE;
+	// восстановление (без таблицы полуследов и с таблицей)
+	memSetZero(xpts + no * 5, no);
+	if (dstuPointRecoverBatch(pts1, codes, params, 7, xpts) != ERR_OK ||
+		!memEq(pts1 + 2 * no * 6, pts + 2 * no * 6, 2 * no) ||
+		dstuPointRecoverBatch(pts1, 0, params, count, xpts) != ERR_OK ||
+		!memEq(pts1, pts, 2 * no * 5) ||
+		!memEq(pts1 + 2 * no * 6, pts + 2 * no * 6, 2 * no * (count - 6)))
+		return FALSE;
+	// восстановление случайных (в том числе некорректных) точек
+	combo_rng(xpts, no * count, state);
+	for (i = 0; i < count; ++i)
+		if (m % 8)
+			xpts[no * i + no - 1] &= (octet)((1 << m % 8) - 1);
+	if (dstuPointRecoverBatch(pts1, codes, params, count, xpts) != 
+			ERR_BAD_POINT)
+		return FALSE;
+	for (i = 0; i < count; ++i)
+		if ((dstuPointRecover(pt, params, xpts + no * i) == ERR_OK) !=
+				(codes[i] == ERR_OK) ||
+			codes[i] == ERR_OK && !memEq(pt, pts1 + 2 * no * i, 2 * no))
+			return FALSE;
+	return TRUE;
+}
+
+static bool_t dstuTestBatch(const dstu_params* params, void* state)
+{
+	const size_t no = O_OF_B(params->p[0]);
+	const size_t count = 256;
+	octet* buf;
+	bool_t ret;
+	if (!(buf = (octet*)blobCreate(count * (5 * no + sizeof(err_t)))))
+		return FALSE;
+	ret = dstuTestBatchRun(params, count, buf, buf + 2 * no * count,
+		buf + 4 * no * count, (err_t*)(buf + 5 * no * count), state);
+	blobClose(buf);
+	return ret;
+}
+
 bool_t dstuTest()
 {
 	dstu_params params[1];
@@ -47,6 +109,7 @@ bool_t dstuTest()
 	octet sig[2 * DSTU_SIZE];
 	size_t ld;
 	octet state[512];
+	void* ctx;
 	// подготовить память
 	if (sizeof(state) < prngEcho_keep() ||
 		sizeof(state) < prngCOMBO_keep())
@@ -94,6 +157,25 @@ bool_t dstuTest()
 	sig[0] ^= 1;
 	if (dstuVerify(params, ld, hash, 21, sig, pubkey) == ERR_OK)
 		return FALSE;
+	// тест Б.1 [контекст]
+	if (!(ctx = blobCreate(dstuCtx_keep(163))))
+		return FALSE;
+	prngEchoStart(state, buf, memNonZeroSize(params->n, O_OF_B(163)));
+	if (dstuCtxStart(ctx, params) != ERR_OK ||
+		dstuSignCtx(sig, ctx, ld, hash, 21, privkey, prngEchoStepR, 
+			state) != ERR_OK ||
+		!hexEqRev(sig, 
+			"000000000000000000000002100D8695"
+			"7331832B8E8C230F5BD6A332B3615ACA"
+			"00000000000000000000000274EA2C0C"
+			"AA014A0D80A424F59ADE7A93068D08A7") ||
+		dstuVerifyCtx(ctx, ld, hash, 21, sig, pubkey) != ERR_OK ||
+		(sig[0] ^= 1, dstuVerifyCtx(ctx, ld, hash, 21, sig, pubkey) == ERR_OK))
+	{
+		blobClose(ctx);
+		return FALSE;
+	}
+	blobClose(ctx);
 	// создать генератор COMBO
 	prngCOMBOStart(state, utilNonce32());
 	// максимальная длина ЭЦП
@@ -250,6 +332,9 @@ bool_t dstuTest()
 		dstuVerify(params, ld, hash, 32, sig, pubkey) != ERR_OK ||
 		(sig[0] ^= 1, dstuVerify(params, ld, hash, 32, sig, pubkey) == ERR_OK))
 		return FALSE;
+	// пакетные сжатие и восстановление
+	if (!dstuTestBatch(params, state))
+		return FALSE;
 	// все нормально
 	return TRUE;
 }
@@ -4,12 +4,13 @@
 \brief Tests for GOST R 34.10-2012 (Russia)
 \project bee2/test
 \created 2014.04.07
-\version 2023.09.22
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include <bee2/core/blob.h>
 #include <bee2/core/mem.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/prng.h>
@@ -34,6 +35,7 @@ bool_t g12sTest()
 	octet hash[64];
 	octet sig[2 * G12S_ORDER_SIZE];
 	octet echo[64];
+	void* ctx;
 	// подготовить память
 	if (sizeof(echo) < prngEcho_keep() ||
 		sizeof(echo) < prngCOMBO_keep())
@@ -131,6 +133,29 @@ bool_t g12sTest()
 	if (g12sVerify(params, hash, sig, pubkey) != ERR_OK ||
 		(sig[0] ^= 1, g12sVerify(params, hash, sig, pubkey) == ERR_OK))
 		return FALSE;
+	// тест A.2 [контекст]
+	if (!(ctx = blobCreate(g12sCtx_keep(params->l))))
+		return FALSE;
+	prngEchoStart(echo, buf, 64);
+	if (g12sCtxStart(ctx, params) != ERR_OK ||
+		g12sSignCtx(sig, ctx, hash, privkey, prngEchoStepR, echo) 
+			!= ERR_OK ||
+		!hexEq(sig, 
+			"2F86FA60A081091A23DD795E1E3C689E"
+			"E512A3C82EE0DCC2643C78EEA8FCACD3"
+			"5492558486B20F1C9EC197C906998502"
+			"60C93BCBCD9C5C3317E19344E173AE36"
+			"1081B394696FFE8E6585E7A9362D26B6"
+			"325F56778AADBC081C0BFBE933D52FF5"
+			"823CE288E8C4F362526080DF7F70CE40"
+			"6A6EEB1F56919CB92A9853BDE73E5B4A") ||
+		g12sVerifyCtx(ctx, hash, sig, pubkey) != ERR_OK ||
+		(sig[0] ^= 1, g12sVerifyCtx(ctx, hash, sig, pubkey) == ERR_OK))
+	{
+		blobClose(ctx);
+		return FALSE;
+	}
+	blobClose(ctx);
 	// проверить кривую cryptoproA
 	if (g12sParamsStd(params, "1.2.643.2.2.35.1") != ERR_OK ||
 		g12sParamsVal(params) != ERR_OK)
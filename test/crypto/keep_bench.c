@@ -0,0 +1,78 @@
+/*
+*******************************************************************************
+\file keep_bench.c
+\brief Memory footprint of the top-level functions
+\project bee2/test
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include <stdio.h>
+#include <bee2/core/blob.h>
+#include <bee2/core/util.h>
+#include <bee2/crypto/bake.h>
+#include <bee2/crypto/bign.h>
+#include <bee2/crypto/dstu.h>
+#include <bee2/crypto/g12s.h>
+#include "../bench.h"
+
+/*
+*******************************************************************************
+Объем памяти
+
+Сообщаются длины контекстов, рабочей памяти и состояний (в октетах),
+которые определяются функциями xxx_keep() для основных протоколов.
+Длины зависят от директивы BEE2_LOW_MEMORY (профиль low-memory).
+*******************************************************************************
+*/
+
+static void keepBenchNote(const char* name, size_t l, size_t keep)
+{
+	char label[32];
+	char value[32];
+	sprintf(label, "%s[%u]", name, (unsigned)l);
+	sprintf(value, "%u", (unsigned)keep);
+	benchNote("keepBench", label, value);
+}
+
+static bool_t keepBenchBign(const char* curve)
+{
+	bign_params params[1];
+	void* ctx;
+	if (bignParamsStd(params, curve) != ERR_OK)
+		return FALSE;
+	ctx = blobCreate(bignCtx_keep(params->l));
+	if (!ctx)
+		return FALSE;
+	if (bignCtxStart(ctx, params) != ERR_OK)
+	{
+		blobClose(ctx);
+		return FALSE;
+	}
+	keepBenchNote("bignCtx", params->l, bignCtx_keep(params->l));
+	keepBenchNote("bignWs", params->l, bignWs_keep(ctx));
+	keepBenchNote("bakeBMQV", params->l, bakeBMQV_keep(params->l));
+	keepBenchNote("bakeBSTS", params->l, bakeBSTS_keep(params->l));
+	keepBenchNote("bakeBPACE", params->l, bakeBPACE_keep(params->l));
+	blobClose(ctx);
+	return TRUE;
+}
+
+bool_t keepBench()
+{
+#ifdef BEE2_LOW_MEMORY
+	benchNote("keepBench", "profile", "low-memory");
+#else
+	benchNote("keepBench", "profile", "default");
+#endif
+	if (!keepBenchBign("1.2.112.0.2.0.34.101.45.3.1") ||
+		!keepBenchBign("1.2.112.0.2.0.34.101.45.3.2") ||
+		!keepBenchBign("1.2.112.0.2.0.34.101.45.3.3"))
+		return FALSE;
+	keepBenchNote("dstuCtx", 431, dstuCtx_keep(431));
+	keepBenchNote("g12sCtx", 512, g12sCtx_keep(512));
+	return TRUE;
+}
@@ -0,0 +1,290 @@
+/*
+*******************************************************************************
+\file mt_bench.c
+\brief Multithreaded scaling benchmarks
+\project bee2/test
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include <stdio.h>
+#include <bee2/core/blob.h>
+#include <bee2/core/err.h>
+#include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
+#include <bee2/core/rng.h>
+#include <bee2/core/tm.h>
+#include <bee2/core/util.h>
+#include <bee2/crypto/bake.h>
+#include <bee2/crypto/belt.h>
+#include <bee2/crypto/bign.h>
+#include "../bench.h"
+
+/*
+*******************************************************************************
+Масштабирование
+
+Операция выполняется одновременно в t потоках, t = 1, 2, 4,..., mtCPUs()
+(последнее значение добавляется, если не является степенью 2). Каждый
+поток выполняет iters операций над собственными буферами, iters
+подбирается так, чтобы в одном потоке операции длились не меньше
+1 / MT_BENCH_FRAC секунды. Время измеряется от запуска первого потока до
+завершения последнего.
+
+Для каждого t печатается суммарное число операций в секунду и
+эффективность масштабирования -- отношение этого числа к t-кратному
+числу операций в секунду при t = 1. Эффективность ниже 100% указывает
+на конкуренцию потоков: за глобальный генератор (rngStepR()), за пулы
+блобов (blobCreate()), на ложное разделение кэш-линий.
+
+Подписи и протокол BMQV используют генератор rngStepR(), общий для всех
+потоков. Операции потоков начинаются после синхронного старта:
+потоки ожидают установки флага _go.
+*******************************************************************************
+*/
+
+#define MT_BENCH_FRAC 20
+#define MT_BENCH_THREADS_MAX 64
+
+typedef struct
+{
+	const bign_params* params;	/*< долговременные параметры */
+	const octet* oid_der;		/*< идентификатор хэш-алгоритма */
+	size_t oid_len;				/*< длина oid_der */
+	const octet* privkey;		/*< личный ключ стороны A */
+	const octet* pubkey;		/*< открытый ключ стороны A */
+	const octet* privkeyb;		/*< личный ключ стороны B */
+	const bake_cert* certa;		/*< сертификат стороны A */
+	const bake_cert* certb;		/*< сертификат стороны B */
+} mt_bench_data;
+
+typedef bool_t (*mt_bench_i)(void* ws, const mt_bench_data* data);
+
+typedef struct
+{
+	mt_thrd_t thrd[1];			/*< поток */
+	mt_bench_i op;				/*< операция */
+	const mt_bench_data* data;	/*< общие данные */
+	size_t iters;				/*< число операций */
+	bool_t ok;					/*< признак успеха */
+} mt_bench_thrd;
+
+static volatile bool_t _go;
+
+/*
+*******************************************************************************
+Операции
+
+Рабочая память ws одной операции состоит из MT_BENCH_WS_SIZE октетов.
+*******************************************************************************
+*/
+
+#define MT_BENCH_WS_SIZE (2 * 32768)
+
+static bool_t mtBenchSign(void* ws, const mt_bench_data* d)
+{
+	octet* hash = (octet*)ws;
+	octet* sig = hash + 32;
+	memSet(hash, 0x5C, 32);
+	return bignSign(sig, d->params, d->oid_der, d->oid_len, hash,
+		d->privkey, rngStepR, 0) == ERR_OK;
+}
+
+static bool_t mtBenchVerify(void* ws, const mt_bench_data* d)
+{
+	octet* hash = (octet*)ws;
+	octet* sig = hash + 32;
+	return bignVerify(d->params, d->oid_der, d->oid_len, hash, sig,
+		d->pubkey) == ERR_OK;
+}
+
+static bool_t mtBenchBMQV(void* ws, const mt_bench_data* d)
+{
+	bake_settings settings[1];
+	octet* statea = (octet*)ws;
+	octet* stateb = statea + MT_BENCH_WS_SIZE / 2 - 1024;
+	octet* buf = stateb + MT_BENCH_WS_SIZE / 2 - 1024;
+	octet keya[32];
+	octet keyb[32];
+	ASSERT(bakeBMQV_keep(128) <= MT_BENCH_WS_SIZE / 2 - 1024);
+	memSetZero(settings, sizeof(bake_settings));
+	settings->kca = settings->kcb = TRUE;
+	settings->rng = rngStepR;
+	return bakeBMQVStart(statea, d->params, settings, d->privkey,
+			d->certa) == ERR_OK &&
+		bakeBMQVStart(stateb, d->params, settings, d->privkeyb,
+			d->certb) == ERR_OK &&
+		bakeBMQVStep2(buf, stateb) == ERR_OK &&
+		bakeBMQVStep3(buf, buf, d->certb, statea) == ERR_OK &&
+		bakeBMQVStep4(buf, buf, d->certa, stateb) == ERR_OK &&
+		bakeBMQVStep5(buf, statea) == ERR_OK &&
+		bakeBMQVStepG(keya, statea) == ERR_OK &&
+		bakeBMQVStepG(keyb, stateb) == ERR_OK &&
+		memEq(keya, keyb, 32);
+}
+
+static bool_t mtBenchRng(void* ws, const mt_bench_data* d)
+{
+	rngStepR(ws, 32, 0);
+	return TRUE;
+}
+
+static bool_t mtBenchCHE(void* ws, const mt_bench_data* d)
+{
+	octet* state = (octet*)ws;
+	octet* buf = state + beltCHE_keep();
+	octet mac[8];
+	ASSERT(beltCHE_keep() + 1024 <= MT_BENCH_WS_SIZE);
+	beltCHEStart(state, beltH(), 32, beltH() + 32);
+	beltCHEStepE(buf, 1024, state);
+	beltCHEStepA(buf, 1024, state);
+	beltCHEStepG(mac, state);
+	return TRUE;
+}
+
+/*
+*******************************************************************************
+Потоки
+*******************************************************************************
+*/
+
+static void mtBenchThrdMain(void* arg)
+{
+	mt_bench_thrd* t = (mt_bench_thrd*)arg;
+	void* ws;
+	size_t i;
+	t->ok = FALSE;
+	ws = blobCreate(MT_BENCH_WS_SIZE);
+	if (!ws)
+		return;
+	// первая операция готовит данные (например, подпись для проверки)
+	if (!mtBenchSign(ws, t->data))
+	{
+		blobClose(ws);
+		return;
+	}
+	while (!_go)
+		mtThrdYield();
+	for (t->ok = TRUE, i = 0; t->ok && i < t->iters; ++i)
+		t->ok = t->op(ws, t->data);
+	blobClose(ws);
+}
+
+static tm_ticks_t mtBenchRunT(mt_bench_thrd thrds[], size_t count,
+	mt_bench_i op, const mt_bench_data* data, size_t iters)
+{
+	tm_ticks_t ticks;
+	size_t i;
+	bool_t ok = TRUE;
+	_go = FALSE;
+	for (i = 0; i < count; ++i)
+	{
+		thrds[i].op = op, thrds[i].data = data, thrds[i].iters = iters;
+		if (!mtThrdCreate(thrds[i].thrd, mtBenchThrdMain, thrds + i))
+			break;
+	}
+	ok = i == count;
+	ticks = tmTicks();
+	_go = TRUE;
+	while (i--)
+		mtThrdJoin(thrds[i].thrd), ok = ok && thrds[i].ok;
+	ticks = tmTicks() - ticks;
+	return ok ? MAX2(ticks, 1) : 0;
+}
+
+static bool_t mtBenchRun(const char* name, mt_bench_i op,
+	const mt_bench_data* data)
+{
+	mt_bench_thrd thrds[MT_BENCH_THREADS_MAX];
+	size_t cpus, count, iters;
+	tm_ticks_t ticks;
+	double rate1 = 0, rate;
+	char label[48];
+	char value[64];
+	if (!benchIsSelected("mtBench", name))
+		return TRUE;
+	cpus = MIN2(mtCPUs(), MT_BENCH_THREADS_MAX);
+	// калибровка
+	for (iters = 1;; iters *= 2)
+	{
+		if (!(ticks = mtBenchRunT(thrds, 1, op, data, iters)))
+			return FALSE;
+		if (ticks >= tmFreq() / MT_BENCH_FRAC || iters >= (1u << 20))
+			break;
+	}
+	// замеры
+	for (count = 1; count <= cpus; count = count < cpus ?
+		MIN2(2 * count, cpus) : cpus + 1)
+	{
+		if (!(ticks = mtBenchRunT(thrds, count, op, data, iters)))
+			return FALSE;
+		rate = (double)tmFreq() * count * iters / ticks;
+		if (count == 1)
+			rate1 = rate;
+		sprintf(label, "%s[t=%u]", name, (unsigned)count);
+		sprintf(value, "%.0f ops/sec (efficiency %.0f%%)", rate,
+			100 * rate / (rate1 * count));
+		benchNote("mtBench", label, value);
+	}
+	return TRUE;
+}
+
+/*
+*******************************************************************************
+Замеры
+*******************************************************************************
+*/
+
+static err_t mtBenchCertVal(octet* pubkey, const bign_params* params,
+	const octet* data, size_t len)
+{
+	if (len != params->l / 2)
+		return ERR_BAD_CERT;
+	if (pubkey)
+		memCopy(pubkey, data, len);
+	return ERR_OK;
+}
+
+bool_t mtBench()
+{
+	bign_params params[1];
+	octet oid_der[16];
+	octet privkey[32];
+	octet pubkey[64];
+	octet privkeyb[32];
+	octet pubkeyb[64];
+	bake_cert certa[1];
+	bake_cert certb[1];
+	mt_bench_data data[1];
+	bool_t ok;
+	// подготовить данные
+	data->oid_len = sizeof(oid_der);
+	if (rngCreate(0, 0) != ERR_OK)
+		return FALSE;
+	if (bignParamsStd(params, "1.2.112.0.2.0.34.101.45.3.1") != ERR_OK ||
+		bignOidToDER(oid_der, &data->oid_len, "1.2.112.0.2.0.34.101.31.81") !=
+			ERR_OK ||
+		bignKeypairGen(privkey, pubkey, params, rngStepR, 0) != ERR_OK ||
+		bignKeypairGen(privkeyb, pubkeyb, params, rngStepR, 0) != ERR_OK)
+	{
+		rngClose();
+		return FALSE;
+	}
+	certa->data = pubkey, certa->len = 64, certa->val = mtBenchCertVal;
+	certb->data = pubkeyb, certb->len = 64, certb->val = mtBenchCertVal;
+	data->params = params, data->oid_der = oid_der;
+	data->privkey = privkey, data->pubkey = pubkey;
+	data->privkeyb = privkeyb;
+	data->certa = certa, data->certb = certb;
+	// замеры
+	ok = mtBenchRun("bignSign", mtBenchSign, data) &&
+		mtBenchRun("bignVerify", mtBenchVerify, data) &&
+		mtBenchRun("bakeBMQV", mtBenchBMQV, data) &&
+		mtBenchRun("rngStepR[32]", mtBenchRng, data) &&
+		mtBenchRun("beltCHE[1024]", mtBenchCHE, data);
+	rngClose();
+	return ok;
+}
@@ -4,12 +4,14 @@
 \brief Tests for Draft of RD_RB (pfok)
 \project bee2/test
 \created 2014.07.08
-\version 2024.02.29
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include <bee2/core/blob.h>
+#include <bee2/core/err.h>
 #include <bee2/core/mem.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/prng.h>
@@ -84,6 +86,30 @@ bool_t pfokTestParamsTest()
 		params1->n != params->n ||
 		!memEq(params1->p, params->p, sizeof(params->p)))
 		return FALSE;
+	// пошаговая генерация с сохранением состояния
+	{
+		octet state[1024];
+		octet ckpt[1024];
+		size_t steps = 0;
+		err_t code;
+		if (sizeof(state) < pfokParamsGen_keep(seed->l) ||
+			pfokParamsGenStart(state, seed) != ERR_OK)
+			return FALSE;
+		do
+		{
+			memCopy(ckpt, state, sizeof(state));
+			memSet(state, 0xAA, sizeof(state));
+			memCopy(state, ckpt, pfokParamsGen_keep(seed->l));
+			code = pfokParamsGenStep(params, state, 1, 1 + steps % 3,
+				_on_q_silent);
+		}
+		while (code == ERR_NOT_READY && ++steps < 100);
+		if (code != ERR_OK || steps < 2 ||
+			!memEq(params, params1, sizeof(pfok_params)) ||
+			pfokParamsGenStep(params, state, 0, 0, 0) != ERR_OK ||
+			!memEq(params, params1, sizeof(pfok_params)))
+			return FALSE;
+	}
 	// все нормально
 	return TRUE;
 }
@@ -129,6 +155,7 @@ bool_t pfokTest()
 	octet vb[O_OF_B(638)];
 	octet yb[O_OF_B(638)];
 	octet key[32];
+	void* ctx;
 	// подготовить память
 	if (sizeof(combo_state) < prngCOMBO_keep())
 		return FALSE;
@@ -169,6 +196,20 @@ bool_t pfokTest()
 		pfokPubkeyCalc(yb, params, ua) != ERR_OK ||
 		!memEq(vb, yb, O_OF_B(params->l)))
 		return FALSE;
+	// сгенерировать ключи с контекстом
+	if (!(ctx = blobCreate(pfokCtx_keep(params->l))))
+		return FALSE;
+	if (pfokCtxStart(ctx, params) != ERR_OK ||
+		pfokKeypairGenCtx(ua, vb, ctx, prngCOMBOStepR, combo_state) 
+			!= ERR_OK ||
+		pfokPubkeyCalc(yb, params, ua) != ERR_OK ||
+		!memEq(vb, yb, O_OF_B(params->l)) ||
+		pfokPubkeyCalcCtx(yb, ctx, ua) != ERR_OK ||
+		!memEq(vb, yb, O_OF_B(params->l)))
+	{
+		blobClose(ctx);
+		return FALSE;
+	}
 	// тест PFOK.ANON.1
 	hexToRev(ua, 
 		"01"
@@ -181,10 +222,17 @@ bool_t pfokTest()
 		"0A2E637AD35E31EB5F034D889B666701");
 	if (pfokPubkeyVal(params, vb) != ERR_OK ||
 		pfokDH(key, params, ua, vb) != ERR_OK ||
+		!hexEqRev(key, 
+			"777BB35E950D3080C1E896BE4172DBD0" 
+			"61423D3BFEF78F15E3F7A7F2FF7A242B") ||
+		pfokDHCtx(key, ctx, ua, vb) != ERR_OK ||
 		!hexEqRev(key, 
 			"777BB35E950D3080C1E896BE4172DBD0" 
 			"61423D3BFEF78F15E3F7A7F2FF7A242B"))
+	{
+		blobClose(ctx);
 		return FALSE;
+	}
 	// тест PFOK.ANON.2
 	hexToRev(ua, 
 		"00"
@@ -200,7 +248,10 @@ bool_t pfokTest()
 		!hexEqRev(key, 
 			"46FA834B28D5E5D4183E28646AFFE806"
 			"803E4C865CB99B1C423B0F1C78DE758D"))
+	{
+		blobClose(ctx);
 		return FALSE;
+	}
 	// тест PFOK.AUTH.1
 	hexToRev(xa, 
 		"00"
@@ -223,10 +274,18 @@ bool_t pfokTest()
 	if (pfokPubkeyVal(params, yb) != ERR_OK ||
 		pfokPubkeyVal(params, vb) != ERR_OK ||
 		pfokMTI(key, params, xa, ua, yb, vb) != ERR_OK ||
+		!hexEqRev(key, 
+			"EA92D5BCEC18BB44514E096748DB3E21"
+			"D6E7B9C97D604699BEA7D3B96C87E18B") ||
+		pfokMTICtx(key, ctx, xa, ua, yb, vb) != ERR_OK ||
 		!hexEqRev(key, 
 			"EA92D5BCEC18BB44514E096748DB3E21"
 			"D6E7B9C97D604699BEA7D3B96C87E18B"))
+	{
+		blobClose(ctx);
 		return FALSE;
+	}
+	blobClose(ctx);
 	// тест PFOK.AUTH.2
 	hexToRev(xa, 
 		"00"
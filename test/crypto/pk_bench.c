@@ -0,0 +1,527 @@
+/*
+*******************************************************************************
+\file pk_bench.c
+\brief Benchmarks for public-key schemes
+\project bee2/test
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include <stdio.h>
+#include <bee2/core/blob.h>
+#include <bee2/core/err.h>
+#include <bee2/core/mem.h>
+#include <bee2/core/prng.h>
+#include <bee2/core/util.h>
+#include <bee2/crypto/bake.h>
+#include <bee2/crypto/bign.h>
+#include <bee2/crypto/bign96.h>
+#include <bee2/crypto/btok.h>
+#include <bee2/crypto/dstu.h>
+#include <bee2/crypto/g12s.h>
+#include <bee2/crypto/pfok.h>
+#include "../bench.h"
+
+/*
+*******************************************************************************
+Схемы с открытым ключом
+
+Для каждого стандартного набора параметров измеряется число операций
+в секунду: выработка ключей, ЭЦП, проверка ЭЦП, построение общего ключа,
+транспорт ключа, протоколы bake и BAUTH (полное выполнение обеими
+сторонами). Все замеры входят в группу pkBench и печатаются в едином
+отчете (в том числе в формате JSON, см. benchInit()). Названия замеров
+имеют вид op[set], где set -- уровень стойкости или имя набора
+параметров.
+
+Замеры выполняются над контекстом pk_bench_ctx, в котором размещаются
+ключи, подписи и состояния протоколов. Перед замером операция выполняется
+однократно, и ее результат проверяется. Если операция завершилась
+с ошибкой, то замер не выполняется, а pkBench() возвращает FALSE.
+
+Протокол BAUTH измеряется только для уровня 128: при l = 192, 256
+сторона T хэширует 16 октетов Rt, а сторона CT -- l / 8 октетов,
+и протокол завершается с ошибкой ERR_AUTH.
+
+В качестве генератора случайных чисел используется prngCOMBO.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	const void* params;		/*< долговременные параметры */
+	size_t l;				/*< уровень стойкости (битовая длина) */
+	octet oid_der[16];		/*< идентификатор хэш-алгоритма */
+	size_t oid_len;			/*< длина oid_der */
+	octet privkey[256];		/*< личный ключ стороны A */
+	octet pubkey[512];		/*< открытый ключ стороны A */
+	octet privkeyb[256];	/*< личный ключ стороны B */
+	octet pubkeyb[512];		/*< открытый ключ стороны B */
+	octet id_privkey[64];	/*< личный ключ bign-ibs */
+	octet id_pubkey[128];	/*< открытый ключ bign-ibs */
+	octet hash[64];			/*< хэш-значение */
+	octet sig[256];			/*< подпись */
+	octet token[128];		/*< токен ключа */
+	octet key[256];			/*< ключ */
+	bake_cert certa[1];		/*< сертификат стороны A */
+	bake_cert certb[1];		/*< сертификат стороны B */
+	octet* statea;			/*< состояние стороны A */
+	octet* stateb;			/*< состояние стороны B */
+	octet buf[1024];		/*< сообщения протоколов */
+	octet combo_state[64];	/*< состояние prngCOMBO */
+	bool_t ok;				/*< признак успеха */
+} pk_bench_ctx;
+
+#define PK_BENCH_STATE_SIZE 32768
+
+static err_t pkBenchCertVal(octet* pubkey, const bign_params* params,
+	const octet* data, size_t len)
+{
+	if (len != params->l / 2)
+		return ERR_BAD_CERT;
+	if (pubkey)
+		memCopy(pubkey, data, len);
+	return ERR_OK;
+}
+
+static void pkBenchCheck(pk_bench_ctx* c, err_t code)
+{
+	if (code != ERR_OK)
+		c->ok = FALSE;
+}
+
+static bool_t pkBenchRun(const char* name, const char* set,
+	bench_op_i op, pk_bench_ctx* c)
+{
+	char label[64];
+	sprintf(label, "%s[%s]", name, set);
+	if (!benchIsSelected("pkBench", label))
+		return TRUE;
+	c->ok = TRUE;
+	op(c);
+	if (!c->ok)
+		return FALSE;
+	benchRun("pkBench", label, 0, op, c);
+	return c->ok;
+}
+
+/*
+*******************************************************************************
+bign
+*******************************************************************************
+*/
+
+static void pkBenchBignKeypairGen(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, bignKeypairGen(c->privkey, c->pubkey, c->params,
+		prngCOMBOStepR, c->combo_state));
+}
+
+static void pkBenchBignSign(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, bignSign(c->sig, c->params, c->oid_der, c->oid_len,
+		c->hash, c->privkey, prngCOMBOStepR, c->combo_state));
+}
+
+static void pkBenchBignSign2(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, bignSign2(c->sig, c->params, c->oid_der, c->oid_len,
+		c->hash, c->privkey, 0, 0));
+}
+
+static void pkBenchBignVerify(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, bignVerify(c->params, c->oid_der, c->oid_len, c->hash,
+		c->sig, c->pubkey));
+}
+
+static void pkBenchBignDH(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, bignDH(c->key, c->params, c->privkey, c->pubkeyb, 32));
+}
+
+static void pkBenchBignKeyWrap(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, bignKeyWrap(c->token, c->params, c->key, 32, 0,
+		c->pubkey, prngCOMBOStepR, c->combo_state));
+}
+
+static void pkBenchBignKeyUnwrap(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, bignKeyUnwrap(c->key, c->params, c->token,
+		32 + 16 + c->l / 4, 0, c->privkey));
+}
+
+static void pkBenchBignIdSign(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, bignIdSign(c->sig, c->params, c->oid_der, c->oid_len,
+		c->hash, c->hash, c->id_privkey, prngCOMBOStepR, c->combo_state));
+}
+
+static void pkBenchBignIdVerify(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, bignIdVerify(c->params, c->oid_der, c->oid_len,
+		c->hash, c->hash, c->sig, c->id_pubkey, c->pubkey));
+}
+
+/*
+*******************************************************************************
+bake и BAUTH
+*******************************************************************************
+*/
+
+static void pkBenchSettings(bake_settings* settings, pk_bench_ctx* c)
+{
+	memSetZero(settings, sizeof(bake_settings));
+	settings->kca = settings->kcb = TRUE;
+	settings->rng = prngCOMBOStepR;
+	settings->rng_state = c->combo_state;
+}
+
+static void pkBenchBakeBMQV(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	bake_settings settings[1];
+	octet keyb[32];
+	pkBenchSettings(settings, c);
+	pkBenchCheck(c, bakeBMQVStart(c->statea, c->params, settings,
+		c->privkey, c->certa));
+	pkBenchCheck(c, bakeBMQVStart(c->stateb, c->params, settings,
+		c->privkeyb, c->certb));
+	pkBenchCheck(c, bakeBMQVStep2(c->buf, c->stateb));
+	pkBenchCheck(c, bakeBMQVStep3(c->buf, c->buf, c->certb, c->statea));
+	pkBenchCheck(c, bakeBMQVStep4(c->buf, c->buf, c->certa, c->stateb));
+	pkBenchCheck(c, bakeBMQVStep5(c->buf, c->statea));
+	pkBenchCheck(c, bakeBMQVStepG(c->key, c->statea));
+	pkBenchCheck(c, bakeBMQVStepG(keyb, c->stateb));
+	if (!memEq(c->key, keyb, 32))
+		c->ok = FALSE;
+}
+
+static void pkBenchBakeBSTS(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	bake_settings settings[1];
+	octet keyb[32];
+	pkBenchSettings(settings, c);
+	pkBenchCheck(c, bakeBSTSStart(c->statea, c->params, settings,
+		c->privkey, c->certa));
+	pkBenchCheck(c, bakeBSTSStart(c->stateb, c->params, settings,
+		c->privkeyb, c->certb));
+	pkBenchCheck(c, bakeBSTSStep2(c->buf, c->stateb));
+	pkBenchCheck(c, bakeBSTSStep3(c->buf, c->buf, c->statea));
+	pkBenchCheck(c, bakeBSTSStep4(c->buf, c->buf,
+		c->l / 2 + c->l / 4 + c->certa->len + 8, pkBenchCertVal, c->stateb));
+	pkBenchCheck(c, bakeBSTSStep5(c->buf, c->l / 4 + c->certb->len + 8,
+		pkBenchCertVal, c->statea));
+	pkBenchCheck(c, bakeBSTSStepG(c->key, c->statea));
+	pkBenchCheck(c, bakeBSTSStepG(keyb, c->stateb));
+	if (!memEq(c->key, keyb, 32))
+		c->ok = FALSE;
+}
+
+static void pkBenchBakeBPACE(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	bake_settings settings[1];
+	octet keyb[32];
+	pkBenchSettings(settings, c);
+	pkBenchCheck(c, bakeBPACEStart(c->statea, c->params, settings,
+		(const octet*)"8086", 4));
+	pkBenchCheck(c, bakeBPACEStart(c->stateb, c->params, settings,
+		(const octet*)"8086", 4));
+	pkBenchCheck(c, bakeBPACEStep2(c->buf, c->stateb));
+	pkBenchCheck(c, bakeBPACEStep3(c->buf + 512, c->buf, c->statea));
+	pkBenchCheck(c, bakeBPACEStep4(c->buf, c->buf + 512, c->stateb));
+	pkBenchCheck(c, bakeBPACEStep5(c->buf + 512, c->buf, c->statea));
+	pkBenchCheck(c, bakeBPACEStep6(c->buf + 512, c->stateb));
+	pkBenchCheck(c, bakeBPACEStepG(c->key, c->statea));
+	pkBenchCheck(c, bakeBPACEStepG(keyb, c->stateb));
+	if (!memEq(c->key, keyb, 32))
+		c->ok = FALSE;
+}
+
+static void pkBenchBtokBAuth(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	bake_settings settings[1];
+	octet keyb[32];
+	pkBenchSettings(settings, c);
+	pkBenchCheck(c, btokBAuthTStart(c->statea, c->params, settings,
+		c->privkey, c->certa));
+	pkBenchCheck(c, btokBAuthCTStart(c->stateb, c->params, settings,
+		c->privkeyb, c->certb));
+	pkBenchCheck(c, btokBAuthCTStep2(c->buf, c->certa, c->stateb));
+	pkBenchCheck(c, btokBAuthTStep3(c->buf, c->buf, c->statea));
+	pkBenchCheck(c, btokBAuthCTStep4(c->buf, c->buf, c->stateb));
+	pkBenchCheck(c, btokBAuthTStep5(c->buf, c->l / 4 + c->certb->len + 8,
+		pkBenchCertVal, c->statea));
+	pkBenchCheck(c, btokBAuthCTStepG(keyb, c->stateb));
+	pkBenchCheck(c, btokBAuthTStepG(c->key, c->statea));
+	if (!memEq(c->key, keyb, 32))
+		c->ok = FALSE;
+}
+
+static bool_t pkBenchBign(const char* curve, pk_bench_ctx* c)
+{
+	bign_params params[1];
+	char set[8];
+	c->oid_len = sizeof(c->oid_der);
+	if (bignParamsStd(params, curve) != ERR_OK ||
+		bignOidToDER(c->oid_der, &c->oid_len, "1.2.112.0.2.0.34.101.31.81") !=
+			ERR_OK)
+		return FALSE;
+	c->params = params, c->l = params->l;
+	sprintf(set, "%u", (unsigned)params->l);
+	prngCOMBOStepR(c->hash, c->l / 4, c->combo_state);
+	prngCOMBOStepR(c->key, 32, c->combo_state);
+	// ключи сторон
+	if (bignKeypairGen(c->privkey, c->pubkey, params, prngCOMBOStepR,
+			c->combo_state) != ERR_OK ||
+		bignKeypairGen(c->privkeyb, c->pubkeyb, params, prngCOMBOStepR,
+			c->combo_state) != ERR_OK)
+		return FALSE;
+	c->certa->data = c->pubkey, c->certa->len = c->l / 2;
+	c->certb->data = c->pubkeyb, c->certb->len = c->l / 2;
+	c->certa->val = c->certb->val = pkBenchCertVal;
+	// замеры
+	if (!pkBenchRun("bignKeypairGen", set, pkBenchBignKeypairGen, c) ||
+		!pkBenchRun("bignSign", set, pkBenchBignSign, c) ||
+		!pkBenchRun("bignSign2", set, pkBenchBignSign2, c) ||
+		bignSign2(c->sig, params, c->oid_der, c->oid_len, c->hash,
+			c->privkey, 0, 0) != ERR_OK ||
+		!pkBenchRun("bignVerify", set, pkBenchBignVerify, c) ||
+		!pkBenchRun("bignDH", set, pkBenchBignDH, c))
+		return FALSE;
+	// транспорт ключа
+	if (!pkBenchRun("bignKeyWrap", set, pkBenchBignKeyWrap, c) ||
+		bignKeyWrap(c->token, params, c->key, 32, 0, c->pubkey,
+			prngCOMBOStepR, c->combo_state) != ERR_OK ||
+		!pkBenchRun("bignKeyUnwrap", set, pkBenchBignKeyUnwrap, c))
+		return FALSE;
+	// bign-ibs: идентификатор с хэш-значением hash заверен на privkey
+	if (bignIdExtract(c->id_privkey, c->id_pubkey, params, c->oid_der,
+			c->oid_len, c->hash, c->sig, c->pubkey) != ERR_OK ||
+		!pkBenchRun("bignIdSign", set, pkBenchBignIdSign, c) ||
+		bignIdSign2(c->sig, params, c->oid_der, c->oid_len, c->hash,
+			c->hash, c->id_privkey, 0, 0) != ERR_OK ||
+		!pkBenchRun("bignIdVerify", set, pkBenchBignIdVerify, c))
+		return FALSE;
+	// протоколы (BAUTH проверяется только для l == 128)
+	return pkBenchRun("bakeBMQV", set, pkBenchBakeBMQV, c) &&
+		pkBenchRun("bakeBSTS", set, pkBenchBakeBSTS, c) &&
+		pkBenchRun("bakeBPACE", set, pkBenchBakeBPACE, c) &&
+		(c->l != 128 || pkBenchRun("btokBAuth", set, pkBenchBtokBAuth, c));
+}
+
+/*
+*******************************************************************************
+bign96
+*******************************************************************************
+*/
+
+static void pkBenchBign96Sign(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, bign96Sign(c->sig, c->params, c->oid_der, c->oid_len,
+		c->hash, c->privkey, prngCOMBOStepR, c->combo_state));
+}
+
+static void pkBenchBign96Verify(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, bign96Verify(c->params, c->oid_der, c->oid_len,
+		c->hash, c->sig, c->pubkey));
+}
+
+static bool_t pkBenchBign96(pk_bench_ctx* c)
+{
+	bign_params params[1];
+	c->oid_len = sizeof(c->oid_der);
+	if (bign96ParamsStd(params, "1.2.112.0.2.0.34.101.45.3.0") != ERR_OK ||
+		bignOidToDER(c->oid_der, &c->oid_len, "1.2.112.0.2.0.34.101.31.81") !=
+			ERR_OK ||
+		bign96KeypairGen(c->privkey, c->pubkey, params, prngCOMBOStepR,
+			c->combo_state) != ERR_OK)
+		return FALSE;
+	c->params = params, c->l = 96;
+	prngCOMBOStepR(c->hash, 24, c->combo_state);
+	return pkBenchRun("bign96Sign", "96", pkBenchBign96Sign, c) &&
+		bign96Sign(c->sig, params, c->oid_der, c->oid_len, c->hash,
+			c->privkey, prngCOMBOStepR, c->combo_state) == ERR_OK &&
+		pkBenchRun("bign96Verify", "96", pkBenchBign96Verify, c);
+}
+
+/*
+*******************************************************************************
+dstu
+
+Длина подписи ld -- минимальное кратное 16, не меньшее 2 * m + 16,
+где m -- степень расширения поля.
+*******************************************************************************
+*/
+
+static void pkBenchDstuSign(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, dstuSign(c->sig, c->params, (2 * c->l + 31) / 16 * 16,
+		c->hash, 32, c->privkey, prngCOMBOStepR, c->combo_state));
+}
+
+static void pkBenchDstuVerify(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, dstuVerify(c->params, (2 * c->l + 31) / 16 * 16,
+		c->hash, 32, c->sig, c->pubkey));
+}
+
+static bool_t pkBenchDstu(const char* curve, pk_bench_ctx* c)
+{
+	dstu_params params[1];
+	char set[8];
+	if (dstuParamsStd(params, curve) != ERR_OK ||
+		dstuPointGen(params->P, params, prngCOMBOStepR, c->combo_state) !=
+			ERR_OK ||
+		dstuKeypairGen(c->privkey, c->pubkey, params, prngCOMBOStepR,
+			c->combo_state) != ERR_OK)
+		return FALSE;
+	c->params = params, c->l = params->p[0];
+	sprintf(set, "%u", (unsigned)params->p[0]);
+	prngCOMBOStepR(c->hash, 32, c->combo_state);
+	return pkBenchRun("dstuSign", set, pkBenchDstuSign, c) &&
+		dstuSign(c->sig, params, (2 * c->l + 31) / 16 * 16, c->hash, 32,
+			c->privkey, prngCOMBOStepR, c->combo_state) == ERR_OK &&
+		pkBenchRun("dstuVerify", set, pkBenchDstuVerify, c);
+}
+
+/*
+*******************************************************************************
+g12s
+*******************************************************************************
+*/
+
+static void pkBenchG12sSign(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, g12sSign(c->sig, c->params, c->hash, c->privkey,
+		prngCOMBOStepR, c->combo_state));
+}
+
+static void pkBenchG12sVerify(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, g12sVerify(c->params, c->hash, c->sig, c->pubkey));
+}
+
+static bool_t pkBenchG12s(const char* name, pk_bench_ctx* c)
+{
+	g12s_params params[1];
+	if (g12sParamsStd(params, name) != ERR_OK ||
+		g12sKeypairGen(c->privkey, c->pubkey, params, prngCOMBOStepR,
+			c->combo_state) != ERR_OK)
+		return FALSE;
+	c->params = params, c->l = params->l;
+	prngCOMBOStepR(c->hash, c->l / 8, c->combo_state);
+	return pkBenchRun("g12sSign", name, pkBenchG12sSign, c) &&
+		g12sSign(c->sig, params, c->hash, c->privkey, prngCOMBOStepR,
+			c->combo_state) == ERR_OK &&
+		pkBenchRun("g12sVerify", name, pkBenchG12sVerify, c);
+}
+
+/*
+*******************************************************************************
+pfok
+*******************************************************************************
+*/
+
+static void pkBenchPfokDH(void* ctx)
+{
+	pk_bench_ctx* c = (pk_bench_ctx*)ctx;
+	pkBenchCheck(c, pfokDH(c->key, c->params, c->privkey, c->pubkeyb));
+}
+
+static bool_t pkBenchPfok(const char* name, pk_bench_ctx* c)
+{
+	pfok_params params[1];
+	char set[8];
+	if (pfokParamsStd(params, 0, name) != ERR_OK ||
+		O_OF_B(params->l) > sizeof(c->pubkey) ||
+		pfokKeypairGen(c->privkey, c->pubkey, params, prngCOMBOStepR,
+			c->combo_state) != ERR_OK ||
+		pfokKeypairGen(c->privkeyb, c->pubkeyb, params, prngCOMBOStepR,
+			c->combo_state) != ERR_OK)
+		return FALSE;
+	c->params = params, c->l = params->l;
+	sprintf(set, "%u", (unsigned)params->l);
+	return pkBenchRun("pfokDH", set, pkBenchPfokDH, c);
+}
+
+/*
+*******************************************************************************
+Замеры
+*******************************************************************************
+*/
+
+bool_t pkBench()
+{
+	pk_bench_ctx* c;
+	bool_t ok;
+	// подготовить контекст
+	c = (pk_bench_ctx*)blobCreate(sizeof(pk_bench_ctx) +
+		2 * PK_BENCH_STATE_SIZE);
+	if (!c)
+		return FALSE;
+	c->statea = (octet*)(c + 1);
+	c->stateb = c->statea + PK_BENCH_STATE_SIZE;
+	if (sizeof(c->combo_state) < prngCOMBO_keep() ||
+		PK_BENCH_STATE_SIZE < bakeBMQV_keep(256) ||
+		PK_BENCH_STATE_SIZE < bakeBSTS_keep(256) ||
+		PK_BENCH_STATE_SIZE < bakeBPACE_keep(256) ||
+		PK_BENCH_STATE_SIZE < btokBAuthT_keep(256) ||
+		PK_BENCH_STATE_SIZE < btokBAuthCT_keep(256))
+	{
+		blobClose(c);
+		return FALSE;
+	}
+	prngCOMBOStart(c->combo_state, utilNonce32());
+	// замеры
+	ok = pkBenchBign("1.2.112.0.2.0.34.101.45.3.1", c) &&
+		pkBenchBign("1.2.112.0.2.0.34.101.45.3.2", c) &&
+		pkBenchBign("1.2.112.0.2.0.34.101.45.3.3", c) &&
+		pkBenchBign96(c) &&
+		pkBenchDstu("1.2.804.2.1.1.1.1.3.1.1.1.2.0", c) &&
+		pkBenchDstu("1.2.804.2.1.1.1.1.3.1.1.1.2.1", c) &&
+		pkBenchDstu("1.2.804.2.1.1.1.1.3.1.1.1.2.2", c) &&
+		pkBenchDstu("1.2.804.2.1.1.1.1.3.1.1.1.2.3", c) &&
+		pkBenchDstu("1.2.804.2.1.1.1.1.3.1.1.1.2.4", c) &&
+		pkBenchDstu("1.2.804.2.1.1.1.1.3.1.1.1.2.5", c) &&
+		pkBenchDstu("1.2.804.2.1.1.1.1.3.1.1.1.2.6", c) &&
+		pkBenchDstu("1.2.804.2.1.1.1.1.3.1.1.1.2.7", c) &&
+		pkBenchDstu("1.2.804.2.1.1.1.1.3.1.1.1.2.8", c) &&
+		pkBenchDstu("1.2.804.2.1.1.1.1.3.1.1.1.2.9", c) &&
+		pkBenchG12s("1.2.643.2.2.35.0", c) &&
+		pkBenchG12s("1.2.643.2.2.35.1", c) &&
+		pkBenchG12s("1.2.643.2.2.35.2", c) &&
+		pkBenchG12s("1.2.643.2.2.35.3", c) &&
+		pkBenchG12s("1.2.643.2.9.1.8.1", c) &&
+		pkBenchG12s("1.2.643.7.1.2.1.2.0", c) &&
+		pkBenchG12s("1.2.643.7.1.2.1.2.1", c) &&
+		pkBenchG12s("1.2.643.7.1.2.1.2.2", c) &&
+		pkBenchPfok("1.2.112.0.2.0.1176.2.3.3.2", c) &&
+		pkBenchPfok("1.2.112.0.2.0.1176.2.3.6.2", c) &&
+		pkBenchPfok("1.2.112.0.2.0.1176.2.3.10.2", c);
+	blobClose(c);
+	return ok;
+}
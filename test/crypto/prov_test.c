@@ -0,0 +1,180 @@
+/*
+*******************************************************************************
+\file prov_test.c
+\brief Tests for cryptographic providers
+\project bee2/test
+\created 2026.10.15
+\version 2026.10.15
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include <bee2/core/err.h>
+#include <bee2/core/mem.h>
+#include <bee2/core/rng.h>
+#include <bee2/core/str.h>
+#include <bee2/core/u32.h>
+#include <bee2/core/util.h>
+#include <bee2/crypto/belt.h>
+#include <bee2/crypto/bign.h>
+#include <bee2/crypto/prov.h>
+
+/*
+*******************************************************************************
+Тестовый провайдер
+
+Провайдер подсчитывает обращения к функциям block_encr и verify_batch
+и отказывается от операций (ERR_NOT_IMPLEMENTED), если не задан флаг
+accept. Хэш-значения и случайные числа провайдера -- постоянные октеты.
+*******************************************************************************
+*/
+
+typedef struct
+{
+	size_t encr;		/*< число обращений к block_encr */
+	size_t verify;		/*< число обращений к verify_batch */
+	bool_t accept;		/*< выполнять операции? */
+	err_t fault;		/*< код отказа block_encr (или ERR_OK) */
+} prov_test_st;
+
+static prov_test_st _st[1];
+
+static err_t provTestBlockEncr(u32 blocks[], size_t count, const u32 key[8],
+	void* state)
+{
+	prov_test_st* st = (prov_test_st*)state;
+	++st->encr;
+	if (st->fault != ERR_OK)
+		return st->fault;
+	if (!st->accept)
+		return ERR_NOT_IMPLEMENTED;
+	memSet(blocks, 0xB1, 16 * count);
+	return ERR_OK;
+}
+
+static err_t provTestHashMB(octet hash[], const void* const src[],
+	const size_t count[], size_t n, void* state)
+{
+	memSet(hash, 0x5A, 32 * n);
+	return ERR_OK;
+}
+
+static err_t provTestVerifyBatch(size_t* bad, const bign_params* params,
+	const octet oid_der[], size_t oid_len, size_t count,
+	const octet hashes[], const octet sigs[], const octet pubkeys[],
+	void* state)
+{
+	prov_test_st* st = (prov_test_st*)state;
+	++st->verify;
+	if (!st->accept)
+		return ERR_NOT_IMPLEMENTED;
+	if (bad)
+		*bad = count;
+	return ERR_OK;
+}
+
+static err_t provTestRng(void* buf, size_t count, void* state)
+{
+	memSet(buf, 0x36, count);
+	return ERR_OK;
+}
+
+static const prov_o _prov =
+{
+	"TEST", _st,
+	provTestBlockEncr, 0, provTestHashMB, 0, provTestVerifyBatch, provTestRng
+};
+
+/*
+*******************************************************************************
+Самотестирование
+*******************************************************************************
+*/
+
+bool_t provTest()
+{
+	prov_o prov1[1];
+	bign_params params[1];
+	octet oid_der[16];
+	size_t oid_len = sizeof(oid_der);
+	u32 buf[16];
+	u32 buf1[16];
+	octet hash[32];
+	octet sig[48];
+	octet pubkey[64];
+	u32 key[8];
+	const void* src[1];
+	size_t count[1];
+	size_t bad;
+	bool_t ok;
+	// программная реализация
+	if (provActive() != 0 || !strEq(provName(), "BEE2") ||
+		provSelect("TEST") != ERR_NOT_FOUND ||
+		provSelect(0) != ERR_OK || provSelect("BEE2") != ERR_OK)
+		return FALSE;
+	// регистрация
+	memCopy(prov1, &_prov, sizeof(prov_o));
+	prov1->name = "BEE2";
+	if (provRegister(prov1) != ERR_BAD_INPUT ||
+		provRegister(&_prov) != ERR_OK ||
+		provRegister(&_prov) != ERR_ALREADY_EXISTS ||
+		provActive() != 0)
+		return FALSE;
+	// подготовить данные
+	if (bignParamsStd(params, "1.2.112.0.2.0.34.101.45.3.1") != ERR_OK ||
+		bignOidToDER(oid_der, &oid_len, "1.2.112.0.2.0.34.101.31.81") !=
+			ERR_OK)
+		return FALSE;
+	memSetZero(sig, sizeof(sig));
+	memCopy(pubkey, beltH(), sizeof(pubkey));
+	u32From(key, beltH() + 128, 32);
+	memCopy(buf, beltH(), sizeof(buf));
+	beltBlockEncrN(buf, 4, key);
+	src[0] = beltH(), count[0] = 32;
+	// выбрать провайдер
+	if (provSelect("TEST") != ERR_OK || provActive() != &_prov ||
+		!strEq(provName(), "TEST"))
+		return FALSE;
+	// belt-block: отказ провайдера
+	_st->encr = _st->verify = 0, _st->accept = FALSE;
+	memCopy(buf1, beltH(), sizeof(buf1));
+	beltBlockEncrN(buf1, 4, key);
+	ok = _st->encr == 1 && memEq(buf, buf1, sizeof(buf));
+	// belt-block: сбой провайдера
+	_st->fault = ERR_SYS;
+	memCopy(buf1, beltH(), sizeof(buf1));
+	beltBlockEncrN(buf1, 4, key);
+	ok = ok && _st->encr == 2 && memEq(buf, buf1, sizeof(buf));
+	_st->fault = ERR_OK;
+	// belt-block: выполнение провайдером
+	_st->accept = TRUE;
+	beltBlockEncrN(buf1, 4, key);
+	ok = ok && _st->encr == 3 && memIsRep(buf1, sizeof(buf1), 0xB1);
+	// belt-hash
+	ok = ok && beltHashMB(hash, src, count, 1) == ERR_OK &&
+		memIsRep(hash, 32, 0x5A);
+	// bign: проверка ЭЦП (ошибки входных данных -- до провайдера)
+	ok = ok && bignVerifyBatch(&bad, params, oid_der, oid_len, 1, hash, sig,
+		pubkey) == ERR_OK && bad == 1 && _st->verify == 1 &&
+		bignVerifyBatch(&bad, params, oid_der, 1, 1, hash, sig,
+			pubkey) == ERR_BAD_OID && _st->verify == 1;
+	_st->accept = FALSE;
+	ok = ok && bignVerifyBatch(&bad, params, oid_der, oid_len, 1, hash, sig,
+		pubkey) != ERR_OK && _st->verify == 2;
+	// rng
+	if (ok && rngCreate(0, 0) == ERR_OK)
+	{
+		rngStepR(buf, sizeof(buf), 0);
+		rngStepR3(buf1, sizeof(buf1), 0);
+		ok = memIsRep(buf, sizeof(buf), 0x36) &&
+			memIsRep(buf1, sizeof(buf1), 0x36);
+		rngClose();
+	}
+	// вернуться к программной реализации
+	if (provSelect(0) != ERR_OK || provActive() != 0)
+		return FALSE;
+	ok = ok && beltHashMB(hash, src, count, 1) == ERR_OK &&
+		!memIsRep(hash, 32, 0x5A);
+	return ok;
+}
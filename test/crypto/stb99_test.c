@@ -4,13 +4,14 @@
 \brief Tests for STB 1176.2-99[generation of parameters]
 \project bee2/test
 \created 2023.08.05
-\version 2024.02.29
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
 #include <bee2/core/mem.h>
+#include <bee2/core/mt.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/prng.h>
 #include <bee2/core/str.h>
@@ -46,6 +47,8 @@ bool_t stb99TestParamsTest()
 	stb99_seed seed1[1];
 	stb99_params params[1];
 	stb99_params params1[1];
+	mt_pool_t* pool;
+	err_t code;
 	// проверка затравочных параметров
 	memSetZero(seed1, sizeof(stb99_seed));
 	if (stb99SeedVal(seed1) == ERR_OK ||
@@ -78,6 +81,23 @@ bool_t stb99TestParamsTest()
 		stb99ParamsVal(params1) != ERR_OK ||
 		!memEq(params, params1, sizeof(stb99_params)))
 		return FALSE;
+	// генерация по нескольким затравкам без пула
+	memCopy(seed, seed1, sizeof(stb99_seed));
+	if (stb99ParamsGenMT(params1, seed1, 3, 0) != ERR_OK ||
+		!memEq(seed, seed1, sizeof(stb99_seed)) ||
+		!memEq(params, params1, sizeof(stb99_params)))
+		return FALSE;
+	// генерация по нескольким затравкам в пуле
+	if (!(pool = mtPoolCreate(0, 0, 0)))
+		return FALSE;
+	code = stb99ParamsGenMT(params1, seed1, 3, pool);
+	mtPoolClose(pool);
+	if (code != ERR_OK ||
+		stb99SeedVal(seed1) != ERR_OK ||
+		stb99ParamsVal(params1) != ERR_OK ||
+		stb99ParamsGen(params, seed1) != ERR_OK ||
+		!memEq(params, params1, sizeof(stb99_params)))
+		return FALSE;
 	// испортить параметры
 	params1->d[0] += 2;
 	if (stb99ParamsVal(params1) == ERR_OK)
@@ -4,7 +4,7 @@
 \brief Benchmarks for elliptic curves over prime fields
 \project bee2/test
 \created 2013.10.17
-\version 2023.09.22
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -14,11 +14,12 @@
 #include <bee2/core/mem.h>
 #include <bee2/core/prng.h>
 #include <bee2/core/stack.h>
-#include <bee2/core/tm.h>
 #include <bee2/core/util.h>
 #include <crypto/bign/bign_lcl.h>
 #include <bee2/math/ecp.h>
 #include <bee2/math/gfp.h>
+#include <bee2/math/opcnt.h>
+#include "../bench.h"
 
 /*
 *******************************************************************************
@@ -33,6 +34,77 @@ static size_t _ecpBench_deep(size_t n, size_t f_deep, size_t ec_d,
 		ecMulA_deep(n, ec_d, ec_deep, n);
 }
 
+typedef struct {
+	ec_o* ec;				/*< описание кривой */
+	octet* combo_state;		/*< генератор COMBO */
+	word* pt;				/*< кратная точка */
+	word* d;				/*< множитель */
+	void* stack;			/*< стек */
+} ecp_bench_ctx;
+
+static void ecpBenchOp(void* ctx)
+{
+	ecp_bench_ctx* c = (ecp_bench_ctx*)ctx;
+	prngCOMBOStepR(c->d, c->ec->f->no, c->combo_state);
+	ecMulA(c->pt, c->ec->base, c->ec, c->d, c->ec->f->n, c->stack);
+}
+
+/*
+*******************************************************************************
+Счетчики операций
+
+Если библиотека собрана с директивой BEE2_INSTRUMENT (см. opcnt.h), то
+дополнительно печатается число операций в поле и над точками, выполняемых
+при однократном вычислении кратной точки. Печатаются только ненулевые
+счетчики.
+*******************************************************************************
+*/
+
+static void ecpBenchCount(const char* name, size_t count)
+{
+	char label[32];
+	char value[32];
+	if (count == 0)
+		return;
+	sprintf(label, "mulpoint.%s", name);
+	sprintf(value, "%u", (unsigned)count);
+	benchNote("ecpBench", label, value);
+}
+
+static void ecpBenchCounts(ecp_bench_ctx* ctx)
+{
+	opcnt_t c[1];
+	opcntReset();
+	ecpBenchOp(ctx);
+	opcntGet(c);
+	ecpBenchCount("qr_from", c->qr_from);
+	ecpBenchCount("qr_to", c->qr_to);
+	ecpBenchCount("qr_add", c->qr_add);
+	ecpBenchCount("qr_sub", c->qr_sub);
+	ecpBenchCount("qr_neg", c->qr_neg);
+	ecpBenchCount("qr_mul", c->qr_mul);
+	ecpBenchCount("qr_sqr", c->qr_sqr);
+	ecpBenchCount("qr_inv", c->qr_inv);
+	ecpBenchCount("qr_div", c->qr_div);
+	ecpBenchCount("ec_froma", c->ec_froma);
+	ecpBenchCount("ec_toa", c->ec_toa);
+	ecpBenchCount("ec_toan", c->ec_toan);
+	ecpBenchCount("ec_neg", c->ec_neg);
+	ecpBenchCount("ec_add", c->ec_add);
+	ecpBenchCount("ec_adda", c->ec_adda);
+	ecpBenchCount("ec_sub", c->ec_sub);
+	ecpBenchCount("ec_suba", c->ec_suba);
+	ecpBenchCount("ec_dbl", c->ec_dbl);
+	ecpBenchCount("ec_dbla", c->ec_dbla);
+	ecpBenchCount("ec_dbln", c->ec_dbln);
+}
+
+/*
+*******************************************************************************
+Замеры
+*******************************************************************************
+*/
+
 bool_t ecpBench()
 {
 	// описание кривой
@@ -62,20 +134,12 @@ bool_t ecpBench()
 	prngCOMBOStart(combo_state, utilNonce32());
 	// оценить число кратных точек в секунду
 	{
-		const size_t reps = 1000;
-		size_t i;
-		tm_ticks_t ticks;
-		// эксперимент
-		for (i = 0, ticks = tmTicks(); i < reps; ++i)
-		{
-			prngCOMBOStepR(d, ec->f->no, combo_state);
-			ecMulA(pt, ec->base, ec, d, ec->f->n, stack);
-		}
-		ticks = tmTicks() - ticks;
-		// печать результатов
-		printf("ecpBench: %u cycles/mulpoint [%u mulpoints/sec]\n", 
-			(unsigned)(ticks / reps),
-			(unsigned)tmSpeed(reps, ticks));
+		ecp_bench_ctx ctx[1];
+		ctx->ec = ec, ctx->combo_state = combo_state;
+		ctx->pt = pt, ctx->d = d, ctx->stack = stack;
+		benchRun("ecpBench", "mulpoint", 0, ecpBenchOp, ctx);
+		if (opcntIsEnabled())
+			ecpBenchCounts(ctx);
 	}
 	// все нормально
 	return TRUE;
@@ -4,19 +4,22 @@
 \brief Tests for elliptic curves over prime fields
 \project bee2/test
 \created 2017.05.29
-\version 2023.03.30
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
 */
 
+#include <bee2/core/blob.h>
 #include <bee2/core/hex.h>
 #include <bee2/core/mem.h>
 #include <bee2/core/obj.h>
+#include <bee2/core/str.h>
 #include <bee2/core/util.h>
 #include <bee2/math/gfp.h>
 #include <bee2/math/ecp.h>
 #include <bee2/math/ww.h>
+#include <bee2/math/zz.h>
 
 /*
 *******************************************************************************
@@ -54,7 +57,7 @@ bool_t ecpTest()
 	const size_t f_deep = gfpCreate_deep(no);
 	// состояние и стек
 	octet state[2048];
-	octet stack[2048];
+	octet stack[8192];
 	octet t[32 * 5];
 	// поле и эк
 	qr_o* f;
@@ -137,6 +140,309 @@ bool_t ecpTest()
 		if (!memEq(pts, pts + 2 * n, 2 * n))
 			return FALSE;
 	}
+	// гребенчатый метод
+	{
+		word pre[2 * W_OF_O(32) * 15];
+		word pts[4 * W_OF_O(32)];
+		word d[W_OF_O(32)];
+		word a[2 * W_OF_O(32)];
+		word e[W_OF_O(32)];
+		word code[2 * W_OF_O(32) + 2];
+		word dbcode[24 * W_OF_O(32)];
+		size_t i;
+		if (sizeof(stack) < utilMax(3,
+				ecCombPrecompA_deep(n, ec->d, ec->deep),
+				ecCombMulA_deep(n, ec->d, ec->deep),
+				ecMulA_deep(n, ec->d, ec->deep, n)) ||
+			!ecCombPrecompA(pre, ec->base, ec, 4, n, stack))
+			return FALSE;
+		// d = 0
+		wwSetZero(d, n);
+		if (ecCombMulA(pts, pre, ec, 4, d, n, stack))
+			return FALSE;
+		// случайные d
+		for (i = 0; i < 8; ++i)
+		{
+			memSet(d, (octet)(0x3C * i + 0x17), sizeof(d));
+			d[0] ^= (word)i;
+			if (ecCombMulA(pts, pre, ec, 4, d, n, stack) !=
+					ecMulA(pts + 2 * n, ec->base, ec, d, n, stack) ||
+				!memEq(pts, pts + 2 * n, O_OF_W(2 * n)))
+				return FALSE;
+		}
+		// d = q - 1
+		wwCopy(d, ec->order, n);
+		d[0]--;
+		ecpNegA(pts + 2 * n, ec->base, ec);
+		if (!ecCombMulA(pts, pre, ec, 4, d, n, stack) ||
+			!memEq(pts, pts + 2 * n, O_OF_W(2 * n)))
+			return FALSE;
+		// d G + e a, a = 3G
+		if (sizeof(stack) < utilMax(2,
+				ecCombAddMulA_deep(n, ec->d, ec->deep, n),
+				ecAddMulA_deep(n, ec->d, ec->deep, 2, n, n)))
+			return FALSE;
+		wwSetW(e, n, 3);
+		if (!ecCombMulA(a, pre, ec, 4, e, n, stack))
+			return FALSE;
+		for (i = 0; i < 4; ++i)
+		{
+			memSet(e, (octet)(0x5A * i + 0x21), sizeof(e));
+			e[i] = 0;
+			if (i == 3)
+				wwSetZero(e, n);
+			if (ecCombAddMulA(pts, pre, ec, 4, d, n, a, e, n - i, stack) !=
+					ecAddMulA(pts + 2 * n, ec, stack, 2, ec->base, d, n,
+						a, e, n - i) ||
+				!memEq(pts, pts + 2 * n, O_OF_W(2 * n)))
+				return FALSE;
+		}
+#ifdef U64_SUPPORT
+		// 8 сумм d_j G + e_j a_j
+		{
+			word* b8;
+			word* a8;
+			word* d8;
+			word* e8;
+			void* stack8;
+			size_t mask, j;
+			b8 = (word*)blobCreate(O_OF_W(8 * 6 * n) +
+				utilMax(2,
+					ecpCombAddMulA8_deep(n, f_deep, 4, n),
+					ecCombAddMulA_deep(n, ec->d, ec->deep, n)));
+			if (!b8)
+				return FALSE;
+			a8 = b8 + 8 * 2 * n;
+			d8 = a8 + 8 * 2 * n;
+			e8 = d8 + 8 * n;
+			stack8 = e8 + 8 * n;
+			for (j = 0; j < 8; ++j)
+			{
+				memSet(d8 + j * n, (octet)(0x3C * j + 0x17), O_OF_W(n));
+				memSet(e8 + j * n, (octet)(0x5A * j + 0x21), O_OF_W(n));
+				wwSetW(pts, n, j + 2);
+				if (!ecCombMulA(a8 + j * 2 * n, pre, ec, 4, pts, n, stack8))
+				{
+					blobClose(b8);
+					return FALSE;
+				}
+			}
+			// d_2 = e_2 = 0 => b_2 == O
+			wwSetZero(d8 + 2 * n, n), wwSetZero(e8 + 2 * n, n);
+			// e_5 = 0
+			wwSetZero(e8 + 5 * n, n);
+			mask = ecpCombAddMulA8(b8, pre, ec, 4, d8, n, a8, e8, n, stack8);
+			if ((mask & 4) || !(mask & 1))
+			{
+				blobClose(b8);
+				return FALSE;
+			}
+			for (j = 0; j < 8; ++j)
+				if ((mask >> j & 1) &&
+					(!ecCombAddMulA(pts, pre, ec, 4, d8 + j * n, n,
+						a8 + j * 2 * n, e8 + j * n, n, stack8) ||
+					!wwEq(pts, b8 + j * 2 * n, 2 * n)))
+				{
+					blobClose(b8);
+					return FALSE;
+				}
+			blobClose(b8);
+		}
+#endif
+		// кодированная кратность: d G, d a
+		if (sizeof(stack) < ecMulANAF_deep(n, ec->d, ec->deep, n))
+			return FALSE;
+		ecNAFCode(code, d, n);
+		if (!ecMulANAF(pts, ec->base, ec, code, n, stack) ||
+			!ecMulA(pts + 2 * n, ec->base, ec, d, n, stack) ||
+			!memEq(pts, pts + 2 * n, O_OF_W(2 * n)) ||
+			!ecMulANAF(pts, a, ec, code, n, stack) ||
+			!ecMulA(pts + 2 * n, a, ec, d, n, stack) ||
+			!memEq(pts, pts + 2 * n, O_OF_W(2 * n)))
+			return FALSE;
+		// цепочки с двойной базой: d a, малые кратности, (q - 1) a
+		if (COUNT_OF(dbcode) < ecDBCode_size(n) ||
+			sizeof(stack) < utilMax(2,
+				ecDBCode_deep(n),
+				ecMulADB_deep(n, ec->d, ec->deep, n)))
+			return FALSE;
+		ecDBCode(dbcode, d, n, 34, 20, stack);
+		if (!ecMulADB(pts, a, ec, dbcode, n, stack) ||
+			!ecMulA(pts + 2 * n, a, ec, d, n, stack) ||
+			!memEq(pts, pts + 2 * n, O_OF_W(2 * n)))
+			return FALSE;
+		for (i = 1; i < 64; ++i)
+		{
+			wwSetW(e, n, (word)(i * i * i));
+			ecDBCode(dbcode, e, n, 16 * (i % 3) + 25, 16 * (i % 2) + 4,
+				stack);
+			if (!ecMulADB(pts, a, ec, dbcode, n, stack) ||
+				!ecMulA(pts + 2 * n, a, ec, e, n, stack) ||
+				!memEq(pts, pts + 2 * n, O_OF_W(2 * n)))
+				return FALSE;
+		}
+		wwCopy(e, ec->order, n);
+		e[0]--;
+		ecDBCode(dbcode, e, n, 34, 20, stack);
+		if (!ecMulADB(pts, ec->base, ec, dbcode, n, stack) ||
+			!ecMulA(pts + 2 * n, ec->base, ec, e, n, stack) ||
+			!memEq(pts, pts + 2 * n, O_OF_W(2 * n)))
+			return FALSE;
+		wwSetZero(e, n);
+		ecDBCode(dbcode, e, n, 34, 20, stack);
+		if (ecMulADB(pts, a, ec, dbcode, n, stack))
+			return FALSE;
+		ecNAFCode(code, e, n);
+		if (ecMulANAF(pts, a, ec, code, n, stack))
+			return FALSE;
+		// регулярное умножение
+		if (sizeof(stack) < ecMulACT_deep(n, ec->d, ec->deep) ||
+			ecMulACT(pts, a, ec, e, n, stack))
+			return FALSE;
+		for (i = 0; i < 8; ++i)
+		{
+			memSet(e, (octet)(0x3C * i + 0x17), sizeof(e));
+			e[0] ^= (word)i;
+			if (i == 6)
+				wwSetW(e, n, 1);
+			if (i == 7)
+				wwCopy(e, d, n);
+			if (!ecMulACT(pts, a, ec, e, n, stack) ||
+				!ecMulA(pts + 2 * n, a, ec, e, n, stack) ||
+				!memEq(pts, pts + 2 * n, O_OF_W(2 * n)))
+				return FALSE;
+		}
+	}
+	// таблицы в формате SoA
+	{
+		word tbl[5 * 3 * W_OF_O(32)];
+		word soa[5 * 3 * W_OF_O(32)];
+		word pt[3 * W_OF_O(32)];
+		size_t i;
+		for (i = 0; i < COUNT_OF(tbl); ++i)
+			tbl[i] = (word)(0x9E3779B97F4A7C15 * (i + 1));
+		ecSoAFrom(soa, tbl, 5, 3 * n);
+		for (i = 0; i < 5; ++i)
+		{
+			ecSoASelect(pt, soa, 5, 3 * n, i);
+			if (!wwEq(pt, tbl + 3 * n * i, 3 * n) ||
+				!wwEq(soa + i, tbl + 3 * n * i, 1))
+				return FALSE;
+		}
+		wwSetZero(tbl, COUNT_OF(tbl));
+		ecSoATo(tbl, soa, 5, 3 * n);
+		for (i = 0; i < 5; ++i)
+		{
+			ecSoASelect(pt, soa, 5, 3 * n, i);
+			if (!wwEq(pt, tbl + 3 * n * i, 3 * n))
+				return FALSE;
+		}
+	}
+	// пакетный экспорт
+	{
+		word pj[3 * 3 * W_OF_O(32)];
+		word pa[3 * 2 * W_OF_O(32)];
+		word pt[2 * W_OF_O(32)];
+		size_t i;
+		if (sizeof(stack) < ecToABatch_deep(n, ec->deep, 3))
+			return FALSE;
+		// pj <- (G, 2G, 3G)
+		ecFromA(pj, ec->base, ec, stack);
+		ecDblA(pj + 3 * n, ec->base, ec, stack);
+		ecAdd(pj + 6 * n, pj + 3 * n, pj, ec, stack);
+		if (!ecToABatch(pa, pj, 3, ec, stack))
+			return FALSE;
+		for (i = 0; i < 3; ++i)
+			if (!ecToA(pt, pj + 3 * n * i, ec, stack) ||
+				!memEq(pt, pa + 2 * n * i, O_OF_W(2 * n)))
+				return FALSE;
+		// pj <- (G, O, 3G)
+		ecSetO(pj + 3 * n, ec);
+		if (ecToABatch(pa, pj, 3, ec, stack) ||
+			!memEq(pa, ec->base, O_OF_W(2 * n)) ||
+			!ecToA(pt, pj + 6 * n, ec, stack) ||
+			!memEq(pt, pa + 4 * n, O_OF_W(2 * n)))
+			return FALSE;
+	}
+	// сумма многих кратных
+	{
+		word pa[64 * 2 * W_OF_O(32)];
+		word d[64 * W_OF_O(32)];
+		word pt[2 * W_OF_O(32)];
+		word ps[2 * W_OF_O(32)];
+		size_t i;
+		if (sizeof(stack) < utilMax(4,
+				ecMultiMulA_deep(n, ec->d, ec->deep, n, 2),
+				ecMultiMulA_deep(n, ec->d, ec->deep, n, 64),
+				ecAddMulA_deep(n, ec->d, ec->deep, 2, n, n),
+				ecMulA_deep(n, ec->d, ec->deep, n)))
+			return FALSE;
+		// pa[i] <- (i + 1) G, d[i] <- ...
+		wwCopy(pa, ec->base, 2 * n);
+		for (i = 1; i < 64; ++i)
+			if (!ecpAddAA(pa + 2 * n * i, pa + 2 * n * (i - 1), ec->base, ec,
+				stack))
+				return FALSE;
+		for (i = 0; i < 64; ++i)
+		{
+			memSet(d + n * i, (octet)(0x4B * i + 0x13), O_OF_W(n));
+			d[n * i] ^= (word)i;
+		}
+		// метод Штрауса
+		if (!ecMultiMulA(pt, pa, d, n, 2, ec, stack) ||
+			!ecAddMulA(ps, ec, stack, 2, pa, d, n, pa + 2 * n, d + n, n) ||
+			!memEq(pt, ps, O_OF_W(2 * n)))
+			return FALSE;
+		// метод Пиппенджера
+		if (!ecMulA(ps, pa, ec, d, n, stack))
+			return FALSE;
+		for (i = 1; i < 64; ++i)
+			if (!ecMulA(pt, pa + 2 * n * i, ec, d + n * i, n, stack) ||
+				!ecpAddAA(ps, ps, pt, ec, stack))
+				return FALSE;
+		if (!ecMultiMulA(pt, pa, d, n, 64, ec, stack) ||
+			!memEq(pt, ps, O_OF_W(2 * n)))
+			return FALSE;
+	}
+	// сжатие точек
+	{
+		word pt[2 * W_OF_O(32)];
+		word ps[2 * W_OF_O(32)];
+		octet y[32];
+		size_t i;
+		if (sizeof(stack) < utilMax(3,
+				ecpDecompress_deep(n, f_deep),
+				ecpAddAA_deep(n, f_deep),
+				f_deep))
+			return FALSE;
+		// pt <- (i + 1) G
+		wwCopy(pt, ec->base, 2 * n);
+		for (i = 0; i < 16; ++i)
+		{
+			qrTo(y, ecY(pt, n), ec->f, stack);
+			if (!ecpDecompress(ps, pt, y[0] & 1, ec, stack) ||
+				!wwEq(ps, pt, 2 * n))
+				return FALSE;
+			if (!ecpDecompress(ps, pt, !(y[0] & 1), ec, stack))
+				return FALSE;
+			ecpNegA(ps, ps, ec);
+			if (!wwEq(ps, pt, 2 * n) ||
+				!ecpAddAA(pt, pt, ec->base, ec, stack))
+				return FALSE;
+		}
+		// x = 1, 2,...: не все x являются абсциссами точек
+		qrSetZero(ps, ec->f);
+		for (i = 0; i < 32; ++i)
+		{
+			qrAddUnity(ps, ps, ec->f);
+			if (!ecpDecompress(pt, ps, FALSE, ec, stack))
+				break;
+			if (!ecpIsOnA(pt, ec, stack))
+				return FALSE;
+		}
+		if (i == 32)
+			return FALSE;
+	}
 	// вывести f = GF(p) за пределы ec
 	f = (qr_o*)(state + ec_keep);
 	memMove(f, objPtr(ec, 0, qr_o), f_keep);
@@ -190,6 +496,91 @@ bool_t ecpTest()
 		ec->toa(pts + 2 * n, pts + 2 * n, ec, stack);
 		if (!memEq(pts, pts + 2 * n, 2 * n))
 			return FALSE;
+		// 5-кратное удвоение (A != -3)
+		if (!ec->dbln)
+			return FALSE;
+		ec->froma(pts + 2 * n, ec->base, ec, stack);
+		ec->dbln(pts + 2 * n, pts + 2 * n, 5, ec, stack);
+		ec->toa(pts, pts + 2 * n, ec, stack);
+		ec->froma(pts + 2 * n, ec->base, ec, stack);
+		for (d = 0; d < 5; ++d)
+			ec->dbl(pts + 2 * n, pts + 2 * n, ec, stack);
+		ec->toa(pts + 2 * n, pts + 2 * n, ec, stack);
+		if (!memEq(pts, pts + 2 * n, 2 * n))
+			return FALSE;
+		// кратная точка с серией нулей NAF
+		d = 32;
+		if (!ecMulA(pts + 2 * n, ec->base, ec, &d, 1, stack) ||
+			!memEq(pts, pts + 2 * n, 2 * n))
+			return FALSE;
+		d = 0x80000003;
+		if (!ecMulA(pts, ec->base, ec, &d, 1, stack))
+			return FALSE;
+		ec->froma(pts + 2 * n, ec->base, ec, stack);
+		ec->dbln(pts + 2 * n, pts + 2 * n, 31, ec, stack);
+		ec->adda(pts + 2 * n, pts + 2 * n, ec->base, ec, stack);
+		ec->adda(pts + 2 * n, pts + 2 * n, ec->base, ec, stack);
+		ec->adda(pts + 2 * n, pts + 2 * n, ec->base, ec, stack);
+		ec->toa(pts + 2 * n, pts + 2 * n, ec, stack);
+		if (!memEq(pts, pts + 2 * n, 2 * n))
+			return FALSE;
+	}
+	// квадратные корни: p \equiv 3 \mod 4, p \equiv 5 \mod 8, p \equiv 1 \mod 8
+	{
+		static const char* ps[] = {
+			p,
+			"7FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFED",
+			"FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF000000000000000000000001",
+		};
+		octet fstate[1024];
+		word x[W_OF_O(32)];
+		word y[W_OF_O(32)];
+		word z[W_OF_O(32)];
+		size_t i, j, nf, nres = 0;
+		f = (qr_o*)fstate;
+		for (i = 0; i < COUNT_OF(ps); ++i)
+		{
+			const size_t fno = strLen(ps[i]) / 2;
+			if (sizeof(fstate) < gfpCreate_keep(fno) ||
+				sizeof(stack) < utilMax(3,
+					gfpCreate_deep(fno),
+					gfpSqrt_deep(W_OF_O(fno), gfpCreate_deep(fno)),
+					zzJacobi_deep(W_OF_O(fno), W_OF_O(fno))))
+				return FALSE;
+			hexToRev(t, ps[i]);
+			if (!gfpCreate(f, t, fno, stack))
+				return FALSE;
+			nf = f->n;
+			// x <- 1, 2, 5, 26,...: x <- x^2 + 1
+			qrSetUnity(x, f);
+			for (j = 0; j < 32; ++j)
+			{
+				bool_t res;
+				// (x^2)^{1/2} = \pm x?
+				qrSqr(y, x, f, stack);
+				if (!gfpSqrt(z, y, f, stack))
+					return FALSE;
+				qrSqr(z, z, f, stack);
+				if (!wwEq(z, y, nf))
+					return FALSE;
+				// x^{1/2} существует <=> (x / p) == 1?
+				res = gfpSqrt(z, x, f, stack);
+				qrTo(t, x, f, stack);
+				wwFrom(z, t, fno);
+				if (res != (zzJacobi(z, nf, f->mod, nf, stack) == 1))
+					return FALSE;
+				nres += !res;
+				// x <- x^2 + 1
+				qrAddUnity(x, y, f);
+			}
+		}
+		// встречались невычеты?
+		if (nres == 0)
+			return FALSE;
+		// x == 0
+		qrSetZero(x, f);
+		if (!gfpSqrt(y, x, f, stack) || !qrIsZero(y, f))
+			return FALSE;
 	}
 	// все нормально
 	return TRUE;
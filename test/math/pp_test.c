@@ -4,7 +4,7 @@
 \brief Tests for the arithmetic of binary polynomials
 \project bee2/test
 \created 2023.11.09
-\version 2023.11.10
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -215,6 +215,253 @@ static bool_t ppTestRed()
 	return TRUE;
 }
 
+/*
+*******************************************************************************
+Неприводимость
+
+Неприводимыми являются модули полей из тестов редукции, а также
+многочлены x^128 + x^7 + x^2 + x + 1 (belt, GCM) и x^127 + x + 1.
+Приводимыми являются произведения этих многочленов между собой
+и на x^2 + x + 1. Многочлены степени 12 проверяются также пробным
+делением на многочлены степени от 1 до 6.
+*******************************************************************************
+*/
+
+static void ppTestIrredSet(word a[], size_t n, size_t m, size_t k, size_t l,
+	size_t l1)
+{
+	wwSetZero(a, n);
+	wwSetBit(a, m, TRUE);
+	wwSetBit(a, k, TRUE);
+	wwSetBit(a, l, TRUE);
+	wwSetBit(a, l1, TRUE);
+	wwSetBit(a, 0, TRUE);
+}
+
+static bool_t ppTestIrred()
+{
+	enum { n = W_OF_B(572) };
+	word a[n];
+	word b[n];
+	word c[2 * n];
+	word r[n];
+	word d[1];
+	octet stack[32768];
+	size_t i, j;
+	bool_t irred;
+	// подготовить память
+	if (sizeof(stack) < utilMax(3,
+			ppIsIrred_deep(n),
+			ppMul_deep(n, n),
+			ppMod_deep(n, 1)))
+		return FALSE;
+	// неприводимые многочлены
+	ppTestIrredSet(a, n, 233, 74, 74, 74);
+	if (!ppIsIrred(a, W_OF_B(234), stack))
+		return FALSE;
+	ppTestIrredSet(a, n, 283, 12, 7, 5);
+	if (!ppIsIrred(a, W_OF_B(284), stack))
+		return FALSE;
+	ppTestIrredSet(a, n, 409, 87, 87, 87);
+	if (!ppIsIrred(a, n, stack))
+		return FALSE;
+	ppTestIrredSet(a, n, 571, 10, 5, 2);
+	if (!ppIsIrred(a, n, stack))
+		return FALSE;
+	ppTestIrredSet(a, n, 128, 7, 2, 1);
+	if (!ppIsIrred(a, W_OF_B(129), stack))
+		return FALSE;
+	ppTestIrredSet(b, n, 127, 1, 1, 1);
+	if (!ppIsIrred(b, W_OF_B(128), stack))
+		return FALSE;
+	// приводимые многочлены: делители большой степени
+	ppMul(c, a, W_OF_B(129), b, W_OF_B(128), stack);
+	if (ppIsIrred(c, W_OF_B(256), stack))
+		return FALSE;
+	ppTestIrredSet(b, n, 283, 12, 7, 5);
+	ppMul(c, a, W_OF_B(129), b, W_OF_B(284), stack);
+	if (ppIsIrred(c, W_OF_B(412), stack))
+		return FALSE;
+	// приводимые многочлены: делитель малой степени
+	wwSetW(b, n, 7);
+	ppMul(c, a, W_OF_B(129), b, 1, stack);
+	if (ppIsIrred(c, W_OF_B(131), stack))
+		return FALSE;
+	// многочлены степени 12
+	for (i = 1 << 12; i < 1 << 13; ++i)
+	{
+		a[0] = (word)i;
+		for (irred = TRUE, j = 2; irred && j < 1 << 7; ++j)
+		{
+			d[0] = (word)j;
+			ppMod(r, a, 1, d, 1, stack);
+			irred = r[0] != 0;
+		}
+		if (ppIsIrred(a, 1, stack) != irred)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+*******************************************************************************
+Минимальные многочлены
+
+Для случайных элементов a полей F_2[x]/(mod(x)) с модулями из тестов
+неприводимости проверяется, что минимальный многочлен b неприводим,
+имеет степень \deg(mod) и b(a) = 0. Кроме этого, проверяются минимальные
+многочлены последовательностей 0...0 (многочлен 1), 1...1 (x + 1)
+и 0...01 (линейная сложность больше половины длины).
+*******************************************************************************
+*/
+
+static bool_t ppTestMinPoly()
+{
+	enum { n = W_OF_B(234) };
+	const size_t mods[][4] = {
+		{ 233, 74, 74, 74 },
+		{ 128, 7, 2, 1 },
+		{ 127, 1, 1, 1 },
+	};
+	word mod[n];
+	word a[n];
+	word b[n];
+	word t[n];
+	octet combo_state[32];
+	octet stack[8192];
+	size_t i, j, k, m;
+	// подготовить память
+	if (sizeof(combo_state) < prngCOMBO_keep() ||
+		sizeof(stack) < utilMax(4,
+			ppMinPolyMod_deep(n),
+			ppMinPoly_deep(n * B_PER_W),
+			ppMulMod_deep(n),
+			ppIsIrred_deep(n)))
+		return FALSE;
+	// инициализировать генератор COMBO
+	prngCOMBOStart(combo_state, utilNonce32());
+	// минимальные многочлены элементов полей
+	for (i = 0; i < COUNT_OF(mods); ++i)
+	{
+		m = W_OF_B(mods[i][0] + 1);
+		ppTestIrredSet(mod, m, mods[i][0], mods[i][1], mods[i][2],
+			mods[i][3]);
+		for (j = 0; j < 4; ++j)
+		{
+			prngCOMBOStepR(a, O_OF_W(m), combo_state);
+			wwTrimHi(a, m, mods[i][0]);
+			if (wwCmpW(a, m, 1) <= 0)
+				continue;
+			ppMinPolyMod(b, a, mod, m, stack);
+			if (ppDeg(b, m) != mods[i][0] || !ppIsIrred(b, m, stack))
+				return FALSE;
+			// t <- b(a) (схема Горнера)
+			wwSetZero(t, m);
+			for (k = mods[i][0] + 1; k--;)
+			{
+				ppMulMod(t, t, a, mod, m, stack);
+				t[0] ^= (word)wwTestBit(b, k);
+			}
+			if (!wwIsZero(t, m))
+				return FALSE;
+		}
+	}
+	// последовательности 0...0, 1...1, 0...01
+	wwSetZero(a, n);
+	ppMinPoly(b, a, 64, stack);
+	if (wwCmpW(b, W_OF_B(65), 1) != 0)
+		return FALSE;
+	wwSetBit(a, 0, 1);
+	ppMinPoly(b, a, 64, stack);
+	if (wwCmpW(b, W_OF_B(65), 1) != 0)
+		return FALSE;
+	for (j = 0; j < 128; ++j)
+		wwSetBit(a, j, 1);
+	ppMinPoly(b, a, 64, stack);
+	if (wwCmpW(b, W_OF_B(65), 3) != 0)
+		return FALSE;
+	return TRUE;
+}
+
+/*
+*******************************************************************************
+Умножение
+
+Произведения ppMul(), ppSqr(), ppMulW(), ppAddMulW() сравниваются
+с произведением, вычисленным по определению (сдвигами и сложениями).
+Проверяются как реализации на основе инструкций умножения без переносов,
+так и программные реализации (в зависимости от платформы).
+*******************************************************************************
+*/
+
+static void ppMulRef(word c[], const word a[], size_t n, const word b[],
+	size_t m, word t[])
+{
+	size_t j;
+	wwSetZero(c, n + m);
+	wwCopy(t, a, n);
+	wwSetZero(t + n, m);
+	for (j = 0; j < B_OF_W(m); ++j)
+	{
+		if (wwTestBit(b, j))
+			wwXor2(c, t, n + m);
+		wwShHi(t, n + m, 1);
+	}
+}
+
+static bool_t ppTestMul()
+{
+	enum { n = 12 };
+	size_t reps = 100;
+	word a[n];
+	word b[n];
+	word c[2 * n];
+	word c1[2 * n];
+	word t[2 * n];
+	octet combo_state[32];
+	octet stack[2048];
+	// подготовить память
+	if (sizeof(combo_state) < prngCOMBO_keep() ||
+		sizeof(stack) < utilMax(3,
+			ppMul_deep(n, n),
+			ppMulW_deep(n),
+			ppAddMulW_deep(n)))
+		return FALSE;
+	// инициализировать генератор COMBO
+	prngCOMBOStart(combo_state, utilNonce32());
+	// умножение
+	while (reps--)
+	{
+		size_t k, m;
+		// генерация
+		prngCOMBOStepR(a, sizeof(a), combo_state);
+		prngCOMBOStepR(b, sizeof(b), combo_state);
+		k = 1 + reps % n, m = 1 + (reps / n) % n;
+		// ppMul
+		ppMul(c, a, k, b, m, stack);
+		ppMulRef(c1, a, k, b, m, t);
+		if (!wwEq(c, c1, k + m))
+			return FALSE;
+		// ppSqr
+		ppSqr(c, a, k, stack);
+		ppMulRef(c1, a, k, a, k, t);
+		if (!wwEq(c, c1, 2 * k))
+			return FALSE;
+		// ppMulW
+		c[k] = ppMulW(c, a, k, b[0], stack);
+		ppMulRef(c1, a, k, b, 1, t);
+		if (!wwEq(c, c1, k + 1))
+			return FALSE;
+		// ppAddMulW
+		wwCopy(c, b, k);
+		c[k] = ppAddMulW(c, a, k, b[0], stack);
+		wwXor2(c, b, k);
+		if (!wwEq(c, c1, k + 1))
+			return FALSE;
+	}
+	return TRUE;
+}
+
 /*
 *******************************************************************************
 Интеграция тестов
@@ -224,5 +471,8 @@ static bool_t ppTestRed()
 bool_t ppTest()
 {
 	return ppTestExps16() &&
-		ppTestRed();
+		ppTestIrred() &&
+		ppTestMinPoly() &&
+		ppTestRed() &&
+		ppTestMul();
 }
@@ -4,7 +4,7 @@
 \brief Tests for prime numbers
 \project bee2/test
 \created 2014.07.07
-\version 2024.02.26
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -29,9 +29,11 @@ bool_t priTest()
 	size_t n;
 	word a[W_OF_B(521)];
 	word p[W_OF_B(289)];
+	word p1[W_OF_B(289)];
 	word mods[1024];
 	octet combo_state[32];
-	octet stack[4096];
+	octet combo_state1[32];
+	octet stack[8192];
 	// инициализировать генератор COMBO
 	if (sizeof(combo_state) < prngCOMBO_keep())
 		return FALSE;
@@ -135,6 +137,25 @@ bool_t priTest()
 		sizeof(stack) < priIsPrime_deep(W_OF_B(256)) ||
 		!priIsPrime(p, W_OF_B(289), stack))
 		return FALSE;
+	// многопоточное расширение: результат не зависит от числа потоков
+	prngCOMBOStart(combo_state, 2026);
+	prngCOMBOStart(combo_state1, 2026);
+	if (sizeof(combo_state1) < prngCOMBO_keep() ||
+		sizeof(stack) < priExtendPrimeMT_deep(289, W_OF_B(256), 10, 3) ||
+		!priExtendPrime(p, 289, a, W_OF_B(256), SIZE_MAX, 10, prngCOMBOStepR,
+			combo_state, stack) ||
+		!priExtendPrimeMT(p1, 289, a, W_OF_B(256), SIZE_MAX, 10, 3,
+			prngCOMBOStepR, combo_state1, stack) ||
+		!wwEq(p, p1, W_OF_B(289)))
+		return FALSE;
+	// многопоточный поиск простого 2^256 - 189
+	wwCopy(p, a, W_OF_B(256));
+	zzSubW2(p, W_OF_B(256), 100);
+	if (sizeof(stack) < priNextPrimeMT_deep(W_OF_B(256), 10, 4) ||
+		!priNextPrimeMT(p, p, W_OF_B(256), 200, 10, B_PER_IMPOSSIBLE, 4,
+			stack) ||
+		!wwEq(p, a, W_OF_B(256)))
+		return FALSE;
 	// удостовериться, что в интервале (2^256 - 188, 2^256 - 1) нет простых
 	zzAddW2(a, W_OF_B(256), 1);
 	if (sizeof(stack) < priNextPrime_deep(W_OF_B(256), 200) ||
@@ -0,0 +1,189 @@
+/*
+*******************************************************************************
+\file zm_bench.c
+\brief Benchmarks for quotient rings of integers modulo m
+\project bee2/test
+\created 2026.10.14
+\version 2026.10.14
+\copyright The Bee2 authors
+\license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
+*******************************************************************************
+*/
+
+#include <stdio.h>
+#include <bee2/core/blob.h>
+#include <bee2/core/prng.h>
+#include <bee2/core/util.h>
+#include <bee2/math/ww.h>
+#include <bee2/math/zm.h>
+#include <bee2/math/zz.h>
+#include "../bench.h"
+
+/*
+*******************************************************************************
+Замеры
+
+Для модулей разных длин измеряется время умножения в кольцах с обычной
+редукцией, редукциями Барретта и Монтгомери. Для каждой длины
+определяется самая быстрая редукция: среди Plain и Mont для нечетных
+модулей, среди Plain и Barr для четных. По результатам печатаются пороги
+ZM_MONT_THRESHOLD, ZM_BARR_THRESHOLD и ZM_PLAIN_THRESHOLD (см. zm.c),
+оптимальные для текущей платформы.
+
+Дополнительно сравниваются умножение zzMul() и школьное умножение
+(произведение раскладывается на a * b_0 + a * (b_1 + b_2 B + ...) B, и
+zzMul() вызывается для множителей разной длины). Печатается длина,
+начиная с которой zzMul() (алгоритм Карацубы) опережает школьное
+умножение. Сравнение выполняется только для длин, при которых zzMul()
+действительно применяет алгоритм Карацубы. Поэтому напечатанная длина
+не меньше ZZ_KARATSUBA_THRESHOLD: если алгоритм Карацубы выигрывает
+уже на пороге, то порог, возможно, следует понизить.
+*******************************************************************************
+*/
+
+#define ZM_BENCH_MAX (4096 / B_PER_W)
+
+static const size_t _bits[] = {64, 128, 256, 384, 512, 768, 1024, 1536,
+	2048, 3072, 4096};
+
+typedef struct {
+	qr_o* r;				/*< кольцо */
+	word* a;				/*< первый множитель / произведение */
+	word* b;				/*< второй множитель */
+	word* c;				/*< [4 * n] произведение чисел */
+	size_t n;				/*< длина чисел */
+	void* stack;			/*< стек */
+} zm_bench_ctx;
+
+static void zmBenchMul(void* ctx)
+{
+	zm_bench_ctx* c = (zm_bench_ctx*)ctx;
+	qrMul(c->a, c->a, c->b, c->r, c->stack);
+}
+
+static void zmBenchZZMul(void* ctx)
+{
+	zm_bench_ctx* c = (zm_bench_ctx*)ctx;
+	zzMul(c->c, c->a, c->n, c->b, c->n, c->stack);
+}
+
+static void zmBenchZZMulSchool(void* ctx)
+{
+	zm_bench_ctx* c = (zm_bench_ctx*)ctx;
+	zzMul(c->c, c->a, c->n, c->b, 1, c->stack);
+	wwSetZero(c->c + c->n + 1, c->n - 1);
+	zzMul(c->c + 2 * c->n, c->a, c->n, c->b + 1, c->n - 1, c->stack);
+	zzAdd2(c->c + 1, c->c + 2 * c->n, 2 * c->n - 1);
+}
+
+typedef void (*zm_create_i)(qr_o* r, const octet mod[], size_t no,
+	void* stack);
+
+static double zmBenchRing(const char* name, size_t bits, zm_create_i create,
+	const octet mod[], zm_bench_ctx* ctx, void* combo_state)
+{
+	char label[32];
+	const size_t no = bits / 8;
+	create(ctx->r, mod, no, ctx->stack);
+	// a, b <- элементы кольца
+	prngCOMBOStepR(ctx->a, O_OF_W(ctx->r->n), combo_state);
+	prngCOMBOStepR(ctx->b, O_OF_W(ctx->r->n), combo_state);
+	ctx->a[ctx->r->n - 1] = ctx->b[ctx->r->n - 1] = 0;
+	sprintf(label, "%s%u", name, (unsigned)bits);
+	return benchRun("zmBench", label, 0, zmBenchMul, ctx);
+}
+
+static void zmBenchNote(const char* name, size_t n)
+{
+	char value[32];
+	if (n == SIZE_MAX)
+		sprintf(value, "SIZE_MAX");
+	else
+		sprintf(value, "%u", (unsigned)n);
+	benchNote("zmBench", name, value);
+}
+
+bool_t zmBench()
+{
+	const size_t no = O_OF_W(ZM_BENCH_MAX);
+	const size_t deep = utilMax(5,
+		zmCreatePlain_deep(no),
+		zmCreateBarr_deep(no),
+		zmCreateMont_deep(no),
+		zzMul_deep(ZM_BENCH_MAX, ZM_BENCH_MAX),
+		prngCOMBO_keep());
+	size_t mont = SIZE_MAX, barr = SIZE_MAX, plain = SIZE_MAX;
+	size_t kara = SIZE_MAX;
+	octet* mod;
+	octet* combo_state;
+	zm_bench_ctx ctx[1];
+	size_t i;
+	// подготовить память
+	mod = (octet*)blobCreate(no + prngCOMBO_keep() +
+		zmCreate_keep(no) + O_OF_W(6 * ZM_BENCH_MAX) + deep);
+	if (!mod)
+		return FALSE;
+	combo_state = mod + no;
+	ctx->r = (qr_o*)(combo_state + prngCOMBO_keep());
+	ctx->a = (word*)((octet*)ctx->r + zmCreate_keep(no));
+	ctx->b = ctx->a + ZM_BENCH_MAX;
+	ctx->c = ctx->b + ZM_BENCH_MAX;
+	ctx->stack = ctx->c + 4 * ZM_BENCH_MAX;
+	prngCOMBOStart(combo_state, utilNonce32());
+	// редукции
+	for (i = 0; i < COUNT_OF(_bits); ++i)
+	{
+		const size_t n = W_OF_B(_bits[i]);
+		double tp, tb, tm;
+		if (n > ZM_BENCH_MAX)
+			break;
+		// нечетный модуль: Plain / Mont
+		prngCOMBOStepR(mod, _bits[i] / 8, combo_state);
+		mod[0] |= 1, mod[_bits[i] / 8 - 1] |= 0x80;
+		tp = zmBenchRing("plain", _bits[i], zmCreatePlain, mod, ctx,
+			combo_state);
+		tm = zmBenchRing("mont", _bits[i], zmCreateMont, mod, ctx,
+			combo_state);
+		if (tp == 0 || tm == 0)
+			continue;
+		if (tm < tp)
+			mont = MIN2(mont, n), plain = SIZE_MAX;
+		else if (mont != SIZE_MAX && plain == SIZE_MAX)
+			plain = n;
+		// четный модуль: Plain / Barr
+		mod[0] ^= 1;
+		tp = zmBenchRing("plain_even", _bits[i], zmCreatePlain, mod, ctx,
+			combo_state);
+		tb = zmBenchRing("barr_even", _bits[i], zmCreateBarr, mod, ctx,
+			combo_state);
+		if (tb && tp && tb < tp)
+			barr = MIN2(barr, n);
+	}
+	zmBenchNote("ZM_MONT_THRESHOLD", mont);
+	zmBenchNote("ZM_BARR_THRESHOLD", barr);
+	zmBenchNote("ZM_PLAIN_THRESHOLD", plain);
+	// умножение
+	for (i = 0; i < COUNT_OF(_bits); ++i)
+	{
+		char label[32];
+		double tk, ts;
+		ctx->n = W_OF_B(_bits[i]);
+		// zzMul() -- школьное умножение?
+		if (ctx->n > ZM_BENCH_MAX || zzMul_deep(ctx->n, ctx->n) == 0)
+			continue;
+		prngCOMBOStepR(ctx->a, O_OF_W(ctx->n), combo_state);
+		prngCOMBOStepR(ctx->b, O_OF_W(ctx->n), combo_state);
+		sprintf(label, "zzMul%u", (unsigned)_bits[i]);
+		tk = benchRun("zmBench", label, 0, zmBenchZZMul, ctx);
+		sprintf(label, "zzMulSchool%u", (unsigned)_bits[i]);
+		ts = benchRun("zmBench", label, 0, zmBenchZZMulSchool, ctx);
+		if (tk && ts && tk < ts && kara == SIZE_MAX)
+			kara = ctx->n;
+		else if (tk && ts && tk >= ts)
+			kara = SIZE_MAX;
+	}
+	zmBenchNote("ZZ_KARATSUBA_THRESHOLD", kara);
+	// завершение
+	blobClose(mod);
+	return TRUE;
+}
@@ -4,7 +4,7 @@
 \brief Tests for multiple-precision unsigned integers
 \project bee2/test
 \created 2014.07.15
-\version 2023.11.10
+\version 2026.10.14
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -14,6 +14,7 @@
 #include <bee2/core/prng.h>
 #include <bee2/core/util.h>
 #include <bee2/core/word.h>
+#include <bee2/math/zm.h>
 #include <bee2/math/zz.h>
 #include <bee2/math/ww.h>
 
@@ -192,6 +193,54 @@ static bool_t zzTestMul()
 	return TRUE;
 }
 
+static bool_t zzTestKaratsuba()
+{
+	enum { n = 4096 / B_PER_W + 3 };
+	size_t reps = 10;
+	word a[n];
+	word b[n];
+	word c[2 * n];
+	word c1[2 * n];
+	word t[2 * n];
+	octet combo_state[32];
+	octet stack[8192];
+	// подготовить память
+	if (sizeof(combo_state) < prngCOMBO_keep() ||
+		sizeof(stack) < utilMax(2,
+			zzMul_deep(n, n),
+			zzSqr_deep(n)))
+		return FALSE;
+	// инициализировать генератор COMBO
+	prngCOMBOStart(combo_state, utilNonce32());
+	// сравнение с неравновесным (школьным) умножением
+	while (reps--)
+	{
+		size_t na;
+		prngCOMBOStepR(a, O_OF_W(n), combo_state);
+		prngCOMBOStepR(b, O_OF_W(n), combo_state);
+		if (reps == 0)
+			wwRepW(a, n, WORD_MAX), wwRepW(b, n, WORD_MAX);
+		for (na = n - 3; na >= 4; na = na * 2 / 3)
+		{
+			// c1 <- a * b_0 + a * b_1 B^1
+			zzMul(c1, a, na, b, 1, stack);
+			wwSetZero(c1 + na + 1, na - 1);
+			zzMul(t, a, na, b + 1, na - 1, stack);
+			zzAdd2(c1 + 1, t, 2 * na - 1);
+			// zzMul / zzSqr
+			zzMul(c, a, na, b, na, stack);
+			if (!wwEq(c, c1, 2 * na))
+				return FALSE;
+			zzMul(c1, a, na, a, na, stack);
+			zzSqr(c, a, na, stack);
+			if (!wwEq(c, c1, 2 * na))
+				return FALSE;
+		}
+	}
+	// все нормально
+	return TRUE;
+}
+
 static bool_t zzTestMod()
 {
 	enum { n = 8 };
@@ -317,6 +366,15 @@ static bool_t zzTestMod()
 		zzMulMod(t1, t1, a, mod, n, stack);
 		if (!wwEq(t1, b, n))
 			return FALSE;
+		// SAFE(zzInvMod) / FAST(zzInvMod), SAFE(zzDivMod) / FAST(zzDivMod)
+		SAFE(zzInvMod)(t, a, mod, n, stack);
+		FAST(zzInvMod)(t1, a, mod, n, stack);
+		if (!wwEq(t, t1, n))
+			return FALSE;
+		SAFE(zzDivMod)(t, b, a, mod, n, stack);
+		FAST(zzDivMod)(t1, b, a, mod, n, stack);
+		if (!wwEq(t, t1, n))
+			return FALSE;
 		// zzMulWMod / zzMulMod
 		wwSetZero(b + 1, n - 1);
 		zzMulWMod(t, a, b[0], mod, n, stack);
@@ -390,6 +448,75 @@ static bool_t zzTestGCD()
 	return TRUE;
 }
 
+static bool_t zzTestLehmer()
+{
+	enum { n = 4096 / B_PER_W, m = n / 4 };
+	size_t reps = 10;
+	word a[n];
+	word b[n];
+	word c[m];
+	word d[n];
+	word d1[n];
+	word da[n];
+	word db[n];
+	word p[2 * n];
+	word p1[2 * n];
+	octet combo_state[32];
+	octet stack[16384];
+	// подготовить память
+	if (sizeof(combo_state) < prngCOMBO_keep() ||
+		sizeof(stack) < utilMax(4,
+			zzMul_deep(n, n),
+			zzMod_deep(n, n),
+			zzGCD_deep(n, n),
+			zzExGCD_deep(n, n)))
+		return FALSE;
+	// инициализировать генератор COMBO
+	prngCOMBOStart(combo_state, utilNonce32());
+	// эксперименты
+	while (reps--)
+	{
+		size_t na, nb, nd;
+		// a <- a * c, b <- b * c
+		na = n - m, nb = n - m - reps % 3;
+		prngCOMBOStepR(a, O_OF_W(na), combo_state);
+		prngCOMBOStepR(b, O_OF_W(nb), combo_state);
+		prngCOMBOStepR(c, O_OF_W(m), combo_state);
+		a[na - 1] |= WORD_1, b[nb - 1] |= WORD_1, c[m - 1] |= WORD_1;
+		if (reps % 2)
+		{
+			zzMul(p, a, na, c, m, stack), wwCopy(a, p, na += m);
+			zzMul(p, b, nb, c, m, stack), wwCopy(b, p, nb += m);
+		}
+		// zzGCD / zzExGCD
+		zzGCD(d, a, na, b, nb, stack);
+		zzExGCD(d1, da, db, a, na, b, nb, stack);
+		nd = MIN2(na, nb);
+		if (!wwEq(d, d1, nd))
+			return FALSE;
+		// d | a, d | b?
+		zzMod(p, a, na, d, wwWordSize(d, nd), stack);
+		zzMod(p1, b, nb, d, wwWordSize(d, nd), stack);
+		if (!wwIsZero(p, wwWordSize(d, nd)) ||
+			!wwIsZero(p1, wwWordSize(d, nd)))
+			return FALSE;
+		// c | d?
+		if (reps % 2)
+		{
+			zzMod(p, d, nd, c, m, stack);
+			if (!wwIsZero(p, m))
+				return FALSE;
+		}
+		// da * a - db * b == d?
+		zzMul(p, da, nb, a, na, stack);
+		zzMul(p1, db, na, b, nb, stack);
+		zzSub2(p, p1, na + nb);
+		if (wwCmp2(p, na + nb, d, nd) != 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
 static bool_t zzTestRed()
 {
 	enum { n = 8 };
@@ -483,6 +610,305 @@ static bool_t zzTestRed()
 	return TRUE;
 }
 
+static bool_t zzTestZm()
+{
+	enum { n = 512 / B_PER_W };
+	size_t reps, no, i;
+	word a[n], b[n], t[n], t1[n];
+	word mod[n];
+	octet buf[O_OF_W(n)];
+	octet r[1024];
+	octet combo_state[32];
+	octet stack[4096];
+	// подготовить память
+	if (sizeof(combo_state) < prngCOMBO_keep() ||
+		sizeof(r) < zmCreate_keep(sizeof(buf)) ||
+		sizeof(stack) < utilMax(5,
+			zmCreate_deep(sizeof(buf)),
+			zzMulMod_deep(n),
+			zzSqrMod_deep(n),
+			zzIsCoprime_deep(n, n),
+			zzInvMod_deep(n)))
+		return FALSE;
+	// инициализировать генератор COMBO
+	prngCOMBOStart(combo_state, utilNonce32());
+	// кольца Крэндалла и Монтгомери с модулями из 256, 384, 512 битов
+	for (no = 32; no <= sizeof(buf); no += 16)
+	for (i = 0; i < 2; ++i)
+	{
+		const size_t m = W_OF_O(no);
+		// модуль
+		prngCOMBOStepR(mod, no, combo_state);
+		mod[0] |= 1;
+		if (i == 0)
+			wwRepW(mod + 1, m - 1, WORD_MAX);
+		else
+			mod[m - 1] = mod[m - 1] ? mod[m - 1] : 1;
+		wwTo(buf, no, mod);
+		zmCreate((qr_o*)r, buf, no, stack);
+		for (reps = 0; reps < 100; ++reps)
+		{
+			// элементы кольца
+			prngCOMBOStepR(a, no, combo_state);
+			prngCOMBOStepR(b, no, combo_state);
+			zzMod(a, a, m, mod, m, stack);
+			zzMod(b, b, m, mod, m, stack);
+			// умножение
+			zzMulMod(t, a, b, mod, m, stack);
+			wwTo(buf, no, a);
+			if (!qrFrom(t1, buf, (qr_o*)r, stack))
+				return FALSE;
+			wwTo(buf, no, b);
+			if (!qrFrom(b, buf, (qr_o*)r, stack))
+				return FALSE;
+			qrMul(t1, t1, b, (qr_o*)r, stack);
+			if (wwCmp(t1, mod, m) >= 0)
+				return FALSE;
+			qrTo(buf, t1, (qr_o*)r, stack);
+			wwFrom(t1, buf, no);
+			if (!wwEq(t, t1, m))
+				return FALSE;
+			// возведение в квадрат
+			zzSqrMod(t, a, mod, m, stack);
+			wwTo(buf, no, a);
+			if (!qrFrom(t1, buf, (qr_o*)r, stack))
+				return FALSE;
+			qrSqr(t1, t1, (qr_o*)r, stack);
+			if (wwCmp(t1, mod, m) >= 0)
+				return FALSE;
+			qrTo(buf, t1, (qr_o*)r, stack);
+			wwFrom(t1, buf, no);
+			if (!wwEq(t, t1, m))
+				return FALSE;
+			// обращение
+			if (!zzIsCoprime(a, m, mod, m, stack))
+				continue;
+			FAST(zzInvMod)(t, a, mod, m, stack);
+			wwTo(buf, no, a);
+			if (!qrFrom(t1, buf, (qr_o*)r, stack))
+				return FALSE;
+			qrInv(t1, t1, (qr_o*)r, stack);
+			qrTo(buf, t1, (qr_o*)r, stack);
+			wwFrom(t1, buf, no);
+			if (!wwEq(t, t1, m))
+				return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static bool_t zzTestZm8()
+{
+#ifdef U64_SUPPORT
+	enum { n = 512 / B_PER_W, l = (512 + 51) / 52 };
+	size_t reps, m, j;
+	word a[8 * n], b[8 * n], t[8 * n], t1[n];
+	word mod[n], d[2];
+	u64 a8[8 * l], b8[8 * l], c8[8 * l];
+	octet state[16384];
+	octet combo_state[32];
+	octet stack[20480];
+	// подготовить память
+	if (sizeof(combo_state) < prngCOMBO_keep() ||
+		zm8Len(n) > l ||
+		sizeof(state) < zm8Start_keep(n) ||
+		sizeof(stack) < utilMax(8,
+			zm8Start_deep(n),
+			zm8From_deep(n),
+			zm8To_deep(n),
+			zm8Mul_deep(n),
+			zm8Power_deep(n, 2),
+			zzMulMod_deep(n),
+			zzPowerMod_deep(n, 2),
+			zzMod_deep(n, n)))
+		return FALSE;
+	// инициализировать генератор COMBO
+	prngCOMBOStart(combo_state, utilNonce32());
+	// модули всех длин
+	for (m = 1; m <= n; ++m)
+	{
+		// модуль
+		prngCOMBOStepR(mod, O_OF_W(m), combo_state);
+		mod[0] |= 1;
+		mod[m - 1] = mod[m - 1] ? mod[m - 1] : 1;
+		zm8Start(state, mod, m, stack);
+		for (reps = 0; reps < 8; ++reps)
+		{
+			// элементы кольца
+			prngCOMBOStepR(a, O_OF_W(8 * m), combo_state);
+			prngCOMBOStepR(b, O_OF_W(8 * m), combo_state);
+			for (j = 0; j < 8; ++j)
+			{
+				zzMod(a + j * m, a + j * m, m, mod, m, stack);
+				zzMod(b + j * m, b + j * m, m, mod, m, stack);
+			}
+			if (reps == 0)
+				wwSetZero(a, m), wwCopy(b + m, mod, m), zzSubW2(b + m, m, 1);
+			zm8From(a8, a, state, stack);
+			zm8From(b8, b, state, stack);
+			// обратное преобразование
+			zm8To(t, a8, state, stack);
+			if (!wwEq(t, a, 8 * m))
+				return FALSE;
+			// нулевые элементы
+			if ((zm8Zeros(a8, state) & 1) != (reps == 0))
+				return FALSE;
+			// сложение
+			zm8Add(c8, a8, b8, state);
+			zm8To(t, c8, state, stack);
+			for (j = 0; j < 8; ++j)
+			{
+				zzAddMod(t1, a + j * m, b + j * m, mod, m);
+				if (!wwEq(t + j * m, t1, m))
+					return FALSE;
+			}
+			// вычитание
+			zm8Sub(c8, a8, b8, state);
+			zm8To(t, c8, state, stack);
+			for (j = 0; j < 8; ++j)
+			{
+				zzSubMod(t1, a + j * m, b + j * m, mod, m);
+				if (!wwEq(t + j * m, t1, m))
+					return FALSE;
+			}
+			// умножение
+			zm8Mul(c8, a8, b8, state, stack);
+			zm8To(t, c8, state, stack);
+			for (j = 0; j < 8; ++j)
+			{
+				zzMulMod(t1, a + j * m, b + j * m, mod, m, stack);
+				if (!wwEq(t + j * m, t1, m))
+					return FALSE;
+			}
+			// выбор
+			zm8Select(c8, a8, b8, 0x5A, state);
+			zm8To(t, c8, state, stack);
+			for (j = 0; j < 8; ++j)
+				if (!wwEq(t + j * m, (0x5A >> j & 1) ? b + j * m : a + j * m,
+					m))
+					return FALSE;
+			// возведение в степень
+			prngCOMBOStepR(d, O_OF_W(2), combo_state);
+			zm8Power(c8, b8, d, 2, state, stack);
+			zm8To(t, c8, state, stack);
+			for (j = 0; j < 8; ++j)
+			{
+				zzPowerMod(t1, b + j * m, m, d, 2, mod, stack);
+				if (!wwEq(t + j * m, t1, m))
+					return FALSE;
+			}
+		}
+	}
+#endif
+	return TRUE;
+}
+
+static bool_t zzTestPower()
+{
+	enum { n = 512 / B_PER_W };
+	size_t reps, m, k;
+	word a[n], b[n], d[n], e[n], t[n], t1[n];
+	word pre[n << 4];
+	octet buf[O_OF_W(n)];
+	octet r[1024];
+	octet combo_state[32];
+	octet stack[8192];
+	// подготовить память
+	if (sizeof(combo_state) < prngCOMBO_keep() ||
+		sizeof(r) < zmCreate_keep(sizeof(buf)) ||
+		sizeof(stack) < utilMax(6,
+			zmCreate_deep(sizeof(buf)),
+			qrPower_deep(n, n, zmCreate_deep(sizeof(buf))),
+			qrPowerCT_deep(n, n, zmCreate_deep(sizeof(buf))),
+			qrCombPrecomp_deep(n, zmCreate_deep(sizeof(buf))),
+			qrCombPowerCT_deep(n, zmCreate_deep(sizeof(buf))),
+			qrPower2_deep(n, n, n, zmCreate_deep(sizeof(buf)))))
+		return FALSE;
+	// инициализировать генератор COMBO
+	prngCOMBOStart(combo_state, utilNonce32());
+	// кольцо с нечетным модулем
+	prngCOMBOStepR(buf, sizeof(buf), combo_state);
+	buf[0] |= 1, buf[sizeof(buf) - 1] |= 0x80;
+	zmCreate((qr_o*)r, buf, sizeof(buf), stack);
+	for (reps = 0; reps < 20; ++reps)
+	for (m = 1; m <= n; m = 2 * m + 1)
+	for (k = 1; k <= n; k = 2 * k + 1)
+	{
+		// основания и показатели
+		prngCOMBOStepR(buf, sizeof(buf), combo_state);
+		buf[sizeof(buf) - 1] = 0;
+		if (!qrFrom(a, buf, (qr_o*)r, stack))
+			return FALSE;
+		prngCOMBOStepR(buf, sizeof(buf), combo_state);
+		buf[sizeof(buf) - 1] = 0;
+		if (!qrFrom(d, buf, (qr_o*)r, stack))
+			return FALSE;
+		prngCOMBOStepR(b, O_OF_W(m), combo_state);
+		prngCOMBOStepR(e, O_OF_W(k), combo_state);
+		if (reps == 0)
+			wwSetZero(b, m);
+		else if (reps == 1)
+			wwSetZero(e, k);
+		else if (reps == 2)
+			wwSetW(b, m, 1), b[m - 1] |= WORD_BIT_HI;
+		// регулярное возведение в степень
+		qrPower(t, a, b, m, (qr_o*)r, stack);
+		qrPowerCT(t1, a, b, m, (qr_o*)r, stack);
+		if (!wwEq(t, t1, n))
+			return FALSE;
+		// возведение в степень фиксированного основания
+		qrCombPrecomp(pre, a, 4, m, (qr_o*)r, stack);
+		qrCombPowerCT(t1, pre, 4, b, m, (qr_o*)r, stack);
+		if (!wwEq(t, t1, n))
+			return FALSE;
+		// совместное возведение в степень
+		qrPower(t1, d, e, k, (qr_o*)r, stack);
+		qrMul(t, t, t1, (qr_o*)r, stack);
+		qrPower2(t1, a, b, m, d, e, k, (qr_o*)r, stack);
+		if (!wwEq(t, t1, n))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+	Эталонный символ Якоби: алгоритм 2.148 из [Menezes A., van Oorschot P.,
+	Vanstone S. Handbook of Applied Cryptography] с делениями на каждом шаге.
+	Эталон сравнивается с бинарным алгоритмом zzJacobi().
+*/
+static int zzJacobiRef(const word a[], size_t n, const word b[], size_t m,
+	void* stack)
+{
+	int t = 1;
+	size_t s;
+	word* u = (word*)stack;
+	word* v = u + n;
+	stack = v + m;
+	wwCopy(v, b, m);
+	m = wwWordSize(v, m);
+	zzMod(u, a, n, v, m, stack);
+	n = wwWordSize(u, m);
+	while (wwCmpW(v, m, 1) > 0)
+	{
+		if (wwIsZero(u, n))
+			return 0;
+		if (wwIsW(u, n, 1))
+			break;
+		s = wwLoZeroBits(u, n);
+		if (s % 2 && ((v[0] & 7) == 3 || (v[0] & 7) == 5))
+			t = -t;
+		wwShLo(u, n, s);
+		n = wwWordSize(u, n);
+		if ((u[0] & 3) == 3 && (v[0] & 3) == 3)
+			t = -t;
+		zzMod(v, v, m, u, n, stack);
+		m = wwWordSize(v, n);
+		wwSwap(u, v, n);
+		s = m, m = n, n = s;
+	}
+	return t;
+}
+
 static bool_t zzTestEtc()
 {
 	enum { n = 8 };
@@ -495,16 +921,19 @@ static bool_t zzTestEtc()
 	octet stack[2048];
 	// подготовить память
 	if (sizeof(combo_state) < prngCOMBO_keep() ||
-		sizeof(stack) < utilMax(3,
+		sizeof(stack) < utilMax(5,
 			zzSqr_deep(n),
+			zzMul_deep(n, n),
 			zzSqrt_deep(n),
-			zzJacobi_deep(2 * n, n)))
+			zzJacobi_deep(2 * n, n),
+			zzMod_deep(2 * n, n) + O_OF_W(3 * n)))
 		return FALSE;
 	// инициализировать генератор COMBO
 	prngCOMBOStart(combo_state, utilNonce32());
 	// символ Якоби
 	while (reps1--)
 	{
+		size_t m;
 		prngCOMBOStepR(a, O_OF_W(n), combo_state);
 		zzSqr(b, a, n, stack);
 		prngCOMBOStepR(t, O_OF_W(n), combo_state);
@@ -512,6 +941,19 @@ static bool_t zzTestEtc()
 		// (a^2 / t) != -1?
 		if (zzJacobi(b, 2 * n, t, n, stack) == -1)
 			return FALSE;
+		// сравнение с эталоном
+		for (m = 1; m <= n; ++m)
+		{
+			if (zzJacobi(a, n, t, m, stack) !=
+					zzJacobiRef(a, n, t, m, stack) ||
+				zzJacobi(b, 2 * n, t, m, stack) !=
+					zzJacobiRef(b, 2 * n, t, m, stack))
+				return FALSE;
+			// (a t / t) == 0?
+			zzMul(b, a, n, t, m, stack);
+			if (zzJacobi(b, n + m, t, m, stack) != (wwIsW(t, m, 1) ? 1 : 0))
+				return FALSE;
+		}
 	}
 	// квадратные корни
 	while (reps2--)
@@ -545,8 +987,13 @@ bool_t zzTest()
 {
 	return zzTestAdd() && 
 		zzTestMul() && 
+		zzTestKaratsuba() &&
 		zzTestMod() && 
 		zzTestGCD() && 
+		zzTestLehmer() &&
 		zzTestRed() &&
+		zzTestZm() &&
+		zzTestZm8() &&
+		zzTestPower() &&
 		zzTestEtc();
 }
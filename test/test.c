@@ -4,7 +4,7 @@
 \brief Bee2 testing
 \project bee2/test
 \created 2014.04.02
-\version 2023.12.19
+\version 2026.10.15
 \copyright The Bee2 authors
 \license Licensed under the Apache License, Version 2.0 (see LICENSE.txt).
 *******************************************************************************
@@ -22,6 +22,7 @@
 extern bool_t apduTest();
 extern bool_t b64Test();
 extern bool_t blobTest();
+extern bool_t cpuTest();
 extern bool_t decTest();
 extern bool_t derTest();
 extern bool_t hexTest();
@@ -31,6 +32,7 @@ extern bool_t objTest();
 extern bool_t oidTest();
 extern bool_t prngTest();
 extern bool_t rngTest();
+extern bool_t stackTest();
 extern bool_t strTest();
 extern bool_t tmTest();
 extern bool_t u16Test();
@@ -45,6 +47,7 @@ int testCore()
 	printf("apduTest: %s\n", (code = apduTest()) ? "OK" : "Err"), ret |= !code;
 	printf("b64Test: %s\n", (code = b64Test()) ? "OK" : "Err"), ret |= !code;
 	printf("blobTest: %s\n", (code = blobTest()) ? "OK" : "Err"), ret |= !code;
+	printf("cpuTest: %s\n", (code = cpuTest()) ? "OK" : "Err"), ret |= !code;
 	printf("decTest: %s\n", (code = decTest()) ? "OK" : "Err"), ret |= !code;
 	printf("derTest: %s\n", (code = derTest()) ? "OK" : "Err"), ret |= !code;
 	printf("hexTest: %s\n", (code = hexTest()) ? "OK" : "Err"), ret |= !code;
@@ -54,6 +57,7 @@ int testCore()
 	printf("oidTest: %s\n", (code = oidTest()) ? "OK" : "Err"), ret |= !code;
 	printf("genTest: %s\n", (code = prngTest()) ? "OK" : "Err"), ret |= !code;
 	printf("rngTest: %s\n", (code = rngTest()) ? "OK" : "Err"), ret |= !code;
+	printf("stackTest: %s\n", (code = stackTest()) ? "OK" : "Err"), ret |= !code;
 	printf("strTest: %s\n", (code = strTest()) ? "OK" : "Err"), ret |= !code;
 	printf("tmTest: %s\n", (code = tmTest()) ? "OK" : "Err"), ret |= !code;
 	printf("u16Test: %s\n", (code = u16Test()) ? "OK" : "Err"), ret |= !code;
@@ -75,7 +79,6 @@ extern bool_t zzTest();
 extern bool_t ppTest();
 extern bool_t priTest();
 extern bool_t ecpTest();
-extern bool_t ecpBench();
 
 int testMath()
 {
@@ -87,7 +90,6 @@ int testMath()
 	printf("ppTest: %s\n", (code = ppTest()) ? "OK" : "Err"), ret |= !code;
 	printf("priTest: %s\n", (code = priTest()) ? "OK" : "Err"), ret |= !code;
 	printf("ecpTest: %s\n", (code = ecpTest()) ? "OK" : "Err"), ret |= !code;
-	code = ecpBench(), ret |= !code;
 	return ret;
 }
 
@@ -98,7 +100,6 @@ int testMath()
 */
 
 extern bool_t beltTest();
-extern bool_t beltBench();
 extern bool_t bignTest();
 extern bool_t bign96Test();
 extern bool_t brngTest();
@@ -106,7 +107,6 @@ extern bool_t belsTest();
 extern bool_t bakeTest();
 extern bool_t bakeDemo();
 extern bool_t bashTest();
-extern bool_t bashBench();
 extern bool_t botpTest();
 extern bool_t bpkiTest();
 extern bool_t btokTest();
@@ -114,6 +114,7 @@ extern bool_t dstuTest();
 extern bool_t g12sTest();
 extern bool_t pfokTest();
 extern bool_t pfokTestParamsStd();
+extern bool_t provTest();
 extern bool_t stb99Test();
 
 int testCrypto()
@@ -122,8 +123,6 @@ int testCrypto()
 	int ret = 0;
 	printf("beltTest: %s\n", (code = beltTest()) ? "OK" : "Err"), ret |= !code;
 	printf("bashTest: %s\n", (code = bashTest()) ? "OK" : "Err"), ret |= !code;
-	code = beltBench(), ret |= !code;
-	code = bashBench(), ret |= !code;
 	printf("bignTest: %s\n", (code = bignTest()) ? "OK" : "Err"), ret |= !code;
 	printf("bign96Test: %s\n", (code = bign96Test()) ? "OK" : "Err"),
 		ret |= !code;
@@ -136,11 +135,32 @@ int testCrypto()
 	printf("dstuTest: %s\n", (code = dstuTest()) ? "OK" : "Err"), ret |= !code;
 	printf("g12sTest: %s\n", (code = g12sTest()) ? "OK" : "Err"), ret |= !code;
 	printf("pfokTest: %s\n", (code = pfokTest()) ? "OK" : "Err"), ret |= !code;
+	printf("provTest: %s\n", (code = provTest()) ? "OK" : "Err"), ret |= !code;
 	printf("stb99Test: %s\n", (code = stb99Test()) ? "OK" : "Err"),
 		ret |= !code;
 	return ret;
 }
 
+/*
+*******************************************************************************
+Тестирование оберток C++
+*******************************************************************************
+*/
+
+#ifdef BEE2_TEST_CPP
+
+extern bool_t cppTest();
+
+int testCpp()
+{
+	bool_t code;
+	int ret = 0;
+	printf("cppTest: %s\n", (code = cppTest()) ? "OK" : "Err"), ret |= !code;
+	return ret;
+}
+
+#endif
+
 /*
 *******************************************************************************
 main
@@ -153,5 +173,8 @@ int main()
 	ret |= testCore();
 	ret |= testMath();
 	ret |= testCrypto();
+#ifdef BEE2_TEST_CPP
+	ret |= testCpp();
+#endif
 	return ret;
 }